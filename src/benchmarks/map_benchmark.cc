@@ -24,6 +24,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "src/shared/upid/upid.h"
+
 template <typename T>
 std::vector<T> GenerateRandomVector(uint64_t count) {
   std::vector<T> data;
@@ -39,6 +41,22 @@ std::vector<T> GenerateRandomVector(uint64_t count) {
   return data;
 }
 
+// UPIDs of the processes of one agent, which only differ in their pid and start time.
+std::vector<px::md::UPID> GenerateRandomUPIDs(uint64_t count) {
+  std::vector<px::md::UPID> data;
+  data.reserve(count);
+
+  std::seed_seq seed = {123};
+  std::mt19937_64 gen(seed);
+  std::uniform_int_distribution<uint32_t> pid_dis(1, 4 * 1024 * 1024);
+  std::uniform_int_distribution<int64_t> ts_dis(0, int64_t{1} << 50);
+
+  for (uint64_t i = 0; i < count; ++i) {
+    data.emplace_back(/* asid */ 7, pid_dis(gen), ts_dis(gen));
+  }
+  return data;
+}
+
 template <typename TMap>
 // NOLINTNEXTLINE : runtime/references.
 static void BM_InsertRandomNumericKeys(benchmark::State& state) {
@@ -93,6 +111,43 @@ static void BM_CountKeys(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations() * count);
 }
 
+template <typename TMap>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_InsertUPIDKeys(benchmark::State& state) {
+  int64_t count = state.range(0);
+  auto data = GenerateRandomUPIDs(count);
+
+  TMap myMap;
+  for (auto _ : state) {
+    for (const auto& d : data) {
+      myMap[d] = 1;
+    }
+    benchmark::DoNotOptimize(myMap);
+    myMap.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename TMap>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_FindUPIDKeys(benchmark::State& state) {
+  int64_t count = state.range(0);
+  auto data = GenerateRandomUPIDs(count);
+
+  TMap myMap;
+  for (const auto& d : data) {
+    myMap[d] = 1;
+  }
+
+  for (auto _ : state) {
+    for (const auto& d : data) {
+      auto it = myMap.find(d);
+      benchmark::DoNotOptimize(it);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
 BENCHMARK_TEMPLATE(BM_InsertRandomNumericKeys, std::unordered_map<int64_t, int64_t>)
     ->Range(1 << 14, 1 << 24);
 BENCHMARK_TEMPLATE(BM_InsertRandomNumericKeys, std::map<int64_t, int64_t>)->Range(1 << 14, 1 << 24);
@@ -108,3 +163,10 @@ BENCHMARK_TEMPLATE(BM_ReadRandomNumericKeys, absl::flat_hash_map<int64_t, int64_
 BENCHMARK_TEMPLATE(BM_CountKeys, std::unordered_map<int64_t, int64_t>)->Range(1 << 14, 1 << 24);
 BENCHMARK_TEMPLATE(BM_CountKeys, std::map<int64_t, int64_t>)->Range(1 << 14, 1 << 24);
 BENCHMARK_TEMPLATE(BM_CountKeys, absl::flat_hash_map<int64_t, int64_t>)->Range(1 << 14, 1 << 24);
+
+BENCHMARK_TEMPLATE(BM_InsertUPIDKeys, absl::flat_hash_map<px::md::UPID, int64_t>)
+    ->Range(1 << 8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_InsertUPIDKeys, px::md::UPIDMap<int64_t>)->Range(1 << 8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_FindUPIDKeys, absl::flat_hash_map<px::md::UPID, int64_t>)
+    ->Range(1 << 8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_FindUPIDKeys, px::md::UPIDMap<int64_t>)->Range(1 << 8, 1 << 16);
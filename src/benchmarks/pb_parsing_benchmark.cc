@@ -18,12 +18,16 @@
 
 #include <benchmark/benchmark.h>
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/message.h>
 
 #include <string>
 
+#include <absl/strings/str_cat.h>
+
 #include "src/benchmarks/proto/benchmark.pb.h"
+#include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/common/grpcutils/service_descriptor_database.h"
 
 const size_t kRangeMultiplier = 10;
@@ -33,7 +37,9 @@ const size_t kRangeEnd = 10'000'000;
 using ::google::protobuf::FileDescriptorSet;
 using ::google::protobuf::Message;
 using ::px::benchmarks::ChargeRequest;
+using ::px::carnotpb::TransferResultChunkRequest;
 using ::px::grpc::MethodInputOutput;
+using ::px::grpc::MethodPrototypes;
 using ::px::grpc::ServiceDescriptorDatabase;
 
 static ChargeRequest SampleChargeRequest() {
@@ -67,6 +73,25 @@ static void BM_dynamic_message_parsing(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations() * state.range(0));
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_dynamic_message_reused_parsing(benchmark::State& state) {
+  const ChargeRequest sample_charge_req = SampleChargeRequest();
+  const std::string serialized_charge_req = sample_charge_req.SerializeAsString();
+
+  FileDescriptorSet fd_set;
+  ChargeRequest::descriptor()->file()->CopyTo(fd_set.add_file());
+  ServiceDescriptorDatabase db(fd_set);
+
+  for (auto _ : state) {
+    MethodPrototypes prototypes = db.GetMethodPrototypes("px.benchmarks.PaymentService.Charge");
+    std::unique_ptr<Message> t(prototypes.input->New());
+    for (size_t i = 0; i < static_cast<size_t>(state.range(0)); ++i) {
+      t->ParseFromString(serialized_charge_req);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_compiled_message_parsing(benchmark::State& state) {
   const ChargeRequest sample_charge_req = SampleChargeRequest();
@@ -81,9 +106,62 @@ static void BM_compiled_message_parsing(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations() * state.range(0));
 }
 
+// A batch of http_events-like rows, as a GRPC sink sends them.
+static TransferResultChunkRequest SampleResultChunk(int64_t num_rows) {
+  TransferResultChunkRequest r;
+  r.set_address("kelvin");
+  auto* rb = r.mutable_query_result()->mutable_row_batch();
+  rb->set_num_rows(num_rows);
+  auto* times = rb->add_cols()->mutable_time64ns_data();
+  auto* upids = rb->add_cols()->mutable_uint128_data();
+  auto* paths = rb->add_cols()->mutable_string_data();
+  auto* latencies = rb->add_cols()->mutable_int64_data();
+  auto* bodies = rb->add_cols()->mutable_string_data();
+  for (int64_t i = 0; i < num_rows; ++i) {
+    times->add_data(1'600'000'000'000'000'000 + i);
+    auto* upid = upids->add_data();
+    upid->set_high(i % 16);
+    upid->set_low(i);
+    paths->add_data(absl::StrCat("/api/v1/items/", i % 100));
+    latencies->add_data(i * 1000);
+    bodies->add_data(std::string(200, 'a'));
+  }
+  return r;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_row_batch_parsing(benchmark::State& state) {
+  const std::string serialized = SampleResultChunk(state.range(0)).SerializeAsString();
+
+  for (auto _ : state) {
+    TransferResultChunkRequest t;
+    t.ParseFromString(serialized);
+    benchmark::DoNotOptimize(t);
+  }
+  state.SetBytesProcessed(state.iterations() * serialized.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_row_batch_arena_parsing(benchmark::State& state) {
+  const std::string serialized = SampleResultChunk(state.range(0)).SerializeAsString();
+
+  for (auto _ : state) {
+    google::protobuf::Arena arena;
+    auto* t = google::protobuf::Arena::CreateMessage<TransferResultChunkRequest>(&arena);
+    t->ParseFromString(serialized);
+    benchmark::DoNotOptimize(t);
+  }
+  state.SetBytesProcessed(state.iterations() * serialized.size());
+}
+
+BENCHMARK(BM_row_batch_parsing)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK(BM_row_batch_arena_parsing)->RangeMultiplier(4)->Range(64, 4096);
 BENCHMARK(BM_dynamic_message_parsing)
     ->RangeMultiplier(kRangeMultiplier)
     ->Range(kRangeBegin, kRangeEnd);
+BENCHMARK(BM_dynamic_message_reused_parsing)
+    ->RangeMultiplier(kRangeMultiplier)
+    ->Range(kRangeBegin, kRangeEnd);
 BENCHMARK(BM_compiled_message_parsing)
     ->RangeMultiplier(kRangeMultiplier)
     ->Range(kRangeBegin, kRangeEnd);
@@ -26,6 +26,7 @@
 #include <sole.hpp>
 
 #include "src/carnot/carnot.h"
+#include "src/carnot/exec/batch_sizer.h"
 #include "src/carnot/exec/local_grpc_result_server.h"
 #include "src/carnot/exec/test_utils.h"
 #include "src/carnot/udf/udf.h"
@@ -93,6 +94,7 @@ void BM_Query(benchmark::State& state, std::vector<types::DataType> types,
   int64_t bytes_processed = 0;
   int i = 0;
   for (auto _ : state) {
+    server.ResetQueryResults();
     auto queryWithTableName = absl::Substitute(query, "results_" + std::to_string(i));
     auto res = carnot->ExecuteQuery(queryWithTableName, sole::uuid4(), CurrentTimeNS());
     if (!res.ok()) {
@@ -122,6 +124,18 @@ void BM_Query_Int(benchmark::State& state, std::vector<types::DataType> types,
   BM_Query(state, types, distribution_types, query, num_batches, default_params, default_params);
 }
 
+// Reads the table in batches of state.range(1) bytes, or in the table's own batches if it's 0.
+// NOLINTNEXTLINE : runtime/references.
+void BM_Query_TargetBatchBytes(benchmark::State& state, std::vector<types::DataType> types,
+                               std::vector<datagen::DistributionType> distribution_types,
+                               const std::string& query, int64_t num_batches) {
+  auto target_batch_bytes = FLAGS_carnot_target_batch_bytes;
+  FLAGS_carnot_target_batch_bytes = state.range(1);
+  const datagen::DistributionParams* default_params = nullptr;
+  BM_Query(state, types, distribution_types, query, num_batches, default_params, default_params);
+  FLAGS_carnot_target_batch_bytes = target_batch_bytes;
+}
+
 const std::unique_ptr<const datagen::DistributionParams> sample_selection_params =
     std::make_unique<const datagen::ZipfianParams>(2, 2, 999);
 const std::unique_ptr<const datagen::DistributionParams> sample_length_params =
@@ -150,6 +164,15 @@ BENCHMARK_CAPTURE(BM_Query_String, eval_group_by_one_uniform_string,
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
 
+// Mirrors groupby(['upid', 'req_path']): a fixed-width key plus a string key.
+BENCHMARK_CAPTURE(BM_Query_String, eval_group_by_int_and_string,
+                  {types::DataType::INT64, types::DataType::STRING, types::DataType::INT64},
+                  {datagen::DistributionType::kUniform, datagen::DistributionType::kZipfian,
+                   datagen::DistributionType::kUniform},
+                  kGroupByTwoQuery, 20, sample_selection_params.get(), sample_length_params.get())
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
 // TODO(philkuz) fails in table.cc because batch size > table size.
 // BENCHMARK_CAPTURE(BM_Query_String, eval_group_by_one_uniform_string_two_data_cols,
 //                   {types::DataType::STRING, types::DataType::STRING, types::DataType::INT64},
@@ -190,6 +213,16 @@ BENCHMARK_CAPTURE(BM_Query_Int, eval_group_by_one_exponential_int,
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
 
+// Batch sizing: the same table, read in its own 64k row batches and in batches of 64KB to 1MB.
+BENCHMARK_CAPTURE(BM_Query_TargetBatchBytes, eval_group_by_one_uniform_int_batch_bytes,
+                  {types::DataType::INT64, types::DataType::INT64},
+                  {datagen::DistributionType::kUniform, datagen::DistributionType::kUniform},
+                  kGroupByOneQuery, 20)
+    ->Args({1 << 16, 0})
+    ->Args({1 << 16, 64 << 10})
+    ->Args({1 << 16, 256 << 10})
+    ->Args({1 << 16, 1 << 20});
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -16,22 +16,32 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <filesystem>
 #include <memory>
 #include <string>
 
 #include "src/carnot/carnot.h"
 #include "src/carnot/engine_state.h"
+#include "src/carnot/exec/async_execution.h"
 #include "src/carnot/exec/exec_graph.h"
 #include "src/carnot/funcs/builtins/builtins.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/plan/plan.h"
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/distributed/annotate_abortable_sources_for_limits_rule.h"
+#include "src/carnot/prepared_plan_cache.h"
+#include "src/carnot/query_trace.h"
 #include "src/carnot/udf/registry.h"
+#include "src/common/metrics/metrics.h"
 #include "src/common/perf/perf.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_string(carnot_query_trace_dir, gflags::StringFromEnv("PL_CARNOT_QUERY_TRACE_DIR", ""),
+              "If set, the agent that merges the execution stats of a query run with analyze "
+              "writes the batch traces (see --carnot_trace_exec_batches) of all the agents to "
+              "<dir>/<query_id>.json, in the Chrome trace event format.");
+
 namespace px {
 namespace carnot {
 
@@ -63,6 +73,9 @@ class CarnotImpl final : public Carnot {
 
   Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze) override;
 
+  void ExecutePlanAsync(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze,
+                        event::Dispatcher* dispatcher, std::function<void(Status)> done) override;
+
   void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc func) override {
     agent_md_callback_ = func;
   };
@@ -70,7 +83,26 @@ class CarnotImpl final : public Carnot {
   const udf::Registry* FuncRegistry() const override { return engine_state_->func_registry(); }
 
  private:
+  struct QueryExecution;
+
+  // Runs the query until it's done, in which case it returns true, or until its current fragment
+  // waits for data, in which case it returns false. continue_func is called when more data arrives.
+  StatusOr<bool> ExecuteQueryStep(QueryExecution* query,
+                                  const std::function<void()>& continue_func);
+  Status StartQuery(QueryExecution* query);
+  StatusOr<bool> ExecuteFragmentUntilBlocked(QueryExecution* query,
+                                             const std::function<void()>& continue_func);
+  // Collects the stats of the fragment that just ran, and moves on to the next one.
+  Status FinishFragment(QueryExecution* query);
+  // Merges the stats of the query with those of the agents that sent it data, and sends them on.
+  Status FinishQuery(QueryExecution* query);
+
   Status RegisterUDFs(exec::ExecState* exec_state, plan::Plan* plan);
+  // Returns the prepared plan for the proto, from the cache or freshly parsed, and registers its
+  // UDFs and UDAs in the exec state.
+  StatusOr<std::unique_ptr<PreparedPlan>> PreparePlan(exec::ExecState* exec_state,
+                                                      const std::string& plan_key,
+                                                      const planpb::Plan& logical_plan);
 
   Status RegisterUDFsInPlanFragment(exec::ExecState* exec_state, plan::PlanFragment* pf);
   Status WalkExpression(exec::ExecState* exec_state, const plan::ScalarExpression& expr);
@@ -93,6 +125,7 @@ class CarnotImpl final : public Carnot {
   AgentMetadataCallbackFunc agent_md_callback_;
   planner::compiler::Compiler compiler_;
   std::unique_ptr<EngineState> engine_state_;
+  PreparedPlanCache prepared_plans_;
 
   std::shared_ptr<grpc::ServerCredentials> grpc_server_creds_;
   std::unique_ptr<std::thread> grpc_server_thread_;
@@ -180,6 +213,7 @@ Status CarnotImpl::RegisterUDFsInPlanFragment(exec::ExecState* exec_state, plan:
       .OnGRPCSink(no_op)
       .OnUDTFSource(no_op)
       .OnEmptySource(no_op)
+      .OnSort(no_op)
       .Walk(pf);
 }
 
@@ -205,6 +239,32 @@ Status CarnotImpl::WalkExpression(exec::ExecState* exec_state, const plan::Scala
   return Status::OK();
 }
 
+StatusOr<std::unique_ptr<PreparedPlan>> CarnotImpl::PreparePlan(exec::ExecState* exec_state,
+                                                                const std::string& plan_key,
+                                                                const planpb::Plan& logical_plan) {
+  std::unique_ptr<PreparedPlan> prepared = prepared_plans_.Take(plan_key, logical_plan);
+  if (prepared != nullptr) {
+    for (const auto& [id, def] : prepared->scalar_udfs) {
+      exec_state->AddScalarUDF(id, def);
+    }
+    for (const auto& [id, def] : prepared->udas) {
+      exec_state->AddUDA(id, def);
+    }
+    return prepared;
+  }
+
+  prepared = std::make_unique<PreparedPlan>();
+  PL_RETURN_IF_ERROR(prepared->plan.Init(logical_plan));
+  PL_RETURN_IF_ERROR(RegisterUDFs(exec_state, &prepared->plan));
+  for (const auto& [id, def] : exec_state->id_to_scalar_udf_map()) {
+    prepared->scalar_udfs.emplace_back(id, def);
+  }
+  for (const auto& [id, def] : exec_state->id_to_uda_map()) {
+    prepared->udas.emplace_back(id, def);
+  }
+  return prepared;
+}
+
 void CarnotImpl::GRPCServerFunc() {
   CHECK(grpc_router_ != nullptr);
   CHECK(grpc_server_creds_ != nullptr);
@@ -270,90 +330,212 @@ Status SendFinalExecutionStatsToOutgoingConns(
   return Status::OK();
 }
 
+/**
+ * The state of a query, which runs its plan fragments one after the other. ExecutePlan() runs it on
+ * the calling thread, ExecutePlanAsync() runs it in steps on the thread pool of a dispatcher.
+ */
+struct CarnotImpl::QueryExecution {
+  QueryExecution(const planpb::Plan& logical_plan, const sole::uuid& query_id, bool analyze)
+      : logical_plan(logical_plan), query_id(query_id), analyze(analyze) {}
+
+  const planpb::Plan& logical_plan;
+  sole::uuid query_id;
+  bool analyze;
+
+  ElapsedTimer timer;
+  std::unique_ptr<exec::ExecState> exec_state;
+  std::string plan_key;
+  std::unique_ptr<PreparedPlan> prepared;
+  std::unique_ptr<plan::PlanState> plan_state;
+  std::vector<plan::PlanFragment*> fragments;
+  // The fragment that runs next, and its execution graph once it started.
+  size_t next_fragment = 0;
+  std::unique_ptr<exec::ExecutionGraph> exec_graph;
+
+  std::vector<std::string> output_table_strs;
+  int64_t bytes_processed = 0;
+  int64_t rows_processed = 0;
+  queryresultspb::AgentExecutionStats agent_operator_exec_stats;
+};
+
 Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uuid& query_id,
                                bool analyze) {
-  auto timer = ElapsedTimer();
-  plan::Plan plan;
+  QueryExecution query(logical_plan, query_id, analyze);
+  PL_ASSIGN_OR_RETURN(bool done, ExecuteQueryStep(&query, nullptr));
+  while (!done) {
+    query.exec_graph->YieldWithTimeout();
+    PL_ASSIGN_OR_RETURN(done, ExecuteQueryStep(&query, nullptr));
+  }
+  return Status::OK();
+}
+
+void CarnotImpl::ExecutePlanAsync(const planpb::Plan& logical_plan, const sole::uuid& query_id,
+                                  bool analyze, event::Dispatcher* dispatcher,
+                                  std::function<void(Status)> done) {
+  auto query = std::make_shared<QueryExecution>(logical_plan, query_id, analyze);
+  auto execution = exec::AsyncExecution::Create(
+      dispatcher, exec::kDefaultYieldTimeoutMS,
+      [this, query](const exec::AsyncExecution::WakeFunc& wake) {
+        return ExecuteQueryStep(query.get(), wake);
+      },
+      std::move(done));
+  execution->Start();
+}
 
-  PL_RETURN_IF_ERROR(plan.Init(logical_plan));
+StatusOr<bool> CarnotImpl::ExecuteQueryStep(QueryExecution* query,
+                                            const std::function<void()>& continue_func) {
+  if (query->exec_state == nullptr) {
+    PL_RETURN_IF_ERROR(StartQuery(query));
+  }
+  while (query->next_fragment < query->fragments.size()) {
+    auto fragment_done = ExecuteFragmentUntilBlocked(query, continue_func);
+    if (!fragment_done.ok()) {
+      static metrics::Counter* const failed_queries =
+          metrics::MetricsRegistry::Global()->GetCounter(
+              "carnot_failed_queries_total", "Queries that failed to execute on this agent.");
+      failed_queries->Increment();
+      return fragment_done.status();
+    }
+    if (!fragment_done.ValueOrDie()) {
+      return false;
+    }
+  }
+  PL_RETURN_IF_ERROR(FinishQuery(query));
+  return true;
+}
 
+Status CarnotImpl::StartQuery(QueryExecution* query) {
   // For each of the plan fragments in the plan, execute the query.
-  std::vector<std::string> output_table_strs;
-  auto exec_state = engine_state_->CreateExecState(query_id);
+  query->exec_state = engine_state_->CreateExecState(query->query_id);
 
   // TODO(michellenguyen/zasgar, PP-2579): We should periodically update the metadata state for
   // long-running queries after a certain time duration or number of row batches processed. For now,
   // we use a single metadata state throughout the entire length of the query.
   auto metadata_state = GetMetadataState();
   if (metadata_state) {
-    exec_state->set_metadata_state(metadata_state);
+    query->exec_state->set_metadata_state(metadata_state);
   }
 
-  PL_RETURN_IF_ERROR(RegisterUDFs(exec_state.get(), &plan));
+  query->plan_key = PreparedPlanCache::MakeKey(query->logical_plan);
+  PL_ASSIGN_OR_RETURN(query->prepared,
+                      PreparePlan(query->exec_state.get(), query->plan_key, query->logical_plan));
 
-  auto plan_state = engine_state_->CreatePlanState();
-  int64_t bytes_processed = 0;
-  int64_t rows_processed = 0;
-  queryresultspb::AgentExecutionStats agent_operator_exec_stats;
-  ToProto(agent_id_, agent_operator_exec_stats.mutable_agent_id());
-  timer.Start();
-  auto s =
-      plan::PlanWalker()
-          .OnPlanFragment([&](auto* pf) {
-            auto exec_graph = exec::ExecutionGraph();
-            PL_RETURN_IF_ERROR(exec_graph.Init(engine_state_->schema(), plan_state.get(),
-                                               exec_state.get(), pf,
-                                               /* collect_exec_node_stats */ analyze));
-            PL_RETURN_IF_ERROR(exec_graph.Execute());
-            std::vector<std::string> frag_sinks = exec_graph.OutputTables();
-            output_table_strs.insert(output_table_strs.end(), frag_sinks.begin(), frag_sinks.end());
-            auto exec_stats = exec_graph.GetStats();
-            bytes_processed += exec_stats.bytes_processed;
-            rows_processed += exec_stats.rows_processed;
-
-            if (analyze) {
-              for (int64_t node_id : pf->dag().TopologicalSort()) {
-                PL_ASSIGN_OR_RETURN(auto exec_node, exec_graph.node(node_id));
-                std::string node_name =
-                    absl::Substitute("$0 (id=$1)", pf->nodes()[node_id]->DebugString(), node_id);
-                exec::ExecNodeStats* stats = exec_node->stats();
-                stats->AddExtraMetric("batches_output", stats->batches_output);
-                int64_t total_time_ns = stats->TotalExecTime();
-                int64_t self_time_ns = stats->SelfExecTime();
-                LOG(INFO) << absl::Substitute(
-                    "self_time:$1\ttotal_time: $2\tbytes_output: $3\trows_output: $4\tnode_id:$0",
-                    node_name, PrettyDuration(self_time_ns), PrettyDuration(total_time_ns),
-                    stats->bytes_output, stats->rows_output);
-
-                queryresultspb::OperatorExecutionStats* stats_pb =
-                    agent_operator_exec_stats.add_operator_execution_stats();
-                stats_pb->set_plan_fragment_id(pf->id());
-                stats_pb->set_node_id(node_id);
-                stats_pb->set_bytes_output(stats->bytes_output);
-                stats_pb->set_records_output(stats->rows_output);
-                stats_pb->set_total_execution_time_ns(total_time_ns);
-                stats_pb->set_self_execution_time_ns(self_time_ns);
-
-                for (const auto& [k, v] : stats->extra_metrics) {
-                  (*stats_pb->mutable_extra_metrics())[k] = v;
-                }
-
-                for (const auto& [k, v] : stats->extra_info) {
-                  (*stats_pb->mutable_extra_info())[k] = v;
-                }
-              }
-            }
-            return Status::OK();
-          })
-          .Walk(&plan);
-  PL_RETURN_IF_ERROR(s);
+  query->plan_state = engine_state_->CreatePlanState();
+  ToProto(agent_id_, query->agent_operator_exec_stats.mutable_agent_id());
+  query->timer.Start();
+  return plan::PlanWalker()
+      .OnPlanFragment([&](auto* pf) {
+        query->fragments.push_back(pf);
+        return Status::OK();
+      })
+      .Walk(&query->prepared->plan);
+}
+
+StatusOr<bool> CarnotImpl::ExecuteFragmentUntilBlocked(
+    QueryExecution* query, const std::function<void()>& continue_func) {
+  if (query->exec_graph == nullptr) {
+    plan::PlanFragment* pf = query->fragments[query->next_fragment];
+    query->exec_graph = std::make_unique<exec::ExecutionGraph>();
+    PL_RETURN_IF_ERROR(query->exec_graph->Init(engine_state_->schema(), query->plan_state.get(),
+                                               query->exec_state.get(), pf,
+                                               /* collect_exec_node_stats */ query->analyze));
+    if (continue_func) {
+      query->exec_graph->set_continue_func(continue_func);
+    }
+    PL_RETURN_IF_ERROR(query->exec_graph->Open());
+  }
+  auto done = query->exec_graph->ExecuteUntilBlocked();
+  if (done.ok() && !done.ValueOrDie()) {
+    return false;
+  }
+  PL_RETURN_IF_ERROR(query->exec_graph->Close(done.status()));
+  PL_RETURN_IF_ERROR(FinishFragment(query));
+  return true;
+}
+
+Status CarnotImpl::FinishFragment(QueryExecution* query) {
+  plan::PlanFragment* pf = query->fragments[query->next_fragment];
+  exec::ExecutionGraph& exec_graph = *query->exec_graph;
+  std::vector<std::string> frag_sinks = exec_graph.OutputTables();
+  query->output_table_strs.insert(query->output_table_strs.end(), frag_sinks.begin(),
+                                  frag_sinks.end());
+  auto exec_stats = exec_graph.GetStats();
+  query->bytes_processed += exec_stats.bytes_processed;
+  query->rows_processed += exec_stats.rows_processed;
+  auto& agent_operator_exec_stats = query->agent_operator_exec_stats;
+  auto* table_records = agent_operator_exec_stats.mutable_table_records_processed();
+  for (const auto& [table_name, rows] : exec_stats.table_rows_processed) {
+    (*table_records)[table_name] += rows;
+  }
+
+  if (query->analyze) {
+    for (int64_t node_id : pf->dag().TopologicalSort()) {
+      PL_ASSIGN_OR_RETURN(auto exec_node, exec_graph.node(node_id));
+      std::string node_name =
+          absl::Substitute("$0 (id=$1)", pf->nodes()[node_id]->DebugString(), node_id);
+      exec::ExecNodeStats* stats = exec_node->stats();
+      stats->AddExtraMetric("batches_output", stats->batches_output);
+      stats->AddExtraMetric("peak_memory_bytes", stats->peak_memory_bytes);
+      if (stats->dropped_trace_spans > 0) {
+        stats->AddExtraMetric("dropped_trace_spans", stats->dropped_trace_spans);
+      }
+      int64_t total_time_ns = stats->TotalExecTime();
+      int64_t self_time_ns = stats->SelfExecTime();
+      LOG(INFO) << absl::Substitute(
+          "self_time:$1\ttotal_time: $2\tbytes_output: $3\trows_output: $4\tnode_id:$0",
+          node_name, PrettyDuration(self_time_ns), PrettyDuration(total_time_ns),
+          stats->bytes_output, stats->rows_output);
+
+      queryresultspb::OperatorExecutionStats* stats_pb =
+          agent_operator_exec_stats.add_operator_execution_stats();
+      stats_pb->set_plan_fragment_id(pf->id());
+      stats_pb->set_node_id(node_id);
+      stats_pb->set_bytes_output(stats->bytes_output);
+      stats_pb->set_records_output(stats->rows_output);
+      stats_pb->set_total_execution_time_ns(total_time_ns);
+      stats_pb->set_self_execution_time_ns(self_time_ns);
+
+      for (const auto& [k, v] : stats->extra_metrics) {
+        (*stats_pb->mutable_extra_metrics())[k] = v;
+      }
+
+      for (const auto& [k, v] : stats->extra_info) {
+        (*stats_pb->mutable_extra_info())[k] = v;
+      }
+      if (!stats->trace_spans.empty()) {
+        (*stats_pb->mutable_extra_info())[kTraceSpansKey] = EncodeTraceSpans(stats->trace_spans);
+        (*stats_pb->mutable_extra_info())[kTraceNameKey] = node_name;
+      }
+    }
+  }
+
+  query->exec_graph.reset();
+  ++query->next_fragment;
+  return Status::OK();
+}
+
+Status CarnotImpl::FinishQuery(QueryExecution* query) {
+  const sole::uuid& query_id = query->query_id;
+  bool analyze = query->analyze;
+  int64_t bytes_processed = query->bytes_processed;
+  int64_t rows_processed = query->rows_processed;
+  auto& agent_operator_exec_stats = query->agent_operator_exec_stats;
+
+  // The execution graphs, which point into the plan, are gone, so it can be reused.
+  prepared_plans_.Return(std::move(query->plan_key), std::move(query->prepared));
 
   std::vector<uuidpb::UUID> incoming_agents;
-  for (const auto& id : logical_plan.incoming_agent_ids()) {
+  for (const auto& id : query->logical_plan.incoming_agent_ids()) {
     incoming_agents.push_back(id);
   }
+  auto& timer = query->timer;
   timer.Stop();
   int64_t exec_time_ns = timer.ElapsedTime_us() * 1000;
+  // 1ms to ~65s.
+  static metrics::Histogram* const query_latency = metrics::MetricsRegistry::Global()->GetHistogram(
+      "carnot_query_latency_us", "Time to execute the plan fragments of a query, in microseconds.",
+      metrics::ExponentialBuckets(1000, 2, 17));
+  query_latency->Observe(timer.ElapsedTime_us());
 
   std::vector<queryresultspb::AgentExecutionStats> input_agent_stats;
   if (HasGRPCServer() && !incoming_agents.empty()) {
@@ -366,6 +548,9 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   for (const auto& agent_stats : input_agent_stats) {
     bytes_processed += agent_stats.bytes_processed();
     rows_processed += agent_stats.records_processed();
+    for (const auto& [table_name, rows] : agent_stats.table_records_processed()) {
+      (*agent_operator_exec_stats.mutable_table_records_processed())[table_name] += rows;
+    }
   }
 
   agent_operator_exec_stats.set_execution_time_ns(exec_time_ns);
@@ -381,7 +566,20 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   // analyze=true will send per operator stats.
   all_agent_stats.push_back(agent_operator_exec_stats);
 
-  return SendFinalExecutionStatsToOutgoingConns(query_id, exec_state->OutgoingServers(),
+  if (analyze && !FLAGS_carnot_query_trace_dir.empty() && !input_agent_stats.empty()) {
+    // Tracing is best effort, it doesn't fail the query.
+    auto trace = ToChromeTrace(all_agent_stats);
+    Status s = trace.status();
+    if (s.ok()) {
+      auto path = std::filesystem::path(FLAGS_carnot_query_trace_dir) /
+                  absl::StrCat(query_id.str(), ".json");
+      s = WriteFileFromString(path.string(), trace.ValueOrDie());
+    }
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to write the trace of query $0: $1",
+                                                 query_id.str(), s.msg());
+  }
+
+  return SendFinalExecutionStatsToOutgoingConns(query_id, query->exec_state->OutgoingServers(),
                                                 engine_state_->add_auth_to_grpc_context_func(),
                                                 agent_operator_exec_stats, all_agent_stats);
 }
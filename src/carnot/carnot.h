@@ -19,6 +19,7 @@
 #pragma once
 
 #include <arrow/memory_pool.h>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -28,6 +29,7 @@
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/queryresultspb/query_results.pb.h"
 #include "src/common/base/base.h"
+#include "src/common/event/dispatcher.h"
 #include "src/shared/metadata/metadata_state.h"
 #include "src/table_store/table_store.h"
 
@@ -72,6 +74,18 @@ class Carnot : public NotCopyable {
   virtual Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id,
                              bool analyze = false) = 0;
 
+  /**
+   * Executes the given logical plan in steps on the thread pool of the dispatcher, without holding
+   * a thread while the query waits for data from other agents. Must be called on the dispatcher's
+   * thread.
+   *
+   * @param plan the plan protobuf, which must stay alive until done is called.
+   * @param done called on the dispatcher's thread with the status of the query.
+   */
+  virtual void ExecutePlanAsync(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze,
+                                event::Dispatcher* dispatcher,
+                                std::function<void(Status)> done) = 0;
+
   /**
    * Registers the callback for updating the agents metadata state.
    */
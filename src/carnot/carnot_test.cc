@@ -416,6 +416,33 @@ TEST_F(CarnotTest, range_test_single_rb) {
   EXPECT_TRUE(rb1.ColumnAt(2)->Equals(types::ToArrow(col2_out1, arrow::default_memory_pool())));
 }
 
+TEST_F(CarnotTest, repeated_range_query) {
+  auto query = absl::StrJoin(
+      {
+          "import px",
+          "queryDF = px.DataFrame(table='big_test_table', select=['time_', 'col2', "
+          "'col3'], start_time=$0, end_time=$1)",
+          "px.display(queryDF, 'range_output')",
+      },
+      "\n");
+  ASSERT_OK(carnot_->ExecuteQuery(absl::Substitute(query, 2, 12), sole::uuid4(), 0));
+  EXPECT_EQ(3, result_server_->query_results("range_output").size());
+
+  // The plans only differ in their time range, so the second query reuses the prepared plan of
+  // the first one, with its range rebound.
+  result_server_->ResetQueryResults();
+  ASSERT_OK(carnot_->ExecuteQuery(absl::Substitute(query, 9, 12), sole::uuid4(), 0));
+  auto output_batches = result_server_->query_results("range_output");
+  ASSERT_EQ(1, output_batches.size());
+  auto times = static_cast<arrow::Int64Array*>(output_batches[0].ColumnAt(0).get());
+  EXPECT_LT(0, times->length());
+  for (int64_t i = 0; i < times->length(); ++i) {
+    int64_t time = times->Value(i);
+    EXPECT_GE(time, 9);
+    EXPECT_LT(time, 12);
+  }
+}
+
 TEST_F(CarnotTest, empty_range_test) {
   // Tests that a table that has no rows that fall within the query's range, doesn't write any
   // rowbatches to the output table.
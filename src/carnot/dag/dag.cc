@@ -42,6 +42,7 @@ using std::end;
 using std::vector;
 
 void DAG::Init(const planpb::DAG& dag) {
+  InvalidateTopologicalSort();
   for (const auto& node : dag.nodes()) {
     AddNode(node.id());
     for (int64_t child : node.sorted_children()) {
@@ -99,6 +100,7 @@ void DAG::ToProto(planpb::DAG* dag, const absl::flat_hash_set<int64_t>& ignore_i
 
 void DAG::AddNode(int64_t node) {
   DCHECK(!HasNode(node)) << absl::Substitute("Node: $0 already exists", node);
+  InvalidateTopologicalSort();
   nodes_.insert(node);
 
   forward_edges_by_node_[node] = {};
@@ -111,6 +113,7 @@ void DAG::DeleteNode(int64_t node) {
   if (!HasNode(node)) {
     LOG(WARNING) << absl::StrCat("Node does not exist: ", node);
   }
+  InvalidateTopologicalSort();
 
   DeleteParentEdges(node);
   DeleteDependentEdges(node);
@@ -121,6 +124,7 @@ void DAG::DeleteNode(int64_t node) {
 void DAG::AddEdge(int64_t from_node, int64_t to_node) {
   CHECK(HasNode(from_node)) << absl::Substitute("from_node $0 does not exist", from_node);
   CHECK(HasNode(to_node)) << absl::Substitute("to_node $0 does not exist", to_node);
+  InvalidateTopologicalSort();
 
   AddForwardEdge(from_node, to_node);
   AddReverseEdge(to_node, from_node);
@@ -156,11 +160,12 @@ void DAG::DeleteParentEdges(int64_t to_node) {
       forward_edges.erase(node);
     }
 
+    // Remove the entry from the map for each parent of the edge.
+    forward_edges_map_[*parent_iter].erase(to_node);
+
     // Erase points to the next valid iterator.
     // Delete to_node->parent edge.
     parent_iter = reverse_edges.erase(parent_iter);
-    // Remove the entry from the map for each parent of the edge.
-    forward_edges_map_[*parent_iter].erase(to_node);
   }
 }
 
@@ -186,6 +191,7 @@ void DAG::DeleteDependentEdges(int64_t from_node) {
 }
 
 void DAG::DeleteEdge(int64_t from_node, int64_t to_node) {
+  InvalidateTopologicalSort();
   // If there is a dependency we need to delete both the forward and backwards dependency.
   auto& forward_edges = forward_edges_by_node_[from_node];
   const auto& node = std::find(begin(forward_edges), end(forward_edges), to_node);
@@ -210,6 +216,7 @@ void DAG::ReplaceChildEdge(int64_t parent_node, int64_t old_child_node, int64_t
   CHECK(HasNode(parent_node)) << "from_node does not exist";
   CHECK(HasNode(old_child_node)) << "old_child_node does not exist";
   CHECK(HasNode(new_child_node)) << "new_child_node does not exist";
+  InvalidateTopologicalSort();
   auto& forward_edges = forward_edges_by_node_[parent_node];
 
   // Repalce the old_child_node with the new_child_node in the forward edge.
@@ -236,6 +243,7 @@ void DAG::ReplaceParentEdge(int64_t child_node, int64_t old_parent_node, int64_t
   CHECK(HasNode(child_node)) << "child_node does not exist";
   CHECK(HasNode(old_parent_node)) << "old_parent_node does not exist";
   CHECK(HasNode(new_parent_node)) << "new_parent_node does not exist";
+  InvalidateTopologicalSort();
   auto& reverse_edges = reverse_edges_by_node_[child_node];
 
   // Repalce the old_from_node with the new_from_node.
@@ -306,6 +314,13 @@ std::unordered_set<int64_t> DAG::Orphans() {
 }
 
 vector<int64_t> DAG::TopologicalSort() const {
+  if (!topological_order_.has_value()) {
+    topological_order_ = ComputeTopologicalSort();
+  }
+  return topological_order_.value();
+}
+
+vector<int64_t> DAG::ComputeTopologicalSort() const {
   if (!nodes_.size()) {
     return {};
   }
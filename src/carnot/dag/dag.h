@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -72,6 +73,12 @@ class DAG {
 
   std::unordered_set<int64_t> Orphans();
   std::unordered_set<int64_t> TransitiveDepsFrom(int64_t node);
+
+  /**
+   * @brief Returns the nodes in topological order. The order is computed once and cached until the
+   * DAG changes, since the planner rules and the IR copies ask for it over and over on the same
+   * graph. Like the rest of the DAG, not thread-safe, even though it's const.
+   */
   std::vector<int64_t> TopologicalSort() const;
 
   std::vector<int64_t> DependenciesOf(int64_t node) const {
@@ -104,6 +111,10 @@ class DAG {
   void DeleteParentEdges(int64_t to_node);
   void DeleteDependentEdges(int64_t from_node);
 
+  std::vector<int64_t> ComputeTopologicalSort() const;
+  // Called by every change to the nodes or edges.
+  void InvalidateTopologicalSort() { topological_order_.reset(); }
+
   // Store all the integer id's as nodes.
   absl::flat_hash_set<int64_t> nodes_;
 
@@ -115,6 +126,9 @@ class DAG {
   absl::flat_hash_map<int64_t, std::vector<int64_t>> reverse_edges_by_node_;
   // Used for quick lookups of edges which get really expensive at scale.
   absl::flat_hash_map<int64_t, absl::flat_hash_set<int64_t>> forward_edges_map_;
+
+  // The cached result of TopologicalSort(), if the DAG didn't change since.
+  mutable std::optional<std::vector<int64_t>> topological_order_;
 };
 
 }  // namespace plan
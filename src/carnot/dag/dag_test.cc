@@ -100,6 +100,38 @@ TEST_F(DAGTest, topological_sort) {
   EXPECT_THAT(dag_.TopologicalSort(), ElementsAre(5, 3, 6));
 }
 
+TEST_F(DAGTest, topological_sort_after_changes) {
+  // The cached order must follow every kind of change.
+  EXPECT_THAT(dag_.TopologicalSort(),
+              AnyOf(ElementsAre(20, 5, 8, 3, 6), ElementsAre(5, 20, 8, 3, 6)));
+
+  dag_.AddEdge(6, 20);
+  EXPECT_THAT(dag_.TopologicalSort(), ElementsAre(5, 8, 3, 6, 20));
+
+  dag_.DeleteEdge(3, 6);
+  dag_.AddEdge(8, 6);
+  EXPECT_THAT(dag_.TopologicalSort(),
+              AnyOf(ElementsAre(5, 8, 3, 6, 20), ElementsAre(5, 8, 6, 3, 20),
+                    ElementsAre(5, 8, 6, 20, 3)));
+
+  dag_.ReplaceChildEdge(8, 6, 20);
+  dag_.ReplaceParentEdge(20, 6, 3);
+  EXPECT_THAT(dag_.TopologicalSort(),
+              AnyOf(ElementsAre(5, 6, 8, 3, 20), ElementsAre(6, 5, 8, 3, 20)));
+
+  dag_.AddNode(1);
+  dag_.AddEdge(1, 5);
+  dag_.AddEdge(1, 6);
+  EXPECT_THAT(dag_.TopologicalSort(), ElementsAre(1, 5, 6, 8, 3, 20));
+}
+
+TEST_F(DAGTest, delete_node_removes_edges_from_parents) {
+  dag_.DeleteNode(3);
+  EXPECT_FALSE(dag_.HasEdge(5, 3));
+  EXPECT_FALSE(dag_.HasEdge(8, 3));
+  EXPECT_TRUE(dag_.HasEdge(5, 8));
+}
+
 using DAGDeathTest = DAGTest;
 TEST_F(DAGDeathTest, check_add_duplicate) { EXPECT_DEBUG_DEATH(dag_.AddNode(5), ".*"); }
 
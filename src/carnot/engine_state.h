@@ -57,7 +57,9 @@ class EngineState : public NotCopyable {
         stub_generator_(stub_generator),
         add_auth_to_grpc_context_func_(add_auth_to_grpc_context_func),
         grpc_router_(grpc_router),
-        model_pool_(std::move(model_pool)) {}
+        model_pool_(std::move(model_pool)),
+        shared_scans_(exec::SharedScanCoordinator::CreateFromFlags()),
+        fragment_cache_(exec::FragmentCache::CreateFromFlags()) {}
 
   static StatusOr<std::unique_ptr<EngineState>> CreateDefault(
       std::unique_ptr<udf::Registry> func_registry,
@@ -80,9 +82,12 @@ class EngineState : public NotCopyable {
 
   table_store::TableStore* table_store() { return table_store_.get(); }
   std::unique_ptr<exec::ExecState> CreateExecState(const sole::uuid& query_id) {
-    return std::make_unique<exec::ExecState>(func_registry_.get(), table_store_, stub_generator_,
-                                             query_id, model_pool_.get(), grpc_router_,
-                                             add_auth_to_grpc_context_func_);
+    auto exec_state = std::make_unique<exec::ExecState>(
+        func_registry_.get(), table_store_, stub_generator_, query_id, model_pool_.get(),
+        grpc_router_, add_auth_to_grpc_context_func_);
+    exec_state->set_shared_scans(shared_scans_.get());
+    exec_state->set_fragment_cache(fragment_cache_.get());
+    return exec_state;
   }
 
   std::unique_ptr<plan::PlanState> CreatePlanState() {
@@ -115,6 +120,10 @@ class EngineState : public NotCopyable {
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_context_func_;
   exec::GRPCRouter* grpc_router_ = nullptr;
   std::unique_ptr<exec::ml::ModelPool> model_pool_;
+  // Shared by the queries of this engine, nullptr if shared scans are disabled.
+  std::unique_ptr<exec::SharedScanCoordinator> shared_scans_;
+  // Shared by the queries of this engine, nullptr if fragment caching is disabled.
+  std::unique_ptr<exec::FragmentCache> fragment_cache_;
 };
 
 }  // namespace carnot
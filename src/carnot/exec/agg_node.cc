@@ -23,10 +23,16 @@
 #include <arrow/status.h>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <thread>
 
+#include <absl/container/flat_hash_set.h>
+#include <absl/hash/hash.h>
+#include <absl/strings/substitute.h>
 #include <magic_enum.hpp>
 
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/hash_kernels.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/carnot/udf/udf_wrapper.h"
@@ -35,12 +41,32 @@
 #include "src/shared/types/type_utils.h"
 #include "src/shared/types/types.h"
 
+DEFINE_int32(carnot_agg_merge_parallelism,
+             gflags::Int32FromEnv("PL_CARNOT_AGG_MERGE_PARALLELISM", 1),
+             "The number of threads an aggregate merges the partial aggregates of a batch on.");
+DEFINE_int64(carnot_agg_memory_budget_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_AGG_MEMORY_BUDGET_BYTES", 0),
+             "The estimated number of bytes of groups a blocking aggregate keeps in memory before "
+             "it spills them to disk. Set to '0' to only spill when the query is over its soft "
+             "memory limit.");
+DEFINE_int32(carnot_agg_spill_partitions, 16,
+             "The number of partitions a blocking aggregate splits the groups it spills into. "
+             "Rounded up to a power of two.");
+DEFINE_string(carnot_agg_spill_dir, gflags::StringFromEnv("PL_CARNOT_AGG_SPILL_DIR", "/tmp"),
+              "The directory the aggregate spill files are created in.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 
 using SharedArray = std::shared_ptr<arrow::Array>;
 constexpr int64_t kAggCompactionThreshold = 512;
+// The fewest rows of a batch each merge thread gets, below that the threads cost more than they
+// save.
+constexpr int64_t kMinRowsPerMergeThread = 1024;
+// The UDAs are allocated one by one rather than in the arenas, so the memory of their states is
+// estimated when deciding whether to spill.
+constexpr int64_t kUDAStateBytesEstimate = 64;
 
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
@@ -65,19 +91,59 @@ void AppendToBuilder(arrow::ArrayBuilder* builder, RowTuple* rt, size_t rt_idx)
 }
 
 template <types::DataType DT>
-void ExtractToColumnWrapper(const std::vector<GroupArgs>& group_args,
+void ExtractToColumnWrapper(const std::vector<AggHashValue*>& row_agg_values,
                             const table_store::schema::RowBatch& rb, size_t col_idx,
                             size_t rb_col_idx) {
   size_t num_rows = rb.num_rows();
-  DCHECK(num_rows <= group_args.size());
+  DCHECK(num_rows <= row_agg_values.size());
   for (size_t row_idx = 0; row_idx < num_rows; ++row_idx) {
-    DCHECK(group_args[row_idx].av != nullptr);
-    auto col_wrapper = group_args[row_idx].av->agg_cols[col_idx].get();
+    DCHECK(row_agg_values[row_idx] != nullptr);
+    auto col_wrapper = row_agg_values[row_idx]->agg_cols[col_idx].get();
     auto arr = rb.ColumnAt(rb_col_idx).get();
     types::ExtractValueToColumnWrapper<DT>(col_wrapper, arr, row_idx);
   }
 }
 
+Status MergeUDAs(const std::vector<UDAInfo>& dst, const std::vector<UDAInfo>& src,
+                 udf::FunctionContext* ctx) {
+  DCHECK_EQ(dst.size(), src.size());
+  for (size_t i = 0; i < dst.size(); ++i) {
+    PL_RETURN_IF_ERROR(dst[i].def->Merge(dst[i].uda.get(), src[i].uda.get(), ctx));
+  }
+  return Status::OK();
+}
+
+// The partial states of the UDAs of a group are packed into the one serialized column of a
+// partial aggregate, each prefixed with its size.
+void AppendPartialState(const std::string& state, std::string* out) {
+  uint64_t size = state.size();
+  out->append(reinterpret_cast<const char*>(&size), sizeof(size));
+  out->append(state);
+}
+
+StatusOr<std::string_view> NextPartialState(std::string_view* data) {
+  uint64_t size = 0;
+  if (data->size() < sizeof(size)) {
+    return error::Internal("Truncated partial aggregate state.");
+  }
+  std::memcpy(&size, data->data(), sizeof(size));
+  data->remove_prefix(sizeof(size));
+  if (data->size() < size) {
+    return error::Internal("Truncated partial aggregate state.");
+  }
+  auto state = data->substr(0, size);
+  data->remove_prefix(size);
+  return state;
+}
+
+// Picks the partition from the high bits of the hash, the hash map buckets use the low ones.
+size_t PartitionIndex(size_t hash, int partition_bits) {
+  if (partition_bits == 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(hash) >> (64 - partition_bits);
+}
+
 }  // namespace
 
 std::string AggNode::DebugStringImpl() {
@@ -106,10 +172,30 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     }
   }
 
-  size_t output_size = plan_node_->values().size() + plan_node_->groups().size();
+  emit_partial_states_ = plan_node_->partial_agg() && !plan_node_->finalize_results();
+  merge_partial_states_ = plan_node_->finalize_results() && !plan_node_->partial_agg();
+
+  auto groups_size = plan_node_->groups().size();
+  // A partial aggregate emits all its values in one serialized column.
+  size_t output_size = (emit_partial_states_ ? 1 : plan_node_->values().size()) + groups_size;
   if (output_size != output_descriptor_->size()) {
     return error::InvalidArgument("Output size mismatch in aggregate");
   }
+  for (size_t values_idx = groups_size; values_idx < output_size; ++values_idx) {
+    value_data_types_.emplace_back(output_descriptor_->type(values_idx));
+  }
+
+  if (merge_partial_states_) {
+    // The partial states follow the groups, see AggOperatorMgr.
+    partial_states_col_idx_ = input_descriptor_->size() - 1;
+    if (input_descriptor_->size() != groups_size + 1 ||
+        input_descriptor_->type(partial_states_col_idx_) != types::STRING) {
+      return error::InvalidArgument(
+          "Aggregate expects the groups and a serialized column as the partial aggregates, got "
+          "$0 columns",
+          input_descriptor_->size());
+    }
+  }
 
   if (HasNoGroups()) {
     return Status::OK();
@@ -119,22 +205,21 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
    * Init specific for group by agg.
    */
 
-  // Compute the group and value data types.
-  // The case of GroupByNone, there will be no groups.
-  auto groups_size = plan_node_->groups().size();
+  // Compute the group data types.
   group_data_types_.reserve(groups_size);
   for (const auto& group : plan_node_->groups()) {
     DCHECK(group.idx < input_descriptor_->size());
     group_data_types_.emplace_back(input_descriptor_->type(group.idx));
   }
-
-  auto values_size = plan_node_->values().size();
-  for (size_t i = 0; i < values_size; ++i) {
-    auto values_idx = i + groups_size;
-    DCHECK(values_idx < output_descriptor_->size());
-    value_data_types_.emplace_back(output_descriptor_->type(values_idx));
+  if (GroupKeyLayout::Supports(group_data_types_)) {
+    group_key_layout_ = std::make_unique<GroupKeyLayout>(group_data_types_);
   }
 
+  if (merge_partial_states_) {
+    // The values of the plan refer to the input of the partial aggregate, so there is nothing
+    // to store for them here.
+    return Status::OK();
+  }
   return CreateColumnMapping();
 }
 
@@ -144,8 +229,44 @@ Status AggNode::PrepareImpl(ExecState* exec_state) {
 }
 
 Status AggNode::OpenImpl(ExecState* exec_state) {
+  if (emit_partial_states_ || merge_partial_states_) {
+    for (const auto& value : plan_node_->values()) {
+      if (!exec_state->GetUDADefinition(value->uda_id())->supports_partial()) {
+        return error::InvalidArgument("UDA '$0' doesn't support partial aggregation.",
+                                      value->name());
+      }
+    }
+  }
+  last_emit_ns_ = CurrentTimeNS();
   if (HasNoGroups()) {
     PL_RETURN_IF_ERROR(CreateUDAInfoValues(&udas_no_groups_, exec_state));
+    return Status::OK();
+  }
+  // Constant arguments would have to be materialized for every group of every batch, so those
+  // aggregates keep copying the values into agg_cols instead.
+  update_on_selections_ = !plan_node_->values().empty() && !merge_partial_states_;
+  for (const auto& value : plan_node_->values()) {
+    auto def = exec_state->GetUDADefinition(value->uda_id());
+    update_on_selections_ &= def->has_update_batch_selection();
+    for (const auto* dep : value->Deps()) {
+      update_on_selections_ &= dep->ExpressionType() == plan::Expression::kColumn;
+    }
+  }
+
+  // The spilled groups are partial states, and windowed and standing aggregates emit before the
+  // end of their input, so they don't hold on to that many groups.
+  spill_enabled_ = !emit_partial_states_ && !plan_node_->windowed() && !plan_node_->standing();
+  for (const auto& value : plan_node_->values()) {
+    spill_enabled_ &= exec_state->GetUDADefinition(value->uda_id())->supports_partial();
+  }
+  if (spill_enabled_) {
+    while ((1 << spill_partition_bits_) < FLAGS_carnot_agg_spill_partitions &&
+           spill_partition_bits_ < 16) {
+      ++spill_partition_bits_;
+    }
+    std::vector<types::DataType> spill_types = group_data_types_;
+    spill_types.push_back(types::STRING);
+    spill_descriptor_ = std::make_unique<RowDescriptor>(spill_types);
   }
   return Status::OK();
 }
@@ -154,20 +275,94 @@ Status AggNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_
   if (HasNoGroups()) {
     return AggregateGroupByNone(exec_state, rb);
   }
+  if (rb.HasDictionaryColumns()) {
+    PL_ASSIGN_OR_RETURN(auto decoded_rb, DecodeValueDictionaries(exec_state, rb));
+    return AggregateGroupByClause(exec_state, *decoded_rb);
+  }
   return AggregateGroupByClause(exec_state, rb);
 }
 
+StatusOr<std::unique_ptr<RowBatch>> AggNode::DecodeValueDictionaries(ExecState* exec_state,
+                                                                     const RowBatch& rb) const {
+  absl::flat_hash_set<int64_t> group_cols;
+  for (const auto& grp : plan_node_->groups()) {
+    group_cols.insert(grp.idx);
+  }
+  auto decoded_rb = std::make_unique<RowBatch>(rb.desc(), rb.num_rows());
+  for (int64_t col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+    auto col = rb.ColumnAt(col_idx);
+    if (!group_cols.contains(col_idx)) {
+      PL_ASSIGN_OR_RETURN(col, types::DecodeDictionaryArray(col, exec_state->exec_mem_pool()));
+    }
+    PL_RETURN_IF_ERROR(decoded_rb->AddColumn(col));
+  }
+  decoded_rb->set_selection(rb.selection());
+  decoded_rb->set_eow(rb.eow());
+  decoded_rb->set_eos(rb.eos());
+  return decoded_rb;
+}
+
 Status AggNode::CloseImpl(ExecState*) {
   udas_no_groups_.clear();
   group_args_chunk_.clear();
+  group_keys_chunk_.clear();
+  row_agg_values_.clear();
+  selected_values_.clear();
+  agg_hash_map_.clear();
+  group_key_hash_map_.clear();
   group_args_pool_.Clear();
   udas_pool_.Clear();
+  spill_files_.clear();
 
   return Status::OK();
 }
 
 bool AggNode::ReadyToEmitBatches(const RowBatch& rb) const {
-  return rb.eos() || (rb.eow() && plan_node_->windowed());
+  return rb.eos() || (rb.eow() && plan_node_->windowed()) || StandingEmitDue();
+}
+
+bool AggNode::StandingEmitDue() const {
+  if (!plan_node_->standing()) {
+    return false;
+  }
+  bool has_updates = HasNoGroups() ? no_groups_updated_ : num_updated_groups_ > 0;
+  return has_updates && CurrentTimeNS() - last_emit_ns_ >= plan_node_->emit_interval_ns();
+}
+
+void AggNode::MarkUpdatedGroups() {
+  int64_t now = CurrentTimeNS();
+  for (auto* val : row_agg_values_) {
+    if (val == nullptr) {
+      continue;
+    }
+    if (!val->updated) {
+      val->updated = true;
+      ++num_updated_groups_;
+    }
+    val->last_update_ns = now;
+  }
+}
+
+void AggNode::ExpireGroups() {
+  if (plan_node_->group_ttl_ns() <= 0) {
+    return;
+  }
+  int64_t min_update_ns = CurrentTimeNS() - plan_node_->group_ttl_ns();
+  auto expire = [min_update_ns](auto* map) {
+    for (auto it = map->begin(); it != map->end();) {
+      AggHashValue* val = it->second;
+      if (val->last_update_ns >= min_update_ns) {
+        ++it;
+        continue;
+      }
+      // The values stay in the pool until the node is closed, but not their UDAs.
+      val->udas.clear();
+      val->agg_cols.clear();
+      map->erase(it++);
+    }
+  };
+  expire(&agg_hash_map_);
+  expire(&group_key_hash_map_);
 }
 
 Status AggNode::ClearAggState(ExecState* exec_state) {
@@ -176,66 +371,129 @@ Status AggNode::ClearAggState(ExecState* exec_state) {
     PL_RETURN_IF_ERROR(CreateUDAInfoValues(&udas_no_groups_, exec_state));
   }
   agg_hash_map_.clear();
+  group_key_hash_map_.clear();
   return Status::OK();
 }
 
+void AggNode::ReleaseGroups() {
+  agg_hash_map_.clear();
+  group_key_hash_map_.clear();
+  // The row tuples of the chunk are in the pool too, ExtractRowTupleForBatch() makes new ones.
+  group_args_chunk_.clear();
+  group_args_pool_.Clear();
+  udas_pool_.Clear();
+}
+
 Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb) {
-  auto values = plan_node_->values();
-  for (size_t i = 0; i < values.size(); ++i) {
-    PL_RETURN_IF_ERROR(
-        EvaluateSingleExpressionNoGroups(exec_state, udas_no_groups_[i], values[i].get(), rb));
+  no_groups_updated_ |= rb.num_rows() > 0;
+  if (merge_partial_states_) {
+    PL_RETURN_IF_ERROR(MergePartialStates(exec_state, rb));
+  } else {
+    auto values = plan_node_->values();
+    for (size_t i = 0; i < values.size(); ++i) {
+      PL_RETURN_IF_ERROR(
+          EvaluateSingleExpressionNoGroups(exec_state, udas_no_groups_[i], values[i].get(), rb));
+    }
   }
 
   if (ReadyToEmitBatches(rb)) {
-    RowBatch output_rb(*output_descriptor_, 1);
-    for (size_t i = 0; i < values.size(); ++i) {
-      const auto& uda_info = udas_no_groups_[i];
-      auto builder = types::MakeArrowBuilder(uda_info.def->finalize_return_type(),
-                                             exec_state->exec_mem_pool());
-      PL_RETURN_IF_ERROR(
-          uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(), builder.get()));
+    PL_RETURN_IF_ERROR(EmitAggState(exec_state, rb.eow(), rb.eos(), /* emitted */ nullptr));
+  }
+  return Status::OK();
+}
+
+Status AggNode::EmitAggState(ExecState* exec_state, bool eow, bool eos,
+                             std::unique_ptr<RowBatch>* emitted) {
+  bool updated_only = EmitsUpdatedGroups();
+  int64_t num_rows = HasNoGroups() ? 1 : (updated_only ? num_updated_groups_ : NumGroups());
+  RowBatch output_rb(*output_descriptor_, num_rows);
+  if (HasNoGroups()) {
+    std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+    for (const auto& value_data_type : value_data_types_) {
+      builders.push_back(types::MakeArrowBuilder(value_data_type, exec_state->exec_mem_pool()));
+    }
+    PL_RETURN_IF_ERROR(AppendResults(udas_no_groups_, builders));
+    for (const auto& builder : builders) {
       SharedArray out_col;
       PL_RETURN_IF_ERROR(builder->Finish(&out_col));
       PL_RETURN_IF_ERROR(output_rb.AddColumn(out_col));
     }
-    output_rb.set_eow(rb.eow());
-    output_rb.set_eos(rb.eos());
-    PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
-    PL_RETURN_IF_ERROR(ClearAggState(exec_state));
+  } else {
+    PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, updated_only, &output_rb));
   }
-  return Status::OK();
+  output_rb.set_eow(eow);
+  output_rb.set_eos(eos);
+  PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+  if (emitted != nullptr) {
+    *emitted = std::make_unique<RowBatch>(output_rb);
+  }
+  last_emit_ns_ = CurrentTimeNS();
+  num_updated_groups_ = 0;
+  no_groups_updated_ = false;
+  if (updated_only) {
+    ExpireGroups();
+    return Status::OK();
+  }
+  return ClearAggState(exec_state);
+}
+
+Status AggNode::EmitPartialStates(ExecState* exec_state, std::unique_ptr<RowBatch>* emitted) {
+  DCHECK(emit_partial_states_);
+  TrackingMemoryPool::ScopedCurrent scoped_pool(mem_pool());
+  return EmitAggState(exec_state, /* eow */ false, /* eos */ false, emitted);
+}
+
+Status AggNode::SendPartialStates(ExecState* exec_state, const RowBatch& rb) {
+  DCHECK(emit_partial_states_);
+  DCHECK(!rb.eow() && !rb.eos());
+  TrackingMemoryPool::ScopedCurrent scoped_pool(mem_pool());
+  return SendRowBatchToChildren(exec_state, rb);
 }
 
-Status AggNode::ExtractRowTupleForBatch(const RowBatch& rb) {
+std::vector<arrow::Array*> AggNode::GroupColumns(const RowBatch& rb) const {
+  std::vector<arrow::Array*> group_cols;
+  group_cols.reserve(plan_node_->groups().size());
+  for (const auto& grp : plan_node_->groups()) {
+    DCHECK(grp.idx < input_descriptor_->size());
+    group_cols.push_back(rb.ColumnAt(grp.idx).get());
+  }
+  return group_cols;
+}
+
+Status AggNode::ExtractRowTupleForBatch(const std::vector<arrow::Array*>& group_cols,
+                                        int64_t num_rows) {
   // Grow the group_args_chunk_ to be the size of the RowBatch.
-  size_t num_rows = rb.num_rows();
-  if (group_args_chunk_.size() < num_rows) {
+  if (group_args_chunk_.size() < static_cast<size_t>(num_rows)) {
     int prev_size = group_args_chunk_.size();
     group_args_chunk_.reserve(num_rows);
-    for (size_t idx = prev_size; idx < num_rows; ++idx) {
+    for (int64_t idx = prev_size; idx < num_rows; ++idx) {
       group_args_chunk_.emplace_back(CreateGroupArgsRowTuple());
     }
   }
 
   // Scan through all the group args in column order and extract the entire column.
-  for (size_t idx = 0; idx < plan_node_->groups().size(); idx++) {
-    auto grp = plan_node_->groups()[idx];
-    DCHECK(grp.idx < input_descriptor_->size());
+  for (size_t idx = 0; idx < group_cols.size(); idx++) {
     DCHECK(idx < group_data_types_.size());
     auto dt = group_data_types_[idx];
-    auto col = rb.ColumnAt(grp.idx).get();
+    auto col = group_cols[idx];
 
 #define TYPE_CASE(_dt_) ExtractIntoGroupArgs<_dt_>(&group_args_chunk_, col, idx);
     PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
 #undef TYPE_CASE
   }
+
+  // The hashes are computed a column at a time as well, rather than by each lookup.
+  HashColumns({group_cols.begin(), group_cols.end()}, group_data_types_, num_rows, &row_hashes_);
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    group_args_chunk_[row_idx].rt->SetHash(row_hashes_[row_idx]);
+  }
   return Status::OK();
 }
 
 Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
-  PL_UNUSED(exec_state);
   // Loop through all the row and basically store the values into column chunk based on which
   // group they belong to.
+  row_agg_values_.resize(rb.num_rows());
   for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
     auto& ga = group_args_chunk_[row_idx];
     AggHashValue* val = nullptr;
@@ -252,16 +510,40 @@ Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
     } else {
       val = it->second;
     }
-    ga.av = val;
+    row_agg_values_[row_idx] = val;
+  }
+  return Status::OK();
+}
+
+Status AggNode::HashRowBatchWithGroupKeys(ExecState* exec_state, const RowBatch& rb,
+                                          const std::vector<arrow::Array*>& group_cols) {
+  group_key_layout_->ExtractKeys({group_cols.begin(), group_cols.end()}, rb.num_rows(),
+                                 &group_keys_chunk_);
+
+  // row_agg_values_ has the group of each selected row.
+  row_agg_values_.resize(rb.num_selected_rows());
+  for (auto i = 0; i < rb.num_selected_rows(); ++i) {
+    auto row_idx = rb.has_selection() ? (*rb.selection())[i] : i;
+    const auto& key = group_keys_chunk_[row_idx];
+    auto it = group_key_hash_map_.find(key);
+    if (it == group_key_hash_map_.end()) {
+      // The view points into the batch, so the map gets its own copy of the string.
+      it = group_key_hash_map_
+               .emplace(GroupKey{key.hash, key.words, std::string(key.str)},
+                        CreateAggHashValue(exec_state))
+               .first;
+    }
+    row_agg_values_[i] = it->second;
   }
+  return Status::OK();
+}
 
-  auto values = plan_node_->values();
-  // Now extract the values in the agg hash value.
+Status AggNode::ExtractAggValues(const RowBatch& rb) {
   for (size_t i = 0; i < stored_cols_data_types_.size(); ++i) {
     const auto& rb_col_idx = stored_cols_to_plan_idx_[i];
     const auto& dt = input_descriptor_->type(rb_col_idx);
 
-#define TYPE_CASE(_dt_) ExtractToColumnWrapper<_dt_>(group_args_chunk_, rb, i, rb_col_idx);
+#define TYPE_CASE(_dt_) ExtractToColumnWrapper<_dt_>(row_agg_values_, rb, i, rb_col_idx);
 
     PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
 #undef TYPE_CASE
@@ -275,22 +557,47 @@ Status AggNode::EvaluatePartialAggregates(ExecState* exec_state, size_t num_reco
   // TODO(zasgar): This only needs to run for unique groups. We should find
   // a way to optimize this.
   for (size_t i = 0; i < num_records; ++i) {
-    DCHECK(i < group_args_chunk_.size());
-    auto& ga = group_args_chunk_[i];
-    DCHECK(ga.av != nullptr);
-    if (ga.av->agg_cols[0]->Size() > kAggCompactionThreshold) {
-      PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, ga.av));
+    DCHECK(i < row_agg_values_.size());
+    auto* val = row_agg_values_[i];
+    DCHECK(val != nullptr);
+    if (val->agg_cols[0]->Size() > kAggCompactionThreshold) {
+      PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
     }
   }
   return Status::OK();
 }
 
+Status AggNode::UpdateOnSelections(ExecState* exec_state, const RowBatch& rb) {
+  // The input columns are converted once per batch and shared by all the groups.
+  std::vector<types::SharedColumnWrapper> cols;
+  cols.reserve(stored_cols_to_plan_idx_.size());
+  for (const auto& rb_col_idx : stored_cols_to_plan_idx_) {
+    cols.push_back(types::ColumnWrapper::FromArrow(rb.ColumnAt(rb_col_idx)));
+  }
+
+  selected_values_.clear();
+  for (auto i = 0; i < rb.num_selected_rows(); ++i) {
+    auto row_idx = rb.has_selection() ? (*rb.selection())[i] : i;
+    auto* val = row_agg_values_[i];
+    DCHECK(val != nullptr);
+    if (val->selected_rows.empty()) {
+      selected_values_.push_back(val);
+    }
+    val->selected_rows.push_back(row_idx);
+  }
+
+  for (auto* val : selected_values_) {
+    PL_RETURN_IF_ERROR(UpdateUDAs(exec_state, val, cols, rb.num_rows(), &val->selected_rows));
+    val->selected_rows.clear();
+  }
+  return Status::OK();
+}
+
 Status AggNode::ResetGroupArgs() {
   // Reset the group args. If the row tuple is null it has been consumed, so
-  // we can replace it with a new RowTuple. We also reset the
-  // agg hash value to nullptr.
+  // we can replace it with a new RowTuple.
+  std::fill(row_agg_values_.begin(), row_agg_values_.end(), nullptr);
   for (size_t i = 0; i < group_args_chunk_.size(); ++i) {
-    group_args_chunk_[i].av = nullptr;
     if (group_args_chunk_[i].rt == nullptr) {
       group_args_chunk_[i].rt = CreateGroupArgsRowTuple();
     } else {
@@ -300,7 +607,8 @@ Status AggNode::ResetGroupArgs() {
   return Status::OK();
 }
 
-Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* output_rb) {
+Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, bool updated_only,
+                                            RowBatch* output_rb) {
   PL_UNUSED(exec_state);
   DCHECK(output_rb != nullptr);
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> group_builders;
@@ -313,24 +621,25 @@ Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* out
   }
 
   // Agg into agg values and emit!
+  if (group_key_layout_ != nullptr) {
+    for (const auto& [key, val] : group_key_hash_map_) {
+      if (updated_only && !val->updated) {
+        continue;
+      }
+      val->updated = false;
+      PL_RETURN_IF_ERROR(group_key_layout_->AppendToBuilders(key, group_builders));
+      PL_RETURN_IF_ERROR(FinalizeAggHashValue(exec_state, val, value_builders));
+    }
+  }
   for (const auto& kv : agg_hash_map_) {
     auto* groups_rt = kv.first;
     auto* val = kv.second;
-
-    for (size_t i = 0; i < group_data_types_.size(); ++i) {
-      DCHECK(i < group_builders.size());
-
-#define TYPE_CASE(_dt_) AppendToBuilder<_dt_>(group_builders[i].get(), groups_rt, i);
-      PL_SWITCH_FOREACH_DATATYPE(group_data_types_[i], TYPE_CASE);
-#undef TYPE_CASE
-    }
-    // Actually Finalize the UDA based on the column wrapper chunks.
-    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
-    for (size_t i = 0; i < val->udas.size(); ++i) {
-      const auto& uda_info = val->udas[i];
-      PL_RETURN_IF_ERROR(uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(),
-                                                     value_builders[i].get()));
+    if (updated_only && !val->updated) {
+      continue;
     }
+    val->updated = false;
+    AppendRowTupleToBuilders(groups_rt, group_builders);
+    PL_RETURN_IF_ERROR(FinalizeAggHashValue(exec_state, val, value_builders));
   }
 
   for (const auto& group_builder : group_builders) {
@@ -348,6 +657,181 @@ Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* out
   return Status::OK();
 }
 
+void AggNode::AppendRowTupleToBuilders(
+    RowTuple* rt, const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders) {
+  for (size_t i = 0; i < group_data_types_.size(); ++i) {
+    DCHECK(i < builders.size());
+
+#define TYPE_CASE(_dt_) AppendToBuilder<_dt_>(builders[i].get(), rt, i);
+    PL_SWITCH_FOREACH_DATATYPE(group_data_types_[i], TYPE_CASE);
+#undef TYPE_CASE
+  }
+}
+
+Status AggNode::FinalizeAggHashValue(
+    ExecState* exec_state, AggHashValue* val,
+    const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders) {
+  // Actually Finalize the UDA based on the column wrapper chunks.
+  if (!update_on_selections_ && !val->agg_cols.empty()) {
+    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
+  }
+  return AppendResults(val->udas, builders);
+}
+
+Status AggNode::AppendResults(const std::vector<UDAInfo>& udas,
+                              const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders) {
+  if (emit_partial_states_) {
+    DCHECK_EQ(builders.size(), 1ULL);
+    return AppendPartialStates(udas, builders[0].get());
+  }
+  for (size_t i = 0; i < udas.size(); ++i) {
+    const auto& uda_info = udas[i];
+    PL_RETURN_IF_ERROR(
+        uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(), builders[i].get()));
+  }
+  return Status::OK();
+}
+
+Status AggNode::AppendPartialStates(const std::vector<UDAInfo>& udas,
+                                    arrow::ArrayBuilder* builder) {
+  std::string states;
+  for (const auto& uda_info : udas) {
+    PL_ASSIGN_OR_RETURN(auto state,
+                        uda_info.def->Serialize(uda_info.uda.get(), function_ctx_.get()));
+    AppendPartialState(state, &states);
+  }
+  return static_cast<arrow::StringBuilder*>(builder)->Append(states);
+}
+
+Status AggNode::MergePartialState(std::string_view state, const std::vector<UDAInfo>& udas,
+                                  const std::vector<std::unique_ptr<udf::UDA>>& scratch) {
+  for (size_t i = 0; i < udas.size(); ++i) {
+    PL_ASSIGN_OR_RETURN(auto uda_state, NextPartialState(&state));
+    const auto& uda_info = udas[i];
+    PL_RETURN_IF_ERROR(
+        uda_info.def->Deserialize(scratch[i].get(), function_ctx_.get(),
+                                  types::StringValue(uda_state.data(), uda_state.size())));
+    PL_RETURN_IF_ERROR(
+        uda_info.def->Merge(uda_info.uda.get(), scratch[i].get(), function_ctx_.get()));
+  }
+  if (!state.empty()) {
+    return error::Internal("Partial aggregate state has $0 extra bytes.", state.size());
+  }
+  return Status::OK();
+}
+
+Status AggNode::MergePartialStateRows(ExecState* exec_state, const arrow::StringArray* states,
+                                      size_t partition, size_t num_partitions) {
+  std::vector<std::unique_ptr<udf::UDA>> scratch;
+  for (const auto& value : plan_node_->values()) {
+    scratch.push_back(exec_state->GetUDADefinition(value->uda_id())->Make());
+  }
+
+  if (HasNoGroups()) {
+    for (int64_t row_idx = 0; row_idx < states->length(); ++row_idx) {
+      PL_RETURN_IF_ERROR(MergePartialState(states->GetView(row_idx), udas_no_groups_, scratch));
+    }
+    return Status::OK();
+  }
+
+  absl::Hash<const AggHashValue*> hasher;
+  for (int64_t row_idx = 0; row_idx < states->length(); ++row_idx) {
+    auto* val = row_agg_values_[row_idx];
+    DCHECK(val != nullptr);
+    // Every row of a group falls in the same partition, so no two threads touch a group.
+    if (num_partitions > 1 && hasher(val) % num_partitions != partition) {
+      continue;
+    }
+    PL_RETURN_IF_ERROR(MergePartialState(states->GetView(row_idx), val->udas, scratch));
+  }
+  return Status::OK();
+}
+
+Status AggNode::MergePartialStates(ExecState* exec_state, const RowBatch& rb) {
+  if (rb.num_rows() == 0) {
+    return Status::OK();
+  }
+  auto* states =
+      static_cast<const arrow::StringArray*>(rb.ColumnAt(partial_states_col_idx_).get());
+  size_t num_threads = 1;
+  if (!HasNoGroups() && FLAGS_carnot_agg_merge_parallelism > 1) {
+    num_threads = std::clamp<int64_t>(rb.num_rows() / kMinRowsPerMergeThread, 1,
+                                      FLAGS_carnot_agg_merge_parallelism);
+  }
+  if (num_threads == 1) {
+    return MergePartialStateRows(exec_state, states, 0, 1);
+  }
+
+  std::vector<Status> statuses(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back([this, exec_state, states, &statuses, i, num_threads] {
+      statuses[i] = MergePartialStateRows(exec_state, states, i, num_threads);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& s : statuses) {
+    PL_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
+Status AggNode::MergeAggHashValue(ExecState* exec_state, AggNode* other,
+                                  AggHashValue* other_val, AggHashValue* val) {
+  // Fold the values other still holds into its UDAs before merging them.
+  if (!other->update_on_selections_ && !other_val->agg_cols.empty()) {
+    PL_RETURN_IF_ERROR(other->EvaluateAggHashValue(exec_state, other_val));
+  }
+  return MergeUDAs(val->udas, other_val->udas, function_ctx_.get());
+}
+
+Status AggNode::MergePartialAggregates(ExecState* exec_state, AggNode* other) {
+  DCHECK(!plan_node_->windowed());
+  DCHECK_EQ(update_on_selections_, other->update_on_selections_);
+  if (HasNoGroups()) {
+    return MergeUDAs(udas_no_groups_, other->udas_no_groups_, function_ctx_.get());
+  }
+
+  for (const auto& [key, other_val] : other->group_key_hash_map_) {
+    auto it = group_key_hash_map_.find(key);
+    if (it == group_key_hash_map_.end()) {
+      it = group_key_hash_map_.emplace(key, CreateAggHashValue(exec_state)).first;
+    }
+    PL_RETURN_IF_ERROR(MergeAggHashValue(exec_state, other, other_val, it->second));
+  }
+  for (const auto& [other_rt, other_val] : other->agg_hash_map_) {
+    auto it = agg_hash_map_.find(other_rt);
+    if (it == agg_hash_map_.end()) {
+      // The key is owned by the pool of other, so the map gets its own copy.
+      auto* rt = CreateGroupArgsRowTuple();
+      rt->fixed_values = other_rt->fixed_values;
+      rt->variable_values = other_rt->variable_values;
+      it = agg_hash_map_.emplace(rt, CreateAggHashValue(exec_state)).first;
+    }
+    PL_RETURN_IF_ERROR(MergeAggHashValue(exec_state, other, other_val, it->second));
+  }
+
+  // Both nodes partition the groups the same way, so the groups other spilled go to the same
+  // partitions here.
+  for (size_t partition_idx = 0; partition_idx < other->spill_files_.size(); ++partition_idx) {
+    auto& other_spill = other->spill_files_[partition_idx];
+    if (other_spill == nullptr) {
+      continue;
+    }
+    PL_RETURN_IF_ERROR(other_spill->Rewind());
+    while (true) {
+      PL_ASSIGN_OR_RETURN(auto spilled_rb, other_spill->ReadNext());
+      if (spilled_rb == nullptr) {
+        break;
+      }
+      PL_RETURN_IF_ERROR(AppendToSpillFile(partition_idx, *spilled_rb));
+    }
+  }
+  return Status::OK();
+}
+
 Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb) {
   // Extracts the row tuples (column wise).
   // TODO(zasgar): PL-455 - Chunk this so we don't create a crazy number of row tuples if the batch
@@ -357,20 +841,191 @@ Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb
   // 3. If the agg values are large then run aggregate and compact.
   // 4. Reset state to prepare for next row batch.
   // 5. If it's the last batch then emit the values.
-  PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(rb));
-  PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
-  if (plan_node_->values().size() > 0) {
-    PL_RETURN_IF_ERROR(EvaluatePartialAggregates(exec_state, rb.num_rows()));
+  //
+  // When the groups fit in a GroupKey, steps 1 and 2 instead extract the keys of the whole batch
+  // a column at a time and look them up in group_key_hash_map_.
+  //
+  // When the UDAs support it, steps 2 and 3 instead update the UDAs on the rows of each group.
+  //
+  // When merging partial aggregates, steps 2 and 3 instead merge the partial states of each row
+  // into the UDAs of its group.
+  //
+  // Blocking aggregates that are over their memory budget spill their groups after step 4, and
+  // step 5 then merges the spilled groups.
+  auto group_cols = GroupColumns(rb);
+  if (group_key_layout_ != nullptr) {
+    PL_RETURN_IF_ERROR(HashRowBatchWithGroupKeys(exec_state, rb, group_cols));
+  } else {
+    PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(group_cols, rb.num_rows()));
+    PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
+  }
+  if (merge_partial_states_) {
+    PL_RETURN_IF_ERROR(MergePartialStates(exec_state, rb));
+  } else if (update_on_selections_) {
+    PL_RETURN_IF_ERROR(UpdateOnSelections(exec_state, rb));
+  } else {
+    PL_RETURN_IF_ERROR(ExtractAggValues(rb));
+    if (plan_node_->values().size() > 0) {
+      PL_RETURN_IF_ERROR(EvaluatePartialAggregates(exec_state, rb.num_rows()));
+    }
+  }
+  if (plan_node_->standing()) {
+    MarkUpdatedGroups();
   }
   PL_RETURN_IF_ERROR(ResetGroupArgs());
+  if (spill_enabled_ && !rb.eos() && OverMemoryBudget()) {
+    PL_RETURN_IF_ERROR(SpillAggState(exec_state));
+  }
   if (ReadyToEmitBatches(rb)) {
-    RowBatch output_rb(*output_descriptor_, agg_hash_map_.size());
-    PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, &output_rb));
-    output_rb.set_eow(rb.eow());
-    output_rb.set_eos(rb.eos());
+    if (!spill_files_.empty()) {
+      return EmitSpilledAggState(exec_state, rb.eow(), rb.eos());
+    }
+    PL_RETURN_IF_ERROR(EmitAggState(exec_state, rb.eow(), rb.eos(), /* emitted */ nullptr));
+  }
+  return Status::OK();
+}
+
+bool AggNode::OverMemoryBudget() const {
+  if (NumGroups() == 0) {
+    return false;
+  }
+  if (mem_pool()->SoftLimitExceeded()) {
+    return true;
+  }
+  if (FLAGS_carnot_agg_memory_budget_bytes <= 0) {
+    return false;
+  }
+  int64_t state_bytes =
+      group_args_pool_.bytes_allocated() + udas_pool_.bytes_allocated() +
+      static_cast<int64_t>(NumGroups() * plan_node_->values().size()) * kUDAStateBytesEstimate;
+  return state_bytes > FLAGS_carnot_agg_memory_budget_bytes;
+}
+
+Status AggNode::AppendToSpillFile(size_t partition_idx, const RowBatch& rb) {
+  if (spill_files_.empty()) {
+    spill_files_.resize(size_t{1} << spill_partition_bits_);
+  }
+  auto& spill = spill_files_[partition_idx];
+  if (spill == nullptr) {
+    PL_ASSIGN_OR_RETURN(spill, SpillFile::Create(FLAGS_carnot_agg_spill_dir));
+  }
+  return spill->Append(rb);
+}
+
+Status AggNode::SpillAggState(ExecState* exec_state) {
+  struct SpillPartition {
+    std::vector<std::unique_ptr<arrow::ArrayBuilder>> group_builders;
+    std::unique_ptr<arrow::ArrayBuilder> states_builder;
+    int64_t num_rows = 0;
+  };
+  std::vector<SpillPartition> partitions(size_t{1} << spill_partition_bits_);
+  for (auto& partition : partitions) {
+    for (const auto& group_dt : group_data_types_) {
+      partition.group_builders.push_back(
+          types::MakeArrowBuilder(group_dt, exec_state->exec_mem_pool()));
+    }
+    partition.states_builder = types::MakeArrowBuilder(types::STRING, exec_state->exec_mem_pool());
+  }
+
+  auto append_states = [&](SpillPartition* partition, AggHashValue* val) -> Status {
+    // Fold the values the group still holds into its UDAs before serializing them.
+    if (!update_on_selections_ && !val->agg_cols.empty()) {
+      PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
+    }
+    ++partition->num_rows;
+    return AppendPartialStates(val->udas, partition->states_builder.get());
+  };
+  for (const auto& [key, val] : group_key_hash_map_) {
+    auto& partition = partitions[PartitionIndex(key.hash, spill_partition_bits_)];
+    PL_RETURN_IF_ERROR(group_key_layout_->AppendToBuilders(key, partition.group_builders));
+    PL_RETURN_IF_ERROR(append_states(&partition, val));
+  }
+  for (const auto& [rt, val] : agg_hash_map_) {
+    auto& partition = partitions[PartitionIndex(rt->Hash(), spill_partition_bits_)];
+    AppendRowTupleToBuilders(rt, partition.group_builders);
+    PL_RETURN_IF_ERROR(append_states(&partition, val));
+  }
+
+  for (size_t partition_idx = 0; partition_idx < partitions.size(); ++partition_idx) {
+    auto& partition = partitions[partition_idx];
+    if (partition.num_rows == 0) {
+      continue;
+    }
+    RowBatch spill_rb(*spill_descriptor_, partition.num_rows);
+    for (const auto& builder : partition.group_builders) {
+      SharedArray arr;
+      PL_RETURN_IF_ERROR(builder->Finish(&arr));
+      PL_RETURN_IF_ERROR(spill_rb.AddColumn(arr));
+    }
+    SharedArray states;
+    PL_RETURN_IF_ERROR(partition.states_builder->Finish(&states));
+    PL_RETURN_IF_ERROR(spill_rb.AddColumn(states));
+    PL_RETURN_IF_ERROR(AppendToSpillFile(partition_idx, spill_rb));
+  }
+  VLOG(1) << absl::Substitute("$0 spilled $1 groups", DebugString(), NumGroups());
+
+  ReleaseGroups();
+  return Status::OK();
+}
+
+Status AggNode::MergeSpilledStates(ExecState* exec_state, const RowBatch& rb,
+                                   const std::vector<std::unique_ptr<udf::UDA>>& scratch) {
+  std::vector<arrow::Array*> group_cols;
+  for (size_t i = 0; i < group_data_types_.size(); ++i) {
+    group_cols.push_back(rb.ColumnAt(i).get());
+  }
+  if (group_key_layout_ != nullptr) {
+    PL_RETURN_IF_ERROR(HashRowBatchWithGroupKeys(exec_state, rb, group_cols));
+  } else {
+    PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(group_cols, rb.num_rows()));
+    PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
+  }
+
+  auto* states = static_cast<const arrow::StringArray*>(rb.ColumnAt(group_cols.size()).get());
+  for (int64_t row_idx = 0; row_idx < states->length(); ++row_idx) {
+    auto* val = row_agg_values_[row_idx];
+    DCHECK(val != nullptr);
+    PL_RETURN_IF_ERROR(MergePartialState(states->GetView(row_idx), val->udas, scratch));
+  }
+  return ResetGroupArgs();
+}
+
+Status AggNode::EmitSpilledAggState(ExecState* exec_state, bool eow, bool eos) {
+  // The groups still in memory are spilled as well, so that each partition is merged on its own.
+  PL_RETURN_IF_ERROR(SpillAggState(exec_state));
+
+  std::vector<std::unique_ptr<udf::UDA>> scratch;
+  for (const auto& value : plan_node_->values()) {
+    scratch.push_back(exec_state->GetUDADefinition(value->uda_id())->Make());
+  }
+  for (size_t partition_idx = 0; partition_idx < spill_files_.size(); ++partition_idx) {
+    bool last = partition_idx + 1 == spill_files_.size();
+    auto& spill = spill_files_[partition_idx];
+    if (spill == nullptr && !last) {
+      continue;
+    }
+    if (spill != nullptr) {
+      PL_RETURN_IF_ERROR(spill->Rewind());
+      while (true) {
+        PL_ASSIGN_OR_RETURN(auto spilled_rb, spill->ReadNext());
+        if (spilled_rb == nullptr) {
+          break;
+        }
+        PL_RETURN_IF_ERROR(MergeSpilledStates(exec_state, *spilled_rb, scratch));
+      }
+      spill.reset();
+    }
+
+    RowBatch output_rb(*output_descriptor_, NumGroups());
+    PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, /* updated_only */ false,
+                                                   &output_rb));
+    output_rb.set_eow(last && eow);
+    output_rb.set_eos(last && eos);
     PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
-    PL_RETURN_IF_ERROR(ClearAggState(exec_state));
+    ReleaseGroups();
   }
+  spill_files_.clear();
+  last_emit_ns_ = CurrentTimeNS();
   return Status::OK();
 }
 
@@ -432,11 +1087,23 @@ Status AggNode::EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UD
 }
 
 Status AggNode::EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val) {
+  PL_RETURN_IF_ERROR(
+      UpdateUDAs(exec_state, val, val->agg_cols, val->agg_cols[0]->Size(), /* rows */ nullptr));
+
+  for (auto& col : val->agg_cols) {
+    // Clear the values, so we don't aggregate them twice.
+    col->Clear();
+  }
+  return Status::OK();
+}
+
+Status AggNode::UpdateUDAs(ExecState* exec_state, AggHashValue* val,
+                           const std::vector<types::SharedColumnWrapper>& cols,
+                           size_t num_records, const udf::SelectionVector* rows) {
   size_t values_size = plan_node_->values().size();
   for (size_t i = 0; i < values_size; ++i) {
     const auto& uda_info = val->udas[i];
     const auto& expr = *plan_node_->values()[i];
-    size_t num_records = val->agg_cols[0]->Size();
     plan::ExpressionWalker<StatusOr<types::SharedColumnWrapper>> walker;
     walker.OnScalarValue([&](const plan::ScalarValue& scalar_val,
                              const std::vector<StatusOr<types::SharedColumnWrapper>>& children)
@@ -449,7 +1116,7 @@ Status AggNode::EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val) {
                         const std::vector<StatusOr<types::SharedColumnWrapper>>& children)
                         -> types::SharedColumnWrapper {
       DCHECK_EQ(children.size(), 0ULL);
-      return val->agg_cols[plan_cols_to_stored_map_[col.Index()]];
+      return cols[plan_cols_to_stored_map_[col.Index()]];
     });
 
     walker.OnAggregateExpression(
@@ -465,18 +1132,18 @@ Status AggNode::EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val) {
             PL_RETURN_IF_ERROR(child);
             raw_children.push_back(child.ValueOrDie().get());
           }
-          PL_RETURN_IF_ERROR(
-              uda_info.def->ExecBatchUpdate(uda_info.uda.get(), nullptr /* ctx */, raw_children));
+          if (rows != nullptr) {
+            PL_RETURN_IF_ERROR(uda_info.def->ExecBatchUpdateSelection(
+                uda_info.uda.get(), nullptr /* ctx */, raw_children, *rows));
+          } else {
+            PL_RETURN_IF_ERROR(uda_info.def->ExecBatchUpdate(uda_info.uda.get(),
+                                                             nullptr /* ctx */, raw_children));
+          }
           // Blocking aggregates don't produce results until all data is seen.
           return {};
         });
     PL_RETURN_IF_ERROR(walker.Walk(expr));
   }
-
-  for (auto& col : val->agg_cols) {
-    // Clear the values, so we don't aggregate them twice.
-    col->Clear();
-  }
   return Status::OK();
 }
 
@@ -507,8 +1174,12 @@ Status AggNode::CreateColumnMapping() {
 }
 
 AggHashValue* AggNode::CreateAggHashValue(ExecState* exec_state) {
-  auto* val = udas_pool_.Add(new AggHashValue);
+  auto* val = udas_pool_.New<AggHashValue>();
   PL_CHECK_OK(CreateUDAInfoValues(&(val->udas), exec_state));
+  if (update_on_selections_) {
+    // The UDAs are updated directly on the input batches, so there is nothing to store.
+    return val;
+  }
   for (const auto& dt : stored_cols_data_types_) {
     val->agg_cols.emplace_back(types::ColumnWrapper::Make(dt, 0));
   }
@@ -520,11 +1191,11 @@ Status AggNode::CreateUDAInfoValues(std::vector<UDAInfo>* val, ExecState* exec_s
   CHECK_EQ(val->size(), 0ULL);
 
   for (const auto& value : plan_node_->values()) {
-    std::vector<types::DataType> types;
-    types.reserve(value->Deps().size());
-    for (auto* dep : value->Deps()) {
-      PL_ASSIGN_OR_RETURN(auto type, GetTypeOfDep(*dep));
-      types.push_back(type);
+    // The deps of a merged aggregate refer to the input of the partial aggregate.
+    if (!merge_partial_states_) {
+      for (auto* dep : value->Deps()) {
+        PL_RETURN_IF_ERROR(GetTypeOfDep(*dep));
+      }
     }
     auto def = exec_state->GetUDADefinition(value->uda_id());
     val->emplace_back(def->Make(), def);
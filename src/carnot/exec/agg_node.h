@@ -21,13 +21,16 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/group_key.h"
 #include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/exec/spill_file.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/udf/base.h"
@@ -40,6 +43,11 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int32(carnot_agg_merge_parallelism);
+DECLARE_int64(carnot_agg_memory_budget_bytes);
+DECLARE_int32(carnot_agg_spill_partitions);
+DECLARE_string(carnot_agg_spill_dir);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -55,21 +63,66 @@ struct UDAInfo {
 struct AggHashValue {
   std::vector<UDAInfo> udas;
   std::vector<types::SharedColumnWrapper> agg_cols;
+  // The rows of the current batch that belong to this group, when updating on selections.
+  udf::SelectionVector selected_rows;
+  // For standing aggregates, whether the group was updated since the last emit, and the time of
+  // its last update.
+  bool updated = false;
+  int64_t last_update_ns = 0;
 };
 
 struct GroupArgs {
-  explicit GroupArgs(RowTuple* rt) : rt(rt), av(nullptr) {}
+  explicit GroupArgs(RowTuple* rt) : rt(rt) {}
   RowTuple* rt;
-  AggHashValue* av;
 };
 
+/**
+ * AggNode runs a windowed or blocking aggregate. When the plan splits the aggregate across agents,
+ * the partial aggregate emits the serialized state of the UDAs of each group instead of the
+ * results, and the finalize aggregate merges those states and emits the results.
+ *
+ * The partial states are deltas: the partial aggregate drops its state every time it emits, so
+ * each window only carries the groups updated since the previous one, and the finalize aggregate
+ * keeps a single merged state per group however many deltas it receives.
+ *
+ * Standing aggregates (see planpb::AggregateOperator::emit_interval_ns) never reach the end of
+ * their input. They emit periodically instead: partial aggregates their deltas, and the others
+ * the results of the groups updated since their last emit, on top of the state they keep.
+ *
+ * Blocking aggregates with groups that emit results spill their groups to disk when they go over
+ * --carnot_agg_memory_budget_bytes or the query goes over its soft memory limit. The groups are
+ * written as partial states, split into partitions by the hash of their keys, and the state in
+ * memory starts over. At the end of the input, the partitions are merged and emitted one at a
+ * time, so only the groups of a single partition are in memory at once.
+ */
 class AggNode : public ProcessingNode {
   using AggHashMap = AbslRowTupleHashMap<AggHashValue*>;
+  using GroupKeyAggHashMap = GroupKeyHashMap<AggHashValue*>;
 
  public:
   AggNode() = default;
   virtual ~AggNode() = default;
 
+  /**
+   * Merges the aggregate state of other into this node. other must run the same blocking
+   * aggregate on another part of the input, eg. in a parallel pipeline. Its groups are copied, so
+   * it can be closed right after.
+   */
+  Status MergePartialAggregates(ExecState* exec_state, AggNode* other);
+
+  /**
+   * Fragment caching, see FragmentCache. Only for partial aggregates that aren't windowed.
+   *
+   * EmitPartialStates sends the partial states of the input consumed since the last emit without
+   * ending the window, and returns them in emitted (if not null). SendPartialStates sends states
+   * returned by an earlier EmitPartialStates of the same aggregate, in place of consuming the
+   * same input again.
+   */
+  Status EmitPartialStates(ExecState* exec_state,
+                           std::unique_ptr<table_store::schema::RowBatch>* emitted);
+  Status SendPartialStates(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  bool emits_partial_states() const { return emit_partial_states_; }
+
  protected:
   Status AggregateGroupByNone(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status AggregateGroupByClause(ExecState* exec_state, const table_store::schema::RowBatch& rb);
@@ -81,21 +134,72 @@ class AggNode : public ProcessingNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  // The group keys are read from the dictionary codes, see DecodeValueDictionaries().
+  bool ConsumesDictionaryStrings() const override { return group_key_layout_ != nullptr; }
+  // Only the rows of the selection are hashed when the UDAs are updated on the rows of each group.
+  bool ConsumesSelections() const override {
+    return group_key_layout_ != nullptr && update_on_selections_;
+  }
 
  private:
   AggHashMap agg_hash_map_;
+  GroupKeyAggHashMap group_key_hash_map_;
   bool HasNoGroups() const { return plan_node_->groups().empty(); }
   // ReadyToEmitBatches returns true when the input stream has reached a point where output batches
   // can be emitted. In the windowed aggregate case, this happens whenever end of window (eow) is
   // reached. In the blocking aggregate case, this happens at eos only.
   bool ReadyToEmitBatches(const table_store::schema::RowBatch& rb) const;
+  // Whether a standing aggregate has updates and its emit interval has passed.
+  bool StandingEmitDue() const;
+  // Whether the aggregate keeps its state when it emits, and only emits the updated groups.
+  bool EmitsUpdatedGroups() const { return plan_node_->standing() && !emit_partial_states_; }
   // When we see a new window, we need to be able to clear the aggregate state.
   Status ClearAggState(ExecState* exec_state);
+  // Drops the groups and frees the memory they hold.
+  void ReleaseGroups();
+  // Marks the groups of the rows of the current batch as updated.
+  void MarkUpdatedGroups();
+  // Drops the groups of a standing aggregate that weren't updated within the group TTL.
+  void ExpireGroups();
+  // Sends the current state to the children as one batch, and clears it.
+  Status EmitAggState(ExecState* exec_state, bool eow, bool eos,
+                      std::unique_ptr<table_store::schema::RowBatch>* emitted);
+
+  // Appends the results of the UDAs to builders, or their packed partial states to the one
+  // builder of the serialized column when emitting partial aggregates.
+  Status AppendResults(const std::vector<UDAInfo>& udas,
+                       const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders);
+  Status AppendPartialStates(const std::vector<UDAInfo>& udas, arrow::ArrayBuilder* builder);
+  // Merges the partial states of each row of rb into the UDAs of the row, or of the node when
+  // there are no groups. With groups, the rows are split by group across
+  // FLAGS_carnot_agg_merge_parallelism threads.
+  Status MergePartialStates(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Merges the rows of states whose group falls in the given partition, using scratch UDAs that
+  // are private to the caller.
+  Status MergePartialStateRows(ExecState* exec_state, const arrow::StringArray* states,
+                               size_t partition, size_t num_partitions);
+  Status MergePartialState(std::string_view state, const std::vector<UDAInfo>& udas,
+                           const std::vector<std::unique_ptr<udf::UDA>>& scratch);
+
+  // Spilling, see the class comment. The spilled batches have the group columns followed by the
+  // serialized column of the partial states.
+  bool OverMemoryBudget() const;
+  Status SpillAggState(ExecState* exec_state);
+  Status AppendToSpillFile(size_t partition_idx, const table_store::schema::RowBatch& rb);
+  Status MergeSpilledStates(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                            const std::vector<std::unique_ptr<udf::UDA>>& scratch);
+  // Merges each spilled partition and sends its results, the last one with eow/eos.
+  Status EmitSpilledAggState(ExecState* exec_state, bool eow, bool eos);
 
   Status EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UDAInfo& uda_info,
                                           plan::AggregateExpression* expr,
                                           const table_store::schema::RowBatch& rb);
   Status EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val);
+  // Updates the UDAs of val on the stored columns cols, or only on the given rows of cols if
+  // rows is not null.
+  Status UpdateUDAs(ExecState* exec_state, AggHashValue* val,
+                    const std::vector<types::SharedColumnWrapper>& cols, size_t num_records,
+                    const udf::SelectionVector* rows);
   StatusOr<types::DataType> GetTypeOfDep(const plan::ScalarExpression& expr) const;
 
   // Store information about aggregate node from the query planner.
@@ -104,6 +208,12 @@ class AggNode : public ProcessingNode {
 
   std::unique_ptr<udf::FunctionContext> function_ctx_;
 
+  // Set when the plan splits the aggregate, see the class comment.
+  bool emit_partial_states_ = false;
+  bool merge_partial_states_ = false;
+  // The input column that holds the partial states, when merging them.
+  int64_t partial_states_col_idx_ = -1;
+
   // Variables specific to GroupByNone Agg.
   std::vector<UDAInfo> udas_no_groups_;
   // END: Variables specific to GroupByNone Agg.
@@ -121,8 +231,10 @@ class AggNode : public ProcessingNode {
   // 3. The data type of the stored colums, by the index they are stored at.
   std::vector<types::DataType> stored_cols_data_types_;
 
-  ObjectPool group_args_pool_{"group_args_pool"};
-  ObjectPool udas_pool_{"udas_pool"};
+  // There is one RowTuple and AggHashValue per group, so they are placed in arenas rather than
+  // allocated one by one.
+  ArenaObjectPool group_args_pool_{"group_args_pool"};
+  ArenaObjectPool udas_pool_{"udas_pool"};
 
   std::vector<types::DataType> group_data_types_;
   std::vector<types::DataType> value_data_types_;
@@ -131,21 +243,74 @@ class AggNode : public ProcessingNode {
   // This vector holds pointers to the row_tuples which are managed by the group_args_pool_.
 
   std::vector<GroupArgs> group_args_chunk_;
+  // The hashes of the rows of the current batch, set on their row tuples.
+  std::vector<uint64_t> row_hashes_;
+
+  // Set when all the group columns fit in a GroupKey, ie. they are fixed-width plus at most one
+  // string. The groups are then stored inline in group_key_hash_map_ instead of as RowTuples in
+  // agg_hash_map_, and the keys of a batch are extracted into group_keys_chunk_.
+  std::unique_ptr<GroupKeyLayout> group_key_layout_;
+  std::vector<GroupKeyView> group_keys_chunk_;
+
+  // The agg hash value of each row of the current batch.
+  std::vector<AggHashValue*> row_agg_values_;
+
+  // Set when all the UDAs implement UpdateBatch on selected rows. The UDAs are then updated
+  // directly on the rows of each input batch, without copying the values into agg_cols.
+  bool update_on_selections_ = false;
+  // The agg hash values with selected rows in the current batch.
+  std::vector<AggHashValue*> selected_values_;
   // END: Variables specific to GroupBy Agg.
 
+  // Variables specific to standing aggregates.
+  int64_t last_emit_ns_ = 0;
+  // The number of groups updated since the last emit, or whether the aggregate was updated at
+  // all when there are no groups.
+  int64_t num_updated_groups_ = 0;
+  bool no_groups_updated_ = false;
+  // END: Variables specific to standing aggregates.
+
+  // Variables specific to spilling.
+  bool spill_enabled_ = false;
+  int spill_partition_bits_ = 0;
+  std::unique_ptr<table_store::schema::RowDescriptor> spill_descriptor_;
+  // One file per partition, created when the partition first spills. Empty until the first spill.
+  std::vector<std::unique_ptr<SpillFile>> spill_files_;
+  // END: Variables specific to spilling.
+
   // Creates a mapping between plan cols and stored cols (see above comment).
   Status CreateColumnMapping();
 
-  Status ExtractRowTupleForBatch(const table_store::schema::RowBatch& rb);
+  // The group columns of an input batch, in the order of the groups of the plan.
+  std::vector<arrow::Array*> GroupColumns(const table_store::schema::RowBatch& rb) const;
+  Status ExtractRowTupleForBatch(const std::vector<arrow::Array*>& group_cols, int64_t num_rows);
   Status HashRowBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  Status HashRowBatchWithGroupKeys(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                                   const std::vector<arrow::Array*>& group_cols);
+  // Decodes the dictionary-encoded columns of rb other than the group columns.
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> DecodeValueDictionaries(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb) const;
+  // Appends the values of each row to the agg columns of the row's agg hash value.
+  Status ExtractAggValues(const table_store::schema::RowBatch& rb);
   Status EvaluatePartialAggregates(ExecState* exec_state, size_t num_records);
+  Status UpdateOnSelections(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status ResetGroupArgs();
-  Status ConvertAggHashMapToRowBatch(ExecState* exec_state,
+  size_t NumGroups() const {
+    return group_key_layout_ != nullptr ? group_key_hash_map_.size() : agg_hash_map_.size();
+  }
+  void AppendRowTupleToBuilders(RowTuple* rt,
+                                const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders);
+  // Appends the groups to output_rb, or only the updated ones when updated_only is set.
+  Status ConvertAggHashMapToRowBatch(ExecState* exec_state, bool updated_only,
                                      table_store::schema::RowBatch* output_rb);
+  Status FinalizeAggHashValue(ExecState* exec_state, AggHashValue* val,
+                              const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders);
+  Status MergeAggHashValue(ExecState* exec_state, AggNode* other, AggHashValue* other_val,
+                           AggHashValue* val);
 
   AggHashValue* CreateAggHashValue(ExecState* exec_state);
   RowTuple* CreateGroupArgsRowTuple() {
-    return group_args_pool_.Add(new RowTuple(&group_data_types_));
+    return group_args_pool_.New<RowTuple>(&group_data_types_);
   }
 
   Status CreateUDAInfoValues(std::vector<UDAInfo>* val, ExecState* exec_state);
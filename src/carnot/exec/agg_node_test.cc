@@ -53,6 +53,56 @@ class MinSumUDA : public udf::UDA {
   types::Int64Value sum_ = 0;
 };
 
+// MinSumUDA with batch updates, so the grouped aggregates update it on the rows of each group.
+class MinSumBatchUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg1, types::Int64Value arg2) {
+    sum_ = sum_.val + std::min(arg1.val, arg2.val);
+  }
+  void UpdateBatch(udf::FunctionContext*, const types::Int64ValueColumnWrapper& arg1,
+                   const types::Int64ValueColumnWrapper& arg2) {
+    for (size_t i = 0; i < arg1.Size(); ++i) {
+      sum_ = sum_.val + std::min(arg1[i].val, arg2[i].val);
+    }
+  }
+  void UpdateBatch(udf::FunctionContext*, const udf::SelectionVector& rows,
+                   const types::Int64ValueColumnWrapper& arg1,
+                   const types::Int64ValueColumnWrapper& arg2) {
+    for (int64_t idx : rows) {
+      sum_ = sum_.val + std::min(arg1[idx].val, arg2[idx].val);
+    }
+  }
+  void Merge(udf::FunctionContext*, const MinSumBatchUDA& other) {
+    sum_ = sum_.val + other.sum_.val;
+  }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+
+ protected:
+  types::Int64Value sum_ = 0;
+};
+
+// MinSumUDA that can be split into partial aggregates.
+class MinSumPartialUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg1, types::Int64Value arg2) {
+    sum_ = sum_.val + std::min(arg1.val, arg2.val);
+  }
+  void Merge(udf::FunctionContext*, const MinSumPartialUDA& other) {
+    sum_ = sum_.val + other.sum_.val;
+  }
+  types::StringValue Serialize(udf::FunctionContext*) {
+    return types::StringValue(reinterpret_cast<const char*>(&sum_.val), sizeof(sum_.val));
+  }
+  Status Deserialize(udf::FunctionContext*, const types::StringValue& data) {
+    sum_ = *reinterpret_cast<const int64_t*>(data.data());
+    return Status::OK();
+  }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+
+ protected:
+  types::Int64Value sum_ = 0;
+};
+
 constexpr char kBlockingNoGroupAgg[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -134,6 +184,38 @@ agg_op {
   value_names: "value1"
 })";
 
+constexpr char kBlockingTwoGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 2
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 3
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  groups {
+     node: 0
+     index: 1
+  }
+  group_names: "g1"
+  group_names: "g2"
+  value_names: "value1"
+})";
+
 constexpr char kWindowedNoGroupAgg[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -183,6 +265,90 @@ agg_op {
   value_names: "value1"
 })";
 
+constexpr char kPartialWindowedSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: true
+  partial_agg: true
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
+constexpr char kFinalizeSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  finalize_results: true
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
+// Emits every time it has updates.
+constexpr char kStandingSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  emit_interval_ns: 1
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
 constexpr char kSingleGroupNoValues[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -303,6 +469,44 @@ TEST_F(AggNodeTest, single_group_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, merge_partial_aggregates) {
+  auto plan_node = PlanNodeFromPbtxt(kBlockingSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  auto partial_tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester.ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                         .AddColumn<types::Int64Value>({1, 1, 2, 2})
+                         .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                         .get(),
+                     0, 0);
+  partial_tester.ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                                 .AddColumn<types::Int64Value>({5, 1, 3, 4})
+                                 .AddColumn<types::Int64Value>({1, 5, 3, 8})
+                                 .get(),
+                             0, 0);
+  EXPECT_OK(tester.node()->MergePartialAggregates(exec_state_.get(), partial_tester.node()));
+  partial_tester.Close();
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 0, true, true)
+                       .AddColumn<types::Int64Value>({})
+                       .AddColumn<types::Int64Value>({})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                          .AddColumn<types::Int64Value>({3, 3, 3, 4, 1})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, multiple_groups_blocking) {
   auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
@@ -366,6 +570,85 @@ TEST_F(AggNodeTest, multiple_groups_with_string_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, uint128_and_string_groups_blocking) {
+  auto plan_node = PlanNodeFromPbtxt(kBlockingTwoGroupAgg);
+  RowDescriptor input_rd({types::DataType::UINT128, types::DataType::STRING,
+                          types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd(
+      {types::DataType::UINT128, types::DataType::STRING, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::UInt128Value>({types::UInt128Value(1, 2),
+                                                        types::UInt128Value(1, 2),
+                                                        types::UInt128Value(2, 1),
+                                                        types::UInt128Value(1, 2)})
+                       .AddColumn<types::StringValue>({"/a", "/b", "/a", "/a"})
+                       .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 4})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, true, true)
+                       .AddColumn<types::UInt128Value>({types::UInt128Value(2, 1),
+                                                        types::UInt128Value(1, 2),
+                                                        types::UInt128Value(2, 2)})
+                       .AddColumn<types::StringValue>({"/a", "/b", "/b"})
+                       .AddColumn<types::Int64Value>({5, 4, 7})
+                       .AddColumn<types::Int64Value>({6, 3, 7})
+                       .get(),
+                   0)
+      .ExpectRowBatch(
+          RowBatchBuilder(output_rd, 4, true, true)
+              .AddColumn<types::UInt128Value>({types::UInt128Value(1, 2), types::UInt128Value(1, 2),
+                                               types::UInt128Value(2, 1),
+                                               types::UInt128Value(2, 2)})
+              .AddColumn<types::StringValue>({"/a", "/b", "/a", "/b"})
+              .AddColumn<types::Int64Value>({3, 4, 8, 7})
+              .get(),
+          false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, multiple_string_groups_blocking) {
+  // Two string groups don't fit in a GroupKey, so this goes through the RowTuple hash map.
+  auto plan_node = PlanNodeFromPbtxt(kBlockingTwoGroupAgg);
+  RowDescriptor input_rd({types::DataType::STRING, types::DataType::STRING,
+                          types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd(
+      {types::DataType::STRING, types::DataType::STRING, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::StringValue>({"abc", "abc", "def", "abc"})
+                       .AddColumn<types::StringValue>({"/a", "/b", "/a", "/a"})
+                       .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 4})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::StringValue>({"def", "abc"})
+                       .AddColumn<types::StringValue>({"/a", "/b"})
+                       .AddColumn<types::Int64Value>({5, 4})
+                       .AddColumn<types::Int64Value>({6, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::StringValue>({"abc", "abc", "def"})
+                          .AddColumn<types::StringValue>({"/a", "/b", "/a"})
+                          .AddColumn<types::Int64Value>({3, 4, 8})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, no_groups_windowed) {
   auto plan_node = PlanNodeFromPbtxt(kWindowedNoGroupAgg);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
@@ -476,6 +759,336 @@ TEST_F(AggNodeTest, no_aggregate_expressions) {
       .Close();
 }
 
+TEST_F(AggNodeTest, standing_emits_updated_groups) {
+  auto plan_node = PlanNodeFromPbtxt(kStandingSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({2, 2})
+                          .get(),
+                      false)
+      // Only the updated groups are emitted, with the state kept from the earlier batches.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, false, false)
+                       .AddColumn<types::Int64Value>({2, 3})
+                       .AddColumn<types::Int64Value>({1, 5})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Int64Value>({2, 3})
+                          .AddColumn<types::Int64Value>({3, 3})
+                          .get(),
+                      false)
+      // Nothing is emitted without updates.
+      .ConsumeNext(RowBatchBuilder(input_rd, 0, false, false)
+                       .AddColumn<types::Int64Value>({})
+                       .AddColumn<types::Int64Value>({})
+                       .get(),
+                   0, 0)
+      .Close();
+}
+
+TEST_F(AggNodeTest, standing_expires_groups) {
+  planpb::Operator op_pb;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kStandingSingleGroupAgg, &op_pb));
+  op_pb.mutable_agg_op()->set_group_ttl_ns(1);
+  auto plan_node = plan::AggregateOperator::FromProto(op_pb, 1);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({2, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .get(),
+                      false)
+      // The groups expired after the first emit, so group 2 starts over.
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, false, false)
+                       .AddColumn<types::Int64Value>({2})
+                       .AddColumn<types::Int64Value>({1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<types::Int64Value>({2})
+                          .AddColumn<types::Int64Value>({1})
+                          .get(),
+                      false)
+      .Close();
+}
+
+class AggNodeUpdateBatchTest : public ::testing::Test {
+ public:
+  AggNodeUpdateBatchTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test");
+    EXPECT_TRUE(func_registry_->Register<MinSumBatchUDA>("minsum").ok());
+
+    exec_state_ = MakeTestExecState(func_registry_.get());
+    EXPECT_OK(exec_state_->AddUDA(0, "minsum",
+                                  std::vector<types::DataType>({types::INT64, types::INT64})));
+  }
+
+ protected:
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(AggNodeUpdateBatchTest, multiple_groups_with_string_blocking) {
+  auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
+  RowDescriptor input_rd({types::DataType::STRING, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd(
+      {types::DataType::STRING, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::StringValue>({"abc", "def", "abc", "fgh"})
+                       .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::StringValue>({"ijk", "abc", "abc", "def"})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 3})
+                       .AddColumn<types::Int64Value>({1, 3, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, true)
+                          .AddColumn<types::StringValue>({"abc", "def", "abc", "fgh", "ijk", "def"})
+                          .AddColumn<types::Int64Value>({2, 1, 3, 1, 1, 3})
+                          .AddColumn<types::Int64Value>({4, 1, 6, 1, 1, 3})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeUpdateBatchTest, single_group_windowed) {
+  auto plan_node = PlanNodeFromPbtxt(kWindowedSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, false)
+                       .AddColumn<types::Int64Value>({5, 6, 3, 4})
+                       .AddColumn<types::Int64Value>({1, 5, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, false)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                          .AddColumn<types::Int64Value>({2, 3, 3, 4, 1, 5})
+                          .get(),
+                      false)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({1, 1, 2, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({2, 3})
+                          .get(),
+                      false)
+      .Close();
+}
+
+class AggNodePartialTest : public ::testing::Test {
+ public:
+  AggNodePartialTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test");
+    EXPECT_TRUE(func_registry_->Register<MinSumPartialUDA>("minsum").ok());
+
+    exec_state_ = MakeTestExecState(func_registry_.get());
+    EXPECT_OK(exec_state_->AddUDA(0, "minsum",
+                                  std::vector<types::DataType>({types::INT64, types::INT64})));
+  }
+
+ protected:
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(AggNodePartialTest, windowed_partial_states_are_deltas) {
+  auto partial_plan_node = PlanNodeFromPbtxt(kPartialWindowedSingleGroupAgg);
+  auto finalize_plan_node = PlanNodeFromPbtxt(kFinalizeSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor partial_rd({types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto partial_tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *partial_plan_node, partial_rd, {input_rd}, exec_state_.get());
+  partial_tester.ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ true, /*eos*/ false)
+                                 .AddColumn<types::Int64Value>({1, 1, 2})
+                                 .AddColumn<types::Int64Value>({2, 3, 3})
+                                 .get(),
+                             0);
+  auto window1 = partial_tester.PopRowBatch();
+  EXPECT_EQ(2, window1->num_rows());
+
+  // Only the group updated in the second window is sent again.
+  partial_tester.ConsumeNext(RowBatchBuilder(input_rd, 1, /*eow*/ true, /*eos*/ true)
+                                 .AddColumn<types::Int64Value>({1})
+                                 .AddColumn<types::Int64Value>({4})
+                                 .get(),
+                             0);
+  auto window2 = partial_tester.PopRowBatch();
+  EXPECT_EQ(1, window2->num_rows());
+  partial_tester.Close();
+
+  auto finalize_tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *finalize_plan_node, output_rd, {partial_rd}, exec_state_.get());
+  finalize_tester.ConsumeNext(*window1, 0, 0)
+      .ConsumeNext(*window2, 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({3, 2})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodePartialTest, merge_partial_states_on_threads) {
+  auto merge_parallelism = FLAGS_carnot_agg_merge_parallelism;
+  FLAGS_carnot_agg_merge_parallelism = 4;
+
+  auto partial_plan_node = PlanNodeFromPbtxt(kPartialWindowedSingleGroupAgg);
+  auto finalize_plan_node = PlanNodeFromPbtxt(kFinalizeSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor partial_rd({types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  constexpr int64_t kNumGroups = 4096;
+  std::vector<types::Int64Value> groups;
+  std::vector<types::Int64Value> sums;
+  for (int64_t i = 0; i < kNumGroups; ++i) {
+    groups.push_back(i);
+    sums.push_back(2 * i);
+  }
+
+  auto partial_tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *partial_plan_node, partial_rd, {input_rd}, exec_state_.get());
+  partial_tester.ConsumeNext(RowBatchBuilder(input_rd, kNumGroups, /*eow*/ true, /*eos*/ true)
+                                 .AddColumn<types::Int64Value>(groups)
+                                 .AddColumn<types::Int64Value>(groups)
+                                 .get(),
+                             0);
+  auto states = partial_tester.PopRowBatch();
+  partial_tester.Close();
+
+  // Merge the same partial states twice, as if they came from two agents.
+  auto finalize_tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *finalize_plan_node, output_rd, {partial_rd}, exec_state_.get());
+  states->set_eow(false);
+  states->set_eos(false);
+  finalize_tester.ConsumeNext(*states, 0, 0);
+  states->set_eow(true);
+  states->set_eos(true);
+  finalize_tester.ConsumeNext(*states, 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, kNumGroups, true, true)
+                          .AddColumn<types::Int64Value>(groups)
+                          .AddColumn<types::Int64Value>(sums)
+                          .get(),
+                      false)
+      .Close();
+
+  FLAGS_carnot_agg_merge_parallelism = merge_parallelism;
+}
+
+TEST_F(AggNodePartialTest, spills_groups_over_memory_budget) {
+  auto memory_budget_bytes = FLAGS_carnot_agg_memory_budget_bytes;
+  auto spill_partitions = FLAGS_carnot_agg_spill_partitions;
+  FLAGS_carnot_agg_memory_budget_bytes = 1;
+
+  auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+  auto input1 = RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                    .AddColumn<types::Int64Value>({1, 5, 1, 2})
+                    .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                    .AddColumn<types::Int64Value>({2, 5, 3, 1})
+                    .get();
+  auto input2 = RowBatchBuilder(input_rd, 4, /*eow*/ true, /*eos*/ true)
+                    .AddColumn<types::Int64Value>({5, 1, 3, 3})
+                    .AddColumn<types::Int64Value>({1, 2, 3, 3})
+                    .AddColumn<types::Int64Value>({1, 3, 3, 8})
+                    .get();
+
+  // The groups of the first batch are spilled, and merged with the ones of the second at eos.
+  FLAGS_carnot_agg_spill_partitions = 1;
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester.ConsumeNext(input1, 0, 0)
+      .ConsumeNext(input2, 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, true, true)
+                          .AddColumn<types::Int64Value>({1, 1, 2, 5, 3})
+                          .AddColumn<types::Int64Value>({2, 3, 1, 1, 3})
+                          .AddColumn<types::Int64Value>({4, 3, 1, 2, 6})
+                          .get(),
+                      false)
+      .Close();
+
+  // Each partition is emitted in its own batch, and only the last one ends the stream.
+  constexpr int64_t kNumGroups = 1024;
+  std::vector<types::Int64Value> groups;
+  std::vector<types::Int64Value> ones(kNumGroups, 1);
+  for (int64_t i = 0; i < kNumGroups; ++i) {
+    groups.push_back(i);
+  }
+  auto many_groups = RowBatchBuilder(input_rd, kNumGroups, /*eow*/ false, /*eos*/ false)
+                         .AddColumn<types::Int64Value>(groups)
+                         .AddColumn<types::Int64Value>(ones)
+                         .AddColumn<types::Int64Value>(ones)
+                         .get();
+  FLAGS_carnot_agg_spill_partitions = 4;
+  auto partitioned_tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  partitioned_tester.ConsumeNext(many_groups, 0, 0);
+  many_groups.set_eow(true);
+  many_groups.set_eos(true);
+  partitioned_tester.ConsumeNext(many_groups, 0, 4);
+  int64_t num_rows = 0;
+  for (int i = 0; i < 4; ++i) {
+    auto rb = partitioned_tester.PopRowBatch();
+    num_rows += rb->num_rows();
+    EXPECT_EQ(i == 3, rb->eos());
+    auto values = std::static_pointer_cast<arrow::Int64Array>(rb->ColumnAt(2));
+    for (int64_t row_idx = 0; row_idx < values->length(); ++row_idx) {
+      EXPECT_EQ(2, values->Value(row_idx));
+    }
+  }
+  EXPECT_EQ(kNumGroups, num_rows);
+  partitioned_tester.Close();
+
+  FLAGS_carnot_agg_memory_budget_bytes = memory_budget_bytes;
+  FLAGS_carnot_agg_spill_partitions = spill_partitions;
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/async_execution.h"
+
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+class AsyncExecution::StepTask : public event::AsyncTask {
+ public:
+  explicit StepTask(AsyncExecution* execution) : execution_(execution) {}
+
+  void Work() override { done_ = execution_->step_(execution_->wake_); }
+
+  void Done() override { execution_->OnStepDone(done_); }
+
+ private:
+  AsyncExecution* execution_;
+  StatusOr<bool> done_ = false;
+};
+
+std::shared_ptr<AsyncExecution> AsyncExecution::Create(event::Dispatcher* dispatcher,
+                                                       std::chrono::milliseconds yield_timeout,
+                                                       StepFunc step, DoneFunc done) {
+  return std::shared_ptr<AsyncExecution>(
+      new AsyncExecution(dispatcher, yield_timeout, std::move(step), std::move(done)));
+}
+
+AsyncExecution::AsyncExecution(event::Dispatcher* dispatcher,
+                               std::chrono::milliseconds yield_timeout, StepFunc step,
+                               DoneFunc done)
+    : dispatcher_(dispatcher),
+      yield_timeout_(yield_timeout),
+      step_(std::move(step)),
+      done_(std::move(done)) {}
+
+void AsyncExecution::Start() {
+  DCHECK(self_ == nullptr) << "AsyncExecution was already started";
+  self_ = shared_from_this();
+
+  // The wake function only holds a weak reference, since the GRPC router may keep it after the
+  // query is done, and it resumes the query on the dispatcher's thread.
+  std::weak_ptr<AsyncExecution> weak_self = self_;
+  event::Dispatcher* dispatcher = dispatcher_;
+  wake_ = [weak_self, dispatcher] {
+    dispatcher->Post([weak_self] {
+      if (auto self = weak_self.lock()) {
+        self->Resume();
+      }
+    });
+  };
+  yield_timer_ = dispatcher_->CreateTimer([this] { RunStep(); });
+  RunStep();
+}
+
+void AsyncExecution::RunStep() {
+  DCHECK(step_task_ == nullptr);
+  yield_timer_->DisableTimer();
+  woken_ = false;
+  step_task_ = dispatcher_->CreateAsyncTask(std::make_unique<StepTask>(this));
+  step_task_->Run();
+}
+
+void AsyncExecution::Resume() {
+  if (finished_) {
+    return;
+  }
+  if (step_running()) {
+    woken_ = true;
+    return;
+  }
+  RunStep();
+}
+
+void AsyncExecution::OnStepDone(const StatusOr<bool>& done) {
+  // This is called by the task, which has to outlive the call.
+  dispatcher_->DeferredDelete(std::move(step_task_));
+
+  if (!done.ok() || done.ValueOrDie()) {
+    finished_ = true;
+    yield_timer_.reset();
+    // The done function may drop the last reference to the query's state, this execution is
+    // released right after it.
+    auto self = std::move(self_);
+    done_(done.status());
+    return;
+  }
+  if (woken_) {
+    RunStep();
+    return;
+  }
+  yield_timer_->EnableTimer(yield_timeout_);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
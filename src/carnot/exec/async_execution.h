@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "src/common/base/base.h"
+#include "src/common/event/dispatcher.h"
+#include "src/common/event/task.h"
+#include "src/common/event/timer.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * AsyncExecution runs a query as a resumable task on the thread pool of a dispatcher, so that the
+ * query doesn't hold a thread while it waits for data from other agents. Each step of the query
+ * runs on the thread pool until the query is done or can't make progress. A blocked query is
+ * resumed when the wake function passed to its step is called (e.g. when a GRPC source receives a
+ * batch) or when the yield timeout passes, which lets a few threads run many queries at once.
+ *
+ * The execution keeps itself alive until the query is done. Start() must be called on the
+ * dispatcher's thread, the done function is called on it too.
+ */
+class AsyncExecution : public std::enable_shared_from_this<AsyncExecution> {
+ public:
+  using WakeFunc = std::function<void()>;
+  // Runs a step of the query, returns true when the query is done and false when it's blocked.
+  // The wake function can be called from any thread, also after the query is done.
+  using StepFunc = std::function<StatusOr<bool>(const WakeFunc& wake)>;
+  using DoneFunc = std::function<void(Status)>;
+
+  static std::shared_ptr<AsyncExecution> Create(event::Dispatcher* dispatcher,
+                                                std::chrono::milliseconds yield_timeout,
+                                                StepFunc step, DoneFunc done);
+
+  /**
+   * Runs the first step of the query.
+   */
+  void Start();
+
+  /**
+   * Whether a step of the query is running on the thread pool.
+   */
+  bool step_running() const { return step_task_ != nullptr; }
+
+ private:
+  class StepTask;
+
+  AsyncExecution(event::Dispatcher* dispatcher, std::chrono::milliseconds yield_timeout,
+                 StepFunc step, DoneFunc done);
+
+  void RunStep();
+  void OnStepDone(const StatusOr<bool>& done);
+  // Runs the next step, or marks the running step as woken so the next one runs right after it.
+  void Resume();
+
+  event::Dispatcher* dispatcher_;
+  std::chrono::milliseconds yield_timeout_;
+  StepFunc step_;
+  DoneFunc done_;
+  WakeFunc wake_;
+
+  // Holds this execution until the query is done.
+  std::shared_ptr<AsyncExecution> self_;
+  event::RunnableAsyncTaskUPtr step_task_;
+  event::TimerUPtr yield_timer_;
+  // Whether the query was woken while its step was running.
+  bool woken_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+
+#include "src/carnot/exec/async_execution.h"
+#include "src/common/event/event.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using event::Dispatcher;
+
+class AsyncExecutionTest : public ::testing::Test {
+ protected:
+  AsyncExecutionTest()
+      : api_(std::make_unique<event::APIImpl>(&time_system_)),
+        dispatcher_(api_->AllocateDispatcher("async_execution_test")) {}
+
+  // Runs the execution on the dispatcher until it's done, and returns its status.
+  Status Run(std::chrono::milliseconds yield_timeout, AsyncExecution::StepFunc step) {
+    Status status;
+    auto execution =
+        AsyncExecution::Create(dispatcher_.get(), yield_timeout, std::move(step), [&](Status s) {
+          status = s;
+          dispatcher_->Exit();
+        });
+    dispatcher_->Post([execution] { execution->Start(); });
+    execution.reset();
+    dispatcher_->Run(Dispatcher::RunType::RunUntilExit);
+    return status;
+  }
+
+  event::RealTimeSystem time_system_;
+  std::unique_ptr<event::API> api_;
+  std::unique_ptr<Dispatcher> dispatcher_;
+};
+
+TEST_F(AsyncExecutionTest, resumes_when_woken) {
+  std::atomic<int> steps = 0;
+  // The yield timeout is long enough that only the wake resumes the query.
+  auto s = Run(std::chrono::seconds(60), [&](const AsyncExecution::WakeFunc& wake) {
+    if (++steps == 1) {
+      wake();
+      return StatusOr<bool>(false);
+    }
+    return StatusOr<bool>(true);
+  });
+  EXPECT_OK(s);
+  EXPECT_EQ(2, steps);
+}
+
+TEST_F(AsyncExecutionTest, resumes_after_yield_timeout) {
+  std::atomic<int> steps = 0;
+  auto s = Run(std::chrono::milliseconds(10), [&](const AsyncExecution::WakeFunc&) {
+    return StatusOr<bool>(++steps == 3);
+  });
+  EXPECT_OK(s);
+  EXPECT_EQ(3, steps);
+}
+
+TEST_F(AsyncExecutionTest, stops_on_error) {
+  std::atomic<int> steps = 0;
+  auto s = Run(std::chrono::milliseconds(10), [&](const AsyncExecution::WakeFunc&) {
+    ++steps;
+    return StatusOr<bool>(error::Internal("step failed"));
+  });
+  EXPECT_NOT_OK(s);
+  EXPECT_EQ(1, steps);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
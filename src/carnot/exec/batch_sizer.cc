@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/batch_sizer.h"
+
+#include <arrow/array.h>
+#include <algorithm>
+#include <utility>
+
+DEFINE_int64(carnot_target_batch_bytes, gflags::Int64FromEnv("PL_CARNOT_TARGET_BATCH_BYTES", 0),
+             "The number of bytes that memory sources and ordered unions size their row batches "
+             "to, from the schema and the observed string lengths. Zero keeps the batch sizes of "
+             "the tables and the plan.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+namespace {
+
+int64_t FixedWidth(types::DataType type) {
+  switch (type) {
+    case types::DataType::BOOLEAN:
+      return sizeof(bool);
+    case types::DataType::UINT128:
+      return 2 * sizeof(uint64_t);
+    case types::DataType::STRING:
+      // The offset of the string, its characters are estimated separately.
+      return sizeof(int32_t);
+    default:
+      return sizeof(int64_t);
+  }
+}
+
+}  // namespace
+
+BatchSizer::BatchSizer(const table_store::schema::RowDescriptor& desc, int64_t target_bytes)
+    : target_bytes_(target_bytes) {
+  for (size_t i = 0; i < desc.size(); ++i) {
+    fixed_row_bytes_ += FixedWidth(desc.type(i));
+    if (desc.type(i) == types::DataType::STRING) {
+      string_cols_.push_back(i);
+    }
+  }
+}
+
+void BatchSizer::Observe(const RowBatch& rb) {
+  for (int64_t col_idx : string_cols_) {
+    auto col = rb.ColumnAt(col_idx);
+    // Dictionary-encoded strings only take the width of their codes.
+    if (col == nullptr || col->type_id() != arrow::Type::STRING) {
+      continue;
+    }
+    const auto* strs = static_cast<const arrow::StringArray*>(col.get());
+    observed_string_bytes_ += strs->value_offset(strs->length()) - strs->value_offset(0);
+    observed_strings_ += strs->length();
+  }
+}
+
+int64_t BatchSizer::RowBytes() const {
+  int64_t string_bytes =
+      observed_strings_ == 0 ? kDefaultStringBytes : observed_string_bytes_ / observed_strings_;
+  return std::max<int64_t>(1, fixed_row_bytes_ + string_bytes * string_cols_.size());
+}
+
+int64_t BatchSizer::RowsPerBatch() const {
+  return std::clamp(target_bytes_ / RowBytes(), kMinRows, kMaxRows);
+}
+
+StatusOr<std::vector<std::unique_ptr<RowBatch>>> BatchSizer::Split(const RowBatch& rb,
+                                                                   int64_t max_rows) {
+  DCHECK_GT(max_rows, 0);
+  std::vector<std::unique_ptr<RowBatch>> batches;
+  int64_t num_selected = rb.num_selected_rows();
+  for (int64_t begin = 0; begin < num_selected || batches.empty(); begin += max_rows) {
+    int64_t end = std::min(begin + max_rows, num_selected);
+    std::unique_ptr<RowBatch> batch;
+    if (!rb.has_selection()) {
+      PL_ASSIGN_OR_RETURN(batch, rb.Slice(begin, end - begin));
+    } else if (begin == end) {
+      PL_ASSIGN_OR_RETURN(batch, rb.Slice(0, 0));
+    } else {
+      // Slice the rows spanned by the selected rows, and shift their indexes to the slice.
+      const auto& selection = *rb.selection();
+      int64_t row_begin = selection[begin];
+      int64_t row_end = selection[end - 1] + 1;
+      PL_ASSIGN_OR_RETURN(batch, rb.Slice(row_begin, row_end - row_begin));
+      if (row_end - row_begin != end - begin) {
+        auto rows = std::make_shared<std::vector<int64_t>>();
+        rows->reserve(end - begin);
+        for (int64_t i = begin; i < end; ++i) {
+          rows->push_back(selection[i] - row_begin);
+        }
+        batch->set_selection(std::move(rows));
+      }
+    }
+    batches.push_back(std::move(batch));
+  }
+  batches.back()->set_eow(rb.eow());
+  batches.back()->set_eos(rb.eos());
+  return batches;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+#include "src/table_store/schema/row_descriptor.h"
+
+DECLARE_int64(carnot_target_batch_bytes);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * Picks the number of rows of the row batches of a schema so that each batch takes about a byte
+ * budget, which by default should fit in L2 with room to spare. The size of a row is estimated
+ * from the fixed widths of the column types and from the average length of the strings observed
+ * so far.
+ */
+class BatchSizer {
+ public:
+  // The bounds of the number of rows of a batch, so that a few huge strings don't make batches of
+  // single rows, and so that narrow schemas don't make batches with huge builders.
+  static constexpr int64_t kMinRows = 64;
+  static constexpr int64_t kMaxRows = 1 << 16;
+  // The string length assumed until strings are observed.
+  static constexpr int64_t kDefaultStringBytes = 32;
+
+  explicit BatchSizer(const table_store::schema::RowDescriptor& desc,
+                      int64_t target_bytes = FLAGS_carnot_target_batch_bytes);
+
+  // Whether batches should be sized at all. Sizing is off when the target isn't positive.
+  bool enabled() const { return target_bytes_ > 0; }
+
+  // Adds the lengths of the strings of the batch to the estimate of the size of a row.
+  void Observe(const table_store::schema::RowBatch& rb);
+
+  // The estimated size of a row, in bytes.
+  int64_t RowBytes() const;
+
+  // The number of rows that fit the target.
+  int64_t RowsPerBatch() const;
+
+  /**
+   * Splits the batch into consecutive batches of at most max_rows selected rows, sharing its
+   * arrays. The selection of the batch is split along with it. Only the last of the batches keeps
+   * the eow and eos of the batch.
+   */
+  static StatusOr<std::vector<std::unique_ptr<table_store::schema::RowBatch>>> Split(
+      const table_store::schema::RowBatch& rb, int64_t max_rows);
+
+ private:
+  int64_t target_bytes_;
+  int64_t fixed_row_bytes_ = 0;
+  std::vector<int64_t> string_cols_;
+  int64_t observed_string_bytes_ = 0;
+  int64_t observed_strings_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
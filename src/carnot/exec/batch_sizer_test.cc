@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/carnot/exec/batch_sizer.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+using types::DataType;
+
+TEST(BatchSizer, rows_per_batch) {
+  RowDescriptor rd({DataType::TIME64NS, DataType::INT64});
+  EXPECT_FALSE(BatchSizer(rd, 0).enabled());
+
+  BatchSizer sizer(rd, 16 * 1024);
+  EXPECT_TRUE(sizer.enabled());
+  EXPECT_EQ(16, sizer.RowBytes());
+  EXPECT_EQ(1024, sizer.RowsPerBatch());
+
+  // A tiny budget still makes batches of kMinRows, and a huge one of kMaxRows.
+  EXPECT_EQ(BatchSizer::kMinRows, BatchSizer(rd, 1).RowsPerBatch());
+  EXPECT_EQ(BatchSizer::kMaxRows, BatchSizer(rd, int64_t{1} << 40).RowsPerBatch());
+}
+
+TEST(BatchSizer, observes_strings) {
+  RowDescriptor rd({DataType::INT64, DataType::STRING});
+  BatchSizer sizer(rd, 1024 * 1024);
+  EXPECT_EQ(8 + 4 + BatchSizer::kDefaultStringBytes, sizer.RowBytes());
+
+  auto rb = RowBatchBuilder(rd, 2, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>({1, 2})
+                .AddColumn<types::StringValue>({std::string(100, 'a'), std::string(300, 'b')})
+                .get();
+  sizer.Observe(rb);
+  EXPECT_EQ(8 + 4 + 200, sizer.RowBytes());
+}
+
+TEST(BatchSizer, split) {
+  RowDescriptor rd({DataType::INT64});
+  auto rb = RowBatchBuilder(rd, 5, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                .get();
+  ASSERT_OK_AND_ASSIGN(auto batches, BatchSizer::Split(rb, 2));
+  ASSERT_EQ(3, batches.size());
+  EXPECT_EQ(2, batches[0]->num_rows());
+  EXPECT_FALSE(batches[0]->eos());
+  EXPECT_EQ(1, batches[2]->num_rows());
+  EXPECT_TRUE(batches[2]->eow());
+  EXPECT_TRUE(batches[2]->eos());
+  EXPECT_EQ(5, static_cast<arrow::Int64Array*>(batches[2]->ColumnAt(0).get())->Value(0));
+}
+
+TEST(BatchSizer, split_selection) {
+  RowDescriptor rd({DataType::INT64});
+  auto rb = RowBatchBuilder(rd, 6, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                .get();
+  rb.set_selection(std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 2, 3, 5}));
+
+  ASSERT_OK_AND_ASSIGN(auto batches, BatchSizer::Split(rb, 2));
+  ASSERT_EQ(2, batches.size());
+  // Rows 0 and 2 span [0, 3), and rows 3 and 5 span [3, 6).
+  EXPECT_EQ(3, batches[0]->num_rows());
+  EXPECT_EQ(std::vector<int64_t>({0, 2}), *batches[0]->selection());
+  EXPECT_EQ(3, batches[1]->num_rows());
+  EXPECT_EQ(std::vector<int64_t>({0, 2}), *batches[1]->selection());
+  EXPECT_EQ(6, static_cast<arrow::Int64Array*>(batches[1]->ColumnAt(0).get())->Value(2));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,303 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/column_predicate.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+
+using Op = planpb::ColumnPredicate;
+
+std::string_view StringAt(const arrow::StringArray& arr, int64_t i) {
+  int32_t len = 0;
+  const uint8_t* data = arr.GetValue(i, &len);
+  return std::string_view(reinterpret_cast<const char*>(data), len);
+}
+
+template <typename TGetter, typename TValue, typename TCmp>
+void ApplyCmp(int64_t n, TGetter get, const TValue& val, TCmp cmp, std::vector<bool>* selected) {
+  for (int64_t i = 0; i < n; ++i) {
+    if ((*selected)[i] && !cmp(get(i), val)) {
+      (*selected)[i] = false;
+    }
+  }
+}
+
+// Dispatches on the op outside of the loop, so that the comparison inlines.
+template <typename TGetter, typename TValue>
+void ApplyOp(planpb::ColumnPredicate::Op op, int64_t n, TGetter get, const TValue& val,
+             std::vector<bool>* selected) {
+  switch (op) {
+    case Op::EQ:
+      return ApplyCmp(n, get, val, std::equal_to<>(), selected);
+    case Op::NE:
+      return ApplyCmp(n, get, val, std::not_equal_to<>(), selected);
+    case Op::LT:
+      return ApplyCmp(n, get, val, std::less<>(), selected);
+    case Op::LE:
+      return ApplyCmp(n, get, val, std::less_equal<>(), selected);
+    case Op::GT:
+      return ApplyCmp(n, get, val, std::greater<>(), selected);
+    case Op::GE:
+      return ApplyCmp(n, get, val, std::greater_equal<>(), selected);
+    default:
+      LOG(DFATAL) << "Unexpected predicate op: " << op;
+  }
+}
+
+template <typename T>
+bool RangeMayMatch(planpb::ColumnPredicate::Op op, const T& min, const T& max, const T& val) {
+  switch (op) {
+    case Op::EQ:
+      return min <= val && val <= max;
+    case Op::NE:
+      return !(min == max && min == val);
+    case Op::LT:
+      return min < val;
+    case Op::LE:
+      return min <= val;
+    case Op::GT:
+      return max > val;
+    case Op::GE:
+      return max >= val;
+    default:
+      return true;
+  }
+}
+
+template <types::DataType T>
+StatusOr<std::shared_ptr<arrow::Array>> SelectRowsImpl(const arrow::Array& arr,
+                                                       const std::vector<bool>& selected,
+                                                       int64_t num_selected,
+                                                       arrow::MemoryPool* mem_pool) {
+  using TArray = typename types::DataTypeTraits<T>::arrow_array_type;
+  using TBuilder = typename types::DataTypeTraits<T>::arrow_builder_type;
+  const auto& typed_arr = static_cast<const TArray&>(arr);
+
+  TBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(num_selected));
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    if (selected[i]) {
+      builder.UnsafeAppend(typed_arr.Value(i));
+    }
+  }
+  std::shared_ptr<arrow::Array> out;
+  PL_RETURN_IF_ERROR(builder.Finish(&out));
+  return out;
+}
+
+template <>
+StatusOr<std::shared_ptr<arrow::Array>> SelectRowsImpl<types::DataType::STRING>(
+    const arrow::Array& arr, const std::vector<bool>& selected, int64_t num_selected,
+    arrow::MemoryPool* mem_pool) {
+  const auto& str_arr = static_cast<const arrow::StringArray&>(arr);
+
+  int64_t total_size = 0;
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    if (selected[i]) {
+      total_size += str_arr.value_length(i);
+    }
+  }
+
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(num_selected));
+  PL_RETURN_IF_ERROR(builder.ReserveData(total_size));
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    if (selected[i]) {
+      auto val = StringAt(str_arr, i);
+      builder.UnsafeAppend(reinterpret_cast<const uint8_t*>(val.data()), val.size());
+    }
+  }
+  std::shared_ptr<arrow::Array> out;
+  PL_RETURN_IF_ERROR(builder.Finish(&out));
+  return out;
+}
+
+// Only the codes of the selected rows are copied, the dictionary is shared with the input.
+StatusOr<std::shared_ptr<arrow::Array>> SelectDictionaryRows(const arrow::Array& arr,
+                                                             const std::vector<bool>& selected,
+                                                             int64_t num_selected,
+                                                             arrow::MemoryPool* mem_pool) {
+  const auto& dict_arr = static_cast<const arrow::DictionaryArray&>(arr);
+  auto codes = static_cast<const arrow::Int32Array*>(dict_arr.indices().get());
+
+  arrow::Int32Builder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(num_selected));
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    if (selected[i]) {
+      builder.UnsafeAppend(codes->Value(i));
+    }
+  }
+  std::shared_ptr<arrow::Array> selected_codes;
+  PL_RETURN_IF_ERROR(builder.Finish(&selected_codes));
+  return types::MakeDictionaryStringArray(selected_codes, dict_arr.dictionary());
+}
+
+}  // namespace
+
+StatusOr<ColumnPredicate> ColumnPredicate::Create(const planpb::ColumnPredicate& pb,
+                                                  types::DataType column_type) {
+  const auto& value = pb.value();
+  ColumnPredicate pred;
+  pred.column_idx_ = pb.column_idx();
+  pred.type_ = column_type;
+  pred.op_ = pb.op();
+
+  if (pred.op_ == planpb::ColumnPredicate::OP_UNKNOWN) {
+    return error::InvalidArgument("Column predicate on column $0 has no op.", pb.column_idx());
+  }
+
+  switch (column_type) {
+    case types::DataType::BOOLEAN:
+      if (value.value_case() == planpb::ScalarValue::kBoolValue) {
+        pred.bool_value_ = value.bool_value();
+        return pred;
+      }
+      break;
+    case types::DataType::INT64:
+      if (value.value_case() == planpb::ScalarValue::kInt64Value) {
+        pred.int64_value_ = value.int64_value();
+        return pred;
+      }
+      break;
+    case types::DataType::TIME64NS:
+      if (value.value_case() == planpb::ScalarValue::kTime64NsValue) {
+        pred.int64_value_ = value.time64_ns_value();
+        return pred;
+      }
+      if (value.value_case() == planpb::ScalarValue::kInt64Value) {
+        pred.int64_value_ = value.int64_value();
+        return pred;
+      }
+      break;
+    case types::DataType::FLOAT64:
+      if (value.value_case() == planpb::ScalarValue::kFloat64Value) {
+        pred.float64_value_ = value.float64_value();
+        return pred;
+      }
+      break;
+    case types::DataType::STRING:
+      if (value.value_case() == planpb::ScalarValue::kStringValue) {
+        pred.string_value_ = value.string_value();
+        return pred;
+      }
+      break;
+    case types::DataType::UINT128:
+      if (value.value_case() == planpb::ScalarValue::kUint128Value) {
+        pred.uint128_value_ =
+            absl::MakeUint128(value.uint128_value().high(), value.uint128_value().low());
+        return pred;
+      }
+      break;
+    default:
+      break;
+  }
+  return error::InvalidArgument("Column predicate value does not match column type $0.",
+                                types::ToString(column_type));
+}
+
+bool ColumnPredicate::MayMatch(const table_store::ColumnZone& zone) const {
+  if (zone.num_rows == 0) {
+    return false;
+  }
+  if (!zone.has_range) {
+    return true;
+  }
+  switch (type_) {
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+      return RangeMayMatch(op_, zone.min, zone.max, int64_value_);
+    case types::DataType::UINT128:
+      return RangeMayMatch(op_, zone.min_uint128, zone.max_uint128, uint128_value_);
+    default:
+      return true;
+  }
+}
+
+void ColumnPredicate::Apply(const arrow::Array& col, std::vector<bool>* selected) const {
+  DCHECK_EQ(static_cast<int64_t>(selected->size()), col.length());
+  int64_t n = col.length();
+
+  switch (type_) {
+    case types::DataType::BOOLEAN: {
+      const auto& arr = static_cast<const arrow::BooleanArray&>(col);
+      ApplyOp(
+          op_, n, [&arr](int64_t i) { return arr.Value(i); }, bool_value_, selected);
+      break;
+    }
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS: {
+      const int64_t* vals = static_cast<const arrow::Int64Array&>(col).raw_values();
+      ApplyOp(
+          op_, n, [vals](int64_t i) { return vals[i]; }, int64_value_, selected);
+      break;
+    }
+    case types::DataType::FLOAT64: {
+      const double* vals = static_cast<const arrow::DoubleArray&>(col).raw_values();
+      ApplyOp(
+          op_, n, [vals](int64_t i) { return vals[i]; }, float64_value_, selected);
+      break;
+    }
+    case types::DataType::STRING: {
+      const auto& arr = static_cast<const arrow::StringArray&>(col);
+      std::string_view val(string_value_);
+      ApplyOp(
+          op_, n, [&arr](int64_t i) { return StringAt(arr, i); }, val, selected);
+      break;
+    }
+    case types::DataType::UINT128: {
+      const auto& arr = static_cast<const arrow::UInt128Array&>(col);
+      ApplyOp(
+          op_, n, [&arr](int64_t i) -> absl::uint128 { return arr.Value(i); }, uint128_value_,
+          selected);
+      break;
+    }
+    default:
+      LOG(DFATAL) << "Unsupported predicate type: " << types::ToString(type_);
+  }
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> SelectRows(types::DataType data_type,
+                                                   const arrow::Array& arr,
+                                                   const std::vector<bool>& selected,
+                                                   int64_t num_selected,
+                                                   arrow::MemoryPool* mem_pool) {
+  DCHECK_EQ(static_cast<int64_t>(selected.size()), arr.length());
+  if (types::IsDictionaryArray(arr)) {
+    return SelectDictionaryRows(arr, selected, num_selected, mem_pool);
+  }
+#define TYPE_CASE(_dt_) return SelectRowsImpl<_dt_>(arr, selected, num_selected, mem_pool);
+  PL_SWITCH_FOREACH_DATATYPE(data_type, TYPE_CASE);
+#undef TYPE_CASE
+  return error::Internal("Unreachable");
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/numeric/int128.h>
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * ColumnPredicate evaluates a comparison that the planner pushed down into a source
+ * (planpb::ColumnPredicate). It works on a single column at a time, so the source can evaluate it
+ * before it materializes any of the other columns.
+ */
+class ColumnPredicate {
+ public:
+  /**
+   * Creates the predicate for a table column of the given type. Fails if the constant does not
+   * match the column type.
+   */
+  static StatusOr<ColumnPredicate> Create(const planpb::ColumnPredicate& pb,
+                                          types::DataType column_type);
+
+  int64_t column_idx() const { return column_idx_; }
+
+  /**
+   * @return false if the zone map proves that no row of the batch satisfies the predicate.
+   */
+  bool MayMatch(const table_store::ColumnZone& zone) const;
+
+  /**
+   * Clears the entries of selected for the rows of col that do not satisfy the predicate.
+   */
+  void Apply(const arrow::Array& col, std::vector<bool>* selected) const;
+
+ private:
+  ColumnPredicate() = default;
+
+  int64_t column_idx_ = 0;
+  types::DataType type_ = types::DataType::DATA_TYPE_UNKNOWN;
+  planpb::ColumnPredicate::Op op_ = planpb::ColumnPredicate::OP_UNKNOWN;
+
+  // The constant to compare against. Only the member matching type_ is set.
+  bool bool_value_ = false;
+  int64_t int64_value_ = 0;
+  double float64_value_ = 0;
+  std::string string_value_;
+  absl::uint128 uint128_value_ = 0;
+};
+
+/**
+ * Copies the rows of arr for which selected is true into a new array.
+ */
+StatusOr<std::shared_ptr<arrow::Array>> SelectRows(types::DataType data_type,
+                                                   const arrow::Array& arr,
+                                                   const std::vector<bool>& selected,
+                                                   int64_t num_selected,
+                                                   arrow::MemoryPool* mem_pool);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/column_predicate.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+planpb::ColumnPredicate Int64Predicate(planpb::ColumnPredicate::Op op, int64_t val) {
+  planpb::ColumnPredicate pb;
+  pb.set_column_idx(0);
+  pb.set_op(op);
+  pb.mutable_value()->set_int64_value(val);
+  return pb;
+}
+
+TEST(ColumnPredicateTest, create_type_mismatch) {
+  EXPECT_NOT_OK(ColumnPredicate::Create(Int64Predicate(planpb::ColumnPredicate::EQ, 1),
+                                        types::DataType::STRING));
+  EXPECT_NOT_OK(ColumnPredicate::Create(Int64Predicate(planpb::ColumnPredicate::OP_UNKNOWN, 1),
+                                        types::DataType::INT64));
+  EXPECT_OK(ColumnPredicate::Create(Int64Predicate(planpb::ColumnPredicate::EQ, 1),
+                                    types::DataType::TIME64NS));
+}
+
+TEST(ColumnPredicateTest, may_match) {
+  std::vector<types::Int64Value> vals = {10, 20, 30};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+  auto zone = table_store::ColumnZone::FromArrow(types::DataType::INT64, arr.get());
+
+  auto may_match = [&](planpb::ColumnPredicate::Op op, int64_t val) {
+    auto pred = ColumnPredicate::Create(Int64Predicate(op, val), types::DataType::INT64);
+    EXPECT_OK(pred);
+    return pred.ConsumeValueOrDie().MayMatch(zone);
+  };
+
+  EXPECT_TRUE(may_match(planpb::ColumnPredicate::EQ, 15));
+  EXPECT_FALSE(may_match(planpb::ColumnPredicate::EQ, 31));
+  EXPECT_TRUE(may_match(planpb::ColumnPredicate::NE, 10));
+  EXPECT_FALSE(may_match(planpb::ColumnPredicate::LT, 10));
+  EXPECT_TRUE(may_match(planpb::ColumnPredicate::LE, 10));
+  EXPECT_FALSE(may_match(planpb::ColumnPredicate::GT, 30));
+  EXPECT_TRUE(may_match(planpb::ColumnPredicate::GE, 30));
+}
+
+TEST(ColumnPredicateTest, apply_and_select_strings) {
+  std::vector<types::StringValue> vals = {"abc", "def", "abc", "ghi"};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  planpb::ColumnPredicate pb;
+  pb.set_column_idx(0);
+  pb.set_op(planpb::ColumnPredicate::NE);
+  pb.mutable_value()->set_string_value("abc");
+  auto pred_or_s = ColumnPredicate::Create(pb, types::DataType::STRING);
+  ASSERT_OK(pred_or_s);
+  auto pred = pred_or_s.ConsumeValueOrDie();
+
+  std::vector<bool> selected(vals.size(), true);
+  pred.Apply(*arr, &selected);
+  EXPECT_EQ(std::vector<bool>({false, true, false, true}), selected);
+
+  auto out_or_s =
+      SelectRows(types::DataType::STRING, *arr, selected, 2, arrow::default_memory_pool());
+  ASSERT_OK(out_or_s);
+  auto out = out_or_s.ConsumeValueOrDie();
+  ASSERT_EQ(2, out->length());
+  EXPECT_EQ("def", types::GetValueFromArrowArray<types::DataType::STRING>(out.get(), 0));
+  EXPECT_EQ("ghi", types::GetValueFromArrowArray<types::DataType::STRING>(out.get(), 1));
+}
+
+TEST(ColumnPredicateTest, apply_int64) {
+  std::vector<types::Int64Value> vals = {1, 5, 3, 7};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  auto pred = ColumnPredicate::Create(Int64Predicate(planpb::ColumnPredicate::GT, 2),
+                                      types::DataType::INT64)
+                  .ConsumeValueOrDie();
+  auto pred2 = ColumnPredicate::Create(Int64Predicate(planpb::ColumnPredicate::LT, 7),
+                                       types::DataType::INT64)
+                   .ConsumeValueOrDie();
+  std::vector<bool> selected(vals.size(), true);
+  pred.Apply(*arr, &selected);
+  pred2.Apply(*arr, &selected);
+  EXPECT_EQ(std::vector<bool>({false, true, true, false}), selected);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -29,12 +29,24 @@
 #include <absl/strings/str_join.h>
 #include <absl/strings/substitute.h>
 
+#include "src/carnot/exec/column_predicate.h"
+#include "src/carnot/exec/hash_kernels.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/carnot/udf/udf_wrapper.h"
 #include "src/common/base/base.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 
+DEFINE_int64(equijoin_memory_budget_bytes,
+             gflags::Int64FromEnv("PL_EQUIJOIN_MEMORY_BUDGET_BYTES", 0),
+             "The number of bytes a join buffers in memory before it spills partitions of its "
+             "inputs to disk. Set to '0' to keep the whole join in memory.");
+DEFINE_int32(equijoin_num_partitions, 16,
+             "The number of partitions a join splits its inputs into when it has a memory "
+             "budget. Rounded up to a power of two.");
+DEFINE_string(equijoin_spill_dir, gflags::StringFromEnv("PL_EQUIJOIN_SPILL_DIR", "/tmp"),
+              "The directory the join spill files are created in.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -61,14 +73,28 @@ Status EquijoinNode::InitImpl(const plan::Operator& plan_node) {
   output_rows_per_batch_ =
       plan_node_->rows_per_batch() == 0 ? kDefaultJoinRowBatchSize : plan_node_->rows_per_batch();
 
-  if (plan_node_->order_by_time() && plan_node_->time_column().parent_index() == 0) {
-    // Make the probe table the left table when we need to preserve the order of the left table in
-    // the output.
+  if (plan_node_->order_by_time()) {
+    // Probe the table the output is time ordered by, to preserve its order in the output.
+    probe_table_ = plan_node_->time_column().parent_index() == 0
+                       ? EquijoinNode::JoinInputTable::kLeftTable
+                       : EquijoinNode::JoinInputTable::kRightTable;
+  } else if (plan_node_->build_parent_index() == 1) {
     probe_table_ = EquijoinNode::JoinInputTable::kLeftTable;
   } else {
     probe_table_ = EquijoinNode::JoinInputTable::kRightTable;
   }
 
+  // Partitioning reorders the probe rows, so it is not used when the output has to follow the
+  // time order of an input.
+  memory_budget_bytes_ = FLAGS_equijoin_memory_budget_bytes;
+  partitioned_ = memory_budget_bytes_ > 0 && !plan_node_->order_by_time();
+  if (partitioned_) {
+    while ((1 << partition_bits_) < FLAGS_equijoin_num_partitions && partition_bits_ < 16) {
+      ++partition_bits_;
+    }
+    partitions_.resize(1 << partition_bits_);
+  }
+
   switch (plan_node_->type()) {
     case planpb::JoinOperator::INNER:
       build_spec_.emit_unmatched_rows = false;
@@ -116,9 +142,11 @@ Status EquijoinNode::InitImpl(const plan::Operator& plan_node) {
 }
 
 Status EquijoinNode::InitializeColumnBuilders() {
+  // The builders are reset when a batch is built from them, so they are only created once.
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
-    column_builders_[i] =
-        MakeArrowBuilder(output_descriptor_->type(i), arrow::default_memory_pool());
+    if (column_builders_[i] == nullptr) {
+      column_builders_[i] = MakeArrowBuilder(output_descriptor_->type(i), mem_pool());
+    }
     PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
   }
   return Status::OK();
@@ -131,13 +159,41 @@ Status EquijoinNode::PrepareImpl(ExecState* /*exec_state*/) {
   return Status::OK();
 }
 
-Status EquijoinNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+Status EquijoinNode::OpenImpl(ExecState* exec_state) {
+  if (plan_node_->join_filter_id() == 0 || exec_state->grpc_router() == nullptr) {
+    return Status::OK();
+  }
+  // Dropping probe rows is only safe when the unmatched ones aren't part of the output.
+  if (!FLAGS_carnot_join_filters || probe_spec_.emit_unmatched_rows) {
+    exec_state->grpc_router()->PublishJoinFilter(exec_state->query_id(),
+                                                 plan_node_->join_filter_id(), nullptr);
+    return Status::OK();
+  }
+  join_filter_builder_ = std::make_unique<JoinFilterBuilder>(
+      build_spec_.key_indices, FLAGS_carnot_join_filter_max_build_keys);
+  return Status::OK();
+}
+
+Status EquijoinNode::AddToJoinFilter(ExecState* exec_state, const RowBatch& rb) {
+  join_filter_builder_->AddBatch(rb);
+  if (!rb.eos()) {
+    return Status::OK();
+  }
+  PL_ASSIGN_OR_RETURN(auto filter, join_filter_builder_->Finish());
+  exec_state->grpc_router()->PublishJoinFilter(exec_state->query_id(),
+                                               plan_node_->join_filter_id(), filter.get());
+  join_filter_builder_.reset();
+  return Status::OK();
+}
 
 Status EquijoinNode::CloseImpl(ExecState* /*exec_state*/) {
   join_keys_chunk_.clear();
   build_buffer_.clear();
   probed_keys_.clear();
   key_values_pool_.Clear();
+  // Closes (and so removes) any spill file left over by a join that didn't finish.
+  partitions_.clear();
+  buffered_bytes_ = 0;
   return Status::OK();
 }
 
@@ -155,7 +211,7 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
   // Reset the row tuples
   for (auto& rt : join_keys_chunk_) {
     if (rt == nullptr) {
-      rt = key_values_pool_.Add(new RowTuple(&key_data_types_));
+      rt = key_values_pool_.New<RowTuple>(&key_data_types_);
     } else {
       rt->Reset();
     }
@@ -167,7 +223,7 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
     int prev_size = join_keys_chunk_.size();
     join_keys_chunk_.reserve(num_rows);
     for (size_t idx = prev_size; idx < num_rows; ++idx) {
-      auto tuple_ptr = key_values_pool_.Add(new RowTuple(&key_data_types_));
+      auto tuple_ptr = key_values_pool_.New<RowTuple>(&key_data_types_);
       join_keys_chunk_.emplace_back(tuple_ptr);
     }
   }
@@ -175,22 +231,29 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
   const TableSpec& spec = is_probe ? probe_spec_ : build_spec_;
 
   // Scan through all the group args in column order and extract the entire column.
+  std::vector<const arrow::Array*> key_cols;
   for (size_t tuple_col_idx = 0; tuple_col_idx < spec.key_indices.size(); ++tuple_col_idx) {
     auto input_col_idx = spec.key_indices[tuple_col_idx];
     auto dt = key_data_types_[tuple_col_idx];
     auto col = rb.ColumnAt(input_col_idx).get();
+    key_cols.push_back(col);
 
 #define TYPE_CASE(_dt_) ExtractIntoRowTuples<_dt_>(&join_keys_chunk_, col, tuple_col_idx);
     PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
 #undef TYPE_CASE
   }
 
+  // The hashes are computed a column at a time as well, rather than by each lookup.
+  HashColumns(key_cols, key_data_types_, rb.num_rows(), &join_key_hashes_);
+  for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    join_keys_chunk_[row_idx]->SetHash(join_key_hashes_[row_idx]);
+  }
   return Status::OK();
 }
 
-std::vector<types::SharedColumnWrapper>* CreateWrapper(ObjectPool* pool,
+std::vector<types::SharedColumnWrapper>* CreateWrapper(ArenaObjectPool* pool,
                                                        const std::vector<types::DataType>& types) {
-  auto ptr = pool->Add(new std::vector<types::SharedColumnWrapper>(types.size()));
+  auto ptr = pool->New<std::vector<types::SharedColumnWrapper>>(types.size());
   for (size_t col_idx = 0; col_idx < types.size(); ++col_idx) {
     (*ptr)[col_idx] = types::ColumnWrapper::Make(types[col_idx], 0);
   }
@@ -238,24 +301,142 @@ Status EquijoinNode::HashRowBatch(const table_store::schema::RowBatch& rb) {
   return Status::OK();
 }
 
+namespace {
+
+// Appends the values of the unmatched side of a row. The builder must have room for them.
 template <types::DataType DT>
-Status AppendValuesFromWrapper(arrow::ArrayBuilder* output_builder,
-                               types::SharedColumnWrapper input_wrapper, size_t start_idx,
-                               size_t num_rows) {
+void AppendDefaultValues(typename types::DataTypeTraits<DT>::arrow_builder_type* builder,
+                         int64_t num_rows) {
   using ValueType = typename types::DataTypeTraits<DT>::value_type;
-  for (size_t row_idx = start_idx; row_idx < start_idx + num_rows; ++row_idx) {
-    PL_RETURN_IF_ERROR(table_store::schema::CopyValue<DT>(
-        output_builder, udf::UnWrap(input_wrapper->Get<ValueType>(row_idx))));
+  auto zeroval = udf::UnWrap(ValueType());
+  for (int64_t i = 0; i < num_rows; ++i) {
+    builder->UnsafeAppend(zeroval);
+  }
+}
+
+// Makes room in the string builder for data_bytes more bytes of values.
+Status ReserveStringData(arrow::StringBuilder* builder, int64_t data_bytes) {
+  int64_t size = builder->value_data_length() + data_bytes;
+  if (size > builder->value_data_capacity()) {
+    PL_RETURN_IF_ERROR(builder->ReserveData(size));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// Copies column col of the build side of the queued chunks into the output builder. The values
+// of a chunk are contiguous in the build table, so they are copied as a block where the value
+// type is laid out like the arrow values.
+template <types::DataType DT>
+Status EquijoinNode::GatherBuildColumn(size_t col, arrow::ArrayBuilder* output_builder) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  using NativeType = typename types::DataTypeTraits<DT>::native_type;
+  using WrapperType = types::ColumnWrapperTmpl<ValueType>;
+  auto* builder =
+      static_cast<typename types::DataTypeTraits<DT>::arrow_builder_type*>(output_builder);
+
+  if constexpr (DT == types::DataType::STRING) {
+    int64_t data_bytes = 0;
+    for (const auto& chunk : chunks_) {
+      if (chunk.wrappers_ptr == nullptr) {
+        continue;
+      }
+      const ValueType* values =
+          static_cast<const WrapperType*>(chunk.wrappers_ptr->at(col).get())->UnsafeRawData();
+      for (int64_t i = chunk.bb_row_idx; i < chunk.bb_row_idx + chunk.num_rows; ++i) {
+        data_bytes += values[i].size();
+      }
+    }
+    PL_RETURN_IF_ERROR(ReserveStringData(builder, data_bytes));
+  }
+
+  for (const auto& chunk : chunks_) {
+    if (chunk.wrappers_ptr == nullptr) {
+      AppendDefaultValues<DT>(builder, chunk.num_rows);
+      continue;
+    }
+    const ValueType* values =
+        static_cast<const WrapperType*>(chunk.wrappers_ptr->at(col).get())->UnsafeRawData() +
+        chunk.bb_row_idx;
+    if constexpr (types::kArrowLayoutCompatible<ValueType>) {
+      PL_RETURN_IF_ERROR(
+          builder->AppendValues(reinterpret_cast<const NativeType*>(values), chunk.num_rows));
+    } else if constexpr (DT == types::DataType::STRING) {
+      for (int64_t i = 0; i < chunk.num_rows; ++i) {
+        builder->UnsafeAppend(reinterpret_cast<const uint8_t*>(values[i].data()),
+                              values[i].size());
+      }
+    } else {
+      for (int64_t i = 0; i < chunk.num_rows; ++i) {
+        builder->UnsafeAppend(udf::UnWrap(values[i]));
+      }
+    }
   }
   return Status::OK();
 }
 
+// Copies column col of the probe side of the queued chunks into the output builder. A probe row
+// is repeated for each of its build matches. Runs of consecutive probe rows that have a single
+// match each, the common case of joins on unique build keys, are copied as a block.
 template <types::DataType DT>
-Status AppendColumnDefaultValue(arrow::ArrayBuilder* output_builder, size_t num_times) {
+Status EquijoinNode::GatherProbeColumn(size_t col, arrow::ArrayBuilder* output_builder) {
   using ValueType = typename types::DataTypeTraits<DT>::value_type;
-  ValueType zeroval;
-  for (size_t i = 0; i < num_times; ++i) {
-    PL_RETURN_IF_ERROR(table_store::schema::CopyValue<DT>(output_builder, udf::UnWrap(zeroval)));
+  using NativeType = typename types::DataTypeTraits<DT>::native_type;
+  using ArrayType = typename types::DataTypeTraits<DT>::arrow_array_type;
+  auto* builder =
+      static_cast<typename types::DataTypeTraits<DT>::arrow_builder_type*>(output_builder);
+  auto src_idx = probe_spec_.input_col_indices[col];
+
+  if constexpr (DT == types::DataType::STRING) {
+    int64_t data_bytes = 0;
+    for (const auto& chunk : chunks_) {
+      if (chunk.rb != nullptr) {
+        const auto* strs = static_cast<const ArrayType*>(chunk.rb->ColumnAt(src_idx).get());
+        data_bytes += strs->value_length(chunk.probe_row_idx) * chunk.num_rows;
+      }
+    }
+    PL_RETURN_IF_ERROR(ReserveStringData(builder, data_bytes));
+  }
+
+  for (size_t chunk_idx = 0; chunk_idx < chunks_.size();) {
+    const auto& chunk = chunks_[chunk_idx];
+    if (chunk.rb == nullptr) {
+      AppendDefaultValues<DT>(builder, chunk.num_rows);
+      ++chunk_idx;
+      continue;
+    }
+    const auto* input = static_cast<const ArrayType*>(chunk.rb->ColumnAt(src_idx).get());
+
+    if constexpr (types::kArrowLayoutCompatible<ValueType>) {
+      size_t run_end = chunk_idx + 1;
+      while (chunk.num_rows == 1 && run_end < chunks_.size() &&
+             chunks_[run_end].rb == chunk.rb && chunks_[run_end].num_rows == 1 &&
+             chunks_[run_end].probe_row_idx ==
+                 chunk.probe_row_idx + static_cast<int64_t>(run_end - chunk_idx)) {
+        ++run_end;
+      }
+      if (run_end - chunk_idx > 1) {
+        PL_RETURN_IF_ERROR(builder->AppendValues(
+            reinterpret_cast<const NativeType*>(input->raw_values() + chunk.probe_row_idx),
+            run_end - chunk_idx));
+        chunk_idx = run_end;
+        continue;
+      }
+    }
+
+    if constexpr (DT == types::DataType::STRING) {
+      auto str = input->GetView(chunk.probe_row_idx);
+      for (int64_t i = 0; i < chunk.num_rows; ++i) {
+        builder->UnsafeAppend(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+      }
+    } else {
+      auto value = types::GetValueFromArrowArray<DT>(input, chunk.probe_row_idx);
+      for (int64_t i = 0; i < chunk.num_rows; ++i) {
+        builder->UnsafeAppend(value);
+      }
+    }
+    ++chunk_idx;
   }
   return Status::OK();
 }
@@ -275,52 +456,32 @@ Status EquijoinNode::NextOutputBatch(ExecState* exec_state) {
   return InitializeColumnBuilders();
 }
 
-Status EquijoinNode::FlushChunkedRows(ExecState* exec_state) {
+Status EquijoinNode::AppendChunkedRows() {
+  // The chunks are the (build rows, probe row) pairs of the output rows. They are gathered column
+  // by column into the builders, which already have room for a full output batch.
   for (size_t col = 0; col < build_spec_.output_col_indices.size(); ++col) {
-    for (const auto& chunk : chunks_) {
-      auto output_idx = build_spec_.output_col_indices[col];
-      auto builder = column_builders_.at(output_idx).get();
-
-      if (chunk.wrappers_ptr == nullptr) {
-#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendColumnDefaultValue<_dt_>(builder, chunk.num_rows))
-        PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
+    auto output_idx = build_spec_.output_col_indices[col];
+    auto builder = column_builders_.at(output_idx).get();
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(GatherBuildColumn<_dt_>(col, builder))
+    PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
 #undef TYPE_CASE
-      } else {
-#define TYPE_CASE(_dt_)                                                                  \
-  PL_RETURN_IF_ERROR(AppendValuesFromWrapper<_dt_>(builder, chunk.wrappers_ptr->at(col), \
-                                                   chunk.bb_row_idx, chunk.num_rows))
-        PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
-#undef TYPE_CASE
-      }
-    }
   }
 
   for (size_t col = 0; col < probe_spec_.output_col_indices.size(); ++col) {
-    for (const auto& chunk : chunks_) {
-      auto output_idx = probe_spec_.output_col_indices[col];
-      auto builder = column_builders_.at(output_idx).get();
-
-      if (chunk.rb == nullptr) {
-#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendColumnDefaultValue<_dt_>(builder, chunk.num_rows))
-        PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
+    auto output_idx = probe_spec_.output_col_indices[col];
+    auto builder = column_builders_.at(output_idx).get();
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(GatherProbeColumn<_dt_>(col, builder))
+    PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
 #undef TYPE_CASE
-      } else {
-        auto src_idx = probe_spec_.input_col_indices[col];
-        auto builder = column_builders_[output_idx].get();
-        auto input_col = chunk.rb->ColumnAt(src_idx).get();
-
-#define TYPE_CASE(_dt_)                                                             \
-  PL_RETURN_IF_ERROR(table_store::schema::CopyValueRepeated<_dt_>(                  \
-      builder, types::GetValueFromArrowArray<_dt_>(input_col, chunk.probe_row_idx), \
-      chunk.num_rows))
-        PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
-#undef TYPE_CASE
-      }
-    }
   }
-  std::vector<EquijoinNode::OutputChunk> new_chunks(0);
-  std::swap(chunks_, new_chunks);
+  // Keep the capacity of the chunks for the next batch.
+  chunks_.clear();
   queued_rows_ = 0;
+  return Status::OK();
+}
+
+Status EquijoinNode::FlushChunkedRows(ExecState* exec_state) {
+  PL_RETURN_IF_ERROR(AppendChunkedRows());
   return NextOutputBatch(exec_state);
 }
 
@@ -338,7 +499,7 @@ Status EquijoinNode::MatchBuildValuesAndFlush(ExecState* exec_state,
     queued_rows_ += chunk_rows;
     bb_rows_left -= chunk_rows;
 
-    if (queued_rows_ == output_rows_per_batch_) {
+    if (column_builders_[0]->length() + queued_rows_ == output_rows_per_batch_) {
       PL_RETURN_IF_ERROR(FlushChunkedRows(exec_state));
     }
   }
@@ -388,7 +549,7 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
                                                 build_buffer_rows_[join_keys_chunk_[row_idx]]));
   }
 
-  if (probe_eos_ && queued_rows_ > 0) {
+  if (rb.eos() && queued_rows_ > 0) {
     PL_RETURN_IF_ERROR(FlushChunkedRows(exec_state));
   }
 
@@ -404,10 +565,9 @@ Status EquijoinNode::EmitUnmatchedBuildRows(ExecState* exec_state) {
                                                 build_buffer_rows_[it->first]));
   }
 
-  if (queued_rows_ > 0) {
-    PL_RETURN_IF_ERROR(FlushChunkedRows(exec_state));
-  }
-  return Status::OK();
+  // The rows left over are output with the final batch, or with the next partition of a
+  // partitioned join.
+  return AppendChunkedRows();
 }
 
 Status EquijoinNode::ConsumeBuildBatch(ExecState* exec_state,
@@ -437,20 +597,241 @@ Status EquijoinNode::ConsumeProbeBatch(ExecState* exec_state,
   return DoProbe(exec_state, rb);
 }
 
+namespace {
+
+// Picks the partition from the high bits of the hash, the hash map buckets use the low ones.
+size_t PartitionIndex(size_t hash, int partition_bits) {
+  if (partition_bits == 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(hash) >> (64 - partition_bits);
+}
+
+}  // namespace
+
+Status EquijoinNode::PartitionRowBatch(const RowBatch& rb, bool is_probe,
+                                       std::vector<std::unique_ptr<RowBatch>>* parts) {
+  parts->clear();
+  parts->resize(partitions_.size());
+  if (rb.num_rows() == 0) {
+    return Status::OK();
+  }
+
+  PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, is_probe));
+  std::vector<size_t> row_partitions(rb.num_rows());
+  std::vector<int64_t> partition_rows(partitions_.size(), 0);
+  for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    row_partitions[row_idx] = PartitionIndex(join_keys_chunk_[row_idx]->Hash(), partition_bits_);
+    ++partition_rows[row_partitions[row_idx]];
+  }
+
+  std::vector<bool> selected(rb.num_rows());
+  for (size_t partition_idx = 0; partition_idx < partitions_.size(); ++partition_idx) {
+    int64_t num_rows = partition_rows[partition_idx];
+    if (num_rows == 0) {
+      continue;
+    }
+    if (num_rows == rb.num_rows()) {
+      // The arrays are shared, there is nothing to copy.
+      (*parts)[partition_idx] = std::make_unique<RowBatch>(rb);
+    } else {
+      for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+        selected[row_idx] = row_partitions[row_idx] == partition_idx;
+      }
+      auto part = std::make_unique<RowBatch>(rb.desc(), num_rows);
+      for (auto col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+        PL_ASSIGN_OR_RETURN(auto col, SelectRows(rb.desc().type(col_idx), *rb.ColumnAt(col_idx),
+                                                 selected, num_rows, mem_pool()));
+        PL_RETURN_IF_ERROR(part->AddColumn(col));
+      }
+      (*parts)[partition_idx] = std::move(part);
+    }
+    (*parts)[partition_idx]->set_eow(false);
+    (*parts)[partition_idx]->set_eos(false);
+  }
+  return Status::OK();
+}
+
+Status EquijoinNode::BufferPartitions(bool is_probe,
+                                      std::vector<std::unique_ptr<RowBatch>>* parts) {
+  for (size_t partition_idx = 0; partition_idx < parts->size(); ++partition_idx) {
+    const auto& part = (*parts)[partition_idx];
+    if (part == nullptr) {
+      continue;
+    }
+    auto& partition = partitions_[partition_idx];
+    if (partition.build_spill != nullptr) {
+      auto spill = is_probe ? partition.probe_spill.get() : partition.build_spill.get();
+      PL_RETURN_IF_ERROR(spill->Append(*part));
+      continue;
+    }
+    auto& batches = is_probe ? partition.probe_batches : partition.build_batches;
+    batches.push_back(*part);
+    partition.bytes += part->NumBytes();
+    buffered_bytes_ += part->NumBytes();
+  }
+
+  // Spill the largest partitions first, as they free the most memory per file. The join also
+  // spills while the query is over its soft memory limit, rather than have the query aborted.
+  while (buffered_bytes_ > memory_budget_bytes_ || mem_pool()->SoftLimitExceeded()) {
+    int64_t largest_idx = -1;
+    for (size_t partition_idx = 0; partition_idx < partitions_.size(); ++partition_idx) {
+      const auto& partition = partitions_[partition_idx];
+      if (partition.build_spill == nullptr && partition.bytes > 0 &&
+          (largest_idx < 0 || partition.bytes > partitions_[largest_idx].bytes)) {
+        largest_idx = partition_idx;
+      }
+    }
+    if (largest_idx < 0) {
+      break;
+    }
+    PL_RETURN_IF_ERROR(SpillPartition(largest_idx));
+  }
+  return Status::OK();
+}
+
+Status EquijoinNode::SpillPartition(size_t partition_idx) {
+  auto& partition = partitions_[partition_idx];
+  PL_ASSIGN_OR_RETURN(partition.build_spill, SpillFile::Create(FLAGS_equijoin_spill_dir));
+  PL_ASSIGN_OR_RETURN(partition.probe_spill, SpillFile::Create(FLAGS_equijoin_spill_dir));
+  for (const auto& rb : partition.build_batches) {
+    PL_RETURN_IF_ERROR(partition.build_spill->Append(rb));
+  }
+  for (const auto& rb : partition.probe_batches) {
+    PL_RETURN_IF_ERROR(partition.probe_spill->Append(rb));
+  }
+  VLOG(1) << absl::Substitute("$0 spilled partition $1 ($2 bytes)", DebugString(), partition_idx,
+                              partition.bytes);
+
+  partition.build_batches.clear();
+  partition.probe_batches.clear();
+  buffered_bytes_ -= partition.bytes;
+  partition.bytes = 0;
+  return Status::OK();
+}
+
+Status EquijoinNode::ResetBuildTable() {
+  // The queued chunks point into the build table, so copy them out before it goes away.
+  PL_RETURN_IF_ERROR(AppendChunkedRows());
+  build_buffer_.clear();
+  build_buffer_rows_.clear();
+  probed_keys_.clear();
+  join_keys_chunk_.clear();
+  build_wrappers_chunk_.clear();
+  probe_wrappers_chunk_.clear();
+  key_values_pool_.Clear();
+  column_values_pool_.Clear();
+  return Status::OK();
+}
+
+Status EquijoinNode::ConsumePartitionedBuildBatch(ExecState* exec_state, const RowBatch& rb) {
+  std::vector<std::unique_ptr<RowBatch>> parts;
+  PL_RETURN_IF_ERROR(PartitionRowBatch(rb, false, &parts));
+  PL_RETURN_IF_ERROR(BufferPartitions(false, &parts));
+  if (!rb.eos()) {
+    return Status::OK();
+  }
+  build_eos_ = true;
+
+  // Hash the partitions that are still in memory, and probe them with the buffered probe rows.
+  for (auto& partition : partitions_) {
+    for (const auto& build_rb : partition.build_batches) {
+      PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(build_rb, false));
+      PL_RETURN_IF_ERROR(HashRowBatch(build_rb));
+    }
+    partition.build_batches.clear();
+  }
+  for (auto& partition : partitions_) {
+    for (const auto& probe_rb : partition.probe_batches) {
+      PL_RETURN_IF_ERROR(DoProbe(exec_state, probe_rb));
+    }
+    partition.probe_batches.clear();
+  }
+  return Status::OK();
+}
+
+Status EquijoinNode::ConsumePartitionedProbeBatch(ExecState* exec_state, const RowBatch& rb) {
+  std::vector<std::unique_ptr<RowBatch>> parts;
+  PL_RETURN_IF_ERROR(PartitionRowBatch(rb, true, &parts));
+  if (!build_eos_) {
+    PL_RETURN_IF_ERROR(BufferPartitions(true, &parts));
+  } else {
+    for (size_t partition_idx = 0; partition_idx < parts.size(); ++partition_idx) {
+      const auto& part = parts[partition_idx];
+      if (part == nullptr) {
+        continue;
+      }
+      auto& partition = partitions_[partition_idx];
+      if (partition.probe_spill != nullptr) {
+        PL_RETURN_IF_ERROR(partition.probe_spill->Append(*part));
+      } else {
+        PL_RETURN_IF_ERROR(DoProbe(exec_state, *part));
+      }
+    }
+  }
+  if (rb.eos()) {
+    probe_eos_ = true;
+  }
+  return Status::OK();
+}
+
+Status EquijoinNode::JoinSpilledPartitions(ExecState* exec_state) {
+  for (auto& partition : partitions_) {
+    if (partition.build_spill == nullptr) {
+      continue;
+    }
+    PL_RETURN_IF_ERROR(ResetBuildTable());
+
+    PL_RETURN_IF_ERROR(partition.build_spill->Rewind());
+    while (true) {
+      PL_ASSIGN_OR_RETURN(auto build_rb, partition.build_spill->ReadNext());
+      if (build_rb == nullptr) {
+        break;
+      }
+      PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(*build_rb, false));
+      PL_RETURN_IF_ERROR(HashRowBatch(*build_rb));
+    }
+    partition.build_spill.reset();
+
+    PL_RETURN_IF_ERROR(partition.probe_spill->Rewind());
+    while (true) {
+      PL_ASSIGN_OR_RETURN(auto probe_rb, partition.probe_spill->ReadNext());
+      if (probe_rb == nullptr) {
+        break;
+      }
+      PL_RETURN_IF_ERROR(DoProbe(exec_state, *probe_rb));
+    }
+    partition.probe_spill.reset();
+
+    if (build_spec_.emit_unmatched_rows) {
+      PL_RETURN_IF_ERROR(EmitUnmatchedBuildRows(exec_state));
+    }
+  }
+  return AppendChunkedRows();
+}
+
 Status EquijoinNode::ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                                      size_t parent_index) {
   if (IsProbeTable(parent_index)) {
     DCHECK(!probe_eos_);
-    PL_RETURN_IF_ERROR(ConsumeProbeBatch(exec_state, rb));
+    PL_RETURN_IF_ERROR(partitioned_ ? ConsumePartitionedProbeBatch(exec_state, rb)
+                                    : ConsumeProbeBatch(exec_state, rb));
   } else {
     DCHECK(!build_eos_);
-    PL_RETURN_IF_ERROR(ConsumeBuildBatch(exec_state, rb));
+    if (join_filter_builder_ != nullptr) {
+      PL_RETURN_IF_ERROR(AddToJoinFilter(exec_state, rb));
+    }
+    PL_RETURN_IF_ERROR(partitioned_ ? ConsumePartitionedBuildBatch(exec_state, rb)
+                                    : ConsumeBuildBatch(exec_state, rb));
   }
 
   if (build_eos_ && probe_eos_) {
     if (build_spec_.emit_unmatched_rows) {
       PL_RETURN_IF_ERROR(EmitUnmatchedBuildRows(exec_state));
     }
+    if (partitioned_) {
+      PL_RETURN_IF_ERROR(JoinSpilledPartitions(exec_state));
+    }
 
     if (column_builders_[0]->length()) {
       PL_RETURN_IF_ERROR(NextOutputBatch(exec_state));
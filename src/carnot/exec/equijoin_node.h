@@ -30,7 +30,9 @@
 
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/join_filter.h"
 #include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/exec/spill_file.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
@@ -39,6 +41,10 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int64(equijoin_memory_budget_bytes);
+DECLARE_int32(equijoin_num_partitions);
+DECLARE_string(equijoin_spill_dir);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -76,6 +82,11 @@ class EquijoinNode : public ProcessingNode {
  private:
   Status InitializeColumnBuilders();
   bool IsProbeTable(size_t parent_index);
+  Status AppendChunkedRows();
+  template <types::DataType DT>
+  Status GatherBuildColumn(size_t col, arrow::ArrayBuilder* output_builder);
+  template <types::DataType DT>
+  Status GatherProbeColumn(size_t col, arrow::ArrayBuilder* output_builder);
   Status FlushChunkedRows(ExecState* exec_state);
   Status ExtractJoinKeysForBatch(const table_store::schema::RowBatch& rb, bool is_probe);
   Status HashRowBatch(const table_store::schema::RowBatch& rb);
@@ -89,6 +100,21 @@ class EquijoinNode : public ProcessingNode {
   Status NextOutputBatch(ExecState* exec_state);
   Status ConsumeBuildBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status ConsumeProbeBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Adds the keys of a build batch to the join filter, and publishes it once the build side ends.
+  Status AddToJoinFilter(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+
+  // Partitioned join, used when the join runs with a memory budget.
+  Status PartitionRowBatch(const table_store::schema::RowBatch& rb, bool is_probe,
+                           std::vector<std::unique_ptr<table_store::schema::RowBatch>>* parts);
+  Status BufferPartitions(bool is_probe,
+                          std::vector<std::unique_ptr<table_store::schema::RowBatch>>* parts);
+  Status SpillPartition(size_t partition_idx);
+  Status ResetBuildTable();
+  Status ConsumePartitionedBuildBatch(ExecState* exec_state,
+                                      const table_store::schema::RowBatch& rb);
+  Status ConsumePartitionedProbeBatch(ExecState* exec_state,
+                                      const table_store::schema::RowBatch& rb);
+  Status JoinSpilledPartitions(ExecState* exec_state);
 
   bool build_eos_ = false;
   bool probe_eos_ = false;
@@ -130,11 +156,13 @@ class EquijoinNode : public ProcessingNode {
   // Column builders will flush a batch once they hit output_rows_per_batch_ rows.
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> column_builders_;
   // Manages the RowTuples containing the keys for the join.
-  ObjectPool key_values_pool_{"equijoin_kv_pool"};
-  ObjectPool column_values_pool_{"equijoin_col_vals_pool"};
+  ArenaObjectPool key_values_pool_{"equijoin_kv_pool"};
+  ArenaObjectPool column_values_pool_{"equijoin_col_vals_pool"};
 
   // Chunk of data to use when extracting join keys.
   std::vector<RowTuple*> join_keys_chunk_;
+  // The hashes of the keys of the current batch, set on the row tuples of join_keys_chunk_.
+  std::vector<uint64_t> join_key_hashes_;
   // Chunk of data to use when performing the build stage of the join.
   std::vector<std::vector<types::SharedColumnWrapper>*> build_wrappers_chunk_;
 
@@ -151,6 +179,30 @@ class EquijoinNode : public ProcessingNode {
   // keep track of which ones they were.
   AbslRowTupleHashSet probed_keys_;
 
+  // When the join has a memory budget, both inputs are split into partitions by the hash of the
+  // join keys. Partitions stay in memory until the buffered batches go over the budget, at which
+  // point the largest partitions are spilled to disk. Once the build side ends, the partitions in
+  // memory are joined right away and the spilled ones are joined one at a time after the probe
+  // side ends, so only a single spilled partition is hashed at any time.
+  struct JoinPartition {
+    // Batches buffered until the build side ends. Unused once the partition is spilled.
+    std::vector<table_store::schema::RowBatch> build_batches;
+    std::vector<table_store::schema::RowBatch> probe_batches;
+    int64_t bytes = 0;
+    // Set when the partition is spilled. All later batches of the partition go to disk.
+    std::unique_ptr<SpillFile> build_spill;
+    std::unique_ptr<SpillFile> probe_spill;
+  };
+  bool partitioned_ = false;
+  int64_t memory_budget_bytes_ = 0;
+  int partition_bits_ = 0;
+  std::vector<JoinPartition> partitions_;
+  // The number of bytes buffered by the partitions that are in memory.
+  int64_t buffered_bytes_ = 0;
+
+  // Set while the build side keys are collected for the join filter (see planpb::JoinOperator).
+  std::unique_ptr<JoinFilterBuilder> join_filter_builder_;
+
   // Handle on the most recent RowBatch (in case it's the final one).
   std::unique_ptr<table_store::schema::RowBatch> pending_output_batch_;
 
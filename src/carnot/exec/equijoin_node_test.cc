@@ -524,6 +524,137 @@ TEST_F(JoinNodeTest, unordered_no_matches) {
       .Close();
 }
 
+TEST_F(JoinNodeTest, unordered_build_right) {
+  // Left table input: [left_0:Int64, left_1:Int64]
+  // Right table input: [right_0:Int64, right_1:Int64]
+  // Output table: [left_1:Int64, right_0:Int64]
+  // Inner join on left_0=right_1, building the hash table on the right.
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "right_0"
+  rows_per_batch: 5
+  build_parent_index: 1
+)";
+
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({-1, -2})
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .get(),
+                   1, 0)
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 4, true, true)
+                       .AddColumn<types::Int64Value>({2, 3, 1, 2})
+                       .AddColumn<types::Int64Value>({10, 20, 30, 40})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({10, 30, 40})
+                          .AddColumn<types::Int64Value>({-2, -1, -2})
+                          .get(),
+                      /*unordered */ false)
+      .Close();
+}
+
+TEST_F(JoinNodeTest, unordered_unique_build_keys) {
+  // Left table input: [left_0:Int64, left_1:String]
+  // Right table input: [right_0:Int64, right_1:Int64, right_2:String]
+  // Output table: [right_2:String, left_0:Int64, right_1:Int64, left_1:String]
+  // Inner join on left_0=right_0. The build keys are unique, so the matching probe rows are
+  // copied in runs, including across output batches.
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 2
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 0
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  column_names: "right_2"
+  column_names: "left_0"
+  column_names: "right_1"
+  column_names: "left_1"
+  rows_per_batch: 3
+  build_parent_index: 0
+)";
+
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor input_rd_1(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd({types::DataType::STRING, types::DataType::INT64,
+                           types::DataType::INT64, types::DataType::STRING});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 4, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .AddColumn<types::StringValue>({"a", "bb", "ccc", "dddd"})
+                       .get(),
+                   0, 0)
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 5, true, true)
+                       .AddColumn<types::Int64Value>({1, 2, 5, 3, 4})
+                       .AddColumn<types::Int64Value>({10, 20, 50, 30, 40})
+                       .AddColumn<types::StringValue>({"w", "x", "y", "z", ""})
+                       .get(),
+                   1,1, 2)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, false, false)
+                          .AddColumn<types::StringValue>({"w", "x", "z"})
+                          .AddColumn<types::Int64Value>({1, 2, 3})
+                          .AddColumn<types::Int64Value>({10, 20, 30})
+                          .AddColumn<types::StringValue>({"a", "bb", "ccc"})
+                          .get(),
+                      /*unordered */ false)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::StringValue>({""})
+                          .AddColumn<types::Int64Value>({4})
+                          .AddColumn<types::Int64Value>({40})
+                          .AddColumn<types::StringValue>({"dddd"})
+                          .get(),
+                      /*unordered */ false)
+      .Close();
+}
+
 TEST_F(JoinNodeTest, zero_row_row_batch_right) {
   // Left table input: [left_0:String, left_1:Int64]
   // Right table input: [right_0:Int64, right_1:String]
@@ -685,6 +816,165 @@ TEST_F(JoinNodeTest, unordered_many_matches) {
       .Close();
 }
 
+TEST_F(JoinNodeTest, partitioned_full_outer_join_spills) {
+  // Same as unordered_full_outer_join, but with a memory budget small enough that the only
+  // partition is spilled and joined back from disk.
+  auto memory_budget_bytes = FLAGS_equijoin_memory_budget_bytes;
+  auto num_partitions = FLAGS_equijoin_num_partitions;
+  FLAGS_equijoin_memory_budget_bytes = 1;
+  FLAGS_equijoin_num_partitions = 1;
+
+  const char* proto = R"(
+  type: FULL_OUTER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "right_1"
+  column_names: "right_0"
+  rows_per_batch: 5
+)";
+
+  RowDescriptor input_rd_0({types::DataType::TIME64NS, types::DataType::INT64});
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::TIME64NS});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::TIME64NS, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 5, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({101, 200, 101, 200, 101})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 5, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({200, 200, 200, 300, 300})
+                       .AddColumn<types::Int64Value>({6, 8, 10, 12, 14})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Time64NSValue>({400, 500})
+                       .AddColumn<types::Int64Value>({16, 18})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, true, true)
+                       .AddColumn<types::Int64Value>({-10, -20, -30})
+                       .AddColumn<types::Time64NSValue>({110, 120, 101})
+                       .get(),
+                   1, 3)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, false, false)
+                          .AddColumn<types::Int64Value>({0, 0, 1, 3, 5})
+                          .AddColumn<types::Time64NSValue>({110, 120, 101, 101, 101})
+                          .AddColumn<types::Int64Value>({-10, -20, -30, -30, -30})
+                          .get(),
+                      true)
+      .ExpectRowBatchesData(RowBatchBuilder(output_rd, 9, true, true)
+                                .AddColumn<types::Int64Value>({2, 4, 6, 8, 10, 12, 14, 16, 18})
+                                .AddColumn<types::Time64NSValue>({0, 0, 0, 0, 0, 0, 0, 0, 0})
+                                .AddColumn<types::Int64Value>({0, 0, 0, 0, 0, 0, 0, 0, 0})
+                                .get(),
+                            2)
+      .Close();
+
+  FLAGS_equijoin_memory_budget_bytes = memory_budget_bytes;
+  FLAGS_equijoin_num_partitions = num_partitions;
+}
+
+TEST_F(JoinNodeTest, partitioned_many_matches) {
+  // Same inputs as unordered_many_matches, split over several partitions that are all spilled.
+  // The probe side starts before the build side ends, so both buffered and late probe rows are
+  // joined from disk.
+  auto memory_budget_bytes = FLAGS_equijoin_memory_budget_bytes;
+  auto num_partitions = FLAGS_equijoin_num_partitions;
+  FLAGS_equijoin_memory_budget_bytes = 1;
+  FLAGS_equijoin_num_partitions = 4;
+
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "time_"
+  column_names: "right_0"
+  rows_per_batch: 100
+)";
+
+  RowDescriptor input_rd_0({types::DataType::TIME64NS, types::DataType::INT64});
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::TIME64NS});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::TIME64NS, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 5, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({101, 102, 103, 101, 102})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 4, false, false)
+                       .AddColumn<types::Int64Value>({10, 20, 30, 40})
+                       .AddColumn<types::Time64NSValue>({101, 101, 102, 102})
+                       .get(),
+                   1, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Time64NSValue>({103, 101, 104})
+                       .AddColumn<types::Int64Value>({6, 7, 8})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 5, true, true)
+                       .AddColumn<types::Int64Value>({50, 60, 70, 80, 90})
+                       .AddColumn<types::Time64NSValue>({103, 103, 103, 103, 105})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(
+          RowBatchBuilder(output_rd, 18, true, true)
+              .AddColumn<types::Int64Value>(
+                  {1, 4, 7, 1, 4, 7, 2, 5, 2, 5, 3, 6, 3, 6, 3, 6, 3, 6})
+              .AddColumn<types::Time64NSValue>({101, 101, 101, 101, 101, 101, 102, 102, 102,
+                                                102, 103, 103, 103, 103, 103, 103, 103, 103})
+              .AddColumn<types::Int64Value>(
+                  {10, 10, 10, 20, 20, 20, 30, 30, 40, 40, 50, 50, 60, 60, 70, 70, 80, 80})
+              .get(),
+          false)
+      .Close();
+
+  FLAGS_equijoin_memory_budget_bytes = memory_budget_bytes;
+  FLAGS_equijoin_num_partitions = num_partitions;
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -21,7 +21,11 @@
 #include <algorithm>
 #include <memory>
 #include <set>
+#include <string>
 #include <unordered_map>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
 
 #include "src/carnot/exec/agg_node.h"
 #include "src/carnot/exec/empty_source_node.h"
@@ -35,6 +39,7 @@
 #include "src/carnot/exec/map_node.h"
 #include "src/carnot/exec/memory_sink_node.h"
 #include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/sort_node.h"
 #include "src/carnot/exec/udtf_source_node.h"
 #include "src/carnot/exec/union_node.h"
 #include "src/carnot/plan/operators.h"
@@ -42,6 +47,16 @@
 #include "src/common/perf/perf.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int32(carnot_exec_parallelism, gflags::Int32FromEnv("PL_CARNOT_EXEC_PARALLELISM", 1),
+             "The number of threads a memory source -> map/filter -> aggregate pipeline of a query "
+             "runs on. Set to '1' to run the whole query on the calling thread.");
+DEFINE_bool(carnot_trace_exec_batches, gflags::BoolFromEnv("PL_CARNOT_TRACE_EXEC_BATCHES", false),
+            "For queries run with analyze, record the time every operator spends on each batch. "
+            "The spans are returned with the operator stats.");
+DEFINE_bool(carnot_grpc_passthrough, gflags::BoolFromEnv("PL_CARNOT_GRPC_PASSTHROUGH", false),
+            "Whether GRPC sources whose rows go unchanged to a GRPC sink forward the serialized "
+            "rows to the sink, instead of decoding them and serializing them again.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -59,36 +74,34 @@ Status ExecutionGraph::Init(std::shared_ptr<table_store::schema::Schema> schema,
   collect_exec_node_stats_ = collect_exec_node_stats;
   consecutive_generate_calls_per_source_ = consecutive_generate_calls_per_source;
 
-  std::unordered_map<int64_t, ExecNode*> nodes;
-  std::unordered_map<int64_t, RowDescriptor> descriptors;
-  return plan::PlanFragmentWalker()
+  auto walk_status = plan::PlanFragmentWalker()
       .OnMap([&](auto& node) {
-        return OnOperatorImpl<plan::MapOperator, MapNode>(node, &descriptors);
+        return OnOperatorImpl<plan::MapOperator, MapNode>(node, &descriptors_);
       })
       .OnMemorySink([&](auto& node) {
         sinks_.push_back(node.id());
-        return OnOperatorImpl<plan::MemorySinkOperator, MemorySinkNode>(node, &descriptors);
+        return OnOperatorImpl<plan::MemorySinkOperator, MemorySinkNode>(node, &descriptors_);
       })
       .OnAggregate([&](auto& node) {
-        return OnOperatorImpl<plan::AggregateOperator, AggNode>(node, &descriptors);
+        return OnOperatorImpl<plan::AggregateOperator, AggNode>(node, &descriptors_);
       })
       .OnMemorySource([&](auto& node) {
-        return OnOperatorImpl<plan::MemorySourceOperator, MemorySourceNode>(node, &descriptors);
+        return OnOperatorImpl<plan::MemorySourceOperator, MemorySourceNode>(node, &descriptors_);
       })
       .OnFilter([&](auto& node) {
-        return OnOperatorImpl<plan::FilterOperator, FilterNode>(node, &descriptors);
+        return OnOperatorImpl<plan::FilterOperator, FilterNode>(node, &descriptors_);
       })
       .OnLimit([&](auto& node) {
-        return OnOperatorImpl<plan::LimitOperator, LimitNode>(node, &descriptors);
+        return OnOperatorImpl<plan::LimitOperator, LimitNode>(node, &descriptors_);
       })
       .OnUnion([&](auto& node) {
-        return OnOperatorImpl<plan::UnionOperator, UnionNode>(node, &descriptors);
+        return OnOperatorImpl<plan::UnionOperator, UnionNode>(node, &descriptors_);
       })
       .OnJoin([&](auto& node) {
-        return OnOperatorImpl<plan::JoinOperator, EquijoinNode>(node, &descriptors);
+        return OnOperatorImpl<plan::JoinOperator, EquijoinNode>(node, &descriptors_);
       })
       .OnGRPCSource([&](auto& node) {
-        auto s = OnOperatorImpl<plan::GRPCSourceOperator, GRPCSourceNode>(node, &descriptors);
+        auto s = OnOperatorImpl<plan::GRPCSourceOperator, GRPCSourceNode>(node, &descriptors_);
         PL_RETURN_IF_ERROR(s);
         grpc_sources_.insert(node.id());
         return exec_state->grpc_router()->AddGRPCSourceNode(
@@ -97,15 +110,67 @@ Status ExecutionGraph::Init(std::shared_ptr<table_store::schema::Schema> schema,
       })
       .OnGRPCSink([&](auto& node) {
         grpc_sinks_.insert(node.id());
-        return OnOperatorImpl<plan::GRPCSinkOperator, GRPCSinkNode>(node, &descriptors);
+        return OnOperatorImpl<plan::GRPCSinkOperator, GRPCSinkNode>(node, &descriptors_);
       })
       .OnUDTFSource([&](auto& node) {
-        return OnOperatorImpl<plan::UDTFSourceOperator, UDTFSourceNode>(node, &descriptors);
+        return OnOperatorImpl<plan::UDTFSourceOperator, UDTFSourceNode>(node, &descriptors_);
       })
       .OnEmptySource([&](auto& node) {
-        return OnOperatorImpl<plan::EmptySourceOperator, EmptySourceNode>(node, &descriptors);
+        return OnOperatorImpl<plan::EmptySourceOperator, EmptySourceNode>(node, &descriptors_);
+      })
+      .OnSort([&](auto& node) {
+        return OnOperatorImpl<plan::SortOperator, SortNode>(node, &descriptors_);
       })
       .Walk(pf_);
+  PL_RETURN_IF_ERROR(walk_status);
+
+  if (FLAGS_carnot_grpc_passthrough) {
+    SetUpGRPCPassthrough();
+  }
+  return Status::OK();
+}
+
+void ExecutionGraph::SetUpGRPCPassthrough() {
+  const auto& dag = pf_->dag();
+  for (int64_t source_id : grpc_sources_) {
+    auto children = dag.DependenciesOf(source_id);
+    if (children.size() != 1) {
+      continue;
+    }
+    int64_t child_id = children[0];
+    const plan::Operator* child = pf_->nodes().at(child_id).get();
+
+    // An unordered union only forwards the columns of its parents, so if it doesn't reorder them
+    // the rows of the source go to its child unchanged.
+    if (child->op_type() == planpb::UNION_OPERATOR) {
+      const auto* union_op = static_cast<const plan::UnionOperator*>(child);
+      auto union_parents = dag.ParentsOf(child_id);
+      auto parent_index =
+          std::find(union_parents.begin(), union_parents.end(), source_id) - union_parents.begin();
+      const auto& mapping = union_op->column_mapping(parent_index);
+      bool identity = true;
+      for (size_t i = 0; i < mapping.size(); ++i) {
+        identity &= mapping[i] == static_cast<int64_t>(i);
+      }
+      auto union_children = dag.DependenciesOf(child_id);
+      if (union_op->order_by_time() || !identity ||
+          mapping.size() != descriptors_.at(source_id).size() || union_children.size() != 1) {
+        continue;
+      }
+      child_id = union_children[0];
+    }
+
+    if (!grpc_sinks_.contains(child_id)) {
+      continue;
+    }
+    auto sink = static_cast<GRPCSinkNode*>(nodes_.at(child_id));
+    if (!sink->AcceptsForwardedRowBatchData()) {
+      continue;
+    }
+    VLOG(1) << absl::Substitute("GRPCSourceNode $0 forwards its rows to GRPCSinkNode $1",
+                                source_id, child_id);
+    static_cast<GRPCSourceNode*>(nodes_.at(source_id))->set_passthrough_sink(sink);
+  }
 }
 
 bool ExecutionGraph::YieldWithTimeout() {
@@ -119,11 +184,16 @@ bool ExecutionGraph::YieldWithTimeout() {
 }
 
 void ExecutionGraph::Continue() {
+  std::function<void()> continue_func;
   {
     std::lock_guard<std::mutex> lock(execution_mutex_);
     continue_ = true;
+    continue_func = continue_func_;
   }
   execution_cv_.notify_one();
+  if (continue_func) {
+    continue_func();
+  }
 }
 
 Status ExecutionGraph::CheckUpstreamGRPCConnectionHealth(GRPCSourceNode* source_node) {
@@ -171,26 +241,57 @@ Status ExecutionGraph::CheckDownstreamGRPCConnectionsHealth() {
   return Status::OK();
 }
 
+bool ExecutionGraph::DownstreamDone() const {
+  if (!sinks_.empty() || grpc_sinks_.empty()) {
+    return false;
+  }
+  for (const auto& grpc_sink_id : grpc_sinks_) {
+    auto node = nodes_.find(grpc_sink_id);
+    if (node == nodes_.end() || !static_cast<GRPCSinkNode*>(node->second)->destination_done()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status ExecutionGraph::ExecuteSources() {
-  absl::flat_hash_set<SourceNode*> running_sources;
+  PL_ASSIGN_OR_RETURN(bool done, ExecuteUntilBlocked());
+  while (!done) {
+    YieldWithTimeout();
+    PL_ASSIGN_OR_RETURN(done, ExecuteUntilBlocked());
+  }
+  return Status::OK();
+}
+
+StatusOr<bool> ExecutionGraph::ExecuteUntilBlocked() {
+  if (sources_started_) {
+    return ResumeSources();
+  }
+  sources_started_ = true;
+
+  for (const auto& pipeline : pipelines_) {
+    PL_RETURN_IF_ERROR(pipeline->Execute(exec_state_));
+  }
 
-  absl::flat_hash_map<SourceNode*, int64_t> source_to_id;
   for (auto node_id : sources_) {
     auto node = nodes_.find(node_id);
     if (node == nodes_.end()) {
       return error::NotFound("Could not find SourceNode $0.", node_id);
     }
     SourceNode* n = static_cast<SourceNode*>(node->second);
-    running_sources.insert(n);
-    source_to_id[n] = node_id;
+    running_sources_.insert(n);
+    source_to_id_[n] = node_id;
   }
+  return ExecuteReadySources();
+}
 
+StatusOr<bool> ExecutionGraph::ExecuteReadySources() {
   // Run all sources to completion, or exit if the query encounters an error.
-  while (running_sources.size()) {
+  while (running_sources_.size()) {
     absl::flat_hash_set<SourceNode*> completed_sources_execute_loop;
 
-    for (SourceNode* source : running_sources) {
-      if (grpc_sources_.contains(source_to_id.at(source))) {
+    for (SourceNode* source : running_sources_) {
+      if (grpc_sources_.contains(source_to_id_.at(source))) {
         auto s = CheckUpstreamGRPCConnectionHealth(static_cast<GRPCSourceNode*>(source));
         if (!s.ok()) {
           LOG(ERROR) << absl::Substitute(
@@ -203,7 +304,7 @@ Status ExecutionGraph::ExecuteSources() {
         }
       }
 
-      exec_state_->SetCurrentSource(source_to_id[source]);
+      exec_state_->SetCurrentSource(source_to_id_[source]);
 
       for (auto i = 0; i < consecutive_generate_calls_per_source_; ++i) {
         if (!source->NextBatchReady() || !exec_state_->keep_running()) {
@@ -214,75 +315,193 @@ Status ExecutionGraph::ExecuteSources() {
 
       // keep_running will be set to false when a downstream limit for this particular
       // source (set in exec_state) has been reached.
+      if (!exec_state_->keep_running() && grpc_sources_.contains(source_to_id_.at(source))) {
+        // Tell the agents that send to this source to stop, rather than have them keep
+        // executing until the whole query is done.
+        auto s = exec_state_->grpc_router()->MarkSourceDone(exec_state_->query_id(),
+                                                            source_to_id_.at(source));
+        if (!s.ok()) {
+          LOG(WARNING) << s.msg();
+        }
+      }
       if (!source->HasBatchesRemaining() || !exec_state_->keep_running()) {
         completed_sources_execute_loop.insert(source);
         break;
       }
     }
     PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
+    if (DownstreamDone()) {
+      VLOG(1) << absl::Substitute("Stopping query $0, its destinations don't need more results",
+                                  exec_state_->query_id().str());
+      running_sources_.clear();
+      return true;
+    }
 
     // Flush all of the completed sources.
     for (SourceNode* source : completed_sources_execute_loop) {
-      running_sources.erase(source);
+      running_sources_.erase(source);
     }
 
     // If all sources are complete, the query is done executing.
-    if (!running_sources.size()) {
+    if (!running_sources_.size()) {
       break;
     }
 
     // For all running sources, check to see if any of them have data
     // or if we need to yield for more data.
     bool wait_for_more_data = true;
-    for (SourceNode* source : running_sources) {
+    for (SourceNode* source : running_sources_) {
       if (source->NextBatchReady()) {
         wait_for_more_data = false;
         break;
       }
     }
+    if (wait_for_more_data) {
+      return false;
+    }
+  }
 
-    while (wait_for_more_data) {
-      auto timer = ElapsedTimer();
-      timer.Start();
-      YieldWithTimeout();
-      timer.Stop();
+  return true;
+}
 
-      absl::flat_hash_set<SourceNode*> completed_sources_wait_loop;
+StatusOr<bool> ExecutionGraph::ResumeSources() {
+  bool wait_for_more_data = true;
+  absl::flat_hash_set<SourceNode*> completed_sources_wait_loop;
 
-      // This check is used for Memory sources that are waiting on data, because we don't currently
-      // have a mechanism to call Yield() on them while they are waiting.
-      // Once we introduce Carnot ETL, we can have the ingest phase of Carnot ETL call yield.
-      for (SourceNode* source : running_sources) {
-        if (source->NextBatchReady()) {
-          wait_for_more_data = false;
-        }
-        // Check the upstream connection health of all running GRPC sources after each yield.
-        if (grpc_sources_.contains(source_to_id.at(source))) {
-          auto s = CheckUpstreamGRPCConnectionHealth(static_cast<GRPCSourceNode*>(source));
-          if (!s.ok()) {
-            LOG(ERROR) << absl::Substitute(
-                "GRPCSourceNode connection to remote sink not healthy, terminating that source and "
-                "proceeding with the rest of the query. Message: $0",
-                s.msg());
-            PL_RETURN_IF_ERROR(source->SendEndOfStream(exec_state_));
-            completed_sources_wait_loop.insert(source);
-            continue;
-          }
-        }
+  // This check is used for Memory sources that are waiting on data, because we don't currently
+  // have a mechanism to call Yield() on them while they are waiting.
+  // Once we introduce Carnot ETL, we can have the ingest phase of Carnot ETL call yield.
+  for (SourceNode* source : running_sources_) {
+    if (source->NextBatchReady()) {
+      wait_for_more_data = false;
+    }
+    // Check the upstream connection health of all running GRPC sources after each yield.
+    if (grpc_sources_.contains(source_to_id_.at(source))) {
+      auto s = CheckUpstreamGRPCConnectionHealth(static_cast<GRPCSourceNode*>(source));
+      if (!s.ok()) {
+        LOG(ERROR) << absl::Substitute(
+            "GRPCSourceNode connection to remote sink not healthy, terminating that source and "
+            "proceeding with the rest of the query. Message: $0",
+            s.msg());
+        PL_RETURN_IF_ERROR(source->SendEndOfStream(exec_state_));
+        completed_sources_wait_loop.insert(source);
+        continue;
       }
-      PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
+    }
+  }
+  PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
 
-      // Flush all of the completed sources after this phase of source deletion.
-      for (SourceNode* source : completed_sources_wait_loop) {
-        running_sources.erase(source);
+  // Flush all of the completed sources after this phase of source deletion.
+  for (SourceNode* source : completed_sources_wait_loop) {
+    running_sources_.erase(source);
+  }
+  if (!running_sources_.size()) {
+    return true;
+  }
+  if (wait_for_more_data) {
+    return false;
+  }
+  return ExecuteReadySources();
+}
+
+std::vector<std::unique_ptr<ParallelPipeline>> ExecutionGraph::FindParallelPipelines() {
+  std::vector<std::unique_ptr<ParallelPipeline>> pipelines;
+  for (int64_t source_id : sources_) {
+    if (pf_->nodes().at(source_id)->op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+      continue;
+    }
+    auto source = static_cast<MemorySourceNode*>(nodes_.at(source_id));
+    if (!source->SupportsMorsels()) {
+      continue;
+    }
+
+    std::vector<PipelineOp> ops;
+    AggNode* agg = nullptr;
+    int64_t id = source_id;
+    while (agg == nullptr) {
+      auto children = pf_->dag().DependenciesOf(id);
+      if (children.size() != 1 || pf_->dag().ParentsOf(children[0]).size() != 1) {
+        break;
       }
-      if (!running_sources.size()) {
-        return Status::OK();
+      int64_t parent_id = id;
+      id = children[0];
+      const plan::Operator* op = pf_->nodes().at(id).get();
+      if (op->op_type() == planpb::AGGREGATE_OPERATOR) {
+        // Windowed aggregates emit results before the end of stream, so the workers can't hold
+        // their partial results until the scan is done.
+        if (static_cast<const plan::AggregateOperator*>(op)->windowed()) {
+          break;
+        }
+        agg = static_cast<AggNode*>(nodes_.at(id));
+      } else if (op->op_type() != planpb::MAP_OPERATOR &&
+                 op->op_type() != planpb::FILTER_OPERATOR) {
+        break;
       }
+      ops.push_back({op, descriptors_.at(id), {descriptors_.at(parent_id)}});
+    }
+    if (agg == nullptr) {
+      continue;
     }
+    pipelines.push_back(std::make_unique<ParallelPipeline>(source_id, source, agg, std::move(ops),
+                                                           FLAGS_carnot_exec_parallelism,
+                                                           collect_exec_node_stats_));
   }
+  return pipelines;
+}
 
-  return Status::OK();
+void ExecutionGraph::EnableFragmentCaches() {
+  for (int64_t source_id : sources_) {
+    const plan::Operator* source_op = pf_->nodes().at(source_id).get();
+    if (source_op->op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+      continue;
+    }
+    auto source_pb = static_cast<const plan::MemorySourceOperator*>(source_op)->pb();
+    // The cached batches are those of a single tablet.
+    if (source_pb.streaming() || source_pb.all_tablets()) {
+      continue;
+    }
+    // Only whole batches are cached, and their output doesn't depend on the time range.
+    source_pb.clear_start_time();
+    source_pb.clear_stop_time();
+
+    std::string fragment;
+    auto append_op = [&fragment](const plan::Operator* op, const std::string& pb) {
+      absl::StrAppend(&fragment, static_cast<int>(op->op_type()), ":", pb.size(), ":", pb);
+    };
+    append_op(source_op, source_pb.SerializeAsString());
+
+    AggNode* agg = nullptr;
+    int64_t id = source_id;
+    while (agg == nullptr) {
+      auto children = pf_->dag().DependenciesOf(id);
+      if (children.size() != 1 || pf_->dag().ParentsOf(children[0]).size() != 1) {
+        break;
+      }
+      id = children[0];
+      const plan::Operator* op = pf_->nodes().at(id).get();
+      if (op->op_type() == planpb::AGGREGATE_OPERATOR) {
+        const auto* agg_op = static_cast<const plan::AggregateOperator*>(op);
+        // Only the partial aggregates emit states that the finalize aggregate can merge however
+        // they are split up.
+        if (agg_op->windowed() || !agg_op->partial_agg() || agg_op->finalize_results()) {
+          break;
+        }
+        append_op(op, agg_op->pb().SerializeAsString());
+        agg = static_cast<AggNode*>(nodes_.at(id));
+      } else if (op->op_type() == planpb::MAP_OPERATOR) {
+        append_op(op, static_cast<const plan::MapOperator*>(op)->pb().SerializeAsString());
+      } else if (op->op_type() == planpb::FILTER_OPERATOR) {
+        append_op(op, static_cast<const plan::FilterOperator*>(op)->pb().SerializeAsString());
+      } else {
+        break;
+      }
+    }
+    if (agg == nullptr) {
+      continue;
+    }
+    auto source = static_cast<MemorySourceNode*>(nodes_.at(source_id));
+    source->EnableFragmentCache(exec_state_->fragment_cache(), agg, std::move(fragment));
+  }
 }
 
 /**
@@ -290,26 +509,50 @@ Status ExecutionGraph::ExecuteSources() {
  * @return a status of whether execution succeeded.
  */
 Status ExecutionGraph::Execute() {
-  query_start_time_ = std::chrono::system_clock::now();
+  PL_RETURN_IF_ERROR(Open());
+  // We don't PL_RETURN_IF_ERROR here because we want to make sure we close all of our
+  // nodes, even if there was an error during execution.
+  return Close(ExecuteSources());
+}
 
-  // Get vector of nodes.
-  std::vector<ExecNode*> nodes(nodes_.size());
-  transform(nodes_.begin(), nodes_.end(), nodes.begin(), [](auto pair) { return pair.second; });
+Status ExecutionGraph::Open() {
+  query_start_time_ = std::chrono::system_clock::now();
 
-  for (auto node : nodes) {
+  for (const auto& [id, node] : nodes_) {
     PL_RETURN_IF_ERROR(node->Prepare(exec_state_));
   }
 
-  for (auto node : nodes) {
+  for (const auto& [id, node] : nodes_) {
     PL_RETURN_IF_ERROR(node->Open(exec_state_));
   }
 
-  // We don't PL_RETURN_IF_ERROR here because we want to make sure we close all of our
-  // nodes, even if there was an error during execution.
-  Status source_status = ExecuteSources();
+  if (exec_state_->fragment_cache() != nullptr) {
+    EnableFragmentCaches();
+  }
+
+  if (FLAGS_carnot_exec_parallelism > 1) {
+    pipelines_ = FindParallelPipelines();
+  }
+  for (const auto& pipeline : pipelines_) {
+    PL_RETURN_IF_ERROR(pipeline->Open(exec_state_));
+  }
+  return Status::OK();
+}
+
+Status ExecutionGraph::Close(const Status& exec_status) {
   Status close_status = Status::OK();
 
-  for (auto node : nodes) {
+  for (const auto& pipeline : pipelines_) {
+    auto s = pipeline->Close(exec_state_);
+    if (!s.ok()) {
+      LOG(ERROR) << absl::Substitute(
+          "Error in ExecutionGraph::Execute() for query $0, could not close pipeline: $1",
+          exec_state_->query_id().str(), s.msg());
+      close_status = s;
+    }
+  }
+
+  for (const auto& [id, node] : nodes_) {
     auto s = node->Close(exec_state_);
     if (!s.ok()) {
       // Since we only return a single error status if there are multiple errors,
@@ -321,8 +564,8 @@ Status ExecutionGraph::Execute() {
     }
   }
 
-  if (!source_status.ok()) {
-    return source_status;
+  if (!exec_status.ok()) {
+    return exec_status;
   }
   return close_status;
 }
@@ -344,8 +587,7 @@ std::vector<std::string> ExecutionGraph::OutputTables() const {
 }
 
 ExecutionStats ExecutionGraph::GetStats() const {
-  int64_t bytes_processed = 0;
-  int64_t rows_processed = 0;
+  ExecutionStats stats;
   for (int64_t src_id : sources_) {
     // Grab the nodes.
     auto res = nodes_.find(src_id);
@@ -353,10 +595,16 @@ ExecutionStats ExecutionGraph::GetStats() const {
     ExecNode* node = res->second;
     CHECK(node->type() == ExecNodeType::kSourceNode);
     auto source_node = static_cast<SourceNode*>(node);
-    bytes_processed += source_node->BytesProcessed();
-    rows_processed += source_node->RowsProcessed();
+    stats.bytes_processed += source_node->BytesProcessed();
+    stats.rows_processed += source_node->RowsProcessed();
+
+    const plan::Operator* op = pf_->nodes().at(src_id).get();
+    if (op->op_type() == planpb::MEMORY_SOURCE_OPERATOR) {
+      auto table_name = static_cast<const plan::MemorySourceOperator*>(op)->TableName();
+      stats.table_rows_processed[table_name] += source_node->RowsProcessed();
+    }
   }
-  return ExecutionStats({bytes_processed, rows_processed});
+  return stats;
 }
 
 }  // namespace exec
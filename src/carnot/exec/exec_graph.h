@@ -22,16 +22,20 @@
 #include <algorithm>
 #include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/dag/dag.h"
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/parallel_pipeline.h"
 #include "src/carnot/plan/plan_fragment.h"
 #include "src/carnot/plan/plan_state.h"
 #include "src/common/base/base.h"
@@ -39,13 +43,19 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int32(carnot_exec_parallelism);
+DECLARE_bool(carnot_trace_exec_batches);
+DECLARE_bool(carnot_grpc_passthrough);
+
 namespace px {
 namespace carnot {
 namespace exec {
 
 struct ExecutionStats {
-  int64_t bytes_processed;
-  int64_t rows_processed;
+  int64_t bytes_processed = 0;
+  int64_t rows_processed = 0;
+  // The rows output by the scans of each table, which the planner uses as row estimates.
+  absl::flat_hash_map<std::string, int64_t> table_rows_processed;
 };
 
 constexpr std::chrono::milliseconds kDefaultYieldTimeoutMS{1000};
@@ -127,10 +137,33 @@ class ExecutionGraph {
   Status Execute();
 
   /**
-   * Re-awakens Execute() when there is more work available to do.
+   * The steps of Execute(), for callers that don't want to block a thread while the sources wait
+   * for data (see AsyncExecution). Open() prepares and opens the nodes. ExecuteUntilBlocked() runs
+   * the sources until they are all done, in which case it returns true, or until none of them has
+   * a batch ready, in which case it returns false and should be called again once Continue() was
+   * called or the yield timeout passed. Close() closes the nodes and returns the first error of the
+   * execution or of closing them.
+   */
+  Status Open();
+  StatusOr<bool> ExecuteUntilBlocked();
+  Status Close(const Status& exec_status);
+
+  /**
+   * Re-awakens Execute() when there is more work available to do, and calls the continue func.
    */
   void Continue();
 
+  /**
+   * Sets the function that Continue() calls from the thread that has more work for the graph,
+   * which lets an async execution resume the graph instead of waiting in YieldWithTimeout().
+   */
+  void set_continue_func(std::function<void()> continue_func) {
+    std::lock_guard<std::mutex> lock(execution_mutex_);
+    continue_func_ = std::move(continue_func);
+  }
+
+  const std::chrono::milliseconds& yield_timeout() const { return yield_timeout_ms_; }
+
   /**
    * Yields the execution of the current graph until Continue() is called or the timeout is reached.
    * @return true if the yield timed out, false if Continue() was called.
@@ -159,6 +192,12 @@ class ExecutionGraph {
   // Check the downstream GRPC connections for the query.
   // If it is not healthy, we will cancel the query.
   Status CheckDownstreamGRPCConnectionsHealth();
+  // Whether all of the outputs of this graph are GRPC sinks whose destinations don't need any
+  // more results, in which case there is no point in running the sources any further.
+  bool DownstreamDone() const;
+  // Lets the GRPC sources whose rows go unchanged to a GRPC sink forward them without decoding
+  // them (see GRPCSourceNode::set_passthrough_sink).
+  void SetUpGRPCPassthrough();
 
  private:
   /**
@@ -193,6 +232,7 @@ class ExecutionGraph {
     // Create ExecNode.
     auto execNode = pool_.Add(new TNode());
     auto s = execNode->Init(node, output_descriptor, input_descriptors, collect_exec_node_stats_);
+    execNode->stats()->trace_batches = collect_exec_node_stats_ && FLAGS_carnot_trace_exec_batches;
 
     AddNode(node.id(), execNode);
 
@@ -209,6 +249,23 @@ class ExecutionGraph {
   }
 
   Status ExecuteSources();
+  // Runs the running sources until they are all done or none of them has a batch ready. Returns
+  // whether the sources are done.
+  StatusOr<bool> ExecuteReadySources();
+  // Drops the unhealthy GRPC sources after a yield, then executes the ready sources, if any.
+  StatusOr<bool> ResumeSources();
+
+  /**
+   * Finds the MemorySource -> (Map|Filter)* -> blocking Agg chains of the graph, which can read
+   * their source on several threads.
+   */
+  std::vector<std::unique_ptr<ParallelPipeline>> FindParallelPipelines();
+
+  /**
+   * Turns on fragment caching for the MemorySource -> (Map|Filter)* -> partial Agg chains of the
+   * graph, see MemorySourceNode::EnableFragmentCache(). Those chains then don't run in parallel.
+   */
+  void EnableFragmentCaches();
 
   ExecState* exec_state_;
   ObjectPool pool_{"exec_graph_pool"};
@@ -220,6 +277,13 @@ class ExecutionGraph {
   absl::flat_hash_set<int64_t> grpc_sources_;
   absl::flat_hash_set<int64_t> grpc_sinks_;
   std::unordered_map<int64_t, ExecNode*> nodes_;
+  std::unordered_map<int64_t, table_store::schema::RowDescriptor> descriptors_;
+  std::vector<std::unique_ptr<ParallelPipeline>> pipelines_;
+
+  // The sources that haven't finished yet, once ExecuteUntilBlocked() was first called.
+  bool sources_started_ = false;
+  absl::flat_hash_set<SourceNode*> running_sources_;
+  absl::flat_hash_map<SourceNode*, int64_t> source_to_id_;
 
   SystemTimePoint query_start_time_;
 
@@ -240,6 +304,7 @@ class ExecutionGraph {
   bool continue_ = false;
   std::mutex execution_mutex_;
   std::condition_variable execution_cv_;
+  std::function<void()> continue_func_;
   // Whether to collect stats on exec nodes.
   bool collect_exec_node_stats_;
 };
@@ -20,11 +20,13 @@
 
 #include <arrow/array.h>
 #include <arrow/memory_pool.h>
+#include <map>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include <gmock/gmock.h>
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -48,6 +50,8 @@ namespace carnot {
 namespace exec {
 
 using google::protobuf::TextFormat;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
 using table_store::Column;
 using table_store::Table;
 using table_store::schema::RowDescriptor;
@@ -66,6 +70,16 @@ class MultiplyUDF : public udf::ScalarUDF {
   }
 };
 
+class SumUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg) { sum_ = sum_.val + arg.val; }
+  void Merge(udf::FunctionContext*, const SumUDA& other) { sum_ = sum_.val + other.sum_.val; }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+
+ protected:
+  types::Int64Value sum_ = 0;
+};
+
 class BaseExecGraphTest : public ::testing::Test {
  protected:
   void SetUpExecState() {
@@ -286,6 +300,144 @@ TEST_F(ExecGraphTest, execute_time) {
                   ->Equals(types::ToArrow(out_in2, arrow::default_memory_pool())));
 }
 
+constexpr char kParallelAggPlanFragment[] = R"(
+  id: 1,
+  dag {
+    nodes {
+      id: 1
+      sorted_children: 2
+    }
+    nodes {
+      id: 2
+      sorted_children: 3
+      sorted_parents: 1
+    }
+    nodes {
+      id: 3
+      sorted_parents: 2
+    }
+  }
+  nodes {
+    id: 1
+    op {
+      op_type: MEMORY_SOURCE_OPERATOR
+      mem_source_op {
+        name: "numbers"
+        column_idxs: 0
+        column_types: INT64
+        column_names: "a"
+        column_idxs: 1
+        column_types: INT64
+        column_names: "b"
+      }
+    }
+  }
+  nodes {
+    id: 2
+    op {
+      op_type: AGGREGATE_OPERATOR
+      agg_op {
+        windowed: false
+        values {
+          name: "sum"
+          id: 0
+          args {
+            column {
+              node: 1
+              index: 1
+            }
+          }
+          args_data_types: INT64
+        }
+        groups {
+          node: 1
+          index: 0
+        }
+        group_names: "a"
+        value_names: "sum_b"
+      }
+    }
+  }
+  nodes {
+    id: 3
+    op {
+      op_type: MEMORY_SINK_OPERATOR
+      mem_sink_op {
+        name: "output"
+        column_types: INT64
+        column_types: INT64
+        column_names: "a"
+        column_names: "sum_b"
+      }
+    }
+  }
+)";
+
+TEST_F(ExecGraphTest, parallel_aggregate) {
+  auto parallelism = FLAGS_carnot_exec_parallelism;
+  FLAGS_carnot_exec_parallelism = 4;
+
+  planpb::PlanFragment pf_pb;
+  ASSERT_TRUE(TextFormat::MergeFromString(kParallelAggPlanFragment, &pf_pb));
+  std::shared_ptr<plan::PlanFragment> plan_fragment_ = std::make_shared<plan::PlanFragment>(1);
+  ASSERT_OK(plan_fragment_->Init(pf_pb));
+
+  auto func_registry = std::make_unique<udf::Registry>("test_registry");
+  func_registry->RegisterOrDie<SumUDA>("sum");
+  auto plan_state = std::make_unique<plan::PlanState>(func_registry.get());
+
+  auto schema = std::make_shared<table_store::schema::Schema>();
+  schema->AddRelation(1, table_store::schema::Relation(
+                             std::vector<types::DataType>({types::DataType::INT64,
+                                                           types::DataType::INT64}),
+                             std::vector<std::string>({"a", "b"})));
+
+  table_store::schema::Relation rel({types::DataType::INT64, types::DataType::INT64},
+                                    {"col1", "col2"});
+  auto table = Table::Create(rel);
+  // Enough batches for each worker to get several morsels.
+  constexpr int64_t kNumBatches = 50;
+  for (int64_t i = 0; i < kNumBatches; ++i) {
+    std::vector<types::Int64Value> col1_in = {0, 1, 2, 1};
+    std::vector<types::Int64Value> col2_in = {i, 1, 2, 3};
+    EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(col1_in, arrow::default_memory_pool())));
+    EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(col2_in, arrow::default_memory_pool())));
+  }
+
+  auto table_store = std::make_shared<table_store::TableStore>();
+  table_store->AddTable("numbers", table);
+  auto exec_state_ = std::make_unique<ExecState>(
+      func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  EXPECT_OK(exec_state_->AddUDA(0, "sum", std::vector<types::DataType>({types::DataType::INT64})));
+
+  ExecutionGraph e;
+  auto s = e.Init(schema, plan_state.get(), exec_state_.get(), plan_fragment_.get(),
+                  /* collect_exec_node_stats */ false);
+
+  EXPECT_OK(e.Execute());
+  auto stats = e.GetStats();
+  EXPECT_EQ(kNumBatches * 4, stats.rows_processed);
+  EXPECT_THAT(stats.table_rows_processed, UnorderedElementsAre(Pair("numbers", kNumBatches * 4)));
+
+  auto output_table = exec_state_->table_store()->GetTable("output");
+  ASSERT_EQ(1, output_table->NumBatches());
+  auto out_rb =
+      output_table->GetRowBatch(0, std::vector<int64_t>({0, 1}), arrow::default_memory_pool())
+          .ConsumeValueOrDie();
+  ASSERT_EQ(3, out_rb->num_rows());
+  auto groups = std::static_pointer_cast<arrow::Int64Array>(out_rb->ColumnAt(0));
+  auto sums = std::static_pointer_cast<arrow::Int64Array>(out_rb->ColumnAt(1));
+  std::map<int64_t, int64_t> sum_by_group;
+  for (int64_t i = 0; i < out_rb->num_rows(); ++i) {
+    sum_by_group[groups->Value(i)] = sums->Value(i);
+  }
+  EXPECT_EQ(kNumBatches * (kNumBatches - 1) / 2, sum_by_group[0]);
+  EXPECT_EQ(kNumBatches * 4, sum_by_group[1]);
+  EXPECT_EQ(kNumBatches * 2, sum_by_group[2]);
+
+  FLAGS_carnot_exec_parallelism = parallelism;
+}
+
 TEST_F(ExecGraphTest, two_limits_dont_interfere) {
   planpb::PlanFragment pf_pb;
   ASSERT_TRUE(
@@ -666,6 +818,49 @@ TEST_F(YieldingExecGraphTest, yield_timeout) {
   exec_thread.join();
 }
 
+TEST_F(YieldingExecGraphTest, continue_calls_continue_func) {
+  ExecutionGraph e;
+  e.testing_set_exec_state(exec_state_.get());
+
+  int continue_calls = 0;
+  e.set_continue_func([&] { ++continue_calls; });
+  e.Continue();
+  EXPECT_EQ(1, continue_calls);
+  EXPECT_FALSE(e.YieldWithTimeout());
+}
+
+TEST_F(YieldingExecGraphTest, execute_until_blocked) {
+  ExecutionGraph e{std::chrono::milliseconds(1), std::chrono::milliseconds(1)};
+  e.testing_set_exec_state(exec_state_.get());
+
+  RowDescriptor output_rd({types::DataType::INT64});
+  MockSourceNode source(output_rd);
+  FakePlanNode plan_node(1);
+  EXPECT_CALL(source, InitImpl(::testing::_));
+  ASSERT_OK(source.Init(plan_node, output_rd, {}));
+  e.AddNode(1, &source);
+
+  auto set_eos = [&](ExecState*) { source.SendEOS(); };
+  EXPECT_CALL(source, PrepareImpl(::testing::_)).WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(source, OpenImpl(::testing::_)).WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(source, NextBatchReady())
+      .WillOnce(::testing::Return(false))   // Nothing to generate.
+      .WillOnce(::testing::Return(false))   // Blocked.
+      .WillOnce(::testing::Return(false))   // Still blocked after resuming.
+      .WillOnce(::testing::Return(true))    // Resumed.
+      .WillOnce(::testing::Return(true))    // Generate EOS batch.
+      .WillOnce(::testing::Return(false));  // No more batches.
+  EXPECT_CALL(source, GenerateNextImpl(::testing::_))
+      .WillOnce(::testing::DoAll(::testing::Invoke(set_eos), ::testing::Return(Status::OK())));
+  EXPECT_CALL(source, CloseImpl(::testing::_)).WillOnce(::testing::Return(Status::OK()));
+
+  ASSERT_OK(e.Open());
+  EXPECT_OK_AND_EQ(e.ExecuteUntilBlocked(), false);
+  EXPECT_OK_AND_EQ(e.ExecuteUntilBlocked(), false);
+  EXPECT_OK_AND_EQ(e.ExecuteUntilBlocked(), true);
+  EXPECT_OK(e.Close(Status::OK()));
+}
+
 constexpr char kGRPCSourcePlanFragment[] = R"(
   id: 1,
   dag {
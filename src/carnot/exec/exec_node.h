@@ -18,11 +18,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/tracking_memory_pool.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/perf/perf.h"
@@ -46,7 +48,7 @@ struct ExecNodeStats {
     }
     ++batches_output;
     bytes_output += rb.NumBytes();
-    rows_output += rb.num_rows();
+    rows_output += rb.num_selected_rows();
   }
 
   void AddInputStats(const table_store::schema::RowBatch& rb) {
@@ -55,7 +57,7 @@ struct ExecNodeStats {
     }
     ++batches_input;
     bytes_input += rb.NumBytes();
-    rows_input += rb.num_rows();
+    rows_input += rb.num_selected_rows();
   }
 
   void ResumeChildTimer() {
@@ -99,6 +101,27 @@ struct ExecNodeStats {
     extra_info[key] = value;
   }
 
+  // The time the node spent on one batch, recorded when tracing batches.
+  struct TraceSpan {
+    int64_t start_ns;
+    int64_t duration_ns;
+    int64_t rows;
+  };
+  // Bounds the memory a long-running query's trace can take.
+  static constexpr size_t kMaxTraceSpans = 100000;
+
+  int64_t StartTraceSpan() const { return trace_batches ? CurrentTimeNS() : 0; }
+  void EndTraceSpan(int64_t start_ns, int64_t rows) {
+    if (!trace_batches) {
+      return;
+    }
+    if (trace_spans.size() >= kMaxTraceSpans) {
+      ++dropped_trace_spans;
+      return;
+    }
+    trace_spans.push_back({start_ns, CurrentTimeNS() - start_ns, rows});
+  }
+
   int64_t ChildExecTime() const { return children_timer.ElapsedTime_us() * 1000; }
   int64_t TotalExecTime() const { return total_timer.ElapsedTime_us() * 1000; }
   int64_t SelfExecTime() const { return TotalExecTime() - ChildExecTime(); }
@@ -115,12 +138,18 @@ struct ExecNodeStats {
   int64_t rows_output = 0;
   // Total batches input to this exec node.
   int64_t batches_output = 0;
+  // The most memory the exec node had allocated at any point.
+  int64_t peak_memory_bytes = 0;
   // Total timer for the node = children_time + self_time.
   ElapsedTimer total_timer;
   // Total timer for the children of the ndoe.
   ElapsedTimer children_timer;
   // Flag to determine whether to collect stats or not.
   bool collect_exec_stats;
+  // Whether to record a TraceSpan for every batch the node generates or consumes.
+  bool trace_batches = false;
+  std::vector<TraceSpan> trace_spans;
+  int64_t dropped_trace_spans = 0;
 
   // Extra metrics to store.
   absl::flat_hash_map<std::string, double> extra_metrics;
@@ -160,6 +189,8 @@ class ExecNode {
    */
   Status Prepare(ExecState* exec_state) {
     DCHECK(is_initialized_);
+    mem_pool_ = exec_state->query_mem_pool()->CreateChild(DebugString());
+    TrackingMemoryPool::ScopedCurrent scoped_pool(mem_pool_.get());
     return PrepareImpl(exec_state);
   }
 
@@ -170,6 +201,7 @@ class ExecNode {
    */
   Status Open(ExecState* exec_state) {
     DCHECK(is_initialized_);
+    TrackingMemoryPool::ScopedCurrent scoped_pool(mem_pool_.get());
     return OpenImpl(exec_state);
   }
 
@@ -182,6 +214,10 @@ class ExecNode {
    */
   Status Close(ExecState* exec_state) {
     DCHECK(is_initialized_);
+    TrackingMemoryPool::ScopedCurrent scoped_pool(mem_pool_.get());
+    if (mem_pool_ != nullptr) {
+      stats_->peak_memory_bytes = mem_pool_->max_memory();
+    }
     return CloseImpl(exec_state);
   }
 
@@ -195,7 +231,16 @@ class ExecNode {
     DCHECK(is_initialized_);
     DCHECK(type() == ExecNodeType::kSourceNode);
     stats_->ResumeTotalTimer();
-    PL_RETURN_IF_ERROR(GenerateNextImpl(exec_state));
+    int64_t span_start_ns = stats_->StartTraceSpan();
+    int64_t rows_output = stats_->rows_output;
+    {
+      TrackingMemoryPool::ScopedCurrent scoped_pool(mem_pool_.get());
+      PL_RETURN_IF_ERROR(GenerateNextImpl(exec_state));
+    }
+    // Nodes that can spill do so before they return, so the query has to give up if it is still
+    // over its soft limit.
+    PL_RETURN_IF_ERROR(exec_state->query_mem_pool()->CheckSoftLimit());
+    stats_->EndTraceSpan(span_start_ns, stats_->rows_output - rows_output);
     stats_->StopTotalTimer();
     return Status::OK();
   }
@@ -220,7 +265,24 @@ class ExecNode {
     }
     stats_->AddInputStats(rb);
     stats_->ResumeTotalTimer();
-    PL_RETURN_IF_ERROR(ConsumeNextImpl(exec_state, rb, parent_index));
+    int64_t span_start_ns = stats_->StartTraceSpan();
+    {
+      TrackingMemoryPool::ScopedCurrent scoped_pool(mem_pool_.get());
+      const table_store::schema::RowBatch* input_rb = &rb;
+      std::unique_ptr<table_store::schema::RowBatch> materialized_rb;
+      if (!ConsumesSelections() && input_rb->has_selection()) {
+        PL_ASSIGN_OR_RETURN(materialized_rb, input_rb->Materialize(exec_state->exec_mem_pool()));
+        input_rb = materialized_rb.get();
+      }
+      std::unique_ptr<table_store::schema::RowBatch> decoded_rb;
+      if (!ConsumesDictionaryStrings() && input_rb->HasDictionaryColumns()) {
+        PL_ASSIGN_OR_RETURN(decoded_rb, input_rb->DecodeDictionaries(exec_state->exec_mem_pool()));
+        input_rb = decoded_rb.get();
+      }
+      PL_RETURN_IF_ERROR(ConsumeNextImpl(exec_state, *input_rb, parent_index));
+    }
+    PL_RETURN_IF_ERROR(exec_state->query_mem_pool()->CheckSoftLimit());
+    stats_->EndTraceSpan(span_start_ns, rb.num_selected_rows());
     stats_->StopTotalTimer();
     return Status::OK();
   }
@@ -275,6 +337,11 @@ class ExecNode {
 
   ExecNodeStats* stats() const { return stats_.get(); }
 
+  /**
+   * The pool the node's allocations are charged to. Only set once the node is prepared.
+   */
+  TrackingMemoryPool* mem_pool() const { return mem_pool_.get(); }
+
  protected:
   /**
    * Send data to children row batches.
@@ -313,6 +380,28 @@ class ExecNode {
   virtual Status ConsumeNextImpl(ExecState*, const table_store::schema::RowBatch&, size_t) {
     return error::Unimplemented("Implement in derived class (if sink or processing)");
   }
+
+  /**
+   * Whether the node reads dictionary-encoded string columns (see types::IsDictionaryArray) as they
+   * are. The other nodes are given their row batches with the dictionaries decoded.
+   */
+  virtual bool ConsumesDictionaryStrings() const { return false; }
+
+  /**
+   * Whether the node reads row batches with a selection (see RowBatch::selection) as they are. The
+   * other nodes are given their row batches with only the selected rows in the columns.
+   */
+  virtual bool ConsumesSelections() const { return false; }
+
+  /**
+   * @ returns whether all the children read row batches with a selection, so that a batch with a
+   * selection can be sent to them without materializing it for each one.
+   */
+  bool ChildrenConsumeSelections() const {
+    return std::all_of(children_.begin(), children_.end(),
+                       [](const ExecNode* child) { return child->ConsumesSelections(); });
+  }
+
   bool is_closed() { return is_closed_; }
 
   std::unique_ptr<table_store::schema::RowDescriptor> output_descriptor_;
@@ -323,6 +412,7 @@ class ExecNode {
  private:
   // The stats of this exec node.
   std::unique_ptr<ExecNodeStats> stats_;
+  std::shared_ptr<TrackingMemoryPool> mem_pool_;
   // Unowned reference to the children. Must remain valid for the duration of query.
   std::vector<ExecNode*> children_;
   // For each of the children (which may have multiple parents) which parent is this node?
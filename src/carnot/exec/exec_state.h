@@ -26,11 +26,15 @@
 #include <utility>
 #include <vector>
 
+#include <absl/strings/substitute.h>
 #include <sole.hpp>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
+#include "src/carnot/exec/fragment_cache.h"
 #include "src/carnot/exec/grpc_router.h"
 #include "src/carnot/exec/ml/model_pool.h"
+#include "src/carnot/exec/shared_scan.h"
+#include "src/carnot/exec/tracking_memory_pool.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 #include "src/shared/metadata/metadata_state.h"
@@ -67,18 +71,28 @@ class ExecState {
         query_id_(query_id),
         model_pool_(model_pool),
         grpc_router_(grpc_router),
-        add_auth_to_grpc_client_context_func_(add_auth_func) {}
+        add_auth_to_grpc_client_context_func_(add_auth_func),
+        query_mem_pool_(TrackingMemoryPool::AgentPool()->CreateChild(
+            absl::Substitute("query $0", query_id.str()),
+            FLAGS_carnot_query_memory_soft_limit_bytes,
+            FLAGS_carnot_query_memory_hard_limit_bytes)) {}
 
   ~ExecState() {
     if (grpc_router_ != nullptr) {
       grpc_router_->DeleteQuery(query_id_);
     }
   }
+  /**
+   * The pool for the allocations of the query. Inside an exec node, this is the node's own pool
+   * (a child of the query pool), so the memory it uses shows up in its stats.
+   */
   arrow::MemoryPool* exec_mem_pool() {
-    // TOOD(zasgar): Make this the correct pool.
-    return arrow::default_memory_pool();
+    TrackingMemoryPool* current = TrackingMemoryPool::Current();
+    return current != nullptr ? current : query_mem_pool_.get();
   }
 
+  TrackingMemoryPool* query_mem_pool() { return query_mem_pool_.get(); }
+
   udf::Registry* func_registry() { return func_registry_; }
 
   table_store::TableStore* table_store() { return table_store_.get(); }
@@ -100,6 +114,10 @@ class ExecState {
     return Status::OK();
   }
 
+  // Adds definitions that were already resolved from the registry, eg. by a prepared plan.
+  void AddScalarUDF(int64_t id, udf::ScalarUDFDefinition* def) { id_to_scalar_udf_map_[id] = def; }
+  void AddUDA(int64_t id, udf::UDADefinition* def) { id_to_uda_map_[id] = def; }
+
   // This function returns a stub to a service that is responsible for receiving results.
   // Currently, it will either be a Kelvin instance or a query broker.
   carnotpb::ResultSinkService::StubInterface* ResultSinkServiceStub(
@@ -116,13 +134,23 @@ class ExecState {
     return raw;
   }
 
-  udf::ScalarUDFDefinition* GetScalarUDFDefinition(int64_t id) { return id_to_scalar_udf_map_[id]; }
+  // The lookups don't insert into the maps, so they can be made from the threads of a parallel
+  // pipeline.
+  udf::ScalarUDFDefinition* GetScalarUDFDefinition(int64_t id) {
+    auto it = id_to_scalar_udf_map_.find(id);
+    return it == id_to_scalar_udf_map_.end() ? nullptr : it->second;
+  }
 
   std::map<int64_t, udf::ScalarUDFDefinition*> id_to_scalar_udf_map() {
     return id_to_scalar_udf_map_;
   }
 
-  udf::UDADefinition* GetUDADefinition(int64_t id) { return id_to_uda_map_[id]; }
+  udf::UDADefinition* GetUDADefinition(int64_t id) {
+    auto it = id_to_uda_map_.find(id);
+    return it == id_to_uda_map_.end() ? nullptr : it->second;
+  }
+
+  const std::map<int64_t, udf::UDADefinition*>& id_to_uda_map() const { return id_to_uda_map_; }
 
   std::unique_ptr<udf::FunctionContext> CreateFunctionContext() {
     auto ctx = std::make_unique<udf::FunctionContext>(metadata_state_, model_pool_);
@@ -151,6 +179,20 @@ class ExecState {
     metadata_state_ = metadata_state;
   }
 
+  /**
+   * Lets memory sources share the batches they read with the concurrent queries scanning the same
+   * batches. Unowned, nullptr if shared scans are disabled.
+   */
+  SharedScanCoordinator* shared_scans() { return shared_scans_; }
+  void set_shared_scans(SharedScanCoordinator* shared_scans) { shared_scans_ = shared_scans; }
+
+  /**
+   * Caches the partial aggregates computed over table batches for the queries that run over the
+   * same batches again. Unowned, nullptr if fragment caching is disabled.
+   */
+  FragmentCache* fragment_cache() { return fragment_cache_; }
+  void set_fragment_cache(FragmentCache* fragment_cache) { fragment_cache_ = fragment_cache; }
+
   GRPCRouter* grpc_router() { return grpc_router_; }
 
   void AddAuthToGRPCClientContext(grpc::ClientContext* ctx) {
@@ -173,7 +215,10 @@ class ExecState {
   const sole::uuid query_id_;
   ml::ModelPool* model_pool_;
   GRPCRouter* grpc_router_ = nullptr;
+  SharedScanCoordinator* shared_scans_ = nullptr;
+  FragmentCache* fragment_cache_ = nullptr;
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_client_context_func_;
+  std::shared_ptr<TrackingMemoryPool> query_mem_pool_;
 
   int64_t current_source_ = 0;
   bool current_source_set_ = false;
@@ -25,6 +25,7 @@
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <vector>
 
@@ -37,6 +38,10 @@
 #include "src/shared/types/types.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
 
+DEFINE_bool(carnot_fused_expressions, gflags::BoolFromEnv("PL_CARNOT_FUSED_EXPRESSIONS", false),
+            "Whether expressions made only of vectorized functions are evaluated as a single "
+            "pass over each batch, without materializing the intermediate columns.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -144,6 +149,24 @@ Status ScalarExpressionEvaluator::Evaluate(ExecState* exec_state, const RowBatch
   }
   return Status::OK();
 }
+
+void ScalarExpressionEvaluator::CompileFusedExpressions(ExecState* exec_state) {
+  if (!FLAGS_carnot_fused_expressions) {
+    return;
+  }
+  for (const auto& expression : expressions_) {
+    auto fused = FusedExpression::Compile(exec_state, *expression, id_to_udf_map_);
+    if (fused != nullptr) {
+      fused_expressions_[expression.get()] = std::move(fused);
+    }
+  }
+}
+
+FusedExpression* ScalarExpressionEvaluator::GetFusedExpression(const plan::ScalarExpression& expr) {
+  auto it = fused_expressions_.find(&expr);
+  return it == fused_expressions_.end() ? nullptr : it->second.get();
+}
+
 std::string ScalarExpressionEvaluator::DebugString() {
   std::vector<std::string> debug_strs(expressions_.size());
   std::transform(begin(expressions_), end(expressions_), begin(debug_strs),
@@ -156,6 +179,7 @@ Status VectorNativeScalarExpressionEvaluator::Open(ExecState* exec_state) {
     auto udf = kv.second->Make();
     id_to_udf_map_[kv.first] = std::move(udf);
   }
+  CompileFusedExpressions(exec_state);
   return Status::OK();
 }
 
@@ -164,56 +188,156 @@ Status VectorNativeScalarExpressionEvaluator::Close(ExecState*) {
   return Status();
 }
 
-StatusOr<types::SharedColumnWrapper>
-VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
-    ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr) {
-  CHECK(exec_state != nullptr);
-  CHECK_GT(input.num_columns(), 0);
+// An intermediate value of the evaluator.
+struct VectorNativeScalarExpressionEvaluator::EvaluatedValue {
+  types::SharedColumnWrapper values;
+  // Set when values holds the distinct values of a dictionary-encoded column, indexed by codes.
+  std::shared_ptr<arrow::Array> codes;
+  // Set for constants, which are only expanded once the number of values they need is known.
+  const plan::ScalarValue* constant = nullptr;
+};
+
+types::SharedColumnWrapper VectorNativeScalarExpressionEvaluator::ExpandValue(
+    ExecState* exec_state, const EvaluatedValue& value, size_t num_rows) {
+  if (value.constant != nullptr) {
+    return EvalScalarToColumnWrapper(exec_state, *value.constant, num_rows);
+  }
+  if (value.codes == nullptr) {
+    return value.values;
+  }
+  auto codes = static_cast<const arrow::Int32Array*>(value.codes.get());
+  std::vector<size_t> indexes(codes->length());
+  for (int64_t i = 0; i < codes->length(); ++i) {
+    indexes[i] = codes->Value(i);
+  }
+  return value.values->CopyIndexes(indexes);
+}
 
-  size_t num_rows = input.num_rows();
+VectorNativeScalarExpressionEvaluator::EvaluatedValue
+VectorNativeScalarExpressionEvaluator::ExecScalarFunc(ExecState* exec_state, size_t num_rows,
+                                                      const plan::ScalarFunc& fn,
+                                                      const std::vector<EvaluatedValue>& children) {
+  // The function runs on the distinct values when all of its column inputs share the codes.
+  std::shared_ptr<arrow::Array> codes;
+  size_t num_values = 0;
+  bool shared_codes = true;
+  for (const auto& child : children) {
+    if (child.constant != nullptr) {
+      continue;
+    }
+    if (child.codes == nullptr || (codes != nullptr && child.codes != codes)) {
+      shared_codes = false;
+      break;
+    }
+    codes = child.codes;
+    num_values = child.values->Size();
+  }
+  if (!shared_codes || codes == nullptr) {
+    codes = nullptr;
+    num_values = num_rows;
+  }
 
-  // Path for scalar funcs an their dependencies to get evaluated.
-  // The Arrow arrays are converted to type erased column wrappers
-  // and then evaluated.
-  plan::ExpressionWalker<types::SharedColumnWrapper> walker;
-  walker.OnScalarValue(
-      [&](const plan::ScalarValue& val,
-          const std::vector<types::SharedColumnWrapper>& children) -> types::SharedColumnWrapper {
-        DCHECK_EQ(children.size(), 0ULL);
-        return EvalScalarToColumnWrapper(exec_state, val, num_rows);
-      });
+  std::vector<types::SharedColumnWrapper> args;
+  args.reserve(children.size());
+  std::vector<const types::ColumnWrapper*> raw_children;
+  raw_children.reserve(children.size());
+  for (const auto& child : children) {
+    args.push_back(codes != nullptr && child.codes != nullptr
+                       ? child.values
+                       : ExpandValue(exec_state, child, num_values));
+    raw_children.emplace_back(args.back().get());
+  }
 
-  walker.OnColumn(
-      [&](const plan::Column& col,
-          const std::vector<types::SharedColumnWrapper>& children) -> types::SharedColumnWrapper {
-        DCHECK_EQ(children.size(), 0ULL);
-        return ColumnWrapper::FromArrow(input.ColumnAt(col.Index()));
-      });
+  auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
+  auto udf = id_to_udf_map_[fn.udf_id()].get();
+  // Numeric results are written to a buffer from the pool, which the output array takes over.
+  auto output = types::ColumnWrapper::Make(def->exec_return_type(), num_values,
+                                           exec_state->exec_mem_pool());
+  // TODO(zasgar): need a better way to handle errors.
+  PL_CHECK_OK(def->ExecBatch(udf, function_ctx_, raw_children, output.get(), num_values));
+  return {output, codes};
+}
 
-  walker.OnScalarFunc(
-      [&](const plan::ScalarFunc& fn,
-          const std::vector<types::SharedColumnWrapper>& children) -> types::SharedColumnWrapper {
-        std::vector<types::DataType> arg_types;
-        arg_types.reserve(children.size());
-        for (const auto& child : children) {
-          arg_types.emplace_back(child->data_type());
-        }
+namespace {
 
-        auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
-        auto udf = id_to_udf_map_[fn.udf_id()].get();
+// Returns the value of a selector that is the same for every row, if it is.
+std::optional<bool> UniformSelector(const plan::ScalarValue* constant,
+                                    const types::ColumnWrapper* values) {
+  if (constant != nullptr) {
+    return constant->BoolValue();
+  }
+  const auto* selector = static_cast<const BoolValueColumnWrapper*>(values);
+  size_t num_true = 0;
+  for (size_t i = 0; i < selector->Size(); ++i) {
+    num_true += (*selector)[i].val;
+  }
+  if (num_true == selector->Size()) {
+    return true;
+  }
+  if (num_true == 0) {
+    return false;
+  }
+  return std::nullopt;
+}
 
-        std::vector<const types::ColumnWrapper*> raw_children;
-        raw_children.reserve(children.size());
-        for (const auto& child : children) {
-          raw_children.emplace_back(child.get());
-        }
-        auto output = types::ColumnWrapper::Make(def->exec_return_type(), num_rows);
-        // TODO(zasgar): need a better way to handle errors.
-        PL_CHECK_OK(def->ExecBatch(udf, function_ctx_, raw_children, output.get(), num_rows));
-        return output;
-      });
+}  // namespace
+
+StatusOr<VectorNativeScalarExpressionEvaluator::EvaluatedValue>
+VectorNativeScalarExpressionEvaluator::EvaluateValue(ExecState* exec_state, const RowBatch& input,
+                                                     const plan::ScalarExpression& expr) {
+  // Scalar funcs and their dependencies are evaluated depth first.
+  // The Arrow arrays are converted to type erased column wrappers
+  // and then evaluated. Numeric arrays are wrapped without a copy.
+  switch (expr.ExpressionType()) {
+    case plan::Expression::kConstant:
+      return EvaluatedValue{nullptr, nullptr, &static_cast<const plan::ScalarValue&>(expr)};
+    case plan::Expression::kColumn: {
+      auto arr = input.ColumnAt(static_cast<const plan::Column&>(expr).Index());
+      if (types::IsDictionaryArray(*arr)) {
+        auto dict_arr = static_cast<const arrow::DictionaryArray*>(arr.get());
+        return EvaluatedValue{ColumnWrapper::FromArrow(dict_arr->dictionary()),
+                              dict_arr->indices()};
+      }
+      return EvaluatedValue{ColumnWrapper::FromArrow(arr)};
+    }
+    case plan::Expression::kFunc:
+      break;
+    default:
+      return error::InvalidArgument("Expression type: $0 is invalid", expr.ExpressionType());
+  }
+
+  const auto& fn = static_cast<const plan::ScalarFunc&>(expr);
+  auto deps = fn.Deps();
+  std::vector<EvaluatedValue> children;
+  children.reserve(deps.size());
+  if (exec_state->GetScalarUDFDefinition(fn.udf_id())->conditional()) {
+    // A side that no row of the batch selects isn't evaluated at all.
+    PL_ASSIGN_OR_RETURN(auto selector, EvaluateValue(exec_state, input, *deps[0]));
+    auto uniform = UniformSelector(selector.constant, selector.values.get());
+    if (uniform.has_value()) {
+      return EvaluateValue(exec_state, input, *deps[*uniform ? 1 : 2]);
+    }
+    children.push_back(std::move(selector));
+    deps.erase(deps.begin());
+  }
+  for (const auto* dep : deps) {
+    PL_ASSIGN_OR_RETURN(auto child, EvaluateValue(exec_state, input, *dep));
+    children.push_back(std::move(child));
+  }
+  return ExecScalarFunc(exec_state, input.num_rows(), fn, children);
+}
 
-  return walker.Walk(expr);
+StatusOr<types::SharedColumnWrapper>
+VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
+    ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr) {
+  CHECK(exec_state != nullptr);
+  CHECK_GT(input.num_columns(), 0);
+
+  if (auto fused = GetFusedExpression(expr); fused != nullptr) {
+    return fused->EvaluateToColumnWrapper(input, function_ctx_);
+  }
+  PL_ASSIGN_OR_RETURN(auto value, EvaluateValue(exec_state, input, expr));
+  return ExpandValue(exec_state, value, input.num_rows());
 }
 
 Status VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
@@ -244,9 +368,21 @@ Status VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
     return Status::OK();
   }
 
-  PL_ASSIGN_OR_RETURN(auto result, VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
-                                       exec_state, input, expr));
-  PL_RETURN_IF_ERROR(output->AddColumn(result->ConvertToArrow(exec_state->exec_mem_pool())));
+  auto mem_pool = exec_state->exec_mem_pool();
+  if (auto fused = GetFusedExpression(expr); fused != nullptr) {
+    PL_ASSIGN_OR_RETURN(auto arr, fused->EvaluateToArrow(input, function_ctx_, mem_pool));
+    PL_RETURN_IF_ERROR(output->AddColumn(arr));
+    return Status::OK();
+  }
+  PL_ASSIGN_OR_RETURN(auto value, EvaluateValue(exec_state, input, expr));
+  // String results of the distinct values stay dictionary encoded, with the input codes.
+  if (value.codes != nullptr && value.values->data_type() == types::STRING) {
+    PL_RETURN_IF_ERROR(output->AddColumn(
+        types::MakeDictionaryStringArray(value.codes, value.values->ConvertToArrow(mem_pool))));
+    return Status::OK();
+  }
+  auto result = ExpandValue(exec_state, value, num_rows);
+  PL_RETURN_IF_ERROR(output->AddColumn(result->ConvertToArrow(mem_pool)));
   return Status::OK();
 }
 
@@ -255,6 +391,7 @@ Status ArrowNativeScalarExpressionEvaluator::Open(ExecState* exec_state) {
     auto udf = kv.second->Make();
     id_to_udf_map_[kv.first] = std::move(udf);
   }
+  CompileFusedExpressions(exec_state);
   return Status::OK();
 }
 Status ArrowNativeScalarExpressionEvaluator::Close(ExecState*) {
@@ -265,6 +402,12 @@ Status ArrowNativeScalarExpressionEvaluator::Close(ExecState*) {
 Status exec::ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
     exec::ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr,
     RowBatch* output) {
+  if (auto fused = GetFusedExpression(expr); fused != nullptr) {
+    PL_ASSIGN_OR_RETURN(auto arr,
+                        fused->EvaluateToArrow(input, function_ctx_, exec_state->exec_mem_pool()));
+    PL_RETURN_IF_ERROR(output->AddColumn(arr));
+    return Status::OK();
+  }
   size_t num_rows = input.num_rows();
   plan::ExpressionWalker<std::shared_ptr<arrow::Array>> walker;
   walker.OnScalarValue(
@@ -278,7 +421,10 @@ Status exec::ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
       [&](const plan::Column& col, const std::vector<std::shared_ptr<arrow::Array>>& children)
           -> std::shared_ptr<arrow::Array> {
         DCHECK_EQ(children.size(), 0ULL);
-        return input.ColumnAt(col.Index());
+        // The arrow UDFs only read plain arrays.
+        return types::DecodeDictionaryArray(input.ColumnAt(col.Index()),
+                                            exec_state->exec_mem_pool())
+            .ConsumeValueOrDie();
       });
 
   walker.OnScalarFunc(
@@ -293,7 +439,7 @@ Status exec::ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
         auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
         auto udf = id_to_udf_map_[fn.udf_id()].get();
 
-        auto output = MakeArrowBuilder(def->exec_return_type(), arrow::default_memory_pool());
+        auto output = MakeArrowBuilder(def->exec_return_type(), exec_state->exec_mem_pool());
 
         std::vector<arrow::Array*> raw_children;
         raw_children.reserve(children.size());
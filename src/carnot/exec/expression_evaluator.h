@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/fused_expression.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/udf/base.h"
 #include "src/carnot/udf/udf.h"
@@ -34,6 +35,8 @@
 #include "src/shared/types/column_wrapper.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_bool(carnot_fused_expressions);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -121,9 +124,17 @@ class ScalarExpressionEvaluator : public ExpressionEvaluator {
                                           const table_store::schema::RowBatch& input,
                                           const plan::ScalarExpression& expr,
                                           table_store::schema::RowBatch* output) = 0;
+
+  // Compiles the expressions that can be fused (see FusedExpression), when enabled. Called by
+  // Open once the UDFs are made.
+  void CompileFusedExpressions(ExecState* exec_state);
+  // Returns the fused version of the expression, or nullptr if it isn't fused.
+  FusedExpression* GetFusedExpression(const plan::ScalarExpression& expr);
+
   plan::ConstScalarExpressionVector expressions_;
   udf::FunctionContext* function_ctx_ = nullptr;
   std::map<int64_t, std::unique_ptr<udf::ScalarUDF>> id_to_udf_map_;
+  std::map<const plan::ScalarExpression*, std::unique_ptr<FusedExpression>> fused_expressions_;
 };
 
 /**
@@ -147,6 +158,21 @@ class VectorNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
   Status EvaluateSingleExpression(ExecState* exec_state, const table_store::schema::RowBatch& input,
                                   const plan::ScalarExpression& expr,
                                   table_store::schema::RowBatch* output) override;
+
+ private:
+  struct EvaluatedValue;
+
+  // Dictionary-encoded string columns are evaluated on their distinct values: the functions whose
+  // column inputs all share the same codes run once per distinct value instead of once per row.
+  // Conditional functions (see udf::ScalarUDF) only evaluate the sides that the selector picks.
+  StatusOr<EvaluatedValue> EvaluateValue(ExecState* exec_state,
+                                         const table_store::schema::RowBatch& input,
+                                         const plan::ScalarExpression& expr);
+  // Runs a function on the evaluated values of its arguments.
+  EvaluatedValue ExecScalarFunc(ExecState* exec_state, size_t num_rows, const plan::ScalarFunc& fn,
+                                const std::vector<EvaluatedValue>& children);
+  types::SharedColumnWrapper ExpandValue(ExecState* exec_state, const EvaluatedValue& value,
+                                         size_t num_rows);
 };
 
 /**
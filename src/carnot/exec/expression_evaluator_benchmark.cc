@@ -67,9 +67,17 @@ class AddUDF : public ScalarUDF {
   Int64Value Exec(FunctionContext*, Int64Value v1, Int64Value v2) { return v1.val + v2.val; }
 };
 
+class VectorizedAddUDF : public ScalarUDF {
+ public:
+  static constexpr bool kVectorized = true;
+
+  Int64Value Exec(FunctionContext*, Int64Value v1, Int64Value v2) { return v1.val + v2.val; }
+};
+
 // NOLINTNEXTLINE : runtime/references.
 void BM_ScalarExpressionTwoCols(benchmark::State& state,
-                                const ScalarExpressionEvaluatorType& eval_type, const char* pbtxt) {
+                                const ScalarExpressionEvaluatorType& eval_type, const char* pbtxt,
+                                bool fused = false) {
   px::carnot::planpb::ScalarExpression se_pb;
   size_t data_size = state.range(0);
 
@@ -80,9 +88,15 @@ void BM_ScalarExpressionTwoCols(benchmark::State& state,
 
   auto func_registry = std::make_unique<Registry>("test_registry");
   auto table_store = std::make_shared<px::table_store::TableStore>();
-  PL_CHECK_OK(func_registry->Register<AddUDF>("add"));
+  if (fused) {
+    PL_CHECK_OK(func_registry->Register<VectorizedAddUDF>("add"));
+  } else {
+    PL_CHECK_OK(func_registry->Register<AddUDF>("add"));
+  }
+  FLAGS_carnot_fused_expressions = fused;
   auto exec_state = std::make_unique<ExecState>(
       func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  PL_CHECK_OK(exec_state->AddScalarUDF(0, "add", {DataType::INT64, DataType::INT64}));
 
   auto in1 = px::datagen::CreateLargeData<Int64Value>(data_size);
   auto in2 = px::datagen::CreateLargeData<Int64Value>(data_size);
@@ -143,3 +157,12 @@ BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_simple_add_vector,
                   ScalarExpressionEvaluatorType::kVectorNative, kAddScalarFuncNestedPbtxt)
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_add_nested_fused_arrow,
+                  ScalarExpressionEvaluatorType::kArrowNative, kAddScalarFuncNestedPbtxt, true)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_add_nested_fused_native,
+                  ScalarExpressionEvaluatorType::kVectorNative, kAddScalarFuncNestedPbtxt, true)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
@@ -18,12 +18,14 @@
 
 #include "src/carnot/exec/expression_evaluator.h"
 
+#include <arrow/builder.h>
 #include <arrow/memory_pool.h>
 #include <arrow/type_fwd.h>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <absl/strings/substitute.h>
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -210,6 +212,207 @@ TEST_P(ScalarExpressionTest, eval_uint128_constant) {
   EXPECT_EQ(types::UInt128Value(123, 456), casted->Value(2));
 }
 
+class SuffixUDF : public udf::ScalarUDF {
+ public:
+  types::StringValue Exec(FunctionContext*, types::StringValue str, types::StringValue suffix) {
+    ++num_calls;
+    return str + suffix;
+  }
+  static inline int num_calls = 0;
+};
+
+constexpr char kSuffixScalarFuncPbtxt[] = R"(
+func {
+  name: "suffix"
+  args {
+    column {
+      node: 0
+      index: 0
+    }
+  }
+  args {
+    constant {
+      data_type: STRING,
+      string_value: "!"
+    }
+  }
+  args_data_types: STRING
+  args_data_types: STRING
+})";
+
+TEST(DictionaryStringsTest, funcs_run_once_per_distinct_value) {
+  auto func_registry = std::make_unique<udf::Registry>("test_registry");
+  ASSERT_OK(func_registry->Register<SuffixUDF>("suffix"));
+  auto exec_state =
+      std::make_unique<ExecState>(func_registry.get(), std::make_shared<table_store::TableStore>(),
+                                  MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  ASSERT_OK(exec_state->AddScalarUDF(0, "suffix",
+                                     std::vector<types::DataType>(
+                                         {types::DataType::STRING, types::DataType::STRING})));
+
+  arrow::Int32Builder codes_builder;
+  for (int32_t code : {0, 1, 1, 0, 1}) {
+    ASSERT_TRUE(codes_builder.Append(code).ok());
+  }
+  std::shared_ptr<arrow::Array> codes;
+  ASSERT_TRUE(codes_builder.Finish(&codes).ok());
+  auto values = ToArrow(std::vector<types::StringValue>{"/healthz", "/api"},
+                        arrow::default_memory_pool());
+  RowBatch input_rb(RowDescriptor({types::DataType::STRING}), 5);
+  ASSERT_OK(input_rb.AddColumn(types::MakeDictionaryStringArray(codes, values)));
+
+  RowBatch output_rb(RowDescriptor({types::DataType::STRING}), 5);
+  auto function_ctx = std::make_unique<udf::FunctionContext>(nullptr, nullptr);
+  auto evaluator = ScalarExpressionEvaluator::Create({ScalarExpressionOf(kSuffixScalarFuncPbtxt)},
+                                                     ScalarExpressionEvaluatorType::kVectorNative,
+                                                     function_ctx.get());
+  SuffixUDF::num_calls = 0;
+  ASSERT_OK(evaluator->Open(exec_state.get()));
+  ASSERT_OK(evaluator->Evaluate(exec_state.get(), input_rb, &output_rb));
+  ASSERT_OK(evaluator->Close(exec_state.get()));
+
+  EXPECT_EQ(2, SuffixUDF::num_calls);
+  auto out_col = output_rb.ColumnAt(0);
+  // The result keeps the input codes.
+  ASSERT_TRUE(types::IsDictionaryArray(*out_col));
+  ASSERT_OK_AND_ASSIGN(auto decoded,
+                       types::DecodeDictionaryArray(out_col, arrow::default_memory_pool()));
+  auto casted = static_cast<arrow::StringArray*>(decoded.get());
+  EXPECT_EQ("/healthz!", casted->GetString(0));
+  EXPECT_EQ("/api!", casted->GetString(1));
+  EXPECT_EQ("/api!", casted->GetString(2));
+  EXPECT_EQ("/healthz!", casted->GetString(3));
+  EXPECT_EQ("/api!", casted->GetString(4));
+}
+
+class GreaterThanUDF : public udf::ScalarUDF {
+ public:
+  types::BoolValue Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val > v2.val;
+  }
+};
+
+class CountingAddUDF : public udf::ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    ++num_calls;
+    return v1.val + v2.val;
+  }
+  static inline int num_calls = 0;
+};
+
+class SelectUDF : public udf::ScalarUDF {
+ public:
+  static constexpr bool kConditional = true;
+
+  types::Int64Value Exec(FunctionContext*, types::BoolValue s, types::Int64Value v1,
+                         types::Int64Value v2) {
+    return s.val ? v1 : v2;
+  }
+};
+
+// select(col0 > $0, col0, counting_add(col0, col1))
+constexpr char kSelectScalarFuncPbtxt[] = R"(
+func {
+  name: "select"
+  id: 10
+  args {
+    func {
+      name: "gt"
+      id: 11
+      args {
+        column {
+          node: 0
+          index: 0
+        }
+      }
+      args {
+        constant {
+          data_type: INT64,
+          int64_value: $0
+        }
+      }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args {
+    column {
+      node: 0
+      index: 0
+    }
+  }
+  args {
+    func {
+      name: "counting_add"
+      id: 12
+      args {
+        column {
+          node: 0
+          index: 0
+        }
+      }
+      args {
+        column {
+          node: 0
+          index: 1
+        }
+      }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args_data_types: BOOLEAN
+  args_data_types: INT64
+  args_data_types: INT64
+})";
+
+class ConditionalExpressionTest : public ScalarExpressionTest {
+ public:
+  void SetUp() override {
+    ScalarExpressionTest::SetUp();
+    EXPECT_OK(func_registry_->Register<GreaterThanUDF>("gt"));
+    EXPECT_OK(func_registry_->Register<CountingAddUDF>("counting_add"));
+    EXPECT_OK(func_registry_->Register<SelectUDF>("select"));
+    std::vector<types::DataType> int_args({types::DataType::INT64, types::DataType::INT64});
+    EXPECT_OK(exec_state_->AddScalarUDF(
+        10, "select",
+        std::vector<types::DataType>(
+            {types::DataType::BOOLEAN, types::DataType::INT64, types::DataType::INT64})));
+    EXPECT_OK(exec_state_->AddScalarUDF(11, "gt", int_args));
+    EXPECT_OK(exec_state_->AddScalarUDF(12, "counting_add", int_args));
+  }
+
+  std::vector<int64_t> EvaluateSelect(int64_t threshold) {
+    RowBatch output_rb(RowDescriptor({types::DataType::INT64}), input_rb_->num_rows());
+    RunEvaluator({ScalarExpressionOf(absl::Substitute(kSelectScalarFuncPbtxt, threshold))},
+                 &output_rb);
+    auto casted = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(0).get());
+    return std::vector<int64_t>(casted->raw_values(), casted->raw_values() + casted->length());
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(TestVecAndArrow, ConditionalExpressionTest,
+                         ::testing::Values(ScalarExpressionEvaluatorType::kVectorNative,
+                                           ScalarExpressionEvaluatorType::kArrowNative));
+
+TEST_P(ConditionalExpressionTest, blends_sides) {
+  // The input rows are (1, 3), (2, 4) and (3, 5).
+  EXPECT_EQ(std::vector<int64_t>({4, 6, 3}), EvaluateSelect(2));
+  EXPECT_EQ(std::vector<int64_t>({1, 2, 3}), EvaluateSelect(0));
+  EXPECT_EQ(std::vector<int64_t>({4, 6, 8}), EvaluateSelect(5));
+}
+
+TEST_P(ConditionalExpressionTest, skips_unselected_side) {
+  CountingAddUDF::num_calls = 0;
+  EXPECT_EQ(std::vector<int64_t>({1, 2, 3}), EvaluateSelect(0));
+  if (GetParam() == ScalarExpressionEvaluatorType::kVectorNative) {
+    EXPECT_EQ(0, CountingAddUDF::num_calls);
+  }
+  EvaluateSelect(2);
+  EXPECT_GT(CountingAddUDF::num_calls, 0);
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -49,8 +49,14 @@ class FilterNode : public ProcessingNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  bool ConsumesDictionaryStrings() const override { return true; }
+  bool ConsumesSelections() const override { return true; }
 
  private:
+  // The fraction of the rows of a batch that need to pass the filter for its output to keep its
+  // columns with a selection instead of copying the selected rows.
+  static constexpr double kMinSelectivityForSelection = 0.25;
+
   std::unique_ptr<VectorNativeScalarExpressionEvaluator> evaluator_;
   std::unique_ptr<plan::FilterOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
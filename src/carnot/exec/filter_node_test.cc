@@ -18,6 +18,9 @@
 
 #include "src/carnot/exec/filter_node.h"
 
+#include <memory>
+#include <vector>
+
 #include <sole.hpp>
 
 #include "src/carnot/exec/test_utils.h"
@@ -139,6 +142,34 @@ TEST_F(FilterNodeTest, column_selection) {
       .Close();
 }
 
+TEST_F(FilterNodeTest, input_with_selection) {
+  auto op_proto = planpb::testutils::CreateTestFilterTwoCols();
+  plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+
+  RowBatchBuilder input_rb(input_rd, 4, /*eow*/ true, /*eos*/ true);
+  input_rb.AddColumn<types::Int64Value>({1, 1, 3, 1})
+      .AddColumn<types::Int64Value>({1, 3, 6, 9})
+      .AddColumn<types::StringValue>({"ABC", "DEF", "HELLO", "WORLD"});
+  // The first row passes the predicate, but isn't selected.
+  input_rb.get().set_selection(
+      std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{1, 2, 3}));
+
+  // The mock child doesn't read selections, so it gets the selected rows.
+  auto tester = exec::ExecNodeTester<FilterNode, plan::FilterOperator>(
+      *plan_node_, output_rd, {input_rd}, exec_state_.get());
+  tester.ConsumeNext(input_rb.get(), 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 1})
+                          .AddColumn<types::Int64Value>({3, 9})
+                          .AddColumn<types::StringValue>({"DEF", "WORLD"})
+                          .get())
+      .Close();
+}
+
 TEST_F(FilterNodeTest, zero_row_row_batch) {
   auto op_proto = planpb::testutils::CreateTestFilterTwoCols();
   plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
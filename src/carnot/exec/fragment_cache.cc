@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/fragment_cache.h"
+
+DEFINE_int64(carnot_fragment_cache_max_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_FRAGMENT_CACHE_MAX_BYTES", 32 * 1024 * 1024),
+             "The number of bytes of partial aggregates cached for the queries that re-run over "
+             "the same table batches. Set to '0' to disable fragment caching.");
+DEFINE_int64(carnot_fragment_cache_bucket_ms,
+             gflags::Int64FromEnv("PL_CARNOT_FRAGMENT_CACHE_BUCKET_MS", 10 * 1000),
+             "The width of the time buckets the table batches are grouped into for fragment "
+             "caching. Each complete bucket of batches gets its own partial aggregate.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+std::unique_ptr<FragmentCache> FragmentCache::CreateFromFlags() {
+  if (FLAGS_carnot_fragment_cache_max_bytes <= 0 || FLAGS_carnot_fragment_cache_bucket_ms <= 0) {
+    return nullptr;
+  }
+  return std::make_unique<FragmentCache>(FLAGS_carnot_fragment_cache_max_bytes);
+}
+
+std::shared_ptr<const RowBatch> FragmentCache::Get(const std::string& fragment,
+                                                   const BatchRefs& batches) {
+  if (batches.empty() || batches[0] == nullptr) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> l(lock_);
+  auto it = entries_.find(Key{fragment, batches[0].get()});
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  const Entry& entry = it->second;
+  bool same_batches = entry.batches.size() == batches.size();
+  for (size_t i = 0; same_batches && i < batches.size(); ++i) {
+    same_batches = entry.batches[i].lock() == batches[i];
+  }
+  if (!same_batches) {
+    // The table no longer holds the batches the entry was computed on, so it can't match again.
+    EraseUnlocked(it);
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, entry.lru_pos);
+  return entry.rb;
+}
+
+void FragmentCache::Put(const std::string& fragment, const BatchRefs& batches,
+                        std::shared_ptr<const RowBatch> rb) {
+  if (batches.empty() || batches[0] == nullptr || rb == nullptr) {
+    return;
+  }
+  Entry entry;
+  entry.batches.assign(batches.begin(), batches.end());
+  entry.bytes = rb->NumBytes();
+  entry.rb = std::move(rb);
+  if (entry.bytes > max_bytes_) {
+    return;
+  }
+
+  Key key{fragment, batches[0].get()};
+  std::lock_guard<std::mutex> l(lock_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    EraseUnlocked(it);
+  }
+  lru_.push_front(key);
+  entry.lru_pos = lru_.begin();
+  bytes_ += entry.bytes;
+  entries_.emplace(std::move(key), std::move(entry));
+
+  while (bytes_ > max_bytes_) {
+    EraseUnlocked(entries_.find(lru_.back()));
+  }
+}
+
+void FragmentCache::EraseUnlocked(absl::flat_hash_map<Key, Entry>::iterator it) {
+  bytes_ -= it->second.bytes;
+  lru_.erase(it->second.lru_pos);
+  entries_.erase(it);
+}
+
+int64_t FragmentCache::num_entries() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return entries_.size();
+}
+
+int64_t FragmentCache::bytes() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return bytes_;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
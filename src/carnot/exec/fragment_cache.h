@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+
+DECLARE_int64(carnot_fragment_cache_max_bytes);
+DECLARE_int64(carnot_fragment_cache_bucket_ms);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * FragmentCache keeps the output of the partial aggregates of a PEM over runs of table batches, so
+ * that the queries a live view re-runs every few seconds only aggregate the batches that are new
+ * since the last run.
+ *
+ * An entry is keyed by the fragment, ie. everything but the time range of the memory source ->
+ * map/filter -> partial aggregate chain that produced it, and by the batches it was computed on
+ * (see table_store::Table::BatchRef). It is only returned while the table still holds exactly
+ * those batches, so expired or compacted batches simply stop matching and age out of the cache.
+ *
+ * Thread-safe. One is shared by all the queries of a Carnot instance, and the least recently used
+ * entries are dropped once the cached batches don't fit in max_bytes.
+ */
+class FragmentCache : public NotCopyable {
+ public:
+  using BatchRefs = std::vector<std::shared_ptr<const void>>;
+
+  explicit FragmentCache(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  /**
+   * Creates a cache configured with the --carnot_fragment_cache_* flags, or returns nullptr if
+   * fragment caching is disabled.
+   */
+  static std::unique_ptr<FragmentCache> CreateFromFlags();
+
+  /**
+   * @return the cached output of the fragment over the given batches, or nullptr if there is none.
+   */
+  std::shared_ptr<const table_store::schema::RowBatch> Get(const std::string& fragment,
+                                                           const BatchRefs& batches);
+
+  /**
+   * Caches the output of the fragment over the given batches, replacing the output cached for an
+   * earlier set of batches that started at the same batch.
+   */
+  void Put(const std::string& fragment, const BatchRefs& batches,
+           std::shared_ptr<const table_store::schema::RowBatch> rb);
+
+  int64_t num_entries() const;
+  int64_t bytes() const;
+
+ private:
+  struct Key {
+    std::string fragment;
+    const void* first_batch;
+
+    bool operator==(const Key& other) const {
+      return first_batch == other.first_batch && fragment == other.fragment;
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.fragment, key.first_batch);
+    }
+  };
+
+  struct Entry {
+    // Weak, so that the cache doesn't keep expired batches around. The batches only match while
+    // they all still lock to the current batches of the table.
+    std::vector<std::weak_ptr<const void>> batches;
+    std::shared_ptr<const table_store::schema::RowBatch> rb;
+    int64_t bytes = 0;
+    std::list<Key>::iterator lru_pos;
+  };
+
+  void EraseUnlocked(absl::flat_hash_map<Key, Entry>::iterator it);
+
+  const int64_t max_bytes_;
+
+  mutable std::mutex lock_;
+  absl::flat_hash_map<Key, Entry> entries_;
+  // The keys from the most to the least recently used.
+  std::list<Key> lru_;
+  int64_t bytes_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
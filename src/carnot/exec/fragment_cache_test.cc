@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/carnot/exec/fragment_cache.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+class FragmentCacheTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<const RowBatch> MakeBatch(int64_t num_rows) {
+    auto rb = std::make_shared<RowBatch>(RowDescriptor({types::DataType::INT64}), num_rows);
+    std::vector<types::Int64Value> values(num_rows, 1);
+    EXPECT_OK(rb->AddColumn(types::ToArrow(values, arrow::default_memory_pool())));
+    return rb;
+  }
+
+  std::shared_ptr<const void> batch0_ = std::make_shared<int>(0);
+  std::shared_ptr<const void> batch1_ = std::make_shared<int>(1);
+};
+
+TEST_F(FragmentCacheTest, returns_output_for_the_same_batches) {
+  FragmentCache cache(1024 * 1024);
+  auto rb = MakeBatch(3);
+  cache.Put("agg", {batch0_, batch1_}, rb);
+
+  EXPECT_EQ(rb, cache.Get("agg", {batch0_, batch1_}));
+  EXPECT_EQ(1, cache.num_entries());
+  EXPECT_EQ(rb->NumBytes(), cache.bytes());
+
+  // Other fragments over the same batches don't match.
+  EXPECT_EQ(nullptr, cache.Get("other_agg", {batch0_, batch1_}));
+  EXPECT_EQ(1, cache.num_entries());
+}
+
+TEST_F(FragmentCacheTest, does_not_return_output_for_other_batches) {
+  FragmentCache cache(1024 * 1024);
+  cache.Put("agg", {batch0_, batch1_}, MakeBatch(3));
+
+  EXPECT_EQ(nullptr, cache.Get("agg", {batch1_}));
+  // Fewer batches starting at the same batch, eg. because the rest was compacted.
+  EXPECT_EQ(nullptr, cache.Get("agg", {batch0_}));
+  EXPECT_EQ(0, cache.num_entries());
+
+  cache.Put("agg", {batch0_, batch1_}, MakeBatch(3));
+  // The second batch expired, and a new one ended up in its place.
+  batch1_ = std::make_shared<int>(1);
+  EXPECT_EQ(nullptr, cache.Get("agg", {batch0_, batch1_}));
+  EXPECT_EQ(0, cache.bytes());
+}
+
+TEST_F(FragmentCacheTest, evicts_least_recently_used) {
+  auto rb = MakeBatch(100);
+  FragmentCache cache(2 * rb->NumBytes());
+  cache.Put("agg0", {batch0_}, rb);
+  cache.Put("agg1", {batch0_}, rb);
+  ASSERT_NE(nullptr, cache.Get("agg0", {batch0_}));
+
+  cache.Put("agg2", {batch0_}, rb);
+  EXPECT_EQ(2, cache.num_entries());
+  EXPECT_NE(nullptr, cache.Get("agg0", {batch0_}));
+  EXPECT_EQ(nullptr, cache.Get("agg1", {batch0_}));
+  EXPECT_NE(nullptr, cache.Get("agg2", {batch0_}));
+
+  // Outputs larger than the cache aren't cached at all.
+  FragmentCache small_cache(rb->NumBytes() - 1);
+  small_cache.Put("agg", {batch0_}, rb);
+  EXPECT_EQ(0, small_cache.num_entries());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
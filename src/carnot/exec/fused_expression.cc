@@ -0,0 +1,213 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/fused_expression.h"
+
+#include <arrow/builder.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "src/shared/types/type_utils.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using types::DataType;
+
+namespace {
+
+// The types of the values that flow between vectorized UDFs.
+bool IsFusedValueType(DataType data_type) {
+  return data_type == DataType::INT64 || data_type == DataType::TIME64NS ||
+         data_type == DataType::FLOAT64;
+}
+
+// Returns the bits of a numeric constant.
+uint64_t ConstantBits(const plan::ScalarValue& val) {
+  uint64_t bits = 0;
+  if (val.DataType() == DataType::FLOAT64) {
+    double v = val.Float64Value();
+    std::memcpy(&bits, &v, sizeof(bits));
+  } else {
+    int64_t v = val.DataType() == DataType::INT64 ? val.Int64Value() : val.Time64NSValue();
+    std::memcpy(&bits, &v, sizeof(bits));
+  }
+  return bits;
+}
+
+}  // namespace
+
+std::unique_ptr<FusedExpression> FusedExpression::Compile(
+    ExecState* exec_state, const plan::ScalarExpression& expr,
+    const std::map<int64_t, std::unique_ptr<udf::ScalarUDF>>& udfs) {
+  if (expr.ExpressionType() != plan::Expression::kFunc) {
+    return nullptr;
+  }
+  std::unique_ptr<FusedExpression> fused(new FusedExpression());
+  auto root_or_s = fused->CompileExpression(exec_state, expr, udfs);
+  if (!root_or_s.ok()) {
+    VLOG(1) << "Not fusing " << expr.DebugString() << ": " << root_or_s.msg();
+    return nullptr;
+  }
+  // The result is written straight to the output, so it doesn't need a buffer.
+  auto& root = fused->slots_[root_or_s.ConsumeValueOrDie()];
+  root.buffer.clear();
+  root.buffer.shrink_to_fit();
+  fused->data_type_ = root.data_type;
+  return fused;
+}
+
+StatusOr<size_t> FusedExpression::CompileExpression(
+    ExecState* exec_state, const plan::ScalarExpression& expr,
+    const std::map<int64_t, std::unique_ptr<udf::ScalarUDF>>& udfs) {
+  switch (expr.ExpressionType()) {
+    case plan::Expression::kColumn: {
+      const auto& col = static_cast<const plan::Column&>(expr);
+      // The type is filled in by the function that reads the column.
+      slots_.push_back({col.Index(), DataType::DATA_TYPE_UNKNOWN, {}});
+      return slots_.size() - 1;
+    }
+    case plan::Expression::kConstant: {
+      const auto& val = static_cast<const plan::ScalarValue&>(expr);
+      if (!IsFusedValueType(val.DataType()) || val.IsNull()) {
+        return error::Unimplemented("constants of type $0 can't be fused",
+                                    types::ToString(val.DataType()));
+      }
+      slots_.push_back({-1, val.DataType(), std::vector<uint64_t>(kChunkSize, ConstantBits(val))});
+      return slots_.size() - 1;
+    }
+    case plan::Expression::kFunc:
+      break;
+    default:
+      return error::Unimplemented("expression type can't be fused");
+  }
+
+  const auto& fn = static_cast<const plan::ScalarFunc&>(expr);
+  auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
+  auto udf_it = udfs.find(fn.udf_id());
+  if (def == nullptr || !def->vectorized() || udf_it == udfs.end()) {
+    return error::Unimplemented("$0 is not vectorized", fn.name());
+  }
+
+  Step step{def, udf_it->second.get(), {}, 0};
+  const auto& args = fn.arg_deps();
+  for (size_t i = 0; i < args.size(); ++i) {
+    PL_ASSIGN_OR_RETURN(size_t arg_slot, CompileExpression(exec_state, *args[i], udfs));
+    auto& slot = slots_[arg_slot];
+    DataType arg_type = def->exec_arguments()[i];
+    if (slot.col_idx >= 0 && slot.data_type == DataType::DATA_TYPE_UNKNOWN) {
+      slot.data_type = arg_type;
+    }
+    if (slot.data_type != arg_type) {
+      return error::Unimplemented("argument $0 of $1 has type $2, expected $3", i, fn.name(),
+                                  types::ToString(slot.data_type), types::ToString(arg_type));
+    }
+    step.arg_slots.push_back(arg_slot);
+  }
+  // Booleans can't be fed to another vectorized UDF, so they can only be the final result.
+  slots_.push_back({-1, def->exec_return_type(), std::vector<uint64_t>(kChunkSize)});
+  step.out_slot = slots_.size() - 1;
+  steps_.push_back(std::move(step));
+  return slots_.size() - 1;
+}
+
+Status FusedExpression::Evaluate(const RowBatch& input, udf::FunctionContext* ctx, void* out) {
+  // The columns are read in place.
+  std::vector<const uint64_t*> columns(slots_.size(), nullptr);
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    const auto& slot = slots_[i];
+    if (slot.col_idx < 0) {
+      continue;
+    }
+    if (input.desc().type(slot.col_idx) != slot.data_type) {
+      return error::InvalidArgument("Column $0 has type $1, expected $2", slot.col_idx,
+                                    types::ToString(input.desc().type(slot.col_idx)),
+                                    types::ToString(slot.data_type));
+    }
+    columns[i] = input.ColumnAt(slot.col_idx)->data()->GetValues<uint64_t>(1);
+  }
+
+  size_t out_width = data_type_ == DataType::BOOLEAN ? sizeof(uint8_t) : sizeof(uint64_t);
+  size_t root_slot = steps_.back().out_slot;
+  size_t num_rows = input.num_rows();
+  std::vector<const void*> args;
+  for (size_t offset = 0; offset < num_rows; offset += kChunkSize) {
+    size_t count = std::min(kChunkSize, num_rows - offset);
+    for (const auto& step : steps_) {
+      args.clear();
+      for (size_t arg_slot : step.arg_slots) {
+        args.push_back(columns[arg_slot] != nullptr ? columns[arg_slot] + offset
+                                                    : slots_[arg_slot].buffer.data());
+      }
+      void* step_out = step.out_slot == root_slot
+                           ? static_cast<uint8_t*>(out) + offset * out_width
+                           : static_cast<void*>(slots_[step.out_slot].buffer.data());
+      step.def->ExecBatchRaw(step.udf, ctx, args, step_out, count);
+    }
+  }
+  return Status::OK();
+}
+
+template <DataType TDataType>
+StatusOr<std::shared_ptr<arrow::Array>> FusedExpression::EvaluateToArrowTyped(
+    const RowBatch& input, udf::FunctionContext* ctx, arrow::MemoryPool* mem_pool) {
+  using native_type = std::conditional_t<TDataType == DataType::BOOLEAN, uint8_t,
+                                         typename types::DataTypeTraits<TDataType>::native_type>;
+  std::vector<native_type> results(input.num_rows());
+  PL_RETURN_IF_ERROR(Evaluate(input, ctx, results.data()));
+
+  typename types::DataTypeTraits<TDataType>::arrow_builder_type builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.AppendValues(results.data(), results.size()));
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> FusedExpression::EvaluateToArrow(
+    const RowBatch& input, udf::FunctionContext* ctx, arrow::MemoryPool* mem_pool) {
+  switch (data_type_) {
+    case DataType::BOOLEAN:
+      return EvaluateToArrowTyped<DataType::BOOLEAN>(input, ctx, mem_pool);
+    case DataType::INT64:
+      return EvaluateToArrowTyped<DataType::INT64>(input, ctx, mem_pool);
+    case DataType::TIME64NS:
+      return EvaluateToArrowTyped<DataType::TIME64NS>(input, ctx, mem_pool);
+    case DataType::FLOAT64:
+      return EvaluateToArrowTyped<DataType::FLOAT64>(input, ctx, mem_pool);
+    default:
+      return error::Internal("Unexpected fused expression type $0", types::ToString(data_type_));
+  }
+}
+
+StatusOr<types::SharedColumnWrapper> FusedExpression::EvaluateToColumnWrapper(
+    const RowBatch& input, udf::FunctionContext* ctx) {
+  // The value types of the fused types only hold their native value.
+  auto output = types::ColumnWrapper::Make(data_type_, input.num_rows());
+  PL_RETURN_IF_ERROR(Evaluate(input, ctx, output->UnsafeRawData()));
+  return output;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
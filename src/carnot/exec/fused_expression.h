@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/carnot/udf/udf.h"
+#include "src/carnot/udf/udf_definition.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * FusedExpression evaluates a tree of vectorized UDFs (see udf::ScalarUDF) over columns and
+ * constants as a single pass over the batch, instead of one pass and one materialized column per
+ * function. The batch is processed in chunks that are small enough for the intermediate results
+ * to stay in cache, and the chunk buffers are allocated once when the expression is compiled.
+ */
+class FusedExpression : public NotCopyable {
+ public:
+  static constexpr size_t kChunkSize = 1024;
+
+  /**
+   * Compiles the expression. Returns nullptr if the expression isn't a function, or any of its
+   * functions isn't vectorized.
+   * @param udfs the UDF instances to run, by UDF id.
+   */
+  static std::unique_ptr<FusedExpression> Compile(
+      ExecState* exec_state, const plan::ScalarExpression& expr,
+      const std::map<int64_t, std::unique_ptr<udf::ScalarUDF>>& udfs);
+
+  types::DataType data_type() const { return data_type_; }
+
+  StatusOr<std::shared_ptr<arrow::Array>> EvaluateToArrow(
+      const table_store::schema::RowBatch& input, udf::FunctionContext* ctx,
+      arrow::MemoryPool* mem_pool);
+
+  StatusOr<types::SharedColumnWrapper> EvaluateToColumnWrapper(
+      const table_store::schema::RowBatch& input, udf::FunctionContext* ctx);
+
+ private:
+  // A value of the expression: an input column, a constant or the result of a function. Each
+  // holds 8 byte native values, except the final result which is written to the output.
+  struct Slot {
+    int64_t col_idx = -1;
+    types::DataType data_type;
+    std::vector<uint64_t> buffer;
+  };
+
+  struct Step {
+    udf::ScalarUDFDefinition* def;
+    udf::ScalarUDF* udf;
+    std::vector<size_t> arg_slots;
+    size_t out_slot;
+  };
+
+  FusedExpression() = default;
+
+  // Returns the slot holding the value of the expression, or an error if it can't be fused.
+  StatusOr<size_t> CompileExpression(
+      ExecState* exec_state, const plan::ScalarExpression& expr,
+      const std::map<int64_t, std::unique_ptr<udf::ScalarUDF>>& udfs);
+
+  // Writes the result for each input row to out, as native values (one byte per BOOLEAN).
+  Status Evaluate(const table_store::schema::RowBatch& input, udf::FunctionContext* ctx,
+                  void* out);
+
+  template <types::DataType TDataType>
+  StatusOr<std::shared_ptr<arrow::Array>> EvaluateToArrowTyped(
+      const table_store::schema::RowBatch& input, udf::FunctionContext* ctx,
+      arrow::MemoryPool* mem_pool);
+
+  std::vector<Slot> slots_;
+  // The functions in the order they run, which is the order of the expression tree post-order.
+  std::vector<Step> steps_;
+  types::DataType data_type_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/fused_expression.h"
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <absl/strings/substitute.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+using types::DataType;
+using udf::FunctionContext;
+
+class VectorizedAddUDF : public udf::ScalarUDF {
+ public:
+  static constexpr bool kVectorized = true;
+
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val + v2.val;
+  }
+};
+
+class VectorizedLessThanUDF : public udf::ScalarUDF {
+ public:
+  static constexpr bool kVectorized = true;
+
+  types::BoolValue Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val < v2.val;
+  }
+};
+
+class AddUDF : public udf::ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val + v2.val;
+  }
+};
+
+// (col0 + (col1 + 1337)) < 5000, with the given id for the inner add.
+constexpr char kNestedLessThanPbtxt[] = R"(
+func {
+  name: "less_than"
+  id: 2
+  args {
+    func {
+      name: "add"
+      args {
+        column {
+          node: 0
+          index: 0
+        }
+      }
+      args {
+        func {
+          name: "add"
+          id: $0
+          args {
+            column {
+              node: 0
+              index: 1
+            }
+          }
+          args {
+            constant {
+              data_type: INT64,
+              int64_value: 1337
+            }
+          }
+        }
+      }
+    }
+  }
+  args {
+    constant {
+      data_type: INT64,
+      int64_value: 5000
+    }
+  }
+})";
+
+class FusedExpressionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    ASSERT_OK(func_registry_->Register<VectorizedAddUDF>("add"));
+    ASSERT_OK(func_registry_->Register<AddUDF>("slow_add"));
+    ASSERT_OK(func_registry_->Register<VectorizedLessThanUDF>("less_than"));
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(),
+                                              std::make_shared<table_store::TableStore>(),
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+    std::vector<DataType> arg_types({DataType::INT64, DataType::INT64});
+    ASSERT_OK(exec_state_->AddScalarUDF(0, "add", arg_types));
+    ASSERT_OK(exec_state_->AddScalarUDF(1, "slow_add", arg_types));
+    ASSERT_OK(exec_state_->AddScalarUDF(2, "less_than", arg_types));
+    for (const auto& [id, def] : exec_state_->id_to_scalar_udf_map()) {
+      udfs_[id] = def->Make();
+    }
+
+    // Spans a few chunks, the last one partial.
+    std::vector<types::Int64Value> in1;
+    std::vector<types::Int64Value> in2;
+    for (int64_t i = 0; i < kNumRows; ++i) {
+      in1.push_back(i);
+      in2.push_back(2 * i);
+    }
+    input_rb_ = std::make_unique<RowBatch>(RowDescriptor({DataType::INT64, DataType::INT64}),
+                                           kNumRows);
+    ASSERT_OK(input_rb_->AddColumn(types::ToArrow(in1, arrow::default_memory_pool())));
+    ASSERT_OK(input_rb_->AddColumn(types::ToArrow(in2, arrow::default_memory_pool())));
+  }
+
+  std::shared_ptr<plan::ScalarExpression> NestedLessThan(int64_t inner_add_id) {
+    planpb::ScalarExpression se_pb;
+    CHECK(google::protobuf::TextFormat::MergeFromString(
+        absl::Substitute(kNestedLessThanPbtxt, inner_add_id), &se_pb));
+    return plan::ScalarExpression::FromProto(se_pb).ConsumeValueOrDie();
+  }
+
+  static constexpr int64_t kNumRows = 2 * FusedExpression::kChunkSize + 100;
+
+  std::unique_ptr<udf::Registry> func_registry_;
+  std::unique_ptr<ExecState> exec_state_;
+  std::map<int64_t, std::unique_ptr<udf::ScalarUDF>> udfs_;
+  std::unique_ptr<RowBatch> input_rb_;
+};
+
+TEST_F(FusedExpressionTest, only_vectorized_funcs_are_fused) {
+  EXPECT_NE(nullptr, FusedExpression::Compile(exec_state_.get(), *NestedLessThan(0), udfs_));
+  EXPECT_EQ(nullptr, FusedExpression::Compile(exec_state_.get(), *NestedLessThan(1), udfs_));
+}
+
+TEST_F(FusedExpressionTest, evaluate) {
+  auto fused = FusedExpression::Compile(exec_state_.get(), *NestedLessThan(0), udfs_);
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ(DataType::BOOLEAN, fused->data_type());
+
+  FunctionContext function_ctx(nullptr, nullptr);
+  ASSERT_OK_AND_ASSIGN(auto arr,
+                       fused->EvaluateToArrow(*input_rb_, &function_ctx,
+                                              arrow::default_memory_pool()));
+  ASSERT_EQ(kNumRows, arr->length());
+  auto casted = static_cast<arrow::BooleanArray*>(arr.get());
+  ASSERT_OK_AND_ASSIGN(auto col, fused->EvaluateToColumnWrapper(*input_rb_, &function_ctx));
+  ASSERT_EQ(kNumRows, col->Size());
+  auto col_values = static_cast<types::BoolValueColumnWrapper*>(col.get());
+  for (int64_t i = 0; i < kNumRows; ++i) {
+    bool expected = i + (2 * i + 1337) < 5000;
+    EXPECT_EQ(expected, casted->Value(i)) << i;
+    EXPECT_EQ(expected, (*col_values)[i].val) << i;
+  }
+}
+
+TEST_F(FusedExpressionTest, evaluator_uses_fused_expressions) {
+  auto fused_expressions = FLAGS_carnot_fused_expressions;
+  FLAGS_carnot_fused_expressions = true;
+
+  for (auto type : {ScalarExpressionEvaluatorType::kVectorNative,
+                    ScalarExpressionEvaluatorType::kArrowNative}) {
+    RowBatch output_rb(RowDescriptor({DataType::BOOLEAN, DataType::BOOLEAN}), kNumRows);
+    FunctionContext function_ctx(nullptr, nullptr);
+    auto evaluator = ScalarExpressionEvaluator::Create({NestedLessThan(0), NestedLessThan(1)},
+                                                       type, &function_ctx);
+    ASSERT_OK(evaluator->Open(exec_state_.get()));
+    ASSERT_OK(evaluator->Evaluate(exec_state_.get(), *input_rb_, &output_rb));
+    ASSERT_OK(evaluator->Close(exec_state_.get()));
+
+    // The fused and the unfused expressions agree.
+    auto fused = static_cast<arrow::BooleanArray*>(output_rb.ColumnAt(0).get());
+    auto unfused = static_cast<arrow::BooleanArray*>(output_rb.ColumnAt(1).get());
+    ASSERT_EQ(kNumRows, fused->length());
+    for (int64_t i = 0; i < kNumRows; ++i) {
+      EXPECT_EQ(unfused->Value(i), fused->Value(i)) << i;
+    }
+  }
+
+  FLAGS_carnot_fused_expressions = fused_expressions;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/group_key.h"
+
+#include <arrow/builder.h>
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "src/carnot/exec/hash_kernels.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+
+// Returns the number of words a value of the data type takes in a GroupKey, or -1 if the type
+// is not stored in the words.
+int NumWords(types::DataType data_type) {
+  switch (data_type) {
+    case types::DataType::BOOLEAN:
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+    case types::DataType::FLOAT64:
+      return 1;
+    case types::DataType::UINT128:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+inline void AddWord(GroupKeyView* key, size_t offset, uint64_t word) {
+  key->words[offset] = word;
+}
+
+template <typename TArray, typename TToWord>
+void ExtractWords(const arrow::Array* col, int64_t num_rows, size_t offset, TToWord to_word,
+                  std::vector<GroupKeyView>* keys) {
+  auto arr = static_cast<const TArray*>(col);
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    AddWord(&(*keys)[row_idx], offset, to_word(arr->Value(row_idx)));
+  }
+}
+
+// The rows of dictionary-encoded strings only look up their code.
+void ExtractDictionaryStrings(const arrow::Array* col, int64_t num_rows,
+                              std::vector<GroupKeyView>* keys) {
+  auto dict_arr = static_cast<const arrow::DictionaryArray*>(col);
+  auto codes = static_cast<const arrow::Int32Array*>(dict_arr->indices().get());
+  auto values = static_cast<const arrow::StringArray*>(dict_arr->dictionary().get());
+
+  std::vector<std::string_view> distinct_strs(values->length());
+  for (int64_t i = 0; i < values->length(); ++i) {
+    int32_t len = 0;
+    const uint8_t* data = values->GetValue(i, &len);
+    distinct_strs[i] = std::string_view(reinterpret_cast<const char*>(data), len);
+  }
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    (*keys)[row_idx].str = distinct_strs[codes->Value(row_idx)];
+  }
+}
+
+}  // namespace
+
+bool GroupKeyLayout::Supports(const std::vector<types::DataType>& data_types) {
+  size_t num_words = 0;
+  size_t num_strings = 0;
+  for (const auto& data_type : data_types) {
+    if (data_type == types::DataType::STRING) {
+      ++num_strings;
+      continue;
+    }
+    int words = NumWords(data_type);
+    if (words < 0) {
+      return false;
+    }
+    num_words += words;
+  }
+  return num_words <= kMaxGroupKeyWords && num_strings <= 1;
+}
+
+GroupKeyLayout::GroupKeyLayout(const std::vector<types::DataType>& data_types)
+    : data_types_(data_types) {
+  DCHECK(Supports(data_types));
+  size_t offset = 0;
+  for (const auto& data_type : data_types_) {
+    word_offsets_.push_back(offset);
+    if (data_type != types::DataType::STRING) {
+      offset += NumWords(data_type);
+    }
+  }
+}
+
+void GroupKeyLayout::ExtractKeys(const std::vector<const arrow::Array*>& cols, int64_t num_rows,
+                                 std::vector<GroupKeyView>* keys) const {
+  DCHECK_EQ(cols.size(), data_types_.size());
+  keys->assign(num_rows, GroupKeyView{});
+  for (size_t col_idx = 0; col_idx < cols.size(); ++col_idx) {
+    const arrow::Array* col = cols[col_idx];
+    DCHECK_GE(col->length(), num_rows);
+    size_t offset = word_offsets_[col_idx];
+    switch (data_types_[col_idx]) {
+      case types::DataType::BOOLEAN:
+        ExtractWords<arrow::BooleanArray>(
+            col, num_rows, offset, [](bool v) { return static_cast<uint64_t>(v); }, keys);
+        break;
+      case types::DataType::INT64:
+      case types::DataType::TIME64NS:
+        ExtractWords<arrow::Int64Array>(
+            col, num_rows, offset, [](int64_t v) { return static_cast<uint64_t>(v); }, keys);
+        break;
+      case types::DataType::FLOAT64:
+        // Doubles are compared bitwise, the same way RowTuple compares them.
+        ExtractWords<arrow::DoubleArray>(col, num_rows, offset, DoubleToWord, keys);
+        break;
+      case types::DataType::UINT128: {
+        auto arr = static_cast<const arrow::UInt128Array*>(col);
+        for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+          absl::uint128 val = arr->Value(row_idx);
+          auto* key = &(*keys)[row_idx];
+          AddWord(key, offset, absl::Uint128High64(val));
+          AddWord(key, offset + 1, absl::Uint128Low64(val));
+        }
+        break;
+      }
+      case types::DataType::STRING: {
+        if (types::IsDictionaryArray(*col)) {
+          ExtractDictionaryStrings(col, num_rows, keys);
+          break;
+        }
+        auto arr = static_cast<const arrow::StringArray*>(col);
+        for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+          int32_t len = 0;
+          const uint8_t* data = arr->GetValue(row_idx, &len);
+          (*keys)[row_idx].str = std::string_view(reinterpret_cast<const char*>(data), len);
+        }
+        break;
+      }
+      default:
+        LOG(DFATAL) << "Unsupported group key type: " << types::ToString(data_types_[col_idx]);
+    }
+  }
+
+  std::vector<uint64_t> hashes;
+  HashColumns(cols, data_types_, num_rows, &hashes);
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    (*keys)[row_idx].hash = hashes[row_idx];
+  }
+}
+
+Status GroupKeyLayout::AppendToBuilders(
+    const GroupKey& key, const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders) const {
+  DCHECK_EQ(builders.size(), data_types_.size());
+  for (size_t col_idx = 0; col_idx < data_types_.size(); ++col_idx) {
+    arrow::ArrayBuilder* builder = builders[col_idx].get();
+    size_t offset = word_offsets_[col_idx];
+    switch (data_types_[col_idx]) {
+      case types::DataType::BOOLEAN:
+        PL_RETURN_IF_ERROR(
+            static_cast<arrow::BooleanBuilder*>(builder)->Append(key.words[offset] != 0));
+        break;
+      case types::DataType::INT64:
+      case types::DataType::TIME64NS:
+        PL_RETURN_IF_ERROR(static_cast<arrow::Int64Builder*>(builder)->Append(
+            static_cast<int64_t>(key.words[offset])));
+        break;
+      case types::DataType::FLOAT64: {
+        double val;
+        std::memcpy(&val, &key.words[offset], sizeof(val));
+        PL_RETURN_IF_ERROR(static_cast<arrow::DoubleBuilder*>(builder)->Append(val));
+        break;
+      }
+      case types::DataType::UINT128: {
+        PL_RETURN_IF_ERROR(static_cast<arrow::UInt128Builder*>(builder)->Append(
+            absl::MakeUint128(key.words[offset], key.words[offset + 1])));
+        break;
+      }
+      case types::DataType::STRING:
+        PL_RETURN_IF_ERROR(static_cast<arrow::StringBuilder*>(builder)->Append(key.str));
+        break;
+      default:
+        return error::Internal("Unsupported group key type: $0",
+                               types::ToString(data_types_[col_idx]));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/array/builder_base.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+// The number of 64-bit words a group key holds inline, eg. a UPID plus two int64 keys.
+constexpr size_t kMaxGroupKeyWords = 4;
+
+/**
+ * A group key made of fixed-width values and at most one string. Each fixed-width value is
+ * stored in one word (two for UINT128). The hash is computed once, when the key is extracted.
+ *
+ * GroupKey owns its string and is what the hash map stores. GroupKeyView points into the
+ * input arrow array and is used for the lookups.
+ */
+template <typename TString>
+struct GroupKeyBase {
+  uint64_t hash = 0;
+  std::array<uint64_t, kMaxGroupKeyWords> words{};
+  TString str;
+};
+
+using GroupKey = GroupKeyBase<std::string>;
+using GroupKeyView = GroupKeyBase<std::string_view>;
+
+struct GroupKeyHasher {
+  using is_transparent = void;
+  template <typename TString>
+  size_t operator()(const GroupKeyBase<TString>& k) const {
+    return k.hash;
+  }
+};
+
+struct GroupKeyEq {
+  using is_transparent = void;
+  template <typename TString1, typename TString2>
+  bool operator()(const GroupKeyBase<TString1>& k1, const GroupKeyBase<TString2>& k2) const {
+    return k1.hash == k2.hash && k1.words == k2.words &&
+           std::string_view(k1.str) == std::string_view(k2.str);
+  }
+};
+
+template <class T>
+using GroupKeyHashMap = absl::flat_hash_map<GroupKey, T, GroupKeyHasher, GroupKeyEq>;
+
+/**
+ * GroupKeyLayout describes where each group column is stored in a GroupKey.
+ */
+class GroupKeyLayout {
+ public:
+  /**
+   * @return true if group columns of the given types fit in a GroupKey.
+   */
+  static bool Supports(const std::vector<types::DataType>& data_types);
+
+  explicit GroupKeyLayout(const std::vector<types::DataType>& data_types);
+
+  /**
+   * Extracts the keys of all the rows of a batch. This runs one column at a time, so the values
+   * and the hashes are computed in tight loops over each arrow array. The hashes are those of
+   * HashColumns(), the same as of the RowTuples with the same values.
+   *
+   * The returned views reference the string data of the arrays, so they are only valid as long
+   * as the arrays are.
+   */
+  void ExtractKeys(const std::vector<const arrow::Array*>& cols, int64_t num_rows,
+                   std::vector<GroupKeyView>* keys) const;
+
+  /**
+   * Appends the values of the key to the builders, one builder per group column.
+   */
+  Status AppendToBuilders(const GroupKey& key,
+                          const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders) const;
+
+ private:
+  std::vector<types::DataType> data_types_;
+  // The index of the first word of each column in GroupKey::words. Unused for the string column.
+  std::vector<size_t> word_offsets_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/carnot/exec/group_key.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using types::DataType;
+
+TEST(GroupKeyLayout, supports) {
+  EXPECT_TRUE(GroupKeyLayout::Supports({DataType::UINT128, DataType::STRING}));
+  EXPECT_TRUE(GroupKeyLayout::Supports(
+      {DataType::UINT128, DataType::TIME64NS, DataType::INT64, DataType::STRING}));
+  EXPECT_TRUE(GroupKeyLayout::Supports({DataType::BOOLEAN, DataType::FLOAT64}));
+  // Too many words.
+  EXPECT_FALSE(GroupKeyLayout::Supports({DataType::UINT128, DataType::UINT128, DataType::INT64}));
+  // More than one string.
+  EXPECT_FALSE(GroupKeyLayout::Supports({DataType::STRING, DataType::STRING}));
+}
+
+TEST(GroupKeyLayout, extract_and_append) {
+  std::vector<DataType> data_types = {DataType::UINT128, DataType::STRING, DataType::INT64};
+  GroupKeyLayout layout(data_types);
+
+  auto upids = types::ToArrow(std::vector<types::UInt128Value>{{1, 2}, {1, 2}, {1, 2}, {2, 1}},
+                              arrow::default_memory_pool());
+  auto paths = types::ToArrow(std::vector<types::StringValue>{"/a", "/a", "/b", "/a"},
+                              arrow::default_memory_pool());
+  auto ints =
+      types::ToArrow(std::vector<types::Int64Value>{-1, -1, -1, -1}, arrow::default_memory_pool());
+
+  std::vector<GroupKeyView> keys;
+  layout.ExtractKeys({upids.get(), paths.get(), ints.get()}, 4, &keys);
+  ASSERT_EQ(4, keys.size());
+
+  GroupKeyEq eq;
+  EXPECT_TRUE(eq(keys[0], keys[1]));
+  EXPECT_EQ(keys[0].hash, keys[1].hash);
+  EXPECT_FALSE(eq(keys[0], keys[2]));
+  EXPECT_FALSE(eq(keys[0], keys[3]));
+
+  GroupKey owned{keys[2].hash, keys[2].words, std::string(keys[2].str)};
+  EXPECT_TRUE(eq(owned, keys[2]));
+  EXPECT_EQ(GroupKeyHasher()(owned), GroupKeyHasher()(keys[2]));
+
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+  for (const auto& data_type : data_types) {
+    builders.push_back(types::MakeArrowBuilder(data_type, arrow::default_memory_pool()));
+  }
+  EXPECT_OK(layout.AppendToBuilders(owned, builders));
+
+  std::shared_ptr<arrow::Array> arr;
+  ASSERT_TRUE(builders[0]->Finish(&arr).ok());
+  EXPECT_EQ(absl::MakeUint128(1, 2), static_cast<arrow::UInt128Array*>(arr.get())->Value(0));
+  ASSERT_TRUE(builders[1]->Finish(&arr).ok());
+  EXPECT_EQ("/b", static_cast<arrow::StringArray*>(arr.get())->GetString(0));
+  ASSERT_TRUE(builders[2]->Finish(&arr).ok());
+  EXPECT_EQ(-1, static_cast<arrow::Int64Array*>(arr.get())->Value(0));
+}
+
+TEST(GroupKeyLayout, dictionary_strings) {
+  GroupKeyLayout layout({DataType::INT64, DataType::STRING});
+  auto ints = types::ToArrow(std::vector<types::Int64Value>{1, 1, 2}, arrow::default_memory_pool());
+  auto paths = types::ToArrow(std::vector<types::StringValue>{"/a", "/b", "/a"},
+                              arrow::default_memory_pool());
+
+  arrow::Int32Builder codes_builder;
+  for (int32_t code : {1, 0, 1}) {
+    ASSERT_TRUE(codes_builder.Append(code).ok());
+  }
+  std::shared_ptr<arrow::Array> codes;
+  ASSERT_TRUE(codes_builder.Finish(&codes).ok());
+  auto dict_values =
+      types::ToArrow(std::vector<types::StringValue>{"/b", "/a"}, arrow::default_memory_pool());
+  auto dict_paths = types::MakeDictionaryStringArray(codes, dict_values);
+
+  std::vector<GroupKeyView> keys;
+  layout.ExtractKeys({ints.get(), paths.get()}, 3, &keys);
+  std::vector<GroupKeyView> dict_keys;
+  layout.ExtractKeys({ints.get(), dict_paths.get()}, 3, &dict_keys);
+
+  // The keys don't depend on how the strings are encoded.
+  GroupKeyEq eq;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(eq(keys[i], dict_keys[i]));
+    EXPECT_EQ(keys[i].hash, dict_keys[i].hash);
+  }
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -34,12 +34,19 @@ namespace px {
 namespace carnot {
 namespace exec {
 
-Status GRPCRouter::EnqueueRowBatch(sole::uuid query_id,
-                                   std::unique_ptr<carnotpb::TransferResultChunkRequest> req) {
+namespace {
+// How often a stream that waits for room in the budget of its source checks for cancellation.
+constexpr std::chrono::milliseconds kBudgetWaitInterval{100};
+}  // namespace
+
+Status GRPCRouter::EnqueueRowBatch(sole::uuid query_id, ResultChunkPtr req,
+                                   std::shared_ptr<ResultQueueBudget>* budget,
+                                   bool* source_done) {
   absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
   auto& query_map = query_node_map_[query_id];
 
-  if (!req->has_query_result() || !req->query_result().has_row_batch() ||
+  if (!req->has_query_result() ||
+      (!req->query_result().has_row_batch() && !req->query_result().has_arrow_row_batch()) ||
       req->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
     return error::Internal(
@@ -49,6 +56,12 @@ Status GRPCRouter::EnqueueRowBatch(sole::uuid query_id,
 
   SourceNodeTracker& snt = query_map.source_node_trackers[req->query_result().grpc_source_id()];
   absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+  *budget = snt.budget;
+  *source_done = snt.source_done;
+  if (snt.source_done) {
+    return Status::OK();
+  }
+  snt.budget->Add(req->ByteSizeLong());
   // It's possible that we see row batches before we have gotten information about the query. To
   // solve this race, We store a backlog of all the pending batches.
   if (snt.source_node == nullptr) {
@@ -119,7 +132,7 @@ void GRPCRouter::MarkResultStreamContextAsComplete(sole::uuid query_id,
     ::grpc::ServerReader<::px::carnotpb::TransferResultChunkRequest>* reader,
     ::px::carnotpb::TransferResultChunkResponse* response) {
   PL_UNUSED(context);
-  auto rb = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  ResultChunkPtr rb = NewResultChunk();
 
   // If this is a query result stream, these are used to track whether or not this particular
   // result stream has been closed so that downstream operators on the corresponding
@@ -153,12 +166,25 @@ void GRPCRouter::MarkResultStreamContextAsComplete(sole::uuid query_id,
                            absl::Substitute("Failed to record stats w/ err: $0", s.msg()));
         break;
       }
-    } else if (rb->has_query_result() && rb->query_result().has_row_batch()) {
-      auto s = EnqueueRowBatch(query_id, std::move(rb));
+    } else if (rb->has_query_result() && (rb->query_result().has_row_batch() ||
+                                          rb->query_result().has_arrow_row_batch())) {
+      std::shared_ptr<ResultQueueBudget> budget;
+      bool source_done = false;
+      auto s = EnqueueRowBatch(query_id, std::move(rb), &budget, &source_done);
       if (!s.ok()) {
         result_status = ::grpc::Status(grpc::StatusCode::INTERNAL, "failed to enqueue batch");
         break;
       }
+      if (source_done) {
+        // End the stream early, so that the agent sending it stops executing.
+        MarkResultStreamContextAsComplete(query_id, context);
+        response->set_success(true);
+        response->set_destination_done(true);
+        return ::grpc::Status::OK;
+      }
+      // Stop reading the stream while the source is behind, see ResultQueueBudget.
+      while (!budget->WaitForRoom(kBudgetWaitInterval) && !context->IsCancelled()) {
+      }
     } else if (rb->has_query_result() && rb->query_result().initiate_result_stream()) {
       if (rb->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
@@ -183,7 +209,7 @@ void GRPCRouter::MarkResultStreamContextAsComplete(sole::uuid query_id,
       break;
     }
 
-    rb = std::make_unique<carnotpb::TransferResultChunkRequest>();
+    rb = NewResultChunk();
   }
 
   if (!result_status.ok()) {
@@ -235,6 +261,7 @@ Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
   }
   absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
   snt->source_node = source_node;
+  source_node->set_queue_budget(snt->budget);
   if (snt->connection_initiated_by_sink) {
     source_node->set_upstream_initiated_connection();
   }
@@ -282,10 +309,78 @@ Status GRPCRouter::DeleteGRPCSourceNode(sole::uuid query_id, int64_t source_id)
     return error::Internal("Query map for query ID $0 does not contain GRPC source $1",
                            query_id.str(), source_id);
   }
+  it->second.budget->Close();
   query_map.source_node_trackers.erase(it);
   return Status::OK();
 }
 
+Status GRPCRouter::MarkSourceDone(sole::uuid query_id, int64_t source_id) {
+  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+  auto it = query_node_map_.find(query_id);
+  if (it == query_node_map_.end()) {
+    return error::Internal("No query ID $0 found in the GRPCRouter", query_id.str());
+  }
+  auto snt_it = it->second.source_node_trackers.find(source_id);
+  if (snt_it == it->second.source_node_trackers.end()) {
+    return error::Internal("Query map for query ID $0 does not contain GRPC source $1",
+                           query_id.str(), source_id);
+  }
+  SourceNodeTracker& snt = snt_it->second;
+  absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+  snt.source_done = true;
+  snt.response_backlog.clear();
+  // Wakes up any stream waiting for room, so that it reads its next batch and ends.
+  snt.budget->Close();
+  return Status::OK();
+}
+
+::grpc::Status GRPCRouter::GetJoinFilter(::grpc::ServerContext*,
+                                         const carnotpb::GetJoinFilterRequest* request,
+                                         carnotpb::GetJoinFilterResponse* response) {
+  auto query_id_or_s = px::ParseUUID(request->query_id());
+  if (!query_id_or_s.ok()) {
+    return ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "invalid query ID");
+  }
+  auto query_id = query_id_or_s.ConsumeValueOrDie();
+  std::shared_ptr<const carnotpb::GetJoinFilterResponse> filter;
+  {
+    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+    auto it = query_node_map_.find(query_id);
+    if (it != query_node_map_.end()) {
+      auto filter_it = it->second.join_filters.find(request->filter_id());
+      if (filter_it != it->second.join_filters.end()) {
+        filter = filter_it->second;
+      }
+    }
+  }
+  // The filter is copied outside of the lock, since it can be large.
+  if (filter == nullptr) {
+    response->set_ready(false);
+  } else {
+    *response = *filter;
+  }
+  return ::grpc::Status::OK;
+}
+
+void GRPCRouter::PublishJoinFilter(sole::uuid query_id, int64_t filter_id,
+                                   bloomfilter::XXHash64BloomFilter* filter) {
+  auto response = std::make_shared<carnotpb::GetJoinFilterResponse>();
+  response->set_ready(true);
+  if (filter == nullptr) {
+    response->set_disabled(true);
+  } else {
+    *response->mutable_filter() = filter->ToProto();
+  }
+  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+  // The query may already be deleted, in which case nobody asks for the filter anymore.
+  auto it = query_node_map_.find(query_id);
+  if (it == query_node_map_.end()) {
+    VLOG(1) << "Dropping join filter of unknown query: " << query_id.str();
+    return;
+  }
+  it->second.join_filters[filter_id] = std::move(response);
+}
+
 void GRPCRouter::DeleteQuery(sole::uuid query_id) {
   absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
   VLOG(1) << "Deleting query ID from GRPC Router: " << query_id.str();
@@ -299,6 +394,9 @@ void GRPCRouter::DeleteQuery(sole::uuid query_id) {
   for (auto ctx : query_node_map_[query_id].active_agent_contexts) {
     ctx->TryCancel();
   }
+  for (auto& [source_id, snt] : it->second.source_node_trackers) {
+    snt.budget->Close();
+  }
   query_node_map_.erase(it);
 }
 
@@ -35,8 +35,10 @@
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
 #include "src/carnot/carnotpb/carnot.pb.h"
+#include "src/carnot/exec/result_queue_budget.h"
 #include "src/common/base/base.h"
 #include "src/common/uuid/uuid.h"
+#include "src/shared/bloomfilter/bloomfilter.h"
 
 namespace px {
 namespace carnot {
@@ -59,6 +61,21 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
       ::grpc::ServerReader<::px::carnotpb::TransferResultChunkRequest>* reader,
       ::px::carnotpb::TransferResultChunkResponse* response) override;
 
+  /**
+   * GetJoinFilter implements the RPC method. Responds with ready unset until the join publishes
+   * its filter.
+   */
+  ::grpc::Status GetJoinFilter(::grpc::ServerContext* context,
+                               const ::px::carnotpb::GetJoinFilterRequest* request,
+                               ::px::carnotpb::GetJoinFilterResponse* response) override;
+
+  /**
+   * Publishes the filter of the build side keys of a join, for the agents that send its probe
+   * side. A null filter tells them that the join doesn't have one.
+   */
+  void PublishJoinFilter(sole::uuid query_id, int64_t filter_id,
+                         bloomfilter::XXHash64BloomFilter* filter);
+
   /**
    * Adds the specified source node to the router. Includes a function that should be called to
    * retrigger execution of the graph if currently yielded.
@@ -79,6 +96,13 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
    */
   Status DeleteGRPCSourceNode(sole::uuid query_id, int64_t source_id);
 
+  /**
+   * Marks a source node as not needing any more data, eg. because a downstream limit has been
+   * reached. The streams sending to it are ended with destination_done set, which tells the
+   * producing agents to stop executing, and any further batches for it are dropped.
+   */
+  Status MarkSourceDone(sole::uuid query_id, int64_t source_id);
+
   /**
    * @brief Get the Exec stats from the agents that are clients to this GRPC and the query_id.
    *
@@ -99,8 +123,10 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
                      const std::vector<queryresultspb::AgentExecutionStats>& stats);
 
  private:
-  Status EnqueueRowBatch(sole::uuid query_id,
-                         std::unique_ptr<carnotpb::TransferResultChunkRequest> req);
+  // Also returns the budget of the source in budget, so that the caller can wait for room in it.
+  // Sets source_done, and drops the batch, if the source doesn't need any more data.
+  Status EnqueueRowBatch(sole::uuid query_id, ResultChunkPtr req,
+                         std::shared_ptr<ResultQueueBudget>* budget, bool* source_done);
 
   Status MarkResultStreamInitiated(sole::uuid query_id, int64_t source_id);
   Status MarkResultStreamClosed(sole::uuid query_id, int64_t source_id);
@@ -116,8 +142,11 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     GRPCSourceNode* source_node GUARDED_BY(node_lock) = nullptr;
     bool connection_initiated_by_sink GUARDED_BY(node_lock) = false;
     bool connection_closed_by_sink GUARDED_BY(node_lock) = false;
-    std::vector<std::unique_ptr<::px::carnotpb::TransferResultChunkRequest>> response_backlog
-        GUARDED_BY(node_lock);
+    bool source_done GUARDED_BY(node_lock) = false;
+    std::vector<ResultChunkPtr> response_backlog GUARDED_BY(node_lock);
+    // Covers the backlog as well as the queue of the source node.
+    std::shared_ptr<ResultQueueBudget> budget =
+        std::make_shared<ResultQueueBudget>(FLAGS_carnot_grpc_source_max_queued_bytes);
     absl::base_internal::SpinLock node_lock;
   };
 
@@ -134,6 +163,9 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     absl::flat_hash_set<::grpc::ServerContext*> active_agent_contexts;
     // The execution stats for agents that are clients to this service.
     std::vector<queryresultspb::AgentExecutionStats> agent_exec_stats;
+    // The published join filters, by filter ID, as the responses to GetJoinFilter.
+    absl::flat_hash_map<int64_t, std::shared_ptr<const carnotpb::GetJoinFilterResponse>>
+        join_filters;
   };
 
   absl::node_hash_map<sole::uuid, QueryTracker> query_node_map_ GUARDED_BY(query_node_map_lock_);
@@ -41,6 +41,7 @@
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 #include "src/common/testing/testing.h"
+#include "src/common/uuid/uuid_utils.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/types.h"
 #include "src/table_store/schemapb/schema.pb.h"
@@ -81,13 +82,13 @@ class GRPCRouterTest : public ::testing::Test {
 
 class FakeGRPCSourceNode : public px::carnot::exec::GRPCSourceNode {
  public:
-  Status EnqueueRowBatch(std::unique_ptr<px::carnotpb::TransferResultChunkRequest> row_batch) {
+  Status EnqueueRowBatch(ResultChunkPtr row_batch) override {
     row_batches.emplace_back(std::move(row_batch));
 
     return Status::OK();
   }
 
-  std::vector<std::unique_ptr<px::carnotpb::TransferResultChunkRequest>> row_batches;
+  std::vector<ResultChunkPtr> row_batches;
 };
 
 TEST_F(GRPCRouterTest, no_node_router_test) {
@@ -353,6 +354,88 @@ TEST_F(GRPCRouterTest, done_query_test) {
   service_->DeleteQuery(query_uuid);
 }
 
+TEST_F(GRPCRouterTest, join_filter_of_deleted_query) {
+  int64_t grpc_source_node_id = 1;
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::BOOLEAN});
+  auto query_uuid = sole::rebuild("ea8aa095-697f-49f1-b127-d50e5b6e2645");
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto source_node = FakeGRPCSourceNode();
+  ASSERT_OK(source_node.Init(*plan_node, input_rd, {}));
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, grpc_source_node_id, &source_node, [] {}));
+
+  carnotpb::GetJoinFilterRequest req;
+  ToProto(query_uuid, req.mutable_query_id());
+  req.set_filter_id(1);
+  carnotpb::GetJoinFilterResponse resp;
+  {
+    grpc::ClientContext context;
+    ASSERT_TRUE(stub_->GetJoinFilter(&context, req, &resp).ok());
+    EXPECT_FALSE(resp.ready());
+  }
+
+  service_->PublishJoinFilter(query_uuid, /* filter_id */ 1, /* filter */ nullptr);
+  {
+    grpc::ClientContext context;
+    ASSERT_TRUE(stub_->GetJoinFilter(&context, req, &resp).ok());
+    EXPECT_TRUE(resp.ready());
+    EXPECT_TRUE(resp.disabled());
+  }
+
+  // A filter published once the query is gone doesn't bring it back.
+  service_->DeleteQuery(query_uuid);
+  service_->PublishJoinFilter(query_uuid, /* filter_id */ 1, /* filter */ nullptr);
+  {
+    grpc::ClientContext context;
+    ASSERT_TRUE(stub_->GetJoinFilter(&context, req, &resp).ok());
+    EXPECT_FALSE(resp.ready());
+  }
+}
+
+TEST_F(GRPCRouterTest, source_done_ends_stream) {
+  int64_t grpc_source_node_id = 1;
+  uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
+  auto query_uuid = sole::rebuild(ab, cd);
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto source_node = FakeGRPCSourceNode();
+  ASSERT_OK(source_node.Init(*plan_node, input_rd, {}));
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, grpc_source_node_id, &source_node, [] {}));
+
+  auto rb = RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>({1, 2})
+                .get();
+  carnotpb::TransferResultChunkRequest rb_req;
+  EXPECT_OK(rb.ToProto(rb_req.mutable_query_result()->mutable_row_batch()));
+  rb_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  rb_req.mutable_query_id()->set_high_bits(ab);
+  rb_req.mutable_query_id()->set_low_bits(cd);
+
+  carnotpb::TransferResultChunkResponse response;
+  grpc::ClientContext context;
+  auto writer = stub_->TransferResultChunk(&context, &response);
+  ASSERT_TRUE(writer->Write(rb_req));
+
+  ASSERT_OK(service_->MarkSourceDone(query_uuid, grpc_source_node_id));
+  EXPECT_NOT_OK(service_->MarkSourceDone(query_uuid, grpc_source_node_id + 1));
+
+  // The stream ends on the next batch, without passing it on to the source.
+  while (writer->Write(rb_req)) {
+  }
+  auto status = writer->Finish();
+  ASSERT_TRUE(status.ok());
+  EXPECT_TRUE(response.success());
+  EXPECT_TRUE(response.destination_done());
+  EXPECT_EQ(1, source_node.row_batches.size());
+
+  service_->DeleteQuery(query_uuid);
+}
+
 // This test is a TSAN test. IT should be run enough times so that all possible
 // race conditions will be met.
 TEST_F(GRPCRouterTest, threaded_router_test) {
@@ -22,12 +22,19 @@
 #include <vector>
 
 #include <absl/strings/substitute.h>
+#include <google/protobuf/arena.h>
 
+#include "src/carnot/exec/join_filter.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/macros.h"
 #include "src/common/uuid/uuid_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_bool(grpc_sink_arrow_row_batches,
+            gflags::BoolFromEnv("PL_GRPC_SINK_ARROW_ROW_BATCHES", false),
+            "Whether GRPC sinks send row batches to other Carnot instances as raw arrow buffers "
+            "instead of per-value RowBatchData protos.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -64,8 +71,36 @@ StatusOr<carnotpb::TransferResultChunkRequest> RequestWithMetadata(
   return req;
 }
 
+Status GRPCSinkNode::SerializeRowBatch(const RowBatch& rb,
+                                       carnotpb::TransferResultChunkRequest* req) {
+  // The query broker only reads RowBatchData, so the arrow buffers are limited to Carnot
+  // destinations.
+  if (FLAGS_grpc_sink_arrow_row_batches && plan_node_->has_grpc_source_id()) {
+    return rb.ToArrowProto(req->mutable_query_result()->mutable_arrow_row_batch());
+  }
+  return rb.ToProto(req->mutable_query_result()->mutable_row_batch());
+}
+
+Status GRPCSinkNode::HandleFailedWrite(ExecState* exec_state) {
+  cancelled_ = true;
+  // The destination ends the stream early, with destination_done set, once it doesn't need any
+  // more results (eg. a limit was reached). Finish picks up that response.
+  auto s = writer_->Finish();
+  if (s.ok() && response_.destination_done()) {
+    LOG(INFO) << absl::Substitute(
+        "GRPCSinkNode $0 of query $1: destination $2 doesn't need any more results",
+        plan_node_->id(), exec_state->query_id().str(), plan_node_->address());
+    destination_done_ = true;
+    return Status::OK();
+  }
+  return error::Cancelled(
+      "GRPCSinkNode $0 of query $1 could not write result to address: $2, stream closed by "
+      "server",
+      exec_state->query_id().str(), plan_node_->id(), plan_node_->address());
+}
+
 Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
-  if (sent_eos_) {
+  if (sent_eos_ || destination_done_) {
     return Status::OK();
   }
 
@@ -80,13 +115,10 @@ Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
   PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
   PL_ASSIGN_OR_RETURN(auto rb,
                       RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false, /* eos */ false));
-  PL_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
+  PL_RETURN_IF_ERROR(SerializeRowBatch(*rb, &req));
 
   if (!writer_->Write(req)) {
-    return error::Cancelled(
-        "GRPCSinkNode $0 of query $1 could not write result to address: $2, stream closed by "
-        "server",
-        exec_state->query_id().str(), plan_node_->id(), plan_node_->address());
+    return HandleFailedWrite(exec_state);
   }
 
   last_send_time_ = time_now;
@@ -103,6 +135,22 @@ Status GRPCSinkNode::InitImpl(const plan::Operator& plan_node) {
   input_descriptor_ = std::make_unique<RowDescriptor>(input_descriptors_[0]);
   const auto* sink_plan_node = static_cast<const plan::GRPCSinkOperator*>(&plan_node);
   plan_node_ = std::make_unique<plan::GRPCSinkOperator>(*sink_plan_node);
+  if (plan_node_->has_join_filter()) {
+    join_filter_pending_ = true;
+    for (auto idx : plan_node_->join_filter().key_column_indexes()) {
+      join_filter_key_indices_.push_back(idx);
+    }
+  }
+  if (plan_node_->has_partition()) {
+    const auto& partition = plan_node_->partition();
+    if (partition.partition_index() >= partition.num_partitions()) {
+      return error::InvalidArgument("GRPCSink partition $0 is out of range, only $1 partitions",
+                                    partition.partition_index(), partition.num_partitions());
+    }
+    for (auto idx : partition.key_column_indexes()) {
+      partition_key_indices_.push_back(idx);
+    }
+  }
   return Status::OK();
 }
 
@@ -149,6 +197,18 @@ Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
 }
 
 Status GRPCSinkNode::CloseImpl(ExecState* exec_state) {
+  CancelJoinFilterFetch();
+  stats()->AddExtraMetric(
+      "write_time_ms", std::chrono::duration_cast<std::chrono::milliseconds>(write_time_).count());
+  if (plan_node_->has_join_filter()) {
+    stats()->AddExtraMetric("join_filter_dropped_rows", join_filter_dropped_rows_);
+  }
+  if (plan_node_->has_partition()) {
+    stats()->AddExtraMetric("partition_skipped_rows", partition_skipped_rows_);
+  }
+  if (forwarded_rows_ > 0) {
+    stats()->AddExtraMetric("forwarded_rows", forwarded_rows_);
+  }
   if (sent_eos_) {
     return Status::OK();
   }
@@ -181,7 +241,7 @@ Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb
   for (int64_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
     PL_ASSIGN_OR_RETURN(std::unique_ptr<RowBatch> output_rb,
                         rb.Slice(batch_idx * main_rb_rows, main_rb_rows));
-    PL_RETURN_IF_ERROR(ConsumeNextImpl(exec_state, *output_rb, parent_idx));
+    PL_RETURN_IF_ERROR(WriteBatch(exec_state, *output_rb, parent_idx));
   }
 
   // Handle the final batch.
@@ -189,29 +249,184 @@ Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb
                       rb.Slice(rb.num_rows() - leftover_rb_rows, leftover_rb_rows));
   output_rb->set_eos(rb.eos());
   output_rb->set_eow(rb.eow());
-  return ConsumeNextImpl(exec_state, *output_rb, parent_idx);
+  return WriteBatch(exec_state, *output_rb, parent_idx);
+}
+
+void GRPCSinkNode::OptionallyFetchJoinFilter(ExecState* exec_state) {
+  if (join_filter_fetch_ != nullptr) {
+    void* tag;
+    bool ok;
+    // Polls the queue, the exec thread never waits for the destination.
+    auto next = join_filter_cq_.AsyncNext(&tag, &ok, std::chrono::system_clock::now());
+    if (next != grpc::CompletionQueue::GOT_EVENT) {
+      return;
+    }
+    DCHECK_EQ(tag, join_filter_fetch_.get());
+    auto fetch = std::move(join_filter_fetch_);
+    HandleJoinFilterResponse(fetch->status, fetch->response);
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_join_filter_fetch_) {
+    return;
+  }
+  next_join_filter_fetch_ = now + kJoinFilterFetchInterval;
+
+  carnotpb::GetJoinFilterRequest req;
+  ToProto(exec_state->query_id(), req.mutable_query_id());
+  req.set_filter_id(plan_node_->join_filter().filter_id());
+  auto fetch = std::make_unique<JoinFilterFetch>();
+  fetch->context.set_deadline(std::chrono::system_clock::now() + kJoinFilterFetchTimeout);
+  fetch->rpc = stub_->AsyncGetJoinFilter(&fetch->context, req, &join_filter_cq_);
+  if (fetch->rpc == nullptr) {
+    return;
+  }
+  fetch->rpc->Finish(&fetch->response, &fetch->status, fetch.get());
+  join_filter_fetch_ = std::move(fetch);
+}
+
+void GRPCSinkNode::CancelJoinFilterFetch() {
+  if (join_filter_fetch_ != nullptr) {
+    join_filter_fetch_->context.TryCancel();
+  }
+  join_filter_cq_.Shutdown();
+  void* tag;
+  bool ok;
+  while (join_filter_cq_.Next(&tag, &ok)) {
+  }
+  join_filter_fetch_.reset();
+}
+
+void GRPCSinkNode::HandleJoinFilterResponse(const grpc::Status& s,
+                                            const carnotpb::GetJoinFilterResponse& resp) {
+  if (!s.ok()) {
+    VLOG(1) << absl::Substitute("GRPCSinkNode $0 failed to fetch join filter: $1",
+                                plan_node_->id(), s.error_message());
+    return;
+  }
+  if (!resp.ready()) {
+    return;
+  }
+  join_filter_pending_ = false;
+  if (resp.disabled()) {
+    return;
+  }
+  auto filter_or_s = bloomfilter::XXHash64BloomFilter::FromProto(resp.filter());
+  if (!filter_or_s.ok()) {
+    LOG(WARNING) << absl::Substitute("GRPCSinkNode $0 received an invalid join filter: $1",
+                                     plan_node_->id(), filter_or_s.msg());
+    return;
+  }
+  join_filter_ = filter_or_s.ConsumeValueOrDie();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> GRPCSinkNode::ApplyJoinFilter(ExecState* exec_state,
+                                                                  const RowBatch& rb) {
+  auto rows = std::make_shared<std::vector<int64_t>>(
+      SelectJoinFilterRows(rb, join_filter_key_indices_, *join_filter_));
+  if (static_cast<int64_t>(rows->size()) == rb.num_selected_rows()) {
+    return std::unique_ptr<RowBatch>();
+  }
+  join_filter_dropped_rows_ += rb.num_selected_rows() - rows->size();
+  return SelectRows(exec_state, rb, std::move(rows));
+}
+
+StatusOr<std::unique_ptr<RowBatch>> GRPCSinkNode::ApplyPartition(ExecState* exec_state,
+                                                                 const RowBatch& rb) {
+  const auto& partition = plan_node_->partition();
+  auto rows = std::make_shared<std::vector<int64_t>>(SelectPartitionRows(
+      rb, partition_key_indices_, partition.num_partitions(), partition.partition_index()));
+  if (static_cast<int64_t>(rows->size()) == rb.num_selected_rows()) {
+    return std::unique_ptr<RowBatch>();
+  }
+  partition_skipped_rows_ += rb.num_selected_rows() - rows->size();
+  return SelectRows(exec_state, rb, std::move(rows));
+}
+
+StatusOr<std::unique_ptr<RowBatch>> GRPCSinkNode::SelectRows(
+    ExecState* exec_state, const RowBatch& rb, std::shared_ptr<std::vector<int64_t>> rows) {
+  RowBatch selected_rb(rb.desc(), rb.num_rows());
+  for (int64_t col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+    PL_RETURN_IF_ERROR(selected_rb.AddColumn(rb.ColumnAt(col_idx)));
+  }
+  selected_rb.set_eow(rb.eow());
+  selected_rb.set_eos(rb.eos());
+  selected_rb.set_selection(std::move(rows));
+  return selected_rb.Materialize(exec_state->exec_mem_pool());
 }
 
 Status GRPCSinkNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t parent_idx) {
+  if (destination_done_) {
+    return Status::OK();
+  }
+  if (join_filter_pending_) {
+    OptionallyFetchJoinFilter(exec_state);
+  }
+  const RowBatch* output_rb = &rb;
+  std::unique_ptr<RowBatch> filtered_rb;
+  if (join_filter_ != nullptr && output_rb->num_rows() > 0) {
+    PL_ASSIGN_OR_RETURN(filtered_rb, ApplyJoinFilter(exec_state, *output_rb));
+    if (filtered_rb != nullptr) {
+      output_rb = filtered_rb.get();
+    }
+  }
+  std::unique_ptr<RowBatch> partitioned_rb;
+  if (plan_node_->has_partition() && output_rb->num_rows() > 0) {
+    PL_ASSIGN_OR_RETURN(partitioned_rb, ApplyPartition(exec_state, *output_rb));
+    if (partitioned_rb != nullptr) {
+      output_rb = partitioned_rb.get();
+    }
+  }
+  return WriteBatch(exec_state, *output_rb, parent_idx);
+}
+
+StatusOr<bool> GRPCSinkNode::WriteRequest(ExecState* exec_state,
+                                          const carnotpb::TransferResultChunkRequest& req) {
+  // Writes block while the destination is behind on reading the stream, so this also stops the
+  // query from producing batches faster than the destination consumes them.
+  auto write_start = std::chrono::steady_clock::now();
+  bool written = writer_->Write(req);
+  write_time_ += std::chrono::steady_clock::now() - write_start;
+  if (!written) {
+    PL_RETURN_IF_ERROR(HandleFailedWrite(exec_state));
+    return false;
+  }
+  last_send_time_ = std::chrono::system_clock::now();
+  return true;
+}
+
+Status GRPCSinkNode::ForwardRowBatchData(ExecState* exec_state,
+                                         table_store::schemapb::RowBatchData* data) {
+  DCHECK(AcceptsForwardedRowBatchData());
+  DCHECK(!data->eow() && !data->eos());
+  if (destination_done_) {
+    return Status::OK();
+  }
+  PL_ASSIGN_OR_RETURN(auto metadata, RequestWithMetadata(plan_node_.get(), exec_state));
+  forwarded_rows_ += data->num_rows();
+  // Swapping across arenas copies the data, so the request goes on the arena of the data, if it
+  // came in on one (see NewResultChunk()).
+  google::protobuf::Arena* arena = data->GetArena();
+  auto* req = google::protobuf::Arena::CreateMessage<carnotpb::TransferResultChunkRequest>(arena);
+  std::unique_ptr<carnotpb::TransferResultChunkRequest> heap_req(arena == nullptr ? req : nullptr);
+  req->Swap(&metadata);
+  req->mutable_query_result()->mutable_row_batch()->Swap(data);
+  return WriteRequest(exec_state, *req).status();
+}
+
+Status GRPCSinkNode::WriteBatch(ExecState* exec_state, const RowBatch& rb, size_t parent_idx) {
   PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
 
   // Serialize the RowBatch.
-  PL_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+  PL_RETURN_IF_ERROR(SerializeRowBatch(rb, &req));
   size_t request_size = req.ByteSizeLong();
   if (request_size > kMaxBatchSize) {
     return SplitAndSendBatch(exec_state, rb, parent_idx, request_size);
   }
 
-  if (!writer_->Write(req)) {
-    cancelled_ = true;
-    return error::Cancelled(
-        "GRPCSinkNode $0 of query $1 could not write result to address: $2, stream closed by "
-        "server",
-        exec_state->query_id().str(), plan_node_->id(), plan_node_->address());
-  }
-  last_send_time_ = std::chrono::system_clock::now();
-
-  if (!rb.eos()) {
+  PL_ASSIGN_OR_RETURN(bool written, WriteRequest(exec_state, req));
+  if (!written || !rb.eos()) {
     return Status::OK();
   }
 
@@ -30,10 +30,13 @@
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
+#include "src/shared/bloomfilter/bloomfilter.h"
 #include "src/table_store/table_store.h"
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
 
+DECLARE_bool(grpc_sink_arrow_row_batches);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -50,6 +53,10 @@ constexpr size_t kMaxBatchSize = 1024 * 1024 - kMetadataMargin;
 // larger than the other. This parameter can be tuned in the future depending on what we learn about
 // the distributions of the row batches.
 constexpr float kBatchSizeFactor = 0.5;
+// How often a sink asks for the filter of the join it sends to until the join publishes it, and
+// how long each request may take. The rows are sent unfiltered in the meantime.
+constexpr std::chrono::milliseconds kJoinFilterFetchInterval{100};
+constexpr std::chrono::milliseconds kJoinFilterFetchTimeout{500};
 
 class GRPCSinkNode : public SinkNode {
  public:
@@ -59,6 +66,21 @@ class GRPCSinkNode : public SinkNode {
   // Used to check the downstream connection after connection_check_timeout_ has elapsed.
   Status OptionallyCheckConnection(ExecState* exec_state);
 
+  // Whether the destination ended the stream because it doesn't need any more results. Any
+  // further input to the sink is dropped.
+  bool destination_done() const { return destination_done_; }
+
+  // Whether the rows are filtered on the filter of the join they are sent to.
+  bool has_join_filter() const { return join_filter_ != nullptr; }
+
+  // Whether the sink sends RowBatchData protos as is, so rows that are already serialized can be
+  // forwarded to it (see ForwardRowBatchData).
+  bool AcceptsForwardedRowBatchData() const { return plan_node_->has_table_name(); }
+  // Sends rows that are already serialized for the destination, without decoding them. The rows
+  // must match the input of the sink and must not end the stream, which still goes through
+  // ConsumeNext. The data is moved out of the proto.
+  Status ForwardRowBatchData(ExecState* exec_state, table_store::schemapb::RowBatchData* data);
+
   void testing_set_connection_check_timeout(const std::chrono::milliseconds& timeout) {
     connection_check_timeout_ = timeout;
   }
@@ -79,8 +101,40 @@ class GRPCSinkNode : public SinkNode {
 
  private:
   Status CloseWriter(ExecState* exec_state);
+  // Called when a write to the stream fails. Returns OK if the destination ended the stream
+  // because it is done, and an error otherwise.
+  Status HandleFailedWrite(ExecState* exec_state);
+  // Writes the row batch into the request, as arrow buffers when the destination is another
+  // Carnot instance and --grpc_sink_arrow_row_batches is set.
+  Status SerializeRowBatch(const table_store::schema::RowBatch& rb,
+                           carnotpb::TransferResultChunkRequest* req);
+  // Sends the batch, split into several requests if it is too large for one.
+  Status WriteBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                    size_t parent_index);
+  // Writes the request to the stream. Returns whether it was written.
+  StatusOr<bool> WriteRequest(ExecState* exec_state,
+                              const carnotpb::TransferResultChunkRequest& req);
+  // Asks the destination for the filter of the join the rows are sent to, at most once per
+  // kJoinFilterFetchInterval. The request is asynchronous: later calls pick up its answer without
+  // waiting for it.
+  void OptionallyFetchJoinFilter(ExecState* exec_state);
+  // Uses the answer to a join filter request.
+  void HandleJoinFilterResponse(const grpc::Status& s, const carnotpb::GetJoinFilterResponse& resp);
+  // Cancels the join filter request in flight, if any, and waits for it to be done.
+  void CancelJoinFilterFetch();
+  // Returns the rows of the batch that may match in the join, or nullptr if they all may.
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> ApplyJoinFilter(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Returns the rows of the batch in the partition of the sink, or nullptr if they all are.
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> ApplyPartition(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Returns a batch with only the given rows of rb.
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> SelectRows(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb,
+      std::shared_ptr<std::vector<int64_t>> rows);
 
   bool cancelled_ = true;
+  bool destination_done_ = false;
 
   grpc::ClientContext context_;
   carnotpb::TransferResultChunkResponse response_;
@@ -94,6 +148,32 @@ class GRPCSinkNode : public SinkNode {
   std::chrono::milliseconds connection_check_timeout_ = kDefaultConnectionCheckTimeoutMS;
   std::chrono::time_point<std::chrono::system_clock> last_send_time_ =
       std::chrono::system_clock::now();
+  // The time spent writing batches, including the time the writes were held up by flow control.
+  std::chrono::steady_clock::duration write_time_{0};
+
+  // Set until the join the rows are sent to publishes its filter (see planpb::GRPCSinkOperator).
+  bool join_filter_pending_ = false;
+  std::chrono::steady_clock::time_point next_join_filter_fetch_;
+  // A GetJoinFilter request in flight. It completes on join_filter_cq_, which is only polled.
+  struct JoinFilterFetch {
+    grpc::ClientContext context;
+    carnotpb::GetJoinFilterResponse response;
+    grpc::Status status;
+    std::unique_ptr<grpc::ClientAsyncResponseReaderInterface<carnotpb::GetJoinFilterResponse>>
+        rpc;
+  };
+  std::unique_ptr<JoinFilterFetch> join_filter_fetch_;
+  grpc::CompletionQueue join_filter_cq_;
+  std::vector<int64_t> join_filter_key_indices_;
+  std::unique_ptr<bloomfilter::XXHash64BloomFilter> join_filter_;
+  int64_t join_filter_dropped_rows_ = 0;
+
+  // Set when the sink only sends one hash partition of its rows (see planpb::GRPCSinkOperator).
+  std::vector<int64_t> partition_key_indices_;
+  int64_t partition_skipped_rows_ = 0;
+
+  // The rows sent with ForwardRowBatchData, which don't show in the input stats of the node.
+  int64_t forwarded_rows_ = 0;
 };
 
 }  // namespace exec
@@ -212,6 +212,58 @@ TEST_F(GRPCSinkNodeTest, internal_result) {
   EXPECT_FALSE(add_metadata_called_);
 }
 
+TEST_F(GRPCSinkNodeTest, internal_result_arrow_row_batches) {
+  bool prev_arrow_row_batches = FLAGS_grpc_sink_arrow_row_batches;
+  FLAGS_grpc_sink_arrow_row_batches = true;
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(4);
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(4)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[2]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[3]), Return(true)));
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  std::vector<RowBatch> input_rbs;
+  for (auto i = 0; i < 3; ++i) {
+    std::vector<types::Int64Value> data(i, i);
+    input_rbs.push_back(RowBatchBuilder(output_rd, i, /*eow*/ i == 2, /*eos*/ i == 2)
+                            .AddColumn<types::Int64Value>(data)
+                            .get());
+    tester.ConsumeNext(input_rbs.back(), 5, 0);
+  }
+  tester.Close();
+
+  EXPECT_TRUE(actual_protos[0].query_result().initiate_result_stream());
+  for (auto i = 0; i < 3; ++i) {
+    const auto& result = actual_protos[i + 1].query_result();
+    EXPECT_EQ(0, result.grpc_source_id());
+    ASSERT_TRUE(result.has_arrow_row_batch());
+    auto arrow_rb = result.arrow_row_batch();
+    ASSERT_OK_AND_ASSIGN(auto rb, RowBatch::FromArrowProto(&arrow_rb));
+    EXPECT_EQ(input_rbs[i].DebugString(), rb->DebugString());
+  }
+
+  FLAGS_grpc_sink_arrow_row_batches = prev_arrow_row_batches;
+}
+
 constexpr char kExpectedExternalInitialization[] = R"proto(
 address: "localhost:1234"
 query_id {
@@ -340,6 +392,61 @@ TEST_F(GRPCSinkNodeTest, external_result) {
   EXPECT_TRUE(add_metadata_called_);
 }
 
+TEST_F(GRPCSinkNodeTest, forward_row_batch_data) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink2PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(3);
+  std::vector<std::string> expected_protos = {
+      absl::Substitute(kExpectedExternalInitialization, exec_state_->query_id().ab,
+                       exec_state_->query_id().cd),
+      absl::Substitute(kExpectedExteralResult1, exec_state_->query_id().ab,
+                       exec_state_->query_id().cd),
+      absl::Substitute(kExpectedExteralResult2, exec_state_->query_id().ab,
+                       exec_state_->query_id().cd),
+  };
+
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(3)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[2]), Return(true)));
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  ASSERT_TRUE(tester.node()->AcceptsForwardedRowBatchData());
+
+  // The rows are sent as they were serialized, with the metadata of the sink.
+  table_store::schemapb::RowBatchData data;
+  auto forwarded_rb = RowBatchBuilder(output_rd, 1, /*eow*/ false, /*eos*/ false)
+                          .AddColumn<types::Int64Value>({1})
+                          .get();
+  ASSERT_OK(forwarded_rb.ToProto(&data));
+  EXPECT_OK(tester.node()->ForwardRowBatchData(exec_state_.get(), &data));
+
+  // The end of the stream still goes through the node.
+  auto eos_rb = RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+                    .AddColumn<types::Int64Value>({2, 2})
+                    .get();
+  tester.ConsumeNext(eos_rb, 5, 0);
+  tester.Close();
+
+  for (auto i = 0; i < 3; ++i) {
+    EXPECT_THAT(actual_protos[i], EqualsProto(expected_protos[i]));
+  }
+}
+
 TEST_F(GRPCSinkNodeTest, check_connection) {
   auto op_proto = planpb::testutils::CreateTestGRPCSink2PB();
   auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
@@ -377,6 +484,43 @@ TEST_F(GRPCSinkNodeTest, check_connection) {
   tester.Close();
 }
 
+TEST_F(GRPCSinkNodeTest, destination_done) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+  resp.set_destination_done(true);
+
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(3)
+      .WillOnce(Return(true))    // Initiate result sink
+      .WillOnce(Return(true))    // First batch
+      .WillOnce(Return(false));  // Stream ended by the destination
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // The batches after the destination is done are dropped, rather than written.
+  for (auto i = 0; i < 4; ++i) {
+    auto rb = RowBatchBuilder(output_rd, 1, /*eow*/ i == 3, /*eos*/ i == 3)
+                  .AddColumn<types::Int64Value>({i})
+                  .get();
+    tester.ConsumeNext(rb, 5, 0);
+    EXPECT_EQ(i >= 1, tester.node()->destination_done());
+  }
+  EXPECT_OK(tester.node()->OptionallyCheckConnection(exec_state_.get()));
+
+  tester.Close();
+}
+
 TEST_F(GRPCSinkNodeTest, update_connection_time) {
   auto op_proto = planpb::testutils::CreateTestGRPCSink2PB();
   auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
@@ -23,7 +23,9 @@
 #include <vector>
 
 #include <absl/strings/substitute.h>
+#include <google/protobuf/arena.h>
 
+#include "src/carnot/exec/grpc_sink_node.h"
 #include "src/carnot/planpb/plan.pb.h"
 
 namespace px {
@@ -32,6 +34,31 @@ namespace exec {
 
 using table_store::schema::RowBatch;
 
+namespace {
+// Sized for the row batches of a few hundred rows that the sinks send.
+constexpr size_t kResultChunkArenaStartBlockSize = 4 * 1024;
+constexpr size_t kResultChunkArenaMaxBlockSize = 64 * 1024;
+}  // namespace
+
+void ResultChunkDeleter::operator()(carnotpb::TransferResultChunkRequest* req) const {
+  google::protobuf::Arena* arena = req->GetArena();
+  if (arena == nullptr) {
+    delete req;
+    return;
+  }
+  // The arena holds nothing but the request, see NewResultChunk().
+  delete arena;
+}
+
+ResultChunkPtr NewResultChunk() {
+  google::protobuf::ArenaOptions options;
+  options.start_block_size = kResultChunkArenaStartBlockSize;
+  options.max_block_size = kResultChunkArenaMaxBlockSize;
+  auto* arena = new google::protobuf::Arena(options);
+  return ResultChunkPtr(
+      google::protobuf::Arena::CreateMessage<carnotpb::TransferResultChunkRequest>(arena));
+}
+
 std::string GRPCSourceNode::DebugStringImpl() {
   return absl::Substitute("Exec::GRPCSourceNode: <id: $0, output: $1>", plan_node_->id(),
                           output_descriptor_->DebugString());
@@ -47,34 +74,79 @@ Status GRPCSourceNode::PrepareImpl(ExecState*) { return Status::OK(); }
 
 Status GRPCSourceNode::OpenImpl(ExecState*) { return Status::OK(); }
 
-Status GRPCSourceNode::CloseImpl(ExecState*) { return Status::OK(); }
+Status GRPCSourceNode::CloseImpl(ExecState*) {
+  if (budget_ != nullptr) {
+    budget_->Close();
+  }
+  return Status::OK();
+}
 
 Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
-  PL_RETURN_IF_ERROR(PopRowBatch());
+  PL_ASSIGN_OR_RETURN(auto rb_request, PopRequest());
+  if (passthrough_sink_ != nullptr && CanForward(*rb_request)) {
+    return Forward(exec_state, rb_request.get());
+  }
+  PL_RETURN_IF_ERROR(ReadRowBatch(rb_request.get()));
   PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *rb_));
   return Status::OK();
 }
 
-Status GRPCSourceNode::EnqueueRowBatch(
-    std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch) {
+bool GRPCSourceNode::CanForward(const carnotpb::TransferResultChunkRequest& rb_request) const {
+  // Arrow row batches have to be converted for the destination, and batches too large to send
+  // with new metadata are split by the sink.
+  return rb_request.has_query_result() && rb_request.query_result().has_row_batch() &&
+         rb_request.query_result().row_batch().ByteSizeLong() < kMaxBatchSize;
+}
+
+Status GRPCSourceNode::Forward(ExecState* exec_state,
+                               carnotpb::TransferResultChunkRequest* rb_request) {
+  auto* data = rb_request->mutable_query_result()->mutable_row_batch();
+  bool eow = data->eow();
+  bool eos = data->eos();
+  if (data->num_rows() > 0) {
+    data->set_eow(false);
+    data->set_eos(false);
+    PL_RETURN_IF_ERROR(passthrough_sink_->ForwardRowBatchData(exec_state, data));
+  }
+  if (!eow && !eos) {
+    return Status::OK();
+  }
+  // The children track the end of the stream of each source, so it still goes through them.
+  PL_ASSIGN_OR_RETURN(rb_, RowBatch::WithZeroRows(*output_descriptor_, eow, eos));
+  return SendRowBatchToChildren(exec_state, *rb_);
+}
+
+Status GRPCSourceNode::EnqueueRowBatch(ResultChunkPtr row_batch) {
   if (!row_batch_queue_.enqueue(std::move(row_batch))) {
     return error::Internal("Failed to enqueue RowBatch");
   }
   return Status::OK();
 }
 
-Status GRPCSourceNode::PopRowBatch() {
+StatusOr<ResultChunkPtr> GRPCSourceNode::PopRequest() {
   DCHECK(NextBatchReady());
-  std::unique_ptr<carnotpb::TransferResultChunkRequest> rb_request;
+  ResultChunkPtr rb_request;
   bool got_one = row_batch_queue_.try_dequeue(rb_request);
   if (!got_one) {
     return error::Internal(
-        "Called GRPCSourceNode::OptionallyPopRowBatch but there was no available row batch in the "
-        "queue.");
+        "Called GRPCSourceNode::PopRequest but there was no available row batch in the queue.");
+  }
+  if (budget_ != nullptr) {
+    budget_->Release(rb_request->ByteSizeLong());
+  }
+  return rb_request;
+}
+
+Status GRPCSourceNode::ReadRowBatch(carnotpb::TransferResultChunkRequest* rb_request) {
+  if (rb_request->has_query_result() && rb_request->query_result().has_arrow_row_batch()) {
+    // The arrow buffers are moved out of the request, rather than copied.
+    PL_ASSIGN_OR_RETURN(rb_, RowBatch::FromArrowProto(
+                                 rb_request->mutable_query_result()->mutable_arrow_row_batch()));
+    return Status::OK();
   }
   if (!rb_request->has_query_result() || !rb_request->query_result().has_row_batch()) {
     return error::Internal(
-        "GRPCSourceNode::PopRowBatch expected TransferResultChunkRequest to have RowBatch "
+        "GRPCSourceNode::ReadRowBatch expected TransferResultChunkRequest to have RowBatch "
         "message.");
   }
 
@@ -21,11 +21,13 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/result_queue_budget.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/table_store/table_store.h"
@@ -36,13 +38,34 @@ namespace px {
 namespace carnot {
 namespace exec {
 
+class GRPCSinkNode;
+
+/**
+ * Deletes a TransferResultChunkRequest, along with its arena when it was allocated on one of its
+ * own by NewResultChunk().
+ */
+struct ResultChunkDeleter {
+  ResultChunkDeleter() = default;
+  // So that the requests allocated on the heap convert to a ResultChunkPtr.
+  ResultChunkDeleter(std::default_delete<carnotpb::TransferResultChunkRequest>) {}  // NOLINT
+  void operator()(carnotpb::TransferResultChunkRequest* req) const;
+};
+
+using ResultChunkPtr = std::unique_ptr<carnotpb::TransferResultChunkRequest, ResultChunkDeleter>;
+
+/**
+ * Allocates a request on an arena of its own. Parsing a row batch into it then takes a few arena
+ * blocks, instead of a heap allocation for every column and string value of the batch.
+ */
+ResultChunkPtr NewResultChunk();
+
 class GRPCSourceNode : public SourceNode {
  public:
   GRPCSourceNode() = default;
   virtual ~GRPCSourceNode() = default;
 
   bool NextBatchReady() override;
-  virtual Status EnqueueRowBatch(std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch);
+  virtual Status EnqueueRowBatch(ResultChunkPtr row_batch);
 
   // Tracks whether the upstream sink node has successfully initiated the connection to
   // this remote source. Used by the exec graph to determine whether or not any sources have
@@ -56,6 +79,16 @@ class GRPCSourceNode : public SourceNode {
   void set_upstream_closed_connection() { upstream_closed_connection_ = true; }
   bool upstream_closed_connection() const { return upstream_closed_connection_; }
 
+  // The budget that the router charges the batches it enqueues to. The source releases the bytes
+  // of every batch it pops, and closes the budget when it is closed.
+  void set_queue_budget(std::shared_ptr<ResultQueueBudget> budget) { budget_ = std::move(budget); }
+
+  // Set when the rows of the source go unchanged to a sink that sends RowBatchData, e.g. through
+  // an unordered union of the results of several agents. The RowBatchData the source receives is
+  // then forwarded to the sink without being decoded. Only the end of the stream, and the rows
+  // that come in other forms, go through the children of the source.
+  void set_passthrough_sink(GRPCSinkNode* sink) { passthrough_sink_ = sink; }
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -65,15 +98,19 @@ class GRPCSourceNode : public SourceNode {
   Status GenerateNextImpl(ExecState* exec_state) override;
 
  private:
-  Status PopRowBatch();
+  StatusOr<ResultChunkPtr> PopRequest();
+  Status ReadRowBatch(carnotpb::TransferResultChunkRequest* rb_request);
+  bool CanForward(const carnotpb::TransferResultChunkRequest& rb_request) const;
+  Status Forward(ExecState* exec_state, carnotpb::TransferResultChunkRequest* rb_request);
 
   std::unique_ptr<table_store::schema::RowBatch> rb_;
-  moodycamel::BlockingConcurrentQueue<std::unique_ptr<carnotpb::TransferResultChunkRequest>>
-      row_batch_queue_;
+  moodycamel::BlockingConcurrentQueue<ResultChunkPtr> row_batch_queue_;
 
   std::unique_ptr<plan::GRPCSourceOperator> plan_node_;
   bool upstream_initiated_connection_ = false;
   bool upstream_closed_connection_ = false;
+  std::shared_ptr<ResultQueueBudget> budget_;
+  GRPCSinkNode* passthrough_sink_ = nullptr;
 };
 
 }  // namespace exec
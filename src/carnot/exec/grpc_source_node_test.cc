@@ -86,6 +86,60 @@ TEST_F(GRPCSourceNodeTest, basic) {
   EXPECT_FALSE(tester.node()->HasBatchesRemaining());
 }
 
+TEST_F(GRPCSourceNodeTest, arrow_row_batches) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::GRPCSourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+
+  for (auto i = 0; i < 3; ++i) {
+    std::vector<types::Int64Value> data(i, i);
+    auto rb = RowBatchBuilder(output_rd, i, /*eow*/ i == 2, /*eos*/ i == 2)
+                  .AddColumn<types::Int64Value>(data)
+                  .get();
+
+    auto rb_wrapper = std::make_unique<carnotpb::TransferResultChunkRequest>();
+    EXPECT_OK(rb.ToArrowProto(rb_wrapper->mutable_query_result()->mutable_arrow_row_batch()));
+    EXPECT_OK(tester.node()->EnqueueRowBatch(std::move(rb_wrapper)));
+
+    EXPECT_TRUE(tester.node()->NextBatchReady());
+    tester.GenerateNextResult().ExpectRowBatch(rb);
+  }
+
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+}
+
+TEST_F(GRPCSourceNodeTest, arena_row_batches) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::GRPCSourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+
+  for (auto i = 0; i < 3; ++i) {
+    std::vector<types::Int64Value> data(i, i);
+    auto rb = RowBatchBuilder(output_rd, i, /*eow*/ i == 2, /*eos*/ i == 2)
+                  .AddColumn<types::Int64Value>(data)
+                  .get();
+
+    // The router parses the requests it receives on arenas of their own.
+    carnotpb::TransferResultChunkRequest req;
+    EXPECT_OK(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+    ResultChunkPtr rb_wrapper = NewResultChunk();
+    ASSERT_NE(nullptr, rb_wrapper->GetArena());
+    ASSERT_TRUE(rb_wrapper->ParseFromString(req.SerializeAsString()));
+    EXPECT_OK(tester.node()->EnqueueRowBatch(std::move(rb_wrapper)));
+
+    EXPECT_TRUE(tester.node()->NextBatchReady());
+    tester.GenerateNextResult().ExpectRowBatch(rb);
+  }
+
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
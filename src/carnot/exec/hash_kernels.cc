@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/hash_kernels.h"
+
+#include <string_view>
+#include <vector>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+
+template <typename TArray, typename TToWord>
+void HashWords(const arrow::Array& col, int64_t num_rows, TToWord to_word,
+               std::vector<uint64_t>* hashes) {
+  const auto& arr = static_cast<const TArray&>(col);
+  uint64_t* out = hashes->data();
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    out[row_idx] = HashKeyWord(out[row_idx], to_word(arr.Value(row_idx)));
+  }
+}
+
+void HashStrings(const arrow::Array& col, int64_t num_rows, std::vector<uint64_t>* hashes) {
+  const auto& arr = static_cast<const arrow::StringArray&>(col);
+  uint64_t* out = hashes->data();
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    int32_t len = 0;
+    const uint8_t* data = arr.GetValue(row_idx, &len);
+    out[row_idx] =
+        HashKeyString(out[row_idx], std::string_view(reinterpret_cast<const char*>(data), len));
+  }
+}
+
+void HashDictionaryStrings(const arrow::Array& col, int64_t num_rows,
+                           std::vector<uint64_t>* hashes) {
+  const auto& dict_arr = static_cast<const arrow::DictionaryArray&>(col);
+  auto codes = static_cast<const arrow::Int32Array*>(dict_arr.indices().get());
+  auto values = static_cast<const arrow::StringArray*>(dict_arr.dictionary().get());
+
+  std::vector<uint64_t> distinct_hashes(values->length());
+  for (int64_t i = 0; i < values->length(); ++i) {
+    int32_t len = 0;
+    const uint8_t* data = values->GetValue(i, &len);
+    distinct_hashes[i] = ::util::Hash64(reinterpret_cast<const char*>(data), len);
+  }
+  uint64_t* out = hashes->data();
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    out[row_idx] = ::px::HashCombine(out[row_idx], distinct_hashes[codes->Value(row_idx)]);
+  }
+}
+
+}  // namespace
+
+void HashColumn(const arrow::Array& col, types::DataType data_type, int64_t num_rows,
+                std::vector<uint64_t>* hashes) {
+  DCHECK_GE(col.length(), num_rows);
+  DCHECK_GE(static_cast<int64_t>(hashes->size()), num_rows);
+  switch (data_type) {
+    case types::DataType::BOOLEAN:
+      HashWords<arrow::BooleanArray>(
+          col, num_rows, [](bool v) { return static_cast<uint64_t>(v); }, hashes);
+      break;
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+      HashWords<arrow::Int64Array>(
+          col, num_rows, [](int64_t v) { return static_cast<uint64_t>(v); }, hashes);
+      break;
+    case types::DataType::FLOAT64:
+      HashWords<arrow::DoubleArray>(col, num_rows, DoubleToWord, hashes);
+      break;
+    case types::DataType::UINT128: {
+      const auto& arr = static_cast<const arrow::UInt128Array&>(col);
+      uint64_t* out = hashes->data();
+      for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+        absl::uint128 val = arr.Value(row_idx);
+        out[row_idx] = HashKeyWord(HashKeyWord(out[row_idx], absl::Uint128High64(val)),
+                                   absl::Uint128Low64(val));
+      }
+      break;
+    }
+    case types::DataType::STRING:
+      if (types::IsDictionaryArray(col)) {
+        HashDictionaryStrings(col, num_rows, hashes);
+      } else {
+        HashStrings(col, num_rows, hashes);
+      }
+      break;
+    default:
+      LOG(DFATAL) << "Unsupported key type: " << types::ToString(data_type);
+  }
+}
+
+void HashColumns(const std::vector<const arrow::Array*>& cols,
+                 const std::vector<types::DataType>& data_types, int64_t num_rows,
+                 std::vector<uint64_t>* hashes) {
+  DCHECK_EQ(cols.size(), data_types.size());
+  hashes->assign(num_rows, 0);
+  for (size_t col_idx = 0; col_idx < cols.size(); ++col_idx) {
+    HashColumn(*cols[col_idx], data_types[col_idx], num_rows, hashes);
+  }
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
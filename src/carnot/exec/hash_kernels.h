@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <farmhash.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/hash_utils.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * Hash kernels for the keys of a batch, shared by the operators that hash rows (aggregates, joins,
+ * partitioning). Each column is hashed in one pass that combines the hash of the value of every
+ * row into the hash of the row, so the type of a column is dispatched once per batch instead of
+ * once per row.
+ *
+ * The hash of a row starts at 0, and each value is combined into it in column order: fixed-width
+ * values as one word (two for UINT128, high first), and strings as their farmhash. This is the
+ * same hash as RowTuple::Hash() and GroupKey, so the hashes of a batch can be used to look up
+ * either kind of key.
+ */
+
+inline uint64_t HashKeyWord(uint64_t hash, uint64_t word) { return ::px::HashCombine(hash, word); }
+
+inline uint64_t HashKeyString(uint64_t hash, std::string_view str) {
+  return ::px::HashCombine(hash, ::util::Hash64(str.data(), str.size()));
+}
+
+// Doubles are hashed bitwise, the same way the keys compare them.
+inline uint64_t DoubleToWord(double v) {
+  uint64_t word;
+  std::memcpy(&word, &v, sizeof(word));
+  return word;
+}
+
+/**
+ * Combines the values of the first num_rows rows of col into hashes, which must have at least
+ * num_rows entries. Dictionary-encoded strings are hashed once per distinct value.
+ */
+void HashColumn(const arrow::Array& col, types::DataType data_type, int64_t num_rows,
+                std::vector<uint64_t>* hashes);
+
+/**
+ * Hashes the first num_rows rows of cols into hashes, which is resized to num_rows.
+ */
+void HashColumns(const std::vector<const arrow::Array*>& cols,
+                 const std::vector<types::DataType>& data_types, int64_t num_rows,
+                 std::vector<uint64_t>* hashes);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
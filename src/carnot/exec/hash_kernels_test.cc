@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "src/carnot/exec/group_key.h"
+#include "src/carnot/exec/hash_kernels.h"
+#include "src/carnot/exec/row_tuple.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using types::DataType;
+
+TEST(HashKernels, matches_row_tuple_and_group_key) {
+  std::vector<DataType> data_types = {DataType::UINT128, DataType::STRING, DataType::FLOAT64,
+                                      DataType::BOOLEAN};
+  auto upids = types::ToArrow(std::vector<types::UInt128Value>{{1, 2}, {1, 2}, {2, 1}},
+                              arrow::default_memory_pool());
+  auto paths = types::ToArrow(std::vector<types::StringValue>{"/a", "/b", "/a"},
+                              arrow::default_memory_pool());
+  auto floats = types::ToArrow(std::vector<types::Float64Value>{0.5, 0.5, -1.0},
+                               arrow::default_memory_pool());
+  auto bools = types::ToArrow(std::vector<types::BoolValue>{true, false, true},
+                              arrow::default_memory_pool());
+  std::vector<const arrow::Array*> cols = {upids.get(), paths.get(), floats.get(), bools.get()};
+
+  std::vector<uint64_t> hashes;
+  HashColumns(cols, data_types, 3, &hashes);
+  ASSERT_EQ(3, hashes.size());
+  EXPECT_NE(hashes[0], hashes[1]);
+  EXPECT_NE(hashes[0], hashes[2]);
+
+  std::vector<GroupKeyView> keys;
+  GroupKeyLayout(data_types).ExtractKeys(cols, 3, &keys);
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    EXPECT_EQ(hashes[i], keys[i].hash);
+  }
+
+  RowTuple rt(&data_types);
+  rt.SetValue(0, types::UInt128Value(1, 2));
+  rt.SetValue(1, types::StringValue("/b"));
+  rt.SetValue(2, types::Float64Value(0.5));
+  rt.SetValue(3, types::BoolValue(false));
+  EXPECT_EQ(hashes[1], rt.Hash());
+}
+
+TEST(HashKernels, dictionary_strings) {
+  arrow::Int32Builder codes_builder;
+  for (int32_t code : {1, 0, 1}) {
+    ASSERT_TRUE(codes_builder.Append(code).ok());
+  }
+  std::shared_ptr<arrow::Array> codes;
+  ASSERT_TRUE(codes_builder.Finish(&codes).ok());
+  auto dict_values =
+      types::ToArrow(std::vector<types::StringValue>{"/b", "/a"}, arrow::default_memory_pool());
+  auto dict_paths = types::MakeDictionaryStringArray(codes, dict_values);
+  auto paths = types::ToArrow(std::vector<types::StringValue>{"/a", "/b", "/a"},
+                              arrow::default_memory_pool());
+
+  std::vector<uint64_t> hashes;
+  HashColumns({paths.get()}, {DataType::STRING}, 3, &hashes);
+  std::vector<uint64_t> dict_hashes;
+  HashColumns({dict_paths.get()}, {DataType::STRING}, 3, &dict_hashes);
+  EXPECT_EQ(hashes, dict_hashes);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
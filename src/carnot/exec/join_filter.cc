@@ -0,0 +1,213 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/join_filter.h"
+
+#include <arrow/array.h>
+
+#include <algorithm>
+#include <string_view>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+#include "src/shared/types/types.h"
+#include "xxhash.h"
+
+DEFINE_bool(carnot_join_filters, gflags::BoolFromEnv("PL_CARNOT_JOIN_FILTERS", false),
+            "Whether joins publish a bloom filter of their build side keys, which the agents "
+            "sending their probe side use to drop the rows that can't match.");
+DEFINE_int64(carnot_join_filter_max_build_keys,
+             gflags::Int64FromEnv("PL_CARNOT_JOIN_FILTER_MAX_BUILD_KEYS", 100000),
+             "The most distinct build side keys a join publishes a filter for.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+namespace {
+
+template <typename T>
+void AppendFixed(T val, std::string* key) {
+  key->append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+// Strings are prefixed with their length, so that the keys of different columns don't run into
+// each other.
+void AppendString(std::string_view str, std::string* key) {
+  AppendFixed(static_cast<uint32_t>(str.size()), key);
+  key->append(str);
+}
+
+void AppendColumn(types::DataType data_type, const arrow::Array* col,
+                  std::vector<std::string>* keys) {
+  int64_t num_rows = col->length();
+  switch (data_type) {
+    case types::DataType::BOOLEAN: {
+      auto arr = static_cast<const arrow::BooleanArray*>(col);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        AppendFixed(static_cast<uint8_t>(arr->Value(i)), &(*keys)[i]);
+      }
+      break;
+    }
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS: {
+      auto arr = static_cast<const arrow::Int64Array*>(col);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        AppendFixed(arr->Value(i), &(*keys)[i]);
+      }
+      break;
+    }
+    case types::DataType::FLOAT64: {
+      // Doubles are compared bitwise, the same way RowTuple compares them.
+      auto arr = static_cast<const arrow::DoubleArray*>(col);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        AppendFixed(arr->Value(i), &(*keys)[i]);
+      }
+      break;
+    }
+    case types::DataType::UINT128: {
+      auto arr = static_cast<const arrow::UInt128Array*>(col);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        absl::uint128 val = arr->Value(i);
+        AppendFixed(absl::Uint128High64(val), &(*keys)[i]);
+        AppendFixed(absl::Uint128Low64(val), &(*keys)[i]);
+      }
+      break;
+    }
+    case types::DataType::STRING: {
+      if (types::IsDictionaryArray(*col)) {
+        auto dict_arr = static_cast<const arrow::DictionaryArray*>(col);
+        auto codes = static_cast<const arrow::Int32Array*>(dict_arr->indices().get());
+        auto values = static_cast<const arrow::StringArray*>(dict_arr->dictionary().get());
+        for (int64_t i = 0; i < num_rows; ++i) {
+          AppendString(values->GetView(codes->Value(i)), &(*keys)[i]);
+        }
+        break;
+      }
+      auto arr = static_cast<const arrow::StringArray*>(col);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        AppendString(arr->GetView(i), &(*keys)[i]);
+      }
+      break;
+    }
+    default:
+      LOG(DFATAL) << "Unsupported join key type: " << types::ToString(data_type);
+  }
+}
+
+}  // namespace
+
+void EncodeJoinKeys(const RowBatch& rb, const std::vector<int64_t>& key_indices,
+                    std::vector<std::string>* keys) {
+  keys->resize(rb.num_rows());
+  for (auto& key : *keys) {
+    key.clear();
+  }
+  for (int64_t col_idx : key_indices) {
+    AppendColumn(rb.desc().type(col_idx), rb.ColumnAt(col_idx).get(), keys);
+  }
+}
+
+void JoinFilterBuilder::AddBatch(const RowBatch& rb) {
+  if (too_many_keys_) {
+    return;
+  }
+  EncodeJoinKeys(rb, key_indices_, &batch_keys_);
+  for (auto& key : batch_keys_) {
+    keys_.insert(std::move(key));
+  }
+  if (static_cast<int64_t>(keys_.size()) > max_keys_) {
+    too_many_keys_ = true;
+    keys_.clear();
+  }
+}
+
+StatusOr<std::unique_ptr<bloomfilter::XXHash64BloomFilter>> JoinFilterBuilder::Finish() {
+  if (too_many_keys_) {
+    return std::unique_ptr<bloomfilter::XXHash64BloomFilter>();
+  }
+  // The filter needs room for at least one entry, even when the build side is empty.
+  PL_ASSIGN_OR_RETURN(auto filter, bloomfilter::XXHash64BloomFilter::Create(
+                                       std::max<int64_t>(keys_.size(), 1), kJoinFilterErrorRate,
+                                       bloomfilter::XXHash64BloomFilter::kSplitBlock));
+  for (const auto& key : keys_) {
+    filter->Insert(key);
+  }
+  keys_.clear();
+  return filter;
+}
+
+std::vector<int64_t> SelectJoinFilterRows(const RowBatch& rb,
+                                          const std::vector<int64_t>& key_indices,
+                                          const bloomfilter::XXHash64BloomFilter& filter) {
+  std::vector<std::string> keys;
+  EncodeJoinKeys(rb, key_indices, &keys);
+  std::vector<std::string_view> lookups;
+  if (rb.has_selection()) {
+    lookups.reserve(rb.selection()->size());
+    for (int64_t row : *rb.selection()) {
+      lookups.push_back(keys[row]);
+    }
+  } else {
+    lookups.assign(keys.begin(), keys.end());
+  }
+  auto contained = filter.ContainsMany(lookups);
+
+  std::vector<int64_t> rows;
+  for (size_t i = 0; i < contained.size(); ++i) {
+    if (contained[i]) {
+      rows.push_back(rb.has_selection() ? (*rb.selection())[i] : static_cast<int64_t>(i));
+    }
+  }
+  return rows;
+}
+
+std::vector<int64_t> SelectPartitionRows(const RowBatch& rb,
+                                         const std::vector<int64_t>& key_indices,
+                                         uint64_t num_partitions, uint64_t partition_index) {
+  // Differs from the seeds of the join filters, so that the partitions don't line up with them.
+  constexpr uint64_t kPartitionSeed = 0x5ca1ab1e;
+  std::vector<std::string> keys;
+  EncodeJoinKeys(rb, key_indices, &keys);
+  auto in_partition = [&](int64_t row) {
+    const auto& key = keys[row];
+    return XXH64(key.data(), key.size(), kPartitionSeed) % num_partitions == partition_index;
+  };
+
+  std::vector<int64_t> rows;
+  if (rb.has_selection()) {
+    for (int64_t row : *rb.selection()) {
+      if (in_partition(row)) {
+        rows.push_back(row);
+      }
+    }
+    return rows;
+  }
+  for (int64_t row = 0; row < rb.num_rows(); ++row) {
+    if (in_partition(row)) {
+      rows.push_back(row);
+    }
+  }
+  return rows;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
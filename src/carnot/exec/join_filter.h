@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/bloomfilter/bloomfilter.h"
+#include "src/table_store/schema/row_batch.h"
+
+DECLARE_bool(carnot_join_filters);
+DECLARE_int64(carnot_join_filter_max_build_keys);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+// The false positive rate of the join filters.
+constexpr double kJoinFilterErrorRate = 0.01;
+
+/**
+ * Encodes the join key made of the key columns of each row of the batch. The encoding only
+ * depends on the values, so a join and the agents sending its probe side agree on it even when
+ * their strings are dictionary encoded differently.
+ */
+void EncodeJoinKeys(const table_store::schema::RowBatch& rb,
+                    const std::vector<int64_t>& key_indices, std::vector<std::string>* keys);
+
+/**
+ * Collects the distinct keys of the build side of a join, to publish a bloom filter of them once
+ * the build side ends. Gives up once there are more than max_keys keys, since the filter then
+ * gets too large to send to the agents and lets most rows through anyway.
+ */
+class JoinFilterBuilder {
+ public:
+  JoinFilterBuilder(std::vector<int64_t> key_indices, int64_t max_keys)
+      : key_indices_(std::move(key_indices)), max_keys_(max_keys) {}
+
+  void AddBatch(const table_store::schema::RowBatch& rb);
+
+  // Returns the filter, or nullptr if the build side had too many keys.
+  StatusOr<std::unique_ptr<bloomfilter::XXHash64BloomFilter>> Finish();
+
+ private:
+  std::vector<int64_t> key_indices_;
+  int64_t max_keys_;
+  bool too_many_keys_ = false;
+  absl::flat_hash_set<std::string> keys_;
+  std::vector<std::string> batch_keys_;
+};
+
+/**
+ * Returns the rows of the batch, among the selected ones, whose join key may be in the filter.
+ */
+std::vector<int64_t> SelectJoinFilterRows(const table_store::schema::RowBatch& rb,
+                                          const std::vector<int64_t>& key_indices,
+                                          const bloomfilter::XXHash64BloomFilter& filter);
+
+/**
+ * Returns the rows of the batch, among the selected ones, whose key falls in the given one of
+ * num_partitions hash partitions. The key is encoded as the join key, so every agent puts a key
+ * in the same partition however its strings are encoded.
+ */
+std::vector<int64_t> SelectPartitionRows(const table_store::schema::RowBatch& rb,
+                                         const std::vector<int64_t>& key_indices,
+                                         uint64_t num_partitions, uint64_t partition_index);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/join_filter.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+using types::DataType;
+
+namespace {
+
+std::unique_ptr<RowBatch> MakeBatch(const std::vector<types::Int64Value>& ids,
+                                    std::shared_ptr<arrow::Array> names) {
+  auto rb = std::make_unique<RowBatch>(RowDescriptor({DataType::INT64, DataType::STRING}),
+                                       ids.size());
+  EXPECT_OK(rb->AddColumn(types::ToArrow(ids, arrow::default_memory_pool())));
+  EXPECT_OK(rb->AddColumn(names));
+  return rb;
+}
+
+}  // namespace
+
+TEST(JoinFilterTest, keys_ignore_dictionary_encoding) {
+  auto names = types::ToArrow(std::vector<types::StringValue>{"a", "b", "a"},
+                              arrow::default_memory_pool());
+  arrow::Int32Builder codes_builder;
+  for (int32_t code : {1, 0, 1}) {
+    ASSERT_TRUE(codes_builder.Append(code).ok());
+  }
+  std::shared_ptr<arrow::Array> codes;
+  ASSERT_TRUE(codes_builder.Finish(&codes).ok());
+  auto dict_values =
+      types::ToArrow(std::vector<types::StringValue>{"b", "a"}, arrow::default_memory_pool());
+  auto dict_names = types::MakeDictionaryStringArray(codes, dict_values);
+
+  std::vector<std::string> keys;
+  EncodeJoinKeys(*MakeBatch({1, 1, 2}, names), {0, 1}, &keys);
+  std::vector<std::string> dict_keys;
+  EncodeJoinKeys(*MakeBatch({1, 1, 2}, dict_names), {0, 1}, &dict_keys);
+
+  EXPECT_EQ(keys, dict_keys);
+  EXPECT_NE(keys[0], keys[1]);
+  EXPECT_NE(keys[0], keys[2]);
+}
+
+TEST(JoinFilterTest, select_rows) {
+  JoinFilterBuilder builder({0, 1}, 100);
+  builder.AddBatch(*MakeBatch({1, 2}, types::ToArrow(std::vector<types::StringValue>{"a", "b"},
+                                                     arrow::default_memory_pool())));
+  ASSERT_OK_AND_ASSIGN(auto filter, builder.Finish());
+  ASSERT_NE(nullptr, filter);
+
+  auto probe_rb = MakeBatch({1, 1, 2, 2}, types::ToArrow(std::vector<types::StringValue>{
+                                                            "a", "b", "b", "a"},
+                                                        arrow::default_memory_pool()));
+  auto rows = SelectJoinFilterRows(*probe_rb, {0, 1}, *filter);
+  // (1, "b") and (2, "a") may be false positives.
+  EXPECT_TRUE(std::find(rows.begin(), rows.end(), 0) != rows.end());
+  EXPECT_TRUE(std::find(rows.begin(), rows.end(), 2) != rows.end());
+
+  // Only the selected rows are checked.
+  probe_rb->set_selection(std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{1, 2}));
+  rows = SelectJoinFilterRows(*probe_rb, {0, 1}, *filter);
+  EXPECT_TRUE(std::find(rows.begin(), rows.end(), 0) == rows.end());
+  EXPECT_TRUE(std::find(rows.begin(), rows.end(), 2) != rows.end());
+}
+
+TEST(JoinFilterTest, too_many_keys) {
+  JoinFilterBuilder builder({0}, 2);
+  auto names = types::ToArrow(std::vector<types::StringValue>{"a", "a", "a"},
+                              arrow::default_memory_pool());
+  builder.AddBatch(*MakeBatch({1, 2, 1}, names));
+  builder.AddBatch(*MakeBatch({2, 3, 1}, names));
+  ASSERT_OK_AND_ASSIGN(auto filter, builder.Finish());
+  EXPECT_EQ(nullptr, filter);
+}
+
+TEST(JoinFilterTest, select_partition_rows) {
+  std::vector<types::Int64Value> ids;
+  std::vector<types::StringValue> names;
+  for (int64_t i = 0; i < 20; ++i) {
+    ids.push_back(i % 5);
+    names.push_back("a");
+  }
+  auto rb = MakeBatch(ids, types::ToArrow(names, arrow::default_memory_pool()));
+
+  // Each row is in exactly one partition, along with all the rows that have the same key.
+  constexpr uint64_t kNumPartitions = 3;
+  std::vector<int64_t> partition_of_row(ids.size(), -1);
+  for (uint64_t partition = 0; partition < kNumPartitions; ++partition) {
+    for (int64_t row : SelectPartitionRows(*rb, {0, 1}, kNumPartitions, partition)) {
+      EXPECT_EQ(-1, partition_of_row[row]);
+      partition_of_row[row] = partition;
+    }
+  }
+  for (size_t row = 0; row < ids.size(); ++row) {
+    EXPECT_NE(-1, partition_of_row[row]);
+    EXPECT_EQ(partition_of_row[row % 5], partition_of_row[row]);
+  }
+
+  // Only the selected rows are checked.
+  rb->set_selection(std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 1}));
+  std::vector<int64_t> selected;
+  for (uint64_t partition = 0; partition < kNumPartitions; ++partition) {
+    auto rows = SelectPartitionRows(*rb, {0, 1}, kNumPartitions, partition);
+    selected.insert(selected.end(), rows.begin(), rows.end());
+  }
+  std::sort(selected.begin(), selected.end());
+  EXPECT_EQ(std::vector<int64_t>({0, 1}), selected);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
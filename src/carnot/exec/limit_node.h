@@ -48,6 +48,7 @@ class LimitNode : public ProcessingNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  bool ConsumesSelections() const override { return true; }
 
  private:
   size_t records_processed_ = 0;
@@ -81,6 +81,27 @@ TEST_F(LimitNodeTest, single_batch) {
       .Close();
 }
 
+TEST_F(LimitNodeTest, single_batch_with_selection) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowBatchBuilder input_rb(input_rd, 12, /*eow*/ true, /*eos*/ true);
+  input_rb.AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6, 1, 2, 3, 4, 5, 6})
+      .AddColumn<types::Int64Value>({1, 3, 6, 9, 12, 15, 1, 3, 6, 9, 12, 15});
+  // The limit counts the selected rows, and the first row is left out.
+  input_rb.get().set_selection(std::make_shared<std::vector<int64_t>>(
+      std::vector<int64_t>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+
+  auto tester = exec::ExecNodeTester<LimitNode, plan::LimitOperator>(*plan_node_, output_rd,
+                                                                     {input_rd}, exec_state_.get());
+  tester.ConsumeNext(input_rb.get(), 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 10, true, true)
+                          .AddColumn<types::Int64Value>({2, 3, 4, 5, 6, 1, 2, 3, 4, 5})
+                          .AddColumn<types::Int64Value>({3, 6, 9, 12, 15, 1, 3, 6, 9, 12})
+                          .get())
+      .Close();
+}
+
 TEST_F(LimitNodeTest, single_empty_batch) {
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
   RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
@@ -63,7 +63,10 @@ Status MapNode::CloseImpl(ExecState* exec_state) {
 }
 Status MapNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
   RowBatch output_rb(*output_descriptor_, rb.num_rows());
+  // The expressions are evaluated on all the rows of the columns, so the output keeps the
+  // selection.
   PL_RETURN_IF_ERROR(evaluator_->Evaluate(exec_state, rb, &output_rb));
+  output_rb.set_selection(rb.selection());
   output_rb.set_eow(rb.eow());
   output_rb.set_eos(rb.eos());
   PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
@@ -49,6 +49,8 @@ class MapNode : public ProcessingNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  bool ConsumesDictionaryStrings() const override { return true; }
+  bool ConsumesSelections() const override { return true; }
 
  private:
   std::unique_ptr<ExpressionEvaluator> evaluator_;
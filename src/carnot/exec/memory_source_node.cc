@@ -18,15 +18,26 @@
 
 #include "src/carnot/exec/memory_source_node.h"
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <absl/hash/hash.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_join.h>
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
 
+DEFINE_bool(carnot_dictionary_strings, gflags::BoolFromEnv("PL_CARNOT_DICTIONARY_STRINGS", false),
+            "Whether memory sources read the dictionary-encoded string columns of the cold tier "
+            "without decoding them, for the operators that can consume the codes.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -45,32 +56,93 @@ Status MemorySourceNode::InitImpl(const plan::Operator& plan_node) {
   return Status::OK();
 }
 
-Status MemorySourceNode::PrepareImpl(ExecState*) { return Status::OK(); }
+Status MemorySourceNode::PrepareImpl(ExecState*) {
+  batch_sizer_ = std::make_unique<BatchSizer>(*output_descriptor_);
+  return Status::OK();
+}
 
 Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
-  table_ = exec_state->table_store()->GetTable(plan_node_->TableName(), plan_node_->Tablet());
-  DCHECK(table_ != nullptr);
-
   infinite_stream_ = plan_node_->infinite_stream();
 
-  if (table_ == nullptr) {
+  std::vector<table_store::Table*> tables;
+  if (plan_node_->AllTablets()) {
+    if (infinite_stream_) {
+      return error::InvalidArgument("Streaming scans of all the tablets of '$0' aren't supported",
+                                    plan_node_->TableName());
+    }
+    tables = exec_state->table_store()->GetTablets(plan_node_->TableName());
+  } else {
+    auto table = exec_state->table_store()->GetTable(plan_node_->TableName(), plan_node_->Tablet());
+    DCHECK(table != nullptr);
+    if (table != nullptr) {
+      tables.push_back(table);
+    }
+  }
+  if (tables.empty()) {
     return error::NotFound("Table '$0' not found", plan_node_->TableName());
   }
+
+  // The time range is looked up in each tablet, so that the tablets read only their own rows in
+  // it, and skip the batches outside of it.
+  for (auto table : tables) {
+    table->RecordRead();
+    TabletScan tablet;
+    tablet.table = table;
+    if (plan_node_->HasStartTime()) {
+      tablet.start_batch_info = table->FindBatchPositionGreaterThanOrEqual(
+          plan_node_->start_time(), exec_state->exec_mem_pool());
+
+      // TODO(philkuz) might have a race condition where the data hasn't loaded yet for the
+      // start_time.
+
+      // If start batch_idx == -1, no batches exist with a timestamp greater than or equal to the
+      // given start time.
+      tablet.begin = !tablet.start_batch_info.FoundValidBatches()
+                         ? std::numeric_limits<int64_t>::max()
+                         : tablet.start_batch_info.batch_idx;
+    }
+    // The stop time is exclusive. Infinite streams keep reading new data, so they ignore it.
+    if (plan_node_->HasStopTime() && !infinite_stream_) {
+      // The table's batch search uses the per-batch zone maps, so only the batch holding the stop
+      // time has its time column materialized.
+      tablet.stop_batch_info = table->FindBatchPositionGreaterThanOrEqual(
+          plan_node_->stop_time(), exec_state->exec_mem_pool());
+    }
+    tablets_.push_back(tablet);
+  }
+  table_ = tablets_.front().table;
+  current_batch_ = tablets_.front().begin;
   // Determine number of chunks at Open() time
   // because Stirling may be pushing to the table
   num_batches_ = table_->NumBatches();
 
-  if (plan_node_->HasStartTime()) {
-    start_batch_info_ = table_->FindBatchPositionGreaterThanOrEqual(plan_node_->start_time(),
-                                                                    exec_state->exec_mem_pool());
+  auto relation = table_->GetRelation();
+  for (const auto& predicate_pb : plan_node_->predicates()) {
+    if (predicate_pb.column_idx() < 0 ||
+        predicate_pb.column_idx() >= static_cast<int64_t>(relation.NumColumns())) {
+      return error::InvalidArgument("Predicate column $0 is out of range for table '$1'",
+                                    predicate_pb.column_idx(), plan_node_->TableName());
+    }
+    PL_ASSIGN_OR_RETURN(auto predicate,
+                        ColumnPredicate::Create(predicate_pb,
+                                                relation.GetColumnType(predicate_pb.column_idx())));
+    predicate_cols_.push_back(predicate.column_idx());
+    predicates_.push_back(std::move(predicate));
+  }
 
-    // TODO(philkuz) might have a race condition where the data hasn't loaded yet for the
-    // start_time.
+  double sample_fraction = plan_node_->sample_fraction();
+  if (sample_fraction < 0 || sample_fraction > 1) {
+    return error::InvalidArgument("Sample fraction $0 of table '$1' isn't in [0, 1]",
+                                  sample_fraction, plan_node_->TableName());
+  }
+  sampled_ = sample_fraction > 0 && sample_fraction < 1;
+  sample_threshold_ = static_cast<uint64_t>(
+      sample_fraction * static_cast<double>(std::numeric_limits<uint64_t>::max()));
 
-    // If start batch_idx == -1, no batches exist with a timestamp greater than or equal to the
-    // given start time.
-    current_batch_ = !start_batch_info_.FoundValidBatches() ? std::numeric_limits<int64_t>::max()
-                                                            : start_batch_info_.batch_idx;
+  shared_scan_key_ = absl::StrCat(absl::StrJoin(plan_node_->Columns(), ","), ";",
+                                  FLAGS_carnot_dictionary_strings);
+  for (const auto& predicate_pb : plan_node_->predicates()) {
+    absl::StrAppend(&shared_scan_key_, ";", predicate_pb.SerializeAsString());
   }
 
   return Status::OK();
@@ -78,52 +150,322 @@ Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
 
 Status MemorySourceNode::CloseImpl(ExecState*) {
   stats()->AddExtraInfo("infinite_stream", infinite_stream_ ? "true" : "false");
+  stats()->AddExtraMetric("shared_scan_batches", num_shared_batches_.load());
+  stats()->AddExtraMetric("fragment_cache_hits", num_fragment_cache_hits_);
   return Status::OK();
 }
 
+bool MemorySourceNode::PastStopTime() const {
+  const auto& stop_batch_info = tablets_[current_tablet_].stop_batch_info;
+  return stop_batch_info.FoundValidBatches() && current_batch_ >= stop_batch_info.batch_idx &&
+         (current_batch_ > stop_batch_info.batch_idx || stop_batch_info.row_idx == 0);
+}
+
+bool MemorySourceNode::BatchMayMatch(const TabletScan& tablet, int64_t batch_idx) const {
+  if (sampled_) {
+    // The node id is part of the hash so that two sampled scans of a query pick different sets.
+    auto key = std::make_pair(tablet.table->BatchRef(batch_idx).get(), plan_node_->id());
+    if (static_cast<uint64_t>(absl::Hash<decltype(key)>()(key)) > sample_threshold_) {
+      return false;
+    }
+  }
+  for (const auto& predicate : predicates_) {
+    if (!predicate.MayMatch(tablet.table->GetColumnZone(batch_idx, predicate.column_idx()))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+StatusOr<int64_t> MemorySourceNode::EvaluatePredicates(const RowBatch& predicate_batch,
+                                                       std::vector<bool>* selected) const {
+  for (const auto& [i, predicate] : Enumerate(predicates_)) {
+    predicate.Apply(*predicate_batch.ColumnAt(i), selected);
+  }
+  return std::count(selected->begin(), selected->end(), true);
+}
+
 StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState* exec_state) {
   DCHECK(table_ != nullptr);
+  if (!pending_batches_.empty()) {
+    auto row_batch = std::move(pending_batches_.front());
+    pending_batches_.pop_front();
+    return row_batch;
+  }
 
-  if (current_batch_ >= table_->NumBatches()) {
-    return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ true, /* eos */ true);
+  while (true) {
+    // Skip the batches that are left out of the sample or that the zone maps rule out, without
+    // reading any of their columns.
+    while ((sampled_ || !predicates_.empty()) && !TabletDone() && current_batch_ != run_end_ &&
+           !BatchMayMatch(tablets_[current_tablet_], current_batch_)) {
+      current_batch_++;
+    }
+    if (!TabletDone() || current_tablet_ + 1 == tablets_.size()) {
+      break;
+    }
+    // Move on to the next tablet.
+    ++current_tablet_;
+    table_ = tablets_[current_tablet_].table;
+    current_batch_ = tablets_[current_tablet_].begin;
+  }
+  if (current_batch_ == run_end_) {
+    // Runs end before the end of the scan, and the run is finished before the next one is read.
+    return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ false, /* eos */ false);
   }
 
-  auto offset = 0;
-  auto end = -1;
-  if (plan_node_->HasStartTime() && current_batch_ == start_batch_info_.batch_idx) {
-    offset = start_batch_info_.row_idx;
+  if (TabletDone()) {
+    if (infinite_stream_) {
+      return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ false, /* eos */ false);
+    }
+    return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ true, /* eos */ true);
   }
 
-  // TODO(michellenguyen, PL-388): Fix our table store to correctly support hot/cold data. For now,
-  // do not support StopTime.
   PL_ASSIGN_OR_RETURN(auto row_batch,
-                      table_->GetRowBatchSlice(current_batch_, plan_node_->Columns(),
-                                               exec_state->exec_mem_pool(), offset, end));
-
-  rows_processed_ += row_batch->num_rows();
+                      ReadBatch(exec_state, tablets_[current_tablet_], current_batch_));
+  rows_processed_ += row_batch->num_selected_rows();
   bytes_processed_ += row_batch->NumBytes();
   current_batch_++;
 
   // If infinite stream is set, we don't send Eow or Eos. Infinite streams therefore never cause
   // HasBatchesRemaining to be false. Instead the outer loop that calls GenerateNext() is
   // responsible for managing whether we continue the stream or end it.
-  if (current_batch_ >= table_->NumBatches() && !infinite_stream_) {
+  if (TabletDone() && current_tablet_ + 1 == tablets_.size() && !infinite_stream_) {
     row_batch->set_eow(true);
     row_batch->set_eos(true);
   }
+
+  // The batches of cached runs have to be sent whole, for the run to end with its last batch.
+  if (!batch_sizer_->enabled() || fragment_cache_ != nullptr) {
+    return row_batch;
+  }
+  batch_sizer_->Observe(*row_batch);
+  int64_t max_rows = batch_sizer_->RowsPerBatch();
+  if (row_batch->num_selected_rows() <= max_rows) {
+    return row_batch;
+  }
+  PL_ASSIGN_OR_RETURN(auto batches, BatchSizer::Split(*row_batch, max_rows));
+  for (size_t i = 1; i < batches.size(); ++i) {
+    pending_batches_.push_back(std::move(batches[i]));
+  }
+  return std::move(batches[0]);
+}
+
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::ReadBatch(ExecState* exec_state,
+                                                                const TabletScan& tablet,
+                                                                int64_t batch_idx) const {
+  auto offset = 0;
+  auto end = -1;
+  if (plan_node_->HasStartTime() && batch_idx == tablet.start_batch_info.batch_idx) {
+    offset = tablet.start_batch_info.row_idx;
+  }
+  if (tablet.stop_batch_info.FoundValidBatches() && batch_idx == tablet.stop_batch_info.batch_idx) {
+    end = tablet.stop_batch_info.row_idx;
+  }
+
+  SharedScanCoordinator* shared_scans = exec_state->shared_scans();
+  if (shared_scans == nullptr) {
+    return ReadBatchRows(exec_state, tablet, batch_idx, offset, end);
+  }
+  auto table = tablet.table;
+  auto batch_ref = table->BatchRef(batch_idx);
+  bool shared = false;
+  PL_ASSIGN_OR_RETURN(
+      auto row_batch,
+      shared_scans->Read(
+          batch_ref, absl::StrCat(shared_scan_key_, ";", offset, ";", end),
+          [&] { return ReadBatchRows(exec_state, tablet, batch_idx, offset, end); },
+          [&] { return table->BatchRef(batch_idx) == batch_ref; }, &shared));
+  if (shared) {
+    ++num_shared_batches_;
+  }
   return row_batch;
 }
 
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::ReadBatchRows(ExecState* exec_state,
+                                                                    const TabletScan& tablet,
+                                                                    int64_t batch_idx,
+                                                                    int64_t offset,
+                                                                    int64_t end) const {
+  if (predicates_.empty()) {
+    return tablet.table->GetRowBatchSlice(batch_idx, plan_node_->Columns(),
+                                          exec_state->exec_mem_pool(), offset, end,
+                                          FLAGS_carnot_dictionary_strings);
+  }
+  // The predicate columns are read first, and reused for the output. The rows that pass the
+  // predicates are selected rather than copied out of the columns, so wide columns (eg. request
+  // bodies) are only copied for the rows that reach a node that reads them, after downstream
+  // filters and limits have narrowed the selection.
+  return tablet.table->GetFilteredRowBatchSlice(
+      batch_idx, plan_node_->Columns(), predicate_cols_,
+      [this](const RowBatch& predicate_batch, std::vector<bool>* selected) {
+        return EvaluatePredicates(predicate_batch, selected);
+      },
+      exec_state->exec_mem_pool(), offset, end, FLAGS_carnot_dictionary_strings);
+}
+
+std::pair<int64_t, int64_t> MemorySourceNode::RemainingBatches(size_t tablet_idx) const {
+  const auto& tablet = tablets_[tablet_idx];
+  int64_t end = tablet.table->NumBatches();
+  if (tablet.stop_batch_info.FoundValidBatches()) {
+    // The batch holding the stop time is only read when some of its rows are before it.
+    int64_t stop_end =
+        tablet.stop_batch_info.batch_idx + (tablet.stop_batch_info.row_idx == 0 ? 0 : 1);
+    end = std::min(end, stop_end);
+  }
+  int64_t begin = tablet_idx == current_tablet_ ? current_batch_ : tablet.begin;
+  return {std::min(begin, end), end};
+}
+
+std::pair<int64_t, int64_t> MemorySourceNode::MorselBatches() {
+  DCHECK(SupportsMorsels());
+  DCHECK(pending_batches_.empty());
+  // The morsel batches of the current tablet are its own batch indexes, and those of the next
+  // tablets follow them.
+  morsel_tablets_.clear();
+  auto [begin, end] = RemainingBatches();
+  morsel_tablets_.push_back({&tablets_[current_tablet_], begin, begin});
+  for (size_t i = current_tablet_ + 1; i < tablets_.size(); ++i) {
+    auto [tablet_begin, tablet_end] = RemainingBatches(i);
+    if (tablet_begin == tablet_end) {
+      continue;
+    }
+    morsel_tablets_.push_back({&tablets_[i], end, tablet_begin});
+    end += tablet_end - tablet_begin;
+  }
+  return {begin, end};
+}
+
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::ReadMorselBatch(ExecState* exec_state,
+                                                                      int64_t batch_idx) const {
+  DCHECK(SupportsMorsels());
+  DCHECK(!morsel_tablets_.empty());
+  auto it = std::upper_bound(
+      morsel_tablets_.begin(), morsel_tablets_.end(), batch_idx,
+      [](int64_t idx, const MorselTablet& morsel_tablet) { return idx < morsel_tablet.begin; });
+  DCHECK(it != morsel_tablets_.begin());
+  const auto& morsel_tablet = *std::prev(it);
+  int64_t tablet_batch_idx = batch_idx - morsel_tablet.begin + morsel_tablet.batch_begin;
+  if (!BatchMayMatch(*morsel_tablet.tablet, tablet_batch_idx)) {
+    return std::unique_ptr<RowBatch>();
+  }
+  return ReadBatch(exec_state, *morsel_tablet.tablet, tablet_batch_idx);
+}
+
+Status MemorySourceNode::FinishMorselScan(ExecState* exec_state, int64_t rows, int64_t bytes) {
+  DCHECK(SupportsMorsels());
+  current_tablet_ = tablets_.size() - 1;
+  table_ = tablets_[current_tablet_].table;
+  current_batch_ = RemainingBatches().second;
+  rows_processed_ += rows;
+  bytes_processed_ += bytes;
+  return SendEndOfStream(exec_state);
+}
+
+void MemorySourceNode::EnableFragmentCache(FragmentCache* cache, AggNode* agg,
+                                           std::string fragment) {
+  DCHECK(table_ != nullptr && !infinite_stream_);
+  DCHECK_EQ(tablets_.size(), 1U);
+  DCHECK(agg->emits_partial_states());
+  fragment_cache_ = cache;
+  fragment_agg_ = agg;
+  fragment_ = std::move(fragment);
+  time_col_idx_ = table_->FindTimeColumn();
+}
+
+int64_t MemorySourceNode::FragmentRunEnd(int64_t begin, int64_t end) const {
+  // Fragment caches are only enabled on scans of a single tablet.
+  const auto& tablet = tablets_[current_tablet_];
+  if (time_col_idx_ < 0 ||
+      (plan_node_->HasStartTime() && begin == tablet.start_batch_info.batch_idx &&
+       tablet.start_batch_info.row_idx > 0)) {
+    return -1;
+  }
+  int64_t bucket_ns = FLAGS_carnot_fragment_cache_bucket_ms * 1000 * 1000;
+  int64_t bucket = 0;
+  int64_t idx = begin;
+  for (; idx < end; ++idx) {
+    // Only part of the batch holding the stop time is read.
+    if (tablet.stop_batch_info.FoundValidBatches() && idx == tablet.stop_batch_info.batch_idx) {
+      break;
+    }
+    auto zone = table_->GetColumnZone(idx, time_col_idx_);
+    if (!zone.has_range || zone.min / bucket_ns != zone.max / bucket_ns ||
+        (idx > begin && zone.min / bucket_ns != bucket)) {
+      break;
+    }
+    bucket = zone.min / bucket_ns;
+  }
+  // The last bucket of the scan can still get more batches, so it isn't cached until a batch past
+  // it shows up.
+  return idx > begin && idx < end ? idx : -1;
+}
+
+FragmentCache::BatchRefs MemorySourceNode::FragmentRunRefs(int64_t begin, int64_t end) const {
+  FragmentCache::BatchRefs refs;
+  for (int64_t idx = begin; idx < end; ++idx) {
+    refs.push_back(table_->BatchRef(idx));
+  }
+  return refs;
+}
+
+Status MemorySourceNode::StartFragmentRun(ExecState* exec_state) {
+  while (true) {
+    auto [begin, end] = RemainingBatches();
+    int64_t run_end = FragmentRunEnd(begin, end);
+    if (run_end < 0) {
+      return Status::OK();
+    }
+    auto refs = FragmentRunRefs(begin, run_end);
+    auto states = fragment_cache_->Get(fragment_, refs);
+    if (states == nullptr) {
+      // The states cached for the run must not include any other input.
+      if (agg_has_uncached_input_) {
+        PL_RETURN_IF_ERROR(fragment_agg_->EmitPartialStates(exec_state, /* emitted */ nullptr));
+        agg_has_uncached_input_ = false;
+      }
+      run_begin_ = begin;
+      run_end_ = run_end;
+      run_refs_ = std::move(refs);
+      return Status::OK();
+    }
+    PL_RETURN_IF_ERROR(fragment_agg_->SendPartialStates(exec_state, *states));
+    ++num_fragment_cache_hits_;
+    current_batch_ = run_end;
+  }
+}
+
+Status MemorySourceNode::FinishFragmentRun(ExecState* exec_state) {
+  std::unique_ptr<RowBatch> states;
+  PL_RETURN_IF_ERROR(fragment_agg_->EmitPartialStates(exec_state, &states));
+  // Expiring batches shifts the batch indices, so the run may have read other batches than the
+  // ones it started on.
+  if (FragmentRunRefs(run_begin_, run_end_) == run_refs_) {
+    fragment_cache_->Put(fragment_, run_refs_, std::move(states));
+  }
+  run_end_ = -1;
+  run_refs_.clear();
+  return Status::OK();
+}
+
 Status MemorySourceNode::GenerateNextImpl(ExecState* exec_state) {
+  if (fragment_cache_ != nullptr && run_end_ < 0) {
+    PL_RETURN_IF_ERROR(StartFragmentRun(exec_state));
+  }
   PL_ASSIGN_OR_RETURN(auto row_batch, GetNextRowBatch(exec_state));
   PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *row_batch));
+  if (run_end_ >= 0 && current_batch_ >= run_end_) {
+    PL_RETURN_IF_ERROR(FinishFragmentRun(exec_state));
+  } else if (run_end_ < 0) {
+    agg_has_uncached_input_ = true;
+  }
   return Status::OK();
 }
 
 bool MemorySourceNode::NextBatchReady() {
   // Next batch is ready if we haven't seen an eow and if it's an infinite_stream that has batches
   // to push.
-  return HasBatchesRemaining() && (!infinite_stream_ || (current_batch_ < table_->NumBatches()));
+  return HasBatchesRemaining() && (!infinite_stream_ || !pending_batches_.empty() ||
+                                   (current_batch_ < table_->NumBatches()));
 }
 
 }  // namespace exec
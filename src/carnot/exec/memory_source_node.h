@@ -19,18 +19,27 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "src/carnot/exec/agg_node.h"
+#include "src/carnot/exec/batch_sizer.h"
+#include "src/carnot/exec/column_predicate.h"
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/fragment_cache.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
 #include "src/table_store/schema/row_batch.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_bool(carnot_dictionary_strings);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -44,6 +53,43 @@ class MemorySourceNode : public SourceNode {
 
   bool NextBatchReady() override;
 
+  /**
+   * Morsel-driven scans. After Open(), a finite scan can be split into morsels of consecutive
+   * table batches, which are read concurrently with ReadMorselBatch(). FinishMorselScan() then
+   * ends the scan in place of GenerateNext(). The batches of a scan of all the tablets of a table
+   * follow each other in one range, so the workers spread over the tablets.
+   */
+  bool SupportsMorsels() const {
+    return table_ != nullptr && !infinite_stream_ && fragment_cache_ == nullptr;
+  }
+
+  /**
+   * Fixes the batches that are left to read for the morsels.
+   * @return the [begin, end) range of the batch indexes to pass to ReadMorselBatch().
+   */
+  std::pair<int64_t, int64_t> MorselBatches();
+
+  /**
+   * Reads a single batch of the scan, with the time range and the predicates applied. Returns
+   * nullptr when the zone maps rule out the whole batch. Safe to call from several threads.
+   */
+  StatusOr<std::unique_ptr<RowBatch>> ReadMorselBatch(ExecState* exec_state,
+                                                      int64_t batch_idx) const;
+
+  /**
+   * Marks all the remaining batches as read, records the rows and bytes read by the morsels, and
+   * sends the end of stream to the children.
+   */
+  Status FinishMorselScan(ExecState* exec_state, int64_t rows, int64_t bytes);
+
+  /**
+   * Fragment caching. After Open(), a finite scan that only feeds map/filter nodes into the
+   * partial aggregate agg can cache the partial states of agg for every time bucket of table
+   * batches in cache, and send them in place of reading the same batches again. fragment describes
+   * the chain from this source to agg, but for the time range.
+   */
+  void EnableFragmentCache(FragmentCache* cache, AggNode* agg, std::string fragment);
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -53,16 +99,102 @@ class MemorySourceNode : public SourceNode {
   Status GenerateNextImpl(ExecState* exec_state) override;
 
  private:
+  // A tablet of the table to read, with the time range of the scan resolved in it.
+  struct TabletScan {
+    table_store::Table* table = nullptr;
+    // Position of the first row at or past the start time.
+    table_store::BatchPosition start_batch_info;
+    // Position of the first row at or past the stop time. Batches beyond it are never read.
+    table_store::BatchPosition stop_batch_info = {-1, -1};
+    // The first batch to read, past the end of the tablet if none of it is after the start time.
+    int64_t begin = 0;
+  };
+  // The tablets of the morsel batches, see MorselBatches(). The morsel batches from begin are
+  // the table batches from batch_begin of the tablet.
+  struct MorselTablet {
+    const TabletScan* tablet;
+    int64_t begin;
+    int64_t batch_begin;
+  };
+
   StatusOr<std::unique_ptr<RowBatch>> GetNextRowBatch(ExecState* exec_state);
+  // Reads the rows of the batch that are in the time range and satisfy the predicates, sharing
+  // the read with the other queries that scan the same batch if shared scans are enabled.
+  StatusOr<std::unique_ptr<RowBatch>> ReadBatch(ExecState* exec_state, const TabletScan& tablet,
+                                                int64_t batch_idx) const;
+  // Reads rows [offset, end) of the batch that satisfy the predicates.
+  StatusOr<std::unique_ptr<RowBatch>> ReadBatchRows(ExecState* exec_state,
+                                                    const TabletScan& tablet, int64_t batch_idx,
+                                                    int64_t offset, int64_t end) const;
+  // Whether all rows before the stop time have been read.
+  bool PastStopTime() const;
+  // Whether the current tablet has no more rows to read, for now if the stream is infinite.
+  bool TabletDone() const { return current_batch_ >= table_->NumBatches() || PastStopTime(); }
+  // Whether the batch is in the sample, if the source samples the table, and the zone maps of the
+  // batch allow any of its rows to satisfy all of the predicates.
+  bool BatchMayMatch(const TabletScan& tablet, int64_t batch_idx) const;
+  // Evaluates the predicates on the predicate columns of a batch, in the order of predicate_cols_.
+  // Returns the number of selected rows.
+  StatusOr<int64_t> EvaluatePredicates(const RowBatch& predicate_batch,
+                                       std::vector<bool>* selected) const;
+  // The [begin, end) range of the batches of the tablet that are left to read.
+  std::pair<int64_t, int64_t> RemainingBatches(size_t tablet_idx) const;
+  std::pair<int64_t, int64_t> RemainingBatches() const { return RemainingBatches(current_tablet_); }
 
   int64_t num_batches_;
+  // The batch to read next in the current tablet.
   int64_t current_batch_ = 0;
   // Whether this memory source will stream infinitely. Can be stopped by the
   // exec_state_->keep_running() call in exec_graph.
   bool infinite_stream_ = false;
-  table_store::BatchPosition start_batch_info_;
+  // The tablets to read, in order. Only one unless the plan reads all the tablets of the table.
+  std::vector<TabletScan> tablets_;
+  size_t current_tablet_ = 0;
+  std::vector<MorselTablet> morsel_tablets_;
+  // Predicates pushed down from a filter by the planner, and the table columns they read.
+  std::vector<ColumnPredicate> predicates_;
+  std::vector<int64_t> predicate_cols_;
+  // Set when the source only reads a sample of the batches. The batches whose hash is at most
+  // sample_threshold_ are in the sample.
+  bool sampled_ = false;
+  uint64_t sample_threshold_ = 0;
+  // Splits the batches that are larger than the byte budget of the batch sizer, when it's enabled
+  // and the scan isn't cached. The rest of a split batch waits in pending_batches_.
+  std::unique_ptr<BatchSizer> batch_sizer_;
+  std::deque<std::unique_ptr<RowBatch>> pending_batches_;
+  // Everything but the batch and its row range that determines what a read returns, so that
+  // queries doing the same reads can share them.
+  std::string shared_scan_key_;
+  // The number of batches that were read by another query.
+  mutable std::atomic<int64_t> num_shared_batches_{0};
+
+  // Fragment caching, see EnableFragmentCache(). The scan is split into runs of whole batches in
+  // the same time bucket, and the partial states of each run are emitted and cached on their own.
+  //
+  // Sends the cached states of the runs at the current batch, and starts the first run that isn't
+  // cached.
+  Status StartFragmentRun(ExecState* exec_state);
+  // Emits and caches the partial states of the run that was just read.
+  Status FinishFragmentRun(ExecState* exec_state);
+  // Returns the end of the run that starts at batch begin, or -1 if there isn't a complete run of
+  // whole batches before end.
+  int64_t FragmentRunEnd(int64_t begin, int64_t end) const;
+  FragmentCache::BatchRefs FragmentRunRefs(int64_t begin, int64_t end) const;
+
+  FragmentCache* fragment_cache_ = nullptr;
+  AggNode* fragment_agg_ = nullptr;
+  std::string fragment_;
+  int64_t time_col_idx_ = -1;
+  // The batches of the run being read. run_end_ is -1 outside of runs.
+  int64_t run_begin_ = 0;
+  int64_t run_end_ = -1;
+  FragmentCache::BatchRefs run_refs_;
+  // Whether the aggregate consumed batches outside of runs since it last emitted.
+  bool agg_has_uncached_input_ = false;
+  int64_t num_fragment_cache_hits_ = 0;
 
   std::unique_ptr<plan::MemorySourceOperator> plan_node_;
+  // The table of the current tablet.
   table_store::Table* table_ = nullptr;
 };
 
@@ -154,8 +154,7 @@ TEST_F(MemorySourceNodeTest, added_batch) {
   EXPECT_EQ(sizeof(int64_t) * 5, tester.node()->BytesProcessed());
 }
 
-// TODO(michellenguyen, PL-388): Re-enable this test when StopTime for range is fixed.
-TEST_F(MemorySourceNodeTest, DISABLED_range) {
+TEST_F(MemorySourceNodeTest, range) {
   auto op_proto = planpb::testutils::CreateTestSourceRangePB();
   std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
   RowDescriptor output_rd({types::DataType::TIME64NS});
@@ -217,6 +216,143 @@ TEST_F(MemorySourceNodeTest, all_range) {
   tester.Close();
 }
 
+TEST_F(MemorySourceNodeTest, predicates) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  auto* predicate = op_proto.mutable_mem_source_op()->add_predicates();
+  predicate->set_column_idx(1);
+  predicate->set_op(planpb::ColumnPredicate::GE);
+  predicate->mutable_value()->set_time64_ns_value(2);
+  predicate = op_proto.mutable_mem_source_op()->add_predicates();
+  predicate->set_column_idx(1);
+  predicate->set_op(planpb::ColumnPredicate::NE);
+  predicate->mutable_value()->set_time64_ns_value(5);
+
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({2, 3})
+          .get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 1, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(3, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTest, predicates_skip_batches) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  auto* predicate = op_proto.mutable_mem_source_op()->add_predicates();
+  predicate->set_column_idx(1);
+  predicate->set_op(planpb::ColumnPredicate::GT);
+  predicate->mutable_value()->set_time64_ns_value(3);
+
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  // The zone map of the first batch rules it out, so the first result is the second batch.
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+}
+
+TEST_F(MemorySourceNodeTest, sample_skips_batches) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  // Small enough that no batch makes it into the sample.
+  op_proto.mutable_mem_source_op()->set_sample_fraction(1e-300);
+
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 0, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(0, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTest, invalid_sample_fraction) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  op_proto.mutable_mem_source_op()->set_sample_fraction(1.5);
+
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  MemorySourceNode node;
+  ASSERT_OK(node.Init(*plan_node, output_rd, {}));
+  ASSERT_OK(node.Prepare(exec_state_.get()));
+  EXPECT_NOT_OK(node.Open(exec_state_.get()));
+}
+
+TEST_F(MemorySourceNodeTest, target_batch_bytes_splits_batches) {
+  auto table = Table::Create(cpu_table_->GetRelation());
+  std::vector<types::BoolValue> col1(100, true);
+  std::vector<types::Int64Value> times(100);
+  for (int64_t i = 0; i < 100; ++i) {
+    times[i] = i;
+  }
+  EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(col1, arrow::default_memory_pool())));
+  EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(times, arrow::default_memory_pool())));
+  exec_state_->table_store()->AddTable("big", table);
+
+  auto target_batch_bytes = FLAGS_carnot_target_batch_bytes;
+  // 64 rows of the single time column.
+  FLAGS_carnot_target_batch_bytes = 64 * sizeof(int64_t);
+
+  auto op_proto = planpb::testutils::CreateTestSource1PB("big");
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  std::vector<types::Time64NSValue> first(times.begin(), times.begin() + 64);
+  std::vector<types::Time64NSValue> rest(times.begin() + 64, times.end());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 64, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>(first)
+          .get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 36, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>(rest)
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(100, tester.node()->RowsProcessed());
+
+  FLAGS_carnot_target_batch_bytes = target_batch_bytes;
+}
+
+TEST_F(MemorySourceNodeTest, predicate_type_mismatch) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  auto* predicate = op_proto.mutable_mem_source_op()->add_predicates();
+  predicate->set_column_idx(1);
+  predicate->set_op(planpb::ColumnPredicate::EQ);
+  predicate->mutable_value()->set_string_value("abc");
+
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  MemorySourceNode node;
+  ASSERT_OK(node.Init(*plan_node, output_rd, {}));
+  ASSERT_OK(node.Prepare(exec_state_.get()));
+  EXPECT_NOT_OK(node.Open(exec_state_.get()));
+}
+
 class MemorySourceNodeTabletTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -317,6 +453,67 @@ TEST_F(MemorySourceNodeTabletTest, multiple_tablet_test) {
   EXPECT_EQ(0, tester.node()->BytesProcessed());
 }
 
+// Test that all the tablets of a table are read, each in the time range of the scan.
+TEST_F(MemorySourceNodeTabletTest, all_tablets) {
+  std::shared_ptr<Table> new_tablet = Table::Create(rel);
+  AddValuesToTable(new_tablet.get());
+  exec_state_->table_store()->AddTable(new_tablet, table_name_, table_id_, "456");
+
+  auto op_proto = planpb::testutils::CreateTestSourceRangePB();
+  op_proto.mutable_mem_source_op()->set_all_tablets(true);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  for (int tablet = 0; tablet < 2; ++tablet) {
+    EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+    tester.GenerateNextResult().ExpectRowBatch(
+        RowBatchBuilder(output_rd, 1, /*eow*/ false, /*eos*/ false)
+            .AddColumn<types::Time64NSValue>({3})
+            .get());
+    EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+    bool last_tablet = tablet == 1;
+    tester.GenerateNextResult().ExpectRowBatch(
+        RowBatchBuilder(output_rd, 1, /*eow*/ last_tablet, /*eos*/ last_tablet)
+            .AddColumn<types::Time64NSValue>({5})
+            .get());
+  }
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(4, tester.node()->RowsProcessed());
+}
+
+// Test that the morsels of a scan of all the tablets cover the batches of every tablet.
+TEST_F(MemorySourceNodeTabletTest, all_tablets_morsels) {
+  std::shared_ptr<Table> new_tablet = Table::Create(rel);
+  AddValuesToTable(new_tablet.get());
+  exec_state_->table_store()->AddTable(new_tablet, table_name_, table_id_, "456");
+
+  auto op_proto = planpb::testutils::CreateTestSourceRangePB();
+  op_proto.mutable_mem_source_op()->set_all_tablets(true);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  ASSERT_TRUE(tester.node()->SupportsMorsels());
+  auto [begin, end] = tester.node()->MorselBatches();
+  EXPECT_EQ(0, begin);
+  EXPECT_EQ(4, end);
+
+  std::vector<int64_t> times;
+  for (int64_t batch_idx = begin; batch_idx < end; ++batch_idx) {
+    ASSERT_OK_AND_ASSIGN(auto rb, tester.node()->ReadMorselBatch(exec_state_.get(), batch_idx));
+    ASSERT_NE(rb, nullptr);
+    auto col = static_cast<arrow::Int64Array*>(rb->ColumnAt(0).get());
+    for (int64_t i = 0; i < col->length(); ++i) {
+      times.push_back(col->Value(i));
+    }
+  }
+  EXPECT_THAT(times, ::testing::ElementsAre(3, 5, 3, 5));
+}
+
 using MemorySourceNodeTabletDeathTest = MemorySourceNodeTabletTest;
 TEST_F(MemorySourceNodeTabletDeathTest, missing_tablet_fails) {
   types::TabletID non_existant_tablet_value = "223";
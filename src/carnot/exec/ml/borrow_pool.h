@@ -17,17 +17,21 @@
  */
 
 #pragma once
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
-#include <absl/base/internal/spinlock.h>
-
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
+/**
+ * A pool of objects that are borrowed for exclusive use and returned to the pool when the borrowed
+ * pointer is destroyed.
+ */
 template <typename T>
 class BorrowPool {
  public:
@@ -35,40 +39,56 @@ class BorrowPool {
   struct ReclaimDeleter {
     void operator()(T* ptr) {
       if (ptr != nullptr) {
-        absl::base_internal::SpinLockHolder l(pool_lock_);
-        StoredPtrType stored_ptr(ptr);
-        pool_->push_back(std::move(stored_ptr));
+        pool_->Add(StoredPtrType(ptr));
       }
     }
-    std::vector<StoredPtrType>* pool_;
-    absl::base_internal::SpinLock* pool_lock_;
+    BorrowPool* pool_;
   };
   using BorrowedPtrType = std::unique_ptr<T, ReclaimDeleter>;
 
   void Add(StoredPtrType ptr) {
-    absl::base_internal::SpinLockHolder l(&pool_lock_);
-    pool_.push_back(std::move(ptr));
+    {
+      std::lock_guard<std::mutex> l(pool_lock_);
+      pool_.push_back(std::move(ptr));
+    }
+    available_.notify_one();
   }
 
+  /**
+   * @return a borrowed object, or nullptr if they are all borrowed.
+   */
   BorrowedPtrType Borrow() {
-    absl::base_internal::SpinLockHolder l(&pool_lock_);
+    std::lock_guard<std::mutex> l(pool_lock_);
     if (pool_.size() == 0) {
       return nullptr;
     }
-    auto raw_ptr = pool_.back().release();
-    pool_.pop_back();
-    BorrowedPtrType ptr(raw_ptr, ReclaimDeleter{&pool_, &pool_lock_});
-    return ptr;
+    return TakeLocked();
+  }
+
+  /**
+   * Waits until an object is returned to the pool if they are all borrowed.
+   */
+  BorrowedPtrType BorrowWait() {
+    std::unique_lock<std::mutex> l(pool_lock_);
+    available_.wait(l, [this] { return !pool_.empty(); });
+    return TakeLocked();
   }
 
   size_t Size() {
-    absl::base_internal::SpinLockHolder l(&pool_lock_);
+    std::lock_guard<std::mutex> l(pool_lock_);
     return pool_.size();
   }
 
  private:
-  std::vector<StoredPtrType> pool_ GUARDED_BY(pool_lock_);
-  absl::base_internal::SpinLock pool_lock_;
+  BorrowedPtrType TakeLocked() {
+    auto raw_ptr = pool_.back().release();
+    pool_.pop_back();
+    return BorrowedPtrType(raw_ptr, ReclaimDeleter{this});
+  }
+
+  std::vector<StoredPtrType> pool_;
+  std::mutex pool_lock_;
+  std::condition_variable available_;
 };
 
 }  // namespace ml
@@ -51,6 +51,27 @@ TEST(BorrowPool, basic) {
   EXPECT_NE(ptr3, nullptr);
 }
 
+TEST(BorrowPool, borrow_wait) {
+  BorrowPool<int> pool;
+  pool.Add(BorrowPool<int>::StoredPtrType(new int(1)));
+  auto ptr1 = pool.BorrowWait();
+  ASSERT_NE(ptr1, nullptr);
+
+  std::atomic<bool> borrowed = false;
+  std::thread thread([&borrowed, &pool] {
+    auto ptr2 = pool.BorrowWait();
+    EXPECT_EQ(1, *ptr2);
+    borrowed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(borrowed);
+  // Returning the item hands it off to the waiting thread.
+  ptr1.reset();
+  thread.join();
+  EXPECT_TRUE(borrowed);
+  EXPECT_EQ(1, pool.Size());
+}
+
 // Test to check for data races with ASAN/TSAN
 TEST(BorrowPool, threaded) {
   BorrowPool<int> pool;
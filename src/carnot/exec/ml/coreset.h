@@ -160,8 +160,12 @@ class CoresetTree {
  public:
   /**
    * r-way Coreset Tree.
+   * If max_levels is nonzero, the tree never grows past max_levels levels: once the top level
+   * fills up it is reduced back into a single coreset on that same level. This caps the tree at
+   * max_levels * r * coreset_size points no matter how many points are streamed through it.
    **/
-  CoresetTree(size_t r, size_t coreset_size) : coreset_size_(coreset_size), r_(r) {}
+  CoresetTree(size_t r, size_t coreset_size, size_t max_levels = 0)
+      : coreset_size_(coreset_size), r_(r), max_levels_(max_levels) {}
 
   void Update(std::shared_ptr<WeightedPointSet> set) {
     if (levels_.size() == 0) {
@@ -169,14 +173,8 @@ class CoresetTree {
     }
     levels_[0].push_back(set);
     auto i = 0UL;
-    while (levels_[i].size() >= r_) {
-      auto merged =
-          TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
-      levels_[i].clear();
-      if (levels_.size() <= i + 1) {
-        levels_.emplace_back();
-      }
-      levels_[i + 1].push_back(std::move(merged));
+    while (i < levels_.size() && levels_[i].size() >= r_) {
+      ReduceLevel(i);
       i++;
     }
   }
@@ -195,28 +193,26 @@ class CoresetTree {
   }
 
   void Merge(const CoresetTree<TCoreset>& other) {
-    for (auto i = 0UL; i < levels_.size(); i++) {
-      if (i < other.levels_.size() && other.levels_[i].size() > 0) {
-        levels_[i].insert(levels_[i].end(), other.levels_[i].begin(), other.levels_[i].end());
-      }
+    if (levels_.size() < other.levels_.size()) {
+      levels_.resize(other.levels_.size());
     }
-    for (auto i = levels_.size(); i < other.levels_.size(); i++) {
-      if (other.levels_[i].size() > 0) {
-        levels_.emplace_back();
-        levels_[i].insert(levels_[i].end(), other.levels_[i].begin(), other.levels_[i].end());
+    for (auto i = 0UL; i < other.levels_.size(); i++) {
+      levels_[i].insert(levels_[i].end(), other.levels_[i].begin(), other.levels_[i].end());
+    }
+    // The other tree might have been built with a larger cap, so fold any levels past ours into
+    // the top level.
+    if (max_levels_ > 0 && levels_.size() > max_levels_) {
+      for (auto i = max_levels_; i < levels_.size(); i++) {
+        auto& top = levels_[max_levels_ - 1];
+        top.insert(top.end(), levels_[i].begin(), levels_[i].end());
       }
+      levels_.resize(max_levels_);
     }
 
     // Fix the r-way tree by coresetting any levels that have r or more buckets after merge.
     for (auto i = 0UL; i < levels_.size(); i++) {
       if (levels_[i].size() >= r_) {
-        auto merged =
-            TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
-        levels_[i].clear();
-        if (i == levels_.size() - 1) {
-          levels_.emplace_back();
-        }
-        levels_[i + 1].push_back(std::move(merged));
+        ReduceLevel(i);
       }
     }
   }
@@ -227,6 +223,8 @@ class CoresetTree {
     writer->Uint(coreset_size_);
     writer->Key("r");
     writer->Uint(r_);
+    writer->Key("max_levels");
+    writer->Uint(max_levels_);
     writer->Key("levels");
     writer->StartObject();
     for (auto i = 0UL; i < levels_.size(); i++) {
@@ -253,6 +251,8 @@ class CoresetTree {
     DCHECK(doc["levels"].IsObject());
     coreset_size_ = doc["coreset_size"].GetUint();
     r_ = doc["r"].GetUint();
+    // Trees serialized before the cap was added have no max_levels.
+    max_levels_ = doc.HasMember("max_levels") ? doc["max_levels"].GetUint() : 0;
     levels_.clear();
 
     for (rapidjson::Value::ConstMemberIterator itr = doc["levels"].MemberBegin();
@@ -274,8 +274,25 @@ class CoresetTree {
   }
 
  private:
+  // Coresets the buckets on level i into a single bucket. The bucket moves up a level, unless
+  // level i is the highest level allowed, in which case it stays on level i.
+  void ReduceLevel(size_t i) {
+    auto merged =
+        TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
+    levels_[i].clear();
+    if (max_levels_ > 0 && i + 1 >= max_levels_) {
+      levels_[i].push_back(std::move(merged));
+      return;
+    }
+    if (levels_.size() <= i + 1) {
+      levels_.emplace_back();
+    }
+    levels_[i + 1].push_back(std::move(merged));
+  }
+
   size_t coreset_size_;
   size_t r_;
+  size_t max_levels_;
   std::vector<Level> levels_;
 };
 
@@ -53,6 +53,17 @@ static void BM_CoresetTreeQuery(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CoresetTreeUpdateMaxLevels(benchmark::State& state) {
+  int d = 64;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64, /*max_levels*/ 2);
+  Eigen::VectorXf point = Eigen::VectorXf::Random(d);
+
+  for (auto _ : state) {
+    driver.Update(point);
+  }
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_CoresetTreeMerge(benchmark::State& state) {
   int d = 64;
@@ -112,6 +123,7 @@ static void BM_CoresetDeserialize(benchmark::State& state) {
 }
 
 BENCHMARK(BM_CoresetTreeUpdate);
+BENCHMARK(BM_CoresetTreeUpdateMaxLevels);
 BENCHMARK(BM_CoresetFromWeightedPointSet);
 BENCHMARK(BM_CoresetTreeQuery);
 BENCHMARK(BM_CoresetTreeMerge);
@@ -105,6 +105,36 @@ TEST(CoresetDriver, serialization) {
   EXPECT_EQ(256, point_set->size());
 }
 
+TEST(CoresetDriver, max_levels) {
+  // Same as above, but the tree is capped at 2 levels.
+  int d = 8;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64, /*max_levels*/ 2);
+  // Without the cap, 64 buckets would leave 1 bucket on the 4th level.
+  for (int i = 0; i < 64 * 64; i++) {
+    driver.Update(Eigen::VectorXf::Random(d));
+  }
+  // Every 4 buckets on the second level get reduced back into 1 bucket on that level, so the
+  // second level should only ever hold between 1 and 3 buckets.
+  auto size = driver.Query()->size();
+  EXPECT_GE(size, 64);
+  EXPECT_LE(size, 3 * 64);
+  for (int i = 0; i < 64 * 64; i++) {
+    driver.Update(Eigen::VectorXf::Random(d));
+  }
+  EXPECT_LE(driver.Query()->size(), 3 * 64 + 3 * 64);
+
+  // Merging with an uncapped tree folds its higher levels into the capped tree's top level.
+  CoresetDriver<CoresetTree<KMeansCoreset>> uncapped(64, d, 4, 64);
+  for (int i = 0; i < 64 * 64; i++) {
+    uncapped.Update(Eigen::VectorXf::Random(d));
+  }
+  driver.Merge(uncapped);
+  EXPECT_LE(driver.Query()->size(), 3 * 64 + 3 * 64);
+
+  // The weights of the coreset should still roughly account for every point.
+  EXPECT_NEAR(3 * 64 * 64, driver.Query()->weights().sum(), 3 * 64 * 64 * 0.5);
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -26,6 +26,15 @@ namespace carnot {
 namespace exec {
 namespace ml {
 
+void SquaredDistances(const Eigen::MatrixXf& points, const Eigen::MatrixXf& centroids,
+                      Eigen::MatrixXf* dists) {
+  dists->noalias() = -2.0f * points * centroids.transpose();
+  dists->colwise() += points.rowwise().squaredNorm();
+  dists->rowwise() += centroids.rowwise().squaredNorm().transpose();
+  // Cancellation can leave tiny negative values for points sitting on a centroid.
+  *dists = dists->cwiseMax(0.0f);
+}
+
 void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
   if (set->size() < 2) {
     LOG(ERROR) << "Fitting KMeans on less than 2 points is currently unsupported.";
@@ -52,12 +61,11 @@ bool KMeans::LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorX
   Eigen::MatrixXf new_centroids = Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols());
   Eigen::ArrayXf centroid_weights = Eigen::ArrayXf::Zero(centroids_.rows());
 
+  Eigen::MatrixXf dists;
+  SquaredDistances(points, centroids_, &dists);
   for (int i = 0; i < points.rows(); i++) {
     Eigen::VectorXf::Index closest_centroid;
-    (centroids_.rowwise() - points(i, Eigen::all))
-        .rowwise()
-        .squaredNorm()
-        .minCoeff(&closest_centroid);
+    dists.row(i).minCoeff(&closest_centroid);
     new_centroids(closest_centroid, Eigen::all) += weights(i) * points(i, Eigen::all);
     centroid_weights(closest_centroid) += weights(i);
   }
@@ -82,20 +90,24 @@ void KMeans::KMeansPlusPlusInit(const Eigen::MatrixXf& points, const Eigen::Vect
   auto firstCentroid = dist(random_gen_);
   centroids_(0, Eigen::all) = points(firstCentroid, Eigen::all);
 
-  Eigen::VectorXf probDist(points.rows());
+  // Distance from each point to its closest centroid so far. Only the distances to the newest
+  // centroid need to be computed each round, instead of the distances to all of them.
+  Eigen::ArrayXf minDists =
+      (points.rowwise() - centroids_(0, Eigen::all)).rowwise().squaredNorm().array();
+  Eigen::ArrayXf probDist(points.rows());
   for (auto i = 1; i < k_; i++) {
-    for (auto j = 0; j < probDist.rows(); j++) {
-      auto point = points(j, Eigen::all);
-      Eigen::VectorXf::Index closestCentroid;
-      auto dist = (centroids_(Eigen::seq(0, i - 1), Eigen::all).rowwise() - point)
-                      .rowwise()
-                      .squaredNorm()
-                      .minCoeff(&closestCentroid);
-      probDist(j) = weights(j) * dist;
+    probDist = weights.array() * minDists;
+    int ind;
+    if (probDist.sum() > 0.0f) {
+      std::discrete_distribution<> pointDist(probDist.begin(), probDist.end());
+      ind = pointDist(random_gen_);
+    } else {
+      // Every point already coincides with a centroid.
+      ind = dist(random_gen_);
     }
-    std::discrete_distribution<> pointDist(probDist.begin(), probDist.end());
-    auto ind = pointDist(random_gen_);
     centroids_(i, Eigen::all) = points(ind, Eigen::all);
+    minDists = minDists.min(
+        (points.rowwise() - centroids_(i, Eigen::all)).rowwise().squaredNorm().array());
   }
 }
 
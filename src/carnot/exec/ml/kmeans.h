@@ -29,6 +29,14 @@ namespace carnot {
 namespace exec {
 namespace ml {
 
+/**
+ * Computes the squared euclidean distance between every row of points and every row of centroids,
+ * using ||p||^2 - 2 p.c + ||c||^2 so that the bulk of the work is a single matrix product.
+ * dists(i, j) is the distance from points(i) to centroids(j).
+ **/
+void SquaredDistances(const Eigen::MatrixXf& points, const Eigen::MatrixXf& centroids,
+                      Eigen::MatrixXf* dists);
+
 class KMeans {
  public:
   enum KMeansInitType {
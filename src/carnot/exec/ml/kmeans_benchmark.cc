@@ -27,8 +27,8 @@ using px::carnot::exec::ml::WeightedPointSet;
 
 // NOLINTNEXTLINE : runtime/references.
 static void BM_KMeansFit(benchmark::State& state) {
-  int k = 10;
-  int d = 64;
+  int k = state.range(0);
+  int d = state.range(1);
   KMeans kmeans(k);
 
   Eigen::MatrixXf points = Eigen::MatrixXf::Random(500, d);
@@ -58,5 +58,5 @@ static void BM_KMeansTransform(benchmark::State& state) {
   }
 }
 
-BENCHMARK(BM_KMeansFit);
+BENCHMARK(BM_KMeansFit)->Ranges({{10, 40}, {16, 256}});
 BENCHMARK(BM_KMeansTransform);
@@ -96,6 +96,37 @@ TEST(KMeans, trimodal_normal_dist) {
   }
 }
 
+TEST(KMeans, squared_distances) {
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(10, 4);
+  Eigen::MatrixXf centroids = Eigen::MatrixXf::Random(3, 4);
+  centroids.row(1) = points.row(7);
+
+  Eigen::MatrixXf dists;
+  SquaredDistances(points, centroids, &dists);
+  ASSERT_EQ(10, dists.rows());
+  ASSERT_EQ(3, dists.cols());
+  for (int i = 0; i < points.rows(); i++) {
+    for (int j = 0; j < centroids.rows(); j++) {
+      EXPECT_NEAR((points.row(i) - centroids.row(j)).squaredNorm(), dists(i, j), 1e-5);
+    }
+  }
+  EXPECT_GE(dists(7, 1), 0.0f);
+}
+
+TEST(KMeans, duplicate_points) {
+  // k-means++ seeding has no nonzero distances to sample from once every distinct point is a
+  // centroid.
+  Eigen::MatrixXf points(4, 2);
+  points << 1, 1, 1, 1, 2, 2, 2, 2;
+  auto set = std::make_shared<WeightedPointSet>(points, Eigen::VectorXf::Ones(4));
+
+  KMeans kmeans(3);
+  kmeans.Fit(set);
+  EXPECT_EQ(3, kmeans.centroids().rows());
+  EXPECT_NE(kmeans.Transform(points.row(0).transpose()),
+            kmeans.Transform(points.row(2).transpose()));
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -0,0 +1,23 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/ml/model_pool.h"
+
+DEFINE_int32(carnot_model_pool_size, gflags::Int32FromEnv("PL_CARNOT_MODEL_POOL_SIZE", 1),
+             "The number of executors of each ML model to keep, so that several UDFs can run "
+             "inference at once. 0 creates one per core.");
@@ -18,21 +18,29 @@
 
 #pragma once
 
-#include <absl/base/internal/spinlock.h>
-#include <chrono>
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <utility>
 
 #include "src/carnot/exec/ml/borrow_pool.h"
 #include "src/carnot/exec/ml/model_executor.h"
+#include "src/common/base/base.h"
+
+DECLARE_int32(carnot_model_pool_size);
 
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
+/**
+ * ModelPool holds --carnot_model_pool_size executors of each model type, so that as many
+ * callers can run inference at once. Once they are all in use, callers wait for one to be
+ * returned.
+ */
 class ModelPool {
  public:
   using PoolType = BorrowPool<ModelExecutor>;
@@ -45,10 +53,19 @@ class ModelPool {
     // TODO(james, PP-2594): currently if you ask for the same type of model with different args the
     // pool will return the first args asked for.
     auto pool = std::make_unique<PoolType>();
-    pool->Add(std::make_unique<TExecutor>(args...));
+    for (int i = 0; i < PoolSize(); ++i) {
+      pool->Add(std::make_unique<TExecutor>(args...));
+    }
     pool_map_[TExecutor::Type()] = std::move(pool);
   }
 
+  static int PoolSize() {
+    if (FLAGS_carnot_model_pool_size > 0) {
+      return FLAGS_carnot_model_pool_size;
+    }
+    return std::max<int>(std::thread::hardware_concurrency(), 1);
+  }
+
   template <typename TExecutor>
   struct DerivedDeleter {
     void operator()(TExecutor* ptr) { deleter_(ptr); }
@@ -57,18 +74,20 @@ class ModelPool {
 
   template <typename TExecutor, typename... Args>
   std::unique_ptr<TExecutor, DerivedDeleter<TExecutor>> GetModelExecutor(Args... args) {
-    if (pool_map_.find(TExecutor::Type()) == pool_map_.end()) {
-      CreatePool<TExecutor>(args...);
-    }
-    auto ptr = pool_map_[TExecutor::Type()]->Borrow();
-    while (ptr == nullptr) {
-      ptr = pool_map_[TExecutor::Type()]->Borrow();
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    PoolType* pool;
+    {
+      std::lock_guard<std::mutex> l(pool_map_lock_);
+      if (pool_map_.find(TExecutor::Type()) == pool_map_.end()) {
+        CreatePool<TExecutor>(args...);
+      }
+      pool = pool_map_[TExecutor::Type()].get();
     }
+    auto ptr = pool->BorrowWait();
     return std::unique_ptr<TExecutor, DerivedDeleter<TExecutor>>(
         static_cast<TExecutor*>(ptr.release()), DerivedDeleter<TExecutor>{ptr.get_deleter()});
   }
 
+  std::mutex pool_map_lock_;
   std::unordered_map<ModelType, std::unique_ptr<PoolType>> pool_map_;
 };
 
@@ -18,14 +18,23 @@
 
 #include "src/carnot/exec/ml/transformer_executor.h"
 
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
+
+#include <algorithm>
+
+DEFINE_bool(carnot_ml_xnnpack, gflags::BoolFromEnv("PL_CARNOT_ML_XNNPACK", false),
+            "Run the ML models with the XNNPACK delegate.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
-static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
+static constexpr int kEmbeddingSize = 256;
+
+static int load_ints_from_json(std::string_view in, int32_t* arr, int max_num) {
   rapidjson::Document d;
-  rapidjson::ParseResult ok = d.Parse(in.data());
+  rapidjson::ParseResult ok = d.Parse(in.data(), in.size());
   // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
   if (ok == nullptr) {
     return 0;
@@ -49,57 +58,96 @@ static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
   return count;
 }
 
-void TransformerExecutor::Execute(std::string doc, std::string* out) {
-  // LOG(INFO) << "inputs: " << tf_interpreter_->inputs().size() << "\n";
-  // LOG(INFO) << "input(0) name: " << tf_interpreter_->GetInputName(0) << "\n";
-
-  // int t_size = tf_interpreter_->tensors_size();
-  // for (int i = 0; i < t_size; i++) {
-  //   if (tf_interpreter_->tensor(i)->name) {
-  //     LOG(INFO) << i << ": " << tf_interpreter_->tensor(i)->name << ", "
-  //               << tf_interpreter_->tensor(i)->bytes << ", "
-  //               << tf_interpreter_->tensor(i)->type;
-  //   }
-  // }
-  auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
-  if (input == nullptr) {
-    LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
-    *out = "";
-    return;
+void TransformerExecutor::Init(std::string model_proto_path) {
+  model_ = tflite::FlatBufferModel::BuildFromFile(model_proto_path.c_str());
+  tflite::ops::builtin::BuiltinOpResolver resolver;
+  tflite::InterpreterBuilder(*model_, resolver)(&tf_interpreter_);
+  if (FLAGS_carnot_ml_xnnpack) {
+    // Each executor runs on its own thread, the pool provides the parallelism.
+    TfLiteXNNPackDelegateOptions options = TfLiteXNNPackDelegateOptionsDefault();
+    options.num_threads = 1;
+    delegate_ = {TfLiteXNNPackDelegateCreate(&options), TfLiteXNNPackDelegateDelete};
+    if (tf_interpreter_->ModifyGraphWithDelegate(delegate_.get()) != kTfLiteOk) {
+      LOG(INFO) << "Failed to apply the XNNPACK delegate";
+    }
   }
-
-  auto count = load_ints_from_json(doc, input, max_length_);
-  if (count == 0) {
-    // Either input array was empty or there was an error parsing the json, either way don't
-    // continue.
-    *out = "";
-    return;
+  if (!ResizeBatch(1)) {
+    LOG(INFO) << "Failed to allocate tensors";
+  } else {
+    LOG(INFO) << "Init Transformer model";
   }
+}
 
-  // Add 1 to each token to account for pad token.
-  for (int i = 0; i < count; i++) {
-    input[i] = input[i] + 1;
+bool TransformerExecutor::ResizeBatch(int batch_size) {
+  if (batch_size == batch_size_) {
+    return true;
   }
-
-  for (int i = count; i < max_length_; i++) {
-    input[i] = 0;
+  if (tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0],
+                                         {batch_size, max_length_}) != kTfLiteOk ||
+      tf_interpreter_->AllocateTensors() != kTfLiteOk) {
+    batch_size_ = 0;
+    return false;
   }
+  batch_size_ = batch_size;
+  return true;
+}
+
+void TransformerExecutor::Execute(std::string doc, std::string* out) {
+  std::vector<std::string> outs;
+  Execute(std::vector<std::string_view>{doc}, &outs);
+  *out = std::move(outs[0]);
+}
 
-  const int embedding_size = 256;
+void TransformerExecutor::Execute(const std::vector<std::string_view>& docs,
+                                  std::vector<std::string>* outs) {
+  outs->assign(docs.size(), "");
+  for (size_t begin = 0; begin < docs.size(); begin += kMaxBatchSize) {
+    int batch_size = std::min<size_t>(kMaxBatchSize, docs.size() - begin);
+    if (!ResizeBatch(batch_size)) {
+      LOG(INFO) << "Failed to resize the model input to a batch of " << batch_size;
+      return;
+    }
+    auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
+    if (input == nullptr) {
+      LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
+      return;
+    }
 
-  tf_interpreter_->Invoke();
+    // Each document is a row of max_length_ tokens in the input.
+    std::vector<bool> valid(batch_size);
+    for (int b = 0; b < batch_size; ++b) {
+      int32_t* row = input + b * max_length_;
+      auto count = load_ints_from_json(docs[begin + b], row, max_length_);
+      // Either input array was empty or there was an error parsing the json, either way the
+      // output for this document is empty.
+      valid[b] = count > 0;
+      // Add 1 to each token to account for pad token.
+      for (int i = 0; i < count; i++) {
+        row[i] = row[i] + 1;
+      }
+      for (int i = count; i < max_length_; i++) {
+        row[i] = 0;
+      }
+    }
 
-  auto output = tf_interpreter_->typed_output_tensor<float>(0);
+    tf_interpreter_->Invoke();
 
-  // Copy output to json array.
-  rapidjson::StringBuffer sb;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-  writer.StartArray();
-  for (int i = 0; i < embedding_size; i++) {
-    writer.Double(output[i]);
+    auto output = tf_interpreter_->typed_output_tensor<float>(0);
+    for (int b = 0; b < batch_size; ++b) {
+      if (!valid[b]) {
+        continue;
+      }
+      // Copy output to json array.
+      rapidjson::StringBuffer sb;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+      writer.StartArray();
+      for (int i = 0; i < kEmbeddingSize; i++) {
+        writer.Double(output[b * kEmbeddingSize + i]);
+      }
+      writer.EndArray();
+      (*outs)[begin + b] = sb.GetString();
+    }
   }
-  writer.EndArray();
-  *out = sb.GetString();
 }
 
 }  // namespace ml
@@ -26,9 +26,14 @@
 #include <tensorflow/lite/model.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "src/carnot/exec/ml/model_executor.h"
+#include "src/common/base/base.h"
 #include "src/common/base/utils.h"
 
+DECLARE_bool(carnot_ml_xnnpack);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -41,24 +46,29 @@ class TransformerExecutor : public ModelExecutor {
 
   static constexpr ModelType Type() { return kTransformer; }
 
-  void Init(std::string model_proto_path) {
-    model_ = tflite::FlatBufferModel::BuildFromFile(model_proto_path.c_str());
-    tflite::ops::builtin::BuiltinOpResolver resolver;
-    tflite::InterpreterBuilder(*model_, resolver)(&tf_interpreter_);
-    tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {1, max_length_});
-    if (tf_interpreter_->AllocateTensors() != kTfLiteOk) {
-      LOG(INFO) << "Failed to allocate tensors";
-    } else {
-      LOG(INFO) << "Init Transformer model";
-    }
-  }
+  // Documents are run through the model in batches of at most this many.
+  static constexpr int kMaxBatchSize = 32;
+
+  void Init(std::string model_proto_path);
 
   void Execute(std::string doc, std::string* out);
 
+  /**
+   * Computes the embeddings of several documents, with up to kMaxBatchSize of them in each
+   * inference. The output for documents that aren't valid token arrays is empty.
+   */
+  void Execute(const std::vector<std::string_view>& docs, std::vector<std::string>* outs);
+
  private:
-  std::unique_ptr<tflite::Interpreter> tf_interpreter_;
+  // Resizes the batch dimension of the model's input, if needed.
+  bool ResizeBatch(int batch_size);
+
+  // The delegate has to outlive the interpreter, and the interpreter the model.
+  std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)> delegate_{nullptr, nullptr};
   std::unique_ptr<tflite::FlatBufferModel> model_;
+  std::unique_ptr<tflite::Interpreter> tf_interpreter_;
   int max_length_ = 64;
+  int batch_size_ = 0;
 };
 
 }  // namespace ml
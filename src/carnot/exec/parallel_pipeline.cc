@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/parallel_pipeline.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "src/carnot/exec/filter_node.h"
+#include "src/carnot/exec/map_node.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+StatusOr<ExecNode*> ParallelPipeline::CreateNode(const PipelineOp& op) {
+  ExecNode* node = nullptr;
+  switch (op.op->op_type()) {
+    case planpb::MAP_OPERATOR:
+      node = pool_.Add(new MapNode());
+      break;
+    case planpb::FILTER_OPERATOR:
+      node = pool_.Add(new FilterNode());
+      break;
+    case planpb::AGGREGATE_OPERATOR:
+      node = pool_.Add(new AggNode());
+      break;
+    default:
+      return error::Internal("Operator $0 can't run in a parallel pipeline.", op.op->DebugString());
+  }
+  PL_RETURN_IF_ERROR(
+      node->Init(*op.op, op.output_descriptor, op.input_descriptors, collect_exec_node_stats_));
+  return node;
+}
+
+Status ParallelPipeline::Open(ExecState* exec_state) {
+  DCHECK(!ops_.empty());
+  DCHECK_EQ(ops_.back().op->op_type(), planpb::AGGREGATE_OPERATOR);
+  workers_.resize(num_workers_);
+  for (auto& worker : workers_) {
+    for (const auto& op : ops_) {
+      PL_ASSIGN_OR_RETURN(auto node, CreateNode(op));
+      if (!worker.nodes.empty()) {
+        worker.nodes.back()->AddChild(node, 0);
+      }
+      worker.nodes.push_back(node);
+    }
+    worker.agg = static_cast<AggNode*>(worker.nodes.back());
+    for (auto node : worker.nodes) {
+      PL_RETURN_IF_ERROR(node->Prepare(exec_state));
+      PL_RETURN_IF_ERROR(node->Open(exec_state));
+    }
+  }
+  return Status::OK();
+}
+
+Status ParallelPipeline::RunWorker(ExecState* exec_state, const Worker& worker,
+                                   ScanState* scan) {
+  ExecNode* head = worker.nodes.front();
+  while (!scan->failed) {
+    int64_t first = scan->next_batch.fetch_add(kMorselBatches);
+    if (first >= scan->end) {
+      break;
+    }
+    int64_t last = std::min(first + kMorselBatches, scan->end);
+    for (int64_t batch_idx = first; batch_idx < last; ++batch_idx) {
+      PL_ASSIGN_OR_RETURN(auto rb, source_->ReadMorselBatch(exec_state, batch_idx));
+      if (rb == nullptr || rb->num_rows() == 0) {
+        continue;
+      }
+      scan->rows += rb->num_selected_rows();
+      scan->bytes += rb->NumBytes();
+      PL_RETURN_IF_ERROR(head->ConsumeNext(exec_state, *rb, 0));
+    }
+  }
+  return Status::OK();
+}
+
+Status ParallelPipeline::Execute(ExecState* exec_state) {
+  ScanState scan;
+  auto [begin, end] = source_->MorselBatches();
+  scan.next_batch = begin;
+  scan.end = end;
+
+  std::vector<Status> statuses(workers_.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    threads.emplace_back([this, exec_state, &scan, &statuses, i] {
+      statuses[i] = RunWorker(exec_state, workers_[i], &scan);
+      if (!statuses[i].ok()) {
+        scan.failed = true;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& s : statuses) {
+    PL_RETURN_IF_ERROR(s);
+  }
+
+  for (const auto& worker : workers_) {
+    PL_RETURN_IF_ERROR(agg_->MergePartialAggregates(exec_state, worker.agg));
+  }
+  exec_state->SetCurrentSource(source_id_);
+  return source_->FinishMorselScan(exec_state, scan.rows, scan.bytes);
+}
+
+Status ParallelPipeline::Close(ExecState* exec_state) {
+  Status close_status = Status::OK();
+  for (const auto& worker : workers_) {
+    for (auto node : worker.nodes) {
+      auto s = node->Close(exec_state);
+      if (!s.ok()) {
+        close_status = s;
+      }
+    }
+  }
+  return close_status;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "src/carnot/exec/agg_node.h"
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/plan/operators.h"
+#include "src/common/base/base.h"
+#include "src/common/memory/memory.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+// The number of table batches a worker claims at a time.
+constexpr int64_t kMorselBatches = 4;
+
+/**
+ * An operator of a parallel pipeline, with the descriptors its exec nodes are initialized with.
+ */
+struct PipelineOp {
+  const plan::Operator* op;
+  table_store::schema::RowDescriptor output_descriptor;
+  std::vector<table_store::schema::RowDescriptor> input_descriptors;
+};
+
+/**
+ * ParallelPipeline runs a MemorySource -> (Map|Filter)* -> Agg chain of the execution graph on
+ * several threads. Each worker owns a copy of the maps, filters and the aggregate, and claims
+ * morsels of table batches from a shared cursor until the table is read. The partial aggregates of
+ * the workers are then merged into the aggregate of the graph, and the source sends its end of
+ * stream through the graph so the aggregate emits its results as usual.
+ */
+class ParallelPipeline {
+ public:
+  /**
+   * @param source The source node of the graph that starts the pipeline.
+   * @param agg The aggregate node of the graph that ends the pipeline.
+   * @param ops The operators of the pipeline after the source, ending with the aggregate.
+   * @param num_workers The number of threads to run the pipeline on.
+   */
+  ParallelPipeline(int64_t source_id, MemorySourceNode* source, AggNode* agg,
+                   std::vector<PipelineOp> ops, int num_workers, bool collect_exec_node_stats)
+      : source_id_(source_id),
+        source_(source),
+        agg_(agg),
+        ops_(std::move(ops)),
+        num_workers_(num_workers),
+        collect_exec_node_stats_(collect_exec_node_stats) {}
+
+  /**
+   * Creates, prepares and opens the exec nodes of the workers.
+   */
+  Status Open(ExecState* exec_state);
+
+  /**
+   * Reads the remaining batches of the source on the workers, then sends the end of stream of
+   * the source. Must be called before the source runs in the graph.
+   */
+  Status Execute(ExecState* exec_state);
+
+  Status Close(ExecState* exec_state);
+
+ private:
+  struct Worker {
+    std::vector<ExecNode*> nodes;
+    AggNode* agg = nullptr;
+  };
+
+  struct ScanState {
+    std::atomic<int64_t> next_batch{0};
+    int64_t end = 0;
+    std::atomic<bool> failed{false};
+    std::atomic<int64_t> rows{0};
+    std::atomic<int64_t> bytes{0};
+  };
+
+  StatusOr<ExecNode*> CreateNode(const PipelineOp& op);
+  Status RunWorker(ExecState* exec_state, const Worker& worker, ScanState* scan);
+
+  int64_t source_id_;
+  MemorySourceNode* source_;
+  AggNode* agg_;
+  std::vector<PipelineOp> ops_;
+  int num_workers_;
+  bool collect_exec_node_stats_;
+
+  ObjectPool pool_{"parallel_pipeline_pool"};
+  std::vector<Worker> workers_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/radix_sort.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+
+constexpr int kRadixBits = 8;
+constexpr int kNumBuckets = 1 << kRadixBits;
+constexpr int kNumDigits = 64 / kRadixBits;
+
+int Digit(uint64_t key, int digit) {
+  return static_cast<int>((key >> (digit * kRadixBits)) & (kNumBuckets - 1));
+}
+
+}  // namespace
+
+void RadixSortPermutation(const std::vector<uint64_t>& keys, std::vector<int64_t>* perm) {
+  size_t n = perm->size();
+  if (n < 2) {
+    return;
+  }
+  // The histograms of all the digits are counted in a single pass over the keys.
+  std::vector<std::array<int64_t, kNumBuckets>> counts(kNumDigits);
+  for (auto& digit_counts : counts) {
+    digit_counts.fill(0);
+  }
+  for (int64_t row : *perm) {
+    uint64_t key = keys[row];
+    for (int digit = 0; digit < kNumDigits; ++digit) {
+      ++counts[digit][Digit(key, digit)];
+    }
+  }
+
+  std::vector<int64_t> scratch(n);
+  for (int digit = 0; digit < kNumDigits; ++digit) {
+    auto& digit_counts = counts[digit];
+    // All the keys have the same digit, so the pass wouldn't move anything.
+    if (digit_counts[Digit(keys[(*perm)[0]], digit)] == static_cast<int64_t>(n)) {
+      continue;
+    }
+    int64_t offset = 0;
+    for (auto& count : digit_counts) {
+      offset += std::exchange(count, offset);
+    }
+    for (int64_t row : *perm) {
+      scratch[digit_counts[Digit(keys[row], digit)]++] = row;
+    }
+    perm->swap(scratch);
+  }
+}
+
+std::vector<int64_t> RadixSortRows(const std::vector<const arrow::Array*>& cols,
+                                   const std::vector<types::DataType>& types,
+                                   const std::vector<bool>& ascending, int64_t num_rows) {
+  DCHECK_EQ(cols.size(), types.size());
+  DCHECK_EQ(cols.size(), ascending.size());
+  std::vector<int64_t> perm(num_rows);
+  std::iota(perm.begin(), perm.end(), 0);
+  std::vector<uint64_t> keys(num_rows);
+  // LSD: the least significant key word goes first, and the later passes keep its order on ties.
+  for (int64_t col_idx = static_cast<int64_t>(cols.size()) - 1; col_idx >= 0; --col_idx) {
+    int64_t num_words = NumRadixKeyWords(types[col_idx]);
+    DCHECK_GT(num_words, 0);
+    for (int64_t word = num_words - 1; word >= 0; --word) {
+      for (int64_t row = 0; row < num_rows; ++row) {
+#define TYPE_CASE(_dt_) keys[row] = RadixKeyWord<_dt_>(cols[col_idx], row, word);
+        PL_SWITCH_FOREACH_DATATYPE(types[col_idx], TYPE_CASE);
+#undef TYPE_CASE
+        if (!ascending[col_idx]) {
+          keys[row] = ~keys[row];
+        }
+      }
+      RadixSortPermutation(keys, &perm);
+    }
+  }
+  return perm;
+}
+
+int64_t SortedRunEnd(const int64_t* values, int64_t begin, int64_t end, int64_t limit,
+                     bool ties_included) {
+  auto in_run = [&](int64_t idx) {
+    return values[idx] < limit || (ties_included && values[idx] == limit);
+  };
+  if (begin == end || !in_run(begin)) {
+    return begin;
+  }
+  // Gallop to a bound of the end of the run, then binary search within the last step.
+  int64_t lo = begin;
+  int64_t step = 1;
+  while (lo + step < end && in_run(lo + step)) {
+    lo += step;
+    step *= 2;
+  }
+  // values[lo] is in the run, and the run ends at or before hi.
+  int64_t hi = std::min(lo + step, end);
+  ++lo;
+  while (lo < hi) {
+    int64_t mid = lo + (hi - lo) / 2;
+    if (in_run(mid)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
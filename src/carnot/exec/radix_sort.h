@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * Radix sort and merge kernels for the fixed-width keys of Carnot (time_, int64, float64, bool and
+ * upids). Every value maps to one or two unsigned 64-bit key words, most significant first, that
+ * order the same way as the values. A sort is then a stable LSD radix sort of a permutation of
+ * the rows, one key word at a time, from the last sort column to the first.
+ */
+
+// The number of key words of a value of the type, or 0 if values of the type aren't radix sorted.
+inline int64_t NumRadixKeyWords(types::DataType type) {
+  switch (type) {
+    case types::DataType::BOOLEAN:
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+    case types::DataType::FLOAT64:
+      return 1;
+    case types::DataType::UINT128:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+inline uint64_t Int64RadixKey(int64_t val) {
+  // Flipping the sign bit orders the negative values before the positive ones.
+  return static_cast<uint64_t>(val) ^ (uint64_t{1} << 63);
+}
+
+inline uint64_t Float64RadixKey(double val) {
+  uint64_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  // Negative values order backwards by their bits, positive ones after all of them.
+  return (bits >> 63) ? ~bits : bits | (uint64_t{1} << 63);
+}
+
+// Returns the word'th key word of the value at idx of arr.
+template <types::DataType DT>
+uint64_t RadixKeyWord(const arrow::Array* arr, int64_t idx, int64_t word) {
+  if constexpr (DT == types::DataType::STRING) {
+    DCHECK(false) << "Strings aren't radix sorted";
+    return 0;
+  } else {
+    auto val = types::GetValueFromArrowArray<DT>(arr, idx);
+    if constexpr (DT == types::DataType::UINT128) {
+      return word == 0 ? absl::Uint128High64(val) : absl::Uint128Low64(val);
+    } else if constexpr (DT == types::DataType::FLOAT64) {
+      return Float64RadixKey(val);
+    } else if constexpr (DT == types::DataType::BOOLEAN) {
+      return val ? 1 : 0;
+    } else {
+      return Int64RadixKey(val);
+    }
+  }
+}
+
+/**
+ * Stably reorders perm by keys[perm[i]], so keys holds the key of every row and perm the rows in
+ * their current order. Only the bytes on which the keys differ are sorted on, e.g. only the
+ * low bytes of the times of a short time range.
+ */
+void RadixSortPermutation(const std::vector<uint64_t>& keys, std::vector<int64_t>* perm);
+
+/**
+ * Returns the order of the rows [0, num_rows) of the columns, sorted by the first column, then by
+ * the second column, etc. Rows with equal keys keep their order. All of the types must have
+ * radix key words, e.g. (time_, upid).
+ */
+std::vector<int64_t> RadixSortRows(const std::vector<const arrow::Array*>& cols,
+                                   const std::vector<types::DataType>& types,
+                                   const std::vector<bool>& ascending, int64_t num_rows);
+
+/**
+ * Merge kernel for sorted runs: returns the end of the run of values[begin, end) that go before
+ * limit (or up to it if ties_included), which are sorted. Gallops from begin, so short runs only
+ * look at a few values.
+ */
+int64_t SortedRunEnd(const int64_t* values, int64_t begin, int64_t end, int64_t limit,
+                     bool ties_included);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
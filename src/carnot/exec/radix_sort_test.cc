@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "src/carnot/exec/radix_sort.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using ::testing::ElementsAre;
+using types::DataType;
+
+TEST(RadixSort, keys_order_like_values) {
+  std::vector<int64_t> ints = {std::numeric_limits<int64_t>::min(), -5, -1, 0, 1, 7,
+                               std::numeric_limits<int64_t>::max()};
+  for (size_t i = 1; i < ints.size(); ++i) {
+    EXPECT_LT(Int64RadixKey(ints[i - 1]), Int64RadixKey(ints[i]));
+  }
+  std::vector<double> doubles = {-1e300, -2.5, -1e-300, 0, 1e-300, 3.5, 1e300};
+  for (size_t i = 1; i < doubles.size(); ++i) {
+    EXPECT_LT(Float64RadixKey(doubles[i - 1]), Float64RadixKey(doubles[i]));
+  }
+}
+
+TEST(RadixSort, permutation_is_stable) {
+  std::vector<uint64_t> keys = {3, 1, 2, 1, 3, 0};
+  std::vector<int64_t> perm = {0, 1, 2, 3, 4, 5};
+  RadixSortPermutation(keys, &perm);
+  EXPECT_THAT(perm, ElementsAre(5, 1, 3, 2, 0, 4));
+}
+
+TEST(RadixSort, matches_std_sort) {
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(1000);
+  for (auto& key : keys) {
+    // Mix small and large keys, so that some of the digits are skipped and some aren't.
+    key = rng() >> (rng() % 64);
+  }
+  std::vector<int64_t> perm(keys.size());
+  std::iota(perm.begin(), perm.end(), 0);
+  std::vector<int64_t> expected = perm;
+  std::stable_sort(expected.begin(), expected.end(),
+                   [&](int64_t a, int64_t b) { return keys[a] < keys[b]; });
+  RadixSortPermutation(keys, &perm);
+  EXPECT_EQ(expected, perm);
+}
+
+TEST(RadixSort, rows_by_time_and_upid) {
+  auto times = types::ToArrow(std::vector<types::Time64NSValue>{20, 10, 20, 10, -5},
+                              arrow::default_memory_pool());
+  auto upids = types::ToArrow(
+      std::vector<types::UInt128Value>{{2, 1}, {1, 9}, {1, 2}, {1, 1}, {3, 3}},
+      arrow::default_memory_pool());
+
+  auto perm = RadixSortRows({times.get(), upids.get()}, {DataType::TIME64NS, DataType::UINT128},
+                            {true, true}, 5);
+  EXPECT_THAT(perm, ElementsAre(4, 3, 1, 2, 0));
+
+  perm = RadixSortRows({times.get(), upids.get()}, {DataType::TIME64NS, DataType::UINT128},
+                       {false, true}, 5);
+  EXPECT_THAT(perm, ElementsAre(2, 0, 3, 1, 4));
+}
+
+TEST(RadixSort, sorted_run_end) {
+  std::vector<int64_t> values = {1, 2, 2, 3, 5, 8, 8, 9};
+  int64_t size = values.size();
+  EXPECT_EQ(0, SortedRunEnd(values.data(), 0, size, 1, /*ties_included*/ false));
+  EXPECT_EQ(1, SortedRunEnd(values.data(), 0, size, 1, /*ties_included*/ true));
+  EXPECT_EQ(1, SortedRunEnd(values.data(), 0, size, 2, /*ties_included*/ false));
+  EXPECT_EQ(3, SortedRunEnd(values.data(), 0, size, 2, /*ties_included*/ true));
+  EXPECT_EQ(5, SortedRunEnd(values.data(), 2, size, 8, /*ties_included*/ false));
+  EXPECT_EQ(7, SortedRunEnd(values.data(), 2, size, 8, /*ties_included*/ true));
+  EXPECT_EQ(size, SortedRunEnd(values.data(), 0, size, 100, /*ties_included*/ false));
+  EXPECT_EQ(4, SortedRunEnd(values.data(), 0, 4, 100, /*ties_included*/ false));
+  EXPECT_EQ(3, SortedRunEnd(values.data(), 3, 3, 100, /*ties_included*/ false));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
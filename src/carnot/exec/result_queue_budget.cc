@@ -0,0 +1,64 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/result_queue_budget.h"
+
+DEFINE_int64(carnot_grpc_source_max_queued_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_GRPC_SOURCE_MAX_QUEUED_BYTES", 64 * 1024 * 1024),
+             "The number of bytes of result batches that can be queued for a GRPC source before "
+             "the router stops reading the stream of the remote sink. Set to '0' for no limit.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+void ResultQueueBudget::Add(int64_t bytes) {
+  std::lock_guard<std::mutex> l(lock_);
+  queued_bytes_ += bytes;
+}
+
+void ResultQueueBudget::Release(int64_t bytes) {
+  {
+    std::lock_guard<std::mutex> l(lock_);
+    queued_bytes_ -= bytes;
+    DCHECK_GE(queued_bytes_, 0);
+  }
+  room_cv_.notify_all();
+}
+
+bool ResultQueueBudget::WaitForRoom(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> l(lock_);
+  return room_cv_.wait_for(l, timeout, [this] { return HasRoomUnlocked(); });
+}
+
+void ResultQueueBudget::Close() {
+  {
+    std::lock_guard<std::mutex> l(lock_);
+    closed_ = true;
+  }
+  room_cv_.notify_all();
+}
+
+int64_t ResultQueueBudget::queued_bytes() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return queued_bytes_;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "src/common/base/base.h"
+
+DECLARE_int64(carnot_grpc_source_max_queued_bytes);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * ResultQueueBudget bounds the bytes of the result batches that GRPCRouter has received for a
+ * GRPC source but that the source hasn't consumed yet.
+ *
+ * The router stops reading the stream of a source that is over its budget until the source
+ * catches up. Once the server stops reading, GRPC's HTTP/2 flow control window fills up and the
+ * writes of the remote GRPC sink block, which in turn stops the remote query from producing more
+ * batches, so neither side buffers more than the budget plus the window.
+ *
+ * Thread-safe.
+ */
+class ResultQueueBudget : public NotCopyable {
+ public:
+  /**
+   * @param max_bytes the budget, or 0 for no limit.
+   */
+  explicit ResultQueueBudget(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  void Add(int64_t bytes);
+  void Release(int64_t bytes);
+
+  /**
+   * Waits until the queued bytes are within the budget, or the budget is closed.
+   * @return whether there is room, false if the timeout was reached first.
+   */
+  bool WaitForRoom(std::chrono::milliseconds timeout);
+
+  /**
+   * Lifts the budget for good, eg. when the source or the query goes away, so that no stream
+   * waits on it anymore.
+   */
+  void Close();
+
+  int64_t queued_bytes() const;
+
+ private:
+  bool HasRoomUnlocked() const { return closed_ || max_bytes_ <= 0 || queued_bytes_ < max_bytes_; }
+
+  const int64_t max_bytes_;
+
+  mutable std::mutex lock_;
+  std::condition_variable room_cv_;
+  int64_t queued_bytes_ = 0;
+  bool closed_ = false;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "src/carnot/exec/result_queue_budget.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(ResultQueueBudget, waits_until_released) {
+  ResultQueueBudget budget(100);
+  EXPECT_TRUE(budget.WaitForRoom(std::chrono::milliseconds(0)));
+  budget.Add(60);
+  EXPECT_TRUE(budget.WaitForRoom(std::chrono::milliseconds(0)));
+  budget.Add(60);
+  EXPECT_EQ(120, budget.queued_bytes());
+  EXPECT_FALSE(budget.WaitForRoom(std::chrono::milliseconds(1)));
+
+  std::thread consumer([&] { budget.Release(60); });
+  EXPECT_TRUE(budget.WaitForRoom(std::chrono::seconds(10)));
+  consumer.join();
+  EXPECT_EQ(60, budget.queued_bytes());
+}
+
+TEST(ResultQueueBudget, close_lifts_the_budget) {
+  ResultQueueBudget budget(100);
+  budget.Add(200);
+  EXPECT_FALSE(budget.WaitForRoom(std::chrono::milliseconds(1)));
+
+  std::thread closer([&] { budget.Close(); });
+  EXPECT_TRUE(budget.WaitForRoom(std::chrono::seconds(10)));
+  closer.join();
+  EXPECT_TRUE(budget.WaitForRoom(std::chrono::milliseconds(0)));
+}
+
+TEST(ResultQueueBudget, unlimited) {
+  ResultQueueBudget budget(0);
+  budget.Add(1024 * 1024 * 1024);
+  EXPECT_TRUE(budget.WaitForRoom(std::chrono::milliseconds(0)));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -36,6 +36,7 @@
 #include <absl/strings/substitute.h>
 
 #include "src/common/base/base.h"
+#include "src/carnot/exec/hash_kernels.h"
 #include "src/common/base/hash_utils.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/hash_utils.h"
@@ -81,6 +82,7 @@ struct RowTuple : public NotCopyable {
   void Reset() {
     fixed_values.resize(types->size());
     variable_values.clear();
+    has_hash = false;
   }
 
   /**
@@ -133,23 +135,58 @@ struct RowTuple : public NotCopyable {
   }
 
   /**
-   * Compute the hash of this RowTuple.
+   * Compute the hash of this RowTuple. It is the same as the hash of its row computed by
+   * HashColumns(), which can be set with SetHash() to skip computing it again.
    *
    * @return the hash results.
    */
   size_t Hash() const {
     DCHECK(CheckSequentialWriteOrder()) << "Variable sized write ordering mismatch";
-    // For fixed sized data we just hash the stored array.
-    size_t hash = ::util::Hash64(reinterpret_cast<const char*>(fixed_values.data()),
-                                 sizeof(types::FixedSizeValueUnion) * fixed_values.size());
-    // For variable sized data we run the appropriate hash function.
-    for (const auto& val : variable_values) {
-      // This should be edited when we add support for new variable sized types.
-      DCHECK(std::holds_alternative<types::StringValue>(val));
-      hash = ::px::HashCombine(
-          hash, types::utils::hash<types::StringValue>()(std::get<types::StringValue>(val)));
+    if (has_hash) {
+      DCHECK_EQ(hash, ComputeHash());
+      return hash;
     }
-    return hash;
+    return ComputeHash();
+  }
+
+  /**
+   * Sets the hash of the tuple, once all its values are set. Reset() clears it.
+   */
+  void SetHash(uint64_t h) {
+    hash = h;
+    has_hash = true;
+  }
+
+  uint64_t ComputeHash() const {
+    uint64_t h = 0;
+    for (size_t idx = 0; idx < fixed_values.size(); ++idx) {
+      const auto& val = fixed_values[idx];
+      switch (types->at(idx)) {
+        case types::DataType::BOOLEAN:
+          h = HashKeyWord(h, static_cast<uint64_t>(types::Get<types::BoolValue>(val).val));
+          break;
+        case types::DataType::INT64:
+          h = HashKeyWord(h, static_cast<uint64_t>(types::Get<types::Int64Value>(val).val));
+          break;
+        case types::DataType::TIME64NS:
+          h = HashKeyWord(h, static_cast<uint64_t>(types::Get<types::Time64NSValue>(val).val));
+          break;
+        case types::DataType::FLOAT64:
+          h = HashKeyWord(h, DoubleToWord(types::Get<types::Float64Value>(val).val));
+          break;
+        case types::DataType::UINT128: {
+          const auto& uint128_val = types::Get<types::UInt128Value>(val);
+          h = HashKeyWord(HashKeyWord(h, uint128_val.High64()), uint128_val.Low64());
+          break;
+        }
+        case types::DataType::STRING:
+          h = HashKeyString(h, GetValue<types::StringValue>(idx));
+          break;
+        default:
+          LOG(DFATAL) << "Unsupported key type: " << types::ToString(types->at(idx));
+      }
+    }
+    return h;
   }
 
   /**
@@ -185,6 +222,9 @@ struct RowTuple : public NotCopyable {
   // This index is stored as a Int64Value.
   std::vector<types::FixedSizeValueUnion> fixed_values;
   std::vector<VariableSizeValueTypeVariant> variable_values;
+
+  uint64_t hash = 0;
+  bool has_hash = false;
 };
 
 namespace internal {
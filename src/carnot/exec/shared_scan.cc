@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/shared_scan.h"
+
+DEFINE_int64(carnot_shared_scan_window_ms,
+             gflags::Int64FromEnv("PL_CARNOT_SHARED_SCAN_WINDOW_MS", 1000),
+             "How long a batch read by a memory source is kept for other queries that scan the "
+             "same batch. Set to '0' to disable shared scans.");
+DEFINE_int64(carnot_shared_scan_max_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_SHARED_SCAN_MAX_BYTES", 64 * 1024 * 1024),
+             "The number of bytes of batches kept for shared scans. The oldest batches are dropped "
+             "first once it is reached.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+std::unique_ptr<SharedScanCoordinator> SharedScanCoordinator::CreateFromFlags() {
+  if (FLAGS_carnot_shared_scan_window_ms <= 0 || FLAGS_carnot_shared_scan_max_bytes <= 0) {
+    return nullptr;
+  }
+  return std::make_unique<SharedScanCoordinator>(
+      std::chrono::milliseconds(FLAGS_carnot_shared_scan_window_ms),
+      FLAGS_carnot_shared_scan_max_bytes);
+}
+
+StatusOr<std::unique_ptr<RowBatch>> SharedScanCoordinator::Read(
+    const std::shared_ptr<const void>& batch_ref, const std::string& scan, const ReadFn& read,
+    const std::function<bool()>& verify_batch_ref, bool* shared) {
+  *shared = false;
+  if (batch_ref == nullptr) {
+    return read();
+  }
+
+  Key key{batch_ref.get(), scan};
+  std::shared_ptr<Entry> entry;
+  std::promise<std::shared_ptr<const RowBatch>> result;
+  bool reader = false;
+  {
+    std::lock_guard<std::mutex> l(lock_);
+    auto now = Clock::now();
+    EvictUnlocked(now);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      entry = it->second;
+    } else {
+      entry = std::make_shared<Entry>();
+      entry->batch_ref = batch_ref;
+      entry->result = result.get_future().share();
+      entry->read_time = now;
+      entries_.emplace(key, entry);
+      read_order_.emplace_back(key, entry);
+      reader = true;
+    }
+  }
+
+  if (!reader) {
+    // Blocks until the query doing the read is done with it.
+    auto rb = entry->result.get();
+    if (rb == nullptr) {
+      return read();
+    }
+    *shared = true;
+    return std::make_unique<RowBatch>(*rb);
+  }
+
+  auto rb_or = read();
+  std::shared_ptr<const RowBatch> rb;
+  // The batch index the read used can point to a different batch if the table expired batches in
+  // the meantime, in which case the result doesn't belong to the key.
+  if (rb_or.ok() && verify_batch_ref()) {
+    rb = std::make_shared<const RowBatch>(*rb_or.ValueOrDie());
+  }
+  result.set_value(rb);
+
+  std::lock_guard<std::mutex> l(lock_);
+  if (rb == nullptr) {
+    EraseUnlocked(key, entry);
+    return rb_or;
+  }
+  auto it = entries_.find(key);
+  if (it != entries_.end() && it->second == entry) {
+    entry->bytes = rb->NumBytes();
+    bytes_ += entry->bytes;
+    EvictUnlocked(Clock::now());
+  }
+  return rb_or;
+}
+
+void SharedScanCoordinator::EvictUnlocked(Clock::time_point now) {
+  while (!read_order_.empty()) {
+    const auto& [key, entry] = read_order_.front();
+    if (now - entry->read_time < window_ && bytes_ <= max_bytes_) {
+      break;
+    }
+    EraseUnlocked(key, entry);
+    read_order_.pop_front();
+  }
+}
+
+void SharedScanCoordinator::EraseUnlocked(const Key& key, const std::shared_ptr<Entry>& entry) {
+  auto it = entries_.find(key);
+  // A failed read erases its entry early, and the key can be read again in the meantime.
+  if (it == entries_.end() || it->second != entry) {
+    return;
+  }
+  bytes_ -= entry->bytes;
+  entries_.erase(it);
+}
+
+int64_t SharedScanCoordinator::num_batches() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return entries_.size();
+}
+
+int64_t SharedScanCoordinator::bytes() const {
+  std::lock_guard<std::mutex> l(lock_);
+  return bytes_;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+
+DECLARE_int64(carnot_shared_scan_window_ms);
+DECLARE_int64(carnot_shared_scan_max_bytes);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * SharedScanCoordinator lets concurrent queries that scan the same table batches share the work
+ * of reading them. Live views fire many near-identical queries at once, and without it each of
+ * their memory sources decodes and filters the same batches on its own.
+ *
+ * A read is keyed by the batch it reads (see table_store::Table::BatchRef) and by everything else
+ * that determines its output (columns, row range, predicates). The first query to read a key does
+ * the read; queries that ask for the key while it is in progress wait for it, and queries that ask
+ * within the window after it finished get the same batch. So N concurrent queries cost one read
+ * of every batch plus N executions of the rest of their plans.
+ *
+ * Thread-safe. One is shared by all the queries of a Carnot instance.
+ */
+class SharedScanCoordinator : public NotCopyable {
+ public:
+  using ReadFn = std::function<StatusOr<std::unique_ptr<table_store::schema::RowBatch>>()>;
+
+  SharedScanCoordinator(std::chrono::milliseconds window, int64_t max_bytes)
+      : window_(window), max_bytes_(max_bytes) {}
+
+  /**
+   * Creates a coordinator configured with the --carnot_shared_scan_* flags, or returns nullptr if
+   * shared scans are disabled.
+   */
+  static std::unique_ptr<SharedScanCoordinator> CreateFromFlags();
+
+  /**
+   * Returns the batch read with the given key, calling read if no other query has read it
+   * recently.
+   *
+   * @param batch_ref the data of the batch that is read. The key is only shared while it is the
+   * same batch, so it is also compared again after the read, by calling verify_batch_ref.
+   * @param scan describes the rest of the read.
+   * @param shared set to whether the batch came from another query's read.
+   */
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> Read(
+      const std::shared_ptr<const void>& batch_ref, const std::string& scan, const ReadFn& read,
+      const std::function<bool()>& verify_batch_ref, bool* shared);
+
+  int64_t num_batches() const;
+  int64_t bytes() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Key {
+    const void* batch;
+    std::string scan;
+
+    bool operator==(const Key& other) const {
+      return batch == other.batch && scan == other.scan;
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.batch, key.scan);
+    }
+  };
+
+  struct Entry {
+    // Keeps the batch the key points to from being freed (and its address reused) while the
+    // entry is around.
+    std::shared_ptr<const void> batch_ref;
+    // Set to nullptr if the read failed or raced with the batch being expired, in which case the
+    // waiting queries read the batch themselves.
+    std::shared_future<std::shared_ptr<const table_store::schema::RowBatch>> result;
+    Clock::time_point read_time;
+    int64_t bytes = 0;
+  };
+
+  // Drops the entries that are past the window, and then the oldest entries until the cached
+  // batches fit in max_bytes_.
+  void EvictUnlocked(Clock::time_point now);
+  void EraseUnlocked(const Key& key, const std::shared_ptr<Entry>& entry);
+
+  const std::chrono::milliseconds window_;
+  const int64_t max_bytes_;
+
+  mutable std::mutex lock_;
+  absl::flat_hash_map<Key, std::shared_ptr<Entry>> entries_;
+  // The keys in the order they were read in.
+  std::deque<std::pair<Key, std::shared_ptr<Entry>>> read_order_;
+  int64_t bytes_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "src/carnot/exec/shared_scan.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+class SharedScanCoordinatorTest : public ::testing::Test {
+ protected:
+  SharedScanCoordinator::ReadFn CountingRead(int* num_reads) {
+    return [num_reads]() -> StatusOr<std::unique_ptr<RowBatch>> {
+      ++*num_reads;
+      auto rb = std::make_unique<RowBatch>(RowDescriptor({types::DataType::INT64}), 3);
+      PL_RETURN_IF_ERROR(rb->AddColumn(
+          types::ToArrow(std::vector<types::Int64Value>{1, 2, 3}, arrow::default_memory_pool())));
+      return rb;
+    };
+  }
+
+  std::function<bool()> same_batch_ = [] { return true; };
+  std::shared_ptr<const void> batch_ = std::make_shared<int>(0);
+};
+
+TEST_F(SharedScanCoordinatorTest, shares_reads_of_the_same_batch) {
+  SharedScanCoordinator coordinator(std::chrono::seconds(60), 1024 * 1024);
+  int num_reads = 0;
+  bool shared = false;
+
+  ASSERT_OK_AND_ASSIGN(auto rb, coordinator.Read(batch_, "cols=0", CountingRead(&num_reads),
+                                                 same_batch_, &shared));
+  EXPECT_FALSE(shared);
+  ASSERT_OK_AND_ASSIGN(auto shared_rb, coordinator.Read(batch_, "cols=0", CountingRead(&num_reads),
+                                                        same_batch_, &shared));
+  EXPECT_TRUE(shared);
+  EXPECT_EQ(1, num_reads);
+  EXPECT_EQ(rb->num_rows(), shared_rb->num_rows());
+  EXPECT_EQ(rb->ColumnAt(0), shared_rb->ColumnAt(0));
+  EXPECT_EQ(1, coordinator.num_batches());
+  EXPECT_EQ(rb->NumBytes(), coordinator.bytes());
+
+  // Different reads of the batch, or reads of another batch, aren't shared.
+  ASSERT_OK(coordinator.Read(batch_, "cols=1", CountingRead(&num_reads), same_batch_, &shared));
+  EXPECT_FALSE(shared);
+  ASSERT_OK(coordinator.Read(std::make_shared<int>(1), "cols=0", CountingRead(&num_reads),
+                             same_batch_, &shared));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(3, num_reads);
+}
+
+TEST_F(SharedScanCoordinatorTest, does_not_share_reads_of_expired_batches) {
+  SharedScanCoordinator coordinator(std::chrono::seconds(60), 1024 * 1024);
+  int num_reads = 0;
+  bool shared = false;
+
+  ASSERT_OK(coordinator.Read(batch_, "cols=0", CountingRead(&num_reads), [] { return false; },
+                             &shared));
+  EXPECT_EQ(0, coordinator.num_batches());
+  ASSERT_OK(coordinator.Read(batch_, "cols=0", CountingRead(&num_reads), same_batch_, &shared));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(2, num_reads);
+}
+
+TEST_F(SharedScanCoordinatorTest, evicts_past_max_bytes) {
+  // Too small for any batch.
+  SharedScanCoordinator coordinator(std::chrono::seconds(60), 1);
+  int num_reads = 0;
+  bool shared = false;
+
+  ASSERT_OK(coordinator.Read(batch_, "cols=0", CountingRead(&num_reads), same_batch_, &shared));
+  EXPECT_EQ(0, coordinator.num_batches());
+  EXPECT_EQ(0, coordinator.bytes());
+  ASSERT_OK(coordinator.Read(batch_, "cols=0", CountingRead(&num_reads), same_batch_, &shared));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(2, num_reads);
+}
+
+TEST_F(SharedScanCoordinatorTest, concurrent_reads_wait_for_the_first) {
+  SharedScanCoordinator coordinator(std::chrono::seconds(60), 1024 * 1024);
+  int num_reads = 0;
+  std::promise<void> read_started;
+  std::promise<void> finish_read;
+  auto read = CountingRead(&num_reads);
+  auto blocking_read = [&]() {
+    read_started.set_value();
+    finish_read.get_future().wait();
+    return read();
+  };
+
+  std::thread first([&] {
+    bool shared = false;
+    EXPECT_OK(coordinator.Read(batch_, "cols=0", blocking_read, same_batch_, &shared));
+    EXPECT_FALSE(shared);
+  });
+  read_started.get_future().wait();
+
+  bool shared = false;
+  std::thread second([&] {
+    EXPECT_OK(coordinator.Read(batch_, "cols=0", read, same_batch_, &shared));
+  });
+  finish_read.set_value();
+  first.join();
+  second.join();
+
+  EXPECT_TRUE(shared);
+  EXPECT_EQ(1, num_reads);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
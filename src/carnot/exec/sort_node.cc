@@ -0,0 +1,245 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/sort_node.h"
+
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+#include <utility>
+
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/exec/radix_sort.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+namespace {
+
+std::string_view StringViewAt(const arrow::Array* arr, int64_t idx) {
+  int32_t len = 0;
+  const uint8_t* data = static_cast<const arrow::StringArray*>(arr)->GetValue(idx, &len);
+  return std::string_view(reinterpret_cast<const char*>(data), len);
+}
+
+template <types::DataType DT>
+int CompareValues(const arrow::Array* a, int64_t a_idx, const arrow::Array* b, int64_t b_idx) {
+  if constexpr (DT == types::DataType::STRING) {
+    return StringViewAt(a, a_idx).compare(StringViewAt(b, b_idx));
+  } else {
+    auto a_val = types::GetValueFromArrowArray<DT>(a, a_idx);
+    auto b_val = types::GetValueFromArrowArray<DT>(b, b_idx);
+    return a_val < b_val ? -1 : (b_val < a_val ? 1 : 0);
+  }
+}
+
+template <types::DataType DT, typename TRows, typename TBatches>
+Status CopyColumn(const TRows& rows, const TBatches& batches, int64_t col_idx,
+                  arrow::ArrayBuilder* builder) {
+  PL_RETURN_IF_ERROR(builder->Reserve(rows.size()));
+  for (const auto& row : rows) {
+    const arrow::Array* arr = batches[row.batch_idx][col_idx].get();
+    PL_RETURN_IF_ERROR(table_store::schema::CopyValue<DT>(
+        builder, types::GetValueFromArrowArray<DT>(arr, row.row_idx)));
+  }
+  return Status::OK();
+}
+
+template <types::DataType DT, typename TRows, typename TBatches>
+void FillRadixKeys(const TRows& rows, const TBatches& batches, int64_t col_idx, int64_t word,
+                   bool ascending, std::vector<uint64_t>* keys) {
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const arrow::Array* arr = batches[rows[i].batch_idx][col_idx].get();
+    uint64_t key = RadixKeyWord<DT>(arr, rows[i].row_idx, word);
+    (*keys)[i] = ascending ? key : ~key;
+  }
+}
+
+}  // namespace
+
+std::string SortNode::DebugStringImpl() {
+  return absl::Substitute("Exec::SortNode<$0>", plan_node_->DebugString());
+}
+
+Status SortNode::InitImpl(const plan::Operator& plan_node) {
+  CHECK(plan_node.op_type() == planpb::OperatorType::SORT_OPERATOR);
+  const auto* sort_plan_node = static_cast<const plan::SortOperator*>(&plan_node);
+  plan_node_ = std::make_unique<plan::SortOperator>(*sort_plan_node);
+
+  if (input_descriptors_.size() != 1) {
+    return error::InvalidArgument("Sort operator expects a single input relation, got $0",
+                                  input_descriptors_.size());
+  }
+  const auto& input_desc = input_descriptors_[0];
+  for (const auto& sort_col : plan_node_->sort_columns()) {
+    auto data_type = input_desc.type(sort_col.index());
+#define TYPE_CASE(_dt_) compare_fns_.push_back(&CompareValues<_dt_>);
+    PL_SWITCH_FOREACH_DATATYPE(data_type, TYPE_CASE);
+#undef TYPE_CASE
+    radix_sortable_ = radix_sortable_ && NumRadixKeyWords(data_type) > 0;
+  }
+  for (size_t i = 0; i < input_desc.size(); ++i) {
+    all_input_cols_.push_back(i);
+  }
+  return Status::OK();
+}
+
+Status SortNode::PrepareImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+
+Status SortNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+
+Status SortNode::CloseImpl(ExecState* /*exec_state*/) {
+  batches_.clear();
+  rows_.clear();
+  return Status::OK();
+}
+
+void SortNode::RadixSortRows() {
+  std::vector<int64_t> perm(rows_.size());
+  std::iota(perm.begin(), perm.end(), 0);
+  std::vector<uint64_t> keys(rows_.size());
+  const auto& sort_columns = plan_node_->sort_columns();
+  for (int64_t i = static_cast<int64_t>(sort_columns.size()) - 1; i >= 0; --i) {
+    int64_t col_idx = sort_columns[i].index();
+    auto data_type = input_descriptors_[0].type(col_idx);
+    for (int64_t word = NumRadixKeyWords(data_type) - 1; word >= 0; --word) {
+#define TYPE_CASE(_dt_) \
+  FillRadixKeys<_dt_>(rows_, batches_, col_idx, word, sort_columns[i].ascending(), &keys);
+      PL_SWITCH_FOREACH_DATATYPE(data_type, TYPE_CASE);
+#undef TYPE_CASE
+      RadixSortPermutation(keys, &perm);
+    }
+  }
+  std::vector<RowRef> sorted_rows;
+  sorted_rows.reserve(rows_.size());
+  for (int64_t row : perm) {
+    sorted_rows.push_back(rows_[row]);
+  }
+  rows_ = std::move(sorted_rows);
+}
+
+bool SortNode::RowLess(const RowRef& a, const RowRef& b) const {
+  const auto& a_cols = batches_[a.batch_idx];
+  const auto& b_cols = batches_[b.batch_idx];
+  const auto& sort_columns = plan_node_->sort_columns();
+  for (size_t i = 0; i < sort_columns.size(); ++i) {
+    int64_t col_idx = sort_columns[i].index();
+    int cmp = compare_fns_[i](a_cols[col_idx].get(), a.row_idx, b_cols[col_idx].get(), b.row_idx);
+    if (cmp != 0) {
+      return sort_columns[i].ascending() ? cmp < 0 : cmp > 0;
+    }
+  }
+  return false;
+}
+
+void SortNode::AddRow(const RowRef& row) {
+  auto row_less = [this](const RowRef& a, const RowRef& b) { return RowLess(a, b); };
+  size_t limit = plan_node_->limit();
+  if (limit == 0) {
+    rows_.push_back(row);
+    return;
+  }
+  if (rows_.size() < limit) {
+    rows_.push_back(row);
+    std::push_heap(rows_.begin(), rows_.end(), row_less);
+    return;
+  }
+  if (!RowLess(row, rows_.front())) {
+    return;
+  }
+  std::pop_heap(rows_.begin(), rows_.end(), row_less);
+  rows_.back() = row;
+  std::push_heap(rows_.begin(), rows_.end(), row_less);
+}
+
+StatusOr<SortNode::Columns> SortNode::CopyRows(const std::vector<int64_t>& input_cols) const {
+  Columns columns;
+  for (int64_t col_idx : input_cols) {
+    auto data_type = input_descriptors_[0].type(col_idx);
+    auto builder = types::MakeArrowBuilder(data_type, mem_pool());
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(CopyColumn<_dt_>(rows_, batches_, col_idx, builder.get()));
+    PL_SWITCH_FOREACH_DATATYPE(data_type, TYPE_CASE);
+#undef TYPE_CASE
+    std::shared_ptr<arrow::Array> arr;
+    PL_RETURN_IF_ERROR(builder->Finish(&arr));
+    columns.push_back(arr);
+  }
+  return columns;
+}
+
+Status SortNode::Compact() {
+  PL_ASSIGN_OR_RETURN(Columns columns, CopyRows(all_input_cols_));
+  batches_.clear();
+  batches_.push_back(std::move(columns));
+  batch_rows_ = rows_.size();
+  // The rows are copied in heap order, so the heap stays valid with the new references.
+  for (size_t i = 0; i < rows_.size(); ++i) {
+    rows_[i] = RowRef{0, static_cast<int64_t>(i)};
+  }
+  return Status::OK();
+}
+
+Status SortNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  if (rb.num_rows() > 0) {
+    batches_.push_back(rb.columns());
+    batch_rows_ += rb.num_rows();
+    for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+      AddRow(RowRef{batches_.size() - 1, row_idx});
+    }
+    int64_t limit = plan_node_->limit();
+    if (limit > 0 && batch_rows_ >= 2 * limit) {
+      PL_RETURN_IF_ERROR(Compact());
+    }
+  }
+
+  if (!rb.eos()) {
+    return Status::OK();
+  }
+
+  auto row_less = [this](const RowRef& a, const RowRef& b) { return RowLess(a, b); };
+  if (plan_node_->limit() > 0) {
+    std::sort_heap(rows_.begin(), rows_.end(), row_less);
+  } else if (radix_sortable_) {
+    RadixSortRows();
+  } else {
+    std::stable_sort(rows_.begin(), rows_.end(), row_less);
+  }
+
+  RowBatch output_rb(*output_descriptor_, rows_.size());
+  PL_ASSIGN_OR_RETURN(Columns columns, CopyRows(plan_node_->selected_cols()));
+  for (const auto& col : columns) {
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(col));
+  }
+  output_rb.set_eow(true);
+  output_rb.set_eos(true);
+  batches_.clear();
+  rows_.clear();
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
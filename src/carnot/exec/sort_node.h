@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/builder.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/plan/operators.h"
+#include "src/common/base/base.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * SortNode outputs the rows of its input ordered by the sort columns, once its input is done.
+ *
+ * With a limit, the node only keeps the first limit rows seen so far in a bounded heap, so its
+ * memory is proportional to the limit rather than the input. Batches are referenced rather than
+ * copied as they come in, and the kept rows are compacted into a single batch once the referenced
+ * batches hold twice as many rows as the limit. Without a limit, the rows are radix sorted when
+ * all of the sort columns have fixed-width types.
+ */
+class SortNode : public ProcessingNode {
+ public:
+  SortNode() = default;
+  virtual ~SortNode() = default;
+
+ protected:
+  std::string DebugStringImpl() override;
+  Status InitImpl(const plan::Operator& plan_node) override;
+  Status PrepareImpl(ExecState* exec_state) override;
+  Status OpenImpl(ExecState* exec_state) override;
+  Status CloseImpl(ExecState* exec_state) override;
+  Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                         size_t parent_index) override;
+
+ private:
+  using Columns = std::vector<std::shared_ptr<arrow::Array>>;
+  // Compares two values of a column, returning <0, 0 or >0 like strcmp.
+  using CompareFn = int (*)(const arrow::Array*, int64_t, const arrow::Array*, int64_t);
+
+  struct RowRef {
+    size_t batch_idx;
+    int64_t row_idx;
+  };
+
+  // Returns true if row a comes before row b in the output.
+  bool RowLess(const RowRef& a, const RowRef& b) const;
+  void AddRow(const RowRef& row);
+  // Copies the kept rows, in their current order, into new arrays of the given input columns.
+  StatusOr<Columns> CopyRows(const std::vector<int64_t>& input_cols) const;
+  // Replaces the referenced batches with a single batch holding only the kept rows.
+  Status Compact();
+  // Stably sorts all of the rows on the radix keys of the sort columns.
+  void RadixSortRows();
+
+  std::unique_ptr<plan::SortOperator> plan_node_;
+  std::vector<CompareFn> compare_fns_;
+  std::vector<int64_t> all_input_cols_;
+  // Whether all of the sort columns can be radix sorted.
+  bool radix_sortable_ = true;
+
+  std::vector<Columns> batches_;
+  int64_t batch_rows_ = 0;
+  // The kept rows. With a limit, this is a max-heap on RowLess, so the front is the row that gets
+  // evicted first.
+  std::vector<RowRef> rows_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
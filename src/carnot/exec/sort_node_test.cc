@@ -0,0 +1,181 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/sort_node.h"
+
+#include <memory>
+#include <string>
+
+#include <absl/strings/substitute.h>
+#include <gmock/gmock.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+using types::Int64Value;
+using types::StringValue;
+
+class SortNodeTest : public ::testing::Test {
+ public:
+  SortNodeTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  }
+
+ protected:
+  std::unique_ptr<plan::Operator> PlanNodeFromPbtxt(const std::string& pbtxt) {
+    planpb::Operator op_pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(
+        absl::Substitute(planpb::testutils::kOperatorProtoTmpl, "SORT_OPERATOR", "sort_op", pbtxt),
+        &op_pb));
+    return plan::SortOperator::FromProto(op_pb, 1);
+  }
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(SortNodeTest, top_k_across_batches) {
+  // Keeps the 3 rows with the largest col_1 and outputs col_1 and col_0.
+  auto plan_node = PlanNodeFromPbtxt(R"(
+  sort_columns {
+    index: 1
+    ascending: false
+  }
+  limit: 3
+  columns {
+    node: 0
+    index: 1
+  }
+  columns {
+    node: 0
+    index: 0
+  }
+)");
+  RowDescriptor input_rd({types::DataType::STRING, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<SortNode, plan::SortOperator>(*plan_node, output_rd,
+                                                                   {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<StringValue>({"a", "b", "c", "d"})
+                       .AddColumn<Int64Value>({5, 1, 7, 3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<StringValue>({"e", "f", "g"})
+                       .AddColumn<Int64Value>({2, 9, 4})
+                       .get(),
+                   0, 0)
+      // Rows that don't make the top 3 are dropped.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<StringValue>({"h", "i"})
+                       .AddColumn<Int64Value>({0, 6})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, /*eow*/ true, /*eos*/ true)
+                          .AddColumn<Int64Value>({9, 7, 6})
+                          .AddColumn<StringValue>({"f", "c", "i"})
+                          .get())
+      .Close();
+}
+
+TEST_F(SortNodeTest, sort_all_rows_by_multiple_columns) {
+  auto plan_node = PlanNodeFromPbtxt(R"(
+  sort_columns {
+    index: 0
+    ascending: true
+  }
+  sort_columns {
+    index: 1
+    ascending: false
+  }
+  columns {
+    node: 0
+    index: 0
+  }
+  columns {
+    node: 0
+    index: 1
+  }
+)");
+  RowDescriptor input_rd({types::DataType::STRING, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<SortNode, plan::SortOperator>(*plan_node, input_rd,
+                                                                   {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<StringValue>({"b", "a", "b"})
+                       .AddColumn<Int64Value>({1, 2, 3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<StringValue>({"a", "c"})
+                       .AddColumn<Int64Value>({4, 0})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(input_rd, 5, /*eow*/ true, /*eos*/ true)
+                          .AddColumn<StringValue>({"a", "a", "b", "b", "c"})
+                          .AddColumn<Int64Value>({4, 2, 3, 1, 0})
+                          .get())
+      .Close();
+}
+
+TEST_F(SortNodeTest, empty_input) {
+  auto plan_node = PlanNodeFromPbtxt(R"(
+  sort_columns {
+    index: 0
+    ascending: true
+  }
+  limit: 10
+  columns {
+    node: 0
+    index: 0
+  }
+)");
+  RowDescriptor input_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<SortNode, plan::SortOperator>(*plan_node, input_rd,
+                                                                   {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 0, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<Int64Value>({})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(input_rd, 0, /*eow*/ true, /*eos*/ true)
+                          .AddColumn<Int64Value>({})
+                          .get())
+      .Close();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
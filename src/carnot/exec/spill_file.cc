@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/spill_file.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+StatusOr<std::unique_ptr<SpillFile>> SpillFile::Create(const std::string& dir) {
+  std::string path_template = dir + "/pl_spill_XXXXXX";
+  std::vector<char> path(path_template.begin(), path_template.end());
+  path.push_back('\0');
+
+  int fd = mkstemp(path.data());
+  if (fd < 0) {
+    return error::Internal("Failed to create spill file in $0 ($1)", dir, std::strerror(errno));
+  }
+  // Nothing else opens the file, so it can be unlinked right away.
+  unlink(path.data());
+
+  std::FILE* f = fdopen(fd, "w+b");
+  if (f == nullptr) {
+    close(fd);
+    return error::Internal("Failed to open spill file in $0 ($1)", dir, std::strerror(errno));
+  }
+  return std::unique_ptr<SpillFile>(new SpillFile(f));
+}
+
+SpillFile::~SpillFile() { fclose(f_); }
+
+Status SpillFile::Append(const RowBatch& rb) {
+  table_store::schemapb::RowBatchData proto;
+  PL_RETURN_IF_ERROR(rb.ToProto(&proto));
+  std::string data;
+  if (!proto.SerializeToString(&data)) {
+    return error::Internal("Failed to serialize row batch for spilling.");
+  }
+
+  uint64_t size = data.size();
+  if (fwrite(&size, sizeof(size), 1, f_) != 1 || fwrite(data.data(), 1, size, f_) != size) {
+    return error::Internal("Failed to write spill file ($0)", std::strerror(errno));
+  }
+  ++num_batches_;
+  bytes_ += sizeof(size) + size;
+  return Status::OK();
+}
+
+Status SpillFile::Rewind() {
+  if (fflush(f_) != 0 || fseek(f_, 0, SEEK_SET) != 0) {
+    return error::Internal("Failed to rewind spill file ($0)", std::strerror(errno));
+  }
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> SpillFile::ReadNext() {
+  uint64_t size = 0;
+  if (fread(&size, sizeof(size), 1, f_) != 1) {
+    if (feof(f_)) {
+      return std::unique_ptr<RowBatch>();
+    }
+    return error::Internal("Failed to read spill file ($0)", std::strerror(errno));
+  }
+
+  std::string data(size, '\0');
+  if (fread(data.data(), 1, size, f_) != size) {
+    return error::Internal("Truncated row batch in spill file.");
+  }
+  table_store::schemapb::RowBatchData proto;
+  if (!proto.ParseFromString(data)) {
+    return error::Internal("Failed to parse row batch from spill file.");
+  }
+  return RowBatch::FromProto(proto);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * SpillFile stores row batches on local disk, for operators that need to hold more data than
+ * their memory budget allows. Batches are written as length-prefixed RowBatchData protos and are
+ * read back in the order they were appended.
+ *
+ * The file is unlinked as soon as it is created, so it goes away with the SpillFile (or the
+ * process) without any cleanup.
+ */
+class SpillFile : public NotCopyable {
+ public:
+  /**
+   * Creates an empty spill file in the given directory.
+   */
+  static StatusOr<std::unique_ptr<SpillFile>> Create(const std::string& dir);
+
+  ~SpillFile();
+
+  Status Append(const table_store::schema::RowBatch& rb);
+
+  /**
+   * Moves back to the first batch. Must be called once all the batches are appended, before
+   * reading them.
+   */
+  Status Rewind();
+
+  /**
+   * @return the next batch in the file, or nullptr once all the batches have been read.
+   */
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> ReadNext();
+
+  int64_t num_batches() const { return num_batches_; }
+  int64_t bytes() const { return bytes_; }
+
+ private:
+  explicit SpillFile(std::FILE* f) : f_(f) {}
+
+  std::FILE* f_;
+  int64_t num_batches_ = 0;
+  int64_t bytes_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
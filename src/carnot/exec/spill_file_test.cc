@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/carnot/exec/spill_file.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+TEST(SpillFile, append_and_read) {
+  ASSERT_OK_AND_ASSIGN(auto spill, SpillFile::Create(fs::TempDirectoryPath().string()));
+
+  RowDescriptor rd({types::DataType::INT64, types::DataType::STRING});
+  RowBatch rb1(rd, 3);
+  EXPECT_OK(rb1.AddColumn(
+      types::ToArrow(std::vector<types::Int64Value>{1, 2, 3}, arrow::default_memory_pool())));
+  EXPECT_OK(rb1.AddColumn(types::ToArrow(std::vector<types::StringValue>{"a", "bc", ""},
+                                         arrow::default_memory_pool())));
+  RowBatch rb2(rd, 1);
+  rb2.set_eos(true);
+  EXPECT_OK(rb2.AddColumn(
+      types::ToArrow(std::vector<types::Int64Value>{4}, arrow::default_memory_pool())));
+  EXPECT_OK(rb2.AddColumn(
+      types::ToArrow(std::vector<types::StringValue>{"d"}, arrow::default_memory_pool())));
+
+  EXPECT_OK(spill->Append(rb1));
+  EXPECT_OK(spill->Append(rb2));
+  EXPECT_EQ(2, spill->num_batches());
+  EXPECT_GT(spill->bytes(), 0);
+
+  EXPECT_OK(spill->Rewind());
+  for (const RowBatch* expected : {&rb1, &rb2}) {
+    ASSERT_OK_AND_ASSIGN(auto actual, spill->ReadNext());
+    ASSERT_NE(nullptr, actual);
+    EXPECT_EQ(expected->num_rows(), actual->num_rows());
+    EXPECT_EQ(expected->eos(), actual->eos());
+    for (int64_t col_idx = 0; col_idx < expected->num_columns(); ++col_idx) {
+      EXPECT_TRUE(expected->ColumnAt(col_idx)->Equals(actual->ColumnAt(col_idx)));
+    }
+  }
+  ASSERT_OK_AND_ASSIGN(auto end, spill->ReadNext());
+  EXPECT_EQ(nullptr, end);
+}
+
+TEST(SpillFile, missing_dir) {
+  EXPECT_NOT_OK(SpillFile::Create("/this/dir/does/not/exist"));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
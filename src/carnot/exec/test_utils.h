@@ -378,6 +378,17 @@ class ExecNodeTester {
     return *this;
   }
 
+  /**
+   * Removes the last rowbatch output by ConsumeNext/GenerateNext, eg. to feed it to another node.
+   * @return the row batch.
+   */
+  std::unique_ptr<table_store::schema::RowBatch> PopRowBatch() {
+    DCHECK(current_row_batches_.size());
+    auto rb = std::move(current_row_batches_.front());
+    current_row_batches_.pop();
+    return rb;
+  }
+
   /**
    * Checks that the row batch matches the last rowbatch output by ConsumeNext/GenerateNext.
    * @param expected_rb Row batch that should match the last rowbatch output by
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/tracking_memory_pool.h"
+
+#include <utility>
+
+#include <absl/strings/substitute.h>
+
+DEFINE_int64(carnot_agent_memory_limit_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_AGENT_MEMORY_LIMIT_BYTES", 0),
+             "The number of bytes all the queries running on the agent can allocate together. "
+             "Set to '0' for no limit.");
+DEFINE_int64(carnot_query_memory_soft_limit_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_QUERY_MEMORY_SOFT_LIMIT_BYTES", 0),
+             "The number of bytes a query can allocate before its operators spill to disk, or the "
+             "query is aborted if they can't. Set to '0' for no limit.");
+DEFINE_int64(carnot_query_memory_hard_limit_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_QUERY_MEMORY_HARD_LIMIT_BYTES", 0),
+             "The number of bytes a query can allocate. Allocations past it fail. Set to '0' for "
+             "no limit.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+thread_local TrackingMemoryPool* current_pool = nullptr;
+}  // namespace
+
+TrackingMemoryPool::TrackingMemoryPool(std::string name,
+                                       std::shared_ptr<TrackingMemoryPool> parent,
+                                       int64_t soft_limit_bytes, int64_t hard_limit_bytes,
+                                       arrow::MemoryPool* backing_pool)
+    : name_(std::move(name)),
+      parent_(std::move(parent)),
+      soft_limit_bytes_(soft_limit_bytes),
+      hard_limit_bytes_(hard_limit_bytes),
+      backing_pool_(backing_pool) {}
+
+std::shared_ptr<TrackingMemoryPool> TrackingMemoryPool::Create(
+    std::string name, std::shared_ptr<TrackingMemoryPool> parent, int64_t soft_limit_bytes,
+    int64_t hard_limit_bytes, arrow::MemoryPool* backing_pool) {
+  return std::shared_ptr<TrackingMemoryPool>(new TrackingMemoryPool(
+      std::move(name), std::move(parent), soft_limit_bytes, hard_limit_bytes, backing_pool));
+}
+
+std::shared_ptr<TrackingMemoryPool> TrackingMemoryPool::AgentPool() {
+  static auto* pool = new std::shared_ptr<TrackingMemoryPool>(
+      Create("agent", nullptr, /* soft_limit_bytes */ 0, FLAGS_carnot_agent_memory_limit_bytes));
+  return *pool;
+}
+
+TrackingMemoryPool* TrackingMemoryPool::Current() { return current_pool; }
+
+TrackingMemoryPool::ScopedCurrent::ScopedCurrent(TrackingMemoryPool* pool) : prev_(current_pool) {
+  current_pool = pool;
+}
+
+TrackingMemoryPool::ScopedCurrent::~ScopedCurrent() { current_pool = prev_; }
+
+std::shared_ptr<TrackingMemoryPool> TrackingMemoryPool::CreateChild(std::string name,
+                                                                    int64_t soft_limit_bytes,
+                                                                    int64_t hard_limit_bytes) {
+  return Create(std::move(name), shared_from_this(), soft_limit_bytes, hard_limit_bytes,
+                backing_pool_);
+}
+
+arrow::Status TrackingMemoryPool::Reserve(int64_t bytes) {
+  for (TrackingMemoryPool* pool = this; pool != nullptr; pool = pool->parent_.get()) {
+    int64_t allocated = pool->bytes_allocated_.fetch_add(bytes) + bytes;
+    if (pool->hard_limit_bytes_ > 0 && allocated > pool->hard_limit_bytes_) {
+      for (TrackingMemoryPool* charged = this; charged != pool->parent_.get();
+           charged = charged->parent_.get()) {
+        charged->bytes_allocated_.fetch_sub(bytes);
+      }
+      return arrow::Status::OutOfMemory(
+          absl::Substitute("Allocating $0 bytes would take '$1' to $2 bytes, over its limit of $3 "
+                           "bytes.",
+                           bytes, pool->name_, allocated, pool->hard_limit_bytes_));
+    }
+  }
+  for (TrackingMemoryPool* pool = this; pool != nullptr; pool = pool->parent_.get()) {
+    int64_t allocated = pool->bytes_allocated_.load();
+    int64_t peak = pool->peak_bytes_.load();
+    while (allocated > peak && !pool->peak_bytes_.compare_exchange_weak(peak, allocated)) {
+    }
+  }
+  return arrow::Status::OK();
+}
+
+void TrackingMemoryPool::Unreserve(int64_t bytes) {
+  for (TrackingMemoryPool* pool = this; pool != nullptr; pool = pool->parent_.get()) {
+    pool->bytes_allocated_.fetch_sub(bytes);
+  }
+}
+
+void TrackingMemoryPool::AddAllocation() {
+  if (num_allocations_.fetch_add(1) != 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(self_ref_lock_);
+  if (num_allocations_.load() > 0 && self_ref_ == nullptr) {
+    self_ref_ = shared_from_this();
+  }
+}
+
+void TrackingMemoryPool::RemoveAllocation() {
+  if (num_allocations_.fetch_sub(1) != 1) {
+    return;
+  }
+  // Released outside the lock, since it can be the last reference to this pool.
+  std::shared_ptr<TrackingMemoryPool> self_ref;
+  {
+    std::lock_guard<std::mutex> lock(self_ref_lock_);
+    if (num_allocations_.load() == 0) {
+      self_ref = std::move(self_ref_);
+    }
+  }
+}
+
+arrow::Status TrackingMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  ARROW_RETURN_NOT_OK(Reserve(size));
+  arrow::Status s = backing_pool_->Allocate(size, out);
+  if (!s.ok()) {
+    Unreserve(size);
+    return s;
+  }
+  AddAllocation();
+  return s;
+}
+
+arrow::Status TrackingMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  if (new_size > old_size) {
+    ARROW_RETURN_NOT_OK(Reserve(new_size - old_size));
+  }
+  arrow::Status s = backing_pool_->Reallocate(old_size, new_size, ptr);
+  if (!s.ok()) {
+    if (new_size > old_size) {
+      Unreserve(new_size - old_size);
+    }
+    return s;
+  }
+  if (new_size < old_size) {
+    Unreserve(old_size - new_size);
+  }
+  return s;
+}
+
+void TrackingMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  backing_pool_->Free(buffer, size);
+  Unreserve(size);
+  RemoveAllocation();
+}
+
+bool TrackingMemoryPool::SoftLimitExceeded() const {
+  for (const TrackingMemoryPool* pool = this; pool != nullptr; pool = pool->parent_.get()) {
+    if (pool->soft_limit_bytes_ > 0 && pool->bytes_allocated() > pool->soft_limit_bytes_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Status TrackingMemoryPool::CheckSoftLimit() const {
+  for (const TrackingMemoryPool* pool = this; pool != nullptr; pool = pool->parent_.get()) {
+    if (pool->soft_limit_bytes_ > 0 && pool->bytes_allocated() > pool->soft_limit_bytes_) {
+      return error::ResourceUnavailable(
+          "'$0' is using $1 bytes, over its memory limit of $2 bytes.", pool->name_,
+          pool->bytes_allocated(), pool->soft_limit_bytes_);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
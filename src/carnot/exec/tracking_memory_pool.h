@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "src/common/base/base.h"
+
+DECLARE_int64(carnot_agent_memory_limit_bytes);
+DECLARE_int64(carnot_query_memory_soft_limit_bytes);
+DECLARE_int64(carnot_query_memory_hard_limit_bytes);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * TrackingMemoryPool is an arrow::MemoryPool that counts the bytes allocated through it and
+ * enforces limits on them. Pools form a tree (agent -> query -> operator): an allocation is charged
+ * to the pool it is made from and to all of its ancestors, and it fails with OutOfMemory if that
+ * takes any of them over its hard limit. The soft limit is only reported (see SoftLimitExceeded),
+ * so that the operators can spill or give up before the hard limit is hit.
+ *
+ * Arrow buffers keep a raw pointer to the pool that allocated them and can outlive the query (eg.
+ * when they are written to the table store), so a pool keeps itself alive for as long as it has
+ * outstanding allocations.
+ *
+ * A limit of 0 means unlimited.
+ */
+class TrackingMemoryPool : public arrow::MemoryPool,
+                           public std::enable_shared_from_this<TrackingMemoryPool> {
+ public:
+  static std::shared_ptr<TrackingMemoryPool> Create(
+      std::string name, std::shared_ptr<TrackingMemoryPool> parent, int64_t soft_limit_bytes,
+      int64_t hard_limit_bytes, arrow::MemoryPool* backing_pool = arrow::default_memory_pool());
+
+  /**
+   * The root of the pool tree, limited by --carnot_agent_memory_limit_bytes.
+   */
+  static std::shared_ptr<TrackingMemoryPool> AgentPool();
+
+  /**
+   * The pool of the exec node the calling thread is in, or nullptr if there is none.
+   */
+  static TrackingMemoryPool* Current();
+
+  /**
+   * Makes a pool the current one of the calling thread for the lifetime of the object.
+   */
+  class ScopedCurrent : public NotCopyable {
+   public:
+    explicit ScopedCurrent(TrackingMemoryPool* pool);
+    ~ScopedCurrent();
+
+   private:
+    TrackingMemoryPool* prev_;
+  };
+
+  std::shared_ptr<TrackingMemoryPool> CreateChild(std::string name, int64_t soft_limit_bytes = 0,
+                                                  int64_t hard_limit_bytes = 0);
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  int64_t bytes_allocated() const override { return bytes_allocated_.load(); }
+  // The peak of bytes_allocated().
+  int64_t max_memory() const override { return peak_bytes_.load(); }
+
+  /**
+   * @return whether this pool or any of its ancestors is over its soft limit.
+   */
+  bool SoftLimitExceeded() const;
+
+  /**
+   * @return a ResourceUnavailable error naming the pool over its soft limit, if there is one.
+   */
+  Status CheckSoftLimit() const;
+
+  const std::string& name() const { return name_; }
+  int64_t soft_limit_bytes() const { return soft_limit_bytes_; }
+  int64_t hard_limit_bytes() const { return hard_limit_bytes_; }
+
+ private:
+  TrackingMemoryPool(std::string name, std::shared_ptr<TrackingMemoryPool> parent,
+                     int64_t soft_limit_bytes, int64_t hard_limit_bytes,
+                     arrow::MemoryPool* backing_pool);
+
+  // Charges the bytes to this pool and its ancestors, or to none of them if that takes one over its
+  // hard limit.
+  arrow::Status Reserve(int64_t bytes);
+  void Unreserve(int64_t bytes);
+
+  void AddAllocation();
+  void RemoveAllocation();
+
+  const std::string name_;
+  const std::shared_ptr<TrackingMemoryPool> parent_;
+  const int64_t soft_limit_bytes_;
+  const int64_t hard_limit_bytes_;
+  arrow::MemoryPool* backing_pool_;
+
+  std::atomic<int64_t> bytes_allocated_{0};
+  std::atomic<int64_t> peak_bytes_{0};
+  std::atomic<int64_t> num_allocations_{0};
+
+  // Holds a reference to this pool while it has outstanding allocations.
+  std::mutex self_ref_lock_;
+  std::shared_ptr<TrackingMemoryPool> self_ref_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
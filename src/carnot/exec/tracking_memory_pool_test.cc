@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/buffer.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/carnot/exec/tracking_memory_pool.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(TrackingMemoryPool, charges_ancestors) {
+  auto agent = TrackingMemoryPool::Create("agent", nullptr, 0, 0);
+  auto query = agent->CreateChild("query");
+  auto node = query->CreateChild("node");
+
+  uint8_t* data = nullptr;
+  ASSERT_TRUE(node->Allocate(1000, &data).ok());
+  EXPECT_EQ(1000, node->bytes_allocated());
+  EXPECT_EQ(1000, query->bytes_allocated());
+  EXPECT_EQ(1000, agent->bytes_allocated());
+
+  ASSERT_TRUE(node->Reallocate(1000, 3000, &data).ok());
+  ASSERT_TRUE(node->Reallocate(3000, 2000, &data).ok());
+  EXPECT_EQ(2000, agent->bytes_allocated());
+
+  node->Free(data, 2000);
+  EXPECT_EQ(0, node->bytes_allocated());
+  EXPECT_EQ(0, agent->bytes_allocated());
+  EXPECT_EQ(3000, node->max_memory());
+  EXPECT_EQ(3000, agent->max_memory());
+}
+
+TEST(TrackingMemoryPool, hard_limit) {
+  auto agent = TrackingMemoryPool::Create("agent", nullptr, 0, 0);
+  auto query = agent->CreateChild("query", /* soft_limit_bytes */ 0, /* hard_limit_bytes */ 1000);
+  auto node = query->CreateChild("node");
+
+  uint8_t* data = nullptr;
+  ASSERT_TRUE(node->Allocate(800, &data).ok());
+  uint8_t* other = nullptr;
+  arrow::Status s = node->Allocate(800, &other);
+  EXPECT_TRUE(s.IsOutOfMemory());
+  EXPECT_NE(std::string::npos, s.message().find("query"));
+  // The failed allocation isn't charged to any of the pools.
+  EXPECT_EQ(800, node->bytes_allocated());
+  EXPECT_EQ(800, agent->bytes_allocated());
+  EXPECT_TRUE(node->Reallocate(800, 1200, &data).IsOutOfMemory());
+  EXPECT_EQ(800, agent->max_memory());
+
+  node->Free(data, 800);
+  EXPECT_EQ(0, agent->bytes_allocated());
+}
+
+TEST(TrackingMemoryPool, soft_limit) {
+  auto agent = TrackingMemoryPool::Create("agent", nullptr, 0, 0);
+  auto query = agent->CreateChild("query", /* soft_limit_bytes */ 1000);
+  auto node = query->CreateChild("node");
+  auto other_node = query->CreateChild("other_node");
+
+  uint8_t* data = nullptr;
+  ASSERT_TRUE(node->Allocate(1500, &data).ok());
+  // Soft limits don't fail allocations, they are reported to all the pools under them.
+  EXPECT_TRUE(other_node->SoftLimitExceeded());
+  EXPECT_FALSE(agent->SoftLimitExceeded());
+  Status s = other_node->CheckSoftLimit();
+  EXPECT_EQ(statuspb::RESOURCE_UNAVAILABLE, s.code());
+  EXPECT_NE(std::string::npos, s.msg().find("'query'"));
+
+  node->Free(data, 1500);
+  EXPECT_FALSE(other_node->SoftLimitExceeded());
+  EXPECT_OK(other_node->CheckSoftLimit());
+}
+
+TEST(TrackingMemoryPool, outlives_owner_while_allocated) {
+  auto agent = TrackingMemoryPool::Create("agent", nullptr, 0, 0);
+  auto query = agent->CreateChild("query");
+  std::weak_ptr<TrackingMemoryPool> weak_query = query;
+
+  std::shared_ptr<arrow::Buffer> buffer;
+  ASSERT_TRUE(arrow::AllocateBuffer(query.get(), 100, &buffer).ok());
+  query.reset();
+  EXPECT_FALSE(weak_query.expired());
+  EXPECT_EQ(100, agent->bytes_allocated());
+
+  buffer.reset();
+  EXPECT_TRUE(weak_query.expired());
+  EXPECT_EQ(0, agent->bytes_allocated());
+}
+
+TEST(TrackingMemoryPool, scoped_current) {
+  auto query = TrackingMemoryPool::Create("query", nullptr, 0, 0);
+  auto node = query->CreateChild("node");
+  EXPECT_EQ(nullptr, TrackingMemoryPool::Current());
+  {
+    TrackingMemoryPool::ScopedCurrent scoped_query(query.get());
+    EXPECT_EQ(query.get(), TrackingMemoryPool::Current());
+    {
+      TrackingMemoryPool::ScopedCurrent scoped_node(node.get());
+      EXPECT_EQ(node.get(), TrackingMemoryPool::Current());
+    }
+    EXPECT_EQ(query.get(), TrackingMemoryPool::Current());
+  }
+  EXPECT_EQ(nullptr, TrackingMemoryPool::Current());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
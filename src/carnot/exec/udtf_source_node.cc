@@ -65,6 +65,8 @@ Status UDTFSourceNode::PrepareImpl(ExecState* exec_state) {
 Status UDTFSourceNode::OpenImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
   udtf_inst_ = udtf_def_->Make();
+  udtf_ready_ = false;
+  ready_status_ = Status::OK();
 
   ObjectPool init_args_pool{"udtf_init_args_pool"};
   std::vector<const types::BaseValueType*> init_args;
@@ -99,10 +101,11 @@ Status UDTFSourceNode::OpenImpl(ExecState* exec_state) {
 Status UDTFSourceNode::CloseImpl(ExecState* /*exec_state*/) { return Status::OK(); }
 
 Status UDTFSourceNode::GenerateNextImpl(ExecState* exec_state) {
+  PL_RETURN_IF_ERROR(ready_status_);
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> outputs;
 
   for (const auto& r : udtf_def_->output_relation()) {
-    outputs.emplace_back(types::MakeArrowBuilder(r.type(), arrow::default_memory_pool()));
+    outputs.emplace_back(types::MakeArrowBuilder(r.type(), exec_state->exec_mem_pool()));
   }
 
   // TODO(zasgar): Change Exec to take in unique_ptrs.
@@ -126,7 +129,19 @@ Status UDTFSourceNode::GenerateNextImpl(ExecState* exec_state) {
   return SendRowBatchToChildren(exec_state, *rb);
 }
 
-bool UDTFSourceNode::NextBatchReady() { return HasBatchesRemaining(); }
+bool UDTFSourceNode::NextBatchReady() {
+  if (!HasBatchesRemaining() || udtf_ready_ || udtf_inst_ == nullptr) {
+    return HasBatchesRemaining();
+  }
+  auto ready_or_s = udtf_def_->ExecReady(udtf_inst_.get(), function_ctx_.get());
+  if (!ready_or_s.ok()) {
+    // GenerateNext returns the error.
+    ready_status_ = ready_or_s.status();
+    return true;
+  }
+  udtf_ready_ = ready_or_s.ConsumeValueOrDie();
+  return udtf_ready_;
+}
 
 }  // namespace exec
 }  // namespace carnot
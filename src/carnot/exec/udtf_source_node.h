@@ -54,6 +54,10 @@ class UDTFSourceNode : public SourceNode {
 
  private:
   bool has_more_batches_ = true;
+  // Set once the UDTF reports that it is ready to produce records.
+  bool udtf_ready_ = false;
+  // Error from the UDTF's Ready call, returned by the next GenerateNext.
+  Status ready_status_;
   udf::UDTFDefinition* udtf_def_ = nullptr;
   std::unique_ptr<plan::UDTFSourceOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
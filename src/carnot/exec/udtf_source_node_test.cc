@@ -19,6 +19,7 @@
 #include "src/carnot/exec/udtf_source_node.h"
 
 #include <stdint.h>
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -87,6 +88,40 @@ class BasicTestUDTF : public UDTF<BasicTestUDTF> {
   std::string some_string_;
 };
 
+// Produces its records in one NextBatch call once the test marks it ready.
+class DeferredTestUDTF : public UDTF<DeferredTestUDTF> {
+ public:
+  static constexpr auto Executor() { return udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(
+        ColInfo("out_int", types::DataType::INT64, types::PatternType::GENERAL, "int result"));
+  }
+
+  StatusOr<bool> Ready(FunctionContext*) {
+    PL_RETURN_IF_ERROR(ready_status);
+    return ready;
+  }
+
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    EXPECT_TRUE(ready);
+    for (int i = 0; i < std::min(max_records, 3); ++i) {
+      rw->Append<IndexOf("out_int")>(i);
+    }
+    return false;
+  }
+
+  static inline bool ready = false;
+  static inline Status ready_status;
+};
+
+constexpr char kDeferredUDTFTestPbtxt[] = R"proto(
+  op_type: UDTF_SOURCE_OPERATOR
+  udtf_source_op {
+    name: "deferred_udtf"
+  }
+)proto";
+
 constexpr char kUDTFTestPbtxt[] = R"proto(
   op_type: UDTF_SOURCE_OPERATOR
   udtf_source_op {
@@ -111,6 +146,7 @@ class UDTFSourceNodeTest : public ::testing::Test {
 
     func_registry_ = std::make_unique<udf::Registry>("test_registry");
     EXPECT_OK(func_registry_->Register<BasicTestUDTF>("test_udtf"));
+    EXPECT_OK(func_registry_->Register<DeferredTestUDTF>("deferred_udtf"));
     auto table_store = std::make_shared<table_store::TableStore>();
 
     exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
@@ -135,6 +171,44 @@ TEST_F(UDTFSourceNodeTest, single_output_batch_test) {
           .get());
 }
 
+TEST_F(UDTFSourceNodeTest, waits_for_ready) {
+  planpb::Operator op_pb;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kDeferredUDTFTestPbtxt, &op_pb));
+  auto plan_node = plan::UDTFSourceOperator::FromProto(op_pb, 1);
+  DeferredTestUDTF::ready = false;
+  DeferredTestUDTF::ready_status = Status::OK();
+
+  RowDescriptor output_rd({types::DataType::INT64});
+  auto tester = exec::ExecNodeTester<UDTFSourceNode, plan::UDTFSourceOperator>(
+      *plan_node, output_rd, {}, exec_state_.get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  EXPECT_FALSE(tester.node()->NextBatchReady());
+  EXPECT_FALSE(tester.node()->NextBatchReady());
+
+  DeferredTestUDTF::ready = true;
+  EXPECT_TRUE(tester.node()->NextBatchReady());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 3, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Int64Value>({0, 1, 2})
+          .get());
+  EXPECT_FALSE(tester.node()->NextBatchReady());
+}
+
+TEST_F(UDTFSourceNodeTest, ready_error_fails_generate) {
+  planpb::Operator op_pb;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kDeferredUDTFTestPbtxt, &op_pb));
+  auto plan_node = plan::UDTFSourceOperator::FromProto(op_pb, 1);
+  DeferredTestUDTF::ready = false;
+  DeferredTestUDTF::ready_status = error::Internal("rpc failed");
+
+  RowDescriptor output_rd({types::DataType::INT64});
+  auto tester = exec::ExecNodeTester<UDTFSourceNode, plan::UDTFSourceOperator>(
+      *plan_node, output_rd, {}, exec_state_.get());
+  // The node reports a batch so that GenerateNext surfaces the error.
+  EXPECT_TRUE(tester.node()->NextBatchReady());
+  EXPECT_NOT_OK(tester.node()->GenerateNext(exec_state_.get()));
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
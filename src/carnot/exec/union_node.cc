@@ -21,13 +21,18 @@
 #include <arrow/memory_pool.h>
 #include <arrow/status.h>
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/str_join.h>
 #include <absl/strings/substitute.h>
 
+#include "src/carnot/exec/radix_sort.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
 #include "src/shared/types/arrow_adapter.h"
@@ -41,6 +46,35 @@ namespace exec {
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
+namespace {
+
+// Appends rows [offset, offset + num_rows) of input to the builder, which must have room for them.
+template <types::DataType T>
+Status AppendSlice(arrow::ArrayBuilder* output_col_builder, const arrow::Array* input,
+                   int64_t offset, int64_t num_rows) {
+  auto* builder =
+      static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(output_col_builder);
+  if constexpr (T == types::DataType::STRING) {
+    const auto* strs = static_cast<const arrow::StringArray*>(input);
+    int64_t size = builder->value_data_length() + strs->value_offset(offset + num_rows) -
+                   strs->value_offset(offset);
+    if (size > builder->value_data_capacity()) {
+      PL_RETURN_IF_ERROR(builder->ReserveData(std::lrint(1.5 * size)));
+    }
+    for (int64_t i = offset; i < offset + num_rows; ++i) {
+      auto str = strs->GetView(i);
+      builder->UnsafeAppend(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+    }
+  } else {
+    for (int64_t i = offset; i < offset + num_rows; ++i) {
+      builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input, i));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 std::string UnionNode::DebugStringImpl() {
   return absl::Substitute("Exec::UnionNode<$0>", absl::StrJoin(plan_node_->column_names(), ","));
 }
@@ -51,6 +85,13 @@ Status UnionNode::InitImpl(const plan::Operator& plan_node) {
   plan_node_ = std::make_unique<plan::UnionOperator>(*union_plan_node);
   output_rows_per_batch_ =
       plan_node_->rows_per_batch() == 0 ? kDefaultUnionRowBatchSize : plan_node_->rows_per_batch();
+  if (plan_node_->rows_per_batch() == 0) {
+    auto batch_sizer = std::make_unique<BatchSizer>(*output_descriptor_);
+    if (batch_sizer->enabled()) {
+      output_rows_per_batch_ = batch_sizer->RowsPerBatch();
+      batch_sizer_ = std::move(batch_sizer);
+    }
+  }
   num_parents_ = input_descriptors_.size();
 
   return Status::OK();
@@ -58,8 +99,10 @@ Status UnionNode::InitImpl(const plan::Operator& plan_node) {
 
 Status UnionNode::InitializeColumnBuilders() {
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
-    column_builders_[i] =
-        MakeArrowBuilder(output_descriptor_->type(i), arrow::default_memory_pool());
+    // Finishing a batch resets the builder, so only its buffers have to be reserved again.
+    if (column_builders_[i] == nullptr) {
+      column_builders_[i] = MakeArrowBuilder(output_descriptor_->type(i), mem_pool());
+    }
     PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
   }
   return Status::OK();
@@ -76,6 +119,7 @@ Status UnionNode::PrepareImpl(ExecState*) {
     row_cursors_.resize(num_parents_);
     time_columns_.resize(num_parents_);
     data_columns_.resize(num_parents_, std::vector<arrow::Array*>(num_output_cols));
+    merge_tree_.resize(num_parents_);
 
     column_builders_.resize(num_output_cols);
     PL_RETURN_IF_ERROR(InitializeColumnBuilders());
@@ -111,13 +155,71 @@ types::Time64NSValue UnionNode::GetTimeAtParentCursor(size_t parent_index) const
                                                         row_cursors_[parent_index]);
 }
 
-Status UnionNode::AppendRow(size_t parent) {
-  auto row = row_cursors_[parent];
+bool UnionNode::MergesBefore(size_t a, size_t b) const {
+  if (flushed_parent_eoses_[a] || flushed_parent_eoses_[b]) {
+    return !flushed_parent_eoses_[a] || (flushed_parent_eoses_[b] && a < b);
+  }
+  auto time_a = GetTimeAtParentCursor(a);
+  auto time_b = GetTimeAtParentCursor(b);
+  return time_a < time_b || (time_a == time_b && a < b);
+}
+
+void UnionNode::BuildMergeTree() {
+  // The leaves are the parents, at nodes num_parents_ to 2 * num_parents_ - 1.
+  std::vector<size_t> winners(num_parents_);
+  auto winner_at = [&](size_t node) {
+    return node >= num_parents_ ? node - num_parents_ : winners[node];
+  };
+  for (size_t node = num_parents_ - 1; node > 0; --node) {
+    size_t left = winner_at(2 * node);
+    size_t right = winner_at(2 * node + 1);
+    bool left_wins = MergesBefore(left, right);
+    winners[node] = left_wins ? left : right;
+    merge_tree_[node] = left_wins ? right : left;
+  }
+  merge_tree_[0] = num_parents_ > 1 ? winners[1] : 0;
+}
+
+void UnionNode::ReplayMergeTree(size_t parent) {
+  size_t winner = parent;
+  for (size_t node = (parent + num_parents_) / 2; node > 0; node /= 2) {
+    if (MergesBefore(merge_tree_[node], winner)) {
+      std::swap(merge_tree_[node], winner);
+    }
+  }
+  merge_tree_[0] = winner;
+}
+
+int64_t UnionNode::WinnerRunLength(int64_t max_rows) const {
+  size_t parent = merge_tree_[0];
+  int64_t begin = row_cursors_[parent];
+  int64_t end = std::min<int64_t>(parent_row_batches_[parent][0].num_rows(), begin + max_rows);
+
+  // The winner keeps winning until it passes the best of the parents it beat on its way up.
+  std::optional<size_t> runner_up;
+  for (size_t node = (parent + num_parents_) / 2; node > 0; node /= 2) {
+    if (!runner_up.has_value() || MergesBefore(merge_tree_[node], *runner_up)) {
+      runner_up = merge_tree_[node];
+    }
+  }
+  if (!runner_up.has_value() || flushed_parent_eoses_[*runner_up]) {
+    return end - begin;
+  }
+
+  // The rows are ordered by time, so the run ends at the first row that the runner-up goes before.
+  int64_t limit = GetTimeAtParentCursor(*runner_up).val;
+  bool ties_included = parent < *runner_up;
+  // The winner's row at the cursor is always part of the run.
+  const int64_t* times = static_cast<const arrow::Int64Array*>(time_columns_[parent])->raw_values();
+  return SortedRunEnd(times, begin + 1, end, limit, ties_included) - begin;
+}
+
+Status UnionNode::AppendRows(size_t parent, int64_t num_rows) {
+  int64_t offset = row_cursors_[parent];
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
-    auto input_col = data_columns_[parent][i];
-#define TYPE_CASE(_dt_)                                    \
-  PL_RETURN_IF_ERROR(table_store::schema::CopyValue<_dt_>( \
-      column_builders_[i].get(), types::GetValueFromArrowArray<_dt_>(input_col, row)));
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(   \
+      AppendSlice<_dt_>(column_builders_[i].get(), data_columns_[parent][i], offset, num_rows));
     PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
 #undef TYPE_CASE
   }
@@ -164,78 +266,63 @@ Status UnionNode::FlushBatch(ExecState* exec_state) {
   bool eos = InputsComplete();
   PL_ASSIGN_OR_RETURN(auto rb, RowBatch::FromColumnBuilders(*output_descriptor_, /*eow*/ eos,
                                                             /*eos*/ eos, &column_builders_));
+  if (batch_sizer_ != nullptr) {
+    batch_sizer_->Observe(*rb);
+    output_rows_per_batch_ = batch_sizer_->RowsPerBatch();
+  }
   PL_RETURN_IF_ERROR(InitializeColumnBuilders());
   last_data_flush_time_ = std::chrono::system_clock::now();
   return SendRowBatchToChildren(exec_state, *rb);
 }
 
 Status UnionNode::MergeData(ExecState* exec_state) {
-  while (!sent_eos_) {
-    // Get the smallest time out of all of the current streams.
-    std::vector<size_t> parent_streams;
-    parent_streams.reserve(row_cursors_.size());
-
-    for (size_t parent = 0; parent < row_cursors_.size(); ++parent) {
-      if (flushed_parent_eoses_[parent]) {
-        continue;
-      }
-      // If we lack necessary data, we can't merge anymore.
-      if (!parent_row_batches_[parent].size()) {
-        return Status::OK();
-      }
-      parent_streams.push_back(parent);
+  if (sent_eos_) {
+    return Status::OK();
+  }
+  // If we lack the next rows of any of the parents, we can't merge at all.
+  for (size_t parent = 0; parent < num_parents_; ++parent) {
+    if (!flushed_parent_eoses_[parent] && parent_row_batches_[parent].empty()) {
+      return Status::OK();
     }
+  }
 
+  // Every step copies the run of rows of the winning parent that go before the rows of all of the
+  // other parents, so the tree is only replayed once per run rather than once per row.
+  BuildMergeTree();
+  while (true) {
+    size_t parent = merge_tree_[0];
     // If we have reached end of stream for all of our inputs, flush the queue.
-    if (!parent_streams.size()) {
+    if (flushed_parent_eoses_[parent]) {
       return OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state);
     }
 
-    std::sort(parent_streams.begin(), parent_streams.end(),
-              [this](size_t parent_a, size_t parent_b) {
-                auto time_a = GetTimeAtParentCursor(parent_a);
-                auto time_b = GetTimeAtParentCursor(parent_b);
-                return time_a < time_b || (time_a == time_b && parent_a < parent_b);
-              });
-
-    bool has_limit = parent_streams.size() > 1;
-    size_t parent = parent_streams[0];
-
-    while (parent_row_batches_[parent].size()) {
-      if (has_limit) {
-        size_t next_parent = parent_streams[1];
-        // If this time is greater than another parent stream's earliest time,
-        // or if they are the same but the first parent is at a smaller index, stop merging.
-        // This way rows are always stable with respect to input parent index.
-        if (GetTimeAtParentCursor(parent) > GetTimeAtParentCursor(next_parent) ||
-            (GetTimeAtParentCursor(parent) == GetTimeAtParentCursor(next_parent) &&
-             parent > next_parent)) {
-          break;
-        }
-      }
-
-      PL_RETURN_IF_ERROR(AppendRow(parent));
-
-      // Mark whether or not we hit the eos for this stream, and whether the row batch needs to be
-      // popped.
-      const auto& rb = parent_row_batches_[parent][0];
-      bool pop_row_batch = ++row_cursors_[parent] == static_cast<size_t>(rb.num_rows());
-      if (pop_row_batch && rb.eos()) {
-        flushed_parent_eoses_[parent] = true;
-      }
-
-      if (pop_row_batch) {
-        // Delete the top row batch from our buffer and update the cursor.
-        parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
-        row_cursors_[parent] = 0;
-        CacheNextRowBatch(parent);
-      }
-
-      // Flush the current RowBatch if necessary.
-      PL_RETURN_IF_ERROR(OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state));
+    int64_t capacity = output_rows_per_batch_ - column_builders_[0]->length();
+    int64_t num_rows = WinnerRunLength(capacity);
+    PL_RETURN_IF_ERROR(AppendRows(parent, num_rows));
+
+    // Mark whether or not we hit the eos for this stream, and whether the row batch needs to be
+    // popped.
+    const auto& rb = parent_row_batches_[parent][0];
+    row_cursors_[parent] += num_rows;
+    bool pop_row_batch = row_cursors_[parent] == static_cast<size_t>(rb.num_rows());
+    if (pop_row_batch && rb.eos()) {
+      flushed_parent_eoses_[parent] = true;
     }
+
+    if (pop_row_batch) {
+      // Delete the top row batch from our buffer and update the cursor.
+      parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
+      row_cursors_[parent] = 0;
+      CacheNextRowBatch(parent);
+    }
+
+    // Flush the current RowBatch if necessary.
+    PL_RETURN_IF_ERROR(OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state));
+    if (sent_eos_ || (!flushed_parent_eoses_[parent] && parent_row_batches_[parent].empty())) {
+      return Status::OK();
+    }
+    ReplayMergeTree(parent);
   }
-  return Status::OK();
 }
 
 void UnionNode::CacheNextRowBatch(size_t parent) {
@@ -26,6 +26,7 @@
 #include <utility>
 #include <vector>
 
+#include "src/carnot/exec/batch_sizer.h"
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/plan/operators.h"
@@ -48,15 +49,6 @@ class UnionNode : public ProcessingNode {
   UnionNode() = default;
   virtual ~UnionNode() = default;
 
-  // For the time ordered case: A MergeRow represents a row in an input row batch.
-  struct MergeRow {
-    size_t parent_index;
-    size_t row_batch_id;
-    size_t row_number;
-    types::Time64NSValue time;
-    bool end_of_row_batch;
-  };
-
   void disable_data_flush_timeout() { enable_data_flush_timeout_ = false; }
   void set_data_flush_timeout(const std::chrono::milliseconds& data_flush_timeout) {
     enable_data_flush_timeout_ = true;
@@ -91,7 +83,19 @@ class UnionNode : public ProcessingNode {
   void CacheNextRowBatch(size_t parent);
   Status InitializeColumnBuilders();
   types::Time64NSValue GetTimeAtParentCursor(size_t parent_index) const;
-  Status AppendRow(size_t parent);
+  // Whether the row at the cursor of parent a is merged before the row at the cursor of parent b.
+  // Ties go to the lower parent index, and parents that reached eos go last.
+  bool MergesBefore(size_t a, size_t b) const;
+  // The merge is a loser tree over the parent cursors: merge_tree_[0] holds the parent with the
+  // next row, and the internal node i > 0 the parent that lost the match played at it.
+  void BuildMergeTree();
+  // Replays the matches on the path of parent, after its cursor moved.
+  void ReplayMergeTree(size_t parent);
+  // The number of rows from the cursor of the winning parent that are merged before the rows of
+  // all of the other parents, at most max_rows and the rest of its current row batch.
+  int64_t WinnerRunLength(int64_t max_rows) const;
+  // Copies the next num_rows rows of parent into the column builders.
+  Status AppendRows(size_t parent, int64_t num_rows);
   Status OptionallyFlushRowBatchIfMaxRowsOrEOS(ExecState* exec_state);
   Status OptionallyFlushRowBatchIfTimeout(ExecState* exec_state);
   Status FlushBatch(ExecState* exec_state);
@@ -100,9 +104,14 @@ class UnionNode : public ProcessingNode {
   // output_rows_per_batch is only used in the ordered case, because in the unordered case,
   // we just maintain the original row count to avoid copying the data.
   size_t output_rows_per_batch_;
+  // Resizes output_rows_per_batch_ to the byte budget after every flush, when the plan doesn't
+  // fix it.
+  std::unique_ptr<BatchSizer> batch_sizer_;
 
-  // Column builders will flush a batch once they hit output_rows_per_batch_ rows.
+  // Column builders will flush a batch once they hit output_rows_per_batch_ rows. They are reused
+  // across flushes.
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> column_builders_;
+  std::vector<size_t> merge_tree_;
 
   // Hold onto the input row batches for every parent until we copy all of their data.
   std::vector<std::vector<table_store::schema::RowBatch>> parent_row_batches_;
@@ -275,6 +275,54 @@ TEST_F(UnionNodeTest, ordered_full_overlap) {
       .Close();
 }
 
+TEST_F(UnionNodeTest, ordered_many_parents) {
+  auto op_proto = planpb::testutils::CreateTestUnionOrderedPB();
+  auto mapping = op_proto.mutable_union_op()->add_column_mappings();
+  mapping->add_column_indexes(0);
+  mapping->add_column_indexes(1);
+  plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor input_rd_0({types::DataType::STRING, types::DataType::TIME64NS});
+  RowDescriptor input_rd_1({types::DataType::TIME64NS, types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::STRING, types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<UnionNode, plan::UnionOperator>(
+      *plan_node_, output_rd, {input_rd_0, input_rd_1, input_rd_0}, exec_state_.get());
+  tester.node()->disable_data_flush_timeout();
+
+  // Runs of rows from the same parent are merged whole, and ties go to the lower parent.
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 5, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::StringValue>({"A", "B", "C", "D", "E"})
+                       .AddColumn<types::Time64NSValue>({0, 1, 1, 5, 6})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 5, true, true)
+                       .AddColumn<types::Time64NSValue>({1, 2, 3, 4, 6})
+                       .AddColumn<types::StringValue>({"a", "b", "c", "d", "e"})
+                       .get(),
+                   1, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, true, true)
+                       .AddColumn<types::StringValue>({"X", "Y", "Z"})
+                       .AddColumn<types::Time64NSValue>({0, 1, 7})
+                       .get(),
+                   2, 3)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, false, false)
+                          .AddColumn<types::StringValue>({"A", "X", "B", "C", "a"})
+                          .AddColumn<types::Time64NSValue>({0, 0, 1, 1, 1})
+                          .get())
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, false, false)
+                          .AddColumn<types::StringValue>({"Y", "b", "c", "d", "D"})
+                          .AddColumn<types::Time64NSValue>({1, 2, 3, 4, 5})
+                          .get())
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::StringValue>({"E", "e", "Z"})
+                          .AddColumn<types::Time64NSValue>({6, 6, 7})
+                          .get())
+      .Close();
+}
+
 TEST_F(UnionNodeTest, no_rows_parent) {
   auto op_proto = planpb::testutils::CreateTestUnionOrderedPB();
   plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
@@ -34,9 +34,10 @@ void RegisterConditionalOpsOrDie(udf::Registry* registry);
 template <typename TArg>
 class SelectUDF : public udf::ScalarUDF {
  public:
+  // Batches are blended without Exec, and a side no row selects isn't evaluated.
+  static constexpr bool kConditional = true;
+
   TArg Exec(FunctionContext*, BoolValue s, TArg v1, TArg v2) {
-    // TODO(zasgar): This does do eager evaluation of both sides./
-    // If we start thinking about code generation, we can probably optimize this.
     if (s.val) {
       return v1;
     }
@@ -19,10 +19,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include <rapidjson/document.h>
+#include <rapidjson/reader.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
@@ -35,34 +37,182 @@ namespace builtins {
 
 // TODO(zasgar): PL-419 To have proper support for JSON we need structs and nullable types.
 // Revisit when we have them.
-class PluckUDF : public udf::ScalarUDF {
+namespace internal {
+
+// The value of a top level key of a JSON object.
+struct PluckedValue {
+  enum Type { kMissing, kNull, kString, kInt64, kDouble, kOther };
+  Type type = kMissing;
+  // The string value, or the serialized JSON for the other types.
+  std::string str;
+  int64_t int64_value = 0;
+  double double_value = 0.0;
+};
+
+/**
+ * A SAX handler that reads the value of a top level key of a JSON object. It returns false (which
+ * stops the parse) as soon as the value has been read, so the rest of the document is skipped and
+ * no DOM is built.
+ */
+class PluckHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, PluckHandler> {
  public:
-  StringValue Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
-    // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return "";
+  explicit PluckHandler(std::string_view key) : key_(key), writer_(buffer_) {}
+
+  bool Null() {
+    return Scalar(PluckedValue::kNull, [this] { writer_.Null(); });
+  }
+  bool Bool(bool b) {
+    return Scalar(PluckedValue::kOther, [this, b] { writer_.Bool(b); });
+  }
+  bool Int(int i) { return Int64(i); }
+  bool Uint(unsigned u) { return Int64(u); }
+  bool Int64(int64_t i) {
+    if (AtValue()) {
+      value_.int64_value = i;
+      value_.double_value = static_cast<double>(i);
+    }
+    return Scalar(PluckedValue::kInt64, [this, i] { writer_.Int64(i); });
+  }
+  bool Uint64(uint64_t u) {
+    if (AtValue()) {
+      value_.int64_value = static_cast<int64_t>(u);
+      value_.double_value = static_cast<double>(u);
+    }
+    return Scalar(PluckedValue::kInt64, [this, u] { writer_.Uint64(u); });
+  }
+  bool Double(double d) {
+    if (AtValue()) {
+      value_.double_value = d;
     }
-    if (!d.IsObject()) {
-      return "";
+    return Scalar(PluckedValue::kDouble, [this, d] { writer_.Double(d); });
+  }
+  bool String(const char* str, rapidjson::SizeType length, bool copy) {
+    if (AtValue()) {
+      value_.type = PluckedValue::kString;
+      value_.str.assign(str, length);
+      done_ = true;
+      return false;
     }
-    if (!d.HasMember(key.data())) {
-      return "";
+    return Scalar(PluckedValue::kOther, [&] { writer_.String(str, length, copy); });
+  }
+
+  bool StartObject() {
+    return Start([this] { writer_.StartObject(); });
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+    if (capturing_) {
+      return writer_.Key(str, length, copy);
     }
-    const auto& plucked_value = d[key.data()];
-    if (plucked_value.IsNull()) {
-      return "";
+    if (depth_ == 1) {
+      key_matched_ = std::string_view(str, length) == key_;
     }
-    if (plucked_value.IsString()) {
-      return plucked_value.GetString();
+    return true;
+  }
+  bool EndObject(rapidjson::SizeType member_count) {
+    return End([this, member_count] { writer_.EndObject(member_count); });
+  }
+  bool StartArray() {
+    // The document must be an object.
+    if (depth_ == 0) {
+      return false;
     }
+    return Start([this] { writer_.StartArray(); });
+  }
+  bool EndArray(rapidjson::SizeType element_count) {
+    return End([this, element_count] { writer_.EndArray(element_count); });
+  }
 
-    // This is robust to nested JSON.
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    plucked_value.Accept(writer);
-    return sb.GetString();
+  PluckedValue& value() { return value_; }
+  bool done() const { return done_; }
+
+ private:
+  // Whether the next value is the value of the key.
+  bool AtValue() const { return depth_ == 1 && key_matched_ && !capturing_; }
+
+  template <typename TWrite>
+  bool Scalar(PluckedValue::Type type, TWrite write) {
+    if (depth_ == 0) {
+      return false;
+    }
+    if (capturing_) {
+      write();
+      return true;
+    }
+    if (AtValue()) {
+      value_.type = type;
+      if (type != PluckedValue::kNull) {
+        write();
+        value_.str = buffer_.GetString();
+      }
+      done_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  template <typename TWrite>
+  bool Start(TWrite write) {
+    if (depth_ == 0) {
+      depth_ = 1;
+      return true;
+    }
+    if (AtValue()) {
+      capturing_ = true;
+      value_.type = PluckedValue::kOther;
+    }
+    if (capturing_) {
+      write();
+    }
+    ++depth_;
+    return true;
+  }
+
+  template <typename TWrite>
+  bool End(TWrite write) {
+    --depth_;
+    if (!capturing_) {
+      return true;
+    }
+    write();
+    if (depth_ == 1) {
+      value_.str = buffer_.GetString();
+      done_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  std::string_view key_;
+  rapidjson::StringBuffer buffer_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_;
+  PluckedValue value_;
+  int depth_ = 0;
+  bool key_matched_ = false;
+  bool capturing_ = false;
+  bool done_ = false;
+};
+
+// Returns the value of the key if the JSON is an object, parsing only up to the end of the value.
+// Anything after the value isn't validated.
+inline PluckedValue PluckValue(const StringValue& in, std::string_view key) {
+  PluckHandler handler(key);
+  rapidjson::Reader reader;
+  rapidjson::StringStream stream(in.data());
+  reader.Parse(stream, handler);
+  if (!handler.done()) {
+    return {};
+  }
+  return std::move(handler.value());
+}
+
+}  // namespace internal
+
+class PluckUDF : public udf::ScalarUDF {
+ public:
+  StringValue Exec(FunctionContext*, StringValue in, StringValue key) {
+    // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
+    // Values that aren't strings, including nested JSON, are returned serialized.
+    return std::move(internal::PluckValue(in, key).str);
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -87,17 +237,8 @@ class PluckUDF : public udf::ScalarUDF {
 class PluckAsInt64UDF : public udf::ScalarUDF {
  public:
   Int64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return 0;
-    }
-    if (!d.IsObject()) {
-      return 0;
-    }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetInt64();
+    return internal::PluckValue(in, key).int64_value;
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -122,17 +263,8 @@ class PluckAsInt64UDF : public udf::ScalarUDF {
 class PluckAsFloat64UDF : public udf::ScalarUDF {
  public:
   Float64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return 0.0;
-    }
-    if (!d.IsObject()) {
-      return 0.0;
-    }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetDouble();
+    return internal::PluckValue(in, key).double_value;
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
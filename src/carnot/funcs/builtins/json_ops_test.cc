@@ -60,6 +60,25 @@ TEST(JSONOps, PluckUDF_non_object_input_return_empty) {
   udf_tester.ForInput("[\"asdad\"]", "str_key").Expect("");
 }
 
+TEST(JSONOps, PluckUDF_only_top_level_keys) {
+  auto udf_tester = udf::UDFTester<PluckUDF>();
+  udf_tester.ForInput(R"({"a": {"b": [1, {"b": 2}]}, "b": [3, 4.5, true, null]})", "b")
+      .Expect("[3,4.5,true,null]");
+  udf_tester.ForInput(R"({"a": {"b": 1}})", "b").Expect("");
+}
+
+TEST(JSONOps, PluckUDF_null_return_empty) {
+  auto udf_tester = udf::UDFTester<PluckUDF>();
+  udf_tester.ForInput(R"({"a": null})", "a").Expect("");
+}
+
+TEST(JSONOps, PluckUDF_stops_after_value) {
+  // Only the document up to the value is parsed.
+  auto udf_tester = udf::UDFTester<PluckUDF>();
+  udf_tester.ForInput(R"({"a": "x", "b": )", "a").Expect("x");
+  udf_tester.ForInput(R"({"a": "x", "b": )", "b").Expect("");
+}
+
 TEST(JSONOps, PluckAsInt64UDF) {
   auto udf_tester = udf::UDFTester<PluckAsInt64UDF>();
   udf_tester.ForInput(kTestJSONStr, "int64_key").Expect(34243242341);
@@ -75,6 +94,13 @@ TEST(JSONOps, PluckAsIntUDF_non_object_input_return_empty) {
   udf_tester.ForInput("[\"asdad\"]", "int64_key").Expect(0);
 }
 
+TEST(JSONOps, PluckAsInt64UDF_non_int_return_zero) {
+  auto udf_tester = udf::UDFTester<PluckAsInt64UDF>();
+  udf_tester.ForInput(kTestJSONStr, "str_plain").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "float64_key").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "blah").Expect(0);
+}
+
 TEST(JSONOps, PluckAsFloat64UDF) {
   auto udf_tester = udf::UDFTester<PluckAsFloat64UDF>();
   udf_tester.ForInput(kTestJSONStr, "float64_key").Expect(123423.5234);
@@ -90,6 +116,11 @@ TEST(JSONOps, PluckAsFloatUDF_non_object_input_return_empty) {
   udf_tester.ForInput("[\"asdad\"]", "float64_key").Expect(0.0);
 }
 
+TEST(JSONOps, PluckAsFloat64UDF_int_value) {
+  auto udf_tester = udf::UDFTester<PluckAsFloat64UDF>();
+  udf_tester.ForInput(kTestJSONStr, "int64_key").Expect(34243242341.0);
+}
+
 TEST(JSONOps, ScriptReferenceUDF_no_args) {
   auto udf_tester = udf::UDFTester<ScriptReferenceUDF<>>();
   auto res = udf_tester.ForInput("text", "px/script").Result();
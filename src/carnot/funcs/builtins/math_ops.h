@@ -33,6 +33,8 @@ udf::ScalarUDFDocBuilder AddDoc();
 template <typename TReturn, typename TArg1, typename TArg2>
 class AddUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val + b2.val; }
   static udf::InfRuleVec SemanticInferenceRules() {
     return {
@@ -58,6 +60,8 @@ class AddUDF<types::StringValue, types::StringValue, types::StringValue> : publi
 template <typename TReturn, typename TArg1, typename TArg2>
 class SubtractUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val - b2.val; }
   static udf::InfRuleVec SemanticInferenceRules() {
     return {
@@ -86,6 +90,8 @@ class DivideUDF : public udf::ScalarUDF {
   using ReturnValueType = typename types::ValueTypeTraits<TReturn>::native_type;
 
  public:
+  static constexpr bool kVectorized = true;
+
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) {
     return ReturnValueType(b1.val) / ReturnValueType(b2.val);
   }
@@ -113,6 +119,8 @@ class DivideUDF : public udf::ScalarUDF {
 template <typename TReturn, typename TArg1, typename TArg2>
 class MultiplyUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val * b2.val; }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Multiplies the arguments.")
@@ -368,6 +376,8 @@ class FloorUDF : public udf::ScalarUDF {
 template <typename TArg1, typename TArg2>
 class EqualUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 == b2; }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the values are equal.")
@@ -388,6 +398,8 @@ class EqualUDF : public udf::ScalarUDF {
 template <typename TArg1, typename TArg2>
 class NotEqualUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 != b2; }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the values are not equal.")
@@ -435,6 +447,8 @@ class ApproxNotEqualUDF : public udf::ScalarUDF {
 template <typename TArg1, typename TArg2>
 class GreaterThanUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 > b2; }
 
   static udf::ScalarUDFDocBuilder Doc() {
@@ -454,6 +468,8 @@ class GreaterThanUDF : public udf::ScalarUDF {
 template <typename TArg1, typename TArg2>
 class GreaterThanEqualUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 >= b2; }
 
   static udf::ScalarUDFDocBuilder Doc() {
@@ -474,6 +490,8 @@ class GreaterThanEqualUDF : public udf::ScalarUDF {
 template <typename TArg1, typename TArg2>
 class LessThanUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 < b2; }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns which value is less than the other.")
@@ -490,6 +508,8 @@ class LessThanUDF : public udf::ScalarUDF {
 template <typename TArg1, typename TArg2>
 class LessThanEqualUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kVectorized = true;
+
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 <= b2; }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns which value is less than or equal to the the other.")
@@ -553,6 +573,25 @@ class MeanUDA : public udf::UDA {
     info_.size++;
     info_.count += arg.val;
   }
+  void UpdateBatch(FunctionContext*, const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    double count = info_.count;
+    for (size_t i = 0; i < args.Size(); ++i) {
+      count += data[i].val;
+    }
+    info_.size += args.Size();
+    info_.count = count;
+  }
+  void UpdateBatch(FunctionContext*, const udf::SelectionVector& rows,
+                   const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    double count = info_.count;
+    for (int64_t idx : rows) {
+      count += data[idx].val;
+    }
+    info_.size += rows.size();
+    info_.count = count;
+  }
   void Merge(FunctionContext*, const MeanUDA& other) {
     info_.size += other.info_.size;
     info_.count += other.info_.count;
@@ -596,6 +635,23 @@ template <typename TArg, typename TAggType = TArg>
 class SumUDA : public udf::UDA {
  public:
   void Update(FunctionContext*, TArg arg) { sum_ = sum_.val + arg.val; }
+  void UpdateBatch(FunctionContext*, const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    auto sum = sum_.val;
+    for (size_t i = 0; i < args.Size(); ++i) {
+      sum += data[i].val;
+    }
+    sum_ = sum;
+  }
+  void UpdateBatch(FunctionContext*, const udf::SelectionVector& rows,
+                   const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    auto sum = sum_.val;
+    for (int64_t idx : rows) {
+      sum += data[idx].val;
+    }
+    sum_ = sum;
+  }
   void Merge(FunctionContext*, const SumUDA& other) { sum_ = sum_.val + other.sum_.val; }
   TAggType Finalize(FunctionContext*) { return sum_; }
   static udf::InfRuleVec SemanticInferenceRules() {
@@ -710,6 +766,13 @@ template <typename TArg>
 class CountUDA : public udf::UDA {
  public:
   void Update(FunctionContext*, TArg) { count_++; }
+  void UpdateBatch(FunctionContext*, const types::ColumnWrapperTmpl<TArg>& args) {
+    count_ += args.Size();
+  }
+  void UpdateBatch(FunctionContext*, const udf::SelectionVector& rows,
+                   const types::ColumnWrapperTmpl<TArg>&) {
+    count_ += rows.size();
+  }
   void Merge(FunctionContext*, const CountUDA& other) { count_ += other.count_; }
   Int64Value Finalize(FunctionContext*) { return count_; }
 
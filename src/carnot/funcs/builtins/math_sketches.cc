@@ -18,6 +18,15 @@
 
 #include "src/carnot/funcs/builtins/math_sketches.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+// NOLINTNEXTLINE: build/include_subdir
+#include "xxhash.h"
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -25,6 +34,461 @@ namespace builtins {
 void RegisterMathSketchesOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<QuantilesUDA<types::Int64Value>>("quantiles");
   registry->RegisterOrDie<QuantilesUDA<types::Float64Value>>("quantiles");
+  registry->RegisterOrDie<TDigestQuantilesUDA<types::Int64Value>>("tdigest_quantiles");
+  registry->RegisterOrDie<TDigestQuantilesUDA<types::Float64Value>>("tdigest_quantiles");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Int64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Float64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Time64NSValue>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::UInt128Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::StringValue>>("approx_count_distinct");
+}
+
+namespace {
+
+const double kGamma = (1 + DDSketch::kRelativeAccuracy) / (1 - DDSketch::kRelativeAccuracy);
+const double kLogGamma = std::log(kGamma);
+// Smaller magnitudes are counted as zero, which keeps the keys well within int64_t.
+constexpr double kMinIndexableValue = 1e-300;
+constexpr uint8_t kSerializationVersion = 1;
+
+constexpr uint64_t kHLLSeed = 3091990;
+constexpr uint8_t kHLLSparse = 0;
+constexpr uint8_t kHLLDense = 1;
+constexpr int kHLLRegisterBits = 6;
+// The largest register value (all the bits after the index are zero).
+constexpr int kHLLMaxRegister = 64 - HyperLogLog::kPrecision + 1;
+constexpr int kHLLExtraSparseBits = HyperLogLog::kSparsePrecision - HyperLogLog::kPrecision;
+// The sparse entries are 4 bytes each, so past this many the dense registers are smaller.
+constexpr size_t kHLLMaxSparseEntries =
+    HyperLogLog::kNumRegisters * kHLLRegisterBits / 8 / sizeof(uint32_t);
+
+// The number of leading zeros plus one of the (64 - precision) bits after the register index.
+uint8_t HLLRegisterValue(uint64_t hash, int precision) {
+  uint64_t rest = hash << precision;
+  int max_value = 64 - precision + 1;
+  return rest == 0 ? max_value : std::min(__builtin_clzll(rest) + 1, max_value);
+}
+
+// The bucket with key k holds the values in (gamma^(k-1), gamma^k].
+int64_t BucketKey(double abs_val) {
+  return static_cast<int64_t>(std::ceil(std::log(abs_val) / kLogGamma));
+}
+
+// The point in the bucket that is within kRelativeAccuracy of every value in it.
+double BucketValue(int64_t key) { return 2 * std::pow(kGamma, key) / (kGamma + 1); }
+
+void PutVarint(uint64_t v, std::string* out) {
+  while (v >= 0x80) {
+    out->push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  out->push_back(static_cast<char>(v));
+}
+
+void PutVarintSigned(int64_t v, std::string* out) {
+  PutVarint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63), out);
+}
+
+void PutDouble(double v, std::string* out) {
+  char buf[sizeof(v)];
+  std::memcpy(buf, &v, sizeof(v));
+  out->append(buf, sizeof(v));
+}
+
+StatusOr<uint64_t> GetVarint(std::string_view* data) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (data->empty()) {
+      break;
+    }
+    auto byte = static_cast<uint8_t>(data->front());
+    data->remove_prefix(1);
+    v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return v;
+    }
+  }
+  return error::InvalidArgument("Invalid varint in serialized sketch");
+}
+
+StatusOr<int64_t> GetVarintSigned(std::string_view* data) {
+  PL_ASSIGN_OR_RETURN(uint64_t v, GetVarint(data));
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+StatusOr<double> GetDouble(std::string_view* data) {
+  double v;
+  if (data->size() < sizeof(v)) {
+    return error::InvalidArgument("Truncated serialized sketch");
+  }
+  std::memcpy(&v, data->data(), sizeof(v));
+  data->remove_prefix(sizeof(v));
+  return v;
+}
+
+// sigma and tau from Ertl's improved HyperLogLog estimator.
+double HLLSigma(double x) {
+  if (x == 1) {
+    return std::numeric_limits<double>::infinity();
+  }
+  double y = 1;
+  double z = x;
+  double prev_z;
+  do {
+    x *= x;
+    prev_z = z;
+    z += x * y;
+    y += y;
+  } while (z != prev_z);
+  return z;
+}
+
+double HLLTau(double x) {
+  if (x == 0 || x == 1) {
+    return 0;
+  }
+  double y = 1;
+  double z = 1 - x;
+  double prev_z;
+  do {
+    x = std::sqrt(x);
+    prev_z = z;
+    y *= 0.5;
+    z -= (1 - x) * (1 - x) * y;
+  } while (z != prev_z);
+  return z / 3;
+}
+
+}  // namespace
+
+void DDSketch::Store::Add(int64_t key, uint64_t n) {
+  if (counts.empty()) {
+    offset = key;
+    counts.push_back(n);
+    return;
+  }
+  if (key > MaxKey()) {
+    // Fold the buckets that no longer fit into the lowest one that does.
+    int64_t new_offset = std::max(offset, key - kMaxBuckets + 1);
+    if (new_offset > MaxKey()) {
+      counts = {Count()};
+    } else if (new_offset > offset) {
+      auto folded_end = counts.begin() + (new_offset - offset);
+      uint64_t folded = std::accumulate(counts.begin(), folded_end, uint64_t{0});
+      counts.erase(counts.begin(), folded_end);
+      counts[0] += folded;
+    }
+    offset = new_offset;
+    counts.resize(key - offset + 1, 0);
+  } else if (key < offset) {
+    int64_t new_offset = std::max(key, MaxKey() - kMaxBuckets + 1);
+    counts.insert(counts.begin(), offset - new_offset, 0);
+    offset = new_offset;
+    key = std::max(key, offset);
+  }
+  counts[key - offset] += n;
+}
+
+void DDSketch::Store::Merge(const Store& other) {
+  if (other.counts.empty()) {
+    return;
+  }
+  if (counts.empty()) {
+    *this = other;
+    return;
+  }
+  int64_t max_key = std::max(MaxKey(), other.MaxKey());
+  int64_t min_key = std::max(std::min(offset, other.offset), max_key - kMaxBuckets + 1);
+  std::vector<uint64_t> merged(max_key - min_key + 1, 0);
+  for (const Store* store : {static_cast<const Store*>(this), &other}) {
+    for (size_t i = 0; i < store->counts.size(); ++i) {
+      merged[std::max(store->offset + static_cast<int64_t>(i), min_key) - min_key] +=
+          store->counts[i];
+    }
+  }
+  counts = std::move(merged);
+  offset = min_key;
+}
+
+uint64_t DDSketch::Store::Count() const {
+  return std::accumulate(counts.begin(), counts.end(), uint64_t{0});
+}
+
+void DDSketch::Add(double val) {
+  if (!std::isfinite(val)) {
+    return;
+  }
+  min_ = std::min(min_, val);
+  max_ = std::max(max_, val);
+  if (val > kMinIndexableValue) {
+    positive_.Add(BucketKey(val), 1);
+  } else if (val < -kMinIndexableValue) {
+    negative_.Add(BucketKey(-val), 1);
+  } else {
+    ++zero_count_;
+  }
+}
+
+void DDSketch::Merge(const DDSketch& other) {
+  negative_.Merge(other.negative_);
+  positive_.Merge(other.positive_);
+  zero_count_ += other.zero_count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+double DDSketch::Quantile(double q) const {
+  uint64_t total = count();
+  if (total == 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  double rank = std::clamp(q, 0.0, 1.0) * (total - 1);
+  auto clamp = [this](double val) { return std::clamp(val, min_, max_); };
+
+  // Walk the buckets in increasing order of value until the rank is reached.
+  uint64_t seen = 0;
+  for (size_t i = negative_.counts.size(); i > 0; --i) {
+    seen += negative_.counts[i - 1];
+    if (seen > rank) {
+      return clamp(-BucketValue(negative_.offset + static_cast<int64_t>(i) - 1));
+    }
+  }
+  seen += zero_count_;
+  if (seen > rank) {
+    return clamp(0);
+  }
+  for (size_t i = 0; i < positive_.counts.size(); ++i) {
+    seen += positive_.counts[i];
+    if (seen > rank) {
+      return clamp(BucketValue(positive_.offset + static_cast<int64_t>(i)));
+    }
+  }
+  return max_;
+}
+
+// Format: version, zero count, min, max and then the negative and positive stores, each as its
+// offset, its number of buckets and the bucket counts. Integers are varints, so the bucket counts
+// mostly take a byte or two each.
+std::string DDSketch::Serialize() const {
+  std::string out;
+  out.push_back(static_cast<char>(kSerializationVersion));
+  PutVarint(zero_count_, &out);
+  PutDouble(min_, &out);
+  PutDouble(max_, &out);
+  for (const Store* store : {&negative_, &positive_}) {
+    PutVarintSigned(store->offset, &out);
+    PutVarint(store->counts.size(), &out);
+    for (uint64_t count : store->counts) {
+      PutVarint(count, &out);
+    }
+  }
+  return out;
+}
+
+Status DDSketch::Deserialize(std::string_view data) {
+  if (data.empty() || static_cast<uint8_t>(data.front()) != kSerializationVersion) {
+    return error::InvalidArgument("DDSketch::Deserialize: unknown serialization version");
+  }
+  data.remove_prefix(1);
+  DDSketch sketch;
+  PL_ASSIGN_OR_RETURN(sketch.zero_count_, GetVarint(&data));
+  PL_ASSIGN_OR_RETURN(sketch.min_, GetDouble(&data));
+  PL_ASSIGN_OR_RETURN(sketch.max_, GetDouble(&data));
+  for (Store* store : {&sketch.negative_, &sketch.positive_}) {
+    PL_ASSIGN_OR_RETURN(store->offset, GetVarintSigned(&data));
+    PL_ASSIGN_OR_RETURN(uint64_t num_buckets, GetVarint(&data));
+    if (num_buckets > static_cast<uint64_t>(kMaxBuckets)) {
+      return error::InvalidArgument("DDSketch::Deserialize: too many buckets");
+    }
+    store->counts.resize(num_buckets);
+    for (auto& count : store->counts) {
+      PL_ASSIGN_OR_RETURN(count, GetVarint(&data));
+    }
+  }
+  if (!data.empty()) {
+    return error::InvalidArgument("DDSketch::Deserialize: unexpected trailing data");
+  }
+  *this = std::move(sketch);
+  return Status::OK();
+}
+
+uint64_t HyperLogLog::Hash(std::string_view data) {
+  return XXH64(data.data(), data.size(), kHLLSeed);
+}
+
+void HyperLogLog::Add(uint64_t hash) {
+  if (!is_sparse()) {
+    AddDenseHash(hash);
+    return;
+  }
+  auto index = static_cast<uint32_t>(hash >> (64 - kSparsePrecision));
+  AddSparseEntry(index << kHLLRegisterBits | HLLRegisterValue(hash, kSparsePrecision));
+  if (sparse_entries_.size() > kHLLMaxSparseEntries) {
+    ToDense();
+  }
+}
+
+void HyperLogLog::AddSparseEntry(uint32_t entry) {
+  // Entries with the same index are adjacent, so only the largest value for each index is kept.
+  uint32_t index = entry >> kHLLRegisterBits;
+  auto it = std::lower_bound(sparse_entries_.begin(), sparse_entries_.end(),
+                             index << kHLLRegisterBits);
+  if (it != sparse_entries_.end() && (*it >> kHLLRegisterBits) == index) {
+    *it = std::max(*it, entry);
+    return;
+  }
+  sparse_entries_.insert(it, entry);
+}
+
+void HyperLogLog::AddDenseHash(uint64_t hash) {
+  auto& reg = registers_[hash >> (64 - kPrecision)];
+  reg = std::max(reg, HLLRegisterValue(hash, kPrecision));
+}
+
+void HyperLogLog::ToDense() {
+  registers_.assign(kNumRegisters, 0);
+  for (uint32_t entry : sparse_entries_) {
+    uint32_t sparse_index = entry >> kHLLRegisterBits;
+    uint8_t value = entry & ((1 << kHLLRegisterBits) - 1);
+    // The dense value counts the zeros in the sparse index bits past the dense index too.
+    uint32_t extra_bits = sparse_index & ((1 << kHLLExtraSparseBits) - 1);
+    if (extra_bits != 0) {
+      value = __builtin_clz(extra_bits) - (32 - kHLLExtraSparseBits) + 1;
+    } else {
+      value += kHLLExtraSparseBits;
+    }
+    auto& reg = registers_[sparse_index >> kHLLExtraSparseBits];
+    reg = std::max(reg, value);
+  }
+  sparse_entries_.clear();
+  sparse_entries_.shrink_to_fit();
+}
+
+void HyperLogLog::Merge(const HyperLogLog& other) {
+  if (is_sparse() && other.is_sparse()) {
+    for (uint32_t entry : other.sparse_entries_) {
+      AddSparseEntry(entry);
+    }
+    if (sparse_entries_.size() > kHLLMaxSparseEntries) {
+      ToDense();
+    }
+    return;
+  }
+  if (is_sparse()) {
+    ToDense();
+  }
+  if (other.is_sparse()) {
+    HyperLogLog dense_other = other;
+    dense_other.ToDense();
+    Merge(dense_other);
+    return;
+  }
+  for (int i = 0; i < kNumRegisters; ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+}
+
+int64_t HyperLogLog::Estimate() const {
+  if (is_sparse()) {
+    // Linear counting over the sparse registers, which is close to exact at these counts.
+    double m = 1 << kSparsePrecision;
+    return std::llround(m * std::log(m / (m - sparse_entries_.size())));
+  }
+  std::array<int, kHLLMaxRegister + 1> histogram = {};
+  for (uint8_t reg : registers_) {
+    ++histogram[reg];
+  }
+  constexpr int q = 64 - kPrecision;
+  double m = kNumRegisters;
+  double z = m * HLLTau(1 - histogram[q + 1] / m);
+  for (int k = q; k >= 1; --k) {
+    z = 0.5 * (z + histogram[k]);
+  }
+  z += m * HLLSigma(histogram[0] / m);
+  return std::llround(m * m / (2 * std::log(2)) / z);
+}
+
+// Format: version, representation and then either the varint encoded deltas between the sorted
+// sparse entries, or the dense registers packed into 6 bits each.
+std::string HyperLogLog::Serialize() const {
+  std::string out;
+  out.push_back(static_cast<char>(kSerializationVersion));
+  if (is_sparse()) {
+    out.push_back(static_cast<char>(kHLLSparse));
+    PutVarint(sparse_entries_.size(), &out);
+    uint32_t prev = 0;
+    for (uint32_t entry : sparse_entries_) {
+      PutVarint(entry - prev, &out);
+      prev = entry;
+    }
+    return out;
+  }
+  out.push_back(static_cast<char>(kHLLDense));
+  uint32_t bits = 0;
+  int num_bits = 0;
+  for (uint8_t reg : registers_) {
+    bits |= static_cast<uint32_t>(reg) << num_bits;
+    num_bits += kHLLRegisterBits;
+    while (num_bits >= 8) {
+      out.push_back(static_cast<char>(bits & 0xff));
+      bits >>= 8;
+      num_bits -= 8;
+    }
+  }
+  return out;
+}
+
+Status HyperLogLog::Deserialize(std::string_view data) {
+  if (data.size() < 2 || static_cast<uint8_t>(data[0]) != kSerializationVersion) {
+    return error::InvalidArgument("HyperLogLog::Deserialize: unknown serialization version");
+  }
+  auto representation = static_cast<uint8_t>(data[1]);
+  data.remove_prefix(2);
+
+  HyperLogLog sketch;
+  if (representation == kHLLSparse) {
+    PL_ASSIGN_OR_RETURN(uint64_t num_entries, GetVarint(&data));
+    if (num_entries > kHLLMaxSparseEntries) {
+      return error::InvalidArgument("HyperLogLog::Deserialize: too many sparse entries");
+    }
+    uint64_t entry = 0;
+    for (uint64_t i = 0; i < num_entries; ++i) {
+      PL_ASSIGN_OR_RETURN(uint64_t delta, GetVarint(&data));
+      entry += delta;
+      if ((i > 0 && delta == 0) || entry >> (kSparsePrecision + kHLLRegisterBits) != 0) {
+        return error::InvalidArgument("HyperLogLog::Deserialize: invalid sparse entry");
+      }
+      sketch.sparse_entries_.push_back(entry);
+    }
+  } else if (representation == kHLLDense) {
+    if (data.size() != kNumRegisters * kHLLRegisterBits / 8) {
+      return error::InvalidArgument("HyperLogLog::Deserialize: invalid dense registers");
+    }
+    sketch.registers_.reserve(kNumRegisters);
+    uint32_t bits = 0;
+    int num_bits = 0;
+    for (char byte : data) {
+      bits |= static_cast<uint32_t>(static_cast<uint8_t>(byte)) << num_bits;
+      num_bits += 8;
+      while (num_bits >= kHLLRegisterBits) {
+        uint8_t reg = bits & ((1 << kHLLRegisterBits) - 1);
+        if (reg > kHLLMaxRegister) {
+          return error::InvalidArgument("HyperLogLog::Deserialize: invalid dense registers");
+        }
+        sketch.registers_.push_back(reg);
+        bits >>= kHLLRegisterBits;
+        num_bits -= kHLLRegisterBits;
+      }
+    }
+    data = {};
+  } else {
+    return error::InvalidArgument("HyperLogLog::Deserialize: unknown representation");
+  }
+  if (!data.empty()) {
+    return error::InvalidArgument("HyperLogLog::Deserialize: unexpected trailing data");
+  }
+  *this = std::move(sketch);
+  return Status::OK();
 }
 
 }  // namespace builtins
@@ -21,6 +21,11 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "src/carnot/udf/registry.h"
 #include "src/shared/types/types.h"
 #include "tdigest/tdigest.h"
@@ -29,28 +34,170 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+/**
+ * DDSketch (https://arxiv.org/abs/1908.10693) is a quantile sketch whose estimates are within
+ * kRelativeAccuracy of the true quantile value. Values are counted in buckets whose bounds grow
+ * geometrically, so adding a value is a log and an increment, merging two sketches is a sum of
+ * their bucket counts, and the whole state is a flat array of counts per sign.
+ *
+ * The number of buckets per sign is capped at kMaxBuckets by folding the buckets closest to zero
+ * together. That only loses accuracy when the data spans more than ~17 orders of magnitude, and
+ * then only for the quantiles closest to zero.
+ */
+class DDSketch {
+ public:
+  static constexpr double kRelativeAccuracy = 0.01;
+  static constexpr int64_t kMaxBuckets = 2048;
+
+  /**
+   * Adds a value to the sketch. Non finite values are ignored.
+   */
+  void Add(double val);
+  void Merge(const DDSketch& other);
+
+  /**
+   * @return the estimated value at quantile q (between 0 and 1), or NaN if the sketch is empty.
+   */
+  double Quantile(double q) const;
+
+  uint64_t count() const { return negative_.Count() + zero_count_ + positive_.Count(); }
+
+  /**
+   * Serializes the sketch into a compact binary form, with the bucket counts varint encoded.
+   */
+  std::string Serialize() const;
+  Status Deserialize(std::string_view data);
+
+ private:
+  // Counts for a contiguous range of bucket keys, starting at offset.
+  struct Store {
+    void Add(int64_t key, uint64_t n);
+    void Merge(const Store& other);
+    uint64_t Count() const;
+    int64_t MaxKey() const { return offset + static_cast<int64_t>(counts.size()) - 1; }
+
+    int64_t offset = 0;
+    std::vector<uint64_t> counts;
+  };
+
+  Store negative_;
+  Store positive_;
+  uint64_t zero_count_ = 0;
+  double min_ = std::numeric_limits<double>::infinity();
+  double max_ = -std::numeric_limits<double>::infinity();
+};
+
+/**
+ * HyperLogLog sketch for approximate distinct counts, with the HyperLogLog++ sparse
+ * representation (https://research.google/pubs/pub40671/) for low cardinalities and Ertl's
+ * improved estimator (https://arxiv.org/abs/1702.01284), which needs no empirical bias
+ * correction.
+ *
+ * Values are added as 64 bit hashes. The sketch starts out as a sorted list of
+ * (index, leading zeros) entries at a precision of kSparsePrecision, which is nearly exact for
+ * small counts, and switches to kNumRegisters dense registers once that list would be larger
+ * than the registers. The dense registers serialize into 6 bits each (1.5KB), with a standard
+ * error of about 2.3%.
+ */
+class HyperLogLog {
+ public:
+  static constexpr int kPrecision = 11;
+  static constexpr int kNumRegisters = 1 << kPrecision;
+  static constexpr int kSparsePrecision = 25;
+
+  static uint64_t Hash(std::string_view data);
+  static uint64_t Hash(const void* data, size_t size) {
+    return Hash(std::string_view(static_cast<const char*>(data), size));
+  }
+
+  void Add(uint64_t hash);
+  void Merge(const HyperLogLog& other);
+
+  /**
+   * @return the estimated number of distinct hashes added to the sketch.
+   */
+  int64_t Estimate() const;
+
+  bool is_sparse() const { return registers_.empty(); }
+
+  std::string Serialize() const;
+  Status Deserialize(std::string_view data);
+
+ private:
+  void AddSparseEntry(uint32_t entry);
+  void AddDenseHash(uint64_t hash);
+  void ToDense();
+
+  // Sorted entries of the sparse representation, each the kSparsePrecision bit register index
+  // followed by the 6 bit register value. Empty once the sketch is dense.
+  std::vector<uint32_t> sparse_entries_;
+  // One unpacked register per byte, empty while the sketch is sparse.
+  std::vector<uint8_t> registers_;
+};
+
+namespace internal {
+
+template <typename TArg>
+uint64_t DistinctHash(const TArg& arg) {
+  return HyperLogLog::Hash(&arg.val, sizeof(arg.val));
+}
+
+inline uint64_t DistinctHash(const types::StringValue& arg) { return HyperLogLog::Hash(arg); }
+
+inline uint64_t DistinctHash(const types::UInt128Value& arg) {
+  uint64_t words[] = {arg.High64(), arg.Low64()};
+  return HyperLogLog::Hash(words, sizeof(words));
+}
+
+// Writes the percentiles returned by the UDAs below as a JSON object, given a function that
+// returns the value at a quantile.
+template <typename TQuantileFn>
+std::string QuantilesToJSON(TQuantileFn quantile) {
+  rapidjson::Document d;
+  d.SetObject();
+  d.AddMember("p01", quantile(0.01), d.GetAllocator());
+  d.AddMember("p10", quantile(0.10), d.GetAllocator());
+  d.AddMember("p25", quantile(0.25), d.GetAllocator());
+  d.AddMember("p50", quantile(0.50), d.GetAllocator());
+  d.AddMember("p75", quantile(0.75), d.GetAllocator());
+  d.AddMember("p90", quantile(0.90), d.GetAllocator());
+  d.AddMember("p99", quantile(0.99), d.GetAllocator());
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  d.Accept(writer);
+  return sb.GetString();
+}
+
+}  // namespace internal
+
 // TODO(zasgar): PL-419 Replace this when we add support for structs.
 template <typename TArg>
 class QuantilesUDA : public udf::UDA {
  public:
-  QuantilesUDA() : digest_(1000) {}
-  void Update(FunctionContext*, TArg val) { digest_.add(val.val); }
-  void Merge(FunctionContext*, const QuantilesUDA& other) { digest_.merge(&other.digest_); }
+  void Update(FunctionContext*, TArg val) { sketch_.Add(val.val); }
+  void UpdateBatch(FunctionContext*, const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    for (size_t i = 0; i < args.Size(); ++i) {
+      sketch_.Add(data[i].val);
+    }
+  }
+  void UpdateBatch(FunctionContext*, const udf::SelectionVector& rows,
+                   const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    for (int64_t idx : rows) {
+      sketch_.Add(data[idx].val);
+    }
+  }
+  void Merge(FunctionContext*, const QuantilesUDA& other) { sketch_.Merge(other.sketch_); }
 
   StringValue Finalize(FunctionContext*) {
-    rapidjson::Document d;
-    d.SetObject();
-    d.AddMember("p01", digest_.quantile(0.01), d.GetAllocator());
-    d.AddMember("p10", digest_.quantile(0.10), d.GetAllocator());
-    d.AddMember("p25", digest_.quantile(0.25), d.GetAllocator());
-    d.AddMember("p50", digest_.quantile(0.50), d.GetAllocator());
-    d.AddMember("p75", digest_.quantile(0.75), d.GetAllocator());
-    d.AddMember("p90", digest_.quantile(0.90), d.GetAllocator());
-    d.AddMember("p99", digest_.quantile(0.99), d.GetAllocator());
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    d.Accept(writer);
-    return sb.GetString();
+    return internal::QuantilesToJSON([this](double q) { return sketch_.Quantile(q); });
+  }
+
+  StringValue Serialize(FunctionContext*) { return sketch_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return sketch_.Deserialize(data);
   }
 
   static udf::InfRuleVec SemanticInferenceRules() {
@@ -59,6 +206,51 @@ class QuantilesUDA : public udf::UDA {
                                                     {types::ST_DURATION_NS})};
   }
 
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Approximates the distribution of the aggregated data.")
+        .Details(
+            "Calculates several useful percentiles of the aggregated data using "
+            "[DDSketch](https://arxiv.org/abs/1908.10693), so each percentile is within 1% of "
+            "its true value. Returns a serialized JSON object with the keys for 1%, 10%, 25%, "
+            "50%, 75%, 90%, and 99%. You can use `px.pluck_float64` to grab the specific values "
+            "from the result.")
+        .Example(R"doc(
+        | # Calculate the quantiles.
+        | df = df.agg(latency_dist=('latency_ms', px.quantiles))
+        | # Pluck p99 from the quantiles.
+        | df.p99 = px.pluck_float64(df.latency_dist, 'p99')
+        )doc")
+        .Arg("val", "The data to calculate the quantiles distribution.")
+        .Returns("The quantiles data, serialized as a JSON dictionary.");
+  }
+
+ protected:
+  DDSketch sketch_;
+};
+
+/**
+ * The t-digest based version of QuantilesUDA. The t-digest can't be merged across PEMs, so the
+ * whole aggregate runs on Kelvin.
+ */
+template <typename TArg>
+class TDigestQuantilesUDA : public udf::UDA {
+ public:
+  TDigestQuantilesUDA() : digest_(1000) {}
+  void Update(FunctionContext*, TArg val) { digest_.add(val.val); }
+  void Merge(FunctionContext*, const TDigestQuantilesUDA& other) {
+    digest_.merge(&other.digest_);
+  }
+
+  StringValue Finalize(FunctionContext*) {
+    return internal::QuantilesToJSON([this](double q) { return digest_.quantile(q); });
+  }
+
+  static udf::InfRuleVec SemanticInferenceRules() {
+    return {udf::ExplicitRule::Create<TDigestQuantilesUDA>(types::ST_QUANTILES, {types::ST_NONE}),
+            udf::ExplicitRule::Create<TDigestQuantilesUDA>(types::ST_DURATION_NS_QUANTILES,
+                                                           {types::ST_DURATION_NS})};
+  }
+
   static udf::UDADocBuilder Doc() {
     return udf::UDADocBuilder("Approximates the distribution of the aggregated data.")
         .Details(
@@ -66,10 +258,11 @@ class QuantilesUDA : public udf::UDA {
             "[tdigest](https://github.com/tdunning/t-digest). Returns a serialized JSON object "
             "with the "
             "keys for 1%, 10%, 50%, 90%, and 99%. You can use `px.pluck_float64` to grab the "
-            "specific values from the result.")
+            "specific values from the result. Prefer `px.quantiles`, which can be computed "
+            "in parts across the PEMs.")
         .Example(R"doc(
         | # Calculate the quantiles.
-        | df = df.agg(latency_dist=('latency_ms', px.quantiles))
+        | df = df.agg(latency_dist=('latency_ms', px.tdigest_quantiles))
         | # Pluck p99 from the quantiles.
         | df.p99 = px.pluck_float64(df.latency_dist, 'p99')
         )doc")
@@ -81,6 +274,54 @@ class QuantilesUDA : public udf::UDA {
   tdigest::TDigest digest_;
 };
 
+template <typename TArg>
+class ApproxCountDistinctUDA : public udf::UDA {
+ public:
+  void Update(FunctionContext*, TArg val) { sketch_.Add(internal::DistinctHash(val)); }
+  void UpdateBatch(FunctionContext*, const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    for (size_t i = 0; i < args.Size(); ++i) {
+      sketch_.Add(internal::DistinctHash(data[i]));
+    }
+  }
+  void UpdateBatch(FunctionContext*, const udf::SelectionVector& rows,
+                   const types::ColumnWrapperTmpl<TArg>& args) {
+    const TArg* data = args.UnsafeRawData();
+    for (int64_t idx : rows) {
+      sketch_.Add(internal::DistinctHash(data[idx]));
+    }
+  }
+  void Merge(FunctionContext*, const ApproxCountDistinctUDA& other) {
+    sketch_.Merge(other.sketch_);
+  }
+  Int64Value Finalize(FunctionContext*) { return sketch_.Estimate(); }
+
+  StringValue Serialize(FunctionContext*) { return sketch_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return sketch_.Deserialize(data);
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Approximates the number of distinct values.")
+        .Details(
+            "Estimates the number of distinct values in the aggregated data with a "
+            "[HyperLogLog](https://en.wikipedia.org/wiki/HyperLogLog) sketch. Small counts are "
+            "nearly exact, and larger ones have a standard error of about 2.3%. Unlike grouping "
+            "by the value and counting the groups, only a sketch of at most 1.5KB per group is "
+            "sent from each PEM.")
+        .Example(R"doc(
+        | # Count the unique clients of each service.
+        | df = df.groupby('service').agg(num_clients=('remote_addr', px.approx_count_distinct))
+        )doc")
+        .Arg("val", "The values to count.")
+        .Returns("The estimated number of distinct values.");
+  }
+
+ protected:
+  HyperLogLog sketch_;
+};
+
 void RegisterMathSketchesOrDie(udf::Registry* registry);
 
 }  // namespace builtins
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/math_sketches.h"
+#include "src/common/benchmark/benchmark.h"
+
+using px::carnot::builtins::QuantilesUDA;
+using px::carnot::builtins::TDigestQuantilesUDA;
+using px::types::Float64Value;
+
+constexpr int kValuesPerGroup = 1000 * 1000;
+
+// Latency-like values, in ns.
+std::vector<Float64Value> LatencyValues(int size) {
+  std::mt19937 gen(37);
+  std::lognormal_distribution<double> dist(14, 1.5);
+  std::vector<Float64Value> values(size);
+  for (auto& v : values) {
+    v = dist(gen);
+  }
+  return values;
+}
+
+template <typename TUDA>
+TUDA BuildUDA(const std::vector<Float64Value>& values) {
+  TUDA uda;
+  for (const auto& v : values) {
+    uda.Update(nullptr, v);
+  }
+  return uda;
+}
+
+template <typename TUDA>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_QuantilesUpdate(benchmark::State& state) {
+  auto values = LatencyValues(kValuesPerGroup);
+  for (auto _ : state) {
+    auto uda = BuildUDA<TUDA>(values);
+    benchmark::DoNotOptimize(uda.Finalize(nullptr));
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// Merges the partial aggregates of state.range(0) PEMs and computes the percentiles.
+template <typename TUDA>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_QuantilesMerge(benchmark::State& state) {
+  std::vector<TUDA> partials;
+  for (int i = 0; i < state.range(0); ++i) {
+    partials.push_back(BuildUDA<TUDA>(LatencyValues(kValuesPerGroup / state.range(0))));
+  }
+  for (auto _ : state) {
+    TUDA merged;
+    for (const auto& partial : partials) {
+      merged.Merge(nullptr, partial);
+    }
+    benchmark::DoNotOptimize(merged.Finalize(nullptr));
+  }
+}
+
+// The t-digest can't be serialized, so this one is only for the DDSketch.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_QuantilesSerialize(benchmark::State& state) {
+  auto uda = BuildUDA<QuantilesUDA<Float64Value>>(LatencyValues(kValuesPerGroup));
+  for (auto _ : state) {
+    QuantilesUDA<Float64Value> other;
+    benchmark::DoNotOptimize(other.Deserialize(nullptr, uda.Serialize(nullptr)));
+  }
+  state.counters["bytes"] = uda.Serialize(nullptr).size();
+}
+
+BENCHMARK_TEMPLATE(BM_QuantilesUpdate, QuantilesUDA<Float64Value>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_QuantilesUpdate, TDigestQuantilesUDA<Float64Value>)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_QuantilesMerge, QuantilesUDA<Float64Value>)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(BM_QuantilesMerge, TDigestQuantilesUDA<Float64Value>)->Arg(10)->Arg(100);
+BENCHMARK(BM_QuantilesSerialize);
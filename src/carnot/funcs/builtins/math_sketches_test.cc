@@ -19,16 +19,22 @@
 #include <gtest/gtest.h>
 #include <rapidjson/document.h>
 
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
 #include "src/carnot/funcs/builtins/math_sketches.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
+#include "src/common/base/test_utils.h"
 
 namespace px {
 namespace carnot {
 namespace builtins {
 
-TEST(MathSketches, quantiles_float64) {
-  auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+TEST(MathSketches, tdigest_quantiles_float64) {
+  auto uda_tester = udf::UDATester<TDigestQuantilesUDA<types::Float64Value>>();
   // This test mostly makes sure that the UDA code runs and produces results.
   // Tdigest is heavily unit tested to be statistically correct.
   auto res = uda_tester.ForInput(1.234)
@@ -47,8 +53,8 @@ TEST(MathSketches, quantiles_float64) {
   EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6.333);
 }
 
-TEST(MathSketches, quantiles_int64) {
-  auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+TEST(MathSketches, tdigest_quantiles_int64) {
+  auto uda_tester = udf::UDATester<TDigestQuantilesUDA<types::Float64Value>>();
   // This test mostly makes sure that the UDA code runs and produces results.
   // Tdigest is heavily unit tested to be statistically correct.
   auto res = uda_tester.ForInput(1)
@@ -69,6 +75,194 @@ TEST(MathSketches, quantiles_int64) {
   EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6);
 }
 
+// Checks that every quantile estimate is within the sketch's relative accuracy of the true value.
+void ExpectAccurate(const DDSketch& sketch, std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  for (double q : {0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1.0}) {
+    double expected = values[static_cast<size_t>(q * (values.size() - 1))];
+    EXPECT_NEAR(expected, sketch.Quantile(q),
+                std::abs(expected) * DDSketch::kRelativeAccuracy + 1e-12)
+        << "q=" << q;
+  }
+}
+
+TEST(DDSketch, relative_accuracy) {
+  std::mt19937 gen(37);
+  std::lognormal_distribution<double> dist(10, 2);
+  std::vector<double> values;
+  DDSketch sketch;
+  for (int i = 0; i < 100000; ++i) {
+    values.push_back(dist(gen));
+    sketch.Add(values.back());
+  }
+  EXPECT_EQ(100000, sketch.count());
+  ExpectAccurate(sketch, values);
+}
+
+TEST(DDSketch, negative_and_zero_values) {
+  std::vector<double> values;
+  DDSketch sketch;
+  for (int i = -500; i <= 500; ++i) {
+    values.push_back(i * 1.5);
+    sketch.Add(values.back());
+  }
+  ExpectAccurate(sketch, values);
+  EXPECT_EQ(0, sketch.Quantile(0.5));
+  EXPECT_TRUE(std::isnan(DDSketch().Quantile(0.5)));
+}
+
+TEST(DDSketch, merge) {
+  std::vector<double> values;
+  DDSketch parts[3];
+  DDSketch all;
+  for (int i = 0; i < 3000; ++i) {
+    values.push_back((i % 3 + 1) * (i + 1));
+    parts[i % 3].Add(values.back());
+    all.Add(values.back());
+  }
+  DDSketch merged;
+  for (const auto& part : parts) {
+    merged.Merge(part);
+  }
+  EXPECT_EQ(all.Serialize(), merged.Serialize());
+  ExpectAccurate(merged, values);
+}
+
+TEST(DDSketch, collapses_lowest_buckets) {
+  DDSketch sketch;
+  sketch.Add(1e-200);
+  sketch.Add(1e-100);
+  for (int i = 0; i < 98; ++i) {
+    sketch.Add(1e200);
+  }
+  EXPECT_EQ(100, sketch.count());
+  // The tiny values get folded into the lowest bucket that fits, but are still counted.
+  EXPECT_LT(sketch.Quantile(0.0), 1e200);
+  EXPECT_NEAR(1e200, sketch.Quantile(0.5), 1e200 * DDSketch::kRelativeAccuracy);
+  EXPECT_NEAR(1e200, sketch.Quantile(1.0), 1e200 * DDSketch::kRelativeAccuracy);
+}
+
+TEST(DDSketch, serialization) {
+  DDSketch sketch;
+  for (int i = -100; i < 10000; ++i) {
+    sketch.Add(i);
+  }
+  auto serialized = sketch.Serialize();
+  DDSketch other;
+  ASSERT_OK(other.Deserialize(serialized));
+  EXPECT_EQ(serialized, other.Serialize());
+  EXPECT_EQ(sketch.Quantile(0.99), other.Quantile(0.99));
+  // A couple of bytes per bucket, rather than a full count.
+  EXPECT_LT(serialized.size(), 1024U);
+
+  EXPECT_NOT_OK(other.Deserialize(""));
+  EXPECT_NOT_OK(other.Deserialize(serialized.substr(0, serialized.size() - 1)));
+  EXPECT_NOT_OK(other.Deserialize(serialized + "x"));
+}
+
+TEST(MathSketches, quantiles_float64) {
+  auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+  auto res = uda_tester.ForInput(1.234)
+                 .ForInput(2.442)
+                 .ForInput(1.04)
+                 .ForInput(5.322)
+                 .ForInput(6.333)
+                 .Result();
+
+  rapidjson::Document d;
+  d.Parse(res.data());
+  // Each quantile is the value at that rank, up to the sketch's relative accuracy.
+  EXPECT_NEAR(d["p01"].GetDouble(), 1.04, 1.04 * DDSketch::kRelativeAccuracy);
+  EXPECT_NEAR(d["p50"].GetDouble(), 2.442, 2.442 * DDSketch::kRelativeAccuracy);
+  EXPECT_NEAR(d["p90"].GetDouble(), 5.322, 5.322 * DDSketch::kRelativeAccuracy);
+  EXPECT_NEAR(d["p99"].GetDouble(), 5.322, 5.322 * DDSketch::kRelativeAccuracy);
+}
+
+TEST(MathSketches, quantiles_partial_agg) {
+  udf::UDATester<QuantilesUDA<types::Int64Value>> pem1;
+  udf::UDATester<QuantilesUDA<types::Int64Value>> pem2;
+  for (int64_t i = 1; i <= 100; ++i) {
+    (i % 2 ? pem1 : pem2).ForInput(i);
+  }
+
+  udf::UDATester<QuantilesUDA<types::Int64Value>> kelvin;
+  ASSERT_OK(kelvin.Deserialize(pem1.Serialize()));
+  ASSERT_OK(kelvin.Deserialize(pem2.Serialize()));
+  auto res = kelvin.Result();
+
+  rapidjson::Document d;
+  d.Parse(res.data());
+  EXPECT_NEAR(d["p50"].GetDouble(), 50, 50 * DDSketch::kRelativeAccuracy);
+  EXPECT_NEAR(d["p99"].GetDouble(), 99, 99 * DDSketch::kRelativeAccuracy);
+}
+
+HyperLogLog DistinctStrings(int begin, int end) {
+  HyperLogLog sketch;
+  for (int i = begin; i < end; ++i) {
+    sketch.Add(HyperLogLog::Hash(absl::StrCat("value", i)));
+  }
+  return sketch;
+}
+
+TEST(HyperLogLog, sparse) {
+  auto sketch = DistinctStrings(0, 300);
+  // Duplicates don't count.
+  sketch.Merge(DistinctStrings(0, 300));
+  EXPECT_TRUE(sketch.is_sparse());
+  EXPECT_NEAR(300, sketch.Estimate(), 1);
+  EXPECT_EQ(0, HyperLogLog().Estimate());
+}
+
+TEST(HyperLogLog, dense) {
+  for (int n : {1000, 10000, 1000000}) {
+    auto sketch = DistinctStrings(0, n);
+    EXPECT_FALSE(sketch.is_sparse());
+    // A few standard errors.
+    EXPECT_NEAR(n, sketch.Estimate(), n * 0.07) << n;
+  }
+}
+
+TEST(HyperLogLog, merge) {
+  auto all = DistinctStrings(0, 5000);
+  // Sparse into sparse, sparse into dense and dense into sparse.
+  for (auto [split1, split2] : {std::pair{100, 200}, std::pair{100, 4000}, std::pair{4900, 4990}}) {
+    auto merged = DistinctStrings(0, split1);
+    merged.Merge(DistinctStrings(split1, split2));
+    auto rest = DistinctStrings(split2, 5000);
+    rest.Merge(merged);
+    EXPECT_EQ(all.Serialize(), rest.Serialize());
+  }
+}
+
+TEST(HyperLogLog, serialization) {
+  for (int n : {0, 10, 300, 5000}) {
+    auto sketch = DistinctStrings(0, n);
+    auto serialized = sketch.Serialize();
+    HyperLogLog other;
+    ASSERT_OK(other.Deserialize(serialized));
+    EXPECT_EQ(sketch.is_sparse(), other.is_sparse());
+    EXPECT_EQ(serialized, other.Serialize());
+    EXPECT_EQ(sketch.Estimate(), other.Estimate());
+    EXPECT_NOT_OK(other.Deserialize(serialized.substr(0, serialized.size() - 1)));
+  }
+  // The dense registers are packed into 6 bits each.
+  EXPECT_EQ(2 + HyperLogLog::kNumRegisters * 6 / 8, DistinctStrings(0, 5000).Serialize().size());
+}
+
+TEST(MathSketches, approx_count_distinct) {
+  udf::UDATester<ApproxCountDistinctUDA<types::StringValue>>()
+      .ForInput("a")
+      .ForInput("b")
+      .ForInput("a")
+      .ForInput("c")
+      .Expect(3);
+  udf::UDATester<ApproxCountDistinctUDA<types::UInt128Value>>()
+      .ForInput(types::UInt128Value(1, 2))
+      .ForInput(types::UInt128Value(2, 1))
+      .ForInput(types::UInt128Value(1, 2))
+      .Expect(2);
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -20,6 +20,11 @@
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 
+DEFINE_int32(carnot_kmeans_coreset_max_levels,
+             gflags::Int32FromEnv("PL_CARNOT_KMEANS_CORESET_MAX_LEVELS", 8),
+             "The number of levels the _kmeans_fit coreset tree may grow to before its top level "
+             "is reduced in place. Bounds the memory used per group; 0 means unbounded.");
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -26,8 +26,11 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/exec/ml/coreset.h"
 #include "src/carnot/exec/ml/kmeans.h"
 #include "src/carnot/exec/ml/model_executor.h"
@@ -37,6 +40,8 @@
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
 
+DECLARE_int32(carnot_kmeans_coreset_max_levels);
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -53,7 +58,26 @@ class TransformerUDF : public udf::ScalarUDF {
  public:
   TransformerUDF() : TransformerUDF("/embedding.proto") {}
   explicit TransformerUDF(std::string model_proto_path) : model_proto_path_(model_proto_path) {}
+
+  static constexpr bool kMemoized = true;
+
+  // Runs the model over all the distinct documents of a batch at once.
+  void Prefetch(FunctionContext* ctx, const std::vector<std::string_view>& docs) {
+    auto executor =
+        ctx->model_pool()->GetModelExecutor<exec::ml::TransformerExecutor>(model_proto_path_);
+    std::vector<std::string> outputs;
+    executor->Execute(docs, &outputs);
+    embeddings_.clear();
+    for (const auto& [i, doc] : Enumerate(docs)) {
+      embeddings_.emplace(doc, std::move(outputs[i]));
+    }
+  }
+
   StringValue Exec(FunctionContext* ctx, StringValue doc) {
+    auto it = embeddings_.find(doc);
+    if (it != embeddings_.end()) {
+      return it->second;
+    }
     auto executor =
         ctx->model_pool()->GetModelExecutor<exec::ml::TransformerExecutor>(model_proto_path_);
     std::string output;
@@ -63,6 +87,8 @@ class TransformerUDF : public udf::ScalarUDF {
 
  private:
   std::string model_proto_path_;
+  // The embeddings of the documents in the current batch.
+  absl::flat_hash_map<std::string, std::string> embeddings_;
 };
 
 class SentencePieceUDF : public udf::ScalarUDF {
@@ -75,6 +101,9 @@ class SentencePieceUDF : public udf::ScalarUDF {
     }
   }
 
+  // Encode is const, so rows can be encoded on several threads.
+  static constexpr bool kParallel = true;
+
   StringValue Exec(FunctionContext*, StringValue in) {
     std::vector<int> ids;
     processor_.Encode(in, &ids);
@@ -89,7 +118,9 @@ class KMeansUDA : public udf::UDA {
  public:
   KMeansUDA() : KMeansUDA(64) {}
   explicit KMeansUDA(int d)
-      : d_(d), coreset_(/*base_bucket_size*/ 64, d, /*r*/ 4, /*coreset_size*/ 64) {}
+      : d_(d),
+        coreset_(/*base_bucket_size*/ 64, d, /*r*/ 4, /*coreset_size*/ 64,
+                 /*max_levels*/ FLAGS_carnot_kmeans_coreset_max_levels) {}
   void Update(FunctionContext*, StringValue in, Int64Value k) {
     if (k_ == -1) {
       k_ = k.val;
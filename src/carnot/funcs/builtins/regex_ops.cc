@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/regex_ops.h"
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+
+#include "src/carnot/udf/registry.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+std::unique_ptr<re2::RE2> CompileRegex(const std::string& pattern) {
+  re2::RE2::Options options;
+  // Patterns come from queries, so a bad one shouldn't spam the logs for every batch.
+  options.set_log_errors(false);
+  auto regex = std::make_unique<re2::RE2>(pattern, options);
+  if (!regex->ok()) {
+    return nullptr;
+  }
+  return regex;
+}
+
+re2::RE2::Options RegexCategories::CompileOptions() {
+  re2::RE2::Options options;
+  options.set_log_errors(false);
+  return options;
+}
+
+std::unique_ptr<RegexCategories> RegexCategories::Compile(const std::string& categories_json) {
+  rapidjson::Document doc;
+  rapidjson::ParseResult ok = doc.Parse(categories_json.data());
+  if (ok == nullptr || !doc.IsObject()) {
+    return nullptr;
+  }
+
+  std::unique_ptr<RegexCategories> compiled(new RegexCategories());
+  for (const auto& member : doc.GetObject()) {
+    if (!member.value.IsString()) {
+      return nullptr;
+    }
+    // The set gives the patterns consecutive indices, which line up with categories_.
+    if (compiled->set_.Add(member.value.GetString(), nullptr) < 0) {
+      return nullptr;
+    }
+    compiled->categories_.emplace_back(member.name.GetString());
+  }
+  if (!compiled->categories_.empty() && !compiled->set_.Compile()) {
+    return nullptr;
+  }
+  return compiled;
+}
+
+std::string RegexCategories::Classify(const std::string& value) const {
+  if (categories_.empty()) {
+    return "";
+  }
+  std::vector<int> matches;
+  if (!set_.Match(value, &matches) || matches.empty()) {
+    return "";
+  }
+  return categories_[*std::min_element(matches.begin(), matches.end())];
+}
+
+void RegisterRegexOpsOrDie(udf::Registry* registry) {
+  CHECK(registry != nullptr);
+  /*****************************************
+   * Scalar UDFs.
+   *****************************************/
+  registry->RegisterOrDie<RegexMatchUDF>("regex_match");
+  registry->RegisterOrDie<RegexReplaceUDF>("replace");
+  registry->RegisterOrDie<RegexClassifyUDF>("regex_classify");
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
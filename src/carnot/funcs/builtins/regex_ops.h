@@ -0,0 +1,182 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <re2/re2.h>
+#include <re2/set.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/node_hash_map.h>
+
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+/**
+ * PatternCache holds the compiled form of the patterns a UDF instance has seen. Patterns are
+ * almost always constants, so each is compiled once for the query instead of once per row.
+ * Patterns that fail to compile are cached as nullptr.
+ */
+template <typename TCompiled>
+class PatternCache {
+ public:
+  // Bounds the cache for the rare queries that compute patterns per row.
+  static constexpr size_t kMaxEntries = 64;
+
+  template <typename TCompileFn>
+  const TCompiled* GetOrCompile(const std::string& pattern, TCompileFn compile) {
+    if (last_ != nullptr && last_->first == pattern) {
+      return last_->second.get();
+    }
+    auto it = cache_.find(pattern);
+    if (it == cache_.end()) {
+      if (cache_.size() >= kMaxEntries) {
+        cache_.clear();
+      }
+      it = cache_.emplace(pattern, compile(pattern)).first;
+    }
+    // Pointers to the entries are stable since they're node based.
+    last_ = &*it;
+    return it->second.get();
+  }
+
+ private:
+  using Map = absl::node_hash_map<std::string, std::unique_ptr<TCompiled>>;
+  Map cache_;
+  const typename Map::value_type* last_ = nullptr;
+};
+
+std::unique_ptr<re2::RE2> CompileRegex(const std::string& pattern);
+
+class RegexMatchUDF : public udf::ScalarUDF {
+ public:
+  BoolValue Exec(FunctionContext*, StringValue pattern, StringValue value) {
+    const re2::RE2* regex = regexes_.GetOrCompile(pattern, CompileRegex);
+    return regex != nullptr && re2::RE2::FullMatch(value, *regex);
+  }
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder("Returns whether the string matches the regular expression.")
+        .Details(
+            "The whole string has to match the pattern, which uses the RE2 syntax "
+            "(https://github.com/google/re2/wiki/Syntax). Returns false if the pattern is "
+            "invalid.")
+        .Example(R"doc(df.is_api = px.regex_match('/api/v[0-9]+/.*', df.req_path))doc")
+        .Arg("pattern", "The regular expression.")
+        .Arg("value", "The string to match.")
+        .Returns("Whether the whole string matches the pattern.");
+  }
+
+ private:
+  PatternCache<re2::RE2> regexes_;
+};
+
+class RegexReplaceUDF : public udf::ScalarUDF {
+ public:
+  StringValue Exec(FunctionContext*, StringValue pattern, StringValue value,
+                   StringValue replacement) {
+    const re2::RE2* regex = regexes_.GetOrCompile(pattern, CompileRegex);
+    if (regex != nullptr) {
+      re2::RE2::GlobalReplace(&value, *regex, replacement);
+    }
+    return value;
+  }
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder(
+               "Replaces all the matches of the regular expression in the string.")
+        .Details(
+            "The pattern uses the RE2 syntax (https://github.com/google/re2/wiki/Syntax). The "
+            "replacement can refer to the capture groups of the pattern as \\1 to \\9, and to the "
+            "whole match as \\0. Returns the string unchanged if the pattern is invalid.")
+        .Example(R"doc(df.path = px.replace('/[0-9]+', df.req_path, '/<id>'))doc")
+        .Arg("pattern", "The regular expression.")
+        .Arg("value", "The string to replace the matches in.")
+        .Arg("replacement", "The string to replace each match with.")
+        .Returns("The string with every match replaced.");
+  }
+
+ private:
+  PatternCache<re2::RE2> regexes_;
+};
+
+/**
+ * The categories of regex_classify, compiled into a single RE2::Set so that each string is
+ * matched against all of the patterns in one pass.
+ */
+class RegexCategories {
+ public:
+  static std::unique_ptr<RegexCategories> Compile(const std::string& categories_json);
+
+  /**
+   * @return the first category with a pattern that matches the string, or the empty string.
+   */
+  std::string Classify(const std::string& value) const;
+
+ private:
+  RegexCategories() : set_(CompileOptions(), re2::RE2::UNANCHORED) {}
+  static re2::RE2::Options CompileOptions();
+
+  re2::RE2::Set set_;
+  std::vector<std::string> categories_;
+};
+
+class RegexClassifyUDF : public udf::ScalarUDF {
+ public:
+  StringValue Exec(FunctionContext*, StringValue categories, StringValue value) {
+    const RegexCategories* compiled =
+        categories_.GetOrCompile(categories, RegexCategories::Compile);
+    return compiled == nullptr ? "" : compiled->Classify(value);
+  }
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder(
+               "Returns the first category with a regular expression that matches the string.")
+        .Details(
+            "The categories are a JSON object that maps each category to a regular expression in "
+            "the RE2 syntax (https://github.com/google/re2/wiki/Syntax). The patterns match "
+            "anywhere in the string unless they're anchored with ^ or $, and are checked in the "
+            "order they appear in the object. All of the patterns are matched in a single pass "
+            "over the string, so this is much cheaper than a chain of px.select and "
+            "px.contains calls. Returns the empty string if no pattern matches, or if the "
+            "categories or any of the patterns are invalid.")
+        .Example(R"doc(df.endpoint = px.regex_classify(
+        |     '{"api": "^/api/", "static": "[.](js|css|png)$", "health": "^/(healthz|readyz)"}',
+        |     df.req_path))doc")
+        .Arg("categories", "A JSON object of category name to regular expression.")
+        .Arg("value", "The string to classify.")
+        .Returns("The name of the first matching category, or the empty string.");
+  }
+
+ private:
+  PatternCache<RegexCategories> categories_;
+};
+
+void RegisterRegexOpsOrDie(udf::Registry* registry);
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/carnot/funcs/builtins/regex_ops.h"
+#include "src/carnot/udf/test_utils.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+TEST(RegexOps, regex_match) {
+  auto udf_tester = udf::UDFTester<RegexMatchUDF>();
+  udf_tester.ForInput("/api/v[0-9]+/.*", "/api/v1/users").Expect(true);
+  udf_tester.ForInput("/api/v[0-9]+/.*", "/static/api/v1/users").Expect(false);
+  udf_tester.ForInput("[a-z]+", "abc").Expect(true);
+  udf_tester.ForInput("[a-z]+", "abc1").Expect(false);
+  // Invalid patterns never match.
+  udf_tester.ForInput("(abc", "(abc").Expect(false);
+}
+
+TEST(RegexOps, replace) {
+  auto udf_tester = udf::UDFTester<RegexReplaceUDF>();
+  udf_tester.ForInput("/[0-9]+", "/api/users/123/orders/45", "/<id>")
+      .Expect("/api/users/<id>/orders/<id>");
+  udf_tester.ForInput("(\\w+)@(\\w+)", "me@pixie", "\\2 at \\1").Expect("pixie at me");
+  udf_tester.ForInput("x", "abc", "y").Expect("abc");
+  udf_tester.ForInput("(abc", "abc", "y").Expect("abc");
+}
+
+TEST(RegexOps, regex_classify) {
+  std::string categories =
+      R"({"health": "^/(healthz|readyz)$", "api": "^/api/", "static": "[.](js|css)$"})";
+  auto udf_tester = udf::UDFTester<RegexClassifyUDF>();
+  udf_tester.ForInput(categories, "/api/v1/users").Expect("api");
+  udf_tester.ForInput(categories, "/healthz").Expect("health");
+  udf_tester.ForInput(categories, "/assets/app.js").Expect("static");
+  // The first matching category wins.
+  udf_tester.ForInput(categories, "/api/app.js").Expect("api");
+  udf_tester.ForInput(categories, "/index.html").Expect("");
+
+  udf_tester.ForInput(R"({"a": "(abc"})", "abc").Expect("");
+  udf_tester.ForInput(R"(["abc"])", "abc").Expect("");
+  udf_tester.ForInput("{}", "abc").Expect("");
+}
+
+TEST(PatternCache, compiles_once) {
+  PatternCache<std::string> cache;
+  int compiles = 0;
+  auto compile = [&](const std::string& pattern) {
+    ++compiles;
+    return pattern == "bad" ? nullptr : std::make_unique<std::string>(pattern + "!");
+  };
+  EXPECT_EQ("a!", *cache.GetOrCompile("a", compile));
+  EXPECT_EQ("a!", *cache.GetOrCompile("a", compile));
+  EXPECT_EQ("b!", *cache.GetOrCompile("b", compile));
+  EXPECT_EQ("a!", *cache.GetOrCompile("a", compile));
+  EXPECT_EQ(nullptr, cache.GetOrCompile("bad", compile));
+  EXPECT_EQ(nullptr, cache.GetOrCompile("bad", compile));
+  EXPECT_EQ(3, compiles);
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -18,6 +18,7 @@
 
 
 #include "src/carnot/funcs/builtins/request_path_ops.h"
+#include <algorithm>
 #include <string_view>
 #include <vector>
 #include "src/carnot/udf/registry.h"
@@ -79,7 +80,8 @@ StatusOr<RequestPath> RequestPath::FromJSON(std::string serialized_request_path)
   return RequestPath::FromJSON(d);
 }
 
-StatusOr<RequestPath> RequestPath::FromJSON(const rapidjson::Document::ValueType& doc) {
+StatusOr<RequestPath> RequestPath::FromJSON(const rapidjson::Document::ValueType& doc,
+                                            const std::vector<std::string>* components) {
   if (!doc.IsArray()) {
     return error::InvalidArgument(
         "RequestPath::FromJSON: expected array of path components, didn't receive array");
@@ -87,6 +89,15 @@ StatusOr<RequestPath> RequestPath::FromJSON(const rapidjson::Document::ValueType
   RequestPath request_path;
   for (rapidjson::Value::ConstValueIterator itr = doc.Begin(); itr != doc.End(); ++itr) {
     const rapidjson::Value& val = *itr;
+    if (components != nullptr) {
+      if (!val.IsUint() || val.GetUint() >= components->size()) {
+        return error::InvalidArgument(
+            "RequestPath::FromJSON: expected array of path component indices, received invalid "
+            "index");
+      }
+      request_path.path_components_.push_back((*components)[val.GetUint()]);
+      continue;
+    }
     if (!val.IsString()) {
       return error::InvalidArgument(
           "RequestPath::FromJSON: expected array of path components, received non string path "
@@ -104,10 +115,15 @@ std::string RequestPath::ToJSON() const {
   return sb.GetString();
 }
 
-void RequestPath::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer) const {
+void RequestPath::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer,
+                         const PathComponentIDs* component_ids) const {
   writer->StartArray();
-  for (auto path : path_components_) {
-    writer->String(path.data(), path.size());
+  for (const auto& path : path_components_) {
+    if (component_ids != nullptr) {
+      writer->Int64(component_ids->at(path));
+    } else {
+      writer->String(path.data(), path.size());
+    }
   }
   writer->EndArray();
 }
@@ -178,33 +194,34 @@ const RequestPath& RequestPathCluster::Predict(const RequestPath& request_path)
 }
 
 StatusOr<RequestPathCluster> RequestPathCluster::FromJSON(
-    const rapidjson::Document::ValueType& doc) {
+    const rapidjson::Document::ValueType& doc, const std::vector<std::string>* components) {
   if (!doc.IsObject()) {
     return error::InvalidArgument(
         "RequestPathCluster::FromJSON outer json must be object with centroid and member keys");
   }
   RequestPathCluster cluster;
-  PL_ASSIGN_OR_RETURN(cluster.centroid_, RequestPath::FromJSON(doc[kCentroidKey]));
+  PL_ASSIGN_OR_RETURN(cluster.centroid_, RequestPath::FromJSON(doc[kCentroidKey], components));
   const auto& members = doc[kMembersKey];
   if (!members.IsArray()) {
     return error::InvalidArgument("RequestPathCluster::FromJSON members key must be array");
   }
   for (rapidjson::Value::ConstValueIterator itr = members.Begin(); itr != members.End(); ++itr) {
     const rapidjson::Value& val = *itr;
-    PL_ASSIGN_OR_RETURN(auto path, RequestPath::FromJSON(val));
+    PL_ASSIGN_OR_RETURN(auto path, RequestPath::FromJSON(val, components));
     cluster.members_.insert(path);
   }
   return cluster;
 }
 
-void RequestPathCluster::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer) const {
+void RequestPathCluster::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer,
+                                const PathComponentIDs* component_ids) const {
   writer->StartObject();
   writer->Key(kCentroidKey);
-  centroid_.ToJSON(writer);
+  centroid_.ToJSON(writer, component_ids);
   writer->Key(kMembersKey);
   writer->StartArray();
   for (const auto& path : members_) {
-    path.ToJSON(writer);
+    path.ToJSON(writer, component_ids);
   }
   writer->EndArray();
   writer->EndObject();
@@ -212,34 +229,75 @@ void RequestPathCluster::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writ
 
 double RequestPathClustering::MaxSimilarity(const RequestPath& request_path,
                                             int64_t* max_index) const {
-  auto it = depth_to_centroid_indices_.find(request_path.depth());
+  auto it = depth_to_component_index_.find(request_path.depth());
   *max_index = -1;
-  if (it == depth_to_centroid_indices_.end()) {
+  if (it == depth_to_component_index_.end()) {
     return 0.0;
   }
-  auto max_similarity = 0.0;
-  for (auto index : it->second) {
-    auto similarity = clusters_[index].Similarity(request_path);
-    if (similarity > max_similarity) {
+  // Count the agreeing path components of each cluster that agrees on at least one of them.
+  absl::flat_hash_map<int64_t, int64_t> num_agree;
+  for (const auto& [i, path_component] : Enumerate(request_path.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    auto postings = it->second[i].find(path_component);
+    if (postings == it->second[i].end()) {
+      continue;
+    }
+    for (auto index : postings->second) {
+      ++num_agree[index];
+    }
+  }
+  // Ties go to the earliest cluster.
+  int64_t max_agree = 0;
+  for (const auto& [index, agree] : num_agree) {
+    if (agree > max_agree || (agree == max_agree && index < *max_index)) {
       *max_index = index;
-      max_similarity = similarity;
+      max_agree = agree;
     }
   }
-  return max_similarity;
+  return static_cast<double>(max_agree) / request_path.depth();
 }
 
-void RequestPathClustering::AddNewCluster(const RequestPathCluster& cluster) {
-  auto centroid = cluster.centroid();
-  if (depth_to_centroid_indices_.find(centroid.depth()) == depth_to_centroid_indices_.end()) {
-    depth_to_centroid_indices_.emplace(centroid.depth(), std::vector<int64_t>());
+void RequestPathClustering::IndexCluster(int64_t cluster_index) {
+  const auto& centroid = clusters_[cluster_index].centroid();
+  auto& component_index = depth_to_component_index_[centroid.depth()];
+  component_index.resize(centroid.depth());
+  for (const auto& [i, path_component] : Enumerate(centroid.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    component_index[i][path_component].push_back(cluster_index);
   }
-  depth_to_centroid_indices_[centroid.depth()].push_back(clusters_.size());
+}
+
+void RequestPathClustering::AddNewCluster(const RequestPathCluster& cluster) {
   clusters_.push_back(cluster);
+  IndexCluster(clusters_.size() - 1);
 }
 
 void RequestPathClustering::MergeCluster(int64_t cluster_index,
                                          const RequestPathCluster& other_cluster) {
-  clusters_[cluster_index].Merge(other_cluster);
+  auto& cluster = clusters_[cluster_index];
+  auto old_centroid = cluster.centroid();
+  cluster.Merge(other_cluster);
+
+  // Merging only ever replaces centroid components with kAnyToken, so drop the cluster from the
+  // index entries of the components that were replaced.
+  auto& component_index = depth_to_component_index_[old_centroid.depth()];
+  for (const auto& [i, path_component] : Enumerate(old_centroid.path_components())) {
+    if (path_component == RequestPath::kAnyToken ||
+        path_component == cluster.centroid().path_components()[i]) {
+      continue;
+    }
+    auto postings = component_index[i].find(path_component);
+    DCHECK(postings != component_index[i].end());
+    auto& indices = postings->second;
+    indices.erase(std::lower_bound(indices.begin(), indices.end(), cluster_index));
+    if (indices.empty()) {
+      component_index[i].erase(postings);
+    }
+  }
 }
 
 StatusOr<RequestPathClustering> RequestPathClustering::FromJSON(const std::string& json) {
@@ -248,27 +306,70 @@ StatusOr<RequestPathClustering> RequestPathClustering::FromJSON(const std::strin
   if (ok == nullptr) {
     return error::InvalidArgument("RequestPathClustering::FromJSON: invalid json");
   }
-  if (!d.IsArray()) {
-    return error::InvalidArgument("RequestPathClustering::FromJSON: expected array");
-  }
 
   RequestPathClustering clustering;
-  for (rapidjson::Value::ConstValueIterator itr = d.Begin(); itr != d.End(); ++itr) {
-    const rapidjson::Value& val = *itr;
-    PL_ASSIGN_OR_RETURN(auto cluster, RequestPathCluster::FromJSON(val));
+  if (d.IsArray()) {
+    for (rapidjson::Value::ConstValueIterator itr = d.Begin(); itr != d.End(); ++itr) {
+      const rapidjson::Value& val = *itr;
+      PL_ASSIGN_OR_RETURN(auto cluster, RequestPathCluster::FromJSON(val));
+      clustering.AddNewCluster(cluster);
+    }
+    return clustering;
+  }
+
+  if (!d.IsObject() || !d.HasMember(kComponentsKey) || !d[kComponentsKey].IsArray() ||
+      !d.HasMember(kClustersKey) || !d[kClustersKey].IsArray()) {
+    return error::InvalidArgument(
+        "RequestPathClustering::FromJSON: expected object with component and cluster arrays");
+  }
+  std::vector<std::string> components;
+  for (const auto& val : d[kComponentsKey].GetArray()) {
+    if (!val.IsString()) {
+      return error::InvalidArgument(
+          "RequestPathClustering::FromJSON: received non string path component");
+    }
+    components.emplace_back(val.GetString(), val.GetStringLength());
+  }
+  for (const auto& val : d[kClustersKey].GetArray()) {
+    PL_ASSIGN_OR_RETURN(auto cluster, RequestPathCluster::FromJSON(val, &components));
     clustering.AddNewCluster(cluster);
   }
   return clustering;
 }
 
 std::string RequestPathClustering::ToJSON() const {
+  PathComponentIDs component_ids;
+  std::vector<std::string_view> components;
+  auto add_components = [&](const RequestPath& path) {
+    for (const auto& path_component : path.path_components()) {
+      if (component_ids.try_emplace(path_component, components.size()).second) {
+        components.push_back(path_component);
+      }
+    }
+  };
+  for (const auto& cluster : clusters_) {
+    add_components(cluster.centroid());
+    for (const auto& path : cluster.members()) {
+      add_components(path);
+    }
+  }
+
   rapidjson::StringBuffer sb;
   rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartObject();
+  writer.Key(kComponentsKey);
   writer.StartArray();
-  for (auto cluster : clusters_) {
-    cluster.ToJSON(&writer);
+  for (const auto& path_component : components) {
+    writer.String(path_component.data(), path_component.size());
   }
   writer.EndArray();
+  writer.Key(kClustersKey);
+  writer.StartArray();
+  for (const auto& cluster : clusters_) {
+    cluster.ToJSON(&writer, &component_ids);
+  }
+  writer.EndArray();
+  writer.EndObject();
   return sb.GetString();
 }
 
@@ -307,14 +408,10 @@ void RequestPathClustering::Merge(const RequestPathClustering& other_clustering)
   }
 
   clusters_ = new_clusters;
-  // Rebuild depth_to_cluster_indices mapping.
-  depth_to_centroid_indices_.clear();
-  for (const auto& [cluster_idx, cluster] : Enumerate(clusters_)) {
-    auto depth = cluster.centroid().depth();
-    if (depth_to_centroid_indices_.find(depth) == depth_to_centroid_indices_.end()) {
-      depth_to_centroid_indices_.emplace(depth, std::vector<int64_t>());
-    }
-    depth_to_centroid_indices_[depth].push_back(cluster_idx);
+  // Rebuild the centroid index.
+  depth_to_component_index_.clear();
+  for (size_t cluster_idx = 0; cluster_idx < clusters_.size(); ++cluster_idx) {
+    IndexCluster(cluster_idx);
   }
 
   for (const auto& cluster : other_clustering.clusters_) {
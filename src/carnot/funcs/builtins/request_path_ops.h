@@ -25,6 +25,9 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/udf/registry.h"
 #include "src/shared/types/types.h"
 
@@ -38,6 +41,13 @@ namespace builtins {
  */
 void RegisterRequestPathOpsOrDie(udf::Registry* registry);
 
+/**
+ * Maps each distinct path component of a clustering to its index in the clustering's serialized
+ * component table. Serializing paths as indices keeps clusterings with thousands of clusters, which
+ * mostly share the same few components, compact.
+ */
+using PathComponentIDs = absl::flat_hash_map<std::string_view, int64_t>;
+
 class RequestPath {
   /**
    * This class assumes that the request paths "/a/b" and "a/b" are equivalent. And as a result,
@@ -88,11 +98,14 @@ class RequestPath {
     return H::combine(std::move(h), request_path.ToString());
   }
 
-  // Serialization/Deserialization
+  // Serialization/Deserialization. If component_ids/components are given, the path components
+  // are written/read as indices into the component table instead of as strings.
   std::string ToJSON() const;
-  void ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
+  void ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer,
+              const PathComponentIDs* component_ids = nullptr) const;
   static StatusOr<RequestPath> FromJSON(std::string serialized_request_path);
-  static StatusOr<RequestPath> FromJSON(const rapidjson::Document::ValueType& doc);
+  static StatusOr<RequestPath> FromJSON(const rapidjson::Document::ValueType& doc,
+                                        const std::vector<std::string>* components = nullptr);
 
   int64_t depth() const { return path_components_.size(); }
   const std::vector<std::string>& path_components() const { return path_components_; }
@@ -154,11 +167,14 @@ class RequestPathCluster {
    */
   const RequestPath& Predict(const RequestPath& request_path) const;
 
-  // Serialization/Deserialization
+  // Serialization/Deserialization. See RequestPath for component_ids/components.
   static StatusOr<RequestPathCluster> FromJSON(const std::string& json);
-  static StatusOr<RequestPathCluster> FromJSON(const rapidjson::Document::ValueType& doc);
+  static StatusOr<RequestPathCluster> FromJSON(
+      const rapidjson::Document::ValueType& doc,
+      const std::vector<std::string>* components = nullptr);
   std::string ToJSON() const;
-  void ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer) const;
+  void ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer,
+              const PathComponentIDs* component_ids = nullptr) const;
 
   const RequestPath& centroid() const { return centroid_; }
   const absl::flat_hash_set<RequestPath>& members() const { return members_; }
@@ -176,8 +192,16 @@ class RequestPathCluster {
 
 class RequestPathClustering {
  public:
+  /**
+   * Parses a clustering serialized by ToJSON. The older format, a plain array of clusters with
+   * string path components, is still accepted.
+   */
   static StatusOr<RequestPathClustering> FromJSON(const std::string& json);
 
+  /**
+   * Serializes the clustering as an object holding a table of the distinct path components, and
+   * the clusters with their paths written as indices into that table.
+   */
   std::string ToJSON() const;
 
   /**
@@ -201,8 +225,19 @@ class RequestPathClustering {
   double MaxSimilarity(const RequestPath& request_path, int64_t* max_index) const;
   void AddNewCluster(const RequestPathCluster& cluster);
   void MergeCluster(int64_t cluster_index, const RequestPathCluster& other_cluster);
+  void IndexCluster(int64_t cluster_index);
+
+  inline static constexpr char kComponentsKey[] = "p";
+  inline static constexpr char kClustersKey[] = "c";
+
+  // Inverted index over the centroids, so that finding the most similar cluster only looks at the
+  // clusters that share a component with the request path, instead of comparing against every
+  // centroid. For each depth, there is one map per position, from a path component to the
+  // (ascending) indices of the clusters whose centroid has that component at that position.
+  // kAnyToken components are not indexed since they never count towards the similarity.
   // We currently only allow request path's with the same depth to be clustered together.
-  absl::flat_hash_map<int64_t, std::vector<int64_t>> depth_to_centroid_indices_;
+  using ComponentIndex = absl::flat_hash_map<std::string, std::vector<int64_t>>;
+  absl::flat_hash_map<int64_t, std::vector<ComponentIndex>> depth_to_component_index_;
   std::vector<RequestPathCluster> clusters_;
   double thresh_ = 0.5;
 };
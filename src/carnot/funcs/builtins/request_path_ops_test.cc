@@ -93,6 +93,57 @@ TEST(RequestPathClusteringPredict, basic_low_cardinality) {
   udf_tester.ForInput("/a/b/c", serialized_clustering).Expect("/a/b/c");
 }
 
+TEST(RequestPathClustering, serialization) {
+  auto uda_tester = udf::UDATester<RequestPathClusteringFitUDA>();
+  auto serialized_clustering = uda_tester.ForInput("/a/b/c")
+                                   .ForInput("/a/b/d")
+                                   .ForInput("/a/b/e")
+                                   .ForInput("/a/b/f")
+                                   .ForInput("/a/b/g")
+                                   .ForInput("/a/b/h")
+                                   .ForInput("/x/y")
+                                   .Result();
+  ASSERT_OK_AND_ASSIGN(auto clustering, RequestPathClustering::FromJSON(serialized_clustering));
+  EXPECT_EQ(serialized_clustering, clustering.ToJSON());
+  std::vector<std::string> centroids({"/a/b/*", "/x/y"});
+  EXPECT_THAT(clustering, HasCentroids(centroids));
+
+  // Path components are only written once, in the component table.
+  EXPECT_EQ(R"({"p":["a","b","*","x","y"],"c":[{"c":[0,1,2],"m":[]},{"c":[3,4],"m":[[3,4]]}]})",
+            serialized_clustering);
+}
+
+TEST(RequestPathClustering, legacy_serialization) {
+  ASSERT_OK_AND_ASSIGN(
+      auto clustering,
+      RequestPathClustering::FromJSON(
+          R"([{"c":["a","b","*"],"m":[]},{"c":["x","y"],"m":[["x","y"]]}])"));
+  std::vector<std::string> centroids({"/a/b/*", "/x/y"});
+  EXPECT_THAT(clustering, HasCentroids(centroids));
+  EXPECT_EQ("/a/b/*", clustering.Predict(RequestPath("/a/b/c")).ToString());
+
+  EXPECT_NOT_OK(RequestPathClustering::FromJSON(R"({"p":["a"],"c":[{"c":[1],"m":[]}]})"));
+}
+
+TEST(RequestPathClustering, predict_many_clusters) {
+  RequestPathClustering clustering;
+  for (int i = 0; i < 1000; ++i) {
+    clustering.Update(RequestPathCluster(RequestPath(absl::Substitute("/svc$0/$0", i))));
+  }
+  ASSERT_EQ(1000, clustering.clusters().size());
+  EXPECT_EQ("/svc123/123", clustering.Predict(RequestPath("/svc123/123")).ToString());
+  // The most similar cluster wins, and ties go to the earliest cluster.
+  EXPECT_EQ("/svc7/7", clustering.Predict(RequestPath("/svc7/8")).ToString());
+  EXPECT_EQ("/svc8/8", clustering.Predict(RequestPath("/abc/8")).ToString());
+
+  // Once the clusters are merged into /*/8, /svc8 no longer counts towards its similarity.
+  for (int i = 0; i < 6; ++i) {
+    clustering.Update(RequestPathCluster(RequestPath(absl::Substitute("/svc$0/8", 1000 + i))));
+  }
+  EXPECT_EQ("/*/8", clustering.Predict(RequestPath("/abc/8")).ToString());
+  EXPECT_EQ("/svc9/9", clustering.Predict(RequestPath("/svc8/9")).ToString());
+}
+
 TEST(RequestPathEndpointMatcher, basic) {
   auto udf_tester = udf::UDFTester<RequestPathEndpointMatcherUDF>();
   udf_tester.ForInput("/a/b/c", "/a/b/*").Expect(true);
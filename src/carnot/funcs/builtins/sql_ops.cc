@@ -18,6 +18,13 @@
 #include <vector>
 
 #include "src/carnot/funcs/builtins/sql_ops.h"
+
+#include <string>
+#include <vector>
+
+#define TBB_PREVIEW_CONCURRENT_LRU_CACHE 1
+#include "tbb/concurrent_lru_cache.h"
+
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 
@@ -36,84 +43,123 @@ static inline px::Status ParseExecuteCommand(std::string execute, std::string* q
   return px::Status::OK();
 }
 
-}  // namespace
-
-namespace px {
-namespace carnot {
-namespace builtins {
-
-void RegisterSQLOpsOrDie(udf::Registry* registry) {
-  CHECK(registry != nullptr);
-  /*****************************************
-   * Scalar UDFs.
-   *****************************************/
-  registry->RegisterOrDie<NormalizePostgresSQLUDF>("normalize_pgsql");
-  registry->RegisterOrDie<NormalizeMySQLUDF>("normalize_mysql");
-  /*****************************************
-   * Aggregate UDFs.
-   *****************************************/
-}
-
-types::StringValue NormalizePostgresSQLUDF::Exec(FunctionContext*, StringValue sql_str,
-                                                 StringValue cmd_code) {
+std::string NormalizePostgresSQL(std::string sql_str, std::string cmd_code) {
   std::string query;
   std::vector<std::string> param_values;
 
-  if (cmd_code.compare(kPgExecCmdCode) == 0) {
+  if (cmd_code.compare(px::carnot::builtins::kPgExecCmdCode) == 0) {
     auto status = ParseExecuteCommand(sql_str, &query, &param_values);
     if (!status.ok()) {
-      sql_parsing::NormalizeResult result;
+      px::carnot::builtins::sql_parsing::NormalizeResult result;
       result.errmsg = status.msg();
       return result.ToJSON();
     }
-  } else if (cmd_code.compare(kPgQueryCmdCode) == 0) {
+  } else if (cmd_code.compare(px::carnot::builtins::kPgQueryCmdCode) == 0) {
     query = sql_str;
   } else {
-    sql_parsing::NormalizeResult result;
-    result.errmsg =
-        absl::Substitute("cmd_code must be one of '$0' or '$1'", kPgQueryCmdCode, kPgExecCmdCode);
+    px::carnot::builtins::sql_parsing::NormalizeResult result;
+    result.errmsg = absl::Substitute("cmd_code must be one of '$0' or '$1'",
+                                     px::carnot::builtins::kPgQueryCmdCode,
+                                     px::carnot::builtins::kPgExecCmdCode);
     return result.ToJSON();
   }
 
-  auto result_or_s = sql_parsing::normalize_pgsql(query, param_values);
+  auto result_or_s = px::carnot::builtins::sql_parsing::normalize_pgsql(query, param_values);
   if (!result_or_s.ok()) {
-    sql_parsing::NormalizeResult result;
+    px::carnot::builtins::sql_parsing::NormalizeResult result;
     result.errmsg = result_or_s.status().msg();
     return result.ToJSON();
   }
   return result_or_s.ConsumeValueOrDie().ToJSON();
 }
 
-types::StringValue NormalizeMySQLUDF::Exec(FunctionContext*, StringValue sql_str,
-                                           Int64Value cmd_code) {
+std::string NormalizeMySQL(std::string sql_str, int64_t cmd_code) {
   std::string query;
   std::vector<std::string> param_values;
 
-  if (cmd_code == kMySQLExecuteCmdCode) {
+  if (cmd_code == px::carnot::builtins::kMySQLExecuteCmdCode) {
     auto status = ParseExecuteCommand(sql_str, &query, &param_values);
     if (!status.ok()) {
-      sql_parsing::NormalizeResult result;
+      px::carnot::builtins::sql_parsing::NormalizeResult result;
       result.errmsg = status.msg();
       return result.ToJSON();
     }
-  } else if (cmd_code == kMySQLQueryCmdCode) {
+  } else if (cmd_code == px::carnot::builtins::kMySQLQueryCmdCode) {
     query = sql_str;
   } else {
-    sql_parsing::NormalizeResult result;
-    result.errmsg = absl::Substitute("cmd_code must be one of '$0' or '$1'", kMySQLQueryCmdCode,
-                                     kMySQLExecuteCmdCode);
+    px::carnot::builtins::sql_parsing::NormalizeResult result;
+    result.errmsg = absl::Substitute("cmd_code must be one of '$0' or '$1'",
+                                     px::carnot::builtins::kMySQLQueryCmdCode,
+                                     px::carnot::builtins::kMySQLExecuteCmdCode);
     return result.ToJSON();
   }
 
-  auto result_or_s = sql_parsing::normalize_mysql(query, param_values);
+  auto result_or_s = px::carnot::builtins::sql_parsing::normalize_mysql(query, param_values);
   if (!result_or_s.ok()) {
-    sql_parsing::NormalizeResult result;
+    px::carnot::builtins::sql_parsing::NormalizeResult result;
     result.errmsg = result_or_s.status().msg();
     return result.ToJSON();
   }
   return result_or_s.ConsumeValueOrDie().ToJSON();
 }
 
+// The cache keys are the command code, then a newline, then the exact query text.
+constexpr size_t kNormalizeCacheSize = 4096;
+
+std::string NormalizePostgresSQLKey(std::string key) {
+  auto newline = key.find('\n');
+  return NormalizePostgresSQL(key.substr(newline + 1), key.substr(0, newline));
+}
+
+std::string NormalizeMySQLKey(std::string key) {
+  auto newline = key.find('\n');
+  int64_t cmd_code = 0;
+  CHECK(absl::SimpleAtoi(key.substr(0, newline), &cmd_code));
+  return NormalizeMySQL(key.substr(newline + 1), cmd_code);
+}
+
+// Most queries are repeats of a few statements, so the normalized results are cached in LRUs
+// shared by all the UDF instances.
+tbb::concurrent_lru_cache<std::string, std::string>& PostgresSQLCache() {
+  static auto* cache = new tbb::concurrent_lru_cache<std::string, std::string>(
+      NormalizePostgresSQLKey, kNormalizeCacheSize);
+  return *cache;
+}
+
+tbb::concurrent_lru_cache<std::string, std::string>& MySQLCache() {
+  static auto* cache = new tbb::concurrent_lru_cache<std::string, std::string>(
+      NormalizeMySQLKey, kNormalizeCacheSize);
+  return *cache;
+}
+
+}  // namespace
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+void RegisterSQLOpsOrDie(udf::Registry* registry) {
+  CHECK(registry != nullptr);
+  /*****************************************
+   * Scalar UDFs.
+   *****************************************/
+  registry->RegisterOrDie<NormalizePostgresSQLUDF>("normalize_pgsql");
+  registry->RegisterOrDie<NormalizeMySQLUDF>("normalize_mysql");
+  /*****************************************
+   * Aggregate UDFs.
+   *****************************************/
+}
+
+types::StringValue NormalizePostgresSQLUDF::Exec(FunctionContext*, StringValue sql_str,
+                                                 StringValue cmd_code) {
+  return PostgresSQLCache()[absl::StrCat(cmd_code, "\n", sql_str)].value();
+}
+
+types::StringValue NormalizeMySQLUDF::Exec(FunctionContext*, StringValue sql_str,
+                                           Int64Value cmd_code) {
+  return MySQLCache()[absl::StrCat(cmd_code.val, "\n", sql_str)].value();
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
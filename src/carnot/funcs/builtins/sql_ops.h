@@ -38,6 +38,8 @@ static constexpr int64_t kMySQLExecuteCmdCode = 0x17;
 
 class NormalizePostgresSQLUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kParallel = true;
+
   StringValue Exec(FunctionContext*, StringValue sql_str, StringValue cmd_code);
 
   static udf::ScalarUDFDocBuilder Doc() {
@@ -63,6 +65,8 @@ class NormalizePostgresSQLUDF : public udf::ScalarUDF {
 
 class NormalizeMySQLUDF : public udf::ScalarUDF {
  public:
+  static constexpr bool kParallel = true;
+
   StringValue Exec(FunctionContext*, StringValue sql_str, Int64Value cmd_code);
 
   static udf::ScalarUDFDocBuilder Doc() {
@@ -16,8 +16,12 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <cctype>
+#include <cstring>
 #include <string>
 
+#include <absl/strings/ascii.h>
+
 #include "mysql_parser/MySQLLexer.h"
 #include "mysql_parser/MySQLParser.h"
 #include "pgsql_parser/PostgresSQLLexer.h"
@@ -51,6 +55,63 @@ int ParserTypeTraits<pgsql_parser::PostgresSQLParser>::PlaceholderToParamIndex(
   return index - 1;
 }
 
+namespace {
+
+// The statements that take the HasNoConstants fast path. Other statements are left to the parser,
+// which also reports the queries that aren't valid.
+const absl::flat_hash_set<std::string>& FastPathStatements() {
+  static const auto* statements = new absl::flat_hash_set<std::string>{
+      "SELECT", "INSERT", "UPDATE", "DELETE",   "BEGIN", "COMMIT",
+      "START",  "SHOW",   "USE",    "ROLLBACK", "CREATE"};
+  return *statements;
+}
+
+// Keywords that the grammars treat as constants.
+const absl::flat_hash_set<std::string>& ConstantKeywords() {
+  static const auto* keywords =
+      new absl::flat_hash_set<std::string>{"TRUE", "FALSE", "NULL", "UNKNOWN"};
+  return *keywords;
+}
+
+}  // namespace
+
+bool HasNoConstants(std::string_view sql) {
+  bool first_word = true;
+  size_t i = 0;
+  while (i < sql.size()) {
+    auto c = static_cast<unsigned char>(sql[i]);
+    if (std::isalpha(c) || c == '_') {
+      size_t start = i;
+      while (i < sql.size() &&
+             (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_')) {
+        ++i;
+      }
+      // Prefixed strings (e.g. X'ab') are caught by their quote.
+      std::string word = absl::AsciiStrToUpper(sql.substr(start, i - start));
+      if ((first_word && !FastPathStatements().contains(word)) ||
+          ConstantKeywords().contains(word)) {
+        return false;
+      }
+      first_word = false;
+      continue;
+    }
+    if (std::isspace(c)) {
+      ++i;
+      continue;
+    }
+    bool comment_start = i + 1 < sql.size() && ((c == '-' && sql[i + 1] == '-') ||
+                                                (c == '/' && sql[i + 1] == '*'));
+    // Anything else, like digits, quotes, placeholders ('?', '$1', '@var') or comments, is left
+    // to the parser.
+    if (first_word || comment_start || c == '\0' ||
+        std::strchr("*,.;()=<>!+-/%|&~^", c) == nullptr) {
+      return false;
+    }
+    ++i;
+  }
+  return !first_word;
+}
+
 void ParserRuleFragmentListener::enterEveryRule(antlr4::ParserRuleContext* ctx) {
   auto index = ctx->getRuleIndex();
   if (index_to_type_.contains(index)) {
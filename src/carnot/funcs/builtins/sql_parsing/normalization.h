@@ -33,6 +33,7 @@
 #include <numeric>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -218,6 +219,13 @@ class ConstantFragmentHandler : public SQLFragmentHandler {
   }
 };
 
+/**
+ * Checks whether the parser would find nothing to normalize in the query: it is a common statement
+ * made only of keywords, unquoted identifiers and operators, without any literals, placeholders or
+ * comments. Such queries normalize to themselves, so they don't need to be parsed.
+ */
+bool HasNoConstants(std::string_view sql);
+
 /**
  * normalize_sql replaces table names and constants in a sql query with placeholders, inplace.
  * @param sql: Unnormalized SQL query.
@@ -229,6 +237,12 @@ class ConstantFragmentHandler : public SQLFragmentHandler {
 template <typename TParser, typename TLexer, typename TCharStream = antlr4::ANTLRInputStream>
 StatusOr<NormalizeResult> normalize_sql(std::string sql,
                                         const std::vector<std::string>& param_values) {
+  if (param_values.empty() && HasNoConstants(sql)) {
+    NormalizeResult result;
+    result.normalized_query = sql;
+    return result;
+  }
+
   AntlrParser<TParser, TLexer, TCharStream> parser(sql);
   ParserRuleFragmentListener listener({ParserTypeTraits<TParser>::constant_rule_index,
                                        ParserTypeTraits<TParser>::param_placeholder_rule_index},
@@ -34,6 +34,22 @@ namespace carnot {
 namespace builtins {
 namespace sql_parsing {
 
+TEST(HasNoConstants, basic) {
+  EXPECT_TRUE(HasNoConstants("BEGIN;"));
+  EXPECT_TRUE(HasNoConstants("SELECT * FROM test WHERE col1 >= col2"));
+  EXPECT_TRUE(HasNoConstants("select sock.name, count(*) from sock join tag on sock.id=tag.id"));
+  EXPECT_FALSE(HasNoConstants(""));
+  EXPECT_FALSE(HasNoConstants("SELECT 1"));
+  EXPECT_FALSE(HasNoConstants("SELECT * FROM test WHERE prop='abcd'"));
+  EXPECT_FALSE(HasNoConstants("SELECT * FROM test WHERE prop=true"));
+  EXPECT_FALSE(HasNoConstants("SELECT * FROM test WHERE prop=$1"));
+  EXPECT_FALSE(HasNoConstants("SELECT * FROM test WHERE prop=?"));
+  EXPECT_FALSE(HasNoConstants("SELECT * FROM test -- comment"));
+  EXPECT_FALSE(HasNoConstants("CREATE TABLE test (name varchar(20))"));
+  // Unknown statements are left to the parser.
+  EXPECT_FALSE(HasNoConstants("SELEC * FROM test"));
+}
+
 struct NormSQLTestCase {
   std::string input_sql_str;
   std::vector<std::string> input_params;
@@ -133,6 +149,13 @@ INSTANTIATE_TEST_SUITE_P(
                 {"'abcd'", "1234", "'abcd'"},
             },
         },
+        // Statements without constants.
+        NormSQLTestCase{"BEGIN;", {}, NormalizeResult{"BEGIN;", {}}},
+        NormSQLTestCase{
+            "SELECT name FROM test WHERE abcd >= efgh",
+            {},
+            NormalizeResult{"SELECT name FROM test WHERE abcd >= efgh", {}},
+        },
         // INSERT INTO test case.
         NormSQLTestCase{
             R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, E'\\xDEADBEEF'))",
@@ -229,6 +252,13 @@ INSTANTIATE_TEST_SUITE_P(
                 {"'abcd'", "1234", "1.23"},
             },
         },
+        // Statements without constants.
+        NormSQLTestCase{"BEGIN;", {}, NormalizeResult{"BEGIN;", {}}},
+        NormSQLTestCase{
+            "SELECT name FROM test WHERE abcd >= efgh",
+            {},
+            NormalizeResult{"SELECT name FROM test WHERE abcd >= efgh", {}},
+        },
         // INSERT INTO
         NormSQLTestCase{
             R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, X'DEADBEEF'))",
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/string_kernels.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/strip.h>
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+int64_t StringSearcher::Find(const char* data, size_t size) const {
+  size_t k = needle_.size();
+  if (k == 0) {
+    return 0;
+  }
+  if (size < k) {
+    return -1;
+  }
+  if (k == 1) {
+    const void* match = memchr(data, needle_[0], size);
+    return match == nullptr ? -1 : static_cast<const char*>(match) - data;
+  }
+
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i first = _mm_set1_epi8(needle_[0]);
+  const __m128i last = _mm_set1_epi8(needle_[k - 1]);
+  for (; i + k - 1 + 16 <= size; i += 16) {
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + k - 1));
+    uint32_t mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      int bit = __builtin_ctz(mask);
+      if (memcmp(data + i + bit + 1, needle_.data() + 1, k - 2) == 0) {
+        return i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+  // The tail that's too short for a full block (or all of it without SSE2).
+  size_t pos = std::string_view(data + i, size - i).find(needle_);
+  return pos == std::string_view::npos ? -1 : i + pos;
+}
+
+namespace {
+
+const char* ValueData(const arrow::StringArray& arr) {
+  const auto& buffer = arr.value_data();
+  return buffer == nullptr ? nullptr : reinterpret_cast<const char*>(buffer->data());
+}
+
+/**
+ * Calls found(row, pos) for every row of strs that contains the needle, with the position of its
+ * first occurrence. Instead of searching each row on its own, this searches the data buffer of
+ * the whole array and maps the matches back to rows, so rows that can't match cost nothing but
+ * the scan.
+ */
+template <typename TFn>
+void SearchColumn(const arrow::StringArray& strs, std::string_view needle, TFn found) {
+  int64_t n = strs.length();
+  const int32_t* offsets = strs.raw_value_offsets();
+  if (needle.empty()) {
+    for (int64_t i = 0; i < n; ++i) {
+      found(i, 0);
+    }
+    return;
+  }
+  const char* data = ValueData(strs);
+  if (n == 0 || data == nullptr) {
+    return;
+  }
+
+  StringSearcher searcher(needle);
+  int64_t end = offsets[n];
+  int64_t pos = offsets[0];
+  int64_t i = 0;
+  while (i < n) {
+    int64_t match = searcher.Find(data + pos, end - pos);
+    if (match < 0) {
+      return;
+    }
+    match += pos;
+    // Skip the rows that end before the match.
+    while (offsets[i + 1] <= match) {
+      ++i;
+    }
+    if (match + static_cast<int64_t>(needle.size()) <= offsets[i + 1]) {
+      found(i, match - offsets[i]);
+      ++i;
+      pos = offsets[i];
+    } else {
+      // The match runs into the next row, so keep looking in this one.
+      pos = match + 1;
+    }
+  }
+}
+
+// Flips the case of the ascii letters between from and from + 25. The loop is branchless so that
+// it gets vectorized.
+void FlipCase(const char* in, size_t size, uint8_t from, char* out) {
+  for (size_t i = 0; i < size; ++i) {
+    uint8_t c = in[i];
+    out[i] = c ^ (static_cast<uint8_t>(c - from) < 26 ? 0x20 : 0);
+  }
+}
+
+Status FlipCaseKernel(const arrow::StringArray& strs, uint8_t from, arrow::StringBuilder* out) {
+  int64_t n = strs.length();
+  PL_RETURN_IF_ERROR(out->Reserve(n));
+  if (n == 0) {
+    return Status::OK();
+  }
+  const int32_t* offsets = strs.raw_value_offsets();
+  int64_t size = offsets[n] - offsets[0];
+  PL_RETURN_IF_ERROR(out->ReserveData(size));
+
+  // Convert the data of all the rows at once, then slice the rows out of it.
+  std::string converted(size, '\0');
+  if (size > 0) {
+    FlipCase(ValueData(strs) + offsets[0], size, from, converted.data());
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    out->UnsafeAppend(converted.data() + offsets[i] - offsets[0], offsets[i + 1] - offsets[i]);
+  }
+  return Status::OK();
+}
+
+template <typename TFn>
+Status AppendViews(const arrow::StringArray& strs, arrow::StringBuilder* out, TFn fn) {
+  int64_t n = strs.length();
+  PL_RETURN_IF_ERROR(out->Reserve(n));
+  if (n > 0) {
+    // The results are never longer than the inputs.
+    PL_RETURN_IF_ERROR(out->ReserveData(strs.value_offset(n) - strs.value_offset(0)));
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    std::string_view result = fn(i);
+    out->UnsafeAppend(result.data(), result.size());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+bool IsConstant(const arrow::StringArray& arr) {
+  int64_t n = arr.length();
+  if (n < 2) {
+    return true;
+  }
+  std::string_view first = arr.GetView(0);
+  for (int64_t i = 1; i < n; ++i) {
+    if (arr.GetView(i) != first) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ContainsKernel(const arrow::StringArray& strs, const arrow::StringArray& substrs,
+                    uint8_t* out) {
+  int64_t n = strs.length();
+  if (IsConstant(substrs)) {
+    std::fill(out, out + n, 0);
+    if (n > 0) {
+      SearchColumn(strs, substrs.GetView(0), [out](int64_t i, int64_t) { out[i] = 1; });
+    }
+    return;
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = strs.GetView(i).find(substrs.GetView(i)) != std::string_view::npos;
+  }
+}
+
+void FindKernel(const arrow::StringArray& strs, const arrow::StringArray& substrs, int64_t* out) {
+  int64_t n = strs.length();
+  if (IsConstant(substrs)) {
+    std::fill(out, out + n, -1);
+    if (n > 0) {
+      SearchColumn(strs, substrs.GetView(0), [out](int64_t i, int64_t pos) { out[i] = pos; });
+    }
+    return;
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = static_cast<int64_t>(strs.GetView(i).find(substrs.GetView(i)));
+  }
+}
+
+void LengthKernel(const arrow::StringArray& strs, int64_t* out) {
+  const int32_t* offsets = strs.raw_value_offsets();
+  for (int64_t i = 0; i < strs.length(); ++i) {
+    out[i] = offsets[i + 1] - offsets[i];
+  }
+}
+
+Status ToLowerKernel(const arrow::StringArray& strs, arrow::StringBuilder* out) {
+  return FlipCaseKernel(strs, 'A', out);
+}
+
+Status ToUpperKernel(const arrow::StringArray& strs, arrow::StringBuilder* out) {
+  return FlipCaseKernel(strs, 'a', out);
+}
+
+Status TrimKernel(const arrow::StringArray& strs, arrow::StringBuilder* out) {
+  return AppendViews(strs, out,
+                     [&strs](int64_t i) { return absl::StripAsciiWhitespace(strs.GetView(i)); });
+}
+
+Status StripPrefixKernel(const arrow::StringArray& prefixes, const arrow::StringArray& strs,
+                         arrow::StringBuilder* out) {
+  return AppendViews(strs, out, [&](int64_t i) {
+    return absl::StripPrefix(strs.GetView(i), prefixes.GetView(i));
+  });
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
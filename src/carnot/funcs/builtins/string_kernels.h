@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/builder.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+/**
+ * StringSearcher finds a fixed needle in strings. On x86 it compares 16 positions at a time
+ * against the first and the last byte of the needle, and only compares the whole needle where
+ * both match, which skips most of the haystack at the speed of a memchr.
+ */
+class StringSearcher {
+ public:
+  explicit StringSearcher(std::string_view needle) : needle_(needle) {}
+
+  /**
+   * @return the position of the first occurrence of the needle in [data, data + size), or -1.
+   */
+  int64_t Find(const char* data, size_t size) const;
+
+ private:
+  std::string needle_;
+};
+
+/**
+ * The string kernels below run over arrow string arrays, reading the offsets and the data
+ * buffers directly. Arguments that are single strings per row (needles, prefixes) are usually
+ * constants broadcast over the batch, and the kernels take a faster path when they are.
+ */
+
+/**
+ * @return whether every row of the array holds the same string.
+ */
+bool IsConstant(const arrow::StringArray& arr);
+
+/**
+ * Writes whether each row of strs contains the matching row of substrs (one byte per row).
+ * With a constant substring, the whole data buffer of strs is searched at once.
+ */
+void ContainsKernel(const arrow::StringArray& strs, const arrow::StringArray& substrs,
+                    uint8_t* out);
+
+/**
+ * Writes the position of the first occurrence of each row of substrs in the matching row of
+ * strs, or -1.
+ */
+void FindKernel(const arrow::StringArray& strs, const arrow::StringArray& substrs, int64_t* out);
+
+void LengthKernel(const arrow::StringArray& strs, int64_t* out);
+
+/**
+ * Appends each row with its ascii letters converted to lower (or upper) case.
+ */
+Status ToLowerKernel(const arrow::StringArray& strs, arrow::StringBuilder* out);
+Status ToUpperKernel(const arrow::StringArray& strs, arrow::StringBuilder* out);
+
+/**
+ * Appends each row with its leading and trailing ascii whitespace removed.
+ */
+Status TrimKernel(const arrow::StringArray& strs, arrow::StringBuilder* out);
+
+/**
+ * Appends each row of strs with the matching row of prefixes removed from its front, if present.
+ */
+Status StripPrefixKernel(const arrow::StringArray& prefixes, const arrow::StringArray& strs,
+                         arrow::StringBuilder* out);
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
+
+#include "src/carnot/funcs/builtins/string_kernels.h"
+#include "src/common/benchmark/benchmark.h"
+#include "src/shared/types/arrow_adapter.h"
+
+using px::carnot::builtins::ContainsKernel;
+
+// Request paths where about 1 in 10 is under /api.
+std::shared_ptr<arrow::StringArray> RequestPaths(int size) {
+  std::mt19937 gen(37);
+  std::uniform_int_distribution<int> dist(0, 9);
+  std::vector<px::types::StringValue> paths(size);
+  for (int i = 0; i < size; ++i) {
+    int r = dist(gen);
+    paths[i] = absl::StrCat(r == 0 ? "/api" : "/static", "/v", r, "/assets/", i, "/index.html");
+  }
+  return std::static_pointer_cast<arrow::StringArray>(
+      px::types::ToArrow(paths, arrow::default_memory_pool()));
+}
+
+std::shared_ptr<arrow::StringArray> Broadcast(const std::string& str, int size) {
+  std::vector<px::types::StringValue> values(size, str);
+  return std::static_pointer_cast<arrow::StringArray>(
+      px::types::ToArrow(values, arrow::default_memory_pool()));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ContainsPerRow(benchmark::State& state) {
+  auto paths = RequestPaths(state.range(0));
+  auto needles = Broadcast("/api", state.range(0));
+  std::vector<uint8_t> out(paths->length());
+  for (auto _ : state) {
+    for (int64_t i = 0; i < paths->length(); ++i) {
+      out[i] = absl::StrContains(paths->GetString(i), needles->GetString(i));
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * paths->value_data()->size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ContainsKernel(benchmark::State& state) {
+  auto paths = RequestPaths(state.range(0));
+  auto needles = Broadcast("/api", state.range(0));
+  std::vector<uint8_t> out(paths->length());
+  for (auto _ : state) {
+    ContainsKernel(*paths, *needles, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * paths->value_data()->size());
+}
+
+BENCHMARK(BM_ContainsPerRow)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_ContainsKernel)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/string_kernels.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+namespace {
+
+std::shared_ptr<arrow::StringArray> MakeStrings(const std::vector<std::string>& strs) {
+  std::vector<types::StringValue> values(strs.begin(), strs.end());
+  return std::static_pointer_cast<arrow::StringArray>(
+      types::ToArrow(values, arrow::default_memory_pool()));
+}
+
+std::vector<std::string> Finish(arrow::StringBuilder* builder) {
+  std::shared_ptr<arrow::Array> arr;
+  EXPECT_TRUE(builder->Finish(&arr).ok());
+  auto* strs = static_cast<arrow::StringArray*>(arr.get());
+  std::vector<std::string> out;
+  for (int64_t i = 0; i < strs->length(); ++i) {
+    out.push_back(strs->GetString(i));
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(StringSearcher, find) {
+  // Long enough haystacks to go through the block search, with and without a tail.
+  std::string haystack = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaab/api/aaaaaaaaaaaaaaaaaaaaaaaaaaaaa/apix";
+  for (std::string needle : {"/api", "/apix", "b", "ab/", "/ap", "a", "aaaaaaaaaaaaaaaaaaaaaaaaa",
+                             "/apiy", "z", "", "x"}) {
+    for (size_t begin = 0; begin < haystack.size(); ++begin) {
+      std::string_view hay = std::string_view(haystack).substr(begin);
+      size_t expected = hay.find(needle);
+      EXPECT_EQ(expected == std::string_view::npos ? -1 : static_cast<int64_t>(expected),
+                StringSearcher(needle).Find(hay.data(), hay.size()))
+          << needle << " in " << hay;
+    }
+  }
+}
+
+TEST(StringKernels, contains_and_find_constant) {
+  auto strs = MakeStrings({"/api/v1", "", "/pi", "xx/ap", "i/api", "/apapi/api", "/a", "pi/api"});
+  auto needles = MakeStrings(std::vector<std::string>(strs->length(), "/api"));
+  ASSERT_TRUE(IsConstant(*needles));
+
+  std::vector<uint8_t> contains(strs->length());
+  ContainsKernel(*strs, *needles, contains.data());
+  std::vector<int64_t> positions(strs->length());
+  FindKernel(*strs, *needles, positions.data());
+
+  // A match that would span "xx/ap" and "i/api" must not count for the first of them.
+  EXPECT_EQ(std::vector<uint8_t>({1, 0, 0, 0, 1, 1, 0, 1}), contains);
+  EXPECT_EQ(std::vector<int64_t>({0, -1, -1, -1, 1, 6, -1, 2}), positions);
+}
+
+TEST(StringKernels, contains_sliced) {
+  auto strs = MakeStrings({"/api", "nope", "a/api", "/api"});
+  auto sliced = std::static_pointer_cast<arrow::StringArray>(strs->Slice(1, 2));
+  auto needles = MakeStrings({"/api", "/api"});
+
+  std::vector<uint8_t> contains(2);
+  ContainsKernel(*sliced, *needles, contains.data());
+  EXPECT_EQ(std::vector<uint8_t>({0, 1}), contains);
+}
+
+TEST(StringKernels, contains_and_find_per_row) {
+  auto strs = MakeStrings({"apple", "banana", "cherry", ""});
+  auto needles = MakeStrings({"pl", "x", "rr", ""});
+  ASSERT_FALSE(IsConstant(*needles));
+
+  std::vector<uint8_t> contains(strs->length());
+  ContainsKernel(*strs, *needles, contains.data());
+  EXPECT_EQ(std::vector<uint8_t>({1, 0, 1, 1}), contains);
+
+  std::vector<int64_t> positions(strs->length());
+  FindKernel(*strs, *needles, positions.data());
+  EXPECT_EQ(std::vector<int64_t>({2, -1, 2, 0}), positions);
+}
+
+TEST(StringKernels, empty_needle) {
+  auto strs = MakeStrings({"abc", ""});
+  auto needles = MakeStrings({"", ""});
+  std::vector<uint8_t> contains(2);
+  ContainsKernel(*strs, *needles, contains.data());
+  EXPECT_EQ(std::vector<uint8_t>({1, 1}), contains);
+}
+
+TEST(StringKernels, length) {
+  auto strs = MakeStrings({"abc", "", "de"});
+  std::vector<int64_t> lengths(3);
+  LengthKernel(*strs, lengths.data());
+  EXPECT_EQ(std::vector<int64_t>({3, 0, 2}), lengths);
+}
+
+TEST(StringKernels, case_conversion) {
+  auto strs = MakeStrings({"Kelvin", "", "PEM-1_@[`{z", "\xc3\x89t\xc3\xa9"});
+  arrow::StringBuilder lower;
+  EXPECT_OK(ToLowerKernel(*strs, &lower));
+  EXPECT_EQ(std::vector<std::string>({"kelvin", "", "pem-1_@[`{z", "\xc3\x89t\xc3\xa9"}),
+            Finish(&lower));
+
+  arrow::StringBuilder upper;
+  EXPECT_OK(ToUpperKernel(*strs, &upper));
+  EXPECT_EQ(std::vector<std::string>({"KELVIN", "", "PEM-1_@[`{Z", "\xc3\x89T\xc3\xa9"}),
+            Finish(&upper));
+}
+
+TEST(StringKernels, trim_and_strip_prefix) {
+  auto strs = MakeStrings({"  pl/kelvin ", "\tpl/pem\n", "", "kelvin"});
+  arrow::StringBuilder trimmed;
+  EXPECT_OK(TrimKernel(*strs, &trimmed));
+  EXPECT_EQ(std::vector<std::string>({"pl/kelvin", "pl/pem", "", "kelvin"}), Finish(&trimmed));
+
+  auto svcs = MakeStrings({"pl/kelvin", "pl/pem", "", "kelvin"});
+  auto prefixes = MakeStrings(std::vector<std::string>(4, "pl/"));
+  arrow::StringBuilder stripped;
+  EXPECT_OK(StripPrefixKernel(*prefixes, *svcs, &stripped));
+  EXPECT_EQ(std::vector<std::string>({"kelvin", "pem", "", "kelvin"}), Finish(&stripped));
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
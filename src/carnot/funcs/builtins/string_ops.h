@@ -21,6 +21,8 @@
 #include <absl/strings/strip.h>
 #include <algorithm>
 #include <string>
+#include <vector>
+#include "src/carnot/funcs/builtins/string_kernels.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
@@ -34,6 +36,13 @@ class ContainsUDF : public udf::ScalarUDF {
   BoolValue Exec(FunctionContext*, StringValue b1, StringValue b2) {
     return absl::StrContains(b1, b2);
   }
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& b1, const arrow::StringArray& b2,
+                   arrow::BooleanBuilder* out) {
+    std::vector<uint8_t> results(b1.length());
+    ContainsKernel(b1, b2, results.data());
+    PL_RETURN_IF_ERROR(out->AppendValues(results.data(), results.size()));
+    return Status::OK();
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the first string contains the second string.")
@@ -47,6 +56,12 @@ class ContainsUDF : public udf::ScalarUDF {
 class LengthUDF : public udf::ScalarUDF {
  public:
   Int64Value Exec(FunctionContext*, StringValue b1) { return b1.length(); }
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& b1, arrow::Int64Builder* out) {
+    std::vector<int64_t> results(b1.length());
+    LengthKernel(b1, results.data());
+    PL_RETURN_IF_ERROR(out->AppendValues(results.data(), results.size()));
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns the length of the string")
         .Example(R"doc(df.service = 'checkout'
@@ -62,6 +77,13 @@ class FindUDF : public udf::ScalarUDF {
   Int64Value Exec(FunctionContext*, StringValue src, StringValue substr) {
     return src.find(substr);
   }
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& src,
+                   const arrow::StringArray& substr, arrow::Int64Builder* out) {
+    std::vector<int64_t> results(src.length());
+    FindKernel(src, substr, results.data());
+    PL_RETURN_IF_ERROR(out->AppendValues(results.data(), results.size()));
+    return Status::OK();
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Find the index of the first occurrence of the substring.")
@@ -108,6 +130,9 @@ class ToLowerUDF : public udf::ScalarUDF {
     transform(b1.begin(), b1.end(), b1.begin(), ::tolower);
     return b1;
   }
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& b1, arrow::StringBuilder* out) {
+    return ToLowerKernel(b1, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Transforms all uppercase ascii characters in the string to lowercase.")
@@ -125,6 +150,9 @@ class ToUpperUDF : public udf::ScalarUDF {
     transform(b1.begin(), b1.end(), b1.begin(), ::toupper);
     return b1;
   }
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& b1, arrow::StringBuilder* out) {
+    return ToUpperKernel(b1, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Transforms all lowercase ascii characters in the string to uppercase.")
@@ -143,6 +171,9 @@ class TrimUDF : public udf::ScalarUDF {
     absl::StripAsciiWhitespace(&val);
     return val;
   }
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& s, arrow::StringBuilder* out) {
+    return TrimKernel(s, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Trim ascii whitespace from before and after the string content.")
@@ -162,6 +193,10 @@ class StripPrefixUDF : public udf::ScalarUDF {
   StringValue Exec(FunctionContext*, StringValue prefix, StringValue s) {
     return StringValue(absl::StripPrefix(s, prefix));
   }
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& prefix, const arrow::StringArray& s,
+                   arrow::StringBuilder* out) {
+    return StripPrefixKernel(prefix, s, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Strips the specified prefix from the string.")
         .Details(
@@ -18,21 +18,57 @@
 
 #include <string>
 
+#include <absl/strings/match.h>
+#include <rapidjson/document.h>
+
 #include "src/carnot/funcs/http/http_ops.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
+#include "src/shared/http_headers/header_encoding.h"
 
 namespace px {
 namespace carnot {
 namespace funcs {
 namespace http {
 
+namespace internal {
+
+std::string HTTPHeaderValue(std::string_view headers, std::string_view name) {
+  if (http_headers::IsCompactHeaders(headers)) {
+    return std::string(http_headers::FindHeader(headers, name).value_or(""));
+  }
+
+  rapidjson::Document doc;
+  doc.Parse(headers.data(), headers.size());
+  if (doc.HasParseError() || !doc.IsObject()) {
+    return "";
+  }
+  for (const auto& member : doc.GetObject()) {
+    std::string_view member_name(member.name.GetString(), member.name.GetStringLength());
+    if (member.value.IsString() && absl::EqualsIgnoreCase(member_name, name)) {
+      return std::string(member.value.GetString(), member.value.GetStringLength());
+    }
+  }
+  return "";
+}
+
+std::string HTTPHeadersToJSON(std::string_view headers) {
+  if (!http_headers::IsCompactHeaders(headers)) {
+    return std::string(headers);
+  }
+  return http_headers::CompactHeadersToJSON(headers);
+}
+
+}  // namespace internal
+
 void RegisterHTTPOpsOrDie(px::carnot::udf::Registry* registry) {
   CHECK(registry != nullptr);
   /*****************************************
    * Scalar UDFs.
    *****************************************/
   registry->RegisterOrDie<HTTPRespMessageUDF>("http_resp_message");
+  registry->RegisterOrDie<HTTPHeaderUDF>("http_header");
+  registry->RegisterOrDie<HTTPHeadersJSONUDF>("http_headers_json");
 
   /*****************************************
    * Aggregate UDFs.
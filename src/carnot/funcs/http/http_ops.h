@@ -19,6 +19,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "src/carnot/funcs/http/http.h"
 #include "src/carnot/udf/registry.h"
@@ -30,6 +31,17 @@ namespace carnot {
 namespace funcs {
 namespace http {
 
+namespace internal {
+
+// Returns the value of the header in either the JSON or the compact form of the header columns,
+// or an empty string if there is no such header.
+std::string HTTPHeaderValue(std::string_view headers, std::string_view name);
+
+// Returns the headers as a JSON object. JSON headers are returned as is.
+std::string HTTPHeadersToJSON(std::string_view headers);
+
+}  // namespace internal
+
 class HTTPRespMessageUDF : public px::carnot::udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, Int64Value resp_code) {
@@ -45,6 +57,44 @@ class HTTPRespMessageUDF : public px::carnot::udf::ScalarUDF {
   }
 };
 
+class HTTPHeaderUDF : public px::carnot::udf::ScalarUDF {
+ public:
+  StringValue Exec(FunctionContext*, StringValue headers, StringValue name) {
+    return internal::HTTPHeaderValue(headers, name);
+  }
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder("Get the value of an HTTP header.")
+        .Details(
+            "Finds a header in the req_headers or resp_headers columns of http_events. The name "
+            "is compared case-insensitively. Works on both the JSON and the compact form of the "
+            "headers, and reads the compact form without decoding the other headers. If the "
+            "header is not found, an empty string is returned.")
+        .Arg("headers", "The headers, as stored in the req_headers or resp_headers column.")
+        .Arg("name", "The name of the header (e.g. 'Content-Type').")
+        .Example("df.content_type = px.http_header(df.resp_headers, 'Content-Type')")
+        .Returns("The value of the header.");
+  }
+};
+
+class HTTPHeadersJSONUDF : public px::carnot::udf::ScalarUDF {
+ public:
+  StringValue Exec(FunctionContext*, StringValue headers) {
+    return internal::HTTPHeadersToJSON(headers);
+  }
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder("Convert HTTP headers to JSON.")
+        .Details(
+            "Converts the compact form of the req_headers or resp_headers columns of "
+            "http_events to a JSON object, for display. Headers already in JSON are returned "
+            "unchanged.")
+        .Arg("headers", "The headers, as stored in the req_headers or resp_headers column.")
+        .Example("df.req_headers = px.http_headers_json(df.req_headers)")
+        .Returns("The headers as a JSON object.");
+  }
+};
+
 void RegisterHTTPOpsOrDie(px::carnot::udf::Registry* registry);
 
 }  // namespace http
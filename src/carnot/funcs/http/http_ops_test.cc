@@ -18,9 +18,13 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
+#include <string>
+
 #include "src/carnot/funcs/http/http_ops.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
+#include "src/shared/http_headers/header_encoding.h"
 
 namespace px {
 namespace carnot {
@@ -33,6 +37,30 @@ TEST(HTTPOps, basic) {
   udf_tester.ForInput(0).Expect("Unassigned");
 }
 
+TEST(HTTPOps, header) {
+  std::string compact = http_headers::EncodeHeaders(
+      std::map<std::string, std::string>{{"Content-Type", "text/plain"}, {"X-Custom", "a"}}, 1024);
+  std::string json = R"({"Content-Type":"text/plain","X-Custom":"a"})";
+
+  auto udf_tester = udf::UDFTester<HTTPHeaderUDF>();
+  udf_tester.ForInput(compact, "content-type").Expect("text/plain");
+  udf_tester.ForInput(compact, "x-custom").Expect("a");
+  udf_tester.ForInput(compact, "host").Expect("");
+  udf_tester.ForInput(json, "content-type").Expect("text/plain");
+  udf_tester.ForInput(json, "X-Custom").Expect("a");
+  udf_tester.ForInput(json, "host").Expect("");
+  udf_tester.ForInput("not json", "host").Expect("");
+}
+
+TEST(HTTPOps, headers_json) {
+  std::string compact = http_headers::EncodeHeaders(
+      std::map<std::string, std::string>{{"Content-Type", "text/plain"}, {"X-Custom", "a"}}, 1024);
+
+  auto udf_tester = udf::UDFTester<HTTPHeadersJSONUDF>();
+  udf_tester.ForInput(compact).Expect(R"({"content-type":"text/plain","X-Custom":"a"})");
+  udf_tester.ForInput(R"({"Host":"a"})").Expect(R"({"Host":"a"})");
+}
+
 }  // namespace http
 }  // namespace funcs
 }  // namespace carnot
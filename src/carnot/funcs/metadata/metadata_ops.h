@@ -99,6 +99,8 @@ class UPIDToASIDUDF : public ScalarUDF {
 
 class PodIDToPodNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
 
@@ -123,6 +125,8 @@ class PodIDToPodNameUDF : public ScalarUDF {
 
 class PodNameToPodIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
     return GetPodID(md, pod_name);
@@ -146,6 +150,8 @@ class PodNameToPodIDUDF : public ScalarUDF {
 
 class PodNameToPodIPUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
     StringValue pod_id = PodNameToPodIDUDF::GetPodID(md, pod_name);
@@ -167,6 +173,8 @@ class PodNameToPodIPUDF : public ScalarUDF {
 
 class PodIDToNamespaceUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
 
@@ -213,6 +221,8 @@ class PodNameToNamespaceUDF : public ScalarUDF {
 
 class UPIDToContainerIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
 
@@ -254,6 +264,8 @@ inline const md::ContainerInfo* UPIDToContainer(const px::md::AgentMetadataState
 
 class UPIDToContainerNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto container_info = UPIDToContainer(md, upid_value);
@@ -313,6 +325,8 @@ inline types::StringValue StringifyVector(const std::vector<std::string>& vec) {
 
 class UPIDToNamespaceUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto pod_info = UPIDtoPod(md, upid_value);
@@ -345,6 +359,8 @@ class UPIDToNamespaceUDF : public ScalarUDF {
 
 class UPIDToPodIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto container_info = UPIDToContainer(md, upid_value);
@@ -372,6 +388,8 @@ class UPIDToPodIDUDF : public ScalarUDF {
 
 class UPIDToPodNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto pod_info = UPIDtoPod(md, upid_value);
@@ -403,6 +421,8 @@ class UPIDToPodNameUDF : public ScalarUDF {
 
 class ServiceIDToServiceNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue service_id) {
     auto md = GetMetadataState(ctx);
 
@@ -431,6 +451,8 @@ class ServiceIDToServiceNameUDF : public ScalarUDF {
 
 class ServiceNameToServiceIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue service_name) {
     auto md = GetMetadataState(ctx);
     // This UDF expects the service name to be in the format of "<ns>/<service-name>".
@@ -483,6 +505,8 @@ class ServiceNameToNamespaceUDF : public ScalarUDF {
  */
 class UPIDToServiceIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto pod_info = UPIDtoPod(md, upid_value);
@@ -525,6 +549,8 @@ class UPIDToServiceIDUDF : public ScalarUDF {
  */
 class UPIDToServiceNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto pod_info = UPIDtoPod(md, upid_value);
@@ -571,6 +597,8 @@ class UPIDToServiceNameUDF : public ScalarUDF {
  */
 class UPIDToNodeNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto pod_info = UPIDtoPod(md, upid_value);
@@ -603,6 +631,8 @@ class UPIDToNodeNameUDF : public ScalarUDF {
  */
 class UPIDToHostnameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
     auto pod_info = UPIDtoPod(md, upid_value);
@@ -631,6 +661,8 @@ class UPIDToHostnameUDF : public ScalarUDF {
  */
 class PodIDToServiceNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
 
@@ -673,6 +705,8 @@ class PodIDToServiceNameUDF : public ScalarUDF {
  */
 class PodIDToServiceIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
 
@@ -709,6 +743,8 @@ class PodIDToServiceIDUDF : public ScalarUDF {
  */
 class PodIDToNodeNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
 
@@ -738,6 +774,8 @@ class PodIDToNodeNameUDF : public ScalarUDF {
  */
 class PodNameToServiceNameUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
 
@@ -784,6 +822,8 @@ class PodNameToServiceNameUDF : public ScalarUDF {
  */
 class PodNameToServiceIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
 
@@ -863,6 +903,8 @@ class UPIDToPIDUDF : public ScalarUDF {
 
 class PodIDToPodStartTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
     const px::md::PodInfo* pod_info = md->k8s_metadata_state().PodInfoByID(pod_id);
@@ -882,6 +924,8 @@ class PodIDToPodStartTimeUDF : public ScalarUDF {
 
 class PodIDToPodStopTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
     const px::md::PodInfo* pod_info = md->k8s_metadata_state().PodInfoByID(pod_id);
@@ -901,6 +945,8 @@ class PodIDToPodStopTimeUDF : public ScalarUDF {
 
 class PodNameToPodStartTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
     StringValue pod_id = PodNameToPodIDUDF::GetPodID(md, pod_name);
@@ -921,6 +967,8 @@ class PodNameToPodStartTimeUDF : public ScalarUDF {
 
 class PodNameToPodStopTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
     StringValue pod_id = PodNameToPodIDUDF::GetPodID(md, pod_name);
@@ -941,6 +989,8 @@ class PodNameToPodStopTimeUDF : public ScalarUDF {
 
 class ContainerNameToContainerIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue container_name) {
     auto md = GetMetadataState(ctx);
     return md->k8s_metadata_state().ContainerIDByName(container_name);
@@ -957,6 +1007,8 @@ class ContainerNameToContainerIDUDF : public ScalarUDF {
 
 class ContainerIDToContainerStartTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue container_id) {
     auto md = GetMetadataState(ctx);
     const px::md::ContainerInfo* container_info =
@@ -979,6 +1031,8 @@ class ContainerIDToContainerStartTimeUDF : public ScalarUDF {
 
 class ContainerIDToContainerStopTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue container_id) {
     auto md = GetMetadataState(ctx);
     const px::md::ContainerInfo* container_info =
@@ -1001,6 +1055,8 @@ class ContainerIDToContainerStopTimeUDF : public ScalarUDF {
 
 class ContainerNameToContainerStartTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue container_name) {
     auto md = GetMetadataState(ctx);
     StringValue container_id = md->k8s_metadata_state().ContainerIDByName(container_name);
@@ -1023,6 +1079,8 @@ class ContainerNameToContainerStartTimeUDF : public ScalarUDF {
 
 class ContainerNameToContainerStopTimeUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   Time64NSValue Exec(FunctionContext* ctx, StringValue container_name) {
     auto md = GetMetadataState(ctx);
     StringValue container_id = md->k8s_metadata_state().ContainerIDByName(container_name);
@@ -1090,6 +1148,8 @@ inline types::StringValue PodInfoToPodStatus(const px::md::PodInfo* pod_info) {
 
 class PodNameToPodStatusUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the Pod status for a passed in pod.
    *
@@ -1126,6 +1186,8 @@ class PodNameToPodStatusUDF : public ScalarUDF {
 
 class PodNameToPodReadyUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   BoolValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
     StringValue pod_id = PodNameToPodIDUDF::GetPodID(md, pod_name);
@@ -1159,6 +1221,8 @@ class PodNameToPodReadyUDF : public ScalarUDF {
 
 class PodNameToPodStatusMessageUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the Pod status message for a passed in pod.
    *
@@ -1179,6 +1243,8 @@ class PodNameToPodStatusMessageUDF : public ScalarUDF {
 
 class PodNameToPodStatusReasonUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the Pod status reason for a passed in pod.
    *
@@ -1213,6 +1279,8 @@ inline std::string ContainerStateToString(const px::md::ContainerState& containe
 
 class ContainerIDToContainerStatusUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the Container status for a passed in container.
    *
@@ -1263,6 +1331,8 @@ class ContainerIDToContainerStatusUDF : public ScalarUDF {
 
 class UPIDToPodStatusUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the Pod status for a passed in UPID.
    *
@@ -1302,6 +1372,8 @@ class UPIDToPodStatusUDF : public ScalarUDF {
 
 class UPIDToCmdLineUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the cmdline for the upid.
    *
@@ -1343,6 +1415,8 @@ inline std::string PodInfoToPodQoS(const px::md::PodInfo* pod_info) {
 
 class UPIDToPodQoSUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the qos for the upid's pod.
    *
@@ -1410,6 +1484,8 @@ class HostNumCPUsUDF : public ScalarUDF {
 
 class PodIPToPodIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   /**
    * @brief Gets the pod id of pod with given pod_ip
    */
@@ -1443,6 +1519,8 @@ class PodIPToPodIDUDF : public ScalarUDF {
 
 class PodIPToServiceIDUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
   StringValue Exec(FunctionContext* ctx, StringValue pod_ip) {
     auto md = GetMetadataState(ctx);
     auto pod_id = md->k8s_metadata_state().PodIDByIP(pod_ip);
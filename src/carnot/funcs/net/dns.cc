@@ -0,0 +1,177 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/net/dns.h"
+
+#include <cstring>
+#include <utility>
+
+DEFINE_int32(carnot_dns_lookup_timeout_ms,
+             gflags::Int32FromEnv("PL_CARNOT_DNS_LOOKUP_TIMEOUT_MS", 250),
+             "How long a batch of nslookup calls waits for uncached addresses to resolve before "
+             "returning the addresses themselves.");
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+StatusOr<std::string> DNSLookup(const std::string& addr) {
+  struct sockaddr_in sa;
+
+  char node[kMaxHostnameSize];
+
+  memset(&sa, 0, sizeof sa);
+  sa.sin_family = AF_INET;
+
+  inet_pton(AF_INET, addr.c_str(), &sa.sin_addr);
+
+  int res =
+      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
+
+  if (res == EAI_NONAME) {
+    return error::NotFound("No hostname for $0", addr);
+  }
+  if (res) {
+    return error::Internal("$0", gai_strerror(res));
+  }
+  return std::string(node);
+}
+
+DNSCache& DNSCache::GetInstance() {
+  // Never destroyed, so that exiting doesn't wait on resolver threads stuck in getnameinfo.
+  static DNSCache* cache = new DNSCache(DNSLookup, Options());
+  return *cache;
+}
+
+DNSCache::DNSCache(LookupFn lookup_fn, const Options& options)
+    : lookup_fn_(std::move(lookup_fn)), options_(options) {
+  for (int i = 0; i < options_.num_threads; ++i) {
+    threads_.emplace_back(&DNSCache::RunResolver, this);
+  }
+}
+
+DNSCache::~DNSCache() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopped_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void DNSCache::Enqueue(std::string_view addr) {
+  // During a resolver outage the queue could otherwise grow with every new address.
+  if (queue_.size() >= options_.max_entries || pending_.contains(addr)) {
+    return;
+  }
+  pending_.emplace(addr);
+  queue_.emplace_back(addr);
+  queue_cv_.notify_one();
+}
+
+void DNSCache::Resolve(const std::vector<std::string_view>& addrs,
+                       std::chrono::milliseconds timeout) {
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::string_view> uncached;
+  std::unique_lock<std::mutex> lock(mu_);
+  for (auto addr : addrs) {
+    auto it = entries_.find(addr);
+    if (it == entries_.end()) {
+      uncached.push_back(addr);
+      Enqueue(addr);
+    } else if (it->second.expiry <= now) {
+      Enqueue(addr);
+    }
+  }
+  resolved_cv_.wait_until(lock, now + timeout, [&] {
+    for (auto addr : uncached) {
+      if (pending_.contains(addr)) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
+std::string DNSCache::Lookup(std::string_view addr) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = entries_.find(addr);
+  if (it == entries_.end()) {
+    Enqueue(addr);
+    return std::string(addr);
+  }
+  if (it->second.expiry <= std::chrono::steady_clock::now()) {
+    Enqueue(addr);
+  }
+  lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+  return it->second.hostname;
+}
+
+void DNSCache::RunResolver() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    queue_cv_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+    if (stopped_) {
+      return;
+    }
+    std::string addr = std::move(queue_.front());
+    queue_.pop_front();
+
+    lock.unlock();
+    auto hostname_or_s = lookup_fn_(addr);
+    lock.lock();
+
+    // Keep the same results as the blocking lookups used to show: the address itself if it has
+    // no name, and the error for failed lookups.
+    std::string hostname;
+    auto ttl = options_.negative_ttl;
+    if (hostname_or_s.ok()) {
+      hostname = hostname_or_s.ConsumeValueOrDie();
+      ttl = options_.positive_ttl;
+    } else if (error::IsNotFound(hostname_or_s.status())) {
+      hostname = addr;
+    } else {
+      hostname = hostname_or_s.msg();
+    }
+
+    auto [it, inserted] = entries_.try_emplace(addr);
+    if (inserted) {
+      lru_.push_front(addr);
+      it->second.lru_it = lru_.begin();
+    }
+    it->second.hostname = std::move(hostname);
+    it->second.expiry = std::chrono::steady_clock::now() + ttl;
+    while (entries_.size() > options_.max_entries) {
+      entries_.erase(lru_.back());
+      lru_.pop_back();
+    }
+
+    pending_.erase(addr);
+    resolved_cv_.notify_all();
+  }
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
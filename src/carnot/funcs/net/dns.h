@@ -18,10 +18,26 @@
 
 #pragma once
 
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-#define TBB_PREVIEW_CONCURRENT_LRU_CACHE 1
-#include "tbb/concurrent_lru_cache.h"
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_int32(carnot_dns_lookup_timeout_ms);
 
 namespace px {
 namespace carnot {
@@ -31,40 +47,77 @@ namespace internal {
 
 constexpr size_t kMaxHostnameSize = 512;
 constexpr size_t kLRUCacheSize = 1024;
+constexpr int kNumResolverThreads = 4;
+constexpr std::chrono::seconds kPositiveTTL{300};
+constexpr std::chrono::seconds kNegativeTTL{30};
 
-inline std::string DNSLookup(const std::string& addr) {
-  struct sockaddr_in sa;
-
-  char node[kMaxHostnameSize];
+/**
+ * Looks up the hostname of an IPv4 address, with a blocking getnameinfo.
+ * @return the hostname, NotFound if the address has no name, or an error if the lookup failed.
+ */
+StatusOr<std::string> DNSLookup(const std::string& addr);
 
-  memset(&sa, 0, sizeof sa);
-  sa.sin_family = AF_INET;
+/**
+ * DNSCache resolves addresses on a small pool of resolver threads, so query execution never
+ * blocks on a slow or unreachable DNS server for longer than the time budget it asks for.
+ *
+ * Resolved names are cached for kPositiveTTL, and failed lookups for kNegativeTTL, in an LRU
+ * of at most kLRUCacheSize addresses. Expired entries keep being served while they are
+ * re-resolved in the background.
+ */
+class DNSCache : public NotCopyable {
+ public:
+  using LookupFn = std::function<StatusOr<std::string>(const std::string&)>;
 
-  inet_pton(AF_INET, addr.c_str(), &sa.sin_addr);
+  struct Options {
+    size_t max_entries = kLRUCacheSize;
+    int num_threads = kNumResolverThreads;
+    std::chrono::steady_clock::duration positive_ttl = kPositiveTTL;
+    std::chrono::steady_clock::duration negative_ttl = kNegativeTTL;
+  };
 
-  int res =
-      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
+  static DNSCache& GetInstance();
 
-  if (res) {
-    return res == EAI_NONAME ? addr : gai_strerror(res);
-  }
-  return node;
-}
+  DNSCache(LookupFn lookup_fn, const Options& options);
+  ~DNSCache();
 
-class DNSCache {
- public:
-  static DNSCache& GetInstance() {
-    static DNSCache cache;
-    return cache;
-  }
+  /**
+   * Queues the addresses that aren't cached, or have expired, for resolution, and waits until
+   * those that have no cached name at all are resolved or the timeout passes.
+   */
+  void Resolve(const std::vector<std::string_view>& addrs, std::chrono::milliseconds timeout);
 
-  std::string Lookup(std::string addr) { return cache_[addr].value(); }
+  /**
+   * Returns the cached name of the address, without blocking. If the address hasn't been
+   * resolved yet it gets queued, and the address itself is returned as a placeholder.
+   */
+  std::string Lookup(std::string_view addr);
 
  private:
-  DNSCache()
-      : cache_([](std::string addr) -> std::string { return DNSLookup(addr); }, kLRUCacheSize) {}
-
-  tbb::concurrent_lru_cache<std::string, std::string> cache_;
+  struct Entry {
+    std::string hostname;
+    std::chrono::steady_clock::time_point expiry;
+    // Position in lru_.
+    std::list<std::string>::iterator lru_it;
+  };
+
+  // Queues addr for resolution, unless it's already queued. Requires mu_.
+  void Enqueue(std::string_view addr);
+  void RunResolver();
+
+  const LookupFn lookup_fn_;
+  const Options options_;
+
+  std::mutex mu_;
+  std::condition_variable queue_cv_;
+  std::condition_variable resolved_cv_;
+  absl::flat_hash_map<std::string, Entry> entries_;
+  // Most recently used addresses first.
+  std::list<std::string> lru_;
+  std::deque<std::string> queue_;
+  absl::flat_hash_set<std::string> pending_;
+  bool stopped_ = false;
+  std::vector<std::thread> threads_;
 };
 
 }  // namespace internal
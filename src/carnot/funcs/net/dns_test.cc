@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <string>
+
+#include "src/carnot/funcs/net/dns.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+using std::chrono_literals::operator""ms;
+using std::chrono_literals::operator""s;
+
+StatusOr<std::string> FakeLookup(const std::string& addr) {
+  if (addr == "0.0.0.0") {
+    return error::NotFound("no name");
+  }
+  if (addr == "0.0.0.1") {
+    return error::Internal("resolver down");
+  }
+  return "host-" + addr;
+}
+
+TEST(DNSCache, resolve) {
+  DNSCache cache(FakeLookup, DNSCache::Options());
+  cache.Resolve({"1.2.3.4", "0.0.0.0", "0.0.0.1"}, 10s);
+  EXPECT_EQ("host-1.2.3.4", cache.Lookup("1.2.3.4"));
+  // Addresses without a name map to themselves, and failed lookups to the error.
+  EXPECT_EQ("0.0.0.0", cache.Lookup("0.0.0.0"));
+  EXPECT_EQ("resolver down", cache.Lookup("0.0.0.1"));
+}
+
+TEST(DNSCache, placeholder_while_pending) {
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  DNSCache cache(
+      [unblocked](const std::string& addr) -> StatusOr<std::string> {
+        unblocked.wait();
+        return "host-" + addr;
+      },
+      DNSCache::Options());
+
+  cache.Resolve({"1.2.3.4"}, 10ms);
+  EXPECT_EQ("1.2.3.4", cache.Lookup("1.2.3.4"));
+  EXPECT_EQ("5.6.7.8", cache.Lookup("5.6.7.8"));
+
+  unblock.set_value();
+  cache.Resolve({"1.2.3.4", "5.6.7.8"}, 10s);
+  EXPECT_EQ("host-1.2.3.4", cache.Lookup("1.2.3.4"));
+  EXPECT_EQ("host-5.6.7.8", cache.Lookup("5.6.7.8"));
+}
+
+TEST(DNSCache, expired_entries_are_refreshed) {
+  std::atomic<int> num_lookups = 0;
+  DNSCache::Options options;
+  options.positive_ttl = std::chrono::seconds(0);
+  DNSCache cache(
+      [&num_lookups](const std::string& addr) -> StatusOr<std::string> {
+        return absl::StrCat("host-", addr, "-", ++num_lookups);
+      },
+      options);
+
+  cache.Resolve({"1.2.3.4"}, 10s);
+  EXPECT_EQ("host-1.2.3.4-1", cache.Lookup("1.2.3.4"));
+  // The expired name is still served while the address is re-resolved.
+  while (cache.Lookup("1.2.3.4") == "host-1.2.3.4-1") {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_GE(num_lookups, 2);
+}
+
+TEST(DNSCache, lru_eviction) {
+  DNSCache::Options options;
+  options.max_entries = 2;
+  DNSCache cache(FakeLookup, options);
+  cache.Resolve({"1.1.1.1"}, 10s);
+  cache.Resolve({"2.2.2.2"}, 10s);
+  EXPECT_EQ("host-1.1.1.1", cache.Lookup("1.1.1.1"));
+  cache.Resolve({"3.3.3.3"}, 10s);
+
+  // 2.2.2.2 was the least recently used.
+  EXPECT_EQ("host-1.1.1.1", cache.Lookup("1.1.1.1"));
+  EXPECT_EQ("host-3.3.3.3", cache.Lookup("3.3.3.3"));
+  EXPECT_EQ("2.2.2.2", cache.Lookup("2.2.2.2"));
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
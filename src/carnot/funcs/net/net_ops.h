@@ -24,6 +24,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -42,11 +43,20 @@ using ScalarUDF = px::carnot::udf::ScalarUDF;
 
 class NSLookupUDF : public ScalarUDF {
  public:
+  static constexpr bool kMemoized = true;
+
+  // Resolves the uncached addresses of a batch in parallel, within the lookup time budget.
+  void Prefetch(FunctionContext*, const std::vector<std::string_view>& addrs) {
+    cache_.Resolve(addrs, std::chrono::milliseconds(FLAGS_carnot_dns_lookup_timeout_ms));
+  }
+
   StringValue Exec(FunctionContext*, StringValue addr) { return cache_.Lookup(addr); }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Perform a DNS lookup for the value (experimental).")
-        .Details("Experimental UDF to perform a DNS lookup for a given value.")
+        .Details(
+            "Experimental UDF to perform a DNS lookup for a given value. Addresses that can't be "
+            "resolved quickly return the address itself, until their lookup completes.")
         .Arg("addr", "An IP address")
         .Example("df.hostname = px.nslookup(df.ip_addr)")
         .Returns("The hostname.");
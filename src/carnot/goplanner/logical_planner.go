@@ -39,6 +39,7 @@ import (
 	"px.dev/pixie/src/carnot/planner/compilerpb"
 	"px.dev/pixie/src/carnot/planner/distributedpb"
 	"px.dev/pixie/src/carnot/planner/plannerpb"
+	"px.dev/pixie/src/carnot/planpb"
 	"px.dev/pixie/src/carnot/udfspb"
 	"px.dev/pixie/src/common/base/statuspb"
 	"px.dev/pixie/src/shared/scriptspb"
@@ -95,6 +96,63 @@ func (cm GoPlanner) Plan(planState *distributedpb.LogicalPlannerState, queryRequ
 	return plan, nil
 }
 
+// UpdateState keeps the planner state resident in the planner under the given version, so that
+// PlanWithState doesn't send it over again for every query. The planner keeps the last two versions.
+func (cm GoPlanner) UpdateState(version int64, planState *distributedpb.LogicalPlannerState) (*distributedpb.LogicalPlannerResult, error) {
+	var resultLen C.int
+	stateBytes, err := proto.Marshal(planState)
+	if err != nil {
+		return nil, err
+	}
+	stateData := C.CBytes(stateBytes)
+	defer C.free(stateData)
+
+	res := C.PlannerUpdateState(cm.planner, C.int64_t(version), (*C.char)(stateData), C.int(len(stateBytes)), &resultLen)
+	defer C.StrFree(res)
+	resultBytes := C.GoBytes(unsafe.Pointer(res), resultLen)
+	if resultLen == 0 {
+		return nil, errors.New("no result returned")
+	}
+
+	resultPB := &distributedpb.LogicalPlannerResult{}
+	if err := proto.Unmarshal(resultBytes, resultPB); err != nil {
+		return resultPB, fmt.Errorf("error: '%s'; string: '%s'", err, string(resultBytes))
+	}
+	return resultPB, nil
+}
+
+// PlanWithState plans the query against a state set by UpdateState. If the version is no longer
+// resident, the status of the result is NOT_FOUND and the caller must call UpdateState again.
+func (cm GoPlanner) PlanWithState(version int64, planOptions *planpb.PlanOptions, queryRequest *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error) {
+	var resultLen C.int
+	optionsBytes, err := proto.Marshal(planOptions)
+	if err != nil {
+		return nil, err
+	}
+	optionsData := C.CBytes(optionsBytes)
+	defer C.free(optionsData)
+
+	queryRequestBytes, err := proto.Marshal(queryRequest)
+	if err != nil {
+		return nil, err
+	}
+	queryRequestData := C.CBytes(queryRequestBytes)
+	defer C.free(queryRequestData)
+
+	res := C.PlannerPlanWithState(cm.planner, C.int64_t(version), (*C.char)(optionsData), C.int(len(optionsBytes)), (*C.char)(queryRequestData), C.int(len(queryRequestBytes)), &resultLen)
+	defer C.StrFree(res)
+	lp := C.GoBytes(unsafe.Pointer(res), resultLen)
+	if resultLen == 0 {
+		return nil, errors.New("no result returned")
+	}
+
+	plan := &distributedpb.LogicalPlannerResult{}
+	if err := proto.Unmarshal(lp, plan); err != nil {
+		return plan, fmt.Errorf("error: '%s'; string: '%s'", err, string(lp))
+	}
+	return plan, nil
+}
+
 // GetMainFuncArgsSpec returns the FuncArgSpec of the main function if it exists, otherwise throws a Compiler Error.
 func (cm GoPlanner) GetMainFuncArgsSpec(queryRequest *plannerpb.QueryRequest) (*scriptspb.MainFuncSpecResult, error) {
 	var resultLen C.int
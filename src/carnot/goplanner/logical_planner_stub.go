@@ -26,6 +26,7 @@ import (
 	"px.dev/pixie/src/carnot/planner/compilerpb"
 	"px.dev/pixie/src/carnot/planner/distributedpb"
 	"px.dev/pixie/src/carnot/planner/plannerpb"
+	"px.dev/pixie/src/carnot/planpb"
 	"px.dev/pixie/src/carnot/udfspb"
 	"px.dev/pixie/src/common/base/statuspb"
 	"px.dev/pixie/src/shared/scriptspb"
@@ -47,6 +48,16 @@ func (cm GoPlanner) Plan(planState *distributedpb.LogicalPlannerState, queryRequ
 	return nil, errorUnimplemented
 }
 
+// UpdateState keeps the planner state resident in the planner under the given version.
+func (cm GoPlanner) UpdateState(version int64, planState *distributedpb.LogicalPlannerState) (*distributedpb.LogicalPlannerResult, error) {
+	return nil, errorUnimplemented
+}
+
+// PlanWithState plans the query against a state set by UpdateState.
+func (cm GoPlanner) PlanWithState(version int64, planOptions *planpb.PlanOptions, queryRequest *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error) {
+	return nil, errorUnimplemented
+}
+
 // GetMainFuncArgsSpec returns the FuncArgSpec of the main function if it exists, otherwise throws a Compiler Error.
 func (cm GoPlanner) GetMainFuncArgsSpec(queryRequest *plannerpb.QueryRequest) (*scriptspb.MainFuncSpecResult, error) {
 	return nil, errorUnimplemented
@@ -82,6 +82,8 @@ std::unique_ptr<Operator> Operator::FromProto(const planpb::Operator& pb, int64_
       return CreateOperator<UDTFSourceOperator>(id, pb.udtf_source_op());
     case planpb::EMPTY_SOURCE_OPERATOR:
       return CreateOperator<EmptySourceOperator>(id, pb.empty_source_op());
+    case planpb::SORT_OPERATOR:
+      return CreateOperator<SortOperator>(id, pb.sort_op());
     default:
       LOG(FATAL) << absl::Substitute("Unknown operator type: $0",
                                      magic_enum::enum_name(pb.op_type()));
@@ -104,6 +106,19 @@ Status MemorySourceOperator::Init(const planpb::MemorySourceOperator& pb) {
   return Status::OK();
 }
 
+void MemorySourceOperator::SetTimeBounds(const planpb::MemorySourceOperator& pb) {
+  if (pb.has_start_time()) {
+    *pb_.mutable_start_time() = pb.start_time();
+  } else {
+    pb_.clear_start_time();
+  }
+  if (pb.has_stop_time()) {
+    *pb_.mutable_stop_time() = pb.stop_time();
+  } else {
+    pb_.clear_stop_time();
+  }
+}
+
 StatusOr<table_store::schema::Relation> MemorySourceOperator::OutputRelation(
     const table_store::schema::Schema&, const PlanState&,
     const std::vector<int64_t>& input_ids) const {
@@ -679,6 +694,70 @@ const std::vector<ScalarValue>& UDTFSourceOperator::init_arguments() const {
   return init_arguments_;
 }
 
+/**
+ * Sort Operator Implementation.
+ */
+std::string SortOperator::DebugString() const {
+  std::vector<std::string> sort_cols;
+  for (const auto& sort_col : sort_columns_) {
+    sort_cols.push_back(
+        absl::Substitute("$0 $1", sort_col.index(), sort_col.ascending() ? "asc" : "desc"));
+  }
+  return absl::Substitute("Op:Sort(by: [$0], limit: $1, cols: [$2])", absl::StrJoin(sort_cols, ","),
+                          pb_.limit(), absl::StrJoin(selected_cols_, ","));
+}
+
+Status SortOperator::Init(const planpb::SortOperator& pb) {
+  pb_ = pb;
+  if (pb_.limit() < 0) {
+    return error::InvalidArgument("Sort limit must not be negative, got $0", pb_.limit());
+  }
+
+  selected_cols_.reserve(pb_.columns_size());
+  for (auto i = 0; i < pb_.columns_size(); ++i) {
+    selected_cols_.push_back(pb_.columns(i).index());
+  }
+  sort_columns_.assign(pb_.sort_columns().begin(), pb_.sort_columns().end());
+
+  is_initialized_ = true;
+  return Status::OK();
+}
+
+StatusOr<table_store::schema::Relation> SortOperator::OutputRelation(
+    const table_store::schema::Schema& schema, const PlanState& /*state*/,
+    const std::vector<int64_t>& input_ids) const {
+  DCHECK(is_initialized_) << "Not initialized";
+
+  if (input_ids.size() != 1) {
+    return error::InvalidArgument("Sort operator must have exactly one input");
+  }
+  if (!schema.HasRelation(input_ids[0])) {
+    return error::NotFound("Missing relation ($0) for input of SortOperator", input_ids[0]);
+  }
+
+  PL_ASSIGN_OR_RETURN(const table_store::schema::Relation& input_relation,
+                      schema.GetRelation(input_ids[0]));
+  int64_t num_input_cols = input_relation.NumColumns();
+  for (const auto& sort_col : sort_columns_) {
+    if (static_cast<int64_t>(sort_col.index()) >= num_input_cols) {
+      return error::InvalidArgument("Sort column index $0 is out of bounds, $1 input columns",
+                                    sort_col.index(), num_input_cols);
+    }
+  }
+
+  table_store::schema::Relation output_relation;
+  for (auto selected_col_idx : selected_cols_) {
+    if (selected_col_idx >= num_input_cols) {
+      return error::InvalidArgument("Column index $0 is out of bounds, $1 input columns",
+                                    selected_col_idx, num_input_cols);
+    }
+    output_relation.AddColumn(input_relation.GetColumnType(selected_col_idx),
+                              input_relation.GetColumnName(selected_col_idx),
+                              input_relation.GetColumnDesc(selected_col_idx));
+  }
+  return output_relation;
+}
+
 /**
  *  EmptySourceOperator definition.
  */
@@ -93,9 +93,19 @@ class MemorySourceOperator : public Operator {
   bool HasStopTime() const { return pb_.has_stop_time(); }
   int64_t start_time() const { return pb_.start_time().value(); }
   int64_t stop_time() const { return pb_.stop_time().value(); }
+  double sample_fraction() const { return pb_.sample_fraction(); }
   std::vector<int64_t> Columns() const { return column_idxs_; }
   const types::TabletID& Tablet() const { return pb_.tablet(); }
+  bool AllTablets() const { return pb_.all_tablets(); }
   bool infinite_stream() const { return pb_.streaming(); }
+  const google::protobuf::RepeatedPtrField<planpb::ColumnPredicate>& predicates() const {
+    return pb_.predicates();
+  }
+  const planpb::MemorySourceOperator& pb() const { return pb_; }
+
+  // Takes the time bounds of pb, which is otherwise the same as the proto that the operator was
+  // initialized with.
+  void SetTimeBounds(const planpb::MemorySourceOperator& pb);
 
  private:
   planpb::MemorySourceOperator pb_;
@@ -116,6 +126,7 @@ class MapOperator : public Operator {
   const std::vector<std::shared_ptr<const ScalarExpression>>& expressions() const {
     return expressions_;
   }
+  const planpb::MapOperator& pb() const { return pb_; }
 
  private:
   std::vector<std::shared_ptr<const ScalarExpression>> expressions_;
@@ -143,6 +154,13 @@ class AggregateOperator : public Operator {
   const std::vector<GroupInfo>& groups() const { return groups_; }
   const std::vector<std::shared_ptr<AggregateExpression>>& values() const { return values_; }
   bool windowed() const { return pb_.windowed(); }
+  bool partial_agg() const { return pb_.partial_agg(); }
+  bool finalize_results() const { return pb_.finalize_results(); }
+  // Standing aggregates emit periodically, see planpb::AggregateOperator.
+  bool standing() const { return pb_.emit_interval_ns() > 0; }
+  int64_t emit_interval_ns() const { return pb_.emit_interval_ns(); }
+  int64_t group_ttl_ns() const { return pb_.group_ttl_ns(); }
+  const planpb::AggregateOperator& pb() const { return pb_; }
 
  private:
   std::vector<std::shared_ptr<AggregateExpression>> values_;
@@ -214,6 +232,14 @@ class GRPCSinkOperator : public Operator {
   }
   std::string table_name() const { return pb_.output_table().table_name(); }
 
+  // The filter of the join that the rows are sent to the probe side of (see planpb).
+  bool has_join_filter() const { return pb_.has_join_filter(); }
+  const planpb::GRPCSinkOperator::JoinFilter& join_filter() const { return pb_.join_filter(); }
+
+  // The partition of the rows that the sink sends (see planpb).
+  bool has_partition() const { return pb_.has_partition(); }
+  const planpb::GRPCSinkOperator::Partition& partition() const { return pb_.partition(); }
+
  private:
   planpb::GRPCSinkOperator pb_;
 };
@@ -231,6 +257,7 @@ class FilterOperator : public Operator {
   std::vector<int64_t> selected_cols() { return selected_cols_; }
 
   const std::shared_ptr<const ScalarExpression>& expression() const { return expression_; }
+  const planpb::FilterOperator& pb() const { return pb_; }
 
  private:
   std::shared_ptr<const ScalarExpression> expression_;
@@ -312,6 +339,8 @@ class JoinOperator : public Operator {
   }
   std::vector<planpb::JoinOperator::ParentColumn> output_columns() const { return output_columns_; }
   size_t rows_per_batch() const { return pb_.rows_per_batch(); }
+  int64_t build_parent_index() const { return pb_.build_parent_index(); }
+  int64_t join_filter_id() const { return pb_.join_filter_id(); }
 
   bool order_by_time() const;
   planpb::JoinOperator::ParentColumn time_column() const;
@@ -324,6 +353,30 @@ class JoinOperator : public Operator {
   planpb::JoinOperator pb_;
 };
 
+class SortOperator : public Operator {
+ public:
+  explicit SortOperator(int64_t id) : Operator(id, planpb::SORT_OPERATOR) {}
+  ~SortOperator() override = default;
+
+  StatusOr<table_store::schema::Relation> OutputRelation(
+      const table_store::schema::Schema& schema, const PlanState& state,
+      const std::vector<int64_t>& input_ids) const override;
+  Status Init(const planpb::SortOperator& pb);
+  std::string DebugString() const override;
+
+  const std::vector<int64_t>& selected_cols() const { return selected_cols_; }
+  const std::vector<planpb::SortOperator::SortColumn>& sort_columns() const {
+    return sort_columns_;
+  }
+  // The number of rows to output, 0 if all the rows are output.
+  int64_t limit() const { return pb_.limit(); }
+
+ private:
+  std::vector<int64_t> selected_cols_;
+  std::vector<planpb::SortOperator::SortColumn> sort_columns_;
+  planpb::SortOperator pb_;
+};
+
 class UDTFSourceOperator : public Operator {
  public:
   explicit UDTFSourceOperator(int64_t id) : Operator(id, planpb::UDTF_SOURCE_OPERATOR) {}
@@ -98,32 +98,74 @@ char* PlannerPlan(PlannerPtr planner_ptr, const char* planner_state_str_c,
 
   auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
 
-  auto distributed_plan_status = planner->Plan(planner_state_pb, query_request_pb);
-  if (!distributed_plan_status.ok()) {
-    return ExitEarly<LogicalPlannerResult>(distributed_plan_status.status(), resultLen);
-  }
-  std::unique_ptr<px::carnot::planner::distributed::DistributedPlan> distributed_plan =
-      distributed_plan_status.ConsumeValueOrDie();
-
-  // If the response is ok, then we can go ahead and set this up.
-  LogicalPlannerResult planner_result_pb;
-  WrapStatus(&planner_result_pb, distributed_plan_status.status());
   // In the future, if we actually have plan options that will actually determine how the plan is
   // constructed, we may want to pass the planOptions to planner.Plan. However, this
   // will need to go through many more layers (such as the coordinator), so this is fine for now.
-  distributed_plan->SetPlanOptions(planner_state_pb.plan_options());
-
-  auto plan_pb_status = distributed_plan->ToProto();
+  auto plan_pb_status = planner->PlanToProto(planner_state_pb, query_request_pb);
   if (!plan_pb_status.ok()) {
     return ExitEarly<LogicalPlannerResult>(plan_pb_status.status(), resultLen);
   }
 
+  // If the response is ok, then we can go ahead and set this up.
+  LogicalPlannerResult planner_result_pb;
+  WrapStatus(&planner_result_pb, plan_pb_status.status());
   *(planner_result_pb.mutable_plan()) = plan_pb_status.ConsumeValueOrDie();
 
   // Serialize the logical plan into bytes.
   return PrepareResult(&planner_result_pb, resultLen);
 }
 
+char* PlannerUpdateState(PlannerPtr planner_ptr, int64_t version, const char* planner_state_str_c,
+                         int planner_state_str_len, int* resultLen) {
+  DCHECK(planner_state_str_c != nullptr);
+  std::string planner_state_pb_str(planner_state_str_c,
+                                   planner_state_str_c + planner_state_str_len);
+
+  px::carnot::planner::distributedpb::LogicalPlannerState planner_state_pb;
+  PLANNER_RETURN_IF_ERROR(LogicalPlannerResult, resultLen,
+                          LoadProto(planner_state_pb_str, &planner_state_pb,
+                                    "Failed to process the logical planner state"));
+
+  auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
+  auto s = planner->SetResidentState(version, std::move(planner_state_pb));
+
+  LogicalPlannerResult planner_result_pb;
+  WrapStatus(&planner_result_pb, s);
+  return PrepareResult(&planner_result_pb, resultLen);
+}
+
+char* PlannerPlanWithState(PlannerPtr planner_ptr, int64_t state_version,
+                           const char* plan_options_str_c, int plan_options_str_len,
+                           const char* query_request_str_c, int query_request_str_len,
+                           int* resultLen) {
+  DCHECK(query_request_str_c != nullptr);
+  std::string plan_options_pb_str(plan_options_str_c, plan_options_str_c + plan_options_str_len);
+  std::string query_request_pb_str(query_request_str_c,
+                                   query_request_str_c + query_request_str_len);
+
+  px::carnot::planpb::PlanOptions plan_options_pb;
+  PLANNER_RETURN_IF_ERROR(
+      LogicalPlannerResult, resultLen,
+      LoadProto(plan_options_pb_str, &plan_options_pb, "Failed to process the plan options"));
+
+  px::carnot::planner::plannerpb::QueryRequest query_request_pb;
+  PLANNER_RETURN_IF_ERROR(
+      LogicalPlannerResult, resultLen,
+      LoadProto(query_request_pb_str, &query_request_pb, "Failed to process the query request"));
+
+  auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
+
+  auto plan_pb_status = planner->PlanToProto(state_version, plan_options_pb, query_request_pb);
+  if (!plan_pb_status.ok()) {
+    return ExitEarly<LogicalPlannerResult>(plan_pb_status.status(), resultLen);
+  }
+
+  LogicalPlannerResult planner_result_pb;
+  WrapStatus(&planner_result_pb, plan_pb_status.status());
+  *(planner_result_pb.mutable_plan()) = plan_pb_status.ConsumeValueOrDie();
+  return PrepareResult(&planner_result_pb, resultLen);
+}
+
 char* PlannerCompileMutations(PlannerPtr planner_ptr, const char* planner_state_str_c,
                               int planner_state_str_len, const char* mutation_request_str_c,
                               int mutation_request_str_len, int* resultLen) {
@@ -22,6 +22,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef void* PlannerPtr;
 
@@ -45,6 +46,38 @@ PlannerPtr PlannerNew(const char* udf_info_str_data, int udf_info_str_len);
 char* PlannerPlan(PlannerPtr planner_ptr, const char* planner_state_str_c,
                   int planner_state_str_len, const char* query, int query_len, int* resultLen);
 
+/**
+ * @brief Keeps the planner state resident in the planner under the given version, so that
+ * PlannerPlanWithState doesn't need it again for every query. The planner keeps the last two
+ * versions.
+ *
+ * @param planner                 Pointer to the Planner.
+ * @param version                 The version of the state, greater than the previous ones.
+ * @param planner_state_str_c     The planner state proto, seralized as a string.
+ * @param planner_state_str_len   Length of the planner state proto serialized string.
+ * @return char*                  A LogicalPlannerResult with only the status, serialized as a
+ * string.
+ */
+char* PlannerUpdateState(PlannerPtr planner_ptr, int64_t version, const char* planner_state_str_c,
+                         int planner_state_str_len, int* resultLen);
+
+/**
+ * @brief Same as PlannerPlan, against a state set by PlannerUpdateState. If the version isn't
+ * resident, the status of the result is NOT_FOUND and the state must be set again.
+ *
+ * @param planner                 Pointer to the Planner.
+ * @param state_version           The version of the state to plan against.
+ * @param plan_options_str_c      The plan options proto, serialized as a string.
+ * @param plan_options_str_len    The length of the plan options serialized string.
+ * @param query_request_str_c     The query request proto to plan, seralized as a string.
+ * @param query_request_str_len   The length of the query request serialized string.
+ * @return char*                  The LogicalPlannerResult, serialized as a string.
+ */
+char* PlannerPlanWithState(PlannerPtr planner_ptr, int64_t state_version,
+                           const char* plan_options_str_c, int plan_options_str_len,
+                           const char* query_request_str_c, int query_request_str_len,
+                           int* resultLen);
+
 /**
  * @brief Returns the Main Function argument's Specification. Fails if the main function doesn't
  * exist in the query argument.
@@ -94,6 +94,49 @@ TEST_F(PlannerExportTest, one_pem_one_kelvin_query_test) {
               Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
 }
 
+TEST_F(PlannerExportTest, plan_with_resident_state) {
+  planner_ = MakePlanner();
+  int result_len;
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState();
+  std::string logical_planner_state;
+  ASSERT_TRUE(state.SerializeToString(&logical_planner_state));
+  std::string plan_options;
+  ASSERT_TRUE(state.plan_options().SerializeToString(&plan_options));
+  std::string query_request;
+  ASSERT_TRUE(MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')")
+                  .SerializeToString(&query_request));
+
+  // The state isn't resident yet.
+  auto interface_result =
+      PlannerPlanWithState(planner_, 1, plan_options.c_str(), plan_options.length(),
+                           query_request.c_str(), query_request.length(), &result_len);
+  ASSERT_GT(result_len, 0);
+  distributedpb::LogicalPlannerResult planner_result;
+  ASSERT_TRUE(
+      planner_result.ParseFromString(std::string(interface_result, interface_result + result_len)));
+  delete[] interface_result;
+  EXPECT_EQ(planner_result.status().err_code(), statuspb::NOT_FOUND);
+
+  interface_result = PlannerUpdateState(planner_, 1, logical_planner_state.c_str(),
+                                        logical_planner_state.length(), &result_len);
+  ASSERT_GT(result_len, 0);
+  ASSERT_TRUE(
+      planner_result.ParseFromString(std::string(interface_result, interface_result + result_len)));
+  delete[] interface_result;
+  ASSERT_OK(planner_result.status());
+
+  interface_result =
+      PlannerPlanWithState(planner_, 1, plan_options.c_str(), plan_options.length(),
+                           query_request.c_str(), query_request.length(), &result_len);
+  ASSERT_GT(result_len, 0);
+  ASSERT_TRUE(
+      planner_result.ParseFromString(std::string(interface_result, interface_result + result_len)));
+  delete[] interface_result;
+  ASSERT_OK(planner_result.status());
+  EXPECT_THAT(planner_result.plan(),
+              Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
+}
+
 TEST_F(PlannerExportTest, bad_queries) {
   planner_ = MakePlanner();
   int result_len;
@@ -32,11 +32,13 @@
 #include "src/carnot/planner/compiler/analyzer/merge_group_by_into_group_acceptor_rule.h"
 #include "src/carnot/planner/compiler/analyzer/nested_blocking_agg_fn_check_rule.h"
 #include "src/carnot/planner/compiler/analyzer/operator_relation_rule.h"
+#include "src/carnot/planner/compiler/analyzer/project_result_columns_rule.h"
 #include "src/carnot/planner/compiler/analyzer/propagate_expression_annotations_rule.h"
 #include "src/carnot/planner/compiler/analyzer/remove_group_by_rule.h"
 #include "src/carnot/planner/compiler/analyzer/resolve_metadata_property_rule.h"
 #include "src/carnot/planner/compiler/analyzer/resolve_stream_rule.h"
 #include "src/carnot/planner/compiler/analyzer/resolve_types_rule.h"
+#include "src/carnot/planner/compiler/analyzer/scale_sampled_aggregates_rule.h"
 #include "src/carnot/planner/compiler/analyzer/set_memory_source_times_rule.h"
 #include "src/carnot/planner/compiler/analyzer/setup_join_type_rule.h"
 #include "src/carnot/planner/compiler/analyzer/source_relation_rule.h"
@@ -90,6 +92,11 @@ class Analyzer : public RuleExecutor<IR> {
     limit_to_res_sink->AddRule<AddLimitToBatchResultSinkRule>(compiler_state_);
   }
 
+  void CreateScaleSampledAggregatesBatch() {
+    RuleBatch* scale_sampled_aggs = CreateRuleBatch<TryUntilMax>("ScaleSampledAggregates", 1);
+    scale_sampled_aggs->AddRule<ScaleSampledAggregatesRule>();
+  }
+
   void CreateOperatorCompileTimeExpressionRuleBatch() {
     RuleBatch* intermediate_resolution_batch =
         CreateRuleBatch<FailOnMax>("IntermediateResolution", 100);
@@ -110,6 +117,11 @@ class Analyzer : public RuleExecutor<IR> {
     intermediate_resolution_batch->AddRule<DropToMapOperatorRule>(compiler_state_);
   }
 
+  void CreateProjectResultColumnsBatch() {
+    RuleBatch* project_result_columns = CreateRuleBatch<FailOnMax>("ProjectResultColumns", 2);
+    project_result_columns->AddRule<ProjectResultColumnsRule>(compiler_state_);
+  }
+
   void CreateMetadataConversionBatch() {
     RuleBatch* metadata_conversion_batch = CreateRuleBatch<FailOnMax>("MetadataConversion", 2);
     metadata_conversion_batch->AddRule<ConvertMetadataRule>(compiler_state_);
@@ -137,9 +149,12 @@ class Analyzer : public RuleExecutor<IR> {
     CreateSourceAndMetadataResolutionBatch();
     CreateUniqueSinkNamesBatch();
     CreateAddLimitToBatchResultSinkBatch();
+    CreateScaleSampledAggregatesBatch();
     CreateOperatorCompileTimeExpressionRuleBatch();
     CreateCombineConsecutiveMapsRule();
     CreateDataTypeResolutionBatch();
+    // Needs the relations of the result sinks.
+    CreateProjectResultColumnsBatch();
     CreateMetadataConversionBatch();
     CreateResolutionVerificationBatch();
     CreateRemoveIROnlyNodesBatch();
@@ -58,9 +58,9 @@ TEST_F(AnalyzerTest, test_utils) {
   table_store::schema::Relation cpu2_relation;
   cpu2_relation.AddColumn(types::FLOAT64, "cpu0");
   cpu2_relation.AddColumn(types::FLOAT64, "cpu1");
-  EXPECT_THAT((*compiler_state_->relation_map())["cpu"],
+  EXPECT_THAT(compiler_state_->relation_map()->at("cpu"),
               Not(UnorderedRelationMatches(cpu2_relation)));
-  EXPECT_EQ((*compiler_state_->relation_map())["cpu"], (*compiler_state_->relation_map())["cpu"]);
+  EXPECT_EQ(compiler_state_->relation_map()->at("cpu"), compiler_state_->relation_map()->at("cpu"));
 }
 
 TEST_F(AnalyzerTest, no_special_relation) {
@@ -251,7 +251,7 @@ TEST_F(AnalyzerTest, test_relation_results) {
   EXPECT_EQ(source_nodes.size(), 1);
   auto source_node = static_cast<MemorySourceIR*>(source_nodes[0]);
   EXPECT_THAT(source_node->relation(),
-              UnorderedRelationMatches((*compiler_state_->relation_map())["cpu"]));
+              UnorderedRelationMatches(compiler_state_->relation_map()->at("cpu")));
 
   // Map relation should be contain cpu0, cpu1, and cpu_sum.
   std::vector<IRNode*> map_nodes = ir_graph->FindNodesOfType(IRNodeType::kMap);
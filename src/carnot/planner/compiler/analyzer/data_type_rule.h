@@ -38,6 +38,10 @@ class DataTypeRule : public Rule {
   explicit DataTypeRule(CompilerState* compiler_state)
       : Rule(compiler_state, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
 
+  absl::flat_hash_set<IRNodeType> TargetNodeTypes() const override {
+    return {IRNodeType::kFunc, IRNodeType::kColumn, IRNodeType::kMetadata};
+  }
+
   /**
    * @brief Evaluates the datatype of column from the type data in the relation. Errors out if the
    * column doesn't exist in the relation.
@@ -34,6 +34,10 @@ class DropToMapOperatorRule : public Rule {
   explicit DropToMapOperatorRule(CompilerState* compiler_state)
       : Rule(compiler_state, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
 
+  absl::flat_hash_set<IRNodeType> TargetNodeTypes() const override {
+    return {IRNodeType::kDrop};
+  }
+
  protected:
   StatusOr<bool> Apply(IRNode* ir_node) override;
 
@@ -37,6 +37,10 @@ class OperatorRelationRule : public Rule {
   explicit OperatorRelationRule(CompilerState* compiler_state)
       : Rule(compiler_state, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
 
+  absl::flat_hash_set<IRNodeType> TargetNodeTypes() const override {
+    return OperatorNodeTypes();
+  }
+
   StatusOr<bool> Apply(IRNode* ir_node) override;
 
  private:
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/carnot/planner/compiler/analyzer/project_result_columns_rule.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+template <typename TSink>
+StatusOr<bool> ProjectSink(
+    TSink* sink, const absl::flat_hash_map<std::string, std::vector<std::string>>& result_columns) {
+  auto it = result_columns.find(sink->name());
+  if (it == result_columns.end() || !sink->IsRelationInit()) {
+    return false;
+  }
+
+  const absl::flat_hash_set<std::string> requested(it->second.begin(), it->second.end());
+  const Relation& relation = sink->relation();
+  std::vector<std::string> out_columns;
+  Relation projected;
+  for (size_t i = 0; i < relation.NumColumns(); ++i) {
+    const std::string& col_name = relation.GetColumnName(i);
+    if (!requested.contains(col_name)) {
+      continue;
+    }
+    out_columns.push_back(col_name);
+    projected.AddColumn(relation.GetColumnType(i), col_name, relation.GetColumnSemanticType(i),
+                        relation.GetColumnDesc(i));
+  }
+  if (out_columns.empty() || out_columns.size() == relation.NumColumns()) {
+    return false;
+  }
+
+  PL_RETURN_IF_ERROR(sink->SetOutColumns(std::move(out_columns)));
+  PL_RETURN_IF_ERROR(sink->SetRelation(projected));
+  return true;
+}
+
+}  // namespace
+
+StatusOr<bool> ProjectResultColumnsRule::Apply(IRNode* ir_node) {
+  if (Match(ir_node, MemorySink())) {
+    return ProjectSink(static_cast<MemorySinkIR*>(ir_node), compiler_state_->result_columns());
+  }
+  if (Match(ir_node, ExternalGRPCSink())) {
+    return ProjectSink(static_cast<GRPCSinkIR*>(ir_node), compiler_state_->result_columns());
+  }
+  return false;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/project_result_columns_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class ProjectResultColumnsRuleTest : public RulesTest {
+ protected:
+  MemorySinkIR* MakeSinkWithRelation(const std::string& name) {
+    MemorySourceIR* src = MakeMemSource(MakeRelation());
+    MemorySinkIR* sink = MakeMemSink(src, name);
+    EXPECT_OK(sink->SetRelation(MakeRelation()));
+    return sink;
+  }
+};
+
+TEST_F(ProjectResultColumnsRuleTest, projects_requested_columns) {
+  compiler_state_->set_result_columns({{"foo", {"cpu2", "cpu0", "not_a_column"}}});
+  MemorySinkIR* sink = MakeSinkWithRelation("foo");
+
+  ProjectResultColumnsRule rule(compiler_state_.get());
+  ASSERT_OK_AND_ASSIGN(bool changed, rule.Execute(graph.get()));
+  EXPECT_TRUE(changed);
+
+  // The columns stay in the order of the script, and unknown columns are ignored.
+  EXPECT_THAT(sink->out_columns(), ElementsAre("cpu0", "cpu2"));
+  EXPECT_THAT(sink->relation().col_names(), ElementsAre("cpu0", "cpu2"));
+  EXPECT_THAT(sink->relation().col_types(),
+              ElementsAre(types::DataType::FLOAT64, types::DataType::FLOAT64));
+}
+
+TEST_F(ProjectResultColumnsRuleTest, external_grpc_sink) {
+  compiler_state_->set_result_columns({{"foo", {"count"}}});
+  MemorySourceIR* src = MakeMemSource(MakeRelation());
+  GRPCSinkIR* sink = MakeGRPCSink(src, "foo", {});
+  ASSERT_OK(sink->SetRelation(MakeRelation()));
+
+  ProjectResultColumnsRule rule(compiler_state_.get());
+  ASSERT_OK_AND_ASSIGN(bool changed, rule.Execute(graph.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(sink->out_columns(), ElementsAre("count"));
+  EXPECT_THAT(sink->relation().col_names(), ElementsAre("count"));
+}
+
+TEST_F(ProjectResultColumnsRuleTest, other_results_unchanged) {
+  compiler_state_->set_result_columns({{"foo", {"cpu0"}}});
+  MemorySinkIR* sink = MakeSinkWithRelation("bar");
+
+  ProjectResultColumnsRule rule(compiler_state_.get());
+  ASSERT_OK_AND_ASSIGN(bool changed, rule.Execute(graph.get()));
+  EXPECT_FALSE(changed);
+  EXPECT_THAT(sink->out_columns(), IsEmpty());
+  EXPECT_EQ(4, sink->relation().NumColumns());
+}
+
+TEST_F(ProjectResultColumnsRuleTest, no_known_columns) {
+  compiler_state_->set_result_columns({{"foo", {"not_a_column"}}});
+  MemorySinkIR* sink = MakeSinkWithRelation("foo");
+
+  ProjectResultColumnsRule rule(compiler_state_.get());
+  ASSERT_OK_AND_ASSIGN(bool changed, rule.Execute(graph.get()));
+  EXPECT_FALSE(changed);
+  EXPECT_EQ(4, sink->relation().NumColumns());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -32,18 +32,23 @@ StatusOr<bool> ResolveStreamRule::Apply(IRNode* ir_node) {
 
   auto stream_node = static_cast<StreamIR*>(ir_node);
 
-  // Check for blocking nodes in the ancestors.
-  // Currently not supported to stream on queries containing blocking operators.
+  // Check for blocking nodes in the ancestors. A single aggregate can emit its updated groups
+  // as the stream goes, but its results can't feed other blocking operators.
   DCHECK_EQ(stream_node->parents().size(), 1UL);
   OperatorIR* parent = stream_node->parents()[0];
   std::queue<OperatorIR*> nodes;
   nodes.push(parent);
+  BlockingAggIR* agg = nullptr;
 
   while (nodes.size()) {
     auto node = nodes.front();
     nodes.pop();
 
-    if (node->IsBlocking()) {
+    if (Match(node, BlockingAgg()) && (agg == nullptr || agg == node)) {
+      agg = static_cast<BlockingAggIR*>(node);
+      agg->SetEmitIntervalNS(kStreamingAggEmitIntervalNS);
+      agg->SetGroupTTLNS(kStreamingAggGroupTTLNS);
+    } else if (node->IsBlocking()) {
       return error::Unimplemented("df.stream() not yet supported with blocking operator %s",
                                   node->DebugString());
     }
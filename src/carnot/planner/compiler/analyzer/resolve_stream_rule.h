@@ -25,9 +25,17 @@ namespace carnot {
 namespace planner {
 namespace compiler {
 
+// How often the aggregates of streaming queries emit the groups they updated.
+constexpr int64_t kStreamingAggEmitIntervalNS = 1000 * 1000 * 1000;
+// How long the aggregates of streaming queries keep a group they no longer update, so that the
+// state of a query that runs for days stays bounded by what it saw recently.
+constexpr int64_t kStreamingAggGroupTTLNS = int64_t{5} * 60 * 1000 * 1000 * 1000;
+
 class ResolveStreamRule : public Rule {
   /**
    * @brief Resolves StreamIRs by setting their ancestor MemorySource nodes to streaming mode.
+   * A streaming query can have one aggregate, which then runs as a standing aggregate that
+   * periodically emits the groups it updated and drops the groups it stopped updating.
    */
  public:
   ResolveStreamRule()
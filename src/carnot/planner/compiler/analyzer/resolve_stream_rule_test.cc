@@ -60,7 +60,7 @@ TEST_F(RulesTest, resolve_stream_no_stream) {
   EXPECT_FALSE(result.ValueOrDie());
 }
 
-TEST_F(RulesTest, resolve_stream_blocking_ancestor) {
+TEST_F(RulesTest, resolve_stream_agg_ancestor) {
   MemorySourceIR* mem_source = MakeMemSource();
   GroupByIR* group_by = MakeGroupBy(mem_source, {MakeColumn("col1", 0), MakeColumn("col2", 0)});
   BlockingAggIR* agg =
@@ -68,6 +68,25 @@ TEST_F(RulesTest, resolve_stream_blocking_ancestor) {
   StreamIR* stream = graph->CreateNode<StreamIR>(ast, agg).ValueOrDie();
   MakeMemSink(stream, "");
 
+  ResolveStreamRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ValueOrDie());
+  EXPECT_TRUE(mem_source->streaming());
+  EXPECT_EQ(kStreamingAggEmitIntervalNS, agg->emit_interval_ns());
+  EXPECT_EQ(kStreamingAggGroupTTLNS, agg->group_ttl_ns());
+}
+
+TEST_F(RulesTest, resolve_stream_blocking_ancestor) {
+  MemorySourceIR* mem_source = MakeMemSource();
+  GroupByIR* group_by = MakeGroupBy(mem_source, {MakeColumn("col1", 0), MakeColumn("col2", 0)});
+  BlockingAggIR* agg =
+      MakeBlockingAgg(group_by, {}, {{"outcount", MakeMeanFunc(MakeColumn("count", 0))}});
+  BlockingAggIR* agg_of_agg =
+      MakeBlockingAgg(agg, {}, {{"outcount", MakeMeanFunc(MakeColumn("outcount", 0))}});
+  StreamIR* stream = graph->CreateNode<StreamIR>(ast, agg_of_agg).ValueOrDie();
+  MakeMemSink(stream, "");
+
   ResolveStreamRule rule;
   auto result = rule.Execute(graph.get());
   ASSERT_NOT_OK(result);
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "src/carnot/planner/compiler/analyzer/scale_sampled_aggregates_rule.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// The z-score of the 95% confidence bound of the normal distribution.
+constexpr double kZScore95 = 1.96;
+
+// Returns the sampled MemorySource that the aggregate reads from, or nullptr if there isn't one
+// or if something between them changes the number of rows in a way that the scaling can't
+// account for.
+MemorySourceIR* SampledSource(BlockingAggIR* agg) {
+  OperatorIR* op = agg->parents()[0];
+  while (Match(op, Map()) || Match(op, Filter())) {
+    op = op->parents()[0];
+  }
+  if (!Match(op, MemorySource())) {
+    return nullptr;
+  }
+  auto mem_src = static_cast<MemorySourceIR*>(op);
+  return mem_src->sampled() ? mem_src : nullptr;
+}
+
+StatusOr<FuncIR*> Multiply(IR* graph, const pypa::AstPtr& ast, ExpressionIR* expr, double val) {
+  PL_ASSIGN_OR_RETURN(FloatIR * factor, graph->CreateNode<FloatIR>(ast, val));
+  return graph->CreateNode<FuncIR>(ast, FuncIR::Op{FuncIR::Opcode::mult, "*", "multiply"},
+                                   std::vector<ExpressionIR*>{expr, factor});
+}
+
+}  // namespace
+
+StatusOr<bool> ScaleSampledAggregatesRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, BlockingAgg())) {
+    return false;
+  }
+  auto agg = static_cast<BlockingAggIR*>(ir_node);
+  MemorySourceIR* mem_src = SampledSource(agg);
+  if (mem_src == nullptr) {
+    return false;
+  }
+  IR* graph = agg->graph();
+  const pypa::AstPtr& ast = agg->ast();
+  double fraction = mem_src->sample_fraction();
+
+  ColExpressionVector exprs;
+  for (ColumnIR* group : agg->groups()) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * col,
+                        graph->CreateNode<ColumnIR>(ast, group->col_name(), /*parent_op_idx*/ 0));
+    exprs.emplace_back(group->col_name(), col);
+  }
+  for (const auto& agg_expr : agg->aggregate_expressions()) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * col,
+                        graph->CreateNode<ColumnIR>(ast, agg_expr.name, /*parent_op_idx*/ 0));
+    std::string func_name;
+    if (Match(agg_expr.node, Func())) {
+      func_name = static_cast<FuncIR*>(agg_expr.node)->func_name();
+    }
+    if (func_name != "count" && func_name != "sum") {
+      exprs.emplace_back(agg_expr.name, col);
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(FuncIR * scaled, Multiply(graph, ast, col, 1 / fraction));
+    exprs.emplace_back(agg_expr.name, scaled);
+    if (func_name != "count") {
+      continue;
+    }
+
+    // A count n of rows sampled with probability f estimates n / f rows, with a standard
+    // deviation of sqrt(n * (1 - f)) / f.
+    PL_ASSIGN_OR_RETURN(ColumnIR * count_col,
+                        graph->CreateNode<ColumnIR>(ast, agg_expr.name, /*parent_op_idx*/ 0));
+    PL_ASSIGN_OR_RETURN(
+        FuncIR * sqrt_count,
+        graph->CreateNode<FuncIR>(ast, FuncIR::Op{FuncIR::Opcode::non_op, "", "sqrt"},
+                                  std::vector<ExpressionIR*>{count_col}));
+    PL_ASSIGN_OR_RETURN(
+        FuncIR * bound,
+        Multiply(graph, ast, sqrt_count, kZScore95 * std::sqrt(1 - fraction) / fraction));
+    exprs.emplace_back(agg_expr.name + "_ci95", bound);
+  }
+
+  std::vector<OperatorIR*> children = agg->Children();
+  PL_ASSIGN_OR_RETURN(MapIR * map, graph->CreateNode<MapIR>(ast, agg, exprs,
+                                                            /* keep_input_columns */ false));
+  for (OperatorIR* child : children) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(agg, map));
+  }
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Scales the counts and sums of the aggregates over a sampled MemorySource up to
+ * estimates for the whole table, and adds a `<name>_ci95` column with the 95% confidence bound of
+ * every count.
+ *
+ * The rule adds a Map after the aggregate rather than changing the aggregate itself, so the
+ * aggregate can still be split into partial and finalize aggregates. Only the aggregates that
+ * reach the source through Maps and Filters are scaled. The bound assumes that the rows are
+ * independent, which is rough when batches of rows are sampled together.
+ */
+class ScaleSampledAggregatesRule : public Rule {
+ public:
+  ScaleSampledAggregatesRule()
+      : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cmath>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/scale_sampled_aggregates_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::testing::ElementsAre;
+
+using ScaleSampledAggregatesRuleTest = RulesTest;
+
+TEST_F(ScaleSampledAggregatesRuleTest, scales_counts_and_sums) {
+  MemorySourceIR* src = MakeMemSource(MakeRelation());
+  src->set_sample_fraction(0.25);
+  BlockingAggIR* agg =
+      MakeBlockingAgg(src, {MakeColumn("count", 0)},
+                      {{"num", MakeCountFunc(MakeColumn("cpu0", 0))},
+                       {"total", MakeFunc("sum", {MakeColumn("cpu1", 0)})},
+                       {"avg", MakeMeanFunc(MakeColumn("cpu2", 0))}});
+  MemorySinkIR* sink = MakeMemSink(agg, "out");
+
+  ScaleSampledAggregatesRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ValueOrDie());
+
+  ASSERT_EQ(1, sink->parents().size());
+  ASSERT_MATCH(sink->parents()[0], Map());
+  auto map = static_cast<MapIR*>(sink->parents()[0]);
+  EXPECT_THAT(map->parents(), ElementsAre(agg));
+  EXPECT_FALSE(map->keep_input_columns());
+
+  const auto& exprs = map->col_exprs();
+  ASSERT_EQ(5, exprs.size());
+  EXPECT_EQ("count", exprs[0].name);
+  EXPECT_MATCH(exprs[0].node, ColumnNode("count"));
+  EXPECT_EQ("num", exprs[1].name);
+  ASSERT_MATCH(exprs[1].node, Func());
+  auto scaled_count = static_cast<FuncIR*>(exprs[1].node);
+  EXPECT_EQ("multiply", scaled_count->func_name());
+  ASSERT_MATCH(scaled_count->args()[1], Float());
+  EXPECT_DOUBLE_EQ(4, static_cast<FloatIR*>(scaled_count->args()[1])->val());
+  EXPECT_EQ("num_ci95", exprs[2].name);
+  ASSERT_MATCH(exprs[2].node, Func());
+  auto bound = static_cast<FuncIR*>(exprs[2].node);
+  ASSERT_MATCH(bound->args()[1], Float());
+  EXPECT_DOUBLE_EQ(1.96 * std::sqrt(0.75) * 4, static_cast<FloatIR*>(bound->args()[1])->val());
+  EXPECT_EQ("total", exprs[3].name);
+  EXPECT_MATCH(exprs[3].node, Func());
+  // Means don't depend on the sample size.
+  EXPECT_EQ("avg", exprs[4].name);
+  EXPECT_MATCH(exprs[4].node, ColumnNode("avg"));
+}
+
+TEST_F(ScaleSampledAggregatesRuleTest, unsampled_source) {
+  MemorySourceIR* src = MakeMemSource(MakeRelation());
+  BlockingAggIR* agg = MakeBlockingAgg(src, {MakeColumn("count", 0)},
+                                       {{"num", MakeCountFunc(MakeColumn("cpu0", 0))}});
+  MakeMemSink(agg, "out");
+
+  ScaleSampledAggregatesRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ValueOrDie());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
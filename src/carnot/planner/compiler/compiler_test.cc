@@ -580,9 +580,8 @@ nodes {
               }
             }
             args {
-              constant {
-                data_type: FLOAT64
-                float64_value: 0.5
+              column {
+                index: 1
               }
             }
             args_data_types: FLOAT64
@@ -628,7 +627,8 @@ class FilterTest : public CompilerTest,
         absl::StrJoin({"import px",
                        "queryDF = px.DataFrame(table='cpu', select=['cpu0', "
                        "'cpu1'])",
-                       "queryDF = queryDF[queryDF['cpu0'] $0 0.5]", "px.display(queryDF, '$1')"},
+                       "queryDF = queryDF[queryDF['cpu0'] $0 queryDF['cpu1']]",
+                       "px.display(queryDF, '$1')"},
                       "\n");
     query = absl::Substitute(query, compare_op_, table_name_);
     VLOG(2) << query;
@@ -657,6 +657,49 @@ TEST_P(FilterTest, basic) {
 
 INSTANTIATE_TEST_SUITE_P(FilterTestSuite, FilterTest, ::testing::ValuesIn(comparison_fns));
 
+constexpr char kPushedFilterQuery[] = R"pxl(
+import px
+queryDF = px.DataFrame(table='cpu', select=['cpu0', 'cpu1'])
+queryDF = queryDF[queryDF['cpu0'] >= 0.5]
+px.display(queryDF, 'range_table')
+)pxl";
+
+constexpr char kPushedFilterPlan[] = R"(
+nodes {
+  nodes {
+    op {
+      op_type: MEMORY_SOURCE_OPERATOR
+      mem_source_op {
+        name: "cpu"
+        column_idxs: 1
+        column_idxs: 2
+        predicates {
+          column_idx: 1
+          op: GE
+          value {
+            data_type: FLOAT64
+            float64_value: 0.5
+          }
+        }
+      }
+    }
+  }
+  nodes {
+    op {
+      op_type: GRPC_SINK_OPERATOR
+    }
+  }
+}
+)";
+
+TEST_F(CompilerTest, filter_pushed_into_memory_source) {
+  auto plan = compiler_.Compile(kPushedFilterQuery, compiler_state_.get());
+  ASSERT_OK(plan);
+  VLOG(2) << plan.ValueOrDie().DebugString();
+
+  EXPECT_THAT(plan.ConsumeValueOrDie(), Partially(EqualsProto(kPushedFilterPlan)));
+}
+
 TEST_F(CompilerTest, filter_errors) {
   std::string non_bool_filter =
       absl::StrJoin({"import px", "queryDF = px.DataFrame(table='cpu', select=['cpu0', 'cpu1'])",
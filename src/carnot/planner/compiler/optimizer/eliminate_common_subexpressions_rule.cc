@@ -0,0 +1,250 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/carnot/planner/compiler/optimizer/eliminate_common_subexpressions_rule.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// A function of an operator expression, with the Map, Filter or Func that holds it.
+struct FuncUse {
+  IRNode* parent;
+  FuncIR* func;
+};
+
+void CollectFuncs(IRNode* parent, ExpressionIR* expr, std::vector<FuncUse>* uses) {
+  if (!Match(expr, Func())) {
+    return;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  uses->push_back({parent, func});
+  for (ExpressionIR* arg : func->args()) {
+    CollectFuncs(func, arg, uses);
+  }
+}
+
+// Returns the functions of the expressions of op, outer functions first.
+std::vector<FuncUse> CollectOperatorFuncs(OperatorIR* op) {
+  std::vector<FuncUse> uses;
+  if (Match(op, Map())) {
+    for (const auto& col_expr : static_cast<MapIR*>(op)->col_exprs()) {
+      CollectFuncs(op, col_expr.node, &uses);
+    }
+  } else if (Match(op, Filter())) {
+    CollectFuncs(op, static_cast<FilterIR*>(op)->filter_expr(), &uses);
+  }
+  return uses;
+}
+
+std::vector<ExpressionIR*> OperatorExpressions(OperatorIR* op) {
+  std::vector<ExpressionIR*> exprs;
+  if (Match(op, Map())) {
+    for (const auto& col_expr : static_cast<MapIR*>(op)->col_exprs()) {
+      exprs.push_back(col_expr.node);
+    }
+  } else if (Match(op, Filter())) {
+    exprs.push_back(static_cast<FilterIR*>(op)->filter_expr());
+  }
+  return exprs;
+}
+
+// Creates a column that reads the value of expr from the parent of the operator.
+StatusOr<ColumnIR*> MakeColumnFor(ExpressionIR* expr, const std::string& col_name) {
+  PL_ASSIGN_OR_RETURN(ColumnIR * col, expr->graph()->CreateNode<ColumnIR>(
+                                          expr->ast(), col_name, /*parent_op_idx*/ 0));
+  col->ResolveColumnType(expr->EvaluatedDataType());
+  if (expr->is_type_resolved()) {
+    PL_RETURN_IF_ERROR(col->SetResolvedType(expr->resolved_type()));
+  }
+  return col;
+}
+
+std::string UniqueColumnName(FuncIR* func, absl::flat_hash_set<std::string>* used_column_names) {
+  std::string col_name;
+  auto idx = 0;
+  while (used_column_names->contains(
+      col_name = absl::Substitute("$0_$1", func->func_name(), idx++))) {
+    // Keep incrementing idx until we get a unique name.
+  }
+  used_column_names->insert(col_name);
+  return col_name;
+}
+
+// Replaces the outermost functions of expr that the parent Map computes with its columns.
+// The columns of a function must pass through the Map unchanged, or the function would read
+// different values on each side of the Map.
+StatusOr<bool> ReplaceWithMapColumns(IRNode* expr_parent, ExpressionIR* expr,
+                                     const std::vector<std::pair<std::string, FuncIR*>>& map_funcs,
+                                     const absl::flat_hash_set<std::string>& pass_through_cols) {
+  if (!Match(expr, Func())) {
+    return false;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  for (const auto& [col_name, map_func] : map_funcs) {
+    if (!func->Equals(map_func)) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(auto input_cols, func->InputColumnNames());
+    bool reads_pass_through_cols = true;
+    for (const auto& input_col : input_cols) {
+      reads_pass_through_cols &= pass_through_cols.contains(input_col);
+    }
+    if (!reads_pass_through_cols) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(ColumnIR * col, MakeColumnFor(func, col_name));
+    PL_RETURN_IF_ERROR(ReplaceExpression(expr_parent, func, col));
+    return true;
+  }
+
+  bool changed = false;
+  // Copy the args, replacing them updates the args of func.
+  std::vector<ExpressionIR*> args = func->args();
+  for (ExpressionIR* arg : args) {
+    PL_ASSIGN_OR_RETURN(bool arg_changed,
+                        ReplaceWithMapColumns(func, arg, map_funcs, pass_through_cols));
+    changed |= arg_changed;
+  }
+  return changed;
+}
+
+}  // namespace
+
+StatusOr<bool> EliminateCommonSubexpressionsRule::ReuseParentMapColumns(OperatorIR* op,
+                                                                        MapIR* parent_map) {
+  std::vector<std::pair<std::string, FuncIR*>> map_funcs;
+  absl::flat_hash_set<std::string> pass_through_cols;
+  for (const auto& col_expr : parent_map->col_exprs()) {
+    if (Match(col_expr.node, Func())) {
+      map_funcs.emplace_back(col_expr.name, static_cast<FuncIR*>(col_expr.node));
+    } else if (Match(col_expr.node, ColumnNode()) &&
+               static_cast<ColumnIR*>(col_expr.node)->col_name() == col_expr.name) {
+      pass_through_cols.insert(col_expr.name);
+    }
+  }
+  if (map_funcs.empty()) {
+    return false;
+  }
+
+  bool changed = false;
+  for (ExpressionIR* expr : OperatorExpressions(op)) {
+    PL_ASSIGN_OR_RETURN(bool expr_changed,
+                        ReplaceWithMapColumns(op, expr, map_funcs, pass_through_cols));
+    changed |= expr_changed;
+  }
+  return changed;
+}
+
+StatusOr<bool> EliminateCommonSubexpressionsRule::HoistRepeatedFuncs(OperatorIR* op) {
+  auto graph = op->graph();
+  auto parent = op->parents()[0];
+  const auto& parent_relation = parent->relation();
+
+  absl::flat_hash_set<std::string> used_column_names;
+  for (const auto& relation : {parent_relation, op->relation()}) {
+    for (const auto& col_name : relation.col_names()) {
+      used_column_names.insert(col_name);
+    }
+  }
+
+  MapIR* hoisted_map = nullptr;
+  while (true) {
+    // The functions are collected again after each hoist, since it deletes the copies.
+    std::vector<FuncUse> uses = CollectOperatorFuncs(op);
+    std::vector<FuncUse> repeats;
+    for (const auto& use : uses) {
+      repeats.clear();
+      for (const auto& other : uses) {
+        if (other.func->Equals(use.func)) {
+          repeats.push_back(other);
+        }
+      }
+      if (repeats.size() > 1) {
+        break;
+      }
+    }
+    if (repeats.size() <= 1) {
+      break;
+    }
+
+    if (hoisted_map == nullptr) {
+      PL_ASSIGN_OR_RETURN(hoisted_map,
+                          graph->CreateNode<MapIR>(op->ast(), parent, ColExpressionVector({}),
+                                                   /* keep_input_columns */ false));
+    }
+    FuncIR* func = repeats[0].func;
+    auto col_name = UniqueColumnName(func, &used_column_names);
+    PL_RETURN_IF_ERROR(hoisted_map->AddColExpr(ColumnExpression(col_name, func)));
+    for (const auto& repeat : repeats) {
+      PL_ASSIGN_OR_RETURN(ColumnIR * col, MakeColumnFor(func, col_name));
+      PL_RETURN_IF_ERROR(ReplaceExpression(repeat.parent, repeat.func, col));
+    }
+  }
+  if (hoisted_map == nullptr) {
+    return false;
+  }
+
+  // The new Map also passes on the other columns the operator reads.
+  PL_ASSIGN_OR_RETURN(auto required_inputs_per_parent, op->RequiredInputColumns());
+  for (const auto& required_input_col : required_inputs_per_parent[0]) {
+    if (!parent_relation.HasColumn(required_input_col)) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(auto col_node, graph->CreateNode<ColumnIR>(op->ast(), required_input_col,
+                                                                   /*parent_op_idx*/ 0));
+    col_node->ResolveColumnType(parent_relation);
+    PL_RETURN_IF_ERROR(hoisted_map->AddColExpr(ColumnExpression(required_input_col, col_node)));
+  }
+  PL_RETURN_IF_ERROR(hoisted_map->SetRelationFromExprs());
+  if (parent->is_type_resolved()) {
+    PL_RETURN_IF_ERROR(ResolveOperatorType(hoisted_map, compiler_state_));
+  }
+  PL_RETURN_IF_ERROR(op->ReplaceParent(parent, hoisted_map));
+  return true;
+}
+
+StatusOr<bool> EliminateCommonSubexpressionsRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Map()) && !Match(ir_node, Filter())) {
+    return false;
+  }
+  auto op = static_cast<OperatorIR*>(ir_node);
+  if (op->parents().size() != 1) {
+    return false;
+  }
+
+  bool changed = false;
+  auto parent = op->parents()[0];
+  if (Match(parent, Map())) {
+    PL_ASSIGN_OR_RETURN(changed, ReuseParentMapColumns(op, static_cast<MapIR*>(parent)));
+  }
+  PL_ASSIGN_OR_RETURN(bool hoisted, HoistRepeatedFuncs(op));
+  return changed || hoisted;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Evaluates each distinct function of a Map or Filter once, eg. a metadata lookup that is
+ * used by several columns of a Map.
+ *
+ * Functions that the parent Map of the operator already computes are replaced with the column of
+ * the Map. Functions that the operator computes more than once are moved into a new Map before the
+ * operator, and replaced with the columns of that Map.
+ */
+class EliminateCommonSubexpressionsRule : public Rule {
+ public:
+  explicit EliminateCommonSubexpressionsRule(CompilerState* compiler_state)
+      : Rule(compiler_state, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  StatusOr<bool> ReuseParentMapColumns(OperatorIR* op, MapIR* parent_map);
+  StatusOr<bool> HoistRepeatedFuncs(OperatorIR* op);
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "src/carnot/planner/compiler/optimizer/eliminate_common_subexpressions_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::testing::UnorderedElementsAre;
+using EliminateCommonSubexpressionsRuleTest = RulesTest;
+
+TEST_F(EliminateCommonSubexpressionsRuleTest, reuses_parent_map_column) {
+  auto relation = MakeRelation();
+  MemorySourceIR* mem_src = MakeMemSource(relation);
+  auto half = MakeMultFunc(MakeColumn("cpu0", 0, relation), MakeFloat(0.5));
+  half->SetOutputDataType(types::FLOAT64);
+  auto parent_map = MakeMap(mem_src, {{"cpu0", MakeColumn("cpu0", 0, relation)}, {"half", half}});
+  ASSERT_OK(parent_map->SetRelationFromExprs());
+
+  auto half_again = MakeMultFunc(MakeColumn("cpu0", 0, relation), MakeFloat(0.5));
+  half_again->SetOutputDataType(types::FLOAT64);
+  auto add = MakeAddFunc(half_again, MakeFloat(1));
+  add->SetOutputDataType(types::FLOAT64);
+  auto map = MakeMap(parent_map, {{"x", add}});
+  MakeMemSink(map, "out");
+
+  EliminateCommonSubexpressionsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  EXPECT_EQ(std::vector<OperatorIR*>{parent_map}, map->parents());
+  ASSERT_EQ(add, map->col_exprs()[0].node);
+  ASSERT_MATCH(add->args()[0], ColumnNode("half", 0));
+  EXPECT_EQ(types::FLOAT64, add->args()[0]->EvaluatedDataType());
+}
+
+TEST_F(EliminateCommonSubexpressionsRuleTest, parent_map_changes_input_column) {
+  auto relation = MakeRelation();
+  MemorySourceIR* mem_src = MakeMemSource(relation);
+  auto half = MakeMultFunc(MakeColumn("cpu0", 0, relation), MakeFloat(0.5));
+  half->SetOutputDataType(types::FLOAT64);
+  // cpu0 is a different column on each side of the map.
+  auto parent_map = MakeMap(mem_src, {{"cpu0", MakeColumn("cpu1", 0, relation)}, {"half", half}});
+  ASSERT_OK(parent_map->SetRelationFromExprs());
+
+  auto half_again = MakeMultFunc(MakeColumn("cpu0", 0, relation), MakeFloat(0.5));
+  half_again->SetOutputDataType(types::FLOAT64);
+  auto map = MakeMap(parent_map, {{"x", half_again}});
+  MakeMemSink(map, "out");
+
+  EliminateCommonSubexpressionsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(half_again, map->col_exprs()[0].node);
+}
+
+TEST_F(EliminateCommonSubexpressionsRuleTest, hoists_repeated_filter_func) {
+  auto relation = MakeRelation();
+  MemorySourceIR* mem_src = MakeMemSource(relation);
+  auto pod1 = MakeFunc("upid_to_pod_name", {MakeColumn("count", 0, relation)}, types::STRING);
+  auto pod2 = MakeFunc("upid_to_pod_name", {MakeColumn("count", 0, relation)}, types::STRING);
+  auto eq1 = MakeEqualsFunc(pod1, MakeString("pl/a"));
+  auto eq2 = MakeEqualsFunc(pod2, MakeString("pl/b"));
+  auto filter = MakeFilter(mem_src, MakeOrFunc(eq1, eq2));
+  ASSERT_OK(filter->SetRelation(relation));
+  MakeMemSink(filter, "out");
+
+  EliminateCommonSubexpressionsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  ASSERT_EQ(1, filter->parents().size());
+  ASSERT_MATCH(filter->parents()[0], Map());
+  auto hoisted_map = static_cast<MapIR*>(filter->parents()[0]);
+  EXPECT_EQ(std::vector<OperatorIR*>{mem_src}, hoisted_map->parents());
+  EXPECT_EQ(pod1, hoisted_map->col_exprs()[0].node);
+  EXPECT_EQ("upid_to_pod_name_0", hoisted_map->col_exprs()[0].name);
+  // The columns the filter passes on are kept.
+  EXPECT_THAT(hoisted_map->relation().col_names(),
+              UnorderedElementsAre("upid_to_pod_name_0", "count", "cpu0", "cpu1", "cpu2"));
+
+  EXPECT_MATCH(eq1->args()[0], ColumnNode("upid_to_pod_name_0", 0));
+  EXPECT_MATCH(eq2->args()[0], ColumnNode("upid_to_pod_name_0", 0));
+
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
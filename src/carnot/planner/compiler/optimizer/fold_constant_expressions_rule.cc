@@ -0,0 +1,243 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "src/carnot/planner/compiler/optimizer/fold_constant_expressions_rule.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// The value of a literal argument of a folded function.
+struct Literal {
+  types::DataType type;
+  int64_t int_val = 0;
+  double float_val = 0;
+  bool bool_val = false;
+
+  double AsFloat() const { return type == types::FLOAT64 ? float_val : int_val; }
+};
+
+std::optional<Literal> GetLiteral(ExpressionIR* expr) {
+  if (Match(expr, Int())) {
+    return Literal{types::INT64, static_cast<IntIR*>(expr)->val()};
+  }
+  if (Match(expr, Float())) {
+    return Literal{types::FLOAT64, 0, static_cast<FloatIR*>(expr)->val()};
+  }
+  if (Match(expr, Bool())) {
+    return Literal{types::BOOLEAN, 0, 0, static_cast<BoolIR*>(expr)->val()};
+  }
+  return std::nullopt;
+}
+
+bool IsNumeric(const Literal& literal) {
+  return literal.type == types::INT64 || literal.type == types::FLOAT64;
+}
+
+// Evaluates an arithmetic function on integers. Returns nullopt on overflow, so that the overflow
+// still happens the same way at runtime.
+std::optional<int64_t> EvaluateInt(FuncIR::Opcode opcode, int64_t a, int64_t b) {
+  int64_t result = 0;
+  bool overflow = false;
+  switch (opcode) {
+    case FuncIR::add:
+      overflow = __builtin_add_overflow(a, b, &result);
+      break;
+    case FuncIR::sub:
+      overflow = __builtin_sub_overflow(a, b, &result);
+      break;
+    case FuncIR::mult:
+      overflow = __builtin_mul_overflow(a, b, &result);
+      break;
+    default:
+      return std::nullopt;
+  }
+  if (overflow) {
+    return std::nullopt;
+  }
+  return result;
+}
+
+std::optional<double> EvaluateFloat(FuncIR::Opcode opcode, double a, double b) {
+  switch (opcode) {
+    case FuncIR::add:
+      return a + b;
+    case FuncIR::sub:
+      return a - b;
+    case FuncIR::mult:
+      return a * b;
+    default:
+      return std::nullopt;
+  }
+}
+
+template <typename T>
+std::optional<bool> EvaluateComparison(FuncIR::Opcode opcode, T a, T b) {
+  switch (opcode) {
+    case FuncIR::eq:
+      return a == b;
+    case FuncIR::neq:
+      return a != b;
+    case FuncIR::lt:
+      return a < b;
+    case FuncIR::lteq:
+      return a <= b;
+    case FuncIR::gt:
+      return a > b;
+    case FuncIR::gteq:
+      return a >= b;
+    default:
+      return std::nullopt;
+  }
+}
+
+}  // namespace
+
+StatusOr<ExpressionIR*> FoldConstantExpressionsRule::EvaluateFunc(FuncIR* func) {
+  if (!func->IsDataTypeEvaluated()) {
+    return nullptr;
+  }
+  std::vector<Literal> args;
+  for (ExpressionIR* arg : func->args()) {
+    auto literal = GetLiteral(arg);
+    if (!literal.has_value()) {
+      return nullptr;
+    }
+    args.push_back(*literal);
+  }
+
+  auto graph = func->graph();
+  auto opcode = func->opcode();
+  // The result must have the type the func was resolved to, eg. so that time arithmetic isn't
+  // folded into a plain integer.
+  auto out_type = func->EvaluatedDataType();
+  ExpressionIR* folded = nullptr;
+  if (args.size() == 1) {
+    const auto& arg = args[0];
+    if (opcode == FuncIR::negate && arg.type == types::INT64 && out_type == types::INT64 &&
+        arg.int_val != std::numeric_limits<int64_t>::min()) {
+      PL_ASSIGN_OR_RETURN(folded, graph->CreateNode<IntIR>(func->ast(), -arg.int_val));
+    } else if (opcode == FuncIR::negate && arg.type == types::FLOAT64 &&
+               out_type == types::FLOAT64) {
+      PL_ASSIGN_OR_RETURN(folded, graph->CreateNode<FloatIR>(func->ast(), -arg.float_val));
+    } else if (opcode == FuncIR::lognot && arg.type == types::BOOLEAN &&
+               out_type == types::BOOLEAN) {
+      PL_ASSIGN_OR_RETURN(folded, graph->CreateNode<BoolIR>(func->ast(), !arg.bool_val));
+    }
+  } else if (args.size() == 2) {
+    const auto& a = args[0];
+    const auto& b = args[1];
+    bool both_ints = a.type == types::INT64 && b.type == types::INT64;
+    bool both_numeric = IsNumeric(a) && IsNumeric(b);
+    bool both_bools = a.type == types::BOOLEAN && b.type == types::BOOLEAN;
+    if (out_type == types::INT64 && both_ints) {
+      auto result = EvaluateInt(opcode, a.int_val, b.int_val);
+      if (result.has_value()) {
+        PL_ASSIGN_OR_RETURN(folded, graph->CreateNode<IntIR>(func->ast(), *result));
+      }
+    } else if (out_type == types::FLOAT64 && both_numeric) {
+      auto result = EvaluateFloat(opcode, a.AsFloat(), b.AsFloat());
+      if (result.has_value()) {
+        PL_ASSIGN_OR_RETURN(folded, graph->CreateNode<FloatIR>(func->ast(), *result));
+      }
+    } else if (out_type == types::BOOLEAN && both_bools &&
+               (opcode == FuncIR::logand || opcode == FuncIR::logor)) {
+      bool result = opcode == FuncIR::logand ? a.bool_val && b.bool_val : a.bool_val || b.bool_val;
+      PL_ASSIGN_OR_RETURN(folded, graph->CreateNode<BoolIR>(func->ast(), result));
+    } else if (out_type == types::BOOLEAN && both_numeric) {
+      auto result = both_ints ? EvaluateComparison(opcode, a.int_val, b.int_val)
+                              : EvaluateComparison(opcode, a.AsFloat(), b.AsFloat());
+      if (result.has_value()) {
+        PL_ASSIGN_OR_RETURN(folded, graph->CreateNode<BoolIR>(func->ast(), *result));
+      }
+    }
+  }
+  if (folded != nullptr && func->is_type_resolved()) {
+    PL_RETURN_IF_ERROR(folded->SetResolvedType(func->resolved_type()));
+  }
+  return folded;
+}
+
+StatusOr<ExpressionIR*> FoldConstantExpressionsRule::FoldExpression(IRNode* expr_parent,
+                                                                    ExpressionIR* expr,
+                                                                    bool* changed) {
+  if (!Match(expr, Func())) {
+    return expr;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  // Copy the args, folding them updates the args of func.
+  std::vector<ExpressionIR*> args = func->args();
+  for (ExpressionIR* arg : args) {
+    PL_RETURN_IF_ERROR(FoldExpression(func, arg, changed));
+  }
+
+  PL_ASSIGN_OR_RETURN(ExpressionIR * folded, EvaluateFunc(func));
+  if (folded == nullptr) {
+    return expr;
+  }
+  PL_RETURN_IF_ERROR(ReplaceExpression(expr_parent, func, folded));
+  *changed = true;
+  return folded;
+}
+
+StatusOr<bool> FoldConstantExpressionsRule::RemoveTrueFilter(FilterIR* filter) {
+  auto expr = filter->filter_expr();
+  if (!Match(expr, Bool()) || !static_cast<BoolIR*>(expr)->val()) {
+    return false;
+  }
+  DCHECK_EQ(filter->parents().size(), 1UL);
+  auto parent = filter->parents()[0];
+  for (OperatorIR* child : filter->Children()) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(filter, parent));
+  }
+  PL_RETURN_IF_ERROR(filter->RemoveParent(parent));
+  PL_RETURN_IF_ERROR(filter->graph()->DeleteSubtree(filter->id()));
+  return true;
+}
+
+StatusOr<bool> FoldConstantExpressionsRule::Apply(IRNode* ir_node) {
+  bool changed = false;
+  if (Match(ir_node, Map())) {
+    auto map = static_cast<MapIR*>(ir_node);
+    // Copy the expressions, folding them updates the map.
+    ColExpressionVector col_exprs = map->col_exprs();
+    for (const auto& col_expr : col_exprs) {
+      PL_RETURN_IF_ERROR(FoldExpression(map, col_expr.node, &changed));
+    }
+    return changed;
+  }
+  if (Match(ir_node, Filter())) {
+    auto filter = static_cast<FilterIR*>(ir_node);
+    PL_RETURN_IF_ERROR(FoldExpression(filter, filter->filter_expr(), &changed));
+    PL_ASSIGN_OR_RETURN(bool removed, RemoveTrueFilter(filter));
+    return changed || removed;
+  }
+  return false;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Evaluates the arithmetic, comparison and logical functions of Map and Filter expressions
+ * whose arguments are all literals, and replaces them with the literal result. Filters whose
+ * expression folds to true are removed.
+ *
+ * Only the operators with a known result are folded, other UDFs can't be run in the planner.
+ */
+class FoldConstantExpressionsRule : public Rule {
+ public:
+  FoldConstantExpressionsRule()
+      : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  // Folds the functions of expr bottom up, replacing them in expr_parent. Returns the expression
+  // that ends up in place of expr.
+  StatusOr<ExpressionIR*> FoldExpression(IRNode* expr_parent, ExpressionIR* expr, bool* changed);
+  // Returns the folded value of func, or nullptr if it can't be folded.
+  StatusOr<ExpressionIR*> EvaluateFunc(FuncIR* func);
+  StatusOr<bool> RemoveTrueFilter(FilterIR* filter);
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <vector>
+
+#include "src/carnot/planner/compiler/optimizer/fold_constant_expressions_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using FoldConstantExpressionsRuleTest = RulesTest;
+
+TEST_F(FoldConstantExpressionsRuleTest, folds_nested_arithmetic) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto mult = MakeMultFunc(MakeInt(2), MakeInt(3));
+  mult->SetOutputDataType(types::INT64);
+  auto add = MakeAddFunc(MakeInt(1), mult);
+  add->SetOutputDataType(types::INT64);
+  auto scaled = MakeMultFunc(MakeColumn("cpu0", 0, types::FLOAT64), MakeFloat(0.5));
+  scaled->SetOutputDataType(types::FLOAT64);
+  auto map = MakeMap(mem_src, {{"x", add}, {"y", scaled}});
+  MakeMemSink(map, "out");
+
+  FoldConstantExpressionsRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  auto x = map->col_exprs()[0].node;
+  ASSERT_MATCH(x, Int());
+  EXPECT_EQ(7, static_cast<IntIR*>(x)->val());
+  // Functions of columns are kept.
+  EXPECT_EQ(scaled, map->col_exprs()[1].node);
+
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(FoldConstantExpressionsRuleTest, keeps_overflowing_arithmetic) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto add = MakeAddFunc(MakeInt(std::numeric_limits<int64_t>::max()), MakeInt(1));
+  add->SetOutputDataType(types::INT64);
+  auto map = MakeMap(mem_src, {{"x", add}});
+  MakeMemSink(map, "out");
+
+  FoldConstantExpressionsRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(add, map->col_exprs()[0].node);
+}
+
+TEST_F(FoldConstantExpressionsRuleTest, removes_true_filter) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto eq = MakeEqualsFunc(MakeInt(1), MakeInt(1));
+  eq->SetOutputDataType(types::BOOLEAN);
+  auto filter = MakeFilter(mem_src, eq);
+  auto filter_id = filter->id();
+  auto sink = MakeMemSink(filter, "out");
+
+  FoldConstantExpressionsRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_FALSE(graph->HasNode(filter_id));
+  EXPECT_EQ(std::vector<OperatorIR*>{mem_src}, sink->parents());
+}
+
+TEST_F(FoldConstantExpressionsRuleTest, keeps_false_filter) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto lt = MakeFunc("lessThan", {MakeInt(2), MakeInt(1)}, types::BOOLEAN);
+  auto filter = MakeFilter(mem_src, lt);
+  MakeMemSink(filter, "out");
+
+  FoldConstantExpressionsRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  // lessThan isn't a builtin operator here, so it isn't folded.
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+
+  auto gt = graph
+                ->CreateNode<FuncIR>(ast, FuncIR::op_map.find(">")->second,
+                                     std::vector<ExpressionIR*>({MakeInt(2), MakeInt(1)}))
+                .ConsumeValueOrDie();
+  gt->SetOutputDataType(types::BOOLEAN);
+  auto lognot = graph
+                    ->CreateNode<FuncIR>(ast, FuncIR::unary_op_map.find("not")->second,
+                                         std::vector<ExpressionIR*>({gt}))
+                    .ConsumeValueOrDie();
+  lognot->SetOutputDataType(types::BOOLEAN);
+  ASSERT_OK(filter->SetFilterExpr(lognot));
+
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  ASSERT_MATCH(filter->filter_expr(), Bool());
+  EXPECT_FALSE(static_cast<BoolIR*>(filter->filter_expr())->val());
+  EXPECT_EQ(std::vector<OperatorIR*>{filter}, mem_src->Children());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/optimizer/join_build_side_rule.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// The rows of a table, which can hold anything up to the table store limits.
+constexpr double kTableRows = 1e9;
+// The rows of a UDTF, which mostly return one row per agent, pod, service, etc.
+constexpr double kUDTFRows = 1e4;
+// The rows of an aggregate with groups, which usually are entities like pods or endpoints.
+constexpr double kGroupedAggRows = 1e5;
+// The fraction of rows a filter is assumed to keep.
+constexpr double kFilterSelectivity = 0.5;
+
+}  // namespace
+
+double JoinBuildSideRule::EstimateRows(const OperatorIR* op, const CompilerState* compiler_state) {
+  absl::flat_hash_map<int64_t, double> memo;
+  return EstimateRows(op, compiler_state, &memo);
+}
+
+double JoinBuildSideRule::EstimateRows(const OperatorIR* op, const CompilerState* compiler_state,
+                                       absl::flat_hash_map<int64_t, double>* memo) {
+  auto it = memo->find(op->id());
+  if (it != memo->end()) {
+    return it->second;
+  }
+
+  std::vector<double> parent_rows;
+  for (const OperatorIR* parent : op->parents()) {
+    parent_rows.push_back(EstimateRows(parent, compiler_state, memo));
+  }
+
+  double rows = kTableRows;
+  if (Match(op, EmptySource())) {
+    rows = 0;
+  } else if (Match(op, UDTFSource())) {
+    rows = kUDTFRows;
+  } else if (Match(op, MemorySource()) && compiler_state != nullptr) {
+    const auto& estimates = compiler_state->table_row_estimates();
+    auto estimate = estimates.find(static_cast<const MemorySourceIR*>(op)->table_name());
+    rows = estimate != estimates.end() ? estimate->second : kTableRows;
+  } else if (parent_rows.empty()) {
+    rows = kTableRows;
+  } else if (Match(op, BlockingAgg())) {
+    bool has_groups = !static_cast<const BlockingAggIR*>(op)->groups().empty();
+    rows = has_groups ? std::min(parent_rows[0], kGroupedAggRows) : 1;
+  } else if (Match(op, Limit())) {
+    auto limit = static_cast<const LimitIR*>(op);
+    rows = limit->limit_value_set()
+               ? std::min(parent_rows[0], static_cast<double>(limit->limit_value()))
+               : parent_rows[0];
+  } else if (Match(op, Sort())) {
+    auto sort = static_cast<const SortIR*>(op);
+    rows = sort->limit() > 0 ? std::min(parent_rows[0], static_cast<double>(sort->limit()))
+                             : parent_rows[0];
+  } else if (Match(op, Filter())) {
+    rows = parent_rows[0] * kFilterSelectivity;
+  } else if (Match(op, Union())) {
+    rows = 0;
+    for (double r : parent_rows) {
+      rows += r;
+    }
+  } else {
+    // Joins output about as many rows as their biggest parent, the other operators as many as
+    // their parent.
+    rows = *std::max_element(parent_rows.begin(), parent_rows.end());
+  }
+  (*memo)[op->id()] = rows;
+  return rows;
+}
+
+StatusOr<bool> JoinBuildSideRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Join())) {
+    return false;
+  }
+  auto join = static_cast<JoinIR*>(ir_node);
+  DCHECK_EQ(join->parents().size(), 2UL);
+  absl::flat_hash_map<int64_t, double> memo;
+  double left_rows = EstimateRows(join->parents()[0], compiler_state_, &memo);
+  double right_rows = EstimateRows(join->parents()[1], compiler_state_, &memo);
+  int64_t build_parent_index = right_rows < left_rows ? 1 : 0;
+  if (build_parent_index == join->build_parent_index()) {
+    return false;
+  }
+  join->SetBuildParentIndex(build_parent_index);
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
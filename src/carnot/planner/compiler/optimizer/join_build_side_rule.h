@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Picks the side of each join that the executor builds its hash table on, from rough
+ * estimates of the number of rows of each parent. Buffering the small side, for example a
+ * metadata UDTF or an aggregate, saves holding a whole table in memory.
+ *
+ * Tables are assumed to be big unless earlier queries reported how many rows they read from them
+ * (see CompilerState::table_row_estimates), and the operators known to shrink their input
+ * (aggregates, limits, filters) or to return few rows (UDTFs) bound the estimates. The left side
+ * stays the build side unless the right one is estimated smaller.
+ */
+class JoinBuildSideRule : public Rule {
+ public:
+  explicit JoinBuildSideRule(CompilerState* compiler_state = nullptr)
+      : Rule(compiler_state, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+  /**
+   * @brief Estimates the number of rows the operator outputs, using the table row estimates of
+   * the compiler state if there is one.
+   */
+  static double EstimateRows(const OperatorIR* op, const CompilerState* compiler_state = nullptr);
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  static double EstimateRows(const OperatorIR* op, const CompilerState* compiler_state,
+                             absl::flat_hash_map<int64_t, double>* memo);
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
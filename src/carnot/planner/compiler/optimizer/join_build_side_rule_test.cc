@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/optimizer/join_build_side_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using JoinBuildSideRuleTest = RulesTest;
+
+TEST_F(JoinBuildSideRuleTest, estimate_rows) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto limit = MakeLimit(mem_src, 10);
+  auto agg = MakeBlockingAgg(mem_src, {}, {{"mean", MakeMeanFunc(MakeColumn("cpu0", 0))}});
+  auto filter = MakeFilter(mem_src, MakeEqualsFunc(MakeColumn("count", 0), MakeInt(2)));
+
+  double table_rows = JoinBuildSideRule::EstimateRows(mem_src);
+  EXPECT_EQ(10, JoinBuildSideRule::EstimateRows(limit));
+  EXPECT_EQ(1, JoinBuildSideRule::EstimateRows(agg));
+  EXPECT_LT(JoinBuildSideRule::EstimateRows(filter), table_rows);
+}
+
+TEST_F(JoinBuildSideRuleTest, builds_on_smaller_right_side) {
+  MemorySourceIR* mem_src1 = MakeMemSource(MakeRelation());
+  MemorySourceIR* mem_src2 = MakeMemSource(MakeRelation());
+  auto agg = MakeBlockingAgg(mem_src2, {MakeColumn("count", 0)},
+                             {{"mean", MakeMeanFunc(MakeColumn("cpu0", 0))}});
+  auto join = MakeJoin({mem_src1, agg}, "inner", {MakeColumn("count", 0)},
+                       {MakeColumn("count", 1)});
+  MakeMemSink(join, "out");
+
+  JoinBuildSideRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_EQ(1, join->build_parent_index());
+
+  // Running again doesn't change anything.
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(JoinBuildSideRuleTest, keeps_left_side_when_not_larger) {
+  MemorySourceIR* mem_src1 = MakeMemSource(MakeRelation());
+  MemorySourceIR* mem_src2 = MakeMemSource(MakeRelation());
+  auto limit = MakeLimit(mem_src1, 100);
+  auto join = MakeJoin({limit, mem_src2}, "inner", {MakeColumn("count", 0)},
+                       {MakeColumn("count", 1)});
+  auto same_size_join = MakeJoin({mem_src1, mem_src2}, "inner", {MakeColumn("count", 0)},
+                            {MakeColumn("count", 1)});
+  MakeMemSink(join, "out");
+  MakeMemSink(same_size_join, "out2");
+
+  JoinBuildSideRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(0, join->build_parent_index());
+  EXPECT_EQ(0, same_size_join->build_parent_index());
+}
+
+TEST_F(JoinBuildSideRuleTest, uses_table_row_estimates) {
+  MemorySourceIR* big_src = MakeMemSource("big", MakeRelation());
+  MemorySourceIR* small_src = MakeMemSource("small", MakeRelation());
+  auto join = MakeJoin({big_src, small_src}, "inner", {MakeColumn("count", 0)},
+                       {MakeColumn("count", 1)});
+  MakeMemSink(join, "out");
+  compiler_state_->set_table_row_estimates({{"big", 1e6}, {"small", 100}});
+
+  EXPECT_EQ(100, JoinBuildSideRule::EstimateRows(small_src, compiler_state_.get()));
+  // Tables without an estimate are assumed to be big.
+  EXPECT_EQ(JoinBuildSideRule::EstimateRows(big_src),
+            JoinBuildSideRule::EstimateRows(MakeMemSource("other", MakeRelation()),
+                                            compiler_state_.get()));
+
+  JoinBuildSideRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_EQ(1, join->build_parent_index());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "src/carnot/planner/compiler/optimizer/merge_limit_into_sort_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using MergeLimitIntoSortRuleTest = RulesTest;
+
+TEST_F(MergeLimitIntoSortRuleTest, sets_sort_limit) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto sort = MakeSort(mem_src, {MakeColumn("cpu0", 0)}, {false});
+  auto limit = MakeLimit(sort, 10);
+  MakeMemSink(limit, "out");
+
+  MergeLimitIntoSortRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_EQ(10, sort->limit());
+  // The limit is kept.
+  EXPECT_EQ(std::vector<OperatorIR*>{limit}, sort->Children());
+
+  // A larger limit doesn't raise the sort limit.
+  auto limit2 = MakeLimit(limit, 20);
+  MakeMemSink(limit2, "out2");
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(10, sort->limit());
+}
+
+TEST_F(MergeLimitIntoSortRuleTest, sort_with_other_children) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto sort = MakeSort(mem_src, {MakeColumn("cpu0", 0)}, {false});
+  auto limit = MakeLimit(sort, 10);
+  MakeMemSink(limit, "out");
+  MakeMemSink(sort, "all");
+
+  MergeLimitIntoSortRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(0, sort->limit());
+}
+
+TEST_F(MergeLimitIntoSortRuleTest, pem_only_limit) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto sort = MakeSort(mem_src, {MakeColumn("cpu0", 0)}, {false});
+  auto limit = MakeLimit(sort, 10, /*pem_only*/ true);
+  MakeMemSink(limit, "out");
+
+  MergeLimitIntoSortRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(0, sort->limit());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -23,9 +23,14 @@
 #include <unordered_set>
 #include <vector>
 
+#include "src/carnot/planner/compiler/optimizer/eliminate_common_subexpressions_rule.h"
+#include "src/carnot/planner/compiler/optimizer/fold_constant_expressions_rule.h"
+#include "src/carnot/planner/compiler/optimizer/join_build_side_rule.h"
+#include "src/carnot/planner/compiler/optimizer/merge_limit_into_sort_rule.h"
 #include "src/carnot/planner/compiler/optimizer/merge_nodes_rule.h"
 #include "src/carnot/planner/compiler/optimizer/prune_unconnected_operators_rule.h"
 #include "src/carnot/planner/compiler/optimizer/prune_unused_columns_rule.h"
+#include "src/carnot/planner/compiler/optimizer/push_filter_into_memory_source_rule.h"
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/compiler_state/registry_info.h"
 #include "src/carnot/planner/ir/ir_nodes.h"
@@ -57,15 +62,40 @@ class Optimizer : public RuleExecutor<IR> {
     merge_nodes_batch->AddRule<MergeNodesRule>(compiler_state_);
   }
 
+  void CreatePushFilterIntoMemorySourceBatch() {
+    RuleBatch* push_filter_batch = CreateRuleBatch<TryUntilMax>("PushFilterIntoMemorySource", 1);
+    push_filter_batch->AddRule<PushFilterIntoMemorySourceRule>();
+  }
+
+  void CreateSimplifyExpressionsBatch() {
+    RuleBatch* simplify_expressions = CreateRuleBatch<TryUntilMax>("SimplifyExpressions", 2);
+    simplify_expressions->AddRule<FoldConstantExpressionsRule>();
+    simplify_expressions->AddRule<EliminateCommonSubexpressionsRule>(compiler_state_);
+  }
+
   void CreatePruneUnusedColumnsBatch() {
     RuleBatch* prune_unused_columns = CreateRuleBatch<FailOnMax>("PruneUnusedColumns", 2);
     prune_unused_columns->AddRule<PruneUnusedColumnsRule>();
   }
 
+  void CreateMergeLimitIntoSortBatch() {
+    RuleBatch* merge_limit_into_sort = CreateRuleBatch<TryUntilMax>("MergeLimitIntoSort", 1);
+    merge_limit_into_sort->AddRule<MergeLimitIntoSortRule>();
+  }
+
+  void CreateJoinBuildSideBatch() {
+    RuleBatch* join_build_side = CreateRuleBatch<TryUntilMax>("JoinBuildSide", 1);
+    join_build_side->AddRule<JoinBuildSideRule>(compiler_state_);
+  }
+
   Status Init() {
     CreatePruneUnconnectedOpsBatch();
     CreateMergeNodesBatch();
+    CreatePushFilterIntoMemorySourceBatch();
+    CreateSimplifyExpressionsBatch();
     CreatePruneUnusedColumnsBatch();
+    CreateMergeLimitIntoSortBatch();
+    CreateJoinBuildSideBatch();
     return Status::OK();
   }
 
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/optimizer/push_filter_into_memory_source_rule.h"
+
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/util/message_differencer.h>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+using planpb::ColumnPredicate;
+
+// Returns the predicate op for `col <op> literal`, or OP_UNKNOWN if the opcode is not a
+// comparison. If the literal is on the left, the comparison is flipped.
+ColumnPredicate::Op PredicateOp(FuncIR::Opcode opcode, bool literal_on_left) {
+  switch (opcode) {
+    case FuncIR::Opcode::eq:
+      return ColumnPredicate::EQ;
+    case FuncIR::Opcode::neq:
+      return ColumnPredicate::NE;
+    case FuncIR::Opcode::lt:
+      return literal_on_left ? ColumnPredicate::GT : ColumnPredicate::LT;
+    case FuncIR::Opcode::lteq:
+      return literal_on_left ? ColumnPredicate::GE : ColumnPredicate::LE;
+    case FuncIR::Opcode::gt:
+      return literal_on_left ? ColumnPredicate::LT : ColumnPredicate::GT;
+    case FuncIR::Opcode::gteq:
+      return literal_on_left ? ColumnPredicate::LE : ColumnPredicate::GE;
+    default:
+      return ColumnPredicate::OP_UNKNOWN;
+  }
+}
+
+// Whether the source can compare a column of column_type against a literal of literal_type with
+// the same result as the filter.
+bool CanPush(types::DataType column_type, types::DataType literal_type, ColumnPredicate::Op op) {
+  switch (column_type) {
+    case types::INT64:
+    case types::FLOAT64:
+    case types::STRING:
+      return literal_type == column_type;
+    case types::TIME64NS:
+      return literal_type == types::TIME64NS || literal_type == types::INT64;
+    case types::BOOLEAN:
+    case types::UINT128:
+      return literal_type == column_type &&
+             (op == ColumnPredicate::EQ || op == ColumnPredicate::NE);
+    default:
+      return false;
+  }
+}
+
+// Converts a single comparison into a predicate on the table column. Returns false if the
+// expression can't be pushed.
+StatusOr<bool> ToPredicate(MemorySourceIR* source, ExpressionIR* expr, ColumnPredicate* pred) {
+  if (!Match(expr, Func())) {
+    return false;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  if (func->args().size() != 2) {
+    return false;
+  }
+  ExpressionIR* left = func->args()[0];
+  ExpressionIR* right = func->args()[1];
+  bool literal_on_left = Match(left, DataNode()) && Match(right, ColumnNode());
+  if (literal_on_left) {
+    std::swap(left, right);
+  }
+  if (!Match(left, ColumnNode()) || !Match(right, DataNode())) {
+    return false;
+  }
+  auto op = PredicateOp(func->opcode(), literal_on_left);
+  if (op == ColumnPredicate::OP_UNKNOWN) {
+    return false;
+  }
+
+  auto column = static_cast<ColumnIR*>(left);
+  auto literal = static_cast<DataIR*>(right);
+  const auto& relation = source->relation();
+  if (!relation.HasColumn(column->col_name())) {
+    return false;
+  }
+  int64_t output_idx = relation.GetColumnIndex(column->col_name());
+  if (!CanPush(relation.GetColumnType(output_idx), literal->EvaluatedDataType(), op)) {
+    return false;
+  }
+
+  pred->set_column_idx(source->column_index_map()[output_idx]);
+  pred->set_op(op);
+  PL_RETURN_IF_ERROR(literal->ToProto(pred->mutable_value()));
+  return true;
+}
+
+// Splits an `and` tree into its conjuncts.
+void CollectConjuncts(ExpressionIR* expr, std::vector<ExpressionIR*>* conjuncts) {
+  if (Match(expr, Func()) && static_cast<FuncIR*>(expr)->opcode() == FuncIR::Opcode::logand) {
+    for (ExpressionIR* arg : static_cast<FuncIR*>(expr)->args()) {
+      CollectConjuncts(arg, conjuncts);
+    }
+    return;
+  }
+  conjuncts->push_back(expr);
+}
+
+}  // namespace
+
+StatusOr<bool> PushFilterIntoMemorySourceRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Filter())) {
+    return false;
+  }
+  auto filter = static_cast<FilterIR*>(ir_node);
+  if (filter->parents().size() != 1 || !Match(filter->parents()[0], MemorySource())) {
+    return false;
+  }
+  auto source = static_cast<MemorySourceIR*>(filter->parents()[0]);
+  // The predicates apply to everything read by the source, so other consumers would lose rows.
+  if (source->Children().size() != 1 || !source->column_index_map_set() ||
+      !source->IsRelationInit()) {
+    return false;
+  }
+
+  std::vector<ExpressionIR*> conjuncts;
+  CollectConjuncts(filter->filter_expr(), &conjuncts);
+
+  size_t num_pushable = 0;
+  bool changed = false;
+  for (ExpressionIR* conjunct : conjuncts) {
+    ColumnPredicate pred;
+    PL_ASSIGN_OR_RETURN(bool pushable, ToPredicate(source, conjunct, &pred));
+    if (!pushable) {
+      continue;
+    }
+    ++num_pushable;
+    // A filter that is only partially pushed stays around, so don't push the same predicate twice
+    // if the rule runs again.
+    bool already_pushed = false;
+    for (const auto& existing : source->predicates()) {
+      already_pushed |= google::protobuf::util::MessageDifferencer::Equals(existing, pred);
+    }
+    if (!already_pushed) {
+      source->AddPredicate(std::move(pred));
+      changed = true;
+    }
+  }
+
+  // The filter still has to evaluate the conjuncts that couldn't be pushed. Re-evaluating the
+  // pushed ones is redundant but harmless.
+  if (num_pushable < conjuncts.size()) {
+    return changed;
+  }
+
+  PL_RETURN_IF_ERROR(filter->RemoveParent(source));
+  for (OperatorIR* child : filter->Children()) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(filter, source));
+  }
+  // Deletes the filter along with its expression.
+  PL_RETURN_IF_ERROR(source->graph()->DeleteOrphansInSubtree(filter->id()));
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
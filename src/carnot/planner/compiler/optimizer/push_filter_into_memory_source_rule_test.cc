@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/optimizer/push_filter_into_memory_source_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+#include "src/common/testing/protobuf.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::px::testing::proto::EqualsProto;
+using PushFilterIntoMemorySourceRuleTest = RulesTest;
+
+TEST_F(PushFilterIntoMemorySourceRuleTest, removes_fully_pushed_filter) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto count_eq = MakeEqualsFunc(MakeColumn("count", 0), MakeInt(10));
+  auto cpu_gt = graph
+                    ->CreateNode<FuncIR>(ast, FuncIR::op_map.find(">")->second,
+                                         std::vector<ExpressionIR*>({MakeFloat(0.5),
+                                                                     MakeColumn("cpu1", 0)}))
+                    .ConsumeValueOrDie();
+  FilterIR* filter = MakeFilter(mem_src, MakeAndFunc(count_eq, cpu_gt));
+  auto filter_id = filter->id();
+  MemorySinkIR* sink = MakeMemSink(filter, "out");
+
+  PushFilterIntoMemorySourceRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  EXPECT_FALSE(graph->HasNode(filter_id));
+  ASSERT_EQ(1, sink->parents().size());
+  EXPECT_EQ(mem_src, sink->parents()[0]);
+
+  ASSERT_EQ(2, mem_src->predicates().size());
+  EXPECT_THAT(mem_src->predicates()[0], EqualsProto(R"pb(
+                column_idx: 0
+                op: EQ
+                value { data_type: INT64 int64_value: 10 })pb"));
+  // The literal was on the left, so the comparison is flipped.
+  EXPECT_THAT(mem_src->predicates()[1], EqualsProto(R"pb(
+                column_idx: 2
+                op: LT
+                value { data_type: FLOAT64 float64_value: 0.5 })pb"));
+}
+
+TEST_F(PushFilterIntoMemorySourceRuleTest, keeps_partially_pushed_filter) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto count_eq = MakeEqualsFunc(MakeColumn("count", 0), MakeInt(10));
+  // Comparing two columns can't be pushed.
+  auto cpu_eq = MakeEqualsFunc(MakeColumn("cpu0", 0), MakeColumn("cpu1", 0));
+  FilterIR* filter = MakeFilter(mem_src, MakeAndFunc(count_eq, cpu_eq));
+  MakeMemSink(filter, "out");
+
+  PushFilterIntoMemorySourceRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_TRUE(graph->HasNode(filter->id()));
+  EXPECT_EQ(1, mem_src->predicates().size());
+
+  // Running the rule again doesn't push the same predicate twice.
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(1, mem_src->predicates().size());
+}
+
+TEST_F(PushFilterIntoMemorySourceRuleTest, unchanged) {
+  // Int literal on a float column keeps the filter's float semantics.
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  FilterIR* filter = MakeFilter(mem_src, MakeEqualsFunc(MakeColumn("cpu0", 0), MakeInt(1)));
+  MakeMemSink(filter, "out");
+
+  // A source shared with another consumer can't drop rows.
+  MemorySourceIR* shared_src = MakeMemSource(MakeRelation());
+  FilterIR* shared_filter =
+      MakeFilter(shared_src, MakeEqualsFunc(MakeColumn("count", 0), MakeInt(1)));
+  MakeMemSink(shared_filter, "out1");
+  MakeMemSink(shared_src, "out2");
+
+  PushFilterIntoMemorySourceRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_TRUE(graph->HasNode(filter->id()));
+  EXPECT_TRUE(graph->HasNode(shared_filter->id()));
+  EXPECT_EQ(0, mem_src->predicates().size());
+  EXPECT_EQ(0, shared_src->predicates().size());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
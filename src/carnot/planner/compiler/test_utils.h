@@ -558,6 +558,14 @@ class OperatorTests : public ::testing::Test {
     return limit;
   }
 
+  SortIR* MakeSort(OperatorIR* parent, const std::vector<ColumnIR*>& sort_columns,
+                   const std::vector<bool>& ascending, int64_t limit = 0) {
+    SortIR* sort =
+        graph->CreateNode<SortIR>(ast, parent, sort_columns, ascending).ConsumeValueOrDie();
+    sort->SetLimit(limit);
+    return sort;
+  }
+
   BlockingAggIR* MakeBlockingAgg(OperatorIR* parent, const std::vector<ColumnIR*>& columns,
                                  const ColExpressionVector& col_agg) {
     BlockingAggIR* agg =
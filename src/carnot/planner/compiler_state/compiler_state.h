@@ -23,6 +23,9 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
 
 #include "src/carnot/planner/compiler_state/registry_info.h"
 
@@ -39,14 +42,16 @@ class CompilerState : public NotCopyable {
   /**
    * CompilerState manages the state needed to compile a single query. A new one will
    * be constructed for every query compiled in Carnot and it will not be reused.
+   *
+   * The relation map is read-only, so that the compiles of the same schema can share one.
    */
-  CompilerState(std::unique_ptr<RelationMap> relation_map, RegistryInfo* registry_info,
+  CompilerState(std::shared_ptr<const RelationMap> relation_map, RegistryInfo* registry_info,
                 types::Time64NSValue time_now, std::string_view result_address,
                 std::string_view result_ssl_targetname = "")
       : CompilerState(std::move(relation_map), registry_info, time_now,
                       /* max_output_rows_per_table */ 0, result_address, result_ssl_targetname) {}
 
-  CompilerState(std::unique_ptr<RelationMap> relation_map, RegistryInfo* registry_info,
+  CompilerState(std::shared_ptr<const RelationMap> relation_map, RegistryInfo* registry_info,
                 types::Time64NSValue time_now, int64_t max_output_rows_per_table,
                 std::string_view result_address, std::string_view result_ssl_targetname)
       : relation_map_(std::move(relation_map)),
@@ -58,9 +63,15 @@ class CompilerState : public NotCopyable {
 
   CompilerState() = delete;
 
-  RelationMap* relation_map() const { return relation_map_.get(); }
+  const RelationMap* relation_map() const { return relation_map_.get(); }
   RegistryInfo* registry_info() const { return registry_info_; }
-  types::Time64NSValue time_now() const { return time_now_; }
+  types::Time64NSValue time_now() const {
+    time_now_used_ = true;
+    return time_now_;
+  }
+  // Whether the query read the current time while compiling, in which case the plan can't be
+  // reused at a later time.
+  bool time_now_used() const { return time_now_used_; }
   const std::string& result_address() const { return result_address_; }
   const std::string& result_ssl_targetname() const { return result_ssl_targetname_; }
 
@@ -90,16 +101,38 @@ class CompilerState : public NotCopyable {
   int64_t max_output_rows_per_table() { return max_output_rows_per_table_; }
   bool has_max_output_rows_per_table() { return max_output_rows_per_table_ > 0; }
 
+  // The rows that earlier queries read from each table, by table name. Tables that aren't in the
+  // map get the planner's default estimates.
+  const absl::flat_hash_map<std::string, double>& table_row_estimates() const {
+    return table_row_estimates_;
+  }
+  void set_table_row_estimates(absl::flat_hash_map<std::string, double> table_row_estimates) {
+    table_row_estimates_ = std::move(table_row_estimates);
+  }
+
+  // The columns that the client reads from each result table, by table name. Tables that aren't
+  // in the map are returned in full.
+  const absl::flat_hash_map<std::string, std::vector<std::string>>& result_columns() const {
+    return result_columns_;
+  }
+  void set_result_columns(
+      absl::flat_hash_map<std::string, std::vector<std::string>> result_columns) {
+    result_columns_ = std::move(result_columns);
+  }
+
  private:
-  std::unique_ptr<RelationMap> relation_map_;
+  std::shared_ptr<const RelationMap> relation_map_;
   RegistryInfo* registry_info_;
   types::Time64NSValue time_now_;
+  mutable bool time_now_used_ = false;
   std::map<RegistryKey, int64_t> udf_to_id_map_;
   std::map<RegistryKey, int64_t> uda_to_id_map_;
 
   int64_t max_output_rows_per_table_ = 0;
   const std::string result_address_;
   const std::string result_ssl_targetname_;
+  absl::flat_hash_map<std::string, double> table_row_estimates_;
+  absl::flat_hash_map<std::string, std::vector<std::string>> result_columns_;
 };
 
 }  // namespace planner
@@ -16,8 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
-#include <limits>
-#include <map>
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -66,9 +65,7 @@ Status RegistryInfo::Init(const udfspb::UDFInfo& info) {
     for (int64_t i = 0; i < uda.update_arg_types_size(); i++) {
       arg_types.push_back(uda.update_arg_types(i));
     }
-    auto key = RegistryKey(uda.name(), arg_types);
-    uda_map_[key] = uda.finalize_type();
-    uda_supports_partial_map_[key] = uda.supports_partial();
+    uda_map_[RegistryKey(uda.name(), arg_types)] = {uda.finalize_type(), uda.supports_partial()};
     // Add uda to funcs_.
     if (funcs_.contains(uda.name())) {
       PL_ASSIGN_OR_RETURN(auto type, GetUDFExecType(uda.name()));
@@ -85,9 +82,7 @@ Status RegistryInfo::Init(const udfspb::UDFInfo& info) {
       arg_types.push_back(udf.exec_arg_types(i));
     }
 
-    auto key = RegistryKey(udf.name(), arg_types);
-    udf_map_[key] = udf.return_type();
-    udf_executor_map_[key] = udf.executor();
+    udf_map_[RegistryKey(udf.name(), arg_types)] = {udf.return_type(), udf.executor()};
 
     // Add udf to funcs_.
     if (funcs_.contains(udf.name())) {
@@ -130,17 +125,17 @@ StatusOr<types::DataType> RegistryInfo::GetUDADataType(
     return error::InvalidArgument("Could not find UDA '$0' with update arg types [$1].", name,
                                   absl::StrJoin(update_arg_types, ","));
   }
-  return uda->second;
+  return uda->second.finalize_type;
 }
 
 StatusOr<bool> RegistryInfo::DoesUDASupportPartial(std::string name,
                                                    std::vector<types::DataType> update_arg_types) {
-  auto uda = uda_supports_partial_map_.find(RegistryKey(name, update_arg_types));
-  if (uda == uda_supports_partial_map_.end()) {
+  auto uda = uda_map_.find(RegistryKey(name, update_arg_types));
+  if (uda == uda_map_.end()) {
     return error::InvalidArgument("Could not find UDA '$0' with update arg types [$1].", name,
                                   absl::StrJoin(update_arg_types, ","));
   }
-  return uda->second;
+  return uda->second.supports_partial;
 }
 
 Status FormatMissingUDFError(std::string name, std::vector<types::DataType> exec_arg_types) {
@@ -158,16 +153,16 @@ StatusOr<types::DataType> RegistryInfo::GetUDFDataType(
   if (udf == udf_map_.end()) {
     return FormatMissingUDFError(name, exec_arg_types);
   }
-  return udf->second;
+  return udf->second.return_type;
 }
 
 StatusOr<udfspb::UDFSourceExecutor> RegistryInfo::GetUDFSourceExecutor(
     std::string name, std::vector<types::DataType> exec_arg_types) {
-  auto udf = udf_executor_map_.find(RegistryKey(name, exec_arg_types));
-  if (udf == udf_executor_map_.end()) {
+  auto udf = udf_map_.find(RegistryKey(name, exec_arg_types));
+  if (udf == udf_map_.end()) {
     return FormatMissingUDFError(name, exec_arg_types);
   }
-  return udf->second;
+  return udf->second.executor;
 }
 
 StatusOr<std::shared_ptr<ValueType>> RegistryInfo::ResolveUDFType(
@@ -203,61 +198,49 @@ void RegistryInfo::AddSemanticInferenceRule(const udfspb::SemanticInferenceRule&
   semantic_rule_registry_.Insert(rule.name(), arg_types, rule.output_type());
 }
 
+namespace {
+int64_t NumNoneTypes(const std::vector<types::SemanticType>& arg_types) {
+  return std::count(arg_types.begin(), arg_types.end(), types::ST_NONE);
+}
+}  // namespace
+
 void SemanticRuleRegistry::Insert(std::string name, const ArgTypes& arg_types,
                                   types::SemanticType out_type) {
-  auto it = map_.find(name);
-  if (it == map_.end()) {
-    map_[name] = TypeSet{};
-  }
-  map_[name].push_back(std::make_pair(arg_types, out_type));
+  auto& set = map_[name];
+  // Insert after every rule that is at least as specific, so that the first rule to match in
+  // Lookup is the most specific one, and the earliest inserted one among equally specific rules.
+  auto num_none = NumNoneTypes(arg_types);
+  auto it = std::upper_bound(set.begin(), set.end(), num_none, [](int64_t n, const auto& rule) {
+    return n < NumNoneTypes(rule.first);
+  });
+  set.insert(it, std::make_pair(arg_types, out_type));
 }
 
-StatusOr<types::SemanticType> SemanticRuleRegistry::Lookup(std::string name,
+StatusOr<types::SemanticType> SemanticRuleRegistry::Lookup(std::string_view name,
                                                            const ArgTypes& arg_types) const {
   auto it = map_.find(name);
   if (it == map_.end()) {
     return error::InvalidArgument("No semantic types registered for '$0'", name);
   }
-  auto set = it->second;
-  auto min_dist = std::numeric_limits<int>::max();
-  types::SemanticType min_out_type;
-  bool found = false;
-
-  for (const auto& [arg_types_candidate, out_type] : set) {
-    bool match;
-    int dist;
-    std::tie(match, dist) = MatchesCandidateAtDist(arg_types, arg_types_candidate);
-    if (!match) {
-      continue;
-    }
-    if (dist < min_dist) {
-      min_dist = dist;
-      min_out_type = out_type;
-      found = true;
+  for (const auto& [arg_types_candidate, out_type] : it->second) {
+    if (MatchesCandidate(arg_types, arg_types_candidate)) {
+      return out_type;
     }
   }
-
-  if (!found) {
-    return error::InvalidArgument("No semantic types match for '$0'", name);
-  }
-  return min_out_type;
+  return error::InvalidArgument("No semantic types match for '$0'", name);
 }
 
-std::pair<bool, int> SemanticRuleRegistry::MatchesCandidateAtDist(
-    const ArgTypes& arg_types, const ArgTypes& arg_types_candidate) const {
+bool SemanticRuleRegistry::MatchesCandidate(const ArgTypes& arg_types,
+                                            const ArgTypes& arg_types_candidate) const {
   if (arg_types.size() != arg_types_candidate.size()) {
-    return std::make_pair(false, 0);
+    return false;
   }
-  int dist = 0;
   for (const auto& [idx, candidate_type] : Enumerate(arg_types_candidate)) {
     if (candidate_type != arg_types[idx] && candidate_type != types::ST_NONE) {
-      return std::make_pair(false, 0);
-    }
-    if (candidate_type != arg_types[idx] && candidate_type == types::ST_NONE) {
-      dist++;
+      return false;
     }
   }
-  return std::make_pair(true, dist);
+  return true;
 }
 
 }  // namespace planner
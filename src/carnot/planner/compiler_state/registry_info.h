@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -73,6 +72,15 @@ class RegistryKey {
     return name_ < lhs.name_;
   }
 
+  bool operator==(const RegistryKey& other) const {
+    return name_ == other.name_ && registry_arg_types_ == other.registry_arg_types_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const RegistryKey& key) {
+    return H::combine(std::move(h), key.name_, key.registry_arg_types_);
+  }
+
  protected:
   std::string name_;
   std::vector<types::DataType> registry_arg_types_;
@@ -87,7 +95,9 @@ class SemanticRuleRegistry {
    * (i.e. they will match any semantic type).
    *
    * If there are multiple matching rules, it will pick the most specific rule, i.e. the rule with
-   * the least number of ST_NONE types that matched other types as above.
+   * the least number of ST_NONE types that matched other types as above. Every rule that matches
+   * has ST_NONE wherever the arguments do, so the rules for a function are kept sorted by their
+   * number of ST_NONE types and the first match is the most specific one.
    */
   using ArgTypes = std::vector<types::SemanticType>;
   using TypeSet = std::vector<std::pair<ArgTypes, types::SemanticType>>;
@@ -110,14 +120,14 @@ class SemanticRuleRegistry {
    * @return if the arg_types match a rule for this function, then it returns the output semantic
    * type of that rule, otherwise it returns an error.
    */
-  StatusOr<types::SemanticType> Lookup(std::string name, const ArgTypes& arg_types) const;
+  StatusOr<types::SemanticType> Lookup(std::string_view name, const ArgTypes& arg_types) const;
 
  protected:
-  std::pair<bool, int> MatchesCandidateAtDist(const ArgTypes& arg_types,
-                                              const ArgTypes& arg_types_candidate) const;
+  bool MatchesCandidate(const ArgTypes& arg_types, const ArgTypes& arg_types_candidate) const;
 
  private:
-  std::map<std::string, TypeSet> map_;
+  // Each TypeSet is sorted by the number of ST_NONE types in its rules, see Insert.
+  absl::flat_hash_map<std::string, TypeSet> map_;
 };
 
 class RegistryInfo {
@@ -135,8 +145,9 @@ class RegistryInfo {
 
   StatusOr<UDFExecType> GetUDFExecType(std::string_view name);
   absl::flat_hash_set<std::string> func_names() const;
+  bool HasFunc(std::string_view name) const { return funcs_.contains(name); }
 
-  std::vector<udfspb::UDTFSourceSpec> udtfs() const { return udtfs_; }
+  const std::vector<udfspb::UDTFSourceSpec>& udtfs() const { return udtfs_; }
 
   // TODO(philkuz) move this function to protected when udtfs are finally supported.
   void AddUDTF(const udfspb::UDTFSourceSpec& source_spec) { udtfs_.push_back(source_spec); }
@@ -161,12 +172,17 @@ class RegistryInfo {
  protected:
   void AddSemanticInferenceRule(const udfspb::SemanticInferenceRule& rule);
 
-  std::map<RegistryKey, types::DataType> udf_map_;
-  std::map<RegistryKey, types::DataType> uda_map_;
-  std::map<RegistryKey, udfspb::UDFSourceExecutor> udf_executor_map_;
-
-  // Allocated as a separate map because this is a temporary solution.
-  std::map<RegistryKey, bool> uda_supports_partial_map_;
+  struct UDFEntry {
+    types::DataType return_type;
+    udfspb::UDFSourceExecutor executor;
+  };
+  struct UDAEntry {
+    types::DataType finalize_type;
+    bool supports_partial;
+  };
+
+  absl::flat_hash_map<RegistryKey, UDFEntry> udf_map_;
+  absl::flat_hash_map<RegistryKey, UDAEntry> uda_map_;
   // Union of udf and uda names.
   absl::flat_hash_map<std::string, UDFExecType> funcs_;
   // The vector containing udtfs.
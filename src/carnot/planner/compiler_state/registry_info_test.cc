@@ -203,6 +203,22 @@ TEST(SemanticRuleRegistry, semantic_lookup) {
   EXPECT_EQ(types::ST_POD_NAME, out_type_or_s.ConsumeValueOrDie());
 }
 
+TEST(SemanticRuleRegistry, most_specific_rule_independent_of_insert_order) {
+  SemanticRuleRegistry map_;
+  map_.Insert("test", {types::ST_NONE, types::ST_NONE}, types::ST_POD_NAME);
+  map_.Insert("test", {types::ST_UPID, types::ST_BYTES}, types::ST_BYTES);
+  map_.Insert("test", {types::ST_UPID, types::ST_NONE}, types::ST_SERVICE_NAME);
+  // Same specificity as the rule above, so the earlier rule wins.
+  map_.Insert("test", {types::ST_NONE, types::ST_BYTES}, types::ST_QUANTILES);
+
+  EXPECT_OK_AND_EQ(map_.Lookup("test", {types::ST_UPID, types::ST_BYTES}), types::ST_BYTES);
+  EXPECT_OK_AND_EQ(map_.Lookup("test", {types::ST_UPID, types::ST_UPID}), types::ST_SERVICE_NAME);
+  EXPECT_OK_AND_EQ(map_.Lookup("test", {types::ST_NONE, types::ST_BYTES}), types::ST_QUANTILES);
+  EXPECT_OK_AND_EQ(map_.Lookup("test", {types::ST_BYTES, types::ST_UPID}), types::ST_POD_NAME);
+  EXPECT_NOT_OK(map_.Lookup("test", {types::ST_BYTES}));
+  EXPECT_NOT_OK(map_.Lookup("other", {types::ST_BYTES, types::ST_UPID}));
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
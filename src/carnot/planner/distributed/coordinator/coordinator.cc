@@ -199,8 +199,10 @@ StatusOr<AgentToPlanMap> GetUniquePEMPlans(IR* query, DistributedPlan* plan,
   if (!remaining_agents.empty()) {
     clusters.emplace_back(remaining_agents, absl::flat_hash_set<OperatorIR*>{});
   }
-  for (const auto& c : clusters) {
-    PL_ASSIGN_OR_RETURN(auto cluster_plan_uptr, c.CreatePlan(query));
+  PL_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<IR>> cluster_plans,
+                      CreatePlans(query, clusters));
+  for (const auto& [i, c] : Enumerate(clusters)) {
+    auto cluster_plan_uptr = std::move(cluster_plans[i]);
     auto cluster_plan = cluster_plan_uptr.get();
     if (cluster_plan->FindNodesThatMatch(Operator()).empty()) {
       continue;
@@ -286,6 +288,15 @@ StatusOr<std::unique_ptr<DistributedPlan>> CoordinatorImpl::CoordinateImpl(const
   PL_RETURN_IF_ERROR(prune_sources_rule.Apply(remote_carnot));
 
   distributed_plan->SetKelvin(remote_carnot);
+  std::vector<CarnotInfo> other_kelvins;
+  for (const auto& remote_processor_info : remote_processor_nodes_) {
+    if (remote_processor_info.agent_id() == GetRemoteProcessor().agent_id() ||
+        remote_processor_info.has_data_store()) {
+      continue;
+    }
+    other_kelvins.push_back(remote_processor_info);
+  }
+  distributed_plan->SetOtherKelvins(std::move(other_kelvins));
   distributed_plan->AddPlanToAgentMap(std::move(agent_to_plan_map.plan_to_agents));
 
   return distributed_plan;
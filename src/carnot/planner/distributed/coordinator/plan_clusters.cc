@@ -20,6 +20,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -155,6 +156,43 @@ absl::flat_hash_set<int64_t> RemainingAgents(const OperatorToAgentSet& op_to_age
   return remaining_agents;
 }
 
+StatusOr<std::vector<std::unique_ptr<IR>>> CreatePlans(const IR* base_query,
+                                                       const std::vector<PlanCluster>& clusters) {
+  std::vector<std::unique_ptr<IR>> plans(clusters.size());
+  std::vector<Status> statuses(clusters.size());
+  auto create_plans = [&](size_t first, size_t stride) {
+    for (size_t i = first; i < clusters.size(); i += stride) {
+      auto plan_or_s = clusters[i].CreatePlan(base_query);
+      if (!plan_or_s.ok()) {
+        statuses[i] = plan_or_s.status();
+        continue;
+      }
+      plans[i] = plan_or_s.ConsumeValueOrDie();
+    }
+  };
+
+  size_t num_threads = std::min<size_t>(
+      {kMaxPlanThreads, std::max<size_t>(std::thread::hardware_concurrency(), 1),
+       clusters.size() / kMinClustersPerPlanThread});
+  if (num_threads <= 1) {
+    create_plans(0, 1);
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+      threads.emplace_back(create_plans, i, num_threads);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // Report the error of the first failing cluster, regardless of which thread got there first.
+  for (const auto& s : statuses) {
+    PL_RETURN_IF_ERROR(s);
+  }
+  return plans;
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -135,6 +135,22 @@ std::vector<PlanCluster> ClusterOperators(const OperatorToAgentSet& set);
 absl::flat_hash_set<int64_t> RemainingAgents(const OperatorToAgentSet& op_to_agent_set,
                                              const absl::flat_hash_set<int64_t>& all_agents);
 
+// Plans are created on several threads once there are enough clusters to keep each thread busy.
+constexpr size_t kMinClustersPerPlanThread = 4;
+constexpr size_t kMaxPlanThreads = 8;
+
+/**
+ * @brief Creates the plan of each cluster, in the order of the clusters. Each plan is an
+ * independent clone of the base query, which is only read, so the plans of large cluster sets are
+ * created in parallel.
+ *
+ * @param base_query The query the clusters were computed on.
+ * @param clusters The clusters to create the plans for.
+ * @return StatusOr<std::vector<std::unique_ptr<IR>>> The error of the first failing cluster.
+ */
+StatusOr<std::vector<std::unique_ptr<IR>>> CreatePlans(const IR* base_query,
+                                                       const std::vector<PlanCluster>& clusters);
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -64,6 +64,38 @@ TEST_F(PlanClustersTest, create_plan) {
             pem_plan->FindNodesThatMatch(Operator()).size());
 }
 
+TEST_F(PlanClustersTest, create_plans) {
+  auto logical_plan = CompileSingleNodePlan(testutils::kDependentRemovableOpsQuery);
+  auto split_plan = SplitPlan(logical_plan.get());
+  auto pem_plan = split_plan->before_blocking.get();
+
+  auto filters = pem_plan->FindNodesThatMatch(Filter());
+  ASSERT_EQ(filters.size(), 1);
+  FilterIR* filter = static_cast<FilterIR*>(filters[0]);
+
+  // Enough clusters to create the plans on several threads.
+  std::vector<PlanCluster> clusters;
+  for (int64_t i = 0; i < 3 * static_cast<int64_t>(kMinClustersPerPlanThread); ++i) {
+    if (i % 2 == 0) {
+      clusters.emplace_back(absl::flat_hash_set<int64_t>{i}, absl::flat_hash_set<OperatorIR*>{});
+    } else {
+      clusters.emplace_back(absl::flat_hash_set<int64_t>{i},
+                            absl::flat_hash_set<OperatorIR*>{filter});
+    }
+  }
+
+  ASSERT_OK_AND_ASSIGN(auto plans, CreatePlans(pem_plan, clusters));
+  ASSERT_EQ(plans.size(), clusters.size());
+  for (const auto& [i, plan] : Enumerate(plans)) {
+    if (i % 2 == 0) {
+      EXPECT_EQ(plan->FindNodesThatMatch(Operator()).size(),
+                pem_plan->FindNodesThatMatch(Operator()).size());
+    } else {
+      EXPECT_TRUE(plan->FindNodesThatMatch(Operator()).empty());
+    }
+  }
+}
+
 TEST_F(PlanClustersTest, cluster_operators) {
   auto mem_src = MakeMemSource();
   auto filter = MakeFilter(MakeMemSource(), MakeEqualsFunc(MakeColumn("cpu", 0), MakeInt(10)));
@@ -158,11 +158,18 @@ class DistributedPlan {
 
   CarnotInstance* kelvin() const { return kelvin_; }
 
+  // The Kelvins that aren't in the plan, which later rules can spread work over.
+  void SetOtherKelvins(std::vector<distributedpb::CarnotInfo> other_kelvins) {
+    other_kelvins_ = std::move(other_kelvins);
+  }
+  const std::vector<distributedpb::CarnotInfo>& other_kelvins() const { return other_kelvins_; }
+
  private:
   plan::DAG dag_;
   absl::flat_hash_map<int64_t, std::unique_ptr<CarnotInstance>> id_to_node_map_;
   absl::flat_hash_map<IR*, absl::flat_hash_set<int64_t>> plan_to_agent_map_;
   CarnotInstance* kelvin_ = nullptr;
+  std::vector<distributedpb::CarnotInfo> other_kelvins_;
   std::vector<std::unique_ptr<IR>> plan_pool_;
   absl::flat_hash_map<int64_t, IR*> agent_to_plan_map_;
   absl::flat_hash_map<sole::uuid, int64_t> uuid_to_id_map_;
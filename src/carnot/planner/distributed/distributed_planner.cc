@@ -27,6 +27,8 @@
 #include "src/carnot/planner/distributed/distributed_rules.h"
 #include "src/carnot/planner/distributed/distributed_stitcher_rules.h"
 #include "src/carnot/planner/distributed/grpc_source_conversion.h"
+#include "src/carnot/planner/distributed/join_filter_rule.h"
+#include "src/carnot/planner/distributed/shuffle_aggregates_rule.h"
 #include "src/carnot/planner/rules/rules.h"
 
 namespace px {
@@ -79,6 +81,9 @@ StatusOr<std::unique_ptr<DistributedPlan>> DistributedPlanner::Plan(
                       coordinator->Coordinate(logical_plan));
 
   PL_RETURN_IF_ERROR(StitchPlan(distributed_plan.get()));
+  PL_RETURN_IF_ERROR(AnnotateJoinFiltersRule::Apply(distributed_plan.get()).status());
+  // Runs after the join filters, which only expect sinks to the main Kelvin.
+  PL_RETURN_IF_ERROR(ShuffleAggregatesRule::Apply(distributed_plan.get()).status());
 
   AnnotateAbortableSourcesForLimitsRule rule;
   for (IR* agent_plan : distributed_plan->UniquePlans()) {
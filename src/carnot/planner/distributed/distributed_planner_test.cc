@@ -27,6 +27,7 @@
 
 #include "src/carnot/planner/compiler/test_utils.h"
 #include "src/carnot/planner/distributed/distributed_planner.h"
+#include "src/carnot/planner/distributed/shuffle_aggregates_rule.h"
 #include "src/carnot/planner/ir/ir_nodes.h"
 #include "src/carnot/planner/rules/rules.h"
 #include "src/carnot/planner/test_utils.h"
@@ -208,6 +209,89 @@ TEST_F(DistributedPlannerTest, three_agents_one_kelvin) {
   EXPECT_THAT(grpc_sink_destinations, UnorderedElementsAreArray(grpc_source_ids));
 }
 
+constexpr char kSecondKelvin[] = R"proto(
+carnot_info {
+  query_broker_address: "kelvin2"
+  agent_id {
+    high_bits: 0x0000000100000000
+    low_bits: 0x0000000000000005
+  }
+  grpc_address: "2222"
+  has_grpc_server: true
+  has_data_store: false
+  processes_data: true
+  accepts_remote_sources: true
+  asid: 457
+  ssl_targetname: "kelvin.pl.svc"
+}
+)proto";
+
+TEST_F(DistributedPlannerTest, three_agents_shuffle_agg_over_two_kelvins) {
+  FLAGS_planner_shuffle_aggregates = true;
+  auto mem_src = MakeMemSource(MakeRelation());
+  auto agg = MakeBlockingAgg(mem_src, {MakeColumn("count", 0)},
+                             {{"mean", MakeMeanFunc(MakeColumn("cpu0", 0))}});
+  table_store::schema::Relation agg_relation({types::INT64, types::FLOAT64}, {"count", "mean"});
+  PL_CHECK_OK(agg->SetRelation(agg_relation));
+  auto mem_sink = MakeMemSink(agg, "out");
+  PL_CHECK_OK(mem_sink->SetRelation(agg_relation));
+
+  distributedpb::DistributedState ps_pb =
+      LoadDistributedStatePb(absl::StrCat(kThreePEMsOneKelvinDistributedState, kSecondKelvin));
+  std::unique_ptr<DistributedPlanner> physical_planner =
+      DistributedPlanner::Create().ConsumeValueOrDie();
+  std::unique_ptr<DistributedPlan> physical_plan =
+      physical_planner->Plan(ps_pb, compiler_state_.get(), graph.get()).ConsumeValueOrDie();
+  FLAGS_planner_shuffle_aggregates = false;
+
+  // The second Kelvin is added after the agents.
+  ASSERT_EQ(physical_plan->dag().nodes().size(), 5);
+  auto worker = physical_plan->Get(4);
+  EXPECT_EQ(worker->carnot_info().query_broker_address(), "kelvin2");
+  EXPECT_THAT(physical_plan->dag().ParentsOf(4), UnorderedElementsAreArray({1, 2, 3}));
+  EXPECT_THAT(physical_plan->dag().ParentsOf(0), ::testing::Contains(4));
+
+  // Each agent sends one partition of its rows to each Kelvin.
+  for (int64_t i = 1; i <= 3; ++i) {
+    SCOPED_TRACE(absl::Substitute("agent id = $0", i));
+    auto grpc_sinks = physical_plan->Get(i)->plan()->FindNodesOfType(IRNodeType::kGRPCSink);
+    ASSERT_EQ(grpc_sinks.size(), 2);
+    absl::flat_hash_map<int64_t, std::string> partition_addresses;
+    for (IRNode* node : grpc_sinks) {
+      auto grpc_sink = static_cast<GRPCSinkIR*>(node);
+      ASSERT_TRUE(grpc_sink->has_partition());
+      EXPECT_EQ(grpc_sink->num_partitions(), 2);
+      EXPECT_THAT(grpc_sink->partition_key_indexes(), ElementsAre(0));
+      partition_addresses[grpc_sink->partition_index()] = grpc_sink->destination_address();
+    }
+    EXPECT_EQ(partition_addresses[0], "1111");
+    EXPECT_EQ(partition_addresses[1], "2222");
+  }
+
+  // The second Kelvin aggregates its partition and sends it back to the first.
+  IR* worker_plan = worker->plan();
+  EXPECT_EQ(worker_plan->FindNodesOfType(IRNodeType::kGRPCSource).size(), 3);
+  auto worker_aggs = worker_plan->FindNodesOfType(IRNodeType::kBlockingAgg);
+  ASSERT_EQ(worker_aggs.size(), 1);
+  auto worker_agg_children = static_cast<BlockingAggIR*>(worker_aggs[0])->Children();
+  ASSERT_EQ(worker_agg_children.size(), 1);
+  ASSERT_MATCH(worker_agg_children[0], GRPCSink());
+  auto worker_sink = static_cast<GRPCSinkIR*>(worker_agg_children[0]);
+  EXPECT_EQ(worker_sink->destination_address(), "1111");
+  EXPECT_FALSE(worker_sink->has_partition());
+
+  // The first Kelvin unions the results of both partitions.
+  IR* kelvin_plan = physical_plan->Get(0)->plan();
+  auto kelvin_sinks = kelvin_plan->FindNodesOfType(IRNodeType::kMemorySink);
+  ASSERT_EQ(kelvin_sinks.size(), 1);
+  auto results = static_cast<OperatorIR*>(kelvin_sinks[0])->parents()[0];
+  ASSERT_MATCH(results, Union());
+  ASSERT_EQ(results->parents().size(), 2);
+  EXPECT_MATCH(results->parents()[0], BlockingAgg());
+  ASSERT_MATCH(results->parents()[1], GRPCSource());
+  EXPECT_EQ(worker_sink->agent_id_to_destination_id().at(4), results->parents()[1]->id());
+}
+
 using DistributedPlannerUDTFTests = DistributedRulesTest;
 TEST_F(DistributedPlannerUDTFTests, UDTFOnlyOnPEMsDoesntRunOnKelvin) {
   uint32_t asid = 123;
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/distributed/join_filter_rule.h"
+
+#include <absl/container/flat_hash_map.h>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace distributed {
+
+void AnnotateJoinFiltersRule::CollectGRPCSources(OperatorIR* op,
+                                                 std::vector<GRPCSourceIR*>* sources) {
+  if (Match(op, GRPCSource())) {
+    sources->push_back(static_cast<GRPCSourceIR*>(op));
+    return;
+  }
+  if (op->type() != IRNodeType::kUnion) {
+    return;
+  }
+  for (OperatorIR* parent : op->parents()) {
+    CollectGRPCSources(parent, sources);
+  }
+}
+
+StatusOr<bool> AnnotateJoinFiltersRule::Apply(DistributedPlan* distributed_plan) {
+  IR* kelvin_plan = distributed_plan->kelvin()->plan();
+
+  // The key columns each GRPCSource on the probe side of a join is filtered on.
+  struct ProbeSource {
+    int64_t filter_id;
+    std::vector<int64_t> key_indexes;
+  };
+  absl::flat_hash_map<int64_t, ProbeSource> probe_sources;
+  int64_t next_filter_id = 1;
+  for (IRNode* node : kelvin_plan->FindNodesOfType(IRNodeType::kJoin)) {
+    auto join = static_cast<JoinIR*>(node);
+    int64_t probe_parent_index = 1 - join->build_parent_index();
+    // Left joins emit the unmatched rows of the left parent.
+    bool emits_unmatched_probe_rows =
+        join->join_type() == JoinIR::JoinType::kOuter ||
+        (join->join_type() == JoinIR::JoinType::kLeft && probe_parent_index == 0);
+    if (emits_unmatched_probe_rows) {
+      continue;
+    }
+
+    std::vector<GRPCSourceIR*> sources;
+    CollectGRPCSources(join->parents()[probe_parent_index], &sources);
+    if (sources.empty()) {
+      continue;
+    }
+    const auto& key_columns =
+        probe_parent_index == 0 ? join->left_on_columns() : join->right_on_columns();
+    int64_t filter_id = next_filter_id;
+    bool has_probe_sources = false;
+    for (GRPCSourceIR* source : sources) {
+      ProbeSource probe_source{filter_id, {}};
+      for (ColumnIR* col : key_columns) {
+        if (!source->relation().HasColumn(col->col_name())) {
+          break;
+        }
+        probe_source.key_indexes.push_back(source->relation().GetColumnIndex(col->col_name()));
+      }
+      if (probe_source.key_indexes.size() == key_columns.size()) {
+        probe_sources[source->id()] = std::move(probe_source);
+        has_probe_sources = true;
+      }
+    }
+    if (has_probe_sources) {
+      join->SetJoinFilterID(filter_id);
+      ++next_filter_id;
+    }
+  }
+  if (probe_sources.empty()) {
+    return false;
+  }
+
+  bool changed = false;
+  for (IR* agent_plan : distributed_plan->UniquePlans()) {
+    for (IRNode* node : agent_plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+      auto sink = static_cast<GRPCSinkIR*>(node);
+      for (const auto& agent_and_destination : sink->agent_id_to_destination_id()) {
+        auto it = probe_sources.find(agent_and_destination.second);
+        if (it == probe_sources.end()) {
+          continue;
+        }
+        sink->SetJoinFilter(it->second.filter_id, it->second.key_indexes);
+        changed = true;
+        break;
+      }
+    }
+  }
+  return changed;
+}
+
+}  // namespace distributed
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
+#include "src/carnot/planner/ir/ir_nodes.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace distributed {
+
+/**
+ * @brief Lets the joins on Kelvin publish a filter on their build keys to the agents that send
+ * them their probe rows, so that the agents drop the rows that can't match before sending them.
+ *
+ * The filter is only used by joins that don't emit the unmatched probe rows, and only for the
+ * probe rows that come straight from GRPCSources (possibly through a Union).
+ */
+class AnnotateJoinFiltersRule {
+ public:
+  static StatusOr<bool> Apply(DistributedPlan* distributed_plan);
+
+ private:
+  // Collects the GRPCSources the rows of op come straight from. Rows that come from elsewhere,
+  // e.g. data local to Kelvin, are sent to the join unfiltered.
+  static void CollectGRPCSources(OperatorIR* op, std::vector<GRPCSourceIR*>* sources);
+};
+
+}  // namespace distributed
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
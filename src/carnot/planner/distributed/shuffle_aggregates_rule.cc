@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/distributed/shuffle_aggregates_rule.h"
+
+#include <memory>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+DEFINE_bool(planner_shuffle_aggregates,
+            gflags::BoolFromEnv("PL_PLANNER_SHUFFLE_AGGREGATES", false),
+            "Whether to split the aggregates of the rows sent by the agents over all of the "
+            "Kelvins, by a hash of their groups.");
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace distributed {
+
+bool ShuffleAggregatesRule::CollectGRPCSources(OperatorIR* op,
+                                               std::vector<GRPCSourceIR*>* sources) {
+  if (op->Children().size() != 1) {
+    return false;
+  }
+  if (Match(op, GRPCSource())) {
+    sources->push_back(static_cast<GRPCSourceIR*>(op));
+    return true;
+  }
+  if (op->type() != IRNodeType::kUnion) {
+    return false;
+  }
+  for (OperatorIR* parent : op->parents()) {
+    if (!CollectGRPCSources(parent, sources)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+StatusOr<bool> ShuffleAggregatesRule::Apply(DistributedPlan* distributed_plan) {
+  if (!FLAGS_planner_shuffle_aggregates || distributed_plan->other_kelvins().empty()) {
+    return false;
+  }
+  CarnotInstance* kelvin = distributed_plan->kelvin();
+  IR* kelvin_plan = kelvin->plan();
+
+  std::vector<Shuffle> shuffles;
+  for (IRNode* node : kelvin_plan->FindNodesOfType(IRNodeType::kBlockingAgg)) {
+    auto agg = static_cast<BlockingAggIR*>(node);
+    // Streaming aggregates emit the groups they updated as they go, so they don't benefit much.
+    if (agg->group_by_all() || agg->emit_interval_ns() != 0) {
+      continue;
+    }
+    Shuffle shuffle{agg, {}, {}};
+    if (!CollectGRPCSources(agg->parents()[0], &shuffle.sources)) {
+      continue;
+    }
+    const auto& input_relation = agg->parents()[0]->relation();
+    for (ColumnIR* group : agg->groups()) {
+      if (!input_relation.HasColumn(group->col_name())) {
+        break;
+      }
+      shuffle.key_indexes.push_back(input_relation.GetColumnIndex(group->col_name()));
+    }
+    if (shuffle.key_indexes.size() == agg->groups().size()) {
+      shuffles.push_back(std::move(shuffle));
+    }
+  }
+  if (shuffles.empty()) {
+    return false;
+  }
+
+  // The other Kelvins each aggregate one of the partitions, the main Kelvin the first one.
+  std::vector<CarnotInstance*> workers;
+  for (const auto& carnot_info : distributed_plan->other_kelvins()) {
+    PL_ASSIGN_OR_RETURN(int64_t worker_id, distributed_plan->AddCarnot(carnot_info));
+    CarnotInstance* worker = distributed_plan->Get(worker_id);
+    auto worker_plan = std::make_unique<IR>();
+    worker->AddPlan(worker_plan.get());
+    distributed_plan->AddPlan(std::move(worker_plan));
+    distributed_plan->AddEdge(worker, kelvin);
+    workers.push_back(worker);
+  }
+
+  // The copies keep the IDs of the aggregates in the Kelvin plan, so they have to be made before
+  // any other node is added to the worker plans.
+  std::vector<std::vector<BlockingAggIR*>> worker_aggs(shuffles.size());
+  for (CarnotInstance* worker : workers) {
+    for (const auto& [i, shuffle] : Enumerate(shuffles)) {
+      absl::flat_hash_map<const IRNode*, IRNode*> copied_nodes;
+      PL_ASSIGN_OR_RETURN(BlockingAggIR * worker_agg,
+                          worker->plan()->CopyNode(shuffle.agg, &copied_nodes));
+      worker_aggs[i].push_back(worker_agg);
+    }
+  }
+
+  for (const auto& [i, shuffle] : Enumerate(shuffles)) {
+    PL_RETURN_IF_ERROR(ShuffleAggregate(distributed_plan, shuffle, worker_aggs[i], workers));
+  }
+  return true;
+}
+
+Status ShuffleAggregatesRule::ShuffleAggregate(DistributedPlan* distributed_plan,
+                                               const Shuffle& shuffle,
+                                               const std::vector<BlockingAggIR*>& worker_aggs,
+                                               const std::vector<CarnotInstance*>& workers) {
+  BlockingAggIR* agg = shuffle.agg;
+  IR* kelvin_plan = agg->graph();
+  const auto& kelvin_info = distributed_plan->kelvin()->carnot_info();
+  int64_t num_partitions = workers.size() + 1;
+
+  absl::flat_hash_set<int64_t> source_ids;
+  for (GRPCSourceIR* source : shuffle.sources) {
+    source_ids.insert(source->id());
+  }
+  // The sinks of the agents that send the rows to the aggregate. Collected before the sinks to
+  // the workers are added, since their destinations are numbered in the worker plans.
+  std::vector<GRPCSinkIR*> agent_sinks;
+  for (IR* agent_plan : distributed_plan->UniquePlans()) {
+    if (agent_plan == kelvin_plan) {
+      continue;
+    }
+    for (IRNode* node : agent_plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+      auto sink = static_cast<GRPCSinkIR*>(node);
+      for (const auto& agent_and_destination : sink->agent_id_to_destination_id()) {
+        if (source_ids.contains(agent_and_destination.second)) {
+          agent_sinks.push_back(sink);
+          break;
+        }
+      }
+    }
+  }
+
+  std::vector<OperatorIR*> partition_results{agg};
+  for (const auto& [i, worker] : Enumerate(workers)) {
+    IR* worker_plan = worker->plan();
+    const auto& worker_info = worker->carnot_info();
+    int64_t partition_index = i + 1;
+
+    // The worker receives its partition of the rows from the same agents as the aggregate.
+    absl::flat_hash_map<int64_t, int64_t> worker_source_ids;
+    std::vector<OperatorIR*> worker_sources;
+    for (GRPCSourceIR* source : shuffle.sources) {
+      PL_ASSIGN_OR_RETURN(GRPCSourceIR * worker_source,
+                          worker_plan->CreateNode<GRPCSourceIR>(source->ast(), source->relation()));
+      worker_source_ids[source->id()] = worker_source->id();
+      worker_sources.push_back(worker_source);
+    }
+    OperatorIR* worker_input = worker_sources[0];
+    if (worker_sources.size() > 1) {
+      PL_ASSIGN_OR_RETURN(UnionIR * union_op,
+                          worker_plan->CreateNode<UnionIR>(agg->ast(), worker_sources));
+      PL_RETURN_IF_ERROR(union_op->SetRelation(worker_sources[0]->relation()));
+      PL_RETURN_IF_ERROR(union_op->SetDefaultColumnMapping());
+      worker_input = union_op;
+    }
+    BlockingAggIR* worker_agg = worker_aggs[i];
+    PL_RETURN_IF_ERROR(worker_agg->AddParent(worker_input));
+
+    for (GRPCSinkIR* sink : agent_sinks) {
+      PL_ASSIGN_OR_RETURN(GRPCSinkIR * worker_sink,
+                          sink->graph()->CreateNode<GRPCSinkIR>(sink->ast(), sink->parents()[0],
+                                                                sink->destination_id()));
+      PL_RETURN_IF_ERROR(worker_sink->SetRelation(sink->relation()));
+      worker_sink->SetDestinationAddress(worker_info.grpc_address());
+      worker_sink->SetDestinationSSLTargetName(worker_info.ssl_targetname());
+      worker_sink->SetPartition(shuffle.key_indexes, num_partitions, partition_index);
+      for (const auto& [agent_id, destination_id] : sink->agent_id_to_destination_id()) {
+        if (!worker_source_ids.contains(destination_id)) {
+          continue;
+        }
+        worker_sink->AddDestinationIDMap(worker_source_ids[destination_id], agent_id);
+        if (!distributed_plan->dag().HasEdge(agent_id, worker->id())) {
+          distributed_plan->AddEdge(agent_id, worker->id());
+        }
+      }
+    }
+
+    // The worker sends the aggregated partition back to the main Kelvin.
+    PL_ASSIGN_OR_RETURN(GRPCSourceIR * result_source,
+                        kelvin_plan->CreateNode<GRPCSourceIR>(agg->ast(), agg->relation()));
+    PL_ASSIGN_OR_RETURN(GRPCSinkIR * worker_sink, worker_plan->CreateNode<GRPCSinkIR>(
+                                                      agg->ast(), worker_agg, result_source->id()));
+    PL_RETURN_IF_ERROR(worker_sink->SetRelation(agg->relation()));
+    worker_sink->SetDestinationAddress(kelvin_info.grpc_address());
+    worker_sink->SetDestinationSSLTargetName(kelvin_info.ssl_targetname());
+    worker_sink->AddDestinationIDMap(result_source->id(), worker->id());
+    partition_results.push_back(result_source);
+  }
+
+  for (GRPCSinkIR* sink : agent_sinks) {
+    sink->SetPartition(shuffle.key_indexes, num_partitions, /* partition_index */ 0);
+  }
+
+  std::vector<OperatorIR*> children = agg->Children();
+  PL_ASSIGN_OR_RETURN(UnionIR * union_op,
+                      kelvin_plan->CreateNode<UnionIR>(agg->ast(), partition_results));
+  PL_RETURN_IF_ERROR(union_op->SetRelation(agg->relation()));
+  PL_RETURN_IF_ERROR(union_op->SetDefaultColumnMapping());
+  for (OperatorIR* child : children) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(agg, union_op));
+  }
+  return Status::OK();
+}
+
+}  // namespace distributed
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
+#include "src/carnot/planner/ir/ir_nodes.h"
+
+DECLARE_bool(planner_shuffle_aggregates);
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace distributed {
+
+/**
+ * @brief Splits the aggregates on Kelvin that group the rows sent by the agents over all of the
+ * Kelvins of the cluster, instead of finishing them all on the one Kelvin the plan runs on.
+ *
+ * The agents hash partition the rows on the group columns and send each partition to its own
+ * Kelvin, which aggregates it. The main Kelvin aggregates the first partition and unions the
+ * results of the others before passing them on, so the rest of its plan doesn't change. Since all
+ * the rows of a group go to the same Kelvin, the partitions don't need to be merged.
+ *
+ * Only used with --planner_shuffle_aggregates, for non-streaming aggregates with groups whose
+ * input comes straight from GRPCSources (possibly through a Union).
+ */
+class ShuffleAggregatesRule {
+ public:
+  static StatusOr<bool> Apply(DistributedPlan* distributed_plan);
+
+ private:
+  struct Shuffle {
+    BlockingAggIR* agg;
+    std::vector<GRPCSourceIR*> sources;
+    std::vector<int64_t> key_indexes;
+  };
+
+  // Collects the GRPCSources the rows of op come from. Returns false if some of the rows come from
+  // elsewhere or the rows are also used by another operator.
+  static bool CollectGRPCSources(OperatorIR* op, std::vector<GRPCSourceIR*>* sources);
+
+  static Status ShuffleAggregate(DistributedPlan* distributed_plan, const Shuffle& shuffle,
+                                 const std::vector<BlockingAggIR*>& worker_aggs,
+                                 const std::vector<CarnotInstance*>& workers);
+};
+
+}  // namespace distributed
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
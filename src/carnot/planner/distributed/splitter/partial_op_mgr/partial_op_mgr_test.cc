@@ -67,6 +67,40 @@ TEST_F(PartialOpMgrTest, limit_test) {
   EXPECT_NE(merge_limit, limit);
 }
 
+TEST_F(PartialOpMgrTest, sort_test) {
+  auto mem_src = MakeMemSource(MakeRelation());
+  auto sort = MakeSort(mem_src, {MakeColumn("count", 0)}, {false}, /*limit*/ 10);
+  MakeMemSink(sort, "out");
+
+  SortOperatorMgr mgr;
+  EXPECT_TRUE(mgr.Matches(sort));
+  auto prepare_sort_or_s = mgr.CreatePrepareOperator(graph.get(), sort);
+  ASSERT_OK(prepare_sort_or_s);
+  OperatorIR* prepare_sort_uncasted = prepare_sort_or_s.ConsumeValueOrDie();
+  ASSERT_MATCH(prepare_sort_uncasted, Sort());
+  SortIR* prepare_sort = static_cast<SortIR*>(prepare_sort_uncasted);
+  EXPECT_EQ(prepare_sort->limit(), 10);
+  EXPECT_THAT(prepare_sort->ascending(), ElementsAre(false));
+  ASSERT_EQ(prepare_sort->sort_columns().size(), 1);
+  EXPECT_EQ(prepare_sort->sort_columns()[0]->col_name(), "count");
+  EXPECT_EQ(prepare_sort->parents(), sort->parents());
+  EXPECT_NE(prepare_sort, sort);
+
+  auto mem_src2 = MakeMemSource(MakeRelation());
+  auto merge_sort_or_s = mgr.CreateMergeOperator(graph.get(), mem_src2, sort);
+  ASSERT_OK(merge_sort_or_s);
+  OperatorIR* merge_sort_uncasted = merge_sort_or_s.ConsumeValueOrDie();
+  ASSERT_MATCH(merge_sort_uncasted, Sort());
+  SortIR* merge_sort = static_cast<SortIR*>(merge_sort_uncasted);
+  EXPECT_EQ(merge_sort->limit(), 10);
+  EXPECT_EQ(merge_sort->parents()[0], mem_src2);
+  EXPECT_NE(merge_sort, sort);
+
+  // A sort without a limit needs all the rows in one place.
+  auto full_sort = MakeSort(mem_src, {MakeColumn("count", 0)}, {true});
+  EXPECT_FALSE(mgr.Matches(full_sort));
+}
+
 TEST_F(PartialOpMgrTest, agg_test) {
   auto relation = MakeRelation();
   relation.AddColumn(types::STRING, "service");
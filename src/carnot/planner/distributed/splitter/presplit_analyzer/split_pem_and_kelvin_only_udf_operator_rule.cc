@@ -84,21 +84,7 @@ SplitPEMAndKelvinOnlyUDFOperatorRule::OptionallyUpdateExpression(
   PL_RETURN_IF_ERROR(pem_only_map->AddColExpr(col_expr));
 
   // Update the original expression's parent to point to the new column in the PEM-only map.
-  // We may want to refactor this logic into a utility for updating Operator expressions,
-  // so that we don't have to match operator type in every place that we want to replace
-  // expression with a new expression.
-  if (Match(expr_parent, Filter())) {
-    auto filter = static_cast<FilterIR*>(expr_parent);
-    PL_RETURN_IF_ERROR(filter->SetFilterExpr(input_col));
-  } else if (Match(expr_parent, Map())) {
-    auto map = static_cast<MapIR*>(expr_parent);
-    PL_RETURN_IF_ERROR(map->UpdateColExpr(expr, input_col));
-  } else if (Match(expr_parent, Func())) {
-    auto func = static_cast<FuncIR*>(expr_parent);
-    PL_RETURN_IF_ERROR(func->UpdateArg(expr, input_col));
-  } else {
-    return error::Internal("Unexpected parent expression type: $0", expr_parent->type_string());
-  }
+  PL_RETURN_IF_ERROR(ReplaceExpression(expr_parent, expr, input_col));
   return new_col_names;
 }
 
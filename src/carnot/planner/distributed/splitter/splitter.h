@@ -122,6 +122,7 @@ class Splitter : public NotCopyable {
       partial_operator_mgrs_.push_back(std::make_unique<AggOperatorMgr>());
     }
     partial_operator_mgrs_.push_back(std::make_unique<LimitOperatorMgr>());
+    partial_operator_mgrs_.push_back(std::make_unique<SortOperatorMgr>());
     return Status::OK();
   }
   /**
@@ -320,8 +320,8 @@ std::string OperatorIR::ChildrenDebugString() {
 }
 
 std::string MemorySourceIR::DebugString() const {
-  return absl::Substitute("$0(id=$1, table=$2, streaming=$3)", type_string(), id(), table_name_,
-                          streaming_);
+  return absl::Substitute("$0(id=$1, table=$2, streaming=$3, predicates=$4)", type_string(), id(),
+                          table_name_, streaming_, predicates_.size());
 }
 
 Status MemorySourceIR::ToProto(planpb::Operator* op) const {
@@ -353,7 +353,14 @@ Status MemorySourceIR::ToProto(planpb::Operator* op) const {
     pb->set_tablet(tablet_value());
   }
 
+  for (const auto& predicate : predicates_) {
+    *pb->add_predicates() = predicate;
+  }
+
   pb->set_streaming(streaming());
+  if (sampled()) {
+    pb->set_sample_fraction(sample_fraction_);
+  }
   return Status::OK();
 }
 
@@ -673,6 +680,70 @@ Status LimitIR::ToProto(planpb::Operator* op) const {
   return Status::OK();
 }
 
+Status SortIR::Init(OperatorIR* parent, const std::vector<ColumnIR*>& sort_columns,
+                    const std::vector<bool>& ascending) {
+  if (sort_columns.size() != ascending.size()) {
+    return CreateIRNodeError("Expected one sort direction per sort column, got $0 for $1 columns",
+                             ascending.size(), sort_columns.size());
+  }
+  PL_RETURN_IF_ERROR(AddParent(parent));
+  ascending_ = ascending;
+  return SetSortColumns(sort_columns);
+}
+
+Status SortIR::SetSortColumns(const std::vector<ColumnIR*>& sort_columns) {
+  DCHECK(sort_columns_.empty());
+  sort_columns_.resize(sort_columns.size());
+  for (size_t i = 0; i < sort_columns.size(); ++i) {
+    PL_ASSIGN_OR_RETURN(sort_columns_[i], graph()->OptionallyCloneWithEdge(this, sort_columns[i]));
+  }
+  return Status::OK();
+}
+
+std::string SortIR::DebugString() const {
+  std::vector<std::string> sort_cols;
+  for (const auto& [i, col] : Enumerate(sort_columns_)) {
+    sort_cols.push_back(absl::Substitute("$0 $1", col->col_name(), ascending_[i] ? "asc" : "desc"));
+  }
+  return absl::Substitute("$0(id=$1, by=[$2], limit=$3)", type_string(), id(),
+                          absl::StrJoin(sort_cols, ", "), limit_);
+}
+
+StatusOr<std::vector<absl::flat_hash_set<std::string>>> SortIR::RequiredInputColumns() const {
+  DCHECK(IsRelationInit());
+  auto required = ColumnsFromRelation(relation());
+  for (const ColumnIR* col : sort_columns_) {
+    required.insert(col->col_name());
+  }
+  return std::vector<absl::flat_hash_set<std::string>>{required};
+}
+
+Status SortIR::ToProto(planpb::Operator* op) const {
+  auto pb = op->mutable_sort_op();
+  op->set_op_type(planpb::SORT_OPERATOR);
+  DCHECK_EQ(parents().size(), 1UL);
+
+  auto parent_rel = parents()[0]->relation();
+  auto parent_id = parents()[0]->id();
+
+  for (const auto& [i, col] : Enumerate(sort_columns_)) {
+    if (!parent_rel.HasColumn(col->col_name())) {
+      return col->CreateIRNodeError("Sort column '$0' not found in parent relation $1",
+                                    col->col_name(), parent_rel.DebugString());
+    }
+    auto sort_col_pb = pb->add_sort_columns();
+    sort_col_pb->set_index(parent_rel.GetColumnIndex(col->col_name()));
+    sort_col_pb->set_ascending(ascending_[i]);
+  }
+  for (const std::string& col_name : relation().col_names()) {
+    planpb::Column* col_pb = pb->add_columns();
+    col_pb->set_node(parent_id);
+    col_pb->set_index(parent_rel.GetColumnIndex(col_name));
+  }
+  pb->set_limit(limit_);
+  return Status::OK();
+}
+
 Status BlockingAggIR::Init(OperatorIR* parent, const std::vector<ColumnIR*>& groups,
                            const ColExpressionVector& agg_expr) {
   PL_RETURN_IF_ERROR(AddParent(parent));
@@ -801,6 +872,8 @@ Status BlockingAggIR::ToProto(planpb::Operator* op) const {
   pb->set_windowed(false);
   pb->set_partial_agg(partial_agg_);
   pb->set_finalize_results(finalize_results_);
+  pb->set_emit_interval_ns(emit_interval_ns_);
+  pb->set_group_ttl_ns(group_ttl_ns_);
 
   op->set_op_type(planpb::AGGREGATE_OPERATOR);
   return Status::OK();
@@ -1177,9 +1250,10 @@ Status ExpressionIR::CopyFromNode(const IRNode* node,
 // Clone Functions
 StatusOr<std::unique_ptr<IR>> IR::Clone() const {
   auto new_ir = std::make_unique<IR>();
-  absl::flat_hash_set<int64_t> nodes{dag().nodes().begin(), dag().nodes().end()};
-  PL_RETURN_IF_ERROR(new_ir->CopySelectedNodesAndDeps(this, nodes));
+  new_ir->id_node_map_.reserve(id_node_map_.size());
+  PL_RETURN_IF_ERROR(new_ir->CopySelectedNodesAndDeps(this, dag().nodes()));
   // TODO(philkuz) check to make sure these are the same.
+  // This also carries over the cached topological order, so the clone doesn't sort again.
   new_ir->dag_ = dag_;
   return new_ir;
 }
@@ -1187,6 +1261,7 @@ StatusOr<std::unique_ptr<IR>> IR::Clone() const {
 Status IR::CopySelectedNodesAndDeps(const IR* src,
                                     const absl::flat_hash_set<int64_t>& selected_nodes) {
   absl::flat_hash_map<const IRNode*, IRNode*> copied_nodes_map;
+  copied_nodes_map.reserve(selected_nodes.size());
   // Need to perform the copies in topological sort order to ensure the edges can be successfully
   // added.
   for (int64_t i : src->dag().TopologicalSort()) {
@@ -1324,6 +1399,8 @@ Status MemorySourceIR::CopyFromNodeImpl(
   column_index_map_ = source_ir->column_index_map_;
   has_time_expressions_ = source_ir->has_time_expressions_;
   streaming_ = source_ir->streaming_;
+  sample_fraction_ = source_ir->sample_fraction_;
+  predicates_ = source_ir->predicates_;
 
   if (has_time_expressions_) {
     PL_ASSIGN_OR_RETURN(ExpressionIR * new_start_expr,
@@ -1384,6 +1461,8 @@ Status BlockingAggIR::CopyFromNodeImpl(
 
   finalize_results_ = blocking_agg->finalize_results_;
   partial_agg_ = blocking_agg->partial_agg_;
+  emit_interval_ns_ = blocking_agg->emit_interval_ns_;
+  group_ttl_ns_ = blocking_agg->group_ttl_ns_;
   pre_split_proto_ = blocking_agg->pre_split_proto_;
 
   return Status::OK();
@@ -1406,6 +1485,19 @@ Status LimitIR::CopyFromNodeImpl(const IRNode* node, absl::flat_hash_map<const I
   return Status::OK();
 }
 
+Status SortIR::CopyFromNodeImpl(const IRNode* node,
+                                absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) {
+  const SortIR* sort = static_cast<const SortIR*>(node);
+  std::vector<ColumnIR*> new_sort_columns;
+  for (const ColumnIR* column : sort->sort_columns_) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * new_column, graph()->CopyNode(column, copied_nodes_map));
+    new_sort_columns.push_back(new_column);
+  }
+  ascending_ = sort->ascending_;
+  limit_ = sort->limit_;
+  return SetSortColumns(new_sort_columns);
+}
+
 Status GRPCSinkIR::CopyFromNodeImpl(const IRNode* node,
                                     absl::flat_hash_map<const IRNode*, IRNode*>*) {
   const GRPCSinkIR* grpc_sink = static_cast<const GRPCSinkIR*>(node);
@@ -1415,6 +1507,11 @@ Status GRPCSinkIR::CopyFromNodeImpl(const IRNode* node,
   destination_ssl_targetname_ = grpc_sink->destination_ssl_targetname_;
   name_ = grpc_sink->name_;
   out_columns_ = grpc_sink->out_columns_;
+  join_filter_id_ = grpc_sink->join_filter_id_;
+  join_filter_key_indexes_ = grpc_sink->join_filter_key_indexes_;
+  partition_key_indexes_ = grpc_sink->partition_key_indexes_;
+  num_partitions_ = grpc_sink->num_partitions_;
+  partition_index_ = grpc_sink->partition_index_;
   return Status::OK();
 }
 
@@ -1474,6 +1571,8 @@ Status JoinIR::CopyFromNodeImpl(const IRNode* node,
 
   PL_RETURN_IF_ERROR(SetJoinColumns(new_left_columns, new_right_columns));
   suffix_strs_ = join_node->suffix_strs_;
+  build_parent_index_ = join_node->build_parent_index_;
+  join_filter_id_ = join_node->join_filter_id_;
   return Status::OK();
 }
 
@@ -1533,6 +1632,19 @@ Status GRPCSinkIR::ToProto(planpb::Operator* op, int64_t agent_id) const {
     return CreateIRNodeError("No agent ID '$0' found in grpc sink '$1'", agent_id, DebugString());
   }
   pb->set_grpc_source_id(agent_id_to_destination_id_.find(agent_id)->second);
+  if (has_join_filter()) {
+    pb->mutable_join_filter()->set_filter_id(join_filter_id_);
+    for (int64_t idx : join_filter_key_indexes_) {
+      pb->mutable_join_filter()->add_key_column_indexes(idx);
+    }
+  }
+  if (has_partition()) {
+    for (int64_t idx : partition_key_indexes_) {
+      pb->mutable_partition()->add_key_column_indexes(idx);
+    }
+    pb->mutable_partition()->set_num_partitions(num_partitions_);
+    pb->mutable_partition()->set_partition_index(partition_index_);
+  }
   return Status::OK();
 }
 
@@ -1868,6 +1980,8 @@ Status JoinIR::ToProto(planpb::Operator* op) const {
   for (const auto& col_name : column_names_) {
     *(pb->add_column_names()) = col_name;
   }
+  pb->set_build_parent_index(build_parent_index_);
+  pb->set_join_filter_id(join_filter_id_);
   // NOTE: not setting value as this is set in the execution engine. Keeping this here in case it
   // needs to be modified in the future.
   // pb->set_rows_per_batch(1024);
@@ -2212,6 +2326,19 @@ Status ResolveExpressionType(ExpressionIR* expr, CompilerState* compiler_state,
   return expr->SetResolvedType(expr->type_cast());
 }
 
+Status ReplaceExpression(IRNode* expr_parent, ExpressionIR* old_expr, ExpressionIR* new_expr) {
+  if (Match(expr_parent, Filter())) {
+    return static_cast<FilterIR*>(expr_parent)->SetFilterExpr(new_expr);
+  }
+  if (Match(expr_parent, Map())) {
+    return static_cast<MapIR*>(expr_parent)->UpdateColExpr(old_expr, new_expr);
+  }
+  if (Match(expr_parent, Func())) {
+    return static_cast<FuncIR*>(expr_parent)->UpdateArg(old_expr, new_expr);
+  }
+  return error::Internal("Unexpected parent expression type: $0", expr_parent->type_string());
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
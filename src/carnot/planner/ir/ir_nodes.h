@@ -335,6 +335,8 @@ class IR {
   IRNode* Get(int64_t id) const;
 
   size_t size() const { return id_node_map_.size(); }
+  // Nodes created from now on get ids greater or equal to this one.
+  int64_t next_node_id() const { return id_node_counter; }
 
   std::vector<OperatorIR*> GetSources() const;
 
@@ -1286,6 +1288,11 @@ class MemorySourceIR : public OperatorIR {
   bool streaming() const { return streaming_; }
   void set_streaming(bool streaming) { streaming_ = streaming; }
 
+  // The fraction of the table's batches that the MemorySource reads, for approximate queries.
+  double sample_fraction() const { return sample_fraction_; }
+  void set_sample_fraction(double sample_fraction) { sample_fraction_ = sample_fraction; }
+  bool sampled() const { return sample_fraction_ < 1; }
+
   Status SetTimeExpressions(ExpressionIR* start_time_expr, ExpressionIR* end_time_expr);
 
   // Sets the time expressions that eventually get converted
@@ -1318,6 +1325,13 @@ class MemorySourceIR : public OperatorIR {
     column_index_map_ = column_index_map;
   }
 
+  // Predicates pushed down from a filter. Their column_idx refers to the table, not to the
+  // output columns of this source.
+  const std::vector<planpb::ColumnPredicate>& predicates() const { return predicates_; }
+  void AddPredicate(planpb::ColumnPredicate predicate) {
+    predicates_.push_back(std::move(predicate));
+  }
+
   Status ToProto(planpb::Operator*) const override;
 
   bool select_all() const { return column_names_.size() == 0; }
@@ -1353,6 +1367,7 @@ class MemorySourceIR : public OperatorIR {
  private:
   std::string table_name_;
   bool streaming_ = false;
+  double sample_fraction_ = 1;
 
   bool has_time_expressions_ = false;
   ExpressionIR* start_time_expr_ = nullptr;
@@ -1369,6 +1384,8 @@ class MemorySourceIR : public OperatorIR {
   std::vector<int64_t> column_index_map_;
   bool column_index_map_set_ = false;
 
+  std::vector<planpb::ColumnPredicate> predicates_;
+
   types::TabletID tablet_value_;
   bool has_tablet_value_ = false;
 };
@@ -1599,6 +1616,15 @@ class BlockingAggIR : public GroupAcceptorIR {
 
   bool partial_agg() const { return partial_agg_; }
   bool finalize_results() const { return finalize_results_; }
+
+  // Set for aggregates in streaming queries, which emit the groups they updated periodically
+  // instead of at the end of their input. See planpb::AggregateOperator::emit_interval_ns.
+  void SetEmitIntervalNS(int64_t emit_interval_ns) { emit_interval_ns_ = emit_interval_ns; }
+  int64_t emit_interval_ns() const { return emit_interval_ns_; }
+  // See planpb::AggregateOperator::group_ttl_ns.
+  void SetGroupTTLNS(int64_t group_ttl_ns) { group_ttl_ns_ = group_ttl_ns; }
+  int64_t group_ttl_ns() const { return group_ttl_ns_; }
+
   void SetPreSplitProto(const planpb::AggregateOperator& pre_split_proto) {
     pre_split_proto_ = pre_split_proto;
   }
@@ -1614,6 +1640,8 @@ class BlockingAggIR : public GroupAcceptorIR {
   bool partial_agg_ = true;
   // Whether this finalizes the result of a partial aggregate.
   bool finalize_results_ = true;
+  int64_t emit_interval_ns_ = 0;
+  int64_t group_ttl_ns_ = 0;
   planpb::AggregateOperator pre_split_proto_;
 };
 
@@ -1713,6 +1741,48 @@ class LimitIR : public OperatorIR {
   std::unordered_set<int64_t> abortable_srcs_;
 };
 
+/**
+ * @brief IR for an operator that orders its input by a set of columns. When a limit is set, only
+ * the first rows in that order are output, which makes the sort a top-K that every agent can run
+ * on its own data before the results are merged.
+ */
+class SortIR : public OperatorIR {
+ public:
+  SortIR() = delete;
+  explicit SortIR(int64_t id) : OperatorIR(id, IRNodeType::kSort) {}
+
+  Status Init(OperatorIR* parent, const std::vector<ColumnIR*>& sort_columns,
+              const std::vector<bool>& ascending);
+  Status ToProto(planpb::Operator*) const override;
+  std::string DebugString() const override;
+
+  const std::vector<ColumnIR*>& sort_columns() const { return sort_columns_; }
+  const std::vector<bool>& ascending() const { return ascending_; }
+
+  // The number of rows the sort outputs, 0 if it outputs all the rows.
+  int64_t limit() const { return limit_; }
+  void SetLimit(int64_t limit) { limit_ = limit; }
+
+  Status CopyFromNodeImpl(const IRNode* node,
+                          absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) override;
+  inline bool IsBlocking() const override { return true; }
+
+  StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
+
+ protected:
+  StatusOr<absl::flat_hash_set<std::string>> PruneOutputColumnsToImpl(
+      const absl::flat_hash_set<std::string>& output_cols) override {
+    return output_cols;
+  }
+
+ private:
+  Status SetSortColumns(const std::vector<ColumnIR*>& sort_columns);
+
+  std::vector<ColumnIR*> sort_columns_;
+  std::vector<bool> ascending_;
+  int64_t limit_ = 0;
+};
+
 /**
  * @brief IR for the network sink operator that passes batches over GRPC to the destination.
  *
@@ -1797,6 +1867,10 @@ class GRPCSinkIR : public OperatorIR {
   void set_name(const std::string& name) { name_ = name; }
   // When out_columns_ is empty, the full input relation will be written to the sink.
   const std::vector<std::string>& out_columns() const { return out_columns_; }
+  Status SetOutColumns(std::vector<std::string> new_out_columns) {
+    out_columns_ = std::move(new_out_columns);
+    return Status::OK();
+  }
 
   inline bool IsBlocking() const override { return true; }
 
@@ -1816,6 +1890,27 @@ class GRPCSinkIR : public OperatorIR {
     return agent_id_to_destination_id_;
   }
 
+  // The join filter the sent rows are checked against, see planpb::GRPCSinkOperator.
+  bool has_join_filter() const { return join_filter_id_ != 0; }
+  int64_t join_filter_id() const { return join_filter_id_; }
+  const std::vector<int64_t>& join_filter_key_indexes() const { return join_filter_key_indexes_; }
+  void SetJoinFilter(int64_t join_filter_id, const std::vector<int64_t>& key_indexes) {
+    join_filter_id_ = join_filter_id;
+    join_filter_key_indexes_ = key_indexes;
+  }
+
+  // The hash partition of the rows the sink sends, see planpb::GRPCSinkOperator.
+  bool has_partition() const { return num_partitions_ != 0; }
+  const std::vector<int64_t>& partition_key_indexes() const { return partition_key_indexes_; }
+  int64_t num_partitions() const { return num_partitions_; }
+  int64_t partition_index() const { return partition_index_; }
+  void SetPartition(const std::vector<int64_t>& key_indexes, int64_t num_partitions,
+                    int64_t partition_index) {
+    partition_key_indexes_ = key_indexes;
+    num_partitions_ = num_partitions;
+    partition_index_ = partition_index;
+  }
+
  protected:
   Status CopyFromNodeImpl(const IRNode* node,
                           absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) override;
@@ -1834,6 +1929,13 @@ class GRPCSinkIR : public OperatorIR {
   std::string name_;
   std::vector<std::string> out_columns_;
   absl::flat_hash_map<int64_t, int64_t> agent_id_to_destination_id_;
+  // Used when the destination is the probe side of a join that publishes a join filter.
+  int64_t join_filter_id_ = 0;
+  std::vector<int64_t> join_filter_key_indexes_;
+  // Used when the rows are split over several destinations by a hash of their key.
+  std::vector<int64_t> partition_key_indexes_;
+  int64_t num_partitions_ = 0;
+  int64_t partition_index_ = 0;
 };
 
 /**
@@ -2055,6 +2157,15 @@ class JoinIR : public OperatorIR {
   Status SetOutputColumns(const std::vector<std::string>& column_names,
                           const std::vector<ColumnIR*>& columns);
   bool specified_as_right() const { return specified_as_right_; }
+  // The parent the executor builds its hash table on, see planpb::JoinOperator.
+  int64_t build_parent_index() const { return build_parent_index_; }
+  void SetBuildParentIndex(int64_t build_parent_index) {
+    DCHECK_LT(build_parent_index, 2);
+    build_parent_index_ = build_parent_index;
+  }
+  // The id of the filter the join publishes on its build keys, or 0 if it doesn't publish one.
+  int64_t join_filter_id() const { return join_filter_id_; }
+  void SetJoinFilterID(int64_t join_filter_id) { join_filter_id_ = join_filter_id; }
 
   StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
 
@@ -2125,6 +2236,9 @@ class JoinIR : public OperatorIR {
   // Whether this join was originally specified as a right join.
   // Used because we transform left joins into right joins but need to do some back transform.
   bool specified_as_right_ = false;
+  // The parent to build the hash table on.
+  int64_t build_parent_index_ = 0;
+  int64_t join_filter_id_ = 0;
 };
 
 /*
@@ -2313,6 +2427,12 @@ Status ResolveOperatorType(OperatorIR* op, CompilerState* compiler_state);
 
 Status ResolveExpressionType(ExpressionIR* expr, CompilerState* compiler_state,
                              const std::vector<TypePtr>& parent_types);
+
+/**
+ * @brief Replaces old_expr with new_expr in expr_parent, which is the Map, Filter or Func that
+ * holds old_expr. old_expr is deleted if nothing else references it.
+ */
+Status ReplaceExpression(IRNode* expr_parent, ExpressionIR* old_expr, ExpressionIR* new_expr);
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
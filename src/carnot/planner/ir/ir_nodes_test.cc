@@ -499,6 +499,46 @@ TEST(ToProto, agg_ir_with_presplit_proto) {
   EXPECT_THAT(cloned_pb, EqualsProto(kExpectedAggPb));
 }
 
+TEST(ToProto, streaming_agg_ir) {
+  auto ast = MakeTestAstPtr();
+  auto graph = std::make_shared<IR>();
+  auto mem_src = graph
+                     ->CreateNode<MemorySourceIR>(
+                         ast, "source", std::vector<std::string>{"col1", "group1", "column"})
+                     .ValueOrDie();
+  table_store::schema::Relation rel({types::INT64, types::INT64, types::INT64},
+                                    {"col1", "group1", "column"});
+  EXPECT_OK(mem_src->SetRelation(rel));
+  auto constant = graph->CreateNode<IntIR>(ast, 10).ValueOrDie();
+  auto col = graph->CreateNode<ColumnIR>(ast, "column", /*parent_op_idx*/ 0).ValueOrDie();
+  col->ResolveColumnType(types::INT64);
+
+  auto agg_func = graph
+                      ->CreateNode<FuncIR>(ast, FuncIR::Op{FuncIR::Opcode::non_op, "", "mean"},
+                                           std::vector<ExpressionIR*>{constant, col})
+                      .ValueOrDie();
+
+  auto group1 = graph->CreateNode<ColumnIR>(ast, "group1", /*parent_op_idx*/ 0).ValueOrDie();
+  group1->ResolveColumnType(types::INT64);
+
+  auto agg = graph
+                 ->CreateNode<BlockingAggIR>(ast, mem_src, std::vector<ColumnIR*>{group1},
+                                             ColExpressionVector{{"mean", agg_func}})
+                 .ValueOrDie();
+  agg->SetEmitIntervalNS(1000);
+  agg->SetGroupTTLNS(60000);
+
+  planpb::Operator pb;
+  ASSERT_OK(agg->ToProto(&pb));
+  EXPECT_EQ(1000, pb.agg_op().emit_interval_ns());
+  EXPECT_EQ(60000, pb.agg_op().group_ttl_ns());
+
+  // The partial and finalize aggregates the splitter copies from it keep the settings.
+  ASSERT_OK_AND_ASSIGN(BlockingAggIR * cloned_agg, graph->CopyNode(agg));
+  EXPECT_EQ(1000, cloned_agg->emit_interval_ns());
+  EXPECT_EQ(60000, cloned_agg->group_ttl_ns());
+}
+
 constexpr char kExpectedLimitPb[] = R"(
   op_type: LIMIT_OPERATOR
   limit_op {
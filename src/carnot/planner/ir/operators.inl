@@ -36,5 +36,6 @@ PL_IR_NODE(UDTFSource)
 PL_IR_NODE(Rolling)
 PL_IR_NODE(Stream)
 PL_IR_NODE(EmptySource)
+PL_IR_NODE(Sort)
 
 #endif
@@ -121,6 +121,12 @@ struct ClassMatch : public ParentMatch {
 // Match an arbitrary Int value.
 inline ClassMatch<IRNodeType::kInt> Int() { return ClassMatch<IRNodeType::kInt>(); }
 
+// Match an arbitrary Float value.
+inline ClassMatch<IRNodeType::kFloat> Float() { return ClassMatch<IRNodeType::kFloat>(); }
+
+// Match an arbitrary Bool value.
+inline ClassMatch<IRNodeType::kBool> Bool() { return ClassMatch<IRNodeType::kBool>(); }
+
 // Match an arbitrary String value.
 inline ClassMatch<IRNodeType::kString> String() { return ClassMatch<IRNodeType::kString>(); }
 
@@ -141,6 +147,7 @@ inline ClassMatch<IRNodeType::kEmptySource> EmptySource() {
   return ClassMatch<IRNodeType::kEmptySource>();
 }
 inline ClassMatch<IRNodeType::kLimit> Limit() { return ClassMatch<IRNodeType::kLimit>(); }
+inline ClassMatch<IRNodeType::kSort> Sort() { return ClassMatch<IRNodeType::kSort>(); }
 
 inline ClassMatch<IRNodeType::kGRPCSource> GRPCSource() {
   return ClassMatch<IRNodeType::kGRPCSource>();
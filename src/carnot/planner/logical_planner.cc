@@ -18,7 +18,13 @@
 
 #include "src/carnot/planner/logical_planner.h"
 
+#include <algorithm>
+#include <string>
 #include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <farmhash.h>
 
 #include "src/shared/scriptspb/scripts.pb.h"
 
@@ -50,16 +56,51 @@ StatusOr<std::unique_ptr<RelationMap>> MakeRelationMapFromDistributedState(
   return rel_map;
 }
 
-StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
-    const distributedpb::LogicalPlannerState& logical_state, RegistryInfo* registry_info,
-    int64_t max_output_rows_per_table) {
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<RelationMap> rel_map,
-                      MakeRelationMapFromDistributedState(logical_state.distributed_state()));
-  // Create a CompilerState obj using the relation map and grabbing the current time.
+// The relations don't depend on which agents hold the tables, so only the names and relations go
+// in the fingerprint.
+uint64_t SchemaFingerprint(const distributedpb::DistributedState& state_pb) {
+  std::string schemas;
+  for (const auto& schema_info : state_pb.schema_info()) {
+    schemas.append(schema_info.name());
+    schemas.push_back('\0');
+    schemas.append(schema_info.relation().SerializeAsString());
+  }
+  return ::util::Fingerprint64(schemas.data(), schemas.size());
+}
+
+StatusOr<std::shared_ptr<const RelationMap>> LogicalPlanner::GetRelationMap(
+    const distributedpb::DistributedState& state_pb) {
+  // The script inspection calls don't have a schema; they don't replace the cached map.
+  if (state_pb.schema_info_size() == 0) {
+    return std::make_shared<const RelationMap>();
+  }
+  uint64_t fingerprint = SchemaFingerprint(state_pb);
+  if (relation_map_ == nullptr || fingerprint != relation_map_fingerprint_) {
+    PL_ASSIGN_OR_RETURN(std::unique_ptr<RelationMap> rel_map,
+                        MakeRelationMapFromDistributedState(state_pb));
+    relation_map_ = std::move(rel_map);
+    relation_map_fingerprint_ = fingerprint;
+  }
+  return relation_map_;
+}
+
+StatusOr<std::unique_ptr<CompilerState>> LogicalPlanner::CreateCompilerState(
+    const distributedpb::LogicalPlannerState& logical_state, int64_t max_output_rows_per_table) {
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<const RelationMap> rel_map,
+                      GetRelationMap(logical_state.distributed_state()));
+  return CreateCompilerState(logical_state, std::move(rel_map), max_output_rows_per_table);
+}
 
-  return std::make_unique<planner::CompilerState>(
-      std::move(rel_map), registry_info, px::CurrentTimeNS(), max_output_rows_per_table,
+std::unique_ptr<CompilerState> LogicalPlanner::CreateCompilerState(
+    const distributedpb::LogicalPlannerState& logical_state,
+    std::shared_ptr<const RelationMap> rel_map, int64_t max_output_rows_per_table) {
+  // Create a CompilerState obj using the relation map and grabbing the current time.
+  auto compiler_state = std::make_unique<planner::CompilerState>(
+      std::move(rel_map), registry_info_.get(), px::CurrentTimeNS(), max_output_rows_per_table,
       logical_state.result_address(), logical_state.result_ssl_targetname());
+  compiler_state->set_table_row_estimates({logical_state.table_row_estimates().begin(),
+                                           logical_state.table_row_estimates().end()});
+  return compiler_state;
 }
 
 StatusOr<std::unique_ptr<LogicalPlanner>> LogicalPlanner::Create(const udfspb::UDFInfo& udf_info) {
@@ -84,18 +125,100 @@ StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
   auto ms = logical_state.plan_options().max_output_rows_per_table();
   VLOG(1) << "Max output rows: " << ms;
   PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState(logical_state, registry_info_.get(), ms));
+                      CreateCompilerState(logical_state, ms));
+  return Plan(logical_state, query_request, compiler_state.get());
+}
+
+StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request, CompilerState* compiler_state) {
+  absl::flat_hash_map<std::string, std::vector<std::string>> result_columns;
+  for (const auto& [table_name, columns] : query_request.result_columns()) {
+    result_columns[table_name] = {columns.column_names().begin(), columns.column_names().end()};
+  }
+  compiler_state->set_result_columns(std::move(result_columns));
 
   std::vector<plannerpb::FuncToExecute> exec_funcs(query_request.exec_funcs().begin(),
                                                    query_request.exec_funcs().end());
-  PL_ASSIGN_OR_RETURN(
-      std::shared_ptr<IR> single_node_plan,
-      compiler_.CompileToIR(query_request.query_str(), compiler_state.get(), exec_funcs));
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<IR> single_node_plan,
+                      compiler_.CompileToIR(query_request.query_str(), compiler_state, exec_funcs));
   // Create the distributed plan.
-  return distributed_planner_->Plan(logical_state.distributed_state(), compiler_state.get(),
+  return distributed_planner_->Plan(logical_state.distributed_state(), compiler_state,
                                     single_node_plan.get());
 }
 
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanToProto(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request) {
+  PlanCacheKey key = PlanCache::MakeKey(logical_state, query_request);
+  distributedpb::DistributedPlan plan_pb;
+  if (plan_cache_.Lookup(key, &plan_pb)) {
+    return plan_pb;
+  }
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<const RelationMap> rel_map,
+                      GetRelationMap(logical_state.distributed_state()));
+  return PlanToProto(logical_state, logical_state.plan_options(), std::move(rel_map),
+                     std::move(key), query_request);
+}
+
+Status LogicalPlanner::SetResidentState(int64_t version,
+                                        distributedpb::LogicalPlannerState logical_state) {
+  if (!resident_states_.empty() && version <= resident_states_.back().version) {
+    return error::InvalidArgument("Planner state version $0 is not newer than the resident $1",
+                                  version, resident_states_.back().version);
+  }
+  logical_state.clear_plan_options();
+
+  ResidentState resident;
+  resident.version = version;
+  PL_ASSIGN_OR_RETURN(resident.relation_map, GetRelationMap(logical_state.distributed_state()));
+  resident.fingerprint = PlanCache::StateFingerprint(logical_state);
+  resident.logical_state = std::move(logical_state);
+
+  resident_states_.push_back(std::move(resident));
+  while (resident_states_.size() > kMaxResidentStates) {
+    resident_states_.pop_front();
+  }
+  return Status::OK();
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanToProto(
+    int64_t state_version, const planpb::PlanOptions& plan_options,
+    const plannerpb::QueryRequest& query_request) {
+  auto it = std::find_if(resident_states_.begin(), resident_states_.end(),
+                         [&](const ResidentState& s) { return s.version == state_version; });
+  if (it == resident_states_.end()) {
+    return error::NotFound("Planner state version $0 is not resident", state_version);
+  }
+  const ResidentState& resident = *it;
+
+  PlanCacheKey key = PlanCache::MakeKey(resident.fingerprint, plan_options, query_request);
+  distributedpb::DistributedPlan plan_pb;
+  if (plan_cache_.Lookup(key, &plan_pb)) {
+    return plan_pb;
+  }
+  return PlanToProto(resident.logical_state, plan_options, resident.relation_map, std::move(key),
+                     query_request);
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanToProto(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const planpb::PlanOptions& plan_options, std::shared_ptr<const RelationMap> rel_map,
+    PlanCacheKey key, const plannerpb::QueryRequest& query_request) {
+  std::unique_ptr<CompilerState> compiler_state = CreateCompilerState(
+      logical_state, std::move(rel_map), plan_options.max_output_rows_per_table());
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<distributed::DistributedPlan> plan,
+                      Plan(logical_state, query_request, compiler_state.get()));
+  plan->SetPlanOptions(plan_options);
+  distributedpb::DistributedPlan plan_pb;
+  PL_ASSIGN_OR_RETURN(plan_pb, plan->ToProto());
+
+  if (!compiler_state->time_now_used()) {
+    plan_cache_.Insert(std::move(key), plan_pb);
+  }
+  return plan_pb;
+}
+
 StatusOr<std::unique_ptr<compiler::MutationsIR>> LogicalPlanner::CompileTrace(
     const distributedpb::LogicalPlannerState& logical_state,
     const plannerpb::CompileMutationsRequest& mutations_req) {
@@ -103,7 +226,7 @@ StatusOr<std::unique_ptr<compiler::MutationsIR>> LogicalPlanner::CompileTrace(
   auto ms = logical_state.plan_options().max_output_rows_per_table();
   VLOG(1) << "Max output rows: " << ms;
   PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState(logical_state, registry_info_.get(), ms));
+                      CreateCompilerState(logical_state, ms));
 
   std::vector<plannerpb::FuncToExecute> exec_funcs(mutations_req.exec_funcs().begin(),
                                                    mutations_req.exec_funcs().end());
@@ -113,16 +236,14 @@ StatusOr<std::unique_ptr<compiler::MutationsIR>> LogicalPlanner::CompileTrace(
 
 StatusOr<shared::scriptspb::FuncArgsSpec> LogicalPlanner::GetMainFuncArgsSpec(
     const plannerpb::QueryRequest& query_request) {
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState({}, registry_info_.get(), 0));
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state, CreateCompilerState({}, 0));
 
   return compiler_.GetMainFuncArgsSpec(query_request.query_str(), compiler_state.get());
 }
 
 StatusOr<px::shared::scriptspb::VisFuncsInfo> LogicalPlanner::GetVisFuncsInfo(
     const std::string& script_str) {
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState({}, registry_info_.get(), 0));
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state, CreateCompilerState({}, 0));
 
   return compiler_.GetVisFuncsInfo(script_str, compiler_state.get());
 }
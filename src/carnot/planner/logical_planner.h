@@ -17,6 +17,7 @@
  */
 
 #pragma once
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
@@ -25,6 +26,7 @@
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
 #include "src/carnot/planner/distributed/distributed_planner.h"
+#include "src/carnot/planner/plan_cache.h"
 #include "src/carnot/planner/plannerpb/func_args.pb.h"
 #include "src/carnot/planner/probes/probes.h"
 #include "src/shared/scriptspb/scripts.pb.h"
@@ -58,6 +60,46 @@ class LogicalPlanner : public NotCopyable {
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::QueryRequest& query);
 
+  /**
+   * @brief Plans the query and converts the distributed plan to its proto, with the plan options
+   * of the logical state set. Plans are cached across calls, so a script that is planned again
+   * against the same logical state is not compiled again. Scripts that read the current time
+   * (eg. relative start times) are always compiled, since their plan changes with the time.
+   *
+   * @param logical_state: the distributed layout of the vizier instance.
+   * @param query: QueryRequest
+   * @return distributedpb::DistributedPlan or error if one occurs during compilation.
+   */
+  StatusOr<distributedpb::DistributedPlan> PlanToProto(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query);
+
+  // The number of resident states kept, see SetResidentState().
+  static constexpr size_t kMaxResidentStates = 2;
+
+  /**
+   * @brief Keeps a planner state resident under a version picked by the caller, so that the
+   * plans against it don't send and parse it again. The plan options of the state are ignored,
+   * each plan comes with its own. The last kMaxResidentStates versions are kept, so that the plans
+   * in flight against the previous state still go through while the caller moves to the new one.
+   *
+   * @param version: a version that is greater than the ones set before.
+   * @param logical_state: the distributed layout of the vizier instance.
+   */
+  Status SetResidentState(int64_t version, distributedpb::LogicalPlannerState logical_state);
+
+  /**
+   * @brief Same as PlanToProto() above, against a state set by SetResidentState().
+   *
+   * @return the distributed plan, or error::NotFound if the version isn't resident (any more), in
+   * which case the caller sets the state again.
+   */
+  StatusOr<distributedpb::DistributedPlan> PlanToProto(int64_t state_version,
+                                                       const planpb::PlanOptions& plan_options,
+                                                       const plannerpb::QueryRequest& query);
+
+  const PlanCache& plan_cache() const { return plan_cache_; }
+
   StatusOr<std::unique_ptr<compiler::MutationsIR>> CompileTrace(
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::CompileMutationsRequest& mutations_req);
@@ -87,9 +129,45 @@ class LogicalPlanner : public NotCopyable {
   LogicalPlanner() {}
 
  private:
+  StatusOr<std::unique_ptr<distributed::DistributedPlan>> Plan(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query, CompilerState* compiler_state);
+
+  StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
+      const distributedpb::LogicalPlannerState& logical_state, int64_t max_output_rows_per_table);
+  std::unique_ptr<CompilerState> CreateCompilerState(
+      const distributedpb::LogicalPlannerState& logical_state,
+      std::shared_ptr<const RelationMap> relation_map, int64_t max_output_rows_per_table);
+
+  StatusOr<distributedpb::DistributedPlan> PlanToProto(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const planpb::PlanOptions& plan_options, std::shared_ptr<const RelationMap> relation_map,
+      PlanCacheKey key, const plannerpb::QueryRequest& query);
+
+  /**
+   * Returns the relations of the schemas in the distributed state. The map is only rebuilt when
+   * the schemas change, and shared by the compiles in between.
+   */
+  StatusOr<std::shared_ptr<const RelationMap>> GetRelationMap(
+      const distributedpb::DistributedState& state_pb);
+
   compiler::Compiler compiler_;
   std::unique_ptr<distributed::Planner> distributed_planner_;
   std::unique_ptr<planner::RegistryInfo> registry_info_;
+  PlanCache plan_cache_;
+  // The map of the last schemas seen, and their fingerprint.
+  std::shared_ptr<const RelationMap> relation_map_;
+  uint64_t relation_map_fingerprint_ = 0;
+
+  struct ResidentState {
+    int64_t version;
+    // Without plan options.
+    distributedpb::LogicalPlannerState logical_state;
+    std::shared_ptr<const RelationMap> relation_map;
+    uint64_t fingerprint;
+  };
+  // Oldest first.
+  std::deque<ResidentState> resident_states_;
 };
 
 }  // namespace planner
@@ -39,6 +39,7 @@ namespace px {
 namespace carnot {
 namespace planner {
 using px::testing::proto::EqualsProto;
+using ::testing::ElementsAre;
 
 class LogicalPlannerTest : public ::testing::Test {
  protected:
@@ -71,6 +72,111 @@ TEST_F(LogicalPlannerTest, distributed_plan_test_basic_queries) {
   EXPECT_OK(plan->ToProto());
 }
 
+TEST_F(LogicalPlannerTest, plan_to_proto_cached) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState();
+  auto query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+  auto plan_pb = planner->PlanToProto(state, query).ConsumeValueOrDie();
+  EXPECT_THAT(plan_pb, Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
+
+  auto cached_plan_pb = planner->PlanToProto(state, query).ConsumeValueOrDie();
+  EXPECT_THAT(cached_plan_pb, EqualsProto(plan_pb.DebugString()));
+  EXPECT_EQ(planner->plan_cache().hits(), 1);
+
+  // A different planner state needs a new plan.
+  state.mutable_plan_options()->set_max_output_rows_per_table(100);
+  ASSERT_OK(planner->PlanToProto(state, query));
+  EXPECT_EQ(planner->plan_cache().hits(), 1);
+  EXPECT_EQ(planner->plan_cache().size(), 2);
+}
+
+TEST_F(LogicalPlannerTest, plan_with_resident_state) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState();
+  auto query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+
+  ASSERT_OK(planner->SetResidentState(1, state));
+  auto plan_pb = planner->PlanToProto(1, state.plan_options(), query).ConsumeValueOrDie();
+  EXPECT_THAT(plan_pb, Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
+
+  ASSERT_OK(planner->PlanToProto(1, state.plan_options(), query));
+  EXPECT_EQ(planner->plan_cache().hits(), 1);
+
+  // The versions only move forward.
+  EXPECT_NOT_OK(planner->SetResidentState(1, state));
+}
+
+TEST_F(LogicalPlannerTest, resident_states_evicted) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState();
+  auto query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+  planpb::PlanOptions plan_options;
+
+  EXPECT_EQ(planner->PlanToProto(1, plan_options, query).code(), statuspb::NOT_FOUND);
+
+  ASSERT_OK(planner->SetResidentState(1, state));
+  ASSERT_OK(planner->SetResidentState(2, state));
+  ASSERT_OK(planner->PlanToProto(1, plan_options, query));
+  ASSERT_OK(planner->SetResidentState(3, state));
+  EXPECT_EQ(planner->PlanToProto(1, plan_options, query).code(), statuspb::NOT_FOUND);
+  ASSERT_OK(planner->PlanToProto(2, plan_options, query));
+  ASSERT_OK(planner->PlanToProto(3, plan_options, query));
+}
+
+TEST_F(LogicalPlannerTest, relations_follow_schema_changes) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto table1_query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+  ASSERT_OK(planner->Plan(testutils::CreateOnePEMOneKelvinPlannerState(), table1_query));
+
+  // The relations are rebuilt for the tables of the new schema, and again for the old one.
+  auto http_state = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  ASSERT_OK(planner->Plan(http_state, MakeQueryRequest(testutils::kHttpRequestStats)));
+  ASSERT_OK(planner->Plan(testutils::CreateOnePEMOneKelvinPlannerState(), table1_query));
+}
+
+TEST_F(LogicalPlannerTest, result_columns) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState();
+  auto query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+  (*query.mutable_result_columns())["out"].add_column_names("cpu_cycles");
+  ASSERT_OK_AND_ASSIGN(auto plan_pb, planner->PlanToProto(state, query));
+
+  int num_result_sinks = 0;
+  for (const auto& [address, plan] : plan_pb.qb_address_to_plan()) {
+    for (const auto& fragment : plan.nodes()) {
+      for (const auto& node : fragment.nodes()) {
+        // The other columns aren't read either.
+        if (node.op().has_mem_source_op()) {
+          EXPECT_THAT(node.op().mem_source_op().column_names(), ElementsAre("cpu_cycles"));
+        }
+        if (node.op().has_grpc_sink_op() && node.op().grpc_sink_op().has_output_table()) {
+          EXPECT_THAT(node.op().grpc_sink_op().output_table().column_names(),
+                      ElementsAre("cpu_cycles"));
+          ++num_result_sinks;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(1, num_result_sinks);
+
+  // The full result is a different plan.
+  query.clear_result_columns();
+  ASSERT_OK(planner->PlanToProto(state, query));
+  EXPECT_EQ(planner->plan_cache().hits(), 0);
+  EXPECT_EQ(planner->plan_cache().size(), 2);
+}
+
+TEST_F(LogicalPlannerTest, plan_to_proto_not_cached_with_relative_time) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState();
+  auto query = MakeQueryRequest(
+      "import px\npx.display(px.DataFrame('table1', start_time='-5m'), 'out')");
+  ASSERT_OK(planner->PlanToProto(state, query));
+  ASSERT_OK(planner->PlanToProto(state, query));
+  EXPECT_EQ(planner->plan_cache().hits(), 0);
+  EXPECT_EQ(planner->plan_cache().size(), 0);
+}
+
 constexpr char kSimpleQueryDefaultLimit[] = R"pxl(
 import px
 t1 = px.DataFrame(table='http_events', start_time='-120s', select=['time_'])
@@ -74,11 +74,12 @@ StatusOr<std::vector<std::string>> ParseAsListOfStrings(QLObjectPtr obj,
 Status Dataframe::Init() {
   PL_ASSIGN_OR_RETURN(
       std::shared_ptr<FuncObject> constructor_fn,
-      FuncObject::Create(name(), {"table", "select", "start_time", "end_time"},
+      FuncObject::Create(name(), {"table", "select", "start_time", "end_time", "sample"},
                          {{"select", "[]"},
                           {"start_time", "0"},
                           {"end_time", absl::Substitute("$0.$1()", PixieModule::kPixieModuleObjName,
-                                                        PixieModule::kNowOpID)}},
+                                                        PixieModule::kNowOpID)},
+                          {"sample", "1"}},
                          /* has_variable_len_args */ false,
                          /* has_variable_len_kwargs */ false,
                          std::bind(&DataFrameHandler::Eval, graph(), std::placeholders::_1,
@@ -172,6 +173,22 @@ Status Dataframe::Init() {
   PL_RETURN_IF_ERROR(limitfn->SetDocString(kLimitOpDocstring));
   AddMethod(kLimitOpID, limitfn);
 
+  /**
+   * # Equivalent to the python method method syntax:
+   * def sort_values(self, by, ascending=True):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> sortfn,
+      FuncObject::Create(kSortOpID, {"by", "ascending"}, {{"ascending", "True"}},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&SortHandler::Eval, graph(), op(), std::placeholders::_1,
+                                   std::placeholders::_2, std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(sortfn->SetDocString(kSortOpDocstring));
+  AddMethod(kSortOpID, sortfn);
+
   /**
    *
    * # Equivalent to the python method method syntax:
@@ -418,6 +435,40 @@ StatusOr<QLObjectPtr> LimitHandler::Eval(IR* graph, OperatorIR* op, const pypa::
   return Dataframe::Create(limit_op, visitor);
 }
 
+StatusOr<QLObjectPtr> SortHandler::Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                        const ParsedArgs& args, ASTVisitor* visitor) {
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> sort_names,
+                      ParseAsListOfStrings(args.GetArg("by"), "by"));
+  if (sort_names.empty()) {
+    return CreateAstError(ast, "'by' must name at least one column");
+  }
+  PL_ASSIGN_OR_RETURN(std::vector<BoolIR*> ascending_irs,
+                      ParseAsListOf<BoolIR>(args.GetArg("ascending"), "ascending"));
+  std::vector<bool> ascending;
+  for (BoolIR* ascending_ir : ascending_irs) {
+    ascending.push_back(ascending_ir->val());
+  }
+  if (ascending.size() == 1) {
+    ascending.resize(sort_names.size(), ascending[0]);
+  }
+  if (ascending.size() != sort_names.size()) {
+    return CreateAstError(ast, "'ascending' has $0 values but $1 columns are sorted on",
+                          ascending.size(), sort_names.size());
+  }
+
+  std::vector<ColumnIR*> sort_columns;
+  sort_columns.reserve(sort_names.size());
+  for (const auto& sort_name : sort_names) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * col,
+                        graph->CreateNode<ColumnIR>(ast, sort_name, /* parent_idx */ 0));
+    sort_columns.push_back(col);
+  }
+
+  PL_ASSIGN_OR_RETURN(SortIR * sort_op,
+                      graph->CreateNode<SortIR>(ast, op, sort_columns, ascending));
+  return Dataframe::Create(sort_op, visitor);
+}
+
 StatusOr<QLObjectPtr> SubscriptHandler::Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
                                              const ParsedArgs& args, ASTVisitor* visitor) {
   QLObjectPtr key = args.GetArg("key");
@@ -542,6 +593,21 @@ StatusOr<QLObjectPtr> DataFrameHandler::Eval(IR* graph, const pypa::AstPtr& ast,
         args.default_subbed_args().contains("end_time"))) {
     PL_RETURN_IF_ERROR(mem_source_op->SetTimeExpressions(start_time, end_time));
   }
+
+  PL_ASSIGN_OR_RETURN(ExpressionIR * sample, GetArgAs<ExpressionIR>(ast, args, "sample"));
+  double sample_fraction;
+  if (Match(sample, Float())) {
+    sample_fraction = static_cast<FloatIR*>(sample)->val();
+  } else if (Match(sample, Int())) {
+    sample_fraction = static_cast<double>(static_cast<IntIR*>(sample)->val());
+  } else {
+    return sample->CreateIRNodeError("'sample' must be a number, not $0",
+                                     sample->type_string());
+  }
+  if (!(sample_fraction > 0 && sample_fraction <= 1)) {
+    return sample->CreateIRNodeError("'sample' must be in (0, 1], not $0", sample_fraction);
+  }
+  mem_source_op->set_sample_fraction(sample_fraction);
   return Dataframe::Create(mem_source_op, visitor);
 }
 
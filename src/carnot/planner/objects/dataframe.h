@@ -85,6 +85,10 @@ class Dataframe : public QLObject {
   Examples:
     # Absolute time specification.
     df = px.DataFrame('http_events', start_time='2020-07-13 18:02:5.00 -0700')
+  Examples:
+    # Approximate the request count over a day from a tenth of the data.
+    df = px.DataFrame('http_events', start_time='-24h', sample=0.1)
+    df = df.agg(count=('latency', px.count))
 
   Args:
     table (string): The table name to load.
@@ -94,6 +98,10 @@ class Dataframe : public QLObject {
       ie "-5m" or an absolute time in the following format "2020-07-13 18:02:5.00 +0000".
     end_time (px.Time): The last timestamp of data to load. Can be a relative time
       ie "-5m" or an absolute time in the following format "2020-07-13 18:02:5.00 +0000".
+    sample (float): The fraction of the table to read, in (0, 1]. Whole batches of rows are
+      sampled, and the counts and sums of aggregates over the sample are scaled up to estimate
+      those of the whole table. A `<name>_ci95` column with the 95% confidence bound is added
+      for every count.
 
   Returns:
     px.DataFrame: DataFrame loaded from the table with the specified columns and time period.
@@ -266,6 +274,32 @@ class Dataframe : public QLObject {
     px.DataFrame: DataFrame with the first n rows.
   )doc";
 
+  inline static constexpr char kSortOpID[] = "sort_values";
+  inline static constexpr char kSortOpDocstring[] = R"doc(
+  Sorts the rows by the values of one or more columns.
+
+  Returns a DataFrame with the same columns, ordered by the `by` columns. Sorting followed by
+  `head(n)` only keeps the first n rows during the sort, and each node only sends its own first n
+  rows to be merged, so it's an efficient way to get the top values of a column.
+
+  :topic: dataframe_ops
+  :opname: Sort
+
+  Examples:
+    df = px.DataFrame('http_events')
+    # Keep the 10 slowest requests.
+    df = df.sort_values('latency', ascending=False).head(10)
+
+  Args:
+    by (Union[str,List[str]]): The column or columns to sort by, the first one being the most
+      significant.
+    ascending (Union[bool,List[bool]], default True): Sort ascending rather than descending,
+      either for all the columns or one value per column.
+
+  Returns:
+    px.DataFrame: DataFrame with the rows sorted.
+  )doc";
+
   inline static constexpr char kMergeOpID[] = "merge";
   inline static constexpr char kMergeOpDocstring[] = R"doc(
   Merges the input DataFrame with this one using a database-style join.
@@ -487,6 +521,24 @@ class DropHandler {
 class LimitHandler {
  public:
   /**
+ * @brief Implements the sort operator logic.
+ *
+ */
+class SortHandler {
+ public:
+  /**
+   * @brief Evaluates the sort_values method.
+   *
+   * @param df the dataframe that's a parent to the sort method.
+   * @param ast the ast node that signifies where the query was written
+   * @param args the arguments for sort_values()
+   * @return StatusOr<QLObjectPtr>
+   */
+  static StatusOr<QLObjectPtr> Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                    const ParsedArgs& args, ASTVisitor* visitor);
+};
+
+/**
    * @brief Evaluates the limit method.
    *
    * @param df the dataframe that's a parent to the limit method.
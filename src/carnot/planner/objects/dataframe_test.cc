@@ -607,6 +607,59 @@ TEST_F(GroupByTest, GroupByInDataframe) {
   EXPECT_MATCH(group_by->groups()[0], ColumnNode("col1", 0));
 }
 
+using SortTest = GroupByTest;
+
+TEST_F(SortTest, SortList) {
+  ParsedArgs parsed_args;
+  parsed_args.AddArg("by", MakeListObj(MakeString("col1"), MakeString("col2")));
+  parsed_args.AddArg("ascending",
+                     MakeListObj(graph->CreateNode<BoolIR>(ast, false).ConsumeValueOrDie(),
+                                 graph->CreateNode<BoolIR>(ast, true).ConsumeValueOrDie()));
+  auto qlo_or_s = SortHandler::Eval(graph.get(), src, ast, parsed_args, ast_visitor.get());
+  ASSERT_OK(qlo_or_s);
+
+  QLObjectPtr ql_object = qlo_or_s.ConsumeValueOrDie();
+  ASSERT_TRUE(ql_object->type_descriptor().type() == QLObjectType::kDataframe);
+  auto sort_obj = std::static_pointer_cast<Dataframe>(ql_object);
+
+  ASSERT_MATCH(sort_obj->op(), Sort());
+  SortIR* sort = static_cast<SortIR*>(sort_obj->op());
+  ASSERT_EQ(sort->sort_columns().size(), 2);
+  EXPECT_MATCH(sort->sort_columns()[0], ColumnNode("col1", 0));
+  EXPECT_MATCH(sort->sort_columns()[1], ColumnNode("col2", 0));
+  EXPECT_THAT(sort->ascending(), ElementsAre(false, true));
+  EXPECT_EQ(sort->limit(), 0);
+}
+
+TEST_F(SortTest, SortInDataframe) {
+  ArgMap args = MakeArgMap({}, {MakeString("col1")});
+
+  auto get_method_status = srcdf->GetMethod("sort_values");
+  ASSERT_OK(get_method_status);
+  FuncObject* func_obj = static_cast<FuncObject*>(get_method_status.ConsumeValueOrDie().get());
+  auto qlo_or_s = func_obj->Call(args, ast);
+  ASSERT_OK(qlo_or_s);
+
+  auto sort_obj = std::static_pointer_cast<Dataframe>(qlo_or_s.ConsumeValueOrDie());
+  ASSERT_MATCH(sort_obj->op(), Sort());
+  SortIR* sort = static_cast<SortIR*>(sort_obj->op());
+  ASSERT_EQ(sort->sort_columns().size(), 1);
+  EXPECT_MATCH(sort->sort_columns()[0], ColumnNode("col1", 0));
+  EXPECT_THAT(sort->ascending(), ElementsAre(true));
+}
+
+TEST_F(SortTest, MismatchedAscending) {
+  ParsedArgs parsed_args;
+  parsed_args.AddArg("by", MakeListObj(MakeString("col1"), MakeString("col2"), MakeString("col3")));
+  parsed_args.AddArg("ascending",
+                     MakeListObj(graph->CreateNode<BoolIR>(ast, false).ConsumeValueOrDie(),
+                                 graph->CreateNode<BoolIR>(ast, true).ConsumeValueOrDie()));
+  auto qlo_or_s = SortHandler::Eval(graph.get(), src, ast, parsed_args, ast_visitor.get());
+  ASSERT_NOT_OK(qlo_or_s);
+  EXPECT_THAT(qlo_or_s.status(),
+              HasCompilerError("'ascending' has 2 values but 3 columns are sorted on"));
+}
+
 TEST_F(DataframeTest, AttributeMetadataSubscriptTest) {
   MemorySourceIR* src = MakeMemSource();
 
@@ -694,6 +747,23 @@ TEST_F(DataframeTest, ConstructorTest) {
   EXPECT_EQ(mem_src->table_name(), "http_events");
 }
 
+TEST_F(DataframeTest, ConstructorSampleTest) {
+  std::shared_ptr<QLObject> srcdf = Dataframe::Create(graph.get(), ast_visitor.get()).ValueOrDie();
+  FuncObject* func_obj = static_cast<FuncObject*>(srcdf->GetCallMethod().ValueOrDie().get());
+
+  ArgMap args = MakeArgMap({{"sample", MakeFloat(0.1)}}, {MakeString("http_events")});
+  auto obj_or_s = func_obj->Call(args, ast);
+  ASSERT_OK(obj_or_s);
+  OperatorIR* op = static_cast<Dataframe*>(obj_or_s.ConsumeValueOrDie().get())->op();
+  ASSERT_MATCH(op, MemorySource());
+  auto mem_src = static_cast<MemorySourceIR*>(op);
+  EXPECT_TRUE(mem_src->sampled());
+  EXPECT_DOUBLE_EQ(0.1, mem_src->sample_fraction());
+
+  args = MakeArgMap({{"sample", MakeFloat(1.5)}}, {MakeString("http_events")});
+  EXPECT_COMPILER_ERROR(func_obj->Call(args, ast), "'sample' must be in");
+}
+
 TEST_F(LimitTest, StreamTest) {
   MemorySourceIR* src = MakeMemSource();
   ParsedArgs args;
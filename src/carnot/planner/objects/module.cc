@@ -40,9 +40,8 @@ StatusOr<std::shared_ptr<QLObject>> Module::GetAttributeImpl(const pypa::AstPtr&
 }
 
 Status Module::Init(std::string_view module_text) {
-  Parser parser;
   PL_ASSIGN_OR_RETURN(pypa::AstModulePtr ast,
-                      parser.Parse(module_text.data(), /* parse_doc_strings */ true));
+                      ASTCache::Global()->Parse(module_text, /* parse_doc_strings */ true));
   var_table_ = VarTable::Create();
   module_visitor_ = ast_visitor()->CreateModuleVisitor(var_table_);
   PL_RETURN_IF_ERROR(module_visitor_->ProcessModuleNode(ast));
@@ -43,21 +43,33 @@ StatusOr<std::shared_ptr<PixieModule>> PixieModule::Create(
   return pixie_module;
 }
 
-Status PixieModule::RegisterUDFFuncs() {
-  auto func_names = compiler_state_->registry_info()->func_names();
-  for (const auto& name : func_names) {
-    PL_ASSIGN_OR_RETURN(std::shared_ptr<FuncObject> fn_obj,
-                        FuncObject::Create(name, {}, {},
-                                           /* has_variable_len_args */ true,
-                                           /* has_variable_len_kwargs */ false,
-                                           std::bind(&UDFHandler::Eval, graph_, std::string(name),
-                                                     std::placeholders::_1, std::placeholders::_2,
-                                                     std::placeholders::_3),
-                                           ast_visitor()));
-
-    AddMethod(std::string(name), fn_obj);
+bool PixieModule::HasNonMethodAttribute(std::string_view name) const {
+  return QLObject::HasNonMethodAttribute(name) || compiler_state_->registry_info()->HasFunc(name);
+}
+
+StatusOr<std::shared_ptr<QLObject>> PixieModule::GetAttributeImpl(const pypa::AstPtr& ast,
+                                                                  std::string_view name) const {
+  if (QLObject::HasNonMethodAttribute(name)) {
+    return QLObject::GetAttributeImpl(ast, name);
   }
-  return Status::OK();
+  return GetUDFFunc(name);
+}
+
+StatusOr<std::shared_ptr<FuncObject>> PixieModule::GetUDFFunc(std::string_view name) const {
+  auto it = udf_funcs_.find(name);
+  if (it != udf_funcs_.end()) {
+    return it->second;
+  }
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<FuncObject> fn_obj,
+                      FuncObject::Create(name, {}, {},
+                                         /* has_variable_len_args */ true,
+                                         /* has_variable_len_kwargs */ false,
+                                         std::bind(&UDFHandler::Eval, graph_, std::string(name),
+                                                   std::placeholders::_1, std::placeholders::_2,
+                                                   std::placeholders::_3),
+                                         ast_visitor()));
+  udf_funcs_[std::string(name)] = fn_obj;
+  return fn_obj;
 }
 
 StatusOr<std::string> PrepareDefaultUDTFArg(const planpb::ScalarValue& scalar_value) {
@@ -262,7 +274,6 @@ Status PixieModule::RegisterTypeObjs() {
 }
 
 Status PixieModule::Init() {
-  PL_RETURN_IF_ERROR(RegisterUDFFuncs());
   PL_RETURN_IF_ERROR(RegisterCompileTimeFuncs());
   PL_RETURN_IF_ERROR(RegisterUDTFs());
   PL_RETURN_IF_ERROR(RegisterTypeObjs());
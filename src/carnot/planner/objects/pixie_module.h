@@ -243,15 +243,24 @@ class PixieModule : public QLObject {
         func_based_exec_(func_based_exec),
         reserved_names_(reserved_names) {}
   Status Init();
-  Status RegisterUDFFuncs();
   Status RegisterUDTFs();
   Status RegisterCompileTimeFuncs();
   Status RegisterCompileTimeUnitFunction(const std::string& name, std::chrono::nanoseconds unit_ns);
   Status RegisterTypeObjs();
 
+  // The UDFs and UDAs of the registry are attributes of the module, but their function objects are
+  // only created once a script uses them, so that a compile doesn't pay for all of them.
+  bool HasNonMethodAttribute(std::string_view name) const override;
+  StatusOr<std::shared_ptr<QLObject>> GetAttributeImpl(const pypa::AstPtr& ast,
+                                                       std::string_view name) const override;
+
  private:
+  StatusOr<std::shared_ptr<FuncObject>> GetUDFFunc(std::string_view name) const;
+
   IR* graph_;
   CompilerState* compiler_state_;
+  // The function objects of the UDFs and UDAs that were used so far, by name.
+  mutable absl::flat_hash_map<std::string, std::shared_ptr<FuncObject>> udf_funcs_;
   absl::flat_hash_set<std::string> compiler_time_fns_;
   const bool func_based_exec_;
   absl::flat_hash_set<std::string> reserved_names_;
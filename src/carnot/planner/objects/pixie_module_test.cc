@@ -158,6 +158,16 @@ TEST_F(PixieModuleTest, ModuleFindAttributeFromRegistryInfo) {
   EXPECT_EQ(func->carnot_op_name(), "equals");
 }
 
+TEST_F(PixieModuleTest, udf_funcs_are_created_once_used) {
+  EXPECT_FALSE(module_->HasMethod("equals"));
+  EXPECT_TRUE(module_->HasAttribute("equals"));
+  EXPECT_FALSE(module_->HasAttribute("bar"));
+
+  auto attr_or_s = module_->GetAttribute(ast, "equals");
+  ASSERT_OK(attr_or_s);
+  EXPECT_OK_AND_EQ(module_->GetAttribute(ast, "equals"), attr_or_s.ConsumeValueOrDie());
+}
+
 TEST_F(PixieModuleTest, AttributeNotFound) {
   std::string attribute = "bar";
   auto attr_or_s = module_->GetAttribute(ast, attribute);
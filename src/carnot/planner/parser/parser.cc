@@ -102,6 +102,32 @@ StatusOr<pypa::AstModulePtr> Parser::Parse(std::string_view query, bool parse_do
   return ast;
 }
 
+ASTCache* ASTCache::Global() {
+  static auto* cache = new ASTCache();
+  return cache;
+}
+
+StatusOr<pypa::AstModulePtr> ASTCache::Parse(std::string_view text, bool parse_doc_strings) {
+  auto key = std::make_pair(std::string(text), parse_doc_strings);
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = asts_.find(key);
+    if (it != asts_.end()) {
+      return it->second;
+    }
+  }
+
+  Parser parser;
+  PL_ASSIGN_OR_RETURN(pypa::AstModulePtr ast, parser.Parse(text, parse_doc_strings));
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (asts_.size() >= max_entries_) {
+    asts_.clear();
+  }
+  asts_.emplace(std::move(key), ast);
+  return ast;
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
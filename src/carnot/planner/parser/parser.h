@@ -19,10 +19,12 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <pypa/ast/ast.hh>
 #include <pypa/ast/tree_walker.hh>
 
@@ -45,6 +47,36 @@ class Parser {
   StatusOr<pypa::AstModulePtr> Parse(std::string_view query, bool parse_doc_strings = true);
 };
 
+/**
+ * ASTCache holds the ASTs of the PxL texts that every compile parses again, such as the modules
+ * that scripts import and the default values of function arguments, keyed by their content. The
+ * compiler only reads the ASTs, so all compiles share them. The cache is emptied when it's full.
+ */
+class ASTCache {
+ public:
+  static constexpr size_t kDefaultMaxEntries = 1024;
+
+  explicit ASTCache(size_t max_entries = kDefaultMaxEntries) : max_entries_(max_entries) {}
+
+  // The cache shared by the compiles of the process.
+  static ASTCache* Global();
+
+  /**
+   * Returns the AST of the text, parsing it only if it isn't cached. Errors aren't cached.
+   */
+  StatusOr<pypa::AstModulePtr> Parse(std::string_view text, bool parse_doc_strings = true);
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return asts_.size();
+  }
+
+ private:
+  const size_t max_entries_;
+  mutable std::mutex mu_;
+  absl::flat_hash_map<std::pair<std::string, bool>, pypa::AstModulePtr> asts_;
+};
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
@@ -159,6 +159,25 @@ TEST_F(ParserTest, indent_dedent_error) {
                   7, 3, "IndentationError: unindent does not match any outer indentation level"));
 }
 
+TEST_F(ParserTest, ast_cache_shares_asts_by_content) {
+  ASTCache cache(/* max_entries */ 2);
+  auto ast_or_s = cache.Parse("a = 1");
+  ASSERT_OK(ast_or_s);
+  auto ast = ast_or_s.ConsumeValueOrDie();
+  EXPECT_OK_AND_EQ(cache.Parse(std::string("a = ") + "1"), ast);
+  EXPECT_OK_AND_NE(cache.Parse("a = 1", /* parse_doc_strings */ false), ast);
+  EXPECT_EQ(2, cache.size());
+
+  // Errors aren't cached.
+  EXPECT_NOT_OK(cache.Parse("a = = 1"));
+  EXPECT_EQ(2, cache.size());
+
+  // A full cache starts over.
+  ASSERT_OK(cache.Parse("b = 2"));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_OK_AND_NE(cache.Parse("a = 1"), ast);
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
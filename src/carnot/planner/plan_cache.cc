@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/plan_cache.h"
+
+#include <farmhash.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <absl/strings/ascii.h>
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+namespace {
+
+// Proto maps don't have a stable wire order unless asked for one.
+std::string SerializeDeterministic(const google::protobuf::Message& msg) {
+  std::string out;
+  {
+    google::protobuf::io::StringOutputStream stream(&out);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    msg.SerializeToCodedStream(&coded);
+  }
+  return out;
+}
+
+// The key without its state fingerprint.
+PlanCacheKey MakeQueryKey(const plannerpb::QueryRequest& query_request) {
+  PlanCacheKey key;
+  // Trailing whitespace never changes what a script does, but editors and clients disagree on it.
+  key.query = std::string(absl::StripTrailingAsciiWhitespace(query_request.query_str()));
+  for (const auto& exec_func : query_request.exec_funcs()) {
+    key.exec_funcs.append(SerializeDeterministic(exec_func));
+  }
+  if (!query_request.result_columns().empty()) {
+    plannerpb::QueryRequest result_columns;
+    *result_columns.mutable_result_columns() = query_request.result_columns();
+    key.result_columns = SerializeDeterministic(result_columns);
+  }
+  return key;
+}
+
+}  // namespace
+
+uint64_t PlanCache::StateFingerprint(const distributedpb::LogicalPlannerState& logical_state) {
+  std::string state = SerializeDeterministic(logical_state);
+  return ::util::Fingerprint64(state.data(), state.size());
+}
+
+PlanCacheKey PlanCache::MakeKey(const distributedpb::LogicalPlannerState& logical_state,
+                                const plannerpb::QueryRequest& query_request) {
+  PlanCacheKey key = MakeQueryKey(query_request);
+  key.state_fingerprint = StateFingerprint(logical_state);
+  return key;
+}
+
+PlanCacheKey PlanCache::MakeKey(uint64_t state_fingerprint, const planpb::PlanOptions& plan_options,
+                                const plannerpb::QueryRequest& query_request) {
+  PlanCacheKey key = MakeQueryKey(query_request);
+  std::string state(reinterpret_cast<const char*>(&state_fingerprint), sizeof(state_fingerprint));
+  state.append(SerializeDeterministic(plan_options));
+  key.state_fingerprint = ::util::Fingerprint64(state.data(), state.size());
+  return key;
+}
+
+bool PlanCache::Lookup(const PlanCacheKey& key, distributedpb::DistributedPlan* plan) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++misses_;
+    return false;
+  }
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  plan->CopyFrom(it->second->second);
+  return true;
+}
+
+void PlanCache::Insert(PlanCacheKey key, const distributedpb::DistributedPlan& plan) {
+  if (capacity_ == 0) {
+    return;
+  }
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second->second.CopyFrom(plan);
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  if (entries_.size() >= capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(key, plan);
+  index_.emplace(std::move(key), entries_.begin());
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
+#include "src/carnot/planner/plannerpb/func_args.pb.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+// The number of plans kept by default, enough for the live views of a busy cluster.
+constexpr size_t kDefaultPlanCacheCapacity = 128;
+
+/**
+ * The key of a cached plan: the script and the functions to execute, plus a fingerprint of
+ * the whole planner state. The distributed state carries both the schemas and the set of
+ * agents, so any change to either (or to the plan options) lands on a different key.
+ */
+struct PlanCacheKey {
+  std::string query;
+  std::string exec_funcs;
+  std::string result_columns;
+  uint64_t state_fingerprint = 0;
+
+  bool operator==(const PlanCacheKey& other) const {
+    return state_fingerprint == other.state_fingerprint && query == other.query &&
+           exec_funcs == other.exec_funcs && result_columns == other.result_columns;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const PlanCacheKey& key) {
+    return H::combine(std::move(h), key.query, key.exec_funcs, key.result_columns,
+                      key.state_fingerprint);
+  }
+};
+
+/**
+ * PlanCache keeps the distributed plan protos of the most recently planned queries, so that
+ * scripts which run over and over (eg. live views refreshed by every open UI) are only
+ * compiled once per planner state. Lookups return copies, which the caller is free to modify.
+ *
+ * Like the planner that owns it, the cache is not thread-safe.
+ */
+class PlanCache : public NotCopyable {
+ public:
+  explicit PlanCache(size_t capacity = kDefaultPlanCacheCapacity) : capacity_(capacity) {}
+
+  static PlanCacheKey MakeKey(const distributedpb::LogicalPlannerState& logical_state,
+                              const plannerpb::QueryRequest& query_request);
+
+  /**
+   * Same as MakeKey() above, for a resident planner state (see LogicalPlanner::SetResidentState)
+   * whose fingerprint was computed once, and the plan options of the query.
+   */
+  static PlanCacheKey MakeKey(uint64_t state_fingerprint, const planpb::PlanOptions& plan_options,
+                              const plannerpb::QueryRequest& query_request);
+
+  static uint64_t StateFingerprint(const distributedpb::LogicalPlannerState& logical_state);
+
+  /**
+   * Copies the plan stored for the key into plan.
+   * @return false if the key is not in the cache.
+   */
+  bool Lookup(const PlanCacheKey& key, distributedpb::DistributedPlan* plan);
+
+  /**
+   * Stores the plan for the key, evicting the least recently used plan if the cache is full.
+   */
+  void Insert(PlanCacheKey key, const distributedpb::DistributedPlan& plan);
+
+  size_t size() const { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+
+ private:
+  using Entry = std::pair<PlanCacheKey, distributedpb::DistributedPlan>;
+
+  const size_t capacity_;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  absl::flat_hash_map<PlanCacheKey, std::list<Entry>::iterator> index_;
+
+  int64_t hits_ = 0;
+  int64_t misses_ = 0;
+};
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
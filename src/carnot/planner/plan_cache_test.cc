@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/carnot/planner/plan_cache.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+plannerpb::QueryRequest MakeQueryRequest(const std::string& query) {
+  plannerpb::QueryRequest query_request;
+  query_request.set_query_str(query);
+  return query_request;
+}
+
+distributedpb::DistributedPlan MakePlan(uint64_t kelvin_dag_id) {
+  distributedpb::DistributedPlan plan;
+  (*plan.mutable_qb_address_to_dag_id())["kelvin"] = kelvin_dag_id;
+  return plan;
+}
+
+TEST(PlanCacheTest, key) {
+  distributedpb::LogicalPlannerState state;
+  auto key = PlanCache::MakeKey(state, MakeQueryRequest("import px\n"));
+  EXPECT_EQ(key, PlanCache::MakeKey(state, MakeQueryRequest("import px\n\n  ")));
+  EXPECT_FALSE(key == PlanCache::MakeKey(state, MakeQueryRequest("import px\nimport px\n")));
+
+  auto query_with_func = MakeQueryRequest("import px\n");
+  query_with_func.add_exec_funcs()->set_func_name("main");
+  EXPECT_FALSE(key == PlanCache::MakeKey(state, query_with_func));
+
+  distributedpb::LogicalPlannerState other_state;
+  other_state.mutable_distributed_state()->add_carnot_info()->set_query_broker_address("pem");
+  EXPECT_FALSE(key == PlanCache::MakeKey(other_state, MakeQueryRequest("import px\n")));
+  other_state = state;
+  other_state.mutable_plan_options()->set_max_output_rows_per_table(100);
+  EXPECT_FALSE(key == PlanCache::MakeKey(other_state, MakeQueryRequest("import px\n")));
+}
+
+TEST(PlanCacheTest, lookup_returns_copy) {
+  PlanCache cache;
+  distributedpb::LogicalPlannerState state;
+  auto key = PlanCache::MakeKey(state, MakeQueryRequest("a"));
+
+  distributedpb::DistributedPlan plan;
+  EXPECT_FALSE(cache.Lookup(key, &plan));
+  cache.Insert(key, MakePlan(1));
+
+  ASSERT_TRUE(cache.Lookup(key, &plan));
+  EXPECT_EQ(plan.qb_address_to_dag_id().at("kelvin"), 1);
+  (*plan.mutable_qb_address_to_dag_id())["kelvin"] = 2;
+
+  distributedpb::DistributedPlan plan2;
+  ASSERT_TRUE(cache.Lookup(key, &plan2));
+  EXPECT_EQ(plan2.qb_address_to_dag_id().at("kelvin"), 1);
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 1);
+}
+
+TEST(PlanCacheTest, evicts_least_recently_used) {
+  PlanCache cache(2);
+  distributedpb::LogicalPlannerState state;
+  auto key_a = PlanCache::MakeKey(state, MakeQueryRequest("a"));
+  auto key_b = PlanCache::MakeKey(state, MakeQueryRequest("b"));
+  auto key_c = PlanCache::MakeKey(state, MakeQueryRequest("c"));
+
+  cache.Insert(key_a, MakePlan(1));
+  cache.Insert(key_b, MakePlan(2));
+  distributedpb::DistributedPlan plan;
+  // Touch a, so b is the one evicted.
+  ASSERT_TRUE(cache.Lookup(key_a, &plan));
+  cache.Insert(key_c, MakePlan(3));
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_TRUE(cache.Lookup(key_a, &plan));
+  EXPECT_FALSE(cache.Lookup(key_b, &plan));
+  EXPECT_TRUE(cache.Lookup(key_c, &plan));
+  EXPECT_EQ(plan.qb_address_to_dag_id().at("kelvin"), 3);
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -19,10 +19,13 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/ir/ir_nodes.h"
 #include "src/carnot/planner/rules/rules.h"
@@ -126,6 +129,12 @@ class RuleExecutor {
   // TODO(philkuz) figure out how to collect stats on the execution.
   Status Execute(TPlan* ir_graph) {
     for (const auto& rb : rule_batches) {
+      if constexpr (std::is_same_v<TPlan, IR>) {
+        if (HasTargetedRules(*rb)) {
+          PL_RETURN_IF_ERROR(ExecuteOnWorklist(rb.get(), ir_graph));
+          continue;
+        }
+      }
       bool can_continue = true;
       int64_t iteration = 0;
       // We continue executing a batch until a stop condition is met.
@@ -161,6 +170,102 @@ class RuleExecutor {
   }
 
  private:
+  static bool HasTargetedRules(const TRuleBatch& rb) {
+    for (const auto& rule : rb.rules()) {
+      if (!rule->TargetNodeTypes().empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns the nodes at most two edges away from the given nodes, the nodes included. Two edges
+  // reach the expressions of the child operators, which is where operator changes propagate to.
+  static absl::flat_hash_set<int64_t> Neighborhood(const IR* ir_graph,
+                                                   const absl::flat_hash_set<int64_t>& nodes) {
+    absl::flat_hash_set<int64_t> neighborhood;
+    std::vector<int64_t> frontier;
+    for (int64_t node : nodes) {
+      if (ir_graph->HasNode(node) && neighborhood.insert(node).second) {
+        frontier.push_back(node);
+      }
+    }
+    for (int hop = 0; hop < 2; ++hop) {
+      std::vector<int64_t> next_frontier;
+      for (int64_t node : frontier) {
+        for (const auto& neighbors :
+             {ir_graph->dag().ParentsOf(node), ir_graph->dag().DependenciesOf(node)}) {
+          for (int64_t neighbor : neighbors) {
+            if (neighborhood.insert(neighbor).second) {
+              next_frontier.push_back(neighbor);
+            }
+          }
+        }
+      }
+      frontier = std::move(next_frontier);
+    }
+    return neighborhood;
+  }
+
+  /**
+   * Runs a batch that has rules with target node types. The first pass visits the whole graph,
+   * and the following ones only visit the neighborhood of the nodes changed by the previous pass.
+   * Once such a pass changes nothing, the batch runs a whole-graph pass again, and stops if that
+   * one changes nothing either. The batch therefore stops at the same fixed point as a batch of
+   * whole-graph passes, without revisiting the unchanged parts of big graphs on every iteration.
+   *
+   * Rules without target types run on the whole graph. Since the nodes they change are unknown,
+   * a pass after one where they changed the graph visits the whole graph.
+   */
+  Status ExecuteOnWorklist(TRuleBatch* rb, IR* ir_graph) {
+    bool full_pass = true;
+    absl::flat_hash_set<int64_t> worklist;
+    int64_t iteration = 0;
+    while (true) {
+      iteration += 1;
+      if (full_pass) {
+        worklist = ir_graph->dag().nodes();
+      }
+      bool graph_is_updated = false;
+      bool untracked_update = false;
+      absl::flat_hash_set<int64_t> changed;
+      for (const auto& rule : rb->rules()) {
+        int64_t next_node_id = ir_graph->next_node_id();
+        bool rule_updates_graph = false;
+        if (rule->TargetNodeTypes().empty()) {
+          PL_ASSIGN_OR_RETURN(rule_updates_graph, rule->Execute(ir_graph));
+          untracked_update = untracked_update || rule_updates_graph;
+        } else {
+          PL_ASSIGN_OR_RETURN(rule_updates_graph,
+                              rule->ExecuteOnNodes(ir_graph, worklist, &changed));
+        }
+        graph_is_updated = graph_is_updated || rule_updates_graph;
+        // Nodes created by the rule are new to the rules that follow.
+        for (int64_t node = next_node_id; node < ir_graph->next_node_id(); ++node) {
+          if (ir_graph->HasNode(node)) {
+            worklist.insert(node);
+            changed.insert(node);
+          }
+        }
+      }
+      if (iteration >= rb->max_iterations() && graph_is_updated) {
+        return rb->MaxIterationsHandler();
+      }
+      if (!graph_is_updated) {
+        if (full_pass) {
+          return Status::OK();
+        }
+        // Make sure no change was missed before declaring the fixed point.
+        full_pass = true;
+        continue;
+      }
+      full_pass = untracked_update;
+      if (!full_pass) {
+        worklist = Neighborhood(ir_graph, changed);
+      }
+    }
+  }
+
   std::vector<std::unique_ptr<TRuleBatch>> rule_batches;
 };
 
@@ -182,6 +182,51 @@ TEST_F(RuleExecutorTest, exit_early) {
   EXPECT_NOT_OK(executor->Execute(graph.get()));
 }
 
+// Changes each int node once, and records the nodes it visits.
+class ChangeIntsOnceRule : public Rule {
+ public:
+  ChangeIntsOnceRule()
+      : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+  absl::flat_hash_set<IRNodeType> TargetNodeTypes() const override { return {IRNodeType::kInt}; }
+
+  std::vector<int64_t> visited;
+  absl::flat_hash_set<int64_t> to_change;
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override {
+    visited.push_back(ir_node->id());
+    return to_change.erase(ir_node->id()) > 0;
+  }
+};
+
+// Tests that after the first pass, only the nodes near the changed ones are visited, until a
+// final pass over the whole graph.
+TEST_F(RuleExecutorTest, worklist_visits_changed_neighborhood) {
+  std::unique_ptr<TestExecutor> executor = std::move(TestExecutor::Create().ValueOrDie());
+  RuleBatch* rule_batch = executor->CreateRuleBatch<FailOnMax>("resolve", 10);
+  auto rule = rule_batch->AddRule<ChangeIntsOnceRule>();
+  rule->to_change.insert(int_constant->id());
+  ASSERT_OK(executor->Execute(graph.get()));
+
+  // int_constant2 is three edges away from int_constant: int -> func -> func2 -> int2.
+  EXPECT_THAT(rule->visited,
+              ::testing::ElementsAre(int_constant->id(), int_constant2->id(), int_constant->id(),
+                                     int_constant->id(), int_constant2->id()));
+}
+
+// Tests that a targeted rule that keeps changing the graph still hits the max iterations.
+TEST_F(RuleExecutorTest, worklist_max_iterations) {
+  std::unique_ptr<TestExecutor> executor = std::move(TestExecutor::Create().ValueOrDie());
+  RuleBatch* rule_batch = executor->CreateRuleBatch<FailOnMax>("resolve", 3);
+  auto rule = rule_batch->AddRule<ChangeIntsOnceRule>();
+  MockRule* untargeted_rule = rule_batch->AddRule<MockRule>(compiler_state_.get());
+  EXPECT_CALL(*untargeted_rule, Execute(_)).Times(3).WillRepeatedly(Return(true));
+  EXPECT_NOT_OK(executor->Execute(graph.get()));
+  // Every pass visits the whole graph, since the untargeted rule changes unknown nodes.
+  EXPECT_EQ(rule->visited.size(), 6);
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
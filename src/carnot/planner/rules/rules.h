@@ -17,12 +17,14 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <memory>
 #include <queue>
 #include <string>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/compiler_state/registry_info.h"
@@ -43,6 +45,18 @@ struct RuleTraits<IR> {
   using node_type = IRNode;
 };
 
+/**
+ * @brief The node types of all the operators, for rules that apply to any operator.
+ */
+inline absl::flat_hash_set<IRNodeType> OperatorNodeTypes() {
+  return {
+#undef PL_IR_NODE
+#define PL_IR_NODE(NAME) IRNodeType::k##NAME,
+#include "src/carnot/planner/ir/operators.inl"
+#undef PL_IR_NODE
+  };
+}
+
 template <typename TPlan>
 class BaseRule {
  public:
@@ -65,6 +79,59 @@ class BaseRule {
     return any_changed;
   }
 
+  /**
+   * @brief The node types this rule applies to. Rules that declare them, and only change the graph
+   * through Apply(), can run on the nodes near the last changes instead of the whole graph (see
+   * ExecuteOnNodes). Rules that don't declare them always run on the whole graph.
+   */
+  virtual absl::flat_hash_set<IRNodeType> TargetNodeTypes() const { return {}; }
+
+  /**
+   * @brief Applies the rule to the given nodes that have one of the target types, in the order
+   * Execute() would visit them.
+   *
+   * @param node_ids: the nodes to visit.
+   * @param changed: the ids of the nodes the rule changed are added to it.
+   * @return true if the rule changed any node.
+   */
+  StatusOr<bool> ExecuteOnNodes(TPlan* graph, const absl::flat_hash_set<int64_t>& node_ids,
+                                absl::flat_hash_set<int64_t>* changed) {
+    std::vector<int64_t> nodes;
+    if (use_topo_) {
+      for (int64_t node_i : graph->dag().TopologicalSort()) {
+        if (node_ids.contains(node_i)) {
+          nodes.push_back(node_i);
+        }
+      }
+      if (reverse_topological_execution_) {
+        std::reverse(nodes.begin(), nodes.end());
+      }
+    } else {
+      nodes.assign(node_ids.begin(), node_ids.end());
+      std::sort(nodes.begin(), nodes.end());
+    }
+
+    absl::flat_hash_set<IRNodeType> target_types = TargetNodeTypes();
+    bool any_changed = false;
+    for (int64_t node_i : nodes) {
+      // The node may have been deleted by a prior call to Apply on a parent or child node.
+      if (!graph->HasNode(node_i)) {
+        continue;
+      }
+      auto node = graph->Get(node_i);
+      if (!target_types.contains(node->type())) {
+        continue;
+      }
+      PL_ASSIGN_OR_RETURN(bool node_is_changed, Apply(node));
+      if (node_is_changed) {
+        any_changed = true;
+        changed->insert(node_i);
+      }
+    }
+    PL_RETURN_IF_ERROR(EmptyDeleteQueue(graph));
+    return any_changed;
+  }
+
  protected:
   StatusOr<bool> ExecuteTopologicalSorted(TPlan* graph) {
     bool any_changed = false;
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/prepared_plan_cache.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+namespace px {
+namespace carnot {
+
+namespace {
+
+// Proto maps don't have a stable wire order unless asked for one.
+std::string SerializeDeterministic(const google::protobuf::Message& msg) {
+  std::string out;
+  {
+    google::protobuf::io::StringOutputStream stream(&out);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    msg.SerializeToCodedStream(&coded);
+  }
+  return out;
+}
+
+}  // namespace
+
+std::string PreparedPlanCache::MakeKey(const planpb::Plan& plan_pb) {
+  planpb::Plan normalized = plan_pb;
+  for (auto& pf : *normalized.mutable_nodes()) {
+    for (auto& node : *pf.mutable_nodes()) {
+      if (node.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        continue;
+      }
+      auto* mem_source = node.mutable_op()->mutable_mem_source_op();
+      mem_source->clear_start_time();
+      mem_source->clear_stop_time();
+    }
+  }
+  return SerializeDeterministic(normalized);
+}
+
+std::unique_ptr<PreparedPlan> PreparedPlanCache::Take(const std::string& key,
+                                                      const planpb::Plan& plan_pb) {
+  std::unique_ptr<PreparedPlan> prepared;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      ++misses_;
+      return nullptr;
+    }
+    ++hits_;
+    auto entry = it->second;
+    index_.erase(it);
+    prepared = std::move(entry->second);
+    entries_.erase(entry);
+  }
+
+  // The key matched, so the plans only differ in the time bounds of their memory sources.
+  for (const auto& pf_pb : plan_pb.nodes()) {
+    auto& pf = prepared->plan.nodes().at(pf_pb.id());
+    for (const auto& node_pb : pf_pb.nodes()) {
+      if (node_pb.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        continue;
+      }
+      auto* mem_source =
+          static_cast<plan::MemorySourceOperator*>(pf->nodes().at(node_pb.id()).get());
+      mem_source->SetTimeBounds(node_pb.op().mem_source_op());
+    }
+  }
+  return prepared;
+}
+
+void PreparedPlanCache::Return(std::string key, std::unique_ptr<PreparedPlan> prepared) {
+  if (capacity_ == 0) {
+    return;
+  }
+  absl::MutexLock lock(&mu_);
+  // A concurrent execution of the same plan already returned its copy.
+  if (index_.contains(key)) {
+    return;
+  }
+  entries_.emplace_front(std::move(key), std::move(prepared));
+  index_.emplace(entries_.front().first, entries_.begin());
+  if (entries_.size() > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+size_t PreparedPlanCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+int64_t PreparedPlanCache::hits() const {
+  absl::MutexLock lock(&mu_);
+  return hits_;
+}
+
+int64_t PreparedPlanCache::misses() const {
+  absl::MutexLock lock(&mu_);
+  return misses_;
+}
+
+}  // namespace carnot
+}  // namespace px
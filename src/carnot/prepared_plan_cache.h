@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/plan/plan.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+
+// The number of prepared plans kept by default, enough for the queries that the query broker
+// runs periodically.
+constexpr size_t kDefaultPreparedPlanCacheCapacity = 64;
+
+/**
+ * A plan that has been parsed, with the UDFs and UDAs of its expressions resolved from the
+ * registry, so that executing it again skips both steps.
+ */
+struct PreparedPlan {
+  plan::Plan plan;
+  std::vector<std::pair<int64_t, udf::ScalarUDFDefinition*>> scalar_udfs;
+  std::vector<std::pair<int64_t, udf::UDADefinition*>> udas;
+};
+
+/**
+ * PreparedPlanCache keeps the prepared plans of the most recently executed plan protos. The
+ * plans that the query broker sends for the same script every few seconds only differ in the
+ * time bounds of their memory sources, so the plans are keyed without them, and the bounds of
+ * a cached plan are rebound to those of the plan being executed.
+ *
+ * A prepared plan is taken out of the cache while it executes, which gives the query exclusive
+ * use of it. Concurrent executions of the same plan prepare their own copy.
+ */
+class PreparedPlanCache : public NotCopyable {
+ public:
+  explicit PreparedPlanCache(size_t capacity = kDefaultPreparedPlanCacheCapacity)
+      : capacity_(capacity) {}
+
+  /**
+   * Returns the key of the plan: its serialization, without the time bounds of its memory
+   * sources.
+   */
+  static std::string MakeKey(const planpb::Plan& plan_pb);
+
+  /**
+   * Takes the prepared plan for the key out of the cache, with its time bounds set from plan_pb.
+   * @return nullptr if the key is not in the cache.
+   */
+  std::unique_ptr<PreparedPlan> Take(const std::string& key, const planpb::Plan& plan_pb);
+
+  /**
+   * Returns a prepared plan to the cache once its query is done, evicting the least recently
+   * used plan if the cache is full.
+   */
+  void Return(std::string key, std::unique_ptr<PreparedPlan> prepared);
+
+  size_t size() const;
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  using Entry = std::pair<std::string, std::unique_ptr<PreparedPlan>>;
+
+  const size_t capacity_;
+  mutable absl::Mutex mu_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string_view, std::list<Entry>::iterator> index_ ABSL_GUARDED_BY(mu_);
+
+  int64_t hits_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "src/carnot/prepared_plan_cache.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+
+constexpr char kRangePlanTmpl[] = R"proto(
+  nodes {
+    id: 1
+    dag {
+      nodes {
+        id: 1
+        sorted_children: 2
+      }
+      nodes {
+        id: 2
+        sorted_parents: 1
+      }
+    }
+    nodes {
+      id: 1
+      op {
+        op_type: MEMORY_SOURCE_OPERATOR
+        mem_source_op {
+          name: "$0"
+          start_time { value: $1 }
+          stop_time { value: $2 }
+          column_idxs: 1
+          column_types: FLOAT64
+          column_names: "usage"
+        }
+      }
+    }
+    nodes {
+      id: 2
+      op {
+        op_type: MEMORY_SINK_OPERATOR
+        mem_sink_op {
+          name: "out"
+          column_names: "usage"
+          column_types: FLOAT64
+        }
+      }
+    }
+  }
+)proto";
+
+planpb::Plan MakePlan(const std::string& table, int64_t start_time, int64_t stop_time) {
+  planpb::Plan plan;
+  CHECK(google::protobuf::TextFormat::ParseFromString(
+      absl::Substitute(kRangePlanTmpl, table, start_time, stop_time), &plan));
+  return plan;
+}
+
+std::unique_ptr<PreparedPlan> Prepare(const planpb::Plan& plan_pb) {
+  auto prepared = std::make_unique<PreparedPlan>();
+  PL_CHECK_OK(prepared->plan.Init(plan_pb));
+  return prepared;
+}
+
+const plan::MemorySourceOperator* MemorySource(PreparedPlan* prepared) {
+  return static_cast<const plan::MemorySourceOperator*>(
+      prepared->plan.nodes().at(1)->nodes().at(1).get());
+}
+
+TEST(PreparedPlanCacheTest, key_ignores_time_bounds) {
+  EXPECT_EQ(PreparedPlanCache::MakeKey(MakePlan("cpu", 0, 10)),
+            PreparedPlanCache::MakeKey(MakePlan("cpu", 20, 30)));
+  EXPECT_NE(PreparedPlanCache::MakeKey(MakePlan("cpu", 0, 10)),
+            PreparedPlanCache::MakeKey(MakePlan("mem", 0, 10)));
+}
+
+TEST(PreparedPlanCacheTest, take_rebinds_time_bounds) {
+  PreparedPlanCache cache;
+  planpb::Plan first = MakePlan("cpu", 0, 10);
+  std::string key = PreparedPlanCache::MakeKey(first);
+  EXPECT_EQ(nullptr, cache.Take(key, first));
+
+  cache.Return(key, Prepare(first));
+  EXPECT_EQ(1, cache.size());
+
+  auto prepared = cache.Take(key, MakePlan("cpu", 20, 30));
+  ASSERT_NE(nullptr, prepared);
+  EXPECT_EQ(20, MemorySource(prepared.get())->start_time());
+  EXPECT_EQ(30, MemorySource(prepared.get())->stop_time());
+  EXPECT_EQ("cpu", MemorySource(prepared.get())->TableName());
+
+  // The plan is out of the cache while it's in use.
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(nullptr, cache.Take(key, first));
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(2, cache.misses());
+}
+
+TEST(PreparedPlanCacheTest, evicts_least_recently_returned) {
+  PreparedPlanCache cache(/* capacity */ 2);
+  planpb::Plan cpu = MakePlan("cpu", 0, 10);
+  planpb::Plan mem = MakePlan("mem", 0, 10);
+  planpb::Plan net = MakePlan("net", 0, 10);
+  cache.Return(PreparedPlanCache::MakeKey(cpu), Prepare(cpu));
+  cache.Return(PreparedPlanCache::MakeKey(mem), Prepare(mem));
+  cache.Return(PreparedPlanCache::MakeKey(net), Prepare(net));
+
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(nullptr, cache.Take(PreparedPlanCache::MakeKey(cpu), cpu));
+  EXPECT_NE(nullptr, cache.Take(PreparedPlanCache::MakeKey(net), net));
+}
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,463 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/btree_map.h>
+#include <absl/random/zipf_distribution.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_join.h>
+#include <sole.hpp>
+
+#include "src/carnot/carnot.h"
+#include "src/carnot/exec/local_grpc_result_server.h"
+#include "src/common/base/base.h"
+#include "src/common/base/file.h"
+#include "src/common/benchmark/benchmark.h"
+#include "src/common/testing/test_environment.h"
+#include "src/shared/metadata/metadata_state.h"
+#include "src/shared/metadata/state_manager.h"
+#include "src/shared/metadata/test_utils.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/table/table_store.h"
+
+// Runs the pxl_scripts behind the UI's live views end to end through Carnot::ExecuteQuery, over
+// synthetic http_events and conn_stats tables, to give planner and executor changes a shared
+// yardstick. Each benchmark reports the average self time of every operator of the query, from
+// its ExecNodeStats, as a counter next to the total time.
+
+namespace px {
+namespace carnot {
+
+using ::px::shared::k8s::metadatapb::ResourceUpdate;
+using table_store::schema::Relation;
+using types::DataType;
+
+constexpr uint32_t kASID = 1;
+constexpr char kNamespace[] = "px-bench";
+constexpr int kNumServices = 32;
+constexpr int kNumPaths = 200;
+constexpr int64_t kRowsPerBatch = 1024;
+// Stirling truncates the bodies that it records, but reports their full size.
+constexpr size_t kMaxBodyBytes = 512;
+// The scripts query the last 5 minutes, so all the rows fall inside that window.
+constexpr int64_t kDataWindowNS = 4LL * 60 * 1000 * 1000 * 1000;
+constexpr std::string_view kResources[] = {"users",   "orders",   "carts",    "items",
+                                           "catalog", "payments", "sessions", "reviews"};
+
+// Every service of the synthetic cluster runs as one pod with one container and one process.
+struct BenchService {
+  std::string name;
+  std::string pod_ip;
+  md::UPID upid;
+};
+
+std::vector<BenchService> MakeServices() {
+  std::vector<BenchService> services;
+  for (int i = 0; i < kNumServices; ++i) {
+    services.push_back({absl::Substitute("svc-$0", i),
+                        absl::Substitute("10.0.$0.$1", i / 200, i % 200 + 1),
+                        md::UPID(kASID, 1000 + i, /* ts_ns */ 1)});
+  }
+  return services;
+}
+
+std::shared_ptr<md::AgentMetadataState> CreateMetadataState(
+    const std::vector<BenchService>& services) {
+  auto state = std::make_shared<md::AgentMetadataState>(/* hostname */ "bench-host", kASID,
+                                                        sole::uuid4(), "bench-pod");
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+  for (const auto& svc : services) {
+    std::string pod_uid = svc.name + "-pod-uid";
+    std::string cid = svc.name + "-container";
+
+    auto container = std::make_unique<ResourceUpdate>();
+    auto* container_update = container->mutable_container_update();
+    container_update->set_cid(cid);
+    container_update->set_name(svc.name);
+    container_update->set_start_timestamp_ns(1);
+    container_update->set_container_state(
+        ::px::shared::k8s::metadatapb::CONTAINER_STATE_RUNNING);
+    updates.enqueue(std::move(container));
+
+    auto pod = std::make_unique<ResourceUpdate>();
+    auto* pod_update = pod->mutable_pod_update();
+    pod_update->set_uid(pod_uid);
+    pod_update->set_name(svc.name + "-pod");
+    pod_update->set_namespace_(kNamespace);
+    pod_update->set_start_timestamp_ns(1);
+    pod_update->add_container_ids(cid);
+    pod_update->set_phase(::px::shared::k8s::metadatapb::RUNNING);
+    pod_update->set_node_name("bench-node");
+    pod_update->set_pod_ip(svc.pod_ip);
+    updates.enqueue(std::move(pod));
+
+    auto service = std::make_unique<ResourceUpdate>();
+    auto* service_update = service->mutable_service_update();
+    service_update->set_uid(svc.name + "-uid");
+    service_update->set_name(svc.name);
+    service_update->set_namespace_(kNamespace);
+    service_update->set_start_timestamp_ns(1);
+    service_update->add_pod_ids(pod_uid);
+    updates.enqueue(std::move(service));
+  }
+  md::TestAgentMetadataFilter filter;
+  PL_CHECK_OK(md::ApplyK8sUpdates(/* ts */ 2, state.get(), &filter, &updates));
+
+  for (const auto& svc : services) {
+    state->AddUPID(svc.upid, std::make_unique<md::PIDInfo>(svc.upid, svc.name + " --serve",
+                                                           svc.name + "-container"));
+  }
+  return state;
+}
+
+types::UInt128Value ToUInt128Value(const md::UPID& upid) {
+  return types::UInt128Value(absl::Uint128High64(upid.value()), absl::Uint128Low64(upid.value()));
+}
+
+/**
+ * Generates the rows of http_events: Zipfian services and paths, health and readiness probes,
+ * log-normal latencies, a small share of errors and a mix of small, medium and large bodies.
+ */
+class HTTPEventsGenerator {
+ public:
+  explicit HTTPEventsGenerator(const std::vector<BenchService>* services) : services_(services) {
+    for (int i = 0; i < kNumPaths; ++i) {
+      paths_.push_back(absl::Substitute("/api/v1/$0/$1", kResources[i % std::size(kResources)], i));
+    }
+    body_.reserve(kMaxBodyBytes);
+    while (body_.size() < kMaxBodyBytes) {
+      absl::StrAppend(&body_, R"({"id":12345,"name":"item","tags":["a","b"],"price":9.99},)");
+    }
+  }
+
+  static Relation relation() {
+    return Relation(
+        {DataType::TIME64NS, DataType::UINT128, DataType::STRING, DataType::INT64, DataType::INT64,
+         DataType::INT64, DataType::INT64, DataType::INT64, DataType::STRING, DataType::STRING,
+         DataType::STRING, DataType::STRING, DataType::INT64, DataType::STRING, DataType::INT64,
+         DataType::STRING, DataType::STRING, DataType::INT64, DataType::INT64},
+        {"time_", "upid", "remote_addr", "remote_port", "trace_role", "major_version",
+         "minor_version", "content_type", "req_headers", "req_method", "req_path", "req_body",
+         "req_body_size", "resp_headers", "resp_status", "resp_message", "resp_body",
+         "resp_body_size", "latency"});
+  }
+
+  void AppendRow(int64_t time_ns, types::ColumnWrapperRecordBatch* rb) {
+    const BenchService& server = (*services_)[service_dist_(rng_)];
+    int64_t status = 200;
+    double outcome = unit_dist_(rng_);
+    if (outcome < 0.02) {
+      status = 500;
+    } else if (outcome < 0.05) {
+      status = 404;
+    }
+    double probe = unit_dist_(rng_);
+    const std::string& path =
+        probe < 0.05 ? kHealthPath : (probe < 0.1 ? kReadyPath : paths_[path_dist_(rng_)]);
+    bool is_post = unit_dist_(rng_) < 0.2;
+    int64_t req_body_size = is_post ? BodySize() : 0;
+    int64_t resp_body_size = BodySize();
+
+    auto& cols = *rb;
+    cols[0]->Append<types::Time64NSValue>(time_ns);
+    cols[1]->Append<types::UInt128Value>(ToUInt128Value(server.upid));
+    cols[2]->Append<types::StringValue>(RemoteAddr());
+    cols[3]->Append<types::Int64Value>(30000 + port_dist_(rng_));
+    cols[4]->Append<types::Int64Value>(/* kRoleServer */ 2);
+    cols[5]->Append<types::Int64Value>(1);
+    cols[6]->Append<types::Int64Value>(1);
+    cols[7]->Append<types::Int64Value>(/* JSON */ 1);
+    cols[8]->Append<types::StringValue>(R"({"Accept":"*/*","Host":")" + server.name + R"("})");
+    cols[9]->Append<types::StringValue>(std::string(is_post ? "POST" : "GET"));
+    cols[10]->Append<types::StringValue>(path);
+    cols[11]->Append<types::StringValue>(Body(req_body_size));
+    cols[12]->Append<types::Int64Value>(req_body_size);
+    cols[13]->Append<types::StringValue>(R"({"Content-Type":"application/json"})");
+    cols[14]->Append<types::Int64Value>(status);
+    cols[15]->Append<types::StringValue>(std::string(status == 200 ? "OK" : "Error"));
+    cols[16]->Append<types::StringValue>(Body(resp_body_size));
+    cols[17]->Append<types::Int64Value>(resp_body_size);
+    cols[18]->Append<types::Int64Value>(static_cast<int64_t>(latency_dist_(rng_)));
+  }
+
+ private:
+  inline static const std::string kHealthPath = "/health";
+  inline static const std::string kReadyPath = "/readyz";
+
+  // Most requests come from other pods of the cluster, a few from outside of it, and a few from
+  // addresses that couldn't be resolved.
+  std::string RemoteAddr() {
+    double r = unit_dist_(rng_);
+    if (r < 0.02) {
+      return "-";
+    }
+    if (r < 0.07) {
+      return absl::Substitute("203.0.113.$0", port_dist_(rng_) % 250);
+    }
+    return (*services_)[service_dist_(rng_)].pod_ip;
+  }
+
+  // 70% small bodies, 25% of a few KiB and 5% large ones.
+  int64_t BodySize() {
+    double r = unit_dist_(rng_);
+    if (r < 0.7) {
+      return 16 + port_dist_(rng_) % 240;
+    }
+    if (r < 0.95) {
+      return 1024 + port_dist_(rng_) % 3072;
+    }
+    return 16 * 1024 + port_dist_(rng_) * 48;
+  }
+
+  std::string Body(int64_t size) {
+    return body_.substr(0, std::min<size_t>(static_cast<size_t>(size), kMaxBodyBytes));
+  }
+
+  const std::vector<BenchService>* services_;
+  std::vector<std::string> paths_;
+  std::string body_;
+
+  std::mt19937_64 rng_{42};
+  absl::zipf_distribution<int> service_dist_{kNumServices - 1, 1.1};
+  absl::zipf_distribution<int> path_dist_{kNumPaths - 1, 1.1};
+  std::uniform_real_distribution<double> unit_dist_{0, 1};
+  std::uniform_int_distribution<int64_t> port_dist_{0, 1000};
+  // A median of 5ms, with a long tail.
+  std::lognormal_distribution<double> latency_dist_{std::log(5e6), 1.0};
+};
+
+/**
+ * Generates the rows of conn_stats: the connection counters of Zipfian (client, server) pairs of
+ * services, which grow by log-normal amounts from one sample to the next.
+ */
+class ConnStatsGenerator {
+ public:
+  explicit ConnStatsGenerator(const std::vector<BenchService>* services) : services_(services) {}
+
+  static Relation relation() {
+    return Relation({DataType::TIME64NS, DataType::UINT128, DataType::STRING, DataType::INT64,
+                     DataType::INT64, DataType::INT64, DataType::INT64, DataType::INT64,
+                     DataType::INT64, DataType::INT64, DataType::INT64, DataType::INT64},
+                    {"time_", "upid", "remote_addr", "remote_port", "trace_role", "addr_family",
+                     "protocol", "conn_open", "conn_close", "conn_active", "bytes_sent",
+                     "bytes_recv"});
+  }
+
+  void AppendRow(int64_t time_ns, types::ColumnWrapperRecordBatch* rb) {
+    int client = service_dist_(rng_);
+    int server = service_dist_(rng_);
+    Counters& counters = counters_[{client, server}];
+    counters.conn_open += conn_dist_(rng_) == 0 ? 1 : 0;
+    counters.bytes_sent += static_cast<int64_t>(bytes_dist_(rng_));
+    counters.bytes_recv += static_cast<int64_t>(bytes_dist_(rng_) * 4);
+
+    auto& cols = *rb;
+    cols[0]->Append<types::Time64NSValue>(time_ns);
+    cols[1]->Append<types::UInt128Value>(ToUInt128Value((*services_)[client].upid));
+    cols[2]->Append<types::StringValue>(std::string((*services_)[server].pod_ip));
+    cols[3]->Append<types::Int64Value>(8080);
+    cols[4]->Append<types::Int64Value>(/* kRoleClient */ 1);
+    cols[5]->Append<types::Int64Value>(/* AF_INET */ 2);
+    cols[6]->Append<types::Int64Value>(/* HTTP */ 1);
+    cols[7]->Append<types::Int64Value>(counters.conn_open);
+    cols[8]->Append<types::Int64Value>(0);
+    cols[9]->Append<types::Int64Value>(counters.conn_open);
+    cols[10]->Append<types::Int64Value>(counters.bytes_sent);
+    cols[11]->Append<types::Int64Value>(counters.bytes_recv);
+  }
+
+ private:
+  struct Counters {
+    int64_t conn_open = 1;
+    int64_t bytes_sent = 0;
+    int64_t bytes_recv = 0;
+  };
+
+  const std::vector<BenchService>* services_;
+  absl::btree_map<std::pair<int, int>, Counters> counters_;
+
+  std::mt19937_64 rng_{43};
+  absl::zipf_distribution<int> service_dist_{kNumServices - 1, 1.1};
+  std::uniform_int_distribution<int> conn_dist_{0, 99};
+  std::lognormal_distribution<double> bytes_dist_{std::log(2048), 1.5};
+};
+
+// Fills a table with num_rows rows, evenly spread over the data window that ends at now.
+template <typename TGenerator>
+std::shared_ptr<table_store::Table> GenerateTable(TGenerator* generator, int64_t num_rows,
+                                                  int64_t now) {
+  Relation relation = TGenerator::relation();
+  auto table = table_store::Table::Create(relation);
+  int64_t step_ns = std::max<int64_t>(1, kDataWindowNS / std::max<int64_t>(1, num_rows));
+  int64_t time_ns = now - kDataWindowNS;
+
+  for (int64_t row = 0; row < num_rows;) {
+    auto rb = std::make_unique<types::ColumnWrapperRecordBatch>();
+    for (DataType type : relation.col_types()) {
+      rb->push_back(types::ColumnWrapper::Make(type, 0));
+      rb->back()->Reserve(kRowsPerBatch);
+    }
+    for (int64_t i = 0; i < kRowsPerBatch && row < num_rows; ++i, ++row) {
+      generator->AppendRow(time_ns, rb.get());
+      time_ns += step_ns;
+    }
+    PL_CHECK_OK(table->TransferRecordBatch(std::move(rb)));
+  }
+  return table;
+}
+
+std::string FormatArg(const rapidjson::Value& variable, std::string_view value) {
+  std::string_view type = variable["type"].GetString();
+  if (type == "PX_INT64" || type == "PX_FLOAT64") {
+    return std::string(value);
+  }
+  if (type == "PX_BOOLEAN") {
+    return value == "true" ? "True" : "False";
+  }
+  return absl::Substitute("'$0'", value);
+}
+
+/**
+ * Builds the query that the UI runs for a live view: the script itself, followed by a
+ * px.display() of every function that its vis.json calls, with the spec's default arguments
+ * unless overridden.
+ */
+std::string LoadLiveViewQuery(const std::string& script_dir, const std::string& script_file,
+                              const std::map<std::string, std::string>& overrides) {
+  std::filesystem::path dir = testing::TestFilePath("src/pxl_scripts/" + script_dir);
+  std::string query = FileContentsOrDie(dir / script_file);
+  std::string vis = FileContentsOrDie(dir / "vis.json");
+
+  rapidjson::Document doc;
+  doc.Parse(vis.data(), vis.size());
+  CHECK(!doc.HasParseError()) << "Failed to parse the vis spec of " << script_dir;
+
+  std::map<std::string, std::string> args;
+  for (const auto& variable : doc["variables"].GetArray()) {
+    std::string name = variable["name"].GetString();
+    auto it = overrides.find(name);
+    std::string value;
+    if (it != overrides.end()) {
+      value = it->second;
+    } else if (variable.HasMember("defaultValue")) {
+      value = variable["defaultValue"].GetString();
+    }
+    args[name] = FormatArg(variable, value);
+  }
+
+  auto add_display = [&](const rapidjson::Value& func, std::string_view output_name) {
+    std::vector<std::string> func_args;
+    for (const auto& arg : func["args"].GetArray()) {
+      func_args.push_back(absl::Substitute("$0=$1", arg["name"].GetString(),
+                                           args[arg["variable"].GetString()]));
+    }
+    absl::StrAppend(&query, absl::Substitute("\npx.display($0($1), '$2')\n",
+                                             func["name"].GetString(),
+                                             absl::StrJoin(func_args, ", "), output_name));
+  };
+  if (doc.HasMember("globalFuncs")) {
+    for (const auto& global_func : doc["globalFuncs"].GetArray()) {
+      add_display(global_func["func"], global_func["outputName"].GetString());
+    }
+  }
+  for (const auto& widget : doc["widgets"].GetArray()) {
+    if (widget.HasMember("func")) {
+      add_display(widget["func"], widget["name"].GetString());
+    }
+  }
+  return query;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+void BM_LiveView(benchmark::State& state, const std::string& script_dir,
+                 const std::string& script_file) {
+  std::vector<BenchService> services = MakeServices();
+  int64_t now = CurrentTimeNS();
+
+  auto table_store = std::make_shared<table_store::TableStore>();
+  HTTPEventsGenerator http_events(&services);
+  table_store->AddTable("http_events", GenerateTable(&http_events, state.range(0), now));
+  ConnStatsGenerator conn_stats(&services);
+  table_store->AddTable("conn_stats", GenerateTable(&conn_stats, state.range(0), now));
+
+  exec::LocalGRPCResultSinkServer server;
+  auto carnot = Carnot::Create(sole::uuid4(), table_store,
+                               std::bind(&exec::LocalGRPCResultSinkServer::StubGenerator, &server,
+                                         std::placeholders::_1))
+                    .ConsumeValueOrDie();
+  std::shared_ptr<const md::AgentMetadataState> metadata_state = CreateMetadataState(services);
+  carnot->RegisterAgentMetadataCallback([metadata_state] { return metadata_state; });
+
+  std::string query =
+      LoadLiveViewQuery(script_dir, script_file, {{"namespace", kNamespace}, {"svc", ""}});
+
+  // The self time of each operator, keyed by its plan fragment and node id.
+  absl::btree_map<std::string, int64_t> self_time_ns;
+  int64_t bytes_processed = 0;
+  for (auto _ : state) {
+    server.ResetQueryResults();
+    PL_CHECK_OK(carnot->ExecuteQuery(query, sole::uuid4(), now, /* analyze */ true));
+
+    state.PauseTiming();
+    auto exec_stats = server.exec_stats().ConsumeValueOrDie();
+    bytes_processed += exec_stats.execution_stats().bytes_processed();
+    for (const auto& agent_stats : exec_stats.agent_execution_stats()) {
+      for (const auto& op : agent_stats.operator_execution_stats()) {
+        self_time_ns[absl::Substitute("pf$0_node$1_self_ns", op.plan_fragment_id(),
+                                      op.node_id())] += op.self_execution_time_ns();
+      }
+    }
+    state.ResumeTiming();
+  }
+
+  for (const auto& [op, time_ns] : self_time_ns) {
+    state.counters[op] = benchmark::Counter(time_ns, benchmark::Counter::kAvgIterations);
+  }
+  state.SetBytesProcessed(bytes_processed);
+}
+
+BENCHMARK_CAPTURE(BM_LiveView, http_data, "px/http_data", "data.pxl")
+    ->RangeMultiplier(4)
+    ->Range(1 << 12, 1 << 18)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_LiveView, service_stats, "px/service_stats", "service_stats.pxl")
+    ->RangeMultiplier(4)
+    ->Range(1 << 12, 1 << 18)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_LiveView, net_flow_graph, "px/net_flow_graph", "net_flow_graph.pxl")
+    ->RangeMultiplier(4)
+    ->Range(1 << 12, 1 << 18)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/query_trace.h"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/substitute.h>
+
+#include "src/common/uuid/uuid_utils.h"
+
+namespace px {
+namespace carnot {
+
+using exec::ExecNodeStats;
+
+std::string EncodeTraceSpans(const std::vector<ExecNodeStats::TraceSpan>& spans) {
+  std::string encoded;
+  for (const auto& span : spans) {
+    if (!encoded.empty()) {
+      encoded.push_back(';');
+    }
+    absl::StrAppend(&encoded, span.start_ns, ",", span.duration_ns, ",", span.rows);
+  }
+  return encoded;
+}
+
+StatusOr<std::vector<ExecNodeStats::TraceSpan>> DecodeTraceSpans(std::string_view encoded) {
+  std::vector<ExecNodeStats::TraceSpan> spans;
+  for (std::string_view entry : absl::StrSplit(encoded, ';', absl::SkipEmpty())) {
+    std::vector<std::string_view> fields = absl::StrSplit(entry, ',');
+    ExecNodeStats::TraceSpan span;
+    if (fields.size() != 3 || !absl::SimpleAtoi(fields[0], &span.start_ns) ||
+        !absl::SimpleAtoi(fields[1], &span.duration_ns) ||
+        !absl::SimpleAtoi(fields[2], &span.rows)) {
+      return error::InvalidArgument("Malformed trace span '$0'", entry);
+    }
+    spans.push_back(span);
+  }
+  return spans;
+}
+
+namespace {
+
+void WriteMetadataEvent(rapidjson::Writer<rapidjson::StringBuffer>* writer, std::string_view name,
+                        int pid, int tid, std::string_view value) {
+  writer->StartObject();
+  writer->Key("name");
+  writer->String(name.data(), name.size());
+  writer->Key("ph");
+  writer->String("M");
+  writer->Key("pid");
+  writer->Int(pid);
+  writer->Key("tid");
+  writer->Int(tid);
+  writer->Key("args");
+  writer->StartObject();
+  writer->Key("name");
+  writer->String(value.data(), value.size());
+  writer->EndObject();
+  writer->EndObject();
+}
+
+}  // namespace
+
+StatusOr<std::string> ToChromeTrace(
+    const std::vector<queryresultspb::AgentExecutionStats>& agent_stats) {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartObject();
+  writer.Key("traceEvents");
+  writer.StartArray();
+  for (size_t pid = 0; pid < agent_stats.size(); ++pid) {
+    const auto& agent = agent_stats[pid];
+    PL_ASSIGN_OR_RETURN(sole::uuid agent_id, ParseUUID(agent.agent_id()));
+    WriteMetadataEvent(&writer, "process_name", pid, 0, agent_id.str());
+
+    int tid = 0;
+    for (const auto& op : agent.operator_execution_stats()) {
+      auto spans_it = op.extra_info().find(kTraceSpansKey);
+      if (spans_it == op.extra_info().end()) {
+        continue;
+      }
+      PL_ASSIGN_OR_RETURN(auto spans, DecodeTraceSpans(spans_it->second));
+      auto name_it = op.extra_info().find(kTraceNameKey);
+      std::string name = name_it != op.extra_info().end()
+                             ? name_it->second
+                             : absl::Substitute("node $0", op.node_id());
+      ++tid;
+      WriteMetadataEvent(&writer, "thread_name", pid, tid,
+                         absl::Substitute("fragment $0: $1", op.plan_fragment_id(), name));
+      for (const auto& span : spans) {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(name.data(), name.size());
+        writer.Key("ph");
+        writer.String("X");
+        writer.Key("pid");
+        writer.Int(pid);
+        writer.Key("tid");
+        writer.Int(tid);
+        // The trace event format uses microseconds.
+        writer.Key("ts");
+        writer.Double(span.start_ns / 1000.0);
+        writer.Key("dur");
+        writer.Double(span.duration_ns / 1000.0);
+        writer.Key("args");
+        writer.StartObject();
+        writer.Key("rows");
+        writer.Int64(span.rows);
+        writer.EndObject();
+        writer.EndObject();
+      }
+    }
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return std::string(sb.GetString(), sb.GetSize());
+}
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/queryresultspb/query_results.pb.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+
+/**
+ * The extra_info keys of OperatorExecutionStats that carry an operator's batch trace.
+ */
+constexpr char kTraceSpansKey[] = "trace_spans";
+constexpr char kTraceNameKey[] = "trace_name";
+
+/**
+ * Encodes an operator's trace spans for the kTraceSpansKey entry of its extra_info, as
+ * "start_ns,duration_ns,rows" entries separated by ';'.
+ */
+std::string EncodeTraceSpans(const std::vector<exec::ExecNodeStats::TraceSpan>& spans);
+
+StatusOr<std::vector<exec::ExecNodeStats::TraceSpan>> DecodeTraceSpans(std::string_view encoded);
+
+/**
+ * Merges the batch traces of the operators of all the given agents into one trace, in the Chrome
+ * trace event format (viewable in chrome://tracing or Perfetto). Each agent is a process, and each
+ * operator a thread within it.
+ */
+StatusOr<std::string> ToChromeTrace(
+    const std::vector<queryresultspb::AgentExecutionStats>& agent_stats);
+
+}  // namespace carnot
+}  // namespace px
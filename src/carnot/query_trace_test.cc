@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/query_trace.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <rapidjson/document.h>
+
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/common/uuid/uuid_utils.h"
+
+namespace px {
+namespace carnot {
+
+using exec::ExecNodeStats;
+
+TEST(QueryTraceTest, EncodeDecodeSpans) {
+  std::vector<ExecNodeStats::TraceSpan> spans = {{1000, 10, 5}, {2000, 20, 0}};
+  std::string encoded = EncodeTraceSpans(spans);
+  EXPECT_EQ("1000,10,5;2000,20,0", encoded);
+
+  ASSERT_OK_AND_ASSIGN(auto decoded, DecodeTraceSpans(encoded));
+  ASSERT_EQ(2, decoded.size());
+  EXPECT_EQ(2000, decoded[1].start_ns);
+  EXPECT_EQ(20, decoded[1].duration_ns);
+  EXPECT_EQ(0, decoded[1].rows);
+
+  EXPECT_NOT_OK(DecodeTraceSpans("1000,10"));
+}
+
+TEST(QueryTraceTest, ChromeTrace) {
+  std::vector<queryresultspb::AgentExecutionStats> agent_stats(2);
+  for (auto& agent : agent_stats) {
+    ToProto(sole::uuid4(), agent.mutable_agent_id());
+  }
+  auto* op = agent_stats[0].add_operator_execution_stats();
+  op->set_plan_fragment_id(1);
+  op->set_node_id(2);
+  (*op->mutable_extra_info())[kTraceSpansKey] = "1000,2000,5;4000,1000,3";
+  (*op->mutable_extra_info())[kTraceNameKey] = "map";
+  // Operators that weren't traced are left out.
+  agent_stats[1].add_operator_execution_stats()->set_node_id(3);
+
+  ASSERT_OK_AND_ASSIGN(std::string trace, ToChromeTrace(agent_stats));
+  rapidjson::Document doc;
+  ASSERT_FALSE(doc.Parse(trace.data(), trace.size()).HasParseError());
+  const auto& events = doc["traceEvents"];
+  // Two process names, one thread name and two spans.
+  ASSERT_EQ(5, events.Size());
+  EXPECT_STREQ("thread_name", events[1]["name"].GetString());
+  EXPECT_STREQ("fragment 1: map", events[1]["args"]["name"].GetString());
+  EXPECT_STREQ("X", events[2]["ph"].GetString());
+  EXPECT_EQ(1.0, events[2]["ts"].GetDouble());
+  EXPECT_EQ(2.0, events[2]["dur"].GetDouble());
+  EXPECT_EQ(5, events[2]["args"]["rows"].GetInt64());
+  EXPECT_EQ(1, events[4]["pid"].GetInt());
+  EXPECT_STREQ("process_name", events[4]["name"].GetString());
+}
+
+}  // namespace carnot
+}  // namespace px
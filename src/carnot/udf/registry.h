@@ -24,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_format.h>
 
 #include "src/carnot/udf/doc.h"
@@ -69,6 +70,15 @@ class RegistryKey {
    */
   bool operator<(const RegistryKey& lhs) const;
 
+  bool operator==(const RegistryKey& other) const {
+    return name_ == other.name_ && registry_arg_types_ == other.registry_arg_types_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const RegistryKey& key) {
+    return H::combine(std::move(h), key.name_, key.registry_arg_types_);
+  }
+
  protected:
   std::string name_;
   std::vector<types::DataType> registry_arg_types_;
@@ -116,11 +126,12 @@ class Registry {
     PL_RETURN_IF_ERROR(udf_def->template Init<T>());
 
     auto key = RegistryKey(name, udf_def->RegistryArgTypes());
-    if (map_.find(key) != map_.end()) {
+    if (index_.contains(key)) {
       return error::AlreadyExists(
           "The UDF with name \"$0\" already exists with same exec args \"$1\".", name,
           key.DebugString());
     }
+    index_[key] = udf_def.get();
     map_[key] = std::move(udf_def);
     RegisterSemanticTypes<T>(name);
 
@@ -187,11 +198,12 @@ class Registry {
     PL_RETURN_IF_ERROR(udf_def->template Init<TUDTF>(std::move(factory)));
 
     auto key = RegistryKey(name, udf_def->RegistryArgTypes());
-    if (map_.find(key) != map_.end()) {
+    if (index_.contains(key)) {
       return error::AlreadyExists(
           "The UDTF with name \"$0\" already exists with same exec args \"$1\".", name,
           key.DebugString());
     }
+    index_[key] = udf_def.get();
     map_[key] = std::move(udf_def);
     return Status::OK();
   }
@@ -239,6 +251,8 @@ class Registry {
 
   std::string name_;
   RegistryMap map_;
+  // Hash index over map_ for lookups. map_ stays ordered so that ToProto and the docs are stable.
+  absl::flat_hash_map<RegistryKey, UDFDefinition*> index_;
   std::map<std::string, ExplicitRuleSet> semantic_type_rules_;
   udfspb::Docs docs_pb_;
 };
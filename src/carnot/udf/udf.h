@@ -25,6 +25,8 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -74,6 +76,39 @@ class AnyUDA : public BaseFunc {
  *      Status Init(FunctionContext *ctx, UDFValue... init_args) {}
  *  This function is called once during initialization of each instance (many instances
  *  may exists in a given query). The arguments are as provided by the query.
+ *
+ * UDFs whose Exec only computes on its arguments (it doesn't use the context or any state) can
+ * declare:
+ *      static constexpr bool kVectorized = true;
+ *  When all the arguments are INT64, TIME64NS or FLOAT64 and the return value is one of those
+ *  or a BOOLEAN, Exec is then run over whole buffers of raw values, in a loop the compiler
+ *  vectorizes.
+ *
+ * UDFs with a single UINT128 or STRING argument whose result only depends on that argument for
+ * the duration of a batch, such as metadata lookups, can declare:
+ *      static constexpr bool kMemoized = true;
+ *  Exec is then called once per distinct argument in a batch, and the result is copied to the
+ *  other rows with that argument. Memoized UDFs can also define
+ *      void Prefetch(FunctionContext*, const std::vector<Key>& args)
+ *  which gets all the distinct arguments of a batch (as absl::uint128 or std::string_view keys)
+ *  before any Exec, to prepare results that are expensive to get one at a time.
+ *
+ * UDFs can also provide a kernel that runs over the whole arrow arrays of a batch:
+ *      Status ExecArrow(FunctionContext* ctx, const ArrowArray&... args, ArrowBuilder* out)
+ *  where each ArrowArray is the arrow array type of the matching Exec argument (eg.
+ *  arrow::StringArray) and ArrowBuilder is the builder of the Exec return type. It is used instead
+ *  of Exec whenever the batch is already in arrow, so string functions can work on the offsets
+ *  and data buffers without creating a value per row.
+ *
+ * UDFs whose Exec is expensive and safe to call concurrently, such as parsers, can declare:
+ *      static constexpr bool kParallel = true;
+ *  Large batches are then split across --carnot_udf_parallelism threads.
+ *
+ * UDFs of the form T Exec(FunctionContext*, BoolValue s, T v1, T v2) that return v1 when s is
+ * true and v2 otherwise can declare:
+ *      static constexpr bool kConditional = true;
+ *  Batches are then blended from the two value buffers without calling Exec, and the evaluator
+ *  skips evaluating a branch that the selector doesn't pick for any row of the batch.
  */
 class ScalarUDF : public AnyUDF {
  public:
@@ -99,6 +134,13 @@ class ScalarUDF : public AnyUDF {
  *     StringValue Serialize(FunctionContext*) {}
  *     Status DeSerialize(FunctionContext*, const StringValue& data) {}
  *
+ * To update on whole columns at once, instead of calling Update per record, UDAs may implement:
+ *     void UpdateBatch(FunctionContext *ctx, const ColumnWrapperTmpl<Args>&...) {}
+ *     void UpdateBatch(FunctionContext *ctx, const SelectionVector& rows,
+ *                      const ColumnWrapperTmpl<Args>&...) {}
+ * The second form only updates on the given rows of the columns, and is used by grouped
+ * aggregates. Both must be equivalent to calling Update on each of the (selected) records.
+ *
  * All argument types must me valid UDFValueTypes.
  */
 class UDA : public AnyUDA {
@@ -106,6 +148,9 @@ class UDA : public AnyUDA {
   ~UDA() override = default;
 };
 
+// Indices of the rows to update on, passed to UpdateBatch.
+using SelectionVector = std::vector<int64_t>;
+
 // SFINAE test for init fn.
 template <typename T, typename = void>
 struct has_udf_init_fn : std::false_type {};
@@ -188,6 +233,63 @@ static constexpr types::DataType ReturnTypeHelper(ReturnType (TUDF::*)(Types...)
   return types::ValueTypeTraits<ReturnType>::data_type;
 }
 
+// SFINAE test for the kVectorized flag.
+template <typename T, typename = void>
+struct has_udf_vectorized_flag : std::false_type {};
+
+template <typename T>
+struct has_udf_vectorized_flag<T, std::void_t<decltype(T::kVectorized)>>
+    : std::bool_constant<T::kVectorized> {};
+
+// SFINAE test for the kMemoized flag.
+template <typename T, typename = void>
+struct has_udf_memoized_flag : std::false_type {};
+
+template <typename T>
+struct has_udf_memoized_flag<T, std::void_t<decltype(T::kMemoized)>>
+    : std::bool_constant<T::kMemoized> {};
+
+// SFINAE test for the kConditional flag.
+template <typename T, typename = void>
+struct has_udf_conditional_flag : std::false_type {};
+
+template <typename T>
+struct has_udf_conditional_flag<T, std::void_t<decltype(T::kConditional)>>
+    : std::bool_constant<T::kConditional> {};
+
+// SFINAE test for the kParallel flag.
+template <typename T, typename = void>
+struct has_udf_parallel_flag : std::false_type {};
+
+template <typename T>
+struct has_udf_parallel_flag<T, std::void_t<decltype(T::kParallel)>>
+    : std::bool_constant<T::kParallel> {};
+
+// SFINAE test for the Prefetch fn of memoized UDFs.
+template <typename T, typename = void>
+struct has_udf_prefetch_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_prefetch_fn<T, std::void_t<decltype(&T::Prefetch)>> : std::true_type {};
+
+// SFINAE test for the ExecArrow kernel.
+template <typename T, typename = void>
+struct has_udf_exec_arrow_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_exec_arrow_fn<T, std::void_t<decltype(&T::ExecArrow)>> : std::true_type {};
+
+// Whether memoized Execs can be cached on an argument of the type.
+constexpr bool IsMemoizedExecType(types::DataType data_type) {
+  return data_type == types::DataType::UINT128 || data_type == types::DataType::STRING;
+}
+
+// Whether vectorized Execs take or return raw buffers of the type.
+constexpr bool IsVectorizedExecType(types::DataType data_type) {
+  return data_type == types::DataType::INT64 || data_type == types::DataType::TIME64NS ||
+         data_type == types::DataType::FLOAT64;
+}
+
 template <typename T, typename = void>
 struct check_init_fn {};
 
@@ -228,6 +330,63 @@ class ScalarUDFTraits {
    */
   static constexpr bool HasExecutor() { return has_udf_executor_fn<T>::value; }
 
+  /**
+   * Checks if Exec can run over raw value buffers (see ScalarUDF).
+   */
+  static constexpr bool IsVectorized() {
+    if constexpr (!has_udf_vectorized_flag<T>::value) {
+      return false;
+    } else {
+      for (const auto& data_type : ExecArguments()) {
+        if (!IsVectorizedExecType(data_type)) {
+          return false;
+        }
+      }
+      return IsVectorizedExecType(ReturnType()) || ReturnType() == types::DataType::BOOLEAN;
+    }
+  }
+
+  /**
+   * Checks if Exec only needs to run once per distinct input in a batch (see ScalarUDF).
+   */
+  static constexpr bool IsMemoized() {
+    if constexpr (!has_udf_memoized_flag<T>::value) {
+      return false;
+    } else {
+      return ExecArguments().size() == 1 && IsMemoizedExecType(ExecArguments()[0]);
+    }
+  }
+
+  /**
+   * Checks if a memoized UDF gets the distinct arguments of each batch before Exec is called.
+   */
+  static constexpr bool HasPrefetch() { return IsMemoized() && has_udf_prefetch_fn<T>::value; }
+
+  /**
+   * Checks if the UDF has an ExecArrow kernel for batches of arrow arrays (see ScalarUDF).
+   */
+  static constexpr bool HasArrowKernel() { return has_udf_exec_arrow_fn<T>::value; }
+
+  /**
+   * Checks if the UDF selects between its last two arguments on its first (see ScalarUDF).
+   */
+  static constexpr bool IsConditional() {
+    if constexpr (!has_udf_conditional_flag<T>::value) {
+      return false;
+    } else {
+      constexpr auto args = ExecArguments();
+      return args.size() == 3 && args[0] == types::DataType::BOOLEAN && args[1] == ReturnType() &&
+             args[2] == ReturnType();
+    }
+  }
+
+  /**
+   * Checks if Exec can run on several threads at once (see ScalarUDF).
+   */
+  static constexpr bool IsParallel() {
+    return has_udf_parallel_flag<T>::value && !IsVectorized() && !IsMemoized();
+  }
+
  private:
   struct check_valid_udf {
     static_assert(std::is_base_of_v<ScalarUDF, T>, "UDF must be derived from ScalarUDF");
@@ -333,6 +492,31 @@ struct has_uda_deserialize_fn<T, std::void_t<decltype(&T::Deserialize)>> : std::
                 "Deserialize(FunctionContext*, const StringValue&)");
 };
 
+template <typename TUDA, typename... Types>
+std::tuple<std::decay_t<Types>...> UpdateArgumentsHelper(void (TUDA::*)(FunctionContext*,
+                                                                       Types...));
+
+// SFINAE test for the UpdateBatch fns, TArgsTuple is the tuple of the Update argument types.
+template <typename T, typename TArgsTuple, typename = void>
+struct has_uda_update_batch_fn : std::false_type {};
+
+template <typename T, typename... TArgs>
+struct has_uda_update_batch_fn<
+    T, std::tuple<TArgs...>,
+    std::void_t<decltype(std::declval<T&>().UpdateBatch(
+        std::declval<FunctionContext*>(),
+        std::declval<const types::ColumnWrapperTmpl<TArgs>&>()...))>> : std::true_type {};
+
+template <typename T, typename TArgsTuple, typename = void>
+struct has_uda_update_batch_selection_fn : std::false_type {};
+
+template <typename T, typename... TArgs>
+struct has_uda_update_batch_selection_fn<
+    T, std::tuple<TArgs...>,
+    std::void_t<decltype(std::declval<T&>().UpdateBatch(
+        std::declval<FunctionContext*>(), std::declval<const SelectionVector&>(),
+        std::declval<const types::ColumnWrapperTmpl<TArgs>&>()...))>> : std::true_type {};
+
 /**
  * ScalarUDFTraits allows access to compile time traits of a given UDA.
  * @tparam T A class that derives from UDA.
@@ -358,6 +542,21 @@ class UDATraits {
     return has_uda_serialize_fn<T>() && has_uda_deserialize_fn<T>();
   }
 
+  /**
+   * Checks if the UDA has an UpdateBatch function on whole columns.
+   */
+  static constexpr bool HasUpdateBatch() {
+    return has_uda_update_batch_fn<T, decltype(UpdateArgumentsHelper(&T::Update))>::value;
+  }
+
+  /**
+   * Checks if the UDA has an UpdateBatch function on selected rows of the columns.
+   */
+  static constexpr bool HasUpdateBatchSelection() {
+    return has_uda_update_batch_selection_fn<T,
+                                             decltype(UpdateArgumentsHelper(&T::Update))>::value;
+  }
+
  private:
   /**
    * Static asserts to validate that the UDA is well formed.
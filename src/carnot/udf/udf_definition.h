@@ -95,6 +95,10 @@ class ScalarUDFDefinition : public UDFDefinition {
     exec_arguments_ = {begin(exec_arguments_array), end(exec_arguments_array)};
     exec_wrapper_fn_ = ScalarUDFWrapper<TUDF>::ExecBatch;
     exec_wrapper_arrow_fn_ = ScalarUDFWrapper<TUDF>::ExecBatchArrow;
+    if constexpr (ScalarUDFTraits<TUDF>::IsVectorized()) {
+      exec_raw_fn_ = ScalarUDFWrapper<TUDF>::ExecBatchRaw;
+    }
+    conditional_ = ScalarUDFTraits<TUDF>::IsConditional();
 
     make_fn_ = ScalarUDFWrapper<TUDF>::Make;
 
@@ -123,6 +127,15 @@ class ScalarUDFDefinition : public UDFDefinition {
     return exec_wrapper_arrow_fn_(udf, ctx, inputs, output, count);
   }
 
+  /**
+   * Executes the UDF on raw value buffers. Only valid for vectorized UDFs.
+   */
+  void ExecBatchRaw(ScalarUDF* udf, FunctionContext* ctx, const std::vector<const void*>& inputs,
+                    void* output, int count) {
+    DCHECK(vectorized());
+    exec_raw_fn_(udf, ctx, inputs, output, count);
+  }
+
   /**
    * Access internal variable exec_return_type.
    * @return the stored return types of the exec function.
@@ -133,12 +146,17 @@ class ScalarUDFDefinition : public UDFDefinition {
 
   const std::vector<types::DataType>& RegistryArgTypes() override { return exec_arguments_; }
   size_t Arity() const { return exec_arguments_.size(); }
+  // Whether the UDF can run on raw value buffers (see ScalarUDF).
+  bool vectorized() const { return exec_raw_fn_ != nullptr; }
+  // Whether the UDF selects between its last two arguments on its first (see ScalarUDF).
+  bool conditional() const { return conditional_; }
   const auto& exec_wrapper() const { return exec_wrapper_fn_; }
 
  private:
   std::vector<types::DataType> exec_arguments_;
   types::DataType exec_return_type_;
   udfspb::UDFSourceExecutor executor_;
+  bool conditional_ = false;
   std::function<std::unique_ptr<ScalarUDF>()> make_fn_;
   std::function<Status(ScalarUDF*, FunctionContext* ctx,
                        const std::vector<const types::ColumnWrapper*>& inputs,
@@ -149,6 +167,10 @@ class ScalarUDFDefinition : public UDFDefinition {
                        const std::vector<arrow::Array*>& inputs, arrow::ArrayBuilder* output,
                        int count)>
       exec_wrapper_arrow_fn_;
+
+  std::function<void(ScalarUDF* udf, FunctionContext* ctx, const std::vector<const void*>& inputs,
+                      void* output, int count)>
+      exec_raw_fn_;
 };
 
 /**
@@ -176,12 +198,16 @@ class UDADefinition : public UDFDefinition {
     make_fn_ = UDAWrapper<T>::Make;
     exec_batch_update_fn_ = UDAWrapper<T>::ExecBatchUpdate;
     exec_batch_update_arrow_fn_ = UDAWrapper<T>::ExecBatchUpdateArrow;
+    exec_batch_update_selection_fn_ = UDAWrapper<T>::ExecBatchUpdateSelection;
 
     merge_fn_ = UDAWrapper<T>::Merge;
+    serialize_fn_ = UDAWrapper<T>::Serialize;
+    deserialize_fn_ = UDAWrapper<T>::Deserialize;
     finalize_arrow_fn_ = UDAWrapper<T>::FinalizeArrow;
     finalize_value_fn = UDAWrapper<T>::FinalizeValue;
 
     supports_partial_ = UDAWrapper<T>::SupportsPartial;
+    has_update_batch_selection_ = UDAWrapper<T>::HasUpdateBatchSelection;
     return Status::OK();
   }
 
@@ -193,6 +219,8 @@ class UDADefinition : public UDFDefinition {
   types::DataType finalize_return_type() const { return finalize_return_type_; }
 
   bool supports_partial() const { return supports_partial_; }
+  // Whether the UDA implements UpdateBatch on selected rows, see udf::UDA.
+  bool has_update_batch_selection() const { return has_update_batch_selection_; }
 
   std::unique_ptr<UDA> Make() { return make_fn_(); }
 
@@ -204,8 +232,21 @@ class UDADefinition : public UDFDefinition {
                               const std::vector<const arrow::Array*>& inputs) {
     return exec_batch_update_arrow_fn_(uda, ctx, inputs);
   }
+  Status ExecBatchUpdateSelection(UDA* uda, FunctionContext* ctx,
+                                  const std::vector<const types::ColumnWrapper*>& inputs,
+                                  const SelectionVector& rows) {
+    return exec_batch_update_selection_fn_(uda, ctx, inputs, rows);
+  }
 
   Status Merge(UDA* uda1, UDA* uda2, FunctionContext* ctx) { return merge_fn_(uda1, uda2, ctx); }
+  // Serialize and Deserialize move the partial state of the UDA between the agents, they fail
+  // unless supports_partial() is true.
+  StatusOr<types::StringValue> Serialize(UDA* uda, FunctionContext* ctx) {
+    return serialize_fn_(uda, ctx);
+  }
+  Status Deserialize(UDA* uda, FunctionContext* ctx, const types::StringValue& data) {
+    return deserialize_fn_(uda, ctx, data);
+  }
   Status FinalizeValue(UDA* uda, FunctionContext* ctx, types::BaseValueType* output) {
     return finalize_value_fn(uda, ctx, output);
   }
@@ -217,6 +258,7 @@ class UDADefinition : public UDFDefinition {
   std::vector<types::DataType> update_arguments_;
   types::DataType finalize_return_type_;
   bool supports_partial_;
+  bool has_update_batch_selection_;
 
   std::function<std::unique_ptr<UDA>()> make_fn_;
   std::function<Status(UDA* uda, FunctionContext* ctx,
@@ -227,11 +269,19 @@ class UDADefinition : public UDFDefinition {
                        const std::vector<const arrow::Array*>& inputs)>
       exec_batch_update_arrow_fn_;
 
+  std::function<Status(UDA* uda, FunctionContext* ctx,
+                       const std::vector<const types::ColumnWrapper*>& inputs,
+                       const SelectionVector& rows)>
+      exec_batch_update_selection_fn_;
+
   std::function<Status(UDA* uda, FunctionContext* ctx, arrow::ArrayBuilder* output)>
       finalize_arrow_fn_;
   std::function<Status(UDA* uda, FunctionContext* ctx, types::BaseValueType* output)>
       finalize_value_fn;
   std::function<Status(UDA* uda1, UDA* uda2, FunctionContext* ctx)> merge_fn_;
+  std::function<StatusOr<types::StringValue>(UDA* uda, FunctionContext* ctx)> serialize_fn_;
+  std::function<Status(UDA* uda, FunctionContext* ctx, const types::StringValue& data)>
+      deserialize_fn_;
 };
 
 class UDTFDefinition : public UDFDefinition {
@@ -270,6 +320,7 @@ class UDTFDefinition : public UDFDefinition {
 
     exec_init_ = UDTFWrapper<T>::Init;
     exec_batch_update_ = UDTFWrapper<T>::ExecBatchUpdate;
+    exec_ready_ = UDTFWrapper<T>::Ready;
 
     auto init_args = UDTFTraits<T>::InitArguments();
     init_arguments_ = {init_args.begin(), init_args.end()};
@@ -301,6 +352,12 @@ class UDTFDefinition : public UDFDefinition {
     return exec_batch_update_(udtf, ctx, max_gen_records, outputs);
   }
 
+  /**
+   * Returns whether the UDTF is ready to produce records. UDTFs without a Ready function are
+   * always ready.
+   */
+  StatusOr<bool> ExecReady(AnyUDTF* udtf, FunctionContext* ctx) { return exec_ready_(udtf, ctx); }
+
   const std::vector<UDTFArg>& init_arguments() const { return init_arguments_; }
   const std::vector<ColInfo>& output_relation() const { return output_relation_; }
   udfspb::UDTFSourceExecutor executor() const { return executor_; }
@@ -312,6 +369,7 @@ class UDTFDefinition : public UDFDefinition {
   std::function<bool(AnyUDTF* udtf, FunctionContext* ctx, int max_gen_records,
                      std::vector<arrow::ArrayBuilder*>* outputs)>
       exec_batch_update_;
+  std::function<StatusOr<bool>(AnyUDTF* udtf, FunctionContext* ctx)> exec_ready_;
   std::vector<UDTFArg> init_arguments_;
   std::vector<ColInfo> output_relation_;
   udfspb::UDTFSourceExecutor executor_;
@@ -20,6 +20,11 @@
 #include <arrow/pretty_print.h>
 
 #include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
 
 #include "src/carnot/udf/udf_definition.h"
 #include "src/common/testing/testing.h"
@@ -49,6 +54,74 @@ class AddUDF : public ScalarUDF {
   }
 };
 
+class VectorizedGreaterThanUDF : public ScalarUDF {
+ public:
+  static constexpr bool kVectorized = true;
+
+  types::BoolValue Exec(FunctionContext*, types::Time64NSValue v1, types::Float64Value v2) {
+    return v1.val > v2.val;
+  }
+};
+
+class MemoizedSuffixUDF : public ScalarUDF {
+ public:
+  static constexpr bool kMemoized = true;
+
+  types::StringValue Exec(FunctionContext*, types::StringValue str) {
+    ++invoke_count;
+    return str + "_" + std::to_string(invoke_count);
+  }
+
+  int invoke_count = 0;
+};
+
+class PrefetchSuffixUDF : public ScalarUDF {
+ public:
+  static constexpr bool kMemoized = true;
+
+  void Prefetch(FunctionContext*, const std::vector<std::string_view>& strs) {
+    for (auto str : strs) {
+      suffixes[std::string(str)] = absl::StrCat("_", suffixes.size());
+    }
+  }
+
+  types::StringValue Exec(FunctionContext*, types::StringValue str) {
+    return str + suffixes[str];
+  }
+
+  absl::flat_hash_map<std::string, std::string> suffixes;
+};
+
+class ArrowLengthUDF : public ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::StringValue str) { return str.size(); }
+
+  Status ExecArrow(FunctionContext*, const arrow::StringArray& strs, arrow::Int64Builder* out) {
+    ++kernel_count;
+    for (int64_t i = 0; i < strs.length(); ++i) {
+      PL_RETURN_IF_ERROR(out->Append(strs.value_length(i)));
+    }
+    return Status::OK();
+  }
+
+  int kernel_count = 0;
+};
+
+class ParallelSquareUDF : public ScalarUDF {
+ public:
+  static constexpr bool kParallel = true;
+
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v) { return v.val * v.val; }
+};
+
+template <typename TArg>
+class SelectUDF : public ScalarUDF {
+ public:
+  static constexpr bool kConditional = true;
+
+  TArg Exec(FunctionContext*, types::BoolValue s, TArg v1, TArg v2) { return s.val ? v1 : v2; }
+};
+
 TEST(UDFDefinition, no_args) {
   auto ctx = FunctionContext(nullptr, nullptr);
   ScalarUDFDefinition def("noargudf");
@@ -97,6 +170,227 @@ TEST(UDFDefinition, str_args) {
   EXPECT_EQ("el", out[2]);
 }
 
+TEST(UDFDefinition, vectorized) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("gt");
+  EXPECT_OK(def.Init<VectorizedGreaterThanUDF>());
+
+  types::Time64NSValueColumnWrapper v1({1, 5, 3, 8, 2});
+  types::Float64ValueColumnWrapper v2({2.5, 2.5, 3.5, 7.5, 1.5});
+
+  types::BoolValueColumnWrapper out(v1.Size());
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1, &v2}, &out, v1.Size()));
+  EXPECT_FALSE(out[0].val);
+  EXPECT_TRUE(out[1].val);
+  EXPECT_FALSE(out[2].val);
+  EXPECT_TRUE(out[3].val);
+  EXPECT_TRUE(out[4].val);
+
+  auto output_builder = std::make_shared<arrow::BooleanBuilder>();
+  auto v1a = v1.ConvertToArrow(arrow::default_memory_pool());
+  auto v2a = v2.ConvertToArrow(arrow::default_memory_pool());
+  EXPECT_OK(def.ExecBatchArrow(u.get(), &ctx, {v1a.get(), v2a.get()}, output_builder.get(),
+                               v1.Size()));
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(output_builder->Finish(&res).ok());
+  auto* res_arr = static_cast<arrow::BooleanArray*>(res.get());
+  ASSERT_EQ(5, res_arr->length());
+  for (int64_t i = 0; i < res_arr->length(); ++i) {
+    EXPECT_EQ(out[i].val, res_arr->Value(i));
+  }
+}
+
+TEST(UDFDefinition, conditional) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  types::BoolValueColumnWrapper sel({true, false, false, true});
+
+  ScalarUDFDefinition float_def("select");
+  EXPECT_OK(float_def.Init<SelectUDF<types::Float64Value>>());
+  EXPECT_TRUE(float_def.conditional());
+  types::Float64ValueColumnWrapper f1({1.5, 2.5, 3.5, 4.5});
+  types::Float64ValueColumnWrapper f2({-1.5, -2.5, -3.5, -4.5});
+  types::Float64ValueColumnWrapper float_out(sel.Size());
+  auto u = float_def.Make();
+  EXPECT_OK(float_def.ExecBatch(u.get(), &ctx, {&sel, &f1, &f2}, &float_out, sel.Size()));
+  EXPECT_EQ(1.5, float_out[0].val);
+  EXPECT_EQ(-2.5, float_out[1].val);
+  EXPECT_EQ(-3.5, float_out[2].val);
+  EXPECT_EQ(4.5, float_out[3].val);
+
+  auto sela = sel.ConvertToArrow(arrow::default_memory_pool());
+  auto f1a = f1.ConvertToArrow(arrow::default_memory_pool());
+  auto f2a = f2.ConvertToArrow(arrow::default_memory_pool());
+  auto float_builder = std::make_shared<arrow::DoubleBuilder>();
+  EXPECT_OK(float_def.ExecBatchArrow(u.get(), &ctx, {sela.get(), f1a.get(), f2a.get()},
+                                     float_builder.get(), sel.Size()));
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(float_builder->Finish(&res).ok());
+  auto* float_arr = static_cast<arrow::DoubleArray*>(res.get());
+  ASSERT_EQ(4, float_arr->length());
+  for (int64_t i = 0; i < float_arr->length(); ++i) {
+    EXPECT_EQ(float_out[i].val, float_arr->Value(i));
+  }
+
+  ScalarUDFDefinition str_def("select");
+  EXPECT_OK(str_def.Init<SelectUDF<types::StringValue>>());
+  types::StringValueColumnWrapper s1({"a", "bb", "ccc", "dddd"});
+  types::StringValueColumnWrapper s2({"w", "xx", "", "zzzz"});
+  types::StringValueColumnWrapper str_out(sel.Size());
+  u = str_def.Make();
+  EXPECT_OK(str_def.ExecBatch(u.get(), &ctx, {&sel, &s1, &s2}, &str_out, sel.Size()));
+  EXPECT_EQ("a", str_out[0]);
+  EXPECT_EQ("xx", str_out[1]);
+  EXPECT_EQ("", str_out[2]);
+  EXPECT_EQ("dddd", str_out[3]);
+
+  auto s1a = s1.ConvertToArrow(arrow::default_memory_pool());
+  auto s2a = s2.ConvertToArrow(arrow::default_memory_pool());
+  auto str_builder = std::make_shared<arrow::StringBuilder>();
+  EXPECT_OK(str_def.ExecBatchArrow(u.get(), &ctx, {sela.get(), s1a.get(), s2a.get()},
+                                   str_builder.get(), sel.Size()));
+  EXPECT_TRUE(str_builder->Finish(&res).ok());
+  auto* str_arr = static_cast<arrow::StringArray*>(res.get());
+  ASSERT_EQ(4, str_arr->length());
+  for (int64_t i = 0; i < str_arr->length(); ++i) {
+    EXPECT_EQ(str_out[i], str_arr->GetString(i));
+  }
+
+  // Booleans are blended on column wrappers, and run Exec per row on arrow arrays.
+  ScalarUDFDefinition bool_def("select");
+  EXPECT_OK(bool_def.Init<SelectUDF<types::BoolValue>>());
+  types::BoolValueColumnWrapper b1({true, true, true, true});
+  types::BoolValueColumnWrapper b2({false, false, false, false});
+  types::BoolValueColumnWrapper bool_out(sel.Size());
+  u = bool_def.Make();
+  EXPECT_OK(bool_def.ExecBatch(u.get(), &ctx, {&sel, &b1, &b2}, &bool_out, sel.Size()));
+  for (size_t i = 0; i < sel.Size(); ++i) {
+    EXPECT_EQ(sel[i].val, bool_out[i].val);
+  }
+
+  ScalarUDFDefinition gt_def("gt");
+  EXPECT_OK(gt_def.Init<VectorizedGreaterThanUDF>());
+  EXPECT_FALSE(gt_def.conditional());
+}
+
+TEST(UDFDefinition, memoized) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("suffix");
+  EXPECT_OK(def.Init<MemoizedSuffixUDF>());
+
+  types::StringValueColumnWrapper v1({"a", "b", "a", "c", "b"});
+
+  types::StringValueColumnWrapper out(v1.Size());
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1}, &out, v1.Size()));
+  // Exec only runs on the first row with each argument.
+  EXPECT_EQ(3, static_cast<MemoizedSuffixUDF*>(u.get())->invoke_count);
+  EXPECT_EQ("a_1", out[0]);
+  EXPECT_EQ("b_2", out[1]);
+  EXPECT_EQ("a_1", out[2]);
+  EXPECT_EQ("c_3", out[3]);
+  EXPECT_EQ("b_2", out[4]);
+
+  auto output_builder = std::make_shared<arrow::StringBuilder>();
+  auto v1a = v1.ConvertToArrow(arrow::default_memory_pool());
+  EXPECT_OK(def.ExecBatchArrow(u.get(), &ctx, {v1a.get()}, output_builder.get(), v1.Size()));
+  EXPECT_EQ(6, static_cast<MemoizedSuffixUDF*>(u.get())->invoke_count);
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(output_builder->Finish(&res).ok());
+  auto* res_arr = static_cast<arrow::StringArray*>(res.get());
+  ASSERT_EQ(5, res_arr->length());
+  EXPECT_EQ("a_4", res_arr->GetString(0));
+  EXPECT_EQ("b_5", res_arr->GetString(1));
+  EXPECT_EQ("a_4", res_arr->GetString(2));
+  EXPECT_EQ("c_6", res_arr->GetString(3));
+  EXPECT_EQ("b_5", res_arr->GetString(4));
+}
+
+TEST(UDFDefinition, prefetch) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("suffix");
+  EXPECT_OK(def.Init<PrefetchSuffixUDF>());
+
+  types::StringValueColumnWrapper v1({"a", "b", "a", "c"});
+  types::StringValueColumnWrapper out(v1.Size());
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1}, &out, v1.Size()));
+  // Each distinct argument is prefetched once, before Exec.
+  auto* udf = static_cast<PrefetchSuffixUDF*>(u.get());
+  ASSERT_EQ(3, udf->suffixes.size());
+  for (size_t i = 0; i < v1.Size(); ++i) {
+    EXPECT_EQ(v1[i] + udf->suffixes[v1[i]], out[i]);
+  }
+
+  auto output_builder = std::make_shared<arrow::StringBuilder>();
+  auto v1a = v1.ConvertToArrow(arrow::default_memory_pool());
+  EXPECT_OK(def.ExecBatchArrow(u.get(), &ctx, {v1a.get()}, output_builder.get(), v1.Size()));
+  EXPECT_EQ(3, udf->suffixes.size());
+}
+
+TEST(UDFDefinition, arrow_kernel) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("length");
+  EXPECT_OK(def.Init<ArrowLengthUDF>());
+
+  types::StringValueColumnWrapper v1({"a", "bcd", ""});
+  auto u = def.Make();
+  auto* udf = static_cast<ArrowLengthUDF*>(u.get());
+
+  // Column wrappers still run Exec on each row.
+  types::Int64ValueColumnWrapper out(v1.Size());
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1}, &out, v1.Size()));
+  EXPECT_EQ(0, udf->kernel_count);
+  EXPECT_EQ(3, out[1].val);
+
+  auto output_builder = std::make_shared<arrow::Int64Builder>();
+  auto v1a = v1.ConvertToArrow(arrow::default_memory_pool());
+  EXPECT_OK(def.ExecBatchArrow(u.get(), &ctx, {v1a.get()}, output_builder.get(), v1.Size()));
+  EXPECT_EQ(1, udf->kernel_count);
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(output_builder->Finish(&res).ok());
+  auto* res_arr = static_cast<arrow::Int64Array*>(res.get());
+  ASSERT_EQ(3, res_arr->length());
+  EXPECT_EQ(1, res_arr->Value(0));
+  EXPECT_EQ(3, res_arr->Value(1));
+  EXPECT_EQ(0, res_arr->Value(2));
+}
+
+TEST(UDFDefinition, parallel) {
+  int32_t parallelism = FLAGS_carnot_udf_parallelism;
+  FLAGS_carnot_udf_parallelism = 4;
+
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("square");
+  EXPECT_OK(def.Init<ParallelSquareUDF>());
+
+  size_t size = 10 * kMinRowsPerUDFThread + 3;
+  types::Int64ValueColumnWrapper v1(size);
+  for (size_t i = 0; i < size; ++i) {
+    v1[i] = i;
+  }
+
+  types::Int64ValueColumnWrapper out(size);
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1}, &out, size));
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_EQ(static_cast<int64_t>(i * i), out[i].val);
+  }
+
+  auto output_builder = std::make_shared<arrow::Int64Builder>();
+  auto v1a = v1.ConvertToArrow(arrow::default_memory_pool());
+  EXPECT_OK(def.ExecBatchArrow(u.get(), &ctx, {v1a.get()}, output_builder.get(), size));
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(output_builder->Finish(&res).ok());
+  auto* res_arr = static_cast<arrow::Int64Array*>(res.get());
+  ASSERT_EQ(static_cast<int64_t>(size), res_arr->length());
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_EQ(static_cast<int64_t>(i * i), res_arr->Value(i));
+  }
+
+  FLAGS_carnot_udf_parallelism = parallelism;
+}
+
 TEST(UDFDefinition, arrow_write) {
   auto ctx = FunctionContext(nullptr, nullptr);
   std::vector<types::Int64Value> v1 = {1, 2, 3};
@@ -186,6 +480,65 @@ TEST(UDADefinition, arrow_output) {
   EXPECT_EQ(5, casted->Value(0));
 }
 
+class BatchSumUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg) { sum_ = sum_.val + arg.val; }
+  void UpdateBatch(udf::FunctionContext*, const types::Int64ValueColumnWrapper& args) {
+    for (size_t i = 0; i < args.Size(); ++i) {
+      sum_ = sum_.val + args[i].val;
+    }
+    ++num_batches_;
+  }
+  void UpdateBatch(udf::FunctionContext*, const SelectionVector& rows,
+                   const types::Int64ValueColumnWrapper& args) {
+    for (int64_t idx : rows) {
+      sum_ = sum_.val + args[idx].val;
+    }
+    ++num_batches_;
+  }
+  void Merge(udf::FunctionContext*, const BatchSumUDA& other) { sum_ = sum_.val + other.sum_.val; }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+
+  int num_batches() const { return num_batches_; }
+
+ protected:
+  types::Int64Value sum_ = 0;
+  int num_batches_ = 0;
+};
+
+TEST(UDADefinition, update_batch) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  UDADefinition def("batchsum");
+  EXPECT_OK(def.Init<BatchSumUDA>());
+  EXPECT_TRUE(def.has_update_batch_selection());
+
+  types::Int64ValueColumnWrapper v1({1, 2, 3, 4});
+
+  types::Int64Value out;
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatchUpdate(u.get(), &ctx, {&v1}));
+  EXPECT_OK(def.ExecBatchUpdateSelection(u.get(), &ctx, {&v1}, {1, 3}));
+  EXPECT_OK(def.FinalizeValue(u.get(), &ctx, &out));
+  EXPECT_EQ(16, out.val);
+  EXPECT_EQ(2, static_cast<BatchSumUDA*>(u.get())->num_batches());
+}
+
+TEST(UDADefinition, update_selection_without_update_batch) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  UDADefinition def("minsum");
+  EXPECT_OK(def.Init<MinSumUDA>());
+  EXPECT_FALSE(def.has_update_batch_selection());
+
+  types::Int64ValueColumnWrapper v1({1, 2, 3});
+  types::Int64ValueColumnWrapper v2({5, 1, 3});
+
+  types::Int64Value out;
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatchUpdateSelection(u.get(), &ctx, {&v1, &v2}, {0, 2}));
+  EXPECT_OK(def.FinalizeValue(u.get(), &ctx, &out));
+  EXPECT_EQ(4, out.val);
+}
+
 }  // namespace udf
 }  // namespace carnot
 }  // namespace px
@@ -36,6 +36,7 @@ using px::carnot::udf::ScalarUDF;
 using px::carnot::udf::ScalarUDFDefinition;
 using px::carnot::udf::ScalarUDFWrapper;
 using px::types::BaseValueType;
+using px::types::BoolValue;
 using px::types::Int64Value;
 using px::types::Int64ValueColumnWrapper;
 using px::types::StringValue;
@@ -57,12 +58,29 @@ class AddUDF : public ScalarUDF {
   Int64Value Exec(FunctionContext*, Int64Value v1, Int64Value v2) { return v1.val + v2.val; }
 };
 
+// AddUDF, run over raw value buffers.
+class VectorizedAddUDF : public AddUDF {
+ public:
+  static constexpr bool kVectorized = true;
+};
+
+class GreaterThanUDF : public ScalarUDF {
+ public:
+  BoolValue Exec(FunctionContext*, Int64Value v1, Int64Value v2) { return v1.val > v2.val; }
+};
+
+class VectorizedGreaterThanUDF : public GreaterThanUDF {
+ public:
+  static constexpr bool kVectorized = true;
+};
+
 class SubStrUDF : public ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue v1) { return v1.substr(1, 2); }
 };
 
 // This benchmark add two columns using Int64ValueVectors.
+template <typename TUDF>
 // NOLINTNEXTLINE : runtime/references.
 static void BM_AddInt64Values(benchmark::State& state) {
   auto vec1 = CreateLargeData<Int64Value>(state.range(0));
@@ -75,7 +93,7 @@ static void BM_AddInt64Values(benchmark::State& state) {
 
   // Create the UDF.
   ScalarUDFDefinition def("add");
-  CHECK(def.template Init<AddUDF>().ok());
+  CHECK(def.template Init<TUDF>().ok());
   auto u = def.Make();
 
   // Loop the test.
@@ -127,13 +145,14 @@ static void BM_SubStr(benchmark::State& state) {
 }
 
 // Benchmark adding two integers using arrow as the interface.
+template <typename TUDF>
 // NOLINTNEXTLINE : runtime/references.
 static void BM_AddTwoInt64sArrow(benchmark::State& state) {
   size_t size = state.range(0);
   auto arr1 = ToArrow(CreateLargeData<Int64Value>(size), arrow::default_memory_pool());
   auto arr2 = ToArrow(CreateLargeData<Int64Value>(size), arrow::default_memory_pool());
 
-  auto u = std::make_shared<AddUDF>();
+  auto u = std::make_shared<TUDF>();
   std::shared_ptr<arrow::Array> out;
   // NOLINTNEXTLINE : clang-analyzer-deadcode.DeadStores.
   for (auto _ : state) {
@@ -141,8 +160,8 @@ static void BM_AddTwoInt64sArrow(benchmark::State& state) {
       out.reset();
     }
     auto output_builder = std::make_shared<arrow::Int64Builder>();
-    auto res = ScalarUDFWrapper<AddUDF>::ExecBatchArrow(u.get(), nullptr, {arr1.get(), arr2.get()},
-                                                        output_builder.get(), size);
+    auto res = ScalarUDFWrapper<TUDF>::ExecBatchArrow(u.get(), nullptr, {arr1.get(), arr2.get()},
+                                                      output_builder.get(), size);
     CHECK(res.ok());
     CHECK(output_builder->Finish(&out).ok());
     benchmark::DoNotOptimize(out);
@@ -159,6 +178,40 @@ static void BM_AddTwoInt64sArrow(benchmark::State& state) {
   state.SetBytesProcessed(int64_t(state.iterations()) * sizeof(int64_t) * 2 * size);
 }
 
+// Benchmark comparing two integer columns, like a filter does, using arrow as the interface.
+template <typename TUDF>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_GreaterThanInt64sArrow(benchmark::State& state) {
+  size_t size = state.range(0);
+  auto arr1 = ToArrow(CreateLargeData<Int64Value>(size), arrow::default_memory_pool());
+  auto arr2 = ToArrow(CreateLargeData<Int64Value>(size), arrow::default_memory_pool());
+
+  auto u = std::make_shared<TUDF>();
+  std::shared_ptr<arrow::Array> out;
+  // NOLINTNEXTLINE : clang-analyzer-deadcode.DeadStores.
+  for (auto _ : state) {
+    if (out) {
+      out.reset();
+    }
+    auto output_builder = std::make_shared<arrow::BooleanBuilder>();
+    auto res = ScalarUDFWrapper<TUDF>::ExecBatchArrow(u.get(), nullptr, {arr1.get(), arr2.get()},
+                                                      output_builder.get(), size);
+    CHECK(res.ok());
+    CHECK(output_builder->Finish(&out).ok());
+    benchmark::DoNotOptimize(out);
+  }
+
+  // Check results.
+  auto arr1_casted = static_cast<arrow::Int64Array*>(arr1.get());
+  auto arr2_casted = static_cast<arrow::Int64Array*>(arr2.get());
+  auto out_casted = static_cast<arrow::BooleanArray*>(out.get());
+  for (size_t idx = 0; idx < size; ++idx) {
+    CHECK((arr1_casted->Value(idx) > arr2_casted->Value(idx)) == out_casted->Value(idx));
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * sizeof(int64_t) * 2 * size);
+}
+
 // Benchmark converting Int64 to Arrow.
 // NOLINTNEXTLINE : runtime/references.
 static void BM_ConvertToArrowInt64(benchmark::State& state) {
@@ -245,8 +298,16 @@ static void BM_SubStrArrow(benchmark::State& state) {
 }
 
 BENCHMARK(BM_AddInt64ValueToArrow)->RangeMultiplier(2)->Range(1, 1 << 16);
-BENCHMARK(BM_AddTwoInt64sArrow)->RangeMultiplier(2)->Range(1, 1 << 16);
-BENCHMARK(BM_AddInt64Values)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_AddTwoInt64sArrow, AddUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_AddTwoInt64sArrow, VectorizedAddUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_AddInt64Values, AddUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_AddInt64Values, VectorizedAddUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_GreaterThanInt64sArrow, GreaterThanUDF)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_GreaterThanInt64sArrow, VectorizedGreaterThanUDF)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
 
 BENCHMARK(BM_ConvertToArrowString)->RangeMultiplier(2)->Range(1, 1 << 16);
 BENCHMARK(BM_ConvertToArrowInt64)->RangeMultiplier(2)->Range(1, 1 << 16);
@@ -43,6 +43,36 @@ class ScalarUDF1WithInit : ScalarUDF {
   types::Int64Value Exec(FunctionContext*, types::BoolValue, types::BoolValue) { return 0; }
 };
 
+class VectorizedUDF : ScalarUDF {
+ public:
+  static constexpr bool kVectorized = true;
+  types::BoolValue Exec(FunctionContext*, types::Int64Value, types::Float64Value) { return false; }
+};
+
+class VectorizedStringUDF : ScalarUDF {
+ public:
+  static constexpr bool kVectorized = true;
+  types::BoolValue Exec(FunctionContext*, types::StringValue, types::StringValue) { return false; }
+};
+
+class ConditionalUDF : ScalarUDF {
+ public:
+  static constexpr bool kConditional = true;
+  types::Int64Value Exec(FunctionContext*, types::BoolValue, types::Int64Value v1,
+                         types::Int64Value) {
+    return v1;
+  }
+};
+
+class BadConditionalUDF : ScalarUDF {
+ public:
+  static constexpr bool kConditional = true;
+  types::Int64Value Exec(FunctionContext*, types::Int64Value, types::Int64Value v1,
+                         types::Int64Value) {
+    return v1;
+  }
+};
+
 TEST(ScalarUDF, basic_tests) {
   EXPECT_EQ(types::DataType::INT64, ScalarUDFTraits<ScalarUDF1>::ReturnType());
   EXPECT_THAT(ScalarUDFTraits<ScalarUDF1>::ExecArguments(),
@@ -51,6 +81,20 @@ TEST(ScalarUDF, basic_tests) {
   EXPECT_TRUE(ScalarUDFTraits<ScalarUDF1WithInit>::HasInit());
 }
 
+TEST(ScalarUDF, vectorized_traits) {
+  EXPECT_FALSE(ScalarUDFTraits<ScalarUDF1>::IsVectorized());
+  EXPECT_TRUE(ScalarUDFTraits<VectorizedUDF>::IsVectorized());
+  // Strings aren't stored as raw values, so they always go through the per row Exec.
+  EXPECT_FALSE(ScalarUDFTraits<VectorizedStringUDF>::IsVectorized());
+}
+
+TEST(ScalarUDF, conditional_traits) {
+  EXPECT_FALSE(ScalarUDFTraits<ScalarUDF1>::IsConditional());
+  EXPECT_TRUE(ScalarUDFTraits<ConditionalUDF>::IsConditional());
+  // The selector has to be a BOOLEAN.
+  EXPECT_FALSE(ScalarUDFTraits<BadConditionalUDF>::IsConditional());
+}
+
 TEST(UDFDataTypes, valid_tests) {
   EXPECT_TRUE((true == types::IsValidValueType<types::BoolValue>::value));
   EXPECT_TRUE((true == types::IsValidValueType<types::Int64Value>::value));
@@ -191,6 +235,47 @@ TEST(UDA, deserialize_fn) { EXPECT_TRUE(IsValidDeserializeFn(&UDAWithSerdes::Des
 
 TEST(UDA, serdes_uda_traits) { EXPECT_TRUE(UDATraits<UDAWithSerdes>::SupportsPartial()); }
 
+class UDAWithUpdateBatch : UDA {
+ public:
+  void Update(FunctionContext*, types::Int64Value, types::Float64Value) {}
+  void UpdateBatch(FunctionContext*, const types::Int64ValueColumnWrapper&,
+                   const types::Float64ValueColumnWrapper&) {}
+  void Merge(FunctionContext*, const UDAWithUpdateBatch&) {}
+  types::Int64Value Finalize(FunctionContext*) { return 0; }
+};
+
+class UDAWithUpdateBatchSelection : UDA {
+ public:
+  void Update(FunctionContext*, types::Int64Value) {}
+  void UpdateBatch(FunctionContext*, const types::Int64ValueColumnWrapper&) {}
+  void UpdateBatch(FunctionContext*, const SelectionVector&,
+                   const types::Int64ValueColumnWrapper&) {}
+  void Merge(FunctionContext*, const UDAWithUpdateBatchSelection&) {}
+  types::Int64Value Finalize(FunctionContext*) { return 0; }
+};
+
+class UDAWithMismatchedUpdateBatch : UDA {
+ public:
+  void Update(FunctionContext*, types::Int64Value) {}
+  void UpdateBatch(FunctionContext*, const types::Float64ValueColumnWrapper&) {}
+  void Merge(FunctionContext*, const UDAWithMismatchedUpdateBatch&) {}
+  types::Int64Value Finalize(FunctionContext*) { return 0; }
+};
+
+TEST(UDA, update_batch_traits) {
+  EXPECT_FALSE(UDATraits<UDA1>::HasUpdateBatch());
+  EXPECT_FALSE(UDATraits<UDA1>::HasUpdateBatchSelection());
+
+  EXPECT_TRUE(UDATraits<UDAWithUpdateBatch>::HasUpdateBatch());
+  EXPECT_FALSE(UDATraits<UDAWithUpdateBatch>::HasUpdateBatchSelection());
+
+  EXPECT_TRUE(UDATraits<UDAWithUpdateBatchSelection>::HasUpdateBatch());
+  EXPECT_TRUE(UDATraits<UDAWithUpdateBatchSelection>::HasUpdateBatchSelection());
+
+  // The column types have to match the Update arguments.
+  EXPECT_FALSE(UDATraits<UDAWithMismatchedUpdateBatch>::HasUpdateBatch());
+}
+
 TEST(BoolValue, value_tests) {
   // Test constructor init.
   types::BoolValue v(false);
@@ -20,16 +20,24 @@
 
 #include <arrow/array.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/udf/udf.h"
 #include "src/carnot/udf/udtf.h"
 #include "src/common/base/base.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/column_wrapper.h"
 
+DECLARE_int32(carnot_udf_parallelism);
+
 namespace px {
 namespace carnot {
 namespace udf {
@@ -116,6 +124,368 @@ Status ExecWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput*
   return Status::OK();
 }
 
+#if defined(__x86_64__)
+#define PL_UDF_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+/**
+ * Runs Exec of a vectorized UDF over raw value buffers. The loop only reads and writes plain
+ * arrays that don't alias, so the compiler turns it into SIMD code.
+ */
+template <typename TUDF, typename TOut, typename... TArgs>
+__attribute__((always_inline)) inline void ExecRawLoop(TUDF* udf, FunctionContext* ctx,
+                                                       size_t count, TOut* __restrict out,
+                                                       const TArgs* __restrict... args) {
+  for (size_t idx = 0; idx < count; ++idx) {
+    out[idx] = udf->Exec(ctx, args[idx]...).val;
+  }
+}
+
+#ifdef PL_UDF_AVX2_TARGET
+// The same loop compiled for AVX2, used when the CPU supports it even if the build targets an
+// older baseline.
+template <typename TUDF, typename TOut, typename... TArgs>
+PL_UDF_AVX2_TARGET void ExecRawAVX2(TUDF* udf, FunctionContext* ctx, size_t count, TOut* out,
+                                    const TArgs*... args) {
+  ExecRawLoop(udf, ctx, count, out, args...);
+}
+
+inline bool CPUSupportsAVX2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+#endif
+
+template <typename TUDF, typename TOut, typename... TArgs>
+void ExecRaw(TUDF* udf, FunctionContext* ctx, size_t count, TOut* out, const TArgs*... args) {
+#ifdef PL_UDF_AVX2_TARGET
+  if (CPUSupportsAVX2()) {
+    ExecRawAVX2(udf, ctx, count, out, args...);
+    return;
+  }
+#endif
+  // On ARM, NEON is part of the baseline, so this loop is vectorized with it.
+  ExecRawLoop(udf, ctx, count, out, args...);
+}
+
+template <types::DataType TDataType>
+using NativeType = typename types::DataTypeTraits<TDataType>::native_type;
+
+/**
+ * The vectorized version of ExecWrapper. Fixed size value types only hold their native value, so
+ * the value buffers are read and written as raw arrays.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecVectorizedWrapper(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                             const std::vector<const types::BaseValueType*>& args,
+                             std::index_sequence<I...>) {
+  [[maybe_unused]] constexpr auto exec_argument_types = ScalarUDFTraits<TUDF>::ExecArguments();
+  static_assert(sizeof(TOutput) == sizeof(out->val));
+  static_assert((... && (sizeof(*CastToUDFValueType<exec_argument_types[I]>(nullptr)) ==
+                         sizeof(NativeType<exec_argument_types[I]>))));
+  ExecRaw(udf, ctx, count, &out->val,
+          &CastToUDFValueType<exec_argument_types[I]>(args[I])->val...);
+  return Status::OK();
+}
+
+/**
+ * The vectorized version of ExecWrapperArrow. It reads the arrow value buffers directly, and
+ * appends all the results to the builder at once.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecVectorizedWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                                  const std::vector<arrow::Array*>& args,
+                                  std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  constexpr types::DataType return_type = ScalarUDFTraits<TUDF>::ReturnType();
+  // Arrow takes booleans as one byte per value, and packs them into its bitmap.
+  using out_type = std::conditional_t<return_type == types::DataType::BOOLEAN, uint8_t,
+                                      NativeType<return_type>>;
+  std::vector<out_type> results(count);
+  ExecRaw(udf, ctx, count, results.data(),
+          static_cast<const typename types::DataTypeTraits<
+              exec_argument_types[I]>::arrow_array_type*>(args[I])
+              ->raw_values()...);
+  PL_RETURN_IF_ERROR(out->AppendValues(results.data(), count));
+  return Status::OK();
+}
+
+/**
+ * Runs a vectorized UDF over type erased raw value buffers, holding the native values of each
+ * argument. The output holds native values too, with one byte per BOOLEAN.
+ */
+template <typename TUDF, std::size_t... I>
+void ExecRawWrapper(TUDF* udf, FunctionContext* ctx, size_t count, void* out,
+                    const std::vector<const void*>& args, std::index_sequence<I...>) {
+  [[maybe_unused]] constexpr auto exec_argument_types = ScalarUDFTraits<TUDF>::ExecArguments();
+  constexpr types::DataType return_type = ScalarUDFTraits<TUDF>::ReturnType();
+  using out_type = std::conditional_t<return_type == types::DataType::BOOLEAN, uint8_t,
+                                      NativeType<return_type>>;
+  ExecRaw(udf, ctx, count, static_cast<out_type*>(out),
+          static_cast<const NativeType<exec_argument_types[I]>*>(args[I])...);
+}
+
+/**
+ * Blends two value buffers on a selector. Both values are loaded before the select, so the
+ * compiler turns the loop into masked blends instead of a branch per row.
+ */
+template <typename TSel, typename T>
+__attribute__((always_inline)) inline void BlendLoop(size_t count, const TSel* __restrict sel,
+                                                     const T* __restrict v1,
+                                                     const T* __restrict v2, T* __restrict out) {
+  for (size_t idx = 0; idx < count; ++idx) {
+    T a = v1[idx];
+    T b = v2[idx];
+    out[idx] = sel[idx] ? a : b;
+  }
+}
+
+#ifdef PL_UDF_AVX2_TARGET
+template <typename TSel, typename T>
+PL_UDF_AVX2_TARGET void BlendAVX2(size_t count, const TSel* sel, const T* v1, const T* v2,
+                                  T* out) {
+  BlendLoop(count, sel, v1, v2, out);
+}
+#endif
+
+template <typename TSel, typename T>
+void Blend(size_t count, const TSel* sel, const T* v1, const T* v2, T* out) {
+#ifdef PL_UDF_AVX2_TARGET
+  if (CPUSupportsAVX2()) {
+    BlendAVX2(count, sel, v1, v2, out);
+    return;
+  }
+#endif
+  BlendLoop(count, sel, v1, v2, out);
+}
+
+/**
+ * The conditional version of ExecWrapper (see ScalarUDF). Fixed size values are blended on their
+ * native buffers, and strings are copied from the branch each row selects.
+ */
+template <typename TUDF, typename TOutput>
+Status ExecConditionalWrapper(size_t count, TOutput* out,
+                              const std::vector<const types::BaseValueType*>& args) {
+  constexpr types::DataType return_type = ScalarUDFTraits<TUDF>::ReturnType();
+  const auto* sel = CastToUDFValueType<types::DataType::BOOLEAN>(args[0]);
+  const auto* v1 = CastToUDFValueType<return_type>(args[1]);
+  const auto* v2 = CastToUDFValueType<return_type>(args[2]);
+  if constexpr (return_type == types::DataType::STRING) {
+    for (size_t idx = 0; idx < count; ++idx) {
+      out[idx] = sel[idx].val ? v1[idx] : v2[idx];
+    }
+  } else {
+    static_assert(sizeof(*sel) == sizeof(sel->val));
+    static_assert(sizeof(TOutput) == sizeof(out->val));
+    Blend(count, &sel->val, &v1->val, &v2->val, &out->val);
+  }
+  return Status::OK();
+}
+
+// Whether the arrow arrays of the type are blended by ExecConditionalWrapperArrow.
+constexpr bool IsConditionalArrowType(types::DataType data_type) {
+  return IsVectorizedExecType(data_type) || data_type == types::DataType::STRING;
+}
+
+/**
+ * The conditional version of ExecWrapperArrow. The selector bitmap is unpacked once, then
+ * numeric values are blended on the raw buffers and strings are gathered from the selected array,
+ * with their data reserved up front.
+ */
+template <typename TUDF, typename TOutput>
+Status ExecConditionalWrapperArrow(size_t count, TOutput* out,
+                                   const std::vector<arrow::Array*>& args) {
+  constexpr types::DataType return_type = ScalarUDFTraits<TUDF>::ReturnType();
+  static_assert(IsConditionalArrowType(return_type));
+  using array_type = typename types::DataTypeTraits<return_type>::arrow_array_type;
+  const auto* sel = static_cast<const arrow::BooleanArray*>(args[0]);
+  const auto* v1 = static_cast<const array_type*>(args[1]);
+  const auto* v2 = static_cast<const array_type*>(args[2]);
+
+  if constexpr (return_type == types::DataType::STRING) {
+    std::vector<const array_type*> srcs(count);
+    int64_t data_size = 0;
+    for (size_t idx = 0; idx < count; ++idx) {
+      srcs[idx] = sel->Value(idx) ? v1 : v2;
+      data_size += srcs[idx]->value_length(idx);
+    }
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    PL_RETURN_IF_ERROR(out->ReserveData(data_size));
+    for (size_t idx = 0; idx < count; ++idx) {
+      auto str = srcs[idx]->GetView(idx);
+      out->UnsafeAppend(str.data(), str.size());
+    }
+  } else {
+    std::vector<uint8_t> mask(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+      mask[idx] = sel->Value(idx);
+    }
+    std::vector<NativeType<return_type>> results(count);
+    Blend(count, mask.data(), v1->raw_values(), v2->raw_values(), results.data());
+    PL_RETURN_IF_ERROR(out->AppendValues(results.data(), count));
+  }
+  return Status::OK();
+}
+
+// The keys that memoized UDFs cache their results on. They point into the input, which outlives
+// the batch.
+inline absl::uint128 MemoKey(const types::UInt128Value& v) { return v.val; }
+inline std::string_view MemoKey(const types::StringValue& v) { return v; }
+inline absl::uint128 MemoKey(const arrow::UInt128Array* arr, int64_t idx) {
+  return arr->Value(idx);
+}
+inline std::string_view MemoKey(const arrow::StringArray* arr, int64_t idx) {
+  return arr->GetView(idx);
+}
+
+/**
+ * The memoized version of ExecWrapper. Exec runs on the first row with each distinct argument,
+ * and the later rows copy its result.
+ */
+template <typename TUDF, typename TOutput>
+Status ExecMemoizedWrapper(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                           const std::vector<const types::BaseValueType*>& args) {
+  constexpr types::DataType arg_type = ScalarUDFTraits<TUDF>::ExecArguments()[0];
+  const auto* in = CastToUDFValueType<arg_type>(args[0]);
+  using key_type = decltype(MemoKey(in[0]));
+  if constexpr (ScalarUDFTraits<TUDF>::HasPrefetch()) {
+    absl::flat_hash_set<key_type> keys;
+    for (size_t idx = 0; idx < count; ++idx) {
+      keys.insert(MemoKey(in[idx]));
+    }
+    udf->Prefetch(ctx, std::vector<key_type>(keys.begin(), keys.end()));
+  }
+  absl::flat_hash_map<key_type, size_t> first_rows;
+  for (size_t idx = 0; idx < count; ++idx) {
+    auto [it, inserted] = first_rows.try_emplace(MemoKey(in[idx]), idx);
+    if (inserted) {
+      out[idx] = udf->Exec(ctx, in[idx]);
+    } else {
+      out[idx] = out[it->second];
+    }
+  }
+  return Status::OK();
+}
+
+/**
+ * The memoized version of ExecWrapperArrow.
+ */
+template <typename TUDF, typename TOutput>
+Status ExecMemoizedWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                                const std::vector<arrow::Array*>& args) {
+  constexpr types::DataType arg_type = ScalarUDFTraits<TUDF>::ExecArguments()[0];
+  const auto* in =
+      static_cast<const typename types::DataTypeTraits<arg_type>::arrow_array_type*>(args[0]);
+  using result_type = decltype(UnWrap(udf->Exec(ctx, types::GetValue(in, 0))));
+  using key_type = decltype(MemoKey(in, 0));
+  if constexpr (ScalarUDFTraits<TUDF>::HasPrefetch()) {
+    absl::flat_hash_set<key_type> keys;
+    for (size_t idx = 0; idx < count; ++idx) {
+      keys.insert(MemoKey(in, idx));
+    }
+    udf->Prefetch(ctx, std::vector<key_type>(keys.begin(), keys.end()));
+  }
+
+  absl::flat_hash_map<key_type, size_t> result_idxs;
+  std::vector<result_type> results;
+  PL_RETURN_IF_ERROR(out->Reserve(count));
+  for (size_t idx = 0; idx < count; ++idx) {
+    auto [it, inserted] = result_idxs.try_emplace(MemoKey(in, idx), results.size());
+    if (inserted) {
+      results.push_back(UnWrap(udf->Exec(ctx, types::GetValue(in, idx))));
+    }
+    PL_RETURN_IF_ERROR(out->Append(results[it->second]));
+  }
+  return Status::OK();
+}
+
+/**
+ * Runs the ExecArrow kernel of the UDF over the whole batch (see ScalarUDF).
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecArrowKernelWrapper(TUDF* udf, FunctionContext* ctx, TOutput* out,
+                              const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  return udf->ExecArrow(
+      ctx,
+      *static_cast<const typename types::DataTypeTraits<exec_argument_types[I]>::arrow_array_type*>(
+          args[I])...,
+      out);
+}
+
+// Batches of parallel UDFs are only split when each thread gets at least this many rows.
+constexpr size_t kMinRowsPerUDFThread = 256;
+
+/**
+ * Calls fn(begin, end) on ranges of rows that split [0, count) across up to
+ * --carnot_udf_parallelism threads.
+ */
+template <typename TFn>
+void ParallelForRows(size_t count, TFn fn) {
+  size_t max_threads = std::max(FLAGS_carnot_udf_parallelism, 1);
+  size_t num_threads = std::clamp<size_t>(count / kMinRowsPerUDFThread, 1, max_threads);
+  if (num_threads == 1) {
+    fn(0, count);
+    return;
+  }
+  size_t rows_per_thread = (count + num_threads - 1) / num_threads;
+  std::vector<std::thread> threads;
+  for (size_t begin = 0; begin < count; begin += rows_per_thread) {
+    threads.emplace_back(fn, begin, std::min(count, begin + rows_per_thread));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+/**
+ * The parallel version of ExecWrapper. The output is preallocated, so each thread writes its
+ * own rows of it.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecParallelWrapper(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                           const std::vector<const types::BaseValueType*>& args,
+                           std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  ParallelForRows(count, [&](size_t begin, size_t end) {
+    for (size_t idx = begin; idx < end; ++idx) {
+      out[idx] = udf->Exec(ctx, CastToUDFValueType<exec_argument_types[I]>(args[I])[idx]...);
+    }
+  });
+  return Status::OK();
+}
+
+/**
+ * The parallel version of ExecWrapperArrow. The results are appended to the builder once all the
+ * threads are done.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecParallelWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                                const std::vector<arrow::Array*>& args,
+                                std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  using result_type = decltype(UnWrap(
+      udf->Exec(ctx, types::GetValueFromArrowArray<exec_argument_types[I]>(args[I], 0)...)));
+  // std::vector<bool> packs its values, so its elements can't be written concurrently.
+  using stored_type = std::conditional_t<std::is_same_v<result_type, bool>, uint8_t, result_type>;
+  std::vector<stored_type> results(count);
+  ParallelForRows(count, [&](size_t begin, size_t end) {
+    for (size_t idx = begin; idx < end; ++idx) {
+      results[idx] = UnWrap(
+          udf->Exec(ctx, types::GetValueFromArrowArray<exec_argument_types[I]>(args[I], idx)...));
+    }
+  });
+  PL_RETURN_IF_ERROR(out->Reserve(count));
+  for (const auto& res : results) {
+    PL_RETURN_IF_ERROR(out->Append(res));
+  }
+  return Status::OK();
+}
+
 /**
  * Checks types between column wrapper and array of types::UDFDataTypes.
  * @return true if all types match.
@@ -181,13 +551,47 @@ struct ScalarUDFWrapper {
     // Check that the arity is correct.
     DCHECK(inputs.size() == ScalarUDFTraits<TUDF>::ExecArguments().size());
 
+    auto* casted_output =
+        static_cast<typename types::DataTypeTraits<return_type>::arrow_builder_type*>(output);
+    if constexpr (ScalarUDFTraits<TUDF>::HasArrowKernel()) {
+      return ExecArrowKernelWrapper<TUDF>(static_cast<TUDF*>(udf), ctx, casted_output, inputs,
+                                          std::make_index_sequence<exec_argument_types.size()>{});
+    }
+    if constexpr (ScalarUDFTraits<TUDF>::IsConditional() && IsConditionalArrowType(return_type)) {
+      return ExecConditionalWrapperArrow<TUDF>(count, casted_output, inputs);
+    }
+    if constexpr (ScalarUDFTraits<TUDF>::IsVectorized()) {
+      return ExecVectorizedWrapperArrow<TUDF>(
+          static_cast<TUDF*>(udf), ctx, count, casted_output, inputs,
+          std::make_index_sequence<exec_argument_types.size()>{});
+    }
+    if constexpr (ScalarUDFTraits<TUDF>::IsMemoized()) {
+      return ExecMemoizedWrapperArrow<TUDF>(static_cast<TUDF*>(udf), ctx, count, casted_output,
+                                            inputs);
+    }
+    if constexpr (ScalarUDFTraits<TUDF>::IsParallel()) {
+      return ExecParallelWrapperArrow<TUDF>(
+          static_cast<TUDF*>(udf), ctx, count, casted_output, inputs,
+          std::make_index_sequence<exec_argument_types.size()>{});
+    }
     // The outer wrapper just casts the output type and UDF type. We then pass in
     // the inputs with a sequence based on the number of arguments to iterate through and
     // cast the inputs.
-    return ExecWrapperArrow<TUDF>(
-        static_cast<TUDF*>(udf), ctx, count,
-        static_cast<typename types::DataTypeTraits<return_type>::arrow_builder_type*>(output),
-        inputs, std::make_index_sequence<exec_argument_types.size()>{});
+    return ExecWrapperArrow<TUDF>(static_cast<TUDF*>(udf), ctx, count, casted_output, inputs,
+                                  std::make_index_sequence<exec_argument_types.size()>{});
+  }
+
+  /**
+   * Executes a vectorized UDF on raw value buffers (see ExecRawWrapper). This is only
+   * instantiated for UDFs where ScalarUDFTraits::IsVectorized() is true.
+   */
+  static void ExecBatchRaw(ScalarUDF* udf, FunctionContext* ctx,
+                           const std::vector<const void*>& inputs, void* output, int count) {
+    static_assert(ScalarUDFTraits<TUDF>::IsVectorized());
+    DCHECK(inputs.size() == ScalarUDFTraits<TUDF>::ExecArguments().size());
+    ExecRawWrapper<TUDF>(
+        static_cast<TUDF*>(udf), ctx, count, output, inputs,
+        std::make_index_sequence<ScalarUDFTraits<TUDF>::ExecArguments().size()>{});
   }
 
   /**
@@ -222,6 +626,23 @@ struct ScalarUDFWrapper {
 
     using output_type = typename types::DataTypeTraits<return_type>::value_type;
     auto* casted_output = static_cast<output_type*>(output->UnsafeRawData());
+    if constexpr (ScalarUDFTraits<TUDF>::IsConditional()) {
+      return ExecConditionalWrapper<TUDF>(count, casted_output, input_as_base_value);
+    }
+    if constexpr (ScalarUDFTraits<TUDF>::IsVectorized()) {
+      return ExecVectorizedWrapper<TUDF>(static_cast<TUDF*>(udf), ctx, count, casted_output,
+                                         input_as_base_value,
+                                         std::make_index_sequence<exec_argument_types.size()>{});
+    }
+    if constexpr (ScalarUDFTraits<TUDF>::IsMemoized()) {
+      return ExecMemoizedWrapper<TUDF>(static_cast<TUDF*>(udf), ctx, count, casted_output,
+                                       input_as_base_value);
+    }
+    if constexpr (ScalarUDFTraits<TUDF>::IsParallel()) {
+      return ExecParallelWrapper<TUDF>(static_cast<TUDF*>(udf), ctx, count, casted_output,
+                                       input_as_base_value,
+                                       std::make_index_sequence<exec_argument_types.size()>{});
+    }
     // The outer wrapper just casts the output type and UDF type. We then pass in
     // the inputs with a sequence based on the number of arguments to iterate through and
     // cast the inputs.
@@ -246,6 +667,49 @@ Status UpdateWrapper(TUDA* uda, FunctionContext* ctx, size_t count,
   return Status::OK();
 }
 
+/**
+ * Performs an update on the selected records of a batch.
+ */
+template <typename TUDA, std::size_t... I>
+Status UpdateSelectionWrapper(TUDA* uda, FunctionContext* ctx, const SelectionVector& rows,
+                              const std::vector<const types::BaseValueType*>& args,
+                              std::index_sequence<I...>) {
+  constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  for (int64_t idx : rows) {
+    uda->Update(ctx, CastToUDFValueType<update_argument_types[I]>(args[I])[idx]...);
+  }
+  return Status::OK();
+}
+
+/**
+ * Calls the UpdateBatch function of the UDA on whole columns.
+ */
+template <typename TUDA, std::size_t... I>
+Status UpdateBatchWrapper(TUDA* uda, FunctionContext* ctx,
+                          const std::vector<const types::ColumnWrapper*>& args,
+                          std::index_sequence<I...>) {
+  constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  uda->UpdateBatch(
+      ctx, *static_cast<const typename types::ColumnWrapperType<update_argument_types[I]>::type*>(
+               args[I])...);
+  return Status::OK();
+}
+
+/**
+ * Calls the UpdateBatch function of the UDA on the selected rows of the columns.
+ */
+template <typename TUDA, std::size_t... I>
+Status UpdateBatchSelectionWrapper(TUDA* uda, FunctionContext* ctx, const SelectionVector& rows,
+                                   const std::vector<const types::ColumnWrapper*>& args,
+                                   std::index_sequence<I...>) {
+  constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  uda->UpdateBatch(
+      ctx, rows,
+      *static_cast<const typename types::ColumnWrapperType<update_argument_types[I]>::type*>(
+          args[I])...);
+  return Status::OK();
+}
+
 /**
  * Performs an update on a batch of records (arrow).
  * This is similar to the ExecBatch, except it does not store a return value.
@@ -268,6 +732,8 @@ template <typename TUDA>
 struct UDAWrapper {
   static constexpr types::DataType return_type = UDATraits<TUDA>::FinalizeReturnType();
   static constexpr bool SupportsPartial = UDATraits<TUDA>::SupportsPartial();
+  static constexpr bool HasUpdateBatch = UDATraits<TUDA>::HasUpdateBatch();
+  static constexpr bool HasUpdateBatchSelection = UDATraits<TUDA>::HasUpdateBatchSelection();
 
   /**
    * Create a new UDA.
@@ -288,6 +754,11 @@ struct UDAWrapper {
     DCHECK(CheckTypes(inputs, update_argument_types));
     DCHECK(inputs.size() == update_argument_types.size());
 
+    if constexpr (HasUpdateBatch) {
+      return UpdateBatchWrapper<TUDA>(static_cast<TUDA*>(uda), ctx, inputs,
+                                      std::make_index_sequence<update_argument_types.size()>{});
+    }
+
     auto input_as_base_value = ConvertToBaseValue(inputs);
 
     size_t num_records = inputs[0]->Size();
@@ -295,6 +766,34 @@ struct UDAWrapper {
                                std::make_index_sequence<update_argument_types.size()>{});
   }
 
+  /**
+   * Perform a batch update of the passed in UDA on the selected rows of the inputs.
+   * Falls back to calling Update on each selected row if the UDA doesn't implement the
+   * selection UpdateBatch.
+   * @param uda The UDA instances.
+   * @param ctx The function context.
+   * @param inputs A vector of pointers to types::ColumnWrappers.
+   * @param rows The indices of the rows of the inputs to update on.
+   * @return Status of update.
+   */
+  static Status ExecBatchUpdateSelection(UDA* uda, FunctionContext* ctx,
+                                         const std::vector<const types::ColumnWrapper*>& inputs,
+                                         const SelectionVector& rows) {
+    constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+    DCHECK(CheckTypes(inputs, update_argument_types));
+    DCHECK(inputs.size() == update_argument_types.size());
+
+    if constexpr (HasUpdateBatchSelection) {
+      return UpdateBatchSelectionWrapper<TUDA>(
+          static_cast<TUDA*>(uda), ctx, rows, inputs,
+          std::make_index_sequence<update_argument_types.size()>{});
+    }
+
+    return UpdateSelectionWrapper<TUDA>(static_cast<TUDA*>(uda), ctx, rows,
+                                        ConvertToBaseValue(inputs),
+                                        std::make_index_sequence<update_argument_types.size()>{});
+  }
+
   /**
    * Perform a batch update of the passed in UDA based in the inputs.
    * @param uda The UDA instances.
@@ -323,6 +822,35 @@ struct UDAWrapper {
     return Status::OK();
   }
 
+  /**
+   * Serializes the partial state of the UDA, so that it can be merged elsewhere.
+   * @return The serialized state, or an error if the UDA doesn't support partial aggregation.
+   */
+  static StatusOr<types::StringValue> Serialize(UDA* uda, FunctionContext* ctx) {
+    if constexpr (SupportsPartial) {
+      return static_cast<TUDA*>(uda)->Serialize(ctx);
+    } else {
+      PL_UNUSED(uda);
+      PL_UNUSED(ctx);
+      return error::Unimplemented("UDA doesn't support partial aggregation.");
+    }
+  }
+
+  /**
+   * Replaces the state of the UDA with a state produced by Serialize.
+   * @return Status of the Deserialize.
+   */
+  static Status Deserialize(UDA* uda, FunctionContext* ctx, const types::StringValue& data) {
+    if constexpr (SupportsPartial) {
+      return static_cast<TUDA*>(uda)->Deserialize(ctx, data);
+    } else {
+      PL_UNUSED(uda);
+      PL_UNUSED(ctx);
+      PL_UNUSED(data);
+      return error::Unimplemented("UDA doesn't support partial aggregation.");
+    }
+  }
+
   /**
    * Finalize the UDA into an arrow builder. The arrow builder needs to be correct type
    * for the finalize return type.
@@ -397,14 +925,27 @@ struct UDTFWrapper {
     }
 
     auto* u = static_cast<TUDTF*>(udtf);
-    int count = 0;
-    bool more = true;
     RecordWriterProxy<TUDTF> rw(outputs);
-    while (count < max_gen_records && more) {
-      more = u->NextRecord(ctx, &rw);
-      ++count;
+    if constexpr (UDTFTraits<TUDTF>::HasNextBatchFn()) {
+      return u->NextBatch(ctx, max_gen_records, &rw);
+    } else {
+      int count = 0;
+      bool more = true;
+      while (count < max_gen_records && more) {
+        more = u->NextRecord(ctx, &rw);
+        ++count;
+      }
+      return more;
+    }
+  }
+
+  static StatusOr<bool> Ready(AnyUDTF* udtf, FunctionContext* ctx) {
+    if constexpr (UDTFTraits<TUDTF>::HasReadyFn()) {
+      return static_cast<TUDTF*>(udtf)->Ready(ctx);
     }
-    return more;
+    PL_UNUSED(udtf);
+    PL_UNUSED(ctx);
+    return true;
   }
 
  private:
@@ -254,6 +254,18 @@ class UDTFTraits {
    */
   static constexpr bool HasNextRecordFn() { return NextRecordFnHelper<TUDTF>::value; }
 
+  /**
+   * Checks to see if NextBatch() exists.
+   * @return
+   */
+  static constexpr bool HasNextBatchFn() { return NextBatchFnHelper<TUDTF>::value; }
+
+  /**
+   * Checks to see if Ready() exists.
+   * @return
+   */
+  static constexpr bool HasReadyFn() { return ReadyFnHelper<TUDTF>::value; }
+
   template <typename Q = TUDTF, std::enable_if_t<UDTFTraits<Q>::HasInitArgsFn(), void>* = nullptr>
   static constexpr auto InitArguments() {
     return Q::InitArgs();
@@ -373,6 +385,24 @@ class UDTFTraits {
   struct NextRecordFnHelper<
       T, std::void_t<decltype (&T::NextRecord)(FunctionContext*, typename T::RecordWriter*)>>
       : std::true_type {};
+
+  template <typename T, typename = void>
+  struct NextBatchFnHelper : std::false_type {};
+
+  template <typename T>
+  struct NextBatchFnHelper<
+      T, std::enable_if_t<std::is_same_v<decltype(std::declval<T>().NextBatch(
+                                             std::declval<FunctionContext*>(), std::declval<int>(),
+                                             std::declval<typename T::RecordWriter*>())),
+                                         bool>>> : std::true_type {};
+
+  template <typename T, typename = void>
+  struct ReadyFnHelper : std::false_type {};
+
+  template <typename T>
+  struct ReadyFnHelper<T, std::enable_if_t<std::is_same_v<
+                              decltype(std::declval<T>().Ready(std::declval<FunctionContext*>())),
+                              StatusOr<bool>>>> : std::true_type {};
 };
 
 /**
@@ -483,10 +513,11 @@ struct UDTFChecker {
   // Check that Executor exists and returns the executor type.
   static_assert(TR::HasExecutorFn(), "UDTF must have an Executor() func");
   static_assert(TR::HasCorrectExectorFnReturnType(), "Executor() must return UDTFSourceExecutor");
-  // Check that NextRecord exists and is well formed.
-  static_assert(
-      TR::HasNextRecordFn(),
-      "UDTF must have NextRecord func of form NextRecord(FunctionContext, RecordWriterProxy*)");
+  // Check that NextRecord or NextBatch exists and is well formed.
+  static_assert(TR::HasNextRecordFn() || TR::HasNextBatchFn(),
+                "UDTF must have NextRecord func of form NextRecord(FunctionContext, "
+                "RecordWriterProxy*) or NextBatch func of form NextBatch(FunctionContext, int, "
+                "RecordWriterProxy*)");
 };
 
 /**
@@ -531,6 +562,17 @@ struct UDTFChecker {
  *     int64_t count_ = 0;
  *   }
  *
+ * Instead of NextRecord, a UDTF can define NextBatch, which writes up to max_records records and
+ * returns whether there are more:
+ *
+ *     bool NextBatch(FunctionContext *, int max_records, RecordWriter *rw);
+ *
+ * A UDTF whose Init starts work that completes in the background (such as an RPC) can also
+ * define Ready. The UDTF source won't produce records until it returns true, and an error
+ * fails the query:
+ *
+ *     StatusOr<bool> Ready(FunctionContext *);
+ *
  * @tparam Derived The name of the derived class.
  */
 template <typename Derived>
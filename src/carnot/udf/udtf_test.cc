@@ -184,6 +184,58 @@ TEST(BasicUDTFOneCol, can_run) {
   EXPECT_EQ(out->GetString(1), "abc 2");
 }
 
+class BatchUDTFOneCol : public UDTF<BatchUDTFOneCol> {
+ public:
+  static constexpr auto Executor() { return udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(
+        ColInfo("out_int", types::DataType::INT64, types::PatternType::GENERAL, "int result"));
+  }
+
+  StatusOr<bool> Ready(FunctionContext*) { return true; }
+
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    for (int i = 0; i < max_records && idx < 5; ++i, ++idx) {
+      rw->Append<IndexOf("out_int")>(idx);
+    }
+    return idx < 5;
+  }
+
+ private:
+  int idx = 0;
+};
+
+TEST(BatchUDTFOneCol, writes_up_to_max_records) {
+  using TR = UDTFTraits<BatchUDTFOneCol>;
+  constexpr BatchUDTFOneCol::Checker check;
+  PL_UNUSED(check);
+
+  EXPECT_FALSE(TR::HasNextRecordFn());
+  EXPECT_TRUE(TR::HasNextBatchFn());
+  EXPECT_TRUE(TR::HasReadyFn());
+  EXPECT_FALSE(UDTFTraits<BasicUDTFOneCol>::HasNextBatchFn());
+  EXPECT_FALSE(UDTFTraits<BasicUDTFOneCol>::HasReadyFn());
+
+  UDTFWrapper<BatchUDTFOneCol> wrapper;
+  auto u = wrapper.Make();
+  EXPECT_OK(wrapper.Init(u.get(), nullptr, {}));
+  EXPECT_OK_AND_EQ(wrapper.Ready(u.get(), nullptr), true);
+
+  arrow::Int64Builder int64_builder(0);
+  std::vector<arrow::ArrayBuilder*> outs{&int64_builder};
+  EXPECT_TRUE(wrapper.ExecBatchUpdate(u.get(), nullptr, 3, &outs));
+  EXPECT_EQ(3, int64_builder.length());
+  EXPECT_FALSE(wrapper.ExecBatchUpdate(u.get(), nullptr, 3, &outs));
+
+  std::shared_ptr<arrow::Int64Array> out;
+  EXPECT_TRUE(int64_builder.Finish(&out).ok());
+  ASSERT_EQ(out->length(), 5);
+  for (int64_t i = 0; i < out->length(); ++i) {
+    EXPECT_EQ(i, out->Value(i));
+  }
+}
+
 class BasicUDTFTwoColBad : public UDTF<BasicUDTFTwoColBad> {
  public:
   static constexpr auto Executor() { return udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
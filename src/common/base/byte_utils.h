@@ -20,6 +20,7 @@
 
 #include <cstring>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "src/common/base/logging.h"
@@ -128,6 +129,22 @@ T BEndianBytesToInt(std::string_view buf) {
   // Source buffer must have enough bytes.
   DCHECK_GE(buf.size(), N);
 
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // Whole ints are loaded at once and byte swapped, which the byte loop below isn't always
+  // compiled into.
+  if constexpr (std::is_integral_v<T> && N == sizeof(T) && (N == 2 || N == 4 || N == 8)) {
+    std::make_unsigned_t<T> val;
+    std::memcpy(&val, buf.data(), N);
+    if constexpr (N == 2) {
+      return static_cast<T>(__builtin_bswap16(val));
+    } else if constexpr (N == 4) {
+      return static_cast<T>(__builtin_bswap32(val));
+    } else {
+      return static_cast<T>(__builtin_bswap64(val));
+    }
+  }
+#endif
+
   T result = 0;
   for (size_t i = 0; i < N; i++) {
     result = static_cast<uint8_t>(buf[i]) | (result << 8);
@@ -62,6 +62,7 @@ Status Exists(const std::filesystem::path& path);
 Status Copy(const std::filesystem::path& from, const std::filesystem::path& to,
             std::filesystem::copy_options options = std::filesystem::copy_options::none);
 Status Remove(const std::filesystem::path& f);
+Status Rename(const std::filesystem::path& from, const std::filesystem::path& to);
 
 StatusOr<bool> IsEmpty(const std::filesystem::path& f);
 
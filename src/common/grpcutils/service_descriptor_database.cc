@@ -45,24 +45,36 @@ ServiceDescriptorDatabase::ServiceDescriptorDatabase(FileDescriptorSet fdset)
 }
 
 MethodInputOutput ServiceDescriptorDatabase::GetMethodInputOutput(const std::string& method_path) {
-  const MethodDescriptor* method = desc_pool_.FindMethodByName(method_path);
-  if (method == nullptr) {
-    return {nullptr, nullptr};
-  }
+  MethodPrototypes prototypes = GetMethodPrototypes(method_path);
 
   MethodInputOutput res;
-
-  const Message* input_prototype = message_factory_.GetPrototype(method->input_type());
-  if (input_prototype != nullptr) {
-    res.input.reset(input_prototype->New());
+  if (prototypes.input != nullptr) {
+    res.input.reset(prototypes.input->New());
   }
-  const Message* output_prototype = message_factory_.GetPrototype(method->output_type());
-  if (output_prototype != nullptr) {
-    res.output.reset(output_prototype->New());
+  if (prototypes.output != nullptr) {
+    res.output.reset(prototypes.output->New());
   }
   return res;
 }
 
+MethodPrototypes ServiceDescriptorDatabase::GetMethodPrototypes(const std::string& method_path) {
+  auto iter = method_prototypes_.find(method_path);
+  if (iter != method_prototypes_.end()) {
+    return iter->second;
+  }
+
+  const MethodDescriptor* method = desc_pool_.FindMethodByName(method_path);
+  if (method == nullptr) {
+    // Not memoized, the method paths that aren't found may come from anywhere.
+    return {};
+  }
+  MethodPrototypes prototypes;
+  prototypes.input = message_factory_.GetPrototype(method->input_type());
+  prototypes.output = message_factory_.GetPrototype(method->output_type());
+  method_prototypes_.emplace(method_path, prototypes);
+  return prototypes;
+}
+
 std::unique_ptr<Message> ServiceDescriptorDatabase::GetMessage(const std::string& message_path) {
   const Descriptor* msg_desc = desc_pool_.FindMessageTypeByName(message_path);
   if (msg_desc == nullptr) {
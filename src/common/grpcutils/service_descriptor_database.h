@@ -29,6 +29,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/base/base.h"
 
 namespace px {
@@ -39,8 +41,17 @@ struct MethodInputOutput {
   std::unique_ptr<google::protobuf::Message> output;
 };
 
+// The prototypes of the input and output types of a method. They live as long as the database
+// that returned them, and are what the messages of these types are created from, with New().
+struct MethodPrototypes {
+  const google::protobuf::Message* input = nullptr;
+  const google::protobuf::Message* output = nullptr;
+};
+
 /**
  * @brief Indexes services and the descriptors of their methods' input and output protobuf messages.
+ *
+ * Not thread-safe.
  */
 class ServiceDescriptorDatabase {
  public:
@@ -54,6 +65,15 @@ class ServiceDescriptorDatabase {
    */
   MethodInputOutput GetMethodInputOutput(const std::string& method_path);
 
+  /**
+   * @brief Returns the prototypes of the input and output type of the method. The methods that
+   * are found are memoized, so looking one up again doesn't go through the descriptor pool.
+   *
+   * @param method_path A dot-separated name including the service name.
+   * @return Null prototypes if the method is not found.
+   */
+  MethodPrototypes GetMethodPrototypes(const std::string& method_path);
+
   /**
    * @brief Returns an empty instance of the message specified by the input path.
    *
@@ -76,6 +96,7 @@ class ServiceDescriptorDatabase {
   google::protobuf::SimpleDescriptorDatabase desc_db_;
   google::protobuf::DescriptorPool desc_pool_;
   google::protobuf::DynamicMessageFactory message_factory_;
+  absl::flat_hash_map<std::string, MethodPrototypes> method_prototypes_;
 };
 
 // TODO(yzhao): Benchmark dynamic message parsing.
@@ -102,6 +102,25 @@ TEST_F(ServiceDescriptorDatabaseTest, GetInputOutput) {
   EXPECT_THAT(*in_out.output, EqualsProto(kExpectedRespInText));
 }
 
+TEST_F(ServiceDescriptorDatabaseTest, GetMethodPrototypes) {
+  MethodPrototypes prototypes = db_->GetMethodPrototypes("hipstershop.CheckoutService.PlaceOrder");
+  ASSERT_NE(nullptr, prototypes.input);
+  ASSERT_NE(nullptr, prototypes.output);
+  EXPECT_EQ("hipstershop.PlaceOrderRequest", prototypes.input->GetDescriptor()->full_name());
+  EXPECT_EQ("hipstershop.PlaceOrderResponse", prototypes.output->GetDescriptor()->full_name());
+
+  // The same prototypes every time, and the messages of the method are created from them.
+  MethodPrototypes again = db_->GetMethodPrototypes("hipstershop.CheckoutService.PlaceOrder");
+  EXPECT_EQ(prototypes.input, again.input);
+  EXPECT_EQ(prototypes.output, again.output);
+  MethodInputOutput in_out = db_->GetMethodInputOutput("hipstershop.CheckoutService.PlaceOrder");
+  EXPECT_EQ(prototypes.input->GetDescriptor(), in_out.input->GetDescriptor());
+
+  MethodPrototypes unknown = db_->GetMethodPrototypes("hipstershop.CheckoutService.NoSuchMethod");
+  EXPECT_EQ(nullptr, unknown.input);
+  EXPECT_EQ(nullptr, unknown.output);
+}
+
 TEST_F(ServiceDescriptorDatabaseTest, GetMessage) {
   std::unique_ptr<Message> msg = db_->GetMessage("hipstershop.PlaceOrderRequest");
   ASSERT_NE(nullptr, msg);
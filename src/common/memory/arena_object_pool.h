@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+
+/**
+ * An ObjectPool variant that constructs its objects in place in large chunks of memory, instead
+ * of taking ownership of individually allocated ones. Everything is freed at once by Clear() or
+ * on destruction. Destructors are only recorded (and run, in reverse order of construction) for
+ * types that are not trivially destructible.
+ *
+ * Unlike ObjectPool, this is not thread-safe. It is meant for the many small objects that a
+ * single operator creates, eg. the per-group state of an aggregate.
+ */
+class ArenaObjectPool final : public px::NotCopyable {
+ public:
+  static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+  explicit ArenaObjectPool(std::string_view name = "", size_t chunk_size = kDefaultChunkSize)
+      : name_(name), chunk_size_(chunk_size) {
+    VLOG_IF(1, !name_.empty()) << "Creating Arena Object Pool: " << name_;
+  }
+
+  ~ArenaObjectPool() {
+    Clear();
+    VLOG_IF(1, !name_.empty()) << "Deleting Arena Object Pool: " << name_;
+  }
+
+  /**
+   * Constructs a T from the given arguments in the pool.
+   *
+   * @return The pointer to the new object, which is owned by the pool.
+   */
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported.");
+    T* obj = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors_.emplace_back(Destructor{obj, [](void* p) { static_cast<T*>(p)->~T(); }});
+    }
+    return obj;
+  }
+
+  /**
+   * Destroys all the objects and frees all but the first chunk, which is kept for reuse.
+   */
+  void Clear() {
+    for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+      it->destroy_fn(it->obj);
+    }
+    destructors_.clear();
+    if (chunks_.size() > 1) {
+      chunks_.resize(1);
+      bytes_allocated_ = chunks_[0].size;
+    }
+    chunk_used_ = 0;
+  }
+
+  /**
+   * The number of bytes of memory held in chunks.
+   */
+  size_t bytes_allocated() const { return bytes_allocated_; }
+
+ private:
+  void* Allocate(size_t size, size_t align) {
+    size_t offset = (chunk_used_ + align - 1) & ~(align - 1);
+    if (chunks_.empty() || offset + size > chunks_.back().size) {
+      // Objects larger than a chunk get a chunk of their own. The chunk isn't zeroed.
+      size_t chunk_size = std::max(chunk_size_, size);
+      chunks_.push_back(Chunk{std::unique_ptr<char[]>(new char[chunk_size]), chunk_size});
+      bytes_allocated_ += chunk_size;
+      offset = 0;
+    }
+    chunk_used_ = offset + size;
+    return chunks_.back().data.get() + offset;
+  }
+
+  // A generic destruction function pointer. Runs the destructor of its first argument.
+  using DestroyFn = void (*)(void*);
+
+  struct Destructor {
+    void* obj;
+    DestroyFn destroy_fn;
+  };
+
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  const std::string name_;
+  const size_t chunk_size_;
+  std::vector<Chunk> chunks_;
+  // The number of bytes used in the last chunk.
+  size_t chunk_used_ = 0;
+  size_t bytes_allocated_ = 0;
+  std::vector<Destructor> destructors_;
+};
+
+}  // namespace px
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/memory/arena_object_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace px {
+
+class CountedObject {
+ public:
+  CountedObject(int* destroy_count, std::vector<int>* destroy_order, int id)
+      : destroy_count_(destroy_count), destroy_order_(destroy_order), id_(id) {}
+  ~CountedObject() {
+    (*destroy_count_)++;
+    destroy_order_->push_back(id_);
+  }
+
+ private:
+  int* destroy_count_;
+  std::vector<int>* destroy_order_;
+  int id_;
+};
+
+TEST(ArenaObjectPoolTest, destroys_objects_in_reverse_order) {
+  int count = 0;
+  std::vector<int> order;
+  {
+    ArenaObjectPool pool;
+    pool.New<CountedObject>(&count, &order, 1);
+    pool.New<CountedObject>(&count, &order, 2);
+    pool.New<CountedObject>(&count, &order, 3);
+    EXPECT_EQ(0, count);
+  }
+  EXPECT_EQ(3, count);
+  EXPECT_EQ(std::vector<int>({3, 2, 1}), order);
+}
+
+TEST(ArenaObjectPoolTest, clear_keeps_first_chunk) {
+  int count = 0;
+  std::vector<int> order;
+  ArenaObjectPool pool("test", /* chunk_size */ 256);
+  for (int i = 0; i < 100; ++i) {
+    pool.New<CountedObject>(&count, &order, i);
+  }
+  EXPECT_GT(pool.bytes_allocated(), 256);
+
+  pool.Clear();
+  EXPECT_EQ(100, count);
+  EXPECT_EQ(256, pool.bytes_allocated());
+
+  // The kept chunk is reused.
+  pool.New<CountedObject>(&count, &order, 0);
+  EXPECT_EQ(256, pool.bytes_allocated());
+}
+
+TEST(ArenaObjectPoolTest, alignment_and_large_objects) {
+  ArenaObjectPool pool("test", /* chunk_size */ 64);
+  char* c = pool.New<char>('a');
+  double* d = pool.New<double>(1.5);
+  EXPECT_EQ('a', *c);
+  EXPECT_EQ(1.5, *d);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(d) % alignof(double));
+
+  // Larger than a chunk.
+  auto* str = pool.New<std::string>(1000, 'x');
+  auto* big = pool.New<std::array<char, 200>>();
+  EXPECT_EQ(1000, str->size());
+  EXPECT_EQ(200, big->size());
+}
+
+}  // namespace px
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/metrics/metrics_registry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+
+namespace px {
+namespace metrics {
+
+int64_t Counter::Value() const {
+  int64_t value = 0;
+  for (const auto& shard : shards_) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+Histogram::Histogram(std::vector<int64_t> bounds)
+    : bounds_(std::move(bounds)),
+      buckets_(std::make_unique<std::atomic<int64_t>[]>(bounds_.size() + 1)) {
+  DCHECK(std::is_sorted(bounds_.begin(), bounds_.end()));
+}
+
+void Histogram::Observe(int64_t value) {
+  // The bucket of the first bound that is not below the value, or +Inf.
+  const size_t bucket =
+      std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+std::vector<int64_t> Histogram::BucketCounts() const {
+  std::vector<int64_t> counts(bounds_.size() + 1);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+std::vector<int64_t> ExponentialBuckets(int64_t start, double factor, int count) {
+  std::vector<int64_t> bounds;
+  bounds.reserve(count);
+  double bound = start;
+  for (int i = 0; i < count; ++i) {
+    bounds.push_back(std::llround(bound));
+    bound *= factor;
+  }
+  return bounds;
+}
+
+namespace {
+
+// Renders the labels as k1="v1",k2="v2", escaping the values as the text format requires.
+std::string RenderLabels(const Labels& labels) {
+  std::string out;
+  for (const auto& [key, value] : labels) {
+    if (!out.empty()) {
+      out += ',';
+    }
+    absl::StrAppend(&out, key, "=\"");
+    for (char c : value) {
+      switch (c) {
+        case '\\':
+          out += "\\\\";
+          break;
+        case '"':
+          out += "\\\"";
+          break;
+        case '\n':
+          out += "\\n";
+          break;
+        default:
+          out += c;
+      }
+    }
+    out += '"';
+  }
+  return out;
+}
+
+void AppendSample(std::string* out, std::string_view name, std::string_view labels,
+                  int64_t value) {
+  if (labels.empty()) {
+    absl::StrAppend(out, name, " ", value, "\n");
+  } else {
+    absl::StrAppend(out, name, "{", labels, "} ", value, "\n");
+  }
+}
+
+std::string JoinLabels(std::string_view labels, std::string_view extra) {
+  return labels.empty() ? std::string(extra) : absl::StrCat(labels, ",", extra);
+}
+
+}  // namespace
+
+MetricsRegistry* MetricsRegistry::Global() {
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return registry;
+}
+
+MetricsRegistry::Family* MetricsRegistry::GetFamily(std::string_view name, std::string_view help,
+                                                    Type type) {
+  auto iter = families_.find(name);
+  if (iter == families_.end()) {
+    iter = families_.emplace(std::string(name), Family{type, std::string(help), {}, {}, {}}).first;
+  }
+  CHECK(iter->second.type == type) << absl::Substitute(
+      "Metric $0 is already registered with a different type.", name);
+  return &iter->second;
+}
+
+Counter* MetricsRegistry::GetCounter(std::string_view name, std::string_view help,
+                                     const Labels& labels) {
+  absl::MutexLock lock(&mu_);
+  auto& metric = GetFamily(name, help, Type::kCounter)->counters[RenderLabels(labels)];
+  if (metric == nullptr) {
+    metric = std::make_unique<Counter>();
+  }
+  return metric.get();
+}
+
+Gauge* MetricsRegistry::GetGauge(std::string_view name, std::string_view help,
+                                 const Labels& labels) {
+  absl::MutexLock lock(&mu_);
+  auto& metric = GetFamily(name, help, Type::kGauge)->gauges[RenderLabels(labels)];
+  if (metric == nullptr) {
+    metric = std::make_unique<Gauge>();
+  }
+  return metric.get();
+}
+
+Histogram* MetricsRegistry::GetHistogram(std::string_view name, std::string_view help,
+                                         std::vector<int64_t> bounds, const Labels& labels) {
+  absl::MutexLock lock(&mu_);
+  auto& metric = GetFamily(name, help, Type::kHistogram)->histograms[RenderLabels(labels)];
+  if (metric == nullptr) {
+    metric = std::make_unique<Histogram>(std::move(bounds));
+  }
+  return metric.get();
+}
+
+std::string MetricsRegistry::ToPrometheusText() const {
+  absl::ReaderMutexLock lock(&mu_);
+  std::string out;
+  for (const auto& [name, family] : families_) {
+    absl::StrAppend(&out, "# HELP ", name, " ", family.help, "\n");
+    switch (family.type) {
+      case Type::kCounter:
+        absl::StrAppend(&out, "# TYPE ", name, " counter\n");
+        for (const auto& [labels, counter] : family.counters) {
+          AppendSample(&out, name, labels, counter->Value());
+        }
+        break;
+      case Type::kGauge:
+        absl::StrAppend(&out, "# TYPE ", name, " gauge\n");
+        for (const auto& [labels, gauge] : family.gauges) {
+          AppendSample(&out, name, labels, gauge->Value());
+        }
+        break;
+      case Type::kHistogram:
+        absl::StrAppend(&out, "# TYPE ", name, " histogram\n");
+        for (const auto& [labels, histogram] : family.histograms) {
+          const std::string bucket_name = absl::StrCat(name, "_bucket");
+          const std::vector<int64_t> counts = histogram->BucketCounts();
+          int64_t cumulative_count = 0;
+          for (size_t i = 0; i < counts.size(); ++i) {
+            cumulative_count += counts[i];
+            const std::string le = i < histogram->bounds().size()
+                                       ? absl::StrCat(histogram->bounds()[i])
+                                       : std::string("+Inf");
+            AppendSample(&out, bucket_name, JoinLabels(labels, absl::StrCat("le=\"", le, "\"")),
+                         cumulative_count);
+          }
+          AppendSample(&out, absl::StrCat(name, "_sum"), labels, histogram->Sum());
+          AppendSample(&out, absl::StrCat(name, "_count"), labels, cumulative_count);
+        }
+        break;
+    }
+  }
+  return out;
+}
+
+}  // namespace metrics
+}  // namespace px
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace metrics {
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * A monotonically increasing counter. Increments go to one of a few cache-line sized shards,
+ * picked per thread, so that threads updating the same counter don't contend. An increment is a
+ * single relaxed atomic add.
+ */
+class Counter : public NotCopyable {
+ public:
+  void Increment(int64_t n = 1) {
+    shards_[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  int64_t Value() const;
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct alignas(64) Shard {
+    std::atomic<int64_t> value = 0;
+  };
+
+  static size_t ShardIndex() {
+    static std::atomic<size_t> next_index = 0;
+    static thread_local const size_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+    return index;
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+/**
+ * A value that can go up and down, e.g. a number of connection trackers.
+ */
+class Gauge : public NotCopyable {
+ public:
+  void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_ = 0;
+};
+
+/**
+ * A histogram with fixed bucket bounds. An observation is a relaxed atomic add to its bucket,
+ * plus one to the sum of the observations.
+ */
+class Histogram : public NotCopyable {
+ public:
+  /**
+   * @param bounds the inclusive upper bounds of the buckets, in increasing order. Values above
+   * the last bound go to an implicit +Inf bucket.
+   */
+  explicit Histogram(std::vector<int64_t> bounds);
+
+  void Observe(int64_t value);
+
+  const std::vector<int64_t>& bounds() const { return bounds_; }
+
+  /**
+   * Returns the (non-cumulative) count of each bucket, the last one being the +Inf bucket.
+   */
+  std::vector<int64_t> BucketCounts() const;
+  int64_t Sum() const { return sum_.load(std::memory_order_relaxed); }
+
+ private:
+  const std::vector<int64_t> bounds_;
+  std::unique_ptr<std::atomic<int64_t>[]> buckets_;
+  std::atomic<int64_t> sum_ = 0;
+};
+
+/**
+ * Returns count bucket bounds, starting at start and growing by factor.
+ */
+std::vector<int64_t> ExponentialBuckets(int64_t start, double factor, int count);
+
+/**
+ * Process-wide registry of metrics, rendered in the Prometheus text format by the metrics server.
+ *
+ * Only creating and rendering the metrics takes the registry lock. The returned metrics live as
+ * long as the registry, so callers look them up once and keep the pointer for the hot path.
+ * Asking for an existing metric (same name and labels) returns the same one.
+ */
+class MetricsRegistry : public NotCopyable {
+ public:
+  static MetricsRegistry* Global();
+
+  Counter* GetCounter(std::string_view name, std::string_view help, const Labels& labels = {});
+  Gauge* GetGauge(std::string_view name, std::string_view help, const Labels& labels = {});
+  Histogram* GetHistogram(std::string_view name, std::string_view help,
+                          std::vector<int64_t> bounds, const Labels& labels = {});
+
+  /**
+   * Renders all the metrics in the Prometheus text exposition format (version 0.0.4).
+   */
+  std::string ToPrometheusText() const;
+
+ private:
+  enum class Type {
+    kCounter,
+    kGauge,
+    kHistogram,
+  };
+
+  // All the metrics of one name, keyed by their rendered labels.
+  struct Family {
+    Type type;
+    std::string help;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+  };
+
+  Family* GetFamily(std::string_view name, std::string_view help, Type type)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable absl::Mutex mu_;
+  std::map<std::string, Family, std::less<>> families_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace metrics
+}  // namespace px
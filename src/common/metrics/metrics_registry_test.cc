@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <thread>
+#include <vector>
+
+#include "src/common/metrics/metrics_registry.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace metrics {
+
+using ::testing::HasSubstr;
+
+TEST(CounterTest, SumsIncrementsAcrossThreads) {
+  Counter counter;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&counter] {
+      for (int j = 0; j < 1000; ++j) {
+        counter.Increment();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  counter.Increment(5);
+  EXPECT_EQ(counter.Value(), 8005);
+}
+
+TEST(HistogramTest, BucketsAreInclusiveUpperBounds) {
+  Histogram histogram({10, 100});
+  for (int64_t value : {1, 10, 11, 100, 1000}) {
+    histogram.Observe(value);
+  }
+  EXPECT_THAT(histogram.BucketCounts(), ::testing::ElementsAre(2, 2, 1));
+  EXPECT_EQ(histogram.Sum(), 1122);
+}
+
+TEST(ExponentialBucketsTest, GrowsByFactor) {
+  EXPECT_THAT(ExponentialBuckets(100, 2, 4), ::testing::ElementsAre(100, 200, 400, 800));
+}
+
+TEST(MetricsRegistryTest, ReturnsTheSameMetricForTheSameNameAndLabels) {
+  MetricsRegistry registry;
+  Counter* a = registry.GetCounter("lost_total", "Lost events.", {{"buffer", "a"}});
+  Counter* b = registry.GetCounter("lost_total", "Lost events.", {{"buffer", "b"}});
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, registry.GetCounter("lost_total", "Lost events.", {{"buffer", "a"}}));
+}
+
+TEST(MetricsRegistryTest, PrometheusText) {
+  MetricsRegistry registry;
+  registry.GetCounter("lost_total", "Lost events.", {{"buffer", "a\"b"}})->Increment(3);
+  registry.GetGauge("trackers", "Number of trackers.")->Set(7);
+  Histogram* latency = registry.GetHistogram("latency_us", "Latency.", {10, 100});
+  latency->Observe(5);
+  latency->Observe(50);
+  latency->Observe(500);
+
+  std::string text = registry.ToPrometheusText();
+  EXPECT_THAT(text, HasSubstr("# HELP lost_total Lost events.\n# TYPE lost_total counter\n"
+                              "lost_total{buffer=\"a\\\"b\"} 3\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE trackers gauge\ntrackers 7\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE latency_us histogram\n"
+                              "latency_us_bucket{le=\"10\"} 1\n"
+                              "latency_us_bucket{le=\"100\"} 2\n"
+                              "latency_us_bucket{le=\"+Inf\"} 3\n"
+                              "latency_us_sum 555\n"
+                              "latency_us_count 3\n"));
+}
+
+}  // namespace metrics
+}  // namespace px
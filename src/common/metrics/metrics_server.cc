@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/metrics/metrics_server.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
+
+namespace px {
+namespace metrics {
+
+namespace {
+
+// How often the server thread checks whether it was stopped.
+constexpr int kPollTimeoutMS = 100;
+// Requests are only a request line and a few headers; anything longer is not a scraper.
+constexpr size_t kMaxRequestSize = 8 * 1024;
+
+void SendAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    data.remove_prefix(n);
+  }
+}
+
+std::string HTTPResponse(std::string_view status, std::string_view content_type,
+                         std::string_view body) {
+  return absl::StrCat("HTTP/1.1 ", status, "\r\nContent-Type: ", content_type,
+                      "\r\nContent-Length: ", body.size(), "\r\nConnection: close\r\n\r\n", body);
+}
+
+}  // namespace
+
+MetricsServer::~MetricsServer() { Stop(); }
+
+Status MetricsServer::Start(int port) {
+  DCHECK(!running_);
+  listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    return error::Internal("Failed to create metrics server socket ($0)", std::strerror(errno));
+  }
+  int reuse = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  socklen_t addr_len = sizeof(addr);
+  if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), addr_len) != 0 ||
+      listen(listen_fd_, /*backlog*/ 16) != 0 ||
+      getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) != 0) {
+    Status s = error::Internal("Failed to listen on metrics port $0 ($1)", port,
+                               std::strerror(errno));
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return s;
+  }
+  port_ = ntohs(addr.sin_port);
+
+  running_ = true;
+  thread_ = std::thread(&MetricsServer::Run, this);
+  LOG(INFO) << absl::Substitute("Serving metrics on port $0", port_);
+  return Status::OK();
+}
+
+void MetricsServer::Stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+}
+
+void MetricsServer::Run() {
+  while (running_) {
+    struct pollfd pfd = {listen_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, kPollTimeoutMS) <= 0) {
+      continue;
+    }
+    int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+    HandleConnection(fd);
+    close(fd);
+  }
+}
+
+void MetricsServer::HandleConnection(int fd) {
+  // Don't let a stalled client hold up the server.
+  struct timeval timeout = {1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  char buf[1024];
+  while (!absl::StrContains(request, "\r\n\r\n") && request.size() < kMaxRequestSize) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      break;
+    }
+    request.append(buf, n);
+  }
+
+  // Only the request line matters, e.g. "GET /metrics HTTP/1.1".
+  std::string_view request_line = std::string_view(request).substr(0, request.find("\r\n"));
+  if (absl::StartsWith(request_line, "GET /metrics ") ||
+      absl::StartsWith(request_line, "GET /metrics?")) {
+    SendAll(fd, HTTPResponse("200 OK", "text/plain; version=0.0.4",
+                             registry_->ToPrometheusText()));
+  } else {
+    SendAll(fd, HTTPResponse("404 Not Found", "text/plain", "Not found.\n"));
+  }
+}
+
+}  // namespace metrics
+}  // namespace px
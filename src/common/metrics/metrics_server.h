@@ -0,0 +1,64 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "src/common/base/base.h"
+#include "src/common/metrics/metrics_registry.h"
+
+namespace px {
+namespace metrics {
+
+/**
+ * A minimal HTTP server that serves the metrics of a registry on /metrics, for Prometheus to
+ * scrape. It handles one connection at a time on its own thread, which is plenty for a scraper.
+ */
+class MetricsServer : public NotCopyable {
+ public:
+  explicit MetricsServer(const MetricsRegistry* registry) : registry_(registry) {}
+  ~MetricsServer();
+
+  /**
+   * Starts serving on the given port, on all interfaces. Port 0 picks a free port, see port().
+   */
+  Status Start(int port);
+
+  /**
+   * Stops serving, and waits for the server thread to exit.
+   */
+  void Stop();
+
+  int port() const { return port_; }
+
+ private:
+  void Run();
+  void HandleConnection(int fd);
+
+  const MetricsRegistry* registry_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> running_ = false;
+  std::thread thread_;
+};
+
+}  // namespace metrics
+}  // namespace px
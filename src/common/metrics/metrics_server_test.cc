@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <absl/strings/str_cat.h>
+
+#include "src/common/metrics/metrics_server.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace metrics {
+
+using ::testing::HasSubstr;
+using ::testing::StartsWith;
+
+namespace {
+
+std::string Get(int port, std::string_view path) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  EXPECT_EQ(connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+
+  std::string request = absl::StrCat("GET ", path, " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  EXPECT_EQ(send(fd, request.data(), request.size(), 0), static_cast<ssize_t>(request.size()));
+
+  std::string response;
+  char buf[1024];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    response.append(buf, n);
+  }
+  close(fd);
+  return response;
+}
+
+}  // namespace
+
+TEST(MetricsServerTest, ServesMetrics) {
+  MetricsRegistry registry;
+  registry.GetCounter("requests_total", "Requests.")->Increment(2);
+
+  MetricsServer server(&registry);
+  ASSERT_OK(server.Start(0));
+  ASSERT_NE(server.port(), 0);
+
+  std::string response = Get(server.port(), "/metrics");
+  EXPECT_THAT(response, StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_THAT(response, HasSubstr("\r\n\r\n# HELP requests_total Requests.\n"));
+  EXPECT_THAT(response, HasSubstr("requests_total 2\n"));
+
+  EXPECT_THAT(Get(server.port(), "/foo"), StartsWith("HTTP/1.1 404 Not Found\r\n"));
+  server.Stop();
+}
+
+}  // namespace metrics
+}  // namespace px
@@ -26,3 +26,4 @@
 #include "src/common/perf/profiler.h"         // IWYU pragma: export
 #include "src/common/perf/scoped_profiler.h"  // IWYU pragma: export
 #include "src/common/perf/scoped_timer.h"     // IWYU pragma: export
+#include "src/common/perf/self_profile.h"     // IWYU pragma: export
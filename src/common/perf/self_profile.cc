@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/perf/self_profile.h"
+
+#include <pthread.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace profiler {
+
+void SetCurrentThreadRole(ThreadRole role) {
+  std::string_view name;
+  switch (role) {
+    case ThreadRole::kStirlingCore:
+      name = kStirlingCoreThreadName;
+      break;
+    case ThreadRole::kCarnotQuery:
+      name = kCarnotQueryThreadName;
+      break;
+    case ThreadRole::kDispatcher:
+      name = kDispatcherThreadName;
+      break;
+    case ThreadRole::kUnknown:
+      return;
+  }
+  // Best effort: a failure only means the thread's samples go untagged.
+  pthread_setname_np(pthread_self(), std::string(name).c_str());
+}
+
+ThreadRole ThreadRoleFromName(std::string_view thread_name) {
+  if (thread_name == kStirlingCoreThreadName) {
+    return ThreadRole::kStirlingCore;
+  }
+  if (thread_name == kCarnotQueryThreadName) {
+    return ThreadRole::kCarnotQuery;
+  }
+  if (thread_name == kDispatcherThreadName) {
+    return ThreadRole::kDispatcher;
+  }
+  return ThreadRole::kUnknown;
+}
+
+std::string_view ThreadRoleName(ThreadRole role) {
+  switch (role) {
+    case ThreadRole::kStirlingCore:
+      return "stirling_core";
+    case ThreadRole::kCarnotQuery:
+      return "carnot_query";
+    case ThreadRole::kDispatcher:
+      return "dispatcher";
+    case ThreadRole::kUnknown:
+      break;
+  }
+  return "unknown";
+}
+
+SelfProfile* SelfProfile::Global() {
+  static SelfProfile* profile = new SelfProfile();
+  return profile;
+}
+
+void SelfProfile::Update(int64_t time_ns, std::vector<SelfProfileSample> samples) {
+  absl::MutexLock lock(&mu_);
+  time_ns_ = time_ns;
+  samples_ = std::move(samples);
+}
+
+std::vector<SelfProfileSample> SelfProfile::Snapshot(int64_t* time_ns) const {
+  absl::ReaderMutexLock lock(&mu_);
+  *time_ns = time_ns_;
+  return samples_;
+}
+
+}  // namespace profiler
+}  // namespace px
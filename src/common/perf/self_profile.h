@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/numeric/int128.h>
+#include <absl/synchronization/mutex.h>
+
+namespace px {
+namespace profiler {
+
+/**
+ * The roles of the threads in our agents. A thread announces its role by setting its name,
+ * which is how the perf profiler recognizes samples from our own threads.
+ */
+enum class ThreadRole {
+  kUnknown,
+  kStirlingCore,
+  kCarnotQuery,
+  kDispatcher,
+};
+
+// Names are kept to the 15 characters that fit in a thread's comm.
+inline constexpr std::string_view kThreadNamePrefix = "px_";
+inline constexpr std::string_view kStirlingCoreThreadName = "px_stirling";
+inline constexpr std::string_view kCarnotQueryThreadName = "px_query";
+inline constexpr std::string_view kDispatcherThreadName = "px_dispatch";
+
+/**
+ * Names the calling thread after the given role. Threads spawned afterwards inherit the name,
+ * so helper threads (e.g. those of the NATS client) are attributed to their creator's role.
+ */
+void SetCurrentThreadRole(ThreadRole role);
+
+/**
+ * Returns the role of a thread with the given name.
+ */
+ThreadRole ThreadRoleFromName(std::string_view thread_name);
+
+/**
+ * Returns a short printable name for the role, e.g. "stirling_core".
+ */
+std::string_view ThreadRoleName(ThreadRole role);
+
+struct SelfProfileSample {
+  absl::uint128 upid;
+  ThreadRole role;
+  // Folded stack trace, rooted at a "[<role>]" frame.
+  std::string stack_trace;
+  uint64_t count;
+};
+
+/**
+ * SelfProfile holds the most recent profile of our own agent threads, as gathered by the
+ * perf profiler.
+ */
+class SelfProfile {
+ public:
+  static SelfProfile* Global();
+
+  void Update(int64_t time_ns, std::vector<SelfProfileSample> samples) ABSL_LOCKS_EXCLUDED(mu_);
+
+  /**
+   * Returns the samples of the last update, and sets time_ns to when it was taken.
+   */
+  std::vector<SelfProfileSample> Snapshot(int64_t* time_ns) const ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  mutable absl::Mutex mu_;
+  int64_t time_ns_ ABSL_GUARDED_BY(mu_) = 0;
+  std::vector<SelfProfileSample> samples_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace profiler
+}  // namespace px
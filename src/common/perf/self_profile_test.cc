@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pthread.h>
+
+#include <string>
+#include <thread>
+
+#include "src/common/perf/self_profile.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace profiler {
+
+TEST(ThreadRoleTest, RoundTripsThroughThreadName) {
+  std::string name;
+  std::thread t([&name] {
+    SetCurrentThreadRole(ThreadRole::kCarnotQuery);
+    char buf[16] = {};
+    pthread_getname_np(pthread_self(), buf, sizeof(buf));
+    name = buf;
+  });
+  t.join();
+
+  EXPECT_EQ(name, kCarnotQueryThreadName);
+  EXPECT_EQ(ThreadRoleFromName(name), ThreadRole::kCarnotQuery);
+  EXPECT_EQ(ThreadRoleFromName("px_stirling"), ThreadRole::kStirlingCore);
+  EXPECT_EQ(ThreadRoleFromName("px_dispatch"), ThreadRole::kDispatcher);
+  EXPECT_EQ(ThreadRoleFromName("pem"), ThreadRole::kUnknown);
+  EXPECT_EQ(ThreadRoleName(ThreadRole::kCarnotQuery), "carnot_query");
+}
+
+TEST(SelfProfileTest, SnapshotReturnsLastUpdate) {
+  SelfProfile profile;
+  int64_t time_ns = -1;
+  EXPECT_TRUE(profile.Snapshot(&time_ns).empty());
+  EXPECT_EQ(time_ns, 0);
+
+  profile.Update(10, {{1, ThreadRole::kStirlingCore, "[stirling_core];main;foo", 3}});
+  profile.Update(20, {{1, ThreadRole::kDispatcher, "[dispatcher];main;bar", 5}});
+
+  auto samples = profile.Snapshot(&time_ns);
+  EXPECT_EQ(time_ns, 20);
+  ASSERT_EQ(samples.size(), 1);
+  EXPECT_EQ(samples[0].role, ThreadRole::kDispatcher);
+  EXPECT_EQ(samples[0].stack_trace, "[dispatcher];main;bar");
+  EXPECT_EQ(samples[0].count, 5);
+}
+
+}  // namespace profiler
+}  // namespace px
@@ -18,7 +18,12 @@
 
 #pragma once
 
+#include <time.h>
+
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <limits>
 
 namespace px {
 namespace chrono {
@@ -51,5 +56,68 @@ using boot_clock = basic_clock<CLOCK_BOOTTIME>;
 // If resolution beyond a millisecond is not required, this should be sufficient.
 using coarse_steady_clock = basic_clock<CLOCK_MONOTONIC_COARSE>;
 
+/**
+ * ClockConverter converts CLOCK_MONOTONIC times (e.g. BPF timestamps) to CLOCK_REALTIME times.
+ *
+ * The offset between the two clocks changes when the realtime clock is stepped, or when the
+ * machine resumes from suspend, so it must be re-sampled periodically with Update().
+ * Convert() is a relaxed atomic load and an add, and is safe to call concurrently with Update().
+ */
+class ClockConverter {
+ public:
+  // Re-sampled offsets closer than this to the current one are ignored, so that sampling noise
+  // does not make converted times go back and forth.
+  static constexpr int64_t kMinOffsetChangeNS = 1000;
+
+  ClockConverter() { offset_.store(SampleOffset(), std::memory_order_relaxed); }
+
+  /**
+   * Re-samples the offset between the clocks. The clocks are read through the vDSO, so this costs
+   * a few hundred nanoseconds.
+   */
+  void Update() {
+    const uint64_t offset = SampleOffset();
+    const uint64_t prev_offset = offset_.load(std::memory_order_relaxed);
+    const auto change = static_cast<int64_t>(offset - prev_offset);
+    if (change >= kMinOffsetChangeNS || change <= -kMinOffsetChangeNS) {
+      offset_.store(offset, std::memory_order_relaxed);
+    }
+  }
+
+  uint64_t Convert(uint64_t monotonic_ns) const { return monotonic_ns + offset(); }
+
+  /**
+   * @return the offset to add to CLOCK_MONOTONIC times to get CLOCK_REALTIME times.
+   */
+  uint64_t offset() const { return offset_.load(std::memory_order_relaxed); }
+
+ private:
+  static uint64_t ToNS(const timespec& ts) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+  }
+
+  // Takes the sample with the tightest MONOTONIC bracket around the REALTIME read, to keep
+  // preemption between the reads out of the offset.
+  static uint64_t SampleOffset() {
+    static constexpr int kNumSamples = 3;
+    uint64_t best_offset = 0;
+    uint64_t best_width = std::numeric_limits<uint64_t>::max();
+    for (int i = 0; i < kNumSamples; ++i) {
+      timespec before, real, after;
+      clock_gettime(CLOCK_MONOTONIC, &before);
+      clock_gettime(CLOCK_REALTIME, &real);
+      clock_gettime(CLOCK_MONOTONIC, &after);
+      const uint64_t width = ToNS(after) - ToNS(before);
+      if (width < best_width) {
+        best_width = width;
+        best_offset = ToNS(real) - (ToNS(before) + width / 2);
+      }
+    }
+    return best_offset;
+  }
+
+  std::atomic<uint64_t> offset_;
+};
+
 }  // namespace chrono
 }  // namespace px
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include "src/common/system/clock.h"
+
+namespace px {
+namespace chrono {
+
+namespace {
+uint64_t NowNS(clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+}  // namespace
+
+TEST(ClockConverterTest, ConvertsToRealTime) {
+  ClockConverter converter;
+  const uint64_t real_before = NowNS(CLOCK_REALTIME);
+  const uint64_t converted = converter.Convert(NowNS(CLOCK_MONOTONIC));
+  const uint64_t real_after = NowNS(CLOCK_REALTIME);
+
+  // Leave some slack for the sampling error of the offset.
+  constexpr uint64_t kSlackNS = 1000000;
+  EXPECT_GE(converted + kSlackNS, real_before);
+  EXPECT_LE(converted, real_after + kSlackNS);
+}
+
+TEST(ClockConverterTest, UpdateIgnoresNoise) {
+  ClockConverter converter;
+  const uint64_t offset = converter.offset();
+  converter.Update();
+  // The clocks were not stepped in between, so the offset stays within the sampling noise.
+  const auto change = static_cast<int64_t>(converter.offset() - offset);
+  EXPECT_LT(std::abs(change), 1000000);
+}
+
+}  // namespace chrono
+}  // namespace px
@@ -22,6 +22,7 @@
 
 #include "src/common/base/base.h"
 #include "src/common/fs/fs_wrapper.h"
+#include "src/common/system/clock.h"
 
 namespace px {
 namespace system {
@@ -39,9 +40,7 @@ class ConfigImpl final : public Config {
   ConfigImpl()
       : host_path_(FLAGS_host_path),
         sysfs_path_(FLAGS_sysfs_path),
-        proc_path_(absl::StrCat(FLAGS_host_path, "/proc")) {
-    InitClockRealTimeOffset();
-  }
+        proc_path_(absl::StrCat(FLAGS_host_path, "/proc")) {}
 
   bool HasConfig() const override { return true; }
 
@@ -49,7 +48,9 @@ class ConfigImpl final : public Config {
 
   int64_t KernelTicksPerSecond() const override { return sysconf(_SC_CLK_TCK); }
 
-  uint64_t ClockRealTimeOffset() const override { return real_time_offset_; }
+  uint64_t ClockRealTimeOffset() const override { return clock_converter_.offset(); }
+
+  void UpdateClockRealTimeOffset() const override { clock_converter_.Update(); }
 
   const std::filesystem::path& sysfs_path() const override { return sysfs_path_; }
 
@@ -65,24 +66,12 @@ class ConfigImpl final : public Config {
   }
 
  private:
-  uint64_t real_time_offset_ = 0;
+  // Converts times recorded with the monotonic clock (aka steady_clock) to real time
+  // (aka system_clock).
+  mutable chrono::ClockConverter clock_converter_;
   const std::filesystem::path host_path_;
   const std::filesystem::path sysfs_path_;
   const std::filesystem::path proc_path_;
-
-  // Utility function to convert time as recorded by in monotonic clock (aka steady_clock)
-  // to real time (aka system_clock).
-  // TODO(oazizi): if machine is ever suspended, this function would have to be called again.
-  void InitClockRealTimeOffset() {
-    static constexpr uint64_t kSecToNanosecFactor = 1000000000;
-
-    struct timespec time, real_time;
-    clock_gettime(CLOCK_MONOTONIC, &time);
-    clock_gettime(CLOCK_REALTIME, &real_time);
-
-    real_time_offset_ =
-        kSecToNanosecFactor * (real_time.tv_sec - time.tv_sec) + real_time.tv_nsec - time.tv_nsec;
-  }
 };
 
 namespace {
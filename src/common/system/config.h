@@ -71,6 +71,12 @@ class Config : public NotCopyable {
    */
   virtual uint64_t ClockRealTimeOffset() const = 0;
 
+  /**
+   * Re-samples the offset returned by ClockRealTimeOffset(), which changes if the realtime clock
+   * is stepped or the machine is suspended. Safe to call concurrently with ClockRealTimeOffset().
+   */
+  virtual void UpdateClockRealTimeOffset() const = 0;
+
   /**
    * Get the sysfs path.
    */
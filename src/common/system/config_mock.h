@@ -33,6 +33,7 @@ class MockConfig : public Config {
   MOCK_CONST_METHOD0(PageSize, int64_t());
   MOCK_CONST_METHOD0(KernelTicksPerSecond, int64_t());
   MOCK_CONST_METHOD0(ClockRealTimeOffset, uint64_t());
+  MOCK_CONST_METHOD0(UpdateClockRealTimeOffset, void());
   MOCK_CONST_METHOD0(sysfs_path, const std::filesystem::path&());
   MOCK_CONST_METHOD0(host_path, const std::filesystem::path&());
   MOCK_CONST_METHOD0(proc_path, const std::filesystem::path&());
@@ -16,6 +16,14 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstring>
 #include <fstream>
 #include <limits>
 #include <string>
@@ -95,6 +103,104 @@ constexpr int kProcStatStartTimeField = 21;
 constexpr int kProcStatVSizeField = 22;
 constexpr int kProcStatRSSField = 23;
 
+namespace {
+
+// Reads a file in /proc into buf, reusing the capacity of buf.
+// Files in /proc report a size of 0, so they are read in chunks until EOF.
+// Unlike std::ifstream, this never throws (e.g. when the process exits during the read).
+Status ReadProcFile(const std::string& fpath, std::string* buf) {
+  int fd = open(fpath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open file $0", fpath);
+  }
+  DEFER(close(fd));
+
+  constexpr size_t kReadChunkSize = 4096;
+  buf->clear();
+  while (true) {
+    const size_t size = buf->size();
+    buf->resize(size + kReadChunkSize);
+    ssize_t n = read(fd, buf->data() + size, kReadChunkSize);
+    if (n < 0) {
+      buf->resize(size);
+      return error::Internal("Failed to read file $0 ($1)", fpath, std::strerror(errno));
+    }
+    buf->resize(size + n);
+    if (n == 0) {
+      return Status::OK();
+    }
+  }
+}
+
+// The buffers into which the files of /proc are read and split. They are reused across calls,
+// so that scanning the stats of all the processes of the system does not allocate per PID.
+std::string* ProcFileBuffer() {
+  thread_local std::string buf;
+  return &buf;
+}
+
+std::vector<std::string_view>* ProcFieldsBuffer() {
+  thread_local std::vector<std::string_view> fields;
+  return &fields;
+}
+
+// Returns the next line of content, and removes it (and its newline) from content.
+std::string_view NextLine(std::string_view* content) {
+  size_t pos = content->find('\n');
+  std::string_view line = content->substr(0, pos);
+  content->remove_prefix(pos == std::string_view::npos ? content->size() : pos + 1);
+  return line;
+}
+
+// Appends the space or tab separated fields of str to fields.
+void AppendFields(std::string_view str, std::vector<std::string_view>* fields) {
+  size_t pos = 0;
+  while (true) {
+    pos = str.find_first_not_of(kFieldSeparators, pos);
+    if (pos == std::string_view::npos) {
+      return;
+    }
+    size_t end = str.find_first_of(kFieldSeparators, pos);
+    if (end == std::string_view::npos) {
+      end = str.size();
+    }
+    fields->push_back(str.substr(pos, end - pos));
+    pos = end;
+  }
+}
+
+void SplitFields(std::string_view str, std::vector<std::string_view>* fields) {
+  fields->clear();
+  AppendFields(str, fields);
+}
+
+template <typename TInt>
+bool ParseInt(std::string_view str, TInt* val) {
+  const char* end = str.data() + str.size();
+  auto [ptr, ec] = std::from_chars(str.data(), end, *val);
+  return ec == std::errc() && ptr == end;
+}
+
+// Splits the first line of /proc/<pid>/stat. The process name (the second field) is in
+// parentheses, and may itself contain spaces, so it ends at the last ')'.
+Status SplitProcPIDStat(std::string_view content, std::vector<std::string_view>* fields) {
+  std::string_view line = NextLine(&content);
+  const size_t name_start = line.find('(');
+  const size_t name_end = line.rfind(')');
+  if (name_start == std::string_view::npos || name_end == std::string_view::npos ||
+      name_end < name_start) {
+    return error::Internal("Could not find the process name");
+  }
+
+  SplitFields(line.substr(0, name_start), fields);
+  // Keep the parentheses, so the field is the same as when the name has no spaces.
+  fields->push_back(line.substr(name_start, name_end - name_start + 1));
+  AppendFields(line.substr(name_end + 1), fields);
+  return Status::OK();
+}
+
+}  // namespace
+
 std::filesystem::path ProcParser::ProcPidPath(pid_t pid) const {
   return std::filesystem::path(proc_base_path_) / std::to_string(pid);
 }
@@ -113,29 +219,29 @@ Status ProcParser::ParseNetworkStatAccumulateIFaceData(
   int64_t val;
   bool ok = true;
   // Rx Data.
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevRxBytesField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevRxBytesField], &val);
   out->rx_bytes += val;
 
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevRxPacketsField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevRxPacketsField], &val);
   out->rx_packets += val;
 
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevRxDropField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevRxDropField], &val);
   out->rx_drops += val;
 
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevRxErrsField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevRxErrsField], &val);
   out->rx_errs += val;
 
   // Tx Data.
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevTxBytesField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevTxBytesField], &val);
   out->tx_bytes += val;
 
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevTxPacketsField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevTxPacketsField], &val);
   out->tx_packets += val;
 
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevTxDropField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevTxDropField], &val);
   out->tx_drops += val;
 
-  ok &= absl::SimpleAtoi(dev_stat_record[kProcNetDevTxErrsField], &val);
+  ok &= ParseInt(dev_stat_record[kProcNetDevTxErrsField], &val);
   out->tx_errs += val;
 
   if (!ok) {
@@ -171,32 +277,33 @@ Status ProcParser::ParseProcPIDNetDev(int32_t pid, NetworkStats* out) const {
   DCHECK(out != nullptr);
 
   std::string fpath = absl::Substitute("$0/$1/net/dev", proc_base_path_, pid);
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
-  }
+  std::string* buf = ProcFileBuffer();
+  PL_RETURN_IF_ERROR(ReadProcFile(fpath, buf));
+  std::string_view content = *buf;
 
   // Ignore the first two lines since they are just headers;
   const int kHeaderLines = 2;
   for (int i = 0; i < kHeaderLines; ++i) {
-    ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    NextLine(&content);
   }
 
-  std::string line;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
+  std::vector<std::string_view>* split = ProcFieldsBuffer();
+  while (!content.empty()) {
+    SplitFields(NextLine(&content), split);
+    if (split->empty()) {
+      continue;
+    }
     // We check less than in case more fields are added later.
-    if (split.size() < kProcNetDevNumFields) {
+    if (split->size() < kProcNetDevNumFields) {
       return error::Internal("failed to parse net dev file, incorrect number of fields");
     }
 
-    if (!ShouldIncludeNetIFace(split[kProcNetDevIFaceField])) {
+    if (!ShouldIncludeNetIFace((*split)[kProcNetDevIFaceField])) {
       continue;
     }
 
     // We should track this interface. Accumulate the results.
-    auto s = ParseNetworkStatAccumulateIFaceData(split, out);
+    auto s = ParseNetworkStatAccumulateIFaceData(*split, out);
     if (!s.ok()) {
       // Empty out the stats so we don't leave intermediate results.
       return s;
@@ -217,48 +324,47 @@ Status ProcParser::ParseProcPIDStat(int32_t pid, ProcessStats* out) const {
    */
   DCHECK(out != nullptr);
   std::string fpath = absl::Substitute("$0/$1/stat", proc_base_path_, pid);
+  std::string* buf = ProcFileBuffer();
+  PL_RETURN_IF_ERROR(ReadProcFile(fpath, buf));
+  if (buf->empty()) {
+    return error::Internal("Failed to read proc stat file: $0", fpath);
+  }
 
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
+  std::vector<std::string_view>* fields = ProcFieldsBuffer();
+  Status s = SplitProcPIDStat(*buf, fields);
+  if (!s.ok()) {
+    return error::Unknown("$0 in stat file: $1", s.msg(), fpath);
+  }
+  const std::vector<std::string_view>& split = *fields;
+  // We check less than in case more fields are added later.
+  if (split.size() < kProcStatNumFields) {
+    return error::Unknown("Incorrect number of fields in stat file: $0", fpath);
   }
 
-  std::string line;
   bool ok = true;
-  if (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
-    // We check less than in case more fields are added later.
-    if (split.size() < kProcStatNumFields) {
-      return error::Unknown("Incorrect number of fields in stat file: $0", fpath);
-    }
-    ok &= absl::SimpleAtoi(split[kProcStatPIDField], &out->pid);
-    // The name is surrounded by () we remove it here.
-    const std::string_view& name_field = split[kProcStatProcessNameField];
-    if (name_field.length() > 2) {
-      out->process_name = std::string(name_field.substr(1, name_field.size() - 2));
-    } else {
-      ok = false;
-    }
-    ok &= absl::SimpleAtoi(split[kProcStatMinorFaultsField], &out->minor_faults);
-    ok &= absl::SimpleAtoi(split[kProcStatMajorFaultsField], &out->major_faults);
-
-    ok &= absl::SimpleAtoi(split[kProcStatUTimeField], &out->utime_ns);
-    ok &= absl::SimpleAtoi(split[kProcStatKTimeField], &out->ktime_ns);
-    // The kernel tracks utime and ktime in kernel ticks.
-    out->utime_ns *= ns_per_kernel_tick_;
-    out->ktime_ns *= ns_per_kernel_tick_;
+  ok &= ParseInt(split[kProcStatPIDField], &out->pid);
+  // The name is surrounded by () we remove it here.
+  const std::string_view& name_field = split[kProcStatProcessNameField];
+  if (name_field.length() > 2) {
+    out->process_name = std::string(name_field.substr(1, name_field.size() - 2));
+  } else {
+    ok = false;
+  }
+  ok &= ParseInt(split[kProcStatMinorFaultsField], &out->minor_faults);
+  ok &= ParseInt(split[kProcStatMajorFaultsField], &out->major_faults);
 
-    ok &= absl::SimpleAtoi(split[kProcStatNumThreadsField], &out->num_threads);
-    ok &= absl::SimpleAtoi(split[kProcStatVSizeField], &out->vsize_bytes);
-    ok &= absl::SimpleAtoi(std::string(split[kProcStatRSSField]), &out->rss_bytes);
+  ok &= ParseInt(split[kProcStatUTimeField], &out->utime_ns);
+  ok &= ParseInt(split[kProcStatKTimeField], &out->ktime_ns);
+  // The kernel tracks utime and ktime in kernel ticks.
+  out->utime_ns *= ns_per_kernel_tick_;
+  out->ktime_ns *= ns_per_kernel_tick_;
 
-    // RSS is in pages.
-    out->rss_bytes *= bytes_per_page_;
+  ok &= ParseInt(split[kProcStatNumThreadsField], &out->num_threads);
+  ok &= ParseInt(split[kProcStatVSizeField], &out->vsize_bytes);
+  ok &= ParseInt(split[kProcStatRSSField], &out->rss_bytes);
 
-  } else {
-    return error::Internal("Failed to read proc stat file: $0", fpath);
-  }
+  // RSS is in pages.
+  out->rss_bytes *= bytes_per_page_;
 
   if (!ok) {
     // This should never happen since it requires the file to be ill-formed
@@ -305,24 +411,23 @@ Status ProcParser::ParseProcStat(SystemStats* out) const {
    */
   CHECK(out != nullptr);
   std::string fpath = absl::Substitute("$0/stat", proc_base_path_);
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
-  }
+  std::string* buf = ProcFileBuffer();
+  PL_RETURN_IF_ERROR(ReadProcFile(fpath, buf));
+  std::string_view content = *buf;
 
-  std::string line;
-  bool ok = true;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
+  std::vector<std::string_view>* fields = ProcFieldsBuffer();
+  while (!content.empty()) {
+    SplitFields(NextLine(&content), fields);
+    const std::vector<std::string_view>& split = *fields;
 
     if (!split.empty() && split[0] == "cpu") {
       if (split.size() < kProcStatCPUNumFields) {
         return error::Unknown("Incorrect number of fields in proc/stat CPU");
       }
 
-      ok &= absl::SimpleAtoi(split[KProcStatCPUKTimeField], &out->cpu_ktime_ns);
-      ok &= absl::SimpleAtoi(split[KProcStatCPUUTimeField], &out->cpu_utime_ns);
+      bool ok = true;
+      ok &= ParseInt(split[KProcStatCPUKTimeField], &out->cpu_ktime_ns);
+      ok &= ParseInt(split[KProcStatCPUUTimeField], &out->cpu_utime_ns);
 
       if (!ok) {
         return error::Unknown("Failed to parse proc/stat cpu info");
@@ -373,25 +478,23 @@ Status ProcParser::ParseFromKeyValueFile(
     const std::string& fpath,
     const absl::flat_hash_map<std::string_view, size_t>& field_name_to_value_map, uint8_t* out_base,
     int64_t field_value_multiplier) {
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Failed to open file $0", fpath);
-  }
+  std::string* buf = ProcFileBuffer();
+  PL_RETURN_IF_ERROR(ReadProcFile(fpath, buf));
+  std::string_view content = *buf;
 
-  std::string line;
+  std::vector<std::string_view>* split = ProcFieldsBuffer();
   size_t read_count = 0;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
+  while (!content.empty()) {
+    SplitFields(NextLine(&content), split);
     // This is a key value pair with a unit (that is always KB when present).
     // If the number is 0 then the units are missing so we either have 2 or 3
     // for the width of the field.
     const int kMemInfoMinFields = 2;
     const int kMemInfoMaxFields = 3;
 
-    if (split.size() >= kMemInfoMinFields && split.size() <= kMemInfoMaxFields) {
-      const auto& key = split[0];
-      const auto& val = split[1];
+    if (split->size() >= kMemInfoMinFields && split->size() <= kMemInfoMaxFields) {
+      const auto& key = (*split)[0];
+      const auto& val = (*split)[1];
 
       const auto& it = field_name_to_value_map.find(key);
       // Key not found in map, we can just go to next iteration of loop.
@@ -401,7 +504,7 @@ Status ProcParser::ParseFromKeyValueFile(
 
       size_t offset = it->second;
       auto val_ptr = reinterpret_cast<int64_t*>(out_base + offset);
-      bool ok = absl::SimpleAtoi(val, val_ptr);
+      bool ok = ParseInt(val, val_ptr);
       *val_ptr *= field_value_multiplier;
 
       if (!ok) {
@@ -410,6 +513,7 @@ Status ProcParser::ParseFromKeyValueFile(
 
       // Check to see if we have read all the fields, if so we can skip the
       // rest. We assume no duplicates.
+      ++read_count;
       if (read_count == field_name_to_value_map.size()) {
         break;
       }
@@ -463,6 +567,38 @@ Status ProcParser::ReadProcPIDFDLink(int32_t pid, int32_t fd, std::string* out)
   return Status::OK();
 }
 
+Status ProcParser::ReadProcPIDFDLinks(int32_t pid, std::string_view prefix,
+                                      absl::flat_hash_map<int32_t, std::string>* out) const {
+  std::string dir_path = absl::Substitute("$0/$1/fd", proc_base_path_, pid);
+  DIR* dir = opendir(dir_path.c_str());
+  if (dir == nullptr) {
+    return error::Internal("Failed to open $0 ($1)", dir_path, std::strerror(errno));
+  }
+
+  out->clear();
+  // readdir() reads the entries in batches (getdents), and readlinkat() resolves them relative
+  // to the open directory, so the path of the process isn't looked up for every FD.
+  char buf[PATH_MAX];
+  for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+    int32_t fd;
+    if (!absl::SimpleAtoi(entry->d_name, &fd)) {
+      // "." and "..".
+      continue;
+    }
+    ssize_t size = readlinkat(dirfd(dir), entry->d_name, buf, sizeof(buf));
+    if (size < 0) {
+      // The FD was closed since the directory was read.
+      continue;
+    }
+    std::string_view link(buf, size);
+    if (absl::StartsWith(link, prefix)) {
+      out->emplace(fd, link);
+    }
+  }
+  closedir(dir);
+  return Status::OK();
+}
+
 std::string_view LineWithPrefix(std::string_view content, std::string_view prefix) {
   const std::vector<std::string_view> lines = absl::StrSplit(content, "\n");
   for (const auto& line : lines) {
@@ -535,42 +671,18 @@ StatusOr<int64_t> GetPIDStartTimeTicks(const std::filesystem::path& proc_pid_pat
   const std::filesystem::path proc_pid_stat_path = proc_pid_path / "stat";
   const std::string fpath = proc_pid_stat_path.string();
 
-  std::string line;
-
-  // It's usually a big no-no to ifdef based on compilation mode,
-  // but this is a workaround for an ASAN bug that causes crashes and flakiness
-  // in our tests. See //src/common/system/proc_parser_bug_test.cc for details.
-  //
-  // The workaround implementation uses a C functions that don't throw exceptions.
-  // Why not just use the workaround version all the time?
-  // Because it has a hard-coded constant which makes it less robust.
-#if defined(PL_CONFIG_ASAN)
-  std::FILE* fp = std::fopen(fpath.c_str(), "r");
-  if (fp == nullptr) {
-    return error::Internal("Could not open file $0", fpath);
-  }
-
-  // A few quick runs show that /proc/<pid>/stat is <200 characters on my machine,
-  // but a lot of those numbers are 0. If they were non-zero, the string could be much
-  // longer. Hopefully a 4KB block keeps us safe. This is for ASAN only anyways.
-  constexpr int kMaxSupportedProcPIDStatLength = 4096;
-  line.resize(kMaxSupportedProcPIDStatLength);
-  if (std::fgets(line.data(), line.size(), fp) == nullptr) {
-    return error::Internal("Could not get line from file $0", fpath);
-  }
-#else
-  std::ifstream ifs;
-  ifs.open(fpath);
-  if (!ifs) {
-    return error::Internal("Could not open file $0", fpath);
-  }
-
-  if (!std::getline(ifs, line)) {
+  // This used to read the file with std::ifstream, which throws in ASAN builds when the process
+  // exits while the file is read. See //src/common/system/proc_parser_bug_test.cc for details.
+  // ReadProcFile() uses read(2), which returns an error instead.
+  std::string* buf = ProcFileBuffer();
+  PL_RETURN_IF_ERROR(ReadProcFile(fpath, buf));
+  if (buf->empty()) {
     return error::Internal("Could not get line from file $0", fpath);
   }
-#endif
 
-  std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
+  std::vector<std::string_view>* fields = ProcFieldsBuffer();
+  PL_RETURN_IF_ERROR(SplitProcPIDStat(*buf, fields));
+  const std::vector<std::string_view>& split = *fields;
   // We check less than in case more fields are added later.
   if (split.size() < kProcStatNumFields) {
     return error::Internal("Unexpected number of columns in file $0 [columns = $1].", fpath,
@@ -578,7 +690,7 @@ StatusOr<int64_t> GetPIDStartTimeTicks(const std::filesystem::path& proc_pid_pat
   }
 
   int64_t start_time_ticks;
-  if (!absl::SimpleAtoi(split[kProcStatStartTimeField], &start_time_ticks)) {
+  if (!ParseInt(split[kProcStatStartTimeField], &start_time_ticks)) {
     return error::Internal("Time value does not parse in file $0", fpath);
   }
 
@@ -615,6 +727,52 @@ Status ProcParser::ReadMountInfos(pid_t pid,
   return Status::OK();
 }
 
+namespace {
+
+bool ParseHex(std::string_view str, uint64_t* val) {
+  const char* end = str.data() + str.size();
+  auto [ptr, ec] = std::from_chars(str.data(), end, *val, 16);
+  return ec == std::errc() && ptr == end;
+}
+
+Status ParseProcessMap(std::string_view str, ProcParser::ProcessMap* map) {
+  static constexpr int kProcMapNumFields = 6;
+  // The pathname is the last field, and may contain spaces.
+  std::vector<std::string_view> fields =
+      absl::StrSplit(str, absl::MaxSplits(' ', kProcMapNumFields - 1), absl::SkipWhitespace());
+  if (fields.size() < kProcMapNumFields - 1) {
+    return error::InvalidArgument("Maps record should have at least 5 fields, got: $0",
+                                  fields.size());
+  }
+
+  std::vector<std::string_view> addrs = absl::StrSplit(fields[0], '-');
+  if (addrs.size() != 2 || !ParseHex(addrs[0], &map->vmem_start) ||
+      !ParseHex(addrs[1], &map->vmem_end) || !ParseHex(fields[2], &map->file_offset) ||
+      !absl::SimpleAtoi(fields[4], &map->inode)) {
+    return error::InvalidArgument("Malformed maps record: $0", str);
+  }
+  map->permissions = fields[1];
+  map->dev = fields[3];
+  if (fields.size() == kProcMapNumFields) {
+    map->pathname = absl::StripAsciiWhitespace(fields[kProcMapNumFields - 1]);
+  }
+
+  return Status::OK();
+}
+
+}  // namespace
+
+Status ProcParser::ReadProcessMaps(pid_t pid, std::vector<ProcessMap>* maps) const {
+  const std::filesystem::path proc_pid_maps_path = ProcPidPath(pid) / "maps";
+  PL_ASSIGN_OR_RETURN(std::string content, px::ReadFileToString(proc_pid_maps_path));
+  std::vector<std::string_view> lines = absl::StrSplit(content, "\n", absl::SkipWhitespace());
+  for (const auto line : lines) {
+    ProcParser::ProcessMap& map = maps->emplace_back();
+    PL_RETURN_IF_ERROR(ParseProcessMap(line, &map));
+  }
+  return Status::OK();
+}
+
 StatusOr<absl::flat_hash_set<std::string>> ProcParser::GetMapPaths(pid_t pid) {
   static constexpr int kProcMapNumFields = 6;
   absl::flat_hash_set<std::string> map_paths;
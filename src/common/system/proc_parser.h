@@ -196,6 +196,19 @@ class ProcParser {
    */
   Status ReadProcPIDFDLink(int32_t pid, int32_t fd, std::string* out) const;
 
+  /**
+   * Reads the /proc/<pid>/fd/* links that start with the prefix (e.g. "socket:"), in a single
+   * pass over the directory. Cheaper than calling ReadProcPIDFDLink() for each FD of a process
+   * that has many of them.
+   *
+   * @param pid is the pid for which we want the fd links.
+   * @param prefix is the prefix of the links to return; empty for all links.
+   * @param out A valid pointer to the output map, from FD to link.
+   * @return Status of the parsing.
+   */
+  Status ReadProcPIDFDLinks(int32_t pid, std::string_view prefix,
+                            absl::flat_hash_map<int32_t, std::string>* out) const;
+
   /**
    * UIDs associated with a process.
    */
@@ -243,6 +256,32 @@ class ProcParser {
 
   Status ReadMountInfos(pid_t pid, std::vector<MountInfo>* mount_infos) const;
 
+  struct ProcessMap {
+    uint64_t vmem_start = 0;
+    uint64_t vmem_end = 0;
+    // E.g. r-xp.
+    std::string permissions;
+    uint64_t file_offset = 0;
+    // Device of the mapped file, as <major>:<minor>.
+    std::string dev;
+    uint64_t inode = 0;
+    // Empty for anonymous mappings.
+    std::string pathname;
+
+    bool executable() const { return permissions.size() > 2 && permissions[2] == 'x'; }
+
+    std::string ToString() const {
+      return absl::Substitute("[$0-$1] perms=$2 offset=$3 dev=$4 inode=$5 path=$6",
+                              absl::Hex(vmem_start), absl::Hex(vmem_end), permissions,
+                              absl::Hex(file_offset), dev, inode, pathname);
+    }
+  };
+
+  /**
+   * Reads all the entries of /proc/<pid>/maps, in address order.
+   */
+  Status ReadProcessMaps(pid_t pid, std::vector<ProcessMap>* maps) const;
+
   /**
    * Returns all mapped paths found in /proc/<pid>/maps.
    *
@@ -35,6 +35,7 @@ namespace system {
 
 using ::testing::ElementsAre;
 using ::testing::IsEmpty;
+using ::testing::Pair;
 using ::testing::Return;
 using ::testing::ReturnRef;
 using ::testing::UnorderedElementsAre;
@@ -185,6 +186,16 @@ TEST_F(ProcParserTest, read_proc_fd_link) {
 
   s = parser_->ReadProcPIDFDLink(123, 3, &out);
   EXPECT_NOT_OK(s);
+
+  absl::flat_hash_map<int32_t, std::string> links;
+  ASSERT_OK(parser_->ReadProcPIDFDLinks(123, "", &links));
+  EXPECT_THAT(links, UnorderedElementsAre(Pair(0, "/dev/null"), Pair(1, "/foobar"),
+                                          Pair(2, "socket:[12345]")));
+
+  ASSERT_OK(parser_->ReadProcPIDFDLinks(123, "socket:", &links));
+  EXPECT_THAT(links, UnorderedElementsAre(Pair(2, "socket:[12345]")));
+
+  EXPECT_NOT_OK(parser_->ReadProcPIDFDLinks(999999, "", &links));
 }
 
 TEST_F(ProcParserTest, ReadUIDs) {
@@ -226,6 +237,26 @@ TEST_F(ProcParserTest, ReadMountInfos) {
   }
 }
 
+TEST_F(ProcParserTest, ReadProcessMaps) {
+  std::vector<ProcParser::ProcessMap> maps;
+  ASSERT_OK(parser_->ReadProcessMaps(123, &maps));
+  ASSERT_EQ(maps.size(), 44);
+
+  EXPECT_EQ(maps[1].vmem_start, 0x565078f8c000);
+  EXPECT_EQ(maps[1].vmem_end, 0x565079054000);
+  EXPECT_EQ(maps[1].permissions, "r-xp");
+  EXPECT_TRUE(maps[1].executable());
+  EXPECT_EQ(maps[1].file_offset, 0x28000);
+  EXPECT_EQ(maps[1].dev, "103:02");
+  EXPECT_EQ(maps[1].inode, 27147818);
+  EXPECT_EQ(maps[1].pathname, "/usr/sbin/nginx");
+
+  // Anonymous mapping.
+  EXPECT_FALSE(maps[5].executable());
+  EXPECT_EQ(maps[5].inode, 0);
+  EXPECT_EQ(maps[5].pathname, "");
+}
+
 TEST_F(ProcParserTest, GetMapPaths) {
   {
     EXPECT_OK_AND_THAT(
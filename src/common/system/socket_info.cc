@@ -468,51 +468,68 @@ StatusOr<std::unique_ptr<SocketInfoManager>> SocketInfoManager::Create(
   return socket_info_db_ptr;
 }
 
-StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(uint32_t net_ns, NetNamespace(cfg_proc_path_, pid));
+Status SocketInfoManager::ProbeNamespace(uint32_t pid, NamespaceConns* ns_conns) {
+  const uint32_t net_ns = ns_conns->net_ns;
+  PL_ASSIGN_OR_RETURN(NetlinkSocketProber * socket_prober,
+                      socket_probers_->GetOrCreateSocketProber(net_ns, {static_cast<int>(pid)}));
+  DCHECK(socket_prober != nullptr);
 
-  // Step 1: Get the map of connections for this network namespace.
-  // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
+  ns_conns->conns.clear();
+  ns_conns->probed = true;
 
-  auto ns_iter = connections_.find(net_ns);
-  if (ns_iter != connections_.end()) {
-    // Found a map of connections for this network namespace, so use it.
-    namespace_conns = &ns_iter->second;
-  } else {
-    // No map of connections for this network namespace, so use a socker prober to populate one.
-    PL_ASSIGN_OR_RETURN(NetlinkSocketProber * socket_prober,
-                        socket_probers_->GetOrCreateSocketProber(net_ns, {static_cast<int>(pid)}));
-    DCHECK(socket_prober != nullptr);
+  Status s;
 
-    ns_iter = connections_.insert(ns_iter, {net_ns, {}});
-    namespace_conns = &ns_iter->second;
+  s = socket_prober->InetConnections(&ns_conns->conns, cfg_conn_states_);
+  LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe InetConnections [net_ns=$0 msg=$1]",
+                                             net_ns, s.msg());
 
-    Status s;
+  s = socket_prober->UnixConnections(&ns_conns->conns, cfg_conn_states_);
+  LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe UnixConnections [net_ns=$0 msg=$1]",
+                                             net_ns, s.msg());
 
-    s = socket_prober->InetConnections(namespace_conns, cfg_conn_states_);
-    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe InetConnections [net_ns=$0 msg=$1]",
-                                               net_ns, s.msg());
+  ++num_socket_prober_calls_;
+  return Status::OK();
+}
 
-    s = socket_prober->UnixConnections(namespace_conns, cfg_conn_states_);
-    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe UnixConnections [net_ns=$0 msg=$1]",
-                                               net_ns, s.msg());
+StatusOr<SocketInfoManager::NamespaceConns*> SocketInfoManager::GetNamespace(uint32_t pid) {
+  PL_ASSIGN_OR_RETURN(uint32_t net_ns, NetNamespace(cfg_proc_path_, pid));
 
-    ++num_socket_prober_calls_;
+  auto ns_iter = connections_.find(net_ns);
+  if (ns_iter == connections_.end()) {
+    // No snapshot for this network namespace, so use a socket prober to populate one.
+    NamespaceConns ns_conns;
+    ns_conns.net_ns = net_ns;
+    PL_RETURN_IF_ERROR(ProbeNamespace(pid, &ns_conns));
+    ns_iter = connections_.insert(ns_iter, {net_ns, std::move(ns_conns)});
+  } else if (!ns_iter->second.accessed) {
+    // Keep the socket prober of the namespace, so that probing it again does not need to enter
+    // the namespace.
+    socket_probers_->GetSocketProber(net_ns);
   }
 
-  return namespace_conns;
+  NamespaceConns* ns_conns = &ns_iter->second;
+  ns_conns->accessed = true;
+  return ns_conns;
+}
+
+StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
+  PL_ASSIGN_OR_RETURN(NamespaceConns * ns_conns, GetNamespace(pid));
+  return &ns_conns->conns;
 }
 
 StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num) {
-  // Step 1: Get the map of connections for this network namespace.
-  // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
-  PL_ASSIGN_OR_RETURN(namespace_conns, GetNamespaceConns(pid));
+  // Step 1: Get the snapshot of connections for this network namespace.
+  PL_ASSIGN_OR_RETURN(NamespaceConns * ns_conns, GetNamespace(pid));
 
   // Step 2: Lookup the inode.
-  auto iter = namespace_conns->find(inode_num);
-  if (iter == namespace_conns->end()) {
+  auto iter = ns_conns->conns.find(inode_num);
+  if (iter == ns_conns->conns.end() && !ns_conns->probed) {
+    // The snapshot was taken before the last Flush(), and the inode may belong to a newer
+    // connection. Take a new snapshot.
+    PL_RETURN_IF_ERROR(ProbeNamespace(pid, ns_conns));
+    iter = ns_conns->conns.find(inode_num);
+  }
+  if (iter == ns_conns->conns.end()) {
     return error::NotFound(
         "Likely not a TCP/Unix connection (might be some other socket type). Alternatively, might "
         "be looking in the wrong net namespace, which can happen if the target PID has connections "
@@ -524,7 +541,15 @@ StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num
 
 void SocketInfoManager::Flush() {
   socket_probers_->Update();
-  connections_.clear();
+  for (auto iter = connections_.begin(); iter != connections_.end();) {
+    if (!iter->second.accessed) {
+      iter = connections_.erase(iter);
+      continue;
+    }
+    iter->second.probed = false;
+    iter->second.accessed = false;
+    ++iter;
+  }
   num_socket_prober_calls_ = 0;
 }
 
@@ -251,9 +251,10 @@ class SocketProberManager {
  * network namespace, the information is gathered and then cached. Future queries will operate off
  * that snapshot of the known connections, for efficiency.
  *
- * Note that no attempt is made to check if new connections have been created after the snapshot is
- * established. This responsibility is on the user, who must explicitly call Flush(), so that new
- * connections can be discovered.
+ * Snapshots are kept across calls to Flush(), since the information of an inode never changes.
+ * Instead, a lookup for an inode that is not in the snapshot probes the namespace again, at most
+ * once between calls to Flush(), since the inode may belong to a connection created after the
+ * snapshot. Namespaces that are not accessed between two calls to Flush() are dropped.
  */
 class SocketInfoManager {
  public:
@@ -283,12 +284,14 @@ class SocketInfoManager {
    * @param pid The PID owning the connection. Used to determine the network namespace.
    * @param inode_num The inode number of the local socket.
    * @return Information for socket, including remote endpoint information. Returns error if
-   * information could not be queried.
+   * information could not be queried. The pointer is only valid until the next call to Lookup() or
+   * Flush(), since a lookup can replace the snapshot of the namespace.
    */
   StatusOr<SocketInfo*> Lookup(uint32_t pid, uint32_t inode_num);
 
   /**
-   * Flushes the cache so new connections can be discovered.
+   * Starts a new round: allows new connections to be discovered, and drops the namespaces that
+   * were not accessed since the previous call.
    */
   void Flush();
 
@@ -310,9 +313,24 @@ class SocketInfoManager {
   // See connection states at the top of this file.
   const int cfg_conn_states_;
 
-  // Two-level to socket information:
-  // First key is namespace inode; second key is socket inode.
-  std::map<int, std::map<int, SocketInfo>> connections_;
+  struct NamespaceConns {
+    uint32_t net_ns = 0;
+    // Key is the socket inode.
+    std::map<int, SocketInfo> conns;
+    // Whether the namespace was probed since the last Flush().
+    bool probed = false;
+    // Whether the namespace was accessed since the last Flush().
+    bool accessed = false;
+  };
+
+  // Returns the snapshot of the namespace, probing it if there is none yet.
+  StatusOr<NamespaceConns*> GetNamespace(uint32_t pid);
+
+  // Replaces the snapshot of the namespace with the current connections.
+  Status ProbeNamespace(uint32_t pid, NamespaceConns* ns_conns);
+
+  // Key is the namespace inode.
+  std::map<int, NamespaceConns> connections_;
 
   // Portal through which new connection information is gathered,
   // and populated into connections_.
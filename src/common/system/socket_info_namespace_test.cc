@@ -175,7 +175,20 @@ TEST_F(NetNamespaceTest, SocketInfoManager) {
     ASSERT_NE(socket_info, nullptr);
     EXPECT_EQ(socket_info->family, AF_INET);
 
-    // After flush, we should have made one more call.
+    // The inode is in the snapshot, so it is still served from the cache after the flush.
+    EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 0);
+
+    // An unknown inode probes the namespace again, but only once per flush.
+    const uint32_t kUnusedInode = 3;
+    ASSERT_NOT_OK(socket_info_db->Lookup(kPID, kUnusedInode));
+    EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
+    ASSERT_NOT_OK(socket_info_db->Lookup(kPID, kUnusedInode));
+    EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
+
+    // The namespace is dropped if it is not accessed between two flushes.
+    socket_info_db->Flush();
+    socket_info_db->Flush();
+    ASSERT_OK_AND_ASSIGN(socket_info, socket_info_db->Lookup(kPID, inode_num));
     EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
   }
 }
@@ -17,6 +17,8 @@
  */
 
 #include <zlib.h>
+#include <algorithm>
+#include <limits>
 #include <string>
 
 #include "src/common/base/base.h"
@@ -25,36 +27,138 @@
 namespace px {
 namespace zlib {
 
+namespace {
+
+// The smallest output buffer that Inflater::Inflate() starts with.
+constexpr size_t kMinOutputSize = 256;
+// Deflate can't compress by more than this.
+constexpr size_t kMaxDeflateRatio = 1032;
+
+// The size of the output buffer to start decompressing in into. The gzip trailer holds the
+// decompressed size, but it's garbage if the buffer is cut short, so it's capped at the most that
+// the input can hold.
+size_t InitialOutputSize(std::string_view in) {
+  StatusOr<size_t> size = GzipDecompressedSize(in);
+  if (!size.ok()) {
+    return kMinOutputSize;
+  }
+  return std::max(kMinOutputSize, std::min(size.ValueOrDie(), in.size() * kMaxDeflateRatio));
+}
+
+}  // namespace
+
+Inflater::Inflater() : zs_(std::make_unique<z_stream>()) {}
+
+Inflater::~Inflater() {
+  if (initialized_) {
+    inflateEnd(zs_.get());
+  }
+}
+
+StatusOr<bool> Inflater::Inflate(std::string_view in, size_t max_output_size, std::string* out) {
+  z_stream* zs = zs_.get();
+  if (!initialized_) {
+    *zs = {};
+    if (inflateInit2(zs, MAX_WBITS + 16) != Z_OK) {
+      return error::Internal("inflateInit2 failed while decompressing.");
+    }
+    initialized_ = true;
+  } else if (inflateReset(zs) != Z_OK) {
+    return error::Internal("inflateReset failed while decompressing.");
+  }
+
+  if (max_output_size == 0) {
+    out->clear();
+    return false;
+  }
+
+  zs->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs->avail_in = in.size();
+
+  // Growing out only clears the bytes past its previous size, which are all overwritten anyway.
+  out->resize(std::min(max_output_size, std::max(out->capacity(), InitialOutputSize(in))));
+  zs->next_out = reinterpret_cast<Bytef*>(out->data());
+  zs->avail_out = out->size();
+
+  while (true) {
+    int ret = inflate(zs, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) {
+      out->resize(zs->total_out);
+      return true;
+    }
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      out->resize(zs->total_out);
+      return error::Internal("Exception during zlib decompression: $0", zs->msg ? zs->msg : "");
+    }
+
+    if (zs->avail_out == 0) {
+      if (out->size() == max_output_size) {
+        return false;
+      }
+      out->resize(out->size() > max_output_size / 2 ? max_output_size : 2 * out->size());
+      zs->next_out = reinterpret_cast<Bytef*>(out->data() + zs->total_out);
+      zs->avail_out = out->size() - zs->total_out;
+    } else if (zs->avail_in == 0 || ret == Z_BUF_ERROR) {
+      out->resize(zs->total_out);
+      return error::Internal("Exception during zlib decompression: the gzip buffer is incomplete");
+    }
+  }
+}
+
+Inflater& ThreadLocalInflater() {
+  static thread_local Inflater inflater;
+  return inflater;
+}
+
 StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size) {
+  std::string out;
+  out.reserve(output_block_size);
+  PL_RETURN_IF_ERROR(
+      ThreadLocalInflater().Inflate(in, std::numeric_limits<size_t>::max(), &out));
+  return out;
+}
+
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_size) {
+  std::string out;
+  PL_RETURN_IF_ERROR(ThreadLocalInflater().Inflate(in, max_output_size, &out));
+  return out;
+}
+
+StatusOr<size_t> GzipDecompressedSize(std::string_view in) {
+  // A gzip buffer has a 10-byte header, and ends with the CRC32 and the size, 4 bytes each.
+  constexpr size_t kMinGzipSize = 18;
+  if (in.size() < kMinGzipSize) {
+    return error::InvalidArgument("Buffer of $0 bytes is too small to be gzip.", in.size());
+  }
+  const auto* trailer = reinterpret_cast<const uint8_t*>(in.data() + in.size() - 4);
+  return static_cast<size_t>(trailer[0]) | static_cast<size_t>(trailer[1]) << 8 |
+         static_cast<size_t>(trailer[2]) << 16 | static_cast<size_t>(trailer[3]) << 24;
+}
+
+StatusOr<std::string> Deflate(std::string_view in, int level) {
   z_stream zs = {};
 
-  if (inflateInit2(&zs, MAX_WBITS + 16) != Z_OK) {
-    return error::Internal("inflateInit2 failed while decompressing.");
+  if (deflateInit2(&zs, level, Z_DEFLATED, MAX_WBITS + 16, /* memLevel */ 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return error::Internal("deflateInit2 failed while compressing.");
   }
 
-  // Setup input buffer.
   zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
   zs.avail_in = in.size();
 
-  int ret;
+  // deflateBound() gives an upper bound on the compressed size, so a single call suffices.
   std::string out;
+  out.resize(deflateBound(&zs, in.size()));
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
 
-  // Get the decompressed bytes blockwise using repeated calls to inflate.
-  do {
-    out.resize(out.size() + output_block_size);
-    zs.next_out = reinterpret_cast<Bytef*>(out.data() + zs.total_out);
-    zs.avail_out = out.size() - zs.total_out;
-
-    ret = inflate(&zs, 0);
-  } while (ret == Z_OK);
-
+  int ret = deflate(&zs, Z_FINISH);
   out.resize(zs.total_out);
 
-  inflateEnd(&zs);
+  deflateEnd(&zs);
 
   if (ret != Z_STREAM_END) {
-    // An error occurred that was not EOF.
-    return error::Internal("Exception during zlib decompression: $0", zs.msg);
+    return error::Internal("Exception during zlib compression: $0", zs.msg ? zs.msg : "");
   }
 
   return out;
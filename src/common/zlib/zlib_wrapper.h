@@ -18,22 +18,90 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
+#include "src/common/base/mixins.h"
 #include "src/common/base/statusor.h"
 
+// zlib's stream state, see zlib.h.
+struct z_stream_s;
+
 namespace px {
 namespace zlib {
 
+/**
+ * @brief Inflater decompresses gzip buffers one after another with the same zlib stream, which is
+ * reset between buffers instead of being set up (and its window allocated) again for each of them.
+ *
+ * An Inflater must only be used by one thread at a time; ThreadLocalInflater() gives each thread
+ * its own.
+ */
+class Inflater : public NotCopyable {
+ public:
+  Inflater();
+  ~Inflater();
+
+  /**
+   * @brief Inflates (gunzip) a source buffer into out, replacing its contents. The memory of out is
+   * reused, so a caller that keeps the same string across calls stops reallocating once it has
+   * grown to the size of its largest output.
+   *
+   * @param in A view into the source buffer.
+   * @param max_output_size Decompression stops as soon as this many bytes are produced.
+   * @param out The decompressed content, or its first max_output_size bytes.
+   * @return Status or whether out holds the whole content.
+   */
+  StatusOr<bool> Inflate(std::string_view in, size_t max_output_size, std::string* out);
+
+ private:
+  std::unique_ptr<z_stream_s> zs_;
+  bool initialized_ = false;
+};
+
+/**
+ * @brief The Inflater of the calling thread.
+ */
+Inflater& ThreadLocalInflater();
+
 /**
  * @brief Inflates (gunzip) a source buffer and returns the decompressed content as a string.
+ * Uses the thread's Inflater.
  *
  * @param in A view into the source buffer.
- * @param output_block_size How many bytes to decompress into the output buffer at a time.
- *        For small strings, best to keep this only slightly larger than the expected output size.
+ * @param output_block_size The initial size of the output buffer, which is doubled whenever it
+ *        fills up. For small strings, best to keep this only slightly larger than the expected
+ *        output size.
  * @return Status or the decompressed content as a string.
  */
 StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size = 16384);
 
+/**
+ * @brief Inflates (gunzip) only the first bytes of a source buffer. Decompression stops as soon as
+ * max_output_size bytes are produced, so this is much cheaper than Inflate() when only a prefix
+ * of a large content is kept. Uses the thread's Inflater.
+ *
+ * @param in A view into the source buffer.
+ * @param max_output_size The maximum number of decompressed bytes to return.
+ * @return Status or the decompressed prefix, which is shorter than max_output_size only if it is
+ *         the whole content.
+ */
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_size);
+
+/**
+ * @brief Reads the decompressed size of a gzip buffer from its trailer, without decompressing it.
+ * The trailer holds the size modulo 2^32, and is only meaningful for a complete gzip buffer.
+ */
+StatusOr<size_t> GzipDecompressedSize(std::string_view in);
+
+/**
+ * @brief Deflates (gzip) a source buffer. The output can be decompressed with Inflate().
+ *
+ * @param in A view into the source buffer.
+ * @param level The zlib compression level [0-9]. Defaults to the fastest setting.
+ * @return Status or the compressed content as a string.
+ */
+StatusOr<std::string> Deflate(std::string_view in, int level = 1);
+
 }  // namespace zlib
 }  // namespace px
@@ -46,4 +46,77 @@ TEST_F(ZlibTest, inflate_test) {
   EXPECT_OK_AND_EQ(result, GetExpectedResult());
 }
 
+TEST_F(ZlibTest, inflate_prefix_test) {
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 4), "This");
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 0), "");
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 1024), GetExpectedResult());
+
+  std::string truncated = GetCompressedString();
+  truncated.resize(truncated.size() / 2);
+  EXPECT_NOT_OK(px::zlib::InflatePrefix(truncated, 1024));
+}
+
+TEST_F(ZlibTest, inflate_prefix_large_test) {
+  std::string input;
+  for (int i = 0; i < 100000; ++i) {
+    input += GetExpectedResult();
+  }
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(input));
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(compressed, 513), input.substr(0, 513));
+  EXPECT_OK_AND_EQ(px::zlib::GzipDecompressedSize(compressed), input.size());
+}
+
+TEST_F(ZlibTest, gzip_decompressed_size_test) {
+  EXPECT_OK_AND_EQ(px::zlib::GzipDecompressedSize(GetCompressedString()),
+                   GetExpectedResult().size());
+  EXPECT_NOT_OK(px::zlib::GzipDecompressedSize("abc"));
+}
+
+TEST_F(ZlibTest, deflate_round_trip_test) {
+  std::string input;
+  for (int i = 0; i < 100; ++i) {
+    input += GetExpectedResult();
+  }
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(input));
+  EXPECT_LT(compressed.size(), input.size());
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(compressed), input);
+}
+
+TEST_F(ZlibTest, deflate_empty_test) {
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(""));
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(compressed), "");
+}
+
+TEST_F(ZlibTest, inflater_reuse_test) {
+  std::string large_input;
+  for (int i = 0; i < 10000; ++i) {
+    large_input += GetExpectedResult();
+  }
+  ASSERT_OK_AND_ASSIGN(std::string large_compressed, px::zlib::Deflate(large_input));
+
+  px::zlib::Inflater inflater;
+  std::string out;
+  EXPECT_OK_AND_EQ(inflater.Inflate(GetCompressedString(), 1024, &out), true);
+  EXPECT_EQ(out, GetExpectedResult());
+
+  EXPECT_OK_AND_EQ(inflater.Inflate(large_compressed, large_input.size(), &out), true);
+  EXPECT_EQ(out, large_input);
+
+  // The output is capped, and keeps its memory for the next call.
+  const char* data = out.data();
+  EXPECT_OK_AND_EQ(inflater.Inflate(large_compressed, 100, &out), false);
+  EXPECT_EQ(out, large_input.substr(0, 100));
+  EXPECT_OK_AND_EQ(inflater.Inflate(GetCompressedString(), 1024, &out), true);
+  EXPECT_EQ(out, GetExpectedResult());
+  EXPECT_EQ(out.data(), data);
+
+  // A failed buffer doesn't affect the next one.
+  std::string truncated = GetCompressedString();
+  truncated.resize(truncated.size() / 2);
+  EXPECT_NOT_OK(inflater.Inflate(truncated, 1024, &out));
+  EXPECT_NOT_OK(inflater.Inflate("not gzip", 1024, &out));
+  EXPECT_OK_AND_EQ(inflater.Inflate(GetCompressedString(), 1024, &out), true);
+  EXPECT_EQ(out, GetExpectedResult());
+}
+
 }  // namespace px
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package main
+
+import (
+	"bufio"
+	"context"
+	"crypto/tls"
+	"encoding/json"
+	"fmt"
+	"io"
+	"net/http"
+	"os"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/olekukonko/tablewriter"
+	log "github.com/sirupsen/logrus"
+	"github.com/spf13/pflag"
+	"github.com/spf13/viper"
+
+	"px.dev/pixie/src/shared/services"
+)
+
+// The kernel reports CPU times in /proc/<pid>/stat in clock ticks. USER_HZ is 100 on all the
+// architectures we run on.
+const clockTicksPerSecond = 100
+
+func init() {
+	pflag.String("target_url", "http://localhost:50100/", "The URL of the demo app to load")
+	pflag.String("protocol", "http", "The protocol of the demo app, used to label the results")
+	pflag.Bool("insecure_skip_verify", true, "Skip verification of the demo app TLS certificate")
+	pflag.Float64("rps", 1000, "The rate at which requests are sent")
+	pflag.Int("concurrency", 64, "The maximum number of requests in flight")
+	pflag.Duration("duration", time.Minute, "How long to load the demo app for")
+	pflag.Duration("warmup", 10*time.Second, "How long to load the demo app for before measuring")
+	pflag.Int("pem_pid", 0, "The PID of the PEM tracing the demo app. 0 means the PEM isn't running")
+	pflag.String("release", "", "The release of the PEM, used to label the results")
+	pflag.String("output", "", "The file to write the results to, as JSON")
+	pflag.String("baseline", "", "The results of a baseline run to compare against, as JSON")
+	pflag.Float64("max_regression", 0.1, "The relative regression over the baseline that fails the run")
+}
+
+// runLoad sends requests at a fixed rate, and returns the latencies of the successful requests.
+// Latencies are measured from the time each request was scheduled, so that a slow app doesn't
+// hide its latency by slowing down the load (coordinated omission).
+func runLoad(ctx context.Context, client *http.Client, url string, rps float64, concurrency int,
+	duration time.Duration) ([]time.Duration, int) {
+	scheduled := make(chan time.Time, concurrency)
+	var mu sync.Mutex
+	var latencies []time.Duration
+	numErrors := 0
+
+	var wg sync.WaitGroup
+	for i := 0; i < concurrency; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for start := range scheduled {
+				err := sendRequest(ctx, client, url)
+				latency := time.Since(start)
+				mu.Lock()
+				if err != nil {
+					numErrors++
+				} else {
+					latencies = append(latencies, latency)
+				}
+				mu.Unlock()
+			}
+		}()
+	}
+
+	interval := time.Duration(float64(time.Second) / rps)
+	start := time.Now()
+	for next := start; next.Sub(start) < duration; next = next.Add(interval) {
+		time.Sleep(time.Until(next))
+		scheduled <- next
+	}
+	close(scheduled)
+	wg.Wait()
+	return latencies, numErrors
+}
+
+func sendRequest(ctx context.Context, client *http.Client, url string) error {
+	req, err := http.NewRequestWithContext(ctx, http.MethodGet, url, nil)
+	if err != nil {
+		return err
+	}
+	resp, err := client.Do(req)
+	if err != nil {
+		return err
+	}
+	defer resp.Body.Close()
+	// Read the body, so that the connection is reused.
+	if _, err := io.Copy(io.Discard, resp.Body); err != nil {
+		return err
+	}
+	if resp.StatusCode != http.StatusOK {
+		return fmt.Errorf("unexpected status %d", resp.StatusCode)
+	}
+	return nil
+}
+
+// readCPUTime returns the user+system CPU time used so far by the process.
+func readCPUTime(pid int) (time.Duration, error) {
+	stat, err := os.ReadFile(fmt.Sprintf("/proc/%d/stat", pid))
+	if err != nil {
+		return 0, err
+	}
+	// The command name may contain spaces, so the fields are counted from its closing paren.
+	fields := strings.Fields(string(stat[strings.LastIndexByte(string(stat), ')')+1:]))
+	// utime and stime are fields 14 and 15 of the file; fields[0] is field 3.
+	if len(fields) < 13 {
+		return 0, fmt.Errorf("malformed /proc/%d/stat", pid)
+	}
+	var ticks int64
+	for _, field := range fields[11:13] {
+		t, err := strconv.ParseInt(field, 10, 64)
+		if err != nil {
+			return 0, err
+		}
+		ticks += t
+	}
+	return time.Duration(ticks) * time.Second / clockTicksPerSecond, nil
+}
+
+// readRSS returns the resident set size of the process.
+func readRSS(pid int) (int64, error) {
+	f, err := os.Open(fmt.Sprintf("/proc/%d/status", pid))
+	if err != nil {
+		return 0, err
+	}
+	defer f.Close()
+	scanner := bufio.NewScanner(f)
+	for scanner.Scan() {
+		fields := strings.Fields(scanner.Text())
+		if len(fields) == 3 && fields[0] == "VmRSS:" {
+			kb, err := strconv.ParseInt(fields[1], 10, 64)
+			return kb * 1024, err
+		}
+	}
+	return 0, fmt.Errorf("no VmRSS in /proc/%d/status", pid)
+}
+
+// samplePEM records the CPU usage and the peak RSS of the PEM until ctx is done.
+func samplePEM(ctx context.Context, pid int, result *Result) error {
+	startCPU, err := readCPUTime(pid)
+	if err != nil {
+		return err
+	}
+	start := time.Now()
+	ticker := time.NewTicker(time.Second)
+	defer ticker.Stop()
+	for {
+		rss, err := readRSS(pid)
+		if err != nil {
+			return err
+		}
+		if rss > result.PEMMaxRSS {
+			result.PEMMaxRSS = rss
+		}
+		select {
+		case <-ctx.Done():
+			endCPU, err := readCPUTime(pid)
+			if err != nil {
+				return err
+			}
+			result.PEMCPUCores = float64(endCPU-startCPU) / float64(time.Since(start))
+			return nil
+		case <-ticker.C:
+		}
+	}
+}
+
+func readResult(path string) (*Result, error) {
+	content, err := os.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	result := &Result{}
+	if err := json.Unmarshal(content, result); err != nil {
+		return nil, err
+	}
+	return result, nil
+}
+
+func writeResult(path string, result *Result) error {
+	content, err := json.MarshalIndent(result, "", "  ")
+	if err != nil {
+		return err
+	}
+	return os.WriteFile(path, content, 0644)
+}
+
+func writeSummary(result *Result) {
+	table := tablewriter.NewWriter(os.Stdout)
+	table.SetHeader([]string{"Metric", "Value"})
+	table.Append([]string{"Throughput (req/s)", fmt.Sprintf("%.1f", result.AchievedRPS)})
+	table.Append([]string{"Errors", fmt.Sprintf("%d / %d", result.NumErrors, result.NumRequests)})
+	table.Append([]string{"p50 latency", result.P50.String()})
+	table.Append([]string{"p99 latency", result.P99.String()})
+	if result.WithPEM {
+		table.Append([]string{"PEM CPU cores per 1k req/s", fmt.Sprintf("%.3f", result.PEMCPUCoresPer1kRPS())})
+		table.Append([]string{"PEM max RSS (MiB)", fmt.Sprintf("%.1f", mib(result.PEMMaxRSS))})
+	}
+	table.Render()
+}
+
+func writeReport(baseline, current *Result, comparisons []Comparison) {
+	fmt.Printf("%s (PEM: %v) vs. baseline %s (PEM: %v), %s at %.0f req/s\n", current.Release,
+		current.WithPEM, baseline.Release, baseline.WithPEM, current.Protocol, current.TargetRPS)
+	table := tablewriter.NewWriter(os.Stdout)
+	table.SetHeader([]string{"Metric", "Baseline", "Current", "Regression", "Status"})
+	for _, c := range comparisons {
+		status := "OK"
+		if c.Failed {
+			status = "FAILED"
+		}
+		table.Append([]string{c.Metric, fmt.Sprintf("%.3f", c.Baseline), fmt.Sprintf("%.3f", c.Current),
+			fmt.Sprintf("%+.1f%%", 100*c.Regression), status})
+	}
+	table.Render()
+}
+
+func main() {
+	services.PostFlagSetupAndParse()
+
+	pemPID := viper.GetInt("pem_pid")
+	result := &Result{
+		Release:   viper.GetString("release"),
+		Protocol:  viper.GetString("protocol"),
+		WithPEM:   pemPID != 0,
+		TargetRPS: viper.GetFloat64("rps"),
+	}
+
+	client := &http.Client{
+		Timeout: 10 * time.Second,
+		Transport: &http.Transport{
+			MaxIdleConnsPerHost: viper.GetInt("concurrency"),
+			TLSClientConfig:     &tls.Config{InsecureSkipVerify: viper.GetBool("insecure_skip_verify")},
+		},
+	}
+	url := viper.GetString("target_url")
+	ctx := context.Background()
+
+	log.Infof("Warming up %s for %v", url, viper.GetDuration("warmup"))
+	runLoad(ctx, client, url, result.TargetRPS, viper.GetInt("concurrency"), viper.GetDuration("warmup"))
+
+	sampleCtx, stopSampling := context.WithCancel(ctx)
+	var sampleErr error
+	var sampleWG sync.WaitGroup
+	if result.WithPEM {
+		sampleWG.Add(1)
+		go func() {
+			defer sampleWG.Done()
+			sampleErr = samplePEM(sampleCtx, pemPID, result)
+		}()
+	}
+
+	log.Infof("Loading %s at %.0f req/s for %v", url, result.TargetRPS, viper.GetDuration("duration"))
+	start := time.Now()
+	latencies, numErrors := runLoad(ctx, client, url, result.TargetRPS, viper.GetInt("concurrency"),
+		viper.GetDuration("duration"))
+	elapsed := time.Since(start)
+	stopSampling()
+	sampleWG.Wait()
+	if sampleErr != nil {
+		log.WithError(sampleErr).Fatalf("Failed to sample the PEM (pid=%d)", pemPID)
+	}
+	result.Summarize(latencies, numErrors, elapsed)
+
+	if output := viper.GetString("output"); output != "" {
+		if err := writeResult(output, result); err != nil {
+			log.WithError(err).Fatal("Failed to write the results")
+		}
+	}
+
+	baselinePath := viper.GetString("baseline")
+	if baselinePath == "" {
+		writeSummary(result)
+		return
+	}
+	baseline, err := readResult(baselinePath)
+	if err != nil {
+		log.WithError(err).Fatal("Failed to read the baseline results")
+	}
+	comparisons := Compare(baseline, result, viper.GetFloat64("max_regression"))
+	writeReport(baseline, result, comparisons)
+	for _, c := range comparisons {
+		if c.Failed {
+			log.Fatalf("Regression over the baseline: %s", c.String())
+		}
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package main
+
+import (
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/assert"
+)
+
+func TestPercentile(t *testing.T) {
+	var latencies []time.Duration
+	for i := 1; i <= 100; i++ {
+		latencies = append(latencies, time.Duration(i)*time.Millisecond)
+	}
+	assert.Equal(t, 50*time.Millisecond, Percentile(latencies, 0.5))
+	assert.Equal(t, 99*time.Millisecond, Percentile(latencies, 0.99))
+	assert.Equal(t, 100*time.Millisecond, Percentile(latencies, 1))
+	assert.Equal(t, time.Duration(0), Percentile(nil, 0.5))
+}
+
+func TestSummarize(t *testing.T) {
+	r := &Result{}
+	r.Summarize([]time.Duration{3 * time.Millisecond, time.Millisecond, 2 * time.Millisecond}, 1,
+		time.Second)
+	assert.Equal(t, 4, r.NumRequests)
+	assert.Equal(t, 1, r.NumErrors)
+	assert.Equal(t, 3.0, r.AchievedRPS)
+	assert.Equal(t, 2*time.Millisecond, r.P50)
+	assert.Equal(t, 3*time.Millisecond, r.P99)
+}
+
+func TestCompare(t *testing.T) {
+	baseline := &Result{
+		WithPEM:     true,
+		AchievedRPS: 1000,
+		NumRequests: 1000,
+		P50:         time.Millisecond,
+		P99:         10 * time.Millisecond,
+		PEMCPUCores: 0.5,
+		PEMMaxRSS:   500 << 20,
+	}
+	current := *baseline
+	current.P99 = 12 * time.Millisecond
+	current.PEMCPUCores = 0.52
+
+	comparisons := Compare(baseline, &current, 0.1)
+	assert.Len(t, comparisons, 6)
+	failed := map[string]bool{}
+	for _, c := range comparisons {
+		failed[c.Metric] = c.Failed
+	}
+	assert.True(t, failed["p99 latency (ms)"])
+	assert.False(t, failed["p50 latency (ms)"])
+	assert.False(t, failed["PEM CPU cores per 1k req/s"])
+	assert.False(t, failed["Throughput (req/s)"])
+
+	// A baseline without the PEM measures the overhead on the app only.
+	baseline.WithPEM = false
+	assert.Len(t, Compare(baseline, &current, 0.1), 4)
+}
+
+func TestCompareThroughputDrop(t *testing.T) {
+	baseline := &Result{AchievedRPS: 1000}
+	current := &Result{AchievedRPS: 800}
+	comparisons := Compare(baseline, current, 0.1)
+	assert.Equal(t, "Throughput (req/s)", comparisons[0].Metric)
+	assert.InDelta(t, 0.2, comparisons[0].Regression, 1e-9)
+	assert.True(t, comparisons[0].Failed)
+}
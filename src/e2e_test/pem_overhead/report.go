@@ -0,0 +1,152 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package main
+
+import (
+	"fmt"
+	"sort"
+	"time"
+)
+
+// Result holds the measurements of one load run against a demo app.
+type Result struct {
+	Release  string `json:"release"`
+	Protocol string `json:"protocol"`
+	// Whether the PEM was tracing the app during the run.
+	WithPEM     bool          `json:"with_pem"`
+	TargetRPS   float64       `json:"target_rps"`
+	AchievedRPS float64       `json:"achieved_rps"`
+	NumRequests int           `json:"num_requests"`
+	NumErrors   int           `json:"num_errors"`
+	P50         time.Duration `json:"p50_ns"`
+	P99         time.Duration `json:"p99_ns"`
+	// The PEM measurements are only set if WithPEM is true.
+	PEMCPUCores float64 `json:"pem_cpu_cores"`
+	PEMMaxRSS   int64   `json:"pem_max_rss_bytes"`
+}
+
+// PEMCPUCoresPer1kRPS normalizes the PEM CPU usage by the load, so that runs at different rates
+// can be compared.
+func (r *Result) PEMCPUCoresPer1kRPS() float64 {
+	if r.AchievedRPS == 0 {
+		return 0
+	}
+	return r.PEMCPUCores / (r.AchievedRPS / 1000)
+}
+
+// Percentile returns the p-th percentile (0 < p <= 1) of the latencies, which must be sorted.
+func Percentile(sorted []time.Duration, p float64) time.Duration {
+	if len(sorted) == 0 {
+		return 0
+	}
+	idx := int(float64(len(sorted))*p+0.5) - 1
+	if idx < 0 {
+		idx = 0
+	}
+	if idx >= len(sorted) {
+		idx = len(sorted) - 1
+	}
+	return sorted[idx]
+}
+
+// Summarize fills in the request stats of the result from the latencies of the successful
+// requests.
+func (r *Result) Summarize(latencies []time.Duration, numErrors int, elapsed time.Duration) {
+	sort.Slice(latencies, func(i, j int) bool { return latencies[i] < latencies[j] })
+	r.NumRequests = len(latencies) + numErrors
+	r.NumErrors = numErrors
+	r.AchievedRPS = float64(len(latencies)) / elapsed.Seconds()
+	r.P50 = Percentile(latencies, 0.5)
+	r.P99 = Percentile(latencies, 0.99)
+}
+
+// Comparison is one metric of a run compared against the same metric of a baseline run.
+type Comparison struct {
+	Metric   string
+	Baseline float64
+	Current  float64
+	// Relative change, positive when the current run is worse.
+	Regression float64
+	Failed     bool
+}
+
+func relativeChange(baseline, current float64, higherIsWorse bool) float64 {
+	if baseline == 0 {
+		return 0
+	}
+	change := (current - baseline) / baseline
+	if !higherIsWorse {
+		change = -change
+	}
+	return change
+}
+
+// Compare compares the current run against the baseline run. The baseline is either a run of the
+// same release without the PEM (to measure the overhead on the app), or a run of the previous
+// release (to catch regressions). The PEM metrics are only compared if both runs traced the app.
+// A metric fails if it is worse than the baseline by more than maxRegression.
+func Compare(baseline, current *Result, maxRegression float64) []Comparison {
+	type metric struct {
+		name          string
+		baseline      float64
+		current       float64
+		higherIsWorse bool
+	}
+	metrics := []metric{
+		{"Throughput (req/s)", baseline.AchievedRPS, current.AchievedRPS, false},
+		{"p50 latency (ms)", ms(baseline.P50), ms(current.P50), true},
+		{"p99 latency (ms)", ms(baseline.P99), ms(current.P99), true},
+		{"Error rate", errorRate(baseline), errorRate(current), true},
+	}
+	if baseline.WithPEM && current.WithPEM {
+		metrics = append(metrics,
+			metric{"PEM CPU cores per 1k req/s", baseline.PEMCPUCoresPer1kRPS(),
+				current.PEMCPUCoresPer1kRPS(), true},
+			metric{"PEM max RSS (MiB)", mib(baseline.PEMMaxRSS), mib(current.PEMMaxRSS), true})
+	}
+
+	comparisons := make([]Comparison, len(metrics))
+	for i, m := range metrics {
+		regression := relativeChange(m.baseline, m.current, m.higherIsWorse)
+		comparisons[i] = Comparison{
+			Metric:     m.name,
+			Baseline:   m.baseline,
+			Current:    m.current,
+			Regression: regression,
+			Failed:     regression > maxRegression,
+		}
+	}
+	return comparisons
+}
+
+func ms(d time.Duration) float64 { return float64(d) / float64(time.Millisecond) }
+
+func mib(bytes int64) float64 { return float64(bytes) / (1 << 20) }
+
+func errorRate(r *Result) float64 {
+	if r.NumRequests == 0 {
+		return 0
+	}
+	return float64(r.NumErrors) / float64(r.NumRequests)
+}
+
+// String formats the comparison for the regression report.
+func (c *Comparison) String() string {
+	return fmt.Sprintf("%s: %.3f -> %.3f (%+.1f%%)", c.Metric, c.Baseline, c.Current, 100*c.Regression)
+}
@@ -17,6 +17,8 @@
  */
 
 #include <math.h>
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <utility>
 
@@ -31,8 +33,37 @@ PL_SUPPRESS_WARNINGS_END()
 namespace px {
 namespace bloomfilter {
 
+namespace {
+
+// The odd constants that pick the bit of each word of a block, from the split block bloom filters
+// of Parquet and Impala.
+constexpr uint32_t kBlockSalts[] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+// The number of items that ContainsMany hashes (and prefetches the blocks of) ahead of testing
+// them.
+constexpr size_t kContainsManyBatch = 32;
+
+// The false positive rate of a split block filter whose blocks hold entries_per_block entries on
+// average. The number of entries of a block is Poisson distributed, and an item that isn't in the
+// filter matches a block of k entries if its bit is set in each of the block's words.
+double SplitBlockErrorRate(double entries_per_block, int block_words) {
+  double rate = 0;
+  // The probability that a block holds k entries.
+  double p = std::exp(-entries_per_block);
+  auto max_k = static_cast<int64_t>(entries_per_block + 10 * std::sqrt(entries_per_block) + 20);
+  for (int64_t k = 0; k <= max_k; ++k) {
+    rate += p * std::pow(1 - std::pow(1 - 1.0 / 32, k), block_words);
+    p *= entries_per_block / (k + 1);
+  }
+  return rate;
+}
+
+}  // namespace
+
 StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64_t max_entries,
-                                                                           double error_rate) {
+                                                                           double error_rate,
+                                                                           Layout layout) {
   if (error_rate <= 0.0 || error_rate >= 1.0) {
     return error::Internal(
         "Bloom filter error rate must be greater than 0 and less than 1, received %e", error_rate);
@@ -42,6 +73,23 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64
                            max_entries);
   }
 
+  if (layout == kSplitBlock) {
+    // If the entries were spread evenly over the blocks, each bit of an item would be set with
+    // the same probability, which gives bits = -kBlockWords * entries / ln(1 - error_rate^(1 /
+    // kBlockWords)). Some blocks get more entries than others though, so the filter is then grown
+    // until it meets the error rate.
+    double num_bits =
+        -kBlockWords * max_entries / std::log(1 - std::pow(error_rate, 1.0 / kBlockWords));
+    int64_t num_blocks =
+        std::max<int64_t>(1, static_cast<int64_t>(std::ceil(num_bits / (8 * kBlockBytes))));
+    while (SplitBlockErrorRate(static_cast<double>(max_entries) / num_blocks, kBlockWords) >
+           error_rate) {
+      num_blocks += std::max<int64_t>(1, num_blocks / 20);
+    }
+    return std::unique_ptr<XXHash64BloomFilter>(
+        new XXHash64BloomFilter(num_blocks * kBlockBytes, kBlockWords, kSplitBlock));
+  }
+
   // From Wikipedia: https://en.wikipedia.org/wiki/Bloom_filter
   // bits per entry = ln(error_rate)/ln(2)^2
   double bpe = -(std::log(error_rate) / std::pow(std::log(2), 2));
@@ -65,13 +113,28 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::FromProto(
     return error::Internal("Received 0 hash functions in BloomFilter num_hashes field");
   }
 
+  switch (pb.layout()) {
+    case kStandard:
+      break;
+    case kSplitBlock:
+      if (bytes_str.size() % kBlockBytes != 0) {
+        return error::Internal("Split block BloomFilter data is not a multiple of $0 bytes",
+                               kBlockBytes);
+      }
+      break;
+    default:
+      return error::Internal("Received unknown BloomFilter layout $0", pb.layout());
+  }
+
   std::vector<uint8_t> data{bytes_str.begin(), bytes_str.end()};
-  return std::unique_ptr<XXHash64BloomFilter>(new XXHash64BloomFilter(data, pb.num_hashes()));
+  return std::unique_ptr<XXHash64BloomFilter>(
+      new XXHash64BloomFilter(data, pb.num_hashes(), pb.layout()));
 }
 
 XXHash64BloomFilterPB XXHash64BloomFilter::ToProto() {
   XXHash64BloomFilterPB output;
   output.set_num_hashes(num_hashes_);
+  output.set_layout(layout_);
   std::string bytes_str{buffer_.begin(), buffer_.end()};
   output.set_data(std::move(bytes_str));
   return output;
@@ -89,7 +152,44 @@ bool XXHash64BloomFilter::HasBitSet(int bit_number) const {
   return buffer_[byte_index] & mask;
 }
 
+size_t XXHash64BloomFilter::BlockOffset(uint64_t hash) const {
+  // Maps the top 32 bits of the hash onto the blocks, without a division.
+  uint64_t num_blocks = buffer_.size() / kBlockBytes;
+  return ((hash >> 32) * num_blocks >> 32) * kBlockBytes;
+}
+
+// The blocks are copied in and out of arrays of words, which the compiler keeps in vector
+// registers, so both loops below turn into a handful of SIMD instructions. The words are stored in
+// host order, which is little-endian on all the platforms we run on.
+void XXHash64BloomFilter::InsertIntoBlock(uint64_t hash) {
+  uint8_t* data = buffer_.data() + BlockOffset(hash);
+  auto key = static_cast<uint32_t>(hash);
+  uint32_t block[kBlockWords];
+  std::memcpy(block, data, kBlockBytes);
+  for (int i = 0; i < kBlockWords; ++i) {
+    block[i] |= uint32_t{1} << ((key * kBlockSalts[i]) >> 27);
+  }
+  std::memcpy(data, block, kBlockBytes);
+}
+
+bool XXHash64BloomFilter::BlockContains(uint64_t hash) const {
+  const uint8_t* data = buffer_.data() + BlockOffset(hash);
+  auto key = static_cast<uint32_t>(hash);
+  uint32_t block[kBlockWords];
+  std::memcpy(block, data, kBlockBytes);
+  uint32_t missing = 0;
+  for (int i = 0; i < kBlockWords; ++i) {
+    missing |= ~block[i] & (uint32_t{1} << ((key * kBlockSalts[i]) >> 27));
+  }
+  return missing == 0;
+}
+
 void XXHash64BloomFilter::Insert(std::string_view item) {
+  if (layout_ == kSplitBlock) {
+    InsertIntoBlock(XXH64(item.data(), item.size(), seed_));
+    return;
+  }
+
   uint64_t a = XXH64(item.data(), item.size(), seed_);
   uint64_t b = XXH64(item.data(), item.size(), a);
 
@@ -103,6 +203,10 @@ void XXHash64BloomFilter::Insert(std::string_view item) {
 }
 
 bool XXHash64BloomFilter::Contains(std::string_view item) const {
+  if (layout_ == kSplitBlock) {
+    return BlockContains(XXH64(item.data(), item.size(), seed_));
+  }
+
   uint64_t a = XXH64(item.data(), item.size(), seed_);
   uint64_t b = XXH64(item.data(), item.size(), a);
 
@@ -116,5 +220,31 @@ bool XXHash64BloomFilter::Contains(std::string_view item) const {
   return true;
 }
 
+std::vector<bool> XXHash64BloomFilter::ContainsMany(
+    const std::vector<std::string_view>& items) const {
+  std::vector<bool> results(items.size());
+  if (layout_ != kSplitBlock) {
+    for (size_t i = 0; i < items.size(); ++i) {
+      results[i] = Contains(items[i]);
+    }
+    return results;
+  }
+
+  // Each item needs a single block, so the blocks of a batch of items are all requested before
+  // the first one is tested.
+  uint64_t hashes[kContainsManyBatch];
+  for (size_t begin = 0; begin < items.size(); begin += kContainsManyBatch) {
+    size_t end = std::min(items.size(), begin + kContainsManyBatch);
+    for (size_t i = begin; i < end; ++i) {
+      hashes[i - begin] = XXH64(items[i].data(), items[i].size(), seed_);
+      __builtin_prefetch(buffer_.data() + BlockOffset(hashes[i - begin]));
+    }
+    for (size_t i = begin; i < end; ++i) {
+      results[i] = BlockContains(hashes[i - begin]);
+    }
+  }
+  return results;
+}
+
 }  // namespace bloomfilter
 }  // namespace px
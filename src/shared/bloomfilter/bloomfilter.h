@@ -33,12 +33,21 @@ using XXHash64BloomFilterPB = shared::bloomfilterpb::XXHash64BloomFilter;
 
 class XXHash64BloomFilter {
  public:
+  using Layout = XXHash64BloomFilterPB::Layout;
+  // Each entry sets num_hashes bits anywhere in the buffer.
+  static constexpr Layout kStandard = XXHash64BloomFilterPB::STANDARD;
+  // Each entry sets one bit in each 32-bit word of a single 256-bit block of the buffer, so
+  // lookups cost one cache miss instead of up to num_hashes. Takes a little more space than the
+  // standard layout for the same error rate.
+  static constexpr Layout kSplitBlock = XXHash64BloomFilterPB::SPLIT_BLOCK;
+
   /**
    * Create creates a bloom filter which is sized to meet the criteria for maximum number of
    * entries and the false positive error rate. The false negative error rate is always 0.
    */
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> Create(int64_t max_entries,
-                                                               double error_rate);
+                                                               double error_rate,
+                                                               Layout layout = kStandard);
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> FromProto(const XXHash64BloomFilterPB& pb);
   XXHash64BloomFilterPB ToProto();
 
@@ -55,6 +64,12 @@ class XXHash64BloomFilter {
   bool Contains(std::string_view item) const;
   bool Contains(const std::string& item) const { return Contains(std::string_view(item)); }
 
+  /**
+   * ContainsMany checks for the presence of each of the items. The lookups are interleaved, so
+   * that the cache misses of the different items overlap.
+   */
+  std::vector<bool> ContainsMany(const std::vector<std::string_view>& items) const;
+
   /**
    * Get the buffer size in bytes of the bloom filter.
    */
@@ -65,18 +80,31 @@ class XXHash64BloomFilter {
    */
   int num_hashes() const { return num_hashes_; }
 
+  Layout layout() const { return layout_; }
+
  protected:
-  XXHash64BloomFilter(int64_t num_bytes, int num_hashes)
-      : XXHash64BloomFilter(std::vector<uint8_t>(num_bytes, 0), num_hashes) {}
+  XXHash64BloomFilter(int64_t num_bytes, int num_hashes, Layout layout = kStandard)
+      : XXHash64BloomFilter(std::vector<uint8_t>(num_bytes, 0), num_hashes, layout) {}
 
-  XXHash64BloomFilter(const std::vector<uint8_t>& buffer, int32_t num_hashes)
-      : num_hashes_(num_hashes), buffer_(buffer) {}
+  XXHash64BloomFilter(const std::vector<uint8_t>& buffer, int32_t num_hashes,
+                      Layout layout = kStandard)
+      : num_hashes_(num_hashes), layout_(layout), buffer_(buffer) {}
 
  private:
+  static constexpr int kBlockWords = 8;
+  static constexpr int kBlockBytes = kBlockWords * sizeof(uint32_t);
+
   void SetBit(int bit_number);
   bool HasBitSet(int bit_number) const;
 
+  // The offset in buffer_ of the block that holds the bits of the hash, for the split block
+  // layout.
+  size_t BlockOffset(uint64_t hash) const;
+  void InsertIntoBlock(uint64_t hash);
+  bool BlockContains(uint64_t hash) const;
+
   const int num_hashes_;
+  const Layout layout_;
   std::vector<uint8_t> buffer_;
   const uint64_t seed_ = 3091990;
 };
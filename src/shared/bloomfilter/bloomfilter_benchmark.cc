@@ -35,8 +35,12 @@ class BloomFilterBenchmark : public benchmark::Fixture {
     auto num_items = state.range(0);
     auto error_rate = 1.0 / state.range(1);
     auto strlen = state.range(2);
-    insert_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
-    lookup_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
+    auto layout =
+        state.range(3) ? XXHash64BloomFilter::kSplitBlock : XXHash64BloomFilter::kStandard;
+    insert_bf_ =
+        XXHash64BloomFilter::Create(num_items * 2, error_rate, layout).ConsumeValueOrDie();
+    lookup_bf_ =
+        XXHash64BloomFilter::Create(num_items * 2, error_rate, layout).ConsumeValueOrDie();
     random_strs_.reserve(num_items);
     for (auto i = 0; i < num_items; ++i) {
       random_strs_.push_back(datagen::RandomString(strlen));
@@ -74,10 +78,24 @@ BENCHMARK_DEFINE_F(BloomFilterBenchmark, LookupTest)(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations() * random_strs_.size());
 }
 
+// NOLINTNEXTLINE : runtime/references.
+BENCHMARK_DEFINE_F(BloomFilterBenchmark, ContainsManyTest)(benchmark::State& state) {
+  std::vector<std::string_view> items(random_strs_.begin(), random_strs_.end());
+  for (auto _ : state) {
+    std::vector<bool> results = lookup_bf_->ContainsMany(items);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetBytesProcessed(state.iterations() * random_strs_.size() * random_strs_[0].size());
+  state.SetItemsProcessed(state.iterations() * random_strs_.size());
+}
+
+// The last argument picks the layout: 0 for the standard one, 1 for split blocks.
 BENCHMARK_REGISTER_F(BloomFilterBenchmark, InsertTest)
-    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}, {0, 1}});
 BENCHMARK_REGISTER_F(BloomFilterBenchmark, LookupTest)
-    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}, {0, 1}});
+BENCHMARK_REGISTER_F(BloomFilterBenchmark, ContainsManyTest)
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}, {0, 1}});
 
 }  // namespace bloomfilter
 }  // namespace px
@@ -16,8 +16,12 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <absl/strings/str_cat.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 #include "src/shared/bloomfilter/bloomfilter.h"
 
 namespace px {
@@ -113,5 +117,79 @@ TEST(XXHash64BloomFilter, test_create_from_proto) {
   }
 }
 
+TEST(XXHash64BloomFilter, split_block_create) {
+  auto bf1 = XXHash64BloomFilter::Create(10, 0.1, XXHash64BloomFilter::kSplitBlock)
+                 .ConsumeValueOrDie();
+  EXPECT_EQ(bf1->layout(), XXHash64BloomFilter::kSplitBlock);
+  EXPECT_EQ(bf1->num_hashes(), 8);
+  EXPECT_EQ(bf1->buffer_size_bytes(), 32);
+
+  // Takes a little more space than the standard layout.
+  auto bf2 = XXHash64BloomFilter::Create(100000, 0.01, XXHash64BloomFilter::kSplitBlock)
+                 .ConsumeValueOrDie();
+  EXPECT_EQ(bf2->buffer_size_bytes() % 32, 0);
+  EXPECT_GT(bf2->buffer_size_bytes(), 119814);
+  EXPECT_LT(bf2->buffer_size_bytes(), 2 * 119814);
+}
+
+TEST(XXHash64BloomFilter, split_block_error_rate) {
+  auto bf = XXHash64BloomFilter::Create(10000, 0.01, XXHash64BloomFilter::kSplitBlock)
+                .ConsumeValueOrDie();
+  for (int i = 0; i < 10000; ++i) {
+    bf->Insert(absl::StrCat("entry", i));
+  }
+
+  int false_positives = 0;
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(bf->Contains(absl::StrCat("entry", i)));
+    false_positives += bf->Contains(absl::StrCat("other", i));
+  }
+  EXPECT_LT(false_positives, 150);
+}
+
+TEST(XXHash64BloomFilter, contains_many) {
+  for (auto layout : {XXHash64BloomFilter::kStandard, XXHash64BloomFilter::kSplitBlock}) {
+    auto bf = XXHash64BloomFilter::Create(100, 0.01, layout).ConsumeValueOrDie();
+    std::vector<std::string> strs;
+    for (int i = 0; i < 100; ++i) {
+      strs.push_back(absl::StrCat("entry", i));
+      if (i % 2 == 0) {
+        bf->Insert(strs.back());
+      }
+    }
+
+    std::vector<std::string_view> items(strs.begin(), strs.end());
+    std::vector<bool> results = bf->ContainsMany(items);
+    ASSERT_EQ(results.size(), items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+      EXPECT_EQ(results[i], bf->Contains(items[i]));
+      if (i % 2 == 0) {
+        EXPECT_TRUE(results[i]);
+      }
+    }
+  }
+}
+
+TEST(XXHash64BloomFilter, split_block_proto) {
+  auto bf = XXHash64BloomFilter::Create(100, 0.01, XXHash64BloomFilter::kSplitBlock)
+                .ConsumeValueOrDie();
+  bf->Insert(std::string("foo"));
+
+  auto proto = bf->ToProto();
+  EXPECT_EQ(proto.layout(), XXHash64BloomFilterPB::SPLIT_BLOCK);
+  auto reconstructed = XXHash64BloomFilter::FromProto(proto).ConsumeValueOrDie();
+  EXPECT_EQ(reconstructed->layout(), XXHash64BloomFilter::kSplitBlock);
+  EXPECT_TRUE(reconstructed->Contains(std::string("foo")));
+
+  // Filters written without a layout use the standard one.
+  auto standard_proto = XXHash64BloomFilter::Create(100, 0.01).ConsumeValueOrDie()->ToProto();
+  standard_proto.clear_layout();
+  EXPECT_EQ(XXHash64BloomFilter::FromProto(standard_proto).ConsumeValueOrDie()->layout(),
+            XXHash64BloomFilter::kStandard);
+
+  proto.mutable_data()->pop_back();
+  EXPECT_FALSE(XXHash64BloomFilter::FromProto(proto).ok());
+}
+
 }  // namespace bloomfilter
 }  // namespace px
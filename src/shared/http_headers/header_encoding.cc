@@ -0,0 +1,235 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/http_headers/header_encoding.h"
+
+#include <array>
+
+#include <absl/strings/match.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace px {
+namespace http_headers {
+
+namespace {
+
+constexpr uint8_t kLiteralName = 0;
+
+// The names that are coded as their index + 1. Only append to the table, the index is stored.
+constexpr std::array<std::string_view, 48> kCommonNames = {
+    ":authority",
+    ":method",
+    ":path",
+    ":scheme",
+    ":status",
+    "accept",
+    "accept-encoding",
+    "accept-language",
+    "authorization",
+    "cache-control",
+    "connection",
+    "content-encoding",
+    "content-length",
+    "content-type",
+    "cookie",
+    "date",
+    "etag",
+    "expires",
+    "grpc-accept-encoding",
+    "grpc-encoding",
+    "grpc-message",
+    "grpc-status",
+    "grpc-timeout",
+    "host",
+    "if-modified-since",
+    "if-none-match",
+    "keep-alive",
+    "last-modified",
+    "location",
+    "origin",
+    "pragma",
+    "referer",
+    "server",
+    "set-cookie",
+    "te",
+    "traceparent",
+    "transfer-encoding",
+    "upgrade",
+    "user-agent",
+    "vary",
+    "via",
+    "x-b3-sampled",
+    "x-b3-spanid",
+    "x-b3-traceid",
+    "x-envoy-upstream-service-time",
+    "x-forwarded-for",
+    "x-forwarded-proto",
+    "x-request-id",
+};
+
+// Returns the code of the name, or kLiteralName if it is not a common name.
+uint8_t NameCode(std::string_view name) {
+  for (size_t i = 0; i < kCommonNames.size(); ++i) {
+    if (absl::EqualsIgnoreCase(name, kCommonNames[i])) {
+      return i + 1;
+    }
+  }
+  return kLiteralName;
+}
+
+void AppendVarint(uint64_t v, std::string* buf) {
+  while (v >= 0x80) {
+    buf->push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  buf->push_back(static_cast<char>(v));
+}
+
+size_t VarintSize(uint64_t v) {
+  size_t size = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+bool ReadVarint(std::string_view* buf, uint64_t* v) {
+  *v = 0;
+  for (int shift = 0; shift < 64 && !buf->empty(); shift += 7) {
+    auto byte = static_cast<uint8_t>(buf->front());
+    buf->remove_prefix(1);
+    *v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ReadString(std::string_view* buf, std::string_view* str) {
+  uint64_t size;
+  if (!ReadVarint(buf, &size) || size > buf->size()) {
+    return false;
+  }
+  *str = buf->substr(0, size);
+  buf->remove_prefix(size);
+  return true;
+}
+
+// Reads the next header, with code set to the code of its name.
+bool ReadHeader(std::string_view* buf, uint8_t* code, std::string_view* name,
+                std::string_view* value) {
+  *code = static_cast<uint8_t>(buf->front());
+  buf->remove_prefix(1);
+  if (*code == kLiteralName) {
+    if (!ReadString(buf, name)) {
+      return false;
+    }
+  } else if (*code <= kCommonNames.size()) {
+    *name = kCommonNames[*code - 1];
+  } else {
+    return false;
+  }
+  return ReadString(buf, value);
+}
+
+}  // namespace
+
+CompactHeadersEncoder::CompactHeadersEncoder(size_t max_bytes) : max_bytes_(max_bytes) {
+  buf_.push_back(kCompactHeadersMagic);
+}
+
+bool CompactHeadersEncoder::Add(std::string_view name, std::string_view value) {
+  uint8_t code = NameCode(name);
+  size_t size = 1 + VarintSize(value.size()) + value.size();
+  if (code == kLiteralName) {
+    size += VarintSize(name.size()) + name.size();
+  }
+  if (buf_.size() + size > max_bytes_) {
+    return false;
+  }
+  buf_.push_back(static_cast<char>(code));
+  if (code == kLiteralName) {
+    AppendVarint(name.size(), &buf_);
+    buf_.append(name);
+  }
+  AppendVarint(value.size(), &buf_);
+  buf_.append(value);
+  return true;
+}
+
+bool DecodeHeaders(std::string_view encoded,
+                   std::vector<std::pair<std::string_view, std::string_view>>* headers) {
+  headers->clear();
+  if (!IsCompactHeaders(encoded)) {
+    return false;
+  }
+  encoded.remove_prefix(1);
+  while (!encoded.empty()) {
+    uint8_t code;
+    std::string_view name;
+    std::string_view value;
+    if (!ReadHeader(&encoded, &code, &name, &value)) {
+      return false;
+    }
+    headers->emplace_back(name, value);
+  }
+  return true;
+}
+
+std::optional<std::string_view> FindHeader(std::string_view encoded, std::string_view name) {
+  if (!IsCompactHeaders(encoded)) {
+    return std::nullopt;
+  }
+  encoded.remove_prefix(1);
+  // A common name can only be stored as its code.
+  uint8_t name_code = NameCode(name);
+  while (!encoded.empty()) {
+    uint8_t code;
+    std::string_view header_name;
+    std::string_view value;
+    if (!ReadHeader(&encoded, &code, &header_name, &value)) {
+      return std::nullopt;
+    }
+    if (code == name_code &&
+        (code != kLiteralName || absl::EqualsIgnoreCase(header_name, name))) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+std::string CompactHeadersToJSON(std::string_view encoded) {
+  std::vector<std::pair<std::string_view, std::string_view>> headers;
+  DecodeHeaders(encoded, &headers);
+
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartObject();
+  for (const auto& [name, value] : headers) {
+    writer.Key(name.data(), name.size());
+    writer.String(value.data(), value.size());
+  }
+  writer.EndObject();
+  return sb.GetString();
+}
+
+}  // namespace http_headers
+}  // namespace px
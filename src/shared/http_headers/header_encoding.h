@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace http_headers {
+
+/**
+ * Compact encoding of a set of HTTP headers, for the header columns of http_events.
+ *
+ * The encoding starts with kCompactHeadersMagic, followed by one entry per header:
+ *   - the code of the name: 0 for a literal name, which follows as a varint length and the
+ *     bytes of the name, otherwise the index + 1 of the name in a table of common names;
+ *   - the value, as a varint length and the bytes of the value.
+ *
+ * Headers are found without parsing the whole set, and the common names take a single byte.
+ * Names from the table are stored, and come back, in lower case. JSON header sets never start
+ * with kCompactHeadersMagic, so both forms can be stored in the same column.
+ */
+constexpr char kCompactHeadersMagic = '\x01';
+
+inline bool IsCompactHeaders(std::string_view headers) {
+  return !headers.empty() && headers[0] == kCompactHeadersMagic;
+}
+
+class CompactHeadersEncoder {
+ public:
+  // Headers that would take the encoding over max_bytes are dropped.
+  explicit CompactHeadersEncoder(size_t max_bytes);
+
+  // Returns false if the header was dropped.
+  bool Add(std::string_view name, std::string_view value);
+
+  std::string Finish() { return std::move(buf_); }
+
+ private:
+  size_t max_bytes_;
+  std::string buf_;
+};
+
+// Encodes the (name, value) pairs of a header map.
+template <typename TContainer>
+std::string EncodeHeaders(const TContainer& headers, size_t max_bytes) {
+  CompactHeadersEncoder encoder(max_bytes);
+  for (const auto& [name, value] : headers) {
+    encoder.Add(name, value);
+  }
+  return encoder.Finish();
+}
+
+// Decodes the headers, which point into the encoded string. Returns false if it is malformed.
+bool DecodeHeaders(std::string_view encoded,
+                   std::vector<std::pair<std::string_view, std::string_view>>* headers);
+
+// Returns the value of the first header with the given name, compared case-insensitively.
+std::optional<std::string_view> FindHeader(std::string_view encoded, std::string_view name);
+
+// Converts the headers to the JSON object the header columns store by default.
+std::string CompactHeadersToJSON(std::string_view encoded);
+
+}  // namespace http_headers
+}  // namespace px
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/shared/http_headers/header_encoding.h"
+
+namespace px {
+namespace http_headers {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+TEST(HeaderEncodingTest, round_trip) {
+  std::multimap<std::string, std::string> headers = {
+      {"Content-Type", "application/json"},
+      {"X-Custom", "a"},
+      {"X-Custom", "b"},
+      {":path", "/index.html"},
+  };
+  std::string encoded = EncodeHeaders(headers, 1024);
+  ASSERT_TRUE(IsCompactHeaders(encoded));
+
+  std::vector<std::pair<std::string_view, std::string_view>> decoded;
+  ASSERT_TRUE(DecodeHeaders(encoded, &decoded));
+  // Common names come back in lower case.
+  EXPECT_THAT(decoded, ElementsAre(Pair(":path", "/index.html"),
+                                   Pair("content-type", "application/json"),
+                                   Pair("X-Custom", "a"), Pair("X-Custom", "b")));
+}
+
+TEST(HeaderEncodingTest, find_header) {
+  std::multimap<std::string, std::string> headers = {
+      {"Content-Type", "text/plain"},
+      {"X-Custom", "a"},
+      {"X-Custom", "b"},
+  };
+  std::string encoded = EncodeHeaders(headers, 1024);
+
+  EXPECT_EQ("text/plain", FindHeader(encoded, "content-type"));
+  EXPECT_EQ("a", FindHeader(encoded, "x-custom"));
+  EXPECT_EQ(std::nullopt, FindHeader(encoded, "host"));
+  EXPECT_EQ(std::nullopt, FindHeader("{\"Host\":\"a\"}", "host"));
+}
+
+TEST(HeaderEncodingTest, drops_headers_past_max_bytes) {
+  CompactHeadersEncoder encoder(17);
+  EXPECT_TRUE(encoder.Add("host", "example.com"));
+  EXPECT_FALSE(encoder.Add("x-long-name", "v"));
+  EXPECT_TRUE(encoder.Add("te", "x"));
+  std::string encoded = encoder.Finish();
+  EXPECT_EQ(17, encoded.size());
+  EXPECT_EQ(R"({"host":"example.com","te":"x"})", CompactHeadersToJSON(encoded));
+}
+
+TEST(HeaderEncodingTest, malformed) {
+  std::string encoded = EncodeHeaders(std::map<std::string, std::string>{{"host", "a"}}, 1024);
+  std::vector<std::pair<std::string_view, std::string_view>> decoded;
+  EXPECT_FALSE(DecodeHeaders(encoded.substr(0, encoded.size() - 1), &decoded));
+  EXPECT_FALSE(DecodeHeaders("{}", &decoded));
+}
+
+}  // namespace http_headers
+}  // namespace px
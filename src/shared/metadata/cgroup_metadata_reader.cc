@@ -16,7 +16,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <sys/stat.h>
+
 #include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <memory>
 #include <string>
@@ -55,6 +58,21 @@ CGroupMetadataReader::CGroupMetadataReader(const system::Config& cfg) {
   }
 }
 
+StatusOr<uint64_t> CGroupMetadataReader::ReadCGroupID(PodQOSClass qos_class,
+                                                     std::string_view pod_id,
+                                                     std::string_view container_id,
+                                                     ContainerType container_type) const {
+  PL_ASSIGN_OR_RETURN(std::string fpath, PodPath(qos_class, pod_id, container_id, container_type));
+
+  // The path is the one of the cgroup.procs file in the cgroup directory.
+  std::string cgroup_dir = std::filesystem::path(fpath).parent_path().string();
+  struct stat st;
+  if (stat(cgroup_dir.c_str(), &st) != 0) {
+    return error::NotFound("Failed to stat cgroup directory $0", cgroup_dir);
+  }
+  return static_cast<uint64_t>(st.st_ino);
+}
+
 StatusOr<std::string> CGroupMetadataReader::PodPath(PodQOSClass qos_class, std::string_view pod_id,
                                                     std::string_view container_id,
                                                     ContainerType container_type) const {
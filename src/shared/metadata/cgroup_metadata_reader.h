@@ -54,6 +54,15 @@ class CGroupMetadataReader : public NotCopyable {
                           std::string_view container_id, ContainerType container_type,
                           absl::flat_hash_set<uint32_t>* pid_set) const;
 
+  /**
+   * ReadCGroupID returns the ID of the cgroup of a container running as part of a given pod, which
+   * is the inode number of its cgroup directory. On the unified (v2) hierarchy, this is the ID
+   * that BPF's bpf_get_current_cgroup_id() returns for the container's processes.
+   */
+  virtual StatusOr<uint64_t> ReadCGroupID(PodQOSClass qos_class, std::string_view pod_id,
+                                          std::string_view container_id,
+                                          ContainerType container_type) const;
+
  private:
   StatusOr<std::string> PodPath(PodQOSClass qos_class, std::string_view pod_id,
                                 std::string_view container_id, ContainerType container_type) const;
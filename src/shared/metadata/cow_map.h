@@ -0,0 +1,219 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace px {
+namespace md {
+
+/**
+ * CowMap is a hash map whose copies share their contents, so that copying it is cheap no matter
+ * how large it is.
+ *
+ * The entries are spread over a fixed number of shards, and a copy only takes a reference to each
+ * shard. A shard is copied the first time it's written to while another map still references it,
+ * so each write costs at most one shard copy (about 1/kNumShards of the map), and the shards that
+ * aren't touched stay shared with every copy that came before.
+ *
+ * Like the flat_hash_map underneath, a CowMap can't be written to and read at the same time.
+ * Different copies can be used from different threads, however, since a write never touches a
+ * shard that's shared with another copy.
+ *
+ * Iteration order is unspecified; pointers returned by Find and FindMutable are invalidated by
+ * any later write.
+ */
+template <typename K, typename V, typename Hash = absl::container_internal::hash_default_hash<K>,
+          typename Eq = absl::container_internal::hash_default_eq<K>>
+class CowMap {
+  using Shard = absl::flat_hash_map<K, V, Hash, Eq>;
+
+ public:
+  static constexpr size_t kNumShardBits = 6;
+  static constexpr size_t kNumShards = 1ULL << kNumShardBits;
+
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = typename Shard::value_type;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Shard::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    reference operator*() const { return *it_; }
+    pointer operator->() const { return &*it_; }
+
+    const_iterator& operator++() {
+      ++it_;
+      SkipExhaustedShards();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return shard_ == other.shard_ && (shard_ == kNumShards || it_ == other.it_);
+    }
+    bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class CowMap;
+
+    const_iterator(const CowMap* map, size_t shard) : map_(map), shard_(shard) {
+      if (shard_ < kNumShards && map_->shards_[shard_] != nullptr) {
+        it_ = map_->shards_[shard_]->begin();
+      }
+      SkipExhaustedShards();
+    }
+
+    void SkipExhaustedShards() {
+      while (shard_ < kNumShards &&
+             (map_->shards_[shard_] == nullptr || it_ == map_->shards_[shard_]->end())) {
+        ++shard_;
+        if (shard_ < kNumShards && map_->shards_[shard_] != nullptr) {
+          it_ = map_->shards_[shard_]->begin();
+        }
+      }
+    }
+
+    const CowMap* map_;
+    size_t shard_;
+    typename Shard::const_iterator it_;
+  };
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, kNumShards); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * @return the value for the key, or nullptr if it's not in the map.
+   */
+  template <typename Q>
+  const V* Find(const Q& key) const {
+    const auto& shard = shards_[ShardIndex(key)];
+    if (shard == nullptr) {
+      return nullptr;
+    }
+    auto it = shard->find(key);
+    return it == shard->end() ? nullptr : &it->second;
+  }
+
+  template <typename Q>
+  bool contains(const Q& key) const {
+    return Find(key) != nullptr;
+  }
+
+  /**
+   * Like Find, but may be written through. The key's shard is copied first if it's shared, so
+   * only call this to actually write; a miss doesn't copy anything.
+   */
+  template <typename Q>
+  V* FindMutable(const Q& key) {
+    size_t idx = ShardIndex(key);
+    if (shards_[idx] == nullptr || !shards_[idx]->contains(key)) {
+      return nullptr;
+    }
+    return &MutableShard(idx).find(key)->second;
+  }
+
+  template <typename... Args>
+  std::pair<V*, bool> try_emplace(const K& key, Args&&... args) {
+    auto [it, inserted] =
+        MutableShard(ShardIndex(key)).try_emplace(key, std::forward<Args>(args)...);
+    size_ += inserted;
+    return {&it->second, inserted};
+  }
+
+  V& operator[](const K& key) { return *try_emplace(key).first; }
+
+  /**
+   * Removes the key, if present. Erasing a missing key doesn't copy anything.
+   * @return the number of entries removed.
+   */
+  template <typename Q>
+  size_t erase(const Q& key) {
+    size_t idx = ShardIndex(key);
+    if (shards_[idx] == nullptr || !shards_[idx]->contains(key)) {
+      return 0;
+    }
+    MutableShard(idx).erase(key);
+    --size_;
+    return 1;
+  }
+
+  void clear() {
+    for (auto& shard : shards_) {
+      shard.reset();
+    }
+    size_ = 0;
+  }
+
+ private:
+  template <typename Q>
+  static size_t ShardIndex(const Q& key) {
+    // The shards hash the keys with the same function, and only use its top bits once they grow
+    // very large, so those are the ones to pick the shard with.
+    return static_cast<size_t>(Hash{}(key)) >> (8 * sizeof(size_t) - kNumShardBits);
+  }
+
+  Shard& MutableShard(size_t idx) {
+    auto& shard = shards_[idx];
+    if (shard == nullptr) {
+      shard = std::make_shared<Shard>();
+    } else if (shard.use_count() > 1) {
+      shard = std::make_shared<Shard>(*shard);
+    }
+    return *shard;
+  }
+
+  std::array<std::shared_ptr<Shard>, kNumShards> shards_;
+  size_t size_ = 0;
+};
+
+/**
+ * Prepares a shared object for writing: if anything else references it (typically the map of an
+ * older copy), the pointer is replaced by a private clone first. The pointer itself must already
+ * be writable, e.g. from CowMap::FindMutable.
+ * @return the object, which can now be safely modified.
+ */
+template <typename T>
+T* UnshareObject(std::shared_ptr<T>* obj) {
+  if (obj->use_count() > 1) {
+    *obj = (*obj)->Clone();
+  }
+  return obj->get();
+}
+
+}  // namespace md
+}  // namespace px
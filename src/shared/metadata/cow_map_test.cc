@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "src/shared/metadata/cow_map.h"
+
+namespace px {
+namespace md {
+
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+TEST(CowMapTest, basic) {
+  CowMap<std::string, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.Find("a"));
+
+  map["a"] = 1;
+  EXPECT_TRUE(map.try_emplace("b", 2).second);
+  EXPECT_FALSE(map.try_emplace("b", 3).second);
+  EXPECT_EQ(2, map.size());
+  EXPECT_TRUE(map.contains(std::string_view("a")));
+  EXPECT_EQ(2, *map.Find("b"));
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("a", 1), Pair("b", 2)));
+
+  *map.FindMutable("a") = 10;
+  EXPECT_EQ(10, *map.Find("a"));
+  EXPECT_EQ(nullptr, map.FindMutable("c"));
+
+  EXPECT_EQ(1, map.erase("a"));
+  EXPECT_EQ(0, map.erase("a"));
+  EXPECT_EQ(1, map.size());
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("b", 2)));
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(CowMapTest, copies_are_independent) {
+  CowMap<int, int> map;
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = i;
+  }
+
+  CowMap<int, int> copy = map;
+  copy[1] = -1;
+  copy.erase(2);
+  copy[1000] = 1000;
+
+  EXPECT_EQ(1000, map.size());
+  EXPECT_EQ(1, *map.Find(1));
+  EXPECT_EQ(2, *map.Find(2));
+  EXPECT_FALSE(map.contains(1000));
+
+  EXPECT_EQ(1000, copy.size());
+  EXPECT_EQ(-1, *copy.Find(1));
+  EXPECT_FALSE(copy.contains(2));
+  EXPECT_EQ(1000, *copy.Find(1000));
+
+  int count = 0;
+  for (const auto& [k, v] : copy) {
+    EXPECT_EQ(k == 1 ? -1 : k, v);
+    ++count;
+  }
+  EXPECT_EQ(1000, count);
+}
+
+struct Counter {
+  int value;
+  std::unique_ptr<Counter> Clone() const { return std::make_unique<Counter>(*this); }
+};
+
+TEST(CowMapTest, unchanged_objects_are_shared) {
+  CowMap<int, std::shared_ptr<Counter>> map;
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = std::make_shared<Counter>(Counter{i});
+  }
+
+  CowMap<int, std::shared_ptr<Counter>> copy = map;
+  UnshareObject(copy.FindMutable(7))->value = -7;
+
+  EXPECT_EQ(7, (*map.Find(7))->value);
+  EXPECT_EQ(-7, (*copy.Find(7))->value);
+  EXPECT_NE(map.Find(7)->get(), copy.Find(7)->get());
+  // Everything else still points at the same objects.
+  EXPECT_EQ(map.Find(8)->get(), copy.Find(8)->get());
+  EXPECT_EQ(map.Find(999)->get(), copy.Find(999)->get());
+
+  // Once unshared, the object is written in place.
+  Counter* counter = copy.FindMutable(7)->get();
+  EXPECT_EQ(counter, UnshareObject(copy.FindMutable(7)));
+}
+
+}  // namespace md
+}  // namespace px
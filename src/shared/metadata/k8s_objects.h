@@ -26,6 +26,7 @@
 #include <absl/container/flat_hash_set.h>
 #include "src/common/base/base.h"
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
+#include "src/shared/metadata/string_pool.h"
 #include "src/shared/upid/upid.h"
 
 namespace px {
@@ -48,8 +49,8 @@ class K8sMetadataObject {
                     int64_t start_time_ns = 0, int64_t stop_time_ns = 0)
       : type_(type),
         uid_(std::move(uid)),
-        ns_(ns),
-        name_(name),
+        ns_(StringPool::Global()->Intern(ns)),
+        name_(StringPool::Global()->Intern(name)),
         start_time_ns_(start_time_ns),
         stop_time_ns_(stop_time_ns) {}
 
@@ -57,8 +58,8 @@ class K8sMetadataObject {
 
   const UID& uid() const { return uid_; }
 
-  const std::string& name() const { return name_; }
-  const std::string& ns() const { return ns_; }
+  const std::string& name() const { return *name_; }
+  const std::string& ns() const { return *ns_; }
 
   int64_t start_time_ns() const { return start_time_ns_; }
   void set_start_time_ns(int64_t start_time_ns) { start_time_ns_ = start_time_ns; }
@@ -86,14 +87,14 @@ class K8sMetadataObject {
 
   /**
    * The namespace for this object.
+   * Names are interned, since many objects share them and every clone copies them.
    */
-
-  std::string ns_;
+  InternedString ns_;
 
   /**
    * The name which is unique in space but not time.
    */
-  std::string name_;
+  InternedString name_;
 
   /**
    * Start time of this K8s object.
@@ -245,8 +246,8 @@ class PodInfo : public K8sMetadataObject {
         conditions_(conditions),
         phase_message_(phase_message),
         phase_reason_(phase_reason),
-        node_name_(node_name),
-        hostname_(hostname),
+        node_name_(StringPool::Global()->Intern(node_name)),
+        hostname_(StringPool::Global()->Intern(hostname)),
         pod_ip_(pod_ip) {}
 
   explicit PodInfo(const px::shared::k8s::metadatapb::PodUpdate& pod_update_info)
@@ -278,11 +279,15 @@ class PodInfo : public K8sMetadataObject {
   const std::string& phase_reason() const { return phase_reason_; }
   void set_phase_reason(std::string_view phase_reason) { phase_reason_ = phase_reason; }
 
-  void set_node_name(std::string_view node_name) { node_name_ = node_name; }
-  void set_hostname(std::string_view hostname) { hostname_ = hostname; }
+  void set_node_name(std::string_view node_name) {
+    node_name_ = StringPool::Global()->Intern(node_name);
+  }
+  void set_hostname(std::string_view hostname) {
+    hostname_ = StringPool::Global()->Intern(hostname);
+  }
   void set_pod_ip(std::string_view pod_ip) { pod_ip_ = pod_ip; }
-  const std::string& node_name() const { return node_name_; }
-  const std::string& hostname() const { return hostname_; }
+  const std::string& node_name() const { return *node_name_; }
+  const std::string& hostname() const { return *hostname_; }
   const std::string& pod_ip() const { return pod_ip_; }
 
   const absl::flat_hash_set<std::string>& containers() const { return containers_; }
@@ -320,8 +325,8 @@ class PodInfo : public K8sMetadataObject {
    */
   absl::flat_hash_set<UID> services_;
 
-  std::string node_name_;
-  std::string hostname_;
+  InternedString node_name_;
+  InternedString hostname_;
   std::string pod_ip_;
 };
 
@@ -338,7 +343,7 @@ class ContainerInfo {
                 std::string_view state_message, std::string_view state_reason,
                 int64_t start_time_ns, int64_t stop_time_ns = 0)
       : cid_(std::move(cid)),
-        name_(std::string(name)),
+        name_(StringPool::Global()->Intern(name)),
         state_(state),
         type_(type),
         state_message_(state_message),
@@ -355,12 +360,16 @@ class ContainerInfo {
                       container_update_info.stop_timestamp_ns()) {}
 
   const CID& cid() const { return cid_; }
-  const std::string& name() const { return name_; }
+  const std::string& name() const { return *name_; }
   ContainerType type() const { return type_; }
 
   void set_pod_id(std::string_view pod_id) { pod_id_ = pod_id; }
   const UID& pod_id() const { return pod_id_; }
 
+  // The ID of the container's cgroup, or 0 if it isn't known (yet).
+  uint64_t cgroup_id() const { return cgroup_id_; }
+  void set_cgroup_id(uint64_t cgroup_id) { cgroup_id_ = cgroup_id; }
+
   const absl::flat_hash_set<UPID>& active_upids() const { return active_upids_; }
   absl::flat_hash_set<UPID>* mutable_active_upids() { return &active_upids_; }
 
@@ -390,8 +399,9 @@ class ContainerInfo {
 
  private:
   const CID cid_;
-  const std::string name_;
+  const InternedString name_;
   UID pod_id_ = "";
+  uint64_t cgroup_id_ = 0;
 
   /**
    * The set of UPIDs that are running on this container.
@@ -101,6 +101,24 @@ TEST(PodInfo, clone) {
   EXPECT_EQ(cloned->phase(), pod_info.phase());
   EXPECT_EQ(cloned->phase_message(), pod_info.phase_message());
   EXPECT_EQ(cloned->phase_reason(), pod_info.phase_reason());
+
+  // Names are interned, so the clone shares them with the original.
+  EXPECT_EQ(&cloned->ns(), &pod_info.ns());
+  EXPECT_EQ(&cloned->node_name(), &pod_info.node_name());
+}
+
+TEST(PodInfo, shared_names) {
+  PodInfo pod1("123", "pl", "pod1", PodQOSClass::kBurstable, PodPhase::kRunning, {}, "", "",
+               "testnode", "testhost", "1.2.3.4");
+  PodInfo pod2("456", "pl", "pod2", PodQOSClass::kBurstable, PodPhase::kRunning, {}, "", "",
+               "testnode", "testhost", "1.2.3.5");
+  EXPECT_EQ(&pod1.ns(), &pod2.ns());
+  EXPECT_EQ(&pod1.node_name(), &pod2.node_name());
+  EXPECT_NE(&pod1.name(), &pod2.name());
+
+  pod2.set_node_name("othernode");
+  EXPECT_EQ(pod2.node_name(), "othernode");
+  EXPECT_EQ(pod1.node_name(), "testnode");
 }
 
 TEST(ContainerInfo, pod_id) {
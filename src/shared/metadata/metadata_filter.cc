@@ -47,11 +47,18 @@ std::string ToEntityKeyPair(MetadataType type, std::string_view entity) {
 }
 
 Status AgentMetadataFilter::InsertEntity(MetadataType key, std::string_view value) {
-  epoch_id_++;
   if (!metadata_types_.contains(key)) {
     return error::Internal("Metadata type $0 is not registered in AgentMetadataFilter.", key);
   }
-  Insert(ToEntityKeyPair(key, value));
+  std::string entity = ToEntityKeyPair(key, value);
+  // Every K8s update of an object re-inserts its entities. The epoch only moves when the filter
+  // actually changes, so that the heartbeats don't resend an identical filter. For a bloom
+  // filter, an entity that it already appears to contain would not change it either.
+  if (Contains(entity)) {
+    return Status::OK();
+  }
+  Insert(entity);
+  epoch_id_++;
   return Status::OK();
 }
 
@@ -43,6 +43,23 @@ TEST(AgentMetadataFilter, test_basic) {
   EXPECT_NOT_OK(filter->InsertEntity(MetadataType::SERVICE_NAME, "abc"));
 }
 
+TEST(AgentMetadataFilter, epoch_only_changes_with_filter) {
+  auto filter =
+      AgentMetadataFilter::Create(100, 0.01, {MetadataType::POD_NAME, MetadataType::CONTAINER_ID})
+          .ConsumeValueOrDie();
+  int64_t epoch_id = filter->epoch_id();
+
+  EXPECT_OK(filter->InsertEntity(MetadataType::POD_NAME, "foo"));
+  EXPECT_GT(filter->epoch_id(), epoch_id);
+  epoch_id = filter->epoch_id();
+
+  EXPECT_OK(filter->InsertEntity(MetadataType::POD_NAME, "foo"));
+  EXPECT_EQ(filter->epoch_id(), epoch_id);
+
+  EXPECT_OK(filter->InsertEntity(MetadataType::CONTAINER_ID, "foo"));
+  EXPECT_GT(filter->epoch_id(), epoch_id);
+}
+
 TEST(AgentMetadataFilter, test_proto) {
   auto filter =
       AgentMetadataFilter::Create(100, 0.01, {MetadataType::POD_NAME, MetadataType::CONTAINER_ID})
@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_set.h>
 
@@ -27,19 +28,57 @@
 namespace px {
 namespace md {
 
+namespace {
+
+// Writing to a CowMap copies the shard of the key, so index entries that already hold the right
+// value are left alone.
+template <typename TMap, typename TKey, typename TValue>
+void SetIfChanged(TMap* map, const TKey& key, const TValue& value) {
+  const auto* current = map->Find(key);
+  if (current == nullptr || *current != value) {
+    (*map)[key] = value;
+  }
+}
+
+// Adds the UID to the set of the key. The map isn't written to if it's already there, so the
+// shard isn't copied on repeated updates.
+template <typename TMap, typename TKey>
+void AddToIndex(TMap* index, const TKey& key, UIDView uid) {
+  const auto* uids = index->Find(key);
+  if (uids == nullptr || !uids->contains(uid)) {
+    (*index)[key].emplace(uid);
+  }
+}
+
+// Removes the UID from the set of the key, and the key once its set is empty.
+template <typename TMap, typename TKey>
+void RemoveFromIndex(TMap* index, const TKey& key, UIDView uid) {
+  const auto* uids = index->Find(key);
+  if (uids == nullptr || !uids->contains(uid)) {
+    return;
+  }
+  auto* mutable_uids = index->FindMutable(key);
+  mutable_uids->erase(uid);
+  if (mutable_uids->empty()) {
+    index->erase(key);
+  }
+}
+
+}  // namespace
+
 const K8sMetadataObject* K8sMetadataState::K8sMetadataObjectByID(UIDView id,
                                                                  K8sObjectType type) const {
-  auto it = k8s_objects_by_id_.find(id);
+  const K8sMetadataObjectPtr* obj = k8s_objects_by_id_.Find(id);
 
-  if (it == k8s_objects_by_id_.end()) {
+  if (obj == nullptr) {
     return nullptr;
   }
 
-  if (it->second->type() != type) {
+  if ((*obj)->type() != type) {
     return nullptr;
   }
 
-  return it->second.get();
+  return obj->get();
 }
 
 const PodInfo* K8sMetadataState::PodInfoByID(UIDView pod_id) const {
@@ -58,38 +97,47 @@ const NamespaceInfo* K8sMetadataState::NamespaceInfoByID(UIDView ns_id) const {
 }
 
 const ContainerInfo* K8sMetadataState::ContainerInfoByID(CIDView id) const {
-  auto it = containers_by_id_.find(id);
-
-  if (it == containers_by_id_.end()) {
-    return nullptr;
-  }
+  const ContainerInfoPtr* cinfo = containers_by_id_.Find(id);
+  return cinfo == nullptr ? nullptr : cinfo->get();
+}
 
-  return it->second.get();
+ContainerInfo* K8sMetadataState::MutableContainerInfoByID(CIDView id) {
+  ContainerInfoPtr* cinfo = containers_by_id_.FindMutable(id);
+  return cinfo == nullptr ? nullptr : UnshareObject(cinfo);
 }
 
 UID K8sMetadataState::PodIDByName(K8sNameIdentView pod_name) const {
-  auto it = pods_by_name_.find(pod_name);
-  return (it == pods_by_name_.end()) ? "" : it->second;
+  const UID* uid = pods_by_name_.Find(pod_name);
+  return (uid == nullptr) ? "" : *uid;
 }
 
 UID K8sMetadataState::PodIDByIP(std::string_view pod_ip) const {
-  auto it = pods_by_ip_.find(pod_ip);
-  return (it == pods_by_ip_.end()) ? "" : it->second;
+  const UID* uid = pods_by_ip_.Find(pod_ip);
+  return (uid == nullptr) ? "" : *uid;
+}
+
+const K8sMetadataState::UIDSet* K8sMetadataState::PodIDsByNodeName(
+    std::string_view node_name) const {
+  return pods_by_node_name_.Find(node_name);
+}
+
+const K8sMetadataState::UIDSet* K8sMetadataState::PodIDsByServiceID(UIDView service_id) const {
+  return pods_by_service_id_.Find(service_id);
 }
 
 CID K8sMetadataState::ContainerIDByName(std::string_view container_name) const {
-  auto it = containers_by_name_.find(container_name);
-  return (it == containers_by_name_.end()) ? "" : it->second;
+  const CID* cid = containers_by_name_.Find(container_name);
+  return (cid == nullptr) ? "" : *cid;
 }
 
 UID K8sMetadataState::ServiceIDByName(K8sNameIdentView service_name) const {
-  auto it = services_by_name_.find(service_name);
-  return (it == services_by_name_.end()) ? "" : it->second;
+  const UID* uid = services_by_name_.Find(service_name);
+  return (uid == nullptr) ? "" : *uid;
 }
 
 UID K8sMetadataState::NamespaceIDByName(K8sNameIdentView namespace_name) const {
-  auto it = namespaces_by_name_.find(namespace_name);
-  return (it == namespaces_by_name_.end()) ? "" : it->second;
+  const UID* uid = namespaces_by_name_.Find(namespace_name);
+  return (uid == nullptr) ? "" : *uid;
 }
 
 std::unique_ptr<K8sMetadataState> K8sMetadataState::Clone() const {
@@ -98,21 +146,16 @@ std::unique_ptr<K8sMetadataState> K8sMetadataState::Clone() const {
   other->pod_cidrs_ = pod_cidrs_;
   other->service_cidr_ = service_cidr_;
 
-  other->k8s_objects_by_id_.reserve(k8s_objects_by_id_.size());
-  for (const auto& [k, v] : k8s_objects_by_id_) {
-    other->k8s_objects_by_id_[k] = v->Clone();
-  }
-
-  other->containers_by_id_.reserve(containers_by_id_.size());
-  for (const auto& [k, v] : containers_by_id_) {
-    other->containers_by_id_[k] = v->Clone();
-  }
-
+  // These only share the contents; the objects are copied once they're updated.
+  other->k8s_objects_by_id_ = k8s_objects_by_id_;
+  other->containers_by_id_ = containers_by_id_;
   other->pods_by_name_ = pods_by_name_;
   other->services_by_name_ = services_by_name_;
   other->namespaces_by_name_ = namespaces_by_name_;
   other->containers_by_name_ = containers_by_name_;
   other->pods_by_ip_ = pods_by_ip_;
+  other->pods_by_node_name_ = pods_by_node_name_;
+  other->pods_by_service_id_ = pods_by_service_id_;
 
   return other;
 }
@@ -150,13 +193,13 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(object_uid);
-  if (it == k8s_objects_by_id_.end()) {
+  K8sMetadataObjectPtr* obj = k8s_objects_by_id_.FindMutable(object_uid);
+  if (obj == nullptr) {
     auto pod = std::make_unique<PodInfo>(update);
     VLOG(1) << "Adding Pod: " << pod->DebugString();
-    it = k8s_objects_by_id_.try_emplace(object_uid, std::move(pod)).first;
+    obj = k8s_objects_by_id_.try_emplace(object_uid, std::move(pod)).first;
   }
-  auto pod_info = static_cast<PodInfo*>(it->second.get());
+  auto pod_info = static_cast<PodInfo*>(UnshareObject(obj));
 
   // We always just add to the container set even if the container is stopped.
   // We expect all cleanup to happen periodically to allow stale objects to be queried for some
@@ -165,7 +208,8 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   // state might be periodically inconsistent.
 
   for (const auto& cid : update.container_ids()) {
-    if (containers_by_id_.find(cid) == containers_by_id_.end()) {
+    const ContainerInfo* cinfo = ContainerInfoByID(cid);
+    if (cinfo == nullptr) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
@@ -174,11 +218,19 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
     }
 
     pod_info->AddContainer(cid);
-    containers_by_id_[cid]->set_pod_id(object_uid);
+    if (cinfo->pod_id() != object_uid) {
+      MutableContainerInfoByID(cid)->set_pod_id(object_uid);
+    }
   }
 
   pod_info->set_start_time_ns(update.start_timestamp_ns());
   pod_info->set_stop_time_ns(update.stop_timestamp_ns());
+  if (pod_info->node_name() != update.node_name()) {
+    RemoveFromIndex(&pods_by_node_name_, pod_info->node_name(), object_uid);
+  }
+  if (!update.node_name().empty()) {
+    AddToIndex(&pods_by_node_name_, update.node_name(), object_uid);
+  }
   pod_info->set_node_name(update.node_name());
   pod_info->set_hostname(update.hostname());
   pod_info->set_pod_ip(update.pod_ip());
@@ -187,10 +239,10 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   pod_info->set_phase_message(update.message());
   pod_info->set_phase_reason(update.reason());
 
-  pods_by_name_[{ns, name}] = object_uid;
+  SetIfChanged(&pods_by_name_, K8sNameIdent{ns, name}, object_uid);
   if (update.host_ip() !=
       update.pod_ip()) {  // Filter out daemonset which don't have their own, unique podIP.
-    pods_by_ip_[update.pod_ip()] = object_uid;
+    SetIfChanged(&pods_by_ip_, update.pod_ip(), object_uid);
   }
 
   return Status::OK();
@@ -199,21 +251,21 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
 Status K8sMetadataState::HandleContainerUpdate(const ContainerUpdate& update) {
   const CID& cid = update.cid();
 
-  auto it = containers_by_id_.find(cid);
-  if (it == containers_by_id_.end()) {
+  ContainerInfoPtr* cinfo = containers_by_id_.FindMutable(cid);
+  if (cinfo == nullptr) {
     auto container = std::make_unique<ContainerInfo>(update);
     VLOG(1) << "Adding Container: " << container->DebugString();
-    it = containers_by_id_.try_emplace(cid, std::move(container)).first;
+    cinfo = containers_by_id_.try_emplace(cid, std::move(container)).first;
   }
   VLOG(1) << "container update: " << update.name();
 
-  auto* container_info = it->second.get();
+  auto* container_info = UnshareObject(cinfo);
   container_info->set_stop_time_ns(update.stop_timestamp_ns());
   container_info->set_state(ConvertToContainerState(update.container_state()));
   container_info->set_state_message(update.message());
   container_info->set_state_reason(update.reason());
 
-  containers_by_name_[update.name()] = cid;
+  SetIfChanged(&containers_by_name_, update.name(), cid);
 
   return Status::OK();
 }
@@ -223,33 +275,37 @@ Status K8sMetadataState::HandleServiceUpdate(const ServiceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(service_uid);
-  if (it == k8s_objects_by_id_.end()) {
+  K8sMetadataObjectPtr* obj = k8s_objects_by_id_.FindMutable(service_uid);
+  if (obj == nullptr) {
     auto service = std::make_unique<ServiceInfo>(service_uid, ns, name);
     VLOG(1) << "Adding Service: " << service->DebugString();
-    it = k8s_objects_by_id_.try_emplace(service_uid, std::move(service)).first;
+    obj = k8s_objects_by_id_.try_emplace(service_uid, std::move(service)).first;
   }
-  auto service_info = static_cast<ServiceInfo*>(it->second.get());
+  auto service_info = static_cast<ServiceInfo*>(UnshareObject(obj));
 
   for (const auto& uid : update.pod_ids()) {
-    if (k8s_objects_by_id_.find(uid) == k8s_objects_by_id_.end()) {
+    const K8sMetadataObjectPtr* pod = k8s_objects_by_id_.Find(uid);
+    if (pod == nullptr) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
       LOG(INFO) << absl::Substitute("Didn't find pod UID $0 for service $1/$2", uid, ns, name);
       continue;
     }
-    ECHECK(k8s_objects_by_id_[uid]->type() == K8sObjectType::kPod);
+    ECHECK((*pod)->type() == K8sObjectType::kPod);
     // We add the service uid to the pod. Lifetime of service still handled by the service object.
-    PodInfo* pod_info = static_cast<PodInfo*>(k8s_objects_by_id_[uid].get());
-    pod_info->AddService(service_uid);
+    if (!static_cast<const PodInfo*>(pod->get())->services().contains(service_uid)) {
+      auto* pod_info = static_cast<PodInfo*>(UnshareObject(k8s_objects_by_id_.FindMutable(uid)));
+      pod_info->AddService(service_uid);
+    }
+    AddToIndex(&pods_by_service_id_, service_uid, uid);
   }
   service_info->set_start_time_ns(update.start_timestamp_ns());
   service_info->set_stop_time_ns(update.stop_timestamp_ns());
 
   VLOG(1) << "service update: " << update.name();
 
-  services_by_name_[{ns, name}] = service_uid;
+  SetIfChanged(&services_by_name_, K8sNameIdent{ns, name}, service_uid);
   return Status::OK();
 }
 
@@ -258,20 +314,20 @@ Status K8sMetadataState::HandleNamespaceUpdate(const NamespaceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.name();
 
-  auto it = k8s_objects_by_id_.find(namespace_uid);
-  if (it == k8s_objects_by_id_.end()) {
+  K8sMetadataObjectPtr* obj = k8s_objects_by_id_.FindMutable(namespace_uid);
+  if (obj == nullptr) {
     auto ns_obj = std::make_unique<NamespaceInfo>(namespace_uid, ns, name);
     VLOG(1) << "Adding Namespace: " << ns_obj->DebugString();
-    it = k8s_objects_by_id_.try_emplace(namespace_uid, std::move(ns_obj)).first;
+    obj = k8s_objects_by_id_.try_emplace(namespace_uid, std::move(ns_obj)).first;
   }
-  auto ns_info = static_cast<NamespaceInfo*>(it->second.get());
+  auto ns_info = static_cast<NamespaceInfo*>(UnshareObject(obj));
 
   ns_info->set_start_time_ns(update.start_timestamp_ns());
   ns_info->set_stop_time_ns(update.stop_timestamp_ns());
 
   VLOG(1) << "namespace update: " << update.name();
 
-  namespaces_by_name_[{ns, name}] = namespace_uid;
+  SetIfChanged(&namespaces_by_name_, K8sNameIdent{ns, name}, namespace_uid);
   return Status::OK();
 }
 
@@ -289,45 +345,69 @@ bool IsExpired(const T& obj, int64_t retention_time, int64_t now) {
 Status K8sMetadataState::CleanupExpiredMetadata(int64_t retention_time_ns) {
   int64_t now = CurrentTimeNS();
 
-  for (auto iter = k8s_objects_by_id_.begin(); iter != k8s_objects_by_id_.end();) {
-    const auto& k8s_object = iter->second;
-
-    if (!IsExpired(*k8s_object, retention_time_ns, now)) {
-      ++iter;
-      continue;
+  // The expired objects are collected first, since erasing from a CowMap invalidates its
+  // iterators.
+  std::vector<K8sMetadataObjectPtr> expired_objects;
+  for (const auto& [uid, k8s_object] : k8s_objects_by_id_) {
+    if (IsExpired(*k8s_object, retention_time_ns, now)) {
+      expired_objects.push_back(k8s_object);
     }
+  }
 
+  for (const auto& k8s_object : expired_objects) {
+    K8sNameIdentView name_ident(k8s_object->ns(), k8s_object->name());
     switch (k8s_object->type()) {
-      case K8sObjectType::kPod:
-        pods_by_name_.erase({k8s_object->ns(), k8s_object->name()});
-        pods_by_ip_.erase(static_cast<PodInfo*>(k8s_object.get())->pod_ip());
-        break;
+      case K8sObjectType::kPod: {
+        const auto* pod_info = static_cast<const PodInfo*>(k8s_object.get());
+        pods_by_name_.erase(name_ident);
+        pods_by_ip_.erase(pod_info->pod_ip());
+        RemoveFromIndex(&pods_by_node_name_, pod_info->node_name(), pod_info->uid());
+        for (const auto& service_uid : pod_info->services()) {
+          RemoveFromIndex(&pods_by_service_id_, service_uid, pod_info->uid());
+        }
+      } break;
       case K8sObjectType::kNamespace:
-        namespaces_by_name_.erase({k8s_object->ns(), k8s_object->name()});
-        break;
-      case K8sObjectType::kService:
-        services_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+        namespaces_by_name_.erase(name_ident);
         break;
+      case K8sObjectType::kService: {
+        services_by_name_.erase(name_ident);
+        // Drop the service from its pods, so that lookups through PodInfo::services() don't keep
+        // visiting it.
+        const UIDSet* pod_uids = pods_by_service_id_.Find(k8s_object->uid());
+        if (pod_uids != nullptr) {
+          for (const auto& pod_uid : *pod_uids) {
+            K8sMetadataObjectPtr* pod = k8s_objects_by_id_.FindMutable(pod_uid);
+            if (pod != nullptr) {
+              static_cast<PodInfo*>(UnshareObject(pod))->RmService(k8s_object->uid());
+            }
+          }
+          pods_by_service_id_.erase(k8s_object->uid());
+        }
+      } break;
       default:
         LOG(DFATAL) << absl::Substitute("Unexpected object type: $0",
                                         static_cast<int>(k8s_object->type()));
     }
 
-    k8s_objects_by_id_.erase(iter++);
+    k8s_objects_by_id_.erase(k8s_object->uid());
   }
 
-  for (auto iter = containers_by_id_.begin(); iter != containers_by_id_.end();) {
-    const auto& cinfo = iter->second;
-
-    if (!IsExpired(*cinfo, retention_time_ns, now)) {
-      ++iter;
-      continue;
+  std::vector<ContainerInfoPtr> expired_containers;
+  for (const auto& [cid, cinfo] : containers_by_id_) {
+    if (IsExpired(*cinfo, retention_time_ns, now)) {
+      expired_containers.push_back(cinfo);
     }
+  }
 
+  for (const auto& cinfo : expired_containers) {
     containers_by_name_.erase(cinfo->name());
-    containers_by_id_.erase(iter++);
+    containers_by_id_.erase(cinfo->cid());
   }
 
+  // Names only used by the objects dropped above are freed on the next pass, once the older
+  // clones of this state that still hold them are gone.
+  StringPool::Global()->Collect();
+
   return Status::OK();
 }
 
@@ -337,10 +417,7 @@ std::shared_ptr<AgentMetadataState> AgentMetadataState::CloneToShared() const {
   state->epoch_id_ = epoch_id_;
   state->asid_ = asid_;
   state->k8s_metadata_state_ = k8s_metadata_state_->Clone();
-  state->pids_by_upid_.reserve(pids_by_upid_.size());
-  for (const auto& [k, v] : pids_by_upid_) {
-    state->pids_by_upid_[k] = v->Clone();
-  }
+  state->pids_by_upid_ = pids_by_upid_;
   state->upids_ = upids_;
   return state;
 }
@@ -28,6 +28,7 @@
 
 #include "src/common/base/base.h"
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
+#include "src/shared/metadata/cow_map.h"
 #include "src/shared/metadata/k8s_objects.h"
 #include "src/shared/metadata/pids.h"
 #include "src/shared/upid/upid.h"
@@ -35,13 +36,18 @@
 namespace px {
 namespace md {
 
-using K8sMetadataObjectUPtr = std::unique_ptr<K8sMetadataObject>;
-using ContainerInfoUPtr = std::unique_ptr<ContainerInfo>;
-using PIDInfoUPtr = std::unique_ptr<PIDInfo>;
+// The objects are shared between the states of consecutive epochs, and are only copied when one
+// of them modifies them (see UnshareObject).
+using K8sMetadataObjectPtr = std::shared_ptr<K8sMetadataObject>;
+using ContainerInfoPtr = std::shared_ptr<ContainerInfo>;
+using PIDInfoPtr = std::shared_ptr<PIDInfo>;
 using AgentID = sole::uuid;
 
 /**
  * This class contains all kubernetes relate metadata.
+ *
+ * All the maps are CowMaps that share their contents with the state this one was cloned from, so
+ * Clone is cheap and an update only copies the parts of the state that it changes.
  */
 class K8sMetadataState : NotCopyable {
  public:
@@ -90,14 +96,18 @@ class K8sMetadataState : NotCopyable {
       }
     };
   };
-  using K8sEntityByNameMap =
-      absl::flat_hash_map<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>;
+  using K8sEntityByNameMap = CowMap<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>;
 
   using PodsByNameMap = K8sEntityByNameMap;
   using ServicesByNameMap = K8sEntityByNameMap;
   using NamespacesByNameMap = K8sEntityByNameMap;
-  using ContainersByNameMap = absl::flat_hash_map<std::string, CID>;
-  using PodsByPodIpMap = absl::flat_hash_map<std::string, UID>;
+  using ContainersByNameMap = CowMap<std::string, CID>;
+  using PodsByPodIpMap = CowMap<std::string, UID>;
+  using UIDSet = absl::flat_hash_set<UID>;
+  using PodsByNodeNameMap = CowMap<std::string, UIDSet>;
+  using PodsByServiceIDMap = CowMap<UID, UIDSet>;
+  using K8sObjectsByIDMap = CowMap<UID, K8sMetadataObjectPtr>;
+  using ContainersByIDMap = CowMap<CID, ContainerInfoPtr>;
 
   void set_service_cidr(CIDRBlock cidr) {
     if (!service_cidr_.has_value() || service_cidr_.value() != cidr) {
@@ -135,6 +145,21 @@ class K8sMetadataState : NotCopyable {
    */
   UID PodIDByIP(std::string_view pod_ip) const;
 
+  /**
+   * PodIDsByNodeName returns the IDs of the pods scheduled on the given node.
+   * @param node_name the node name
+   * @return the pod ids, or nullptr if the node has no pods.
+   */
+  const UIDSet* PodIDsByNodeName(std::string_view node_name) const;
+
+  /**
+   * PodIDsByServiceID returns the IDs of the pods that back the given service. This is the
+   * reverse of PodInfo::services().
+   * @param service_id the id of the Service.
+   * @return the pod ids, or nullptr if the service has no pods.
+   */
+  const UIDSet* PodIDsByServiceID(UIDView service_id) const;
+
   /**
    * ContainerInfoByID returns the container info by ID.
    * @param id The ID of the container.
@@ -188,7 +213,16 @@ class K8sMetadataState : NotCopyable {
 
   Status CleanupExpiredMetadata(int64_t retention_time_ns);
 
-  absl::flat_hash_map<CID, ContainerInfoUPtr>& containers_by_id() { return containers_by_id_; }
+  const ContainersByIDMap& containers_by_id() const { return containers_by_id_; }
+
+  /**
+   * MutableContainerInfoByID returns the container info by ID, for modifying it. The container is
+   * copied first if it's shared with another state, so only use this to actually write.
+   * @param id The ID of the container.
+   * @return ContainerInfo or nullptr if not found.
+   */
+  ContainerInfo* MutableContainerInfoByID(CIDView id);
+
   std::string DebugString(int indent_level = 0) const;
 
  private:
@@ -201,10 +235,10 @@ class K8sMetadataState : NotCopyable {
   std::vector<CIDRBlock> pod_cidrs_;
 
   // This stores K8s native objects (services, pods, etc).
-  absl::flat_hash_map<UID, K8sMetadataObjectUPtr> k8s_objects_by_id_;
+  K8sObjectsByIDMap k8s_objects_by_id_;
 
   // This stores container objects, complementing k8s_objects_by_id_.
-  absl::flat_hash_map<CID, ContainerInfoUPtr> containers_by_id_;
+  ContainersByIDMap containers_by_id_;
 
   /**
    * Mapping of pods by name.
@@ -230,10 +264,22 @@ class K8sMetadataState : NotCopyable {
    * Mapping of Pods by host ip.
    */
   PodsByPodIpMap pods_by_ip_;
+
+  /**
+   * Mapping of Pods by the name of the node they are scheduled on.
+   */
+  PodsByNodeNameMap pods_by_node_name_;
+
+  /**
+   * Mapping of Pods by the services they back, kept in sync with PodInfo::services().
+   */
+  PodsByServiceIDMap pods_by_service_id_;
 };
 
 class AgentMetadataState : NotCopyable {
  public:
+  using PIDInfoByUPIDMap = CowMap<UPID, PIDInfoPtr, UPIDHash>;
+
   AgentMetadataState() = delete;
   explicit AgentMetadataState(uint32_t asid)
       : AgentMetadataState(/* hostname */ "unknown", asid, sole::uuid(), /* pod_name */ "unknown") {
@@ -264,12 +310,9 @@ class AgentMetadataState : NotCopyable {
 
   std::shared_ptr<AgentMetadataState> CloneToShared() const;
 
-  PIDInfo* GetPIDByUPID(UPID upid) const {
-    auto it = pids_by_upid_.find(upid);
-    if (it != pids_by_upid_.end()) {
-      return it->second.get();
-    }
-    return nullptr;
+  const PIDInfo* GetPIDByUPID(UPID upid) const {
+    const PIDInfoPtr* pid_info = pids_by_upid_.Find(upid);
+    return pid_info == nullptr ? nullptr : pid_info->get();
   }
 
   void AddUPID(UPID upid, std::unique_ptr<PIDInfo> pid_info) {
@@ -277,22 +320,24 @@ class AgentMetadataState : NotCopyable {
     DCHECK_EQ(pid_info->stop_time_ns(), 0);
 
     pids_by_upid_[upid] = std::move(pid_info);
-    upids_.insert(upid);
+    MutableUPIDs()->insert(upid);
   }
 
   void MarkUPIDAsStopped(UPID upid, int64_t ts) {
-    auto* pid_info = GetPIDByUPID(upid);
+    PIDInfoPtr* pid_info = pids_by_upid_.FindMutable(upid);
     if (pid_info != nullptr) {
-      pid_info->set_stop_time_ns(ts);
-      upids_.erase(upid);
+      UnshareObject(pid_info)->set_stop_time_ns(ts);
+      if (upids_->contains(upid)) {
+        MutableUPIDs()->erase(upid);
+      }
     } else {
-      DCHECK(!upids_.contains(upid));
+      DCHECK(!upids_->contains(upid));
     }
   }
 
-  const absl::flat_hash_map<UPID, PIDInfoUPtr>& pids_by_upid() const { return pids_by_upid_; }
+  const PIDInfoByUPIDMap& pids_by_upid() const { return pids_by_upid_; }
 
-  const absl::flat_hash_set<md::UPID>& upids() const { return upids_; }
+  const absl::flat_hash_set<md::UPID>& upids() const { return *upids_; }
 
   std::string DebugString(int indent_level = 0) const;
 
@@ -320,14 +365,23 @@ class AgentMetadataState : NotCopyable {
   /**
    * Mapping of PIDs by UPID for active pods on the system.
    */
-  absl::flat_hash_map<UPID, PIDInfoUPtr> pids_by_upid_;
+  PIDInfoByUPIDMap pids_by_upid_;
+
+  absl::flat_hash_set<md::UPID>* MutableUPIDs() {
+    if (upids_.use_count() > 1) {
+      upids_ = std::make_shared<absl::flat_hash_set<md::UPID>>(*upids_);
+    }
+    return upids_.get();
+  }
 
   /**
    * All active UPIDs. Unlike pids_by_upid_, this does not contain stopped pids.
    * While this set could be reconstructed from pids_by_upid_,
    * it is tracked separately as a performance optimization.
+   * Like the maps, it's shared with the cloned states until one of them changes it.
    */
-  absl::flat_hash_set<md::UPID> upids_;
+  std::shared_ptr<absl::flat_hash_set<md::UPID>> upids_ =
+      std::make_shared<absl::flat_hash_set<md::UPID>>();
 };
 
 }  // namespace md
@@ -20,6 +20,8 @@
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
 #include "src/common/base/test_utils.h"
 #include "src/shared/metadata/metadata_state.h"
 
@@ -113,6 +115,60 @@ TEST(K8sMetadataStateTest, CloneCopiedCIDR) {
   EXPECT_EQ(service_cidr.prefix_length, state_copy->service_cidr()->prefix_length);
 }
 
+TEST(K8sMetadataStateTest, CloneSharesUnchangedObjects) {
+  K8sMetadataState state;
+
+  K8sMetadataState::ContainerUpdate container_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kContainer0UpdatePbTxt, &container_update))
+      << "Failed to parse proto";
+  K8sMetadataState::PodUpdate pod_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod_update))
+      << "Failed to parse proto";
+  K8sMetadataState::ServiceUpdate service_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kRunningServiceUpdatePbTxt, &service_update))
+      << "Failed to parse proto";
+
+  EXPECT_OK(state.HandleContainerUpdate(container_update));
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+
+  auto state_copy = state.Clone();
+  EXPECT_EQ(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+  EXPECT_EQ(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+
+  // Updating the copy copies the objects it touches, and leaves the original alone.
+  EXPECT_OK(state_copy->HandleServiceUpdate(service_update));
+  EXPECT_NE(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+  EXPECT_THAT(state_copy->PodInfoByID("pod0_uid")->services(),
+              UnorderedElementsAre("service0_uid"));
+  EXPECT_TRUE(state.PodInfoByID("pod0_uid")->services().empty());
+  EXPECT_EQ(nullptr, state.ServiceInfoByID("service0_uid"));
+  EXPECT_NE(nullptr, state_copy->ServiceInfoByID("service0_uid"));
+  EXPECT_EQ(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+
+  state_copy->MutableContainerInfoByID("container0_uid")->set_stop_time_ns(1000);
+  EXPECT_EQ(102, state.ContainerInfoByID("container0_uid")->stop_time_ns());
+  EXPECT_EQ(1000, state_copy->ContainerInfoByID("container0_uid")->stop_time_ns());
+}
+
+TEST(AgentMetadataStateTest, CloneSharesUnchangedPIDs) {
+  AgentMetadataState state(/* asid */ 1);
+  UPID upid0(1, 100, 1000);
+  UPID upid1(1, 101, 1001);
+  state.AddUPID(upid0, std::make_unique<PIDInfo>(upid0, "cmd0", "container0_uid"));
+  state.AddUPID(upid1, std::make_unique<PIDInfo>(upid1, "cmd1", "container0_uid"));
+
+  auto state_copy = state.CloneToShared();
+  state_copy->MarkUPIDAsStopped(upid0, 2000);
+
+  EXPECT_EQ(0, state.GetPIDByUPID(upid0)->stop_time_ns());
+  EXPECT_EQ(2000, state_copy->GetPIDByUPID(upid0)->stop_time_ns());
+  EXPECT_EQ(state.GetPIDByUPID(upid1), state_copy->GetPIDByUPID(upid1));
+  EXPECT_THAT(state.upids(), UnorderedElementsAre(upid0, upid1));
+  EXPECT_THAT(state_copy->upids(), UnorderedElementsAre(upid1));
+}
+
 TEST(K8sMetadataStateTest, HandleContainerUpdate) {
   K8sMetadataState state;
 
@@ -177,6 +233,16 @@ TEST(K8sMetadataStateTest, HandlePodUpdate) {
 
   // Check that the container info pod ID got set.
   EXPECT_EQ("pod0_uid", container_info->pod_id());
+
+  ASSERT_NE(nullptr, state.PodIDsByNodeName("a_node"));
+  EXPECT_THAT(*state.PodIDsByNodeName("a_node"), UnorderedElementsAre("pod0_uid"));
+
+  // Moving the pod to another node updates the index.
+  pod_update.set_node_name("b_node");
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+  EXPECT_EQ(nullptr, state.PodIDsByNodeName("a_node"));
+  ASSERT_NE(nullptr, state.PodIDsByNodeName("b_node"));
+  EXPECT_THAT(*state.PodIDsByNodeName("b_node"), UnorderedElementsAre("pod0_uid"));
 }
 
 TEST(K8sMetadataStateTest, HandleServiceUpdate) {
@@ -210,6 +276,8 @@ TEST(K8sMetadataStateTest, HandleServiceUpdate) {
 
   // Check that the pod info service got set.
   EXPECT_THAT(pod_info->services(), UnorderedElementsAre("service0_uid"));
+  ASSERT_NE(nullptr, state.PodIDsByServiceID("service0_uid"));
+  EXPECT_THAT(*state.PodIDsByServiceID("service0_uid"), UnorderedElementsAre("pod0_uid"));
 }
 
 TEST(K8sMetadataStateTest, HandleNamespaceUpdate) {
@@ -310,8 +378,32 @@ TEST(K8sMetadataStateTest, CleanupExpiredMetadata) {
 
     const ContainerInfo* container_info = state.ContainerInfoByID("container0_uid");
     ASSERT_EQ(container_info, nullptr);
+
+    EXPECT_EQ(state.PodIDsByNodeName("a_node"), nullptr);
+    EXPECT_EQ(state.PodIDsByServiceID("service0_uid"), nullptr);
   }
 }
 
+TEST(K8sMetadataStateTest, CleanupExpiredServiceRemovesItFromPods) {
+  K8sMetadataState state;
+
+  K8sMetadataState::PodUpdate pod_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod_update));
+  pod_update.set_stop_timestamp_ns(0);
+
+  K8sMetadataState::ServiceUpdate service_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kRunningServiceUpdatePbTxt, &service_update));
+
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+  EXPECT_OK(state.HandleServiceUpdate(service_update));
+  ASSERT_OK(state.CleanupExpiredMetadata(/* retention_time_ns */ 0));
+
+  const PodInfo* pod_info = state.PodInfoByID("pod0_uid");
+  ASSERT_NE(pod_info, nullptr);
+  EXPECT_THAT(pod_info->services(), ::testing::IsEmpty());
+  EXPECT_EQ(state.PodIDsByServiceID("service0_uid"), nullptr);
+  ASSERT_NE(state.PodIDsByNodeName("a_node"), nullptr);
+}
+
 }  // namespace md
 }  // namespace px
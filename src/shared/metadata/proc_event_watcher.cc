@@ -0,0 +1,211 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/metadata/proc_event_watcher.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/strip.h>
+
+namespace px {
+namespace md {
+
+namespace {
+
+// How often the background thread checks whether it should stop.
+constexpr int kPollTimeoutMillis = 200;
+
+// Docker, containerd and CRI-O all use 64 hex digits for container IDs.
+constexpr size_t kContainerIDLength = 64;
+
+}  // namespace
+
+std::string_view ContainerIDFromCGroupPath(std::string_view cgroup_path) {
+  std::string_view name = cgroup_path.substr(cgroup_path.find_last_of('/') + 1);
+  if (absl::ConsumeSuffix(&name, ".scope")) {
+    // systemd names the scope <runtime>-<cid>.scope.
+    name = name.substr(name.find_last_of('-') + 1);
+  }
+  if (name.size() != kContainerIDLength ||
+      !std::all_of(name.begin(), name.end(), [](char c) { return absl::ascii_isxdigit(c); })) {
+    return {};
+  }
+  return name;
+}
+
+StatusOr<std::unique_ptr<ProcEventWatcher>> ProcEventWatcher::Create(const system::Config& cfg) {
+  int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (fd < 0) {
+    return error::Internal("Could not create proc connector socket. [errno=$0]", errno);
+  }
+
+  struct sockaddr_nl addr = {};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = CN_IDX_PROC;
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+    close(fd);
+    return error::Internal("Could not bind proc connector socket. [errno=$0]", errno);
+  }
+
+  // Subscribe to the process events.
+  constexpr size_t kReqPayloadSize = sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op);
+  alignas(struct nlmsghdr) char req[NLMSG_SPACE(kReqPayloadSize)] = {};
+  auto* hdr = reinterpret_cast<struct nlmsghdr*>(req);
+  hdr->nlmsg_len = NLMSG_LENGTH(kReqPayloadSize);
+  hdr->nlmsg_type = NLMSG_DONE;
+  auto* msg = reinterpret_cast<struct cn_msg*>(NLMSG_DATA(hdr));
+  msg->id.idx = CN_IDX_PROC;
+  msg->id.val = CN_VAL_PROC;
+  msg->len = sizeof(enum proc_cn_mcast_op);
+  *reinterpret_cast<enum proc_cn_mcast_op*>(msg->data) = PROC_CN_MCAST_LISTEN;
+  if (send(fd, req, hdr->nlmsg_len, 0) < 0) {
+    close(fd);
+    return error::Internal("Could not subscribe to proc events. [errno=$0]", errno);
+  }
+
+  return std::unique_ptr<ProcEventWatcher>(new ProcEventWatcher(fd, cfg.proc_path()));
+}
+
+ProcEventWatcher::ProcEventWatcher(int fd, std::filesystem::path proc_path)
+    : fd_(fd), proc_path_(std::move(proc_path)) {
+  thread_ = std::thread(&ProcEventWatcher::Run, this);
+}
+
+ProcEventWatcher::~ProcEventWatcher() {
+  running_ = false;
+  thread_.join();
+  close(fd_);
+}
+
+bool ProcEventWatcher::TakeChanges(PIDChanges* changes) {
+  std::lock_guard<std::mutex> lock(changes_lock_);
+  *changes = std::move(changes_);
+  changes_ = PIDChanges();
+  bool lost = lost_;
+  lost_ = false;
+  return !lost;
+}
+
+void ProcEventWatcher::Run() {
+  alignas(struct nlmsghdr) char buf[16 * 1024];
+  while (running_) {
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    if (poll(&pfd, 1, kPollTimeoutMillis) <= 0) {
+      continue;
+    }
+    ssize_t len = recv(fd_, buf, sizeof(buf), 0);
+    if (len < 0) {
+      if (errno == ENOBUFS) {
+        // The socket buffer overflowed, so the kernel dropped some events.
+        MarkLost();
+      }
+      continue;
+    }
+    HandleMessages(buf, static_cast<int>(len));
+  }
+}
+
+void ProcEventWatcher::HandleMessages(char* buf, int len) {
+  for (auto* hdr = reinterpret_cast<struct nlmsghdr*>(buf); NLMSG_OK(hdr, len);
+       hdr = NLMSG_NEXT(hdr, len)) {
+    if (hdr->nlmsg_type == NLMSG_ERROR || hdr->nlmsg_type == NLMSG_NOOP) {
+      continue;
+    }
+    const auto* msg = reinterpret_cast<const struct cn_msg*>(NLMSG_DATA(hdr));
+    if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC) {
+      continue;
+    }
+
+    // Threads are reported too; only processes matter here.
+    const auto* event = reinterpret_cast<const struct proc_event*>(msg->data);
+    switch (event->what) {
+      case proc_event::PROC_EVENT_FORK:
+        if (event->event_data.fork.child_pid == event->event_data.fork.child_tgid) {
+          RecordStartedPID(event->event_data.fork.child_tgid);
+        }
+        break;
+      case proc_event::PROC_EVENT_EXEC:
+        if (event->event_data.exec.process_pid == event->event_data.exec.process_tgid) {
+          RecordStartedPID(event->event_data.exec.process_tgid);
+        }
+        break;
+      case proc_event::PROC_EVENT_EXIT:
+        if (event->event_data.exit.process_pid == event->event_data.exit.process_tgid) {
+          RecordExitedPID(event->event_data.exit.process_tgid);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void ProcEventWatcher::RecordStartedPID(uint32_t pid) {
+  // The cgroup has to be read now, while the process is still around.
+  std::ifstream ifs(proc_path_ / std::to_string(pid) / "cgroup");
+  std::string line;
+  std::string_view cid;
+  while (cid.empty() && std::getline(ifs, line)) {
+    // Each line is <hierarchy-id>:<controllers>:<path>.
+    size_t pos = line.find(':', line.find(':') + 1);
+    if (pos != std::string::npos) {
+      cid = ContainerIDFromCGroupPath(std::string_view(line).substr(pos + 1));
+    }
+  }
+  if (cid.empty()) {
+    // Not a container process, or it already exited.
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(changes_lock_);
+  changes_.started_cids.emplace(cid);
+  DropChangesIfOverflowed();
+}
+
+void ProcEventWatcher::RecordExitedPID(uint32_t pid) {
+  std::lock_guard<std::mutex> lock(changes_lock_);
+  changes_.exited_pids.insert(pid);
+  DropChangesIfOverflowed();
+}
+
+void ProcEventWatcher::DropChangesIfOverflowed() {
+  if (changes_.started_cids.size() + changes_.exited_pids.size() > kMaxPendingChanges) {
+    changes_ = PIDChanges();
+    lost_ = true;
+  }
+}
+
+void ProcEventWatcher::MarkLost() {
+  std::lock_guard<std::mutex> lock(changes_lock_);
+  changes_ = PIDChanges();
+  lost_ = true;
+}
+
+}  // namespace md
+}  // namespace px
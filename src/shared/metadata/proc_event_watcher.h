@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/common/base/base.h"
+#include "src/common/system/system.h"
+#include "src/shared/upid/upid.h"
+
+namespace px {
+namespace md {
+
+/**
+ * PIDChanges describes the process activity seen since the last PID scan.
+ */
+struct PIDChanges {
+  // Containers in which a process was started (forked or exec'd).
+  absl::flat_hash_set<CID> started_cids;
+  // Processes that exited. They can't be attributed to a container anymore, so they're matched
+  // against the known UPIDs instead.
+  absl::flat_hash_set<uint32_t> exited_pids;
+};
+
+/**
+ * ContainerIDFromCGroupPath extracts the container ID from the cgroup path of a process, as listed
+ * in /proc/<pid>/cgroup. Both the cgroupfs (.../pod<uid>/<cid>) and the systemd
+ * (.../docker-<cid>.scope, .../cri-containerd-<cid>.scope, ...) layouts are supported.
+ * @return the container ID, or an empty string if the path doesn't belong to a container.
+ */
+std::string_view ContainerIDFromCGroupPath(std::string_view cgroup_path);
+
+/**
+ * ProcEventWatcher listens to the process events of the kernel (through the netlink proc
+ * connector), and tracks which containers may have gained or lost processes. This lets the PID
+ * scan skip the containers that haven't changed, rather than reading the cgroup of every
+ * container on every metadata update.
+ *
+ * The events are read on a background thread. Subscribing to them requires CAP_NET_ADMIN.
+ */
+class ProcEventWatcher : public NotCopyable {
+ public:
+  static StatusOr<std::unique_ptr<ProcEventWatcher>> Create(const system::Config& cfg);
+
+  ~ProcEventWatcher();
+
+  /**
+   * Moves the changes seen since the last call into changes.
+   * @return false if some events were lost, in which case every container needs to be rescanned.
+   */
+  bool TakeChanges(PIDChanges* changes);
+
+ private:
+  // Bounds the memory used when the changes aren't taken for a long time; past this, the changes
+  // are dropped and reported as lost.
+  static constexpr size_t kMaxPendingChanges = 64 * 1024;
+
+  ProcEventWatcher(int fd, std::filesystem::path proc_path);
+
+  void Run();
+  void HandleMessages(char* buf, int len);
+  void RecordStartedPID(uint32_t pid);
+  void RecordExitedPID(uint32_t pid);
+  // Must be called with changes_lock_ held.
+  void DropChangesIfOverflowed();
+  void MarkLost();
+
+  const int fd_;
+  const std::filesystem::path proc_path_;
+
+  std::mutex changes_lock_;
+  PIDChanges changes_;
+  bool lost_ = false;
+
+  std::atomic<bool> running_ = true;
+  std::thread thread_;
+};
+
+}  // namespace md
+}  // namespace px
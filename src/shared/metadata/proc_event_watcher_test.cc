@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/shared/metadata/proc_event_watcher.h"
+
+namespace px {
+namespace md {
+
+constexpr char kCID[] = "a7638fe3934b37419cc56bca73465a02b354ba6e98e10272542d84eb2014dd62";
+
+TEST(ContainerIDFromCGroupPathTest, cgroupfs) {
+  EXPECT_EQ(kCID, ContainerIDFromCGroupPath(absl::StrCat(
+                      "/kubepods/burstable/pod5c5f8fba-4ad2-4d2d-9e8b-d3a6e5b1f4a1/", kCID)));
+}
+
+TEST(ContainerIDFromCGroupPathTest, systemd) {
+  EXPECT_EQ(kCID, ContainerIDFromCGroupPath(
+                      absl::StrCat("/kubepods.slice/kubepods-besteffort.slice/"
+                                   "kubepods-besteffort-pod5c5f8fba_4ad2.slice/docker-",
+                                   kCID, ".scope")));
+  EXPECT_EQ(kCID, ContainerIDFromCGroupPath(
+                      absl::StrCat("/kubepods.slice/cri-containerd-", kCID, ".scope")));
+  EXPECT_EQ(kCID, ContainerIDFromCGroupPath(absl::StrCat("/kubepods.slice/crio-", kCID, ".scope")));
+}
+
+TEST(ContainerIDFromCGroupPathTest, not_a_container) {
+  EXPECT_EQ("", ContainerIDFromCGroupPath("/"));
+  EXPECT_EQ("", ContainerIDFromCGroupPath("/user.slice/user-1000.slice/session-2.scope"));
+  EXPECT_EQ("", ContainerIDFromCGroupPath("/system.slice/docker.service"));
+  EXPECT_EQ("", ContainerIDFromCGroupPath("/kubepods/burstable/pod5c5f8fba-4ad2-4d2d-9e8b"));
+  std::string not_hex(64, 'z');
+  EXPECT_EQ("", ContainerIDFromCGroupPath(absl::StrCat("/kubepods/", not_hex)));
+}
+
+}  // namespace md
+}  // namespace px
@@ -16,13 +16,25 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include "src/shared/metadata/state_manager.h"
 
+DEFINE_bool(metadata_watch_proc_events,
+            gflags::BoolFromEnv("PL_METADATA_WATCH_PROC_EVENTS", true),
+            "Use process events to only read the PIDs of the containers that changed.");
+DEFINE_int32(metadata_pid_full_rescan_epochs,
+             gflags::Int32FromEnv("PL_METADATA_PID_FULL_RESCAN_EPOCHS", 12),
+             "When using process events, read the PIDs of all the containers every this many "
+             "metadata updates anyway, in case an event was missed. 0 disables the rescans.");
+
 namespace px {
 namespace md {
 
@@ -89,9 +101,15 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
       ApplyK8sUpdates(ts, shadow_state.get(), metadata_filter_, &incoming_k8s_updates_));
 
   if (collects_data_) {
-    // Update PID information.
-    PL_RETURN_IF_ERROR(
-        ProcessPIDUpdates(ts, proc_parser_, shadow_state.get(), md_reader_.get(), &pid_updates_));
+    // Update PID information. With process events, only the containers that started or lost
+    // processes need their PIDs read.
+    PIDChanges pid_changes;
+    bool use_changes = proc_event_watcher_ != nullptr &&
+                       proc_event_watcher_->TakeChanges(&pid_changes) &&
+                       (FLAGS_metadata_pid_full_rescan_epochs <= 0 ||
+                        epoch_id % FLAGS_metadata_pid_full_rescan_epochs != 0);
+    PL_RETURN_IF_ERROR(ProcessPIDUpdates(ts, proc_parser_, shadow_state.get(), md_reader_.get(),
+                                         &pid_updates_, use_changes ? &pid_changes : nullptr));
   }
 
   // Update the pod/service CIDRs if they have been updated.
@@ -128,14 +146,132 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   return Status::OK();
 }
 
+namespace {
+
+using StringList = google::protobuf::RepeatedPtrField<std::string>;
+
+std::string_view UpdatedObjectID(const ResourceUpdate& update) {
+  switch (update.update_case()) {
+    case ResourceUpdate::kPodUpdate:
+      return update.pod_update().uid();
+    case ResourceUpdate::kContainerUpdate:
+      return update.container_update().cid();
+    case ResourceUpdate::kServiceUpdate:
+      return update.service_update().uid();
+    case ResourceUpdate::kNamespaceUpdate:
+      return update.namespace_update().uid();
+    default:
+      return {};
+  }
+}
+
+// The order in which the update types are applied within a batch. Pods look up their containers
+// and services look up their pods, so those have to be applied first.
+int UpdateRank(const ResourceUpdate& update) {
+  switch (update.update_case()) {
+    case ResourceUpdate::kNamespaceUpdate:
+      return 0;
+    case ResourceUpdate::kContainerUpdate:
+      return 1;
+    case ResourceUpdate::kPodUpdate:
+      return 2;
+    case ResourceUpdate::kServiceUpdate:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+// Adds the IDs (and their names, when given) of from_ids that are missing from to_ids.
+void MergeIDs(const StringList& from_ids, const StringList& from_names, StringList* to_ids,
+              StringList* to_names) {
+  bool has_names = from_names.size() == from_ids.size() && to_names->size() == to_ids->size();
+  absl::flat_hash_set<std::string> ids(to_ids->begin(), to_ids->end());
+  for (int i = 0; i < from_ids.size(); ++i) {
+    if (!ids.insert(from_ids[i]).second) {
+      continue;
+    }
+    *to_ids->Add() = from_ids[i];
+    if (has_names) {
+      *to_names->Add() = from_names[i];
+    }
+  }
+}
+
+// Carries over what an earlier update of the same object contributes to the state into the later
+// one. Returns true if the earlier update can then be skipped.
+bool FoldIntoLaterUpdate(const ResourceUpdate& earlier, ResourceUpdate* later) {
+  switch (later->update_case()) {
+    case ResourceUpdate::kPodUpdate: {
+      // Pods never lose containers in the state, so the later update takes all of them.
+      const PodUpdate& from = earlier.pod_update();
+      PodUpdate* to = later->mutable_pod_update();
+      MergeIDs(from.container_ids(), from.container_names(), to->mutable_container_ids(),
+               to->mutable_container_names());
+      // The pod stays reachable by an earlier IP, so an update with a different one is kept.
+      bool from_sets_ip = from.host_ip() != from.pod_ip();
+      bool to_sets_ip = to->host_ip() != to->pod_ip();
+      return !from_sets_ip || (to_sets_ip && from.pod_ip() == to->pod_ip());
+    }
+    case ResourceUpdate::kServiceUpdate: {
+      // Likewise, services never lose pods.
+      const ServiceUpdate& from = earlier.service_update();
+      ServiceUpdate* to = later->mutable_service_update();
+      MergeIDs(from.pod_ids(), from.pod_names(), to->mutable_pod_ids(), to->mutable_pod_names());
+      return true;
+    }
+    case ResourceUpdate::kContainerUpdate:
+    case ResourceUpdate::kNamespaceUpdate:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
 Status ApplyK8sUpdates(
     int64_t ts, AgentMetadataState* state, AgentMetadataFilter* metadata_filter,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>>* updates) {
-  std::unique_ptr<ResourceUpdate> update(nullptr);
   PL_UNUSED(ts);
 
+  std::vector<std::unique_ptr<ResourceUpdate>> batch;
+  batch.reserve(updates->size_approx());
+  std::unique_ptr<ResourceUpdate> update(nullptr);
   // Returns false when no more items.
   while (updates->try_dequeue(update)) {
+    batch.push_back(std::move(update));
+  }
+
+  // During rollouts the queue holds many updates of the same objects. Only the latest update of
+  // each object is applied, with whatever the earlier ones would have added folded into it.
+  absl::flat_hash_map<std::pair<ResourceUpdate::UpdateCase, std::string>, size_t> latest_update;
+  latest_update.reserve(batch.size());
+  size_t num_coalesced = 0;
+  for (size_t i = 0; i < batch.size(); ++i) {
+    std::string_view object_id = UpdatedObjectID(*batch[i]);
+    if (object_id.empty()) {
+      continue;
+    }
+    auto [it, inserted] = latest_update.try_emplace(
+        std::make_pair(batch[i]->update_case(), std::string(object_id)), i);
+    if (inserted) {
+      continue;
+    }
+    if (FoldIntoLaterUpdate(*batch[it->second], batch[i].get())) {
+      batch[it->second].reset();
+      ++num_coalesced;
+    }
+    it->second = i;
+  }
+  batch.erase(std::remove(batch.begin(), batch.end(), nullptr), batch.end());
+  std::stable_sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) {
+    return UpdateRank(*a) < UpdateRank(*b);
+  });
+  VLOG(1) << absl::Substitute("Applying $0 K8s updates ($1 coalesced)", batch.size(),
+                              num_coalesced);
+
+  for (const auto& update : batch) {
     switch (update->update_case()) {
       case ResourceUpdate::kPodUpdate:
         PL_RETURN_IF_ERROR(HandlePodUpdate(update->pod_update(), state, metadata_filter));
@@ -166,6 +302,21 @@ StatusOr<UPID> InitUPID(const system::ProcParser& proc_parser, uint32_t asid, ui
   return UPID(asid, pid, pid_start_time);
 }
 
+// Containers are shared with the metadata states of earlier epochs until they're modified, so
+// this is checked before getting a container for writing in order to leave unchanged ones alone.
+bool ContainerPIDsChanged(const absl::flat_hash_set<UPID>& upids,
+                          const absl::flat_hash_set<uint32_t>& cgroups_pids) {
+  if (upids.size() != cgroups_pids.size()) {
+    return true;
+  }
+  for (const auto& upid : upids) {
+    if (!cgroups_pids.contains(upid.pid())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 void ProcessContainerPIDUpdates(
@@ -220,9 +371,26 @@ void ProcessContainerPIDUpdates(
 Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState* md,
     CGroupMetadataReader* md_reader,
-    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates) {
-  const auto& k8s_md_state = md->k8s_metadata_state();
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates,
+    const PIDChanges* changes) {
+  K8sMetadataState* k8s_md_state = md->k8s_metadata_state();
+
+  absl::flat_hash_set<CID> changed_cids;
+  if (changes != nullptr) {
+    changed_cids = changes->started_cids;
+    for (const auto& upid : md->upids()) {
+      if (changes->exited_pids.contains(upid.pid())) {
+        const PIDInfo* pid_info = md->GetPIDByUPID(upid);
+        if (pid_info != nullptr) {
+          changed_cids.insert(pid_info->cid());
+        }
+      }
+    }
+  }
 
+  // Updating a container can copy part of the containers map, so the running ones are collected
+  // before any of them is updated.
+  std::vector<CID> running_cids;
   for (const auto& [cid, cinfo] : k8s_md_state->containers_by_id()) {
     if (cinfo->stop_time_ns() != 0) {
       // Ignore dead containers.
@@ -231,6 +399,11 @@ Status ProcessPIDUpdates(
       VLOG(1) << "Ignore dead container: " << cinfo->DebugString();
       continue;
     }
+    running_cids.push_back(cid);
+  }
+
+  for (const CID& cid : running_cids) {
+    const ContainerInfo* cinfo = k8s_md_state->ContainerInfoByID(cid);
 
     // For every container:
     //   1. Read the current PIDs (from cgroups).
@@ -249,7 +422,12 @@ Status ProcessPIDUpdates(
     if (pod_info->stop_time_ns() != 0) {
       VLOG(1) << absl::Substitute("Found a running container in a deleted pod [cid=$0, pod_id=$1]",
                                   cid, pod_id);
-      cinfo->set_stop_time_ns(pod_info->stop_time_ns());
+      k8s_md_state->MutableContainerInfoByID(cid)->set_stop_time_ns(pod_info->stop_time_ns());
+      continue;
+    }
+
+    if (changes != nullptr && !cinfo->active_upids().empty() && !changed_cids.contains(cid)) {
+      // No process started or exited in this container since the last update.
       continue;
     }
 
@@ -267,17 +445,33 @@ Status ProcessPIDUpdates(
       // NOTE: Currently, MDS sends pods that do no belong to this Agent, so this is actually
       // required to avoid repeatedly printing out the warning message above.
       if (error::IsNotFound(s)) {
-        cinfo->set_stop_time_ns(ts);
-        for (const auto& upid : cinfo->active_upids()) {
+        ContainerInfo* mutable_cinfo = k8s_md_state->MutableContainerInfoByID(cid);
+        mutable_cinfo->set_stop_time_ns(ts);
+        for (const auto& upid : mutable_cinfo->active_upids()) {
           md->MarkUPIDAsStopped(upid, ts);
         }
-        cinfo->mutable_active_upids()->clear();
+        mutable_cinfo->mutable_active_upids()->clear();
       }
       continue;
     }
 
-    ProcessContainerPIDUpdates(cid, ts, proc_parser, md, cinfo->mutable_active_upids(),
-                               &cgroups_active_pids, pid_updates);
+    if (cinfo->cgroup_id() == 0) {
+      // Read once per container, for the BPF probes that filter on cgroups.
+      auto cgroup_id_or =
+          md_reader->ReadCGroupID(pod_info->qos_class(), pod_id, cid, cinfo->type());
+      if (cgroup_id_or.ok()) {
+        k8s_md_state->MutableContainerInfoByID(cid)->set_cgroup_id(cgroup_id_or.ValueOrDie());
+        cinfo = k8s_md_state->ContainerInfoByID(cid);
+      }
+    }
+
+    if (!ContainerPIDsChanged(cinfo->active_upids(), cgroups_active_pids)) {
+      continue;
+    }
+    ProcessContainerPIDUpdates(
+        cid, ts, proc_parser, md,
+        k8s_md_state->MutableContainerInfoByID(cid)->mutable_active_upids(),
+        &cgroups_active_pids, pid_updates);
   }
 
   return Status::OK();
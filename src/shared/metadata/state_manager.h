@@ -37,6 +37,7 @@
 #include "src/shared/metadata/metadata_filter.h"
 #include "src/shared/metadata/metadata_state.h"
 #include "src/shared/metadata/pids.h"
+#include "src/shared/metadata/proc_event_watcher.h"
 #include "src/shared/metadatapb/metadata.pb.h"
 #include "src/shared/upid/upid.h"
 
@@ -44,6 +45,9 @@ PL_SUPPRESS_WARNINGS_START()
 #include "blockingconcurrentqueue.h"
 PL_SUPPRESS_WARNINGS_END()
 
+DECLARE_bool(metadata_watch_proc_events);
+DECLARE_int32(metadata_pid_full_rescan_epochs);
+
 namespace px {
 namespace md {
 
@@ -124,6 +128,17 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
         collects_data_(collects_data),
         metadata_filter_(metadata_filter) {
     md_reader_ = std::make_unique<CGroupMetadataReader>(config);
+    if (collects_data_ && FLAGS_metadata_watch_proc_events) {
+      auto watcher_or = ProcEventWatcher::Create(config);
+      if (watcher_or.ok()) {
+        proc_event_watcher_ = watcher_or.ConsumeValueOrDie();
+      } else {
+        LOG(WARNING) << absl::Substitute(
+            "Failed to watch process events, PIDs of all containers will be read on every update "
+            "[error = $0]",
+            watcher_or.msg());
+      }
+    }
     agent_metadata_state_ =
         std::make_shared<AgentMetadataState>(hostname, asid, agent_id, pod_name);
   }
@@ -160,6 +175,8 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
   system::ProcParser proc_parser_;
 
   std::unique_ptr<CGroupMetadataReader> md_reader_;
+  // Tracks the containers whose PIDs changed, when process events are available.
+  std::unique_ptr<ProcEventWatcher> proc_event_watcher_;
   // The metadata state stored here is immutable so that we can easily share a read only
   // copy across threads. The pointer is atomically updated in PerformMetadataStateUpdate(),
   // which is responsible for applying the queued updates.
@@ -193,10 +210,14 @@ void RemoveDeadPods(int64_t ts, AgentMetadataState* md, CGroupMetadataReader* md
 
 /**
  * Processes PID updates.
+ *
+ * If changes are given, only the containers they affect (plus the ones without any known PIDs)
+ * have their PIDs read; otherwise all the running containers do.
  */
 Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState*, CGroupMetadataReader*,
-    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates);
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates,
+    const PIDChanges* changes = nullptr);
 
 /**
  * Deletes metadata for dead objects.
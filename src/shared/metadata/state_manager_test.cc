@@ -36,6 +36,7 @@ using ::testing::ElementsAre;
 using ::testing::Pair;
 using ::testing::Return;
 using ::testing::ReturnRef;
+using ::testing::SizeIs;
 using ::testing::UnorderedElementsAre;
 
 constexpr char kUpdate0_0Pbtxt[] = R"(
@@ -278,6 +279,125 @@ TEST_F(AgentMetadataStateTest, pid_created) {
   EXPECT_THAT(pids_started, UnorderedElementsAre(PIDStartedEvent{pid1}, PIDStartedEvent{pid2}));
 }
 
+class CountingPIDData : public FakePIDData {
+ public:
+  Status ReadPIDs(PodQOSClass qos, std::string_view pod_id, std::string_view container_id,
+                  ContainerType type, absl::flat_hash_set<uint32_t>* pid_set) const override {
+    ++num_reads;
+    return FakePIDData::ReadPIDs(qos, pod_id, container_id, type, pid_set);
+  }
+
+  mutable int num_reads = 0;
+};
+
+TEST_F(AgentMetadataStateTest, pid_changes_skip_unchanged_containers) {
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+  GenerateTestUpdateEvents(&updates);
+  EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, &updates));
+
+  std::filesystem::path proc_path = testing::TestFilePath("src/shared/metadata/testdata/proc");
+  system::MockConfig sysconfig;
+  EXPECT_CALL(sysconfig, ClockRealTimeOffset()).WillRepeatedly(Return(128));
+  EXPECT_CALL(sysconfig, HasConfig()).WillRepeatedly(Return(true));
+  EXPECT_CALL(sysconfig, PageSize()).WillRepeatedly(Return(4096));
+  EXPECT_CALL(sysconfig, KernelTicksPerSecond()).WillRepeatedly(Return(10000000));
+  EXPECT_CALL(sysconfig, proc_path()).WillRepeatedly(ReturnRef(proc_path));
+  system::ProcParser proc_parser(sysconfig);
+
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>> events;
+  CountingPIDData md_reader;
+
+  // Containers without known PIDs are read even with changes.
+  PIDChanges no_changes;
+  EXPECT_OK(
+      ProcessPIDUpdates(1000, proc_parser, &metadata_state_, &md_reader, &events, &no_changes));
+  EXPECT_EQ(1, md_reader.num_reads);
+  EXPECT_THAT(
+      metadata_state_.k8s_metadata_state()->ContainerInfoByID("container_id1")->active_upids(),
+      SizeIs(2));
+
+  // Nothing changed since then, so nothing's read.
+  EXPECT_OK(
+      ProcessPIDUpdates(2000, proc_parser, &metadata_state_, &md_reader, &events, &no_changes));
+  EXPECT_EQ(1, md_reader.num_reads);
+
+  // One of the container's processes exited.
+  PIDChanges exited;
+  exited.exited_pids.insert(100);
+  EXPECT_OK(ProcessPIDUpdates(3000, proc_parser, &metadata_state_, &md_reader, &events, &exited));
+  EXPECT_EQ(2, md_reader.num_reads);
+
+  PIDChanges started;
+  started.started_cids.insert("container_id1");
+  EXPECT_OK(ProcessPIDUpdates(4000, proc_parser, &metadata_state_, &md_reader, &events, &started));
+  EXPECT_EQ(3, md_reader.num_reads);
+
+  // Without changes, all the containers are read.
+  EXPECT_OK(ProcessPIDUpdates(5000, proc_parser, &metadata_state_, &md_reader, &events));
+  EXPECT_EQ(4, md_reader.num_reads);
+}
+
+TEST_F(AgentMetadataStateTest, coalesced_updates) {
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+  auto enqueue = [&updates](std::string_view pbtxt) {
+    auto update = std::make_unique<ResourceUpdate>();
+    CHECK(google::protobuf::TextFormat::MergeFromString(std::string(pbtxt), update.get()));
+    updates.enqueue(std::move(update));
+  };
+
+  // The pod and its service arrive before the container, and the pod is updated again later.
+  enqueue(kUpdate1_1Pbtxt);
+  enqueue(R"(
+    service_update {
+      name: "service1"
+      namespace: "pl"
+      uid: "service_id1"
+      start_timestamp_ns: 1000
+      pod_ids: "pod_id1"
+      pod_names: "pod1"
+    }
+  )");
+  enqueue(kUpdate1_0Pbtxt);
+  enqueue(R"(
+    pod_update {
+      name: "pod1"
+      namespace: "pl"
+      uid: "pod_id1"
+      start_timestamp_ns: 1000
+      stop_timestamp_ns: 1500
+      qos_class: QOS_CLASS_BURSTABLE
+      phase: SUCCEEDED
+      message: "succeeded message"
+      reason: "succeeded reason"
+    }
+  )");
+  enqueue(R"(
+    service_update {
+      name: "service1"
+      namespace: "pl"
+      uid: "service_id1"
+      start_timestamp_ns: 1000
+    }
+  )");
+
+  EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, &updates));
+  EXPECT_EQ(0, updates.size_approx());
+
+  K8sMetadataState* state = metadata_state_.k8s_metadata_state();
+  auto* pod_info = state->PodInfoByID("pod_id1");
+  ASSERT_NE(nullptr, pod_info);
+  EXPECT_EQ(PodPhase::kSucceeded, pod_info->phase());
+  EXPECT_EQ("succeeded message", pod_info->phase_message());
+  EXPECT_EQ(1500, pod_info->stop_time_ns());
+  // The earlier updates still contribute the container and the service.
+  EXPECT_THAT(pod_info->containers(), UnorderedElementsAre("container_id1"));
+  EXPECT_THAT(pod_info->services(), UnorderedElementsAre("service_id1"));
+
+  auto* container_info = state->ContainerInfoByID("container_id1");
+  ASSERT_NE(nullptr, container_info);
+  EXPECT_EQ("pod_id1", container_info->pod_id());
+}
+
 TEST_F(AgentMetadataStateTest, insert_into_filter) {
   moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
   GenerateTestUpdateEvents(&updates);
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/metadata/string_pool.h"
+
+namespace px {
+namespace md {
+
+StringPool* StringPool::Global() {
+  static StringPool* pool = new StringPool();
+  return pool;
+}
+
+InternedString StringPool::Intern(std::string_view str) {
+  absl::MutexLock lock(&mu_);
+  auto it = strings_.find(str);
+  if (it != strings_.end()) {
+    return it->second;
+  }
+  auto interned = std::make_shared<const std::string>(str);
+  strings_.emplace(std::string_view(*interned), interned);
+  return interned;
+}
+
+size_t StringPool::Collect() {
+  absl::MutexLock lock(&mu_);
+  size_t num_dropped = 0;
+  for (auto it = strings_.begin(); it != strings_.end();) {
+    // New references can only be handed out by Intern() under the lock, so a count of 1 means
+    // nothing else can be holding this string.
+    if (it->second.use_count() == 1) {
+      strings_.erase(it++);
+      ++num_dropped;
+    } else {
+      ++it;
+    }
+  }
+  return num_dropped;
+}
+
+size_t StringPool::size() const {
+  absl::MutexLock lock(&mu_);
+  return strings_.size();
+}
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+namespace px {
+namespace md {
+
+/**
+ * A shared, immutable string handed out by a StringPool. Copying the handle only bumps a
+ * refcount, so objects holding the same name share one allocation.
+ */
+using InternedString = std::shared_ptr<const std::string>;
+
+/**
+ * StringPool deduplicates the names that show up over and over in K8s metadata (namespaces,
+ * node names, service names, container names).
+ *
+ * Strings are not freed as soon as their last user drops them. Instead, Collect() is called
+ * periodically (once per metadata cleanup pass) and drops every string that is only referenced
+ * by the pool.
+ *
+ * Thread-safe.
+ */
+class StringPool {
+ public:
+  /**
+   * The pool used by the K8s metadata objects.
+   */
+  static StringPool* Global();
+
+  /**
+   * Returns the pooled copy of str, adding it to the pool if needed.
+   */
+  InternedString Intern(std::string_view str);
+
+  /**
+   * Drops the strings that are no longer referenced outside the pool.
+   * Returns the number of strings dropped.
+   */
+  size_t Collect();
+
+  size_t size() const;
+
+ private:
+  mutable absl::Mutex mu_;
+  // The keys point into the values, which the pool keeps alive until Collect() drops them.
+  absl::flat_hash_map<std::string_view, InternedString> strings_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/shared/metadata/string_pool.h"
+
+namespace px {
+namespace md {
+
+TEST(StringPoolTest, InternSharesStorage) {
+  StringPool pool;
+  InternedString a = pool.Intern("pl");
+  InternedString b = pool.Intern(std::string("pl"));
+  InternedString c = pool.Intern("kube-system");
+
+  EXPECT_EQ(*a, "pl");
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_NE(a.get(), c.get());
+  EXPECT_EQ(pool.size(), 2);
+}
+
+TEST(StringPoolTest, CollectDropsUnreferencedStrings) {
+  StringPool pool;
+  InternedString a = pool.Intern("pl");
+  pool.Intern("kube-system");
+  EXPECT_EQ(pool.size(), 2);
+
+  EXPECT_EQ(pool.Collect(), 1);
+  EXPECT_EQ(pool.size(), 1);
+  EXPECT_EQ(pool.Intern("pl").get(), a.get());
+
+  a.reset();
+  EXPECT_EQ(pool.Collect(), 1);
+  EXPECT_EQ(pool.size(), 0);
+}
+
+}  // namespace md
+}  // namespace px
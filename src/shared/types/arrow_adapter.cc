@@ -118,5 +118,41 @@ std::unique_ptr<arrow::ArrayBuilder> MakeArrowBuilder(const DataType& data_type,
 
 #undef BUILDER_CASE
 
+bool IsDictionaryArray(const arrow::Array& arr) { return arr.type_id() == Type::DICTIONARY; }
+
+std::shared_ptr<arrow::Array> MakeDictionaryStringArray(
+    const std::shared_ptr<arrow::Array>& codes, const std::shared_ptr<arrow::Array>& values) {
+  DCHECK_EQ(codes->type_id(), Type::INT32);
+  DCHECK_EQ(values->type_id(), Type::STRING);
+  return std::make_shared<arrow::DictionaryArray>(arrow::dictionary(arrow::int32(), arrow::utf8()),
+                                                  codes, values);
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> DecodeDictionaryArray(
+    const std::shared_ptr<arrow::Array>& arr, arrow::MemoryPool* mem_pool) {
+  if (!IsDictionaryArray(*arr)) {
+    return arr;
+  }
+  auto dict_arr = static_cast<const arrow::DictionaryArray*>(arr.get());
+  auto codes = static_cast<const arrow::Int32Array*>(dict_arr->indices().get());
+  auto values = static_cast<const arrow::StringArray*>(dict_arr->dictionary().get());
+
+  int64_t total_size = 0;
+  for (int64_t i = 0; i < codes->length(); ++i) {
+    total_size += values->value_length(codes->Value(i));
+  }
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(codes->length()));
+  PL_RETURN_IF_ERROR(builder.ReserveData(total_size));
+  for (int64_t i = 0; i < codes->length(); ++i) {
+    int32_t len = 0;
+    const uint8_t* data = values->GetValue(codes->Value(i), &len);
+    builder.UnsafeAppend(data, len);
+  }
+  std::shared_ptr<arrow::Array> out;
+  PL_RETURN_IF_ERROR(builder.Finish(&out));
+  return out;
+}
+
 }  // namespace types
 }  // namespace px
@@ -100,6 +100,22 @@ int64_t ArrowTypeToBytes(const arrow::Type::type& arrow_type);
 std::unique_ptr<arrow::ArrayBuilder> MakeArrowBuilder(const DataType& data_type,
                                                       arrow::MemoryPool* mem_pool);
 
+/**
+ * Dictionary-encoded string columns are arrow DictionaryArrays of int32 codes into a StringArray of
+ * the distinct values. They have the STRING data type, like plain string columns.
+ */
+bool IsDictionaryArray(const arrow::Array& arr);
+
+std::shared_ptr<arrow::Array> MakeDictionaryStringArray(
+    const std::shared_ptr<arrow::Array>& codes, const std::shared_ptr<arrow::Array>& values);
+
+/**
+ * Decodes a dictionary-encoded string column into a plain StringArray. Other arrays are returned
+ * as is.
+ */
+StatusOr<std::shared_ptr<arrow::Array>> DecodeDictionaryArray(
+    const std::shared_ptr<arrow::Array>& arr, arrow::MemoryPool* mem_pool);
+
 // The get value functions pluck out value at a specific index.
 template <typename T>
 inline auto GetValue(const T* arr, int64_t idx) {
@@ -130,6 +146,11 @@ inline int64_t GetArrowArrayBytes(const arrow::Array* arr) {
 
 template <>
 inline int64_t GetArrowArrayBytes<types::DataType::STRING>(const arrow::Array* arr) {
+  if (IsDictionaryArray(*arr)) {
+    auto dict_arr = static_cast<const arrow::DictionaryArray*>(arr);
+    return arr->length() * sizeof(int32_t) +
+           GetArrowArrayBytes<types::DataType::STRING>(dict_arr->dictionary().get());
+  }
   int64_t total_bytes = 0;
   // Loop through each string in the Arrow array.
   for (int64_t i = 0; i < arr->length(); i++) {
@@ -24,10 +24,13 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/string_arena.h"
 #include "src/shared/types/type_utils.h"
 #include "src/shared/types/types.h"
 
@@ -52,6 +55,10 @@ class ColumnWrapper {
   virtual ~ColumnWrapper() = default;
 
   static SharedColumnWrapper Make(DataType data_type, size_t size);
+  // Like Make(), but the values of fixed-size types whose arrow layout matches are allocated from
+  // the memory pool, so that ConvertToArrow() hands them over instead of copying them.
+  static SharedColumnWrapper Make(DataType data_type, size_t size, arrow::MemoryPool* mem_pool);
+  // Numeric arrays are viewed in place, without a copy. Other types are copied.
   static SharedColumnWrapper FromArrow(const std::shared_ptr<arrow::Array>& arr);
 
   virtual BaseValueType* UnsafeRawData() = 0;
@@ -94,8 +101,27 @@ class ColumnWrapper {
   virtual SharedColumnWrapper MoveIndexes(const std::vector<size_t>& indexes) = 0;
 };
 
+// The value types that are laid out in memory like the values of their arrow arrays, so a column
+// can use an arrow buffer as is.
+template <typename T>
+inline constexpr bool kArrowLayoutCompatible = std::is_same_v<T, Int64Value> ||
+                                               std::is_same_v<T, Float64Value> ||
+                                               std::is_same_v<T, Time64NSValue>;
+
 /**
  * Implementation of type erased vectors for a specific data type.
+ *
+ * The values normally live in a std::vector. For the types of kArrowLayoutCompatible, they can
+ * live in an arrow buffer instead, either viewed from an arrow array (see ViewOf()), or allocated
+ * from a memory pool (see MakeInBuffer()), so that no copy is made to or from arrow. A view is
+ * read-only: its values are copied into the vector before any change. Appending to or resizing a
+ * buffer-backed column also moves its values into the vector.
+ *
+ * StringValue columns can instead append their values to a StringArena (see MakeInArena()), so
+ * that they don't make an allocation per string, and ConvertToArrow() hands the arena's buffers
+ * over as the array. The strings are read from the arena, or from the array once handed over,
+ * and are only moved into the vector for mutable access or resizing.
+ *
  * @tparam T The UDFValueType.
  */
 template <typename T>
@@ -107,30 +133,138 @@ class ColumnWrapperTmpl : public ColumnWrapper {
 
   ~ColumnWrapperTmpl() override = default;
 
-  T* UnsafeRawData() override { return data_.data(); }
-  const T* UnsafeRawData() const override { return data_.data(); }
+  /**
+   * Returns a read-only column over the values of the arrow array, which it keeps alive.
+   */
+  static std::shared_ptr<ColumnWrapperTmpl<T>> ViewOf(std::shared_ptr<arrow::Array> arr) {
+    static_assert(kArrowLayoutCompatible<T>);
+    using TArrowArray = typename ValueTypeTraits<T>::arrow_array_type;
+    DCHECK_EQ(arr->type_id(), TArrowArray::TypeClass::type_id);
+    auto col = std::make_shared<ColumnWrapperTmpl<T>>(0);
+    const auto* values = static_cast<const TArrowArray*>(arr.get())->raw_values();
+    // The column only writes to the values after copying them out.
+    col->buffer_data_ = const_cast<T*>(reinterpret_cast<const T*>(values));
+    col->buffer_size_ = arr->length();
+    col->array_ = std::move(arr);
+    return col;
+  }
+
+  /**
+   * Returns a column of the given size, with its values in a buffer allocated from the pool.
+   * The values are not initialized.
+   */
+  static std::shared_ptr<ColumnWrapperTmpl<T>> MakeInBuffer(size_t size,
+                                                            arrow::MemoryPool* mem_pool) {
+    static_assert(kArrowLayoutCompatible<T>);
+    std::shared_ptr<arrow::Buffer> buffer;
+    PL_CHECK_OK(arrow::AllocateBuffer(mem_pool, size * sizeof(T), &buffer));
+    auto col = std::make_shared<ColumnWrapperTmpl<T>>(0);
+    col->buffer_data_ = reinterpret_cast<T*>(buffer->mutable_data());
+    col->buffer_size_ = size;
+    col->buffer_ = std::move(buffer);
+    return col;
+  }
+
+  /**
+   * Returns an empty StringValue column whose values are appended to an arena allocated from the
+   * pool.
+   */
+  static std::shared_ptr<ColumnWrapperTmpl<T>> MakeInArena(arrow::MemoryPool* mem_pool) {
+    static_assert(std::is_same_v<T, StringValue>);
+    auto col = std::make_shared<ColumnWrapperTmpl<T>>(0);
+    col->arena_ = std::make_unique<StringArena>(mem_pool);
+    return col;
+  }
+
+  T* UnsafeRawData() override { return mutable_values(); }
+  const T* UnsafeRawData() const override { return values(); }
   DataType data_type() const override { return ValueTypeTraits<T>::data_type; }
 
-  size_t Size() const override { return data_.size(); }
-  bool Empty() const override { return data_.empty(); }
+  size_t Size() const override {
+    if (in_string_storage()) {
+      return arena_ != nullptr ? arena_->size() : array_->length();
+    }
+    return buffer_data_ != nullptr ? buffer_size_ : data_.size();
+  }
+  bool Empty() const override { return Size() == 0; }
 
   std::shared_ptr<arrow::Array> ConvertToArrow(arrow::MemoryPool* mem_pool) override {
+    if constexpr (kArrowLayoutCompatible<T>) {
+      if (buffer_data_ != nullptr) {
+        if (array_ == nullptr) {
+          // Hand the buffer over. The column is a view of the array from now on.
+          array_ = std::make_shared<typename ValueTypeTraits<T>::arrow_array_type>(buffer_size_,
+                                                                                   buffer_);
+        }
+        return array_;
+      }
+    }
+    if constexpr (std::is_same_v<T, StringValue>) {
+      if (arena_ != nullptr) {
+        // Hand the arena over. The strings are read from the array from now on.
+        array_ = arena_->Finish();
+        arena_.reset();
+      }
+      if (in_string_storage()) {
+        return array_;
+      }
+    }
     return ToArrow(data_, mem_pool);
   }
 
-  T operator[](size_t idx) const { return data_[idx]; }
+  T operator[](size_t idx) const {
+    if constexpr (std::is_same_v<T, StringValue>) {
+      if (in_string_storage()) {
+        return T(std::string(StringAt(idx)));
+      }
+    }
+    return values()[idx];
+  }
 
-  T& operator[](size_t idx) { return data_[idx]; }
+  T& operator[](size_t idx) { return mutable_values()[idx]; }
 
-  void Append(T val) { data_.push_back(val); }
+  void Append(T val) {
+    if constexpr (std::is_same_v<T, StringValue>) {
+      if (arena_ != nullptr) {
+        arena_->Append(val);
+        return;
+      }
+    }
+    if (buffer_data_ != nullptr || in_string_storage()) {
+      MoveToVector();
+    }
+    data_.push_back(val);
+  }
 
-  void Reserve(size_t size) override { data_.reserve(size); }
+  void Reserve(size_t size) override {
+    if (arena_ != nullptr) {
+      arena_->Reserve(size);
+      return;
+    }
+    MoveToVector();
+    data_.reserve(size);
+  }
 
-  void ShrinkToFit() override { data_.shrink_to_fit(); }
+  void ShrinkToFit() override {
+    if (arena_ != nullptr) {
+      return;
+    }
+    MoveToVector();
+    data_.shrink_to_fit();
+  }
 
-  void Resize(size_t size) { data_.resize(size); }
+  void Resize(size_t size) {
+    MoveToVector();
+    data_.resize(size);
+  }
 
-  void Clear() override { data_.clear(); }
+  void Clear() override {
+    ReleaseBuffer();
+    data_.clear();
+    if (arena_ != nullptr) {
+      arena_->Clear();
+    }
+  }
 
   int64_t Bytes() const override;
 
@@ -143,10 +277,23 @@ class ColumnWrapperTmpl : public ColumnWrapper {
   // Return a new SharedColumnWrapper with values according to the spec:
   //    { data[idx[0]], data[idx[1]], data[idx[2]], ... }
   SharedColumnWrapper CopyIndexes(const std::vector<size_t>& indexes) const override {
-    DCHECK_LE(indexes.size(), data_.size());
+    DCHECK_LE(indexes.size(), Size());
+    if constexpr (std::is_same_v<T, StringValue>) {
+      if (in_string_storage()) {
+        // The copy keeps its strings in an arena too.
+        auto copy = MakeInArena(arena_ != nullptr ? arena_->mem_pool()
+                                                  : arrow::default_memory_pool());
+        copy->Reserve(indexes.size());
+        for (size_t idx : indexes) {
+          copy->arena_->Append(StringAt(idx));
+        }
+        return copy;
+      }
+    }
+    const T* values = this->values();
     auto copy = std::make_shared<ColumnWrapperTmpl<T>>(indexes.size());
     for (size_t i = 0; i < indexes.size(); ++i) {
-      copy->data_[i] = data_[indexes[i]];
+      copy->data_[i] = values[indexes[i]];
     }
     return copy;
   }
@@ -156,6 +303,11 @@ class ColumnWrapperTmpl : public ColumnWrapper {
   // Warning: Indexes in "this" ColumnWrapper have their contents moved,
   // so "this" should be discarded.
   SharedColumnWrapper MoveIndexes(const std::vector<size_t>& indexes) override {
+    if (buffer_data_ != nullptr || in_string_storage()) {
+      // Buffer-backed values are fixed-size, and strings in an arena or an array can't be moved
+      // out one by one, so moving them is copying them.
+      return CopyIndexes(indexes);
+    }
     DCHECK_LE(indexes.size(), data_.size());
     auto col = std::make_shared<ColumnWrapperTmpl<T>>(indexes.size());
     for (size_t i = 0; i < indexes.size(); ++i) {
@@ -165,7 +317,80 @@ class ColumnWrapperTmpl : public ColumnWrapper {
   }
 
  private:
+  const T* values() const {
+    if (in_string_storage()) {
+      // The strings have to become StringValues to be handed out as an array. This leaves the
+      // values of the column as they are.
+      const_cast<ColumnWrapperTmpl<T>*>(this)->MoveToVector();
+    }
+    return buffer_data_ != nullptr ? buffer_data_ : data_.data();
+  }
+
+  // Views are copied before they are written to.
+  T* mutable_values() {
+    if (array_ != nullptr || in_string_storage()) {
+      MoveToVector();
+    }
+    return buffer_data_ != nullptr ? buffer_data_ : data_.data();
+  }
+
+  // Whether the values are strings in arena_, or in array_ once the arena was handed over,
+  // rather than in data_.
+  bool in_string_storage() const {
+    if constexpr (std::is_same_v<T, StringValue>) {
+      return arena_ != nullptr || array_ != nullptr;
+    }
+    return false;
+  }
+
+  std::string_view StringAt(size_t idx) const {
+    DCHECK(in_string_storage());
+    if (arena_ != nullptr) {
+      return (*arena_)[idx];
+    }
+    int32_t length = 0;
+    auto arr = static_cast<const arrow::StringArray*>(array_.get());
+    const uint8_t* val = arr->GetValue(idx, &length);
+    return std::string_view(reinterpret_cast<const char*>(val), length);
+  }
+
+  void MoveToVector() {
+    if (buffer_data_ != nullptr) {
+      data_.assign(buffer_data_, buffer_data_ + buffer_size_);
+      ReleaseBuffer();
+    }
+    if constexpr (std::is_same_v<T, StringValue>) {
+      if (in_string_storage()) {
+        const size_t size = Size();
+        data_.clear();
+        data_.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+          data_.emplace_back(std::string(StringAt(i)));
+        }
+        arena_.reset();
+        ReleaseBuffer();
+      }
+    }
+  }
+
+  void ReleaseBuffer() {
+    buffer_data_ = nullptr;
+    buffer_size_ = 0;
+    buffer_.reset();
+    array_.reset();
+  }
+
   std::vector<T> data_;
+
+  // When buffer_data_ is set, the values are there rather than in data_. The memory is owned by
+  // buffer_ for columns made with MakeInBuffer(), and by array_ for views.
+  T* buffer_data_ = nullptr;
+  size_t buffer_size_ = 0;
+  std::shared_ptr<arrow::Buffer> buffer_;
+  std::shared_ptr<arrow::Array> array_;
+
+  // Only used by StringValue columns. When set, the values are there rather than in data_.
+  std::unique_ptr<StringArena> arena_;
 };
 
 template <typename T>
@@ -175,6 +400,13 @@ int64_t ColumnWrapperTmpl<T>::Bytes() const {
 
 template <>
 inline int64_t ColumnWrapperTmpl<StringValue>::Bytes() const {
+  if (arena_ != nullptr) {
+    return arena_->bytes();
+  }
+  if (array_ != nullptr) {
+    auto arr = static_cast<const arrow::StringArray*>(array_.get());
+    return arr->value_offset(arr->length()) - arr->value_offset(0);
+  }
   int64_t bytes = 0;
   for (const auto& data : data_) {
     bytes += data.bytes();
@@ -234,6 +466,26 @@ inline SharedColumnWrapper FromArrowImpl<StringValueColumnWrapper, DataType::STR
   return wrapper;
 }
 
+// Dictionary-encoded strings are read once per distinct value.
+inline SharedColumnWrapper FromArrowDictionary(const std::shared_ptr<arrow::Array>& arr) {
+  DCHECK(IsDictionaryArray(*arr));
+  auto dict_arr = static_cast<arrow::DictionaryArray*>(arr.get());
+  auto codes = static_cast<const arrow::Int32Array*>(dict_arr->indices().get());
+  auto values = static_cast<const arrow::StringArray*>(dict_arr->dictionary().get());
+  std::vector<StringValue> distinct_values(values->length());
+  for (int64_t i = 0; i < values->length(); ++i) {
+    distinct_values[i] = values->GetString(i);
+  }
+
+  size_t size = arr->length();
+  auto wrapper = StringValueColumnWrapper::Make(types::STRING, size);
+  StringValue* out_data = static_cast<StringValueColumnWrapper*>(wrapper.get())->UnsafeRawData();
+  for (size_t i = 0; i < size; ++i) {
+    out_data[i] = distinct_values[codes->Value(i)];
+  }
+  return wrapper;
+}
+
 /**
  * Create a type erased ColumnWrapper from an ArrowArray.
  * @param arr the arrow array.
@@ -246,13 +498,15 @@ inline SharedColumnWrapper ColumnWrapper::FromArrow(const std::shared_ptr<arrow:
     case arrow::Type::BOOL:
       return FromArrowImpl<BoolValueColumnWrapper, DataType::BOOLEAN>(arr);
     case arrow::Type::INT64:
-      return FromArrowImpl<Int64ValueColumnWrapper, DataType::INT64>(arr);
+      return Int64ValueColumnWrapper::ViewOf(arr);
     case arrow::Type::UINT128:
       return FromArrowImpl<UInt128ValueColumnWrapper, DataType::UINT128>(arr);
     case arrow::Type::DOUBLE:
-      return FromArrowImpl<Float64ValueColumnWrapper, DataType::FLOAT64>(arr);
+      return Float64ValueColumnWrapper::ViewOf(arr);
     case arrow::Type::STRING:
       return FromArrowImpl<StringValueColumnWrapper, DataType::STRING>(arr);
+    case arrow::Type::DICTIONARY:
+      return FromArrowDictionary(arr);
     case arrow::Type::TIME64:
       return FromArrowImpl<Time64NSValueColumnWrapper, DataType::TIME64NS>(arr);
     case arrow::Type::DURATION:
@@ -288,6 +542,20 @@ inline SharedColumnWrapper ColumnWrapper::Make(DataType data_type, size_t size)
   }
 }
 
+inline SharedColumnWrapper ColumnWrapper::Make(DataType data_type, size_t size,
+                                               arrow::MemoryPool* mem_pool) {
+  switch (data_type) {
+    case DataType::INT64:
+      return Int64ValueColumnWrapper::MakeInBuffer(size, mem_pool);
+    case DataType::FLOAT64:
+      return Float64ValueColumnWrapper::MakeInBuffer(size, mem_pool);
+    case DataType::TIME64NS:
+      return Time64NSValueColumnWrapper::MakeInBuffer(size, mem_pool);
+    default:
+      return Make(data_type, size);
+  }
+}
+
 template <class TValueType>
 inline void ColumnWrapper::Append(TValueType val) {
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type)
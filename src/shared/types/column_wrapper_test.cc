@@ -24,6 +24,8 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/types.h"
@@ -283,5 +285,81 @@ TEST(ColumnWrapperTest, MoveIndexes) {
   }
 }
 
+TEST(ColumnWrapperTest, FromArrowIsAView) {
+  std::vector<Int64Value> values = {1, 2, 3};
+  auto arr = ToArrow(values, arrow::default_memory_pool());
+  auto wrapper = ColumnWrapper::FromArrow(arr);
+  const ColumnWrapper* const_wrapper = wrapper.get();
+
+  const auto* raw = static_cast<const arrow::Int64Array*>(arr.get())->raw_values();
+  EXPECT_EQ(reinterpret_cast<const int64_t*>(const_wrapper->UnsafeRawData()), raw);
+  EXPECT_EQ(const_wrapper->Get<Int64Value>(2), 3);
+  EXPECT_EQ(wrapper->ConvertToArrow(arrow::default_memory_pool()), arr);
+
+  // A write copies the values, and leaves the array untouched.
+  wrapper->Get<Int64Value>(0) = 10;
+  EXPECT_EQ(wrapper->Get<Int64Value>(0), 10);
+  EXPECT_EQ(raw[0], 1);
+  wrapper->Append<Int64Value>(4);
+  EXPECT_EQ(wrapper->Size(), 4);
+  EXPECT_NE(wrapper->ConvertToArrow(arrow::default_memory_pool()), arr);
+}
+
+TEST(ColumnWrapperTest, MakeInBuffer) {
+  auto wrapper = ColumnWrapper::Make(DataType::FLOAT64, 3, arrow::default_memory_pool());
+  EXPECT_EQ(wrapper->Size(), 3);
+  auto* data = static_cast<Float64Value*>(wrapper->UnsafeRawData());
+  for (int i = 0; i < 3; ++i) {
+    data[i] = 0.5 * i;
+  }
+
+  // The array takes over the buffer.
+  auto arr = wrapper->ConvertToArrow(arrow::default_memory_pool());
+  ASSERT_EQ(arr->length(), 3);
+  const auto* raw = static_cast<const arrow::DoubleArray*>(arr.get())->raw_values();
+  EXPECT_EQ(reinterpret_cast<const void*>(raw), reinterpret_cast<const void*>(data));
+  EXPECT_EQ(raw[2], 1.0);
+
+  // Other types are not buffer-backed.
+  EXPECT_EQ(ColumnWrapper::Make(DataType::STRING, 3, arrow::default_memory_pool())->Size(), 3);
+}
+
+TEST(ColumnWrapperTest, MakeInArena) {
+  auto wrapper = StringValueColumnWrapper::MakeInArena(arrow::default_memory_pool());
+  wrapper->Reserve(4);
+  std::vector<std::string> vals = {"abc", "", "defg", "h"};
+  for (const auto& val : vals) {
+    wrapper->Append(val);
+  }
+  EXPECT_EQ(wrapper->Size(), 4);
+  EXPECT_EQ(wrapper->Bytes(), 8);
+  const ColumnWrapper& const_wrapper = *wrapper;
+  EXPECT_EQ(const_wrapper.Get<StringValue>(2), "defg");
+
+  // Copies keep their strings in an arena.
+  auto copy = wrapper->CopyIndexes({3, 0});
+  EXPECT_EQ(copy->Size(), 2);
+  EXPECT_EQ(copy->Get<StringValue>(0), "h");
+  EXPECT_EQ(copy->Get<StringValue>(1), "abc");
+
+  // The array takes over the arena, and the column reads its strings from the array.
+  auto arr = wrapper->ConvertToArrow(arrow::default_memory_pool());
+  ASSERT_EQ(arr->length(), 4);
+  auto str_arr = static_cast<const arrow::StringArray*>(arr.get());
+  for (size_t i = 0; i < vals.size(); ++i) {
+    EXPECT_EQ(str_arr->GetString(i), vals[i]);
+  }
+  EXPECT_EQ(wrapper->ConvertToArrow(arrow::default_memory_pool()), arr);
+  EXPECT_EQ(const_wrapper.Get<StringValue>(0), "abc");
+
+  // Mutable access moves the strings into the vector, leaving the array untouched.
+  wrapper->Get<StringValue>(0) = "xyz";
+  wrapper->Append(StringValue("i"));
+  EXPECT_EQ(wrapper->Size(), 5);
+  EXPECT_EQ(wrapper->Get<StringValue>(0), "xyz");
+  EXPECT_EQ(wrapper->Get<StringValue>(4), "i");
+  EXPECT_EQ(str_arr->GetString(0), "abc");
+}
+
 }  // namespace types
 }  // namespace px
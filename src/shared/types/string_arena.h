@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/buffer.h>
+#include <arrow/buffer_builder.h>
+#include <arrow/memory_pool.h>
+
+#include <limits>
+#include <memory>
+#include <string_view>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace types {
+
+/**
+ * StringArena stores strings back to back in a single growing buffer, along with the offsets at
+ * which each of them starts and ends. This is the layout of an arrow::StringArray, so Finish()
+ * turns the arena into one by handing its buffers over, without copying the strings.
+ */
+class StringArena {
+ public:
+  explicit StringArena(arrow::MemoryPool* mem_pool)
+      : mem_pool_(mem_pool), offsets_(mem_pool), data_(mem_pool) {
+    PL_CHECK_OK(offsets_.Append(0));
+  }
+
+  arrow::MemoryPool* mem_pool() const { return mem_pool_; }
+  size_t size() const { return offsets_.length() - 1; }
+  int64_t bytes() const { return data_.length(); }
+
+  std::string_view operator[](size_t idx) const {
+    const int32_t* offsets = offsets_.data();
+    return std::string_view(reinterpret_cast<const char*>(data_.data()) + offsets[idx],
+                            offsets[idx + 1] - offsets[idx]);
+  }
+
+  void Append(std::string_view val) {
+    DCHECK_LE(data_.length() + val.size(),
+              static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+    PL_CHECK_OK(data_.Append(val.data(), val.size()));
+    PL_CHECK_OK(offsets_.Append(static_cast<int32_t>(data_.length())));
+  }
+
+  // Reserves room for the offsets of the given total number of strings.
+  void Reserve(size_t size) {
+    if (size > this->size()) {
+      PL_CHECK_OK(offsets_.Reserve(size - this->size()));
+    }
+  }
+
+  void Clear() {
+    offsets_.Reset();
+    data_.Reset();
+    PL_CHECK_OK(offsets_.Append(0));
+  }
+
+  // Returns the strings as an arrow array, and leaves the arena empty.
+  std::shared_ptr<arrow::StringArray> Finish() {
+    const int64_t length = size();
+    std::shared_ptr<arrow::Buffer> offsets;
+    std::shared_ptr<arrow::Buffer> data;
+    // Shrinking the buffers would reallocate them, which copies the strings.
+    PL_CHECK_OK(offsets_.Finish(&offsets, /* shrink_to_fit */ false));
+    PL_CHECK_OK(data_.Finish(&data, /* shrink_to_fit */ false));
+    PL_CHECK_OK(offsets_.Append(0));
+    return std::make_shared<arrow::StringArray>(length, std::move(offsets), std::move(data),
+                                                /* null_bitmap */ nullptr, /* null_count */ 0);
+  }
+
+ private:
+  arrow::MemoryPool* mem_pool_;
+  arrow::TypedBufferBuilder<int32_t> offsets_;
+  arrow::BufferBuilder data_;
+};
+
+}  // namespace types
+}  // namespace px
@@ -52,6 +52,30 @@ TEST(UPID, hash_func) {
   }));
 }
 
+TEST(UPID, upid_hash) {
+  UPIDHash hash;
+  EXPECT_EQ(hash(UPID(123, 456, 789)), hash(UPID(123, 456, 789)));
+
+  // Keys that differ in a single field still spread over the shards of a CowMap (the top bits)
+  // and the groups of a flat_hash_map (the low bits).
+  std::set<size_t> top_bits;
+  std::set<size_t> low_bits;
+  for (int64_t ts = 0; ts < 64; ++ts) {
+    size_t h = hash(UPID(1, 100, 1000 + ts));
+    top_bits.insert(h >> 58);
+    low_bits.insert(h & 0x7f);
+  }
+  EXPECT_GT(top_bits.size(), 32U);
+  EXPECT_GT(low_bits.size(), 32U);
+
+  UPIDMap<int> upid_map;
+  upid_map[UPID(1, 2, 3)] = 1;
+  upid_map[UPID(1, 2, 4)] = 2;
+  EXPECT_EQ(1, upid_map[UPID(1, 2, 3)]);
+  EXPECT_EQ(2, upid_map[UPID(1, 2, 4)]);
+  EXPECT_FALSE(upid_map.contains(UPID(2, 2, 3)));
+}
+
 TEST(UPID, string) {
   EXPECT_EQ("123:456:3420030816657", UPID(123, 456, 3420030816657ULL).String());
   EXPECT_EQ("12:456:3420030816657", UPID(12, 456, 3420030816657ULL).String());
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// LINT_C_FILE: Do not remove this line. It ensures cpplint treats this as a C file.
+
+#pragma once
+
+#include "src/stirling/bpf_tools/bcc_bpf/utils.h"
+
+// A filter on the cgroup of the current task, which the probes check before anything else, so
+// that the processes of the pods that aren't traced cost a single map lookup.
+//
+// Compiled in with -DENABLE_CGROUP_FILTER=1. cgroup_filter_map holds a verdict for the cgroups
+// that user-space knows of: non-zero to trace the cgroup, zero to skip it. The other cgroups get
+// CGROUP_FILTER_DEFAULT_VERDICT, which is zero for an allow-list and non-zero for a deny-list.
+//
+// The cgroup IDs are the ones of the unified (v2) hierarchy.
+#ifdef ENABLE_CGROUP_FILTER
+
+#ifndef CGROUP_FILTER_MAP_SIZE
+#define CGROUP_FILTER_MAP_SIZE 16384
+#endif
+
+BPF_HASH(cgroup_filter_map, uint64_t, uint8_t, CGROUP_FILTER_MAP_SIZE);
+
+static __inline bool cgroup_filter_passes() {
+  uint64_t cgroup_id = bpf_get_current_cgroup_id();
+  uint8_t* verdict = cgroup_filter_map.lookup(&cgroup_id);
+  if (verdict == NULL) {
+    return CGROUP_FILTER_DEFAULT_VERDICT;
+  }
+  return *verdict != 0;
+}
+
+#else
+
+static __inline bool cgroup_filter_passes() { return true; }
+
+#endif
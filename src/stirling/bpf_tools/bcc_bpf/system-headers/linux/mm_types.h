@@ -0,0 +1 @@
+include <linux/mm_types.h>
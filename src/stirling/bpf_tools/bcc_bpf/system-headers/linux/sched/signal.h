@@ -0,0 +1 @@
+include <linux/sched/signal.h>
@@ -0,0 +1 @@
+include <linux/version.h>
@@ -18,23 +18,44 @@
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
+#include <linux/bpf.h>
 #include <linux/perf_event.h>
 #include <sys/mount.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
+
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
 #include <magic_enum.hpp>
 
 #include "src/common/base/base.h"
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/config.h"
+#include "src/stirling/bpf_tools/btf.h"
 #include "src/stirling/bpf_tools/task_struct_resolver.h"
 #include "src/stirling/utils/linux_headers.h"
 
 DEFINE_bool(
     stirling_always_infer_task_struct_offsets, false,
     "When true, run the task_struct offset resolver even when local/host headers are found.");
+DEFINE_string(stirling_bpf_cache_dir, gflags::StringFromEnv("PL_STIRLING_BPF_CACHE_DIR", ""),
+              "A directory (e.g. on a hostPath) where results derived from the running kernel, "
+              "like the resolved task_struct offsets, are cached across restarts. "
+              "Empty disables the cache.");
+DEFINE_bool(stirling_enable_bpf_stats, gflags::BoolFromEnv("PL_STIRLING_ENABLE_BPF_STATS", false),
+            "When true, the kernel counts the runs and run time of the BPF programs, which are "
+            "then reported in the stirling_overhead table. Adds two clock reads per program run.");
 
 namespace px {
 namespace stirling {
@@ -86,6 +107,100 @@ StatusOr<utils::TaskStructOffsets> ResolveTaskStructOffsets() {
   return offsets_status;
 }
 
+// The offsets only depend on the kernel build, which `uname -r` and `uname -v` identify.
+StatusOr<std::filesystem::path> TaskStructOffsetsCachePath() {
+  struct utsname buffer;
+  if (uname(&buffer) != 0) {
+    return error::Internal("Could not determine kernel version (uname)");
+  }
+  std::string file_name =
+      absl::Substitute("task_struct_offsets_$0_$1", buffer.release,
+                       std::hash<std::string>{}(std::string(buffer.version)));
+  return std::filesystem::path(FLAGS_stirling_bpf_cache_dir) / file_name;
+}
+
+std::optional<utils::TaskStructOffsets> ReadCachedTaskStructOffsets(
+    const std::filesystem::path& path) {
+  StatusOr<std::string> contents = ReadFileToString(path.string());
+  if (!contents.ok()) {
+    return std::nullopt;
+  }
+  std::vector<std::string_view> fields = absl::StrSplit(contents.ValueOrDie(), ' ');
+  utils::TaskStructOffsets offsets;
+  if (fields.size() != 2 || !absl::SimpleAtoi(fields[0], &offsets.group_leader_offset) ||
+      !absl::SimpleAtoi(fields[1], &offsets.real_start_time_offset)) {
+    LOG(WARNING) << absl::Substitute("Ignoring malformed task_struct offsets cache file $0",
+                                     path.string());
+    return std::nullopt;
+  }
+  return offsets;
+}
+
+void WriteCachedTaskStructOffsets(const std::filesystem::path& path,
+                                  const utils::TaskStructOffsets& offsets) {
+  Status s = fs::CreateDirectories(path.parent_path());
+  if (s.ok()) {
+    s = WriteFileFromString(path.string(),
+                            absl::Substitute("$0 $1", offsets.group_leader_offset,
+                                             offsets.real_start_time_offset));
+  }
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to cache task_struct offsets: $0",
+                                               s.msg());
+}
+
+StatusOr<utils::TaskStructOffsets> ReadTaskStructOffsetsFromBTFFile(
+    const std::filesystem::path& path) {
+  PL_ASSIGN_OR_RETURN(std::string btf, ReadFileToString(path.string(), std::ios_base::binary));
+  return utils::ReadTaskStructOffsetsFromBTF(btf);
+}
+
+StatusOr<utils::TaskStructOffsets> ResolveOrLoadTaskStructOffsets() {
+  // Every BPF program that needs linux headers asks for the offsets, so they are resolved only
+  // once per process. Resolution compiles and runs a BPF program of its own.
+  static std::mutex mu;
+  static std::optional<utils::TaskStructOffsets> resolved_offsets;
+  std::lock_guard<std::mutex> lock(mu);
+  if (resolved_offsets.has_value()) {
+    return resolved_offsets.value();
+  }
+
+  // Kernels with BTF describe task_struct exactly, so there is nothing to resolve.
+  std::filesystem::path btf_path =
+      system::Config::GetInstance().ToHostPath(std::filesystem::path(utils::kVmlinuxBTFPath));
+  if (fs::Exists(btf_path).ok()) {
+    StatusOr<utils::TaskStructOffsets> offsets_or = ReadTaskStructOffsetsFromBTFFile(btf_path);
+    if (offsets_or.ok()) {
+      LOG(INFO) << absl::Substitute("Using task_struct offsets from $0.", btf_path.string());
+      resolved_offsets = offsets_or.ConsumeValueOrDie();
+      return resolved_offsets.value();
+    }
+    LOG(WARNING) << absl::Substitute("Failed to read task_struct offsets from $0: $1",
+                                     btf_path.string(), offsets_or.msg());
+  }
+
+  std::optional<std::filesystem::path> cache_path;
+  if (!FLAGS_stirling_bpf_cache_dir.empty()) {
+    StatusOr<std::filesystem::path> path_or = TaskStructOffsetsCachePath();
+    if (path_or.ok()) {
+      cache_path = path_or.ConsumeValueOrDie();
+      resolved_offsets = ReadCachedTaskStructOffsets(cache_path.value());
+      if (resolved_offsets.has_value()) {
+        LOG(INFO) << absl::Substitute("Using cached task_struct offsets from $0.",
+                                      cache_path->string());
+        return resolved_offsets.value();
+      }
+    }
+  }
+
+  LOG(INFO) << "Resolving task_struct offsets.";
+  PL_ASSIGN_OR_RETURN(utils::TaskStructOffsets offsets, ResolveTaskStructOffsets());
+  resolved_offsets = offsets;
+  if (cache_path.has_value()) {
+    WriteCachedTaskStructOffsets(cache_path.value(), offsets);
+  }
+  return offsets;
+}
+
 StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets() {
   // Defaults to zero offsets, which tells BPF not to use the offset overrides.
   // If the values are changed (as they are if ResolveTaskStructOffsets() is run),
@@ -102,9 +217,7 @@ StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets() {
   // local headers, and for testing purposes.
   bool potentially_mismatched_headers = utils::g_packaged_headers_installed;
   if (potentially_mismatched_headers || FLAGS_stirling_always_infer_task_struct_offsets) {
-    LOG(INFO) << "Resolving task_struct offsets.";
-
-    PL_ASSIGN_OR_RETURN(offsets, ResolveTaskStructOffsets());
+    PL_ASSIGN_OR_RETURN(offsets, ResolveOrLoadTaskStructOffsets());
 
     LOG(INFO) << absl::Substitute("Task struct offsets: group_leader=$0 real_start_time=$1",
                                   offsets.group_leader_offset, offsets.real_start_time_offset);
@@ -113,6 +226,29 @@ StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets() {
   return offsets;
 }
 
+namespace {
+
+// Turns on the kernel's accounting of BPF program runs, for the whole host.
+// BPF_ENABLE_STATS (Linux 5.8+) keeps it on until the returned fd is closed, so the fd is left
+// open for the life of the process. Older kernels (5.1+) only have the sysctl.
+void EnableBPFStats() {
+  static std::once_flag once;
+  std::call_once(once, [] {
+    union bpf_attr attr = {};
+    attr.enable_stats.type = BPF_STATS_RUN_TIME;
+    if (syscall(__NR_bpf, BPF_ENABLE_STATS, &attr, sizeof(attr)) >= 0) {
+      LOG(INFO) << "Enabled BPF program stats.";
+      return;
+    }
+    const auto sysctl = system::Config::GetInstance().proc_path() / "sys/kernel/bpf_stats_enabled";
+    Status s = WriteFileFromString(sysctl.string(), "1");
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Could not enable BPF program stats: $0",
+                                                 s.msg());
+  });
+}
+
+}  // namespace
+
 Status BCCWrapper::InitBPFProgram(std::string_view bpf_program, std::vector<std::string> cflags,
                                   bool requires_linux_headers) {
   using utils::TaskStructOffsets;
@@ -121,6 +257,11 @@ Status BCCWrapper::InitBPFProgram(std::string_view bpf_program, std::vector<std:
     return error::PermissionDenied("BCC currently only supported as the root user.");
   }
 
+  // Stirling initializes its sources concurrently. Installing the headers and mounting debugfs
+  // change the host, so they are done one program at a time; the compilation itself is not.
+  static std::mutex setup_mu;
+  std::unique_lock<std::mutex> setup_lock(setup_mu);
+
   if (requires_linux_headers) {
     PL_ASSIGN_OR_RETURN(utils::KernelVersion kernel_version, utils::GetKernelVersion());
 
@@ -160,14 +301,58 @@ Status BCCWrapper::InitBPFProgram(std::string_view bpf_program, std::vector<std:
   }
 
   PL_RETURN_IF_ERROR(MountDebugFS());
+  setup_lock.unlock();
 
   auto init_res = bpf_.init(std::string(bpf_program), cflags);
   if (!init_res.ok()) {
     return error::Internal("Unable to initialize BCC BPF program: $0", init_res.msg());
   }
+
+  if (FLAGS_stirling_enable_bpf_stats) {
+    EnableBPFStats();
+  }
+  if (!overhead_collector_id_.has_value()) {
+    overhead_collector_id_ = utils::OverheadStats::GetInstance().AddCollector(
+        [this](std::vector<utils::OverheadStat>* stats) { CollectOverheadStats(stats); });
+  }
   return Status::OK();
 }
 
+void BCCWrapper::AddProgramForStats(const std::string& probe_fn, bpf_prog_type type) {
+  // The program is already loaded by the attach, so this only looks up its fd.
+  int fd = -1;
+  ebpf::StatusTuple status = bpf_.load_func(probe_fn, type, fd);
+  if (!status.ok()) {
+    VLOG(1) << absl::Substitute("No program fd for $0: $1", probe_fn, status.msg());
+    return;
+  }
+  absl::MutexLock lock(&stats_mu_);
+  prog_fds_[probe_fn] = fd;
+}
+
+void BCCWrapper::CollectOverheadStats(std::vector<utils::OverheadStat>* stats) {
+  absl::MutexLock lock(&stats_mu_);
+  for (const auto& [probe_fn, fd] : prog_fds_) {
+    struct bpf_prog_info info = {};
+    union bpf_attr attr = {};
+    attr.info.bpf_fd = fd;
+    attr.info.info_len = sizeof(info);
+    attr.info.info = reinterpret_cast<uint64_t>(&info);
+    if (syscall(__NR_bpf, BPF_OBJ_GET_INFO_BY_FD, &attr, sizeof(attr)) != 0) {
+      VLOG(1) << absl::Substitute("Could not get the info of program $0: $1", probe_fn,
+                                  std::strerror(errno));
+      continue;
+    }
+    stats->push_back({utils::OverheadStat::Kind::kBPFProgram, probe_fn,
+                      static_cast<int64_t>(info.run_cnt), static_cast<int64_t>(info.run_time_ns),
+                      0});
+  }
+  for (const auto& callback : perf_buffer_callbacks_) {
+    stats->push_back({utils::OverheadStat::Kind::kPerfBuffer, callback->name, 0, 0,
+                      callback->lost_count.load()});
+  }
+}
+
 Status BCCWrapper::AttachKProbe(const KProbeSpec& probe) {
   VLOG(1) << "Deploying kprobe: " << probe.ToString();
   DCHECK(probe.attach_type != BPFProbeAttachType::kReturnInsts);
@@ -175,6 +360,7 @@ Status BCCWrapper::AttachKProbe(const KProbeSpec& probe) {
   PL_RETURN_IF_ERROR(
       bpf_.attach_kprobe(GetKProbeTargetName(probe), std::string(probe.probe_fn), 0 /* offset */,
                          static_cast<bpf_probe_attach_type>(probe.attach_type), kKprobeMaxActive));
+  AddProgramForStats(std::string(probe.probe_fn), BPF_PROG_TYPE_KPROBE);
   kprobes_.push_back(probe);
   ++num_attached_kprobes_;
   return Status::OK();
@@ -184,6 +370,7 @@ Status BCCWrapper::AttachTracepoint(const TracepointSpec& probe) {
   VLOG(1) << "Deploying tracepoint: " << probe.ToString();
 
   PL_RETURN_IF_ERROR(bpf_.attach_tracepoint(probe.tracepoint, probe.probe_fn));
+  AddProgramForStats(probe.probe_fn, BPF_PROG_TYPE_TRACEPOINT);
   tracepoints_.push_back(probe);
   ++num_attached_tracepoints_;
   return Status::OK();
@@ -199,6 +386,7 @@ Status BCCWrapper::AttachUProbe(const UProbeSpec& probe) {
   PL_RETURN_IF_ERROR(bpf_.attach_uprobe(
       probe.binary_path, probe.symbol, std::string(probe.probe_fn), probe.address,
       static_cast<bpf_probe_attach_type>(probe.attach_type), probe.pid));
+  AddProgramForStats(std::string(probe.probe_fn), BPF_PROG_TYPE_KPROBE);
   uprobes_.push_back(probe);
   ++num_attached_uprobes_;
   return Status::OK();
@@ -316,19 +504,36 @@ void BCCWrapper::DetachTracepoints() {
   tracepoints_.clear();
 }
 
-Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie) {
+int BufferPageCount(int64_t size_bytes) {
   const int kPageSizeBytes = system::Config::GetInstance().PageSize();
-  int num_pages = IntRoundUpDivide(perf_buffer.size_bytes, kPageSizeBytes);
+  int num_pages = IntRoundUpDivide<int64_t>(size_bytes, kPageSizeBytes);
 
-  // Perf buffers must be sized to a power of 2.
-  num_pages = IntRoundUpToPow2(num_pages);
+  // Perf and ring buffers must be sized to a power of 2.
+  return IntRoundUpToPow2(num_pages);
+}
+
+Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie) {
+  const int kPageSizeBytes = system::Config::GetInstance().PageSize();
+  int num_pages = BufferPageCount(perf_buffer.size_bytes);
 
   VLOG(1) << absl::Substitute("Opening perf buffer: $0 [requested_size=$1 num_pages=$2 size=$3]",
                               perf_buffer.name, perf_buffer.size_bytes, num_pages,
                               num_pages * kPageSizeBytes);
-  PL_RETURN_IF_ERROR(bpf_.open_perf_buffer(std::string(perf_buffer.name),
-                                           perf_buffer.probe_output_fn, perf_buffer.probe_loss_fn,
-                                           cb_cookie, num_pages));
+  auto callback = std::make_unique<PerfBufferCallback>();
+  callback->name = perf_buffer.name;
+  callback->probe_output_fn = perf_buffer.probe_output_fn;
+  callback->probe_loss_fn = perf_buffer.probe_loss_fn;
+  callback->cb_cookie = cb_cookie;
+  callback->lost_counter = metrics::MetricsRegistry::Global()->GetCounter(
+      "stirling_perf_buffer_lost_events_total",
+      "Number of events lost because a perf buffer was full.",
+      {{"perf_buffer", perf_buffer.name}});
+  PL_RETURN_IF_ERROR(bpf_.open_perf_buffer(std::string(perf_buffer.name), &HandlePerfBufferEvent,
+                                           &HandlePerfBufferLoss, callback.get(), num_pages));
+  {
+    absl::MutexLock lock(&stats_mu_);
+    perf_buffer_callbacks_.push_back(std::move(callback));
+  }
   perf_buffers_.push_back(perf_buffer);
   ++num_open_perf_buffers_;
   return Status::OK();
@@ -354,6 +559,85 @@ void BCCWrapper::ClosePerfBuffers() {
     LOG_IF(ERROR, !res.ok()) << res.msg();
   }
   perf_buffers_.clear();
+  absl::MutexLock lock(&stats_mu_);
+  perf_buffer_callbacks_.clear();
+}
+
+void BCCWrapper::HandlePerfBufferEvent(void* ctx, void* data, int data_size) {
+  auto* callback = static_cast<const PerfBufferCallback*>(ctx);
+  callback->probe_output_fn(callback->cb_cookie, data, data_size);
+}
+
+void BCCWrapper::HandlePerfBufferLoss(void* ctx, uint64_t lost) {
+  auto* callback = static_cast<PerfBufferCallback*>(ctx);
+  callback->lost_count += lost;
+  callback->lost_counter->Increment(lost);
+  if (callback->probe_loss_fn != nullptr) {
+    callback->probe_loss_fn(callback->cb_cookie, lost);
+  }
+}
+
+int BCCWrapper::HandleRingBufferEvent(void* ctx, void* data, size_t data_size) {
+  auto* callback = static_cast<const RingBufferCallback*>(ctx);
+  callback->probe_output_fn(callback->cb_cookie, data, static_cast<int>(data_size));
+  return 0;
+}
+
+namespace {
+
+bool KernelVersionAtLeast(uint8_t major, uint8_t minor) {
+  StatusOr<utils::KernelVersion> kernel_version = utils::GetKernelVersion();
+  if (!kernel_version.ok()) {
+    LOG(WARNING) << absl::Substitute("Could not determine the kernel version: $0",
+                                     kernel_version.msg());
+    return false;
+  }
+  return kernel_version.ValueOrDie().code() >= ((major << 16) | (minor << 8));
+}
+
+}  // namespace
+
+bool BCCWrapper::SupportsRingBuffers() {
+  // BPF_MAP_TYPE_RINGBUF was added in Linux 5.8.
+  return KernelVersionAtLeast(5, 8);
+}
+
+bool BCCWrapper::SupportsLRUHashMaps() {
+  // BPF_MAP_TYPE_LRU_HASH was added in Linux 4.10.
+  return KernelVersionAtLeast(4, 10);
+}
+
+bool BCCWrapper::SupportsBoundedLoops() {
+  // The verifier accepts bounded loops since Linux 5.3, which also raised the instruction limit.
+  return KernelVersionAtLeast(5, 3);
+}
+
+Status BCCWrapper::OpenRingBuffer(const RingBufferSpec& ring_buffer, void* cb_cookie) {
+  VLOG(1) << "Opening ring buffer: " << ring_buffer.name;
+  auto callback = std::make_unique<RingBufferCallback>(
+      RingBufferCallback{ring_buffer.probe_output_fn, cb_cookie});
+  PL_RETURN_IF_ERROR(
+      bpf_.open_ring_buffer(ring_buffer.name, &HandleRingBufferEvent, callback.get()));
+  ring_buffer_callbacks_.push_back(std::move(callback));
+  ring_buffers_.push_back(ring_buffer);
+  ++num_open_ring_buffers_;
+  return Status::OK();
+}
+
+Status BCCWrapper::CloseRingBuffer(const RingBufferSpec& ring_buffer) {
+  VLOG(1) << "Closing ring buffer: " << ring_buffer.name;
+  PL_RETURN_IF_ERROR(bpf_.close_ring_buffer(ring_buffer.name));
+  --num_open_ring_buffers_;
+  return Status::OK();
+}
+
+void BCCWrapper::CloseRingBuffers() {
+  for (const RingBufferSpec& r : ring_buffers_) {
+    auto res = CloseRingBuffer(r);
+    LOG_IF(ERROR, !res.ok()) << res.msg();
+  }
+  ring_buffers_.clear();
+  ring_buffer_callbacks_.clear();
 }
 
 Status BCCWrapper::AttachPerfEvent(const PerfEventSpec& perf_event) {
@@ -362,6 +646,7 @@ Status BCCWrapper::AttachPerfEvent(const PerfEventSpec& perf_event) {
   PL_RETURN_IF_ERROR(bpf_.attach_perf_event(perf_event.type, perf_event.config,
                                             std::string(perf_event.probe_fn),
                                             perf_event.sample_period, 0));
+  AddProgramForStats(std::string(perf_event.probe_fn), BPF_PROG_TYPE_PERF_EVENT);
   perf_events_.push_back(perf_event);
   ++num_attached_perf_events_;
   return Status::OK();
@@ -411,12 +696,26 @@ void BCCWrapper::PollPerfBuffers(int timeout_ms) {
   }
 }
 
+void BCCWrapper::PollRingBuffers(int timeout_ms) {
+  for (const auto& spec : ring_buffers_) {
+    // Ring buffers are epoll-driven: a timeout of 0 consumes what is available without blocking.
+    bpf_.poll_ring_buffer(spec.name, timeout_ms);
+  }
+}
+
 void BCCWrapper::Close() {
+  if (overhead_collector_id_.has_value()) {
+    utils::OverheadStats::GetInstance().RemoveCollector(*overhead_collector_id_);
+    overhead_collector_id_.reset();
+  }
   DetachPerfEvents();
   ClosePerfBuffers();
+  CloseRingBuffers();
   DetachKProbes();
   DetachUProbes();
   DetachTracepoints();
+  absl::MutexLock lock(&stats_mu_);
+  prog_fds_.clear();
 }
 
 }  // namespace bpf_tools
@@ -34,19 +34,30 @@
 
 #include <gtest/gtest_prod.h>
 
+#include <atomic>
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
+#include "src/stirling/bpf_tools/bpf_map_batch.h"
 #include "src/stirling/obj_tools/elf_tools.h"
+#include "src/stirling/utils/overhead_stats.h"
 
 DECLARE_uint32(stirling_bpf_perf_buffer_page_count);
 DECLARE_bool(stirling_always_infer_task_struct_offsets);
+DECLARE_bool(stirling_enable_bpf_stats);
+DECLARE_string(stirling_bpf_cache_dir);
 
 namespace px {
 /*
@@ -65,6 +76,62 @@ namespace px {
 namespace stirling {
 namespace bpf_tools {
 
+/**
+ * A BCC hash table, with batched operations (see bpf_map_batch.h) on top of the per-key ones.
+ * Each batched operation takes a handful of bpf() syscalls, instead of one or two per key.
+ */
+template <typename TKeyType, typename TValueType>
+class BatchHashTable : public ebpf::BPFHashTable<TKeyType, TValueType> {
+ public:
+  explicit BatchHashTable(const ebpf::BPFHashTable<TKeyType, TValueType>& table)
+      : ebpf::BPFHashTable<TKeyType, TValueType>(table) {}
+
+  /**
+   * Creates or updates the given entries.
+   */
+  StatusOr<size_t> UpdateValues(const std::vector<std::pair<TKeyType, TValueType>>& entries) {
+    std::vector<TKeyType> keys;
+    std::vector<TValueType> values;
+    keys.reserve(entries.size());
+    values.reserve(entries.size());
+    for (const auto& [key, value] : entries) {
+      keys.push_back(key);
+      values.push_back(value);
+    }
+    return UpdateBPFMapEntries(fd(), AsBytes(keys), AsBytes(values), entries.size());
+  }
+
+  /**
+   * Removes the given keys. Keys that are not in the table are skipped.
+   *
+   * @return the number of entries removed.
+   */
+  StatusOr<size_t> RemoveValues(const std::vector<TKeyType>& keys) {
+    return RemoveBPFMapEntries(fd(), AsBytes(keys), keys.size());
+  }
+
+  /**
+   * Returns all the entries of the table, and deletes them if clear_table is true.
+   * Unlike get_table_offline(), the entries are not read one key at a time.
+   */
+  StatusOr<std::vector<std::pair<TKeyType, TValueType>>> GetTableOffline(bool clear_table = false) {
+    std::vector<std::pair<TKeyType, TValueType>> entries;
+    PL_RETURN_IF_ERROR(ReadBPFMapEntries(
+        fd(), clear_table, [&entries](std::string_view key, std::string_view value) {
+          entries.emplace_back(utils::MemCpy<TKeyType>(key), utils::MemCpy<TValueType>(value));
+        }));
+    return entries;
+  }
+
+ private:
+  int fd() const { return static_cast<int>(this->desc.fd); }
+
+  template <typename T>
+  static std::string_view AsBytes(const std::vector<T>& v) {
+    return std::string_view(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+  }
+};
+
 enum class BPFProbeAttachType {
   // Attach to function entry.
   kEntry = BPF_PROBE_ENTRY,
@@ -167,6 +234,31 @@ struct PerfBufferSpec {
   int size_bytes = 1024 * 1024;
 };
 
+/**
+ * Describes a BPF ring buffer (BPF_MAP_TYPE_RINGBUF, kernels 5.8+), through which data is
+ * returned to user-space. Unlike a perf buffer, a ring buffer is shared by all CPUs, so it takes
+ * less memory and keeps the events in the order they were submitted.
+ *
+ * The size of a ring buffer is part of its BPF_RINGBUF_OUTPUT declaration in the probe code;
+ * see BufferPageCount().
+ */
+struct RingBufferSpec {
+  // Name of the ring buffer.
+  // Must be the same as the ring buffer name declared in the probe code with BPF_RINGBUF_OUTPUT.
+  std::string name;
+
+  // Function that will be called for every event in the ring buffer,
+  // when ring buffer read is triggered. Same signature as for perf buffers, so that the same
+  // handlers can be used with either transport.
+  perf_reader_raw_cb probe_output_fn;
+};
+
+/**
+ * Returns the number of pages of a perf or ring buffer of the requested size.
+ * Buffers must be sized to a power of 2 number of pages.
+ */
+int BufferPageCount(int64_t size_bytes);
+
 /**
  * Describes a perf event to attach.
  * This can be run stand-alone and is not dependent on kProbes.
@@ -248,6 +340,30 @@ class BCCWrapper {
    */
   Status OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie = nullptr);
 
+  /**
+   * Open a ring buffer for reading events.
+   * @param ring_buffer Specifications of the ring buffer (name, callback function).
+   * @param cb_cookie A pointer that is sent to the callback function when triggered by
+   * PollRingBuffers().
+   * @return Error if ring buffer cannot be opened (e.g. ring buffer does not exist).
+   */
+  Status OpenRingBuffer(const RingBufferSpec& ring_buffer, void* cb_cookie = nullptr);
+
+  /**
+   * @return true if the kernel supports BPF ring buffers (5.8+).
+   */
+  static bool SupportsRingBuffers();
+
+  /**
+   * @return true if the kernel supports BPF LRU hash maps (4.10+).
+   */
+  static bool SupportsLRUHashMaps();
+
+  /**
+   * @return true if the kernel verifier accepts bounded loops (5.3+).
+   */
+  static bool SupportsBoundedLoops();
+
   /**
    * Attach a perf event, which runs a probe every time a perf counter reaches a threshold
    * condition.
@@ -324,6 +440,14 @@ class BCCWrapper {
    */
   void PollPerfBuffers(int timeout_ms = 0);
 
+  /**
+   * Drains all of the opened ring buffers, calling the handle function that was
+   * specified in the RingBufferSpec when OpenRingBuffer was called.
+   *
+   * @param timeout_ms See PollPerfBuffers().
+   */
+  void PollRingBuffers(int timeout_ms = 0);
+
   /**
    * Detaches all probes, and closes all perf buffers that are open.
    */
@@ -334,6 +458,11 @@ class BCCWrapper {
     return bpf_.get_hash_table<TKeyType, TValueType>(table_name);
   }
 
+  template <typename TKeyType, typename TValueType>
+  BatchHashTable<TKeyType, TValueType> GetBatchHashTable(const std::string& table_name) {
+    return BatchHashTable<TKeyType, TValueType>(GetHashTable<TKeyType, TValueType>(table_name));
+  }
+
   template <typename TValueType>
   ebpf::BPFArrayTable<TValueType> GetArrayTable(const std::string& table_name) {
     return bpf_.get_array_table<TValueType>(table_name);
@@ -356,6 +485,7 @@ class BCCWrapper {
   // It is meant for verification that we have cleaned-up all resources in tests.
   static size_t num_attached_probes() { return num_attached_kprobes_ + num_attached_uprobes_; }
   static size_t num_open_perf_buffers() { return num_open_perf_buffers_; }
+  static size_t num_open_ring_buffers() { return num_open_ring_buffers_; }
   static size_t num_attached_perf_events() { return num_attached_perf_events_; }
 
  private:
@@ -365,6 +495,7 @@ class BCCWrapper {
   Status DetachUProbe(const UProbeSpec& probe);
   Status DetachTracepoint(const TracepointSpec& probe);
   Status ClosePerfBuffer(const PerfBufferSpec& perf_buffer);
+  Status CloseRingBuffer(const RingBufferSpec& ring_buffer);
   Status DetachPerfEvent(const PerfEventSpec& perf_event);
   void PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms);
 
@@ -374,17 +505,55 @@ class BCCWrapper {
   void DetachUProbes();
   void DetachTracepoints();
   void ClosePerfBuffers();
+  void CloseRingBuffers();
   void DetachPerfEvents();
 
   // Returns the name that identifies the target to attach this k-probe.
   std::string GetKProbeTargetName(const KProbeSpec& probe);
 
+  // Remembers the program of an attached probe, so its run time can be reported.
+  void AddProgramForStats(const std::string& probe_fn, bpf_prog_type type);
+
+  // Appends the run counts of the attached programs, and the losses of the open perf buffers.
+  // Registered with utils::OverheadStats by InitBPFProgram().
+  void CollectOverheadStats(std::vector<utils::OverheadStat>* stats);
+
   std::vector<KProbeSpec> kprobes_;
   std::vector<UProbeSpec> uprobes_;
   std::vector<TracepointSpec> tracepoints_;
   std::vector<PerfBufferSpec> perf_buffers_;
+  std::vector<RingBufferSpec> ring_buffers_;
+
+  // The ring buffer callbacks take a different signature than the perf buffer ones, so the
+  // handler and cookie of each ring buffer are kept here, and passed to a common trampoline.
+  struct RingBufferCallback {
+    perf_reader_raw_cb probe_output_fn;
+    void* cb_cookie;
+  };
+  std::vector<std::unique_ptr<RingBufferCallback>> ring_buffer_callbacks_;
+  static int HandleRingBufferEvent(void* ctx, void* data, size_t data_size);
   std::vector<PerfEventSpec> perf_events_;
 
+  // BCC passes the same cookie to both callbacks of a perf buffer, so to count the lost events,
+  // both are routed through trampolines that get this struct as their cookie.
+  struct PerfBufferCallback {
+    std::string name;
+    perf_reader_raw_cb probe_output_fn;
+    perf_reader_lost_cb probe_loss_fn;
+    void* cb_cookie;
+    std::atomic<int64_t> lost_count = 0;
+    metrics::Counter* lost_counter;
+  };
+  static void HandlePerfBufferEvent(void* ctx, void* data, int data_size);
+  static void HandlePerfBufferLoss(void* ctx, uint64_t lost);
+
+  // Guards the state read by CollectOverheadStats(), which runs on the thread reading the table.
+  absl::Mutex stats_mu_;
+  std::vector<std::unique_ptr<PerfBufferCallback>> perf_buffer_callbacks_
+      ABSL_GUARDED_BY(stats_mu_);
+  absl::flat_hash_map<std::string, int> prog_fds_ ABSL_GUARDED_BY(stats_mu_);
+  std::optional<int64_t> overhead_collector_id_;
+
   std::string system_headers_include_dir_;
 
   ebpf::BPF bpf_;
@@ -397,6 +566,7 @@ class BCCWrapper {
   inline static size_t num_attached_uprobes_;
   inline static size_t num_attached_tracepoints_;
   inline static size_t num_open_perf_buffers_;
+  inline static size_t num_open_ring_buffers_;
   inline static size_t num_attached_perf_events_;
 };
 
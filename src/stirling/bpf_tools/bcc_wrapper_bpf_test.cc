@@ -152,6 +152,52 @@ TEST(BCCWrapperTest, GetTGIDStartTime) {
   EXPECT_EQ(proc_pid_start_time, expected_proc_pid_start_time);
 }
 
+void AppendRingBufferPID(void* cb_cookie, void* data, int data_size) {
+  ASSERT_EQ(data_size, sizeof(uint32_t));
+  static_cast<std::vector<uint32_t>*>(cb_cookie)->push_back(*static_cast<uint32_t*>(data));
+}
+
+TEST(BCCWrapperTest, RingBuffer) {
+  if (!BCCWrapper::SupportsRingBuffers()) {
+    GTEST_SKIP() << "BPF ring buffers require Linux 5.8+.";
+  }
+
+  constexpr char kProgram[] = R"BCC(
+    BPF_RINGBUF_OUTPUT(pid_events, 1);
+
+    int probe_pid(struct pt_regs* ctx) {
+      uint32_t pid = bpf_get_current_pid_tgid() >> 32;
+      pid_events.ringbuf_output(&pid, sizeof(pid), 0);
+      return 0;
+    }
+  )BCC";
+
+  BCCWrapper bcc_wrapper;
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(kProgram));
+
+  ASSERT_OK_AND_ASSIGN(std::filesystem::path self_path, fs::ReadSymlink("/proc/self/exe"));
+  UProbeSpec uprobe{.binary_path = self_path,
+                    .symbol = {},  // Keep GCC happy.
+                    .address = reinterpret_cast<uint64_t>(&BCCWrapperTestProbeTrigger),
+                    .attach_type = BPFProbeAttachType::kEntry,
+                    .probe_fn = "probe_pid"};
+  ASSERT_OK(bcc_wrapper.AttachUProbe(uprobe));
+
+  std::vector<uint32_t> pids;
+  ASSERT_OK(bcc_wrapper.OpenRingBuffer({"pid_events", AppendRingBufferPID}, &pids));
+  EXPECT_EQ(1, BCCWrapper::num_open_ring_buffers());
+
+  BCCWrapperTestProbeTrigger();
+  BCCWrapperTestProbeTrigger();
+  bcc_wrapper.PollRingBuffers();
+
+  const auto pid = static_cast<uint32_t>(getpid());
+  EXPECT_THAT(pids, ::testing::ElementsAre(pid, pid));
+
+  bcc_wrapper.Close();
+  EXPECT_EQ(0, BCCWrapper::num_open_ring_buffers());
+}
+
 TEST(BCCWrapperTest, TestMapClearingAPIs) {
   // Test to show that get_table_offline() with clear_table=true actually clears the table.
   bpf_tools::BCCWrapper bcc_wrapper;
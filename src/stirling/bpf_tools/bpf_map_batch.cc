@@ -0,0 +1,279 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/bpf_map_batch.h"
+
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+namespace {
+
+// The kernel-internal ENOTSUPP, which BPF syscalls can return to user space.
+constexpr int kKernelENOTSUPP = 524;
+
+int BPFSyscall(int cmd, union bpf_attr* attr) {
+  return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+uint64_t PtrToU64(const void* ptr) {
+  return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
+}
+
+// Whether a batch command failed because the kernel or the map type doesn't support it.
+bool BatchUnsupported(int err) {
+  return err == EINVAL || err == ENOTSUP || err == kKernelENOTSUPP;
+}
+
+StatusOr<struct bpf_map_info> GetMapInfo(int map_fd) {
+  struct bpf_map_info info = {};
+  union bpf_attr attr = {};
+  attr.info.bpf_fd = map_fd;
+  attr.info.info_len = sizeof(info);
+  attr.info.info = PtrToU64(&info);
+  if (BPFSyscall(BPF_OBJ_GET_INFO_BY_FD, &attr) != 0) {
+    return error::Internal("Failed to get BPF map info ($0)", std::strerror(errno));
+  }
+  return info;
+}
+
+Status CheckSize(std::string_view buf, size_t elem_size, size_t num_elems) {
+  if (buf.size() != elem_size * num_elems) {
+    return error::InvalidArgument("Expected $0 elements of $1 bytes, got $2 bytes.", num_elems,
+                                  elem_size, buf.size());
+  }
+  return Status::OK();
+}
+
+// Reads the map with BPF_MAP_LOOKUP_BATCH or BPF_MAP_LOOKUP_AND_DELETE_BATCH. Returns an
+// Unimplemented error, before reading anything, if batches are not supported.
+StatusOr<size_t> ReadBPFMapEntriesInBatches(int map_fd, const struct bpf_map_info& info,
+                                            bool delete_entries, const BPFMapEntryFn& fn) {
+  std::string keys(info.key_size * kBPFMapBatchSize, '\0');
+  std::string values(info.value_size * kBPFMapBatchSize, '\0');
+  // The batch token is opaque; it is at most a key, or a 32-bit bucket index for hash maps.
+  std::string batch(std::max<size_t>(info.key_size, sizeof(uint64_t)), '\0');
+
+  const int cmd = delete_entries ? BPF_MAP_LOOKUP_AND_DELETE_BATCH : BPF_MAP_LOOKUP_BATCH;
+
+  size_t num_entries = 0;
+  bool first = true;
+  bool done = false;
+  while (!done) {
+    union bpf_attr attr = {};
+    attr.batch.map_fd = map_fd;
+    attr.batch.in_batch = first ? 0 : PtrToU64(batch.data());
+    attr.batch.out_batch = PtrToU64(batch.data());
+    attr.batch.keys = PtrToU64(keys.data());
+    attr.batch.values = PtrToU64(values.data());
+    attr.batch.count = kBPFMapBatchSize;
+
+    if (BPFSyscall(cmd, &attr) != 0) {
+      if (errno == ENOENT) {
+        // This was the last batch. The count is still valid.
+        done = true;
+      } else if (first && BatchUnsupported(errno)) {
+        return error::Unimplemented("Batch map operations are not supported.");
+      } else {
+        return error::Internal("Failed to read BPF map ($0)", std::strerror(errno));
+      }
+    }
+    first = false;
+
+    for (uint32_t i = 0; i < attr.batch.count; ++i) {
+      fn(std::string_view(keys.data() + i * info.key_size, info.key_size),
+         std::string_view(values.data() + i * info.value_size, info.value_size));
+    }
+    num_entries += attr.batch.count;
+  }
+
+  return num_entries;
+}
+
+// Reads the map one key at a time.
+StatusOr<size_t> ReadBPFMapEntriesByKey(int map_fd, const struct bpf_map_info& info,
+                                        bool delete_entries, const BPFMapEntryFn& fn) {
+  // Collect the keys first, since deleting entries while iterating could restart the iteration.
+  std::vector<std::string> keys;
+  std::string key(info.key_size, '\0');
+  std::string next_key(info.key_size, '\0');
+  bool first = true;
+  while (true) {
+    union bpf_attr attr = {};
+    attr.map_fd = map_fd;
+    attr.key = first ? 0 : PtrToU64(key.data());
+    attr.next_key = PtrToU64(next_key.data());
+    if (BPFSyscall(BPF_MAP_GET_NEXT_KEY, &attr) != 0) {
+      if (errno == ENOENT) {
+        break;
+      }
+      return error::Internal("Failed to iterate BPF map ($0)", std::strerror(errno));
+    }
+    first = false;
+    keys.push_back(next_key);
+    key.swap(next_key);
+  }
+
+  size_t num_entries = 0;
+  std::string value(info.value_size, '\0');
+  for (const auto& k : keys) {
+    union bpf_attr attr = {};
+    attr.map_fd = map_fd;
+    attr.key = PtrToU64(k.data());
+    attr.value = PtrToU64(value.data());
+    if (BPFSyscall(BPF_MAP_LOOKUP_ELEM, &attr) != 0) {
+      // The entry was deleted since its key was read.
+      continue;
+    }
+    if (delete_entries) {
+      // Ignore failures, the entry might have been deleted by BPF code in the meantime.
+      attr.value = 0;
+      BPFSyscall(BPF_MAP_DELETE_ELEM, &attr);
+    }
+
+    fn(k, value);
+    ++num_entries;
+  }
+
+  return num_entries;
+}
+
+}  // namespace
+
+StatusOr<size_t> UpdateBPFMapEntries(int map_fd, std::string_view keys, std::string_view values,
+                                     size_t num_entries) {
+  PL_ASSIGN_OR_RETURN(struct bpf_map_info info, GetMapInfo(map_fd));
+  PL_RETURN_IF_ERROR(CheckSize(keys, info.key_size, num_entries));
+  PL_RETURN_IF_ERROR(CheckSize(values, info.value_size, num_entries));
+
+  size_t num_updated = 0;
+  bool use_batch = true;
+  while (num_updated < num_entries) {
+    union bpf_attr attr = {};
+    const char* key = keys.data() + num_updated * info.key_size;
+    const char* value = values.data() + num_updated * info.value_size;
+
+    if (use_batch) {
+      attr.batch.map_fd = map_fd;
+      attr.batch.keys = PtrToU64(key);
+      attr.batch.values = PtrToU64(value);
+      attr.batch.count = std::min<size_t>(kBPFMapBatchSize, num_entries - num_updated);
+      attr.batch.elem_flags = BPF_ANY;
+      int ret = BPFSyscall(BPF_MAP_UPDATE_BATCH, &attr);
+      // On failure, the count is the number of entries updated before the error.
+      num_updated += attr.batch.count;
+      if (ret == 0) {
+        continue;
+      }
+      if (attr.batch.count == 0 && BatchUnsupported(errno)) {
+        use_batch = false;
+        continue;
+      }
+    } else {
+      attr.map_fd = map_fd;
+      attr.key = PtrToU64(key);
+      attr.value = PtrToU64(value);
+      attr.flags = BPF_ANY;
+      if (BPFSyscall(BPF_MAP_UPDATE_ELEM, &attr) == 0) {
+        ++num_updated;
+        continue;
+      }
+    }
+    return error::Internal("Failed to update BPF map entry $0 ($1)", num_updated,
+                           std::strerror(errno));
+  }
+
+  return num_updated;
+}
+
+StatusOr<size_t> RemoveBPFMapEntries(int map_fd, std::string_view keys, size_t num_keys) {
+  PL_ASSIGN_OR_RETURN(struct bpf_map_info info, GetMapInfo(map_fd));
+  PL_RETURN_IF_ERROR(CheckSize(keys, info.key_size, num_keys));
+
+  size_t num_processed = 0;
+  size_t num_removed = 0;
+  bool use_batch = true;
+  while (num_processed < num_keys) {
+    union bpf_attr attr = {};
+    const char* key = keys.data() + num_processed * info.key_size;
+
+    if (use_batch) {
+      attr.batch.map_fd = map_fd;
+      attr.batch.keys = PtrToU64(key);
+      attr.batch.count = std::min<size_t>(kBPFMapBatchSize, num_keys - num_processed);
+      int ret = BPFSyscall(BPF_MAP_DELETE_BATCH, &attr);
+      // On failure, the count is the number of entries removed before the error.
+      num_processed += attr.batch.count;
+      num_removed += attr.batch.count;
+      if (ret == 0) {
+        continue;
+      }
+      if (errno == ENOENT) {
+        // The next key is not in the map, skip it.
+        ++num_processed;
+        continue;
+      }
+      if (attr.batch.count == 0 && BatchUnsupported(errno)) {
+        use_batch = false;
+        continue;
+      }
+    } else {
+      attr.map_fd = map_fd;
+      attr.key = PtrToU64(key);
+      int ret = BPFSyscall(BPF_MAP_DELETE_ELEM, &attr);
+      if (ret == 0 || errno == ENOENT) {
+        num_removed += (ret == 0);
+        ++num_processed;
+        continue;
+      }
+    }
+    return error::Internal("Failed to remove BPF map entry $0 ($1)", num_processed,
+                           std::strerror(errno));
+  }
+
+  return num_removed;
+}
+
+StatusOr<size_t> ReadBPFMapEntries(int map_fd, bool delete_entries, const BPFMapEntryFn& fn) {
+  PL_ASSIGN_OR_RETURN(struct bpf_map_info info, GetMapInfo(map_fd));
+  if (info.type == BPF_MAP_TYPE_PERCPU_HASH || info.type == BPF_MAP_TYPE_PERCPU_ARRAY ||
+      info.type == BPF_MAP_TYPE_LRU_PERCPU_HASH) {
+    return error::Unimplemented("Cannot read per-CPU BPF map $0.", info.name);
+  }
+
+  StatusOr<size_t> num_entries = ReadBPFMapEntriesInBatches(map_fd, info, delete_entries, fn);
+  if (num_entries.ok() || !error::IsUnimplemented(num_entries.status())) {
+    return num_entries;
+  }
+  VLOG(1) << "Batch BPF map operations are not supported, reading the map key by key.";
+  return ReadBPFMapEntriesByKey(map_fd, info, delete_entries, fn);
+}
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
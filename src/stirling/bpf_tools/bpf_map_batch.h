@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <functional>
+#include <string_view>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+/**
+ * Batched operations on BPF maps, by file descriptor.
+ *
+ * Each operation uses the kernel's BPF_MAP_*_BATCH command when available (Linux 5.6+), which
+ * handles many entries per bpf() syscall. On older kernels, and for maps that don't support
+ * batches, the operations fall back to one syscall per entry.
+ *
+ * Keys and values are passed as packed arrays, using the key and value sizes of the map.
+ */
+
+// The number of entries handled per batch syscall.
+constexpr uint32_t kBPFMapBatchSize = 256;
+
+// Called for each entry read from a map, with the raw bytes of its key and value.
+// The bytes are only valid during the call.
+using BPFMapEntryFn = std::function<void(std::string_view key, std::string_view value)>;
+
+/**
+ * Creates or updates the num_entries entries given by the packed keys and values.
+ *
+ * @return the number of entries updated, or an error if any of the updates fails.
+ */
+StatusOr<size_t> UpdateBPFMapEntries(int map_fd, std::string_view keys, std::string_view values,
+                                     size_t num_entries);
+
+/**
+ * Removes the num_keys entries given by the packed keys. Keys that are not in the map are skipped.
+ *
+ * @return the number of entries removed.
+ */
+StatusOr<size_t> RemoveBPFMapEntries(int map_fd, std::string_view keys, size_t num_keys);
+
+/**
+ * Reads all the entries of the map, calling fn for each of them. If delete_entries is true, the
+ * entries are deleted as they are read. Per-CPU maps are not supported.
+ *
+ * @return the number of entries read.
+ */
+StatusOr<size_t> ReadBPFMapEntries(int map_fd, bool delete_entries, const BPFMapEntryFn& fn);
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
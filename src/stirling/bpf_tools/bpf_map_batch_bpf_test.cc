@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/bpf_map_batch.h"
+
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+class BPFMapBatchTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    union bpf_attr attr = {};
+    attr.map_type = BPF_MAP_TYPE_HASH;
+    attr.key_size = sizeof(uint64_t);
+    attr.value_size = sizeof(uint64_t);
+    attr.max_entries = 4096;
+    map_fd_ = syscall(__NR_bpf, BPF_MAP_CREATE, &attr, sizeof(attr));
+    ASSERT_GE(map_fd_, 0);
+  }
+
+  void TearDown() override { close(map_fd_); }
+
+  std::map<uint64_t, uint64_t> ReadAll(bool delete_entries) {
+    std::map<uint64_t, uint64_t> entries;
+    auto fn = [&entries](std::string_view key, std::string_view value) {
+      entries[utils::MemCpy<uint64_t>(key)] = utils::MemCpy<uint64_t>(value);
+    };
+    EXPECT_OK(ReadBPFMapEntries(map_fd_, delete_entries, fn));
+    return entries;
+  }
+
+  template <typename T>
+  static std::string_view AsBytes(const std::vector<T>& v) {
+    return std::string_view(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+  }
+
+  int map_fd_ = -1;
+};
+
+TEST_F(BPFMapBatchTest, UpdateRemoveAndRead) {
+  // More entries than a single batch.
+  constexpr uint64_t kNumEntries = 3 * kBPFMapBatchSize + 1;
+  std::vector<uint64_t> keys;
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < kNumEntries; ++i) {
+    keys.push_back(i);
+    values.push_back(10 * i);
+  }
+
+  ASSERT_OK_AND_ASSIGN(size_t num_updated,
+                       UpdateBPFMapEntries(map_fd_, AsBytes(keys), AsBytes(values), kNumEntries));
+  EXPECT_EQ(num_updated, kNumEntries);
+
+  // Keys that are not in the map are skipped.
+  std::vector<uint64_t> keys_to_remove = {5, kNumEntries + 100, 6, 7};
+  ASSERT_OK_AND_ASSIGN(size_t num_removed, RemoveBPFMapEntries(map_fd_, AsBytes(keys_to_remove),
+                                                               keys_to_remove.size()));
+  EXPECT_EQ(num_removed, 3);
+
+  std::map<uint64_t, uint64_t> entries = ReadAll(/* delete_entries */ false);
+  EXPECT_EQ(entries.size(), kNumEntries - 3);
+  EXPECT_EQ(entries[0], 0);
+  EXPECT_EQ(entries[kNumEntries - 1], 10 * (kNumEntries - 1));
+  EXPECT_EQ(entries.count(5), 0);
+
+  // Draining returns the same entries, and leaves the map empty.
+  EXPECT_EQ(ReadAll(/* delete_entries */ true), entries);
+  EXPECT_TRUE(ReadAll(/* delete_entries */ false).empty());
+}
+
+TEST_F(BPFMapBatchTest, MismatchedSizes) {
+  std::vector<uint32_t> keys = {1, 2};
+  std::vector<uint64_t> values = {1, 2};
+  EXPECT_NOT_OK(UpdateBPFMapEntries(map_fd_, AsBytes(keys), AsBytes(values), 2));
+  EXPECT_NOT_OK(RemoveBPFMapEntries(map_fd_, AsBytes(keys), 2));
+}
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
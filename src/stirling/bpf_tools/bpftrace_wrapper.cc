@@ -235,6 +235,19 @@ bpftrace::BPFTraceMap BPFTraceWrapper::GetBPFMap(const std::string& name) {
   return bpftrace_.get_map(name);
 }
 
+StatusOr<size_t> BPFTraceWrapper::DrainBPFMap(const std::string& name,
+                                              const MapEntryCallback& callback) {
+  DCHECK(compiled_) << "Must compile first.";
+
+  auto map = bpftrace_.maps.Lookup(name);
+  if (!map.has_value()) {
+    return error::NotFound("BPF map $0 does not exist.", name);
+  }
+  int map_fd = (*map)->mapfd_;
+
+  return ReadBPFMapEntries(map_fd, /* delete_entries */ true, callback);
+}
+
 }  // namespace bpf_tools
 }  // namespace stirling
 }  // namespace px
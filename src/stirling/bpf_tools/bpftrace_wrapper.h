@@ -22,11 +22,13 @@
 #include <bpftrace/src/bpftrace.h>
 #include <bpftrace/src/driver.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bpf_map_batch.h"
 
 namespace px {
 namespace stirling {
@@ -46,6 +48,12 @@ class BPFTraceWrapper {
    */
   using PrintfCallback = std::function<void(uint8_t*)>;
 
+  /**
+   * Callback for each entry drained from a BPF map, with the raw bytes of its key and value.
+   * The bytes are only valid during the call.
+   */
+  using MapEntryCallback = BPFMapEntryFn;
+
   ~BPFTraceWrapper() { Stop(); }
 
   /**
@@ -97,6 +105,20 @@ class BPFTraceWrapper {
    */
   bpftrace::BPFTraceMap GetBPFMap(const std::string& name);
 
+  /**
+   * Reads and deletes all the entries of the specified map, calling the callback for each entry.
+   * Map name should include the '@' prefix.
+   *
+   * Unlike GetBPFMap(), the entries are not copied or sorted, and since they are deleted, each
+   * drain only sees the entries written since the previous one. This keeps the cost proportional
+   * to the entries updated in a period, instead of to the size of the map.
+   *
+   * See ReadBPFMapEntries() for how the entries are read. Per-CPU maps are not supported.
+   *
+   * @return the number of entries drained.
+   */
+  StatusOr<size_t> DrainBPFMap(const std::string& name, const MapEntryCallback& callback);
+
  protected:
   bpftrace::BPFtrace bpftrace_;
   std::unique_ptr<bpftrace::BpfOrc> bpforc_;
@@ -18,6 +18,8 @@
 
 #include "src/stirling/bpf_tools/bpftrace_wrapper.h"
 
+#include <map>
+
 #include "src/common/testing/testing.h"
 
 namespace px {
@@ -45,6 +47,42 @@ TEST(BPFTracerWrapperTest, MapRead) {
   bpftrace_wrapper.Stop();
 }
 
+TEST(BPFTracerWrapperTest, MapDrain) {
+  constexpr std::string_view kScript = R"(
+  interval:ms:100 {
+      @count[0] = @count[0] + 1;
+      @count[1] = @count[1] + 1;
+  }
+  )";
+
+  BPFTraceWrapper bpftrace_wrapper;
+  ASSERT_OK(bpftrace_wrapper.CompileForMapOutput(kScript, /* params */ {}));
+  ASSERT_OK(bpftrace_wrapper.Deploy());
+  sleep(1);
+
+  std::map<uint64_t, uint64_t> counts;
+  auto drain_fn = [&counts](std::string_view key, std::string_view value) {
+    ASSERT_EQ(key.size(), sizeof(uint64_t));
+    ASSERT_EQ(value.size(), sizeof(uint64_t));
+    counts[utils::MemCpy<uint64_t>(key)] = utils::MemCpy<uint64_t>(value);
+  };
+
+  ASSERT_OK_AND_ASSIGN(size_t num_entries, bpftrace_wrapper.DrainBPFMap("@count", drain_fn));
+  EXPECT_EQ(num_entries, 2);
+  ASSERT_EQ(counts.size(), 2);
+  EXPECT_GT(counts[0], 0);
+
+  // The drained entries are deleted, so draining again right away finds (almost) nothing.
+  counts.clear();
+  ASSERT_OK_AND_ASSIGN(num_entries, bpftrace_wrapper.DrainBPFMap("@count", drain_fn));
+  EXPECT_LE(num_entries, 2);
+  EXPECT_LE(counts[0], 1);
+
+  EXPECT_NOT_OK(bpftrace_wrapper.DrainBPFMap("@missing", drain_fn));
+
+  bpftrace_wrapper.Stop();
+}
+
 TEST(BPFTracerWrapperTest, PerfBufferPoll) {
   constexpr std::string_view kScript = R"(
     interval:ms:100 {
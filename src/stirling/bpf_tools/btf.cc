@@ -0,0 +1,279 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/btf.h"
+
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include <absl/strings/str_join.h>
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+namespace {
+
+// The layouts below follow include/uapi/linux/btf.h.
+constexpr uint16_t kBTFMagic = 0xeB9F;
+
+struct BTFHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint32_t hdr_len;
+  uint32_t type_off;
+  uint32_t type_len;
+  uint32_t str_off;
+  uint32_t str_len;
+};
+
+struct BTFType {
+  uint32_t name_off;
+  // Bits 0-15: vlen, bits 24-28: kind, bit 31: kind_flag.
+  uint32_t info;
+  // The size for INT, ENUM, STRUCT and UNION. The referenced type id for the others.
+  uint32_t size_or_type;
+
+  uint32_t vlen() const { return info & 0xffff; }
+  uint32_t kind() const { return (info >> 24) & 0x1f; }
+  bool kind_flag() const { return info >> 31; }
+};
+
+struct BTFMember {
+  uint32_t name_off;
+  uint32_t type;
+  // The bit offset. With kind_flag set, bits 24-31 hold the bitfield size.
+  uint32_t offset;
+};
+
+enum BTFKind : uint32_t {
+  kInt = 1,
+  kPtr = 2,
+  kArray = 3,
+  kStruct = 4,
+  kUnion = 5,
+  kEnum = 6,
+  kFwd = 7,
+  kTypedef = 8,
+  kVolatile = 9,
+  kConst = 10,
+  kRestrict = 11,
+  kFunc = 12,
+  kFuncProto = 13,
+  kVar = 14,
+  kDatasec = 15,
+  kFloat = 16,
+  kDeclTag = 17,
+  kTypeTag = 18,
+  kEnum64 = 19,
+};
+
+template <typename T>
+T ReadAt(std::string_view data, size_t pos) {
+  T val;
+  std::memcpy(&val, data.data() + pos, sizeof(T));
+  return val;
+}
+
+class BTFTypes {
+ public:
+  Status Init(std::string_view btf) {
+    if (btf.size() < sizeof(BTFHeader)) {
+      return error::InvalidArgument("BTF data is too short ($0 bytes)", btf.size());
+    }
+    auto hdr = ReadAt<BTFHeader>(btf, 0);
+    if (hdr.magic != kBTFMagic) {
+      return error::InvalidArgument("Unexpected BTF magic $0", hdr.magic);
+    }
+    uint64_t types_end = uint64_t{hdr.hdr_len} + hdr.type_off + hdr.type_len;
+    uint64_t strs_end = uint64_t{hdr.hdr_len} + hdr.str_off + hdr.str_len;
+    if (types_end > btf.size() || strs_end > btf.size()) {
+      return error::InvalidArgument("BTF sections are out of bounds");
+    }
+    types_ = btf.substr(hdr.hdr_len + hdr.type_off, hdr.type_len);
+    strs_ = btf.substr(hdr.hdr_len + hdr.str_off, hdr.str_len);
+
+    // Type ids start at 1, id 0 is void.
+    type_pos_.push_back(0);
+    size_t pos = 0;
+    while (pos < types_.size()) {
+      if (pos + sizeof(BTFType) > types_.size()) {
+        return error::InvalidArgument("Truncated BTF type");
+      }
+      type_pos_.push_back(pos);
+      auto type = ReadAt<BTFType>(types_, pos);
+      PL_ASSIGN_OR_RETURN(size_t extra, ExtraSize(type));
+      pos += sizeof(BTFType) + extra;
+    }
+    if (pos != types_.size()) {
+      return error::InvalidArgument("Truncated BTF type");
+    }
+    return Status::OK();
+  }
+
+  size_t num_types() const { return type_pos_.size(); }
+
+  BTFType Type(uint32_t id) const { return ReadAt<BTFType>(types_, type_pos_[id]); }
+
+  BTFMember Member(uint32_t id, uint32_t i) const {
+    return ReadAt<BTFMember>(types_, type_pos_[id] + sizeof(BTFType) + i * sizeof(BTFMember));
+  }
+
+  std::string_view Name(uint32_t name_off) const {
+    if (name_off >= strs_.size()) {
+      return {};
+    }
+    std::string_view name = strs_.substr(name_off);
+    return name.substr(0, name.find('\0'));
+  }
+
+  // Skips typedefs and type qualifiers.
+  uint32_t ResolveType(uint32_t id) const {
+    while (id != 0 && id < num_types()) {
+      BTFType type = Type(id);
+      switch (type.kind()) {
+        case kTypedef:
+        case kVolatile:
+        case kConst:
+        case kRestrict:
+        case kTypeTag:
+          id = type.size_or_type;
+          break;
+        default:
+          return id;
+      }
+    }
+    return id;
+  }
+
+ private:
+  static StatusOr<size_t> ExtraSize(const BTFType& type) {
+    switch (type.kind()) {
+      case kInt:
+      case kVar:
+      case kDeclTag:
+        return 4;
+      case kArray:
+        return 12;
+      case kStruct:
+      case kUnion:
+        return type.vlen() * sizeof(BTFMember);
+      case kEnum:
+      case kFuncProto:
+        return type.vlen() * 8;
+      case kDatasec:
+      case kEnum64:
+        return type.vlen() * 12;
+      case kPtr:
+      case kFwd:
+      case kTypedef:
+      case kVolatile:
+      case kConst:
+      case kRestrict:
+      case kFunc:
+      case kFloat:
+      case kTypeTag:
+        return 0;
+      default:
+        return error::InvalidArgument("Unknown BTF kind $0", type.kind());
+    }
+  }
+
+  std::string_view types_;
+  std::string_view strs_;
+  std::vector<size_t> type_pos_;
+};
+
+// Returns the bit offset of the named member of a struct, looking through anonymous struct and
+// union members (e.g. the one that holds task_struct's randomized fields).
+std::optional<uint64_t> FindMemberBitOffset(const BTFTypes& types, uint32_t struct_id,
+                                            std::string_view name) {
+  BTFType type = types.Type(struct_id);
+  for (uint32_t i = 0; i < type.vlen(); ++i) {
+    BTFMember member = types.Member(struct_id, i);
+    uint64_t bit_offset = type.kind_flag() ? (member.offset & 0xffffff) : member.offset;
+    if (member.name_off != 0) {
+      if (types.Name(member.name_off) == name) {
+        return bit_offset;
+      }
+      continue;
+    }
+    uint32_t member_type_id = types.ResolveType(member.type);
+    if (member_type_id == 0 || member_type_id >= types.num_types()) {
+      continue;
+    }
+    uint32_t kind = types.Type(member_type_id).kind();
+    if (kind != kStruct && kind != kUnion) {
+      continue;
+    }
+    std::optional<uint64_t> nested = FindMemberBitOffset(types, member_type_id, name);
+    if (nested.has_value()) {
+      return bit_offset + nested.value();
+    }
+  }
+  return std::nullopt;
+}
+
+StatusOr<uint64_t> FindMemberOffset(const BTFTypes& types, uint32_t struct_id,
+                                    const std::vector<std::string_view>& names) {
+  for (std::string_view name : names) {
+    std::optional<uint64_t> bit_offset = FindMemberBitOffset(types, struct_id, name);
+    if (!bit_offset.has_value()) {
+      continue;
+    }
+    if (bit_offset.value() % 8 != 0) {
+      return error::Internal("task_struct member $0 is not byte aligned", name);
+    }
+    return bit_offset.value() / 8;
+  }
+  return error::NotFound("task_struct has none of the members [$0]", absl::StrJoin(names, ","));
+}
+
+}  // namespace
+
+StatusOr<TaskStructOffsets> ReadTaskStructOffsetsFromBTF(std::string_view btf) {
+  BTFTypes types;
+  PL_RETURN_IF_ERROR(types.Init(btf));
+
+  uint32_t task_struct_id = 0;
+  for (uint32_t id = 1; id < types.num_types(); ++id) {
+    BTFType type = types.Type(id);
+    if (type.kind() == kStruct && types.Name(type.name_off) == "task_struct") {
+      task_struct_id = id;
+      break;
+    }
+  }
+  if (task_struct_id == 0) {
+    return error::NotFound("BTF data has no task_struct");
+  }
+
+  TaskStructOffsets offsets;
+  // The member was renamed to start_boottime in Linux 5.5.
+  PL_ASSIGN_OR_RETURN(
+      offsets.real_start_time_offset,
+      FindMemberOffset(types, task_struct_id, {"start_boottime", "real_start_time"}));
+  PL_ASSIGN_OR_RETURN(offsets.group_leader_offset,
+                      FindMemberOffset(types, task_struct_id, {"group_leader"}));
+  return offsets;
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
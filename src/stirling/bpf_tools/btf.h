@@ -0,0 +1,46 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/task_struct_resolver.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+/**
+ * The BTF description of the running kernel, on kernels built with CONFIG_DEBUG_INFO_BTF.
+ */
+inline constexpr char kVmlinuxBTFPath[] = "/sys/kernel/btf/vmlinux";
+
+/**
+ * Reads the offsets of the task_struct members needed by the BPF code from raw BTF data (e.g.
+ * the contents of /sys/kernel/btf/vmlinux).
+ *
+ * Unlike ResolveTaskStructOffsets(), this doesn't need to compile and run a BPF program, and
+ * the offsets are exact, since they come from the kernel's own type information.
+ */
+StatusOr<TaskStructOffsets> ReadTaskStructOffsetsFromBTF(std::string_view btf);
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
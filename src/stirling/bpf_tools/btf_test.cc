@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/btf.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+// Assembles raw BTF data from 32-bit words for the type section and a string section.
+class BTFBuilder {
+ public:
+  BTFBuilder() { strs_.push_back('\0'); }
+
+  uint32_t AddString(std::string_view s) {
+    uint32_t off = strs_.size();
+    strs_.append(s);
+    strs_.push_back('\0');
+    return off;
+  }
+
+  static uint32_t Info(uint32_t kind, uint32_t vlen) { return (kind << 24) | vlen; }
+
+  void AddWords(const std::vector<uint32_t>& words) {
+    types_.insert(types_.end(), words.begin(), words.end());
+  }
+
+  std::string Build(uint16_t magic = 0xeB9F) const {
+    struct {
+      uint16_t magic;
+      uint8_t version;
+      uint8_t flags;
+      uint32_t hdr_len;
+      uint32_t type_off;
+      uint32_t type_len;
+      uint32_t str_off;
+      uint32_t str_len;
+    } hdr = {magic,
+             1,
+             0,
+             sizeof(hdr),
+             0,
+             static_cast<uint32_t>(types_.size() * 4),
+             static_cast<uint32_t>(types_.size() * 4),
+             static_cast<uint32_t>(strs_.size())};
+    std::string out(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.append(reinterpret_cast<const char*>(types_.data()), types_.size() * 4);
+    out.append(strs_);
+    return out;
+  }
+
+ private:
+  std::vector<uint32_t> types_;
+  std::string strs_;
+};
+
+constexpr uint32_t kInt = 1;
+constexpr uint32_t kPtr = 2;
+constexpr uint32_t kStruct = 4;
+
+// Builds a task_struct with group_leader at byte 32, and start_boottime inside an anonymous
+// struct at byte 64.
+std::string TaskStructBTF(std::string_view boottime_name) {
+  BTFBuilder b;
+  uint32_t int_name = b.AddString("int");
+  uint32_t task_struct_name = b.AddString("task_struct");
+  uint32_t pid_name = b.AddString("pid");
+  uint32_t group_leader_name = b.AddString("group_leader");
+  uint32_t boottime = b.AddString(boottime_name);
+
+  // [1] int, with its encoding word.
+  b.AddWords({int_name, BTFBuilder::Info(kInt, 0), 4, 32});
+  // [2] struct task_struct*.
+  b.AddWords({0, BTFBuilder::Info(kPtr, 0), 3});
+  // [3] struct task_struct.
+  b.AddWords({task_struct_name, BTFBuilder::Info(kStruct, 3), 128});
+  b.AddWords({pid_name, 1, 0});
+  b.AddWords({group_leader_name, 2, 32 * 8});
+  b.AddWords({0, 4, 64 * 8});
+  // [4] The anonymous struct.
+  b.AddWords({0, BTFBuilder::Info(kStruct, 2), 16});
+  b.AddWords({pid_name, 1, 0});
+  b.AddWords({boottime, 1, 8 * 8});
+  return b.Build();
+}
+
+TEST(ReadTaskStructOffsetsFromBTF, finds_members) {
+  ASSERT_OK_AND_ASSIGN(TaskStructOffsets offsets,
+                       ReadTaskStructOffsetsFromBTF(TaskStructBTF("start_boottime")));
+  EXPECT_EQ(offsets.group_leader_offset, 32);
+  EXPECT_EQ(offsets.real_start_time_offset, 72);
+}
+
+TEST(ReadTaskStructOffsetsFromBTF, old_start_time_name) {
+  ASSERT_OK_AND_ASSIGN(TaskStructOffsets offsets,
+                       ReadTaskStructOffsetsFromBTF(TaskStructBTF("real_start_time")));
+  EXPECT_EQ(offsets.real_start_time_offset, 72);
+}
+
+TEST(ReadTaskStructOffsetsFromBTF, errors) {
+  EXPECT_NOT_OK(ReadTaskStructOffsetsFromBTF("short"));
+  EXPECT_NOT_OK(ReadTaskStructOffsetsFromBTF(BTFBuilder().Build(/*magic*/ 0x1234)));
+  // No task_struct at all.
+  EXPECT_NOT_OK(ReadTaskStructOffsetsFromBTF(BTFBuilder().Build()));
+  // No start time member.
+  EXPECT_NOT_OK(ReadTaskStructOffsetsFromBTF(TaskStructBTF("start_time")));
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
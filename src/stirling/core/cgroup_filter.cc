@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/core/cgroup_filter.h"
+
+#include <utility>
+
+#include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+
+DEFINE_string(stirling_cgroup_filter_allow,
+              gflags::StringFromEnv("PL_STIRLING_CGROUP_FILTER_ALLOW", ""),
+              "Comma separated namespaces, or <namespace>/<pod> names, that the BPF probes only "
+              "trace the processes of. Traces all the processes if empty.");
+DEFINE_string(stirling_cgroup_filter_deny,
+              gflags::StringFromEnv("PL_STIRLING_CGROUP_FILTER_DENY", ""),
+              "Comma separated namespaces, or <namespace>/<pod> names, that the BPF probes don't "
+              "trace the processes of, even if they are in --stirling_cgroup_filter_allow.");
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+std::vector<std::string> SplitFlag(std::string_view flag) {
+  return absl::StrSplit(flag, ',', absl::SkipWhitespace());
+}
+
+void AddNames(const std::vector<std::string>& names, absl::flat_hash_set<std::string>* namespaces,
+              absl::flat_hash_set<std::string>* pods) {
+  for (const auto& name : names) {
+    if (absl::StrContains(name, '/')) {
+      pods->insert(name);
+    } else {
+      namespaces->insert(name);
+    }
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<CGroupFilter> CGroupFilter::CreateFromFlags() {
+  std::vector<std::string> allow = SplitFlag(FLAGS_stirling_cgroup_filter_allow);
+  std::vector<std::string> deny = SplitFlag(FLAGS_stirling_cgroup_filter_deny);
+  if (allow.empty() && deny.empty()) {
+    return nullptr;
+  }
+  return std::make_unique<CGroupFilter>(allow, deny);
+}
+
+CGroupFilter::CGroupFilter(const std::vector<std::string>& allow,
+                           const std::vector<std::string>& deny)
+    : allow_list_(!allow.empty()) {
+  AddNames(allow, &allowed_namespaces_, &allowed_pods_);
+  AddNames(deny, &denied_namespaces_, &denied_pods_);
+}
+
+std::vector<std::string> CGroupFilter::BPFCFlags() const {
+  // The cgroups outside of the map get the verdict opposite to the one in it.
+  return {"-DENABLE_CGROUP_FILTER=1",
+          absl::Substitute("-DCGROUP_FILTER_DEFAULT_VERDICT=$0", map_verdict() == 0 ? 1 : 0)};
+}
+
+bool CGroupFilter::InMap(const md::PodInfo& pod_info) const {
+  std::string pod_name = absl::StrCat(pod_info.ns(), "/", pod_info.name());
+  bool denied = denied_namespaces_.contains(pod_info.ns()) || denied_pods_.contains(pod_name);
+  if (!allow_list_) {
+    return denied;
+  }
+  bool allowed = allowed_namespaces_.contains(pod_info.ns()) || allowed_pods_.contains(pod_name);
+  return allowed && !denied;
+}
+
+void CGroupFilter::Update(const md::K8sMetadataState& k8s_md, uint64_t generation) {
+  new_cgroup_ids_.clear();
+  deleted_cgroup_ids_.clear();
+  if (generation != 0 && generation == generation_) {
+    return;
+  }
+  generation_ = generation;
+
+  absl::flat_hash_set<uint64_t> cgroup_ids;
+  for (const auto& [cid, cinfo] : k8s_md.containers_by_id()) {
+    if (cinfo->cgroup_id() == 0 || cinfo->stop_time_ns() != 0) {
+      continue;
+    }
+    const md::PodInfo* pod_info = k8s_md.PodInfoByID(cinfo->pod_id());
+    if (pod_info != nullptr && InMap(*pod_info)) {
+      cgroup_ids.insert(cinfo->cgroup_id());
+    }
+  }
+
+  for (uint64_t cgroup_id : cgroup_ids) {
+    if (!cgroup_ids_.contains(cgroup_id)) {
+      new_cgroup_ids_.insert(cgroup_id);
+    }
+  }
+  for (uint64_t cgroup_id : cgroup_ids_) {
+    if (!cgroup_ids.contains(cgroup_id)) {
+      deleted_cgroup_ids_.insert(cgroup_id);
+    }
+  }
+  cgroup_ids_ = std::move(cgroup_ids);
+}
+
+}  // namespace stirling
+}  // namespace px
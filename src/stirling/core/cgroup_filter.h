@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/metadata/metadata_state.h"
+
+DECLARE_string(stirling_cgroup_filter_allow);
+DECLARE_string(stirling_cgroup_filter_deny);
+
+namespace px {
+namespace stirling {
+
+/**
+ * Decides which cgroups the BPF probes trace, from the namespaces and pods that are allowed or
+ * denied, and keeps the cgroup_filter_map of a BPF program (see bcc_bpf/cgroup_filter.h) in sync
+ * with the containers of the pods.
+ *
+ * With an allow-list, only the cgroups of the allowed pods are traced; with only a deny-list,
+ * everything but the cgroups of the denied pods is. The map holds the cgroups whose verdict differs
+ * from that default.
+ */
+class CGroupFilter : public NotCopyable {
+ public:
+  // The name of the map in the BPF programs.
+  static constexpr char kBPFMapName[] = "cgroup_filter_map";
+
+  /**
+   * @return the filter of --stirling_cgroup_filter_allow and --stirling_cgroup_filter_deny, or
+   * nullptr if neither is set.
+   */
+  static std::unique_ptr<CGroupFilter> CreateFromFlags();
+
+  /**
+   * @param allow the namespaces, or <namespace>/<pod> names, to trace. Traces all if empty.
+   * @param deny the namespaces, or <namespace>/<pod> names, not to trace, even if allowed.
+   */
+  CGroupFilter(const std::vector<std::string>& allow, const std::vector<std::string>& deny);
+
+  /**
+   * @return the flags that compile the filter into a BPF program.
+   */
+  std::vector<std::string> BPFCFlags() const;
+
+  /**
+   * Recomputes the cgroups that get the verdict opposite to the default, from the containers with
+   * a known cgroup ID. An update with the same (non-zero) generation as the previous one is
+   * skipped, and leaves new_cgroup_ids() and deleted_cgroup_ids() empty.
+   */
+  void Update(const md::K8sMetadataState& k8s_md, uint64_t generation = 0);
+
+  /**
+   * @return the cgroups to add to the BPF map since the previous Update().
+   */
+  const absl::flat_hash_set<uint64_t>& new_cgroup_ids() const { return new_cgroup_ids_; }
+
+  /**
+   * @return the cgroups to remove from the BPF map since the previous Update().
+   */
+  const absl::flat_hash_set<uint64_t>& deleted_cgroup_ids() const { return deleted_cgroup_ids_; }
+
+  /**
+   * @return the verdict of the cgroups in the BPF map: 1 to trace, 0 to skip.
+   */
+  uint8_t map_verdict() const { return allow_list_ ? 1 : 0; }
+
+  /**
+   * Calls Update(), then writes the changes to the given BPF map, eg. an
+   * ebpf::BPFHashTable<uint64_t, uint8_t>.
+   */
+  template <typename TBPFMap>
+  Status UpdateBPFMap(const md::K8sMetadataState& k8s_md, uint64_t generation, TBPFMap* map) {
+    Update(k8s_md, generation);
+    Status status;
+    for (uint64_t cgroup_id : deleted_cgroup_ids_) {
+      // Fails if the entry is already gone, which is fine.
+      map->remove_value(cgroup_id);
+    }
+    uint8_t verdict = map_verdict();
+    for (uint64_t cgroup_id : new_cgroup_ids_) {
+      auto s = map->update_value(cgroup_id, verdict);
+      if (!s.ok()) {
+        // Retried by the next update.
+        cgroup_ids_.erase(cgroup_id);
+        generation_ = 0;
+        status = error::Internal("Failed to add cgroup $0 to the cgroup filter: $1", cgroup_id,
+                                 s.msg());
+      }
+    }
+    return status;
+  }
+
+ private:
+  // Whether the pod's cgroups get the verdict opposite to the default.
+  bool InMap(const md::PodInfo& pod_info) const;
+
+  bool allow_list_ = false;
+  absl::flat_hash_set<std::string> allowed_namespaces_;
+  absl::flat_hash_set<std::string> allowed_pods_;
+  absl::flat_hash_set<std::string> denied_namespaces_;
+  absl::flat_hash_set<std::string> denied_pods_;
+
+  absl::flat_hash_set<uint64_t> cgroup_ids_;
+  absl::flat_hash_set<uint64_t> new_cgroup_ids_;
+  absl::flat_hash_set<uint64_t> deleted_cgroup_ids_;
+  uint64_t generation_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/core/cgroup_filter.h"
+
+namespace px {
+namespace stirling {
+
+using ::google::protobuf::TextFormat;
+using ::testing::Contains;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+class CGroupFilterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    AddPod("ns0", "pod0", 100);
+    AddPod("ns1", "pod1", 101);
+  }
+
+  void AddPod(std::string_view ns, std::string_view pod, uint64_t cgroup_id) {
+    md::K8sMetadataState::ContainerUpdate container_update;
+    ASSERT_TRUE(TextFormat::MergeFromString(
+        absl::Substitute(R"(cid: "$0_cid" name: "$0_container" pod_id: "$0_uid" pod_name: "$0"
+                            container_state: CONTAINER_STATE_RUNNING)",
+                         pod),
+        &container_update));
+    ASSERT_OK(k8s_md_.HandleContainerUpdate(container_update));
+
+    md::K8sMetadataState::PodUpdate pod_update;
+    ASSERT_TRUE(TextFormat::MergeFromString(
+        absl::Substitute(R"(uid: "$1_uid" name: "$1" namespace: "$0" container_ids: "$1_cid"
+                            phase: RUNNING)",
+                         ns, pod),
+        &pod_update));
+    ASSERT_OK(k8s_md_.HandlePodUpdate(pod_update));
+
+    k8s_md_.MutableContainerInfoByID(absl::StrCat(pod, "_cid"))->set_cgroup_id(cgroup_id);
+  }
+
+  md::K8sMetadataState k8s_md_;
+};
+
+TEST_F(CGroupFilterTest, allow_list) {
+  CGroupFilter filter({"ns0", "ns1/pod1"}, {"ns1/pod1"});
+  EXPECT_EQ(1, filter.map_verdict());
+  EXPECT_THAT(filter.BPFCFlags(), Contains("-DCGROUP_FILTER_DEFAULT_VERDICT=0"));
+
+  filter.Update(k8s_md_, 1);
+  EXPECT_THAT(filter.new_cgroup_ids(), UnorderedElementsAre(100));
+  EXPECT_THAT(filter.deleted_cgroup_ids(), IsEmpty());
+
+  // Nothing changed in the same generation.
+  filter.Update(k8s_md_, 1);
+  EXPECT_THAT(filter.new_cgroup_ids(), IsEmpty());
+
+  // The cgroup of a stopped container is removed.
+  k8s_md_.MutableContainerInfoByID("pod0_cid")->set_stop_time_ns(1);
+  filter.Update(k8s_md_, 2);
+  EXPECT_THAT(filter.new_cgroup_ids(), IsEmpty());
+  EXPECT_THAT(filter.deleted_cgroup_ids(), UnorderedElementsAre(100));
+}
+
+TEST_F(CGroupFilterTest, deny_list) {
+  CGroupFilter filter({}, {"ns1"});
+  EXPECT_EQ(0, filter.map_verdict());
+  EXPECT_THAT(filter.BPFCFlags(), Contains("-DCGROUP_FILTER_DEFAULT_VERDICT=1"));
+
+  filter.Update(k8s_md_);
+  EXPECT_THAT(filter.new_cgroup_ids(), UnorderedElementsAre(101));
+}
+
+struct FakeStatus {
+  bool ok() const { return ok_; }
+  std::string msg() const { return "fake"; }
+  bool ok_ = true;
+};
+
+struct FakeBPFMap {
+  FakeStatus update_value(uint64_t key, uint8_t value) {
+    if (fail_updates) {
+      return {false};
+    }
+    values[key] = value;
+    return {};
+  }
+  FakeStatus remove_value(uint64_t key) {
+    values.erase(key);
+    return {};
+  }
+  bool fail_updates = false;
+  absl::flat_hash_map<uint64_t, uint8_t> values;
+};
+
+TEST_F(CGroupFilterTest, update_bpf_map) {
+  CGroupFilter filter({"ns0"}, {});
+  FakeBPFMap map;
+
+  map.fail_updates = true;
+  EXPECT_NOT_OK(filter.UpdateBPFMap(k8s_md_, 1, &map));
+  EXPECT_THAT(map.values, IsEmpty());
+
+  // The failed update is retried, even in the same generation.
+  map.fail_updates = false;
+  ASSERT_OK(filter.UpdateBPFMap(k8s_md_, 1, &map));
+  EXPECT_THAT(map.values, UnorderedElementsAre(Pair(100, 1)));
+
+  k8s_md_.MutableContainerInfoByID("pod0_cid")->set_stop_time_ns(1);
+  ASSERT_OK(filter.UpdateBPFMap(k8s_md_, 2, &map));
+  EXPECT_THAT(map.values, IsEmpty());
+}
+
+}  // namespace stirling
+}  // namespace px
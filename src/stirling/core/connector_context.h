@@ -54,10 +54,16 @@ class ConnectorContext {
    */
   virtual const absl::flat_hash_set<md::UPID>& GetUPIDs() const = 0;
 
+  /**
+   * Return a number that changes whenever GetUPIDs() may have changed, or 0 if that's unknown.
+   * Lets ProcTracker skip diffing an unchanged set of UPIDs.
+   */
+  virtual uint64_t GetUPIDsGeneration() const { return 0; }
+
   /**
    * Return detailed information on UPIDs.
    */
-  virtual const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const = 0;
+  virtual const md::AgentMetadataState::PIDInfoByUPIDMap& GetPIDInfoMap() const = 0;
 
   /**
    * Return K8s information (Pod and container information)
@@ -95,7 +101,10 @@ class AgentContext : public ConnectorContext {
     return agent_metadata_state_->upids();
   }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
+  // The UPIDs only change when the metadata state manager publishes a new epoch.
+  uint64_t GetUPIDsGeneration() const override { return agent_metadata_state_->epoch_id(); }
+
+  const md::AgentMetadataState::PIDInfoByUPIDMap& GetPIDInfoMap() const override {
     return agent_metadata_state_->pids_by_upid();
   }
 
@@ -127,8 +136,8 @@ class StandaloneContext : public ConnectorContext {
 
   const absl::flat_hash_set<md::UPID>& GetUPIDs() const override { return upids_; }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
-    static const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr> kEmpty;
+  const md::AgentMetadataState::PIDInfoByUPIDMap& GetPIDInfoMap() const override {
+    static const md::AgentMetadataState::PIDInfoByUPIDMap kEmpty;
     return kEmpty;
   }
 
@@ -35,16 +35,25 @@ using types::DataType;
 
 DataTable::DataTable(uint64_t id, const DataTableSchema& schema) : id_(id), table_schema_(schema) {}
 
-void DataTable::InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr) {
+void DataTable::InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr, size_t capacity) {
   DCHECK(record_batch_ptr != nullptr);
   DCHECK(record_batch_ptr->empty());
 
   for (const auto& element : table_schema_.elements()) {
     px::types::DataType type = element.type();
 
+    if (type == DataType::STRING) {
+      // Strings are appended to an arena rather than allocated one by one, and the table store
+      // takes the arena over as the arrow array.
+      auto col = types::StringValueColumnWrapper::MakeInArena(arrow::default_memory_pool());
+      col->Reserve(capacity);
+      record_batch_ptr->push_back(col);
+      continue;
+    }
+
 #define TYPE_CASE(_dt_)                           \
   auto col = types::ColumnWrapper::Make(_dt_, 0); \
-  col->Reserve(kTargetCapacity);                  \
+  col->Reserve(capacity);                         \
   record_batch_ptr->push_back(col);
     PL_SWITCH_FOREACH_DATATYPE(type, TYPE_CASE);
 #undef TYPE_CASE
@@ -54,19 +63,73 @@ void DataTable::InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr) {
 Tablet* DataTable::GetTablet(types::TabletIDView tablet_id) {
   auto& tablet = tablets_[tablet_id];
   if (tablet.records.empty()) {
-    InitBuffers(&tablet.records);
+    auto iter = tablet_capacities_.find(tablet_id);
+    size_t capacity = iter != tablet_capacities_.end() ? iter->second : kTargetCapacity;
+    tablet.times.reserve(capacity);
+    InitBuffers(&tablet.records, capacity);
   }
   return &tablet;
 }
 
+namespace {
+
+template <DataType TDataType>
+void MoveValues(ColumnWrapper* src, ColumnWrapper* dst) {
+  using TValueType = typename types::DataTypeTraits<TDataType>::value_type;
+  dst->Reserve(dst->Size() + src->Size());
+  for (size_t i = 0; i < src->Size(); ++i) {
+    if constexpr (TDataType == DataType::STRING) {
+      // Read through the const accessor, which doesn't move arena strings into StringValues.
+      dst->AppendNoTypeCheck(static_cast<const ColumnWrapper*>(src)->GetNoTypeCheck<TValueType>(i));
+    } else {
+      dst->AppendNoTypeCheck(std::move(src->GetNoTypeCheck<TValueType>(i)));
+    }
+  }
+}
+
+}  // namespace
+
+void DataTable::Merge(DataTable* other) {
+  DCHECK_EQ(&table_schema_, &other->table_schema_);
+  for (auto& [tablet_id, other_tablet] : other->tablets_) {
+    Tablet* tablet = GetTablet(tablet_id);
+    const size_t offset = tablet->times.size();
+    if (offset > 0 && !other_tablet.times.empty() &&
+        other_tablet.times.front() < tablet->times.back()) {
+      tablet->run_starts.push_back(offset);
+    }
+    for (size_t run_start : other_tablet.run_starts) {
+      tablet->run_starts.push_back(offset + run_start);
+    }
+    tablet->times.insert(tablet->times.end(), other_tablet.times.begin(),
+                         other_tablet.times.end());
+    for (size_t i = 0; i < tablet->records.size(); ++i) {
+      ColumnWrapper* src = other_tablet.records[i].get();
+      ColumnWrapper* dst = tablet->records[i].get();
+#define TYPE_CASE(_dt_) MoveValues<_dt_>(src, dst);
+      PL_SWITCH_FOREACH_DATATYPE(dst->data_type(), TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+  other->tablets_.clear();
+}
+
 std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
   std::vector<TaggedRecordBatch> tablets_out;
   absl::flat_hash_map<types::TabletID, Tablet> carryover_tablets;
+  absl::flat_hash_map<types::TabletID, size_t> tablet_capacities;
   uint64_t next_start_time = start_time_;
 
   for (auto& [tablet_id, tablet] : tablets_) {
-    // Sort based on times.
-    std::vector<size_t> sort_indexes = utils::SortedIndexes(tablet.times);
+    const size_t num_records = tablet.times.size();
+    const size_t capacity = std::min(std::max<size_t>(num_records, 1), kMaxReservedCapacity);
+    tablet_capacities[tablet_id] = capacity;
+    if (num_records == 0) {
+      continue;
+    }
+
+    // Order the records by time, by merging the sorted runs they were appended in.
+    std::vector<size_t> sort_indexes = utils::MergedRunIndexes(tablet.times, tablet.run_starts);
 
     // End time is cutoff time + 1, so call to SplitSortedVector() produces the following
     // classification: which classified according to:
@@ -81,9 +144,9 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
     // 3) Carryover indexes: these are too new to return, so hold on to them until the next round.
     auto positions =
         utils::SplitSortedVector<2>(tablet.times, sort_indexes, {start_time_, end_time});
-    int num_expired = positions[0];
-    int num_pushable = positions[1] - positions[0];
-    int num_carryover = tablet.times.size() - positions[1];
+    size_t num_expired = positions[0];
+    size_t num_pushable = positions[1] - positions[0];
+    size_t num_carryover = num_records - positions[1];
 
     // Case 1: Expired records. Just print a message.
     VLOG_IF(1, num_expired > 0) << absl::Substitute(
@@ -93,37 +156,47 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
 
     // Case 2: Pushable records. Copy to output.
     if (num_pushable > 0) {
+      uint64_t last_time = tablet.times[sort_indexes[positions[1] - 1]];
+      next_start_time = std::max(next_start_time, last_time);
+
+      if (num_pushable == num_records && tablet.run_starts.empty()) {
+        // The common case: the records are in order, and all pushable, so hand over the columns.
+        tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(tablet.records)});
+        continue;
+      }
+
       // TODO(oazizi): Consider VectorView to avoid copying.
-      std::vector<size_t> push_indexes(sort_indexes.begin() + num_expired,
-                                       sort_indexes.end() - num_carryover);
+      std::vector<size_t> push_indexes(sort_indexes.begin() + positions[0],
+                                       sort_indexes.begin() + positions[1]);
       types::ColumnWrapperRecordBatch pushable_records;
       for (auto& col : tablet.records) {
         pushable_records.push_back(col->MoveIndexes(push_indexes));
       }
-      uint64_t last_time = tablet.times[push_indexes.back()];
-      next_start_time = std::max(next_start_time, last_time);
       tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(pushable_records)});
     }
 
-    // Case 3: Carryover records.
+    // Case 3: Carryover records. These are moved in time order, so they form a single run.
     if (num_carryover > 0) {
       // TODO(oazizi): Consider VectorView to avoid copying.
-      std::vector<size_t> carryover_indexes(sort_indexes.begin() + num_pushable,
+      std::vector<size_t> carryover_indexes(sort_indexes.begin() + positions[1],
                                             sort_indexes.end());
       types::ColumnWrapperRecordBatch carryover_records;
       for (auto& col : tablet.records) {
         carryover_records.push_back(col->MoveIndexes(carryover_indexes));
+        carryover_records.back()->Reserve(std::max(capacity, num_carryover));
       }
 
-      std::vector<uint64_t> times(carryover_indexes.size());
-      for (size_t i = 0; i < times.size(); ++i) {
-        times[i] = tablet.times[carryover_indexes[i]];
+      std::vector<uint64_t> times;
+      times.reserve(std::max(capacity, num_carryover));
+      for (size_t idx : carryover_indexes) {
+        times.push_back(tablet.times[idx]);
       }
       carryover_tablets[tablet_id] =
-          Tablet{tablet_id, std::move(times), std::move(carryover_records)};
+          Tablet{tablet_id, std::move(times), {}, std::move(carryover_records)};
     }
   }
   tablets_ = std::move(carryover_tablets);
+  tablet_capacities_ = std::move(tablet_capacities);
 
   start_time_ = next_start_time;
 
@@ -43,9 +43,18 @@ struct TaggedRecordBatch {
 
 struct Tablet {
   types::TabletID tablet_id;
-  // TODO(oazizi): Convert this vector into a heap of {time, index} objects.
   std::vector<uint64_t> times;
+  // Records mostly arrive in time order, so times is kept as sorted runs, which ConsumeRecords()
+  // merges instead of sorting. This has the start of every run but the first.
+  std::vector<size_t> run_starts;
   types::ColumnWrapperRecordBatch records;
+
+  void AddTime(uint64_t time) {
+    if (!times.empty() && time < times.back()) {
+      run_starts.push_back(times.size());
+    }
+    times.push_back(time);
+  }
 };
 
 class DataTable : public NotCopyable {
@@ -70,6 +79,17 @@ class DataTable : public NotCopyable {
    */
   std::vector<TaggedRecordBatch> ConsumeRecords();
 
+  /**
+   * Moves all the records buffered in another table of the same schema into this one. The other
+   * table is left empty.
+   *
+   * This lets several threads stage records in tables of their own, and push them into the
+   * shared table once they are done.
+   *
+   * @param other The table to move the records from.
+   */
+  void Merge(DataTable* other);
+
   /**
    * Sets a cutoff time for the table. Any records that appear after this time
    * will not be pushed out on a call to ConsumeRecords(). Instead, they will
@@ -190,7 +210,7 @@ class DataTable : public NotCopyable {
    private:
     void Init(uint64_t time) {
       DCHECK_EQ(schema->elements().size(), tablet_.records.size());
-      tablet_.times.push_back(time);
+      tablet_.AddTime(time);
     }
 
     Tablet& tablet_;
@@ -246,7 +266,7 @@ class DataTable : public NotCopyable {
    private:
     void Init(uint64_t time) {
       DCHECK_EQ(schema_.elements().size(), tablet_.records.size());
-      tablet_.times.push_back(time);
+      tablet_.AddTime(time);
       LOG_IF(DFATAL, schema_.elements().size() > kMaxSupportedColumns) << absl::Substitute(
           "Tables with more than $0 columns are not supported.", kMaxSupportedColumns);
     }
@@ -263,12 +283,14 @@ class DataTable : public NotCopyable {
  protected:
   // ColumnWrapper specific members
   static constexpr size_t kTargetCapacity = 1024;
+  // The most a tablet's columns are pre-sized to, however many records it had before.
+  static constexpr size_t kMaxReservedCapacity = 64 * 1024;
 
   // Unique ID set by InfoClassManager.
   const uint64_t id_;
 
-  // Initialize a new Active record batch.
-  void InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr);
+  // Initialize a new Active record batch, with room for the given number of records.
+  void InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr, size_t capacity);
 
   // Get a pointer to the Tablet, for appending. Used by RecordBuilder.
   Tablet* GetTablet(types::TabletIDView tablet_id);
@@ -279,6 +301,9 @@ class DataTable : public NotCopyable {
   // Key is tablet id, value is tablet records.
   absl::flat_hash_map<types::TabletID, Tablet> tablets_;
 
+  // The number of records each tablet had at the last ConsumeRecords(), to pre-size its columns.
+  absl::flat_hash_map<types::TabletID, size_t> tablet_capacities_;
+
   uint64_t start_time_ = 0;
 
   // The cutoff time is an optional field that sets up to which time
@@ -19,6 +19,7 @@
 #include <gtest/gtest.h>
 #include <random>
 #include <string>
+#include <vector>
 
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/source_connectors/seq_gen/sequence_generator.h"
@@ -69,6 +70,38 @@ TEST_F(DataTableTest, ResultIsSorted) {
   }
 }
 
+TEST_F(DataTableTest, Merge) {
+  std::vector<int> time_vals = {0, 10, 40, 20, 30, 50, 90, 70, 60, 80};
+  std::vector<int> x_vals = {0, 1, 4, 2, 3, 5, 9, 7, 6, 8};
+  std::vector<std::string> s_vals = {"a", "b", "e", "c", "d", "f", "j", "h", "g", "i"};
+
+  // Alternate the records between the table and a staging table.
+  DataTable staging_table(/*id*/ 0, kSchema);
+  for (size_t i = 0; i < time_vals.size(); ++i) {
+    DataTable::RecordBuilder<&kSchema> r(i % 2 == 0 ? data_table_.get() : &staging_table,
+                                         time_vals[i]);
+    r.Append<r.ColIndex("time_")>(time_vals[i]);
+    r.Append<r.ColIndex("x")>(x_vals[i]);
+    r.Append<r.ColIndex("s")>(s_vals[i]);
+  }
+
+  data_table_->Merge(&staging_table);
+  EXPECT_EQ(staging_table.Occupancy(), 0);
+  EXPECT_EQ(data_table_->Occupancy(), time_vals.size());
+
+  std::vector<TaggedRecordBatch> record_batches = data_table_->ConsumeRecords();
+
+  ASSERT_EQ(record_batches.size(), 1);
+  types::ColumnWrapperRecordBatch& rb = record_batches[0].records;
+  ASSERT_EQ(rb[0]->Size(), time_vals.size());
+
+  for (size_t i = 0; i < time_vals.size(); ++i) {
+    EXPECT_EQ(rb[0]->Get<types::Time64NSValue>(i), 10 * static_cast<int>(i));
+    EXPECT_EQ(rb[1]->Get<types::Int64Value>(i), static_cast<int>(i));
+    EXPECT_EQ(rb[2]->Get<types::StringValue>(i), std::string(1, 'a' + i));
+  }
+}
+
 // No time passed to RecordBuilder, so all timestamps should be zero.
 // That means there should never be any expired or carry-over records.
 // Also, nothing should be sorted in any way.
@@ -314,6 +347,44 @@ TEST_F(DataTableTest, Carryover) {
   }
 }
 
+// Records both too old and too recent to push in the same round.
+TEST_F(DataTableTest, ExpiredAndCarryover) {
+  auto append = [this](std::vector<int> time_vals) {
+    for (int t : time_vals) {
+      DataTable::RecordBuilder<&kSchema> r(data_table_.get(), t);
+      r.Append<r.ColIndex("time_")>(t);
+      r.Append<r.ColIndex("x")>(t / 10);
+      r.Append<r.ColIndex("s")>(std::string(1, 'a' + t / 10));
+    }
+  };
+
+  append({10, 20});
+  data_table_->SetConsumeRecordsCutoffTime(20);
+  ASSERT_EQ(data_table_->ConsumeRecords().size(), 1);
+
+  // 0 is expired, 30 and 40 are pushed, 50 and 60 are carried over.
+  append({30, 60, 0, 40, 50});
+  data_table_->SetConsumeRecordsCutoffTime(40);
+  std::vector<TaggedRecordBatch> tablets = data_table_->ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  ASSERT_EQ(tablets[0].records[0]->Size(), 2);
+  EXPECT_EQ(tablets[0].records[0]->Get<types::Time64NSValue>(0), 30);
+  EXPECT_EQ(tablets[0].records[0]->Get<types::Time64NSValue>(1), 40);
+  EXPECT_EQ(data_table_->Occupancy(), 2);
+
+  append({70});
+  data_table_->SetConsumeRecordsCutoffTime(100);
+  tablets = data_table_->ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  types::ColumnWrapperRecordBatch& rb = tablets[0].records;
+  ASSERT_EQ(rb[0]->Size(), 3);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(rb[0]->Get<types::Time64NSValue>(i), 50 + 10 * static_cast<int>(i));
+    EXPECT_EQ(rb[1]->Get<types::Int64Value>(i), 5 + static_cast<int>(i));
+    EXPECT_EQ(rb[2]->Get<types::StringValue>(i), std::string(1, 'f' + i));
+  }
+}
+
 class DataTableStressTest : public ::testing::Test {
  private:
   std::default_random_engine rng_;
@@ -18,13 +18,37 @@
 
 #include "src/stirling/core/frequency_manager.h"
 
+#include <algorithm>
+
+#include "src/common/base/base.h"
+
 namespace px {
 namespace stirling {
 
 void FrequencyManager::Reset() {
-  next_ = px::chrono::coarse_steady_clock::now() + period_;
+  next_ = px::chrono::coarse_steady_clock::now() + period_ * slowdown_;
   ++count_;
 }
 
+void FrequencyManager::Reset(double load) {
+  if (max_period_.count() != 0) {
+    if (load > kHighLoad) {
+      period_ = std::max(min_period_, period_ / 2);
+    } else if (load < kLowLoad) {
+      auto step = std::max(period_ / 4, std::chrono::milliseconds{1});
+      period_ = std::min(max_period_, period_ + step);
+    }
+  }
+  Reset();
+}
+
+void FrequencyManager::EnableAdaptivePeriod(std::chrono::milliseconds min_period,
+                                            std::chrono::milliseconds max_period) {
+  DCHECK_LE(min_period, max_period);
+  min_period_ = min_period;
+  max_period_ = max_period;
+  period_ = std::clamp(period_, min_period_, max_period_);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -20,6 +20,7 @@
 
 #include <chrono>
 
+#include "src/common/base/base.h"
 #include "src/common/system/clock.h"
 
 namespace px {
@@ -40,6 +41,34 @@ class FrequencyManager {
    */
   void Reset();
 
+  /**
+   * Same as Reset(), but with an adaptive period, first adjusts the period to the load of the
+   * cycle that ended: the fraction of the buffering capacity it used. The period is halved when
+   * the load is high, so bursts are drained before they overflow, and slowly lengthened when the
+   * load is low, to avoid wasted wakeups.
+   */
+  void Reset(double load);
+
+  /**
+   * Lets Reset(load) adapt the period between min_period and max_period.
+   */
+  void EnableAdaptivePeriod(std::chrono::milliseconds min_period,
+                            std::chrono::milliseconds max_period);
+
+  // The load above which the period is shortened, and below which it is lengthened.
+  static constexpr double kHighLoad = 0.5;
+  static constexpr double kLowLoad = 0.1;
+
+  /**
+   * Makes the cycles last factor times the period, e.g. while the agent sheds load. The period
+   * itself, and its adaptation, are left alone, so that a factor of 1 restores the cycles.
+   */
+  void set_slowdown(int factor) {
+    DCHECK_GE(factor, 1);
+    slowdown_ = factor;
+  }
+  int slowdown() const { return slowdown_; }
+
   void set_period(std::chrono::milliseconds period) { period_ = period; }
   const auto& period() const { return period_; }
   const auto& next() const { return next_; }
@@ -49,6 +78,13 @@ class FrequencyManager {
   // The cycle's period.
   std::chrono::milliseconds period_ = {};
 
+  // The range of an adaptive period. Both are zero if the period is fixed.
+  std::chrono::milliseconds min_period_ = {};
+  std::chrono::milliseconds max_period_ = {};
+
+  // How many times the period the cycles last.
+  int slowdown_ = 1;
+
   // When the current cycle should end.
   px::chrono::coarse_steady_clock::time_point next_ = {};
 
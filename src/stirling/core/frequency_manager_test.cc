@@ -49,5 +49,53 @@ TEST(FrequencyManagerTest, SetPeriodEndAndCheck) {
   EXPECT_GE(computed_period, std::chrono::milliseconds{9990});
 }
 
+TEST(FrequencyManagerTest, AdaptivePeriod) {
+  FrequencyManager mgr;
+  mgr.set_period(std::chrono::milliseconds{100});
+
+  // A fixed period ignores the load.
+  mgr.Reset(1.0);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{100});
+
+  mgr.EnableAdaptivePeriod(std::chrono::milliseconds{25}, std::chrono::milliseconds{400});
+
+  // High load shortens the period, down to the minimum.
+  mgr.Reset(1.0);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{50});
+  mgr.Reset(1.0);
+  mgr.Reset(1.0);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{25});
+
+  // Moderate load keeps it.
+  mgr.Reset(0.3);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{25});
+
+  // Low load lengthens it, up to the maximum.
+  mgr.Reset(0.0);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{31});
+  for (int i = 0; i < 20; ++i) {
+    mgr.Reset(0.0);
+  }
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{400});
+  EXPECT_FALSE(mgr.Expired());
+}
+
+TEST(FrequencyManagerTest, Slowdown) {
+  FrequencyManager mgr;
+  mgr.set_period(std::chrono::milliseconds{10000});
+  mgr.set_slowdown(4);
+
+  mgr.Reset();
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{10000});
+  auto computed_period = mgr.next() - px::chrono::coarse_steady_clock::now();
+  EXPECT_LE(computed_period, std::chrono::milliseconds{40000});
+  EXPECT_GE(computed_period, std::chrono::milliseconds{39990});
+
+  mgr.set_slowdown(1);
+  mgr.Reset();
+  computed_period = mgr.next() - px::chrono::coarse_steady_clock::now();
+  EXPECT_LE(computed_period, std::chrono::milliseconds{10000});
+}
+
 }  // namespace stirling
 }  // namespace px
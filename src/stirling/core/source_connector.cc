@@ -16,14 +16,24 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <ctime>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <magic_enum.hpp>
 
 #include "src/stirling/core/source_connector.h"
+#include "src/stirling/utils/overhead_stats.h"
+
+DEFINE_bool(stirling_adaptive_scheduling,
+            gflags::BoolFromEnv("PL_STIRLING_ADAPTIVE_SCHEDULING", false),
+            "If true, the sampling period of each source connector adapts to its load, and the "
+            "data of all source connectors is pushed together once any of them is due.");
 
 namespace px {
 namespace stirling {
@@ -40,22 +50,64 @@ Status SourceConnector::Init() {
   DCHECK_NE(sampling_freq_mgr_.period().count(), 0) << "Sampling period has not been initialized";
   DCHECK_NE(push_freq_mgr_.period().count(), 0) << "Push period has not been initialized";
 
+  if (FLAGS_stirling_adaptive_scheduling) {
+    // The configured period is the middle of the range the sampling period can adapt in.
+    constexpr int kAdaptivePeriodRange = 4;
+    const auto period = sampling_freq_mgr_.period();
+    sampling_freq_mgr_.EnableAdaptivePeriod(period / kAdaptivePeriodRange,
+                                            period * kAdaptivePeriodRange);
+  }
+
   return s;
 }
 
 void SourceConnector::InitContext(ConnectorContext* ctx) { InitContextImpl(ctx); }
 
+void SourceConnector::SetLoadShedLevel(int level) {
+  DCHECK_GE(level, 0);
+  DCHECK_LE(level, kMaxLoadShedLevel);
+  sampling_freq_mgr_.set_slowdown(1 << level);
+  push_freq_mgr_.set_slowdown(1 << level);
+}
+
+metrics::Histogram* SourceConnector::TransferDataLatencyHistogram(std::string_view source_name) {
+  // 100us to ~3s.
+  static const std::vector<int64_t> kBucketsUs = metrics::ExponentialBuckets(100, 2, 16);
+  return metrics::MetricsRegistry::Global()->GetHistogram(
+      "stirling_transfer_data_latency_us",
+      "Latency of one TransferData() iteration of a source connector, in microseconds.",
+      kBucketsUs, {{"source", std::string(source_name)}});
+}
+
 void SourceConnector::TransferData(ConnectorContext* ctx,
                                    const std::vector<DataTable*>& data_tables) {
   DCHECK(ctx != nullptr);
   DCHECK_EQ(data_tables.size(), table_schemas().size())
       << "DataTable objects must all be specified.";
-  TransferDataImpl(ctx, data_tables);
-  sampling_freq_mgr_.Reset();
+  {
+    const auto start = std::chrono::steady_clock::now();
+    utils::ScopedOverheadTimer timer(utils::OverheadStat::Kind::kTransferData, name());
+    TransferDataImpl(ctx, data_tables);
+    transfer_data_latency_us_->Observe(std::chrono::duration_cast<std::chrono::microseconds>(
+                                           std::chrono::steady_clock::now() - start)
+                                           .count());
+  }
+  sampling_freq_mgr_.Reset(SamplingLoad(data_tables));
+}
+
+double SourceConnector::SamplingLoad(const std::vector<DataTable*>& data_tables) {
+  double load = 0;
+  for (const auto* data_table : data_tables) {
+    if (data_table != nullptr) {
+      load = std::max(load, data_table->OccupancyPct());
+    }
+  }
+  return load;
 }
 
 void SourceConnector::PushData(DataPushCallback agent_callback,
                                const std::vector<DataTable*>& data_tables) {
+  utils::ScopedOverheadTimer timer(utils::OverheadStat::Kind::kPushData, name());
   for (auto* data_table : data_tables) {
     auto record_batches = data_table->ConsumeRecords();
     for (auto& record_batch : record_batches) {
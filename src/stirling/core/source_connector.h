@@ -21,13 +21,18 @@
 #include <string>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
 #include "src/common/system/system.h"
 #include "src/shared/types/types.h"
 #include "src/stirling/core/connector_context.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/frequency_manager.h"
 
+DECLARE_bool(stirling_adaptive_scheduling);
+
 /**
  * These are the steps to follow to add a new data source connector.
  * 1. If required, create a new SourceConnector class.
@@ -107,13 +112,31 @@ class SourceConnector : public NotCopyable {
   virtual void EnablePIDTrace(int pid) { pids_to_trace_.insert(pid); }
   virtual void DisablePIDTrace(int pid) { pids_to_trace_.erase(pid); }
 
+  /**
+   * Sets the tables that the agent queries or retains, by name. Connectors that can collect less
+   * for the other tables override this; the default collects all the subscribed tables regardless.
+   */
+  virtual void SetTableDemand(const absl::flat_hash_set<std::string>& /* table_names */) {}
+
+  // The highest load shed level, see SetLoadShedLevel().
+  static constexpr int kMaxLoadShedLevel = 3;
+
+  /**
+   * Sets how much collection to shed to save CPU, from 0 (none) to kMaxLoadShedLevel. By default,
+   * the sampling and push cycles last 2^level times their period. Connectors that can also collect
+   * less per cycle override this, and call it too.
+   */
+  virtual void SetLoadShedLevel(int level);
+
   const FrequencyManager& sampling_freq_mgr() const { return sampling_freq_mgr_; }
   const FrequencyManager& push_freq_mgr() const { return push_freq_mgr_; }
 
  protected:
   explicit SourceConnector(std::string_view source_name,
                            const ArrayView<DataTableSchema>& table_schemas)
-      : source_name_(source_name), table_schemas_(table_schemas) {}
+      : source_name_(source_name),
+        table_schemas_(table_schemas),
+        transfer_data_latency_us_(TransferDataLatencyHistogram(source_name)) {}
 
   virtual Status InitImpl() = 0;
 
@@ -125,6 +148,11 @@ class SourceConnector : public NotCopyable {
 
   virtual Status StopImpl() = 0;
 
+  // The load of the last TransferData(), for an adaptive sampling period: the fraction of its
+  // buffering capacity that it used. Defaults to the occupancy of the fullest data table.
+  // Connectors with buffers of their own (eg. perf buffers) can account for them too.
+  virtual double SamplingLoad(const std::vector<DataTable*>& data_tables);
+
  protected:
   /**
    * Track state of connector. A connector's lifetime typically progresses sequentially
@@ -149,8 +177,13 @@ class SourceConnector : public NotCopyable {
  private:
   std::atomic<State> state_ = State::kUninitialized;
 
+  static metrics::Histogram* TransferDataLatencyHistogram(std::string_view source_name);
+
   const std::string source_name_;
   const ArrayView<DataTableSchema> table_schemas_;
+
+  // Latency of TransferData(), exported on /metrics.
+  metrics::Histogram* const transfer_data_latency_us_;
 };
 
 }  // namespace stirling
@@ -319,6 +319,42 @@ TEST_F(StirlingTest, hammer_time_on_stirling_on_the_fly_subs) {
   EXPECT_GT(NumProcessed(), 0);
 }
 
+// Runs the second source on its own thread.
+class StirlingSourceThreadsTest : public StirlingTest {
+ protected:
+  void SetUp() override {
+    FLAGS_stirling_source_thread_groups = "sequences1";
+    StirlingTest::SetUp();
+  }
+
+  void TearDown() override {
+    StirlingTest::TearDown();
+    FLAGS_stirling_source_thread_groups = "";
+  }
+};
+
+TEST_F(StirlingSourceThreadsTest, hammer_time_on_source_threads) {
+  ASSERT_OK(stirling_->RunAsThread());
+  ASSERT_OK(stirling_->WaitUntilRunning(std::chrono::seconds(5)));
+
+  uint32_t i = 0;
+  while (NumProcessed() < kNumProcessedRequirement || i < kNumIterMin) {
+    std::this_thread::sleep_for(kDurationPerIter);
+
+    i++;
+    if (i > kNumIterMax) {
+      break;
+    }
+  }
+
+  stirling_->Stop();
+
+  // Both sources pushed their data, from their own threads.
+  for (const auto& [table_id, num_processed] : num_processed_per_table_) {
+    EXPECT_GT(num_processed, 0) << table_id;
+  }
+}
+
 TEST_F(StirlingTest, no_data_callback_defined) {
   stirling_->RegisterDataPushCallback(nullptr);
 
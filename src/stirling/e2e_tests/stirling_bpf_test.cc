@@ -80,6 +80,7 @@ TEST_F(StirlingBPFTest, CleanupTest) {
 
   EXPECT_EQ(SocketTraceConnector::num_attached_probes(), 0);
   EXPECT_EQ(SocketTraceConnector::num_open_perf_buffers(), 0);
+  EXPECT_EQ(SocketTraceConnector::num_open_ring_buffers(), 0);
 }
 
 }  // namespace stirling
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/build_id.h"
+
+#include <elf.h>
+
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include <absl/strings/escaping.h>
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+namespace {
+
+// The owner and type of the Go build ID note. See cmd/internal/buildid in the Go sources.
+constexpr std::string_view kGoNoteName = "Go";
+constexpr uint32_t kGoBuildIDNoteType = 4;
+constexpr std::string_view kGNUNoteName = "GNU";
+
+constexpr size_t Align4(size_t n) { return (n + 3) & ~static_cast<size_t>(3); }
+
+Status ReadAt(std::ifstream* file, uint64_t offset, size_t size, void* out) {
+  file->seekg(offset);
+  file->read(static_cast<char*>(out), size);
+  if (!file->good()) {
+    return error::Internal("Failed to read $0 bytes at offset $1.", size, offset);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+StatusOr<std::string> ReadBuildID(const std::string& binary_path) {
+  std::ifstream file(binary_path, std::ios::binary);
+  if (!file.is_open()) {
+    return error::Internal("Failed to open $0.", binary_path);
+  }
+
+  Elf64_Ehdr ehdr;
+  PL_RETURN_IF_ERROR(ReadAt(&file, 0, sizeof(ehdr), &ehdr));
+  if (std::string_view(reinterpret_cast<const char*>(ehdr.e_ident), SELFMAG) != ELFMAG) {
+    return error::InvalidArgument("$0 is not an ELF binary.", binary_path);
+  }
+  if (ehdr.e_ident[EI_CLASS] != ELFCLASS64 || ehdr.e_ident[EI_DATA] != ELFDATA2LSB) {
+    return error::Unimplemented("Only 64-bit little-endian ELF binaries are supported.");
+  }
+  if (ehdr.e_shentsize != sizeof(Elf64_Shdr)) {
+    return error::InvalidArgument("Unexpected section header size $0.", ehdr.e_shentsize);
+  }
+
+  std::vector<Elf64_Shdr> shdrs(ehdr.e_shnum);
+  PL_RETURN_IF_ERROR(
+      ReadAt(&file, ehdr.e_shoff, shdrs.size() * sizeof(Elf64_Shdr), shdrs.data()));
+
+  std::string go_build_id;
+  for (const auto& shdr : shdrs) {
+    if (shdr.sh_type != SHT_NOTE) {
+      continue;
+    }
+    std::string notes(shdr.sh_size, '\0');
+    PL_RETURN_IF_ERROR(ReadAt(&file, shdr.sh_offset, notes.size(), notes.data()));
+
+    // A note section holds a sequence of notes: a header, followed by the name and the
+    // description, each padded to 4 bytes.
+    size_t pos = 0;
+    while (pos + sizeof(Elf64_Nhdr) <= notes.size()) {
+      Elf64_Nhdr nhdr;
+      memcpy(&nhdr, notes.data() + pos, sizeof(nhdr));
+      size_t name_pos = pos + sizeof(nhdr);
+      size_t desc_pos = name_pos + Align4(nhdr.n_namesz);
+      if (desc_pos + nhdr.n_descsz > notes.size()) {
+        break;
+      }
+      // The name is null-terminated, and Go pads it with more nulls ("Go\0\0").
+      std::string_view name(notes.data() + name_pos, nhdr.n_namesz);
+      name = name.substr(0, name.find('\0'));
+      std::string_view desc(notes.data() + desc_pos, nhdr.n_descsz);
+
+      if (name == kGNUNoteName && nhdr.n_type == NT_GNU_BUILD_ID) {
+        return absl::BytesToHexString(desc);
+      }
+      if (name == kGoNoteName && nhdr.n_type == kGoBuildIDNoteType) {
+        go_build_id = absl::StrCat("go:", desc);
+      }
+      pos = desc_pos + Align4(nhdr.n_descsz);
+    }
+  }
+
+  if (!go_build_id.empty()) {
+    return go_build_id;
+  }
+  return error::NotFound("$0 has no build-id.", binary_path);
+}
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
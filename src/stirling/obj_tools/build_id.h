@@ -0,0 +1,44 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+/**
+ * Returns the build-id of the ELF binary, which identifies the contents of the binary.
+ *
+ * Only the ELF header, the section headers and the notes are read, so this is cheap even for
+ * large binaries, unlike ElfReader which loads all the sections.
+ *
+ * The GNU build-id (.note.gnu.build-id) is returned as lowercase hex. Go binaries without one
+ * return their Go build ID (.note.go.buildid) as is, prefixed with "go:".
+ *
+ * @return The build-id, or NotFound if the binary has neither note.
+ */
+StatusOr<std::string> ReadBuildID(const std::string& binary_path);
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/build_id.h"
+
+#include "src/common/testing/test_environment.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+TEST(ReadBuildIDTest, GNUBuildID) {
+  const std::string kPath =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/stripped_dummy_exe");
+  EXPECT_OK_AND_EQ(ReadBuildID(kPath), "7deb0e3f89deba61");
+}
+
+TEST(ReadBuildIDTest, GoBuildID) {
+  const std::string kPath =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/sockshop_payments_service");
+  EXPECT_OK_AND_EQ(ReadBuildID(kPath), "go:814e3d13eb0fc7900f7b3e6e4bd2fc27536fd9f2");
+}
+
+TEST(ReadBuildIDTest, NoBuildID) {
+  const std::string kPath =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/prebuilt_dummy_exe");
+  EXPECT_NOT_OK(ReadBuildID(kPath));
+}
+
+TEST(ReadBuildIDTest, NonExistentPath) { EXPECT_NOT_OK(ReadBuildID("/bogus")); }
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
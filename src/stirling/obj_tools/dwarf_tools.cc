@@ -104,8 +104,11 @@ StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::Create(std::string_view obj_
 
   std::error_code ec;
 
+  // Not requiring a null terminator lets LLVM mmap the file instead of reading it into a heap
+  // buffer, so the (often large) debug sections are paged in only as the DIEs are visited.
   llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> buff_or_err =
-      MemoryBuffer::getFileOrSTDIN(std::string(obj_filename));
+      MemoryBuffer::getFile(std::string(obj_filename), /* FileSize */ -1,
+                            /* RequiresNullTerminator */ false);
   ec = buff_or_err.getError();
   if (ec) {
     return error::Internal("DwarfReader $0: $1", ec.message(), obj_filename);
@@ -129,9 +132,9 @@ StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::Create(std::string_view obj_
 
   PL_RETURN_IF_ERROR(dwarf_reader->DetectSourceLanguage());
 
-  if (index) {
-    dwarf_reader->IndexDIEs();
-  }
+  // The index is built on the first lookup that can use it, so readers that are created but
+  // never queried don't pay for the pass over all the DIEs.
+  dwarf_reader->index_pending_ = index;
 
   return dwarf_reader;
 }
@@ -182,6 +185,37 @@ Status DwarfReader::GetMatchingDIEs(DWARFContext::unit_iterator_range CUs, std::
   return Status::OK();
 }
 
+bool DwarfReader::GetMatchingDIEsFromAccelTable(std::string_view name,
+                                                std::optional<llvm::dwarf::Tag> tag,
+                                                std::vector<DWARFDie>* dies_out) {
+  const llvm::DWARFDebugNames& debug_names = dwarf_context_->getDebugNames();
+  if (debug_names.begin() == debug_names.end()) {
+    return false;
+  }
+
+  for (const llvm::DWARFDebugNames::Entry& entry :
+       debug_names.equal_range(llvm::StringRef(name.data(), name.size()))) {
+    if (tag.has_value() && entry.tag() != tag.value()) {
+      continue;
+    }
+    llvm::Optional<uint64_t> cu_offset = entry.getCUOffset();
+    llvm::Optional<uint64_t> die_offset = entry.getDIEUnitOffset();
+    if (!cu_offset.hasValue() || !die_offset.hasValue()) {
+      continue;
+    }
+    llvm::DWARFCompileUnit* CU = dwarf_context_->getCompileUnitForOffset(cu_offset.getValue());
+    if (CU == nullptr) {
+      continue;
+    }
+    DWARFDie die = CU->getDIEForOffset(cu_offset.getValue() + die_offset.getValue());
+    if (die.isValid() && IsMatchingDIE(name, tag, die)) {
+      dies_out->push_back(std::move(die));
+    }
+  }
+
+  return true;
+}
+
 namespace {
 
 bool IsIndexedType(llvm::dwarf::Tag tag) {
@@ -307,6 +341,10 @@ StatusOr<std::vector<DWARFDie>> DwarfReader::GetMatchingDIEs(std::string_view na
   std::vector<DWARFDie> dies;
 
   // Special case for types that are indexed.
+  if (index_pending_ && type.has_value() && IsIndexedType(type.value())) {
+    IndexDIEs();
+    index_pending_ = false;
+  }
   if (type.has_value() && !die_map_.empty()) {
     llvm::dwarf::Tag tag = type.value();
     if (IsIndexedType(tag)) {
@@ -321,7 +359,11 @@ StatusOr<std::vector<DWARFDie>> DwarfReader::GetMatchingDIEs(std::string_view na
     }
   }
 
-  // When there is no index, fall-back to manual search.
+  // When there is no index, use the name index the compiler emitted (.debug_names), if any.
+  // Otherwise fall-back to manual search.
+  if (GetMatchingDIEsFromAccelTable(name, type, &dies)) {
+    return dies;
+  }
   PL_RETURN_IF_ERROR(GetMatchingDIEs(dwarf_context_->normal_units(), name, type, &dies));
 
   return dies;
@@ -168,7 +168,9 @@ class DwarfReader {
   /**
    * Creates a DwarfReader that provides access to DWARF Debugging information entries (DIEs).
    * @param obj_filename The object file from which to read DWARF information.
+   * The object file is memory mapped rather than copied into memory.
    * @param index If true, creates an index to speed up accesses when called more than once.
+   *              The index is built on the first lookup of an indexed DIE type.
    * @return error if file does not exist or is not a valid object file. Otherwise returns
    * a unique pointer to a DwarfReader.
    */
@@ -304,6 +306,12 @@ class DwarfReader {
                                 std::optional<llvm::dwarf::Tag> tag,
                                 std::vector<llvm::DWARFDie>* dies_out);
 
+  // Searches the .debug_names accelerator table for DIEs that match the name.
+  // Returns false if the object file has no such table, in which case the caller must fall back
+  // to walking all the DIEs.
+  bool GetMatchingDIEsFromAccelTable(std::string_view name, std::optional<llvm::dwarf::Tag> tag,
+                                     std::vector<llvm::DWARFDie>* dies_out);
+
   // Walks the struct_die for all members, recursively visiting any members which are also structs,
   // to capture information of all base type members of the struct in a flattened form.
   // See GetStructSpec() for the public interface, and the output format.
@@ -316,6 +324,9 @@ class DwarfReader {
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer_;
   std::unique_ptr<llvm::DWARFContext> dwarf_context_;
 
+  // True if an index was requested, but has not been built yet.
+  bool index_pending_ = false;
+
   // Nested map: [tag][symbol_name] -> DWARFDie
   absl::flat_hash_map<llvm::dwarf::Tag, absl::flat_hash_map<std::string, llvm::DWARFDie>> die_map_;
 };
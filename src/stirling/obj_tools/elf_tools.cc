@@ -23,6 +23,9 @@
 #include <llvm/Support/TargetSelect.h>
 
 #include <absl/container/flat_hash_set.h>
+#include <algorithm>
+#include <numeric>
+#include <regex>
 #include <set>
 #include <utility>
 
@@ -64,7 +67,10 @@ Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir
     // For more details: https://sourceware.org/gdb/onlinedocs/gdb/Separate-Debug-Files.html
 
     // Method 1: build-id.
-    if (psec->get_name() == ".note.gnu.build-id") {
+    // Go binaries have the same kind of note for the Go build ID, which only identifies the
+    // binary and isn't used to find debug symbols.
+    bool is_gnu_build_id = psec->get_name() == ".note.gnu.build-id";
+    if (is_gnu_build_id || psec->get_name() == ".note.go.buildid") {
       // Structure of this section:
       //    namesz :   32-bit, size of "name" field
       //    descsz :   32-bit, size of "desc" field
@@ -79,8 +85,13 @@ Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir
       int32_t desc_pos = 3 * sizeof(int32_t) + name_size;
       std::string_view desc = std::string_view(psec->get_data() + desc_pos, desc_size);
 
-      build_id = BytesToString<LowercaseHex>(desc);
-      VLOG(1) << absl::Substitute("Found build-id: $0", build_id);
+      if (is_gnu_build_id) {
+        build_id = BytesToString<LowercaseHex>(desc);
+        build_id_ = build_id;
+        VLOG(1) << absl::Substitute("Found build-id: $0", build_id);
+      } else if (build_id_.empty()) {
+        build_id_ = BytesToString<LowercaseHex>(desc);
+      }
     }
 
     // Method 2: .gnu_debuglink.
@@ -170,6 +181,14 @@ StatusOr<std::unique_ptr<ElfReader>> ElfReader::Create(
     return error::Internal("Can't find or process ELF file $0", binary_path);
   }
 
+  for (int i = 0; i < elf_reader->elf_reader_.sections.size(); ++i) {
+    ELFIO::section* psec = elf_reader->elf_reader_.sections[i];
+    if (psec->get_name() == ".text") {
+      elf_reader->text_addr_offset_delta_ = psec->get_address() - psec->get_offset();
+      break;
+    }
+  }
+
   // Check for external debug symbols.
   Status s = elf_reader->LocateDebugSymbols(debug_file_dir);
   if (s.ok()) {
@@ -213,15 +232,18 @@ StatusOr<ELFIO::section*> ElfReader::SymtabSection() {
   return symtab_section;
 }
 
-StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
-    std::string_view search_symbol, SymbolMatchType match_type, std::optional<int> symbol_type) {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
+Status ElfReader::LoadSymbols() {
+  if (symbols_loaded_) {
+    return Status::OK();
+  }
 
-  std::vector<SymbolInfo> symbol_infos;
+  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
 
-  // Scan all symbols inside the symbol table.
+  // Read all symbols of the symbol table once.
   const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-  for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
+  const unsigned int num_symbols = symbols.get_symbols_num();
+  symbols_.reserve(num_symbols);
+  for (unsigned int j = 0; j < num_symbols; ++j) {
     std::string name;
     ELFIO::Elf64_Addr addr = 0;
     ELFIO::Elf_Xword size = 0;
@@ -230,31 +252,98 @@ StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
     ELFIO::Elf_Half section_index;
     unsigned char other;
     symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
+    symbols_.push_back({std::move(name), type, addr, size});
+  }
 
-    if (symbol_type.has_value() && type != symbol_type.value()) {
-      continue;
-    }
+  // Both indexes are stable sorted, so that symbols with the same key keep their table order.
+  symbols_by_name_.resize(symbols_.size());
+  std::iota(symbols_by_name_.begin(), symbols_by_name_.end(), 0);
+  std::stable_sort(symbols_by_name_.begin(), symbols_by_name_.end(),
+                   [this](uint32_t a, uint32_t b) { return symbols_[a].name < symbols_[b].name; });
+
+  symbols_by_addr_.resize(symbols_.size());
+  std::iota(symbols_by_addr_.begin(), symbols_by_addr_.end(), 0);
+  std::stable_sort(
+      symbols_by_addr_.begin(), symbols_by_addr_.end(),
+      [this](uint32_t a, uint32_t b) { return symbols_[a].address < symbols_[b].address; });
+
+  max_end_by_addr_.resize(symbols_by_addr_.size());
+  uint64_t max_end = 0;
+  for (size_t i = 0; i < symbols_by_addr_.size(); ++i) {
+    const SymbolInfo& symbol = symbols_[symbols_by_addr_[i]];
+    max_end = std::max(max_end, symbol.address + symbol.size);
+    max_end_by_addr_[i] = max_end;
+  }
+
+  symbols_loaded_ = true;
+  return Status::OK();
+}
 
-    // Check for symbol match.
-    bool match = false;
-    switch (match_type) {
-      case SymbolMatchType::kExact:
-        match = (name == search_symbol);
-        break;
-      case SymbolMatchType::kPrefix:
-        match = absl::StartsWith(name, search_symbol);
-        break;
-      case SymbolMatchType::kSuffix:
-        match = absl::EndsWith(name, search_symbol);
-        break;
-      case SymbolMatchType::kSubstr:
-        match = (name.find(search_symbol) != std::string::npos);
-        break;
+StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
+    std::string_view search_symbol, SymbolMatchType match_type, std::optional<int> symbol_type) {
+  PL_RETURN_IF_ERROR(LoadSymbols());
+
+  // Indexes into symbols_ of the matching symbols.
+  std::vector<uint32_t> matches;
+
+  switch (match_type) {
+    case SymbolMatchType::kExact:
+    case SymbolMatchType::kPrefix: {
+      // Symbols that start with the search string are contiguous in the name index, starting
+      // with the exact matches.
+      auto iter = std::lower_bound(
+          symbols_by_name_.begin(), symbols_by_name_.end(), search_symbol,
+          [this](uint32_t idx, std::string_view s) { return symbols_[idx].name < s; });
+      for (; iter != symbols_by_name_.end(); ++iter) {
+        const std::string& name = symbols_[*iter].name;
+        bool match = (match_type == SymbolMatchType::kExact)
+                         ? (name == search_symbol)
+                         : absl::StartsWith(name, search_symbol);
+        if (!match) {
+          break;
+        }
+        matches.push_back(*iter);
+      }
+      // Return the symbols in table order, like the other match types.
+      std::sort(matches.begin(), matches.end());
+      break;
     }
-    if (!match) {
+    case SymbolMatchType::kSuffix:
+    case SymbolMatchType::kSubstr:
+    case SymbolMatchType::kRegex: {
+      std::optional<std::regex> regex;
+      if (match_type == SymbolMatchType::kRegex) {
+        try {
+          regex.emplace(search_symbol.data(), search_symbol.size());
+        } catch (const std::regex_error& e) {
+          return error::InvalidArgument("Invalid symbol regex '$0': $1", search_symbol, e.what());
+        }
+      }
+      for (uint32_t j = 0; j < symbols_.size(); ++j) {
+        const std::string& name = symbols_[j].name;
+        bool match = false;
+        if (match_type == SymbolMatchType::kSuffix) {
+          match = absl::EndsWith(name, search_symbol);
+        } else if (match_type == SymbolMatchType::kSubstr) {
+          match = (name.find(search_symbol) != std::string::npos);
+        } else {
+          match = std::regex_match(name, regex.value());
+        }
+        if (match) {
+          matches.push_back(j);
+        }
+      }
+      break;
+    }
+  }
+
+  std::vector<SymbolInfo> symbol_infos;
+  for (uint32_t idx : matches) {
+    const SymbolInfo& symbol = symbols_[idx];
+    if (symbol_type.has_value() && symbol.type != symbol_type.value()) {
       continue;
     }
-    symbol_infos.push_back({std::move(name), type, addr, size});
+    symbol_infos.push_back(symbol);
   }
   return symbol_infos;
 }
@@ -293,50 +382,33 @@ std::optional<int64_t> ElfReader::SymbolAddress(std::string_view symbol) {
 }
 
 StatusOr<std::string> ElfReader::AddrToSymbol(size_t sym_addr) {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
+  PL_RETURN_IF_ERROR(LoadSymbols());
 
-  const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-
-  // Call ELFIO to get symbol by address.
-  // ELFIO looks up the symbol and then populates name, size, type, etc.
-  // We only care about the name, but need to declare the other variables as well.
-  const ELFIO::Elf64_Addr addr = sym_addr;
-  std::string name;
-  ELFIO::Elf_Xword size = 0;
-  unsigned char bind = 0;
-  unsigned char type = ELFIO::STT_NOTYPE;
-  ELFIO::Elf_Half section_index;
-  unsigned char other;
-  bool found = symbols.get_symbol(addr, name, size, bind, type, section_index, other);
-
-  if (!found) {
+  // The first symbol, in table order, located exactly at the address.
+  auto iter = std::lower_bound(
+      symbols_by_addr_.begin(), symbols_by_addr_.end(), sym_addr,
+      [this](uint32_t idx, uint64_t addr) { return symbols_[idx].address < addr; });
+  if (iter == symbols_by_addr_.end() || symbols_[*iter].address != sym_addr) {
     return error::NotFound("Could not resolve address $0", sym_addr);
   }
 
-  return name;
+  return symbols_[*iter].name;
 }
 
-// TODO(oazizi): Optimize by indexing or switching to binary search if we can guarantee addresses
-//               are ordered.
 StatusOr<std::string> ElfReader::InstrAddrToSymbol(size_t sym_addr) {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
-
-  const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-  for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
-    // Call ELFIO to get symbol by index.
-    // ELFIO looks up the index and then populates name, addr, size, type, etc.
-    // We only care about the name and addr, but need to declare the other variables as well.
-    std::string name;
-    ELFIO::Elf64_Addr addr = 0;
-    ELFIO::Elf_Xword size = 0;
-    unsigned char bind = 0;
-    unsigned char type = ELFIO::STT_NOTYPE;
-    ELFIO::Elf_Half section_index;
-    unsigned char other;
-    symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
-
-    if (sym_addr >= addr && sym_addr < addr + size) {
-      return name;
+  PL_RETURN_IF_ERROR(LoadSymbols());
+
+  // Walk back from the last symbol that starts at or before the address, to the closest one
+  // whose body covers it. No symbol before position i covers the address once
+  // max_end_by_addr_[i] is not past it, which bounds the walk.
+  auto iter = std::upper_bound(
+      symbols_by_addr_.begin(), symbols_by_addr_.end(), sym_addr,
+      [this](uint64_t addr, uint32_t idx) { return addr < symbols_[idx].address; });
+  for (size_t i = iter - symbols_by_addr_.begin(); i > 0 && max_end_by_addr_[i - 1] > sym_addr;
+       --i) {
+    const SymbolInfo& symbol = symbols_[symbols_by_addr_[i - 1]];
+    if (sym_addr < symbol.address + symbol.size) {
+      return symbol.name;
     }
   }
 
@@ -394,7 +466,9 @@ std::vector<uint64_t> FindRetInsts(utils::u8string_view byte_code) {
 
   // TODO(yzhao): This is a short-term quick way to avoid unnecessary overheads.
   // We should create LLVMDisasmContext object inside SocketTraceConnector and pass it around.
-  static const LLVMDisasmContext kLLVMDisasmContext;
+  // One per thread, because UProbeManager analyzes binaries on several threads, and a
+  // disassembler context cannot be shared between them.
+  static thread_local const LLVMDisasmContext kLLVMDisasmContext;
 
   // Size of the buffer to hold disassembled assembly code. Since we do not really use the assembly
   // code, we just provide a small buffer.
@@ -428,6 +502,13 @@ std::vector<uint64_t> FindRetInsts(utils::u8string_view byte_code) {
 
 }  // namespace
 
+StatusOr<uint64_t> ElfReader::FileOffsetToVirtualAddr(uint64_t file_offset) const {
+  if (!text_addr_offset_delta_.has_value()) {
+    return error::NotFound("Could not find the .text section in binary=$0", binary_path_);
+  }
+  return file_offset + text_addr_offset_delta_.value();
+}
+
 StatusOr<std::vector<uint64_t>> ElfReader::FuncRetInstAddrs(const SymbolInfo& func_symbol) {
   PL_ASSIGN_OR_RETURN(utils::u8string byte_code, FuncByteCode(func_symbol));
   std::vector<uint64_t> addrs = FindRetInsts(byte_code);
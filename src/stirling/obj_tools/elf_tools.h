@@ -44,7 +44,10 @@ enum class SymbolMatchType {
   kSuffix,
 
   // Search for a symbol that contains the search string.
-  kSubstr
+  kSubstr,
+
+  // Search for a symbol that matches the search string as an ECMAScript regex.
+  kRegex
 };
 
 class ElfReader {
@@ -62,6 +65,12 @@ class ElfReader {
 
   std::filesystem::path& debug_symbols_path() { return debug_symbols_path_; }
 
+  /**
+   * Returns the GNU build-id of the binary, as a hex string. Go binaries without one use their Go
+   * build ID instead. Empty if the binary has neither.
+   */
+  const std::string& build_id() const { return build_id_; }
+
   struct SymbolInfo {
     std::string name;
     int type = -1;
@@ -70,7 +79,9 @@ class ElfReader {
   };
 
   /**
-   * Returns a list of symbol names that meets the search criteria.
+   * Returns a list of symbol names that meets the search criteria, in symbol table order.
+   * The symbol table is read and indexed on the first lookup, so exact and prefix searches
+   * are binary searches.
    *
    * @param search_symbol The symbol to search for.
    * @param match_type Type of search (e.g. exact match, substring, suffix).
@@ -117,6 +128,16 @@ class ElfReader {
    */
   StatusOr<std::string> InstrAddrToSymbol(size_t addr);
 
+  /**
+   * Converts an offset in the binary file to the virtual address it is loaded at, which is what
+   * the symbol table uses. A runtime address of a process, in a mapping that starts at vmem_start
+   * with file_offset (see /proc/<pid>/maps), is resolved with:
+   *   AddrToSymbol(FileOffsetToVirtualAddr(addr - vmem_start + file_offset))
+   *
+   * Assumes that the offset is in the same segment as the .text section.
+   */
+  StatusOr<uint64_t> FileOffsetToVirtualAddr(uint64_t file_offset) const;
+
   /**
    * Returns the address of the return instructions of the function.
    */
@@ -127,6 +148,11 @@ class ElfReader {
 
   StatusOr<ELFIO::section*> SymtabSection();
 
+  /**
+   * Reads the symbol table and builds the name and address indexes, on the first call only.
+   */
+  Status LoadSymbols();
+
   /**
    * Locates the debug symbols for the currently loaded ELF object.
    * External symbols are discovered using either the build-id or the debug-link.
@@ -145,8 +171,25 @@ class ElfReader {
 
   std::filesystem::path debug_symbols_path_;
 
+  std::string build_id_;
+
   // Set up an elf reader, so we can extract debug symbols.
   ELFIO::elfio elf_reader_;
+
+  // The virtual address minus the file offset of the .text section of the binary.
+  // Read from the binary itself, since sections of external debug files hold no data.
+  std::optional<int64_t> text_addr_offset_delta_;
+
+  // The symbols of the symtab (or dynsym) section, in table order. See LoadSymbols().
+  bool symbols_loaded_ = false;
+  std::vector<SymbolInfo> symbols_;
+
+  // Indexes into symbols_, sorted by name and by address.
+  std::vector<uint32_t> symbols_by_name_;
+  std::vector<uint32_t> symbols_by_addr_;
+
+  // The largest end address (address + size) of symbols_by_addr_[0..i], for InstrAddrToSymbol().
+  std::vector<uint64_t> max_end_by_addr_;
 };
 
 struct IntfImplTypeInfo {
@@ -110,6 +110,16 @@ TEST(ElfReaderTest, ListSymbolsSuffixMatch) {
                      ElementsAre(SymbolNameIs("CanYouFindThis")));
 }
 
+TEST(ElfReaderTest, ListSymbolsRegexMatch) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader,
+                       ElfReader::Create(kDummyExeFixture.Path()));
+
+  EXPECT_OK_AND_THAT(elf_reader->ListFuncSymbols("CanYou.*This", SymbolMatchType::kRegex),
+                     ElementsAre(SymbolNameIs("CanYouFindThis")));
+  EXPECT_OK_AND_THAT(elf_reader->ListFuncSymbols("CanYou", SymbolMatchType::kRegex), IsEmpty());
+  EXPECT_NOT_OK(elf_reader->ListFuncSymbols("CanYou(", SymbolMatchType::kRegex));
+}
+
 TEST(ElfReaderTest, SymbolAddress) {
   const std::string path = kDummyExeFixture.Path().string();
   const std::string kSymbolName = "CanYouFindThis";
@@ -56,27 +56,35 @@ void CPUStatBPFTraceConnector::TransferDataImpl(ConnectorContext* /* ctx */,
     return;
   }
 
-  auto cpustat_map = GetBPFMap("@retval");
+  StatusOr<size_t> num_entries =
+      DrainBPFMap("@retval", [this](std::string_view key, std::string_view value) {
+        auto idx = utils::MemCpy<uint64_t>(key);
+        if (idx >= retval_.size()) {
+          return;
+        }
+        retval_[idx] = utils::MemCpy<int64_t>(value);
+        retval_seen_.set(idx);
+      });
+  if (!num_entries.ok()) {
+    LOG(ERROR) << absl::Substitute("Failed to drain @retval: $0", num_entries.msg());
+    return;
+  }
 
   // If kernel hasn't populated BPF map yet, then we have no data to return.
-  constexpr size_t kElementsSize = sizeof(kElements) / sizeof(kElements[0]);
-  if (cpustat_map.size() != kElementsSize) {
+  if (!retval_seen_.all()) {
     return;
   }
+  retval_seen_.reset();
 
   DataTable::RecordBuilder<&kTable> r(data_table);
-  r.Append<r.ColIndex("time_")>(*(reinterpret_cast<int64_t*>(cpustat_map[0].second.data())) +
-                                ClockRealTimeOffset());
-  r.Append<r.ColIndex("cpustat_user")>(*(reinterpret_cast<int64_t*>(cpustat_map[1].second.data())));
-  r.Append<r.ColIndex("cpustat_nice")>(*(reinterpret_cast<int64_t*>(cpustat_map[2].second.data())));
-  r.Append<r.ColIndex("cpustat_system")>(
-      *(reinterpret_cast<int64_t*>(cpustat_map[3].second.data())));
-  r.Append<r.ColIndex("cpustat_idle")>(*(reinterpret_cast<int64_t*>(cpustat_map[4].second.data())));
-  r.Append<r.ColIndex("cpustat_iowait")>(
-      *(reinterpret_cast<int64_t*>(cpustat_map[5].second.data())));
-  r.Append<r.ColIndex("cpustat_irq")>(*(reinterpret_cast<int64_t*>(cpustat_map[6].second.data())));
-  r.Append<r.ColIndex("cpustat_softirq")>(
-      *(reinterpret_cast<int64_t*>(cpustat_map[7].second.data())));
+  r.Append<r.ColIndex("time_")>(retval_[0] + ClockRealTimeOffset());
+  r.Append<r.ColIndex("cpustat_user")>(retval_[1]);
+  r.Append<r.ColIndex("cpustat_nice")>(retval_[2]);
+  r.Append<r.ColIndex("cpustat_system")>(retval_[3]);
+  r.Append<r.ColIndex("cpustat_idle")>(retval_[4]);
+  r.Append<r.ColIndex("cpustat_iowait")>(retval_[5]);
+  r.Append<r.ColIndex("cpustat_irq")>(retval_[6]);
+  r.Append<r.ColIndex("cpustat_softirq")>(retval_[7]);
 }
 
 }  // namespace stirling
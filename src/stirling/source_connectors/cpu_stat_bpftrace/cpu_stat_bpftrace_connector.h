@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <memory>
 #include <string>
 #include <vector>
@@ -95,6 +97,7 @@ class CPUStatBPFTraceConnector : public SourceConnector, public bpf_tools::BPFTr
   static constexpr auto kTable = DataTableSchema(
       "bpftrace_cpu_stats", "CPU usage metrics for processes (obtained via BPFtrace)", kElements);
   static constexpr auto kTables = MakeArray(kTable);
+  static constexpr size_t kNumElements = sizeof(kElements) / sizeof(kElements[0]);
 
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     // TODO(oazizi): Expose cpu_id through Create.
@@ -111,6 +114,12 @@ class CPUStatBPFTraceConnector : public SourceConnector, public bpf_tools::BPFTr
 
  private:
   uint64_t cpu_id_ = 0;
+
+  // The latest value of each entry of the @retval map, indexed by key, and the entries seen since
+  // the last record was written. The map is drained, so a record is only written once all of its
+  // entries were updated by the script.
+  std::array<int64_t, kNumElements> retval_ = {};
+  std::bitset<kNumElements> retval_seen_;
 };
 
 }  // namespace stirling
@@ -152,21 +152,28 @@ StatusOr<std::unique_ptr<SourceConnector>> DynamicTraceConnector::Create(
 
   LOG(INFO) << "BCCProgram:\n" << bcc_program.ToString();
 
-  if (bcc_program.perf_buffer_specs.size() != 1) {
-    return error::Internal("Only a single output table is allowed for now.");
+  if (bcc_program.perf_buffer_specs.empty()) {
+    return error::Internal("The program has no output table.");
   }
 
-  const auto& output = bcc_program.perf_buffer_specs[0];
+  std::vector<std::unique_ptr<DynamicDataTableSchema>> table_schemas;
+  std::vector<DataTableSchema> table_schema_views;
+  for (const auto& output : bcc_program.perf_buffer_specs) {
+    // Could consider making a better description, but may require more user input,
+    // so punting on that for now.
+    std::string desc = absl::StrCat("Dynamic table for ", output.name);
 
-  // Could consider making a better description, but may require more user input,
-  // so punting on that for now.
-  std::string desc = absl::StrCat("Dynamic table for ", output.name);
+    table_schemas.push_back(
+        DynamicDataTableSchema::Create(output.name, desc, ConvertFields(output.output.fields())));
+    table_schema_views.push_back(table_schemas.back()->Get());
+  }
 
-  std::unique_ptr<DynamicDataTableSchema> table_schema =
-      DynamicDataTableSchema::Create(output.name, desc, ConvertFields(output.output.fields()));
+  auto connector = std::unique_ptr<DynamicTraceConnector>(
+      new DynamicTraceConnector(name, std::move(table_schemas), std::move(table_schema_views),
+                                std::move(bcc_program)));
+  PL_RETURN_IF_ERROR(connector->BuildOutputDecoders());
 
-  return std::unique_ptr<SourceConnector>(
-      new DynamicTraceConnector(name, std::move(table_schema), std::move(bcc_program)));
+  return std::unique_ptr<SourceConnector>(std::move(connector));
 }
 
 Status DynamicTraceConnector::InitImpl() {
@@ -179,9 +186,10 @@ Status DynamicTraceConnector::InitImpl() {
     PL_RETURN_IF_ERROR(AttachUProbe(uprobe_spec));
   }
 
-  // TODO(yzhao/oazizi): Might need to change this if we need to support multiple perf buffers.
+  // Programs with several outputs submit them all to one shared perf buffer.
   bpf_tools::PerfBufferSpec spec = {
-      .name = bcc_program_.perf_buffer_specs.front().name,
+      .name = bcc_program_.shared_perf_buffer ? dynamic_tracing::kSharedPerfBufferName
+                                              : bcc_program_.perf_buffer_specs.front().name,
       .probe_output_fn = &GenericHandleEvent,
       .probe_loss_fn = &GenericHandleEventLoss,
   };
@@ -360,148 +368,228 @@ class StructDecoder {
   std::string_view buf_;
 };
 
-Status FillColumn(StructDecoder* struct_decoder, DataTable::DynamicRecordBuilder* r, size_t col_idx,
-                  ScalarType type, const RepeatedPtrField<StructSpec>& col_decoder) {
-#define WRITE_COLUMN(field_type, column_type)                                        \
-  {                                                                                  \
-    PL_ASSIGN_OR_RETURN(field_type val, struct_decoder->ExtractField<field_type>()); \
-    r->Append(col_idx, column_type(val));                                            \
-    break;                                                                           \
-  }
+template <typename TFieldType, typename TColumnType>
+Status WriteScalar(std::string_view bytes, const Field& /* field */,
+                   DataTable::DynamicRecordBuilder* r, size_t col_idx) {
+  r->Append(col_idx, TColumnType(MemCpy<TFieldType>(bytes)));
+  return Status::OK();
+}
+
+Status WriteString(std::string_view bytes, const Field& /* field */,
+                   DataTable::DynamicRecordBuilder* r, size_t col_idx) {
+  StructDecoder struct_decoder(bytes);
+  PL_ASSIGN_OR_RETURN(std::string val, struct_decoder.ExtractString());
+  r->Append(col_idx, types::StringValue(std::move(val)));
+  return Status::OK();
+}
+
+Status WriteByteArray(std::string_view bytes, const Field& /* field */,
+                      DataTable::DynamicRecordBuilder* r, size_t col_idx) {
+  StructDecoder struct_decoder(bytes);
+  PL_ASSIGN_OR_RETURN(std::string val, struct_decoder.ExtractByteArrayAsHex());
+  r->Append(col_idx, types::StringValue(std::move(val)));
+  return Status::OK();
+}
+
+Status WriteStructBlob(std::string_view bytes, const Field& field,
+                       DataTable::DynamicRecordBuilder* r, size_t col_idx) {
+  StructDecoder struct_decoder(bytes);
+  PL_ASSIGN_OR_RETURN(std::string val,
+                      struct_decoder.ExtractStructBlobAsJSON(field.blob_decoders()));
+  r->Append(col_idx, types::StringValue(std::move(val)));
+  return Status::OK();
+}
+
+struct FieldWriter {
+  size_t size;
+  ColumnDecoder::WriteFn write_fn;
+};
+
+StatusOr<FieldWriter> GetFieldWriter(ScalarType type) {
+#define SCALAR_WRITER(field_type, column_type) \
+  return FieldWriter{sizeof(field_type), &WriteScalar<field_type, column_type>};
 
   // TODO(yzhao): Right now only support scalar types. We should replace type with ScalarType
   // in Struct::Field.
   switch (type) {
     case ScalarType::BOOL:
-      WRITE_COLUMN(bool, types::BoolValue);
+      SCALAR_WRITER(bool, types::BoolValue);
     case ScalarType::INT:
-      WRITE_COLUMN(int, types::Int64Value);
+      SCALAR_WRITER(int, types::Int64Value);
     case ScalarType::INT8:
-      WRITE_COLUMN(int8_t, types::Int64Value);
+      SCALAR_WRITER(int8_t, types::Int64Value);
     case ScalarType::INT16:
-      WRITE_COLUMN(int16_t, types::Int64Value);
+      SCALAR_WRITER(int16_t, types::Int64Value);
     case ScalarType::INT32:
-      WRITE_COLUMN(int32_t, types::Int64Value);
+      SCALAR_WRITER(int32_t, types::Int64Value);
     case ScalarType::INT64:
-      WRITE_COLUMN(int64_t, types::Int64Value);
+      SCALAR_WRITER(int64_t, types::Int64Value);
     case ScalarType::UINT:
-      WRITE_COLUMN(unsigned int, types::Int64Value);
+      SCALAR_WRITER(unsigned int, types::Int64Value);
     case ScalarType::UINT8:
-      WRITE_COLUMN(uint8_t, types::Int64Value);
+      SCALAR_WRITER(uint8_t, types::Int64Value);
     case ScalarType::UINT16:
-      WRITE_COLUMN(uint16_t, types::Int64Value);
+      SCALAR_WRITER(uint16_t, types::Int64Value);
     case ScalarType::UINT32:
-      WRITE_COLUMN(uint32_t, types::Int64Value);
+      SCALAR_WRITER(uint32_t, types::Int64Value);
     case ScalarType::UINT64:
-      WRITE_COLUMN(uint64_t, types::Int64Value);
+      SCALAR_WRITER(uint64_t, types::Int64Value);
 
     case ScalarType::SHORT:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(short, types::Int64Value);
+      SCALAR_WRITER(short, types::Int64Value);
     case ScalarType::USHORT:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned short, types::Int64Value);
+      SCALAR_WRITER(unsigned short, types::Int64Value);
     case ScalarType::LONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(long, types::Int64Value);
+      SCALAR_WRITER(long, types::Int64Value);
     case ScalarType::ULONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned long, types::Int64Value);
+      SCALAR_WRITER(unsigned long, types::Int64Value);
     case ScalarType::LONGLONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(long long, types::Int64Value);
+      SCALAR_WRITER(long long, types::Int64Value);
     case ScalarType::ULONGLONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned long long, types::Int64Value);
+      SCALAR_WRITER(unsigned long long, types::Int64Value);
     case ScalarType::CHAR:
-      WRITE_COLUMN(char, types::Int64Value);
+      SCALAR_WRITER(char, types::Int64Value);
     case ScalarType::UCHAR:
-      WRITE_COLUMN(unsigned char, types::Int64Value);
+      SCALAR_WRITER(unsigned char, types::Int64Value);
 
     case ScalarType::FLOAT:
-      WRITE_COLUMN(float, types::Float64Value);
+      SCALAR_WRITER(float, types::Float64Value);
     case ScalarType::DOUBLE:
-      WRITE_COLUMN(double, types::Float64Value);
+      SCALAR_WRITER(double, types::Float64Value);
     case ScalarType::VOID_POINTER:
-      WRITE_COLUMN(uint64_t, types::Int64Value);
-    case ScalarType::STRING: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractString());
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
-    case ScalarType::BYTE_ARRAY: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractByteArrayAsHex());
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
-    case ScalarType::STRUCT_BLOB: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractStructBlobAsJSON(col_decoder));
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
+      SCALAR_WRITER(uint64_t, types::Int64Value);
+    case ScalarType::STRING:
+      return FieldWriter{dynamic_tracing::kStructStringSize, &WriteString};
+    case ScalarType::BYTE_ARRAY:
+      return FieldWriter{dynamic_tracing::kStructByteArraySize, &WriteByteArray};
+    case ScalarType::STRUCT_BLOB:
+      return FieldWriter{dynamic_tracing::kStructBlobSize, &WriteStructBlob};
     case ScalarType::UNKNOWN:
       return error::Internal("Unknown scalar type should not be used.");
     case ScalarType::ScalarType_INT_MIN_SENTINEL_DO_NOT_USE_:
     case ScalarType::ScalarType_INT_MAX_SENTINEL_DO_NOT_USE_:
-      LOG(DFATAL) << "Impossible enum value";
       break;
   }
-#undef WRITE_COLUMN
+#undef SCALAR_WRITER
 
-  return Status::OK();
+  return error::Internal("Impossible enum value $0", static_cast<int>(type));
 }
 
 }  // namespace
 
-Status DynamicTraceConnector::AppendRecord(const Struct& st, uint32_t asid, std::string_view buf,
-                                           DataTable* data_table) {
-  StructDecoder struct_decoder(buf);
-  DataTable::DynamicRecordBuilder r(data_table);
+StatusOr<OutputDecoder> BuildOutputDecoder(const Struct& st) {
+  OutputDecoder decoder;
 
-  int col_idx = 0;
   for (int i = 0; i < st.fields_size(); ++i) {
-    auto& field = st.fields(i);
+    const auto& field = st.fields(i);
+
+    ColumnDecoder column;
+    column.offset = decoder.record_size;
+    column.field = &field;
 
     if (field.name() == "time_") {
-      PL_ASSIGN_OR_RETURN(uint64_t ktime_ns, struct_decoder.ExtractField<uint64_t>());
-      int64_t time = ktime_ns + ClockRealTimeOffset();
-      r.Append(col_idx++, types::Time64NSValue(time));
+      column.kind = ColumnDecoder::Kind::kTime;
+      decoder.record_size += sizeof(uint64_t);
     } else if ((field.name() == "tgid_") && (i + 1 < st.fields_size()) &&
                (st.fields(i + 1).name() == "tgid_start_time_")) {
       // If we see "tgid_" and "tgid_start_time_" back-to-back, then we automatically create UPID.
-      PL_ASSIGN_OR_RETURN(uint32_t tgid, struct_decoder.ExtractField<uint32_t>());
-      PL_ASSIGN_OR_RETURN(uint64_t tgid_start_time, struct_decoder.ExtractField<uint64_t>());
-      md::UPID upid(asid, tgid, tgid_start_time);
-      r.Append(col_idx++, types::UInt128Value(upid.value()));
+      column.kind = ColumnDecoder::Kind::kUPID;
+      decoder.record_size += sizeof(uint32_t) + sizeof(uint64_t);
 
       // Consume the extra tgid_start_time_ column.
       ++i;
     } else {
-      PL_RETURN_IF_ERROR(
-          FillColumn(&struct_decoder, &r, col_idx++, field.type(), field.blob_decoders()));
+      PL_ASSIGN_OR_RETURN(FieldWriter writer, GetFieldWriter(field.type()));
+      column.kind = ColumnDecoder::Kind::kField;
+      column.write_fn = writer.write_fn;
+      decoder.record_size += writer.size;
     }
+
+    decoder.columns.push_back(column);
   }
 
+  return decoder;
+}
+
+Status DynamicTraceConnector::BuildOutputDecoders() {
+  output_decoders_.clear();
+  for (const auto& output : bcc_program_.perf_buffer_specs) {
+    PL_ASSIGN_OR_RETURN(OutputDecoder decoder, BuildOutputDecoder(output.output));
+    output_decoders_.push_back(std::move(decoder));
+  }
   return Status::OK();
 }
 
-void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
-                                             const std::vector<DataTable*>& data_tables) {
-  DCHECK_EQ(data_tables.size(), 1)
-      << "Now only support having exactly one table per DynamicTraceConnector";
+Status DynamicTraceConnector::AppendRecord(const OutputDecoder& decoder, uint32_t asid,
+                                           std::string_view buf, DataTable* data_table) {
+  // All the fields have a fixed size, so one check covers every column.
+  if (buf.size() < decoder.record_size) {
+    return error::ResourceUnavailable("Insufficient number of bytes: $0 < $1", buf.size(),
+                                      decoder.record_size);
+  }
 
-  auto* data_table = data_tables[0];
-  if (data_table == nullptr) {
-    return;
+  DataTable::DynamicRecordBuilder r(data_table);
+
+  for (size_t col_idx = 0; col_idx < decoder.columns.size(); ++col_idx) {
+    const ColumnDecoder& column = decoder.columns[col_idx];
+    std::string_view bytes = buf.substr(column.offset);
+
+    switch (column.kind) {
+      case ColumnDecoder::Kind::kTime: {
+        int64_t time = MemCpy<uint64_t>(bytes) + ClockRealTimeOffset();
+        r.Append(col_idx, types::Time64NSValue(time));
+        break;
+      }
+      case ColumnDecoder::Kind::kUPID: {
+        auto tgid = MemCpy<uint32_t>(bytes);
+        auto tgid_start_time = MemCpy<uint64_t>(bytes.substr(sizeof(uint32_t)));
+        md::UPID upid(asid, tgid, tgid_start_time);
+        r.Append(col_idx, types::UInt128Value(upid.value()));
+        break;
+      }
+      case ColumnDecoder::Kind::kField:
+        PL_RETURN_IF_ERROR(column.write_fn(bytes, *column.field, &r, col_idx));
+        break;
+    }
   }
 
+  return Status::OK();
+}
+
+void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
+                                             const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), bcc_program_.perf_buffer_specs.size());
+
   PollPerfBuffers();
 
-  for (const auto& item : data_items_) {
-    // TODO(yzhao): Right now only support scalar types. We should replace type with ScalarType
-    // in Struct::Field.
-    ECHECK_OK(AppendRecord(bcc_program_.perf_buffer_specs.front().output, ctx->GetASID(), item,
-                           data_table));
+  for (std::string_view item : data_items_) {
+    size_t output_index = 0;
+    if (bcc_program_.shared_perf_buffer) {
+      // Records in the shared perf buffer start with the index of their output.
+      if (item.size() < sizeof(uint32_t)) {
+        LOG(DFATAL) << "Perf buffer record is too short for the output index.";
+        continue;
+      }
+      output_index = MemCpy<uint32_t>(item);
+      item.remove_prefix(sizeof(uint32_t));
+      if (output_index >= data_tables.size()) {
+        LOG(DFATAL) << absl::Substitute("Invalid output index $0", output_index);
+        continue;
+      }
+    }
+
+    auto* data_table = data_tables[output_index];
+    if (data_table == nullptr) {
+      continue;
+    }
+
+    ECHECK_OK(AppendRecord(output_decoders_[output_index], ctx->GetASID(), item, data_table));
   }
 
   data_items_.clear();
@@ -32,6 +32,42 @@
 namespace px {
 namespace stirling {
 
+// Decodes the packed output structs of a dynamic trace program into table columns.
+// The decoder is built once per output when the program is deployed: every field of an output
+// struct has a fixed size, so the offset of each column is known up front, and records are decoded
+// with a single bounds check instead of walking the fields one by one.
+struct ColumnDecoder {
+  enum class Kind {
+    // The "time_" field, converted from monotonic to real time.
+    kTime,
+    // The "tgid_" and "tgid_start_time_" fields, merged into a UPID.
+    kUPID,
+    // Any other field, written by write_fn.
+    kField,
+  };
+
+  // Writes the field in the given bytes into the column col_idx.
+  using WriteFn = Status (*)(std::string_view bytes,
+                             const dynamic_tracing::ir::physical::Field& field,
+                             DataTable::DynamicRecordBuilder* r, size_t col_idx);
+
+  Kind kind = Kind::kField;
+  size_t offset = 0;
+  const dynamic_tracing::ir::physical::Field* field = nullptr;
+  WriteFn write_fn = nullptr;
+};
+
+struct OutputDecoder {
+  // One decoder per column, in column order.
+  std::vector<ColumnDecoder> columns;
+  // The size of a record of the output struct.
+  size_t record_size = 0;
+};
+
+// Builds the decoder of an output struct. The decoder refers to the fields of the struct, which
+// must outlive it. Only public for testing purposes.
+StatusOr<OutputDecoder> BuildOutputDecoder(const dynamic_tracing::ir::physical::Struct& st);
+
 class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{100};
@@ -46,15 +82,23 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
   void AcceptDataEvents(std::string data) { data_items_.push_back(std::move(data)); }
 
  protected:
-  // TODO(oazizi): This constructor only works with a single table,
-  //               since the ArrayView creation only works for a single schema.
-  //               Consider how to expand to multiple tables if/when needed.
-  DynamicTraceConnector(std::string_view name, std::unique_ptr<DynamicDataTableSchema> table_schema,
+  // There is one table per output of the program. table_schema_views holds the DataTableSchema of
+  // each of table_schemas; the vector's buffer backs the ArrayView given to SourceConnector and is
+  // kept alive (moving a vector doesn't move its elements) in table_schema_views_.
+  DynamicTraceConnector(std::string_view name,
+                        std::vector<std::unique_ptr<DynamicDataTableSchema>> table_schemas,
+                        std::vector<DataTableSchema> table_schema_views,
                         dynamic_tracing::BCCProgram bcc_program)
-      : SourceConnector(name, ArrayView<DataTableSchema>(&table_schema->Get(), 1)),
-        table_schema_(std::move(table_schema)),
+      : SourceConnector(name, ArrayView<DataTableSchema>(table_schema_views.data(),
+                                                         table_schema_views.size())),
+        table_schemas_(std::move(table_schemas)),
+        table_schema_views_(std::move(table_schema_views)),
         bcc_program_(std::move(bcc_program)) {}
 
+  // Builds the decoders of the outputs of bcc_program_. Must be called once the connector is
+  // constructed, since the decoders point into bcc_program_.
+  Status BuildOutputDecoders();
+
   Status InitImpl() override;
 
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
@@ -62,15 +106,19 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
   Status StopImpl() override { return Status::OK(); }
 
  private:
-  Status AppendRecord(const ::px::stirling::dynamic_tracing::ir::physical::Struct& st,
-                      uint32_t asid, std::string_view buf, DataTable* data_table);
+  Status AppendRecord(const OutputDecoder& decoder, uint32_t asid, std::string_view buf,
+                      DataTable* data_table);
 
-  // Describes the output table column types.
-  std::unique_ptr<DynamicDataTableSchema> table_schema_;
+  // Describes the output table column types, one table per output of the program.
+  std::vector<std::unique_ptr<DynamicDataTableSchema>> table_schemas_;
+  std::vector<DataTableSchema> table_schema_views_;
 
   // The actual dynamic trace program.
   dynamic_tracing::BCCProgram bcc_program_;
 
+  // The decoders of the outputs, indexed like bcc_program_.perf_buffer_specs.
+  std::vector<OutputDecoder> output_decoders_;
+
   // A buffer to hold raw data items from the perf buffer.
   std::deque<std::string> data_items_;
 };
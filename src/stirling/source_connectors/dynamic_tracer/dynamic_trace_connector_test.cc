@@ -79,5 +79,62 @@ TEST(DynamicTraceConnectorTest, ConvertFields) {
   EXPECT_EQ(elements.elements()[2].type(), types::TIME64NS);
 }
 
+TEST(DynamicTraceConnectorTest, BuildOutputDecoder) {
+  constexpr std::string_view kOutputStruct = R"(
+      name: "out_table_value_t"
+      fields {
+        name: "tgid_"
+        type: INT32
+      }
+      fields {
+        name: "tgid_start_time_"
+        type: UINT64
+      }
+      fields {
+        name: "time_"
+        type: UINT64
+      }
+      fields {
+        name: "arg0"
+        type: INT16
+      }
+      fields {
+        name: "arg1"
+        type: STRING
+      }
+      fields {
+        name: "arg2"
+        type: BOOL
+      }
+  )";
+
+  ::px::stirling::dynamic_tracing::ir::physical::Struct output_struct;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(std::string(kOutputStruct), &output_struct));
+
+  ASSERT_OK_AND_ASSIGN(OutputDecoder decoder, BuildOutputDecoder(output_struct));
+
+  // Same columns as ConvertFields(): tgid_ and tgid_start_time_ are decoded together as the upid.
+  ASSERT_EQ(decoder.columns.size(), 5);
+  EXPECT_EQ(decoder.columns[0].kind, ColumnDecoder::Kind::kUPID);
+  EXPECT_EQ(decoder.columns[0].offset, 0);
+  EXPECT_EQ(decoder.columns[1].kind, ColumnDecoder::Kind::kTime);
+  EXPECT_EQ(decoder.columns[1].offset, 12);
+  EXPECT_EQ(decoder.columns[2].kind, ColumnDecoder::Kind::kField);
+  EXPECT_EQ(decoder.columns[2].offset, 20);
+  EXPECT_EQ(decoder.columns[3].offset, 22);
+  EXPECT_EQ(decoder.columns[4].offset, 22 + dynamic_tracing::kStructStringSize);
+  EXPECT_EQ(decoder.record_size, 23 + dynamic_tracing::kStructStringSize);
+}
+
+TEST(DynamicTraceConnectorTest, BuildOutputDecoderUnknownType) {
+  ::px::stirling::dynamic_tracing::ir::physical::Struct output_struct;
+  auto* field = output_struct.add_fields();
+  field->set_name("arg0");
+  field->set_type(::px::stirling::dynamic_tracing::ir::shared::ScalarType::UNKNOWN);
+
+  EXPECT_NOT_OK(BuildOutputDecoder(output_struct));
+}
+
 }  // namespace stirling
 }  // namespace px
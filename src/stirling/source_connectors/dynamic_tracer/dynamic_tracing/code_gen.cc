@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include <absl/container/flat_hash_set.h>
@@ -182,6 +183,9 @@ class BCCCodeGenerator {
 
   // Map from Struct names to their definition.
   absl::flat_hash_map<std::string_view, const ir::physical::Struct*> structs_;
+
+  // Map from output names to their index in the program, when the outputs share a perf buffer.
+  absl::flat_hash_map<std::string_view, int> shared_output_indexes_;
 };
 
 // Returns the C type name of the input ScalarType.
@@ -556,8 +560,11 @@ std::string GenPerfBufferOutput(const PerfBufferOutput& output) {
 
 namespace {
 
+// With a shared perf buffer, output_index is the index of the output in the program, which
+// is written at the start of the record.
 StatusOr<std::vector<std::string>> GenPerfBufferOutputAction(
-    const ir::physical::Struct& output_struct, const PerfBufferOutputAction& action) {
+    const ir::physical::Struct& output_struct, const PerfBufferOutputAction& action,
+    std::optional<int> output_index) {
   std::string output_var_name = absl::StrCat(action.perf_buffer_name(), "_value");
 
   std::vector<std::string> code_lines;
@@ -576,8 +583,15 @@ StatusOr<std::vector<std::string>> GenPerfBufferOutputAction(
                                           output_struct.fields(struct_field_index++).name(), f));
   }
 
-  code_lines.push_back(absl::Substitute("$0.perf_submit(ctx, $1, sizeof(*$1));",
-                                        action.perf_buffer_name(), output_var_name));
+  if (output_index.has_value()) {
+    code_lines.push_back(absl::Substitute("$0->$1 = $2;", output_var_name, kOutputIndexFieldName,
+                                          output_index.value()));
+  }
+
+  code_lines.push_back(absl::Substitute(
+      "$0.perf_submit(ctx, $1, sizeof(*$1));",
+      output_index.has_value() ? kSharedPerfBufferName : action.perf_buffer_name(),
+      output_var_name));
 
   return code_lines;
 }
@@ -829,7 +843,13 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateProbe(const Probe&
     if (iter == structs_.end()) {
       return error::InvalidArgument("Output struct '$0' is undefined", action.output_struct_name());
     }
-    MOVE_BACK_STR_VEC(GenPerfBufferOutputAction(*iter->second, action), &code_lines);
+    std::optional<int> output_index;
+    auto index_iter = shared_output_indexes_.find(action.perf_buffer_name());
+    if (index_iter != shared_output_indexes_.end()) {
+      output_index = index_iter->second;
+    }
+    MOVE_BACK_STR_VEC(GenPerfBufferOutputAction(*iter->second, action, output_index),
+                      &code_lines);
   }
 
   for (const auto& printk : probe.printks()) {
@@ -970,8 +990,28 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateCodeLines() {
   MoveBackStrVec(GenUtilFNs(), &code_lines);
   MoveBackStrVec(GenTypes(), &code_lines);
 
+  // The outputs of programs with several tracepoints share one perf buffer, see types.h.
+  absl::flat_hash_set<std::string_view> shared_output_structs;
+  if (program_.outputs_size() > 1) {
+    for (int i = 0; i < program_.outputs_size(); ++i) {
+      shared_output_indexes_[program_.outputs(i).name()] = i;
+      shared_output_structs.insert(program_.outputs(i).struct_type());
+    }
+  }
+
   for (const auto& st : program_.structs()) {
-    MOVE_BACK_STR_VEC(GenStruct(st), &code_lines);
+    if (shared_output_structs.contains(st.name())) {
+      // Prefix the output struct with the index of its output.
+      ir::physical::Struct tagged_st;
+      tagged_st.set_name(st.name());
+      auto* index_field = tagged_st.add_fields();
+      index_field->set_name(kOutputIndexFieldName);
+      index_field->set_type(ScalarType::UINT32);
+      tagged_st.mutable_fields()->MergeFrom(st.fields());
+      MOVE_BACK_STR_VEC(GenStruct(tagged_st), &code_lines);
+    } else {
+      MOVE_BACK_STR_VEC(GenStruct(st), &code_lines);
+    }
     structs_[st.name()] = &st;
   }
 
@@ -998,8 +1038,12 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateCodeLines() {
     MoveBackStrVec(GenGOID(), &code_lines);
   }
 
-  for (const auto& output : program_.outputs()) {
-    code_lines.push_back(GenPerfBufferOutput(output));
+  if (shared_output_indexes_.empty()) {
+    for (const auto& output : program_.outputs()) {
+      code_lines.push_back(GenPerfBufferOutput(output));
+    }
+  } else {
+    code_lines.push_back(absl::Substitute("BPF_PERF_OUTPUT($0);", kSharedPerfBufferName));
   }
 
   for (const auto& probe : program_.probes()) {
@@ -423,7 +423,10 @@ TEST(GenProgramTest, SpecsAndCode) {
       "  uint8_t buf[64-sizeof(uint64_t)-2];",
       "  uint8_t truncated;",
       "};",
+      // The program has two outputs, so they share a perf buffer, and the output struct is
+      // prefixed with the output index.
       "struct socket_data_event_t {",
+      "  uint32_t output_index_;",
       "  int32_t i32;",
       "} __attribute__((packed, aligned(1)));",
       "struct value_t {",
@@ -436,8 +439,7 @@ TEST(GenProgramTest, SpecsAndCode) {
       "const struct pid_goid_map_value_t* goid_ptr = pid_goid_map.lookup(&current_pid_tgid);",
       "return (goid_ptr == NULL) ? -1 : goid_ptr->goid;",
       "}",
-      "BPF_PERF_OUTPUT(data_events);",
-      "BPF_PERF_OUTPUT(data_events2);",
+      "BPF_PERF_OUTPUT(shared_output_);",
       "int probe_entry(struct pt_regs* ctx) {",
       "uint32_t key = bpf_get_current_pid_tgid() >> 32;",
       "int32_t var = (int32_t)PT_REGS_SP(ctx);",
@@ -462,7 +464,8 @@ TEST(GenProgramTest, SpecsAndCode) {
       "data_events_value_array.lookup(&data_events_value_idx);",
       "if (data_events_value == NULL) { return 0; }",
       "data_events_value->i32 = inner_var;",
-      "data_events.perf_submit(ctx, data_events_value, sizeof(*data_events_value));",
+      "data_events_value->output_index_ = 0;",
+      "shared_output_.perf_submit(ctx, data_events_value, sizeof(*data_events_value));",
       R"(bpf_trace_printk("var: %d\n", var);)",
       "return 0;",
       "}",
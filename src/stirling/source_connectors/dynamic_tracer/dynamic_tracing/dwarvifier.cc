@@ -160,9 +160,8 @@ class Dwarvifier {
 StatusOr<ir::physical::Program> GeneratePhysicalProgram(
     const ir::logical::TracepointDeployment& input, obj_tools::DwarfReader* dwarf_reader,
     obj_tools::ElfReader* elf_reader) {
-  if (input.tracepoints_size() != 1) {
-    return error::InvalidArgument("Right now only support exactly 1 Tracepoint, got '$0'",
-                                  input.tracepoints_size());
+  if (input.tracepoints_size() == 0) {
+    return error::InvalidArgument("Must have at least one Tracepoint");
   }
 
   ir::physical::Program output_program;
@@ -19,12 +19,18 @@
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
 #include <algorithm>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <regex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/system.h"
 
@@ -95,6 +101,88 @@ StatusOr<BCCProgram::PerfBufferSpec> GetPerfBufferSpec(
   return pf_spec;
 }
 
+// The result of compiling a tracepoint: the input program after pre-processing, and the
+// BCC program.
+struct CompiledProgram {
+  ir::logical::TracepointDeployment input_program;
+  BCCProgram bcc_program;
+};
+
+// Caches compiled programs by binary build ID and tracepoint spec, so that deploying the same
+// tracepoint to many processes running the same binary skips the DWARF analysis and code
+// generation after the first one. The compiled programs don't depend on the binary's path, other
+// than through the uprobe specs, which are pointed at the new path on reuse.
+class CompiledProgramCache {
+ public:
+  static CompiledProgramCache* Get() {
+    static CompiledProgramCache cache;
+    return &cache;
+  }
+
+  // Returns an empty key if the binary can't be identified, in which case nothing is cached.
+  static std::string Key(const ElfReader& elf_reader,
+                         const ir::logical::TracepointDeployment& input_program) {
+    if (elf_reader.build_id().empty()) {
+      return "";
+    }
+    ir::logical::TracepointDeployment spec = input_program;
+    spec.clear_deployment_spec();
+    return absl::StrCat(elf_reader.build_id(), "/", spec.SerializeAsString());
+  }
+
+  std::optional<CompiledProgram> Lookup(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = programs_.find(key);
+    if (it == programs_.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  void Insert(const std::string& key, CompiledProgram program) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!programs_.try_emplace(key, std::move(program)).second) {
+      return;
+    }
+    insertion_order_.push_back(key);
+    if (insertion_order_.size() > kMaxPrograms) {
+      programs_.erase(insertion_order_.front());
+      insertion_order_.pop_front();
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxPrograms = 64;
+
+  std::mutex mu_;
+  absl::flat_hash_map<std::string, CompiledProgram> programs_;
+  std::deque<std::string> insertion_order_;
+};
+
+// Tracepoints deployed together share the BPF program, so their names must not collide.
+Status CheckUniqueNames(const ir::logical::TracepointDeployment& input_program) {
+  absl::flat_hash_set<std::string_view> names;
+  for (const auto& tracepoint : input_program.tracepoints()) {
+    const auto& program = tracepoint.program();
+    for (const auto& map : program.maps()) {
+      if (!names.insert(map.name()).second) {
+        return error::InvalidArgument("Map name '$0' is used more than once", map.name());
+      }
+    }
+    for (const auto& output : program.outputs()) {
+      if (!names.insert(output.name()).second) {
+        return error::InvalidArgument("Output name '$0' is used more than once", output.name());
+      }
+    }
+    for (const auto& probe : program.probes()) {
+      if (!names.insert(probe.name()).second) {
+        return error::InvalidArgument("Probe name '$0' is used more than once", probe.name());
+      }
+    }
+  }
+  return Status::OK();
+}
+
 // Return value for Prepare(), so we can return multiple pointers.
 struct ObjInfo {
   std::unique_ptr<ElfReader> elf_reader;
@@ -103,7 +191,9 @@ struct ObjInfo {
 
 // Prepares the input program for compilation by:
 // 1) Resolving the tracepoint target specification into an object path (e.g. UPID->path).
-// 2) Preparing the Elf and Dwarf info for the binary.
+// 2) Preparing the Elf info for the binary.
+// The Dwarf info is prepared separately by PrepareDwarf(), as it's not needed when the compiled
+// program is cached.
 StatusOr<ObjInfo> Prepare(const ir::logical::TracepointDeployment& input_program) {
   ObjInfo obj_info;
 
@@ -112,11 +202,13 @@ StatusOr<ObjInfo> Prepare(const ir::logical::TracepointDeployment& input_program
 
   PL_ASSIGN_OR_RETURN(obj_info.elf_reader, ElfReader::Create(binary_path));
 
-  const auto& debug_symbols_path = obj_info.elf_reader->debug_symbols_path().string();
+  return obj_info;
+}
 
-  obj_info.dwarf_reader = DwarfReader::Create(debug_symbols_path).ConsumeValueOr(nullptr);
+void PrepareDwarf(ObjInfo* obj_info) {
+  const auto& debug_symbols_path = obj_info->elf_reader->debug_symbols_path().string();
 
-  return obj_info;
+  obj_info->dwarf_reader = DwarfReader::Create(debug_symbols_path).ConsumeValueOr(nullptr);
 }
 
 }  // namespace
@@ -126,14 +218,32 @@ StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_pro
     return error::InvalidArgument("Must have path resolved before compiling program");
   }
 
-  if (input_program->tracepoints_size() != 1) {
-    return error::InvalidArgument("Only one tracepoint currently supported, got '$0'",
-                                  input_program->tracepoints_size());
+  if (input_program->tracepoints_size() == 0) {
+    return error::InvalidArgument("Must have at least one tracepoint");
   }
 
   // Get the ELF and DWARF readers for the program.
   PL_ASSIGN_OR_RETURN(ObjInfo obj_info, Prepare(*input_program));
 
+  const std::string cache_key = CompiledProgramCache::Key(*obj_info.elf_reader, *input_program);
+  if (!cache_key.empty()) {
+    std::optional<CompiledProgram> cached = CompiledProgramCache::Get()->Lookup(cache_key);
+    if (cached.has_value()) {
+      LOG(INFO) << absl::Substitute("Reusing the compiled tracepoint program for build ID $0",
+                                    obj_info.elf_reader->build_id());
+      const std::string binary_path = input_program->deployment_spec().path();
+      ir::shared::DeploymentSpec deployment_spec = input_program->deployment_spec();
+      *input_program = std::move(cached->input_program);
+      *input_program->mutable_deployment_spec() = std::move(deployment_spec);
+      for (auto& spec : cached->bcc_program.uprobe_specs) {
+        spec.binary_path = binary_path;
+      }
+      return std::move(cached->bcc_program);
+    }
+  }
+
+  PrepareDwarf(&obj_info);
+
   // --------------------------
   // Pre-processing pipeline
   // --------------------------
@@ -151,6 +261,8 @@ StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_pro
 
   LOG_IF(INFO, FLAGS_debug_dt_pipeline) << input_program->DebugString();
 
+  PL_RETURN_IF_ERROR(CheckUniqueNames(*input_program));
+
   // --------------------------
   // Main compilation pipeline
   // --------------------------
@@ -176,6 +288,7 @@ StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_pro
 
   BCCProgram bcc_program;
   bcc_program.code = std::move(bcc_code);
+  bcc_program.shared_perf_buffer = physical_program.outputs_size() > 1;
 
   const ir::shared::Language& language = physical_program.language();
   const std::string& binary_path = physical_program.deployment_spec().path();
@@ -201,6 +314,10 @@ StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_pro
     bcc_program.perf_buffer_specs.push_back(std::move(pf_spec));
   }
 
+  if (!cache_key.empty()) {
+    CompiledProgramCache::Get()->Insert(cache_key, {*input_program, bcc_program});
+  }
+
   return bcc_program;
 }
 
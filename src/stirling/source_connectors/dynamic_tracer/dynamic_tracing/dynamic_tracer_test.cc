@@ -106,7 +106,7 @@ class ResolveTargetObjPathTest : public ::testing::Test {
     ASSERT_OK(k8s_mds_.HandlePodUpdate(pod0_update));
     ASSERT_OK(k8s_mds_.HandlePodUpdate(pod1_update));
 
-    k8s_mds_.containers_by_id()["container0"]->mutable_active_upids()->emplace(
+    k8s_mds_.MutableContainerInfoByID("container0")->mutable_active_upids()->emplace(
         PIDToUPID(s_.child_pid()));
   }
 
@@ -447,6 +447,87 @@ TEST(DynamicTracerTest, Compile) {
   EXPECT_THAT(code_lines, ElementsAreArray(kExpectedBCC));
 }
 
+// Compiling the same tracepoint for a copy of the binary reuses the compiled program, but
+// attaches to the copy.
+TEST(DynamicTracerTest, CompileSameBinaryAtAnotherPath) {
+  const std::filesystem::path binary_path = px::testing::BazelBinTestFilePath(kBinaryPath);
+  px::testing::TempDir temp_dir;
+  const std::filesystem::path copy_path = temp_dir.path() / "dummy_go_binary_copy";
+  ASSERT_OK(fs::Copy(binary_path, copy_path));
+
+  ir::logical::TracepointDeployment input_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kLogicalProgramSpec, binary_path.string()), &input_program));
+  ASSERT_OK_AND_ASSIGN(BCCProgram bcc_program, CompileProgram(&input_program));
+
+  ir::logical::TracepointDeployment copy_input_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kLogicalProgramSpec, copy_path.string()), &copy_input_program));
+  ASSERT_OK_AND_ASSIGN(BCCProgram copy_bcc_program, CompileProgram(&copy_input_program));
+
+  EXPECT_EQ(copy_bcc_program.code, bcc_program.code);
+  EXPECT_EQ(copy_input_program.deployment_spec().path(), copy_path.string());
+  ASSERT_THAT(copy_bcc_program.uprobe_specs, SizeIs(bcc_program.uprobe_specs.size()));
+  for (const auto& spec : copy_bcc_program.uprobe_specs) {
+    EXPECT_EQ(spec.binary_path, copy_path.string());
+  }
+}
+
+constexpr std::string_view kSecondTracepointSpec = R"(
+tracepoints {
+  program {
+    language: GOLANG
+    outputs {
+      name: "probe_output2"
+      fields: "f1"
+    }
+    probes: {
+      name: "probe1"
+      tracepoint: {
+        symbol: "main.MixedArgTypes"
+        type: LOGICAL
+      }
+      args {
+        id: "arg0"
+        expr: "i1"
+      }
+      output_actions {
+        output_name: "probe_output2"
+        variable_names: "arg0"
+      }
+    }
+  }
+}
+)";
+
+// Tracepoints deployed together compile into one program, whose outputs share a perf buffer.
+TEST(DynamicTracerTest, CompileMultipleTracepoints) {
+  std::string input_program_str = absl::Substitute(
+      kLogicalProgramSpec, px::testing::BazelBinTestFilePath(kBinaryPath).string());
+  ir::logical::TracepointDeployment input_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(input_program_str, &input_program));
+  ASSERT_TRUE(TextFormat::MergeFromString(std::string(kSecondTracepointSpec), &input_program));
+
+  ASSERT_OK_AND_ASSIGN(BCCProgram bcc_program, CompileProgram(&input_program));
+
+  EXPECT_TRUE(bcc_program.shared_perf_buffer);
+  ASSERT_THAT(bcc_program.perf_buffer_specs, SizeIs(2));
+  EXPECT_EQ(bcc_program.perf_buffer_specs[0].name, "probe_output");
+  EXPECT_EQ(bcc_program.perf_buffer_specs[1].name, "probe_output2");
+  EXPECT_THAT(bcc_program.code, HasSubstr("BPF_PERF_OUTPUT(shared_output_);"));
+  EXPECT_THAT(bcc_program.code, HasSubstr("probe_output2_value->output_index_ = 1;"));
+}
+
+TEST(DynamicTracerTest, CompileMultipleTracepointsNameCollision) {
+  std::string input_program_str = absl::Substitute(
+      kLogicalProgramSpec, px::testing::BazelBinTestFilePath(kBinaryPath).string());
+  ir::logical::TracepointDeployment input_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(input_program_str, &input_program));
+  *input_program.add_tracepoints() = input_program.tracepoints(0);
+
+  EXPECT_NOT_OK(CompileProgram(&input_program));
+}
+
 }  // namespace dynamic_tracing
 }  // namespace stirling
 }  // namespace px
@@ -197,6 +197,10 @@ StatusOr<ir::logical::TracepointDeployment> TransformLogicalProgram(
   // Copy the binary path.
   out.mutable_deployment_spec()->CopyFrom(input_program.deployment_spec());
 
+  // The tracepoints are compiled into one BPF program, so the goid map and probe are only needed
+  // once, even if several tracepoints use them.
+  bool goid_probe_added = false;
+
   // For each input Tracepoint, generate probes that needed for producing data between entry and
   // return of the target function.
   for (const auto& input_tracepoint : input_program.tracepoints()) {
@@ -222,10 +226,11 @@ StatusOr<ir::logical::TracepointDeployment> TransformLogicalProgram(
       map->CopyFrom(m);
     }
 
-    if (!input_tracepoint_spec.probes().empty()) {
+    if (!input_tracepoint_spec.probes().empty() && !goid_probe_added) {
       if (input_tracepoint_spec.language() == ir::shared::GOLANG) {
         out_tracepoint_spec->add_maps()->CopyFrom(GenGOIDMap());
         out_tracepoint_spec->add_probes()->CopyFrom(GenGOIDProbe());
+        goid_probe_added = true;
       }
     }
 
@@ -53,6 +53,13 @@ constexpr size_t kStructByteArraySize = 64;
 // generated types.
 constexpr size_t kStructBlobSize = 64;
 
+// When a program has more than one output, all the outputs are submitted to this single perf
+// buffer, so the perf buffer memory doesn't grow with the number of tracepoints in the program.
+// Each record then starts with a uint32_t, kOutputIndexFieldName, that holds the index of its
+// output in BCCProgram::perf_buffer_specs.
+constexpr char kSharedPerfBufferName[] = "shared_output_";
+constexpr char kOutputIndexFieldName[] = "output_index_";
+
 struct BCCProgram {
   struct PerfBufferSpec {
     std::string name;
@@ -65,6 +72,9 @@ struct BCCProgram {
 
   std::vector<bpf_tools::UProbeSpec> uprobe_specs;
   std::vector<PerfBufferSpec> perf_buffer_specs;
+  // Whether the outputs are submitted to kSharedPerfBufferName, instead of the perf buffers
+  // named in perf_buffer_specs.
+  bool shared_perf_buffer = false;
   std::string code;
 
   std::string ToString() const {
@@ -43,7 +43,12 @@ Status JVMStatsConnector::InitImpl() {
 }
 
 void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
-  proc_tracker_.Update(ctx.GetUPIDs());
+  proc_tracker_.Update(ctx.GetUPIDs(), ctx.GetUPIDsGeneration());
+
+  // The mapping of a process' hsperfdata stays readable after the process exits.
+  for (const auto& upid : proc_tracker_.deleted_upids()) {
+    java_procs_.erase(upid);
+  }
 
   for (const auto& upid : proc_tracker_.new_upids()) {
     // The host PID 1 is not a Java app. However, when later invoking HsperfdataPath(), it could be
@@ -57,21 +62,27 @@ void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
   }
 }
 
-Status JVMStatsConnector::ExportStats(const md::UPID& upid,
-                                      const std::filesystem::path& hsperf_data_path,
+Status JVMStatsConnector::ExportStats(const md::UPID& upid, JavaProcInfo* java_proc,
                                       DataTable* data_table) const {
-  PL_ASSIGN_OR_RETURN(std::string hsperf_data_str, ReadFileToString(hsperf_data_path));
+  if (java_proc->hsperf_data_reader == nullptr) {
+    PL_ASSIGN_OR_RETURN(java_proc->hsperf_data_reader,
+                        java::HsperfdataReader::Create(java_proc->hsperf_data_path));
+  }
 
-  if (hsperf_data_str.empty()) {
-    // Assume this is a transient failure.
+  auto stats_or = java_proc->hsperf_data_reader->Read();
+  if (!stats_or.ok()) {
+    // Assumes this is a transient failure.
     return Status::OK();
   }
+  const java::Stats& stats = stats_or.ValueOrDie();
 
-  java::Stats stats(std::move(hsperf_data_str));
-  if (!stats.Parse().ok()) {
-    // Assumes this is a transient failure.
+  // Idle JVMs are still exported once in a while, so they show up in short query windows.
+  if (!java_proc->hsperf_data_reader->changed() &&
+      java_proc->num_skipped_exports < kMaxSkippedExports) {
+    ++java_proc->num_skipped_exports;
     return Status::OK();
   }
+  java_proc->num_skipped_exports = 0;
 
   uint64_t time = CurrentTimeNS();
 
@@ -103,7 +114,7 @@ void JVMStatsConnector::TransferDataImpl(ConnectorContext* ctx,
     JavaProcInfo& java_proc = iter->second;
 
     md::UPID upid_with_asid(ctx->GetASID(), upid.pid(), upid.start_ts());
-    auto status = ExportStats(upid_with_asid, java_proc.hsperf_data_path, data_table);
+    auto status = ExportStats(upid_with_asid, &java_proc, data_table);
     if (!status.ok()) {
       ++java_proc.export_failure_count;
     }
@@ -47,6 +47,8 @@ class JVMStatsConnector : public SourceConnector {
   static constexpr int kTableNum = SourceConnector::TableNum(kTables, kJVMStatsTable);
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{1000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
+  // The number of sampling periods a JVM whose stats did not change can go without an export.
+  static constexpr int kMaxSkippedExports = 9;
 
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     return std::unique_ptr<SourceConnector>(new JVMStatsConnector(name));
@@ -64,20 +66,24 @@ class JVMStatsConnector : public SourceConnector {
   // Finds the UPIDs of newly-created processes as monitoring targets.
   void FindJavaUPIDs(const ConnectorContext& ctx);
 
-  // Exports JVM performance metrics to data table.
-  Status ExportStats(const md::UPID& upid, const std::filesystem::path& hsperf_data_path,
-                     DataTable* data_table) const;
-
-  // Keeps track of the currently-running processes. Used to find the newly-created processes.
-  ProcTracker proc_tracker_;
-
   // Records the PIDs of previously scanned Java processes, and their hsperfdata file path.
   struct JavaProcInfo {
     // How many times we have failed to export stats for this process. Once this reaches a limit,
     // the process will no longer be monitored.
     int export_failure_count = 0;
     std::filesystem::path hsperf_data_path;
+    // Keeps the hsperfdata file mapped. Created on the first export.
+    std::unique_ptr<java::HsperfdataReader> hsperf_data_reader;
+    // How many exports in a row were skipped, because the stats did not change.
+    int num_skipped_exports = 0;
   };
+
+  // Exports JVM performance metrics to data table.
+  Status ExportStats(const md::UPID& upid, JavaProcInfo* java_proc, DataTable* data_table) const;
+
+  // Keeps track of the currently-running processes. Used to find the newly-created processes.
+  ProcTracker proc_tracker_;
+
   absl::flat_hash_map<md::UPID, JavaProcInfo> java_procs_;
 };
 
@@ -121,8 +121,19 @@ TEST_F(JVMStatsConnectorTest, CaptureData) {
   ASSERT_FALSE(tablets.empty());
   record_batch = tablets[0].records;
   EXPECT_THAT(FindRecordIdxMatchesPID(record_batch, kUPIDIdx, hello_world2.child_pid()), SizeIs(1));
-  // Make sure the previous processes were scanned as well.
-  EXPECT_THAT(FindRecordIdxMatchesPID(record_batch, kUPIDIdx, hello_world1.child_pid()), SizeIs(1));
+
+  // Make sure the previous processes were scanned as well. hello_world1 is idle, so its stats might
+  // not have changed, in which case it is only exported again after kMaxSkippedExports periods.
+  size_t num_hello_world1_records =
+      FindRecordIdxMatchesPID(record_batch, kUPIDIdx, hello_world1.child_pid()).size();
+  for (int i = 0; i < JVMStatsConnector::kMaxSkippedExports; ++i) {
+    connector_->TransferData(ctx.get(), data_tables_);
+    for (const auto& tablet : data_table_.ConsumeRecords()) {
+      num_hello_world1_records +=
+          FindRecordIdxMatchesPID(tablet.records, kUPIDIdx, hello_world1.child_pid()).size();
+    }
+  }
+  EXPECT_GE(num_hello_world1_records, 1);
 }
 
 }  // namespace stirling
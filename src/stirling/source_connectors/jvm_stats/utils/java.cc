@@ -18,13 +18,21 @@
 
 #include "src/stirling/source_connectors/jvm_stats/utils/java.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <absl/strings/match.h>
 
+#include <cerrno>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "src/common/base/base.h"
 #include "src/common/base/byte_utils.h"
 #include "src/common/base/statusor.h"
 #include "src/common/fs/fs_wrapper.h"
@@ -41,6 +49,39 @@ using ::px::stirling::java::hsperf::ParseHsperfData;
 using ::px::system::ProcParser;
 using ::px::utils::LEndianBytesToInt;
 
+namespace {
+
+constexpr std::string_view kYoungGCTimeSuffix = "gc.collector.0.time";
+constexpr std::string_view kFullGCTimeSuffix = "gc.collector.1.time";
+constexpr std::string_view kUsedHeapSizeSuffixes[] = {
+    "gc.generation.0.space.0.used",
+    "gc.generation.0.space.1.used",
+    "gc.generation.0.space.2.used",
+    "gc.generation.1.space.0.used",
+};
+constexpr std::string_view kTotalHeapSizeSuffixes[] = {
+    "gc.generation.0.space.0.capacity",
+    "gc.generation.0.space.1.capacity",
+    "gc.generation.0.space.2.capacity",
+    "gc.generation.1.space.0.capacity",
+};
+constexpr std::string_view kMaxHeapSizeSuffixes[] = {
+    "gc.generation.0.maxCapacity",
+    "gc.generation.1.maxCapacity",
+};
+
+template <size_t N>
+bool EndsWithAny(std::string_view name, const std::string_view (&suffixes)[N]) {
+  for (const auto& suffix : suffixes) {
+    if (absl::EndsWith(name, suffix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 Stats::Stats(std::vector<Stat> stats) : stats_(std::move(stats)) {}
 
 Stats::Stats(std::string hsperf_data_str) : hsperf_data_(std::move(hsperf_data_str)) {}
@@ -58,33 +99,27 @@ Status Stats::Parse() {
   return Status::OK();
 }
 
-uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix("gc.collector.0.time"); }
+bool Stats::IsUsed(std::string_view name) {
+  return absl::EndsWith(name, kYoungGCTimeSuffix) || absl::EndsWith(name, kFullGCTimeSuffix) ||
+         EndsWithAny(name, kUsedHeapSizeSuffixes) || EndsWithAny(name, kTotalHeapSizeSuffixes) ||
+         EndsWithAny(name, kMaxHeapSizeSuffixes);
+}
 
-uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix("gc.collector.1.time"); }
+uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix(kYoungGCTimeSuffix); }
+
+uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix(kFullGCTimeSuffix); }
 
 uint64_t Stats::UsedHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.used",
-      "gc.generation.0.space.1.used",
-      "gc.generation.0.space.2.used",
-      "gc.generation.1.space.0.used",
-  });
+  return SumStatsForSuffixes({std::begin(kUsedHeapSizeSuffixes), std::end(kUsedHeapSizeSuffixes)});
 }
 
 uint64_t Stats::TotalHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.capacity",
-      "gc.generation.0.space.1.capacity",
-      "gc.generation.0.space.2.capacity",
-      "gc.generation.1.space.0.capacity",
-  });
+  return SumStatsForSuffixes(
+      {std::begin(kTotalHeapSizeSuffixes), std::end(kTotalHeapSizeSuffixes)});
 }
 
 uint64_t Stats::MaxHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.maxCapacity",
-      "gc.generation.1.maxCapacity",
-  });
+  return SumStatsForSuffixes({std::begin(kMaxHeapSizeSuffixes), std::end(kMaxHeapSizeSuffixes)});
 }
 
 uint64_t Stats::StatForSuffix(std::string_view suffix) const {
@@ -104,6 +139,82 @@ uint64_t Stats::SumStatsForSuffixes(const std::vector<std::string_view>& suffixe
   return sum;
 }
 
+StatusOr<std::unique_ptr<HsperfdataReader>> HsperfdataReader::Create(
+    const std::filesystem::path& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open $0 ($1)", path.string(), std::strerror(errno));
+  }
+  DEFER(close(fd));
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return error::Internal("Failed to stat $0 ($1)", path.string(), std::strerror(errno));
+  }
+  if (static_cast<size_t>(st.st_size) < sizeof(hsperf::Prologue)) {
+    return error::Internal("$0 is too small [size=$1]", path.string(), st.st_size);
+  }
+
+  // The JVM creates the file with its final size, and never grows it.
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    return error::Internal("Failed to mmap $0 ($1)", path.string(), std::strerror(errno));
+  }
+  return std::unique_ptr<HsperfdataReader>(
+      new HsperfdataReader(static_cast<const uint8_t*>(data), st.st_size));
+}
+
+HsperfdataReader::~HsperfdataReader() { munmap(const_cast<uint8_t*>(data_), size_); }
+
+Status HsperfdataReader::LocateEntries() {
+  entry_offsets_.clear();
+
+  hsperf::HsperfData hsperf_data = {};
+  PL_RETURN_IF_ERROR(ParseHsperfData(
+      std::string_view(reinterpret_cast<const char*>(data_), size_), &hsperf_data));
+  for (const auto& entry : hsperf_data.data_entries) {
+    if (entry.header->data_type != static_cast<uint8_t>(hsperf::DataType::kLong) ||
+        !Stats::IsUsed(entry.name)) {
+      continue;
+    }
+    const size_t offset = reinterpret_cast<const uint8_t*>(entry.data.data()) - data_;
+    if (offset + sizeof(uint64_t) > size_) {
+      continue;
+    }
+    entry_offsets_.emplace_back(entry.name, offset);
+  }
+
+  located_num_entries_ = hsperf_data.prologue->num_entries;
+  located_used_ = hsperf_data.prologue->used;
+  values_.clear();
+  return Status::OK();
+}
+
+StatusOr<Stats> HsperfdataReader::Read() {
+  const auto* prologue = reinterpret_cast<const hsperf::Prologue*>(data_);
+  if (prologue->accessible == 0) {
+    return error::ResourceUnavailable("The JVM has not finished initializing hsperfdata.");
+  }
+  if (located_num_entries_ == 0 || prologue->num_entries != located_num_entries_ ||
+      prologue->used != located_used_) {
+    PL_RETURN_IF_ERROR(LocateEntries());
+  }
+
+  std::vector<Stats::Stat> stats;
+  stats.reserve(entry_offsets_.size());
+  changed_ = values_.size() != entry_offsets_.size();
+  values_.resize(entry_offsets_.size());
+  for (size_t i = 0; i < entry_offsets_.size(); ++i) {
+    const auto& [name, offset] = entry_offsets_[i];
+    auto value = LEndianBytesToInt<uint64_t>(
+        std::string_view(reinterpret_cast<const char*>(data_) + offset, sizeof(uint64_t)));
+    changed_ |= value != values_[i];
+    values_[i] = value;
+    stats.push_back({name, value});
+  }
+  return Stats(std::move(stats));
+}
+
 StatusOr<std::filesystem::path> HsperfdataPath(pid_t pid) {
   const system::Config& sysconfig = system::Config::GetInstance();
   const std::filesystem::path& host_path = sysconfig.host_path();
@@ -19,11 +19,13 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "src/common/base/mixins.h"
 #include "src/common/base/statusor.h"
 
 namespace px {
@@ -45,6 +47,11 @@ class Stats {
   explicit Stats(std::vector<Stat> stats);
   explicit Stats(std::string hsperf_data);
 
+  /**
+   * Returns true if the stat is used to compute any of the values below.
+   */
+  static bool IsUsed(std::string_view name);
+
   /**
    * Parses the held hsperf data into structured stats.
    */
@@ -64,6 +71,47 @@ class Stats {
   std::vector<Stat> stats_;
 };
 
+/**
+ * HsperfdataReader keeps the hsperfdata file of a JVM mapped. The JVM updates the counters in
+ * place, so the entries used by Stats are located once, and each read only loads their values,
+ * without any file IO or parsing. The entries are located again when the JVM adds entries.
+ */
+class HsperfdataReader : public NotCopyable {
+ public:
+  static StatusOr<std::unique_ptr<HsperfdataReader>> Create(const std::filesystem::path& path);
+
+  ~HsperfdataReader();
+
+  /**
+   * Reads the current values of the stats.
+   */
+  StatusOr<Stats> Read();
+
+  /**
+   * Returns true if the last Read() returned different values than the one before it.
+   */
+  bool changed() const { return changed_; }
+
+ private:
+  HsperfdataReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  Status LocateEntries();
+
+  const uint8_t* data_;
+  size_t size_;
+
+  // The values of the prologue when the entries were located.
+  uint32_t located_num_entries_ = 0;
+  uint32_t located_used_ = 0;
+
+  // The names of the long entries used by Stats, and the offsets of their values in the file.
+  // The names point into the mapped file.
+  std::vector<std::pair<std::string_view, size_t>> entry_offsets_;
+
+  std::vector<uint64_t> values_;
+  bool changed_ = true;
+};
+
 /**
  * Returns the path of the hsperfdata for a JVM process.
  */
@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 
@@ -59,6 +60,29 @@ TEST(StatsTest, CommonValues) {
   EXPECT_EQ(2, stats.MaxHeapSizeBytes());
 }
 
+// Tests that the mapped reader returns the same stats as parsing the whole file.
+TEST(HsperfdataReaderTest, ReadsSameStatsAsParse) {
+  const std::string path =
+      testing::TestFilePath("src/stirling/source_connectors/jvm_stats/utils/test_hsperfdata");
+  ASSERT_OK_AND_ASSIGN(std::string content, ReadFileToString(path));
+  Stats parsed_stats(std::move(content));
+  ASSERT_OK(parsed_stats.Parse());
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<HsperfdataReader> reader, HsperfdataReader::Create(path));
+  ASSERT_OK_AND_ASSIGN(Stats stats, reader->Read());
+  EXPECT_TRUE(reader->changed());
+  EXPECT_EQ(stats.YoungGCTimeNanos(), parsed_stats.YoungGCTimeNanos());
+  EXPECT_EQ(stats.FullGCTimeNanos(), parsed_stats.FullGCTimeNanos());
+  EXPECT_EQ(stats.UsedHeapSizeBytes(), parsed_stats.UsedHeapSizeBytes());
+  EXPECT_EQ(stats.TotalHeapSizeBytes(), parsed_stats.TotalHeapSizeBytes());
+  EXPECT_EQ(stats.MaxHeapSizeBytes(), parsed_stats.MaxHeapSizeBytes());
+  EXPECT_GT(stats.MaxHeapSizeBytes(), 0);
+
+  // The file does not change, so neither do the stats.
+  ASSERT_OK(reader->Read());
+  EXPECT_FALSE(reader->changed());
+}
+
 TEST(HsperfdataPathTest, ResultIsAsExpected) {
   const char kClassPath[] = "src/stirling/source_connectors/jvm_stats/testing/HelloWorld.jar";
   const std::string class_path = testing::TestFilePath(kClassPath);
@@ -25,6 +25,7 @@
 
 #include "src/common/base/base.h"
 #include "src/common/system/proc_parser.h"
+#include "src/common/system/socket_info.h"
 #include "src/shared/metadata/metadata.h"
 
 namespace px {
@@ -54,6 +55,7 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
   const md::K8sMetadataState& k8s_md = ctx->GetK8SMetadata();
 
   int64_t timestamp = CurrentTimeNS();
+  netns_stats_.clear();
 
   for (const auto& [pod_name, pod_id] : k8s_md.pods_by_name()) {
     PL_UNUSED(pod_name);
@@ -65,7 +67,8 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
     }
 
     ProcParser::NetworkStats stats;
-    auto s = GetNetworkStatsForPod(*proc_parser_, *pod_info, k8s_md, &stats);
+    auto s = GetNetworkStatsForPod(*proc_parser_, sysconfig_.proc_path(), *pod_info, k8s_md,
+                                   &netns_stats_, &stats);
 
     if (!s.ok()) {
       VLOG(1) << absl::StrCat("Failed to get Pod network stats: ", s.msg());
@@ -88,8 +91,10 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
 }
 
 Status NetworkStatsConnector::GetNetworkStatsForPod(const system::ProcParser& proc_parser,
+                                                    const std::filesystem::path& proc_path,
                                                     const md::PodInfo& pod_info,
                                                     const md::K8sMetadataState& k8s_metadata_state,
+                                                    NetNamespaceStats* netns_stats,
                                                     system::ProcParser::NetworkStats* stats) {
   DCHECK(stats != nullptr);
   // Since all the containers running in a K8s pod use the same network
@@ -110,8 +115,22 @@ Status NetworkStatsConnector::GetNetworkStatsForPod(const system::ProcParser& pr
     }
 
     for (const auto& upid : container_info->active_upids()) {
+      StatusOr<uint32_t> netns = system::NetNamespace(proc_path, upid.pid());
+      if (netns.ok()) {
+        auto iter = netns_stats->find(netns.ValueOrDie());
+        if (iter != netns_stats->end()) {
+          *stats = iter->second;
+          return Status::OK();
+        }
+      }
+
+      // A failed read may leave partial stats behind.
+      stats->Clear();
       auto s = proc_parser.ParseProcPIDNetDev(upid.pid(), stats);
       if (s.ok()) {
+        if (netns.ok()) {
+          netns_stats->emplace(netns.ValueOrDie(), *stats);
+        }
         // Since we just need to read one pid, we can bail on the first successful read.
         return s;
       }
@@ -18,12 +18,15 @@
 
 #pragma once
 
+#include <filesystem>
 #include <map>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/base/base.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/metadata.h"
@@ -64,12 +67,21 @@ class NetworkStatsConnector : public SourceConnector {
  private:
   void TransferNetworkStatsTable(ConnectorContext* ctx, DataTable* data_table);
 
+  // The stats of a network namespace, by its inode number.
+  using NetNamespaceStats = absl::flat_hash_map<uint32_t, system::ProcParser::NetworkStats>;
+
+  // Uses, and adds to, the stats of the network namespaces already read in netns_stats.
   static Status GetNetworkStatsForPod(const system::ProcParser& proc_parser,
+                                      const std::filesystem::path& proc_path,
                                       const md::PodInfo& pod_info,
                                       const md::K8sMetadataState& k8s_metadata_state,
+                                      NetNamespaceStats* netns_stats,
                                       system::ProcParser::NetworkStats* stats);
 
   std::unique_ptr<system::ProcParser> proc_parser_;
+  // The network namespaces read in the current iteration. Pods share one when they run in the
+  // network of the host, so its /proc/<pid>/net/dev is only read once for all of them.
+  NetNamespaceStats netns_stats_;
 };
 
 }  // namespace stirling
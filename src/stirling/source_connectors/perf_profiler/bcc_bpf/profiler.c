@@ -27,6 +27,7 @@
 
 #include <linux/bpf_perf_event.h>
 
+#include "src/stirling/bpf_tools/bcc_bpf/cgroup_filter.h"
 #include "src/stirling/bpf_tools/bcc_bpf/task_struct_utils.h"
 #include "src/stirling/bpf_tools/bcc_bpf/utils.h"
 #include "src/stirling/source_connectors/perf_profiler/bcc_bpf_intf/stack_event.h"
@@ -70,6 +71,7 @@
 // Here, we compute the number of expected stack traces (used to allocate space
 // in the shared BPF maps) per the notes above. NCPUS, TRANSFER_PERIOD, and SAMPLE_PERIOD
 // pre-processor defines specified on the compiler command line (e.g. -DNCPUS=24).
+// SELF_PROFILE, when defined, enables tagging the samples of our own agent threads.
 
 #define DIV_ROUND_UP(NUM, DEN) ((NUM + DEN - 1) / DEN)
 
@@ -94,6 +96,10 @@ BPF_STACK_TRACE(stack_traces_b, kNumMapEntries);
 BPF_ARRAY(profiler_state, uint64_t, kProfilerStateVectorSize);
 
 int sample_call_stack(struct bpf_perf_event_data* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   int transfer_count_idx = kTransferCountIdx;
   int sample_count_a_idx = kSampleCountAIdx;
   int sample_count_b_idx = kSampleCountAIdx;
@@ -115,9 +121,21 @@ int sample_call_stack(struct bpf_perf_event_data* ctx) {
 
   // Create map key.
   struct stack_trace_key_t key = {};
-  key.upid.tgid = bpf_get_current_pid_tgid() >> 32;
+  const uint64_t pid_tgid = bpf_get_current_pid_tgid();
+  key.upid.tgid = pid_tgid >> 32;
   key.upid.start_time_ticks = get_tgid_start_time();
 
+#ifdef SELF_PROFILE
+  // Our agents name their threads "px_<role>"; keep the tid of those samples,
+  // so that user space can attribute them to a thread role.
+  // TASK_COMM_LEN is not defined here, so it is hardcoded.
+  char comm[16];
+  if (bpf_get_current_comm(&comm, sizeof(comm)) == 0 && comm[0] == 'p' && comm[1] == 'x' &&
+      comm[2] == '_') {
+    key.tid = (uint32_t)pid_tgid;
+  }
+#endif
+
   uint64_t sample_count = 0;
 
   if (transfer_count % 2 == 0) {
@@ -48,6 +48,24 @@ struct stack_trace_key_t {
 
   // kernel_stack_id, an index into the stack-traces map.
   int kernel_stack_id;
+
+  // tid, set only when self-profiling and the sample is from one of our own agent threads
+  // (its name starts with "px_"); zero otherwise, so other processes' samples still collapse
+  // across threads.
+  uint32_t tid;
+
+#ifdef __cplusplus
+  friend inline bool operator==(const stack_trace_key_t& lhs, const stack_trace_key_t& rhs) {
+    return (lhs.upid == rhs.upid) && (lhs.user_stack_id == rhs.user_stack_id) &&
+           (lhs.kernel_stack_id == rhs.kernel_stack_id) && (lhs.tid == rhs.tid);
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const stack_trace_key_t& key) {
+    return H::combine(std::move(h), key.upid, key.user_stack_id, key.kernel_stack_id,
+                           key.tid);
+  }
+#endif
 };
 
 // Bit positions in the error status bitfield:
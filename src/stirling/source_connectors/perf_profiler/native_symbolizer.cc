@@ -0,0 +1,239 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/native_symbolizer.h"
+
+#include <llvm/Demangle/Demangle.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <utility>
+
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+#include "src/common/system/config.h"
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+bool ParseHex(std::string_view str, uint64_t* val) {
+  absl::ConsumePrefix(&str, "0x");
+  const char* end = str.data() + str.size();
+  auto [ptr, ec] = std::from_chars(str.data(), end, *val, 16);
+  return ec == std::errc() && ptr == end;
+}
+
+std::string AddrToHex(uintptr_t addr) { return absl::StrFormat("0x%016llx", addr); }
+
+}  // namespace
+
+NativeSymbolizer::NativeSymbolizer(std::chrono::steady_clock::duration min_reload_interval)
+    : min_reload_interval_(min_reload_interval), proc_parser_(system::Config::GetInstance()) {}
+
+void NativeSymbolizer::UpdatePerfMap(const std::filesystem::path& path, PerfMap* perf_map) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    // Most processes don't have a perf map.
+    *perf_map = PerfMap();
+    return;
+  }
+  const auto size = static_cast<uint64_t>(st.st_size);
+  if (path != perf_map->path || st.st_ino != perf_map->inode || size < perf_map->offset) {
+    *perf_map = PerfMap();
+    perf_map->path = path;
+    perf_map->inode = st.st_ino;
+  }
+  if (size == perf_map->offset) {
+    return;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file.seekg(perf_map->offset)) {
+    return;
+  }
+  std::string content(size - perf_map->offset, '\0');
+  file.read(content.data(), content.size());
+  content.resize(file.gcount());
+  // The runtime may be in the middle of writing a line; it is parsed on the next update.
+  const size_t last_newline = content.rfind('\n');
+  if (last_newline == std::string::npos) {
+    return;
+  }
+  content.resize(last_newline + 1);
+  perf_map->offset += content.size();
+
+  std::vector<JITSymbol> symbols;
+  std::vector<std::string_view> lines = absl::StrSplit(content, "\n", absl::SkipWhitespace());
+  for (const auto line : lines) {
+    std::vector<std::string_view> fields = absl::StrSplit(line, absl::MaxSplits(' ', 2));
+    JITSymbol symbol;
+    if (fields.size() != 3 || !ParseHex(fields[0], &symbol.addr) ||
+        !ParseHex(fields[1], &symbol.size)) {
+      VLOG(1) << absl::Substitute("Ignoring malformed line in $0: $1", path.string(), line);
+      continue;
+    }
+    symbol.name = fields[2];
+    symbols.push_back(std::move(symbol));
+  }
+
+  // Both sorts are stable, so that code recompiled at a reused address resolves to the newest
+  // entry (see Resolve()).
+  auto by_addr = [](const JITSymbol& a, const JITSymbol& b) { return a.addr < b.addr; };
+  std::stable_sort(symbols.begin(), symbols.end(), by_addr);
+  const auto num_old_symbols = static_cast<std::ptrdiff_t>(perf_map->symbols.size());
+  perf_map->symbols.insert(perf_map->symbols.end(), std::make_move_iterator(symbols.begin()),
+                           std::make_move_iterator(symbols.end()));
+  std::inplace_merge(perf_map->symbols.begin(), perf_map->symbols.begin() + num_old_symbols,
+                     perf_map->symbols.end(), by_addr);
+}
+
+std::shared_ptr<obj_tools::ElfReader> NativeSymbolizer::GetElfReader(
+    int pid, const system::ProcParser::ProcessMap& map) {
+  const std::string key = absl::StrCat(map.dev, ":", map.inode);
+  std::weak_ptr<obj_tools::ElfReader>& cached = elf_readers_[key];
+  std::shared_ptr<obj_tools::ElfReader> elf_reader = cached.lock();
+  if (elf_reader != nullptr) {
+    return elf_reader;
+  }
+
+  // The path is in the mount namespace of the process.
+  const std::filesystem::path path = system::Config::GetInstance().proc_path() /
+                                     std::to_string(pid) / "root" /
+                                     std::filesystem::path(map.pathname).relative_path();
+  StatusOr<std::unique_ptr<obj_tools::ElfReader>> elf_reader_or =
+      obj_tools::ElfReader::Create(path.string());
+  if (!elf_reader_or.ok()) {
+    VLOG(1) << absl::Substitute("Could not read symbols of $0: $1", path.string(),
+                                elf_reader_or.msg());
+    elf_readers_.erase(key);
+    return nullptr;
+  }
+  elf_reader = std::move(elf_reader_or.ValueOrDie());
+  cached = elf_reader;
+  return elf_reader;
+}
+
+Status NativeSymbolizer::LoadProcessSymbols(int pid, ProcessSymbols* process) {
+  process->load_time = std::chrono::steady_clock::now();
+
+  std::vector<system::ProcParser::ProcessMap> maps;
+  PL_RETURN_IF_ERROR(proc_parser_.ReadProcessMaps(pid, &maps));
+
+  process->mappings.clear();
+  for (const auto& map : maps) {
+    if (!map.executable()) {
+      continue;
+    }
+    Mapping& mapping = process->mappings.emplace_back();
+    mapping.vmem_start = map.vmem_start;
+    mapping.vmem_end = map.vmem_end;
+    mapping.file_offset = map.file_offset;
+    if (map.inode != 0 && !map.pathname.empty()) {
+      mapping.elf_reader = GetElfReader(pid, map);
+    }
+  }
+
+  // The runtime names the perf map with the pid as seen in its own pid namespace.
+  std::vector<std::string> ns_pids;
+  std::string ns_pid = std::to_string(pid);
+  if (proc_parser_.ReadNSPid(pid, &ns_pids).ok() && !ns_pids.empty()) {
+    ns_pid = ns_pids.back();
+  }
+  UpdatePerfMap(system::Config::GetInstance().proc_path() / std::to_string(pid) / "root/tmp" /
+                    absl::StrCat("perf-", ns_pid, ".map"),
+                &process->perf_map);
+
+  return Status::OK();
+}
+
+std::optional<std::string> NativeSymbolizer::Resolve(const ProcessSymbols& process,
+                                                     uintptr_t addr) {
+  auto mapping_iter =
+      std::upper_bound(process.mappings.begin(), process.mappings.end(), addr,
+                       [](uintptr_t a, const Mapping& m) { return a < m.vmem_start; });
+  if (mapping_iter != process.mappings.begin()) {
+    const Mapping& mapping = *std::prev(mapping_iter);
+    if (addr < mapping.vmem_end && mapping.elf_reader != nullptr) {
+      StatusOr<uint64_t> vaddr_or = mapping.elf_reader->FileOffsetToVirtualAddr(
+          addr - mapping.vmem_start + mapping.file_offset);
+      if (vaddr_or.ok()) {
+        StatusOr<std::string> symbol_or =
+            mapping.elf_reader->InstrAddrToSymbol(vaddr_or.ValueOrDie());
+        if (symbol_or.ok()) {
+          return llvm::demangle(symbol_or.ValueOrDie());
+        }
+      }
+      return std::nullopt;
+    }
+  }
+
+  const std::vector<JITSymbol>& jit_symbols = process.perf_map.symbols;
+  auto jit_iter = std::upper_bound(jit_symbols.begin(), jit_symbols.end(), addr,
+                                   [](uintptr_t a, const JITSymbol& s) { return a < s.addr; });
+  if (jit_iter != jit_symbols.begin()) {
+    const JITSymbol& symbol = *std::prev(jit_iter);
+    if (addr < symbol.addr + symbol.size) {
+      return symbol.name;
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::string NativeSymbolizer::Symbolize(int pid, uintptr_t addr) {
+  auto [iter, inserted] = processes_.try_emplace(pid, nullptr);
+  if (inserted) {
+    iter->second = std::make_unique<ProcessSymbols>();
+    Status s = LoadProcessSymbols(pid, iter->second.get());
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Could not read the maps of pid=$0: $1", pid,
+                                                 s.msg());
+  }
+  ProcessSymbols* process = iter->second.get();
+
+  std::optional<std::string> symbol = Resolve(*process, addr);
+  if (!symbol.has_value() &&
+      std::chrono::steady_clock::now() - process->load_time >= min_reload_interval_) {
+    Status s = LoadProcessSymbols(pid, process);
+    if (s.ok()) {
+      symbol = Resolve(*process, addr);
+    }
+  }
+
+  return symbol.has_value() ? std::move(symbol.value()) : AddrToHex(addr);
+}
+
+void NativeSymbolizer::FlushProcess(int pid) {
+  processes_.erase(pid);
+
+  // Drop the entries of the files that no remaining process maps.
+  for (auto iter = elf_readers_.begin(); iter != elf_readers_.end();) {
+    if (iter->second.expired()) {
+      elf_readers_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
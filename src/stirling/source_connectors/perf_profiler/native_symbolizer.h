@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/common/system/proc_parser.h"
+#include "src/stirling/obj_tools/elf_tools.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * NativeSymbolizer resolves the user space addresses of a process to symbols, using
+ * /proc/<pid>/maps and the (indexed) symbol tables of the mapped ELF files, without going
+ * through BCC.
+ *
+ * The ElfReader of a file is shared by all the processes that map it (files are identified by
+ * device and inode), and is released once none of these processes is tracked anymore.
+ *
+ * Addresses in code generated at runtime are resolved with the perf map of the process
+ * (/tmp/perf-<pid>.map), for runtimes that write one (e.g. Java with perf-map-agent, or
+ * node --perf-basic-prof). Perf maps are append-only and can grow to many MBs, so only the lines
+ * appended since the previous read are parsed when the process symbols are reloaded.
+ */
+class NativeSymbolizer : public NotCopyMoveable {
+ public:
+  // Addresses that could not be resolved trigger a reload of the process symbols (e.g. to pick up
+  // libraries loaded by dlopen(), or newly compiled code), but no more often than this.
+  static constexpr auto kDefaultMinReloadInterval = std::chrono::seconds(10);
+
+  explicit NativeSymbolizer(
+      std::chrono::steady_clock::duration min_reload_interval = kDefaultMinReloadInterval);
+
+  /**
+   * Returns the symbol of the address, or the address in hex if it could not be resolved.
+   */
+  std::string Symbolize(int pid, uintptr_t addr);
+
+  /**
+   * Forgets the process, and releases the ElfReaders that only it was using.
+   */
+  void FlushProcess(int pid);
+
+  size_t num_processes() const { return processes_.size(); }
+  size_t num_elf_readers() const { return elf_readers_.size(); }
+
+ private:
+  struct Mapping {
+    uint64_t vmem_start;
+    uint64_t vmem_end;
+    uint64_t file_offset;
+    // Null if the file could not be read (e.g. [vdso], or a deleted file).
+    std::shared_ptr<obj_tools::ElfReader> elf_reader;
+  };
+
+  struct JITSymbol {
+    uint64_t addr;
+    uint64_t size;
+    std::string name;
+  };
+
+  struct PerfMap {
+    std::filesystem::path path;
+    // The file read so far. A different file, or a truncated one, is read again from the start.
+    ino_t inode = 0;
+    // Number of bytes parsed so far. Only complete lines are parsed.
+    uint64_t offset = 0;
+    // In address order. For the same address, the latest entry comes last.
+    std::vector<JITSymbol> symbols;
+  };
+
+  struct ProcessSymbols {
+    // Executable mappings, in address order.
+    std::vector<Mapping> mappings;
+    PerfMap perf_map;
+    std::chrono::steady_clock::time_point load_time;
+  };
+
+  // Parses the lines appended to the perf map since the previous call.
+  // Each line is: <start addr> <size> <symbol>, with the numbers in hex.
+  static void UpdatePerfMap(const std::filesystem::path& path, PerfMap* perf_map);
+
+  Status LoadProcessSymbols(int pid, ProcessSymbols* process);
+  std::shared_ptr<obj_tools::ElfReader> GetElfReader(
+      int pid, const system::ProcParser::ProcessMap& map);
+  static std::optional<std::string> Resolve(const ProcessSymbols& process, uintptr_t addr);
+
+  const std::chrono::steady_clock::duration min_reload_interval_;
+
+  system::ProcParser proc_parser_;
+
+  absl::flat_hash_map<int, std::unique_ptr<ProcessSymbols>> processes_;
+
+  // Keyed by <dev>:<inode> of the files.
+  absl::flat_hash_map<std::string, std::weak_ptr<obj_tools::ElfReader>> elf_readers_;
+};
+
+}  // namespace stirling
+}  // namespace px
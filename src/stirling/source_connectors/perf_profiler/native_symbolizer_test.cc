@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/perf_profiler/native_symbolizer.h"
+
+namespace test {
+// Not used directly; their addresses are symbolized by the test.
+void NativeFoo() { LOG(INFO) << "NativeFoo()."; }
+void NativeBar() { LOG(INFO) << "NativeBar()."; }
+}  // namespace test
+
+namespace px {
+namespace stirling {
+
+using ::testing::MatchesRegex;
+
+TEST(NativeSymbolizerTest, SymbolizeSelf) {
+  NativeSymbolizer symbolizer;
+  const int pid = getpid();
+
+  const uintptr_t foo_addr = reinterpret_cast<uintptr_t>(&::test::NativeFoo);
+  const uintptr_t bar_addr = reinterpret_cast<uintptr_t>(&::test::NativeBar);
+
+  EXPECT_EQ(symbolizer.Symbolize(pid, foo_addr), "test::NativeFoo()");
+  // An address inside the body of the function.
+  EXPECT_EQ(symbolizer.Symbolize(pid, foo_addr + 1), "test::NativeFoo()");
+  EXPECT_EQ(symbolizer.Symbolize(pid, bar_addr), "test::NativeBar()");
+  EXPECT_EQ(symbolizer.num_processes(), 1);
+  EXPECT_GE(symbolizer.num_elf_readers(), 1);
+
+  // Not a mapped address.
+  EXPECT_THAT(symbolizer.Symbolize(pid, 8), MatchesRegex("0x0+8"));
+
+  symbolizer.FlushProcess(pid);
+  EXPECT_EQ(symbolizer.num_processes(), 0);
+  EXPECT_EQ(symbolizer.num_elf_readers(), 0);
+}
+
+TEST(NativeSymbolizerTest, PerfMap) {
+  const int pid = getpid();
+  const std::string perf_map_path = absl::StrCat("/tmp/perf-", pid, ".map");
+  {
+    std::ofstream perf_map(perf_map_path);
+    perf_map << "10000 100 LFoo;bar\n";
+    perf_map << "20000 10 Interpreted frame with spaces\n";
+  }
+
+  NativeSymbolizer symbolizer;
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x10000), "LFoo;bar");
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x100ff), "LFoo;bar");
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x20004), "Interpreted frame with spaces");
+  EXPECT_THAT(symbolizer.Symbolize(pid, 0x10100), MatchesRegex("0x0+10100"));
+
+  std::remove(perf_map_path.c_str());
+}
+
+TEST(NativeSymbolizerTest, PerfMapAppends) {
+  const int pid = getpid();
+  const std::string perf_map_path = absl::StrCat("/tmp/perf-", pid, ".map");
+  std::ofstream perf_map(perf_map_path);
+  perf_map << "10000 100 LFoo;bar\n";
+  // Not complete yet.
+  perf_map << "20000 10 LFoo;ba" << std::flush;
+
+  // Reload the perf map on every miss.
+  NativeSymbolizer symbolizer(std::chrono::seconds(0));
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x10000), "LFoo;bar");
+  EXPECT_THAT(symbolizer.Symbolize(pid, 0x20000), MatchesRegex("0x0+20000"));
+
+  perf_map << "z\n";
+  // The code at 0x10000 was recompiled.
+  perf_map << "10000 80 LFoo;qux\n" << std::flush;
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x20000), "LFoo;baz");
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x10000), "LFoo;qux");
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x1007f), "LFoo;qux");
+
+  // A new (shorter) perf map is read from the start.
+  perf_map.close();
+  std::ofstream(perf_map_path) << "30000 10 LNew\n";
+  EXPECT_EQ(symbolizer.Symbolize(pid, 0x30000), "LNew");
+  EXPECT_THAT(symbolizer.Symbolize(pid, 0x20000), MatchesRegex("0x0+20000"));
+
+  std::remove(perf_map_path.c_str());
+}
+
+}  // namespace stirling
+}  // namespace px
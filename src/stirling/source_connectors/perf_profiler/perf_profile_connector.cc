@@ -18,11 +18,17 @@
 
 #include <sys/sysinfo.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/strings/ascii.h>
+
+#include "src/common/perf/self_profile.h"
+#include "src/common/system/config.h"
 #include "src/stirling/bpf_tools/macros.h"
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
 
@@ -31,24 +37,44 @@ BPF_SRC_STRVIEW(profiler_bcc_script, profiler);
 DEFINE_uint32(stirling_perf_profiler_stats_logging_ratio,
               std::chrono::minutes(10) / px::stirling::PerfProfileConnector::kSamplingPeriod,
               "Sets the frequency of printing perf profiler stats.");
+DEFINE_uint32(stirling_perf_profiler_sampling_period_ms,
+              px::stirling::PerfProfileConnector::kSamplingPeriod.count(),
+              "How often, in milliseconds, stack traces are read out of BPF into the table. "
+              "Clamped to between 5000 and 30000.");
+DEFINE_bool(stirling_profiler_self_profile,
+            gflags::BoolFromEnv("PL_PROFILER_SELF_PROFILE", false),
+            "If true, samples from our own agent threads are tagged with the thread's role, "
+            "and kept as a self-profile that can be queried with _DebugSelfProfile().");
 
 namespace px {
 namespace stirling {
 
 PerfProfileConnector::PerfProfileConnector(std::string_view source_name)
-    : SourceConnector(source_name, kTables) {}
+    : SourceConnector(source_name, kTables),
+      sampling_period_(std::clamp(
+          std::chrono::milliseconds{FLAGS_stirling_perf_profiler_sampling_period_ms},
+          kMinSamplingPeriod, kSamplingPeriod)) {}
 
 Status PerfProfileConnector::InitImpl() {
-  sampling_freq_mgr_.set_period(kSamplingPeriod);
-  push_freq_mgr_.set_period(kPushPeriod);
+  sampling_freq_mgr_.set_period(sampling_period_);
+  push_freq_mgr_.set_period(sampling_period_ / 2);
 
   const size_t ncpus = get_nprocs_conf();
   VLOG(1) << "PerfProfiler: get_nprocs_conf(): " << ncpus;
 
-  const std::vector<std::string> defines = {
+  std::vector<std::string> defines = {
       absl::Substitute("-DNCPUS=$0", ncpus),
-      absl::Substitute("-DTRANSFER_PERIOD=$0", kSamplingPeriod.count()),
+      absl::Substitute("-DTRANSFER_PERIOD=$0", sampling_period_.count()),
       absl::Substitute("-DSAMPLE_PERIOD=$0", kBPFSamplingPeriod.count())};
+  if (FLAGS_stirling_profiler_self_profile) {
+    defines.push_back("-DSELF_PROFILE");
+  }
+  cgroup_filter_ = CGroupFilter::CreateFromFlags();
+  if (cgroup_filter_ != nullptr) {
+    for (auto& cflag : cgroup_filter_->BPFCFlags()) {
+      defines.push_back(std::move(cflag));
+    }
+  }
 
   PL_RETURN_IF_ERROR(InitBPFProgram(profiler_bcc_script, defines));
   PL_RETURN_IF_ERROR(AttachSamplingProbes(kProbeSpecs));
@@ -104,6 +130,25 @@ void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID
   }
 }
 
+px::profiler::ThreadRole PerfProfileConnector::LookupThreadRole(uint32_t pid, uint32_t tid) {
+  auto iter = thread_roles_.find(tid);
+  if (iter != thread_roles_.end()) {
+    return iter->second;
+  }
+
+  const std::filesystem::path comm_path = system::Config::GetInstance().proc_path() /
+                                          std::to_string(pid) / "task" / std::to_string(tid) /
+                                          "comm";
+  px::profiler::ThreadRole role = px::profiler::ThreadRole::kUnknown;
+  StatusOr<std::string> comm_or = ReadFileToString(comm_path);
+  if (comm_or.ok()) {
+    const std::string_view comm = absl::StripTrailingAsciiWhitespace(comm_or.ValueOrDie());
+    role = px::profiler::ThreadRoleFromName(comm);
+  }
+  thread_roles_[tid] = role;
+  return role;
+}
+
 PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces(
     ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces) {
   // TODO(jps): switch from using get_table_offline() to directly stepping through
@@ -120,11 +165,26 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
 
   absl::flat_hash_set<int> k_stack_ids_to_remove;
 
+  // The samples of our own agent threads: stack trace => (thread role, count).
+  absl::flat_hash_map<SymbolicStackTrace, std::pair<px::profiler::ThreadRole, uint64_t>>
+      self_profile_histo;
+
+  // Collapse the samples by stack trace key first, so that each distinct key is stringified
+  // (and its folded string hashed into the histogram) once per iteration, no matter how often
+  // it was sampled. An iteration then costs in proportion to the number of distinct stack traces,
+  // rather than to the number of samples.
+  absl::flat_hash_map<stack_trace_key_t, uint64_t> stack_trace_key_counts;
   for (const auto& stack_trace_key : raw_histo_data_) {
+    ++stack_trace_key_counts[stack_trace_key];
+  }
+
+  for (const auto& [stack_trace_key, count] : stack_trace_key_counts) {
     std::string stack_trace_str;
 
     const md::UPID upid(asid, stack_trace_key.upid.pid, stack_trace_key.upid.start_time_ticks);
-    const bool symbolize = upids_for_symbolization.contains(upid);
+    // Our own threads are always symbolized, since they make up the self-profile.
+    const bool self_sample = stack_trace_key.tid != 0;
+    const bool symbolize = self_sample || upids_for_symbolization.contains(upid);
 
     if (symbolize) {
       // The stringifier clears stack-ids out of the stack traces table when it
@@ -148,10 +208,21 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
       stack_trace_str = std::string(profiler::kNotSymbolizedMessage);
     }
 
+    if (self_sample) {
+      // Root the stack at a frame naming the thread's role, e.g. "[carnot_query];main;...".
+      const px::profiler::ThreadRole role =
+          LookupThreadRole(stack_trace_key.upid.pid, stack_trace_key.tid);
+      stack_trace_str = absl::StrCat("[", px::profiler::ThreadRoleName(role), "]",
+                                     stringifier::kSeparator, stack_trace_str);
+      auto& [histo_role, histo_count] = self_profile_histo[{upid, stack_trace_str}];
+      histo_role = role;
+      histo_count += count;
+    }
+
     SymbolicStackTrace symbolic_stack_trace = {upid, std::move(stack_trace_str)};
 
-    ++symbolic_histogram[symbolic_stack_trace];
-    ++cum_sum_count;
+    symbolic_histogram[symbolic_stack_trace] += count;
+    cum_sum_count += count;
 
     // TODO(jps): If we see a perf. issue with having two maps keyed by symbolic-stack-trace,
     // refactor such that creating/finding symoblic-stack-trace-id and count aggregation
@@ -173,6 +244,18 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
 
   raw_histo_data_.clear();
 
+  if (FLAGS_stirling_profiler_self_profile) {
+    std::vector<px::profiler::SelfProfileSample> self_profile;
+    self_profile.reserve(self_profile_histo.size());
+    for (const auto& [stack_trace, role_and_count] : self_profile_histo) {
+      self_profile.push_back({stack_trace.upid.value(), role_and_count.first,
+                              stack_trace.stack_trace_str, role_and_count.second});
+    }
+    px::profiler::SelfProfile::Global()->Update(CurrentTimeNS(), std::move(self_profile));
+  }
+  // Thread ids are reused, so only trust a role for one iteration.
+  thread_roles_.clear();
+
   VLOG(1) << "PerfProfileConnector::AggregateStackTraces(): cum_sum_count: " << cum_sum_count;
   stats_.Increment(StatKey::kCumulativeSumOfAllStackTraces, cum_sum_count);
   return symbolic_histogram;
@@ -195,7 +278,7 @@ void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, Conn
   StackTraceHisto stack_trace_histogram = AggregateStackTraces(ctx, stack_traces);
 
   constexpr auto age_tick_period = std::chrono::minutes(5);
-  if (sampling_freq_mgr_.count() % (age_tick_period / kSamplingPeriod) == 0) {
+  if (sampling_freq_mgr_.count() % (age_tick_period / sampling_period_) == 0) {
     stack_trace_ids_.AgeTick();
   }
 
@@ -241,6 +324,13 @@ void PerfProfileConnector::TransferDataImpl(ConnectorContext* ctx,
 
   auto* data_table = data_tables[0];
 
+  if (cgroup_filter_ != nullptr) {
+    auto cgroup_filter_map = GetHashTable<uint64_t, uint8_t>(CGroupFilter::kBPFMapName);
+    Status s = cgroup_filter_->UpdateBPFMap(ctx->GetK8SMetadata(), ctx->GetUPIDsGeneration(),
+                                            &cgroup_filter_map);
+    LOG_IF(ERROR, !s.ok()) << s.msg();
+  }
+
   if (data_table == nullptr) {
     return;
   }
@@ -248,7 +338,7 @@ void PerfProfileConnector::TransferDataImpl(ConnectorContext* ctx,
   ProcessBPFStackTraces(ctx, data_table);
 
   // Cleanup the symbolizer so we don't leak memory.
-  proc_tracker_.Update(ctx->GetUPIDs());
+  proc_tracker_.Update(ctx->GetUPIDs(), ctx->GetUPIDsGeneration());
   CleanupSymbolizers(proc_tracker_.deleted_upids());
 
   stats_.Increment(StatKey::kBPFMapSwitchoverEvent, 1);
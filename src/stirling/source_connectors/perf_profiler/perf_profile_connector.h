@@ -23,9 +23,11 @@
 #include <utility>
 #include <vector>
 
+#include "src/common/perf/self_profile.h"
 #include "src/shared/types/types.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/core/cgroup_filter.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/core/types.h"
 #include "src/stirling/source_connectors/perf_profiler/bcc_bpf_intf/stack_event.h"
@@ -58,6 +60,11 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{30000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{15000};
 
+  // The sampling period can be shortened, down to kMinSamplingPeriod, with
+  // --stirling_perf_profiler_sampling_period_ms. The push period remains 1/2 of it.
+  // The BPF maps & perf buffers are sized for kSamplingPeriod, which is also the longest period.
+  static constexpr auto kMinSamplingPeriod = std::chrono::milliseconds{5000};
+
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     return std::unique_ptr<SourceConnector>(new PerfProfileConnector(name));
   }
@@ -85,12 +92,18 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   void CleanupSymbolizers(const absl::flat_hash_set<md::UPID>& deleted_upids);
 
+  // Returns the role of one of our own agent threads, based on its name.
+  px::profiler::ThreadRole LookupThreadRole(uint32_t pid, uint32_t tid);
+
   // data structures shared with BPF:
   std::unique_ptr<ebpf::BPFStackTable> stack_traces_a_;
   std::unique_ptr<ebpf::BPFStackTable> stack_traces_b_;
 
   std::unique_ptr<ebpf::BPFArrayTable<uint64_t>> profiler_state_;
 
+  // See kMinSamplingPeriod.
+  const std::chrono::milliseconds sampling_period_;
+
   // Number of iterations, where each iteration is drains the information collectid in BPF.
   uint64_t transfer_count_ = 0;
 
@@ -110,6 +123,12 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // TODO(oazizi): Investigate ways of sharing across source_connectors.
   ProcTracker proc_tracker_;
 
+  // Only set when the probes filter on cgroups, see CGroupFilter::CreateFromFlags().
+  std::unique_ptr<CGroupFilter> cgroup_filter_;
+
+  // Thread roles resolved during the current iteration, keyed by tid.
+  absl::flat_hash_map<uint32_t, px::profiler::ThreadRole> thread_roles_;
+
   static constexpr auto kProbeSpecs =
       MakeArray<bpf_tools::SamplingProbeSpec>({"sample_call_stack", kBPFSamplingPeriod.count()});
 
@@ -21,13 +21,21 @@
 #include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
 
 DEFINE_bool(stirling_profiler_symcache, true, "Enable the Stirling managed symbol cache.");
+DEFINE_bool(stirling_profiler_native_symbolizer, false,
+            "Resolve user space addresses from the ELF symbol tables of the mapped files, "
+            "instead of through BCC.");
 
 namespace px {
 namespace stirling {
 
 namespace {
-std::string SymbolOrAddrIfUnknown(ebpf::BPFStackTable* bcc_symbolizer, const uintptr_t addr,
+std::string SymbolOrAddrIfUnknown(ebpf::BPFStackTable* bcc_symbolizer,
+                                  NativeSymbolizer* native_symbolizer, const uintptr_t addr,
                                   const int pid) {
+  if (native_symbolizer != nullptr && static_cast<uint32_t>(pid) != profiler::kKernelPIDAsU32) {
+    return native_symbolizer->Symbolize(pid, addr);
+  }
+
   static constexpr std::string_view kUnknown = "[UNKNOWN]";
   std::string sym_or_addr = bcc_symbolizer->get_addr_symbol(addr, pid);
   if (sym_or_addr == kUnknown) {
@@ -37,9 +45,10 @@ std::string SymbolOrAddrIfUnknown(ebpf::BPFStackTable* bcc_symbolizer, const uin
 }
 }  // namespace
 
-SymbolCache::Symbol::Symbol(ebpf::BPFStackTable* bcc_symbolizer, const uintptr_t addr,
+SymbolCache::Symbol::Symbol(ebpf::BPFStackTable* bcc_symbolizer,
+                            NativeSymbolizer* native_symbolizer, const uintptr_t addr,
                             const int pid)
-    : symbol_(SymbolOrAddrIfUnknown(bcc_symbolizer, addr, pid)) {}
+    : symbol_(SymbolOrAddrIfUnknown(bcc_symbolizer, native_symbolizer, addr, pid)) {}
 
 SymbolCache::LookupResult SymbolCache::Lookup(const uintptr_t addr) {
   // Check old cache first, and move result to new cache if we have a hit.
@@ -54,7 +63,8 @@ SymbolCache::LookupResult SymbolCache::Lookup(const uintptr_t addr) {
   }
 
   // If not in old cache, try the new cache (with automatic insertion if required).
-  const auto [iter, inserted] = cache_.try_emplace(addr, symbolizer_, addr, pid_);
+  const auto [iter, inserted] =
+      cache_.try_emplace(addr, symbolizer_, native_symbolizer_, addr, pid_);
   return SymbolCache::LookupResult{iter->second.symbol_, !inserted};
 }
 
@@ -66,6 +76,9 @@ Status Symbolizer::Init() {
   const std::string_view kProgram = "BPF_STACK_TRACE(bcc_symbolizer, 16);";
   PL_RETURN_IF_ERROR(InitBPFProgram(kProgram));
   bcc_symbolizer_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("bcc_symbolizer"));
+  if (FLAGS_stirling_profiler_native_symbolizer) {
+    native_symbolizer_ = std::make_unique<NativeSymbolizer>();
+  }
   return Status::OK();
 }
 
@@ -78,13 +91,21 @@ void Symbolizer::FlushCache(const struct upid_t& upid) {
   // If later the pid is reused, then BCC will re-allocate the pid's symbol
   // symbol cache (when get_addr_symbol() is called).
   bcc_symbolizer_->free_symcache(upid.pid);
+
+  if (native_symbolizer_ != nullptr) {
+    native_symbolizer_->FlushProcess(upid.pid);
+  }
 }
 
 std::string_view Symbolizer::Symbolize(SymbolCache* symbol_cache, const int pid,
                                        const uintptr_t addr) {
   static std::string symbol;
   if (!FLAGS_stirling_profiler_symcache) {
-    symbol = bcc_symbolizer_->get_addr_symbol(addr, pid);
+    if (native_symbolizer_ != nullptr && static_cast<uint32_t>(pid) != profiler::kKernelPIDAsU32) {
+      symbol = native_symbolizer_->Symbolize(pid, addr);
+    } else {
+      symbol = bcc_symbolizer_->get_addr_symbol(addr, pid);
+    }
     return symbol;
   }
 
@@ -106,7 +127,8 @@ std::function<std::string_view(const uintptr_t addr)> Symbolizer::GetSymbolizerF
   using std::placeholders::_1;
   const auto [iter, inserted] = symbol_caches_.try_emplace(upid, nullptr);
   if (inserted) {
-    iter->second = std::make_unique<SymbolCache>(upid.pid, bcc_symbolizer_.get());
+    iter->second =
+        std::make_unique<SymbolCache>(upid.pid, bcc_symbolizer_.get(), native_symbolizer_.get());
   }
   auto& cache = iter->second;
   auto fn = std::bind(&Symbolizer::Symbolize, this, cache.get(), upid.pid, _1);
@@ -22,10 +22,13 @@
 #include <string>
 #include <utility>
 
+#include "src/shared/upid/upid.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/source_connectors/perf_profiler/native_symbolizer.h"
 
 DECLARE_bool(stirling_profiler_symcache);
+DECLARE_bool(stirling_profiler_native_symbolizer);
 
 namespace px {
 namespace stirling {
@@ -37,7 +40,10 @@ static constexpr upid_t kKernelUPID = {.pid = kKernelPIDAsU32, .start_time_ticks
 
 class SymbolCache {
  public:
-  SymbolCache(int pid, ebpf::BPFStackTable* symbolizer) : pid_(pid), symbolizer_(symbolizer) {}
+  // If native_symbolizer is set, it is used instead of BCC to resolve the addresses.
+  SymbolCache(int pid, ebpf::BPFStackTable* symbolizer,
+              NativeSymbolizer* native_symbolizer = nullptr)
+      : pid_(pid), symbolizer_(symbolizer), native_symbolizer_(native_symbolizer) {}
 
   struct LookupResult {
     std::string_view symbol;
@@ -63,13 +69,15 @@ class SymbolCache {
    */
   class Symbol {
    public:
-    Symbol(ebpf::BPFStackTable* bcc_symbolizer, const uintptr_t addr, const int pid);
+    Symbol(ebpf::BPFStackTable* bcc_symbolizer, NativeSymbolizer* native_symbolizer,
+           const uintptr_t addr, const int pid);
     explicit Symbol(std::string&& symbol_str) : symbol_(std::move(symbol_str)) {}
     std::string symbol_;
   };
 
   int pid_;
   ebpf::BPFStackTable* symbolizer_;
+  NativeSymbolizer* native_symbolizer_;
   absl::flat_hash_map<uintptr_t, Symbol> cache_;
   absl::flat_hash_map<uintptr_t, Symbol> prev_cache_;
 };
@@ -82,12 +90,21 @@ class SymbolCache {
  *
  * Symbolizer creates a 'bpf stack table' solely to gain access to the BCC
  * symbolization API (the underlying BPF shared map and BPF program are not used).
+ * If FLAGS_stirling_profiler_native_symbolizer==true, user space addresses are instead
+ * resolved by a NativeSymbolizer; BCC is then only used for kernel addresses.
  *
  * A typical use case looks like this:
  *   auto symbolize_fn = symbolizer.GetSymbolizerFn(upid);
  *   const std::string symbol = symbolize_fn(addr);
  *
  */
+// The symbol caches are looked up for every stack trace, so they use the cheaper UPID hash.
+struct SymbolCacheHash {
+  size_t operator()(const struct upid_t& upid) const {
+    return md::MixUPIDWords(upid.pid, upid.start_time_ticks);
+  }
+};
+
 class Symbolizer : public bpf_tools::BCCWrapper, public NotCopyMoveable {
  public:
   Status Init();
@@ -105,7 +122,11 @@ class Symbolizer : public bpf_tools::BCCWrapper, public NotCopyMoveable {
   // i.e. while this does create a shared BPF "stack trace" map, we do not use that.
   std::unique_ptr<ebpf::BPFStackTable> bcc_symbolizer_;
 
-  absl::flat_hash_map<struct upid_t, std::unique_ptr<SymbolCache>> symbol_caches_;
+  // Only set if FLAGS_stirling_profiler_native_symbolizer is true.
+  std::unique_ptr<NativeSymbolizer> native_symbolizer_;
+
+  absl::flat_hash_map<struct upid_t, std::unique_ptr<SymbolCache>, SymbolCacheHash>
+      symbol_caches_;
 
   int64_t stat_accesses_ = 0;
   int64_t stat_hits_ = 0;
@@ -25,11 +25,16 @@
 
 // LINT_C_FILE: Do not remove this line. It ensures cpplint treats this as a C file.
 
+#include "src/stirling/bpf_tools/bcc_bpf/cgroup_filter.h"
 #include "src/stirling/source_connectors/pid_runtime/bcc_bpf_intf/pidruntime.h"
 
 BPF_HASH(pid_cpu_time, uint16_t, struct pidruntime_val_t);
 
 int trace_pid_runtime(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint16_t cur_pid = bpf_get_current_pid_tgid() >> 32;
 
   struct pidruntime_val_t* cur_val = pid_cpu_time.lookup(&cur_pid);
@@ -31,7 +31,12 @@ namespace stirling {
 Status PIDRuntimeConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
-  PL_RETURN_IF_ERROR(InitBPFProgram(pidruntime_bcc_script));
+  std::vector<std::string> cflags;
+  cgroup_filter_ = CGroupFilter::CreateFromFlags();
+  if (cgroup_filter_ != nullptr) {
+    cflags = cgroup_filter_->BPFCFlags();
+  }
+  PL_RETURN_IF_ERROR(InitBPFProgram(pidruntime_bcc_script, cflags));
   PL_RETURN_IF_ERROR(AttachSamplingProbes(kSamplingProbes));
   return Status::OK();
 }
@@ -41,9 +46,15 @@ Status PIDRuntimeConnector::StopImpl() {
   return Status::OK();
 }
 
-void PIDRuntimeConnector::TransferDataImpl(ConnectorContext* /* ctx */,
+void PIDRuntimeConnector::TransferDataImpl(ConnectorContext* ctx,
                                            const std::vector<DataTable*>& data_tables) {
   DCHECK_EQ(data_tables.size(), 1);
+  if (cgroup_filter_ != nullptr) {
+    auto cgroup_filter_map = GetHashTable<uint64_t, uint8_t>(CGroupFilter::kBPFMapName);
+    Status s = cgroup_filter_->UpdateBPFMap(ctx->GetK8SMetadata(), ctx->GetUPIDsGeneration(),
+                                            &cgroup_filter_map);
+    LOG_IF(ERROR, !s.ok()) << s.msg();
+  }
   DataTable* data_table = data_tables[0];
 
   if (data_table == nullptr) {
@@ -27,6 +27,7 @@
 #include "src/common/base/base.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/core/canonical_types.h"
+#include "src/stirling/core/cgroup_filter.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/source_connectors/pid_runtime/bcc_bpf_intf/pidruntime.h"
 
@@ -76,6 +77,9 @@ class PIDRuntimeConnector : public SourceConnector, public bpf_tools::BCCWrapper
       MakeArray<bpf_tools::SamplingProbeSpec>({"trace_pid_runtime", kSamplingFreqHz});
 
   std::map<uint16_t, uint64_t> prev_run_time_map_;
+
+  // Only set when the probes filter on cgroups, see CGroupFilter::CreateFromFlags().
+  std::unique_ptr<CGroupFilter> cgroup_filter_;
 };
 
 }  // namespace stirling
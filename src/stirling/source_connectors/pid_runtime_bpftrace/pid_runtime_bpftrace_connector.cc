@@ -45,25 +45,6 @@ Status PIDCPUUseBPFTraceConnector::StopImpl() {
   return Status::OK();
 }
 
-// Helper function for searching through a BPFTraceMap vector of key-value pairs.
-// Note that the vector is sorted by keys, and the search is performed sequentially.
-// The search will stop as soon as a key >= the search key is found (not just ==).
-// This serves two purposes:
-// (1) It enables a quicker return.
-// (2) It enables resumed searching, when the next search key is >= the previous search key.
-// The latter is significant when iteratively comparing elements between two sorted vectors,
-// which is the main use case for this function.
-// To enable the resumed searching, this function takes the start iterator as an input.
-bpftrace::BPFTraceMap::iterator PIDCPUUseBPFTraceConnector::BPFTraceMapSearch(
-    const bpftrace::BPFTraceMap& vector, bpftrace::BPFTraceMap::iterator it, uint64_t search_key) {
-  auto next_it =
-      std::find_if(it, const_cast<bpftrace::BPFTraceMap&>(vector).end(),
-                   [&search_key](const std::pair<std::vector<uint8_t>, std::vector<uint8_t>>& x) {
-                     return *(reinterpret_cast<const uint32_t*>(x.first.data())) >= search_key;
-                   });
-  return next_it;
-}
-
 void PIDCPUUseBPFTraceConnector::TransferDataImpl(ConnectorContext* /* ctx */,
                                                   const std::vector<DataTable*>& data_tables) {
   DCHECK_EQ(data_tables.size(), 1) << "PIDCPUUseBPFTraceConnector only has one data table.";
@@ -74,58 +55,57 @@ void PIDCPUUseBPFTraceConnector::TransferDataImpl(ConnectorContext* /* ctx */,
     return;
   }
 
-  auto pid_time_pairs = GetBPFMap("@total_time");
-  auto pid_name_pairs = GetBPFMap("@names");
-
   // This is a special map with only one entry at location 0.
   auto sampling_time = GetBPFMap("@time");
   CHECK_EQ(1ULL, sampling_time.size());
   auto timestamp = *(reinterpret_cast<int64_t*>(sampling_time[0].second.data()));
 
-  auto last_result_it = last_result_times_.begin();
-  auto pid_name_it = pid_name_pairs.begin();
-
-  for (auto& pid_time_pair : pid_time_pairs) {
-    auto key = pid_time_pair.first;
-    auto value = pid_time_pair.second;
-
-    uint64_t cputime = *(reinterpret_cast<uint64_t*>(value.data()));
+  // The script adds the runtime of a PID to @total_time every time the PID is descheduled.
+  // Draining the map yields the runtime since the previous drain, and only visits the PIDs that
+  // ran in between, instead of every PID seen since the connector started.
+  std::vector<std::pair<uint32_t, uint64_t>> pid_runtimes;
+  StatusOr<size_t> num_entries =
+      DrainBPFMap("@total_time", [&pid_runtimes](std::string_view key, std::string_view value) {
+        DCHECK_EQ(4ULL, key.size()) << "Expected uint32_t key";
+        pid_runtimes.emplace_back(utils::MemCpy<uint32_t>(key), utils::MemCpy<uint64_t>(value));
+      });
+  if (!num_entries.ok()) {
+    LOG(ERROR) << absl::Substitute("Failed to drain @total_time: $0", num_entries.msg());
+    return;
+  }
 
-    DCHECK_EQ(4ULL, key.size()) << "Expected uint32_t key";
-    uint64_t pid = *(reinterpret_cast<uint32_t*>(key.data()));
+  // The script writes @names before @total_time, so draining @names after @total_time gets the
+  // names of all the PIDs above. The names of the previous period cover PIDs whose name was
+  // drained just before their runtime was added.
+  absl::flat_hash_map<uint32_t, std::string> names;
+  num_entries = DrainBPFMap("@names", [&names](std::string_view key, std::string_view value) {
+    auto pid = utils::MemCpy<uint32_t>(key);
+    names[pid] = std::string(value.data(), strnlen(value.data(), value.size()));
+  });
+  if (!num_entries.ok()) {
+    LOG(ERROR) << absl::Substitute("Failed to drain @names: $0", num_entries.msg());
+  }
 
-    // Get the name from the auxiliary BPFTraceMap for names.
+  for (const auto& [pid, runtime] : pid_runtimes) {
+    // Get the name from the names drained in this period, or else in the previous one.
     std::string name("-");
-    pid_name_it = BPFTraceMapSearch(pid_name_pairs, pid_name_it, pid);
-    if (pid_name_it != pid_name_pairs.end()) {
-      uint32_t found_pid = *(reinterpret_cast<uint32_t*>(pid_name_it->first.data()));
-      if (found_pid == pid) {
-        name = std::string(reinterpret_cast<char*>(pid_name_it->second.data()));
-      } else {
-        // Couldn't find the name for the PID.
-        LOG(WARNING) << absl::StrFormat("Could not find a name for the PID %d", pid);
-      }
-    }
-
-    // Get the last cpu time from the BPFTraceMap from previous call to this function.
-    uint64_t last_cputime = 0;
-    last_result_it = BPFTraceMapSearch(last_result_times_, last_result_it, pid);
-    if (last_result_it != last_result_times_.end()) {
-      uint32_t found_pid = *(reinterpret_cast<uint32_t*>(last_result_it->first.data()));
-      if (found_pid == pid) {
-        last_cputime = *(reinterpret_cast<uint64_t*>(last_result_it->second.data()));
-      }
+    if (auto iter = names.find(pid); iter != names.end()) {
+      name = iter->second;
+    } else if (auto prev_iter = names_.find(pid); prev_iter != names_.end()) {
+      name = prev_iter->second;
+    } else {
+      // Couldn't find the name for the PID.
+      LOG(WARNING) << absl::StrFormat("Could not find a name for the PID %d", pid);
     }
 
     DataTable::RecordBuilder<&kTable> r(data_table);
     r.Append<r.ColIndex("time_")>(timestamp + ClockRealTimeOffset());
     r.Append<r.ColIndex("pid")>(pid);
-    r.Append<r.ColIndex("runtime_ns")>(cputime - last_cputime);
+    r.Append<r.ColIndex("runtime_ns")>(runtime);
     r.Append<r.ColIndex("cmd")>(std::move(name));
   }
 
-  // Keep this, because we will want to compute deltas next time.
-  last_result_times_ = std::move(pid_time_pairs);
+  names_ = std::move(names);
 }
 
 }  // namespace stirling
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <absl/container/flat_hash_map.h>
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -79,11 +81,8 @@ class PIDCPUUseBPFTraceConnector : public SourceConnector, public bpf_tools::BPF
  private:
   explicit PIDCPUUseBPFTraceConnector(std::string_view name) : SourceConnector(name, kTables) {}
 
-  bpftrace::BPFTraceMap last_result_times_;
-
-  bpftrace::BPFTraceMap::iterator BPFTraceMapSearch(const bpftrace::BPFTraceMap& vector,
-                                                    bpftrace::BPFTraceMap::iterator it,
-                                                    uint64_t search_key);
+  // The names of the PIDs drained from @names in the previous period.
+  absl::flat_hash_map<uint32_t, std::string> names_;
 };
 
 }  // namespace stirling
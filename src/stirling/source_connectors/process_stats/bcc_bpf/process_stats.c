@@ -0,0 +1,223 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// LINT_C_FILE: Do not remove this line. It ensures cpplint treats this as a C file.
+
+#include <linux/mm_types.h>
+#include <linux/sched.h>
+#include <linux/sched/signal.h>
+#include <linux/version.h>
+
+#include "src/stirling/bpf_tools/bcc_bpf/task_struct_utils.h"
+#include "src/stirling/source_connectors/process_stats/bcc_bpf_intf/process_stats.h"
+
+// Keyed by TGID. Entries are removed when the last thread of the process exits.
+BPF_HASH(process_stats, uint32_t, struct process_stats_t, 32768);
+
+// The counters of each thread the last time it was accounted, keyed by TID.
+// Only the difference with the current counters is added to the process.
+BPF_HASH(thread_counters, uint32_t, struct task_counters_t, 131072);
+
+#define READ_FIELD(dst, ptr, field) bpf_probe_read(&(dst), sizeof(dst), &(ptr)->field)
+
+static __inline void read_task_counters(struct task_struct* task, struct task_counters_t* c) {
+  READ_FIELD(c->utime_ns, task, utime);
+  READ_FIELD(c->ktime_ns, task, stime);
+
+  unsigned long flt = 0;
+  READ_FIELD(flt, task, min_flt);
+  c->minor_faults = flt;
+  READ_FIELD(flt, task, maj_flt);
+  c->major_faults = flt;
+
+#ifdef CONFIG_TASK_XACCT
+  READ_FIELD(c->rchar_bytes, task, ioac.rchar);
+  READ_FIELD(c->wchar_bytes, task, ioac.wchar);
+#endif
+#ifdef CONFIG_TASK_IO_ACCOUNTING
+  READ_FIELD(c->read_bytes, task, ioac.read_bytes);
+  READ_FIELD(c->write_bytes, task, ioac.write_bytes);
+#endif
+}
+
+// Reads the counters of the threads of the process that already exited. The kernel adds the
+// counters of a thread to its signal_struct when the thread is released.
+static __inline void read_signal_counters(struct signal_struct* signal,
+                                          struct task_counters_t* c) {
+  READ_FIELD(c->utime_ns, signal, utime);
+  READ_FIELD(c->ktime_ns, signal, stime);
+
+  unsigned long flt = 0;
+  READ_FIELD(flt, signal, min_flt);
+  c->minor_faults = flt;
+  READ_FIELD(flt, signal, maj_flt);
+  c->major_faults = flt;
+
+#ifdef CONFIG_TASK_XACCT
+  READ_FIELD(c->rchar_bytes, signal, ioac.rchar);
+  READ_FIELD(c->wchar_bytes, signal, ioac.wchar);
+#endif
+#ifdef CONFIG_TASK_IO_ACCOUNTING
+  READ_FIELD(c->read_bytes, signal, ioac.read_bytes);
+  READ_FIELD(c->write_bytes, signal, ioac.write_bytes);
+#endif
+}
+
+// Reads the resident set size in pages, like get_mm_rss() does.
+static __inline uint64_t read_mm_rss_pages(struct mm_struct* mm) {
+  int64_t file_pages = 0;
+  int64_t anon_pages = 0;
+  int64_t shmem_pages = 0;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 2, 0)
+  READ_FIELD(file_pages, mm, rss_stat[MM_FILEPAGES].count);
+  READ_FIELD(anon_pages, mm, rss_stat[MM_ANONPAGES].count);
+  READ_FIELD(shmem_pages, mm, rss_stat[MM_SHMEMPAGES].count);
+#else
+  READ_FIELD(file_pages, mm, rss_stat.count[MM_FILEPAGES].counter);
+  READ_FIELD(anon_pages, mm, rss_stat.count[MM_ANONPAGES].counter);
+  READ_FIELD(shmem_pages, mm, rss_stat.count[MM_SHMEMPAGES].counter);
+#endif
+  int64_t pages = file_pages + anon_pages + shmem_pages;
+  // The per-CPU caches of the counters can make the sum transiently negative.
+  return pages > 0 ? pages : 0;
+}
+
+static __inline struct process_stats_t* get_or_init_process_stats(uint32_t tgid,
+                                                                   struct task_struct* task) {
+  uint64_t start_time_ticks = get_tgid_start_time();
+
+  struct process_stats_t* stats = process_stats.lookup(&tgid);
+  if (stats != NULL && stats->start_time_ticks == start_time_ticks) {
+    return stats;
+  }
+
+  // First time the process is seen, or the TGID was reused by a new process.
+  struct process_stats_t new_stats = {};
+  new_stats.start_time_ticks = start_time_ticks;
+
+  struct signal_struct* signal = NULL;
+  READ_FIELD(signal, task, signal);
+  read_signal_counters(signal, &new_stats.counters);
+
+  process_stats.update(&tgid, &new_stats);
+  return process_stats.lookup(&tgid);
+}
+
+#define ACCOUNT_COUNTER(stats, cur, prev, field) \
+  __sync_fetch_and_add(&(stats)->counters.field, (cur).field - (prev).field)
+
+// Adds what the current thread did since it was last accounted to its process.
+static __inline void account_current_task(struct process_stats_t* stats, uint32_t tid,
+                                          struct task_struct* task, bool exiting) {
+  struct task_counters_t cur = {};
+  read_task_counters(task, &cur);
+
+  // A thread that was never seen contributes all its counters, since it started.
+  struct task_counters_t prev = {};
+  struct task_counters_t* prev_ptr = thread_counters.lookup(&tid);
+  if (prev_ptr != NULL) {
+    prev = *prev_ptr;
+  }
+
+  ACCOUNT_COUNTER(stats, cur, prev, utime_ns);
+  ACCOUNT_COUNTER(stats, cur, prev, ktime_ns);
+  ACCOUNT_COUNTER(stats, cur, prev, minor_faults);
+  ACCOUNT_COUNTER(stats, cur, prev, major_faults);
+  ACCOUNT_COUNTER(stats, cur, prev, rchar_bytes);
+  ACCOUNT_COUNTER(stats, cur, prev, wchar_bytes);
+  ACCOUNT_COUNTER(stats, cur, prev, read_bytes);
+  ACCOUNT_COUNTER(stats, cur, prev, write_bytes);
+
+  if (exiting) {
+    thread_counters.delete(&tid);
+  } else {
+    thread_counters.update(&tid, &cur);
+  }
+}
+
+// The tracepoint runs before the context switch, so the current task is the one switched out.
+TRACEPOINT_PROBE(sched, sched_switch) {
+  uint64_t id = bpf_get_current_pid_tgid();
+  uint32_t tgid = id >> 32;
+  uint32_t tid = id;
+  if (tgid == 0) {
+    // The idle task.
+    return 0;
+  }
+
+  struct task_struct* task = (struct task_struct*)bpf_get_current_task();
+  struct mm_struct* mm = NULL;
+  READ_FIELD(mm, task, mm);
+  if (mm == NULL) {
+    // Kernel threads have no memory map, and are not reported by ProcessStatsConnector either.
+    return 0;
+  }
+
+  struct process_stats_t* stats = get_or_init_process_stats(tgid, task);
+  if (stats == NULL) {
+    return 0;
+  }
+  account_current_task(stats, tid, task, /*exiting*/ false);
+
+  struct signal_struct* signal = NULL;
+  READ_FIELD(signal, task, signal);
+  int nr_threads = 0;
+  READ_FIELD(nr_threads, signal, nr_threads);
+  stats->num_threads = nr_threads;
+
+  unsigned long total_vm = 0;
+  READ_FIELD(total_vm, mm, total_vm);
+  stats->vsize_pages = total_vm;
+  stats->rss_pages = read_mm_rss_pages(mm);
+
+  return 0;
+}
+
+TRACEPOINT_PROBE(sched, sched_process_exit) {
+  uint64_t id = bpf_get_current_pid_tgid();
+  uint32_t tgid = id >> 32;
+  uint32_t tid = id;
+
+  struct process_stats_t* stats = process_stats.lookup(&tgid);
+  if (stats == NULL) {
+    thread_counters.delete(&tid);
+    return 0;
+  }
+
+  struct task_struct* task = (struct task_struct*)bpf_get_current_task();
+  account_current_task(stats, tid, task, /*exiting*/ true);
+
+  // do_exit() decrements signal->live before this tracepoint, so it is 0 once the last thread
+  // of the process exits.
+  struct signal_struct* signal = NULL;
+  READ_FIELD(signal, task, signal);
+  int live = 1;
+  READ_FIELD(live, signal, live.counter);
+  if (live == 0) {
+    process_stats.delete(&tgid);
+  }
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+// The cumulative counters of a task, as found in task_struct (and in signal_struct for the
+// threads of a process that have exited).
+struct task_counters_t {
+  uint64_t utime_ns;
+  uint64_t ktime_ns;
+  uint64_t minor_faults;
+  uint64_t major_faults;
+  uint64_t rchar_bytes;
+  uint64_t wchar_bytes;
+  uint64_t read_bytes;
+  uint64_t write_bytes;
+};
+
+// The stats of a process (TGID), updated by BPF every time one of its threads is switched out.
+struct process_stats_t {
+  // Start time of the process in clock ticks, as in /proc/<pid>/stat. Used to build the UPID.
+  uint64_t start_time_ticks;
+  // Summed over all the threads of the process, since it started.
+  struct task_counters_t counters;
+  // Gauges, as of the last time a thread of the process was switched out.
+  uint64_t num_threads;
+  uint64_t vsize_pages;
+  uint64_t rss_pages;
+};
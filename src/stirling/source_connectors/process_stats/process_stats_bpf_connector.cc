@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/process_stats/process_stats_bpf_connector.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/stirling/bpf_tools/macros.h"
+
+BPF_SRC_STRVIEW(process_stats_bcc_script, process_stats);
+
+namespace px {
+namespace stirling {
+
+Status ProcessStatsBPFConnector::InitImpl() {
+  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  push_freq_mgr_.set_period(kPushPeriod);
+
+  PL_RETURN_IF_ERROR(InitBPFProgram(process_stats_bcc_script));
+
+  const std::vector<bpf_tools::TracepointSpec> kTracepoints = {
+      {"sched:sched_switch", "tracepoint__sched__sched_switch"},
+      {"sched:sched_process_exit", "tracepoint__sched__sched_process_exit"},
+  };
+  for (const auto& tracepoint : kTracepoints) {
+    PL_RETURN_IF_ERROR(AttachTracepoint(tracepoint));
+  }
+
+  process_stats_ = std::make_unique<ebpf::BPFHashTable<uint32_t, struct process_stats_t>>(
+      GetHashTable<uint32_t, struct process_stats_t>("process_stats"));
+  return Status::OK();
+}
+
+Status ProcessStatsBPFConnector::StopImpl() {
+  Close();
+  return Status::OK();
+}
+
+void ProcessStatsBPFConnector::TransferDataImpl(ConnectorContext* ctx,
+                                                const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), 1);
+  DataTable* data_table = data_tables[0];
+
+  if (data_table == nullptr) {
+    return;
+  }
+
+  const absl::flat_hash_set<md::UPID>& upids = ctx->GetUPIDs();
+  const uint32_t asid = ctx->GetASID();
+  const int64_t bytes_per_page = sysconfig_.PageSize();
+  const int64_t timestamp = CurrentTimeNS();
+
+  std::vector<std::pair<uint32_t, struct process_stats_t>> items =
+      process_stats_->get_table_offline();
+
+  for (const auto& [tgid, stats] : items) {
+    // Only report the processes of the context, like ProcessStatsConnector does.
+    // This also skips the entries left behind by a process whose PID was reused.
+    md::UPID upid(asid, tgid, stats.start_time_ticks);
+    if (!upids.contains(upid)) {
+      continue;
+    }
+
+    DataTable::RecordBuilder<&kProcessStatsTable> r(data_table, timestamp);
+    r.Append<r.ColIndex("time_")>(timestamp);
+    r.Append<r.ColIndex("upid")>(upid.value());
+    r.Append<r.ColIndex("major_faults")>(stats.counters.major_faults);
+    r.Append<r.ColIndex("minor_faults")>(stats.counters.minor_faults);
+    r.Append<r.ColIndex("cpu_utime_ns")>(stats.counters.utime_ns);
+    r.Append<r.ColIndex("cpu_ktime_ns")>(stats.counters.ktime_ns);
+    r.Append<r.ColIndex("num_threads")>(stats.num_threads);
+    r.Append<r.ColIndex("vsize_bytes")>(stats.vsize_pages * bytes_per_page);
+    r.Append<r.ColIndex("rss_bytes")>(stats.rss_pages * bytes_per_page);
+    r.Append<r.ColIndex("rchar_bytes")>(stats.counters.rchar_bytes);
+    r.Append<r.ColIndex("wchar_bytes")>(stats.counters.wchar_bytes);
+    r.Append<r.ColIndex("read_bytes")>(stats.counters.read_bytes);
+    r.Append<r.ColIndex("write_bytes")>(stats.counters.write_bytes);
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
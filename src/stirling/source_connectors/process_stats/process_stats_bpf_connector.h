@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/core/source_connector.h"
+#include "src/stirling/source_connectors/process_stats/bcc_bpf_intf/process_stats.h"
+#include "src/stirling/source_connectors/process_stats/process_stats_table.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * ProcessStatsBPFConnector fills the same table as ProcessStatsConnector, but from a BPF hash
+ * map instead of reading /proc/<pid>/stat and /proc/<pid>/io of every process.
+ *
+ * The counters of a thread are added to its process every time the thread is switched out, and
+ * when it exits. So the cost of the BPF side is proportional to the scheduling activity, and the
+ * user space side reads one map entry per process that ran since it started.
+ *
+ * The BPF program reads task_struct, signal_struct and mm_struct directly, so it needs the
+ * headers of the exact host kernel.
+ */
+class ProcessStatsBPFConnector : public SourceConnector, public bpf_tools::BCCWrapper {
+ public:
+  static constexpr std::string_view kName = "process_stats_bpf";
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{1000};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
+  static constexpr auto kTables = MakeArray(kProcessStatsTable);
+
+  static std::unique_ptr<SourceConnector> Create(std::string_view name) {
+    return std::unique_ptr<SourceConnector>(new ProcessStatsBPFConnector(name));
+  }
+
+  Status InitImpl() override;
+  Status StopImpl() override;
+  void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+
+ protected:
+  explicit ProcessStatsBPFConnector(std::string_view name)
+      : SourceConnector(name, kTables), bpf_tools::BCCWrapper() {}
+
+ private:
+  std::unique_ptr<ebpf::BPFHashTable<uint32_t, struct process_stats_t>> process_stats_;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -42,7 +42,7 @@ Status ProcessStatsConnector::StopImpl() { return Status::OK(); }
 
 void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
                                                       DataTable* data_table) {
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& pid_info_by_upid = ctx->GetPIDInfoMap();
+  const md::AgentMetadataState::PIDInfoByUPIDMap& pid_info_by_upid = ctx->GetPIDInfoMap();
 
   int64_t timestamp = CurrentTimeNS();
 
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef TCMALLOC
+#include <gperftools/malloc_hook.h>
+#endif
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/canonical_types.h"
+#include "src/stirling/core/connector_context.h"
+#include "src/stirling/core/data_table.h"
+#include "src/stirling/source_connectors/seq_gen/seq_gen_connector.h"
+#include "src/table_store/table_store.h"
+
+// Measures the collection path of Stirling without a kernel: synthetic records go through
+// SourceConnector::TransferData() into the DataTables, and are pushed by PushData() into a
+// TableStore, as in the PEM. Reports records/s, bytes/s, the p99 time of an iteration and, with
+// tcmalloc, the bytes allocated per record. Eg.
+//   seq_gen_benchmark --benchmark_filter=BM_string_load/1000/256
+
+namespace px {
+namespace stirling {
+namespace {
+
+// A connector whose records carry strings of a configurable size, like the request and response
+// bodies of the socket tracer.
+class StringLoadConnector : public SourceConnector {
+ public:
+  static constexpr std::string_view kName = "string_load";
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{100};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
+  static constexpr size_t kMaxStringBytes = 64 * 1024;
+  // clang-format off
+  static constexpr DataElement kElements[] = {
+      canonical_data_elements::kTime,
+      {"x", "A sequence number.",
+       types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+      {"xmod10", "The value of x % 10.",
+       types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL_ENUM},
+      {"req_body", "A string.",
+       types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+      {"resp_body", "Another string.",
+       types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+  };
+  // clang-format on
+  static constexpr auto kTable =
+      DataTableSchema("string_load", "A table of records with strings", kElements);
+  static constexpr auto kTables = MakeArray(kTable);
+
+  StringLoadConnector(uint32_t num_records, size_t string_bytes)
+      : SourceConnector(kName, kTables),
+        num_records_(num_records),
+        payload_(std::min(string_bytes, kMaxStringBytes), 'x') {}
+
+ protected:
+  Status InitImpl() override {
+    sampling_freq_mgr_.set_period(kSamplingPeriod);
+    push_freq_mgr_.set_period(kPushPeriod);
+    return Status::OK();
+  }
+
+  void TransferDataImpl(ConnectorContext* /* ctx */,
+                        const std::vector<DataTable*>& data_tables) override {
+    for (uint32_t i = 0; i < num_records_; ++i) {
+      const int64_t time = time_seq_();
+      DataTable::RecordBuilder<&kTable> r(data_tables[0], time);
+      r.Append<r.ColIndex("time_")>(time);
+      r.Append<r.ColIndex("x")>(x_);
+      r.Append<r.ColIndex("xmod10")>(x_ % 10);
+      r.Append<r.ColIndex("req_body"), kMaxStringBytes>(payload_);
+      r.Append<r.ColIndex("resp_body"), kMaxStringBytes>(payload_);
+      ++x_;
+    }
+  }
+
+  Status StopImpl() override { return Status::OK(); }
+
+ private:
+  const uint32_t num_records_;
+  const std::string payload_;
+  TimeSequence<int64_t> time_seq_;
+  int64_t x_ = 0;
+};
+
+table_store::schema::Relation ToRelation(const DataTableSchema& schema) {
+  table_store::schema::Relation relation;
+  for (const DataElement& element : schema.elements()) {
+    relation.AddColumn(element.type(), std::string(element.name()));
+  }
+  return relation;
+}
+
+std::atomic<int64_t> num_allocated_bytes = 0;
+
+#ifdef TCMALLOC
+void CountAllocation(const void* /*ptr*/, size_t size) {
+  num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+#endif
+
+// Runs iterations of TransferData() followed by PushData() on the connector, which is pushed into
+// a TableStore holding one table per table of the connector.
+void RunCollectionPath(benchmark::State& state, SourceConnector* connector) {  // NOLINT
+  Status s = connector->Init();
+  if (!s.ok()) {
+    state.SkipWithError(s.msg().c_str());
+    return;
+  }
+
+  table_store::TableStore table_store;
+  std::vector<std::unique_ptr<DataTable>> data_tables;
+  std::vector<DataTable*> data_table_ptrs;
+  for (const DataTableSchema& schema : connector->table_schemas()) {
+    const uint64_t id = data_tables.size();
+    table_store.AddTable(table_store::Table::Create(ToRelation(schema)),
+                         std::string(schema.name()), id);
+    data_tables.push_back(std::make_unique<DataTable>(id, schema));
+    data_table_ptrs.push_back(data_tables.back().get());
+  }
+
+  int64_t num_records = 0;
+  int64_t num_bytes = 0;
+  DataPushCallback push_cb = [&](uint32_t table_id, types::TabletID tablet_id,
+                                 std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch) {
+    num_records += (*record_batch)[0]->Size();
+    for (const auto& col : *record_batch) {
+      num_bytes += col->Bytes();
+    }
+    return table_store.AppendData(table_id, std::move(tablet_id), std::move(record_batch));
+  };
+
+  StandaloneContext ctx;
+  std::vector<int64_t> iteration_times_ns;
+  iteration_times_ns.reserve(state.max_iterations);
+
+#ifdef TCMALLOC
+  MallocHook::AddNewHook(&CountAllocation);
+#endif
+  num_allocated_bytes = 0;
+
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    connector->TransferData(&ctx, data_table_ptrs);
+    connector->PushData(push_cb, data_table_ptrs);
+    iteration_times_ns.push_back((std::chrono::steady_clock::now() - start).count());
+  }
+
+#ifdef TCMALLOC
+  MallocHook::RemoveNewHook(&CountAllocation);
+  state.counters["bytes_allocated_per_record"] =
+      num_records == 0 ? 0 : static_cast<double>(num_allocated_bytes) / num_records;
+#endif
+
+  if (!iteration_times_ns.empty()) {
+    auto p99 = iteration_times_ns.begin() + iteration_times_ns.size() * 99 / 100;
+    std::nth_element(iteration_times_ns.begin(), p99, iteration_times_ns.end());
+    state.counters["p99_iteration_us"] = *p99 / 1000.0;
+  }
+  state.SetBytesProcessed(num_bytes);
+  state.counters["records"] = benchmark::Counter(num_records, benchmark::Counter::kIsRate);
+
+  ECHECK_OK(connector->Stop());
+}
+
+// Numeric records, in a plain and a tabletized table.
+// Arg: the number of records per table and iteration.
+void BM_seq_gen(benchmark::State& state) {  // NOLINT
+  std::unique_ptr<SourceConnector> connector = SeqGenConnector::Create("seq_gen");
+  static_cast<SeqGenConnector*>(connector.get())->ConfigureNumRowsPerGet(state.range(0));
+  RunCollectionPath(state, connector.get());
+}
+
+// Records with two string columns.
+// Args: the number of records per iteration, and the size of the strings.
+void BM_string_load(benchmark::State& state) {  // NOLINT
+  StringLoadConnector connector(state.range(0), state.range(1));
+  RunCollectionPath(state, &connector);
+}
+
+BENCHMARK(BM_seq_gen)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_string_load)
+    ->Args({100, 16})
+    ->Args({100, 256})
+    ->Args({100, 4096})
+    ->Args({1000, 16})
+    ->Args({1000, 256})
+    ->Args({1000, 4096})
+    ->Args({10000, 16})
+    ->Args({10000, 256});
+
+}  // namespace
+}  // namespace stirling
+}  // namespace px
@@ -43,6 +43,13 @@ static __inline struct go_grpc_data_event_t* get_data_event() {
   return data_event_buffer_heap.lookup(&kZero);
 }
 
+// A batch of header fields doesn't fit on the stack either.
+BPF_PERCPU_ARRAY(header_event_buffer_heap, struct go_grpc_http2_header_event_t, 1);
+static __inline struct go_grpc_http2_header_event_t* get_header_event() {
+  uint32_t kZero = 0;
+  return header_event_buffer_heap.lookup(&kZero);
+}
+
 // Maps that communicates the location of symbols within a binary.
 //   Key: TGID
 //   Value: Symbol addresses for the binary with that TGID.
@@ -174,7 +181,7 @@ static __inline void copy_header_field(struct header_field_t* dst, struct gostri
   }
 }
 
-static __inline void fill_header_field(struct go_grpc_http2_header_event_t* event,
+static __inline void fill_header_field(struct go_grpc_http2_header_field_t* field,
                                        const void* header_field_ptr,
                                        const struct go_http2_symaddrs_t* symaddrs) {
   struct gostring name;
@@ -185,8 +192,35 @@ static __inline void fill_header_field(struct go_grpc_http2_header_event_t* even
   bpf_probe_read(&value, sizeof(struct gostring),
                  header_field_ptr + symaddrs->HeaderField_Value_offset);
 
-  copy_header_field(&event->name, &name);
-  copy_header_field(&event->value, &value);
+  copy_header_field(&field->name, &name);
+  copy_header_field(&field->value, &value);
+}
+
+// Submits the first num_fields fields of the event, which must be less than HEADER_BATCH_SIZE,
+// or all of them if num_fields is HEADER_BATCH_SIZE.
+static __inline void submit_header_batch(struct pt_regs* ctx,
+                                         struct go_grpc_http2_header_event_t* event,
+                                         uint32_t num_fields) {
+  event->num_fields = num_fields;
+  // The mask bounds the size for the verifier. A full batch, with the mask at zero, is sent whole.
+  size_t size = num_fields == HEADER_BATCH_SIZE
+                    ? sizeof(*event)
+                    : sizeof(event->attr) + sizeof(event->num_fields) +
+                          (num_fields & (HEADER_BATCH_SIZE - 1)) *
+                              sizeof(struct go_grpc_http2_header_field_t);
+  go_grpc_header_events.perf_submit(ctx, event, size);
+}
+
+static __inline void init_header_event(struct go_grpc_http2_header_event_t* event,
+                                       enum http2_probe_type_t probe_type,
+                                       enum HeaderEventType type, struct conn_id_t conn_id,
+                                       uint32_t stream_id) {
+  event->attr.probe_type = probe_type;
+  event->attr.type = type;
+  event->attr.timestamp_ns = bpf_ktime_get_ns();
+  event->attr.conn_id = conn_id;
+  event->attr.stream_id = stream_id;
+  event->attr.end_stream = false;
 }
 
 static __inline void submit_headers(struct pt_regs* ctx, enum http2_probe_type_t probe_type,
@@ -199,29 +233,32 @@ static __inline void submit_headers(struct pt_regs* ctx, enum http2_probe_type_t
     return;
   }
 
-  struct go_grpc_http2_header_event_t event = {};
-  event.attr.probe_type = probe_type;
-  event.attr.type = type;
-  event.attr.timestamp_ns = bpf_ktime_get_ns();
-  event.attr.conn_id = conn_info->conn_id;
-  event.attr.stream_id = stream_id;
+  struct go_grpc_http2_header_event_t* event = get_header_event();
+  if (event == NULL) {
+    return;
+  }
+  init_header_event(event, probe_type, type, conn_info->conn_id, stream_id);
 
+  // The fields are sent in full batches, and the rest with the last batch, which also carries the
+  // end-stream flag. The index into the batch is a constant in each unrolled iteration.
   // TODO(oazizi): Replace this constant with information from DWARF.
   const int kSizeOfHeaderField = 40;
 #pragma unroll
   for (unsigned int i = 0; i < MAX_HEADER_COUNT; ++i) {
     if (i < fields.len) {
-      fill_header_field(&event, fields.ptr + i * kSizeOfHeaderField, symaddrs);
-      go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+      fill_header_field(&event->fields[i % HEADER_BATCH_SIZE], fields.ptr + i * kSizeOfHeaderField,
+                        symaddrs);
+      if (i % HEADER_BATCH_SIZE == HEADER_BATCH_SIZE - 1) {
+        submit_header_batch(ctx, event, HEADER_BATCH_SIZE);
+      }
     }
   }
 
-  // If end of stream, send one extra empty header with end-stream flag set.
-  if (end_stream) {
-    event.name.size = 0;
-    event.value.size = 0;
-    event.attr.end_stream = true;
-    go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+  uint32_t num_fields = fields.len < MAX_HEADER_COUNT ? fields.len : MAX_HEADER_COUNT;
+  uint32_t num_remaining = num_fields % HEADER_BATCH_SIZE;
+  if (num_remaining > 0 || end_stream) {
+    event->attr.end_stream = end_stream;
+    submit_header_batch(ctx, event, num_remaining);
   }
 }
 
@@ -234,15 +271,15 @@ static __inline void submit_header(struct pt_regs* ctx, enum http2_probe_type_t
     return;
   }
 
-  struct go_grpc_http2_header_event_t event = {};
-  event.attr.probe_type = probe_type;
-  event.attr.type = type;
-  event.attr.timestamp_ns = bpf_ktime_get_ns();
-  event.attr.conn_id = attr->conn_id;
-  event.attr.stream_id = attr->stream_id;
+  struct go_grpc_http2_header_event_t* event = get_header_event();
+  if (event == NULL) {
+    return;
+  }
+  init_header_event(event, probe_type, type, attr->conn_id, attr->stream_id);
 
-  fill_header_field(&event, header_field_ptr, symaddrs);
-  go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+  // The encoder is called once per field, so each field is a batch of its own.
+  fill_header_field(&event->fields[0], header_field_ptr, symaddrs);
+  submit_header_batch(ctx, event, 1);
 }
 
 // TODO(oazizi): Remove this struct; Use DWARF instead.
@@ -260,6 +297,10 @@ struct go_grpc_framer_t {
 // Symbol:
 //   google.golang.org/grpc/internal/transport.(*loopyWriter).writeHeader
 int probe_loopy_writer_write_header(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -386,6 +427,10 @@ static __inline void probe_http2_operate_headers(struct pt_regs* ctx,
 // Symbol:
 //   google.golang.org/grpc/internal/transport.(*http2Client).operateHeaders
 int probe_http2_client_operate_headers(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -439,6 +484,10 @@ int probe_http2_client_operate_headers(struct pt_regs* ctx) {
 // Symbol:
 //   google.golang.org/grpc/internal/transport.(*http2Server).operateHeaders
 int probe_http2_server_operate_headers(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -493,6 +542,10 @@ int probe_http2_server_operate_headers(struct pt_regs* ctx) {
 //
 // Verified to be stable from go1.?? to t go.1.13.
 int probe_http_http2serverConn_processHeaders(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -585,6 +638,10 @@ int probe_http_http2serverConn_processHeaders(struct pt_regs* ctx) {
 //
 // Verified to be stable from at least go1.6 to t go.1.13.
 int probe_hpack_header_encoder(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -626,6 +683,10 @@ int probe_hpack_header_encoder(struct pt_regs* ctx) {
 //
 // Verified to be stable from go1.?? to t go.1.13.
 int probe_http_http2writeResHeaders_write_frame(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -709,16 +770,14 @@ int probe_http_http2writeResHeaders_write_frame(struct pt_regs* ctx) {
   // TODO(oazizi): Content beyond this point needs to move to return probe of the same function.
 
   if (end_stream) {
-    struct go_grpc_http2_header_event_t event = {};
-    event.attr.probe_type = k_probe_http_http2writeResHeaders_write_frame;
-    event.attr.type = kHeaderEventWrite;
-    event.attr.timestamp_ns = bpf_ktime_get_ns();
-    event.attr.conn_id = conn_info->conn_id;
-    event.attr.stream_id = stream_id;
-    event.name.size = 0;
-    event.value.size = 0;
-    event.attr.end_stream = true;
-    go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+    struct go_grpc_http2_header_event_t* event = get_header_event();
+    if (event == NULL) {
+      return 0;
+    }
+    init_header_event(event, k_probe_http_http2writeResHeaders_write_frame, kHeaderEventWrite,
+                      conn_info->conn_id, stream_id);
+    event->attr.end_stream = true;
+    submit_header_batch(ctx, event, 0);
   }
 
   // TODO(oazizi): We are leaking BPF map entries until this line is activated,
@@ -794,6 +853,10 @@ static __inline void go_http2_submit_data(struct pt_regs* ctx, enum http2_probe_
 //
 // Verified to be stable from at least go1.6 to t go.1.13.
 int probe_http2_framer_check_frame_order(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -891,6 +954,10 @@ int probe_http2_framer_check_frame_order(struct pt_regs* ctx) {
 //
 // Verified to be stable from at least go1.?? to go.1.13.
 int probe_http_http2framer_check_frame_order(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -986,6 +1053,10 @@ int probe_http_http2framer_check_frame_order(struct pt_regs* ctx) {
 //
 // Verified to be stable from go1.7 to t go.1.13.
 int probe_http2_framer_write_data(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -1047,6 +1118,10 @@ int probe_http2_framer_write_data(struct pt_regs* ctx) {
 //
 // Verified to be stable from go1.?? to t go.1.13.
 int probe_http_http2framer_write_data(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
   struct go_http2_symaddrs_t* symaddrs = http2_symaddrs_map.lookup(&tgid);
   if (symaddrs == NULL) {
@@ -41,6 +41,10 @@ BPF_HASH(go_tls_symaddrs_map, uint32_t, struct go_tls_symaddrs_t);
 // Symbol:
 //   crypto/tls.(*Conn).Write
 int probe_tls_conn_write(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
   uint32_t tgid = id >> 32;
 
@@ -96,7 +100,7 @@ int probe_tls_conn_write(struct pt_regs* ctx) {
   struct data_args_t args;
   args.source_fn = kGoTLSConnWrite;
   args.buf = plaintext.ptr;
-  args.msg_len = 0;  // Unused.
+  args.msgvec = NULL;  // Unused.
   args.fd = fd;
 
   process_data(/* vecs */ false, ctx, id, kEgress, &args, retval0, /* ssl */ true);
@@ -112,6 +116,10 @@ int probe_tls_conn_write(struct pt_regs* ctx) {
 // Symbol:
 //   crypto/tls.(*Conn).Read
 int probe_tls_conn_read(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
   uint32_t tgid = id >> 32;
 
@@ -168,7 +176,7 @@ int probe_tls_conn_read(struct pt_regs* ctx) {
   struct data_args_t args;
   args.source_fn = kGoTLSConnRead;
   args.buf = plaintext.ptr;
-  args.msg_len = 0;  // Unused.
+  args.msgvec = NULL;  // Unused.
   args.fd = fd;
 
   process_data(/* vecs */ false, ctx, id, kIngress, &args, retval0, /* ssl */ true);
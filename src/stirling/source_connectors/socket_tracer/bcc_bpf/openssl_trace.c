@@ -93,6 +93,10 @@ BPF_HASH(active_ssl_write_args_map, uint64_t, struct data_args_t);
 // Function signature being probed:
 // int SSL_write(SSL *ssl, const void *buf, int num);
 int probe_entry_SSL_write(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
   uint32_t tgid = id >> 32;
 
@@ -131,6 +135,10 @@ int probe_ret_SSL_write(struct pt_regs* ctx) {
 // Function signature being probed:
 // int SSL_read(SSL *s, void *buf, int num)
 int probe_entry_SSL_read(struct pt_regs* ctx) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
   uint32_t tgid = id >> 32;
 
@@ -54,6 +54,23 @@ static __inline enum MessageType infer_http_message(const char* buf, size_t coun
   return kUnknown;
 }
 
+// HTTP2 is detected by the connection preface, which the client sends first on the connection:
+// "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n". See https://httpwg.org/specs/rfc7540.html#ConnectionHeader.
+// Only the connections traced from their start can be decoded anyway, because of HPACK.
+static __inline enum MessageType infer_http2_message(const char* buf, size_t count) {
+  static const size_t kPrefaceSize = 24;
+  if (count < kPrefaceSize) {
+    return kUnknown;
+  }
+
+  if (buf[0] == 'P' && buf[1] == 'R' && buf[2] == 'I' && buf[3] == ' ' && buf[4] == '*' &&
+      buf[9] == '/' && buf[10] == '2' && buf[18] == 'S' && buf[19] == 'M') {
+    return kRequest;
+  }
+
+  return kUnknown;
+}
+
 // Cassandra frame:
 //      0         8        16        24        32         40
 //      +---------+---------+---------+---------+---------+
@@ -521,27 +538,54 @@ static __inline enum MessageType infer_nats_message(const char* buf, size_t coun
   return kUnknown;
 }
 
+// A bit mask of the protocols, by TrafficProtocol value, that are never inferred.
+// User-space sets it through cflags, so that the checks of skipped protocols are compiled out.
+#ifndef PROTOCOL_INFERENCE_SKIP_MASK
+#define PROTOCOL_INFERENCE_SKIP_MASK 0
+#endif
+
+// Returns true if infer_protocol() should check for the protocol. Once a connection is classified,
+// only its own protocol is checked, which is still needed to infer its role and match counts.
+static __inline bool should_infer_protocol(enum TrafficProtocol protocol,
+                                           const struct conn_info_t* conn_info) {
+  // Constant for each call site, so this is folded away at compile-time.
+  if (PROTOCOL_INFERENCE_SKIP_MASK & (1ULL << protocol)) {
+    return false;
+  }
+  return conn_info->protocol == kProtocolUnknown || conn_info->protocol == protocol;
+}
+
 static __inline struct protocol_message_t infer_protocol(const char* buf, size_t count,
                                                          struct conn_info_t* conn_info) {
   struct protocol_message_t inferred_message;
   inferred_message.protocol = kProtocolUnknown;
   inferred_message.type = kUnknown;
 
-  if ((inferred_message.type = infer_http_message(buf, count)) != kUnknown) {
+  if (should_infer_protocol(kProtocolHTTP, conn_info) &&
+      (inferred_message.type = infer_http_message(buf, count)) != kUnknown) {
     inferred_message.protocol = kProtocolHTTP;
-  } else if ((inferred_message.type = infer_cql_message(buf, count)) != kUnknown) {
+  } else if (should_infer_protocol(kProtocolHTTP2, conn_info) &&
+             (inferred_message.type = infer_http2_message(buf, count)) != kUnknown) {
+    inferred_message.protocol = kProtocolHTTP2;
+  } else if (should_infer_protocol(kProtocolCQL, conn_info) &&
+             (inferred_message.type = infer_cql_message(buf, count)) != kUnknown) {
     inferred_message.protocol = kProtocolCQL;
-  } else if ((inferred_message.type = infer_mongo_message(buf, count)) != kUnknown) {
+  } else if (should_infer_protocol(kProtocolMongo, conn_info) &&
+             (inferred_message.type = infer_mongo_message(buf, count)) != kUnknown) {
     inferred_message.protocol = kProtocolMongo;
-  } else if ((inferred_message.type = infer_pgsql_message(buf, count)) != kUnknown) {
+  } else if (should_infer_protocol(kProtocolPGSQL, conn_info) &&
+             (inferred_message.type = infer_pgsql_message(buf, count)) != kUnknown) {
     inferred_message.protocol = kProtocolPGSQL;
-  } else if ((inferred_message.type = infer_mysql_message(buf, count, conn_info)) != kUnknown) {
+  } else if (should_infer_protocol(kProtocolMySQL, conn_info) &&
+             (inferred_message.type = infer_mysql_message(buf, count, conn_info)) != kUnknown) {
     inferred_message.protocol = kProtocolMySQL;
-  } else if ((inferred_message.type = infer_kafka_message(buf, count, conn_info)) != kUnknown) {
+  } else if (should_infer_protocol(kProtocolKafka, conn_info) &&
+             (inferred_message.type = infer_kafka_message(buf, count, conn_info)) != kUnknown) {
     inferred_message.protocol = kProtocolKafka;
-  } else if ((inferred_message.type = infer_dns_message(buf, count)) != kUnknown) {
+  } else if (should_infer_protocol(kProtocolDNS, conn_info) &&
+             (inferred_message.type = infer_dns_message(buf, count)) != kUnknown) {
     inferred_message.protocol = kProtocolDNS;
-  } else if (is_redis_message(buf, count)) {
+  } else if (should_infer_protocol(kProtocolRedis, conn_info) && is_redis_message(buf, count)) {
     // For Redis, the message type is left to be kUnknown.
     // The message types are then inferred via traffic direction and client/server role.
     inferred_message.protocol = kProtocolRedis;
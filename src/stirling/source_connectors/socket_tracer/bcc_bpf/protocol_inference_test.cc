@@ -50,6 +50,20 @@ TEST(ProtocolInferenceTest, Postgres) {
   EXPECT_EQ(kRequest, infer_pgsql_message(kQueryMessage, sizeof(kQueryMessage)));
 }
 
+TEST(ProtocolInferenceTest, HTTP2) {
+  // The connection preface, followed by an empty SETTINGS frame.
+  constexpr char kPreface[] =
+      "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+      "\x00\x00\x00\x04\x00\x00\x00\x00\x00";
+  EXPECT_EQ(kRequest, infer_http2_message(kPreface, sizeof(kPreface) - 1));
+
+  // Truncated preface.
+  EXPECT_EQ(kUnknown, infer_http2_message(kPreface, 16));
+
+  constexpr char kHTTP1Request[] = "PRI / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+  EXPECT_EQ(kUnknown, infer_http2_message(kHTTP1Request, sizeof(kHTTP1Request) - 1));
+}
+
 TEST(ProtocolInferenceTest, DNS) {
   // A query captured via WireShark:
   //   Domain Name System (query)
@@ -280,6 +294,19 @@ TEST(ProtocolInferenceTest, Kafka) {
   EXPECT_EQ(protocol_message.protocol, kProtocolKafka);
 }
 
+TEST(ProtocolInferenceTest, ClassifiedConnectionOnlyChecksItsProtocol) {
+  struct conn_info_t conn_info = {};
+  constexpr std::string_view kHTTPReq = "GET /index.html HTTP/1.1\r\n";
+
+  auto protocol_message = infer_protocol(kHTTPReq.data(), kHTTPReq.size(), &conn_info);
+  EXPECT_EQ(protocol_message.protocol, kProtocolHTTP);
+  EXPECT_EQ(protocol_message.type, kRequest);
+
+  conn_info.protocol = kProtocolRedis;
+  protocol_message = infer_protocol(kHTTPReq.data(), kHTTPReq.size(), &conn_info);
+  EXPECT_EQ(protocol_message.protocol, kProtocolUnknown);
+}
+
 TEST(ProtocolInferenceTest, NATS) {
   auto call = [](std::string_view msg) { return infer_nats_message(msg.data(), msg.size()); };
 
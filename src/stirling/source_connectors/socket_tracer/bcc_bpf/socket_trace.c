@@ -32,6 +32,7 @@
 
 #define socklen_t size_t
 
+#include "src/stirling/bpf_tools/bcc_bpf/cgroup_filter.h"
 #include "src/stirling/bpf_tools/bcc_bpf/task_struct_utils.h"
 #include "src/stirling/bpf_tools/bcc_bpf/utils.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
@@ -41,8 +42,22 @@
 // This keeps instruction count below BPF's limit of 4096 per probe.
 #define LOOP_LIMIT 45
 
+// With COALESCE_IOVECS, the iovecs are copied with bounded loops instead of unrolled ones (5.3+),
+// so many more of them fit into a probe.
+#define COALESCE_IOV_LIMIT 256
+
+// The number of messages of a sendmmsg()/recvmmsg() call that are traced. Each message is processed
+// like a separate sendmsg()/recvmsg() call, which only fits into a probe on newer kernels.
+#ifndef MMSG_LIMIT
+#define MMSG_LIMIT 1
+#endif
+
 const int32_t kInvalidFD = -1;
 
+// From <sys/mman.h>.
+const int kProtExec = 0x4;
+const int kMapAnonymous = 0x20;
+
 // Determines what percentage of events must be inferred as a certain type for us to consider the
 // connection to be of that type. Encoded as a numerator/denominator. Currently set to 20%. While
 // this may seem low, one must consider that not all captures are packet-aligned, and the inference
@@ -62,9 +77,24 @@ const int kTrafficInferenceBias = 5;
 const int kConnStatsDataThreshold = 65536;
 
 // This is the perf buffer for BPF program to export data from kernel to user space.
+// On kernels with ring buffers, user-space can compile the program with USE_RINGBUF, so that
+// the data events go through a single ring buffer shared by all CPUs instead.
+#ifdef USE_RINGBUF
+BPF_RINGBUF_OUTPUT(socket_data_events, RINGBUF_PAGE_CNT);
+#else
 BPF_PERF_OUTPUT(socket_data_events);
+#endif
 BPF_PERF_OUTPUT(socket_control_events);
+// User-space can compile the program with USE_CONN_STATS_MAP, so that the totals of the
+// connections are kept in conn_stats_map, which user-space reads every conn_stats period,
+// instead of being sent as conn_stats_events.
+#ifdef USE_CONN_STATS_MAP
+// Key is the conn_id of the connection. Entries of closed connections are deleted by user-space
+// once it has read them.
+BPF_HASH(conn_stats_map, struct conn_id_t, struct conn_stats_event_t, 131072);
+#else
 BPF_PERF_OUTPUT(conn_stats_events);
+#endif
 
 // This output is used to export notification of processes that have performed an mmap.
 BPF_PERF_OUTPUT(mmap_events);
@@ -75,10 +105,28 @@ BPF_PERF_OUTPUT(mmap_events);
 // There is a control map element for each protocol.
 BPF_PERCPU_ARRAY(control_map, uint64_t, kNumProtocols);
 
+// Trace policies set by user-space, which sample connections and limit the amount of data sent,
+// so that uninteresting traffic is dropped here instead of in user-space.
+// Key is {tgid, protocol, role}; lookups fall back to tgid 0 when a process has no policy.
+BPF_HASH(trace_policy_map, struct trace_policy_key_t, struct trace_policy_t, 1024);
+
 // Map from user-space file descriptors to the connections obtained from accept() syscall.
 // Tracks connection from accept() -> close().
 // Key is {tgid, fd}.
-BPF_HASH(conn_info_map, uint64_t, struct conn_info_t, 131072);
+// With CONN_INFO_MAP_LRU, a new connection evicts the least recently used entry when the map is
+// full, instead of failing to be tracked; this also reclaims entries leaked by missed close()s.
+#ifndef CONN_INFO_MAP_SIZE
+#define CONN_INFO_MAP_SIZE 131072
+#endif
+#ifdef CONN_INFO_MAP_LRU
+BPF_TABLE("lru_hash", uint64_t, struct conn_info_t, conn_info_map, CONN_INFO_MAP_SIZE);
+#else
+BPF_HASH(conn_info_map, uint64_t, struct conn_info_t, CONN_INFO_MAP_SIZE);
+#endif
+
+// Counts the inserts, failed inserts and deletes of conn_info_map, indexed by
+// ConnInfoMapStatIndex. User-space derives the occupancy pressure and LRU evictions from these.
+BPF_PERCPU_ARRAY(conn_info_map_stats, int64_t, kNumConnInfoMapStats);
 
 // Map to indicate which connections (TGID+FD), user-space has disabled.
 // This is tracked separately from conn_info_map to avoid any read-write races.
@@ -88,6 +136,11 @@ BPF_HASH(conn_info_map, uint64_t, struct conn_info_t, 131072);
 // Key is {tgid, fd}; Value is TSID.
 BPF_HASH(conn_disabled_map, uint64_t, uint64_t);
 
+// Map to limit how much of the TLS data of a connection is sent, once user-space has parsed its
+// protocol headers; see conn_capture_limit_t. Only written from user-space, except for the
+// delete on close(). Key is {tgid, fd}.
+BPF_HASH(conn_capture_limit_map, uint64_t, struct conn_capture_limit_t);
+
 // Map from user-space file descriptors to open files obtained from open() syscall.
 // Used to filter out file read/writes.
 // Tracks connection from open() -> close().
@@ -119,9 +172,19 @@ BPF_HASH(active_read_args_map, uint64_t, struct data_args_t);
 // Key is {tgid, pid}.
 BPF_HASH(active_close_args_map, uint64_t, struct close_args_t);
 
+struct socket_data_event_buffer_t {
+  struct socket_data_event_t event;
+#ifdef COALESCE_IOVECS
+  // The coalesced iovecs are copied at variable offsets into event.msg, and the verifier bounds the
+  // end of each copy by the largest offset plus the largest size. This slack keeps that bound
+  // inside the map value. It is never written, since the copies are also checked to fit in msg.
+  char slack[MAX_MSG_SIZE];
+#endif
+};
+
 // BPF programs are limited to a 512-byte stack. We store this value per CPU
 // and use it as a heap allocated value.
-BPF_PERCPU_ARRAY(socket_data_event_buffer_heap, struct socket_data_event_t, 1);
+BPF_PERCPU_ARRAY(socket_data_event_buffer_heap, struct socket_data_event_buffer_t, 1);
 BPF_PERCPU_ARRAY(conn_stats_event_buffer_heap, struct conn_stats_event_t, 1);
 
 // This array records singular values that are used by probes. We group them together to reduce the
@@ -154,6 +217,13 @@ static __inline void clear_open_file(uint32_t tgid, int fd) {
   open_file_map.delete(&tgid_fd);
 }
 
+static __inline void inc_conn_info_map_stat(int idx) {
+  int64_t* count = conn_info_map_stats.lookup(&idx);
+  if (count != NULL) {
+    *count += 1;
+  }
+}
+
 static __inline void init_conn_id(uint32_t tgid, int32_t fd, struct conn_id_t* conn_id) {
   conn_id->upid.tgid = tgid;
   conn_id->upid.start_time_ticks = get_tgid_start_time();
@@ -174,9 +244,23 @@ static __inline void init_conn_info(uint32_t tgid, int32_t fd, struct conn_info_
 // the relevant map entries every time a ConnTracker is destroyed.
 static __inline struct conn_info_t* get_or_create_conn_info(uint32_t tgid, int32_t fd) {
   uint64_t tgid_fd = gen_tgid_fd(tgid, fd);
+  struct conn_info_t* conn_info = conn_info_map.lookup(&tgid_fd);
+  if (conn_info != NULL) {
+    return conn_info;
+  }
+
   struct conn_info_t new_conn_info = {};
   init_conn_info(tgid, fd, &new_conn_info);
-  return conn_info_map.lookup_or_init(&tgid_fd, &new_conn_info);
+  // The insert also fails if another CPU created the entry first, so only a failed lookup after
+  // it counts as an insert failure.
+  int ret = conn_info_map.insert(&tgid_fd, &new_conn_info);
+  conn_info = conn_info_map.lookup(&tgid_fd);
+  if (ret == 0) {
+    inc_conn_info_map_stat(kConnInfoMapInserts);
+  } else if (conn_info == NULL) {
+    inc_conn_info_map_stat(kConnInfoMapInsertFailures);
+  }
+  return conn_info;
 }
 
 static __inline void set_conn_as_ssl(uint32_t tgid, int32_t fd) {
@@ -191,10 +275,11 @@ static __inline struct socket_data_event_t* fill_socket_data_event(
     enum source_function_t src_fn, enum TrafficDirection direction,
     const struct conn_info_t* conn_info) {
   uint32_t kZero = 0;
-  struct socket_data_event_t* event = socket_data_event_buffer_heap.lookup(&kZero);
-  if (event == NULL) {
+  struct socket_data_event_buffer_t* buffer = socket_data_event_buffer_heap.lookup(&kZero);
+  if (buffer == NULL) {
     return NULL;
   }
+  struct socket_data_event_t* event = &buffer->event;
   event->attr.timestamp_ns = bpf_ktime_get_ns();
   event->attr.source_fn = src_fn;
   event->attr.ssl = conn_info->ssl;
@@ -223,6 +308,19 @@ static __inline struct conn_stats_event_t* fill_conn_stats_event(
   return event;
 }
 
+#ifdef USE_CONN_STATS_MAP
+// Writes the current totals of the connection to conn_stats_map.
+static __inline void update_conn_stats_map(const struct conn_info_t* conn_info,
+                                           uint32_t conn_events) {
+  struct conn_stats_event_t* event = fill_conn_stats_event(conn_info);
+  if (event == NULL) {
+    return;
+  }
+  event->conn_events = conn_events;
+  conn_stats_map.update(&event->conn_id, event);
+}
+#endif
+
 /***********************************************************
  * Trace filtering functions
  ***********************************************************/
@@ -261,6 +359,29 @@ static __inline bool should_trace_protocol_data(const struct conn_info_t* conn_i
   return control & conn_info->role;
 }
 
+static __inline const struct trace_policy_t* lookup_trace_policy(
+    const struct conn_info_t* conn_info) {
+  struct trace_policy_key_t key = {};
+  key.tgid = conn_info->conn_id.upid.tgid;
+  key.protocol = conn_info->protocol;
+  key.role = conn_info->role;
+
+  const struct trace_policy_t* policy = trace_policy_map.lookup(&key);
+  if (policy != NULL) {
+    return policy;
+  }
+
+  key.tgid = 0;
+  return trace_policy_map.lookup(&key);
+}
+
+// The tsid is the connection's creation time in nanoseconds, so its low digits are as good as
+// random, and stay the same for all the events of the connection.
+static __inline bool trace_policy_samples_conn(const struct trace_policy_t* policy,
+                                               const struct conn_info_t* conn_info) {
+  return conn_info->conn_id.tsid % kTracePolicySampleRateDenom < policy->sample_rate;
+}
+
 static __inline bool is_stirling_tgid(const uint32_t tgid) {
   int idx = kStirlingTGIDIndex;
   int64_t* stirling_tgid = control_values.lookup(&idx);
@@ -301,12 +422,16 @@ static __inline void update_traffic_class(struct conn_info_t* conn_info,
   }
   conn_info->protocol_total_count += 1;
 
+  // Nothing more is inferred for these protocols once they are classified.
+  if (conn_info->protocol == kProtocolMongo || conn_info->protocol == kProtocolKafka) {
+    return;
+  }
+
   // Try to infer connection type (protocol) based on data.
   struct protocol_message_t inferred_protocol = infer_protocol(buf, count, conn_info);
 
   // Could not infer the traffic.
-  if (inferred_protocol.protocol == kProtocolUnknown || conn_info->protocol == kProtocolMongo ||
-      conn_info->protocol == kProtocolKafka) {
+  if (inferred_protocol.protocol == kProtocolUnknown) {
     return;
   }
 
@@ -381,7 +506,12 @@ static __inline void submit_new_conn(struct pt_regs* ctx, uint32_t tgid, int32_t
   conn_info.role = role;
 
   uint64_t tgid_fd = gen_tgid_fd(tgid, fd);
-  conn_info_map.update(&tgid_fd, &conn_info);
+  bool replaced = conn_info_map.lookup(&tgid_fd) != NULL;
+  if (conn_info_map.update(&tgid_fd, &conn_info) != 0) {
+    inc_conn_info_map_stat(kConnInfoMapInsertFailures);
+  } else if (!replaced) {
+    inc_conn_info_map_stat(kConnInfoMapInserts);
+  }
 
   // While we keep all sa_family types in conn_info_map,
   // we only send connections with supported protocols to user-space.
@@ -484,10 +614,39 @@ static __inline void perf_submit_buf(struct pt_regs* ctx, const enum TrafficDire
   if (buf_size_minus_1 < MAX_MSG_SIZE) {
     bpf_probe_read(&event->msg, buf_size, buf);
     event->attr.msg_buf_size = buf_size;
+#ifdef USE_RINGBUF
+    // The events are variable-sized, so they are copied in with ringbuf_output() rather than
+    // reserving a full-sized event in the ring buffer.
+    socket_data_events.ringbuf_output(event, sizeof(event->attr) + buf_size, /*flags*/ 0);
+#else
     socket_data_events.perf_submit(ctx, event, sizeof(event->attr) + buf_size);
+#endif
   }
 }
 
+// Sends only the attributes of the data, for connections whose data is not captured.
+// The data shows up as a gap in the data stream.
+static __inline void perf_submit_metadata(struct pt_regs* ctx,
+                                          const enum TrafficDirection direction, size_t msg_size,
+                                          struct conn_info_t* conn_info,
+                                          struct socket_data_event_t* event) {
+  switch (direction) {
+    case kEgress:
+      event->attr.pos = conn_info->wr_bytes;
+      break;
+    case kIngress:
+      event->attr.pos = conn_info->rd_bytes;
+      break;
+  }
+  event->attr.msg_size = msg_size;
+  event->attr.msg_buf_size = 0;
+#ifdef USE_RINGBUF
+  socket_data_events.ringbuf_output(event, sizeof(event->attr), /*flags*/ 0);
+#else
+  socket_data_events.perf_submit(ctx, event, sizeof(event->attr));
+#endif
+}
+
 static __inline void perf_submit_wrapper(struct pt_regs* ctx, const enum TrafficDirection direction,
                                          const char* buf, const size_t buf_size,
                                          struct conn_info_t* conn_info,
@@ -538,6 +697,91 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx, const enum TrafficD
   }
 }
 
+#ifdef COALESCE_IOVECS
+// Submits the msg_size bytes already copied into event->msg, which start at the given offset of
+// the data of the syscall.
+static __inline void perf_submit_coalesced(struct pt_regs* ctx,
+                                           const enum TrafficDirection direction, size_t msg_size,
+                                           size_t offset, struct conn_info_t* conn_info,
+                                           struct socket_data_event_t* event) {
+  switch (direction) {
+    case kEgress:
+      event->attr.pos = conn_info->wr_bytes + offset;
+      break;
+    case kIngress:
+      event->attr.pos = conn_info->rd_bytes + offset;
+      break;
+  }
+
+  size_t msg_size_minus_1 = msg_size - 1;
+  asm volatile("" : "+r"(msg_size_minus_1) :);
+  if (msg_size == 0 || msg_size_minus_1 >= MAX_MSG_SIZE) {
+    return;
+  }
+
+  event->attr.msg_size = msg_size_minus_1 + 1;
+  event->attr.msg_buf_size = msg_size_minus_1 + 1;
+#ifdef USE_RINGBUF
+  socket_data_events.ringbuf_output(event, sizeof(event->attr) + msg_size_minus_1 + 1,
+                                    /*flags*/ 0);
+#else
+  socket_data_events.perf_submit(ctx, event, sizeof(event->attr) + msg_size_minus_1 + 1);
+#endif
+}
+
+// Like perf_submit_iovecs(), but copies consecutive iovecs contiguously into one event, until the
+// next one does not fit in the event anymore. Small iovecs, such as the header and the body of a
+// UDP message, are then sent as one event instead of one each.
+//
+// As with perf_submit_buf(), an iovec larger than an event is not captured, and shows up as a gap
+// in the data stream.
+static __inline void perf_submit_coalesced_iovecs(struct pt_regs* ctx,
+                                                  const enum TrafficDirection direction,
+                                                  const struct iovec* iov, const size_t iovlen,
+                                                  const size_t total_size,
+                                                  struct conn_info_t* conn_info,
+                                                  struct socket_data_event_t* event) {
+  // Offset of the pending event in the data of the syscall, and the bytes copied into it.
+  size_t event_offset = 0;
+  size_t msg_size = 0;
+
+  size_t bytes_sent = 0;
+#pragma clang loop unroll(disable)
+  for (unsigned int i = 0; i < COALESCE_IOV_LIMIT && i < iovlen && bytes_sent < total_size; ++i) {
+    struct iovec iov_cpy;
+    bpf_probe_read(&iov_cpy, sizeof(struct iovec), &iov[i]);
+
+    const size_t bytes_remaining = total_size - bytes_sent;
+    const size_t iov_size = iov_cpy.iov_len < bytes_remaining ? iov_cpy.iov_len : bytes_remaining;
+
+    if (msg_size + iov_size > MAX_MSG_SIZE) {
+      perf_submit_coalesced(ctx, direction, msg_size, event_offset, conn_info, event);
+      msg_size = 0;
+      event_offset = bytes_sent;
+    }
+
+    if (iov_size > MAX_MSG_SIZE) {
+      bytes_sent += iov_size;
+      event_offset = bytes_sent;
+      continue;
+    }
+
+    // See perf_submit_buf() for why the sizes are laundered through volatile asm.
+    size_t copy_offset = msg_size;
+    size_t copy_size_minus_1 = iov_size - 1;
+    asm volatile("" : "+r"(copy_offset), "+r"(copy_size_minus_1) :);
+    if (iov_size > 0 && copy_offset < MAX_MSG_SIZE && copy_size_minus_1 < MAX_MSG_SIZE) {
+      bpf_probe_read(event->msg + copy_offset, copy_size_minus_1 + 1, iov_cpy.iov_base);
+    }
+
+    msg_size += iov_size;
+    bytes_sent += iov_size;
+  }
+
+  perf_submit_coalesced(ctx, direction, msg_size, event_offset, conn_info, event);
+}
+#endif
+
 /***********************************************************
  * Map cleanup functions
  ***********************************************************/
@@ -562,8 +806,9 @@ int conn_cleanup_uprobe(struct pt_regs* ctx) {
     // We don't want to accidentally delete a newer generation that has since come into existence.
 
     struct conn_info_t* conn_info = conn_info_map.lookup(&tgid_fd);
-    if (conn_info != NULL && conn_info->conn_id.tsid == conn_id.tsid) {
-      conn_info_map.delete(&tgid_fd);
+    if (conn_info != NULL && conn_info->conn_id.tsid == conn_id.tsid &&
+        conn_info_map.delete(&tgid_fd) == 0) {
+      inc_conn_info_map_stat(kConnInfoMapDeletes);
     }
 
     uint64_t* tsid = conn_disabled_map.lookup(&tgid_fd);
@@ -765,6 +1010,29 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
                    (match_result == TARGET_TGID_MATCHED || should_trace_protocol_data(conn_info)) &&
                    (conn_disabled_tsid == NULL || conn_info->conn_id.tsid > *conn_disabled_tsid);
 
+  size_t send_bytes_count = bytes_count;
+  if (send_data) {
+    const struct trace_policy_t* policy = lookup_trace_policy(conn_info);
+    if (policy != NULL) {
+      send_data = trace_policy_samples_conn(policy, conn_info);
+      if (policy->max_bytes_per_syscall != 0 && send_bytes_count > policy->max_bytes_per_syscall) {
+        send_bytes_count = policy->max_bytes_per_syscall;
+      }
+    }
+  }
+
+  // ssl is a constant at each call site, so the syscall probes don't pay for this lookup.
+  bool metadata_only = false;
+  if (send_data && ssl) {
+    const struct conn_capture_limit_t* limit = conn_capture_limit_map.lookup(&tgid_fd);
+    if (limit != NULL && limit->tsid == conn_info->conn_id.tsid) {
+      metadata_only = limit->max_bytes_per_call == 0;
+      if (send_bytes_count > limit->max_bytes_per_call) {
+        send_bytes_count = limit->max_bytes_per_call;
+      }
+    }
+  }
+
   if (send_data) {
     struct socket_data_event_t* event =
         fill_socket_data_event(args->source_fn, direction, conn_info);
@@ -774,13 +1042,21 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
     }
 
     // TODO(yzhao): Same TODO for split the interface.
-    if (!vecs) {
-      perf_submit_wrapper(ctx, direction, args->buf, bytes_count, conn_info, event);
+    if (metadata_only) {
+      perf_submit_metadata(ctx, direction, bytes_count, conn_info, event);
+    } else if (!vecs) {
+      perf_submit_wrapper(ctx, direction, args->buf, send_bytes_count, conn_info, event);
     } else {
       // TODO(yzhao): iov[0] is copied twice, once in calling update_traffic_class(), and here.
       // This happens to the write probes as well, but the calls are placed in the entry and return
       // probes respectively. Consider remove one copy.
-      perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, bytes_count, conn_info, event);
+#ifdef COALESCE_IOVECS
+      perf_submit_coalesced_iovecs(ctx, direction, args->iov, args->iovlen, send_bytes_count,
+                                   conn_info, event);
+#else
+      perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, send_bytes_count, conn_info,
+                         event);
+#endif
     }
   }
 
@@ -794,6 +1070,9 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
       break;
   }
 
+#ifdef USE_CONN_STATS_MAP
+  update_conn_stats_map(conn_info, /* conn_events */ 0);
+#else
   // Only send event if there's been enough of a change.
   // TODO(oazizi): Add elapsed time since last send as a triggering condition too.
   uint64_t total_bytes = conn_info->wr_bytes + conn_info->rd_bytes;
@@ -807,6 +1086,7 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
 
     conn_info->last_reported_bytes = conn_info->rd_bytes + conn_info->wr_bytes;
   }
+#endif
 
   return;
 }
@@ -834,6 +1114,21 @@ static __inline void process_syscall_data_vecs(struct pt_regs* ctx, uint64_t id,
   process_data(/* vecs */ true, ctx, id, direction, args, bytes_count, /* ssl */ false);
 }
 
+// Processes the first num_msgs messages of a sendmmsg()/recvmmsg() call, up to MMSG_LIMIT, each as
+// if it came from its own sendmsg()/recvmsg() call. Each message is then sent in its own data
+// events, which keeps the boundaries of the messages, eg. UDP datagrams, in the data stream.
+static __inline void process_syscall_data_mmsgs(struct pt_regs* ctx, uint64_t id,
+                                                const enum TrafficDirection direction,
+                                                struct data_args_t* args, int num_msgs) {
+  for (unsigned int i = 0; i < MMSG_LIMIT && i < num_msgs; ++i) {
+    struct mmsghdr msg;
+    bpf_probe_read(&msg, sizeof(msg), &args->msgvec[i]);
+    args->iov = msg.msg_hdr.msg_iov;
+    args->iovlen = msg.msg_hdr.msg_iovlen;
+    process_syscall_data_vecs(ctx, id, direction, args, msg.msg_len);
+  }
+}
+
 static __inline void process_syscall_close(struct pt_regs* ctx, uint64_t id,
                                            const struct close_args_t* close_args) {
   uint32_t tgid = id >> 32;
@@ -867,14 +1162,21 @@ static __inline void process_syscall_close(struct pt_regs* ctx, uint64_t id,
     submit_close_event(ctx, conn_info);
 
     // Report final conn stats event for this connection.
+#ifdef USE_CONN_STATS_MAP
+    update_conn_stats_map(conn_info, CONN_CLOSE);
+#else
     struct conn_stats_event_t* event = fill_conn_stats_event(conn_info);
     if (event != NULL) {
       event->conn_events = event->conn_events | CONN_CLOSE;
       conn_stats_events.perf_submit(ctx, event, sizeof(struct conn_stats_event_t));
     }
+#endif
   }
 
-  conn_info_map.delete(&tgid_fd);
+  if (conn_info_map.delete(&tgid_fd) == 0) {
+    inc_conn_info_map_stat(kConnInfoMapDeletes);
+  }
+  conn_capture_limit_map.delete(&tgid_fd);
 }
 
 /***********************************************************
@@ -907,6 +1209,10 @@ int syscall__probe_ret_open(struct pt_regs* ctx) {
 // int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen);
 int syscall__probe_entry_connect(struct pt_regs* ctx, int sockfd, const struct sockaddr* addr,
                                  socklen_t addrlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -934,6 +1240,10 @@ int syscall__probe_ret_connect(struct pt_regs* ctx) {
 // int accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
 int syscall__probe_entry_accept(struct pt_regs* ctx, int sockfd, struct sockaddr* addr,
                                 socklen_t* addrlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -960,6 +1270,10 @@ int syscall__probe_ret_accept(struct pt_regs* ctx) {
 // int accept4(int sockfd, struct sockaddr *addr, socklen_t *addrlen, int flags);
 int syscall__probe_entry_accept4(struct pt_regs* ctx, int sockfd, struct sockaddr* addr,
                                  socklen_t* addrlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -985,6 +1299,10 @@ int syscall__probe_ret_accept4(struct pt_regs* ctx) {
 
 // ssize_t write(int fd, const void *buf, size_t count);
 int syscall__probe_entry_write(struct pt_regs* ctx, int fd, char* buf, size_t count) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1014,6 +1332,10 @@ int syscall__probe_ret_write(struct pt_regs* ctx) {
 
 // ssize_t send(int sockfd, const void *buf, size_t len, int flags);
 int syscall__probe_entry_send(struct pt_regs* ctx, int sockfd, char* buf, size_t len) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1042,6 +1364,10 @@ int syscall__probe_ret_send(struct pt_regs* ctx) {
 
 // ssize_t read(int fd, void *buf, size_t count);
 int syscall__probe_entry_read(struct pt_regs* ctx, int fd, char* buf, size_t count) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1071,6 +1397,10 @@ int syscall__probe_ret_read(struct pt_regs* ctx) {
 
 // ssize_t recv(int sockfd, void *buf, size_t len, int flags);
 int syscall__probe_entry_recv(struct pt_regs* ctx, int sockfd, char* buf, size_t len) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1101,6 +1431,10 @@ int syscall__probe_ret_recv(struct pt_regs* ctx) {
 //                const struct sockaddr *dest_addr, socklen_t addrlen);
 int syscall__probe_entry_sendto(struct pt_regs* ctx, int sockfd, char* buf, size_t len, int flags,
                                 const struct sockaddr* dest_addr, socklen_t addrlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1160,6 +1494,10 @@ int syscall__probe_ret_sendto(struct pt_regs* ctx) {
 //                  struct sockaddr *src_addr, socklen_t *addrlen);
 int syscall__probe_entry_recvfrom(struct pt_regs* ctx, int sockfd, char* buf, size_t len, int flags,
                                   struct sockaddr* src_addr, socklen_t* addrlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1204,6 +1542,10 @@ int syscall__probe_ret_recvfrom(struct pt_regs* ctx) {
 // ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags);
 int syscall__probe_entry_sendmsg(struct pt_regs* ctx, int sockfd,
                                  const struct user_msghdr* msghdr) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   if (msghdr != NULL) {
@@ -1250,9 +1592,13 @@ int syscall__probe_ret_sendmsg(struct pt_regs* ctx) {
 
 int syscall__probe_entry_sendmmsg(struct pt_regs* ctx, int sockfd, struct mmsghdr* msgvec,
                                   unsigned int vlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
-  // TODO(oazizi): Right now, we only trace the first message in a sendmmsg() call.
+  // Only the first MMSG_LIMIT messages of a sendmmsg() call are traced.
   if (msgvec != NULL && vlen >= 1) {
     // Stash arguments.
     if (msgvec[0].msg_hdr.msg_name != NULL) {
@@ -1266,9 +1612,7 @@ int syscall__probe_entry_sendmmsg(struct pt_regs* ctx, int sockfd, struct mmsghd
     struct data_args_t write_args = {};
     write_args.source_fn = kSyscallSendMMsg;
     write_args.fd = sockfd;
-    write_args.iov = msgvec[0].msg_hdr.msg_iov;
-    write_args.iovlen = msgvec[0].msg_hdr.msg_iovlen;
-    write_args.msg_len = &msgvec[0].msg_len;
+    write_args.msgvec = msgvec;
     active_write_args_map.update(&id, &write_args);
   }
 
@@ -1289,9 +1633,7 @@ int syscall__probe_ret_sendmmsg(struct pt_regs* ctx) {
   // Unstash arguments, and process syscall.
   struct data_args_t* write_args = active_write_args_map.lookup(&id);
   if (write_args != NULL && num_msgs > 0) {
-    ssize_t bytes_count;
-    bpf_probe_read(&bytes_count, sizeof(write_args->msg_len), write_args->msg_len);
-    process_syscall_data_vecs(ctx, id, kEgress, write_args, bytes_count);
+    process_syscall_data_mmsgs(ctx, id, kEgress, write_args, num_msgs);
   }
   active_write_args_map.delete(&id);
 
@@ -1300,6 +1642,10 @@ int syscall__probe_ret_sendmmsg(struct pt_regs* ctx) {
 
 // ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags);
 int syscall__probe_entry_recvmsg(struct pt_regs* ctx, int sockfd, struct user_msghdr* msghdr) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   if (msghdr != NULL) {
@@ -1348,9 +1694,13 @@ int syscall__probe_ret_recvmsg(struct pt_regs* ctx) {
 //              int flags, struct timespec *timeout);
 int syscall__probe_entry_recvmmsg(struct pt_regs* ctx, int sockfd, struct mmsghdr* msgvec,
                                   unsigned int vlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
-  // TODO(oazizi): Right now, we only trace the first message in a recvmmsg() call.
+  // Only the first MMSG_LIMIT messages of a recvmmsg() call are traced.
   if (msgvec != NULL && vlen >= 1) {
     // Stash arguments.
     if (msgvec[0].msg_hdr.msg_name != NULL) {
@@ -1364,9 +1714,7 @@ int syscall__probe_entry_recvmmsg(struct pt_regs* ctx, int sockfd, struct mmsghd
     struct data_args_t read_args = {};
     read_args.source_fn = kSyscallRecvMMsg;
     read_args.fd = sockfd;
-    read_args.iov = msgvec[0].msg_hdr.msg_iov;
-    read_args.iovlen = msgvec[0].msg_hdr.msg_iovlen;
-    read_args.msg_len = &msgvec[0].msg_len;
+    read_args.msgvec = msgvec;
     active_read_args_map.update(&id, &read_args);
   }
 
@@ -1387,9 +1735,7 @@ int syscall__probe_ret_recvmmsg(struct pt_regs* ctx) {
   // Unstash arguments, and process syscall.
   struct data_args_t* read_args = active_read_args_map.lookup(&id);
   if (read_args != NULL && num_msgs > 0) {
-    ssize_t bytes_count;
-    bpf_probe_read(&bytes_count, sizeof(read_args->msg_len), read_args->msg_len);
-    process_syscall_data_vecs(ctx, id, kIngress, read_args, bytes_count);
+    process_syscall_data_mmsgs(ctx, id, kIngress, read_args, num_msgs);
   }
   active_read_args_map.delete(&id);
 
@@ -1398,6 +1744,10 @@ int syscall__probe_ret_recvmmsg(struct pt_regs* ctx) {
 
 // ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
 int syscall__probe_entry_writev(struct pt_regs* ctx, int fd, const struct iovec* iov, int iovlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1427,6 +1777,10 @@ int syscall__probe_ret_writev(struct pt_regs* ctx) {
 
 // ssize_t readv(int fd, const struct iovec *iov, int iovcnt);
 int syscall__probe_entry_readv(struct pt_regs* ctx, int fd, struct iovec* iov, int iovlen) {
+  if (!cgroup_filter_passes()) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
 
   // Stash arguments.
@@ -1480,7 +1834,14 @@ int syscall__probe_ret_close(struct pt_regs* ctx) {
 }
 
 // void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
-int syscall__probe_entry_mmap(struct pt_regs* ctx) {
+int syscall__probe_entry_mmap(struct pt_regs* ctx, void* addr, size_t length, int prot, int flags,
+                              int fd) {
+  // Only executable mappings of files can load a library. This leaves out the anonymous mappings
+  // of allocators and thread stacks, which are most of the mmap calls.
+  if ((prot & kProtExec) == 0 || (flags & kMapAnonymous) != 0 || fd < 0) {
+    return 0;
+  }
+
   uint64_t id = bpf_get_current_pid_tgid();
   struct upid_t upid = {};
   upid.tgid = id >> 32;
@@ -24,10 +24,15 @@
 // Must be a power of two, otherwise masking will break.
 #define HEADER_FIELD_STR_SIZE 128
 #define MAX_DATA_SIZE 16384
+// The header fields of a frame are submitted in batches of up to this many fields.
+// Must be a power of two, otherwise masking will break.
+#define HEADER_BATCH_SIZE 8
 
 // These checks are here for compatibility with BPF_LEN_CAP.
 #ifdef __cplusplus
 static_assert((MAX_DATA_SIZE & (MAX_DATA_SIZE - 1)) == 0, "MAX_DATA_SIZE must be a power of 2.");
+static_assert((HEADER_BATCH_SIZE & (HEADER_BATCH_SIZE - 1)) == 0,
+              "HEADER_BATCH_SIZE must be a power of 2.");
 #endif
 
 struct header_field_t {
@@ -35,6 +40,11 @@ struct header_field_t {
   char msg[HEADER_FIELD_STR_SIZE];
 };
 
+struct go_grpc_http2_header_field_t {
+  struct header_field_t name;
+  struct header_field_t value;
+};
+
 enum http2_probe_type_t {
   k_probe_http2_operate_headers,
   k_probe_loopy_writer_write_header,
@@ -58,11 +68,13 @@ struct go_grpc_http2_header_event_t {
     uint64_t timestamp_ns;
     struct conn_id_t conn_id;
     uint32_t stream_id;
+    // Set on the last batch of the frame that ends the stream.
     bool end_stream;
   } attr;
 
-  struct header_field_t name;
-  struct header_field_t value;
+  // The number of fields in the batch. The event is submitted with only these fields.
+  uint32_t num_fields;
+  struct go_grpc_http2_header_field_t fields[HEADER_BATCH_SIZE];
 };
 
 enum DataFrameEventType { kDataFrameEventUnknown, kDataFrameEventRead, kDataFrameEventWrite };
@@ -19,7 +19,9 @@
 #pragma once
 
 #include <algorithm>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <magic_enum.hpp>
 
@@ -92,32 +94,27 @@ struct HTTP2DataEvent {
 
 struct HTTP2HeaderEvent {
   HTTP2HeaderEvent() : attr{} {}
-  explicit HTTP2HeaderEvent(const void* data) {
-    auto data_ptr = static_cast<const char*>(data);
-
-    // Pointers into relevant sub-fields within the go_grpc_http2_header_event_t struct.
-    auto attr_ptr = data_ptr + offsetof(go_grpc_http2_header_event_t, attr);
-    auto name_data_ptr = data_ptr + offsetof(go_grpc_http2_header_event_t, name.msg);
-    auto name_len_ptr = data_ptr + offsetof(go_grpc_http2_header_event_t, name.size);
-    auto value_data_ptr = data_ptr + offsetof(go_grpc_http2_header_event_t, value.msg);
-    auto value_len_ptr = data_ptr + offsetof(go_grpc_http2_header_event_t, value.size);
-
-    // Copy attr sub-struct via memcpy as char -- requires 1-byte alignment.
-    memcpy(&attr, attr_ptr, sizeof(go_grpc_http2_header_event_t::header_attr_t));
+  // Reads the name and value of a go_grpc_http2_header_field_t.
+  HTTP2HeaderEvent(const go_grpc_http2_header_event_t::header_attr_t& event_attr,
+                   const char* field_ptr)
+      : attr(event_attr) {
+    // Pointers into relevant sub-fields within the go_grpc_http2_header_field_t struct.
+    auto name_data_ptr = field_ptr + offsetof(go_grpc_http2_header_field_t, name.msg);
+    auto name_len_ptr = field_ptr + offsetof(go_grpc_http2_header_field_t, name.size);
+    auto value_data_ptr = field_ptr + offsetof(go_grpc_http2_header_field_t, value.msg);
+    auto value_len_ptr = field_ptr + offsetof(go_grpc_http2_header_field_t, value.size);
 
     // Copy name length (uint32_t) -- requires 4-byte alignment.
     uint32_t name_len = *reinterpret_cast<const uint32_t*>(name_len_ptr);
 
     // Copy name string (char) -- requires 1-byte alignment.
-    name.assign(name_data_ptr,
-                std::min<uint32_t>(name_len, sizeof(go_grpc_http2_header_event_t::name)));
+    name.assign(name_data_ptr, std::min<uint32_t>(name_len, HEADER_FIELD_STR_SIZE));
 
     // Copy value length (uint32_t) -- requires 4-byte alignment.
     uint32_t value_len = *reinterpret_cast<const uint32_t*>(value_len_ptr);
 
     // Copy value string (char) -- requires 1-byte alignment.
-    value.assign(value_data_ptr,
-                 std::min<uint32_t>(value_len, sizeof(go_grpc_http2_header_event_t::value)));
+    value.assign(value_data_ptr, std::min<uint32_t>(value_len, HEADER_FIELD_STR_SIZE));
   }
 
   std::string ToString() const {
@@ -130,5 +127,51 @@ struct HTTP2HeaderEvent {
   std::string value;
 };
 
+/**
+ * Unpacks a go_grpc_http2_header_event_t, which carries a batch of header fields, into one
+ * HTTP2HeaderEvent per field. If the batch ends the stream, it is followed by an empty event with
+ * end_stream set.
+ *
+ * @param data the event, as submitted to the perf buffer.
+ * @param data_size the size of the event, which holds only the fields of the batch.
+ */
+inline std::vector<std::unique_ptr<HTTP2HeaderEvent>> UnpackHTTP2HeaderEvents(const void* data,
+                                                                              int data_size) {
+  auto data_ptr = static_cast<const char*>(data);
+  constexpr size_t kFieldsOffset = offsetof(go_grpc_http2_header_event_t, fields);
+  constexpr size_t kFieldSize = sizeof(go_grpc_http2_header_field_t);
+
+  std::vector<std::unique_ptr<HTTP2HeaderEvent>> events;
+  if (data_size < static_cast<int>(kFieldsOffset)) {
+    return events;
+  }
+
+  // Copy attr sub-struct via memcpy as char -- requires 1-byte alignment.
+  go_grpc_http2_header_event_t::header_attr_t attr;
+  memcpy(&attr, data_ptr + offsetof(go_grpc_http2_header_event_t, attr), sizeof(attr));
+  const bool end_stream = attr.end_stream;
+  attr.end_stream = false;
+
+  // Copy num_fields (uint32_t) -- requires 4-byte alignment.
+  uint32_t num_fields = *reinterpret_cast<const uint32_t*>(
+      data_ptr + offsetof(go_grpc_http2_header_event_t, num_fields));
+  num_fields = std::min<uint32_t>(num_fields, HEADER_BATCH_SIZE);
+  num_fields =
+      std::min<uint32_t>(num_fields, (static_cast<size_t>(data_size) - kFieldsOffset) / kFieldSize);
+
+  events.reserve(num_fields + (end_stream ? 1 : 0));
+  for (uint32_t i = 0; i < num_fields; ++i) {
+    events.push_back(
+        std::make_unique<HTTP2HeaderEvent>(attr, data_ptr + kFieldsOffset + i * kFieldSize));
+  }
+  if (end_stream) {
+    auto end_stream_event = std::make_unique<HTTP2HeaderEvent>();
+    end_stream_event->attr = attr;
+    end_stream_event->attr.end_stream = true;
+    events.push_back(std::move(end_stream_event));
+  }
+  return events;
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/go_grpc_types.hpp"
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+void SetField(struct header_field_t* field, std::string_view str) {
+  field->size = str.size();
+  memcpy(field->msg, str.data(), str.size());
+}
+
+// Returns the bytes of the event as BPF submits them, with only the first num_fields fields.
+std::string Submitted(const go_grpc_http2_header_event_t& event, uint32_t num_fields) {
+  size_t size = offsetof(go_grpc_http2_header_event_t, fields) +
+                num_fields * sizeof(go_grpc_http2_header_field_t);
+  return std::string(reinterpret_cast<const char*>(&event), size);
+}
+
+}  // namespace
+
+// BPF submits the batch up to the last field, so the fields must follow the attributes.
+TEST(GoGRPCHeaderEventTest, VerifyAlignment) {
+  EXPECT_EQ(0, offsetof(go_grpc_http2_header_event_t, attr));
+  EXPECT_EQ(sizeof(go_grpc_http2_header_event_t::attr) + sizeof(uint32_t),
+            offsetof(go_grpc_http2_header_event_t, fields));
+}
+
+TEST(GoGRPCHeaderEventTest, UnpackBatch) {
+  go_grpc_http2_header_event_t event = {};
+  event.attr.type = kHeaderEventWrite;
+  event.attr.stream_id = 7;
+  event.attr.end_stream = true;
+  event.num_fields = 2;
+  SetField(&event.fields[0].name, ":method");
+  SetField(&event.fields[0].value, "POST");
+  SetField(&event.fields[1].name, "content-type");
+  SetField(&event.fields[1].value, "application/grpc");
+
+  std::string data = Submitted(event, 2);
+  std::vector<std::unique_ptr<HTTP2HeaderEvent>> events =
+      UnpackHTTP2HeaderEvents(data.data(), data.size());
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[0]->name, ":method");
+  EXPECT_EQ(events[0]->value, "POST");
+  EXPECT_EQ(events[0]->attr.stream_id, 7);
+  EXPECT_FALSE(events[0]->attr.end_stream);
+  EXPECT_EQ(events[1]->name, "content-type");
+  EXPECT_EQ(events[1]->value, "application/grpc");
+  EXPECT_FALSE(events[1]->attr.end_stream);
+
+  // The end of the stream comes as an empty header, like ConnTracker expects.
+  EXPECT_TRUE(events[2]->name.empty());
+  EXPECT_TRUE(events[2]->value.empty());
+  EXPECT_TRUE(events[2]->attr.end_stream);
+}
+
+TEST(GoGRPCHeaderEventTest, UnpackTruncated) {
+  go_grpc_http2_header_event_t event = {};
+  event.num_fields = 3;
+  SetField(&event.fields[0].name, "a");
+
+  // Fields past the end of the submitted data are ignored.
+  std::string data = Submitted(event, 1);
+  EXPECT_EQ(UnpackHTTP2HeaderEvents(data.data(), data.size()).size(), 1);
+  EXPECT_TRUE(UnpackHTTP2HeaderEvents(data.data(), 4).empty());
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -32,6 +32,22 @@ const uint64_t kSocketTraceNothing = 0;
 const int64_t kTraceAllTGIDs = -1;
 const char kControlValuesArrayName[] = "control_values";
 
+const char kConnInfoMapStatsArrayName[] = "conn_info_map_stats";
+
+// Specifies the indexes of the counters in conn_info_map_stats.
+enum ConnInfoMapStatIndex {
+  kConnInfoMapInserts = 0,
+  // Inserts that failed, e.g. because the (non-LRU) map was full. Such connections are not traced.
+  kConnInfoMapInsertFailures,
+  kConnInfoMapDeletes,
+  kNumConnInfoMapStats,
+};
+
+const char kTracePolicyMapName[] = "trace_policy_map";
+const char kConnCaptureLimitMapName[] = "conn_capture_limit_map";
+// The sample rates of trace policies are out of this many connections.
+const uint32_t kTracePolicySampleRateDenom = 100;
+
 // Note: A value of 100 results in >4096 BPF instructions, which is too much for older kernels.
 #define CONN_CLEANUP_ITERS 90
 const int kMaxConnMapCleanupItems = CONN_CLEANUP_ITERS;
@@ -87,6 +103,37 @@ struct conn_info_t {
   char prev_buf[4];
 };
 
+// The key of a trace policy. A tgid of 0 applies to all the processes without a policy of their
+// own.
+struct trace_policy_key_t {
+  uint32_t tgid;
+  enum TrafficProtocol protocol;
+  enum EndpointRole role;
+};
+
+// A policy set by user-space, to send only part of the data of the matching connections to
+// user-space. Connections without a policy have all their data sent.
+struct trace_policy_t {
+  // The number of connections, out of kTracePolicySampleRateDenom, whose data is sent.
+  // Whole connections are sampled, rather than events, so the traced ones keep complete streams.
+  uint32_t sample_rate;
+
+  // The maximum number of bytes sent for each syscall, or 0 for no limit. This is used to only
+  // capture the headers of messages; the rest of the message shows up as a gap in the data stream.
+  uint32_t max_bytes_per_syscall;
+};
+
+// A limit on the data captured from the TLS uprobes of a connection, which user-space sets once
+// it has parsed the connection's protocol headers.
+struct conn_capture_limit_t {
+  // The connection generation that the limit applies to.
+  uint64_t tsid;
+
+  // The maximum number of bytes sent for each call. If 0, only the metadata (the size and the
+  // timestamp) of each call is sent.
+  uint32_t max_bytes_per_call;
+};
+
 // This struct is a subset of conn_info_t. It is used to communicate connect/accept events.
 // See conn_info_t for descriptions of the members.
 struct conn_event_t {
@@ -289,8 +336,8 @@ struct data_args_t {
   // For sendmsg()/recvmsg()/writev()/readv().
   const struct iovec* iov;
   size_t iovlen;
-  // For sendmmsg()
-  unsigned int* msg_len;
+  // For sendmmsg()/recvmmsg().
+  const struct mmsghdr* msgvec;
 };
 
 struct close_args_t {
@@ -54,6 +54,12 @@ DEFINE_int64(
     stirling_check_proc_for_conn_close, true,
     "If enabled, Stirling will check Linux /proc on idle connections to see if they are closed.");
 
+DEFINE_int32(stirling_tls_capture_bytes_after_headers,
+             gflags::Int32FromEnv("PL_STIRLING_TLS_CAPTURE_BYTES_AFTER_HEADERS", -1),
+             "If not negative, once the first record of a TLS connection is parsed, the TLS "
+             "uprobes only send this many bytes of each call, or only the sizes and timestamps "
+             "if 0. This caps the data of bulk transfers over TLS.");
+
 DECLARE_int32(test_only_socket_trace_target_pid);
 
 namespace px {
@@ -71,6 +77,9 @@ ConnTracker::~ConnTracker() {
   CONN_TRACE(2) << "Being destroyed";
   if (conn_info_map_mgr_ != nullptr) {
     conn_info_map_mgr_->ReleaseResources(conn_id_);
+    if (capture_limited_) {
+      conn_info_map_mgr_->ReleaseCaptureLimit(conn_id_);
+    }
   }
 }
 
@@ -126,6 +135,7 @@ void ConnTracker::AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
   CheckTracker();
   UpdateTimestamps(event->attr.timestamp_ns);
   UpdateDataStats(*event);
+  ssl_ |= event->attr.ssl;
 
   CONN_TRACE(1) << absl::Substitute("Data event received: $0", event->ToString());
 
@@ -146,10 +156,10 @@ void ConnTracker::AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
 
   switch (event->attr.direction) {
     case TrafficDirection::kEgress: {
-      send_data_.AddData(std::move(event));
+      mutable_protocol_data().send_data.AddData(std::move(event));
     } break;
     case TrafficDirection::kIngress: {
-      recv_data_.AddData(std::move(event));
+      mutable_protocol_data().recv_data.AddData(std::move(event));
     } break;
   }
 }
@@ -186,7 +196,9 @@ protocols::http2::HalfStream* ConnTracker::HalfStreamPtr(uint32_t stream_id, boo
   // Server-initiated streams have even stream IDs.
   // https://tools.ietf.org/html/rfc7540#section-5.1.1
   const bool client_stream = (stream_id % 2 == 1);
-  HTTP2StreamsContainer& streams = client_stream ? http2_client_streams_ : http2_server_streams_;
+  ProtocolData& data = mutable_protocol_data();
+  HTTP2StreamsContainer& streams =
+      client_stream ? data.http2_client_streams : data.http2_server_streams;
   return streams.HalfStreamPtr(stream_id, write_event);
 }
 
@@ -212,6 +224,7 @@ void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
   }
 
   CONN_TRACE(2) << absl::Substitute("HTTP2 header event received: $0", hdr->ToString());
+  http2_uprobe_events_ = true;
 
   if (conn_id_.fd == 0) {
     Disable(
@@ -289,6 +302,7 @@ void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
   }
 
   CONN_TRACE(1) << absl::Substitute("HTTP2 data event received: $0", data->ToString());
+  http2_uprobe_events_ = true;
 
   if (conn_id_.fd == 0) {
     Disable(
@@ -343,13 +357,47 @@ void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
   half_stream_ptr->UpdateTimestamp(data->attr.timestamp_ns);
 }
 
+protocols::http2::FrameDecoder* ConnTracker::HTTP2FrameDecoder(bool write_event) {
+  auto& decoder = write_event ? http2_send_decoder_ : http2_recv_decoder_;
+  if (decoder == nullptr) {
+    decoder = std::make_unique<protocols::http2::FrameDecoder>();
+  }
+  return decoder.get();
+}
+
+void ConnTracker::DecodeHTTP2Frames(bool write_event) {
+  ProtocolData& data = mutable_protocol_data();
+  DataStream* data_stream = write_event ? &data.send_data : &data.recv_data;
+  // Frames are parsed the same way in both directions.
+  data_stream->ProcessBytesToFrames<protocols::http2::Frame>(MessageType::kUnknown);
+
+  auto& frames = data_stream->Frames<protocols::http2::Frame>();
+  if (frames.empty()) {
+    return;
+  }
+  HTTP2FrameDecoder(write_event)->Decode(frames, [this, write_event](uint32_t stream_id) {
+    return HalfStreamPtr(stream_id, write_event);
+  });
+  frames.clear();
+}
+
 template <>
 std::vector<protocols::http2::Record>
 ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>() {
   protocols::RecordsWithErrorCount<protocols::http2::Record> result;
+  ProtocolData& data = mutable_protocol_data();
+
+  if (http2_uprobe_events_) {
+    // Don't double count the traffic that the kprobes also captured, eg. for plain-text gRPC.
+    data.send_data.Reset();
+    data.recv_data.Reset();
+  } else {
+    DecodeHTTP2Frames(/*write_event*/ true);
+    DecodeHTTP2Frames(/*write_event*/ false);
+  }
 
-  protocols::http2::ProcessHTTP2Streams(&http2_client_streams_, IsZombie(), &result);
-  protocols::http2::ProcessHTTP2Streams(&http2_server_streams_, IsZombie(), &result);
+  protocols::http2::ProcessHTTP2Streams(&data.http2_client_streams, IsZombie(), &result);
+  protocols::http2::ProcessHTTP2Streams(&data.http2_server_streams, IsZombie(), &result);
 
   UpdateResultStats(result);
 
@@ -357,10 +405,51 @@ ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>() {
 }
 
 void ConnTracker::Reset() {
-  send_data_.Reset();
-  recv_data_.Reset();
+  if (protocol_data_ == nullptr) {
+    return;
+  }
+
+  // The unparsed HTTP2 frames are dropped, which the HPACK decoders need to know about.
+  if (protocol_ == kProtocolHTTP2) {
+    if (!protocol_data_->send_data.data_buffer().empty()) {
+      HTTP2FrameDecoder(/*write_event*/ true)->MarkDataLoss();
+    }
+    if (!protocol_data_->recv_data.data_buffer().empty()) {
+      HTTP2FrameDecoder(/*write_event*/ false)->MarkDataLoss();
+    }
+  }
+
+  protocol_data_->send_data.Reset();
+  protocol_data_->recv_data.Reset();
+
+  protocol_data_->protocol_state.reset();
+}
 
-  protocol_state_.reset();
+const ConnTracker::ProtocolData& ConnTracker::protocol_data() const {
+  static const ProtocolData* const kEmptyProtocolData = new ProtocolData();
+  return protocol_data_ != nullptr ? *protocol_data_ : *kEmptyProtocolData;
+}
+
+size_t ConnTracker::MemUsage() const {
+  size_t size = sizeof(ConnTracker);
+  if (protocol_data_ != nullptr) {
+    size += sizeof(ProtocolData);
+    size += protocol_data_->send_data.data_buffer().size();
+    size += protocol_data_->recv_data.data_buffer().size();
+  }
+  return size;
+}
+
+void ConnTracker::MaybeLimitCapture() {
+  if (FLAGS_stirling_tls_capture_bytes_after_headers < 0 || !ssl_ || capture_limited_ ||
+      state_ == State::kDisabled || conn_info_map_mgr_ == nullptr ||
+      stats_.Get(StatKey::kValidRecords) == 0) {
+    return;
+  }
+  conn_info_map_mgr_->LimitCapture(conn_id_, FLAGS_stirling_tls_capture_bytes_after_headers);
+  capture_limited_ = true;
+  CONN_TRACE(1) << absl::Substitute("Limiting TLS capture to $0 bytes per call",
+                                    FLAGS_stirling_tls_capture_bytes_after_headers);
 }
 
 void ConnTracker::Disable(std::string_view reason) {
@@ -503,9 +592,9 @@ DataStream* ConnTracker::req_data() {
   DCHECK_NE(role_, kRoleUnknown);
   switch (role_) {
     case kRoleClient:
-      return &send_data_;
+      return &mutable_protocol_data().send_data;
     case kRoleServer:
-      return &recv_data_;
+      return &mutable_protocol_data().recv_data;
     default:
       return nullptr;
   }
@@ -515,9 +604,9 @@ DataStream* ConnTracker::resp_data() {
   DCHECK_NE(role_, kRoleUnknown);
   switch (role_) {
     case kRoleClient:
-      return &recv_data_;
+      return &mutable_protocol_data().recv_data;
     case kRoleServer:
-      return &send_data_;
+      return &mutable_protocol_data().send_data;
     default:
       return nullptr;
   }
@@ -655,7 +744,7 @@ void ConnTracker::UpdateDataStats(const SocketDataEvent& event) {
 
 void ConnTracker::IterationPreTick(
     const std::chrono::time_point<std::chrono::steady_clock>& iteration_time,
-    const std::vector<CIDRBlock>& cluster_cidrs, system::ProcParser* proc_parser,
+    const std::vector<CIDRBlock>& cluster_cidrs, FDLinkCache* fd_link_cache,
     system::SocketInfoManager* socket_info_mgr) {
   set_current_time(iteration_time);
 
@@ -671,7 +760,7 @@ void ConnTracker::IterationPreTick(
   // If remote_addr is missing, it means the connect/accept was not traced.
   // Attempt to infer the connection information, to populate remote_addr.
   if (open_info_.remote_addr.family == SockAddrFamily::kUnspecified && socket_info_mgr != nullptr) {
-    InferConnInfo(proc_parser, socket_info_mgr);
+    InferConnInfo(fd_link_cache, socket_info_mgr);
 
     // TODO(oazizi): If connection resolves to SockAddr type "Other",
     //               we should mark the state in BPF to Other too, so BPF stops tracing.
@@ -762,6 +851,45 @@ void ConnTracker::HandleInactivity() {
   }
 }
 
+std::optional<std::chrono::time_point<std::chrono::steady_clock>> ConnTracker::IdleUntil(
+    std::chrono::nanoseconds iteration_period) const {
+  // Zombies count down to their destruction.
+  if (IsZombie()) {
+    return std::nullopt;
+  }
+
+  // Trackers that are waiting on the connection inference, or that are collecting with a known
+  // role, may change state at any iteration. Disabled trackers skip all of that.
+  if (state_ != State::kDisabled) {
+    if (conn_resolver_ != nullptr) {
+      return std::nullopt;
+    }
+    if (open_info_.remote_addr.family == SockAddrFamily::kUnspecified &&
+        !conn_resolution_failed_) {
+      return std::nullopt;
+    }
+    if (state_ == State::kCollecting && role_ != kRoleUnknown) {
+      return std::nullopt;
+    }
+  }
+
+  // Buffered data is parsed and expired by the iterations.
+  if (protocol_data_ != nullptr &&
+      (protocol_data_->send_data.HasData() || protocol_data_->recv_data.HasData() ||
+       protocol_data_->http2_client_streams.num_streams() > 0 ||
+       protocol_data_->http2_server_streams.num_streams() > 0)) {
+    return std::nullopt;
+  }
+
+  // What remains is HandleInactivity().
+  auto due = last_activity_timestamp_ + InactivityDuration();
+  if (FLAGS_stirling_check_proc_for_conn_close) {
+    int iters = std::max(idle_iteration_threshold_ - idle_iteration_count_, 1);
+    due = std::min(due, current_time_ + iters * iteration_period);
+  }
+  return due;
+}
+
 double ConnTracker::StitchFailureRate() const {
   int total_attempts = stats_.Get(StatKey::kInvalidRecords) + stats_.Get(StatKey::kValidRecords);
 
@@ -813,9 +941,9 @@ EndpointRole TranslateRole(system::ClientServerRole role) {
 
 }  // namespace
 
-void ConnTracker::InferConnInfo(system::ProcParser* proc_parser,
+void ConnTracker::InferConnInfo(FDLinkCache* fd_link_cache,
                                 system::SocketInfoManager* socket_info_mgr) {
-  DCHECK(proc_parser != nullptr);
+  DCHECK(fd_link_cache != nullptr);
   DCHECK(socket_info_mgr != nullptr);
 
   if (conn_resolution_failed_) {
@@ -827,7 +955,7 @@ void ConnTracker::InferConnInfo(system::ProcParser* proc_parser,
   }
 
   if (conn_resolver_ == nullptr) {
-    conn_resolver_ = std::make_unique<FDResolver>(proc_parser, conn_id_.upid.pid, conn_id_.fd);
+    conn_resolver_ = std::make_unique<FDResolver>(fd_link_cache, conn_id_.upid.pid, conn_id_.fd);
     bool success = conn_resolver_->Setup();
     if (!success) {
       conn_resolver_.reset();
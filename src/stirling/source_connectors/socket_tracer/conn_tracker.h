@@ -23,6 +23,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <variant>
@@ -37,6 +38,7 @@
 #include "src/stirling/source_connectors/socket_tracer/data_stream.h"
 #include "src/stirling/source_connectors/socket_tracer/fd_resolver.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/frame_decoder.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/http2_streams_container.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
 // Include all specializations of the StitchFrames() template specializations for all protocols.
@@ -48,6 +50,7 @@ DECLARE_int64(stirling_conn_trace_pid);
 DECLARE_int64(stirling_conn_trace_fd);
 DECLARE_bool(stirling_conn_disable_to_bpf);
 DECLARE_int64(stirling_check_proc_for_conn_close);
+DECLARE_int32(stirling_tls_capture_bytes_after_headers);
 
 #define CONN_TRACE(level) LOG_IF(INFO, level <= debug_trace_level_) << ToString() << " "
 
@@ -228,10 +231,10 @@ class ConnTracker : NotCopyMoveable {
    *
    * Intended for cases where the accept/connect was not traced.
    *
-   * @param proc_parser Pointer to a proc_parser for access to /proc filesystem.
+   * @param fd_link_cache Pointer to the cache of the /proc/<pid>/fd links.
    * @param connections A map of inodes to endpoint information.
    */
-  void InferConnInfo(system::ProcParser* proc_parser, system::SocketInfoManager* socket_info_mgr);
+  void InferConnInfo(FDLinkCache* fd_link_cache, system::SocketInfoManager* socket_info_mgr);
 
   /**
    * Processes the connection tracker, parsing raw events into frames,
@@ -264,8 +267,9 @@ class ConnTracker : NotCopyMoveable {
     CONN_TRACE(1) << absl::Substitute("records=$0", result.records.size());
 
     UpdateResultStats(result);
+    MaybeLimitCapture();
 
-    return result.records;
+    return std::move(result.records);
   }
 
   /**
@@ -280,11 +284,15 @@ class ConnTracker : NotCopyMoveable {
   // not set that. So send_data() is created. Investigate more unified approach.
   template <typename TFrameType>
   const std::deque<TFrameType>& send_frames() const {
-    return send_data_.Frames<TFrameType>();
+    return protocol_data().send_data.Frames<TFrameType>();
   }
 
-  size_t http2_client_streams_size() const { return http2_client_streams_.streams().size(); }
-  size_t http2_server_streams_size() const { return http2_server_streams_.streams().size(); }
+  size_t http2_client_streams_size() const {
+    return protocol_data().http2_client_streams.num_streams();
+  }
+  size_t http2_server_streams_size() const {
+    return protocol_data().http2_server_streams.num_streams();
+  }
 
   /**
    * Returns reference to current set of unconsumed responses.
@@ -296,7 +304,7 @@ class ConnTracker : NotCopyMoveable {
   }
   template <typename TFrameType>
   const std::deque<TFrameType>& recv_frames() const {
-    return recv_data_.Frames<TFrameType>();
+    return protocol_data().recv_data.Frames<TFrameType>();
   }
 
   const conn_id_t& conn_id() const { return conn_id_; }
@@ -323,14 +331,14 @@ class ConnTracker : NotCopyMoveable {
    *
    * @return Data stream of send data.
    */
-  const DataStream& send_data() const { return send_data_; }
+  const DataStream& send_data() const { return protocol_data().send_data; }
 
   /**
    * Get the DataStream of received frames for this connection.
    *
    * @return Data stream of received data.
    */
-  const DataStream& recv_data() const { return recv_data_; }
+  const DataStream& recv_data() const { return protocol_data().recv_data; }
 
   /**
    * Get the DataStream of requests for this connection.
@@ -428,12 +436,11 @@ class ConnTracker : NotCopyMoveable {
    * connection tracker.
    * Should be called once per sampling, before ProcessToRecords().
    *
-   * @param proc_parser Pointer to a proc_parser for access to /proc filesystem.
+   * @param fd_link_cache Pointer to the cache of the /proc/<pid>/fd links.
    * @param connections A map of inodes to endpoint information.
    */
   void IterationPreTick(const std::chrono::time_point<std::chrono::steady_clock>& iteration_time,
-                        const std::vector<CIDRBlock>& cluster_cidrs,
-                        system::ProcParser* proc_parser,
+                        const std::vector<CIDRBlock>& cluster_cidrs, FDLinkCache* fd_link_cache,
                         system::SocketInfoManager* socket_info_mgr);
 
   /**
@@ -442,6 +449,17 @@ class ConnTracker : NotCopyMoveable {
    */
   void IterationPostTick();
 
+  /**
+   * Returns whether iterations are no-ops for this tracker until it receives new events: it holds
+   * no data, and is neither dying nor being classified. If so, returns the time at which it needs
+   * to be visited anyway, for the inactivity reset or for the check of /proc for a closed
+   * connection. Should be called after IterationPostTick().
+   *
+   * @param iteration_period The expected time between iterations.
+   */
+  std::optional<std::chrono::time_point<std::chrono::steady_clock>> IdleUntil(
+      std::chrono::nanoseconds iteration_period) const;
+
   /**
    * Sets the duration after which a connection is deemed to be inactive.
    * After becoming inactive, the connection may either (1) have its buffers purged,
@@ -474,6 +492,12 @@ class ConnTracker : NotCopyMoveable {
 
   uint64_t GetStat(StatKey key) const { return stats_.Get(key); }
 
+  /**
+   * Approximate memory held by the tracker: the object itself, its protocol data if it was
+   * allocated, and the raw bytes buffered in its data streams. Parsed frames are not counted.
+   */
+  size_t MemUsage() const;
+
   /**
    * Initializes protocol state for a protocol.
    */
@@ -485,9 +509,10 @@ class ConnTracker : NotCopyMoveable {
     // No need to create an object on the heap for protocols that don't have state.
     // Note that protocol_state() has the same `if constexpr`, for this optimization to work.
     if constexpr (!std::is_same_v<TStateType, protocols::NoState>) {
-      TStateType* state_types_ptr = std::any_cast<TStateType>(&protocol_state_);
+      std::any& protocol_state = mutable_protocol_data().protocol_state;
+      TStateType* state_types_ptr = std::any_cast<TStateType>(&protocol_state);
       if (state_types_ptr == nullptr) {
-        protocol_state_.emplace<TStateType>();
+        protocol_state.emplace<TStateType>();
       }
     }
   }
@@ -501,7 +526,10 @@ class ConnTracker : NotCopyMoveable {
     if constexpr (std::is_same_v<TStateType, protocols::NoState>) {
       return nullptr;
     } else {
-      TStateType* ptr = std::any_cast<TStateType>(&protocol_state_);
+      if (protocol_data_ == nullptr) {
+        return nullptr;
+      }
+      TStateType* ptr = std::any_cast<TStateType>(&protocol_data_->protocol_state);
       return ptr;
     }
   }
@@ -512,26 +540,37 @@ class ConnTracker : NotCopyMoveable {
     using TFrameType = typename TProtocolTraits::frame_type;
     using TStateType = typename TProtocolTraits::state_type;
 
+    // Nothing to clean up if the tracker never collected any traffic.
+    if (protocol_data_ == nullptr) {
+      return;
+    }
+
     if constexpr (std::is_same_v<TFrameType, protocols::http2::Stream>) {
-      http2_client_streams_.Cleanup(size_limit_bytes, expiry_timestamp);
-      http2_server_streams_.Cleanup(size_limit_bytes, expiry_timestamp);
+      protocol_data_->http2_client_streams.Cleanup(size_limit_bytes, expiry_timestamp);
+      protocol_data_->http2_server_streams.Cleanup(size_limit_bytes, expiry_timestamp);
     } else {
-      send_data_.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
-      recv_data_.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
+      protocol_data_->send_data.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
+      protocol_data_->recv_data.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
     }
 
     auto* state = protocol_state<TStateType>();
-    if (send_data_.CleanupEvents()) {
+    if (protocol_data_->send_data.CleanupEvents()) {
       if (state != nullptr) {
         state->global = {};
         state->send = {};
       }
+      if constexpr (std::is_same_v<TFrameType, protocols::http2::Stream>) {
+        HTTP2FrameDecoder(/*write_event*/ true)->MarkDataLoss();
+      }
     }
-    if (recv_data_.CleanupEvents()) {
+    if (protocol_data_->recv_data.CleanupEvents()) {
       if (state != nullptr) {
         state->global = {};
         state->recv = {};
       }
+      if constexpr (std::is_same_v<TFrameType, protocols::http2::Stream>) {
+        HTTP2FrameDecoder(/*write_event*/ false)->MarkDataLoss();
+      }
     }
   }
 
@@ -591,6 +630,10 @@ class ConnTracker : NotCopyMoveable {
 
   void UpdateDataStats(const SocketDataEvent& event);
 
+  // Once a record of a TLS connection is parsed, limits the data that BPF captures from its TLS
+  // uprobes, per --stirling_tls_capture_bytes_after_headers.
+  void MaybeLimitCapture();
+
   template <typename TFrameType>
   void DataStreamsToFrames() {
     DataStream* resp_data_ptr = resp_data();
@@ -608,44 +651,93 @@ class ConnTracker : NotCopyMoveable {
     stats_.Increment(StatKey::kValidRecords, result.records.size());
   }
 
+  // The fields that every event and every iteration touch come first.
+  struct conn_id_t conn_id_ = {};
+  TrafficProtocol protocol_ = kProtocolUnknown;
+  EndpointRole role_ = kRoleUnknown;
+  State state_ = State::kCollecting;
+
+  // The timestamp of the last activity on this connection.
+  // Recorded as the latest timestamp on a BPF event.
+  uint64_t last_bpf_timestamp_ns_ = 0;
+
+  std::chrono::time_point<std::chrono::steady_clock> current_time_;
+
+  // The timestamp of the last update on this connection which alters the states.
+  // Recorded as the latest activity time on the ConnTracker.
+  // Currently using steady clock, so cannot be used meaningfully for logging real times.
+  std::chrono::time_point<std::chrono::steady_clock> last_activity_timestamp_;
+
   int debug_trace_level_ = 0;
 
   // Used to identify the remove endpoint in case the accept/connect was not traced.
   std::unique_ptr<FDResolver> conn_resolver_ = nullptr;
   bool conn_resolution_failed_ = false;
 
-  struct conn_id_t conn_id_ = {};
-
-  TrafficProtocol protocol_ = kProtocolUnknown;
-  EndpointRole role_ = kRoleUnknown;
   SocketOpen open_info_;
   SocketClose close_info_;
   ConnStatsTracker conn_stats_;
   uint64_t last_conn_stats_update_ = 0;
   bool final_conn_stats_reported_ = false;
 
-  // The data collected by the stream, one per direction.
-  DataStream send_data_;
-  DataStream recv_data_;
+  // Whether the data comes from TLS uprobes, and whether BPF was told to limit its capture.
+  bool ssl_ = false;
+  bool capture_limited_ = false;
+
+  // The data collected for the protocol of the connection. It is allocated when the tracker gets
+  // its first traffic of the protocol, so trackers that are never classified or that are
+  // disabled (most of them, on a busy node) don't carry the streams and the protocol state.
+  struct ProtocolData {
+    // The data collected by the stream, one per direction.
+    DataStream send_data;
+    DataStream recv_data;
+
+    // Uprobe-based HTTP2 uses a different scheme, where it holds client and server-initiated
+    // streams, instead of send and recv messages. As such, we create aliases for HTTP2.
+    HTTP2StreamsContainer http2_client_streams;
+    HTTP2StreamsContainer http2_server_streams;
+
+    // Connection trackers need to keep a state because there can be information between
+    // needed from previous requests/responses needed to parse or render current request.
+    // E.g. MySQL keeps a map of previously occurred stmt prepare events as the state such
+    // that future stmt execute events can match up with the correct one using stmt_id.
+    //
+    // TODO(oazizi): Is there a better structure than std::any?
+    // One alternative is an std::variant, but that becomes tedious to maintain with a
+    // growing number of protocols.
+    // Two considerations:
+    // 1) We want something with an interface-type API. The current structure does achieve
+    //    this, but not in a clear way. The compilation errors will be due to SFINAE and
+    //    hard to interpret.
+    // 2) We want something with some type safety. std::any does provide this, in the
+    //    similar way as std::variant.
+    std::any protocol_state;
+  };
+  std::unique_ptr<ProtocolData> protocol_data_;
+
+  // Returns the protocol data, allocating it on first use.
+  ProtocolData& mutable_protocol_data() {
+    if (protocol_data_ == nullptr) {
+      protocol_data_ = std::make_unique<ProtocolData>();
+    }
+    return *protocol_data_;
+  }
 
-  // Uprobe-based HTTP2 uses a different scheme, where it holds client and server-initiated streams,
-  // instead of send and recv messages. As such, we create aliases for HTTP2.
-  HTTP2StreamsContainer http2_client_streams_;
-  HTTP2StreamsContainer http2_server_streams_;
+  // Returns the protocol data, or an empty one if it was never allocated.
+  const ProtocolData& protocol_data() const;
 
   // Access the appropriate HalfStream object for the given stream ID.
   protocols::http2::HalfStream* HalfStreamPtr(uint32_t stream_id, bool write_event);
 
-  // The timestamp of the last activity on this connection.
-  // Recorded as the latest timestamp on a BPF event.
-  uint64_t last_bpf_timestamp_ns_ = 0;
+  // HTTP2 traffic that is not traced by the uprobes is captured as raw frames by the kprobes, and
+  // decoded into the streams above. The decoders are created with the first frames, one per
+  // direction. If any uprobe event is received, the raw frames are ignored.
+  std::unique_ptr<protocols::http2::FrameDecoder> http2_send_decoder_;
+  std::unique_ptr<protocols::http2::FrameDecoder> http2_recv_decoder_;
+  bool http2_uprobe_events_ = false;
 
-  std::chrono::time_point<std::chrono::steady_clock> current_time_;
-
-  // The timestamp of the last update on this connection which alters the states.
-  // Recorded as the latest activity time on the ConnTracker.
-  // Currently using steady clock, so cannot be used meaningfully for logging real times.
-  std::chrono::time_point<std::chrono::steady_clock> last_activity_timestamp_;
+  protocols::http2::FrameDecoder* HTTP2FrameDecoder(bool write_event);
+  void DecodeHTTP2Frames(bool write_event);
 
   // Filter for less spammy trace logs.
   bool suppress_fd_link_log_ = false;
@@ -656,8 +748,6 @@ class ConnTracker : NotCopyMoveable {
   int idle_iteration_count_ = 0;
   int idle_iteration_threshold_ = 2;
 
-  State state_ = State::kCollecting;
-
   std::string disable_reason_;
 
   // Iterations before the tracker can be killed.
@@ -665,28 +755,18 @@ class ConnTracker : NotCopyMoveable {
 
   utils::StatCounter<StatKey> stats_;
 
-  // Connection trackers need to keep a state because there can be information between
-  // needed from previous requests/responses needed to parse or render current request.
-  // E.g. MySQL keeps a map of previously occurred stmt prepare events as the state such
-  // that future stmt execute events can match up with the correct one using stmt_id.
-  //
-  // TODO(oazizi): Is there a better structure than std::any?
-  // One alternative is an std::variant, but that becomes tedious to maintain with a
-  // growing number of protocols.
-  // Two considerations:
-  // 1) We want something with an interface-type API. The current structure does achieve
-  //    this, but not in a clear way. The compilation errors will be due to SFINAE and
-  //    hard to interpret.
-  // 2) We want something with some type safety. std::any does provide this, in the
-  //    similar way as std::variant.
-  std::any protocol_state_;
-
   template <typename TProtocolTraits>
   friend std::string DebugString(const ConnTracker& c, std::string_view prefix);
 
   // A pointer to the conn trackers manager, used for notifying a protocol change.
   ConnTrackersManager* manager_ = nullptr;
 
+  // Bookkeeping of the manager. Parked trackers are skipped by the iterations, see
+  // ConnTrackersManager::ParkIdleTrackers().
+  std::list<ConnTracker*>::iterator active_iter_;
+  bool parked_ = false;
+  uint64_t parked_iteration_ = 0;
+
   friend class ConnTrackersManager;
   friend class ConnTrackersManagerTest;
   friend class ConnTrackerGenerationsTest;
@@ -711,8 +791,8 @@ std::string DebugString(const ConnTracker& c, std::string_view prefix) {
   info += absl::Substitute("$0recv queue\n", prefix);
   info += absl::Substitute("$0send queue\n", prefix);
   if constexpr (std::is_same_v<TFrameType, protocols::http2::Stream>) {
-    info += c.http2_client_streams_.DebugString(absl::StrCat(prefix, "  "));
-    info += c.http2_server_streams_.DebugString(absl::StrCat(prefix, "  "));
+    info += c.protocol_data().http2_client_streams.DebugString(absl::StrCat(prefix, "  "));
+    info += c.protocol_data().http2_server_streams.DebugString(absl::StrCat(prefix, "  "));
   } else {
     info += DebugString<TFrameType>(c.recv_data(), absl::StrCat(prefix, "  "));
     info += DebugString<TFrameType>(c.send_data(), absl::StrCat(prefix, "  "));
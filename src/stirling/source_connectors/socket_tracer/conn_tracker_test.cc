@@ -358,6 +358,21 @@ TEST_F(ConnTrackerTest, DataEventsChangesCounter) {
   EXPECT_EQ(kHTTPResp0.size(), tracker.GetStat(ConnTracker::StatKey::kBytesSent));
 }
 
+// Tests that the streams are only allocated once there is traffic of the tracker's protocol.
+TEST_F(ConnTrackerTest, ProtocolDataAllocatedWithTraffic) {
+  ConnTracker tracker;
+  EXPECT_EQ(tracker.MemUsage(), sizeof(ConnTracker));
+
+  // Unclassified traffic is not collected.
+  auto event0 = event_gen_.InitRecvEvent<kProtocolUnknown>(kHTTPReq0);
+  tracker.AddDataEvent(std::move(event0));
+  EXPECT_EQ(tracker.MemUsage(), sizeof(ConnTracker));
+
+  auto event1 = event_gen_.InitSendEvent<kProtocolHTTP>(kHTTPResp0);
+  tracker.AddDataEvent(std::move(event1));
+  EXPECT_GE(tracker.MemUsage(), sizeof(ConnTracker) + kHTTPResp0.size());
+}
+
 TEST_F(ConnTrackerTest, HTTPStuckEventsAreRemoved) {
   // Use incomplete data to make it stuck.
   testing::EventGenerator event_gen(&real_clock_);
@@ -434,7 +449,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForIntraClusterRemoteEndpoint) {
   tracker.AddControlEvent(conn);
   tracker.SetProtocol(kProtocolHTTP, "testing");
   tracker.SetRole(kRoleClient, "testing");
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -453,7 +468,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForLocalhostRemoteEndpoint) {
   tracker.AddControlEvent(conn);
   tracker.SetProtocol(kProtocolHTTP, "testing");
   tracker.SetRole(kRoleClient, "testing");
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -467,7 +482,7 @@ TEST_F(ConnTrackerTest, TrackerCollectingForClientSideTracingWithNoCIDR) {
   tracker.AddControlEvent(conn);
   tracker.SetProtocol(kProtocolHTTP, "testing");
   tracker.SetRole(kRoleClient, "testing");
-  tracker.IterationPreTick(now_, /*cluster_cidrs*/ {}, /*proc_parser*/ nullptr,
+  tracker.IterationPreTick(now_, /*cluster_cidrs*/ {}, /*fd_link_cache*/ nullptr,
                            /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kCollecting, tracker.state());
 }
@@ -484,7 +499,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForUnixDomainSocket) {
 
   ConnTracker tracker;
   tracker.AddControlEvent(conn);
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -501,7 +516,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForOtherSockAddrFamily) {
 
   ConnTracker tracker;
   tracker.AddControlEvent(conn);
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -519,7 +534,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledAfterMapping) {
     tracker.AddControlEvent(conn);
     tracker.SetProtocol(kProtocolHTTP, "testing");
     tracker.SetRole(kRoleClient, "testing");
-    tracker.IterationPreTick(now_, {cidr}, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+    tracker.IterationPreTick(now_, {cidr}, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
     EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state())
         << "Got: " << magic_enum::enum_name(tracker.state());
   }
@@ -535,7 +550,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledAfterMapping) {
     tracker.AddControlEvent(conn);
     tracker.SetProtocol(kProtocolHTTP, "testing");
     tracker.SetRole(kRoleClient, "testing");
-    tracker.IterationPreTick(now_, {cidr}, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+    tracker.IterationPreTick(now_, {cidr}, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
     EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state())
         << "Got: " << magic_enum::enum_name(tracker.state());
   }
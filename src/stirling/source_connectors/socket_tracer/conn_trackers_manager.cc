@@ -21,6 +21,9 @@
 DEFINE_double(
     stirling_conn_tracker_cleanup_threshold, 0.2,
     "Percentage of trackers that are ready for destruction that will trigger a memory cleanup");
+DEFINE_bool(stirling_conn_tracker_park_idle, false,
+            "If true, idle connection trackers are skipped by the iterations until they receive "
+            "new events, or until they are due for their inactivity checks.");
 
 namespace px {
 namespace stirling {
@@ -107,6 +110,13 @@ namespace {
 
 constexpr size_t kMaxConnTrackerPoolSize = 2048;
 
+// Parked trackers are woken up at most this late; the iterations are coarser anyways.
+constexpr auto kParkTimerTick = std::chrono::milliseconds(100);
+
+uint64_t ToNanos(std::chrono::time_point<std::chrono::steady_clock> time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
 uint64_t GetConnMapKey(uint32_t pid, int32_t fd) { return (static_cast<uint64_t>(pid) << 32) | fd; }
 
 std::optional<ConnTrackersManager::StatKey> GetStatKeyForProtocol(TrafficProtocol protocol) {
@@ -131,9 +141,32 @@ std::optional<ConnTrackersManager::StatKey> GetStatKeyForProtocol(TrafficProtoco
   return std::nullopt;
 }
 
+std::optional<ConnTrackersManager::StatKey> GetMemStatKeyForProtocol(TrafficProtocol protocol) {
+#define CASE(protocol) \
+  case kProtocol##protocol: \
+    return ConnTrackersManager::StatKey::kMemProtocol##protocol;
+  switch (protocol) {
+    CASE(Unknown)
+    CASE(HTTP)
+    CASE(HTTP2)
+    CASE(MySQL)
+    CASE(CQL)
+    CASE(PGSQL)
+    CASE(DNS)
+    CASE(Redis)
+    CASE(Mongo)
+    CASE(Kafka)
+    case kNumProtocols:
+      return std::nullopt;
+  }
+#undef CASE
+  return std::nullopt;
+}
+
 }  // namespace
 
-ConnTrackersManager::ConnTrackersManager() : trackers_pool_(kMaxConnTrackerPoolSize) {}
+ConnTrackersManager::ConnTrackersManager()
+    : park_timers_(kParkTimerTick), trackers_pool_(kMaxConnTrackerPoolSize) {}
 
 ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_id) {
   const uint64_t conn_map_key = GetConnMapKey(conn_id.upid.pid, conn_id.fd);
@@ -143,12 +176,21 @@ ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_i
   auto [conn_tracker_ptr, created] = conn_trackers.GetOrCreate(conn_id.tsid, &trackers_pool_);
 
   if (created) {
-    active_trackers_.push_back(conn_tracker_ptr);
+    conn_tracker_ptr->active_iter_ = active_trackers_.insert(active_trackers_.end(),
+                                                             conn_tracker_ptr);
+    hot_trackers_.push_back(conn_tracker_ptr);
     conn_tracker_ptr->manager_ = this;
     conn_tracker_ptr->SetConnID(conn_id);
 
     stats_.Increment(StatKey::kTotal);
     stats_.Increment(StatKey::kCreated);
+
+    // A new generation marks the previous one for death, which has to count down.
+    for (const auto& [tsid, tracker] : conn_trackers.generations()) {
+      Wake(tracker.get());
+    }
+  } else {
+    Wake(conn_tracker_ptr);
   }
 
   DebugChecks();
@@ -175,19 +217,76 @@ StatusOr<const ConnTracker*> ConnTrackersManager::GetConnTracker(uint32_t pid, i
   return tracker_generations.GetActive();
 }
 
+ConnTracker* ConnTrackersManager::FindTracker(uint64_t conn_map_key, uint64_t tsid) const {
+  auto iter = conn_id_tracker_generations_.find(conn_map_key);
+  if (iter == conn_id_tracker_generations_.end()) {
+    return nullptr;
+  }
+  const auto& generations = iter->second.generations();
+  auto gen_iter = generations.find(tsid);
+  return gen_iter == generations.end() ? nullptr : gen_iter->second.get();
+}
+
+void ConnTrackersManager::Wake(ConnTracker* tracker) {
+  if (!tracker->parked_) {
+    return;
+  }
+  tracker->parked_ = false;
+  // The iterations that skipped the tracker were idle iterations.
+  tracker->idle_iteration_count_ += static_cast<int>(iteration_ - tracker->parked_iteration_);
+  hot_trackers_.push_back(tracker);
+}
+
+void ConnTrackersManager::BeginIteration(
+    std::chrono::time_point<std::chrono::steady_clock> iteration_time) {
+  std::vector<ParkTimer> due_timers;
+  park_timers_.Advance(ToNanos(iteration_time), &due_timers);
+  for (const ParkTimer& timer : due_timers) {
+    ConnTracker* tracker = FindTracker(timer.conn_map_key, timer.tsid);
+    if (tracker != nullptr && tracker->parked_ &&
+        tracker->parked_iteration_ == timer.parked_iteration) {
+      Wake(tracker);
+    }
+  }
+  ++iteration_;
+}
+
+void ConnTrackersManager::ParkIdleTrackers(std::chrono::nanoseconds iteration_period) {
+  if (!FLAGS_stirling_conn_tracker_park_idle) {
+    return;
+  }
+
+  size_t num_hot = 0;
+  for (ConnTracker* tracker : hot_trackers_) {
+    auto idle_until = tracker->IdleUntil(iteration_period);
+    if (!idle_until.has_value()) {
+      hot_trackers_[num_hot++] = tracker;
+      continue;
+    }
+    tracker->parked_ = true;
+    tracker->parked_iteration_ = iteration_;
+    const struct conn_id_t& conn_id = tracker->conn_id();
+    park_timers_.Schedule({GetConnMapKey(conn_id.upid.pid, conn_id.fd), conn_id.tsid, iteration_},
+                          ToNanos(idle_until.value()));
+  }
+  hot_trackers_.resize(num_hot);
+
+  DebugChecks();
+}
+
 void ConnTrackersManager::CleanupTrackers() {
-  {
-    auto iter = active_trackers_.begin();
-    while (iter != active_trackers_.end()) {
-      const auto& tracker = *iter;
-      if (tracker->ReadyForDestruction()) {
-        active_trackers_.erase(iter++);
-        stats_.Increment(StatKey::kReadyForDestruction);
-      } else {
-        ++iter;
-      }
+  size_t num_hot = 0;
+  for (ConnTracker* tracker : hot_trackers_) {
+    if (tracker->ReadyForDestruction()) {
+      active_trackers_.erase(tracker->active_iter_);
+      const struct conn_id_t& conn_id = tracker->conn_id();
+      keys_pending_destruction_.insert(GetConnMapKey(conn_id.upid.pid, conn_id.fd));
+      stats_.Increment(StatKey::kReadyForDestruction);
+    } else {
+      hot_trackers_[num_hot++] = tracker;
     }
   }
+  hot_trackers_.resize(num_hot);
 
   // As a performance optimization, we only clean up trackers once we reach a certain threshold
   // of trackers that are ready for destruction.
@@ -195,10 +294,13 @@ void ConnTrackersManager::CleanupTrackers() {
   double percent_destroyable =
       1.0 * stats_.Get(StatKey::kReadyForDestruction) / stats_.Get(StatKey::kTotal);
   if (percent_destroyable > FLAGS_stirling_conn_tracker_cleanup_threshold) {
-    // Outer loop iterates through tracker sets (keyed by PID+FD),
-    // while inner loop iterates through generations of trackers for that PID+FD pair.
-    auto iter = conn_id_tracker_generations_.begin();
-    while (iter != conn_id_tracker_generations_.end()) {
+    // Only visit the tracker sets (keyed by PID+FD) that have trackers to destroy,
+    // and iterate through the generations of trackers for that PID+FD pair.
+    for (uint64_t conn_map_key : keys_pending_destruction_) {
+      auto iter = conn_id_tracker_generations_.find(conn_map_key);
+      if (iter == conn_id_tracker_generations_.end()) {
+        continue;
+      }
       auto& tracker_generations = iter->second;
 
       int num_erased = tracker_generations.CleanupGenerations(&trackers_pool_);
@@ -208,12 +310,11 @@ void ConnTrackersManager::CleanupTrackers() {
       stats_.Increment(StatKey::kDestroyed, num_erased);
 
       if (tracker_generations.empty()) {
-        conn_id_tracker_generations_.erase(iter++);
+        conn_id_tracker_generations_.erase(iter);
         stats_.Increment(StatKey::kDestroyedGens);
-      } else {
-        ++iter;
       }
     }
+    keys_pending_destruction_.clear();
   }
 
   DebugChecks();
@@ -222,6 +323,7 @@ void ConnTrackersManager::CleanupTrackers() {
 void ConnTrackersManager::DebugChecks() const {
   DCHECK_EQ(stats_.Get(StatKey::kTotal),
             active_trackers_.size() + stats_.Get(StatKey::kReadyForDestruction));
+  DCHECK_LE(hot_trackers_.size(), active_trackers_.size());
 }
 
 std::string ConnTrackersManager::DebugInfo() const {
@@ -243,21 +345,30 @@ std::string ConnTrackersManager::StatsString() const { return stats_.Print(); }
 
 void ConnTrackersManager::ComputeProtocolStats() {
   absl::flat_hash_map<TrafficProtocol, int> protocol_count;
+  absl::flat_hash_map<TrafficProtocol, size_t> protocol_mem_usage;
   for (const auto* tracker : active_trackers_) {
     ++protocol_count[tracker->protocol()];
+    protocol_mem_usage[tracker->protocol()] += tracker->MemUsage();
   }
   for (auto protocol : magic_enum::enum_values<TrafficProtocol>()) {
     auto protocol_stat_key_opt = GetStatKeyForProtocol(protocol);
-    if (!protocol_stat_key_opt.has_value()) {
+    auto mem_stat_key_opt = GetMemStatKeyForProtocol(protocol);
+    if (!protocol_stat_key_opt.has_value() || !mem_stat_key_opt.has_value()) {
       continue;
     }
     auto protocol_stat_key = protocol_stat_key_opt.value();
+    auto mem_stat_key = mem_stat_key_opt.value();
     stats_.Reset(protocol_stat_key);
+    stats_.Reset(mem_stat_key);
 
     auto iter = protocol_count.find(protocol);
     if (iter != protocol_count.end()) {
       stats_.Increment(protocol_stat_key, iter->second);
     }
+    auto mem_iter = protocol_mem_usage.find(protocol);
+    if (mem_iter != protocol_mem_usage.end()) {
+      stats_.Increment(mem_stat_key, mem_iter->second);
+    }
   }
 }
 
@@ -26,11 +26,15 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
 #include "src/stirling/utils/obj_pool.h"
 #include "src/stirling/utils/stat_counter.h"
+#include "src/stirling/utils/timer_wheel.h"
 
 DECLARE_double(stirling_conn_tracker_cleanup_threshold);
+DECLARE_bool(stirling_conn_tracker_park_idle);
 
 namespace px {
 namespace stirling {
@@ -106,6 +110,18 @@ class ConnTrackersManager {
     kProtocolRedis,
     kProtocolMongo,
     kProtocolKafka,
+
+    // Approximate bytes held by the trackers of each protocol. See ConnTracker::MemUsage().
+    kMemProtocolUnknown,
+    kMemProtocolHTTP,
+    kMemProtocolHTTP2,
+    kMemProtocolMySQL,
+    kMemProtocolCQL,
+    kMemProtocolPGSQL,
+    kMemProtocolDNS,
+    kMemProtocolRedis,
+    kMemProtocolMongo,
+    kMemProtocolKafka,
   };
 
   ConnTrackersManager();
@@ -118,6 +134,26 @@ class ConnTrackersManager {
 
   const std::list<ConnTracker*>& active_trackers() const { return active_trackers_; }
 
+  /**
+   * Starts an iteration at the given time: wakes up the parked trackers whose timers are due.
+   */
+  void BeginIteration(std::chrono::time_point<std::chrono::steady_clock> iteration_time);
+
+  /**
+   * Returns the trackers that the iteration should visit: the active trackers that are not
+   * parked. Must not be held across calls that create or wake trackers.
+   */
+  const std::vector<ConnTracker*>& hot_trackers() const { return hot_trackers_; }
+
+  /**
+   * Parks the visited trackers that are idle (see ConnTracker::IdleUntil()), so the following
+   * iterations skip them until they receive an event, or until their timer is due.
+   * Only does anything if --stirling_conn_tracker_park_idle is set.
+   *
+   * @param iteration_period The expected time between iterations.
+   */
+  void ParkIdleTrackers(std::chrono::nanoseconds iteration_period);
+
   /**
    * Returns the latest generation of a connection tracker for the given pid and fd.
    * If there is no tracker for {pid, fd}, returns error::NotFound.
@@ -126,8 +162,9 @@ class ConnTrackersManager {
 
   /**
    * Deletes trackers that are ReadyForDestruction().
-   * Call this only after accumulating enough trackers to clean-up, to avoid the performance
-   * impact of scanning through all trackers every iteration.
+   * Only the hot trackers are checked, since parked trackers are never ReadyForDestruction().
+   * The trackers are only destroyed once enough of them accumulate, see
+   * --stirling_conn_tracker_cleanup_threshold.
    */
   void CleanupTrackers();
 
@@ -137,7 +174,8 @@ class ConnTrackersManager {
   std::string DebugInfo() const;
 
   /**
-   * Computes the count of ConnTracker objects for each protocol and stores them into stats_.
+   * Computes the count of ConnTracker objects for each protocol, and the memory they hold,
+   * and stores them into stats_.
    */
   void ComputeProtocolStats();
 
@@ -146,10 +184,18 @@ class ConnTrackersManager {
    */
   std::string StatsString() const;
 
+  int64_t GetStat(StatKey key) const { return stats_.Get(key); }
+  const utils::StatCounter<StatKey>& stats() const { return stats_; }
+
  private:
   // Simple consistency DCHECKs meant for enforcing invariants.
   void DebugChecks() const;
 
+  ConnTracker* FindTracker(uint64_t conn_map_key, uint64_t tsid) const;
+
+  // Moves a parked tracker back to the hot trackers.
+  void Wake(ConnTracker* tracker);
+
   // A map from conn_id (PID+FD+TSID) to tracker. This is for easy update on BPF events.
   // Structured as two nested maps to be explicit about "generations" of trackers per PID+FD.
   // Key is {PID, FD} for outer map, and tsid for inner map.
@@ -157,6 +203,22 @@ class ConnTrackersManager {
 
   std::list<ConnTracker*> active_trackers_;
 
+  // The active trackers that are not parked. Without parking, these are all active trackers.
+  std::vector<ConnTracker*> hot_trackers_;
+
+  // Wakes up parked trackers for their inactivity handling. A timer belongs to the parking of
+  // the tracker in the given iteration, so timers of earlier parkings are ignored.
+  struct ParkTimer {
+    uint64_t conn_map_key;
+    uint64_t tsid;
+    uint64_t parked_iteration;
+  };
+  TimerWheel<ParkTimer> park_timers_;
+  uint64_t iteration_ = 0;
+
+  // {PID, FD} keys of the trackers that are ReadyForDestruction(), and not destroyed yet.
+  absl::flat_hash_set<uint64_t> keys_pending_destruction_;
+
   // A pool of unused trackers that can be recycled.
   // This is useful for avoiding memory reallocations.
   ConnTrackerPool trackers_pool_;
@@ -17,6 +17,7 @@
  */
 
 #include <random>
+#include <vector>
 
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
@@ -24,7 +25,9 @@
 namespace px {
 namespace stirling {
 
+using ::testing::ElementsAre;
 using ::testing::StrEq;
+using ::testing::UnorderedElementsAre;
 
 class ConnTrackersManagerTest : public ::testing::Test {
  protected:
@@ -48,6 +51,12 @@ class ConnTrackersManagerTest : public ::testing::Test {
     }
   }
 
+  static void SetLastActivity(ConnTracker* tracker,
+                              std::chrono::time_point<std::chrono::steady_clock> time) {
+    tracker->set_current_time(time);
+    tracker->last_activity_timestamp_ = time;
+  }
+
   void TrackerEvent(struct conn_id_t conn_id, TrafficProtocol protocol) {
     VLOG(1) << "TrackerEvent";
     ConnTracker& tracker = trackers_mgr_.GetOrCreateConnTracker(conn_id);
@@ -110,13 +119,91 @@ TEST_F(ConnTrackersManagerTest, DebugInfo) {
       StrEq("ConnTracker count statistics: kTotal=1 kReadyForDestruction=0 "
             "kCreated=1 kDestroyed=0 kDestroyedGens=0 "
             "kProtocolUnknown=0 kProtocolHTTP=0 kProtocolHTTP2=0 kProtocolMySQL=0 kProtocolCQL=0 "
-            "kProtocolPGSQL=0 kProtocolDNS=0 kProtocolRedis=0 kProtocolMongo=0 kProtocolKafka=0 \n"
+            "kProtocolPGSQL=0 kProtocolDNS=0 kProtocolRedis=0 kProtocolMongo=0 kProtocolKafka=0 "
+            "kMemProtocolUnknown=0 kMemProtocolHTTP=0 kMemProtocolHTTP2=0 kMemProtocolMySQL=0 "
+            "kMemProtocolCQL=0 kMemProtocolPGSQL=0 kMemProtocolDNS=0 kMemProtocolRedis=0 "
+            "kMemProtocolMongo=0 kMemProtocolKafka=0 \n"
             "Detailed statistics of individual ConnTracker:\n"
             "  conn_tracker=conn_id=[pid=1 start_time_ticks=1 fd=1 gen=1] state=kCollecting "
             "remote_addr=-:-1 role=kRoleUnknown protocol=kProtocolUnknown zombie=false "
             "ready_for_destruction=false\n"));
 }
 
+// Tests that ComputeProtocolStats() accounts the memory of the trackers to their protocol.
+TEST_F(ConnTrackersManagerTest, ProtocolMemStats) {
+  struct conn_id_t conn_id = {};
+  conn_id.upid.pid = 1;
+  conn_id.fd = 1;
+  conn_id.tsid = 1;
+  TrackerEvent(conn_id, kProtocolHTTP);
+  conn_id.fd = 2;
+  TrackerEvent(conn_id, kProtocolHTTP);
+  conn_id.fd = 3;
+  TrackerEvent(conn_id, kProtocolMySQL);
+
+  trackers_mgr_.ComputeProtocolStats();
+  using StatKey = ConnTrackersManager::StatKey;
+  const int64_t kTrackerSize = sizeof(ConnTracker);
+  EXPECT_EQ(trackers_mgr_.GetStat(StatKey::kProtocolHTTP), 2);
+  EXPECT_EQ(trackers_mgr_.GetStat(StatKey::kMemProtocolHTTP), 2 * kTrackerSize);
+  EXPECT_EQ(trackers_mgr_.GetStat(StatKey::kProtocolMySQL), 1);
+  EXPECT_EQ(trackers_mgr_.GetStat(StatKey::kMemProtocolMySQL), kTrackerSize);
+  EXPECT_EQ(trackers_mgr_.GetStat(StatKey::kMemProtocolCQL), 0);
+}
+
+// Tests that idle trackers are skipped until they receive an event, or until their timer is due.
+TEST_F(ConnTrackersManagerTest, ParkIdleTrackers) {
+  FLAGS_stirling_conn_tracker_park_idle = true;
+  FLAGS_stirling_check_proc_for_conn_close = false;
+  constexpr auto kIterationPeriod = std::chrono::milliseconds(200);
+  const auto now = std::chrono::steady_clock::now();
+
+  struct conn_id_t conn_id = {};
+  conn_id.upid.pid = 1;
+  conn_id.tsid = 1;
+  std::vector<ConnTracker*> trackers;
+  for (int fd = 1; fd <= 3; ++fd) {
+    conn_id.fd = fd;
+    ConnTracker* tracker = &trackers_mgr_.GetOrCreateConnTracker(conn_id);
+    SetLastActivity(tracker, now);
+    trackers.push_back(tracker);
+  }
+  // Disabled trackers don't do anything until they're closed. The last tracker still waits
+  // for its connection info.
+  trackers[0]->Disable("for testing");
+  trackers[1]->Disable("for testing");
+
+  trackers_mgr_.BeginIteration(now);
+  trackers_mgr_.ParkIdleTrackers(kIterationPeriod);
+  EXPECT_THAT(trackers_mgr_.hot_trackers(), ElementsAre(trackers[2]));
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 3);
+
+  trackers_mgr_.BeginIteration(now + std::chrono::seconds(1));
+  EXPECT_THAT(trackers_mgr_.hot_trackers(), ElementsAre(trackers[2]));
+
+  // An event wakes up the tracker.
+  conn_id.fd = 1;
+  trackers_mgr_.GetOrCreateConnTracker(conn_id);
+  EXPECT_THAT(trackers_mgr_.hot_trackers(), UnorderedElementsAre(trackers[0], trackers[2]));
+  trackers_mgr_.ParkIdleTrackers(kIterationPeriod);
+  EXPECT_THAT(trackers_mgr_.hot_trackers(), ElementsAre(trackers[2]));
+
+  // The timers wake up the trackers for their inactivity checks.
+  trackers_mgr_.BeginIteration(now + ConnTracker::InactivityDuration() + std::chrono::seconds(1));
+  EXPECT_THAT(trackers_mgr_.hot_trackers(),
+              UnorderedElementsAre(trackers[0], trackers[1], trackers[2]));
+
+  // Trackers ready for destruction are cleaned up from the hot trackers.
+  trackers[2]->MarkForDeath(0);
+  trackers[2]->MarkFinalConnStatsReported();
+  CleanupTrackers();
+  EXPECT_THAT(trackers_mgr_.hot_trackers(), UnorderedElementsAre(trackers[0], trackers[1]));
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 2);
+  EXPECT_EQ(trackers_mgr_.GetStat(ConnTrackersManager::StatKey::kDestroyed), 1);
+
+  FLAGS_stirling_conn_tracker_park_idle = false;
+}
+
 class ConnTrackerGenerationsTest : public ::testing::Test {
  protected:
   ConnTrackerGenerationsTest() : tracker_pool(1024) {
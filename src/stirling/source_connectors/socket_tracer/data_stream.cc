@@ -20,6 +20,7 @@
 
 #include <utility>
 
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/parse.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/types.h"
 // TODO(yzhao): Without this line :stirling_wrapper fails to link redis template specializations
 // of FindFrameBoundary() and ParseFrames().
@@ -31,6 +32,11 @@ namespace px {
 namespace stirling {
 
 void DataStream::AddData(std::unique_ptr<SocketDataEvent> event) {
+  // Metadata-only events have no data to add; the data after them starts after a gap.
+  if (event->msg.empty()) {
+    return;
+  }
+
   // Note that the BPF code will also generate a missing sequence number when truncation occurs,
   // so the data stream will naturally reset after processing this event.
   LOG_IF(ERROR, event->attr.msg_size > event->msg.size() && !event->msg.empty())
@@ -68,6 +74,17 @@ bool IsSyncRequired(int64_t stuck_count) {
   return true;
 }
 
+// Decoding HTTP/2 headers depends on all the previous frames (see http2::HPACKDecoder), so the
+// decoder needs to know where data was lost. Other protocols are parsed frame by frame.
+template <typename TFrameType>
+void MarkDataLoss(std::deque<TFrameType>* frames) {
+  if constexpr (std::is_same_v<TFrameType, protocols::http2::Frame>) {
+    protocols::http2::Frame frame;
+    frame.data_loss = true;
+    frames->push_back(std::move(frame));
+  }
+}
+
 }  // namespace
 
 // ProcessBytesToFrames() processes the raw data in the DataStream to extract parsed frames.
@@ -124,6 +141,11 @@ void DataStream::ProcessBytesToFrames(MessageType type) {
   while (keep_processing && !data_buffer_.empty()) {
     size_t contiguous_bytes = data_buffer_.Head().size();
 
+    // A resync skips the data up to the next frame boundary.
+    if (IsSyncRequired(stuck_count_)) {
+      MarkDataLoss(&typed_messages);
+    }
+
     // Now parse the raw data.
     parse_result =
         protocols::ParseFrames(type, data_buffer_, &typed_messages, IsSyncRequired(stuck_count_));
@@ -134,6 +156,7 @@ void DataStream::ProcessBytesToFrames(MessageType type) {
       // Drop all events up to this point, and then try to resume.
       data_buffer_.RemovePrefix(contiguous_bytes);
       data_buffer_.Trim();
+      MarkDataLoss(&typed_messages);
 
       // Update stuck count so we use the correct sync type on the next iteration.
       stuck_count_ = 0;
@@ -176,6 +199,7 @@ void DataStream::ProcessBytesToFrames(MessageType type) {
     // TODO(oazizi): A dedicated data_buffer_.Flush() implementation would be more efficient.
     data_buffer_.RemovePrefix(data_buffer_.size());
     stuck_count_ = 0;
+    MarkDataLoss(&typed_messages);
   }
 
   last_parse_state_ = parse_result.state;
@@ -191,6 +215,8 @@ template void DataStream::ProcessBytesToFrames<protocols::cass::Frame>(MessageTy
 template void DataStream::ProcessBytesToFrames<protocols::pgsql::RegularMessage>(MessageType type);
 template void DataStream::ProcessBytesToFrames<protocols::dns::Frame>(MessageType type);
 template void DataStream::ProcessBytesToFrames<protocols::redis::Message>(MessageType type);
+template void DataStream::ProcessBytesToFrames<protocols::http2::Frame>(MessageType type);
+template void DataStream::ProcessBytesToFrames<protocols::kafka::Packet>(MessageType type);
 
 void DataStream::Reset() {
   data_buffer_.Reset();
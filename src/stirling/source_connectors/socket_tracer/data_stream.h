@@ -23,6 +23,8 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <variant>
 
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
@@ -122,6 +124,24 @@ class DataStream : NotCopyMoveable {
                                     std::get<std::deque<TFrameType>>(frames_).empty());
   }
 
+  /**
+   * Checks if the DataStream holds any raw events or parsed frames, of whatever frame type.
+   */
+  bool HasData() const {
+    if (!data_buffer_.empty()) {
+      return true;
+    }
+    return std::visit(
+        [](const auto& frames) {
+          if constexpr (std::is_same_v<std::decay_t<decltype(frames)>, std::monostate>) {
+            return false;
+          } else {
+            return !frames.empty();
+          }
+        },
+        frames_);
+  }
+
   /**
    * Checks if the DataStream is in a Stuck state, which means that it has
    * raw events with no missing events, but that it cannot parse anything.
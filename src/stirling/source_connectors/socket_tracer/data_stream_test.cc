@@ -82,6 +82,25 @@ TEST_F(DataStreamTest, LostEvent) {
   EXPECT_FALSE(stream.IsStuck());
 }
 
+TEST_F(DataStreamTest, MetadataOnlyEvent) {
+  testing::EventGenerator event_gen(&real_clock_);
+  std::unique_ptr<SocketDataEvent> req0 = event_gen.InitSendEvent<kProtocolHTTP>(kHTTPReq0);
+  std::unique_ptr<SocketDataEvent> req1 = event_gen.InitSendEvent<kProtocolHTTP>(kHTTPReq0);
+  std::unique_ptr<SocketDataEvent> req2 = event_gen.InitSendEvent<kProtocolHTTP>(kHTTPReq0);
+
+  // BPF sent only the size of req1.
+  req1->msg.clear();
+  req1->attr.msg_buf_size = 0;
+
+  DataStream stream;
+  stream.AddData(std::move(req0));
+  stream.AddData(std::move(req1));
+  stream.AddData(std::move(req2));
+  stream.ProcessBytesToFrames<http::Message>(MessageType::kRequest);
+  EXPECT_THAT(stream.Frames<http::Message>(), SizeIs(2));
+  EXPECT_FALSE(stream.IsStuck());
+}
+
 TEST_F(DataStreamTest, StuckTemporarily) {
   testing::EventGenerator event_gen(&real_clock_);
 
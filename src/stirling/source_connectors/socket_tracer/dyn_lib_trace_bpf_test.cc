@@ -112,7 +112,6 @@ Commercial support is available at
 
 TEST_F(DynLibTraceTest, TraceDynLoadedOpenSSL) {
   FLAGS_stirling_rescan_for_dlopen = true;
-  FLAGS_stirling_rescan_exp_backoff_factor = 1.0;
 
   // Note that stirling is deployed before starting this test.
 
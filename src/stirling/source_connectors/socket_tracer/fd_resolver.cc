@@ -20,15 +20,74 @@
 
 #include <chrono>
 
+#include <absl/strings/match.h>
+
 #include "src/common/base/base.h"
 #include "src/common/fs/inode_utils.h"
 
 namespace px {
 namespace stirling {
 
+Status FDLinkCache::ReadFDLink(int pid, int fd, std::string* out) {
+  FDTable& table = tables_[pid];
+  table.used = true;
+
+  auto iter = table.socket_links.find(fd);
+  if (iter != table.socket_links.end()) {
+    *out = iter->second;
+    return Status::OK();
+  }
+
+  if (!table.table_read && ++table.num_misses > kTableReadThreshold) {
+    // The table is read once. Sockets opened later are added as they are looked up.
+    table.table_read = true;
+    PL_RETURN_IF_ERROR(
+        proc_parser_->ReadProcPIDFDLinks(pid, fs::kSocketInodePrefix, &table.socket_links));
+    iter = table.socket_links.find(fd);
+    if (iter != table.socket_links.end()) {
+      *out = iter->second;
+      return Status::OK();
+    }
+  }
+
+  PL_RETURN_IF_ERROR(proc_parser_->ReadProcPIDFDLink(pid, fd, out));
+  if (absl::StartsWith(*out, fs::kSocketInodePrefix)) {
+    table.socket_links[fd] = *out;
+  }
+  return Status::OK();
+}
+
+void FDLinkCache::Invalidate(int pid, int fd) {
+  auto iter = tables_.find(pid);
+  if (iter != tables_.end()) {
+    iter->second.socket_links.erase(fd);
+  }
+}
+
+void FDLinkCache::EvictUnused() {
+  for (auto iter = tables_.begin(); iter != tables_.end();) {
+    if (!iter->second.used) {
+      tables_.erase(iter++);
+    } else {
+      iter->second.used = false;
+      ++iter;
+    }
+  }
+}
+
 FDResolver::FDResolver(system::ProcParser* proc_parser, int pid, int fd)
     : proc_parser_(proc_parser), pid_(pid), fd_(fd) {}
 
+FDResolver::FDResolver(FDLinkCache* fd_link_cache, int pid, int fd)
+    : fd_link_cache_(fd_link_cache), pid_(pid), fd_(fd) {}
+
+Status FDResolver::ReadFDLink(std::string* out) {
+  if (fd_link_cache_ != nullptr) {
+    return fd_link_cache_->ReadFDLink(pid_, fd_, out);
+  }
+  return proc_parser_->ReadProcPIDFDLink(pid_, fd_, out);
+}
+
 bool FDResolver::Setup() {
   // Record some information about the FD.
   // This marks the starting point at which we reliably know the connection.
@@ -36,7 +95,7 @@ bool FDResolver::Setup() {
   // the hope is that we can recover the socket information on the next iteration,
   // if the connection appears to be stable.
 
-  Status s = proc_parser_->ReadProcPIDFDLink(pid_, fd_, &fd_link_);
+  Status s = ReadFDLink(&fd_link_);
   if (!s.ok()) {
     VLOG(2) << absl::Substitute("Can't set-up connection inference [msg=$0].", s.msg());
     active_ = false;
@@ -62,7 +121,7 @@ bool FDResolver::Update() {
   std::chrono::time_point<std::chrono::steady_clock> timestamp = std::chrono::steady_clock::now();
 
   std::string current_fd_link;
-  Status s = proc_parser_->ReadProcPIDFDLink(pid_, fd_, &current_fd_link);
+  Status s = ReadFDLink(&current_fd_link);
   if (!s.ok()) {
     VLOG(2) << "Can't infer remote endpoint. FD is not accessible.";
     active_ = false;
@@ -24,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/system/proc_parser.h"
 #include "src/common/system/socket_info.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
@@ -31,6 +33,56 @@
 namespace px {
 namespace stirling {
 
+/**
+ * FDLinkCache caches the socket links of /proc/<pid>/fd, so resolving the FDs of the many
+ * connections of a process (e.g. a proxy) doesn't read /proc once per connection and sample.
+ *
+ * A PID's FDs are read one by one at first. Once enough distinct FDs of the PID were looked up,
+ * its socket links are read in a single pass over /proc/<pid>/fd. Cached links stay valid until
+ * an open or close event of the FD (socket_control_events) invalidates them. Non-socket links
+ * are never cached.
+ */
+class FDLinkCache {
+ public:
+  // The number of lookups that miss the cache of a PID before its whole table is read.
+  static constexpr int kTableReadThreshold = 32;
+
+  explicit FDLinkCache(system::ProcParser* proc_parser) : proc_parser_(proc_parser) {}
+
+  /**
+   * Returns the link of /proc/<pid>/fd/<fd>, from the cache if possible.
+   */
+  Status ReadFDLink(int pid, int fd, std::string* out);
+
+  /**
+   * Drops the cached link of the FD, which was opened or closed.
+   */
+  void Invalidate(int pid, int fd);
+
+  /**
+   * Drops all the cached links, for when control events were lost.
+   */
+  void Clear() { tables_.clear(); }
+
+  /**
+   * Drops the tables of the PIDs that were not looked up since the previous call.
+   */
+  void EvictUnused();
+
+  size_t num_pids() const { return tables_.size(); }
+
+ private:
+  struct FDTable {
+    absl::flat_hash_map<int, std::string> socket_links;
+    int num_misses = 0;
+    bool table_read = false;
+    bool used = true;
+  };
+
+  system::ProcParser* proc_parser_;
+  absl::flat_hash_map<int, FDTable> tables_;
+};
+
 /**
  * SocketResolver tries to determine the socket inode number of a given a PID and FD.
  *
@@ -52,6 +104,12 @@ class FDResolver {
    */
   FDResolver(system::ProcParser* proc_parser, int pid, int fd);
 
+  /**
+   * Creates a SocketResolver for the PID and FD, which reads the FD info through the cache.
+   * Samples of the FD are then only as fresh as the events that invalidate the cache.
+   */
+  FDResolver(FDLinkCache* fd_link_cache, int pid, int fd);
+
   /**
    * Collects the first sample from Linux, to begin the tracking process.
    */
@@ -86,7 +144,10 @@ class FDResolver {
   }
 
  private:
-  system::ProcParser* proc_parser_;
+  Status ReadFDLink(std::string* out);
+
+  system::ProcParser* proc_parser_ = nullptr;
+  FDLinkCache* fd_link_cache_ = nullptr;
   int pid_;
   int fd_;
 
@@ -20,9 +20,13 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "src/common/base/types.h"
 #include "src/common/system/tcp_socket.h"
+#include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/fd_resolver.h"
 
 namespace px {
@@ -187,5 +191,54 @@ TEST_F(FDResolverTest, NewSocketSameFD) {
   EXPECT_FALSE(fd_link.has_value());
 }
 
+TEST_F(FDResolverTest, FDLinkCache) {
+  FDLinkCache cache(proc_parser_.get());
+  system::TCPSocket socket;
+  int pid = getpid();
+  int fd = socket.sockfd();
+
+  std::string link;
+  ASSERT_OK(cache.ReadFDLink(pid, fd, &link));
+  EXPECT_TRUE(absl::StartsWith(link, "socket:["));
+
+  // The link stays cached until the FD is invalidated, so the close goes unnoticed.
+  socket.Close();
+  std::string cached_link;
+  ASSERT_OK(cache.ReadFDLink(pid, fd, &cached_link));
+  EXPECT_EQ(link, cached_link);
+
+  cache.Invalidate(pid, fd);
+  EXPECT_NOT_OK(cache.ReadFDLink(pid, fd, &cached_link));
+
+  // Non-socket links are not cached.
+  ASSERT_OK(cache.ReadFDLink(pid, STDOUT_FILENO, &link));
+
+  // The table is dropped once it goes unused for a whole iteration.
+  cache.EvictUnused();
+  EXPECT_EQ(1, cache.num_pids());
+  cache.EvictUnused();
+  EXPECT_EQ(0, cache.num_pids());
+}
+
+TEST_F(FDResolverTest, FDLinkCacheReadsTable) {
+  FDLinkCache cache(proc_parser_.get());
+  int pid = getpid();
+
+  std::vector<std::unique_ptr<system::TCPSocket>> sockets;
+  for (int i = 0; i < FDLinkCache::kTableReadThreshold + 2; ++i) {
+    sockets.push_back(std::make_unique<system::TCPSocket>());
+  }
+
+  // Past the threshold, the whole table is read, so the last socket is already cached.
+  std::string link;
+  for (int i = 0; i <= FDLinkCache::kTableReadThreshold; ++i) {
+    ASSERT_OK(cache.ReadFDLink(pid, sockets[i]->sockfd(), &link));
+  }
+  int last_fd = sockets.back()->sockfd();
+  sockets.back()->Close();
+  ASSERT_OK(cache.ReadFDLink(pid, last_fd, &link));
+  EXPECT_TRUE(absl::StartsWith(link, "socket:["));
+}
+
 }  // namespace stirling
 }  // namespace px
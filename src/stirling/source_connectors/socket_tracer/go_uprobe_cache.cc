@@ -0,0 +1,185 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/go_uprobe_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/escaping.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
+#include "src/common/base/file.h"
+#include "src/common/fs/fs_wrapper.h"
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+// Bump the version whenever the layout of the symaddrs structs or the probe templates change, so
+// that files written by older versions are ignored. The struct sizes are checked too, as a
+// safety net.
+constexpr std::string_view kFormatVersion = "go_uprobe_cache_v1";
+
+std::string Header() {
+  return absl::Substitute("$0 $1 $2 $3", kFormatVersion, sizeof(struct go_common_symaddrs_t),
+                          sizeof(struct go_tls_symaddrs_t), sizeof(struct go_http2_symaddrs_t));
+}
+
+template <typename TStruct>
+std::string StructToHex(const TStruct& s) {
+  return absl::BytesToHexString(std::string_view(reinterpret_cast<const char*>(&s), sizeof(s)));
+}
+
+template <typename TStruct>
+StatusOr<TStruct> HexToStruct(std::string_view hex) {
+  if (hex.size() != 2 * sizeof(TStruct) ||
+      !std::all_of(hex.begin(), hex.end(), [](char c) { return absl::ascii_isxdigit(c); })) {
+    return error::InvalidArgument("Invalid symaddrs [size=$0].", hex.size());
+  }
+  std::string bytes = absl::HexStringToBytes(hex);
+  TStruct s;
+  memcpy(&s, bytes.data(), sizeof(s));
+  return s;
+}
+
+void AppendProbes(std::string_view tag, const std::vector<bpf_tools::UProbeSpec>& probes,
+                  std::string* out) {
+  for (const auto& probe : probes) {
+    // The symbol goes last, because Go symbols may contain spaces.
+    absl::StrAppend(out, absl::Substitute("$0 $1 $2 $3 $4\n", tag,
+                                          static_cast<int>(probe.attach_type), probe.address,
+                                          probe.probe_fn, probe.symbol));
+  }
+}
+
+StatusOr<bpf_tools::UProbeSpec> ParseProbe(const std::vector<std::string_view>& fields) {
+  int attach_type;
+  bpf_tools::UProbeSpec probe;
+  if (fields.size() != 5 || !absl::SimpleAtoi(fields[1], &attach_type) ||
+      !absl::SimpleAtoi(fields[2], &probe.address)) {
+    return error::InvalidArgument("Invalid probe.");
+  }
+  probe.attach_type = static_cast<bpf_tools::BPFProbeAttachType>(attach_type);
+  probe.probe_fn = std::string(fields[3]);
+  probe.symbol = std::string(fields[4]);
+  return probe;
+}
+
+}  // namespace
+
+std::string SerializeGoBinaryUProbeInfo(const GoBinaryUProbeInfo& info) {
+  std::string out = absl::StrCat(Header(), "\n");
+  if (info.common_symaddrs.has_value()) {
+    absl::StrAppend(&out, "common ", StructToHex(info.common_symaddrs.value()), "\n");
+  }
+  if (info.tls_symaddrs.has_value()) {
+    absl::StrAppend(&out, "tls ", StructToHex(info.tls_symaddrs.value()), "\n");
+  }
+  AppendProbes("tls_probe", info.tls_probes, &out);
+  if (info.http2_resolved) {
+    absl::StrAppend(&out, "http2_resolved\n");
+  }
+  if (info.http2_symaddrs.has_value()) {
+    absl::StrAppend(&out, "http2 ", StructToHex(info.http2_symaddrs.value()), "\n");
+  }
+  AppendProbes("http2_probe", info.http2_probes, &out);
+  return out;
+}
+
+StatusOr<GoBinaryUProbeInfo> ParseGoBinaryUProbeInfo(std::string_view str) {
+  std::vector<std::string_view> lines = absl::StrSplit(str, '\n', absl::SkipEmpty());
+  if (lines.empty() || lines[0] != Header()) {
+    return error::InvalidArgument("Unknown format version.");
+  }
+
+  GoBinaryUProbeInfo info;
+  for (size_t i = 1; i < lines.size(); ++i) {
+    std::vector<std::string_view> fields = absl::StrSplit(lines[i], absl::MaxSplits(' ', 4));
+    std::string_view tag = fields[0];
+    if (tag == "common" && fields.size() == 2) {
+      PL_ASSIGN_OR_RETURN(info.common_symaddrs, HexToStruct<go_common_symaddrs_t>(fields[1]));
+    } else if (tag == "tls" && fields.size() == 2) {
+      PL_ASSIGN_OR_RETURN(info.tls_symaddrs, HexToStruct<go_tls_symaddrs_t>(fields[1]));
+    } else if (tag == "tls_probe") {
+      PL_ASSIGN_OR_RETURN(bpf_tools::UProbeSpec probe, ParseProbe(fields));
+      info.tls_probes.push_back(std::move(probe));
+    } else if (tag == "http2_resolved") {
+      info.http2_resolved = true;
+    } else if (tag == "http2" && fields.size() == 2) {
+      PL_ASSIGN_OR_RETURN(info.http2_symaddrs, HexToStruct<go_http2_symaddrs_t>(fields[1]));
+    } else if (tag == "http2_probe") {
+      PL_ASSIGN_OR_RETURN(bpf_tools::UProbeSpec probe, ParseProbe(fields));
+      info.http2_probes.push_back(std::move(probe));
+    } else {
+      return error::InvalidArgument("Invalid line $0.", i);
+    }
+  }
+  return info;
+}
+
+std::filesystem::path GoUProbeCache::FilePath(const std::string& build_id) const {
+  // Go build IDs contain slashes.
+  std::string file_name = build_id;
+  std::replace(file_name.begin(), file_name.end(), '/', '_');
+  return dir_ / file_name;
+}
+
+const GoBinaryUProbeInfo* GoUProbeCache::Lookup(const std::string& build_id) {
+  auto iter = infos_.find(build_id);
+  if (iter != infos_.end()) {
+    return &iter->second;
+  }
+  if (dir_.empty()) {
+    return nullptr;
+  }
+
+  StatusOr<std::string> contents = ReadFileToString(FilePath(build_id));
+  if (!contents.ok()) {
+    return nullptr;
+  }
+  StatusOr<GoBinaryUProbeInfo> info = ParseGoBinaryUProbeInfo(contents.ValueOrDie());
+  if (!info.ok()) {
+    LOG(WARNING) << absl::Substitute("Ignoring uprobe cache file of build-id $0: $1", build_id,
+                                     info.msg());
+    return nullptr;
+  }
+  return &infos_.insert_or_assign(build_id, info.ConsumeValueOrDie()).first->second;
+}
+
+void GoUProbeCache::Insert(const std::string& build_id, GoBinaryUProbeInfo info) {
+  if (!dir_.empty()) {
+    // Write to a temporary file first, so that a concurrent reader never sees a partial file.
+    std::filesystem::path path = FilePath(build_id);
+    std::filesystem::path tmp_path = absl::StrCat(path.string(), ".tmp");
+    Status s = WriteFileFromString(tmp_path, SerializeGoBinaryUProbeInfo(info));
+    if (s.ok()) {
+      s = fs::Rename(tmp_path, path);
+    }
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to persist uprobe cache file $0: $1",
+                                                 path.string(), s.msg());
+  }
+  infos_.insert_or_assign(build_id, std::move(info));
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/node_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * What UProbeManager resolves from a Go binary to trace it: the symbol addresses passed to the
+ * BPF probes, and the uprobes to attach. All of it only depends on the contents of the binary.
+ */
+struct GoBinaryUProbeInfo {
+  // Unset if the binary is not a Go binary, or lacks the symbols that all the Go probes need.
+  std::optional<struct go_common_symaddrs_t> common_symaddrs;
+
+  // Unset if the binary doesn't use Go TLS.
+  std::optional<struct go_tls_symaddrs_t> tls_symaddrs;
+  std::vector<bpf_tools::UProbeSpec> tls_probes;
+
+  // The HTTP2 fields are only resolved when HTTP2 tracing is enabled.
+  bool http2_resolved = false;
+  std::optional<struct go_http2_symaddrs_t> http2_symaddrs;
+  std::vector<bpf_tools::UProbeSpec> http2_probes;
+};
+
+// The UProbeSpecs hold no binary_path or pid, those are filled in when attaching.
+std::string SerializeGoBinaryUProbeInfo(const GoBinaryUProbeInfo& info);
+StatusOr<GoBinaryUProbeInfo> ParseGoBinaryUProbeInfo(std::string_view str);
+
+/**
+ * A cache of GoBinaryUProbeInfo keyed by build-id, so that the many instances of the same binary
+ * (eg. the replicas of a deployment, each in its own container) are only analyzed once.
+ *
+ * If a directory is given, the entries are also persisted there, one file per build-id, and
+ * survive restarts.
+ *
+ * Not thread-safe.
+ */
+class GoUProbeCache {
+ public:
+  explicit GoUProbeCache(std::filesystem::path dir = {}) : dir_(std::move(dir)) {}
+
+  /**
+   * @return The info of the binary with the build-id, or nullptr if it is neither in memory nor
+   *         on disk.
+   */
+  const GoBinaryUProbeInfo* Lookup(const std::string& build_id);
+
+  void Insert(const std::string& build_id, GoBinaryUProbeInfo info);
+
+  size_t size() const { return infos_.size(); }
+
+ private:
+  std::filesystem::path FilePath(const std::string& build_id) const;
+
+  std::filesystem::path dir_;
+  // node_hash_map, because Lookup() hands out pointers to the entries.
+  absl::node_hash_map<std::string, GoBinaryUProbeInfo> infos_;
+};
+
+}  // namespace stirling
+}  // namespace px
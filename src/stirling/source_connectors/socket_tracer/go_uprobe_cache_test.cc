@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/go_uprobe_cache.h"
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::testing::TempDir;
+
+GoBinaryUProbeInfo SampleInfo() {
+  GoBinaryUProbeInfo info;
+  info.common_symaddrs = go_common_symaddrs_t{};
+  info.common_symaddrs->FD_Sysfd_offset = 16;
+  info.tls_symaddrs = go_tls_symaddrs_t{8, 16, 8, 16};
+  info.tls_probes.push_back({{},
+                             "crypto/tls.(*Conn).Write",
+                             0,
+                             bpf_tools::UProbeSpec::kDefaultPID,
+                             bpf_tools::BPFProbeAttachType::kEntry,
+                             "probe_entry_tls_conn_write"});
+  info.tls_probes.push_back({{},
+                             "",
+                             0x4abcde,
+                             bpf_tools::UProbeSpec::kDefaultPID,
+                             bpf_tools::BPFProbeAttachType::kEntry,
+                             "probe_return_tls_conn_write"});
+  info.http2_resolved = true;
+  return info;
+}
+
+TEST(GoBinaryUProbeInfoTest, SerializeAndParse) {
+  GoBinaryUProbeInfo info = SampleInfo();
+
+  ASSERT_OK_AND_ASSIGN(GoBinaryUProbeInfo parsed,
+                       ParseGoBinaryUProbeInfo(SerializeGoBinaryUProbeInfo(info)));
+  ASSERT_TRUE(parsed.common_symaddrs.has_value());
+  EXPECT_EQ(parsed.common_symaddrs->FD_Sysfd_offset, 16);
+  ASSERT_TRUE(parsed.tls_symaddrs.has_value());
+  EXPECT_EQ(parsed.tls_symaddrs->Read_b_offset, 16);
+  ASSERT_EQ(parsed.tls_probes.size(), 2);
+  EXPECT_EQ(parsed.tls_probes[0].symbol, "crypto/tls.(*Conn).Write");
+  EXPECT_EQ(parsed.tls_probes[0].probe_fn, "probe_entry_tls_conn_write");
+  EXPECT_EQ(parsed.tls_probes[1].symbol, "");
+  EXPECT_EQ(parsed.tls_probes[1].address, 0x4abcde);
+  EXPECT_TRUE(parsed.http2_resolved);
+  EXPECT_FALSE(parsed.http2_symaddrs.has_value());
+  EXPECT_TRUE(parsed.http2_probes.empty());
+}
+
+TEST(GoBinaryUProbeInfoTest, ParseInvalid) {
+  EXPECT_NOT_OK(ParseGoBinaryUProbeInfo(""));
+  EXPECT_NOT_OK(ParseGoBinaryUProbeInfo("go_uprobe_cache_v0 1 2 3\n"));
+
+  std::string serialized = SerializeGoBinaryUProbeInfo(SampleInfo());
+  EXPECT_NOT_OK(ParseGoBinaryUProbeInfo(absl::StrCat(serialized, "bogus\n")));
+  EXPECT_NOT_OK(ParseGoBinaryUProbeInfo(absl::StrCat(serialized, "tls 0102\n")));
+}
+
+TEST(GoUProbeCacheTest, InMemory) {
+  GoUProbeCache cache;
+  EXPECT_EQ(cache.Lookup("abcd"), nullptr);
+
+  cache.Insert("abcd", SampleInfo());
+  const GoBinaryUProbeInfo* info = cache.Lookup("abcd");
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->tls_probes.size(), 2);
+}
+
+TEST(GoUProbeCacheTest, PersistedAcrossInstances) {
+  TempDir tmp_dir;
+  const std::string kBuildID = "go:abc/def";
+
+  {
+    GoUProbeCache cache(tmp_dir.path());
+    cache.Insert(kBuildID, SampleInfo());
+  }
+
+  GoUProbeCache cache(tmp_dir.path());
+  EXPECT_EQ(cache.Lookup("go:other"), nullptr);
+  const GoBinaryUProbeInfo* info = cache.Lookup(kBuildID);
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->tls_probes.size(), 2);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -56,7 +56,7 @@ constexpr DataElement kHTTPElements[] = {
          types::SemanticType::ST_NONE,
          types::PatternType::GENERAL_ENUM,
          &kHTTPContentTypeDecoder},
-        {"req_headers", "Request headers in JSON format",
+        {"req_headers", "Request headers in JSON format, or compact (see px.http_header)",
          types::DataType::STRING,
          types::SemanticType::ST_NONE,
          types::PatternType::STRUCTURED},
@@ -76,7 +76,7 @@ constexpr DataElement kHTTPElements[] = {
          types::DataType::INT64,
          types::SemanticType::ST_BYTES,
          types::PatternType::METRIC_GAUGE},
-        {"resp_headers", "Response headers in JSON format",
+        {"resp_headers", "Response headers in JSON format, or compact (see px.http_header)",
          types::DataType::STRING,
          types::SemanticType::ST_NONE,
          types::PatternType::STRUCTURED},
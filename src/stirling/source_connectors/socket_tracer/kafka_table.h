@@ -28,9 +28,7 @@ namespace px {
 namespace stirling {
 
 static const std::map<int64_t, std::string_view> kKafkaAPIKeyDecoder =
-    px::EnumDefToMap<protocols::kafka::Command>();
-static const std::map<int64_t, std::string_view> kKafkaErrorCodeDecoder =
-    px::EnumDefToMap<protocols::kafka::ErrorCode>();
+    px::EnumDefToMap<protocols::kafka::APIKey>();
 
 // clang-format off
 static constexpr DataElement kKafkaElements[] = {
@@ -44,38 +42,36 @@ static constexpr DataElement kKafkaElements[] = {
        types::SemanticType::ST_NONE,
        types::PatternType::GENERAL_ENUM,
        &kKafkaAPIKeyDecoder},
-      {"req_body", "Kafka request body",
+      {"client_id", "Kafka client ID",
        types::DataType::STRING,
        types::SemanticType::ST_NONE,
        types::PatternType::GENERAL},
-      {"resp_status", "Kafka response error code. 0 for OK.",
-       types::DataType::INT64,
+      {"req_body", "Kafka request body, as JSON. Empty for commands that are not decoded.",
+       types::DataType::STRING,
        types::SemanticType::ST_NONE,
        types::PatternType::GENERAL},
-      {"resp_body", "Kafka response body",
+      {"resp_body", "Kafka response body, as JSON. Empty for commands that are not decoded.",
        types::DataType::STRING,
        types::SemanticType::ST_NONE,
-       type::PatternType::GENERAL},
-       canonical_data_elements::kLatencyNS,
+       types::PatternType::GENERAL},
+      canonical_data_elements::kLatencyNS,
 #ifndef NDEBUG
       canonical_data_elements::kPXInfo,
 #endif
-}
+};
 // clang-format on
 
 static constexpr auto kKafkaTable =
-    DataTableSchema("kafka_events.beta", "Kafka resquest-response pair events", kKafkaElements);
+    DataTableSchema("kafka_events.beta", "Kafka request-response pair events", kKafkaElements);
 DEFINE_PRINT_TABLE(Kafka)
 
 constexpr int kKafkaTimeIdx = kKafkaTable.ColIndex("time_");
 constexpr int kKafkaUPIDIdx = kKafkaTable.ColIndex("upid");
 constexpr int kKafkaReqCmdIdx = kKafkaTable.ColIndex("req_cmd");
+constexpr int kKafkaClientIDIdx = kKafkaTable.ColIndex("client_id");
 constexpr int kKafkaReqBodyIdx = kKafkaTable.ColIndex("req_body");
-constexpr int kKafkaRespStatusIdx = kKafkaTable.ColIndex("resp_status");
 constexpr int kKafkaRespBodyIdx = kKafkaTable.ColIndex("resp_body");
 constexpr int kKafkaLatencyIdx = kKafkaTable.ColIndex("latency");
-#ifndef NDEBUG
-constexpr int kKafkaPXInfoIdx = kKafkaTable.ColIndex("px_info");
-#endif
+
 }  // namespace stirling
 }  // namespace px
@@ -19,8 +19,6 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
 
 #include <algorithm>
-#include <deque>
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -33,22 +31,31 @@ namespace protocols {
 
 namespace {
 
-// Get element <= key in a map.
-template <typename TMapType>
-typename TMapType::const_iterator MapLE(const TMapType& map, size_t key) {
-  auto iter = map.upper_bound(key);
-  if (iter == map.begin()) {
-    return map.cend();
+// Get the element with the largest pos <= key in a vector sorted by pos.
+template <typename TVectorType>
+typename TVectorType::const_iterator VectorLE(const TVectorType& vec, size_t key) {
+  auto iter = std::upper_bound(vec.begin(), vec.end(), key,
+                               [](size_t key, const auto& elem) { return key < elem.pos; });
+  if (iter == vec.begin()) {
+    return vec.cend();
   }
   --iter;
 
   return iter;
 }
 
+// Get the first element with pos >= key in a vector sorted by pos.
+template <typename TVectorType>
+typename TVectorType::iterator VectorGE(TVectorType* vec, size_t key) {
+  return std::lower_bound(vec->begin(), vec->end(), key,
+                          [](const auto& elem, size_t key) { return elem.pos < key; });
+}
+
 }  // namespace
 
 void DataStreamBuffer::Reset() {
   buffer_.clear();
+  head_ = 0;
   chunks_.clear();
   timestamps_.clear();
   position_ = 0;
@@ -58,52 +65,49 @@ void DataStreamBuffer::Reset() {
 //               Return error in such cases.
 void DataStreamBuffer::AddNewChunk(size_t pos, size_t size) {
   // Look for the chunks to the left and right of this new chunk.
-  auto r_iter = chunks_.lower_bound(pos);
-  auto l_iter = r_iter;
-  if (l_iter != chunks_.begin()) {
-    --l_iter;
+  auto r_iter = VectorGE(&chunks_, pos);
+  auto l_iter = chunks_.end();
+  if (r_iter != chunks_.begin()) {
+    l_iter = r_iter - 1;
   }
 
   // Does this chunk fuse with the chunk on the left of it?
-  bool left_fuse = false;
-  if (l_iter != chunks_.end()) {
-    size_t l_pos = l_iter->first;
-    size_t l_size = l_iter->second;
-
-    left_fuse = (l_pos + l_size == pos);
-  }
+  bool left_fuse = (l_iter != chunks_.end()) && (l_iter->pos + l_iter->size == pos);
 
   // Does this chunk fuse with the chunk on the right of it?
-  bool right_fuse = false;
-  if (r_iter != chunks_.end()) {
-    size_t r_pos = r_iter->first;
-
-    right_fuse = (pos + size == r_pos);
-  }
+  bool right_fuse = (r_iter != chunks_.end()) && (pos + size == r_iter->pos);
 
   if (left_fuse && right_fuse) {
     // The new chunk bridges two previously separate chunks together.
     // Keep the left one and increase its size to cover all three chunks.
-    l_iter->second += (size + r_iter->second);
+    l_iter->size += (size + r_iter->size);
     chunks_.erase(r_iter);
   } else if (left_fuse) {
     // Merge new chunk directly to the one on its left.
-    l_iter->second += size;
+    l_iter->size += size;
   } else if (right_fuse) {
     // Merge new chunk into the one on its right.
-    // Since its key changes, this requires removing and re-inserting the node.
-    auto node = chunks_.extract(r_iter);
-    node.key() = pos;
-    node.mapped() += size;
-    chunks_.insert(std::move(node));
+    r_iter->pos = pos;
+    r_iter->size += size;
   } else {
     // No fusing, so just add the new chunk.
-    chunks_[pos] = size;
+    chunks_.insert(r_iter, Chunk{pos, size});
   }
 }
 
 void DataStreamBuffer::AddNewTimestamp(size_t pos, uint64_t timestamp) {
-  timestamps_[pos] = timestamp;
+  // Fast path for data arriving in order.
+  if (timestamps_.empty() || timestamps_.back().pos < pos) {
+    timestamps_.push_back(Timestamp{pos, timestamp});
+    return;
+  }
+
+  auto iter = VectorGE(&timestamps_, pos);
+  if (iter != timestamps_.end() && iter->pos == pos) {
+    iter->timestamp = timestamp;
+  } else {
+    timestamps_.insert(iter, Timestamp{pos, timestamp});
+  }
 }
 
 void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp) {
@@ -137,7 +141,7 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
     data.remove_prefix(prefix);
     pos += prefix;
     ppos_front = 0;
-  } else if (ppos_back > static_cast<ssize_t>(buffer_.size())) {
+  } else if (ppos_back > static_cast<ssize_t>(size())) {
     // Case 3: Data being added extends the buffer. Resize the buffer.
 
     if (pos > position_ + capacity_) {
@@ -167,13 +171,12 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
     DCHECK_GE(ppos_back, 0);
     DCHECK_LE(ppos_back, capacity_);
 
-    ssize_t extension = ppos_back - buffer_.size();
+    ssize_t extension = ppos_back - size();
     DCHECK_GE(extension, 0);
     DCHECK_LE(extension, capacity_);
 
     buffer_.resize(buffer_.size() + extension);
-    DCHECK_GE(buffer_.size(), 0);
-    DCHECK_LE(buffer_.size(), capacity_);
+    DCHECK_LE(size(), capacity_);
   } else {
     // Case 4: Data being added is completely within the buffer. Write it directly.
 
@@ -181,24 +184,25 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
   }
 
   // Now copy the data into the buffer.
-  memcpy(buffer_.data() + ppos_front, data.data(), data.size());
+  memcpy(buffer_.data() + head_ + ppos_front, data.data(), data.size());
 
   // Update the metadata.
   AddNewChunk(pos, data.size());
   AddNewTimestamp(pos, timestamp);
 }
 
-std::map<size_t, size_t>::const_iterator DataStreamBuffer::GetChunkForPos(size_t pos) const {
+std::vector<DataStreamBuffer::Chunk>::const_iterator DataStreamBuffer::GetChunkForPos(
+    size_t pos) const {
   // Get chunk which is <= pos.
-  auto iter = MapLE(chunks_, pos);
+  auto iter = VectorLE(chunks_, pos);
   if (iter == chunks_.cend()) {
     return chunks_.cend();
   }
 
-  DCHECK_GE(pos, iter->first);
+  DCHECK_GE(pos, iter->pos);
 
   // Does the chunk include pos? If not, return {}.
-  ssize_t available = iter->second - (pos - iter->first);
+  ssize_t available = iter->size - (pos - iter->pos);
   if (available <= 0) {
     return chunks_.cend();
   }
@@ -212,16 +216,16 @@ std::string_view DataStreamBuffer::Get(size_t pos) const {
     return {};
   }
 
-  size_t chunk_pos = iter->first;
-  size_t chunk_size = iter->second;
+  size_t chunk_pos = iter->pos;
+  size_t chunk_size = iter->size;
 
   ssize_t bytes_available = chunk_size - (pos - chunk_pos);
   DCHECK_GT(bytes_available, 0);
 
   DCHECK_GE(pos, position_);
   size_t ppos = pos - position_;
-  DCHECK_LT(ppos, buffer_.size());
-  return std::string_view(buffer_.data() + ppos, bytes_available);
+  DCHECK_LT(ppos, size());
+  return std::string_view(buffer_.data() + head_ + ppos, bytes_available);
 }
 
 StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
@@ -231,7 +235,7 @@ StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
   }
 
   // Get chunk which is <= pos.
-  auto iter = MapLE(timestamps_, pos);
+  auto iter = VectorLE(timestamps_, pos);
   if (iter == timestamps_.cend()) {
     LOG(DFATAL) << absl::Substitute(
         "Specified position should have been found, since we verified we are not in a chunk gap "
@@ -240,9 +244,9 @@ StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
     return error::Internal("Specified position not found.");
   }
 
-  DCHECK_GE(pos, iter->first);
+  DCHECK_GE(pos, iter->pos);
 
-  return iter->second;
+  return iter->timestamp;
 }
 
 void DataStreamBuffer::CleanupMetadata() {
@@ -254,13 +258,13 @@ void DataStreamBuffer::CleanupChunks() {
   // Find and remove irrelevant metadata in `chunks_`.
 
   // Get chunk which is <= position_.
-  auto iter = MapLE(chunks_, position_);
+  auto iter = VectorLE(chunks_, position_);
   if (iter == chunks_.cend()) {
     return;
   }
 
-  size_t chunk_pos = iter->first;
-  size_t chunk_size = iter->second;
+  size_t chunk_pos = iter->pos;
+  size_t chunk_size = iter->size;
 
   DCHECK_GE(position_, chunk_pos);
   ssize_t available = chunk_size - (position_ - chunk_pos);
@@ -268,17 +272,14 @@ void DataStreamBuffer::CleanupChunks() {
   if (available <= 0) {
     // position_ was in a gap area between two chunks, so go back to the next chunk.
     ++iter;
-    chunks_.erase(chunks_.begin(), iter);
+    chunks_.erase(chunks_.cbegin(), iter);
   } else {
     // Remove all chunks entirely before position_.
-    chunks_.erase(chunks_.begin(), iter);
+    chunks_.erase(chunks_.cbegin(), iter);
 
     // Adjust the first chunk's size.
     DCHECK(!chunks_.empty());
-    auto node = chunks_.extract(chunks_.begin());
-    node.key() = position_;
-    node.mapped() = available;
-    chunks_.insert(std::move(node));
+    chunks_.front() = Chunk{position_, static_cast<size_t>(available)};
   }
 }
 
@@ -286,14 +287,14 @@ void DataStreamBuffer::CleanupTimestamps() {
   // Find and remove irrelevant metadata in `timestamps_`.
 
   // Get timestamp which is <= position_.
-  auto iter = MapLE(timestamps_, position_);
+  auto iter = VectorLE(timestamps_, position_);
   if (iter == timestamps_.cend()) {
     return;
   }
 
   // We are now at the timestamp that covers position_,
   // anything before this is expired and can be removed.
-  timestamps_.erase(timestamps_.begin(), iter);
+  timestamps_.erase(timestamps_.cbegin(), iter);
 
   DCHECK(!timestamps_.empty());
 }
@@ -306,22 +307,34 @@ void DataStreamBuffer::RemovePrefix(ssize_t n) {
     return;
   }
 
-  buffer_.erase(0, n);
+  ConsumeBytes(std::min<size_t>(n, size()));
   position_ += n;
 
   CleanupMetadata();
 }
 
+void DataStreamBuffer::ConsumeBytes(size_t n) {
+  DCHECK_LE(n, size());
+  head_ += n;
+
+  // Only move the remaining bytes back to the start of the buffer once more bytes have been
+  // consumed than are left, so each byte is moved at most once per byte consumed.
+  if (head_ >= size()) {
+    buffer_.erase(0, head_);
+    head_ = 0;
+  }
+}
+
 void DataStreamBuffer::Trim() {
   if (chunks_.empty()) {
     return;
   }
 
-  auto& chunk_pos = chunks_.begin()->first;
+  size_t chunk_pos = chunks_.front().pos;
   DCHECK_GE(chunk_pos, position_);
   size_t trim_size = chunk_pos - position_;
 
-  buffer_.erase(0, trim_size);
+  ConsumeBytes(trim_size);
   position_ += trim_size;
 }
 
@@ -329,16 +342,16 @@ std::string DataStreamBuffer::DebugInfo() const {
   std::string s;
 
   absl::StrAppend(&s, absl::Substitute("Position: $0\n", position_));
-  absl::StrAppend(&s, absl::Substitute("BufferSize: $0/$1\n", buffer_.size(), capacity_));
+  absl::StrAppend(&s, absl::Substitute("BufferSize: $0/$1\n", size(), capacity_));
   absl::StrAppend(&s, "Chunks:\n");
-  for (const auto& [pos, size] : chunks_) {
-    absl::StrAppend(&s, absl::Substitute("  position:$0 size:$1\n", pos, size));
+  for (const auto& chunk : chunks_) {
+    absl::StrAppend(&s, absl::Substitute("  position:$0 size:$1\n", chunk.pos, chunk.size));
   }
   absl::StrAppend(&s, "Timestamps:\n");
-  for (const auto& [pos, timestamp] : timestamps_) {
-    absl::StrAppend(&s, absl::Substitute("  position:$0 timestamp:$1\n", pos, timestamp));
+  for (const auto& ts : timestamps_) {
+    absl::StrAppend(&s, absl::Substitute("  position:$0 timestamp:$1\n", ts.pos, ts.timestamp));
   }
-  absl::StrAppend(&s, absl::Substitute("Buffer: $0\n", buffer_));
+  absl::StrAppend(&s, absl::Substitute("Buffer: $0\n", buffer_.substr(head_)));
 
   return s;
 }
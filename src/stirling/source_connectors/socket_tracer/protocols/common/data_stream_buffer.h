@@ -18,8 +18,8 @@
 
 #pragma once
 
-#include <map>
 #include <string>
+#include <vector>
 
 #include "src/common/base/base.h"
 
@@ -40,8 +40,10 @@ namespace protocols {
  * DataStreamBuffer supports data arriving out-of-order such that they are slotted into the middle
  * of the buffer.
  *
- * The underlying implementation is currently a simple string buffer, but this could be changed
- * in the future, as long as the data is maintained in a contiguous buffer.
+ * The data is kept in a contiguous buffer, so that Get() can return a single string_view.
+ * Consuming data from the head only advances an offset into the buffer; the remaining bytes are
+ * moved back to the start of the buffer once more bytes have been consumed than are left, which
+ * keeps RemovePrefix() amortized O(1) and the buffer within twice its capacity.
  */
 class DataStreamBuffer {
  public:
@@ -95,12 +97,12 @@ class DataStreamBuffer {
   /**
    * Current size of the internal buffer. Not all bytes may be populated.
    */
-  size_t size() const { return buffer_.size(); }
+  size_t size() const { return buffer_.size() - head_; }
 
   /**
    * Return true if the buffer is empty.
    */
-  bool empty() const { return buffer_.empty(); }
+  bool empty() const { return size() == 0; }
 
   /**
    * Logical position of the head of the buffer.
@@ -116,10 +118,25 @@ class DataStreamBuffer {
   void Reset();
 
  private:
-  std::map<size_t, size_t>::const_iterator GetChunkForPos(size_t pos) const;
+  // A contiguous sequence of bytes, starting at logical position pos.
+  struct Chunk {
+    size_t pos;
+    size_t size;
+  };
+
+  // The timestamp of the event that was added at logical position pos.
+  struct Timestamp {
+    size_t pos;
+    uint64_t timestamp;
+  };
+
+  std::vector<Chunk>::const_iterator GetChunkForPos(size_t pos) const;
   void AddNewChunk(size_t pos, size_t size);
   void AddNewTimestamp(size_t pos, uint64_t timestamp);
 
+  // Drops the first n bytes of the physical buffer, which must already be behind position_.
+  void ConsumeBytes(size_t n);
+
   void CleanupTimestamps();
   void CleanupChunks();
 
@@ -129,22 +146,22 @@ class DataStreamBuffer {
   const size_t capacity_;
 
   // Logical position of data stream buffer.
-  // In other words, the position of buffer_[0].
+  // In other words, the position of buffer_[head_].
   size_t position_ = 0;
 
-  // Buffer where all data is stored.
-  // TODO(oazizi): Investigate buffer that is better suited to the rolling buffer (slinky) model.
+  // Buffer where all data is stored. The bytes before head_ have been consumed.
   std::string buffer_;
+  size_t head_ = 0;
 
-  // Map of chunk start positions to chunk sizes.
-  // A chunk is a contiguous sequence of bytes.
+  // Chunks sorted by position.
   // Adjacent chunks are always fused, so a chunk either ends at a gap or the end of the buffer.
-  std::map<size_t, size_t> chunks_;
+  // Data mostly arrives in order, so new chunks are usually appended or fused at the back.
+  std::vector<Chunk> chunks_;
 
-  // Map of positions to timestamps.
+  // Timestamps sorted by position.
   // Unlike chunks_, which will fuse when adjacent, timestamps never fuse.
   // Also, we don't track gaps in the buffer with timestamps; must use chunks_ for that.
-  std::map<size_t, uint64_t> timestamps_;
+  std::vector<Timestamp> timestamps_;
 };
 
 }  // namespace protocols
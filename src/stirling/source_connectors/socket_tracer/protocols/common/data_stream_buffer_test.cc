@@ -291,6 +291,45 @@ TEST(DataStreamTest, SizeAndGetPos) {
   EXPECT_FALSE(stream_buffer.empty());
 }
 
+// Consumes the buffer a few bytes at a time while new data keeps arriving, which is how the
+// parsers use it. Removed bytes are reclaimed lazily, so this checks the contents stay intact.
+TEST(DataStreamTest, InterleavedAddAndRemovePrefix) {
+  DataStreamBuffer stream_buffer(15);
+
+  stream_buffer.Add(0, "0123", 0);
+  stream_buffer.Add(4, "4567", 4);
+  stream_buffer.RemovePrefix(3);
+  EXPECT_EQ(stream_buffer.position(), 3);
+  EXPECT_EQ(stream_buffer.Head(), "34567");
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(3), 0);
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(4), 4);
+
+  stream_buffer.Add(8, "89", 8);
+  stream_buffer.RemovePrefix(2);
+  EXPECT_EQ(stream_buffer.position(), 5);
+  EXPECT_EQ(stream_buffer.Head(), "56789");
+  EXPECT_EQ(stream_buffer.Get(7), "789");
+  EXPECT_NOT_OK(stream_buffer.GetTimestamp(3));
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(5), 4);
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(9), 8);
+
+  stream_buffer.Add(12, "cd", 12);
+  stream_buffer.RemovePrefix(4);
+  EXPECT_EQ(stream_buffer.position(), 9);
+  EXPECT_EQ(stream_buffer.Head(), "9");
+  EXPECT_EQ(stream_buffer.Get(12), "cd");
+
+  // Filling the gap makes the data contiguous again.
+  stream_buffer.Add(10, "ab", 10);
+  EXPECT_EQ(stream_buffer.Head(), "9abcd");
+  EXPECT_EQ(stream_buffer.size(), 5);
+
+  stream_buffer.RemovePrefix(5);
+  EXPECT_TRUE(stream_buffer.empty());
+  stream_buffer.Add(14, "ef", 14);
+  EXPECT_EQ(stream_buffer.Head(), "ef");
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -31,6 +31,7 @@
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/common.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/frame_pool.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
 #include "src/stirling/utils/parse_state.h"
 #include "src/stirling/utils/utils.h"
@@ -162,9 +163,12 @@ ParseResult ParseFramesLoop(MessageType type, std::string_view buf,
   ParseState s = ParseState::kSuccess;
   size_t bytes_processed = 0;
   int invalid_count = 0;
+  // Attempts that don't produce a frame (eg. when more data is needed) hand their frame back to
+  // the pool, for the next attempt to reuse its buffers.
+  FramePool<TFrameType>* pool = FramePool<TFrameType>::ThreadLocal();
 
   while (!buf.empty() && s != ParseState::kEOS) {
-    TFrameType frame;
+    TFrameType frame = pool->Acquire();
 
     s = ParseFrame(type, &buf, &frame);
 
@@ -206,6 +210,7 @@ ParseResult ParseFramesLoop(MessageType type, std::string_view buf,
     }
 
     if (stop) {
+      pool->Recycle(std::move(frame));
       break;
     }
 
@@ -216,6 +221,8 @@ ParseResult ParseFramesLoop(MessageType type, std::string_view buf,
     if (push) {
       frame_positions.push_back({start_position, end_position});
       frames->push_back(std::move(frame));
+    } else {
+      pool->Recycle(std::move(frame));
     }
   }
   return ParseResult{std::move(frame_positions), bytes_processed, s, invalid_count};
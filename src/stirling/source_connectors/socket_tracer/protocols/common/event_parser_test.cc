@@ -98,6 +98,63 @@ TEST_F(EventParserTest, BasicProtocolParsing) {
   EXPECT_THAT(timestamps, ElementsAre(0, 1, 1, 2, 3, 4));
 }
 
+// Same as TestFrame, but pooled (see FramePool). The parser fills in the frame before it knows
+// whether the frame is complete, like real parsers do.
+struct PooledFrame : public FrameBase {
+  std::string msg;
+
+  size_t ByteSize() const override { return sizeof(PooledFrame) + msg.size(); }
+  void Reset() {
+    timestamp_ns = 0;
+    msg.clear();
+  }
+};
+
+template <>
+ParseState ParseFrame(MessageType /* type */, std::string_view* buf, PooledFrame* frame) {
+  size_t pos = buf->find(",");
+  frame->msg = buf->substr(0, pos);
+  if (pos == buf->npos) {
+    return ParseState::kNeedsMoreData;
+  }
+  buf->remove_prefix(pos + 1);
+  return ParseState::kSuccess;
+}
+
+TEST(FramePoolTest, ParseRecyclesIncompleteFrames) {
+  FramePool<PooledFrame>* pool = FramePool<PooledFrame>::ThreadLocal();
+  ASSERT_EQ(pool->size(), 0);
+
+  std::deque<PooledFrame> frames;
+  ParseResult res = ParseFramesLoop(MessageType::kRequest, "venus,earth,a long incomplete frame",
+                                    &frames);
+  EXPECT_EQ(res.state, ParseState::kNeedsMoreData);
+  ASSERT_EQ(frames.size(), 2);
+
+  // The frame of the last attempt is back in the pool, cleared but with its buffer.
+  ASSERT_EQ(pool->size(), 1);
+  PooledFrame frame = pool->Acquire();
+  EXPECT_EQ(pool->size(), 0);
+  EXPECT_EQ(frame.msg, "");
+  EXPECT_GE(frame.msg.capacity(), std::string_view("a long incomplete frame").size());
+
+  pool->Recycle(std::move(frame));
+  res = ParseFramesLoop(MessageType::kRequest, "mars,", &frames);
+  EXPECT_EQ(res.state, ParseState::kSuccess);
+  ASSERT_EQ(frames.size(), 3);
+  EXPECT_EQ(frames.back().msg, "mars");
+  EXPECT_EQ(pool->size(), 0);
+}
+
+TEST(FramePoolTest, FramesWithoutResetAreNotPooled) {
+  FramePool<TestFrame>* pool = FramePool<TestFrame>::ThreadLocal();
+
+  std::deque<TestFrame> frames;
+  ParseFramesLoop(MessageType::kRequest, "venus,earth", &frames);
+  EXPECT_EQ(frames.size(), 1);
+  EXPECT_EQ(pool->size(), 0);
+}
+
 // TODO(oazizi): Move any protocol specific tests that check for general EventParser behavior here.
 // Should help reduce duplication of tests.
 
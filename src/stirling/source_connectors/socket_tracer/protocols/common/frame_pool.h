@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * A FramePool recycles the frames that are no longer needed, so that parsing into them again
+ * reuses their buffers (eg. the strings of an HTTP message) instead of allocating new ones.
+ *
+ * Only frame types with a Reset() method are pooled. Reset() must clear the frame to its default
+ * state, while keeping the capacity of its buffers. Other frame types are created and freed as
+ * usual.
+ *
+ * The pools are thread-local, since the trackers can be parsed on several threads (see
+ * SocketTraceConnector::TransferConnTrackersParallel()).
+ */
+template <typename TFrameType>
+class FramePool {
+ public:
+  // Maximum number of frames held by the pool of a thread.
+  static constexpr size_t kCapacity = 64;
+
+  static FramePool* ThreadLocal() {
+    thread_local FramePool pool;
+    return &pool;
+  }
+
+  /**
+   * @return a recycled frame if one is available, otherwise a new one.
+   */
+  TFrameType Acquire() {
+    if (frames_.empty()) {
+      return TFrameType();
+    }
+    TFrameType frame = std::move(frames_.back());
+    frames_.pop_back();
+    return frame;
+  }
+
+  /**
+   * Adds the frame to the pool, unless the pool is full or the frame type isn't pooled.
+   */
+  void Recycle(TFrameType&& frame) {
+    if constexpr (kPooled) {
+      if (frames_.size() >= kCapacity) {
+        return;
+      }
+      frame.Reset();
+      frames_.push_back(std::move(frame));
+    }
+  }
+
+  size_t size() const { return frames_.size(); }
+
+ private:
+  template <typename T, typename = void>
+  struct HasReset : std::false_type {};
+  template <typename T>
+  struct HasReset<T, std::void_t<decltype(std::declval<T&>().Reset())>> : std::true_type {};
+
+  static constexpr bool kPooled = HasReset<TFrameType>::value;
+
+  std::vector<TFrameType> frames_;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
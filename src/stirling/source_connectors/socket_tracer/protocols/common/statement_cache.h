@@ -0,0 +1,166 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * StatementCache holds the prepared statements of a connection, for the protocols (MySQL,
+ * PostgreSQL) that refer to a statement by an ID once it is prepared.
+ *
+ * The statement texts are interned: statements with the same text share one copy, which is
+ * common with connection pools that prepare the same queries over and over. The memory is
+ * bounded by the total size of the texts; when it is exceeded, the least recently used
+ * statements are evicted.
+ *
+ * @tparam TKey The statement ID.
+ * @tparam TValue Whatever else the protocol needs to keep about a statement.
+ */
+template <typename TKey, typename TValue>
+class StatementCache {
+ public:
+  static constexpr size_t kDefaultMaxBytes = 1024 * 1024;
+
+  struct Entry {
+    TKey key;
+    std::shared_ptr<const std::string> text;
+    TValue value;
+  };
+
+  StatementCache() = default;
+  explicit StatementCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+  // The protocol state is held in a std::any by ConnTracker, which requires it to be copyable.
+  StatementCache(const StatementCache& other)
+      : max_bytes_(other.max_bytes_), num_evictions_(other.num_evictions_) {
+    for (auto iter = other.lru_.rbegin(); iter != other.lru_.rend(); ++iter) {
+      lru_.push_front(Entry{iter->key, Intern(*iter->text), iter->value});
+      index_[lru_.front().key] = lru_.begin();
+    }
+  }
+  StatementCache(StatementCache&&) = default;
+  StatementCache& operator=(const StatementCache&) = delete;
+  StatementCache& operator=(StatementCache&&) = default;
+
+  /**
+   * Adds a statement, replacing any statement with the same key, and evicts the least recently
+   * used statements if the cache is over its limit. The new statement itself is never evicted.
+   */
+  const Entry& Insert(TKey key, std::string_view text, TValue value = {}) {
+    Erase(key);
+
+    lru_.push_front(Entry{std::move(key), Intern(text), std::move(value)});
+    index_[lru_.front().key] = lru_.begin();
+
+    while (bytes_ > max_bytes_ && lru_.size() > 1) {
+      EraseIter(std::prev(lru_.end()));
+      ++num_evictions_;
+    }
+    return lru_.front();
+  }
+
+  /**
+   * @return The statement, or nullptr if it was never prepared (or was evicted).
+   * The statement becomes the most recently used one.
+   */
+  const Entry* Find(const TKey& key) {
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    return &*iter->second;
+  }
+
+  /**
+   * @return true if the statement was in the cache.
+   */
+  bool Erase(const TKey& key) {
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return false;
+    }
+    EraseIter(iter->second);
+    return true;
+  }
+
+  size_t size() const { return lru_.size(); }
+  bool empty() const { return lru_.empty(); }
+
+  // The size of the distinct statement texts.
+  size_t bytes() const { return bytes_; }
+
+  int64_t num_evictions() const { return num_evictions_; }
+
+ private:
+  struct InternedText {
+    std::shared_ptr<const std::string> text;
+    int num_entries = 0;
+  };
+
+  std::shared_ptr<const std::string> Intern(std::string_view text) {
+    auto iter = interned_.find(text);
+    if (iter == interned_.end()) {
+      auto owned = std::make_shared<const std::string>(text);
+      bytes_ += owned->size();
+      // The key references the interned copy, which lives as long as the map entry.
+      std::string_view owned_text = *owned;
+      iter = interned_.emplace(owned_text, InternedText{std::move(owned)}).first;
+    }
+    ++iter->second.num_entries;
+    return iter->second.text;
+  }
+
+  void EraseIter(typename std::list<Entry>::iterator iter) {
+    auto interned_iter = interned_.find(*iter->text);
+    DCHECK(interned_iter != interned_.end());
+    if (--interned_iter->second.num_entries == 0) {
+      bytes_ -= interned_iter->second.text->size();
+      interned_.erase(interned_iter);
+    }
+    index_.erase(iter->key);
+    lru_.erase(iter);
+  }
+
+  size_t max_bytes_ = kDefaultMaxBytes;
+
+  // Most recently used first.
+  std::list<Entry> lru_;
+  absl::flat_hash_map<TKey, typename std::list<Entry>::iterator> index_;
+  absl::flat_hash_map<std::string_view, InternedText> interned_;
+
+  size_t bytes_ = 0;
+  int64_t num_evictions_ = 0;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/statement_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+using StringCache = StatementCache<std::string, int>;
+
+TEST(StatementCacheTest, InsertFindErase) {
+  StringCache cache;
+  cache.Insert("a", "select 1", 1);
+  cache.Insert("b", "select 2", 2);
+
+  const StringCache::Entry* entry = cache.Find("a");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(*entry->text, "select 1");
+  EXPECT_EQ(entry->value, 1);
+  EXPECT_EQ(cache.Find("c"), nullptr);
+
+  // Re-preparing a statement replaces it.
+  cache.Insert("a", "select 3", 3);
+  EXPECT_EQ(*cache.Find("a")->text, "select 3");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.bytes(), 16);
+
+  EXPECT_TRUE(cache.Erase("a"));
+  EXPECT_FALSE(cache.Erase("a"));
+  EXPECT_EQ(cache.Find("a"), nullptr);
+  EXPECT_EQ(cache.bytes(), 8);
+}
+
+TEST(StatementCacheTest, SharesIdenticalTexts) {
+  StringCache cache;
+  cache.Insert("a", "select * from t where id = ?");
+  cache.Insert("b", "select * from t where id = ?");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.bytes(), 28);
+  EXPECT_EQ(cache.Find("a")->text, cache.Find("b")->text);
+
+  cache.Erase("a");
+  EXPECT_EQ(cache.bytes(), 28);
+  cache.Erase("b");
+  EXPECT_EQ(cache.bytes(), 0);
+}
+
+TEST(StatementCacheTest, EvictsLeastRecentlyUsed) {
+  StringCache cache(/* max_bytes */ 20);
+  cache.Insert("a", "0123456789");
+  cache.Insert("b", "abcdefghij");
+  // Touch "a", so that "b" is the least recently used.
+  ASSERT_NE(cache.Find("a"), nullptr);
+
+  cache.Insert("c", "ABCDEFGHIJ");
+  EXPECT_NE(cache.Find("a"), nullptr);
+  EXPECT_EQ(cache.Find("b"), nullptr);
+  EXPECT_NE(cache.Find("c"), nullptr);
+  EXPECT_EQ(cache.bytes(), 20);
+  EXPECT_EQ(cache.num_evictions(), 1);
+
+  // A statement over the limit by itself is kept until the next one comes.
+  cache.Insert("d", std::string(30, 'x'));
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_NE(cache.Find("d"), nullptr);
+}
+
+TEST(StatementCacheTest, TextOutlivesEviction) {
+  StringCache cache(/* max_bytes */ 10);
+  std::shared_ptr<const std::string> text = cache.Insert("a", "0123456789").text;
+  cache.Insert("b", "abcdefghij");
+  EXPECT_EQ(cache.Find("a"), nullptr);
+  EXPECT_EQ(*text, "0123456789");
+}
+
+TEST(StatementCacheTest, Copy) {
+  StringCache cache(/* max_bytes */ 20);
+  cache.Insert("a", "0123456789");
+  cache.Insert("b", "abcdefghij");
+
+  StringCache copy(cache);
+  // The copy keeps the recency order, so "a" is the one evicted.
+  copy.Insert("c", "ABCDEFGHIJ");
+  EXPECT_EQ(copy.Find("a"), nullptr);
+  EXPECT_EQ(*copy.Find("b")->text, "abcdefghij");
+  EXPECT_EQ(copy.bytes(), 20);
+
+  // The original is unaffected.
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(*cache.Find("a")->text, "0123456789");
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
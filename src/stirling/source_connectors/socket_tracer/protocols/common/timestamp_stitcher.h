@@ -47,6 +47,8 @@ template <typename TRecordType, typename TMessageType>
 RecordsWithErrorCount<TRecordType> StitchMessagesWithTimestampOrder(
     std::deque<TMessageType>* req_messages, std::deque<TMessageType>* resp_messages) {
   std::vector<TRecordType> records;
+  // At most one record per response.
+  records.reserve(resp_messages->size());
 
   TRecordType record;
   record.req.timestamp_ns = 0;
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "src/common/base/byte_utils.h"
 
@@ -363,6 +364,16 @@ StatusOr<ResultMetadata> FrameBodyDecoder::ExtractResultMetadata(bool prepared_r
   return r;
 }
 
+StatusOr<std::vector<std::basic_string<uint8_t>>> FrameBodyDecoder::ExtractRow(
+    int32_t columns_count) {
+  std::vector<std::basic_string<uint8_t>> row;
+  for (int32_t i = 0; i < columns_count; ++i) {
+    PL_ASSIGN_OR_RETURN(std::basic_string<uint8_t> cell, ExtractBytes());
+    row.push_back(std::move(cell));
+  }
+  return row;
+}
+
 StatusOr<SchemaChange> FrameBodyDecoder::ExtractSchemaChange() {
   SchemaChange sc;
 
@@ -562,12 +573,18 @@ StatusOr<ResultVoidResp> ParseResultVoid(FrameBodyDecoder* decoder) {
 }
 
 // See section 4.2.5.2 of the spec.
-StatusOr<ResultRowsResp> ParseResultRows(FrameBodyDecoder* decoder) {
+StatusOr<ResultRowsResp> ParseResultRows(FrameBodyDecoder* decoder, int32_t max_sample_rows) {
   ResultRowsResp r;
   PL_ASSIGN_OR_RETURN(r.metadata, decoder->ExtractResultMetadata());
   PL_ASSIGN_OR_RETURN(r.rows_count, decoder->ExtractInt());
-  // Skip grabbing the row content for now.
-  // PL_RETURN_IF_ERROR(decoder->ExpectEOF());
+  // The rows can make up most of a large result, so beyond the sample they are skipped
+  // rather than decoded. That also means there is no EOF check here.
+  int32_t num_sample_rows = std::min(r.rows_count, max_sample_rows);
+  for (int32_t i = 0; i < num_sample_rows; ++i) {
+    PL_ASSIGN_OR_RETURN(std::vector<std::basic_string<uint8_t>> row,
+                        decoder->ExtractRow(r.metadata.columns_count));
+    r.sample_rows.push_back(std::move(row));
+  }
   return r;
 }
 
@@ -598,7 +615,7 @@ StatusOr<ResultSchemaChangeResp> ParseResultSchemaChange(FrameBodyDecoder* decod
 
 }  // namespace
 
-StatusOr<ResultResp> ParseResultResp(Frame* frame) {
+StatusOr<ResultResp> ParseResultResp(Frame* frame, int32_t max_sample_rows) {
   ResultResp r;
   FrameBodyDecoder decoder(*frame);
   PL_ASSIGN_OR_RETURN(int32_t kind_raw, decoder.ExtractInt());
@@ -610,7 +627,7 @@ StatusOr<ResultResp> ParseResultResp(Frame* frame) {
       break;
     }
     case ResultRespKind::kRows: {
-      PL_ASSIGN_OR_RETURN(r.resp, ParseResultRows(&decoder));
+      PL_ASSIGN_OR_RETURN(r.resp, ParseResultRows(&decoder, max_sample_rows));
       break;
     }
     case ResultRespKind::kSetKeyspace: {
@@ -188,7 +188,9 @@ struct ResultVoidResp {};
 struct ResultRowsResp {
   ResultMetadata metadata;
   int32_t rows_count;
-  // Don't actually grab the row content for now.
+  // The first rows of the result, with one [bytes] value per column (null values are left
+  // empty). Only filled when a sample is requested; the other rows are never decoded.
+  std::vector<std::vector<std::basic_string<uint8_t>>> sample_rows;
 };
 
 struct ResultSetKeyspaceResp {
@@ -379,6 +381,9 @@ class FrameBodyDecoder {
   // with kind=prepared, then set prepared_result_metadata to true, so it parses correctly.
   StatusOr<ResultMetadata> ExtractResultMetadata(bool prepared_result_metadata = false);
 
+  // Extracts one row of a rows result, which is columns_count [bytes] values.
+  StatusOr<std::vector<std::basic_string<uint8_t>>> ExtractRow(int32_t columns_count);
+
   // Extracts a schema change response. See struct for details.
   StatusOr<SchemaChange> ExtractSchemaChange();
 
@@ -417,7 +422,10 @@ StatusOr<AuthenticateResp> ParseAuthenticateResp(Frame* frame);
 StatusOr<OptionsReq> ParseOptionsReq(Frame* frame);
 StatusOr<SupportedResp> ParseSupportedResp(Frame* frame);
 StatusOr<QueryReq> ParseQueryReq(Frame* frame);
-StatusOr<ResultResp> ParseResultResp(Frame* frame);
+// For a rows result, only the metadata and the row count are decoded, plus the first
+// max_sample_rows rows. The rest of the body is left untouched, so the cost does not grow
+// with the size of the result.
+StatusOr<ResultResp> ParseResultResp(Frame* frame, int32_t max_sample_rows = 0);
 StatusOr<PrepareReq> ParsePrepareReq(Frame* frame);
 StatusOr<ExecuteReq> ParseExecuteReq(Frame* frame);
 StatusOr<RegisterReq> ParseRegisterReq(Frame* frame);
@@ -155,6 +155,14 @@ constexpr uint8_t kResultPreparedMetadata[] = {
     0x02, 0x43, 0x32, 0x00, 0x05, 0x00, 0x02, 0x43, 0x33, 0x00, 0x05, 0x00, 0x02, 0x43, 0x34, 0x00,
     0x05, 0x00, 0x03, 0x6b, 0x65, 0x79, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04};
 
+// A rows result with columns (a varchar, b int) and 3 rows. Only the first 2 rows are present,
+// since the decoder should never reach the last one.
+constexpr uint8_t kResultRows[] = {
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x02, 0x6b,
+    0x73, 0x00, 0x01, 0x74, 0x00, 0x01, 0x61, 0x00, 0x0d, 0x00, 0x01, 0x62, 0x00, 0x09, 0x00,
+    0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02, 0x68, 0x69, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+    0x00, 0x2a, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x07};
+
 constexpr uint8_t kSchemaChange[]{0x00, 0x07, 0x44, 0x52, 0x4f, 0x50, 0x50, 0x45, 0x44, 0x00,
                                   0x05, 0x54, 0x41, 0x42, 0x4c, 0x45, 0x00, 0x0e, 0x74, 0x75,
                                   0x74, 0x6f, 0x72, 0x69, 0x61, 0x6c, 0x73, 0x70, 0x6f, 0x69,
@@ -751,6 +759,44 @@ TEST(ExtractResultMetdata, Prepared) {
   EXPECT_EQ(md.col_specs[5].type.type, DataType::kBlob);
 }
 
+//------------------------
+// ParseResultResp
+//------------------------
+
+TEST(ParseResultResp, RowsSkipped) {
+  Frame frame;
+  frame.hdr.version = 4;
+  frame.msg = CreateCharArrayView<char>(kResultRows);
+  ASSERT_OK_AND_ASSIGN(ResultResp r, ParseResultResp(&frame));
+
+  ASSERT_EQ(r.kind, ResultRespKind::kRows);
+  const auto& rows = std::get<ResultRowsResp>(r.resp);
+  EXPECT_EQ(rows.metadata.columns_count, 2);
+  ASSERT_EQ(rows.metadata.col_specs.size(), 2);
+  EXPECT_EQ(rows.metadata.col_specs[1].name, "b");
+  EXPECT_EQ(rows.rows_count, 3);
+  EXPECT_THAT(rows.sample_rows, IsEmpty());
+}
+
+TEST(ParseResultResp, RowsSampled) {
+  Frame frame;
+  frame.hdr.version = 4;
+  frame.msg = CreateCharArrayView<char>(kResultRows);
+  ASSERT_OK_AND_ASSIGN(ResultResp r, ParseResultResp(&frame, /* max_sample_rows */ 2));
+
+  const auto& rows = std::get<ResultRowsResp>(r.resp);
+  EXPECT_EQ(rows.rows_count, 3);
+  ASSERT_EQ(rows.sample_rows.size(), 2);
+  ASSERT_EQ(rows.sample_rows[0].size(), 2);
+  EXPECT_EQ(CreateStringView<char>(rows.sample_rows[0][0]), "hi");
+  EXPECT_EQ(CreateStringView<char>(rows.sample_rows[0][1]), ConstStringView("\x00\x00\x00\x2a"));
+  // A null value.
+  EXPECT_THAT(rows.sample_rows[1][0], IsEmpty());
+
+  // Asking for more rows than the body holds is an error.
+  EXPECT_NOT_OK(ParseResultResp(&frame, /* max_sample_rows */ 3));
+}
+
 //------------------------
 // ExtractSchemaChange
 //------------------------
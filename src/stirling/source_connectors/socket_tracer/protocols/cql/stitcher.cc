@@ -27,6 +27,10 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/cql/frame_body_decoder.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/cql/types.h"
 
+DEFINE_int32(stirling_cql_result_sample_rows, 0,
+             "The number of rows of a CQL rows result to decode and record with the response. "
+             "The other rows are skipped without being decoded.");
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -38,6 +42,36 @@ namespace {
 std::string BytesToString(std::basic_string_view<uint8_t> x) {
   return px::BytesToString<bytes_format::HexCompact>(CreateStringView<char>(x));
 }
+
+// Formats the value of a result cell. Only the simple types are decoded; the others are
+// shown as hex.
+std::string CellToString(DataType type, std::basic_string_view<uint8_t> cell) {
+  FrameBodyDecoder decoder(CreateStringView<char>(cell));
+  switch (type) {
+    case DataType::kAscii:
+    case DataType::kVarchar:
+      return std::string(CreateStringView<char>(cell));
+    case DataType::kInt: {
+      auto val = decoder.ExtractInt();
+      if (val.ok() && decoder.eof()) {
+        return std::to_string(val.ValueOrDie());
+      }
+      break;
+    }
+    case DataType::kBigint:
+    case DataType::kCounter:
+    case DataType::kTimestamp: {
+      auto val = decoder.ExtractLong();
+      if (val.ok() && decoder.eof()) {
+        return std::to_string(val.ValueOrDie());
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return BytesToString(cell);
+}
 }  // namespace
 
 Status ProcessStartupReq(Frame* req_frame, Request* req) {
@@ -211,7 +245,8 @@ Status ProcessAuthChallengeResp(Frame* resp_frame, Response* resp) {
 }
 
 Status ProcessResultResp(Frame* resp_frame, Response* resp) {
-  PL_ASSIGN_OR_RETURN(ResultResp r, ParseResultResp(resp_frame));
+  PL_ASSIGN_OR_RETURN(ResultResp r,
+                      ParseResultResp(resp_frame, FLAGS_stirling_cql_result_sample_rows));
 
   DCHECK(resp->msg.empty());
 
@@ -234,6 +269,21 @@ Status ProcessResultResp(Frame* resp_frame, Response* resp) {
       resp->msg = absl::StrCat("Response type = ROWS\n",
                                "Number of columns = ", r_resp.metadata.columns_count, "\n",
                                ToJSONString(names), "\n", "Number of rows = ", r_resp.rows_count);
+
+      if (!r_resp.sample_rows.empty()) {
+        // The column types are unknown if the server skipped the metadata.
+        const auto& col_specs = r_resp.metadata.col_specs;
+        std::vector<std::vector<std::string>> rows;
+        for (const auto& row : r_resp.sample_rows) {
+          std::vector<std::string> cells;
+          for (size_t i = 0; i < row.size(); ++i) {
+            DataType type = i < col_specs.size() ? col_specs[i].type.type : DataType::kBlob;
+            cells.push_back(CellToString(type, row[i]));
+          }
+          rows.push_back(std::move(cells));
+        }
+        absl::StrAppend(&resp->msg, "\n", "Sample rows = ", ToJSONString(rows));
+      }
       // TODO(oazizi): Consider which other parts of metadata would be interesting to record into
       // resp.
       break;
@@ -26,6 +26,8 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/cql/types.h"
 
+DECLARE_int32(stirling_cql_result_sample_rows);
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -18,13 +18,17 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/dns/stitcher.h"
 
+#include <absl/container/flat_hash_map.h>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
 #include <deque>
+#include <limits>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "src/common/base/base.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/dns/types.h"
@@ -172,66 +176,87 @@ StatusOr<Record> ProcessReqRespPair(const Frame& req_frame, const Frame& resp_fr
   return r;
 }
 
-// Currently StitchFrames() uses a response-led matching algorithm.
-// For each response that is at the head of the deque, there should exist a previous request with
-// the same txid. Find it, and consume both frames.
+// StitchFrames() uses a response-led matching algorithm. For each response, there should exist a
+// previous request with the same txid. Responses can come out-of-order, so the requests are
+// indexed by txid first, and each response finds its request with a lookup instead of a scan
+// of the request deque. Response frames don't keep their question, so only the txid is matched.
 RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
                                            std::deque<Frame>* resp_frames) {
   std::vector<Record> entries;
   int error_count = 0;
 
-  for (auto& resp_frame : *resp_frames) {
-    bool found_match = false;
-
-    // Search for matching req frame
-    for (auto& req_frame : *req_frames) {
-      // If the request timestamp is after the response, then it can't be the match.
-      // Nor can any subsequent requests either, so stop searching.
-      if (req_frame.timestamp_ns > resp_frame.timestamp_ns) {
-        break;
-      }
-
-      if (resp_frame.header.txid == req_frame.header.txid) {
-        StatusOr<Record> record_status = ProcessReqRespPair(req_frame, resp_frame);
-        if (record_status.ok()) {
-          entries.push_back(record_status.ConsumeValueOrDie());
-        } else {
-          VLOG(1) << record_status.ToString();
-          ++error_count;
-        }
-
-        // Found a match, so remove both request and response.
-        // We don't remove request frames on the fly, however,
-        // because it could otherwise cause unnecessary churn/copying in the deque.
-        // This is due to the fact that responses can come out-of-order.
-        // Just mark the request as consumed, and clean-up when they reach the head of the queue.
-        // Note that responses are always head-processed, so they don't require this optimization.
-        found_match = true;
-        resp_frames->pop_front();
-        req_frame.consumed = true;
-        break;
-      }
+  // Requests that share a txid (e.g. retries) are chained in order:
+  // req_index holds the position of the first one, and next_req holds the position of the next
+  // one after each request.
+  constexpr size_t kEndOfChain = std::numeric_limits<size_t>::max();
+  absl::flat_hash_map<uint16_t, size_t> req_index;
+  req_index.reserve(req_frames->size());
+  std::vector<size_t> next_req(req_frames->size(), kEndOfChain);
+  for (size_t i = req_frames->size(); i-- > 0;) {
+    const Frame& req_frame = (*req_frames)[i];
+    if (req_frame.consumed) {
+      continue;
     }
+    auto [iter, inserted] = req_index.try_emplace(req_frame.header.txid, i);
+    if (!inserted) {
+      next_req[i] = iter->second;
+      iter->second = i;
+    }
+  }
+
+  uint64_t latest_resp_timestamp_ns = 0;
 
-    if (!found_match) {
+  for (const auto& resp_frame : *resp_frames) {
+    latest_resp_timestamp_ns = std::max(latest_resp_timestamp_ns, resp_frame.timestamp_ns);
+
+    // The first request in the chain is the oldest one. If it is after the response, then it
+    // can't be the match, nor can any of the later ones.
+    auto iter = req_index.find(resp_frame.header.txid);
+    if (iter == req_index.end() ||
+        (*req_frames)[iter->second].timestamp_ns > resp_frame.timestamp_ns) {
       VLOG(1) << absl::Substitute("Did not find a request matching the response. TXID = $0",
                                   resp_frame.header.txid);
       ++error_count;
+      continue;
+    }
+
+    size_t req_pos = iter->second;
+    if (next_req[req_pos] == kEndOfChain) {
+      req_index.erase(iter);
+    } else {
+      iter->second = next_req[req_pos];
     }
 
-    // Clean-up consumed frames at the head.
-    // Do this inside the resp loop to aggressively clean-out req_frames whenever a frame consumed.
-    // Should speed up the req_frames search for the next iteration.
-    for (auto& req_frame : *req_frames) {
-      if (!req_frame.consumed) {
-        break;
-      }
-      req_frames->pop_front();
+    Frame& req_frame = (*req_frames)[req_pos];
+    StatusOr<Record> record_status = ProcessReqRespPair(req_frame, resp_frame);
+    if (record_status.ok()) {
+      entries.push_back(record_status.ConsumeValueOrDie());
+    } else {
+      VLOG(1) << record_status.ToString();
+      ++error_count;
     }
 
-    // TODO(oazizi): Consider removing requests that are too old, otherwise a lost response can mean
-    // the are never processed. This would result in a memory leak until the more drastic connection
-    // tracker clean-up mechanisms kick in.
+    // We don't remove request frames on the fly, because it could otherwise cause unnecessary
+    // churn/copying in the deque. Just mark the request as consumed, and clean-up when they reach
+    // the head of the queue.
+    req_frame.consumed = true;
+  }
+  resp_frames->clear();
+
+  // Clean-up consumed frames at the head, as well as requests that are too old to still get a
+  // response. Otherwise a lost response would keep its request, and all the ones after it,
+  // around until the connection tracker is cleaned up.
+  auto is_expired = [latest_resp_timestamp_ns](const Frame& req_frame) {
+    return req_frame.timestamp_ns + kMaxPendingReqAge.count() < latest_resp_timestamp_ns;
+  };
+  while (!req_frames->empty() &&
+         (req_frames->front().consumed || is_expired(req_frames->front()))) {
+    if (!req_frames->front().consumed) {
+      VLOG(1) << absl::Substitute("Dropping a request that never got a response. TXID = $0",
+                                  req_frames->front().header.txid);
+      ++error_count;
+    }
+    req_frames->pop_front();
   }
 
   return {entries, error_count};
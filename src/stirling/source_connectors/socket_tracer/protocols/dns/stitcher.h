@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <deque>
 #include <map>
 #include <string>
@@ -31,6 +32,10 @@ namespace stirling {
 namespace protocols {
 namespace dns {
 
+// Requests still waiting for a response this long after a later response are dropped.
+// Resolvers give up after a few seconds, so these never get a response.
+constexpr std::chrono::nanoseconds kMaxPendingReqAge = std::chrono::seconds(10);
+
 /**
  * StitchFrames is the entry point of the DNS Stitcher.
  *
@@ -173,6 +173,59 @@ TEST(DnsStitcherTest, OutOfOrderMatching) {
   EXPECT_EQ(result.records.size(), 0);
 }
 
+TEST(DnsStitcherTest, RepeatedTxid) {
+  std::deque<Frame> req_frames;
+  std::deque<Frame> resp_frames;
+  RecordsWithErrorCount<Record> result;
+
+  // A retry reuses the txid of the first request, and the responses match them in order.
+  req_frames.push_back(CreateReqFrame(1, 7));
+  req_frames.push_back(CreateReqFrame(2, 8));
+  req_frames.push_back(CreateReqFrame(3, 7));
+  resp_frames.push_back(CreateRespFrame(4, 7, {}));
+  resp_frames.push_back(CreateRespFrame(5, 7, {}));
+
+  result = StitchFrames(&req_frames, &resp_frames);
+  EXPECT_TRUE(resp_frames.empty());
+  EXPECT_EQ(req_frames.size(), 2);
+  EXPECT_EQ(result.error_count, 0);
+  ASSERT_EQ(result.records.size(), 2);
+  EXPECT_EQ(result.records[0].req.timestamp_ns, 1);
+  EXPECT_EQ(result.records[1].req.timestamp_ns, 3);
+
+  // A response for which there is no request is dropped.
+  resp_frames.push_back(CreateRespFrame(6, 9, {}));
+  resp_frames.push_back(CreateRespFrame(7, 8, {}));
+
+  result = StitchFrames(&req_frames, &resp_frames);
+  EXPECT_TRUE(resp_frames.empty());
+  EXPECT_THAT(req_frames, IsEmpty());
+  EXPECT_EQ(result.error_count, 1);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_EQ(result.records[0].req.timestamp_ns, 2);
+}
+
+TEST(DnsStitcherTest, ExpireLostRequests) {
+  std::deque<Frame> req_frames;
+  std::deque<Frame> resp_frames;
+  RecordsWithErrorCount<Record> result;
+
+  const uint64_t kMaxAgeNs = kMaxPendingReqAge.count();
+
+  req_frames.push_back(CreateReqFrame(1, 0));
+  req_frames.push_back(CreateReqFrame(2, 1));
+  req_frames.push_back(CreateReqFrame(kMaxAgeNs, 2));
+  resp_frames.push_back(CreateRespFrame(kMaxAgeNs + 2, 1, {}));
+
+  // The request with txid 0 is too old to still get a response, but the one with txid 2 is not.
+  result = StitchFrames(&req_frames, &resp_frames);
+  EXPECT_TRUE(resp_frames.empty());
+  ASSERT_EQ(req_frames.size(), 1);
+  EXPECT_EQ(req_frames.front().header.txid, 2);
+  EXPECT_EQ(result.error_count, 1);
+  EXPECT_EQ(result.records.size(), 1);
+}
+
 }  // namespace dns
 }  // namespace protocols
 }  // namespace stirling
@@ -21,9 +21,12 @@
 #include <picohttpparser.h>
 
 #include <algorithm>
+#include <array>
 #include <string>
 #include <utility>
 
+#include <absl/strings/match.h>
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -223,8 +226,8 @@ ParseState ParseRequest(std::string_view* buf, Message* result) {
     result->type = MessageType::kRequest;
     result->minor_version = minor_version;
     result->headers = GetHTTPHeadersMap(headers, num_headers);
-    result->req_method = std::string(method, method_len);
-    result->req_path = std::string(path, path_len);
+    result->req_method.assign(method, method_len);
+    result->req_path.assign(path, path_len);
     result->headers_byte_size = retval;
 
     return ParseBody(buf, result);
@@ -256,7 +259,7 @@ ParseState ParseResponse(std::string_view* buf, Message* result) {
     result->minor_version = minor_version;
     result->headers = GetHTTPHeadersMap(headers, num_headers);
     result->resp_status = status;
-    result->resp_message = std::string(msg, msg_len);
+    result->resp_message.assign(msg, msg_len);
     result->headers_byte_size = retval;
 
     return ParseBody(buf, result);
@@ -290,6 +293,33 @@ ParseState ParseFrame(MessageType type, std::string_view* buf, Message* result)
   }
 }
 
+namespace {
+
+// Returns the position of the last occurrence of any of the patterns in buf, or npos.
+// This is a single backwards pass over buf, which only compares the patterns at the bytes that
+// can start one of them, instead of an rfind() over the whole of buf for each pattern.
+size_t FindLastStartPattern(std::string_view buf, const ArrayView<std::string_view>& patterns) {
+  std::array<bool, 256> first_chars = {};
+  for (const auto& pattern : patterns) {
+    first_chars[static_cast<uint8_t>(pattern.front())] = true;
+  }
+
+  for (size_t pos = buf.size(); pos-- > 0;) {
+    if (!first_chars[static_cast<uint8_t>(buf[pos])]) {
+      continue;
+    }
+    std::string_view tail = buf.substr(pos);
+    for (const auto& pattern : patterns) {
+      if (absl::StartsWith(tail, pattern)) {
+        return pos;
+      }
+    }
+  }
+  return std::string::npos;
+}
+
+}  // namespace
+
 // TODO(oazizi/yzhao): This function should use is_http_{response,request} inside
 // bcc_bpf/socket_trace.c to check if a sequence of bytes are aligned on HTTP message boundary.
 // ATM, they actually do not share the same logic. As a result, BPF events detected as HTTP traffic,
@@ -346,17 +376,9 @@ size_t FindFrameBoundary(MessageType type, std::string_view buf, size_t start_po
 
     std::string_view buf_substr = buf.substr(start_pos, marker_pos - start_pos);
 
-    size_t substr_pos = std::string::npos;
-    for (auto& start_pattern : *start_patterns) {
-      size_t current_substr_pos = buf_substr.rfind(start_pattern);
-      if (current_substr_pos != std::string::npos) {
-        // Found a match. Check if it is closer to the marker than our previous match.
-        // We want to return the match that is closest to the marker, so we aren't
-        // matching to something in a previous message's body.
-        substr_pos = (substr_pos == std::string::npos) ? current_substr_pos
-                                                       : std::max(substr_pos, current_substr_pos);
-      }
-    }
+    // We want the match that is closest to the marker, so we aren't matching to something in a
+    // previous message's body.
+    size_t substr_pos = FindLastStartPattern(buf_substr, *start_patterns);
 
     if (substr_pos != std::string::npos) {
       return start_pos + substr_pos;
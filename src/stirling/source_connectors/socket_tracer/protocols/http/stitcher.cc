@@ -19,7 +19,6 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
 
 #include <deque>
-#include <limits>
 #include <string>
 #include <utility>
 
@@ -43,7 +42,7 @@ namespace stirling {
 namespace protocols {
 namespace http {
 
-void PreProcessMessage(Message* message) {
+void PreProcessMessage(Message* message, size_t max_body_bytes) {
   // Parse the flags on the first time only.
   static const HTTPHeaderFilter kHTTPResponseHeaderFilter =
       ParseHTTPHeaderFilters(FLAGS_http_response_header_filters);
@@ -66,16 +65,37 @@ void PreProcessMessage(Message* message) {
 
   auto content_encoding_iter = message->headers.find(kContentEncoding);
   // Replace body with decompressed version, if required.
-  if (content_encoding_iter != message->headers.end() && content_encoding_iter->second == "gzip") {
-    std::string_view body_strview(message->body);
-    auto bodyOrErr = px::zlib::Inflate(body_strview);
-    if (!bodyOrErr.ok()) {
-      LOG(WARNING) << "Unable to gunzip HTTP body.";
-      message->body = "<Failed to gunzip body>";
-    } else {
-      message->body = bodyOrErr.ValueOrDie();
+  if (content_encoding_iter == message->headers.end() || content_encoding_iter->second != "gzip") {
+    return;
+  }
+
+  // Large bodies are truncated when they are recorded, so only decompress what is going to be
+  // kept, instead of inflating the whole body first. The bodies are decompressed with the same
+  // zlib stream into the same buffer, and then copied into the memory of the compressed body,
+  // which is reused whenever it is large enough.
+  constexpr size_t kMaxKeptBufferSize = 1024 * 1024;
+  thread_local std::string body;
+  std::string_view body_strview(message->body);
+  StatusOr<bool> complete_or_err =
+      px::zlib::ThreadLocalInflater().Inflate(body_strview, max_body_bytes, &body);
+  if (!complete_or_err.ok()) {
+    LOG(WARNING) << "Unable to gunzip HTTP body.";
+    message->body = "<Failed to gunzip body>";
+    return;
+  }
+
+  if (!complete_or_err.ValueOrDie()) {
+    StatusOr<size_t> body_size = px::zlib::GzipDecompressedSize(body_strview);
+    if (body_size.ok() && body_size.ValueOrDie() > body.size()) {
+      message->body_truncated = true;
+      message->body_size = body_size.ValueOrDie();
     }
   }
+  message->body.assign(body);
+  if (body.capacity() > kMaxKeptBufferSize) {
+    // Don't hold on to the memory of an unusually large body.
+    std::string().swap(body);
+  }
 }
 
 }  // namespace http
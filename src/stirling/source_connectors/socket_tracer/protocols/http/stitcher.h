@@ -19,6 +19,7 @@
 #pragma once
 
 #include <deque>
+#include <limits>
 #include <map>
 #include <string>
 #include <vector>
@@ -45,7 +46,13 @@ namespace http {
 RecordsWithErrorCount<Record> ProcessMessages(std::deque<Message>* req_messages,
                                               std::deque<Message>* resp_messages);
 
-void PreProcessMessage(Message* message);
+/**
+ * Filters out the bodies of messages with uninteresting content types, and decompresses gzip
+ * bodies. Only the first max_body_bytes of a compressed body are decompressed; the rest is
+ * skipped and the message is marked as truncated.
+ */
+void PreProcessMessage(Message* message,
+                       size_t max_body_bytes = std::numeric_limits<size_t>::max());
 
 }  // namespace http
 
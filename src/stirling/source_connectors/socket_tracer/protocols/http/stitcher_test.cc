@@ -19,6 +19,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+
+#include "src/common/testing/testing.h"
+#include "src/common/zlib/zlib_wrapper.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
 
 namespace px {
@@ -44,6 +48,31 @@ TEST(PreProcessRecordTest, GzipCompressedContentIsDecompressed) {
   EXPECT_EQ("This is a test\n", message.body);
 }
 
+TEST(PreProcessRecordTest, GzipCompressedContentIsTruncated) {
+  std::string body;
+  for (int i = 0; i < 10000; ++i) {
+    absl::StrAppend(&body, "{\"i\":", i, "}");
+  }
+
+  Message message;
+  message.type = MessageType::kResponse;
+  message.headers.insert({kContentEncoding, "gzip"});
+  message.headers.insert({kContentType, "json"});
+  ASSERT_OK_AND_ASSIGN(message.body, px::zlib::Deflate(body));
+  PreProcessMessage(&message, 100);
+  EXPECT_EQ(message.body, body.substr(0, 100));
+  EXPECT_TRUE(message.body_truncated);
+  EXPECT_EQ(message.BodySize(), body.size());
+
+  // A body that fits is not marked as truncated.
+  ASSERT_OK_AND_ASSIGN(message.body, px::zlib::Deflate(body.substr(0, 50)));
+  message.body_truncated = false;
+  PreProcessMessage(&message, 100);
+  EXPECT_EQ(message.body, body.substr(0, 50));
+  EXPECT_FALSE(message.body_truncated);
+  EXPECT_EQ(message.BodySize(), 50);
+}
+
 TEST(PreProcessRecordTest, ContentHeaderIsNotAdded) {
   Message message;
   message.type = MessageType::kResponse;
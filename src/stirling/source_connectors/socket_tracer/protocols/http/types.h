@@ -60,6 +60,14 @@ struct Message : public FrameBase {
 
   std::string body = "-";
 
+  // Set when body only holds a prefix of the message body, eg. because a compressed body was only
+  // partly decompressed. body_size is then the size of the whole body.
+  bool body_truncated = false;
+  size_t body_size = 0;
+
+  // The size of the whole body, before any truncation.
+  size_t BodySize() const { return body_truncated ? body_size : body.size(); }
+
   // The number of bytes in the HTTP header, used in ByteSize(),
   // as an approximation of the size of the non-body fields.
   size_t headers_byte_size = 0;
@@ -68,6 +76,23 @@ struct Message : public FrameBase {
     return sizeof(Message) + headers_byte_size + body.size() + resp_message.size();
   }
 
+  // Clears the message back to its default state, keeping the buffers of its strings, for the
+  // message to be parsed into again (see protocols::FramePool).
+  void Reset() {
+    timestamp_ns = 0;
+    type = MessageType::kUnknown;
+    minor_version = -1;
+    headers.clear();
+    req_method.assign("-");
+    req_path.assign("-");
+    resp_status = -1;
+    resp_message.assign("-");
+    body.assign("-");
+    body_truncated = false;
+    body_size = 0;
+    headers_byte_size = 0;
+  }
+
   std::string ToString() const {
     return absl::Substitute(
         "[type=$0 minor_version=$1 headers=[$2] req_method=$3 "
@@ -46,6 +46,29 @@ TEST(HTTPHeadersMap, CaseInsensitivity) {
   }
 }
 
+TEST(MessageTest, ResetRestoresDefaults) {
+  Message message;
+  message.timestamp_ns = 100;
+  message.type = MessageType::kResponse;
+  message.minor_version = 1;
+  message.headers = {{"Content-Type", "application/json"}};
+  message.resp_status = 200;
+  message.resp_message = "OK";
+  message.body = std::string(1000, 'x');
+  message.body_truncated = true;
+  message.body_size = 2000;
+  message.headers_byte_size = 30;
+
+  message.Reset();
+  EXPECT_EQ(message.timestamp_ns, 0);
+  EXPECT_EQ(message.ToString(), Message().ToString());
+  EXPECT_FALSE(message.body_truncated);
+  EXPECT_EQ(message.body_size, 0);
+  EXPECT_EQ(message.headers_byte_size, 0);
+  // The buffer of the body is kept for the next message parsed into it.
+  EXPECT_GE(message.body.capacity(), 1000);
+}
+
 }  // namespace http
 }  // namespace protocols
 }  // namespace stirling
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/frame_decoder.h"
+
+#include <string_view>
+#include <utility>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+namespace {
+
+// Returns the payload of the frame without its padding, and without the fields that precede
+// the header block fragment in HEADERS and PUSH_PROMISE frames.
+// https://httpwg.org/specs/rfc7540.html#FrameTypes
+StatusOr<std::string_view> FramePayload(const Frame& frame) {
+  std::string_view payload = frame.payload;
+
+  if (frame.flags & frame_flags::kPadded) {
+    if (payload.empty()) {
+      return error::InvalidArgument("Missing pad length.");
+    }
+    const size_t pad_length = static_cast<uint8_t>(payload.front());
+    payload.remove_prefix(1);
+    if (pad_length > payload.size()) {
+      return error::InvalidArgument("Pad length $0 is larger than the payload $1.", pad_length,
+                                    payload.size());
+    }
+    payload.remove_suffix(pad_length);
+  }
+
+  size_t skip = 0;
+  if (frame.type == FrameType::kHeaders && (frame.flags & frame_flags::kPriority)) {
+    // Stream dependency and weight.
+    skip = 5;
+  } else if (frame.type == FrameType::kPushPromise) {
+    // Promised stream ID.
+    skip = 4;
+  }
+  if (skip > payload.size()) {
+    return error::InvalidArgument("Frame payload is too short.");
+  }
+  payload.remove_prefix(skip);
+
+  return payload;
+}
+
+}  // namespace
+
+void FrameDecoder::Decode(const std::deque<Frame>& frames, const HalfStreamFn& half_stream_fn) {
+  for (const Frame& frame : frames) {
+    if (frame.data_loss) {
+      MarkDataLoss();
+      continue;
+    }
+
+    // A header block must be followed by its CONTINUATION frames, with nothing in between.
+    if (header_block_pending_ && (frame.type != FrameType::kContinuation ||
+                                  frame.stream_id != header_block_stream_id_)) {
+      VLOG(1) << "Missing CONTINUATION frame of header block.";
+      MarkDataLoss();
+    }
+
+    StatusOr<std::string_view> payload_or = FramePayload(frame);
+    if (!payload_or.ok()) {
+      VLOG(1) << absl::Substitute("Invalid frame: $0 $1", payload_or.msg(), frame.ToString());
+      // Any missing header block leaves the HPACK decoder out of sync.
+      if (frame.type != FrameType::kData) {
+        MarkDataLoss();
+      }
+      continue;
+    }
+    std::string_view payload = payload_or.ValueOrDie();
+
+    switch (frame.type) {
+      case FrameType::kData: {
+        HalfStream* half_stream = half_stream_fn(frame.stream_id);
+        half_stream->AddData(payload);
+        if (frame.flags & frame_flags::kEndStream) {
+          half_stream->AddEndStream();
+        }
+        half_stream->UpdateTimestamp(frame.timestamp_ns);
+      } break;
+      case FrameType::kHeaders:
+      case FrameType::kPushPromise:
+        header_block_.assign(payload);
+        header_block_pending_ = true;
+        header_block_stream_id_ = frame.stream_id;
+        header_block_end_stream_ = (frame.flags & frame_flags::kEndStream) != 0;
+        header_block_push_promise_ = (frame.type == FrameType::kPushPromise);
+        header_block_timestamp_ns_ = frame.timestamp_ns;
+        if (frame.flags & frame_flags::kEndHeaders) {
+          DecodeHeaderBlock(half_stream_fn);
+        }
+        break;
+      case FrameType::kContinuation:
+        if (!header_block_pending_) {
+          // The start of the header block was lost, MarkDataLoss() was already called.
+          continue;
+        }
+        header_block_.append(payload);
+        if (frame.flags & frame_flags::kEndHeaders) {
+          DecodeHeaderBlock(half_stream_fn);
+        }
+        break;
+      default:
+        // The other frames are dropped by ParseFrame().
+        break;
+    }
+  }
+}
+
+void FrameDecoder::DecodeHeaderBlock(const HalfStreamFn& half_stream_fn) {
+  header_block_pending_ = false;
+
+  NVMap headers;
+  Status s = hpack_decoder_.Decode(header_block_, &headers);
+  header_block_.clear();
+  if (!s.ok()) {
+    VLOG(1) << absl::Substitute("Failed to decode header block of stream $0: $1",
+                                header_block_stream_id_, s.msg());
+  }
+
+  // The headers of a PUSH_PROMISE belong to a request the client never sent. The block is
+  // only decoded to keep the dynamic table up to date.
+  if (header_block_push_promise_) {
+    return;
+  }
+
+  HalfStream* half_stream = half_stream_fn(header_block_stream_id_);
+  for (auto& [name, value] : headers) {
+    half_stream->AddHeader(name, std::move(value));
+  }
+  if (header_block_end_stream_) {
+    half_stream->AddEndStream();
+  }
+  half_stream->UpdateTimestamp(header_block_timestamp_ns_);
+}
+
+void FrameDecoder::MarkDataLoss() {
+  hpack_decoder_.MarkDataLoss();
+  header_block_.clear();
+  header_block_pending_ = false;
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <string>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/hpack.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/types.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+/**
+ * FrameDecoder decodes the frames sent in one direction of an HTTP/2 connection into the
+ * HalfStreams of the connection's streams.
+ *
+ * This is how the HTTP/2 traffic captured by the kprobes, ie. the traffic of the applications
+ * that are not traced by the Go uprobes, ends up in the same Streams as the uprobe events.
+ */
+class FrameDecoder {
+ public:
+  using HalfStreamFn = std::function<HalfStream*(uint32_t stream_id)>;
+
+  /**
+   * Decodes the frames in order, and adds their headers and data to the HalfStreams returned
+   * by half_stream_fn.
+   */
+  void Decode(const std::deque<Frame>& frames, const HalfStreamFn& half_stream_fn);
+
+  /**
+   * Signals that some frames were lost. See HPACKDecoder::MarkDataLoss().
+   */
+  void MarkDataLoss();
+
+  const HPACKDecoder& hpack_decoder() const { return hpack_decoder_; }
+
+ private:
+  void DecodeHeaderBlock(const HalfStreamFn& half_stream_fn);
+
+  HPACKDecoder hpack_decoder_;
+
+  // The header block of a HEADERS or PUSH_PROMISE frame, until its last CONTINUATION frame.
+  std::string header_block_;
+  bool header_block_pending_ = false;
+  uint32_t header_block_stream_id_ = 0;
+  bool header_block_end_stream_ = false;
+  bool header_block_push_promise_ = false;
+  uint64_t header_block_timestamp_ns_ = 0;
+};
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/frame_decoder.h"
+
+#include <deque>
+#include <string>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/http2_streams_container.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+using ::testing::IsEmpty;
+using ::testing::Pair;
+using ::testing::StrEq;
+using ::testing::UnorderedElementsAre;
+
+Frame MakeFrame(FrameType type, uint8_t flags, uint32_t stream_id, std::string payload,
+                uint64_t timestamp_ns = 0) {
+  Frame frame;
+  frame.type = type;
+  frame.flags = flags;
+  frame.stream_id = stream_id;
+  frame.payload = std::move(payload);
+  frame.timestamp_ns = timestamp_ns;
+  return frame;
+}
+
+Frame DataLossFrame() {
+  Frame frame;
+  frame.data_loss = true;
+  return frame;
+}
+
+class FrameDecoderTest : public ::testing::Test {
+ protected:
+  void Decode(std::deque<Frame> frames) {
+    decoder_.Decode(frames, [this](uint32_t stream_id) {
+      return streams_.HalfStreamPtr(stream_id, /*write_event*/ true);
+    });
+  }
+
+  const HalfStream& half_stream(uint32_t stream_id) {
+    const Stream* stream = streams_.FindStream(stream_id);
+    CHECK(stream != nullptr);
+    return stream->send;
+  }
+
+  FrameDecoder decoder_;
+  HTTP2StreamsContainer streams_;
+};
+
+TEST_F(FrameDecoderTest, HeadersAndData) {
+  // :method GET, :scheme http, :path /, :authority www.example.com.
+  const std::string kHeaderBlock = "\x82\x86\x84\x41\x0f" "www.example.com";
+
+  Decode({MakeFrame(FrameType::kHeaders, frame_flags::kEndHeaders, 1, kHeaderBlock, 100),
+          MakeFrame(FrameType::kData, 0, 1, "hello ", 200),
+          MakeFrame(FrameType::kData, frame_flags::kEndStream, 1, "world", 300)});
+
+  const HalfStream& req = half_stream(1);
+  EXPECT_THAT(req.headers(), UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "http"),
+                                                  Pair(":path", "/"),
+                                                  Pair(":authority", "www.example.com")));
+  EXPECT_THAT(req.data(), StrEq("hello world"));
+  EXPECT_TRUE(req.end_stream());
+  EXPECT_EQ(req.timestamp_ns, 100);
+}
+
+TEST_F(FrameDecoderTest, ContinuationAndPadding) {
+  // Padded, with priority: pad length 2, stream dependency and weight, then :method GET.
+  std::string headers("\x02\x00\x00\x00\x03\x10\x82\x00\x00", 9);
+  Decode({MakeFrame(FrameType::kHeaders,
+                    frame_flags::kPadded | frame_flags::kPriority | frame_flags::kEndStream, 1,
+                    headers),
+          MakeFrame(FrameType::kContinuation, frame_flags::kEndHeaders, 1, "\x84")});
+
+  const HalfStream& req = half_stream(1);
+  EXPECT_THAT(req.headers(), UnorderedElementsAre(Pair(":method", "GET"), Pair(":path", "/")));
+  EXPECT_THAT(req.data(), IsEmpty());
+  EXPECT_TRUE(req.end_stream());
+}
+
+TEST_F(FrameDecoderTest, DataLoss) {
+  // Adds custom-key: custom-value to the dynamic table.
+  const std::string kHeaderBlock = "\x40\x0a" "custom-key" "\x0c" "custom-value";
+  Decode({MakeFrame(FrameType::kHeaders, frame_flags::kEndHeaders, 1, kHeaderBlock)});
+  ASSERT_THAT(half_stream(1).headers(), UnorderedElementsAre(Pair("custom-key", "custom-value")));
+
+  // After the loss, the reference to the dynamic table entry cannot be resolved.
+  Decode({DataLossFrame(),
+          MakeFrame(FrameType::kHeaders, frame_flags::kEndHeaders, 3, "\x82\xbe")});
+  EXPECT_THAT(half_stream(3).headers(), UnorderedElementsAre(Pair(":method", "GET")));
+  EXPECT_FALSE(decoder_.hpack_decoder().in_sync());
+  EXPECT_EQ(decoder_.hpack_decoder().num_unresolved_fields(), 1);
+}
+
+TEST_F(FrameDecoderTest, MissingContinuation) {
+  Decode({MakeFrame(FrameType::kHeaders, 0, 1, "\x82"),
+          MakeFrame(FrameType::kData, frame_flags::kEndStream, 1, "hello")});
+
+  const HalfStream& req = half_stream(1);
+  EXPECT_THAT(req.headers(), IsEmpty());
+  EXPECT_THAT(req.data(), StrEq("hello"));
+  EXPECT_FALSE(decoder_.hpack_decoder().in_sync());
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -22,6 +22,11 @@
 
 #include <google/protobuf/empty.pb.h>
 #include <google/protobuf/text_format.h>
+#include <google/protobuf/util/json_util.h>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_replace.h>
+#include <absl/strings/strip.h>
 
 #include "src/common/base/base.h"
 #include "src/stirling/utils/binary_decoder.h"
@@ -31,8 +36,12 @@ namespace stirling {
 namespace grpc {
 
 using ::google::protobuf::Empty;
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::FileDescriptorSet;
 using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
 using ::google::protobuf::TextFormat;
+using ::px::grpc::MethodPrototypes;
 
 namespace {
 
@@ -53,11 +62,11 @@ Status PBWireToText(std::string_view message, TextFormat::Printer* pb_printer, s
   return Status::OK();
 }
 
-// Parses the gRPC payload into text format protobuf. In addition to parsing protobuf messages, this
-// function extracts compression and length field, and also handles multiple concatenated payloads
-// as well.
-Status GRPCPBWireToText(std::string_view message, std::string* text,
-                        std::optional<int> str_truncation_len) {
+// Calls fn on each of the length-prefixed protobuf messages of a gRPC payload; the payload may
+// hold several concatenated ones. Stops early if fn returns false.
+// Returns the status of the last call to fn, or an error if the payload is malformed.
+template <typename TFn>
+Status ForEachGRPCMessage(std::string_view message, TFn fn) {
   if (message.size() < kGRPCMessageHeaderSizeInBytes) {
     return error::InvalidArgument(
         "The gRPC message does not have enough data. "
@@ -67,9 +76,6 @@ Status GRPCPBWireToText(std::string_view message, std::string* text,
 
   BinaryDecoder decoder(message);
 
-  TextFormat::Printer pb_printer;
-  pb_printer.SetTruncateStringFieldLongerThan(str_truncation_len.value_or(0));
-
   Status status;
 
   while (!decoder.eof()) {
@@ -82,18 +88,77 @@ Status GRPCPBWireToText(std::string_view message, std::string* text,
     PL_ASSIGN_OR_RETURN(std::string_view data, decoder.ExtractString<char>(std::min(
                                                    static_cast<size_t>(len), decoder.BufSize())));
 
-    std::string pb_str;
     // Include the most recent status.
-    status = PBWireToText(data, &pb_printer, &pb_str);
+    if (!fn(data, &status)) {
+      break;
+    }
+  }
+  return status;
+}
 
+// Parses the gRPC payload into text format protobuf. In addition to parsing protobuf messages, this
+// function extracts compression and length field, and also handles multiple concatenated payloads
+// as well.
+Status GRPCPBWireToText(std::string_view message, std::string* text,
+                        std::optional<int> str_truncation_len) {
+  TextFormat::Printer pb_printer;
+  pb_printer.SetTruncateStringFieldLongerThan(str_truncation_len.value_or(0));
+
+  return ForEachGRPCMessage(message, [&](std::string_view data, Status* status) {
+    std::string pb_str;
+    *status = PBWireToText(data, &pb_printer, &pb_str);
     text->append(pb_str);
+    return true;
+  });
+}
+
+// Truncates the string and bytes fields of the message, and of its sub-messages, like
+// TextFormat::Printer::SetTruncateStringFieldLongerThan() does when printing. The suffix has no
+// '<' or '>', which the JSON printer would escape.
+void TruncateStringFields(Message* pb, size_t len) {
+  constexpr std::string_view kTruncatedSuffix = "...[truncated]...";
+
+  const Reflection* reflection = pb->GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(*pb, &fields);
+  for (const FieldDescriptor* field : fields) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_STRING: {
+        auto truncate = [&](const std::string& str) {
+          return absl::StrCat(std::string_view(str).substr(0, len), kTruncatedSuffix);
+        };
+        if (field->is_repeated()) {
+          for (int i = 0; i < reflection->FieldSize(*pb, field); ++i) {
+            const std::string& str = reflection->GetRepeatedStringReference(*pb, field, i, nullptr);
+            if (str.size() > len) {
+              reflection->SetRepeatedString(pb, field, i, truncate(str));
+            }
+          }
+        } else {
+          const std::string& str = reflection->GetStringReference(*pb, field, nullptr);
+          if (str.size() > len) {
+            reflection->SetString(pb, field, truncate(str));
+          }
+        }
+        break;
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        if (field->is_repeated()) {
+          for (int i = 0; i < reflection->FieldSize(*pb, field); ++i) {
+            TruncateStringFields(reflection->MutableRepeatedMessage(pb, field, i), len);
+          }
+        } else {
+          TruncateStringFields(reflection->MutableMessage(pb, field), len);
+        }
+        break;
+      default:
+        break;
+    }
   }
-  return status;
 }
 
 }  // namespace
 
-// TODO(yzhao): Support reflection to get message types instead of empty message.
 std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len) {
   std::string text;
   Status s = GRPCPBWireToText(str, &text, str_truncation_len);
@@ -104,6 +169,96 @@ std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len)
   return text;
 }
 
+std::string ParsePBToJSON(std::string_view str, const Message& prototype,
+                          std::optional<int> str_truncation_len, size_t max_len) {
+  std::unique_ptr<Message> pb(prototype.New());
+  return ParsePBToJSON(str, pb.get(), str_truncation_len, max_len);
+}
+
+std::string ParsePBToJSON(std::string_view str, Message* pb, std::optional<int> str_truncation_len,
+                          size_t max_len) {
+  google::protobuf::util::JsonPrintOptions options;
+  options.preserve_proto_field_names = true;
+
+  std::string text;
+  Status s = ForEachGRPCMessage(str, [&](std::string_view data, Status* status) {
+    pb->Clear();
+    // Print whatever could be parsed, like PBWireToText() does.
+    const bool parse_succeeded = pb->ParsePartialFromArray(data.data(), data.size());
+    if (str_truncation_len.has_value()) {
+      TruncateStringFields(pb, str_truncation_len.value());
+    }
+    std::string json;
+    const bool print_succeeded =
+        google::protobuf::util::MessageToJsonString(*pb, &json, options).ok();
+    if (!parse_succeeded) {
+      *status = error::InvalidArgument("Failed to parse the serialized protobuf message");
+    } else if (!print_succeeded) {
+      *status = error::InvalidArgument("Failed to print protobuf message to JSON");
+    } else {
+      *status = Status::OK();
+    }
+    if (print_succeeded) {
+      if (!text.empty()) {
+        text.append("\n");
+      }
+      text.append(json);
+    }
+    return text.size() < max_len;
+  });
+  if (!s.ok() && text.empty()) {
+    return "<Failed to parse protobuf>";
+  }
+  return text;
+}
+
+StatusOr<std::unique_ptr<GRPCMethodRegistry>> GRPCMethodRegistry::CreateFromFiles(
+    const std::vector<std::string>& paths) {
+  FileDescriptorSet fdset;
+  for (const auto& path : paths) {
+    PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(path, std::ios_base::binary));
+    FileDescriptorSet file_fdset;
+    if (!file_fdset.ParseFromString(contents)) {
+      return error::InvalidArgument("$0 is not a serialized FileDescriptorSet.", path);
+    }
+    fdset.MergeFrom(file_fdset);
+  }
+  return std::make_unique<GRPCMethodRegistry>(std::move(fdset));
+}
+
+MethodPrototypes GRPCMethodRegistry::Lookup(std::string_view path) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = methods_.find(path);
+  if (iter == methods_.end()) {
+    // The path is /<package>.<service>/<method>, and the method is named
+    // <package>.<service>.<method> in the descriptors.
+    std::string_view method_path = path;
+    absl::ConsumePrefix(&method_path, "/");
+    MethodPrototypes method =
+        desc_db_.GetMethodPrototypes(absl::StrReplaceAll(method_path, {{"/", "."}}));
+    if (method.input == nullptr || method.output == nullptr) {
+      if (num_unknown_paths_ >= kMaxUnknownPaths) {
+        return {};
+      }
+      ++num_unknown_paths_;
+    }
+    iter = methods_.emplace(path, method).first;
+  }
+  const MethodPrototypes& method = iter->second;
+  return method.input != nullptr && method.output != nullptr ? method : MethodPrototypes{};
+}
+
+std::string GRPCMethodRegistry::ParsePBToJSON(std::string_view str, const Message& prototype,
+                                              std::optional<int> str_truncation_len,
+                                              size_t max_len) {
+  absl::MutexLock lock(&mutex_);
+  std::unique_ptr<Message>& pb = messages_[&prototype];
+  if (pb == nullptr) {
+    pb.reset(prototype.New());
+  }
+  return grpc::ParsePBToJSON(str, pb.get(), str_truncation_len, max_len);
+}
+
 }  // namespace grpc
 }  // namespace stirling
 }  // namespace px
@@ -18,11 +18,21 @@
 
 #pragma once
 
+#include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/message.h>
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+#include "src/common/grpcutils/service_descriptor_database.h"
 
 namespace px {
 namespace stirling {
@@ -41,6 +51,79 @@ constexpr size_t kGRPCMessageHeaderSizeInBytes = 5;
  */
 std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len = std::nullopt);
 
+/**
+ * Parses the input str as messages of the type of the prototype, and prints them as compact
+ * JSON, one message per line. Unlike ParsePB(), field names are known, so the output is both
+ * smaller and readable.
+ *
+ * @param str The raw message as a string.
+ * @param prototype A message of the type to parse into.
+ * @param str_truncation_len The string length of any string/bytes fields beyond which truncation
+ *        applies, if specified.
+ * @param max_len Messages that follow once the output has reached this length are not decoded.
+ * @return The parsed messages.
+ */
+std::string ParsePBToJSON(std::string_view str, const google::protobuf::Message& prototype,
+                          std::optional<int> str_truncation_len = std::nullopt,
+                          size_t max_len = std::string::npos);
+
+/**
+ * Same as above, parsing the messages into pb. The fields of pb keep their memory from one
+ * message to the next, so passing the same pb for all the bodies of a type saves allocating its
+ * fields again for every body.
+ */
+std::string ParsePBToJSON(std::string_view str, google::protobuf::Message* pb,
+                          std::optional<int> str_truncation_len = std::nullopt,
+                          size_t max_len = std::string::npos);
+
+/**
+ * Holds the descriptors of the traced gRPC services, and the request & response message types
+ * of their methods, by the :path header of the calls.
+ *
+ * The prototypes of a path are only looked up once. Thread-safe.
+ */
+class GRPCMethodRegistry {
+ public:
+  /**
+   * Creates a registry from serialized FileDescriptorSet files, eg. the output of
+   * `protoc --include_imports --descriptor_set_out`.
+   */
+  static StatusOr<std::unique_ptr<GRPCMethodRegistry>> CreateFromFiles(
+      const std::vector<std::string>& paths);
+
+  explicit GRPCMethodRegistry(google::protobuf::FileDescriptorSet fdset)
+      : desc_db_(std::move(fdset)) {}
+
+  /**
+   * @param path The :path of a gRPC call, eg. "/helloworld.Greeter/SayHello".
+   * @return The request & response prototypes of the method, or null prototypes if the method is
+   *         unknown. The prototypes live as long as the registry.
+   */
+  ::px::grpc::MethodPrototypes Lookup(std::string_view path);
+
+  /**
+   * Same as the free ParsePBToJSON(), parsing into a message of the type of the prototype that the
+   * registry keeps and reuses for all the bodies of that type.
+   *
+   * @param prototype A prototype returned by Lookup().
+   */
+  std::string ParsePBToJSON(std::string_view str, const google::protobuf::Message& prototype,
+                            std::optional<int> str_truncation_len = std::nullopt,
+                            size_t max_len = std::string::npos);
+
+ private:
+  // Bounds the number of unknown paths that are remembered, since paths come from the traffic.
+  static constexpr size_t kMaxUnknownPaths = 1024;
+
+  absl::Mutex mutex_;
+  ::px::grpc::ServiceDescriptorDatabase desc_db_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, ::px::grpc::MethodPrototypes> methods_ ABSL_GUARDED_BY(mutex_);
+  size_t num_unknown_paths_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The messages that the bodies are parsed into, by their prototype.
+  absl::flat_hash_map<const google::protobuf::Message*, std::unique_ptr<google::protobuf::Message>>
+      messages_ ABSL_GUARDED_BY(mutex_);
+};
+
 }  // namespace grpc
 }  // namespace stirling
 }  // namespace px
@@ -22,12 +22,14 @@
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/testing/proto/greet.pb.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/testing/proto/multi_fields.pb.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/testing/utils.h"
 
 namespace px {
 namespace stirling {
 namespace grpc {
 
 using ::google::protobuf::TextFormat;
+using ::px::stirling::protocols::http2::testing::GreetServiceFDSet;
 using ::px::stirling::protocols::http2::testing::HelloReply;
 using ::px::stirling::protocols::http2::testing::HelloRequest;
 using ::px::stirling::protocols::http2::testing::MultiFieldsMessage;
@@ -125,6 +127,58 @@ TEST(ParsePb, ParsingPartialMessage) {
 4: 0x00000419)"));
 }
 
+TEST(ParsePBToJSON, UsesFieldNames) {
+  HelloRequest req;
+  req.set_name("pixielabs");
+  req.set_count(2);
+  std::string s = absl::StrCat(PackGRPCMsg(req.SerializeAsString()),
+                               PackGRPCMsg(req.SerializeAsString()));
+  EXPECT_THAT(ParsePBToJSON(s, HelloRequest()),
+              StrEq("{\"name\":\"pixielabs\",\"count\":2}\n{\"name\":\"pixielabs\",\"count\":2}"));
+  // The second message is not decoded once the output is long enough.
+  EXPECT_THAT(ParsePBToJSON(s, HelloRequest(), std::nullopt, 10),
+              StrEq(R"({"name":"pixielabs","count":2})"));
+  EXPECT_THAT(ParsePBToJSON(s.substr(0, 4), HelloRequest()), StrEq("<Failed to parse protobuf>"));
+}
+
+TEST(ParsePBToJSON, LongStringTruncation) {
+  HelloReply reply;
+  reply.set_message("This is a long string. It is so long that is expected to get truncated.");
+  EXPECT_THAT(ParsePBToJSON(PackGRPCMsg(reply.SerializeAsString()), HelloReply(), 32),
+              StrEq(R"({"message":"This is a long string. It is so ...[truncated]..."})"));
+}
+
+TEST(GRPCMethodRegistry, LookupByPath) {
+  GRPCMethodRegistry registry(GreetServiceFDSet());
+
+  ::px::grpc::MethodPrototypes method =
+      registry.Lookup("/px.stirling.protocols.http2.testing.Greeter/SayHello");
+  ASSERT_NE(method.input, nullptr);
+  ASSERT_NE(method.output, nullptr);
+  EXPECT_EQ(method.input->GetDescriptor()->full_name(),
+            "px.stirling.protocols.http2.testing.HelloRequest");
+  EXPECT_EQ(method.output->GetDescriptor()->full_name(),
+            "px.stirling.protocols.http2.testing.HelloReply");
+  // Cached.
+  EXPECT_EQ(registry.Lookup("/px.stirling.protocols.http2.testing.Greeter/SayHello").input,
+            method.input);
+
+  EXPECT_EQ(registry.Lookup("/px.stirling.protocols.http2.testing.Greeter/NoSuchMethod").input,
+            nullptr);
+  EXPECT_EQ(registry.Lookup("/NoSuchService/SayHello").input, nullptr);
+
+  HelloRequest req;
+  req.set_name("pixielabs");
+  EXPECT_THAT(ParsePBToJSON(PackGRPCMsg(req.SerializeAsString()), *method.input),
+              StrEq(R"({"name":"pixielabs"})"));
+
+  // The message that the registry parses into is cleared from one body to the next.
+  EXPECT_THAT(registry.ParsePBToJSON(PackGRPCMsg(req.SerializeAsString()), *method.input),
+              StrEq(R"({"name":"pixielabs"})"));
+  std::string empty_body = PackGRPCMsg(HelloRequest().SerializeAsString());
+  EXPECT_THAT(registry.ParsePBToJSON(empty_body, *method.input), StrEq("{}"));
+}
+
 }  // namespace grpc
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,389 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/hpack.h"
+
+#include <array>
+#include <vector>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+namespace {
+
+// https://httpwg.org/specs/rfc7541.html#static.table.definition
+constexpr std::pair<std::string_view, std::string_view> kStaticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+constexpr uint64_t kStaticTableSize = std::size(kStaticTable);
+
+constexpr int kEOSSymbol = 256;
+constexpr int kNumSymbols = 257;
+constexpr int kMaxCodeLength = 30;
+
+// The length of the Huffman code of each symbol, including EOS.
+// https://httpwg.org/specs/rfc7541.html#huffman.code
+// The code is canonical, so the codes themselves follow from the lengths.
+constexpr uint8_t kHuffmanCodeLengths[kNumSymbols] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+// The canonical Huffman decoding table: the codes of each length are consecutive, and are
+// assigned to the symbols of that length in increasing order.
+struct HuffmanTable {
+  // The first code of each length.
+  std::array<uint32_t, kMaxCodeLength + 1> first_code{};
+  // The number of codes of each length.
+  std::array<uint32_t, kMaxCodeLength + 1> count{};
+  // The position in symbols of the symbol of the first code of each length.
+  std::array<uint32_t, kMaxCodeLength + 1> offset{};
+  // The symbols, sorted by code.
+  std::array<uint16_t, kNumSymbols> symbols{};
+
+  HuffmanTable() {
+    for (uint8_t len : kHuffmanCodeLengths) {
+      ++count[len];
+    }
+    uint32_t code = 0;
+    uint32_t pos = 0;
+    for (int len = 1; len <= kMaxCodeLength; ++len) {
+      code = (code + count[len - 1]) << 1;
+      first_code[len] = code;
+      offset[len] = pos;
+      pos += count[len];
+    }
+    std::array<uint32_t, kMaxCodeLength + 1> next = offset;
+    for (int sym = 0; sym < kNumSymbols; ++sym) {
+      symbols[next[kHuffmanCodeLengths[sym]]++] = sym;
+    }
+  }
+};
+
+// Decodes an integer with an N-bit prefix.
+// https://httpwg.org/specs/rfc7541.html#integer.representation
+StatusOr<uint64_t> ExtractInt(std::string_view* buf, int prefix_bits) {
+  if (buf->empty()) {
+    return error::InvalidArgument("Missing integer.");
+  }
+  const uint64_t mask = (1 << prefix_bits) - 1;
+  uint64_t value = static_cast<uint8_t>(buf->front()) & mask;
+  buf->remove_prefix(1);
+  if (value < mask) {
+    return value;
+  }
+  // Values are bounded by the table sizes and string lengths, so 4 continuation bytes is plenty.
+  constexpr int kMaxShift = 28;
+  for (int shift = 0; shift <= kMaxShift; shift += 7) {
+    if (buf->empty()) {
+      return error::InvalidArgument("Truncated integer.");
+    }
+    uint8_t b = buf->front();
+    buf->remove_prefix(1);
+    value += static_cast<uint64_t>(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return value;
+    }
+  }
+  return error::InvalidArgument("Integer is too large.");
+}
+
+// https://httpwg.org/specs/rfc7541.html#string.literal.representation
+StatusOr<std::string> ExtractString(std::string_view* buf) {
+  if (buf->empty()) {
+    return error::InvalidArgument("Missing string literal.");
+  }
+  const bool huffman = (buf->front() & 0x80) != 0;
+  PL_ASSIGN_OR_RETURN(uint64_t len, ExtractInt(buf, 7));
+  if (len > buf->size()) {
+    return error::InvalidArgument("Truncated string literal, length=$0 remaining=$1", len,
+                                  buf->size());
+  }
+  std::string_view str = buf->substr(0, len);
+  buf->remove_prefix(len);
+  if (huffman) {
+    return HuffmanDecode(str);
+  }
+  return std::string(str);
+}
+
+}  // namespace
+
+StatusOr<std::string> HuffmanDecode(std::string_view buf) {
+  static const HuffmanTable kTable;
+
+  std::string out;
+  out.reserve(buf.size() * 8 / 5);
+
+  uint32_t code = 0;
+  int len = 0;
+  bool all_ones = true;
+  for (char c : buf) {
+    for (int bit = 7; bit >= 0; --bit) {
+      uint32_t b = (static_cast<uint8_t>(c) >> bit) & 1;
+      code = (code << 1) | b;
+      all_ones &= (b == 1);
+      ++len;
+      if (len > kMaxCodeLength) {
+        return error::InvalidArgument("Invalid Huffman code.");
+      }
+      if (code - kTable.first_code[len] < kTable.count[len]) {
+        uint16_t sym = kTable.symbols[kTable.offset[len] + code - kTable.first_code[len]];
+        if (sym == kEOSSymbol) {
+          return error::InvalidArgument("EOS symbol in Huffman-encoded string.");
+        }
+        out.push_back(static_cast<char>(sym));
+        code = 0;
+        len = 0;
+        all_ones = true;
+      }
+    }
+  }
+  // The last code is padded with the most significant bits of EOS, which are all ones.
+  if (len > 7 || !all_ones) {
+    return error::InvalidArgument("Invalid Huffman padding.");
+  }
+  return out;
+}
+
+Status HPACKDecoder::Decode(std::string_view block, NVMap* headers) {
+  while (!block.empty()) {
+    Status s = DecodeField(&block, headers);
+    if (!s.ok()) {
+      MarkDataLoss();
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
+void HPACKDecoder::MarkDataLoss() {
+  // The lost data may have added entries, which would then be newer than the known ones.
+  // So none of the entries can be referenced by index anymore.
+  table_.clear();
+  table_size_ = 0;
+  in_sync_ = false;
+}
+
+StatusOr<const HPACKDecoder::Entry*> HPACKDecoder::Lookup(uint64_t index) const {
+  // A copy of the static table, with the same type as the dynamic table entries.
+  static const auto* kStaticEntries = [] {
+    auto* entries = new std::vector<Entry>();
+    for (const auto& [name, value] : kStaticTable) {
+      entries->push_back({std::string(name), std::string(value)});
+    }
+    return entries;
+  }();
+
+  if (index == 0) {
+    return error::InvalidArgument("Header field index 0 is not used.");
+  }
+  if (index <= kStaticTableSize) {
+    return &(*kStaticEntries)[index - 1];
+  }
+  uint64_t dynamic_index = index - kStaticTableSize - 1;
+  if (dynamic_index < table_.size()) {
+    return &table_[dynamic_index];
+  }
+  if (!in_sync_) {
+    return nullptr;
+  }
+  return error::InvalidArgument("Header field index $0 is out of range, the table has $1 entries",
+                                index, kStaticTableSize + table_.size());
+}
+
+Status HPACKDecoder::DecodeField(std::string_view* buf, NVMap* headers) {
+  const uint8_t b = buf->front();
+
+  // Indexed header field: https://httpwg.org/specs/rfc7541.html#indexed.header.representation
+  if ((b & 0x80) != 0) {
+    PL_ASSIGN_OR_RETURN(uint64_t index, ExtractInt(buf, 7));
+    PL_ASSIGN_OR_RETURN(const Entry* entry, Lookup(index));
+    if (entry == nullptr) {
+      ++num_unresolved_fields_;
+      return Status::OK();
+    }
+    headers->emplace(entry->name, entry->value);
+    return Status::OK();
+  }
+
+  // Dynamic table size update: https://httpwg.org/specs/rfc7541.html#encoding.context.update
+  if ((b & 0xe0) == 0x20) {
+    PL_ASSIGN_OR_RETURN(uint64_t size, ExtractInt(buf, 5));
+    if (size > kMaxTableSizeLimit) {
+      return error::InvalidArgument("Dynamic table size $0 is over the limit $1", size,
+                                    kMaxTableSizeLimit);
+    }
+    SetMaxTableSize(size);
+    return Status::OK();
+  }
+
+  // Literal header fields: https://httpwg.org/specs/rfc7541.html#literal.header.representation
+  // With incremental indexing (01), the field is added to the dynamic table. Without indexing
+  // (0000) and never indexed (0001) only differ for intermediaries.
+  const bool incremental_indexing = (b & 0xc0) == 0x40;
+  PL_ASSIGN_OR_RETURN(uint64_t name_index, ExtractInt(buf, incremental_indexing ? 6 : 4));
+
+  bool resolved = true;
+  Entry field;
+  if (name_index == 0) {
+    PL_ASSIGN_OR_RETURN(field.name, ExtractString(buf));
+  } else {
+    PL_ASSIGN_OR_RETURN(const Entry* entry, Lookup(name_index));
+    if (entry == nullptr) {
+      resolved = false;
+    } else {
+      field.name = entry->name;
+    }
+  }
+  PL_ASSIGN_OR_RETURN(field.value, ExtractString(buf));
+
+  if (!resolved) {
+    ++num_unresolved_fields_;
+    if (incremental_indexing) {
+      // An entry of unknown size is added on top of the known ones, so the eviction of the older
+      // entries can no longer be tracked.
+      MarkDataLoss();
+    }
+    return Status::OK();
+  }
+
+  headers->emplace(field.name, field.value);
+  if (incremental_indexing) {
+    AddEntry(std::move(field));
+  }
+  return Status::OK();
+}
+
+void HPACKDecoder::AddEntry(Entry entry) {
+  const size_t entry_size = EntrySize(entry);
+  // The unknown entries are older than the known ones, so they are evicted first. If the known
+  // entries and the new one do not fit in the table, all the unknown entries must be gone.
+  //
+  // Note that this assumes the maximum size did not change with the lost data.
+  if (table_size_ + entry_size > max_table_size_) {
+    in_sync_ = true;
+  }
+  if (entry_size > max_table_size_) {
+    // An entry larger than the table empties it, and is not added.
+    EvictTo(0);
+    return;
+  }
+  EvictTo(max_table_size_ - entry_size);
+  table_size_ += entry_size;
+  table_.push_front(std::move(entry));
+}
+
+void HPACKDecoder::SetMaxTableSize(size_t size) {
+  max_table_size_ = size;
+  // Same reasoning as in AddEntry().
+  if (table_size_ >= max_table_size_) {
+    in_sync_ = true;
+  }
+  EvictTo(max_table_size_);
+}
+
+void HPACKDecoder::EvictTo(size_t size) {
+  while (table_size_ > size) {
+    table_size_ -= EntrySize(table_.back());
+    table_.pop_back();
+  }
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/types.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+/**
+ * HPACKDecoder decodes the header blocks written in one direction of an HTTP/2 connection.
+ * See https://httpwg.org/specs/rfc7541.html.
+ *
+ * HPACK is stateful: the encoder adds header fields to a dynamic table and later refers to them
+ * by index, so the blocks must be decoded in order, starting from the beginning of the connection.
+ *
+ * After some data is lost (see MarkDataLoss()), the entries of the dynamic table are unknown.
+ * The decoder then keeps track of the entries added after the loss, which are the newest ones,
+ * and resolves the references to them. References to the older, unknown entries are dropped
+ * from the decoded headers. Since the table evicts the oldest entries first, all the unknown
+ * entries are gone once the known ones fill the table, and the decoder is back in sync.
+ */
+class HPACKDecoder {
+ public:
+  // The initial size of the dynamic table, before any dynamic table size update.
+  static constexpr size_t kDefaultMaxTableSize = 4096;
+
+  // Dynamic table size updates above this are considered invalid.
+  static constexpr size_t kMaxTableSizeLimit = 1024 * 1024;
+
+  /**
+   * Decodes a complete header block, ie. the header block fragments of a HEADERS frame and its
+   * CONTINUATION frames, and appends the header fields to headers.
+   *
+   * On error, the headers decoded so far are kept, and the decoder assumes it lost sync.
+   */
+  Status Decode(std::string_view block, NVMap* headers);
+
+  /**
+   * Signals that some of the encoded data was lost, so the dynamic table is no longer known.
+   */
+  void MarkDataLoss();
+
+  /**
+   * Returns true if all the entries of the dynamic table are known.
+   */
+  bool in_sync() const { return in_sync_; }
+
+  /**
+   * Returns the number of header fields that could not be resolved, since the last data loss.
+   */
+  int num_unresolved_fields() const { return num_unresolved_fields_; }
+
+  size_t dynamic_table_size() const { return table_size_; }
+  size_t max_dynamic_table_size() const { return max_table_size_; }
+
+ private:
+  struct Entry {
+    std::string name;
+    std::string value;
+  };
+
+  // See https://httpwg.org/specs/rfc7541.html#calculating.table.size.
+  static size_t EntrySize(const Entry& entry) {
+    return entry.name.size() + entry.value.size() + 32;
+  }
+
+  Status DecodeField(std::string_view* buf, NVMap* headers);
+
+  // Looks up a header field by its index in the static and dynamic tables. Returns nullptr if it
+  // refers to a dynamic table entry that is unknown because of a data loss.
+  StatusOr<const Entry*> Lookup(uint64_t index) const;
+
+  void AddEntry(Entry entry);
+  void SetMaxTableSize(size_t size);
+  void EvictTo(size_t size);
+
+  // The known entries of the dynamic table, the newest first.
+  std::deque<Entry> table_;
+  size_t table_size_ = 0;
+  size_t max_table_size_ = kDefaultMaxTableSize;
+
+  bool in_sync_ = true;
+  int num_unresolved_fields_ = 0;
+};
+
+/**
+ * Decodes an HPACK Huffman-encoded string (https://httpwg.org/specs/rfc7541.html#huffman.code).
+ */
+StatusOr<std::string> HuffmanDecode(std::string_view buf);
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
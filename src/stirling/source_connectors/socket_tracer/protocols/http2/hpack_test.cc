@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/hpack.h"
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+using ::testing::IsEmpty;
+using ::testing::Pair;
+using ::testing::StrEq;
+using ::testing::UnorderedElementsAre;
+
+std::string Hex(std::string_view hex) {
+  return AsciiHexToBytes<std::string>(std::string(hex), {' '}).ConsumeValueOrDie();
+}
+
+TEST(HuffmanDecodeTest, Basic) {
+  EXPECT_OK_AND_THAT(HuffmanDecode(Hex("f1e3 c2e5 f23a 6ba0 ab90 f4ff")), StrEq("www.example.com"));
+  EXPECT_OK_AND_THAT(HuffmanDecode(Hex("a8eb 1064 9cbf")), StrEq("no-cache"));
+  EXPECT_OK_AND_THAT(HuffmanDecode(""), IsEmpty());
+
+  // '0' is 00000, so the remaining 3 bits are not a valid padding.
+  EXPECT_NOT_OK(HuffmanDecode(Hex("00")));
+  // More than 7 bits of padding.
+  EXPECT_NOT_OK(HuffmanDecode(Hex("ffff")));
+}
+
+// The examples from https://httpwg.org/specs/rfc7541.html#request.examples.without.huffman.coding.
+TEST(HPACKDecoderTest, RequestsWithoutHuffman) {
+  HPACKDecoder decoder;
+
+  NVMap headers;
+  ASSERT_OK(decoder.Decode(Hex("8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "http"),
+                                            Pair(":path", "/"),
+                                            Pair(":authority", "www.example.com")));
+  EXPECT_EQ(decoder.dynamic_table_size(), 57);
+
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("8286 84be 5808 6e6f 2d63 6163 6865"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "http"),
+                                            Pair(":path", "/"),
+                                            Pair(":authority", "www.example.com"),
+                                            Pair("cache-control", "no-cache")));
+  EXPECT_EQ(decoder.dynamic_table_size(), 110);
+
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d "
+                               "7661 6c75 65"),
+                           &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "https"),
+                                            Pair(":path", "/index.html"),
+                                            Pair(":authority", "www.example.com"),
+                                            Pair("custom-key", "custom-value")));
+  EXPECT_EQ(decoder.dynamic_table_size(), 164);
+  EXPECT_TRUE(decoder.in_sync());
+}
+
+// The examples from https://httpwg.org/specs/rfc7541.html#request.examples.with.huffman.coding.
+TEST(HPACKDecoderTest, RequestsWithHuffman) {
+  HPACKDecoder decoder;
+
+  NVMap headers;
+  ASSERT_OK(decoder.Decode(Hex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "http"),
+                                            Pair(":path", "/"),
+                                            Pair(":authority", "www.example.com")));
+
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("8286 84be 5886 a8eb 1064 9cbf"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "http"),
+                                            Pair(":path", "/"),
+                                            Pair(":authority", "www.example.com"),
+                                            Pair("cache-control", "no-cache")));
+
+  headers.clear();
+  ASSERT_OK(decoder.Decode(
+      Hex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "https"),
+                                            Pair(":path", "/index.html"),
+                                            Pair(":authority", "www.example.com"),
+                                            Pair("custom-key", "custom-value")));
+  EXPECT_EQ(decoder.dynamic_table_size(), 164);
+}
+
+// The examples from https://httpwg.org/specs/rfc7541.html#response.examples.without.huffman.coding,
+// which use a 256 bytes table to show the evictions.
+TEST(HPACKDecoderTest, ResponsesWithEviction) {
+  HPACKDecoder decoder;
+
+  NVMap headers;
+  // Starts with a dynamic table size update to 256.
+  ASSERT_OK(decoder.Decode(
+      Hex("3fe1 01 "
+          "4803 3330 3258 0770 7269 7661 7465 611d 4d6f 6e2c 2032 3120 4f63 7420 3230 3133 "
+          "2032 303a 3133 3a32 3120 474d 546e 1768 7474 7073 3a2f 2f77 7777 2e65 7861 6d70 "
+          "6c65 2e63 6f6d"),
+      &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":status", "302"),
+                                            Pair("cache-control", "private"),
+                                            Pair("date", "Mon, 21 Oct 2013 20:13:21 GMT"),
+                                            Pair("location", "https://www.example.com")));
+  EXPECT_EQ(decoder.max_dynamic_table_size(), 256);
+  EXPECT_EQ(decoder.dynamic_table_size(), 222);
+
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("4803 3330 37c1 c0bf"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":status", "307"),
+                                            Pair("cache-control", "private"),
+                                            Pair("date", "Mon, 21 Oct 2013 20:13:21 GMT"),
+                                            Pair("location", "https://www.example.com")));
+  EXPECT_EQ(decoder.dynamic_table_size(), 222);
+
+  headers.clear();
+  ASSERT_OK(decoder.Decode(
+      Hex("88c1 611d 4d6f 6e2c 2032 3120 4f63 7420 3230 3133 2032 303a 3133 3a32 3220 474d "
+          "54c0 5a04 677a 6970 7738 666f 6f3d 4153 444a 4b48 514b 425a 584f 5157 454f 5049 "
+          "5541 5851 5745 4f49 553b 206d 6178 2d61 6765 3d33 3630 303b 2076 6572 7369 6f6e "
+          "3d31"),
+      &headers));
+  EXPECT_THAT(headers,
+              UnorderedElementsAre(
+                  Pair(":status", "200"), Pair("cache-control", "private"),
+                  Pair("date", "Mon, 21 Oct 2013 20:13:22 GMT"),
+                  Pair("location", "https://www.example.com"), Pair("content-encoding", "gzip"),
+                  Pair("set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1")));
+  EXPECT_EQ(decoder.dynamic_table_size(), 215);
+}
+
+TEST(HPACKDecoderTest, UnknownEntriesAfterDataLoss) {
+  HPACKDecoder decoder;
+
+  NVMap headers;
+  ASSERT_OK(decoder.Decode(Hex("8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"), &headers));
+
+  decoder.MarkDataLoss();
+  EXPECT_FALSE(decoder.in_sync());
+
+  // The reference to :authority (be) cannot be resolved, the new cache-control entry is known.
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("8286 84be 5808 6e6f 2d63 6163 6865"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair(":method", "GET"), Pair(":scheme", "http"),
+                                            Pair(":path", "/"), Pair("cache-control", "no-cache")));
+  EXPECT_EQ(decoder.num_unresolved_fields(), 1);
+
+  // be now refers to cache-control.
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("be"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair("cache-control", "no-cache")));
+  EXPECT_FALSE(decoder.in_sync());
+
+  // Shrinking the table to the size of the known entries evicts all the unknown ones.
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("3f16 be"), &headers));
+  EXPECT_THAT(headers, UnorderedElementsAre(Pair("cache-control", "no-cache")));
+  EXPECT_EQ(decoder.max_dynamic_table_size(), 53);
+  EXPECT_TRUE(decoder.in_sync());
+
+  // In sync, references beyond the table are errors.
+  headers.clear();
+  EXPECT_NOT_OK(decoder.Decode(Hex("bf"), &headers));
+  EXPECT_FALSE(decoder.in_sync());
+}
+
+TEST(HPACKDecoderTest, SyncedByEviction) {
+  HPACKDecoder decoder;
+  decoder.MarkDataLoss();
+
+  // A literal with incremental indexing, with a 4063 bytes value, fills the 4096 bytes table.
+  std::string block = Hex("40 0178 7fe0 1e");
+  block.append(4063, 'x');
+
+  NVMap headers;
+  ASSERT_OK(decoder.Decode(block, &headers));
+  EXPECT_FALSE(decoder.in_sync());
+
+  // The next entry evicts everything older than itself.
+  headers.clear();
+  ASSERT_OK(decoder.Decode(Hex("400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65"),
+                           &headers));
+  EXPECT_TRUE(decoder.in_sync());
+  EXPECT_EQ(decoder.dynamic_table_size(), 54);
+}
+
+TEST(HPACKDecoderTest, InvalidBlocks) {
+  HPACKDecoder decoder;
+  NVMap headers;
+
+  // Index 0.
+  EXPECT_NOT_OK(decoder.Decode(Hex("80"), &headers));
+
+  // Truncated string.
+  EXPECT_NOT_OK(decoder.Decode(Hex("400a 6375 7374"), &headers));
+
+  // Dynamic table size update over the limit.
+  EXPECT_NOT_OK(decoder.Decode(Hex("3fff ffff 7f"), &headers));
+
+  EXPECT_THAT(headers, IsEmpty());
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
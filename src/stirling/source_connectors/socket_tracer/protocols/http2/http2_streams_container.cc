@@ -29,29 +29,41 @@ namespace stirling {
 
 namespace {
 
-void EraseExpiredStreams(std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp,
-                         absl::flat_hash_map<uint32_t, protocols::http2::Stream>* streams) {
-  auto iter = streams->begin();
-  while (iter != streams->end()) {
-    const auto& stream = iter->second;
-    uint64_t timestamp_ns = std::max(stream.send.timestamp_ns, stream.recv.timestamp_ns);
-    auto last_activity =
-        std::chrono::time_point<std::chrono::steady_clock>(std::chrono::nanoseconds(timestamp_ns));
-
-    if (expiry_timestamp < last_activity) {
-      break;
+uint64_t LastActivityNS(const protocols::http2::Stream& stream) {
+  return std::max(stream.send.timestamp_ns, stream.recv.timestamp_ns);
+}
+
+}  // namespace
+
+const protocols::http2::Stream* HTTP2StreamsContainer::FindStream(uint32_t stream_id) const {
+  const Entry* entry = streams_.Find(stream_id);
+  return entry == nullptr ? nullptr : &entry->stream;
+}
+
+void HTTP2StreamsContainer::ProcessTouchedStreams() {
+  for (uint32_t id : touched_ids_) {
+    Entry* entry = streams_.Find(id);
+    if (entry == nullptr) {
+      continue;
+    }
+    entry->touched = false;
+
+    size_t byte_size = entry->stream.ByteSize();
+    streams_byte_size_ += byte_size;
+    streams_byte_size_ -= entry->byte_size;
+    entry->byte_size = byte_size;
+
+    if (!entry->scheduled) {
+      expiry_wheel_.Schedule(id, LastActivityNS(entry->stream));
+      entry->scheduled = true;
     }
-    streams->erase(iter++);
   }
+  touched_ids_.clear();
 }
-}  // namespace
 
 size_t HTTP2StreamsContainer::StreamsSize() {
-  size_t size = 0;
-  for (const auto& [id, stream] : streams_) {
-    size += stream.ByteSize();
-  }
-  return size;
+  ProcessTouchedStreams();
+  return streams_byte_size_;
 }
 
 void HTTP2StreamsContainer::Cleanup(
@@ -60,15 +72,38 @@ void HTTP2StreamsContainer::Cleanup(
   if (size > size_limit_bytes) {
     VLOG(1) << absl::Substitute("HTTP2 streams cleared due to size limit ($0 > $1).", size,
                                 size_limit_bytes);
-    streams_.clear();
+    Clear();
   }
 
-  EraseExpiredStreams(expiry_timestamp, &streams_);
+  const uint64_t expiry_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(expiry_timestamp.time_since_epoch())
+          .count();
+  std::vector<uint32_t> timers;
+  expiry_wheel_.Advance(expiry_ns, &timers);
+  for (uint32_t id : timers) {
+    Entry* entry = streams_.Find(id);
+    if (entry == nullptr) {
+      // The stream was already consumed or erased.
+      continue;
+    }
+    uint64_t last_activity_ns = LastActivityNS(entry->stream);
+    if (last_activity_ns <= expiry_ns) {
+      Erase(id);
+    } else {
+      expiry_wheel_.Schedule(id, last_activity_ns);
+      entry->scheduled = true;
+    }
+  }
 }
 
 protocols::http2::HalfStream* HTTP2StreamsContainer::HalfStreamPtr(uint32_t stream_id,
                                                                    bool write_event) {
-  protocols::http2::Stream& stream = streams_[stream_id];
+  Entry& entry = streams_.FindOrInsert(stream_id);
+  if (!entry.touched) {
+    entry.touched = true;
+    touched_ids_.push_back(stream_id);
+  }
+  protocols::http2::Stream& stream = entry.stream;
 
   if (stream.consumed) {
     // Don't expect this to happen, but log it just in case.
@@ -80,6 +115,23 @@ protocols::http2::HalfStream* HTTP2StreamsContainer::HalfStreamPtr(uint32_t stre
   return half_stream_ptr;
 }
 
+void HTTP2StreamsContainer::Erase(uint32_t stream_id) {
+  Entry* entry = streams_.Find(stream_id);
+  if (entry == nullptr) {
+    return;
+  }
+  // Any pending timer and touched ID are dropped lazily, once they find the stream gone.
+  streams_byte_size_ -= entry->byte_size;
+  streams_.Erase(stream_id);
+}
+
+void HTTP2StreamsContainer::Clear() {
+  streams_.Clear();
+  touched_ids_.clear();
+  streams_byte_size_ = 0;
+  expiry_wheel_.Clear();
+}
+
 std::string HTTP2StreamsContainer::DebugString(std::string_view prefix) const {
   std::string info;
   info += absl::Substitute("$0streams=$1\n", prefix, streams_.size());
@@ -18,36 +18,68 @@
 
 #pragma once
 
-#include <deque>
+#include <chrono>
 #include <string>
-
-#include <absl/container/flat_hash_map.h>
+#include <utility>
+#include <vector>
 
 #include "src/common/base/mixins.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/stream_table.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/types.h"
+#include "src/stirling/utils/timer_wheel.h"
 
 namespace px {
 namespace stirling {
 
 /**
  * HTTP2StreamsContainer is an object that holds the captured HTTP2 stream data from BPF.
- * This is managed differently from other protocols because it comes as UProbe data
+ * This is managed differently from other protocols because it mostly comes as UProbe data
  * and is already structured. This in contrast to other protocols which are captured via
- * KProbes and need to be parsed.
+ * KProbes and need to be parsed. The HTTP2 traffic captured via KProbes is decoded into the
+ * same streams, see protocols::http2::FrameDecoder.
+ *
+ * Streams are kept in a flat table indexed by stream ID. The container remembers which streams
+ * were touched since the last Cleanup(), so that consuming and size accounting only visit those,
+ * and expires streams through a timer wheel, so that Cleanup() only visits expired streams.
  */
 class HTTP2StreamsContainer : NotCopyMoveable {
  public:
-  const absl::flat_hash_map<uint32_t, protocols::http2::Stream>& streams() const {
-    return streams_;
-  }
-  absl::flat_hash_map<uint32_t, protocols::http2::Stream>* mutable_streams() { return &streams_; }
-
   /**
    * Get the HTTP2 stream for the given stream ID and the direction of traffic.
+   * The pointer is only valid until the next call.
    * @param write_event==true for send HalfStream, write_event==false for recv HalfStream.
    */
   protocols::http2::HalfStream* HalfStreamPtr(uint32_t stream_id, bool write_event);
 
+  /**
+   * Returns the stream with the given ID, or nullptr if there is none.
+   */
+  const protocols::http2::Stream* FindStream(uint32_t stream_id) const;
+
+  /**
+   * Moves the streams that have ended into records, or all streams if all is true.
+   * Only the streams that were touched since the last Cleanup() can have ended.
+   */
+  template <typename TRecord>
+  void ConsumeStreams(bool all, std::vector<TRecord>* records) {
+    if (all) {
+      streams_.ForEach([records](uint32_t, Entry& entry) {
+        records->emplace_back(std::move(entry.stream));
+      });
+      Clear();
+      return;
+    }
+    for (uint32_t id : touched_ids_) {
+      Entry* entry = streams_.Find(id);
+      if (entry != nullptr && entry->stream.StreamEnded()) {
+        records->emplace_back(std::move(entry->stream));
+        Erase(id);
+      }
+    }
+  }
+
+  size_t num_streams() const { return streams_.size(); }
+
   /**
    * Returns the approximate memory consumption of the HTTP2StreamsContainer.
    */
@@ -60,16 +92,30 @@ class HTTP2StreamsContainer : NotCopyMoveable {
   void Cleanup(size_t size_limit_bytes,
                std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp);
 
-  /**
-   * Erase n stream IDs from the head of the streams container.
-   */
-  void EraseHead(size_t n);
-
   std::string DebugString(std::string_view prefix) const;
 
  private:
-  // Map of all HTTP2 streams. Key is stream ID.
-  absl::flat_hash_map<uint32_t, protocols::http2::Stream> streams_;
+  struct Entry {
+    protocols::http2::Stream stream;
+    // ByteSize() of the stream, as of the last time it was accounted for.
+    size_t byte_size = 0;
+    bool touched = false;
+    // Whether the stream has a pending timer in expiry_wheel_.
+    bool scheduled = false;
+  };
+
+  // Accounts for the size of the touched streams, and schedules their expiry.
+  void ProcessTouchedStreams();
+  void Erase(uint32_t stream_id);
+  void Clear();
+
+  protocols::http2::StreamTable<Entry> streams_;
+  std::vector<uint32_t> touched_ids_;
+  size_t streams_byte_size_ = 0;
+
+  // Timers are keyed by the last activity of the stream; it's only ever pushed later,
+  // so a stream keeps a single timer, which is re-armed when it fires too early.
+  TimerWheel<uint32_t> expiry_wheel_{std::chrono::seconds(1)};
 };
 
 }  // namespace stirling
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/http2_streams_container.h"
+
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using protocols::http2::HalfStream;
+using protocols::http2::Stream;
+
+namespace {
+
+constexpr std::chrono::steady_clock::time_point kTime0{std::chrono::seconds(1000000)};
+
+uint64_t ToNS(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+void AddRequest(HTTP2StreamsContainer* streams, uint32_t stream_id, uint64_t timestamp_ns,
+                bool end_stream) {
+  HalfStream* half_stream = streams->HalfStreamPtr(stream_id, /*write_event*/ true);
+  half_stream->UpdateTimestamp(timestamp_ns);
+  half_stream->AddHeader(":method", "post");
+  if (end_stream) {
+    half_stream->AddEndStream();
+  }
+}
+
+void AddResponse(HTTP2StreamsContainer* streams, uint32_t stream_id, uint64_t timestamp_ns) {
+  HalfStream* half_stream = streams->HalfStreamPtr(stream_id, /*write_event*/ false);
+  half_stream->UpdateTimestamp(timestamp_ns);
+  half_stream->AddHeader(":status", "200");
+  half_stream->AddEndStream();
+}
+
+}  // namespace
+
+TEST(HTTP2StreamsContainerTest, ConsumesEndedStreams) {
+  HTTP2StreamsContainer streams;
+  for (uint32_t id = 1; id < 200; id += 2) {
+    AddRequest(&streams, id, ToNS(kTime0), /*end_stream*/ true);
+  }
+  // Only every other stream gets a response.
+  for (uint32_t id = 1; id < 200; id += 4) {
+    AddResponse(&streams, id, ToNS(kTime0));
+  }
+  EXPECT_EQ(streams.num_streams(), 100);
+
+  std::vector<Stream> records;
+  streams.ConsumeStreams(/*all*/ false, &records);
+  EXPECT_EQ(records.size(), 50);
+  EXPECT_EQ(streams.num_streams(), 50);
+  EXPECT_EQ(streams.FindStream(1), nullptr);
+  ASSERT_NE(streams.FindStream(3), nullptr);
+  EXPECT_THAT(streams.FindStream(3)->send.headers(),
+              ::testing::ElementsAre(::testing::Pair(":method", "post")));
+
+  streams.Cleanup(/*size_limit_bytes*/ 1000000, kTime0 - std::chrono::seconds(10));
+
+  // Untouched streams are not re-examined.
+  records.clear();
+  streams.ConsumeStreams(/*all*/ false, &records);
+  EXPECT_TRUE(records.empty());
+
+  AddResponse(&streams, 3, ToNS(kTime0));
+  streams.ConsumeStreams(/*all*/ false, &records);
+  EXPECT_EQ(records.size(), 1);
+
+  records.clear();
+  streams.ConsumeStreams(/*all*/ true, &records);
+  EXPECT_EQ(records.size(), 49);
+  EXPECT_EQ(streams.num_streams(), 0);
+}
+
+TEST(HTTP2StreamsContainerTest, StreamIDJumpAhead) {
+  HTTP2StreamsContainer streams;
+  AddRequest(&streams, 7, ToNS(kTime0), /*end_stream*/ false);
+  AddRequest(&streams, 100007, ToNS(kTime0), /*end_stream*/ false);
+  AddRequest(&streams, 9, ToNS(kTime0), /*end_stream*/ false);
+
+  EXPECT_EQ(streams.num_streams(), 3);
+  EXPECT_NE(streams.FindStream(7), nullptr);
+  EXPECT_NE(streams.FindStream(9), nullptr);
+  EXPECT_NE(streams.FindStream(100007), nullptr);
+  EXPECT_EQ(streams.FindStream(11), nullptr);
+}
+
+TEST(HTTP2StreamsContainerTest, SizeLimit) {
+  HTTP2StreamsContainer streams;
+  AddRequest(&streams, 1, ToNS(kTime0), /*end_stream*/ false);
+  AddRequest(&streams, 3, ToNS(kTime0), /*end_stream*/ false);
+  // Two headers of 11 bytes each.
+  EXPECT_EQ(streams.StreamsSize(), 22);
+
+  streams.Cleanup(/*size_limit_bytes*/ 22, kTime0 - std::chrono::seconds(10));
+  EXPECT_EQ(streams.num_streams(), 2);
+
+  AddResponse(&streams, 3, ToNS(kTime0));
+  streams.Cleanup(/*size_limit_bytes*/ 22, kTime0 - std::chrono::seconds(10));
+  EXPECT_EQ(streams.num_streams(), 0);
+  EXPECT_EQ(streams.StreamsSize(), 0);
+}
+
+TEST(HTTP2StreamsContainerTest, Expiry) {
+  HTTP2StreamsContainer streams;
+  AddRequest(&streams, 1, ToNS(kTime0), /*end_stream*/ false);
+  AddRequest(&streams, 3, ToNS(kTime0 + std::chrono::seconds(10)), /*end_stream*/ false);
+  streams.Cleanup(/*size_limit_bytes*/ 1000000, kTime0 - std::chrono::seconds(10));
+  EXPECT_EQ(streams.num_streams(), 2);
+
+  // A late response pushes back the expiry of stream 1.
+  AddResponse(&streams, 1, ToNS(kTime0 + std::chrono::seconds(20)));
+
+  streams.Cleanup(/*size_limit_bytes*/ 1000000, kTime0 + std::chrono::seconds(15));
+  EXPECT_EQ(streams.num_streams(), 1);
+  EXPECT_EQ(streams.FindStream(3), nullptr);
+
+  streams.Cleanup(/*size_limit_bytes*/ 1000000, kTime0 + std::chrono::seconds(20));
+  EXPECT_EQ(streams.num_streams(), 0);
+  EXPECT_EQ(streams.StreamsSize(), 0);
+}
+
+}  // namespace stirling
+}  // namespace px
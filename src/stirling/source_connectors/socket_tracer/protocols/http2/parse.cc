@@ -0,0 +1,201 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/parse.h"
+
+#include <string>
+
+#include <absl/strings/match.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+namespace {
+
+// The largest frame size without SETTINGS_MAX_FRAME_SIZE, used to look for frame boundaries.
+constexpr size_t kDefaultMaxFrameSize = 16384;
+
+struct FrameHeader {
+  uint32_t length;
+  uint8_t type;
+  uint8_t flags;
+  bool reserved_bit;
+  uint32_t stream_id;
+};
+
+FrameHeader ParseFrameHeader(std::string_view buf) {
+  FrameHeader header;
+  header.length = utils::BEndianBytesToInt<uint32_t, 3>(buf);
+  header.type = buf[3];
+  header.flags = buf[4];
+  uint32_t stream_id = utils::BEndianBytesToInt<uint32_t>(buf.substr(5));
+  header.reserved_bit = (stream_id & 0x80000000) != 0;
+  header.stream_id = stream_id & 0x7fffffff;
+  return header;
+}
+
+// Checks the constraints of the frame header: https://httpwg.org/specs/rfc7540.html#FrameTypes.
+// If strict, also requires the frame to look like what is typically sent, to reduce the false
+// positives when looking for a frame boundary in arbitrary data.
+bool IsValidFrameHeader(const FrameHeader& header, bool strict) {
+  if (header.reserved_bit || header.length > kMaxFrameSize) {
+    return false;
+  }
+  if (header.type > static_cast<uint8_t>(FrameType::kContinuation)) {
+    // Frames of unknown types must be ignored.
+    return !strict;
+  }
+  if (strict && header.length > kDefaultMaxFrameSize) {
+    return false;
+  }
+
+  uint8_t known_flags = 0;
+  switch (static_cast<FrameType>(header.type)) {
+    case FrameType::kData:
+      known_flags = frame_flags::kEndStream | frame_flags::kPadded;
+      if (header.stream_id == 0) {
+        return false;
+      }
+      break;
+    case FrameType::kHeaders:
+      known_flags = frame_flags::kEndStream | frame_flags::kEndHeaders | frame_flags::kPadded |
+                    frame_flags::kPriority;
+      if (header.stream_id == 0) {
+        return false;
+      }
+      break;
+    case FrameType::kPriority:
+      if (header.stream_id == 0 || header.length != 5) {
+        return false;
+      }
+      break;
+    case FrameType::kRSTStream:
+      if (header.stream_id == 0 || header.length != 4) {
+        return false;
+      }
+      break;
+    case FrameType::kSettings:
+      known_flags = frame_flags::kAck;
+      if (header.stream_id != 0 || header.length % 6 != 0) {
+        return false;
+      }
+      break;
+    case FrameType::kPushPromise:
+      known_flags = frame_flags::kEndHeaders | frame_flags::kPadded;
+      if (header.stream_id == 0) {
+        return false;
+      }
+      break;
+    case FrameType::kPing:
+      known_flags = frame_flags::kAck;
+      if (header.stream_id != 0 || header.length != 8) {
+        return false;
+      }
+      break;
+    case FrameType::kGoAway:
+      if (header.stream_id != 0 || header.length < 8) {
+        return false;
+      }
+      break;
+    case FrameType::kWindowUpdate:
+      if (header.length != 4) {
+        return false;
+      }
+      break;
+    case FrameType::kContinuation:
+      known_flags = frame_flags::kEndHeaders;
+      if (header.stream_id == 0) {
+        return false;
+      }
+      break;
+  }
+  // Unknown flags must be ignored, but are not expected.
+  return !strict || (header.flags & ~known_flags) == 0;
+}
+
+}  // namespace
+
+size_t FindFrameBoundary(std::string_view buf, size_t start_pos) {
+  for (size_t pos = start_pos; pos + kFrameHeaderSize <= buf.size(); ++pos) {
+    std::string_view s = buf.substr(pos);
+    if (absl::StartsWith(s, kConnectionPreface) ||
+        IsValidFrameHeader(ParseFrameHeader(s), /*strict*/ true)) {
+      return pos;
+    }
+  }
+  return std::string::npos;
+}
+
+ParseState ParseFrame(std::string_view* buf, Frame* frame) {
+  if (absl::StartsWith(*buf, kConnectionPreface)) {
+    buf->remove_prefix(kConnectionPreface.size());
+    return ParseState::kIgnored;
+  }
+  if (absl::StartsWith(kConnectionPreface, *buf)) {
+    return ParseState::kNeedsMoreData;
+  }
+  if (buf->size() < kFrameHeaderSize) {
+    return ParseState::kNeedsMoreData;
+  }
+
+  FrameHeader header = ParseFrameHeader(*buf);
+  if (!IsValidFrameHeader(header, /*strict*/ false)) {
+    // Skip to the next frame here, instead of leaving it to the caller, to return a data loss
+    // marker at the right place in the frames.
+    size_t pos = FindFrameBoundary(*buf, 1);
+    if (pos == std::string::npos) {
+      return ParseState::kInvalid;
+    }
+    buf->remove_prefix(pos);
+    frame->data_loss = true;
+    return ParseState::kSuccess;
+  }
+  if (buf->size() < kFrameHeaderSize + header.length) {
+    return ParseState::kNeedsMoreData;
+  }
+
+  std::string_view payload = buf->substr(kFrameHeaderSize, header.length);
+  buf->remove_prefix(kFrameHeaderSize + header.length);
+
+  // Only keep the frames with stream data, and the ones with header blocks, which update the
+  // HPACK state. A stream reset with RST_STREAM is flushed when the connection closes.
+  switch (static_cast<FrameType>(header.type)) {
+    case FrameType::kData:
+    case FrameType::kHeaders:
+    case FrameType::kPushPromise:
+    case FrameType::kContinuation:
+      break;
+    default:
+      return ParseState::kIgnored;
+  }
+
+  frame->type = static_cast<FrameType>(header.type);
+  frame->flags = header.flags;
+  frame->stream_id = header.stream_id;
+  frame->payload = payload;
+  return ParseState::kSuccess;
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/types.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+// Sent by the client at the start of the connection, before the first frame.
+// https://httpwg.org/specs/rfc7540.html#ConnectionHeader
+constexpr std::string_view kConnectionPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+constexpr size_t kFrameHeaderSize = 9;
+
+// The protocol allows frames of up to 2^24-1 bytes once SETTINGS_MAX_FRAME_SIZE is raised, but
+// in practice larger frames mean that the data is not aligned to a frame boundary.
+constexpr size_t kMaxFrameSize = 1 << 20;
+
+size_t FindFrameBoundary(std::string_view buf, size_t start_pos);
+
+/**
+ * Parses one frame. The connection preface and the frames that are not needed to decode the
+ * streams (SETTINGS, PING, WINDOW_UPDATE, etc.) are consumed and return kIgnored.
+ *
+ * If the data does not start with a valid frame, it is skipped up to the next frame boundary and
+ * a Frame with data_loss set is returned.
+ */
+ParseState ParseFrame(std::string_view* buf, Frame* frame);
+
+}  // namespace http2
+
+template <>
+inline size_t FindFrameBoundary<http2::Frame>(MessageType /*type*/, std::string_view buf,
+                                              size_t start_pos) {
+  return http2::FindFrameBoundary(buf, start_pos);
+}
+
+template <>
+inline ParseState ParseFrame(MessageType /*type*/, std::string_view* buf, http2::Frame* frame) {
+  return http2::ParseFrame(buf, frame);
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
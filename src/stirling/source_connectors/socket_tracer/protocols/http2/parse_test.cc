@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/parse.h"
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+using ::testing::StrEq;
+
+std::string FrameBytes(FrameType type, uint8_t flags, uint32_t stream_id,
+                       std::string_view payload) {
+  std::string frame;
+  frame.push_back(static_cast<char>(payload.size() >> 16));
+  frame.push_back(static_cast<char>(payload.size() >> 8));
+  frame.push_back(static_cast<char>(payload.size()));
+  frame.push_back(static_cast<char>(type));
+  frame.push_back(static_cast<char>(flags));
+  frame.push_back(static_cast<char>(stream_id >> 24));
+  frame.push_back(static_cast<char>(stream_id >> 16));
+  frame.push_back(static_cast<char>(stream_id >> 8));
+  frame.push_back(static_cast<char>(stream_id));
+  frame.append(payload);
+  return frame;
+}
+
+TEST(ParseFrameTest, PrefaceAndControlFramesAreIgnored) {
+  std::string window_update("\x00\x0f\x00\x01", 4);
+  std::string data = std::string(kConnectionPreface) +
+                     FrameBytes(FrameType::kSettings, 0, 0, std::string(6, '\0')) +
+                     FrameBytes(FrameType::kWindowUpdate, 0, 0, window_update);
+  std::string_view buf = data;
+  Frame frame;
+
+  EXPECT_EQ(ParseFrame(&buf, &frame), ParseState::kIgnored);
+  EXPECT_EQ(buf.size(), data.size() - kConnectionPreface.size());
+  EXPECT_EQ(ParseFrame(&buf, &frame), ParseState::kIgnored);
+  EXPECT_EQ(ParseFrame(&buf, &frame), ParseState::kIgnored);
+  EXPECT_TRUE(buf.empty());
+}
+
+TEST(ParseFrameTest, StreamFrames) {
+  std::string data = FrameBytes(FrameType::kHeaders, frame_flags::kEndHeaders, 1, "\x82\x86") +
+                     FrameBytes(FrameType::kData, frame_flags::kEndStream, 1, "hello");
+  std::string_view buf = data;
+
+  Frame frame;
+  ASSERT_EQ(ParseFrame(&buf, &frame), ParseState::kSuccess);
+  EXPECT_EQ(frame.type, FrameType::kHeaders);
+  EXPECT_EQ(frame.flags, frame_flags::kEndHeaders);
+  EXPECT_EQ(frame.stream_id, 1);
+  EXPECT_THAT(frame.payload, StrEq("\x82\x86"));
+
+  frame = {};
+  ASSERT_EQ(ParseFrame(&buf, &frame), ParseState::kSuccess);
+  EXPECT_EQ(frame.type, FrameType::kData);
+  EXPECT_EQ(frame.flags, frame_flags::kEndStream);
+  EXPECT_THAT(frame.payload, StrEq("hello"));
+  EXPECT_FALSE(frame.data_loss);
+  EXPECT_TRUE(buf.empty());
+}
+
+TEST(ParseFrameTest, NeedsMoreData) {
+  Frame frame;
+
+  std::string_view buf = kConnectionPreface.substr(0, 10);
+  EXPECT_EQ(ParseFrame(&buf, &frame), ParseState::kNeedsMoreData);
+
+  std::string data = FrameBytes(FrameType::kData, 0, 1, "hello");
+  buf = std::string_view(data).substr(0, 5);
+  EXPECT_EQ(ParseFrame(&buf, &frame), ParseState::kNeedsMoreData);
+  buf = std::string_view(data).substr(0, data.size() - 1);
+  EXPECT_EQ(ParseFrame(&buf, &frame), ParseState::kNeedsMoreData);
+}
+
+TEST(ParseFrameTest, SkipsToNextFrameAfterGarbage) {
+  std::string data = "the rest of a lost frame" +
+                     FrameBytes(FrameType::kData, frame_flags::kEndStream, 3, "hello");
+  std::string_view buf = data;
+
+  Frame frame;
+  ASSERT_EQ(ParseFrame(&buf, &frame), ParseState::kSuccess);
+  EXPECT_TRUE(frame.data_loss);
+
+  frame = {};
+  ASSERT_EQ(ParseFrame(&buf, &frame), ParseState::kSuccess);
+  EXPECT_EQ(frame.stream_id, 3);
+  EXPECT_THAT(frame.payload, StrEq("hello"));
+}
+
+TEST(FindFrameBoundaryTest, Basic) {
+  std::string frame = FrameBytes(FrameType::kHeaders, frame_flags::kEndHeaders, 1, "\x82\x86");
+  std::string data = "some text" + frame;
+  EXPECT_EQ(FindFrameBoundary(data, 0), 9);
+
+  data = "some text" + std::string(kConnectionPreface);
+  EXPECT_EQ(FindFrameBoundary(data, 0), 9);
+
+  EXPECT_EQ(FindFrameBoundary("some text", 0), std::string::npos);
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -27,17 +27,7 @@ namespace http2 {
 
 void ProcessHTTP2Streams(HTTP2StreamsContainer* http2_streams_container, bool conn_closed,
                          RecordsWithErrorCount<http2::Record>* result) {
-  auto& streams = *http2_streams_container->mutable_streams();
-  auto iter = streams.begin();
-  while (iter != streams.end()) {
-    auto& stream = iter->second;
-    if (conn_closed || stream.StreamEnded()) {
-      result->records.emplace_back(std::move(stream));
-      streams.erase(iter++);
-    } else {
-      ++iter;
-    }
-  }
+  http2_streams_container->ConsumeStreams(conn_closed, &result->records);
 }
 
 }  // namespace http2
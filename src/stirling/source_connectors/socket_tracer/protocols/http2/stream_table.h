@@ -0,0 +1,164 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+/**
+ * StreamTable is a flat, open-addressed (linear probing) table keyed by HTTP2 stream ID.
+ *
+ * A connection side only uses stream IDs of one parity, and allocates them in increasing
+ * order, so the live IDs form a narrow window. Indexing by ID/2 maps such a window onto
+ * consecutive slots, which means lookups almost never probe and iteration is cache friendly.
+ * Arbitrary IDs (e.g. a jump ahead) are still handled correctly, they just probe.
+ */
+template <typename TValue>
+class StreamTable {
+ public:
+  /**
+   * Returns the value for the stream ID, or nullptr if there is none.
+   */
+  TValue* Find(uint32_t id) {
+    if (slots_.empty()) {
+      return nullptr;
+    }
+    for (size_t i = Home(id);; i = Next(i)) {
+      Slot& slot = slots_[i];
+      if (!slot.value.has_value()) {
+        return nullptr;
+      }
+      if (slot.id == id) {
+        return &*slot.value;
+      }
+    }
+  }
+
+  const TValue* Find(uint32_t id) const { return const_cast<StreamTable*>(this)->Find(id); }
+
+  /**
+   * Returns the value for the stream ID, default constructing it if there is none.
+   * Pointers to values are invalidated by further insertions, so values that must stay put
+   * should be held by pointer.
+   */
+  TValue& FindOrInsert(uint32_t id) {
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+      Grow();
+    }
+    size_t i = Home(id);
+    for (; slots_[i].value.has_value(); i = Next(i)) {
+      if (slots_[i].id == id) {
+        return *slots_[i].value;
+      }
+    }
+    slots_[i].id = id;
+    slots_[i].value.emplace();
+    ++size_;
+    return *slots_[i].value;
+  }
+
+  /**
+   * Erases the stream ID, if present.
+   */
+  void Erase(uint32_t id) {
+    if (slots_.empty()) {
+      return;
+    }
+    size_t i = Home(id);
+    for (; slots_[i].id != id || !slots_[i].value.has_value(); i = Next(i)) {
+      if (!slots_[i].value.has_value()) {
+        return;
+      }
+    }
+    slots_[i].value.reset();
+    --size_;
+
+    // Backward shift deletion: move later entries of the probe run into the hole,
+    // so lookups never need tombstones.
+    for (size_t j = Next(i); slots_[j].value.has_value(); j = Next(j)) {
+      size_t home = Home(slots_[j].id);
+      // Move the entry if its home is not cyclically within (i, j].
+      bool in_range = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if (!in_range) {
+        slots_[i] = std::move(slots_[j]);
+        slots_[j].value.reset();
+        i = j;
+      }
+    }
+  }
+
+  /**
+   * Calls f(id, value) for every stream, in no particular order.
+   * f must not insert nor erase.
+   */
+  template <typename TFunc>
+  void ForEach(TFunc f) {
+    for (Slot& slot : slots_) {
+      if (slot.value.has_value()) {
+        f(slot.id, *slot.value);
+      }
+    }
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void Clear() {
+    slots_.clear();
+    size_ = 0;
+  }
+
+ private:
+  struct Slot {
+    uint32_t id = 0;
+    std::optional<TValue> value;
+  };
+
+  static constexpr size_t kMinCapacity = 8;
+
+  size_t Home(uint32_t id) const { return (id >> 1) & (slots_.size() - 1); }
+  size_t Next(size_t i) const { return (i + 1) & (slots_.size() - 1); }
+
+  void Grow() {
+    std::vector<Slot> old = std::move(slots_);
+    slots_ = std::vector<Slot>(old.empty() ? kMinCapacity : old.size() * 2);
+    size_ = 0;
+    for (Slot& slot : old) {
+      if (slot.value.has_value()) {
+        FindOrInsert(slot.id) = std::move(*slot.value);
+      }
+    }
+  }
+
+  // Capacity is always a power of 2.
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/stream_table.h"
+
+#include <set>
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+TEST(StreamTableTest, InsertFindErase) {
+  StreamTable<std::string> table;
+  EXPECT_EQ(table.Find(1), nullptr);
+  table.Erase(1);
+
+  table.FindOrInsert(1) = "a";
+  table.FindOrInsert(3) = "b";
+  EXPECT_EQ(table.FindOrInsert(1), "a");
+  EXPECT_EQ(table.size(), 2);
+
+  ASSERT_NE(table.Find(3), nullptr);
+  EXPECT_EQ(*table.Find(3), "b");
+
+  table.Erase(1);
+  EXPECT_EQ(table.Find(1), nullptr);
+  EXPECT_EQ(*table.Find(3), "b");
+  EXPECT_EQ(table.size(), 1);
+
+  table.Clear();
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.Find(3), nullptr);
+}
+
+// Mixes a sliding window of IDs with colliding and far away IDs, and checks against std::set.
+TEST(StreamTableTest, MatchesReference) {
+  StreamTable<uint32_t> table;
+  std::set<uint32_t> reference;
+
+  for (uint32_t id = 1; id < 20000; id += 2) {
+    table.FindOrInsert(id) = id;
+    reference.insert(id);
+    // IDs of the other parity, and IDs far ahead, land on the same slots.
+    if (id % 7 == 0) {
+      table.FindOrInsert(id + 1) = id + 1;
+      reference.insert(id + 1);
+    }
+    if (id % 101 == 0) {
+      table.FindOrInsert(id + 1000000) = id + 1000000;
+      reference.insert(id + 1000000);
+    }
+    if (id > 200) {
+      table.Erase(id - 200);
+      reference.erase(id - 200);
+    }
+    if (id % 13 == 0) {
+      table.Erase(id + 1 - 14);
+      reference.erase(id + 1 - 14);
+    }
+  }
+
+  EXPECT_EQ(table.size(), reference.size());
+  for (uint32_t id : reference) {
+    ASSERT_NE(table.Find(id), nullptr) << id;
+    EXPECT_EQ(*table.Find(id), id);
+  }
+  for (uint32_t id = 1; id < 20000; ++id) {
+    EXPECT_EQ(table.Find(id) != nullptr, reference.count(id) > 0) << id;
+  }
+
+  std::set<uint32_t> visited;
+  table.ForEach([&visited](uint32_t id, uint32_t value) {
+    EXPECT_EQ(id, value);
+    visited.insert(id);
+  });
+  EXPECT_EQ(visited, reference);
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
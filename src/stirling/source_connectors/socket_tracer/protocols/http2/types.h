@@ -25,8 +25,10 @@
 #include <utility>
 
 #include <absl/strings/str_join.h>
+#include <magic_enum.hpp>
 
 #include "src/common/base/utils.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"  // For FrameBase
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
 #include "src/stirling/utils/utils.h"
 
@@ -182,6 +184,53 @@ struct Stream {
 
 using Record = Stream;
 
+// The frame types defined in https://httpwg.org/specs/rfc7540.html#FrameTypes.
+enum class FrameType : uint8_t {
+  kData = 0x0,
+  kHeaders = 0x1,
+  kPriority = 0x2,
+  kRSTStream = 0x3,
+  kSettings = 0x4,
+  kPushPromise = 0x5,
+  kPing = 0x6,
+  kGoAway = 0x7,
+  kWindowUpdate = 0x8,
+  kContinuation = 0x9,
+};
+
+namespace frame_flags {
+
+constexpr uint8_t kEndStream = 0x1;
+constexpr uint8_t kAck = 0x1;
+constexpr uint8_t kEndHeaders = 0x4;
+constexpr uint8_t kPadded = 0x8;
+constexpr uint8_t kPriority = 0x20;
+
+}  // namespace frame_flags
+
+// An HTTP/2 frame (https://httpwg.org/specs/rfc7540.html#FrameHeader), parsed from the socket
+// data captured by the kprobes. Only used for the HTTP/2 traffic that is not traced by the Go
+// uprobes; the frames are then decoded into Streams.
+struct Frame : public FrameBase {
+  FrameType type = FrameType::kData;
+  uint8_t flags = 0;
+  uint32_t stream_id = 0;
+  // The frame payload, including any padding.
+  std::string payload;
+
+  // If true, this is not a frame read from the data, but a marker of where some of the data was
+  // lost.
+  bool data_loss = false;
+
+  size_t ByteSize() const override { return payload.size(); }
+
+  std::string ToString() const {
+    return absl::Substitute("base=[$0] type=$1 flags=$2 stream_id=$3 payload=$4 data_loss=$5",
+                            FrameBase::ToString(), magic_enum::enum_name(type), flags, stream_id,
+                            BytesToString<bytes_format::HexAsciiMix>(payload), data_loss);
+  }
+};
+
 struct ProtocolTraits {
   using frame_type = Stream;
   using record_type = Record;
@@ -0,0 +1,823 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/packet_decoder.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+//-----------------------------------------------------------------------------
+// Primitive types
+//-----------------------------------------------------------------------------
+
+void PacketDecoder::SetAPIInfo(APIKey api_key, int16_t api_version) {
+  api_key_ = api_key;
+  api_version_ = api_version;
+  switch (api_key) {
+    case APIKey::kProduce:
+      is_flexible_ = api_version >= kProduceFlexibleVersion;
+      break;
+    case APIKey::kFetch:
+      is_flexible_ = api_version >= kFetchFlexibleVersion;
+      break;
+    case APIKey::kMetadata:
+      is_flexible_ = api_version >= kMetadataFlexibleVersion;
+      break;
+    case APIKey::kOffsetCommit:
+      is_flexible_ = api_version >= kOffsetCommitFlexibleVersion;
+      break;
+    default:
+      // Bodies of the other API keys are not decoded.
+      is_flexible_ = false;
+  }
+}
+
+StatusOr<int8_t> PacketDecoder::ExtractInt8() { return binary_decoder_.ExtractInt<int8_t>(); }
+
+StatusOr<int16_t> PacketDecoder::ExtractInt16() { return binary_decoder_.ExtractInt<int16_t>(); }
+
+StatusOr<int32_t> PacketDecoder::ExtractInt32() { return binary_decoder_.ExtractInt<int32_t>(); }
+
+StatusOr<int64_t> PacketDecoder::ExtractInt64() { return binary_decoder_.ExtractInt<int64_t>(); }
+
+StatusOr<bool> PacketDecoder::ExtractBool() {
+  PL_ASSIGN_OR_RETURN(int8_t val, binary_decoder_.ExtractInt<int8_t>());
+  return val != 0;
+}
+
+StatusOr<uint32_t> PacketDecoder::ExtractUnsignedVarint() {
+  constexpr int kMaxVarintBytes = 5;
+  uint32_t value = 0;
+  for (int i = 0; i < kMaxVarintBytes; ++i) {
+    PL_ASSIGN_OR_RETURN(uint8_t b, binary_decoder_.ExtractChar<uint8_t>());
+    value |= static_cast<uint32_t>(b & 0x7f) << (7 * i);
+    if ((b & 0x80) == 0) {
+      return value;
+    }
+  }
+  return error::Internal("Unsigned varint is longer than $0 bytes.", kMaxVarintBytes);
+}
+
+Status PacketDecoder::SkipBytes(size_t len) {
+  return binary_decoder_.ExtractString(len).status();
+}
+
+StatusOr<std::string> PacketDecoder::ExtractString() {
+  size_t len = 0;
+  if (is_flexible_) {
+    PL_ASSIGN_OR_RETURN(uint32_t n, ExtractUnsignedVarint());
+    if (n == 0) {
+      return error::Internal("Null COMPACT_STRING.");
+    }
+    len = n - 1;
+  } else {
+    PL_ASSIGN_OR_RETURN(int16_t n, ExtractInt16());
+    if (n < 0) {
+      return error::Internal("Negative STRING length $0.", n);
+    }
+    len = n;
+  }
+  PL_ASSIGN_OR_RETURN(std::string_view str, binary_decoder_.ExtractString(len));
+  return std::string(str);
+}
+
+StatusOr<std::string> PacketDecoder::ExtractNullableString() {
+  size_t len = 0;
+  if (is_flexible_) {
+    PL_ASSIGN_OR_RETURN(uint32_t n, ExtractUnsignedVarint());
+    if (n == 0) {
+      return std::string();
+    }
+    len = n - 1;
+  } else {
+    PL_ASSIGN_OR_RETURN(int16_t n, ExtractInt16());
+    if (n < 0) {
+      return std::string();
+    }
+    len = n;
+  }
+  PL_ASSIGN_OR_RETURN(std::string_view str, binary_decoder_.ExtractString(len));
+  return std::string(str);
+}
+
+StatusOr<std::string> PacketDecoder::ExtractUUID() {
+  constexpr size_t kUUIDLength = 16;
+  PL_ASSIGN_OR_RETURN(std::string_view uuid, binary_decoder_.ExtractString(kUUIDLength));
+  return BytesToString<bytes_format::HexCompact>(uuid);
+}
+
+StatusOr<int32_t> PacketDecoder::ExtractRecordsSize() {
+  int32_t len = 0;
+  if (is_flexible_) {
+    PL_ASSIGN_OR_RETURN(uint32_t n, ExtractUnsignedVarint());
+    if (n == 0) {
+      return 0;
+    }
+    len = static_cast<int32_t>(n - 1);
+  } else {
+    PL_ASSIGN_OR_RETURN(len, ExtractInt32());
+    if (len < 0) {
+      return 0;
+    }
+  }
+  PL_RETURN_IF_ERROR(SkipBytes(len));
+  return len;
+}
+
+StatusOr<int32_t> PacketDecoder::ExtractArrayLength() {
+  if (is_flexible_) {
+    PL_ASSIGN_OR_RETURN(uint32_t n, ExtractUnsignedVarint());
+    return static_cast<int32_t>(n) - 1;
+  }
+  PL_ASSIGN_OR_RETURN(int32_t len, ExtractInt32());
+  return len < 0 ? -1 : len;
+}
+
+Status PacketDecoder::ExtractTagSection() {
+  if (!is_flexible_) {
+    return Status::OK();
+  }
+  PL_ASSIGN_OR_RETURN(uint32_t num_fields, ExtractUnsignedVarint());
+  for (uint32_t i = 0; i < num_fields; ++i) {
+    PL_ASSIGN_OR_RETURN(uint32_t tag, ExtractUnsignedVarint());
+    PL_UNUSED(tag);
+    PL_ASSIGN_OR_RETURN(uint32_t size, ExtractUnsignedVarint());
+    PL_RETURN_IF_ERROR(SkipBytes(size));
+  }
+  return Status::OK();
+}
+
+Status PacketDecoder::SkipArray(Status (PacketDecoder::*skip_func)()) {
+  PL_ASSIGN_OR_RETURN(int32_t len, ExtractArrayLength());
+  for (int32_t i = 0; i < len; ++i) {
+    PL_RETURN_IF_ERROR((this->*skip_func)());
+  }
+  return Status::OK();
+}
+
+//-----------------------------------------------------------------------------
+// Headers
+//-----------------------------------------------------------------------------
+
+Status PacketDecoder::ExtractReqHeader(Request* req) {
+  PL_ASSIGN_OR_RETURN(int16_t api_key, ExtractInt16());
+  if (!IsValidAPIKey(api_key)) {
+    return error::Internal("Invalid API key $0.", api_key);
+  }
+  req->api_key = static_cast<APIKey>(api_key);
+  PL_ASSIGN_OR_RETURN(req->api_version, ExtractInt16());
+
+  // The correlation ID was already extracted by the parser.
+  PL_RETURN_IF_ERROR(ExtractInt32());
+
+  // The client ID is a NULLABLE_STRING even in flexible request headers, so it is extracted
+  // before the flexible encoding is enabled.
+  SetAPIInfo(APIKey::kProduce, 0);
+  PL_ASSIGN_OR_RETURN(req->client_id, ExtractNullableString());
+
+  SetAPIInfo(req->api_key, req->api_version);
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return Status::OK();
+}
+
+Status PacketDecoder::ExtractRespHeader() {
+  // The correlation ID was already extracted by the parser.
+  PL_RETURN_IF_ERROR(ExtractInt32());
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return Status::OK();
+}
+
+//-----------------------------------------------------------------------------
+// Produce
+//-----------------------------------------------------------------------------
+
+StatusOr<ProduceReqPartition> PacketDecoder::ExtractProduceReqPartition() {
+  ProduceReqPartition r;
+  PL_ASSIGN_OR_RETURN(r.index, ExtractInt32());
+  PL_ASSIGN_OR_RETURN(r.records_size, ExtractRecordsSize());
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<ProduceReqTopic> PacketDecoder::ExtractProduceReqTopic() {
+  ProduceReqTopic r;
+  PL_ASSIGN_OR_RETURN(r.name, ExtractString());
+  PL_ASSIGN_OR_RETURN(r.partitions, ExtractArray(&PacketDecoder::ExtractProduceReqPartition));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<ProduceReq> PacketDecoder::ExtractProduceReq() {
+  ProduceReq r;
+  if (api_version_ >= 3) {
+    PL_ASSIGN_OR_RETURN(r.transactional_id, ExtractNullableString());
+  }
+  PL_ASSIGN_OR_RETURN(r.acks, ExtractInt16());
+  PL_ASSIGN_OR_RETURN(r.timeout_ms, ExtractInt32());
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractProduceReqTopic));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+Status PacketDecoder::SkipRecordError() {
+  // batch_index, batch_index_error_message
+  PL_RETURN_IF_ERROR(ExtractInt32());
+  PL_RETURN_IF_ERROR(ExtractNullableString());
+  return ExtractTagSection();
+}
+
+StatusOr<ProduceRespPartition> PacketDecoder::ExtractProduceRespPartition() {
+  ProduceRespPartition r;
+  PL_ASSIGN_OR_RETURN(r.index, ExtractInt32());
+  PL_ASSIGN_OR_RETURN(r.error_code, ExtractInt16());
+  PL_ASSIGN_OR_RETURN(r.base_offset, ExtractInt64());
+  if (api_version_ >= 2) {
+    // log_append_time_ms
+    PL_RETURN_IF_ERROR(ExtractInt64());
+  }
+  if (api_version_ >= 5) {
+    // log_start_offset
+    PL_RETURN_IF_ERROR(ExtractInt64());
+  }
+  if (api_version_ >= 8) {
+    PL_RETURN_IF_ERROR(SkipArray(&PacketDecoder::SkipRecordError));
+    PL_ASSIGN_OR_RETURN(r.error_message, ExtractNullableString());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<ProduceRespTopic> PacketDecoder::ExtractProduceRespTopic() {
+  ProduceRespTopic r;
+  PL_ASSIGN_OR_RETURN(r.name, ExtractString());
+  PL_ASSIGN_OR_RETURN(r.partitions, ExtractArray(&PacketDecoder::ExtractProduceRespPartition));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<ProduceResp> PacketDecoder::ExtractProduceResp() {
+  ProduceResp r;
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractProduceRespTopic));
+  if (api_version_ >= 1) {
+    PL_ASSIGN_OR_RETURN(r.throttle_time_ms, ExtractInt32());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+// Fetch
+//-----------------------------------------------------------------------------
+
+StatusOr<FetchReqPartition> PacketDecoder::ExtractFetchReqPartition() {
+  FetchReqPartition r;
+  PL_ASSIGN_OR_RETURN(r.index, ExtractInt32());
+  if (api_version_ >= 9) {
+    // current_leader_epoch
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  PL_ASSIGN_OR_RETURN(r.fetch_offset, ExtractInt64());
+  if (api_version_ >= 12) {
+    // last_fetched_epoch
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  if (api_version_ >= 5) {
+    // log_start_offset
+    PL_RETURN_IF_ERROR(ExtractInt64());
+  }
+  PL_ASSIGN_OR_RETURN(r.max_bytes, ExtractInt32());
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<FetchReqTopic> PacketDecoder::ExtractFetchReqTopic() {
+  FetchReqTopic r;
+  if (api_version_ >= 13) {
+    PL_ASSIGN_OR_RETURN(r.name, ExtractUUID());
+  } else {
+    PL_ASSIGN_OR_RETURN(r.name, ExtractString());
+  }
+  PL_ASSIGN_OR_RETURN(r.partitions, ExtractArray(&PacketDecoder::ExtractFetchReqPartition));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+Status PacketDecoder::SkipForgottenTopic() {
+  if (api_version_ >= 13) {
+    PL_RETURN_IF_ERROR(ExtractUUID());
+  } else {
+    PL_RETURN_IF_ERROR(ExtractString());
+  }
+  PL_RETURN_IF_ERROR(SkipArray(&PacketDecoder::SkipInt32));
+  return ExtractTagSection();
+}
+
+StatusOr<FetchReq> PacketDecoder::ExtractFetchReq() {
+  FetchReq r;
+  PL_ASSIGN_OR_RETURN(r.replica_id, ExtractInt32());
+  // max_wait_ms, min_bytes
+  PL_RETURN_IF_ERROR(ExtractInt32());
+  PL_RETURN_IF_ERROR(ExtractInt32());
+  if (api_version_ >= 3) {
+    // max_bytes
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  if (api_version_ >= 4) {
+    // isolation_level
+    PL_RETURN_IF_ERROR(ExtractInt8());
+  }
+  if (api_version_ >= 7) {
+    // session_id, session_epoch
+    PL_RETURN_IF_ERROR(ExtractInt32());
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractFetchReqTopic));
+  if (api_version_ >= 7) {
+    PL_RETURN_IF_ERROR(SkipArray(&PacketDecoder::SkipForgottenTopic));
+  }
+  if (api_version_ >= 11) {
+    // rack_id
+    PL_RETURN_IF_ERROR(ExtractString());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+Status PacketDecoder::SkipAbortedTransaction() {
+  // producer_id, first_offset
+  PL_RETURN_IF_ERROR(ExtractInt64());
+  PL_RETURN_IF_ERROR(ExtractInt64());
+  return ExtractTagSection();
+}
+
+StatusOr<FetchRespPartition> PacketDecoder::ExtractFetchRespPartition() {
+  FetchRespPartition r;
+  PL_ASSIGN_OR_RETURN(r.index, ExtractInt32());
+  PL_ASSIGN_OR_RETURN(r.error_code, ExtractInt16());
+  PL_ASSIGN_OR_RETURN(r.high_watermark, ExtractInt64());
+  if (api_version_ >= 4) {
+    // last_stable_offset
+    PL_RETURN_IF_ERROR(ExtractInt64());
+  }
+  if (api_version_ >= 5) {
+    // log_start_offset
+    PL_RETURN_IF_ERROR(ExtractInt64());
+  }
+  if (api_version_ >= 4) {
+    PL_RETURN_IF_ERROR(SkipArray(&PacketDecoder::SkipAbortedTransaction));
+  }
+  if (api_version_ >= 11) {
+    // preferred_read_replica
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  // The fetched record batches make up most of the response, and are skipped without a copy.
+  PL_ASSIGN_OR_RETURN(r.records_size, ExtractRecordsSize());
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<FetchRespTopic> PacketDecoder::ExtractFetchRespTopic() {
+  FetchRespTopic r;
+  if (api_version_ >= 13) {
+    PL_ASSIGN_OR_RETURN(r.name, ExtractUUID());
+  } else {
+    PL_ASSIGN_OR_RETURN(r.name, ExtractString());
+  }
+  PL_ASSIGN_OR_RETURN(r.partitions, ExtractArray(&PacketDecoder::ExtractFetchRespPartition));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<FetchResp> PacketDecoder::ExtractFetchResp() {
+  FetchResp r;
+  if (api_version_ >= 1) {
+    PL_ASSIGN_OR_RETURN(r.throttle_time_ms, ExtractInt32());
+  }
+  if (api_version_ >= 7) {
+    PL_ASSIGN_OR_RETURN(r.error_code, ExtractInt16());
+    PL_ASSIGN_OR_RETURN(r.session_id, ExtractInt32());
+  }
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractFetchRespTopic));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+// Metadata
+//-----------------------------------------------------------------------------
+
+StatusOr<std::string> PacketDecoder::ExtractMetadataReqTopic() {
+  std::string name;
+  if (api_version_ >= 10) {
+    // topic_id
+    PL_RETURN_IF_ERROR(ExtractUUID());
+    PL_ASSIGN_OR_RETURN(name, ExtractNullableString());
+  } else {
+    PL_ASSIGN_OR_RETURN(name, ExtractString());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return name;
+}
+
+StatusOr<MetadataReq> PacketDecoder::ExtractMetadataReq() {
+  MetadataReq r;
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractMetadataReqTopic));
+  if (api_version_ >= 4) {
+    PL_ASSIGN_OR_RETURN(r.allow_auto_topic_creation, ExtractBool());
+  }
+  if (api_version_ >= 8 && api_version_ <= 10) {
+    // include_cluster_authorized_operations
+    PL_RETURN_IF_ERROR(ExtractBool());
+  }
+  if (api_version_ >= 8) {
+    // include_topic_authorized_operations
+    PL_RETURN_IF_ERROR(ExtractBool());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<MetadataRespBroker> PacketDecoder::ExtractMetadataRespBroker() {
+  MetadataRespBroker r;
+  PL_ASSIGN_OR_RETURN(r.node_id, ExtractInt32());
+  PL_ASSIGN_OR_RETURN(r.host, ExtractString());
+  PL_ASSIGN_OR_RETURN(r.port, ExtractInt32());
+  if (api_version_ >= 1) {
+    // rack
+    PL_RETURN_IF_ERROR(ExtractNullableString());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+Status PacketDecoder::SkipMetadataRespPartition() {
+  // error_code, partition_index, leader_id
+  PL_RETURN_IF_ERROR(ExtractInt16());
+  PL_RETURN_IF_ERROR(ExtractInt32());
+  PL_RETURN_IF_ERROR(ExtractInt32());
+  if (api_version_ >= 7) {
+    // leader_epoch
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  // replica_nodes, isr_nodes
+  PL_RETURN_IF_ERROR(SkipArray(&PacketDecoder::SkipInt32));
+  PL_RETURN_IF_ERROR(SkipArray(&PacketDecoder::SkipInt32));
+  if (api_version_ >= 5) {
+    // offline_replicas
+    PL_RETURN_IF_ERROR(SkipArray(&PacketDecoder::SkipInt32));
+  }
+  return ExtractTagSection();
+}
+
+StatusOr<MetadataRespTopic> PacketDecoder::ExtractMetadataRespTopic() {
+  MetadataRespTopic r;
+  PL_ASSIGN_OR_RETURN(r.error_code, ExtractInt16());
+  PL_ASSIGN_OR_RETURN(r.name, ExtractNullableString());
+  if (api_version_ >= 10) {
+    // topic_id
+    PL_RETURN_IF_ERROR(ExtractUUID());
+  }
+  if (api_version_ >= 1) {
+    // is_internal
+    PL_RETURN_IF_ERROR(ExtractBool());
+  }
+  PL_ASSIGN_OR_RETURN(r.num_partitions, ExtractArrayLength());
+  for (int32_t i = 0; i < r.num_partitions; ++i) {
+    PL_RETURN_IF_ERROR(SkipMetadataRespPartition());
+  }
+  r.num_partitions = std::max(r.num_partitions, 0);
+  if (api_version_ >= 8) {
+    // topic_authorized_operations
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<MetadataResp> PacketDecoder::ExtractMetadataResp() {
+  MetadataResp r;
+  if (api_version_ >= 3) {
+    // throttle_time_ms
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  PL_ASSIGN_OR_RETURN(r.brokers, ExtractArray(&PacketDecoder::ExtractMetadataRespBroker));
+  if (api_version_ >= 2) {
+    // cluster_id
+    PL_RETURN_IF_ERROR(ExtractNullableString());
+  }
+  if (api_version_ >= 1) {
+    PL_ASSIGN_OR_RETURN(r.controller_id, ExtractInt32());
+  }
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractMetadataRespTopic));
+  if (api_version_ >= 8 && api_version_ <= 10) {
+    // cluster_authorized_operations
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+// OffsetCommit
+//-----------------------------------------------------------------------------
+
+StatusOr<OffsetCommitReqPartition> PacketDecoder::ExtractOffsetCommitReqPartition() {
+  OffsetCommitReqPartition r;
+  PL_ASSIGN_OR_RETURN(r.index, ExtractInt32());
+  PL_ASSIGN_OR_RETURN(r.committed_offset, ExtractInt64());
+  if (api_version_ >= 6) {
+    // committed_leader_epoch
+    PL_RETURN_IF_ERROR(ExtractInt32());
+  }
+  if (api_version_ == 1) {
+    // commit_timestamp
+    PL_RETURN_IF_ERROR(ExtractInt64());
+  }
+  // committed_metadata
+  PL_RETURN_IF_ERROR(ExtractNullableString());
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<OffsetCommitReqTopic> PacketDecoder::ExtractOffsetCommitReqTopic() {
+  OffsetCommitReqTopic r;
+  PL_ASSIGN_OR_RETURN(r.name, ExtractString());
+  PL_ASSIGN_OR_RETURN(r.partitions, ExtractArray(&PacketDecoder::ExtractOffsetCommitReqPartition));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<OffsetCommitReq> PacketDecoder::ExtractOffsetCommitReq() {
+  OffsetCommitReq r;
+  PL_ASSIGN_OR_RETURN(r.group_id, ExtractString());
+  if (api_version_ >= 1) {
+    PL_ASSIGN_OR_RETURN(r.generation_id, ExtractInt32());
+    PL_ASSIGN_OR_RETURN(r.member_id, ExtractString());
+  }
+  if (api_version_ >= 7) {
+    // group_instance_id
+    PL_RETURN_IF_ERROR(ExtractNullableString());
+  }
+  if (api_version_ >= 2 && api_version_ <= 4) {
+    // retention_time_ms
+    PL_RETURN_IF_ERROR(ExtractInt64());
+  }
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractOffsetCommitReqTopic));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<OffsetCommitRespPartition> PacketDecoder::ExtractOffsetCommitRespPartition() {
+  OffsetCommitRespPartition r;
+  PL_ASSIGN_OR_RETURN(r.index, ExtractInt32());
+  PL_ASSIGN_OR_RETURN(r.error_code, ExtractInt16());
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<OffsetCommitRespTopic> PacketDecoder::ExtractOffsetCommitRespTopic() {
+  OffsetCommitRespTopic r;
+  PL_ASSIGN_OR_RETURN(r.name, ExtractString());
+  PL_ASSIGN_OR_RETURN(r.partitions,
+                      ExtractArray(&PacketDecoder::ExtractOffsetCommitRespPartition));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+StatusOr<OffsetCommitResp> PacketDecoder::ExtractOffsetCommitResp() {
+  OffsetCommitResp r;
+  if (api_version_ >= 3) {
+    PL_ASSIGN_OR_RETURN(r.throttle_time_ms, ExtractInt32());
+  }
+  PL_ASSIGN_OR_RETURN(r.topics, ExtractArray(&PacketDecoder::ExtractOffsetCommitRespTopic));
+  PL_RETURN_IF_ERROR(ExtractTagSection());
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+// JSON
+//-----------------------------------------------------------------------------
+
+namespace {
+
+void WriteString(std::string_view key, std::string_view val, JSONWriter* writer) {
+  writer->Key(key.data(), key.size());
+  writer->String(val.data(), val.size());
+}
+
+void WriteInt(std::string_view key, int64_t val, JSONWriter* writer) {
+  writer->Key(key.data(), key.size());
+  writer->Int64(val);
+}
+
+template <typename TElement>
+void WriteArray(std::string_view key, const std::vector<TElement>& elements, JSONWriter* writer) {
+  writer->Key(key.data(), key.size());
+  writer->StartArray();
+  for (const auto& element : elements) {
+    element.ToJSON(writer);
+  }
+  writer->EndArray();
+}
+
+}  // namespace
+
+void ProduceReqPartition::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("index", index, writer);
+  WriteInt("records_size", records_size, writer);
+  writer->EndObject();
+}
+
+void ProduceReqTopic::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("name", name, writer);
+  WriteArray("partitions", partitions, writer);
+  writer->EndObject();
+}
+
+void ProduceReq::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("transactional_id", transactional_id, writer);
+  WriteInt("acks", acks, writer);
+  WriteInt("timeout_ms", timeout_ms, writer);
+  WriteArray("topics", topics, writer);
+  writer->EndObject();
+}
+
+void ProduceRespPartition::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("index", index, writer);
+  WriteInt("error_code", error_code, writer);
+  WriteInt("base_offset", base_offset, writer);
+  WriteString("error_message", error_message, writer);
+  writer->EndObject();
+}
+
+void ProduceRespTopic::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("name", name, writer);
+  WriteArray("partitions", partitions, writer);
+  writer->EndObject();
+}
+
+void ProduceResp::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteArray("topics", topics, writer);
+  WriteInt("throttle_time_ms", throttle_time_ms, writer);
+  writer->EndObject();
+}
+
+void FetchReqPartition::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("index", index, writer);
+  WriteInt("fetch_offset", fetch_offset, writer);
+  WriteInt("max_bytes", max_bytes, writer);
+  writer->EndObject();
+}
+
+void FetchReqTopic::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("name", name, writer);
+  WriteArray("partitions", partitions, writer);
+  writer->EndObject();
+}
+
+void FetchReq::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("replica_id", replica_id, writer);
+  WriteArray("topics", topics, writer);
+  writer->EndObject();
+}
+
+void FetchRespPartition::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("index", index, writer);
+  WriteInt("error_code", error_code, writer);
+  WriteInt("high_watermark", high_watermark, writer);
+  WriteInt("records_size", records_size, writer);
+  writer->EndObject();
+}
+
+void FetchRespTopic::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("name", name, writer);
+  WriteArray("partitions", partitions, writer);
+  writer->EndObject();
+}
+
+void FetchResp::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("throttle_time_ms", throttle_time_ms, writer);
+  WriteInt("error_code", error_code, writer);
+  WriteInt("session_id", session_id, writer);
+  WriteArray("topics", topics, writer);
+  writer->EndObject();
+}
+
+void MetadataReq::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  writer->Key("topics");
+  writer->StartArray();
+  for (const auto& topic : topics) {
+    writer->String(topic.data(), topic.size());
+  }
+  writer->EndArray();
+  writer->Key("allow_auto_topic_creation");
+  writer->Bool(allow_auto_topic_creation);
+  writer->EndObject();
+}
+
+void MetadataRespBroker::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("node_id", node_id, writer);
+  WriteString("host", host, writer);
+  WriteInt("port", port, writer);
+  writer->EndObject();
+}
+
+void MetadataRespTopic::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("error_code", error_code, writer);
+  WriteString("name", name, writer);
+  WriteInt("num_partitions", num_partitions, writer);
+  writer->EndObject();
+}
+
+void MetadataResp::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteArray("brokers", brokers, writer);
+  WriteInt("controller_id", controller_id, writer);
+  WriteArray("topics", topics, writer);
+  writer->EndObject();
+}
+
+void OffsetCommitReqPartition::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("index", index, writer);
+  WriteInt("committed_offset", committed_offset, writer);
+  writer->EndObject();
+}
+
+void OffsetCommitReqTopic::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("name", name, writer);
+  WriteArray("partitions", partitions, writer);
+  writer->EndObject();
+}
+
+void OffsetCommitReq::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("group_id", group_id, writer);
+  WriteInt("generation_id", generation_id, writer);
+  WriteString("member_id", member_id, writer);
+  WriteArray("topics", topics, writer);
+  writer->EndObject();
+}
+
+void OffsetCommitRespPartition::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("index", index, writer);
+  WriteInt("error_code", error_code, writer);
+  writer->EndObject();
+}
+
+void OffsetCommitRespTopic::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteString("name", name, writer);
+  WriteArray("partitions", partitions, writer);
+  writer->EndObject();
+}
+
+void OffsetCommitResp::ToJSON(JSONWriter* writer) const {
+  writer->StartObject();
+  WriteInt("throttle_time_ms", throttle_time_ms, writer);
+  WriteArray("topics", topics, writer);
+  writer->EndObject();
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,352 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/types.h"
+#include "src/stirling/utils/binary_decoder.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+using JSONWriter = rapidjson::Writer<rapidjson::StringBuffer>;
+
+// The structs below hold the decoded fields of the API keys that have a decoder. They only keep
+// the fields that are useful in a record; the other fields are consumed but dropped. Record
+// batches (the produced and fetched messages) are never copied, only their size is kept.
+// See https://kafka.apache.org/protocol.html#protocol_messages for the schemas.
+
+struct ProduceReqPartition {
+  int32_t index = 0;
+  int32_t records_size = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct ProduceReqTopic {
+  std::string name;
+  std::vector<ProduceReqPartition> partitions;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct ProduceReq {
+  std::string transactional_id;
+  int16_t acks = 0;
+  int32_t timeout_ms = 0;
+  std::vector<ProduceReqTopic> topics;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct ProduceRespPartition {
+  int32_t index = 0;
+  int16_t error_code = 0;
+  int64_t base_offset = 0;
+  std::string error_message;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct ProduceRespTopic {
+  std::string name;
+  std::vector<ProduceRespPartition> partitions;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct ProduceResp {
+  std::vector<ProduceRespTopic> topics;
+  int32_t throttle_time_ms = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct FetchReqPartition {
+  int32_t index = 0;
+  int64_t fetch_offset = 0;
+  int32_t max_bytes = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct FetchReqTopic {
+  // The topic name, or the hex topic ID from version 13 on.
+  std::string name;
+  std::vector<FetchReqPartition> partitions;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct FetchReq {
+  int32_t replica_id = 0;
+  std::vector<FetchReqTopic> topics;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct FetchRespPartition {
+  int32_t index = 0;
+  int16_t error_code = 0;
+  int64_t high_watermark = 0;
+  int32_t records_size = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct FetchRespTopic {
+  // The topic name, or the hex topic ID from version 13 on.
+  std::string name;
+  std::vector<FetchRespPartition> partitions;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct FetchResp {
+  int32_t throttle_time_ms = 0;
+  int16_t error_code = 0;
+  int32_t session_id = 0;
+  std::vector<FetchRespTopic> topics;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct MetadataReq {
+  // Empty when the request asks for all the topics.
+  std::vector<std::string> topics;
+  bool allow_auto_topic_creation = false;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct MetadataRespBroker {
+  int32_t node_id = 0;
+  std::string host;
+  int32_t port = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct MetadataRespTopic {
+  int16_t error_code = 0;
+  std::string name;
+  int32_t num_partitions = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct MetadataResp {
+  std::vector<MetadataRespBroker> brokers;
+  int32_t controller_id = 0;
+  std::vector<MetadataRespTopic> topics;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct OffsetCommitReqPartition {
+  int32_t index = 0;
+  int64_t committed_offset = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct OffsetCommitReqTopic {
+  std::string name;
+  std::vector<OffsetCommitReqPartition> partitions;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct OffsetCommitReq {
+  std::string group_id;
+  int32_t generation_id = 0;
+  std::string member_id;
+  std::vector<OffsetCommitReqTopic> topics;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct OffsetCommitRespPartition {
+  int32_t index = 0;
+  int16_t error_code = 0;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct OffsetCommitRespTopic {
+  std::string name;
+  std::vector<OffsetCommitRespPartition> partitions;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+struct OffsetCommitResp {
+  int32_t throttle_time_ms = 0;
+  std::vector<OffsetCommitRespTopic> topics;
+
+  void ToJSON(JSONWriter* writer) const;
+};
+
+/**
+ * PacketDecoder provides a structured interface to process the bytes of a Kafka packet.
+ *
+ * A request is decoded by calling ExtractReqHeader() and then the Extract function of its API
+ * key. A response has no API key, so the API key and version of its request are set with
+ * SetAPIInfo() before calling ExtractRespHeader() and the Extract function.
+ *
+ * If there are not enough bytes to process a type, an error Status is returned.
+ * The decoder is then in an undefined state, and the result of any subsequent calls
+ * to any Extract functions are also undefined.
+ */
+class PacketDecoder {
+ public:
+  /**
+   * Create a packet decoder.
+   *
+   * @param buf A string_view into the packet, after the length field.
+   */
+  explicit PacketDecoder(std::string_view buf) : binary_decoder_(buf) {}
+
+  explicit PacketDecoder(const Packet& packet) : PacketDecoder(packet.msg) {}
+
+  // Sets the schema that the following Extract functions decode. ExtractReqHeader() does this
+  // on its own.
+  void SetAPIInfo(APIKey api_key, int16_t api_version);
+
+  bool eof() const { return binary_decoder_.eof(); }
+
+  // Primitive types.
+  StatusOr<int8_t> ExtractInt8();
+  StatusOr<int16_t> ExtractInt16();
+  StatusOr<int32_t> ExtractInt32();
+  StatusOr<int64_t> ExtractInt64();
+  StatusOr<bool> ExtractBool();
+
+  // UNSIGNED_VARINT: a variable length unsigned integer, 7 bits per byte, low bits first.
+  StatusOr<uint32_t> ExtractUnsignedVarint();
+
+  // STRING, or COMPACT_STRING in flexible versions.
+  StatusOr<std::string> ExtractString();
+
+  // NULLABLE_STRING, or COMPACT_NULLABLE_STRING in flexible versions. A null string is returned
+  // as an empty string.
+  StatusOr<std::string> ExtractNullableString();
+
+  // UUID, returned as 32 hex characters.
+  StatusOr<std::string> ExtractUUID();
+
+  // RECORDS, or COMPACT_RECORDS in flexible versions. The record batches are skipped without
+  // being copied. Returns their size in bytes, and 0 for null records.
+  StatusOr<int32_t> ExtractRecordsSize();
+
+  // The length of an ARRAY, or a COMPACT_ARRAY in flexible versions. Null arrays return -1.
+  StatusOr<int32_t> ExtractArrayLength();
+
+  // TAGGED_FIELDS, only present in flexible versions. The fields are skipped.
+  Status ExtractTagSection();
+
+  // An ARRAY of elements, each extracted by extract_func. Null arrays are returned as empty.
+  template <typename TElement>
+  StatusOr<std::vector<TElement>> ExtractArray(StatusOr<TElement> (PacketDecoder::*extract_func)());
+
+  // The request header (v1, or v2 in flexible versions) and the response header (v0, or v1 in
+  // flexible versions). The correlation ID is already in the Packet, so it is skipped.
+  Status ExtractReqHeader(Request* req);
+  Status ExtractRespHeader();
+
+  StatusOr<ProduceReq> ExtractProduceReq();
+  StatusOr<ProduceResp> ExtractProduceResp();
+  StatusOr<FetchReq> ExtractFetchReq();
+  StatusOr<FetchResp> ExtractFetchResp();
+  StatusOr<MetadataReq> ExtractMetadataReq();
+  StatusOr<MetadataResp> ExtractMetadataResp();
+  StatusOr<OffsetCommitReq> ExtractOffsetCommitReq();
+  StatusOr<OffsetCommitResp> ExtractOffsetCommitResp();
+
+ private:
+  Status SkipBytes(size_t len);
+  StatusOr<int32_t> ExtractInt32Element() { return ExtractInt32(); }
+  StatusOr<std::string> ExtractStringElement() { return ExtractString(); }
+
+  StatusOr<ProduceReqPartition> ExtractProduceReqPartition();
+  StatusOr<ProduceReqTopic> ExtractProduceReqTopic();
+  StatusOr<ProduceRespPartition> ExtractProduceRespPartition();
+  StatusOr<ProduceRespTopic> ExtractProduceRespTopic();
+  StatusOr<FetchReqPartition> ExtractFetchReqPartition();
+  StatusOr<FetchReqTopic> ExtractFetchReqTopic();
+  StatusOr<FetchRespPartition> ExtractFetchRespPartition();
+  StatusOr<FetchRespTopic> ExtractFetchRespTopic();
+  StatusOr<std::string> ExtractMetadataReqTopic();
+  StatusOr<MetadataRespBroker> ExtractMetadataRespBroker();
+  StatusOr<MetadataRespTopic> ExtractMetadataRespTopic();
+  StatusOr<OffsetCommitReqPartition> ExtractOffsetCommitReqPartition();
+  StatusOr<OffsetCommitReqTopic> ExtractOffsetCommitReqTopic();
+  StatusOr<OffsetCommitRespPartition> ExtractOffsetCommitRespPartition();
+  StatusOr<OffsetCommitRespTopic> ExtractOffsetCommitRespTopic();
+
+  // Consumes the elements of an ARRAY that are not kept, eg. the aborted transactions of a fetch
+  // response. Each element is consumed by skip_func.
+  Status SkipArray(Status (PacketDecoder::*skip_func)());
+  Status SkipInt32() { return ExtractInt32().status(); }
+  Status SkipAbortedTransaction();
+  Status SkipRecordError();
+  Status SkipForgottenTopic();
+  Status SkipMetadataRespPartition();
+
+  BinaryDecoder binary_decoder_;
+  APIKey api_key_ = APIKey::kProduce;
+  int16_t api_version_ = 0;
+  bool is_flexible_ = false;
+};
+
+template <typename TElement>
+StatusOr<std::vector<TElement>> PacketDecoder::ExtractArray(
+    StatusOr<TElement> (PacketDecoder::*extract_func)()) {
+  PL_ASSIGN_OR_RETURN(int32_t len, ExtractArrayLength());
+  std::vector<TElement> result;
+  if (len <= 0) {
+    return result;
+  }
+  // Each element takes at least one byte, which bounds the allocation on corrupt lengths.
+  if (static_cast<size_t>(len) > binary_decoder_.BufSize()) {
+    return error::ResourceUnavailable("Array length $0 exceeds the remaining $1 bytes.", len,
+                                      binary_decoder_.BufSize());
+  }
+  result.reserve(len);
+  for (int32_t i = 0; i < len; ++i) {
+    PL_ASSIGN_OR_RETURN(TElement element, (this->*extract_func)());
+    result.push_back(std::move(element));
+  }
+  return result;
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/packet_decoder.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/test_data.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/test_utils.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using testutils::PacketBuilder;
+
+// Returns the bytes of a captured packet after its length field, which is what Packet::msg holds.
+template <size_t N>
+std::string_view PacketMsg(const uint8_t (&packet)[N]) {
+  return CreateStringView<char>(CharArrayStringView<uint8_t>(packet)).substr(kMessageLengthBytes);
+}
+
+TEST(KafkaPacketDecoderTest, ExtractUnsignedVarint) {
+  PacketDecoder decoder(ConstStringView("\x00\x7f\x96\x01\xff\xff\xff\xff\x0f\x80"));
+  EXPECT_OK_AND_EQ(decoder.ExtractUnsignedVarint(), 0);
+  EXPECT_OK_AND_EQ(decoder.ExtractUnsignedVarint(), 127);
+  EXPECT_OK_AND_EQ(decoder.ExtractUnsignedVarint(), 150);
+  EXPECT_OK_AND_EQ(decoder.ExtractUnsignedVarint(), 0xffffffff);
+  // Not terminated.
+  EXPECT_NOT_OK(decoder.ExtractUnsignedVarint());
+}
+
+TEST(KafkaPacketDecoderTest, ExtractStrings) {
+  PacketDecoder decoder(ConstStringView("\x00\x03"
+                                        "abc"
+                                        "\xff\xff"
+                                        "\x04"
+                                        "abc"
+                                        "\x00"));
+  EXPECT_OK_AND_EQ(decoder.ExtractString(), "abc");
+  EXPECT_OK_AND_EQ(decoder.ExtractNullableString(), "");
+
+  // Switch to the compact encoding.
+  decoder.SetAPIInfo(APIKey::kFetch, kFetchFlexibleVersion);
+  EXPECT_OK_AND_EQ(decoder.ExtractString(), "abc");
+  EXPECT_OK_AND_EQ(decoder.ExtractNullableString(), "");
+  EXPECT_TRUE(decoder.eof());
+}
+
+TEST(KafkaPacketDecoderTest, ExtractRecordsSize) {
+  PacketDecoder decoder(ConstStringView("\x00\x00\x00\x02"
+                                        "ab"
+                                        "\xff\xff\xff\xff"
+                                        "\x00\x00\x00\x05"
+                                        "ab"));
+  EXPECT_OK_AND_EQ(decoder.ExtractRecordsSize(), 2);
+  EXPECT_OK_AND_EQ(decoder.ExtractRecordsSize(), 0);
+  // Truncated records.
+  EXPECT_NOT_OK(decoder.ExtractRecordsSize());
+}
+
+TEST(KafkaPacketDecoderTest, ExtractArrayWithCorruptLength) {
+  PacketDecoder decoder(ConstStringView("\x7f\xff\xff\xff\x00\x00\x00\x01"));
+  EXPECT_NOT_OK(decoder.ExtractArray(&PacketDecoder::ExtractInt32));
+}
+
+TEST(KafkaPacketDecoderTest, ProduceReqAndResp) {
+  PacketDecoder req_decoder(PacketMsg(testdata::kProduceRequest));
+  Request req;
+  ASSERT_OK(req_decoder.ExtractReqHeader(&req));
+  EXPECT_EQ(req.api_key, APIKey::kProduce);
+  EXPECT_EQ(req.api_version, 9);
+  EXPECT_EQ(req.client_id, "console-producer");
+
+  ASSERT_OK_AND_ASSIGN(ProduceReq produce_req, req_decoder.ExtractProduceReq());
+  EXPECT_TRUE(req_decoder.eof());
+  EXPECT_EQ(produce_req.transactional_id, "");
+  EXPECT_EQ(produce_req.acks, 1);
+  EXPECT_EQ(produce_req.timeout_ms, 1500);
+  ASSERT_EQ(produce_req.topics.size(), 1);
+  EXPECT_EQ(produce_req.topics[0].name, "quickstart-events");
+  ASSERT_EQ(produce_req.topics[0].partitions.size(), 1);
+  EXPECT_EQ(produce_req.topics[0].partitions[0].index, 0);
+  EXPECT_EQ(produce_req.topics[0].partitions[0].records_size, 90);
+
+  PacketDecoder resp_decoder(PacketMsg(testdata::kProduceResponse));
+  resp_decoder.SetAPIInfo(req.api_key, req.api_version);
+  ASSERT_OK(resp_decoder.ExtractRespHeader());
+  ASSERT_OK_AND_ASSIGN(ProduceResp produce_resp, resp_decoder.ExtractProduceResp());
+  EXPECT_TRUE(resp_decoder.eof());
+  ASSERT_EQ(produce_resp.topics.size(), 1);
+  EXPECT_EQ(produce_resp.topics[0].name, "quickstart-events");
+  ASSERT_EQ(produce_resp.topics[0].partitions.size(), 1);
+  EXPECT_EQ(produce_resp.topics[0].partitions[0].error_code, 0);
+  EXPECT_EQ(produce_resp.topics[0].partitions[0].base_offset, 0);
+  EXPECT_EQ(produce_resp.throttle_time_ms, 0);
+}
+
+TEST(KafkaPacketDecoderTest, MetadataReqAndResp) {
+  PacketDecoder req_decoder(PacketMsg(testdata::kMetaDataRequest));
+  Request req;
+  ASSERT_OK(req_decoder.ExtractReqHeader(&req));
+  EXPECT_EQ(req.api_key, APIKey::kMetadata);
+  EXPECT_EQ(req.api_version, 11);
+  EXPECT_EQ(req.client_id, "adminclient-1");
+
+  ASSERT_OK_AND_ASSIGN(MetadataReq metadata_req, req_decoder.ExtractMetadataReq());
+  EXPECT_TRUE(req_decoder.eof());
+  EXPECT_THAT(metadata_req.topics, IsEmpty());
+  EXPECT_TRUE(metadata_req.allow_auto_topic_creation);
+
+  PacketDecoder resp_decoder(PacketMsg(testdata::kMetaDataResponse));
+  resp_decoder.SetAPIInfo(req.api_key, req.api_version);
+  ASSERT_OK(resp_decoder.ExtractRespHeader());
+  ASSERT_OK_AND_ASSIGN(MetadataResp metadata_resp, resp_decoder.ExtractMetadataResp());
+  EXPECT_TRUE(resp_decoder.eof());
+  ASSERT_EQ(metadata_resp.brokers.size(), 1);
+  EXPECT_EQ(metadata_resp.brokers[0].node_id, 0);
+  EXPECT_EQ(metadata_resp.brokers[0].host, "localhost");
+  EXPECT_EQ(metadata_resp.brokers[0].port, 9092);
+  EXPECT_EQ(metadata_resp.controller_id, 0);
+  EXPECT_THAT(metadata_resp.topics, IsEmpty());
+}
+
+TEST(KafkaPacketDecoderTest, FetchReqAndResp) {
+  PacketBuilder req_builder;
+  req_builder.ReqHeader(APIKey::kFetch, 4, 7, "consumer")
+      .Int32(-1)  // replica_id
+      .Int32(500)
+      .Int32(1)
+      .Int32(52428800)
+      .Int8(0)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(2)
+      .Int32(0)
+      .Int64(100)  // fetch_offset
+      .Int32(1048576)
+      .Int32(1)
+      .Int64(200)
+      .Int32(1048576);
+
+  PacketDecoder req_decoder(req_builder.buf());
+  Request req;
+  ASSERT_OK(req_decoder.ExtractReqHeader(&req));
+  ASSERT_OK_AND_ASSIGN(FetchReq fetch_req, req_decoder.ExtractFetchReq());
+  EXPECT_TRUE(req_decoder.eof());
+  EXPECT_EQ(fetch_req.replica_id, -1);
+  ASSERT_EQ(fetch_req.topics.size(), 1);
+  EXPECT_EQ(fetch_req.topics[0].name, "orders");
+  ASSERT_EQ(fetch_req.topics[0].partitions.size(), 2);
+  EXPECT_EQ(fetch_req.topics[0].partitions[1].index, 1);
+  EXPECT_EQ(fetch_req.topics[0].partitions[1].fetch_offset, 200);
+  EXPECT_EQ(fetch_req.topics[0].partitions[1].max_bytes, 1048576);
+
+  PacketBuilder resp_builder;
+  resp_builder.RespHeader(7)
+      .Int32(0)  // throttle_time_ms
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(1)
+      .Int32(0)
+      .Int16(0)
+      .Int64(150)  // high_watermark
+      .Int64(150)
+      .ArrayLength(-1)
+      .Bytes(std::string(1000, 'x'));
+
+  PacketDecoder resp_decoder(resp_builder.buf());
+  resp_decoder.SetAPIInfo(APIKey::kFetch, 4);
+  ASSERT_OK(resp_decoder.ExtractRespHeader());
+  ASSERT_OK_AND_ASSIGN(FetchResp fetch_resp, resp_decoder.ExtractFetchResp());
+  EXPECT_TRUE(resp_decoder.eof());
+  ASSERT_EQ(fetch_resp.topics.size(), 1);
+  ASSERT_EQ(fetch_resp.topics[0].partitions.size(), 1);
+  EXPECT_EQ(fetch_resp.topics[0].partitions[0].high_watermark, 150);
+  EXPECT_EQ(fetch_resp.topics[0].partitions[0].records_size, 1000);
+}
+
+TEST(KafkaPacketDecoderTest, OffsetCommitReqAndResp) {
+  PacketBuilder req_builder;
+  req_builder.ReqHeader(APIKey::kOffsetCommit, 2, 8, "consumer")
+      .String("group-1")
+      .Int32(3)  // generation_id
+      .String("member-1")
+      .Int64(-1)  // retention_time_ms
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(1)
+      .Int32(0)
+      .Int64(150)  // committed_offset
+      .String("");
+
+  PacketDecoder req_decoder(req_builder.buf());
+  Request req;
+  ASSERT_OK(req_decoder.ExtractReqHeader(&req));
+  ASSERT_OK_AND_ASSIGN(OffsetCommitReq offset_commit_req, req_decoder.ExtractOffsetCommitReq());
+  EXPECT_TRUE(req_decoder.eof());
+  EXPECT_EQ(offset_commit_req.group_id, "group-1");
+  EXPECT_EQ(offset_commit_req.generation_id, 3);
+  EXPECT_EQ(offset_commit_req.member_id, "member-1");
+  ASSERT_EQ(offset_commit_req.topics.size(), 1);
+  ASSERT_EQ(offset_commit_req.topics[0].partitions.size(), 1);
+  EXPECT_EQ(offset_commit_req.topics[0].partitions[0].committed_offset, 150);
+
+  PacketBuilder resp_builder;
+  resp_builder.RespHeader(8)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(1)
+      .Int32(0)
+      .Int16(static_cast<int16_t>(ErrorCode::kRebalanceInProgress));
+
+  PacketDecoder resp_decoder(resp_builder.buf());
+  resp_decoder.SetAPIInfo(APIKey::kOffsetCommit, 2);
+  ASSERT_OK(resp_decoder.ExtractRespHeader());
+  ASSERT_OK_AND_ASSIGN(OffsetCommitResp offset_commit_resp,
+                       resp_decoder.ExtractOffsetCommitResp());
+  EXPECT_TRUE(resp_decoder.eof());
+  ASSERT_EQ(offset_commit_resp.topics.size(), 1);
+  ASSERT_EQ(offset_commit_resp.topics[0].partitions.size(), 1);
+  EXPECT_EQ(offset_commit_resp.topics[0].partitions[0].error_code, 27);
+}
+
+TEST(KafkaPacketDecoderTest, TruncatedReq) {
+  std::string_view msg = PacketMsg(testdata::kProduceRequest);
+  PacketDecoder decoder(msg.substr(0, msg.size() - 10));
+  Request req;
+  ASSERT_OK(decoder.ExtractReqHeader(&req));
+  EXPECT_NOT_OK(decoder.ExtractProduceReq());
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -89,8 +89,6 @@ ParseState ParseFrame(MessageType type, std::string_view* buf, Packet* result) {
   return ParseState::kSuccess;
 }
 
-#define PL_ASSIGN_OR_RETURN_NPOS(expr, val_or) PL_ASSIGN_OR(expr, val_or, return std::string::npos)
-
 // FindFrameBoundary currently looks for a proper packet length and valid Kafka api key and version.
 // A good idea for improvement is to use correlation_id to find a matching req resp pair,
 // which gives us high confidence.
@@ -109,17 +107,17 @@ size_t FindFrameBoundary(MessageType type, std::string_view buf, size_t start_po
     std::string_view cur_buf = buf.substr(i);
     BinaryDecoder binary_decoder(cur_buf);
 
-    PL_ASSIGN_OR_RETURN_NPOS(int32_t packet_length, binary_decoder.ExtractInt<int32_t>());
+    // The loop bound leaves at least kMinReqHeaderLength bytes in cur_buf, which covers every
+    // field read below, so the reads skip their per-field bounds checks.
+    int32_t packet_length = binary_decoder.ExtractIntUnchecked<int32_t>();
 
     if (packet_length < 0 || (size_t)packet_length + kMessageLengthBytes > buf.size()) {
       continue;
     }
 
-    PL_ASSIGN_OR_RETURN_NPOS(int16_t request_api_key, binary_decoder.ExtractInt<int16_t>());
-
-    PL_ASSIGN_OR_RETURN_NPOS(int16_t request_api_version, binary_decoder.ExtractInt<int16_t>());
-
-    PL_ASSIGN_OR_RETURN_NPOS(int32_t correlation_id, binary_decoder.ExtractInt<int32_t>());
+    int16_t request_api_key = binary_decoder.ExtractIntUnchecked<int16_t>();
+    int16_t request_api_version = binary_decoder.ExtractIntUnchecked<int16_t>();
+    int32_t correlation_id = binary_decoder.ExtractIntUnchecked<int32_t>();
 
     if (!IsValidAPIKey(request_api_key)) {
       continue;
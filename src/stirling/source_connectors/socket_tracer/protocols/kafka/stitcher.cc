@@ -0,0 +1,234 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/stitcher.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/packet_decoder.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/types.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+namespace {
+
+template <typename TMessage>
+std::string ToJSONString(const TMessage& message) {
+  rapidjson::StringBuffer sb;
+  JSONWriter writer(sb);
+  message.ToJSON(&writer);
+  return std::string(sb.GetString(), sb.GetSize());
+}
+
+// Produce requests with acks=0 get no response from the broker.
+bool IsResponselessProduceReq(const Packet& req_packet) {
+  PacketDecoder decoder(req_packet);
+  Request req;
+  if (!decoder.ExtractReqHeader(&req).ok() || req.api_key != APIKey::kProduce) {
+    return false;
+  }
+  if (req.api_version >= 3 && !decoder.ExtractNullableString().ok()) {
+    return false;
+  }
+  StatusOr<int16_t> acks = decoder.ExtractInt16();
+  return acks.ok() && acks.ValueOrDie() == 0;
+}
+
+}  // namespace
+
+Status ProcessReq(const Packet& req_packet, Request* req) {
+  req->timestamp_ns = req_packet.timestamp_ns;
+
+  PacketDecoder decoder(req_packet);
+  PL_RETURN_IF_ERROR(decoder.ExtractReqHeader(req));
+
+  switch (req->api_key) {
+    case APIKey::kProduce: {
+      PL_ASSIGN_OR_RETURN(ProduceReq r, decoder.ExtractProduceReq());
+      req->msg = ToJSONString(r);
+      break;
+    }
+    case APIKey::kFetch: {
+      PL_ASSIGN_OR_RETURN(FetchReq r, decoder.ExtractFetchReq());
+      req->msg = ToJSONString(r);
+      break;
+    }
+    case APIKey::kMetadata: {
+      PL_ASSIGN_OR_RETURN(MetadataReq r, decoder.ExtractMetadataReq());
+      req->msg = ToJSONString(r);
+      break;
+    }
+    case APIKey::kOffsetCommit: {
+      PL_ASSIGN_OR_RETURN(OffsetCommitReq r, decoder.ExtractOffsetCommitReq());
+      req->msg = ToJSONString(r);
+      break;
+    }
+    default:
+      // The body is not decoded, but the record still has the API key and the latency.
+      break;
+  }
+  return Status::OK();
+}
+
+Status ProcessResp(const Packet& resp_packet, const Request& req, Response* resp) {
+  resp->timestamp_ns = resp_packet.timestamp_ns;
+
+  // Responses don't carry their API key, so they are decoded with the schema of their request.
+  PacketDecoder decoder(resp_packet);
+  decoder.SetAPIInfo(req.api_key, req.api_version);
+  PL_RETURN_IF_ERROR(decoder.ExtractRespHeader());
+
+  switch (req.api_key) {
+    case APIKey::kProduce: {
+      PL_ASSIGN_OR_RETURN(ProduceResp r, decoder.ExtractProduceResp());
+      resp->msg = ToJSONString(r);
+      break;
+    }
+    case APIKey::kFetch: {
+      PL_ASSIGN_OR_RETURN(FetchResp r, decoder.ExtractFetchResp());
+      resp->msg = ToJSONString(r);
+      break;
+    }
+    case APIKey::kMetadata: {
+      PL_ASSIGN_OR_RETURN(MetadataResp r, decoder.ExtractMetadataResp());
+      resp->msg = ToJSONString(r);
+      break;
+    }
+    case APIKey::kOffsetCommit: {
+      PL_ASSIGN_OR_RETURN(OffsetCommitResp r, decoder.ExtractOffsetCommitResp());
+      resp->msg = ToJSONString(r);
+      break;
+    }
+    default:
+      break;
+  }
+  return Status::OK();
+}
+
+StatusOr<Record> ProcessReqRespPair(const Packet& req_packet, const Packet& resp_packet) {
+  ECHECK_LT(req_packet.timestamp_ns, resp_packet.timestamp_ns);
+
+  Record r;
+  PL_RETURN_IF_ERROR(ProcessReq(req_packet, &r.req));
+  PL_RETURN_IF_ERROR(ProcessResp(resp_packet, r.req, &r.resp));
+
+  return r;
+}
+
+StatusOr<Record> ProcessSolitaryReq(const Packet& req_packet) {
+  Record r;
+  PL_RETURN_IF_ERROR(ProcessReq(req_packet, &r.req));
+
+  // Use the request timestamp, so the latency is reported as 0.
+  r.resp.timestamp_ns = req_packet.timestamp_ns;
+
+  return r;
+}
+
+// StitchFrames() uses a response-led matching algorithm. Kafka responses only carry the
+// correlation ID of their request, so the requests are indexed by correlation ID first, and each
+// response finds its request with a single lookup instead of a scan of the request deque.
+//
+// Brokers answer the requests of a connection in order. So once a response is matched, the
+// earlier requests that are still unmatched will never get a response, and are dropped.
+// Produce requests with acks=0 never get a response either, so they are emitted on their own.
+RecordsWithErrorCount<Record> StitchFrames(std::deque<Packet>* req_packets,
+                                           std::deque<Packet>* resp_packets) {
+  std::vector<Record> entries;
+  int error_count = 0;
+
+  // Maps a correlation ID to the position of its request in req_packets.
+  // Clients use unique correlation IDs; if one is ever reused, the oldest request is matched first.
+  absl::flat_hash_map<int32_t, size_t> req_index;
+  req_index.reserve(req_packets->size());
+  for (size_t i = 0; i < req_packets->size(); ++i) {
+    req_index.try_emplace((*req_packets)[i].correlation_id, i);
+  }
+
+  // The number of requests at the head of req_packets that are done with.
+  size_t num_done_reqs = 0;
+
+  for (const auto& resp_packet : *resp_packets) {
+    auto iter = req_index.find(resp_packet.correlation_id);
+    if (iter == req_index.end()) {
+      VLOG(1) << absl::Substitute(
+          "Did not find a request matching the response. Correlation ID = $0",
+          resp_packet.correlation_id);
+      ++error_count;
+      continue;
+    }
+    size_t req_pos = iter->second;
+    req_index.erase(iter);
+
+    Packet& req_packet = (*req_packets)[req_pos];
+    StatusOr<Record> record_status = ProcessReqRespPair(req_packet, resp_packet);
+    if (record_status.ok()) {
+      entries.push_back(record_status.ConsumeValueOrDie());
+    } else {
+      VLOG(1) << record_status.ToString();
+      ++error_count;
+    }
+    req_packet.consumed = true;
+    num_done_reqs = std::max(num_done_reqs, req_pos + 1);
+  }
+  resp_packets->clear();
+
+  for (size_t i = 0; i < req_packets->size(); ++i) {
+    Packet& req_packet = (*req_packets)[i];
+    if (req_packet.consumed) {
+      continue;
+    }
+    if (IsResponselessProduceReq(req_packet)) {
+      StatusOr<Record> record_status = ProcessSolitaryReq(req_packet);
+      if (record_status.ok()) {
+        entries.push_back(record_status.ConsumeValueOrDie());
+      } else {
+        VLOG(1) << record_status.ToString();
+        ++error_count;
+      }
+      req_packet.consumed = true;
+    } else if (i < num_done_reqs) {
+      VLOG(1) << absl::Substitute("Request did not get a response. Correlation ID = $0",
+                                  req_packet.correlation_id);
+      ++error_count;
+    }
+  }
+
+  // Clean-up the requests that are done with, and the consumed requests behind them.
+  while (num_done_reqs < req_packets->size() && (*req_packets)[num_done_reqs].consumed) {
+    ++num_done_reqs;
+  }
+  req_packets->erase(req_packets->begin(), req_packets->begin() + num_done_reqs);
+
+  return {entries, error_count};
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
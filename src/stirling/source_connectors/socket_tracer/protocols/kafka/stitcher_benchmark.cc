@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <string>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/stitcher.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/test_utils.h"
+
+using px::stirling::protocols::RecordsWithErrorCount;
+using px::stirling::protocols::kafka::APIKey;
+using px::stirling::protocols::kafka::Packet;
+using px::stirling::protocols::kafka::Record;
+using px::stirling::protocols::kafka::StitchFrames;
+using px::stirling::protocols::kafka::testutils::GenPacket;
+using px::stirling::protocols::kafka::testutils::PacketBuilder;
+
+constexpr int kNumPairs = 100;
+constexpr int kNumPartitions = 4;
+
+// A Fetch v4 exchange, where each partition of the response carries the given record
+// batches.
+void GenFetchPair(int32_t correlation_id, const std::string& records, std::deque<Packet>* reqs,
+                  std::deque<Packet>* resps) {
+  PacketBuilder req;
+  req.ReqHeader(APIKey::kFetch, 4, correlation_id, "consumer")
+      .Int32(-1)
+      .Int32(500)
+      .Int32(1)
+      .Int32(52428800)
+      .Int8(0)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(kNumPartitions);
+  for (int i = 0; i < kNumPartitions; ++i) {
+    req.Int32(i).Int64(correlation_id).Int32(1048576);
+  }
+
+  PacketBuilder resp;
+  resp.RespHeader(correlation_id)
+      .Int32(0)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(kNumPartitions);
+  for (int i = 0; i < kNumPartitions; ++i) {
+    resp.Int32(i)
+        .Int16(0)
+        .Int64(correlation_id)
+        .Int64(correlation_id)
+        .ArrayLength(-1)
+        .Bytes(records);
+  }
+
+  reqs->push_back(GenPacket(correlation_id, req.buf(), 2 * correlation_id));
+  resps->push_back(GenPacket(correlation_id, resp.buf(), 2 * correlation_id + 1));
+}
+
+// A Produce v2 exchange, where the request carries the given record batches.
+void GenProducePair(int32_t correlation_id, const std::string& records,
+                    std::deque<Packet>* reqs, std::deque<Packet>* resps) {
+  PacketBuilder req;
+  req.ReqHeader(APIKey::kProduce, 2, correlation_id, "producer")
+      .Int16(1)
+      .Int32(1500)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(1)
+      .Int32(0)
+      .Bytes(records);
+
+  PacketBuilder resp;
+  resp.RespHeader(correlation_id)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(1)
+      .Int32(0)
+      .Int16(0)
+      .Int64(correlation_id)
+      .Int64(-1)
+      .Int32(0);
+
+  reqs->push_back(GenPacket(correlation_id, req.buf(), 2 * correlation_id));
+  resps->push_back(GenPacket(correlation_id, resp.buf(), 2 * correlation_id + 1));
+}
+
+template <typename TGenFn>
+void BM_stitch(benchmark::State& state, TGenFn gen_fn) {  // NOLINT
+  const std::string records(state.range(0), 'x');
+
+  std::deque<Packet> reqs;
+  std::deque<Packet> resps;
+  int64_t num_bytes = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int i = 0; i < kNumPairs; ++i) {
+      gen_fn(i, records, &reqs, &resps);
+      num_bytes += reqs.back().msg.size() + resps.back().msg.size();
+    }
+    state.ResumeTiming();
+
+    RecordsWithErrorCount<Record> result = StitchFrames(&reqs, &resps);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(num_bytes);
+  state.SetItemsProcessed(state.iterations() * kNumPairs);
+}
+
+BENCHMARK_CAPTURE(BM_stitch, fetch, GenFetchPair)->RangeMultiplier(16)->Range(64, 1 << 20);
+BENCHMARK_CAPTURE(BM_stitch, produce, GenProducePair)->RangeMultiplier(16)->Range(64, 1 << 20);
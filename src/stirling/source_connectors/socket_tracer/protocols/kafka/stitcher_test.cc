@@ -0,0 +1,179 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/stitcher.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <string>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/test_data.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/test_utils.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using testutils::GenPacket;
+using testutils::PacketBuilder;
+
+template <size_t N>
+Packet ParseCapturedPacket(MessageType type, const uint8_t (&bytes)[N], uint64_t timestamp_ns) {
+  std::string_view buf = CreateStringView<char>(CharArrayStringView<uint8_t>(bytes));
+  Packet packet;
+  EXPECT_EQ(ParseFrame(type, &buf, &packet), ParseState::kSuccess);
+  packet.timestamp_ns = timestamp_ns;
+  return packet;
+}
+
+Packet GenProduceReq(int32_t correlation_id, int16_t acks, uint64_t timestamp_ns) {
+  PacketBuilder builder;
+  builder.ReqHeader(APIKey::kProduce, 2, correlation_id, "producer")
+      .Int16(acks)
+      .Int32(1500)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(1)
+      .Int32(0)
+      .Bytes("records");
+  return GenPacket(correlation_id, builder.buf(), timestamp_ns);
+}
+
+Packet GenProduceResp(int32_t correlation_id, uint64_t timestamp_ns) {
+  PacketBuilder builder;
+  builder.RespHeader(correlation_id)
+      .ArrayLength(1)
+      .String("orders")
+      .ArrayLength(1)
+      .Int32(0)
+      .Int16(0)
+      .Int64(42)
+      .Int64(-1)
+      .Int32(0);
+  return GenPacket(correlation_id, builder.buf(), timestamp_ns);
+}
+
+TEST(KafkaStitcherTest, CapturedReqRespPairs) {
+  std::deque<Packet> req_packets;
+  std::deque<Packet> resp_packets;
+  req_packets.push_back(ParseCapturedPacket(MessageType::kRequest, testdata::kProduceRequest, 0));
+  req_packets.push_back(ParseCapturedPacket(MessageType::kRequest, testdata::kMetaDataRequest, 1));
+  resp_packets.push_back(
+      ParseCapturedPacket(MessageType::kResponse, testdata::kProduceResponse, 2));
+  resp_packets.push_back(
+      ParseCapturedPacket(MessageType::kResponse, testdata::kMetaDataResponse, 3));
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 0);
+  ASSERT_EQ(result.records.size(), 2);
+  EXPECT_THAT(req_packets, IsEmpty());
+  EXPECT_THAT(resp_packets, IsEmpty());
+
+  const Record& produce = result.records[0];
+  EXPECT_EQ(produce.req.api_key, APIKey::kProduce);
+  EXPECT_EQ(produce.req.client_id, "console-producer");
+  EXPECT_EQ(produce.req.msg,
+            R"({"transactional_id":"","acks":1,"timeout_ms":1500,"topics":[{"name":)"
+            R"("quickstart-events","partitions":[{"index":0,"records_size":90}]}]})");
+  EXPECT_EQ(produce.resp.msg,
+            R"({"topics":[{"name":"quickstart-events","partitions":[{"index":0,"error_code":0,)"
+            R"("base_offset":0,"error_message":""}]}],"throttle_time_ms":0})");
+  EXPECT_EQ(produce.resp.timestamp_ns - produce.req.timestamp_ns, 2);
+
+  const Record& metadata = result.records[1];
+  EXPECT_EQ(metadata.req.api_key, APIKey::kMetadata);
+  EXPECT_EQ(metadata.req.msg, R"({"topics":[],"allow_auto_topic_creation":true})");
+  EXPECT_THAT(metadata.resp.msg, HasSubstr(R"("host":"localhost","port":9092)"));
+}
+
+TEST(KafkaStitcherTest, OutOfOrderCorrelationIDs) {
+  std::deque<Packet> req_packets = {GenProduceReq(10, 1, 0), GenProduceReq(11, 1, 1),
+                                    GenProduceReq(12, 1, 2)};
+  std::deque<Packet> resp_packets = {GenProduceResp(11, 3)};
+
+  // Only the second request is answered. The first one never will be, since brokers answer in
+  // order; the third one is kept for a later response.
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 1);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_EQ(result.records[0].req.timestamp_ns, 1);
+  ASSERT_EQ(req_packets.size(), 1);
+  EXPECT_EQ(req_packets[0].correlation_id, 12);
+
+  resp_packets = {GenProduceResp(12, 4)};
+  result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 0);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_THAT(result.records[0].resp.msg, HasSubstr(R"("base_offset":42)"));
+  EXPECT_THAT(req_packets, IsEmpty());
+}
+
+TEST(KafkaStitcherTest, UnmatchedResp) {
+  std::deque<Packet> req_packets = {GenProduceReq(1, 1, 0)};
+  std::deque<Packet> resp_packets = {GenProduceResp(2, 1)};
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 1);
+  EXPECT_THAT(result.records, IsEmpty());
+  EXPECT_EQ(req_packets.size(), 1);
+  EXPECT_THAT(resp_packets, IsEmpty());
+}
+
+TEST(KafkaStitcherTest, ProduceWithoutAcks) {
+  // acks=0 requests get no response, and are emitted on their own with a latency of 0.
+  std::deque<Packet> req_packets = {GenProduceReq(1, 0, 5), GenProduceReq(2, 1, 6)};
+  std::deque<Packet> resp_packets;
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 0);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_EQ(result.records[0].req.timestamp_ns, 5);
+  EXPECT_EQ(result.records[0].resp.timestamp_ns, 5);
+  EXPECT_THAT(result.records[0].resp.msg, IsEmpty());
+  ASSERT_EQ(req_packets.size(), 1);
+  EXPECT_EQ(req_packets[0].correlation_id, 2);
+}
+
+TEST(KafkaStitcherTest, UndecodedAPIKey) {
+  PacketBuilder req_builder;
+  req_builder.ReqHeader(APIKey::kHeartbeat, 0, 1, "consumer").String("group-1").Int32(3);
+  PacketBuilder resp_builder;
+  resp_builder.RespHeader(1).Int16(0);
+
+  std::deque<Packet> req_packets = {GenPacket(1, req_builder.buf(), 0)};
+  std::deque<Packet> resp_packets = {GenPacket(1, resp_builder.buf(), 1)};
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 0);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_EQ(result.records[0].req.api_key, APIKey::kHeartbeat);
+  EXPECT_EQ(result.records[0].req.client_id, "consumer");
+  EXPECT_THAT(result.records[0].req.msg, IsEmpty());
+  EXPECT_THAT(result.records[0].resp.msg, IsEmpty());
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
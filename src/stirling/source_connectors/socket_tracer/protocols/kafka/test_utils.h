@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/types.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+namespace testutils {
+
+// Builds the bytes of a Kafka packet in the non-flexible encoding, one field at a time.
+class PacketBuilder {
+ public:
+  PacketBuilder& Int8(int8_t val) { return AppendInt(val); }
+  PacketBuilder& Int16(int16_t val) { return AppendInt(val); }
+  PacketBuilder& Int32(int32_t val) { return AppendInt(val); }
+  PacketBuilder& Int64(int64_t val) { return AppendInt(val); }
+
+  // STRING or NULLABLE_STRING.
+  PacketBuilder& String(std::string_view str) {
+    Int16(str.size());
+    buf_.append(str);
+    return *this;
+  }
+
+  // BYTES or RECORDS.
+  PacketBuilder& Bytes(std::string_view bytes) {
+    Int32(bytes.size());
+    buf_.append(bytes);
+    return *this;
+  }
+
+  // The length of an ARRAY. The elements follow.
+  PacketBuilder& ArrayLength(int32_t len) { return Int32(len); }
+
+  // The request header v1.
+  PacketBuilder& ReqHeader(APIKey api_key, int16_t api_version, int32_t correlation_id,
+                           std::string_view client_id) {
+    Int16(static_cast<int16_t>(api_key));
+    Int16(api_version);
+    Int32(correlation_id);
+    return String(client_id);
+  }
+
+  // The response header v0.
+  PacketBuilder& RespHeader(int32_t correlation_id) { return Int32(correlation_id); }
+
+  const std::string& buf() const { return buf_; }
+
+ private:
+  template <typename TIntType>
+  PacketBuilder& AppendInt(TIntType val) {
+    for (int i = sizeof(TIntType) - 1; i >= 0; --i) {
+      buf_.push_back(static_cast<char>(static_cast<uint64_t>(val) >> (8 * i)));
+    }
+    return *this;
+  }
+
+  std::string buf_;
+};
+
+inline Packet GenPacket(int32_t correlation_id, std::string msg, uint64_t timestamp_ns) {
+  Packet packet;
+  packet.timestamp_ns = timestamp_ns;
+  packet.correlation_id = correlation_id;
+  packet.msg = std::move(msg);
+  return packet;
+}
+
+}  // namespace testutils
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -30,6 +30,7 @@
 
 #include "src/common/base/base.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"  // For FrameBase
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -231,13 +232,65 @@ constexpr int kMinReqHeaderLength =
 constexpr int kMinRespHeaderLength = kMessageLengthBytes + kCorrelationIDLength;
 constexpr int kMaxAPIVersion = 12;
 
+// The first API version of each decoded API key that uses the flexible (compact) encoding.
+constexpr int16_t kProduceFlexibleVersion = 9;
+constexpr int16_t kFetchFlexibleVersion = 12;
+constexpr int16_t kMetadataFlexibleVersion = 9;
+constexpr int16_t kOffsetCommitFlexibleVersion = 8;
+
 struct Packet : public FrameBase {
   int32_t correlation_id;
   std::string msg;
+  bool consumed = false;
 
   size_t ByteSize() const override { return sizeof(Packet) + msg.size(); }
 };
 
+struct Request {
+  APIKey api_key;
+  int16_t api_version;
+  std::string client_id;
+
+  // The decoded request body, as JSON. Empty for API keys that are not decoded.
+  std::string msg;
+
+  // Timestamp of the request packet.
+  uint64_t timestamp_ns;
+
+  std::string ToString() const {
+    return absl::Substitute("api_key=$0 api_version=$1 client_id=$2 msg=$3",
+                            magic_enum::enum_name(api_key), api_version, client_id, msg);
+  }
+};
+
+struct Response {
+  // The decoded response body, as JSON. Empty for API keys that are not decoded.
+  std::string msg;
+
+  // Timestamp of the response packet.
+  uint64_t timestamp_ns;
+
+  std::string ToString() const { return absl::Substitute("msg=$0", msg); }
+};
+
+/**
+ *  Record is the primary output of the kafka stitcher.
+ */
+struct Record {
+  Request req;
+  Response resp;
+
+  std::string ToString() const {
+    return absl::Substitute("req=[$0] resp=[$1]", req.ToString(), resp.ToString());
+  }
+};
+
+struct ProtocolTraits {
+  using frame_type = Packet;
+  using record_type = Record;
+  using state_type = NoState;
+};
+
 }  // namespace kafka
 }  // namespace protocols
 }  // namespace stirling
@@ -119,137 +119,188 @@ StatusOr<ParseState> HandleOKMessage(DequeView<Packet> resp_packets, Record* ent
 }
 
 StatusOr<ParseState> HandleResultsetResponse(DequeView<Packet> resp_packets, Record* entry,
-                                             bool binary_resultset, bool multi_resultset) {
+                                             bool binary_resultset, bool multi_resultset,
+                                             ResultsetStream* stream) {
   VLOG(3) << absl::Substitute("HandleResultsetResponse with $0 packets", resp_packets.size());
 
-  RETURN_NEEDS_MORE_DATA_IF_EMPTY(resp_packets);
-  const Packet& first_resp_packet = resp_packets.front();
-  resp_packets.pop_front();
-
-  // The last resultset of a multi-resultset is just an OK packet.
-  if (multi_resultset && IsOKPacket(first_resp_packet)) {
-    entry->resp.status = RespStatus::kOK;
-    entry->resp.timestamp_ns = first_resp_packet.timestamp_ns;
-    LOG_IF(ERROR, resp_packets.size() != 1)
-        << absl::Substitute("Found $0 extra packets", resp_packets.size() - 1);
-    return ParseState::kSuccess;
+  // Without a stream, the response is processed from its first packet on every call.
+  const bool streaming = stream != nullptr;
+  ResultsetStream local_stream;
+  if (!streaming) {
+    stream = &local_stream;
   }
 
-  // Process header packet.
-  size_t param_offset = 0;
-  auto s = ProcessLengthEncodedInt(first_resp_packet.msg, &param_offset);
-  if (!s.ok()) {
-    entry->resp.status = RespStatus::kUnknown;
-    return error::Internal("Unable to process header packet of resultset response.");
+  if (stream->in_progress) {
+    entry->resp.msg = stream->resp_msg;
+  } else {
+    *stream = ResultsetStream{};
+    stream->multi_resultset = multi_resultset;
   }
-  int num_col = s.ValueOrDie();
+  stream->num_consumed_packets = 0;
 
-  if (param_offset != first_resp_packet.msg.size()) {
-    entry->resp.status = RespStatus::kUnknown;
-    return error::Internal("Extra bytes in length-encoded int packet.");
-  }
+  const DequeView<Packet> all_packets = resp_packets;
 
-  if (num_col == 0) {
+  // Packets up to the point where num_unconsumed of them remain are fully accounted for by the
+  // stream, so when streaming, record that point for the caller to release them.
+  auto needs_more_data = [&](size_t num_unconsumed) {
     entry->resp.status = RespStatus::kUnknown;
-    return error::Internal("HandleResultsetResponse(): num columns should never be 0.");
-  }
+    size_t num_consumed = all_packets.size() - num_unconsumed;
+    if (streaming && num_consumed > 0) {
+      stream->in_progress = true;
+      stream->num_consumed_packets = num_consumed;
+      stream->next_seq_id = all_packets[num_consumed - 1].sequence_id + 1;
+    }
+    return ParseState::kNeedsMoreData;
+  };
 
-  VLOG(3) << absl::Substitute("num_columns=$0", num_col);
+  auto isLastPacket = [](const Packet& p) {
+    return (IsErrPacket(p) || IsOKPacket(p) || IsEOFPacket(p));
+  };
 
-  // A resultset has:
-  //  1             column_count packet (*already accounted for*)
-  //  column_count  column definition packets
-  //  0 or 1        EOF packet (if CLIENT_DEPRECATE_EOF is false)
-  //  0+            ResultsetRow packets (Spec says 1+, but have seen 0 in practice).
-  //  1             OK or EOF packet
-  // Must have at least the minimum number of remaining packets in a response.
-  if (resp_packets.size() < static_cast<size_t>(num_col + 1)) {
-    entry->resp.status = RespStatus::kUnknown;
-    return ParseState::kNeedsMoreData;
-  }
+  uint64_t resp_timestamp_ns = 0;
 
-  std::vector<ColDefinition> col_defs;
-  for (int i = 0; i < num_col; ++i) {
-    RETURN_NEEDS_MORE_DATA_IF_EMPTY(resp_packets);
-    const Packet& packet = resp_packets.front();
-    resp_packets.pop_front();
+  // Process one resultset of a (possibly multi-) resultset per iteration.
+  while (true) {
+    if (!stream->in_rows) {
+      const size_t num_unconsumed = resp_packets.size();
 
-    auto s = ProcessColumnDefPacket(packet);
-    if (!s.ok()) {
-      entry->resp.status = RespStatus::kUnknown;
-      return error::Internal("Expected column definition packet");
-    }
+      if (resp_packets.empty()) {
+        return needs_more_data(num_unconsumed);
+      }
+      const Packet& first_resp_packet = resp_packets.front();
+      resp_packets.pop_front();
 
-    ColDefinition col_def = s.ValueOrDie();
-    col_defs.push_back(std::move(col_def));
-  }
+      // The last resultset of a multi-resultset is just an OK packet.
+      if (stream->multi_resultset && IsOKPacket(first_resp_packet)) {
+        entry->resp.status = RespStatus::kOK;
+        entry->resp.timestamp_ns = first_resp_packet.timestamp_ns;
+        LOG_IF(ERROR, resp_packets.size() != 1)
+            << absl::Substitute("Found $0 extra packets", resp_packets.size() - 1);
+        return ParseState::kSuccess;
+      }
 
-  // Optional EOF packet.
-  RETURN_NEEDS_MORE_DATA_IF_EMPTY(resp_packets);
-  if (IsEOFPacket(resp_packets.front())) {
-    resp_packets.pop_front();
-  }
+      // Process header packet.
+      size_t param_offset = 0;
+      auto s = ProcessLengthEncodedInt(first_resp_packet.msg, &param_offset);
+      if (!s.ok()) {
+        entry->resp.status = RespStatus::kUnknown;
+        return error::Internal("Unable to process header packet of resultset response.");
+      }
+      int num_col = s.ValueOrDie();
 
-  std::vector<ResultsetRow> results;
+      if (param_offset != first_resp_packet.msg.size()) {
+        entry->resp.status = RespStatus::kUnknown;
+        return error::Internal("Extra bytes in length-encoded int packet.");
+      }
 
-  auto isLastPacket = [](const Packet& p) {
-    return (IsErrPacket(p) || IsOKPacket(p) || IsEOFPacket(p));
-  };
+      if (num_col == 0) {
+        entry->resp.status = RespStatus::kUnknown;
+        return error::Internal("HandleResultsetResponse(): num columns should never be 0.");
+      }
+
+      VLOG(3) << absl::Substitute("num_columns=$0", num_col);
+
+      // A resultset has:
+      //  1             column_count packet (*already accounted for*)
+      //  column_count  column definition packets
+      //  0 or 1        EOF packet (if CLIENT_DEPRECATE_EOF is false)
+      //  0+            ResultsetRow packets (Spec says 1+, but have seen 0 in practice).
+      //  1             OK or EOF packet
+      // Must have at least the minimum number of remaining packets in a response.
+      if (resp_packets.size() < static_cast<size_t>(num_col + 1)) {
+        return needs_more_data(num_unconsumed);
+      }
+
+      std::vector<ColDefinition> col_defs;
+      for (int i = 0; i < num_col; ++i) {
+        const Packet& packet = resp_packets.front();
+        resp_packets.pop_front();
+
+        auto s = ProcessColumnDefPacket(packet);
+        if (!s.ok()) {
+          entry->resp.status = RespStatus::kUnknown;
+          return error::Internal("Expected column definition packet");
+        }
 
-  while (!resp_packets.empty()) {
-    const Packet& row_packet = resp_packets.front();
-
-    Status s;
-    // TODO(chengruizhe): Get actual results from the resultset row packets if needed.
-    // Attempt to process it as a resultset row packet first. Process[Text/Binary]ResultRowPacket
-    // functions, if returning ok, indicates with very high confidence that the packet is indeed a
-    // resultset row packet. IsOKPacket, on the other hand, is not as robust.
-    if (binary_resultset) {
-      s = ProcessBinaryResultsetRowPacket(row_packet, col_defs);
-    } else {
-      s = ProcessTextResultsetRowPacket(row_packet, col_defs.size());
+        ColDefinition col_def = s.ValueOrDie();
+        col_defs.push_back(std::move(col_def));
+      }
+
+      // Optional EOF packet.
+      if (IsEOFPacket(resp_packets.front())) {
+        resp_packets.pop_front();
+      }
+
+      stream->in_rows = true;
+      stream->col_defs = std::move(col_defs);
+      stream->num_rows = 0;
+      stream->num_row_bytes = 0;
     }
 
-    if (s.ok()) {
-      resp_packets.pop_front();
-      ResultsetRow row{row_packet.msg};
-      results.emplace_back(std::move(row));
-    } else if (isLastPacket(row_packet)) {
-      break;
-    } else {
-      entry->resp.status = RespStatus::kUnknown;
-      return error::Internal("Expected resultset row packet [OK=$0 ERR=$1 EOF=$2]",
-                             IsOKPacket(row_packet), IsErrPacket(row_packet),
-                             IsEOFPacket(row_packet));
+    // Row packets are only validated and counted; their contents are not kept.
+    while (!resp_packets.empty()) {
+      const Packet& row_packet = resp_packets.front();
+
+      Status s;
+      // TODO(chengruizhe): Get actual results from the resultset row packets if needed.
+      // Attempt to process it as a resultset row packet first. Process[Text/Binary]ResultRowPacket
+      // functions, if returning ok, indicates with very high confidence that the packet is indeed
+      // a resultset row packet. IsOKPacket, on the other hand, is not as robust.
+      if (binary_resultset) {
+        s = ProcessBinaryResultsetRowPacket(row_packet, stream->col_defs);
+      } else {
+        s = ProcessTextResultsetRowPacket(row_packet, stream->col_defs.size());
+      }
+
+      if (s.ok()) {
+        resp_packets.pop_front();
+        ++stream->num_rows;
+        stream->num_row_bytes += row_packet.msg.size();
+      } else if (isLastPacket(row_packet)) {
+        break;
+      } else {
+        entry->resp.status = RespStatus::kUnknown;
+        return error::Internal("Expected resultset row packet [OK=$0 ERR=$1 EOF=$2]",
+                               IsOKPacket(row_packet), IsErrPacket(row_packet),
+                               IsEOFPacket(row_packet));
+      }
     }
-  }
 
-  RETURN_NEEDS_MORE_DATA_IF_EMPTY(resp_packets);
-  const Packet& last_packet = resp_packets.front();
+    if (resp_packets.empty()) {
+      return needs_more_data(0);
+    }
+    const Packet& last_packet = resp_packets.front();
 
-  DCHECK(isLastPacket(resp_packets.front()));
-  if (IsErrPacket(resp_packets.front())) {
-    return HandleErrMessage(resp_packets, entry);
-  }
+    DCHECK(isLastPacket(resp_packets.front()));
+    if (IsErrPacket(resp_packets.front())) {
+      return HandleErrMessage(resp_packets, entry);
+    }
 
-  resp_packets.pop_front();
+    resp_packets.pop_front();
 
-  if (multi_resultset) {
-    absl::StrAppend(&entry->resp.msg, ", ");
-  }
-  absl::StrAppend(&entry->resp.msg, "Resultset rows = ", results.size());
+    if (stream->multi_resultset) {
+      absl::StrAppend(&entry->resp.msg, ", ");
+    }
+    absl::StrAppend(&entry->resp.msg, "Resultset rows = ", stream->num_rows);
+    resp_timestamp_ns = last_packet.timestamp_ns;
+    VLOG(3) << absl::Substitute("Resultset rows=$0 row_bytes=$1", stream->num_rows,
+                                stream->num_row_bytes);
 
-  // Check for another resultset in case this is a multi-resultset.
-  if (MoreResultsExist(last_packet)) {
-    return HandleResultsetResponse(resp_packets, entry, binary_resultset,
-                                   /* multiresultset */ true);
+    // Check for another resultset in case this is a multi-resultset.
+    if (!MoreResultsExist(last_packet)) {
+      break;
+    }
+    stream->in_rows = false;
+    stream->multi_resultset = true;
+    stream->col_defs.clear();
+    stream->resp_msg = entry->resp.msg;
   }
 
   LOG_IF(ERROR, !resp_packets.empty())
       << absl::Substitute("Found $0 extra packets", resp_packets.size());
 
   entry->resp.status = RespStatus::kOK;
-  entry->resp.timestamp_ns = last_packet.timestamp_ns;
+  entry->resp.timestamp_ns = resp_timestamp_ns;
   return ParseState::kSuccess;
 }
 
@@ -344,12 +395,10 @@ StatusOr<ParseState> HandleStmtPrepareOKResponse(DequeView<Packet> resp_packets,
   }
 
   // Update state.
-  state->prepared_statements.emplace(
-      stmt_id,
-      PreparedStatement{.request = entry->req.msg,
-                        .response = StmtPrepareOKResponse{.header = resp_header,
+  state->prepared_statements.Insert(stmt_id, entry->req.msg,
+                                    StmtPrepareOKResponse{.header = resp_header,
                                                           .col_defs = std::move(col_defs),
-                                                          .param_defs = std::move(param_defs)}});
+                                                          .param_defs = std::move(param_defs)});
 
   entry->resp.status = RespStatus::kOK;
   return ParseState::kSuccess;
@@ -462,8 +511,7 @@ Status ProcessStmtExecuteParam(std::string_view msg, size_t* type_offset, size_t
 }  // namespace
 
 StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
-                                              std::map<int, PreparedStatement>* prepare_map,
-                                              Record* entry) {
+                                              PreparedStatements* prepare_map, Record* entry) {
   if (req_packet.msg.size() < 1 + kStmtIDBytes) {
     return error::Internal("Insufficient number of bytes for STMT_EXECUTE");
   }
@@ -474,11 +522,12 @@ StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
   int stmt_id =
       utils::LEndianBytesToInt<int, kStmtIDBytes>(req_packet.msg.substr(kStmtIDStartOffset));
 
-  auto iter = prepare_map->find(stmt_id);
-  if (iter == prepare_map->end()) {
-    // There can be 2 possibilities in this case:
+  const PreparedStatements::Entry* stmt = prepare_map->Find(stmt_id);
+  if (stmt == nullptr) {
+    // There can be 3 possibilities in this case:
     // 1. The stitcher is confused/messed up and accidentally deleted wrong prepare event.
     // 2. Client sent a Stmt Exec for a deleted Stmt Prepare
+    // 3. The Stmt Prepare was evicted from the cache.
     // We return -1 as stmt_id to indicate error and defer decision to the caller.
 
     // We can't determine whether the rest of this packet is valid or not, so just return success.
@@ -491,7 +540,7 @@ StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
     return ParseState::kSuccess;
   }
 
-  int num_params = iter->second.response.header.num_params;
+  int num_params = stmt->value.header.num_params;
 
   size_t offset = kStmtIDStartOffset + kStmtIDBytes + kFlagsBytes + kIterationCountBytes;
 
@@ -520,15 +569,13 @@ StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
     }
   }
 
-  std::string_view stmt_prepare_request = iter->second.request;
-  entry->req.msg = CombinePrepareExecute(stmt_prepare_request, params);
+  entry->req.msg = CombinePrepareExecute(*stmt->text, params);
 
   return ParseState::kSuccess;
 }
 
 StatusOr<ParseState> HandleStmtCloseRequest(const Packet& req_packet,
-                                            std::map<int, PreparedStatement>* prepare_map,
-                                            Record* entry) {
+                                            PreparedStatements* prepare_map, Record* entry) {
   if (req_packet.msg.size() < 1 + kStmtIDBytes) {
     return error::Internal("Insufficient number of bytes for STMT_CLOSE");
   }
@@ -539,10 +586,7 @@ StatusOr<ParseState> HandleStmtCloseRequest(const Packet& req_packet,
 
   int stmt_id =
       utils::LEndianBytesToInt<int, kStmtIDBytes>(req_packet.msg.substr(kStmtIDStartOffset));
-  auto iter = prepare_map->find(stmt_id);
-  if (iter != prepare_map->end()) {
-    prepare_map->erase(iter);
-  } else {
+  if (!prepare_map->Erase(stmt_id)) {
     // We may have missed the prepare statement (e.g. due to the missing start of connection
     // problem), but we can still process the close, and continue on. Just print a warning.
     entry->px_info = absl::Substitute(
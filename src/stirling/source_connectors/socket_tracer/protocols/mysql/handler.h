@@ -18,7 +18,6 @@
 
 #pragma once
 #include <deque>
-#include <map>
 #include <memory>
 
 #include "src/common/base/statusor.h"
@@ -45,9 +44,14 @@ StatusOr<ParseState> HandleOKMessage(DequeView<Packet> resp_packets, Record* ent
 /**
  * A Resultset can either be a binary resultset(returned by StmtExecute), or a text
  * resultset(returned by Query).
+ *
+ * Row packets are validated and counted, but not kept. If a stream is provided, an incomplete
+ * response is consumed as far as it goes, and the stream records where to pick up on the next
+ * call, which then receives only the packets after the consumed ones.
  */
 StatusOr<ParseState> HandleResultsetResponse(DequeView<Packet> resp_packets, Record* entry,
-                                             bool binaryresultset, bool multiresultset = false);
+                                             bool binaryresultset, bool multiresultset = false,
+                                             ResultsetStream* stream = nullptr);
 
 StatusOr<ParseState> HandleStmtPrepareOKResponse(DequeView<Packet> resp_packets, State* state,
                                                  Record* entry);
@@ -57,16 +61,14 @@ StatusOr<ParseState> HandleStmtPrepareOKResponse(DequeView<Packet> resp_packets,
  * look up the previously parsed StmtPrepare event based on a stmt_id when parsing the request.
  */
 StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
-                                              std::map<int, PreparedStatement>* prepare_map,
-                                              Record* entry);
+                                              PreparedStatements* prepare_map, Record* entry);
 
 /**
  * StmtClose request contains the stmt_id of the prepare stmt to close. It simply deletes
  * the prepare stmt from the map (state of ConnTracker).
  */
 StatusOr<ParseState> HandleStmtCloseRequest(const Packet& req_packet,
-                                            std::map<int, PreparedStatement>* prepare_map,
-                                            Record* entry);
+                                            PreparedStatements* prepare_map, Record* entry);
 
 /**
  * Many requests have just a single string request (e.g. COM_QUERY).
@@ -143,10 +143,9 @@ TEST(HandleStmtPrepareOKResponse, Invalid) {
 
 TEST(HandleStmtExecuteRequest, Basic) {
   Packet req_packet = testutils::GenStmtExecuteRequest(testdata::kStmtExecuteRequest);
-  PreparedStatement prepared_stmt = testdata::kPreparedStatement;
-  int stmt_id = prepared_stmt.response.header.stmt_id;
-  std::map<int, PreparedStatement> prepare_map;
-  prepare_map.emplace(stmt_id, std::move(prepared_stmt));
+  PreparedStatements prepare_map;
+  prepare_map.Insert(testdata::kStmtID, testdata::kStmtPrepareRequest.msg,
+                     testdata::kStmtPrepareResponse);
 
   Record entry;
   EXPECT_OK_AND_EQ(HandleStmtExecuteRequest(req_packet, &prepare_map, &entry),
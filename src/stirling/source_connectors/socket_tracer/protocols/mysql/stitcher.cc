@@ -26,6 +26,11 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/mysql/packet_utils.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/mysql/types.h"
 
+DEFINE_bool(stirling_mysql_stream_resultsets,
+            gflags::BoolFromEnv("PL_STIRLING_MYSQL_STREAM_RESULTSETS", true),
+            "If true, the row packets of a MySQL resultset response are validated, counted and "
+            "released as they arrive, instead of being held until the response is complete.");
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -60,10 +65,12 @@ void SyncRespQueue(const Packet& req_packet, std::deque<Packet>* resp_packets) {
  *
  * @param req_packets Deque of all received request packets (some may be missing).
  * @param resp_packets Dequeue of all received response packets (some may be missing).
+ * @param first_seq_id Sequence ID of the first response packet; not 1 if a streamed response
+ * has already been partially consumed.
  * @return View into the "bundle" of response packets that correspond to the first request packet.
  */
 DequeView<Packet> GetRespView(const std::deque<Packet>& req_packets,
-                              const std::deque<Packet>& resp_packets) {
+                              const std::deque<Packet>& resp_packets, uint8_t first_seq_id) {
   DCHECK(!req_packets.empty());
 
   int count = 0;
@@ -73,7 +80,7 @@ DequeView<Packet> GetRespView(const std::deque<Packet>& req_packets,
       break;
     }
 
-    uint8_t expected_seq_id = count + 1;
+    uint8_t expected_seq_id = first_seq_id + count;
     if (resp_packet.sequence_id != expected_seq_id) {
       VLOG(1) << absl::Substitute(
           "Found packet with unexpected sequence ID [expected=$0 actual=$1]", expected_seq_id,
@@ -135,7 +142,7 @@ StatusOr<ParseState> ProcessPackets(const Packet& req_packet, DequeView<Packet>
       // COM_QUERY has its own COM_QUERY meta response (ERR_Packet, OK_Packet,
       // Protocol::LOCAL_INFILE_Request, or ProtocolText::Resultset).
     case Command::kQuery:
-      return ProcessQuery(req_packet, resp_packets_view, entry);
+      return ProcessQuery(req_packet, resp_packets_view, state, entry);
 
       // COM_STMT_PREPARE returns COM_STMT_PREPARE_OK on success, ERR_Packet otherwise.
     case Command::kStmtPrepare:
@@ -203,7 +210,14 @@ RecordsWithErrorCount<Record> ProcessMySQLPackets(std::deque<Packet>* req_packet
     // For safety, make sure we have no stale response packets.
     SyncRespQueue(req_packet, resp_packets);
 
-    DequeView<Packet> resp_packets_view = GetRespView(*req_packets, *resp_packets);
+    // A streamed resultset only resumes for the request it was started for; that request may
+    // have since been dropped along with the rest of its response.
+    ResultsetStream& stream = state->resultset_stream;
+    if (stream.in_progress && stream.req_timestamp_ns != req_packet.timestamp_ns) {
+      stream = ResultsetStream{};
+    }
+    DequeView<Packet> resp_packets_view =
+        GetRespView(*req_packets, *resp_packets, stream.in_progress ? stream.next_seq_id : 1);
 
     VLOG(2) << absl::Substitute("req_packets=$0 resp_packets=$1 resp_view_size=$2",
                                 req_packets->size(), resp_packets->size(),
@@ -245,6 +259,11 @@ RecordsWithErrorCount<Record> ProcessMySQLPackets(std::deque<Packet>* req_packet
         bool resp_looks_healthy = resp_packets_view.size() == resp_packets->size();
         if (is_last_req && resp_looks_healthy) {
           VLOG(3) << "Appears to be an incomplete message. Waiting for more data";
+          // Release the response packets that a streamed resultset has already accounted for.
+          resp_packets->erase(resp_packets->begin(),
+                              resp_packets->begin() + stream.num_consumed_packets);
+          stream.num_consumed_packets = 0;
+          stream.req_timestamp_ns = req_packet.timestamp_ns;
           // More response data will probably be captured in next iteration, so stop.
           break;
         }
@@ -261,6 +280,7 @@ RecordsWithErrorCount<Record> ProcessMySQLPackets(std::deque<Packet>* req_packet
 
     req_packets->pop_front();
     resp_packets->erase(resp_packets->begin(), resp_packets->begin() + resp_packets_view.size());
+    stream = ResultsetStream{};
   }
 
   // If we haven't seen anything that gives us confidence that this is indeed a MySQL connection,
@@ -280,6 +300,45 @@ RecordsWithErrorCount<Record> ProcessMySQLPackets(std::deque<Packet>* req_packet
     }                                        \
   }
 
+// Process the meta response of COM_QUERY and COM_STMT_EXECUTE: an ERR_Packet, an OK_Packet
+// or a resultset (text or binary, respectively).
+StatusOr<ParseState> ProcessResultsetMetaResponse(DequeView<Packet> resp_packets, State* state,
+                                                  Record* entry, bool binary_resultset) {
+  ResultsetStream* stream = nullptr;
+  if (FLAGS_stirling_mysql_stream_resultsets) {
+    stream = &state->resultset_stream;
+
+    // The packets of a partially consumed resultset pick up in the middle of it, where an
+    // ERR/OK check on the first packet would be meaningless.
+    if (stream->in_progress) {
+      return HandleResultsetResponse(resp_packets, entry, binary_resultset,
+                                     /* multiresultset */ false, stream);
+    }
+  }
+
+  if (resp_packets.empty()) {
+    entry->resp.status = RespStatus::kUnknown;
+    return ParseState::kNeedsMoreData;
+  }
+
+  const Packet& first_resp_packet = resp_packets.front();
+
+  if (IsErrPacket(first_resp_packet)) {
+    PL_RETURN_IF_NOT_SUCCESS(HandleErrMessage(resp_packets, entry));
+
+    return ParseState::kSuccess;
+  }
+
+  if (IsOKPacket(first_resp_packet)) {
+    PL_RETURN_IF_NOT_SUCCESS(HandleOKMessage(resp_packets, entry));
+
+    return ParseState::kSuccess;
+  }
+
+  return HandleResultsetResponse(resp_packets, entry, binary_resultset,
+                                 /* multiresultset */ false, stream);
+}
+
 // Process a COM_STMT_PREPARE request and response, and populate details into a record entry.
 // MySQL documentation: https://dev.mysql.com/doc/internals/en/com-stmt-prepare.html
 StatusOr<ParseState> ProcessStmtPrepare(const Packet& req_packet, DequeView<Packet> resp_packets,
@@ -345,27 +404,7 @@ StatusOr<ParseState> ProcessStmtExecute(const Packet& req_packet, DequeView<Pack
   // Response
   //----------------
 
-  if (resp_packets.empty()) {
-    entry->resp.status = RespStatus::kUnknown;
-    return ParseState::kNeedsMoreData;
-  }
-
-  const Packet& first_resp_packet = resp_packets.front();
-
-  if (IsErrPacket(first_resp_packet)) {
-    PL_RETURN_IF_NOT_SUCCESS(HandleErrMessage(resp_packets, entry));
-
-    return ParseState::kSuccess;
-  }
-
-  if (IsOKPacket(first_resp_packet)) {
-    PL_RETURN_IF_NOT_SUCCESS(HandleOKMessage(resp_packets, entry));
-
-    return ParseState::kSuccess;
-  }
-
-  return HandleResultsetResponse(resp_packets, entry, /* binaryresultset */ true,
-                                 /* multiresultset */ false);
+  return ProcessResultsetMetaResponse(resp_packets, state, entry, /* binaryresultset */ true);
 }
 
 // Process a COM_STMT_CLOSE request and response, and populate details into a record entry.
@@ -418,7 +457,7 @@ StatusOr<ParseState> ProcessStmtReset(const Packet& req_packet, DequeView<Packet
 // Process a COM_QUERY request and response, and populate details into a record entry.
 // MySQL documentation: https://dev.mysql.com/doc/internals/en/com-query.html
 StatusOr<ParseState> ProcessQuery(const Packet& req_packet, DequeView<Packet> resp_packets,
-                                  Record* entry) {
+                                  State* state, Record* entry) {
   //----------------
   // Request
   //----------------
@@ -429,27 +468,7 @@ StatusOr<ParseState> ProcessQuery(const Packet& req_packet, DequeView<Packet> re
   // Response
   //----------------
 
-  if (resp_packets.empty()) {
-    entry->resp.status = RespStatus::kUnknown;
-    return ParseState::kNeedsMoreData;
-  }
-
-  const Packet& first_resp_packet = resp_packets.front();
-
-  if (IsErrPacket(first_resp_packet)) {
-    PL_RETURN_IF_NOT_SUCCESS(HandleErrMessage(resp_packets, entry));
-
-    return ParseState::kSuccess;
-  }
-
-  if (IsOKPacket(first_resp_packet)) {
-    PL_RETURN_IF_NOT_SUCCESS(HandleOKMessage(resp_packets, entry));
-
-    return ParseState::kSuccess;
-  }
-
-  return HandleResultsetResponse(resp_packets, entry, /* binaryresultset */ false,
-                                 /* multiresultset */ false);
+  return ProcessResultsetMetaResponse(resp_packets, state, entry, /* binaryresultset */ false);
 }
 
 // Process a COM_FIELD_LIST request and response, and populate details into a record entry.
@@ -85,7 +85,7 @@ StatusOr<ParseState> ProcessStmtReset(const Packet& req_packet, DequeView<Packet
                                       mysql::State* state, Record* entry);
 
 StatusOr<ParseState> ProcessQuery(const Packet& req_packet, DequeView<Packet> resp_packets,
-                                  Record* entry);
+                                  mysql::State* state, Record* entry);
 
 StatusOr<ParseState> ProcessFieldList(const Packet& req_packet, DequeView<Packet> resp_packets,
                                       Record* entry);
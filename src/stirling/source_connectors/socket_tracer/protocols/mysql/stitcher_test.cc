@@ -40,15 +40,14 @@ TEST(StitcherTest, TestProcessStmtPrepareOK) {
   Packet req = testutils::GenStringRequest(testdata::kStmtPrepareRequest, Command::kStmtPrepare);
   std::deque<Packet> ok_resp_packets =
       testutils::GenStmtPrepareOKResponse(testdata::kStmtPrepareResponse);
-  State state{std::map<int, PreparedStatement>()};
+  State state;
 
   // Run function-under-test.
   Record entry;
   EXPECT_OK_AND_EQ(ProcessStmtPrepare(req, ok_resp_packets, &state, &entry), ParseState::kSuccess);
 
   // Check resulting state and entries.
-  auto iter = state.prepared_statements.find(testdata::kStmtID);
-  EXPECT_TRUE(iter != state.prepared_statements.end());
+  EXPECT_NE(state.prepared_statements.Find(testdata::kStmtID), nullptr);
   Record expected_entry{.req = {Command::kStmtPrepare, testdata::kStmtPrepareRequest.msg, 0},
                         .resp = {RespStatus::kOK, "", 0}};
   EXPECT_EQ(expected_entry, entry);
@@ -60,15 +59,14 @@ TEST(StitcherTest, TestProcessStmtPrepareErr) {
   std::deque<Packet> err_resp_packets;
   ErrResponse err_resp = {.error_code = 1096, .error_message = "This is an error."};
   err_resp_packets.emplace_back(testutils::GenErr(/* seq_id */ 1, err_resp));
-  State state{std::map<int, PreparedStatement>()};
+  State state;
 
   // Run function-under-test.
   Record entry;
   EXPECT_OK_AND_EQ(ProcessStmtPrepare(req, err_resp_packets, &state, &entry), ParseState::kSuccess);
 
   // Check resulting state and entries.
-  auto iter = state.prepared_statements.find(testdata::kStmtID);
-  EXPECT_EQ(iter, state.prepared_statements.end());
+  EXPECT_EQ(state.prepared_statements.Find(testdata::kStmtID), nullptr);
   Record expected_err_entry{.req = {Command::kStmtPrepare, testdata::kStmtPrepareRequest.msg, 0},
                             .resp = {RespStatus::kErr, "This is an error.", 0}};
   EXPECT_EQ(expected_err_entry, entry);
@@ -78,8 +76,9 @@ TEST(StitcherTest, TestProcessStmtExecute) {
   // Test setup.
   Packet req = testutils::GenStmtExecuteRequest(testdata::kStmtExecuteRequest);
   std::deque<Packet> resultset = testutils::GenResultset(testdata::kStmtExecuteResultset);
-  State state{std::map<int, PreparedStatement>()};
-  state.prepared_statements.emplace(testdata::kStmtID, testdata::kPreparedStatement);
+  State state;
+  state.prepared_statements.Insert(testdata::kStmtID, testdata::kStmtPrepareRequest.msg,
+                                   testdata::kStmtPrepareResponse);
 
   // Run function-under-test.
   Record entry;
@@ -105,8 +104,9 @@ TEST(StitcherTest, TestProcessStmtSendLongData) {
   // TODO(oazizi): Not a real COM_STMT_SEND_LONG_DATA. Need to replace with a real capture.
   Packet req = testutils::GenStringRequest(StringRequest{""}, Command::kStmtSendLongData);
   std::deque<Packet> resp_packets = {};
-  State state{std::map<int, PreparedStatement>()};
-  state.prepared_statements.emplace(testdata::kStmtID, testdata::kPreparedStatement);
+  State state;
+  state.prepared_statements.Insert(testdata::kStmtID, testdata::kStmtPrepareRequest.msg,
+                                   testdata::kStmtPrepareResponse);
 
   // Run function-under-test.
   Record entry;
@@ -123,8 +123,9 @@ TEST(StitcherTest, TestProcessStmtClose) {
   // Test setup.
   Packet req = testutils::GenStmtCloseRequest(testdata::kStmtCloseRequest);
   std::deque<Packet> resp_packets = {};
-  State state{std::map<int, PreparedStatement>()};
-  state.prepared_statements.emplace(testdata::kStmtID, testdata::kPreparedStatement);
+  State state;
+  state.prepared_statements.Insert(testdata::kStmtID, testdata::kStmtPrepareRequest.msg,
+                                   testdata::kStmtPrepareResponse);
 
   // Run function-under-test.
   Record entry;
@@ -142,7 +143,8 @@ TEST(StitcherTest, TestProcessQuery) {
 
   // Run function-under-test.
   Record entry;
-  EXPECT_OK_AND_EQ(ProcessQuery(req, resultset, &entry), ParseState::kSuccess);
+  State state;
+  EXPECT_OK_AND_EQ(ProcessQuery(req, resultset, &state, &entry), ParseState::kSuccess);
 
   // Check resulting state and entries.
   Record expected_resultset_entry{.req = {Command::kQuery, "SELECT name FROM tag;", 0},
@@ -190,8 +192,9 @@ TEST(ProcessMySQLPacketsTest, OldResponses) {
   responses.push_front(resp1);
   responses.push_front(resp0);
 
-  State state{std::map<int, PreparedStatement>()};
-  state.prepared_statements.emplace(testdata::kStmtID, testdata::kPreparedStatement);
+  State state;
+  state.prepared_statements.Insert(testdata::kStmtID, testdata::kStmtPrepareRequest.msg,
+                                   testdata::kStmtPrepareResponse);
 
   std::deque<Packet> requests = {req};
   RecordsWithErrorCount<Record> result = ProcessMySQLPackets(&requests, &responses, &state);
@@ -201,6 +204,46 @@ TEST(ProcessMySQLPacketsTest, OldResponses) {
   EXPECT_EQ(responses.size(), 0);
 }
 
+TEST(ProcessMySQLPacketsTest, StreamedResultset) {
+  uint64_t t = 0;
+
+  Packet req = testutils::GenStringRequest(testdata::kQueryRequest, Command::kQuery);
+  req.timestamp_ns = t++;
+
+  // Column count, column definition, EOF, 3 rows and the closing EOF.
+  std::deque<Packet> resultset = testutils::GenResultset(testdata::kQueryResultset);
+  ASSERT_EQ(resultset.size(), 7);
+  for (auto& p : resultset) {
+    p.timestamp_ns = t++;
+  }
+
+  State state;
+  std::deque<Packet> requests = {req};
+  std::deque<Packet> responses(resultset.begin(), resultset.begin() + 5);
+
+  // The response is incomplete, but the packets received so far are accounted for and released.
+  RecordsWithErrorCount<Record> result = ProcessMySQLPackets(&requests, &responses, &state);
+  EXPECT_EQ(result.records.size(), 0);
+  EXPECT_EQ(result.error_count, 0);
+  EXPECT_EQ(requests.size(), 1);
+  EXPECT_EQ(responses.size(), 0);
+  EXPECT_TRUE(state.resultset_stream.in_progress);
+  EXPECT_EQ(state.resultset_stream.num_rows, 2);
+
+  responses.insert(responses.end(), resultset.begin() + 5, resultset.end());
+
+  result = ProcessMySQLPackets(&requests, &responses, &state);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_EQ(result.error_count, 0);
+  EXPECT_EQ(requests.size(), 0);
+  EXPECT_EQ(responses.size(), 0);
+  EXPECT_FALSE(state.resultset_stream.in_progress);
+
+  Record expected_entry{.req = {Command::kQuery, "SELECT name FROM tag;", 0},
+                        .resp = {RespStatus::kOK, "Resultset rows = 3", 7}};
+  EXPECT_EQ(expected_entry, result.records[0]);
+}
+
 TEST(ProcessMySQLPacketsTest, NonMySQLTraffic1) {
   Packet p0;
   p0.sequence_id = 0;
@@ -214,7 +257,7 @@ TEST(ProcessMySQLPacketsTest, NonMySQLTraffic1) {
 
   std::deque<Packet> requests = {p0};
   std::deque<Packet> responses = {p1};
-  State state{.prepared_statements = std::map<int, PreparedStatement>(), .active = false};
+  State state;
 
   RecordsWithErrorCount<Record> result = ProcessMySQLPackets(&requests, &responses, &state);
   EXPECT_EQ(result.records.size(), 0);
@@ -237,7 +280,7 @@ TEST(ProcessMySQLPacketsTest, NonMySQLTraffic2) {
 
   std::deque<Packet> requests = {p0};
   std::deque<Packet> responses = {p1};
-  State state{.prepared_statements = std::map<int, PreparedStatement>(), .active = false};
+  State state;
 
   RecordsWithErrorCount<Record> result = ProcessMySQLPackets(&requests, &responses, &state);
   EXPECT_EQ(result.records.size(), 0);
@@ -257,7 +300,7 @@ TEST(ProcessMySQLPacketsTest, NonMySQLTraffic3) {
 
   std::deque<Packet> requests = {p};
   std::deque<Packet> responses = {};
-  State state{.prepared_statements = std::map<int, PreparedStatement>(), .active = false};
+  State state;
 
   RecordsWithErrorCount<Record> result = ProcessMySQLPackets(&requests, &responses, &state);
   EXPECT_EQ(result.records.size(), 0);
@@ -110,11 +110,6 @@ const StmtPrepareOKResponse kStmtPrepareResponse{.header = kStmtPrepareRespHeade
                                                  .col_defs = kStmtPrepareColDefs,
                                                  .param_defs = kStmtPrepareParamDefs};
 
-const PreparedStatement kPreparedStatement{
-    .request = kStmtPrepareRequest.msg,
-    .response = kStmtPrepareResponse,
-};
-
 /**
  * Statement Execute Event with 2 params, 2 col definitions, and 2 resultset rows.
  */
@@ -20,7 +20,6 @@
 
 #include <chrono>
 #include <deque>
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -30,6 +29,7 @@
 
 #include "src/common/base/base.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"  // For FrameBase
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/statement_cache.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -340,20 +340,58 @@ struct StmtCloseRequest {
 //-----------------------------------------------------------------------------
 
 /**
- * PreparedStatement holds a prepared statement string, and a parsed response,
+ * PreparedStatements maps a stmt_id to its StmtPrepare request string and the parsed response,
  * which contains the placeholder column definitions.
  */
-struct PreparedStatement {
-  std::string request;
-  StmtPrepareOKResponse response;
+using PreparedStatements = StatementCache<int, StmtPrepareOKResponse>;
+
+/**
+ * ResultsetStream tracks a resultset response that is consumed while its packets are still
+ * arriving, so that row packets can be released before the closing packet shows up.
+ * Only what is needed to validate and summarize the rows is kept, so the memory held for a
+ * resultset doesn't grow with its number of rows.
+ */
+struct ResultsetStream {
+  // Whether a prefix of the response was consumed by a previous call.
+  bool in_progress = false;
+
+  // Whether the consumed prefix ends within the rows of a resultset, rather than right after
+  // a complete resultset of a multi-resultset.
+  bool in_rows = false;
+
+  bool multi_resultset = false;
+
+  // Column definitions of the current resultset; required to validate binary resultset rows.
+  std::vector<ColDefinition> col_defs;
+
+  // Number of rows, and their total size in bytes, seen so far in the current resultset.
+  size_t num_rows = 0;
+  size_t num_row_bytes = 0;
+
+  // Response message of the resultsets of a multi-resultset that have already completed.
+  std::string resp_msg;
+
+  // Number of response packets consumed by the last call, which the caller releases.
+  size_t num_consumed_packets = 0;
+
+  // Sequence ID of the next response packet after the consumed prefix.
+  uint8_t next_seq_id = 1;
+
+  // Timestamp of the request whose response this is.
+  uint64_t req_timestamp_ns = 0;
 };
 
 /**
- * State stores a map of stmt_id to active StmtPrepare event. It's used to be looked up
+ * State stores the active StmtPrepare events. It's used to be looked up
  * for the StmtPrepare event when a StmtExecute is received.
  */
 struct State {
-  std::map<int, PreparedStatement> prepared_statements;
+  PreparedStatements prepared_statements;
+
+  // The resultset response of the request at the head of the request queue, if it is being
+  // streamed.
+  ResultsetStream resultset_stream;
+
   // To prevent pushing data on mis-classified connections,
   // we start off in inactive state, which means no data will be pushed out.
   // Only on certain conditions, which increase our confidence that the data is indeed MySQL,
@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/nats/parse.h"
 
+#include <array>
 #include <initializer_list>
 #include <map>
 #include <optional>
@@ -36,14 +37,20 @@ namespace stirling {
 namespace protocols {
 namespace nats {
 
+namespace {
+
+// Based on https://github.com/nats-io/docs/blob/master/nats_protocol/nats-protocol.md.
+constexpr std::array<std::string_view, 10> kMessageTypes = {
+    "INFO", "CONNECT", "PUB", "SUB", "UNSUB", "MSG", "PING", "PONG", "+OK", "-ERR"};
+
+}  // namespace
+
 size_t FindMessageBoundary(std::string_view buf, size_t start_pos) {
-  // Based on https://github.com/nats-io/docs/blob/master/nats_protocol/nats-protocol.md.
-  const std::vector<std::string_view> kMessageTypes = {"INFO", "CONNECT", "PUB",  "SUB", "UNSUB",
-                                                       "MSG",  "PING",    "PONG", "+OK", "-ERR"};
   constexpr size_t kMinMsgSize = 3;
-  for (size_t i = start_pos; i < buf.size() - kMinMsgSize; ++i) {
+  for (size_t i = start_pos; i + kMinMsgSize < buf.size(); ++i) {
+    std::string_view rest = buf.substr(i);
     for (auto msg_type : kMessageTypes) {
-      if (absl::StartsWith(buf.substr(i), msg_type)) {
+      if (absl::StartsWith(rest, msg_type)) {
         return i;
       }
     }
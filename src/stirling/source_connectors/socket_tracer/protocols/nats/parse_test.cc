@@ -44,6 +44,8 @@ TEST(FindMessageBoundaryTest, ResultsAreAsExpected) {
   EXPECT_EQ(FindMessageBoundary(" +OK\r\n", 0), 1);
   EXPECT_EQ(FindMessageBoundary(" -ERR 'test'\r\n", 0), 1);
   EXPECT_EQ(FindMessageBoundary(" {} \r\n", 0), std::string_view::npos);
+  EXPECT_EQ(FindMessageBoundary("MS", 0), std::string_view::npos);
+  EXPECT_EQ(FindMessageBoundary("", 0), std::string_view::npos);
 }
 
 }  // namespace nats
@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/stitcher.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <variant>
@@ -218,9 +219,9 @@ Status HandleParse(const RegularMessage& msg, MsgDeqIter* resp_iter, const MsgDe
 
   if (iter->tag == Tag::kParseComplete) {
     if (parse.stmt_name.empty()) {
-      state->unnamed_statement = parse.query;
+      state->unnamed_statement = std::make_shared<const std::string>(parse.query);
     } else {
-      state->prepared_statements[parse.stmt_name] = parse.query;
+      state->prepared_statements.Insert(parse.stmt_name, parse.query);
     }
     req_resp->resp.msg = CmdCmpl{.timestamp_ns = iter->timestamp_ns, .cmd_tag = kParseCmplText};
   }
@@ -255,13 +256,14 @@ Status HandleBind(const RegularMessage& bind_msg, MsgDeqIter* resp_iter, const M
     if (bind_req.src_prepared_stat_name.empty()) {
       state->bound_statement = state->unnamed_statement;
     } else {
-      if (!state->prepared_statements.contains(bind_req.src_prepared_stat_name)) {
+      const auto* stmt = state->prepared_statements.Find(bind_req.src_prepared_stat_name);
+      if (stmt == nullptr) {
         // TODO(yzhao): The code should handle the case where the previous Parse message was not
         // seen, i.e., state->prepared_statements does not contain the requested statement name.
         return error::InvalidArgument("Statement [name=$0] is not recorded",
                                       bind_req.src_prepared_stat_name);
       }
-      state->bound_statement = state->prepared_statements[bind_req.src_prepared_stat_name];
+      state->bound_statement = stmt->text;
     }
     state->bound_params = bind_req.params;
     req_resp->resp.msg = CmdCmpl{.timestamp_ns = iter->timestamp_ns, .cmd_tag = "BIND COMPLETE"};
@@ -357,7 +359,9 @@ Status HandleExecute(const RegularMessage& msg, MsgDeqIter* resps_begin,
   DCHECK_EQ(msg.tag, Tag::kExecute);
 
   req_resp->req.timestamp_ns = msg.timestamp_ns;
-  req_resp->req.query = state->bound_statement;
+  if (state->bound_statement != nullptr) {
+    req_resp->req.query = *state->bound_statement;
+  }
   req_resp->req.params = state->bound_params;
 
   PL_RETURN_IF_ERROR(FillQueryResp(resps_begin, resps_end, &req_resp->resp));
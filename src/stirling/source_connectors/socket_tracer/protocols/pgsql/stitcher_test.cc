@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/stitcher.h"
 
+#include <memory>
 #include <string>
 
 #include "src/common/testing/testing.h"
@@ -202,8 +203,8 @@ class HandleBindTest : public ::testing::TestWithParam<HandleBindTestCase> {
  protected:
   void SetUp() override {
     constexpr char kStmt[] = "select $1, $2 from t";
-    state_.unnamed_statement = kStmt;
-    state_.prepared_statements["foo"] = kStmt;
+    state_.unnamed_statement = std::make_shared<const std::string>(kStmt);
+    state_.prepared_statements.Insert("foo", kStmt);
   }
 
   State state_;
@@ -226,7 +227,8 @@ TEST_P(HandleBindTest, CheckBoundStatement) {
 
   EXPECT_EQ("BIND COMPLETE", req_resp.resp.ToString());
 
-  EXPECT_EQ(GetParam().expected_bound_statement, state_.bound_statement);
+  ASSERT_NE(state_.bound_statement, nullptr);
+  EXPECT_EQ(GetParam().expected_bound_statement, *state_.bound_statement);
 }
 
 INSTANTIATE_TEST_SUITE_P(
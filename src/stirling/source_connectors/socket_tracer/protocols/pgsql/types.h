@@ -19,14 +19,15 @@
 #pragma once
 
 #include <deque>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
+#include <variant>
 #include <vector>
 
-#include <absl/container/flat_hash_map.h>
-
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/statement_cache.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -523,15 +524,17 @@ struct Record {
 };
 
 struct State {
-  absl::flat_hash_map<std::string, std::string> prepared_statements;
+  // The named statements, keyed by name.
+  StatementCache<std::string, std::monostate> prepared_statements;
 
   // One postgres session can only have at most one unnamed statement.
-  std::string unnamed_statement;
+  std::shared_ptr<const std::string> unnamed_statement;
 
   // The last bound statement of the extended query session, without the parameters substituted. See
   // link for more info on extended query sessions:
   // https://www.postgresql.org/docs/10/protocol-flow.html#PROTOCOL-FLOW-EXT-QUERY
-  std::string bound_statement;
+  // It shares the text of the prepared statement, which may since have been evicted or replaced.
+  std::shared_ptr<const std::string> bound_statement;
   // The last set of parameters bound to bound_statement. Everytime a BIND command happens these are
   // invalidated.
   std::vector<Param> bound_params;
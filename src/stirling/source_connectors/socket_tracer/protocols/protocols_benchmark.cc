@@ -0,0 +1,213 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef TCMALLOC
+#include <gperftools/malloc_hook.h>
+#endif
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/common.h"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/stitchers.h"
+
+DEFINE_string(protocol_trace, "",
+              "The socket data events to replay, as written by a socket tracer run with "
+              "--perf_buffer_events_output_path=<file>.bin.");
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace {
+
+using ::px::stirling::sockeventpb::SocketDataEvent;
+
+// Large enough to hold any message of the trace, so that none of the data is dropped.
+constexpr size_t kBufferCapacity = 64 * 1024 * 1024;
+
+// The data events of one connection.
+struct ConnTrace {
+  std::vector<SocketDataEvent> req_events;
+  std::vector<SocketDataEvent> resp_events;
+  size_t num_bytes = 0;
+};
+
+// The connections of the trace, by protocol.
+using Trace = std::map<TrafficProtocol, std::vector<ConnTrace>>;
+
+StatusOr<Trace> ReadTrace(const std::string& path) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) {
+    return error::Internal("Could not open the trace file $0.", path);
+  }
+  google::protobuf::io::IstreamInputStream input(&ifs);
+
+  // Connections are keyed by pid, start time, fd and generation.
+  std::map<std::tuple<uint32_t, uint64_t, uint32_t, uint32_t>, ConnTrace> conns;
+  std::map<std::tuple<uint32_t, uint64_t, uint32_t, uint32_t>, TrafficProtocol> conn_protocols;
+
+  SocketDataEvent event;
+  bool clean_eof = false;
+  while (google::protobuf::util::ParseDelimitedFromZeroCopyStream(&event, &input, &clean_eof)) {
+    const auto& attr = event.attr();
+    // The connection trackers do not parse the data of connections with an unknown role.
+    if (attr.role() != kRoleClient && attr.role() != kRoleServer) {
+      continue;
+    }
+    auto key = std::make_tuple(attr.conn_id().pid(), attr.conn_id().start_time_ns(),
+                               attr.conn_id().fd(), attr.conn_id().generation());
+    conn_protocols[key] = static_cast<TrafficProtocol>(attr.protocol());
+
+    ConnTrace& conn = conns[key];
+    conn.num_bytes += event.msg().size();
+    // Clients send the requests, servers receive them.
+    bool is_req = (attr.role() == kRoleClient) == (attr.direction() == kEgress);
+    (is_req ? conn.req_events : conn.resp_events).push_back(std::move(event));
+  }
+  if (!clean_eof) {
+    return error::InvalidArgument("The trace file $0 is truncated or corrupted.", path);
+  }
+
+  Trace trace;
+  for (auto& [key, conn] : conns) {
+    trace[conn_protocols[key]].push_back(std::move(conn));
+  }
+  return trace;
+}
+
+// The trace is read once, by the first benchmark that runs.
+const StatusOr<Trace>& GetTrace() {
+  static const StatusOr<Trace> trace = ReadTrace(FLAGS_protocol_trace);
+  return trace;
+}
+
+std::atomic<int64_t> num_allocs = 0;
+
+#ifdef TCMALLOC
+void CountAllocation(const void* /*ptr*/, size_t /*size*/) {
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+// Feeds the events to a DataStreamBuffer one at a time, and parses the frames after each event,
+// the same way a DataStream does when events arrive from the perf buffers.
+template <typename TFrameType>
+void ParseEvents(MessageType type, const std::vector<SocketDataEvent>& events,
+                 std::deque<TFrameType>* frames) {
+  DataStreamBuffer buffer(kBufferCapacity);
+  for (const auto& event : events) {
+    buffer.Add(event.attr().pos(), event.msg(), event.attr().timestamp_ns());
+
+    size_t contiguous_bytes = buffer.Head().size();
+    ParseResult result = ParseFrames(type, buffer, frames);
+    if (contiguous_bytes != buffer.size()) {
+      // A missing event; drop the data before it.
+      buffer.RemovePrefix(contiguous_bytes);
+      buffer.Trim();
+    } else {
+      buffer.RemovePrefix(result.end_position);
+    }
+  }
+}
+
+// Calls fn on each connection of the protocol, and reports bytes/s, frames/s and allocations per
+// frame. fn returns the number of frames parsed from the connection.
+template <typename TFn>
+void ReplayConns(benchmark::State& state, TrafficProtocol protocol, TFn fn) {  // NOLINT
+  const StatusOr<Trace>& trace = GetTrace();
+  if (!trace.ok()) {
+    state.SkipWithError(trace.msg().c_str());
+    return;
+  }
+  auto iter = trace.ValueOrDie().find(protocol);
+  if (iter == trace.ValueOrDie().end()) {
+    state.SkipWithError("The trace has no connection of this protocol.");
+    return;
+  }
+  const std::vector<ConnTrace>& conns = iter->second;
+
+#ifdef TCMALLOC
+  MallocHook::AddNewHook(&CountAllocation);
+#endif
+  num_allocs = 0;
+
+  int64_t num_bytes = 0;
+  int64_t num_frames = 0;
+  for (auto _ : state) {
+    for (const auto& conn : conns) {
+      num_frames += fn(conn);
+      num_bytes += conn.num_bytes;
+    }
+  }
+
+#ifdef TCMALLOC
+  MallocHook::RemoveNewHook(&CountAllocation);
+  state.counters["allocs_per_frame"] =
+      num_frames == 0 ? 0 : static_cast<double>(num_allocs) / num_frames;
+#endif
+  state.SetBytesProcessed(num_bytes);
+  state.counters["frames"] = benchmark::Counter(num_frames, benchmark::Counter::kIsRate);
+}
+
+template <typename TProtocolTraits>
+void BM_parse_and_stitch(benchmark::State& state, TrafficProtocol protocol) {  // NOLINT
+  using TRecordType = typename TProtocolTraits::record_type;
+  using TFrameType = typename TProtocolTraits::frame_type;
+  using TStateType = typename TProtocolTraits::state_type;
+
+  ReplayConns(state, protocol, [](const ConnTrace& conn) {
+    std::deque<TFrameType> req_frames;
+    std::deque<TFrameType> resp_frames;
+    ParseEvents(MessageType::kRequest, conn.req_events, &req_frames);
+    ParseEvents(MessageType::kResponse, conn.resp_events, &resp_frames);
+    size_t num_frames = req_frames.size() + resp_frames.size();
+
+    TStateType protocol_state;
+    RecordsWithErrorCount<TRecordType> result = StitchFrames<TRecordType, TFrameType, TStateType>(
+        &req_frames, &resp_frames, &protocol_state);
+    benchmark::DoNotOptimize(result);
+    return num_frames;
+  });
+}
+
+// PROTOCOL_LIST: Requires update on new protocols.
+BENCHMARK_CAPTURE(BM_parse_and_stitch<http::ProtocolTraits>, http, kProtocolHTTP);
+BENCHMARK_CAPTURE(BM_parse_and_stitch<mysql::ProtocolTraits>, mysql, kProtocolMySQL);
+BENCHMARK_CAPTURE(BM_parse_and_stitch<cass::ProtocolTraits>, cql, kProtocolCQL);
+BENCHMARK_CAPTURE(BM_parse_and_stitch<pgsql::ProtocolTraits>, pgsql, kProtocolPGSQL);
+BENCHMARK_CAPTURE(BM_parse_and_stitch<dns::ProtocolTraits>, dns, kProtocolDNS);
+BENCHMARK_CAPTURE(BM_parse_and_stitch<redis::ProtocolTraits>, redis, kProtocolRedis);
+BENCHMARK_CAPTURE(BM_parse_and_stitch<kafka::ProtocolTraits>, kafka, kProtocolKafka);
+
+}  // namespace
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
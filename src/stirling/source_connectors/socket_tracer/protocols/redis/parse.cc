@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/redis/parse.h"
 
+#include <deque>
 #include <initializer_list>
 #include <map>
 #include <optional>
@@ -74,7 +75,7 @@ StatusOr<int> ParseSize(BinaryDecoder* decoder) {
 }
 
 // Bulk string is formatted as <length>\r\n<actual string, up to 512MB>\r\n
-Status ParseBulkString(BinaryDecoder* decoder, Message* msg) {
+Status ParseBulkString(BinaryDecoder* decoder, std::string_view* payload) {
   PL_ASSIGN_OR_RETURN(int len, ParseSize(decoder));
 
   constexpr int kMaxLen = 512 * 1024 * 1024;
@@ -86,61 +87,55 @@ Status ParseBulkString(BinaryDecoder* decoder, Message* msg) {
     constexpr std::string_view kNullBulkString = "<NULL>";
     // TODO(yzhao): This appears wrong, as Redis has NULL value, here "<NULL>" is presented as
     // a string. ATM don't know how to output NULL value in Rapidjson. Research and update this.
-    msg->payload = kNullBulkString;
+    *payload = kNullBulkString;
     return Status::OK();
   }
 
-  PL_ASSIGN_OR_RETURN(std::string_view payload,
-                      decoder->ExtractString(len + kTerminalSequence.size()));
-  if (!absl::EndsWith(payload, kTerminalSequence)) {
+  PL_ASSIGN_OR_RETURN(*payload, decoder->ExtractString(len + kTerminalSequence.size()));
+  if (!absl::EndsWith(*payload, kTerminalSequence)) {
     return error::InvalidArgument("Bulk string should be terminated by '$0'", kTerminalSequence);
   }
-  payload.remove_suffix(kTerminalSequence.size());
-  msg->payload = payload;
+  payload->remove_suffix(kTerminalSequence.size());
   return Status::OK();
 }
 
-bool IsPubMsg(const std::vector<std::string>& payloads) {
+bool IsPubMsg(const std::vector<std::string_view>& payloads) {
   // Published message format is at https://redis.io/topics/pubsub#format-of-pushed-messages
   constexpr size_t kArrayPayloadSize = 3;
   if (payloads.size() < kArrayPayloadSize) {
     return false;
   }
   constexpr std::string_view kMessageStr = "MESSAGE";
-  if (absl::AsciiStrToUpper(payloads.front()) != kMessageStr) {
-    return false;
-  }
-  return true;
+  return absl::EqualsIgnoreCase(payloads.front(), kMessageStr);
 }
 
-// This calls ParseMessage(), which eventually calls ParseArray() and are both recursive
+// This calls ParsePayload(), which eventually calls ParseArray() and are both recursive
 // functions. This is because Array message can include nested array messages.
 Status ParseArray(MessageType type, BinaryDecoder* decoder, Message* msg);
 
-Status ParseMessage(MessageType type, BinaryDecoder* decoder, Message* msg) {
+// Parses a message into a view of its payload. The payloads of the scalar types are views into the
+// decoder's buffer, so parsing them does not copy anything. Arrays have to be formatted though,
+// so the payload of an array is stored in nested_payloads.
+Status ParsePayload(MessageType type, BinaryDecoder* decoder, std::string_view* payload,
+                    std::deque<std::string>* nested_payloads) {
   PL_ASSIGN_OR_RETURN(const char type_marker, decoder->ExtractChar());
 
   switch (type_marker) {
-    case kSimpleStringMarker: {
-      PL_ASSIGN_OR_RETURN(std::string_view str, decoder->ExtractStringUntil(kTerminalSequence));
-      msg->payload = str;
+    case kSimpleStringMarker:
+    case kErrorMarker:
+    case kIntegerMarker: {
+      PL_ASSIGN_OR_RETURN(*payload, decoder->ExtractStringUntil(kTerminalSequence));
       break;
     }
     case kBulkStringsMarker: {
-      PL_RETURN_IF_ERROR(ParseBulkString(decoder, msg));
-      break;
-    }
-    case kErrorMarker: {
-      PL_ASSIGN_OR_RETURN(std::string_view str, decoder->ExtractStringUntil(kTerminalSequence));
-      msg->payload = str;
-      break;
-    }
-    case kIntegerMarker: {
-      PL_ASSIGN_OR_RETURN(msg->payload, decoder->ExtractStringUntil(kTerminalSequence));
+      PL_RETURN_IF_ERROR(ParseBulkString(decoder, payload));
       break;
     }
     case kArrayMarker: {
-      PL_RETURN_IF_ERROR(ParseArray(type, decoder, msg));
+      Message nested;
+      PL_RETURN_IF_ERROR(ParseArray(type, decoder, &nested));
+      nested_payloads->push_back(std::move(nested.payload));
+      *payload = nested_payloads->back();
       break;
     }
     default:
@@ -161,14 +156,16 @@ Status ParseArray(MessageType type, BinaryDecoder* decoder, Message* msg) {
     return Status::OK();
   }
 
-  std::vector<std::string> payloads;
+  // Only the formatted payload is copied out of the buffer, the elements are views into it.
+  std::vector<std::string_view> payloads;
+  std::deque<std::string> nested_payloads;
   for (int i = 0; i < len; ++i) {
-    Message tmp;
-    PL_RETURN_IF_ERROR(ParseMessage(type, decoder, &tmp));
-    payloads.push_back(std::move(tmp.payload));
+    std::string_view payload;
+    PL_RETURN_IF_ERROR(ParsePayload(type, decoder, &payload, &nested_payloads));
+    payloads.push_back(payload);
   }
 
-  FormatArrayMessage(VectorView<std::string>(payloads), msg);
+  FormatArrayMessage(VectorView<std::string_view>(payloads), msg);
 
   if (type == MessageType::kResponse && IsPubMsg(payloads)) {
     msg->is_published_message = true;
@@ -177,6 +174,19 @@ Status ParseArray(MessageType type, BinaryDecoder* decoder, Message* msg) {
   return Status::OK();
 }
 
+Status ParseMessage(MessageType type, BinaryDecoder* decoder, Message* msg) {
+  if (!decoder->eof() && decoder->Buf().front() == kArrayMarker) {
+    PL_RETURN_IF_ERROR(decoder->ExtractChar());
+    return ParseArray(type, decoder, msg);
+  }
+
+  std::string_view payload;
+  std::deque<std::string> nested_payloads;
+  PL_RETURN_IF_ERROR(ParsePayload(type, decoder, &payload, &nested_payloads));
+  msg->payload = payload;
+  return Status::OK();
+}
+
 ParseState TranslateErrorStatus(const Status& status) {
   if (error::IsNotFound(status) || error::IsResourceUnavailable(status)) {
     return ParseState::kNeedsMoreData;
@@ -40,6 +40,7 @@ constexpr std::string_view kArrayMsg = "*3\r\n+OK\r\n-Error message\r\n$11\r\nbu
 constexpr std::string_view kNullElemInArrayMsg = "*1\r\n$-1\r\n";
 constexpr std::string_view kNullArrayMsg = "*-1\r\n";
 constexpr std::string_view kEmptyArrayMsg = "*0\r\n";
+constexpr std::string_view kNestedArrayMsg = "*2\r\n*2\r\n+foo\r\n:1\r\n$3\r\nbar\r\n";
 constexpr std::string_view kCmdMsg = "*2\r\n+ACL\r\n+LOAD\r\n";
 constexpr std::string_view kPubMsg = "*3\r\n$7\r\nmessage\r\n$3\r\nfoo\r\n$4\r\ntest\r\n";
 constexpr std::string_view kAppendMsg = "*3\r\n$6\r\nappend\r\n$3\r\nfoo\r\n$3\r\nbar\r\n";
@@ -103,6 +104,7 @@ INSTANTIATE_TEST_SUITE_P(
         WellFormedTestCase{kNullElemInArrayMsg, "", R"(["<NULL>"])"},
         WellFormedTestCase{kNullArrayMsg, "", "[NULL]"},
         WellFormedTestCase{kEmptyArrayMsg, "", "[]"},
+        WellFormedTestCase{kNestedArrayMsg, "", R"(["[\"foo\",\"1\"]","bar"])"},
         WellFormedTestCase{kAppendMsg, "APPEND", R"({"key":"foo","value":"bar"})",
                            {MessageType::kRequest}},
         WellFormedTestCase{kAclGetuserMsg,  "ACL GETUSER", R"({"username":"user"})",
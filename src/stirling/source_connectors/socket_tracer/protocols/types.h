@@ -25,6 +25,7 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/dns/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/types.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/mysql/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/redis/types.h"
@@ -41,7 +42,9 @@ using FrameDequeVariant = std::variant<std::monostate,
                                        std::deque<mysql::Packet>,
                                        std::deque<pgsql::RegularMessage>,
                                        std::deque<dns::Frame>,
-                                       std::deque<redis::Message>>;
+                                       std::deque<redis::Message>,
+                                       std::deque<http2::Frame>,
+                                       std::deque<kafka::Packet>>;
 // clang-format off
 
 }  // namespace protocols
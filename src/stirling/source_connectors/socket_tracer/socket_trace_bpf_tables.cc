@@ -18,6 +18,8 @@
 
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
 
+#include <algorithm>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/stirling/bpf_tools/macros.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
@@ -27,6 +29,14 @@ DEFINE_uint32(stirling_conn_map_cleanup_threshold, kMaxConnMapCleanupItems,
               "Number of map cleanup entries to accumulate before triggering a BPF map clean-up. "
               "Higher numbers result in more efficiency. Too high a number will cause a BPF error "
               "because of the instruction count limit..");
+DEFINE_bool(stirling_conn_info_map_lru, gflags::BoolFromEnv("PL_STIRLING_CONN_INFO_MAP_LRU", true),
+            "If true, conn_info_map is an LRU map on kernels that support it, so that new "
+            "connections evict the least recently used ones when it is full, instead of not being "
+            "traced. The periodic scan for leaked conn_info_map entries is skipped then.");
+DEFINE_uint32(stirling_conn_info_map_size,
+              gflags::Uint32FromEnv("PL_STIRLING_CONN_INFO_MAP_SIZE", 0),
+              "The number of entries of conn_info_map. If 0, it is sized from the memory and CPU "
+              "count of the node.");
 
 // A function which we will uprobe on, to trigger our BPF code.
 // The function itself is irrelevant, but it must not be optimized away.
@@ -42,10 +52,32 @@ NO_OPT_ATTR void ConnInfoMapCleanupTrigger(int n, struct conn_id_t* conn_id_vec)
 namespace px {
 namespace stirling {
 
-ConnInfoMapManager::ConnInfoMapManager(bpf_tools::BCCWrapper* bcc)
-    : conn_info_map_(bcc->GetHashTable<uint64_t, struct conn_info_t>("conn_info_map")),
+uint32_t ConnInfoMapSize(int64_t mem_bytes, int num_cpus) {
+  if (FLAGS_stirling_conn_info_map_size != 0) {
+    return FLAGS_stirling_conn_info_map_size;
+  }
+
+  // The size the map used to have, which is kept as the minimum.
+  constexpr int64_t kMinEntries = 131072;
+  constexpr int64_t kMaxEntries = 1 << 20;
+  constexpr int64_t kEntriesPerCPU = 16384;
+  // At most 1/256 of the memory. Each entry also has about 64 bytes of hash table overhead.
+  constexpr int64_t kMemFraction = 256;
+  constexpr int64_t kEntryBytes = sizeof(struct conn_info_t) + 64;
+
+  int64_t entries = std::min(kEntriesPerCPU * num_cpus, mem_bytes / kMemFraction / kEntryBytes);
+  return std::clamp(entries, kMinEntries, kMaxEntries);
+}
+
+ConnInfoMapManager::ConnInfoMapManager(bpf_tools::BCCWrapper* bcc, uint32_t capacity, bool lru)
+    : capacity_(capacity),
+      lru_(lru),
+      conn_info_map_(bcc->GetBatchHashTable<uint64_t, struct conn_info_t>("conn_info_map")),
+      conn_info_map_stats_(bcc->GetPerCPUArrayTable<int64_t>(kConnInfoMapStatsArrayName)),
       conn_disabled_map_(bcc->GetHashTable<uint64_t, uint64_t>("conn_disabled_map")),
-      open_file_map_(bcc->GetHashTable<uint64_t, uint64_t>("open_file_map")) {
+      conn_capture_limit_map_(
+          bcc->GetHashTable<uint64_t, struct conn_capture_limit_t>(kConnCaptureLimitMapName)),
+      open_file_map_(bcc->GetBatchHashTable<uint64_t, uint64_t>("open_file_map")) {
   // Use address instead of symbol to specify this probe,
   // so that even if debug symbols are stripped, the uprobe can still attach.
   uint64_t symbol_addr = reinterpret_cast<uint64_t>(&ConnInfoMapCleanupTrigger);
@@ -78,10 +110,36 @@ void ConnInfoMapManager::Disable(struct conn_id_t conn_id) {
   }
 }
 
-void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr) {
+void ConnInfoMapManager::LimitCapture(struct conn_id_t conn_id, uint32_t max_bytes_per_call) {
+  struct conn_capture_limit_t limit = {};
+  limit.tsid = conn_id.tsid;
+  limit.max_bytes_per_call = max_bytes_per_call;
+  if (!conn_capture_limit_map_.update_value(id(conn_id), limit).ok()) {
+    VLOG(1) << absl::Substitute("$0 Updating conn_capture_limit_map entry failed.",
+                                ToString(conn_id));
+  }
+}
+
+void ConnInfoMapManager::ReleaseCaptureLimit(struct conn_id_t conn_id) {
+  // The entry is usually already deleted by close(). Check the TSID to not remove the limit of a
+  // newer connection on the same FD.
+  uint64_t key = id(conn_id);
+  struct conn_capture_limit_t limit = {};
+  if (conn_capture_limit_map_.get_value(key, limit).ok() && limit.tsid == conn_id.tsid) {
+    conn_capture_limit_map_.remove_value(key);
+  }
+}
+
+void ConnInfoMapManager::CleanupConnInfoMapLeaks(ConnTrackersManager* conn_trackers_mgr) {
   const auto& sysconfig = system::Config::GetInstance();
 
-  for (const auto& [pid_fd, conn_info] : conn_info_map_.get_table_offline()) {
+  auto conn_info_entries = conn_info_map_.GetTableOffline();
+  if (!conn_info_entries.ok()) {
+    LOG(WARNING) << absl::Substitute("Failed to read conn_info_map: $0", conn_info_entries.msg());
+    return;
+  }
+
+  for (const auto& [pid_fd, conn_info] : conn_info_entries.ValueOrDie()) {
     uint32_t pid = pid_fd >> 32;
     int32_t fd = pid_fd;
 
@@ -102,8 +160,24 @@ void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_m
     VLOG(1) << absl::Substitute("Found conn_info_map leak: pid=$0 fd=$1 af=$2", pid, fd,
                                 conn_info.addr.sa.sa_family);
   }
+}
+
+void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr) {
+  const auto& sysconfig = system::Config::GetInstance();
+
+  // An LRU map evicts leaked entries by itself once it fills up.
+  if (!lru_) {
+    CleanupConnInfoMapLeaks(conn_trackers_mgr);
+  }
 
-  for (const auto& [pid_fd, _] : open_file_map_.get_table_offline()) {
+  auto open_file_entries = open_file_map_.GetTableOffline();
+  if (!open_file_entries.ok()) {
+    LOG(WARNING) << absl::Substitute("Failed to read open_file_map: $0", open_file_entries.msg());
+    return;
+  }
+
+  std::vector<uint64_t> leaked_open_files;
+  for (const auto& [pid_fd, _] : open_file_entries.ValueOrDie()) {
     uint32_t pid = pid_fd >> 32;
     int32_t fd = pid_fd;
 
@@ -114,9 +188,45 @@ void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_m
     }
 
     // TODO(yzhao): Rewrite to use the uprobe-style cleanup.
-    open_file_map_.remove_value(pid_fd);
+    leaked_open_files.push_back(pid_fd);
     VLOG(1) << absl::Substitute("Found open_file_map leak: pid=$0 fd=$1", pid, fd);
   }
+
+  if (!leaked_open_files.empty()) {
+    auto num_removed = open_file_map_.RemoveValues(leaked_open_files);
+    LOG_IF(WARNING, !num_removed.ok())
+        << absl::Substitute("Failed to remove open_file_map leaks: $0", num_removed.msg());
+  }
+}
+
+StatusOr<ConnInfoMapStats> ConnInfoMapManager::GetStats() {
+  ConnInfoMapStats stats;
+  stats.capacity = capacity_;
+
+  int64_t* counters[kNumConnInfoMapStats] = {};
+  counters[kConnInfoMapInserts] = &stats.inserts;
+  counters[kConnInfoMapInsertFailures] = &stats.insert_failures;
+  counters[kConnInfoMapDeletes] = &stats.deletes;
+  for (int i = 0; i < kNumConnInfoMapStats; ++i) {
+    std::vector<int64_t> per_cpu_counts;
+    auto s = conn_info_map_stats_.get_value(i, per_cpu_counts);
+    if (!s.ok()) {
+      return error::Internal("Failed to read $0[$1]: $2", kConnInfoMapStatsArrayName, i, s.msg());
+    }
+    for (int64_t count : per_cpu_counts) {
+      *counters[i] += count;
+    }
+  }
+
+  PL_ASSIGN_OR_RETURN(auto conn_info_entries, conn_info_map_.GetTableOffline());
+  stats.occupancy = conn_info_entries.size();
+
+  if (lru_) {
+    // The counters are read before the entries, so this can be off by the concurrent updates.
+    stats.evictions = std::max<int64_t>(
+        0, stats.inserts - stats.deletes - static_cast<int64_t>(stats.occupancy));
+  }
+  return stats;
 }
 
 }  // namespace stirling
@@ -25,6 +25,8 @@
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 
 DECLARE_uint32(stirling_conn_map_cleanup_threshold);
+DECLARE_bool(stirling_conn_info_map_lru);
+DECLARE_uint32(stirling_conn_info_map_size);
 
 namespace px {
 namespace stirling {
@@ -32,23 +34,68 @@ namespace stirling {
 // Forward declaration.
 class ConnTrackersManager;
 
+/**
+ * Returns the number of conn_info_map entries for a node with the given memory and CPUs, unless
+ * --stirling_conn_info_map_size is set. The map is sized by the CPU count, since busy nodes tend
+ * to hold more sockets, but kept to a small fraction of the memory, since LRU maps are
+ * preallocated.
+ */
+uint32_t ConnInfoMapSize(int64_t mem_bytes, int num_cpus);
+
+/**
+ * The occupancy and pressure of conn_info_map. The counters are cumulative.
+ */
+struct ConnInfoMapStats {
+  uint32_t capacity = 0;
+  uint64_t occupancy = 0;
+  int64_t inserts = 0;
+  // Connections that could not be tracked because the insert failed.
+  int64_t insert_failures = 0;
+  int64_t deletes = 0;
+  // Entries that left the map without being deleted, i.e. that the LRU map evicted.
+  int64_t evictions = 0;
+};
+
 class ConnInfoMapManager {
  public:
-  explicit ConnInfoMapManager(bpf_tools::BCCWrapper* bcc);
+  /**
+   * @param capacity The size that conn_info_map was compiled with.
+   * @param lru Whether conn_info_map is an LRU map, in which case it doesn't leak entries.
+   */
+  ConnInfoMapManager(bpf_tools::BCCWrapper* bcc, uint32_t capacity, bool lru);
 
   void ReleaseResources(struct conn_id_t conn_id);
 
   void Disable(struct conn_id_t conn_id);
 
+  /**
+   * Limits the data sent from the TLS uprobes of the connection to max_bytes_per_call per call,
+   * or to metadata only if 0. The limit is removed by close(), or by ReleaseCaptureLimit().
+   */
+  void LimitCapture(struct conn_id_t conn_id, uint32_t max_bytes_per_call);
+  void ReleaseCaptureLimit(struct conn_id_t conn_id);
+
   void CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr);
 
+  /**
+   * Reads the counters of conn_info_map, and counts its entries.
+   */
+  StatusOr<ConnInfoMapStats> GetStats();
+
  private:
-  ebpf::BPFHashTable<uint64_t, struct conn_info_t> conn_info_map_;
+  const uint32_t capacity_;
+  const bool lru_;
+
+  bpf_tools::BatchHashTable<uint64_t, struct conn_info_t> conn_info_map_;
+  ebpf::BPFPercpuArrayTable<int64_t> conn_info_map_stats_;
   ebpf::BPFHashTable<uint64_t, uint64_t> conn_disabled_map_;
-  ebpf::BPFHashTable<uint64_t, uint64_t> open_file_map_;
+  ebpf::BPFHashTable<uint64_t, struct conn_capture_limit_t> conn_capture_limit_map_;
+  bpf_tools::BatchHashTable<uint64_t, uint64_t> open_file_map_;
 
   std::vector<struct conn_id_t> pending_release_queue_;
 
+  void CleanupConnInfoMapLeaks(ConnTrackersManager* conn_trackers_mgr);
+
   // TODO(oazizi): Can we share this with the similar function in socket_trace.c?
   uint64_t id(struct conn_id_t conn_id) const {
     return (static_cast<uint64_t>(conn_id.upid.tgid) << 32) | conn_id.fd;
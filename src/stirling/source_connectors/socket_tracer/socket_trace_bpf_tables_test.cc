@@ -0,0 +1,49 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+constexpr int64_t kGiB = 1024 * 1024 * 1024;
+
+TEST(ConnInfoMapSizeTest, ScalesWithCPUsWithinMemory) {
+  // Small nodes keep the old size.
+  EXPECT_EQ(ConnInfoMapSize(4 * kGiB, 2), 131072);
+  // Limited by the CPU count.
+  EXPECT_EQ(ConnInfoMapSize(1024 * kGiB, 16), 16 * 16384);
+  // Limited by the memory.
+  uint32_t size = ConnInfoMapSize(16 * kGiB, 32);
+  EXPECT_GT(size, 131072);
+  EXPECT_LT(size, 32 * 16384);
+  // Capped.
+  EXPECT_EQ(ConnInfoMapSize(1024 * kGiB, 256), 1 << 20);
+}
+
+TEST(ConnInfoMapSizeTest, FlagOverrides) {
+  uint32_t flag_value = FLAGS_stirling_conn_info_map_size;
+  FLAGS_stirling_conn_info_map_size = 4096;
+  EXPECT_EQ(ConnInfoMapSize(1024 * kGiB, 64), 4096);
+  FLAGS_stirling_conn_info_map_size = flag_value;
+}
+
+}  // namespace stirling
+}  // namespace px
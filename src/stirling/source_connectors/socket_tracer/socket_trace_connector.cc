@@ -21,19 +21,26 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <optional>
+#include <thread>
+#include <tuple>
 #include <utility>
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/delimited_message_util.h>
 #include <magic_enum.hpp>
 
 #include "src/common/base/base.h"
+#include "src/common/base/hash_utils.h"
 #include "src/common/base/utils.h"
 #include "src/common/json/json.h"
 #include "src/common/system/socket_info.h"
+#include "src/shared/http_headers/header_encoding.h"
 #include "src/shared/metadata/metadata.h"
 #include "src/stirling/bpf_tools/macros.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/go_grpc_types.hpp"
@@ -42,6 +49,7 @@
 #include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/utils.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/grpc.h"
+#include "src/stirling/source_connectors/socket_tracer/trace_policy.h"
 #include "src/stirling/utils/proc_path_tools.h"
 
 // 50 X less often than the normal sampling frequency. Based on the conn_stats_table.h's
@@ -55,6 +63,46 @@ DEFINE_uint32(
     std::chrono::minutes(10) / px::stirling::SocketTraceConnector::kSamplingPeriod,
     "Ratio of how frequently conn_stats_table is populated relative to the base sampling period");
 
+DEFINE_bool(stirling_socket_tracer_data_ringbuf,
+            gflags::BoolFromEnv("PL_STIRLING_SOCKET_TRACER_DATA_RINGBUF", false),
+            "If true, socket data events are sent through a BPF ring buffer instead of per-CPU "
+            "perf buffers. Falls back to perf buffers on kernels older than 5.8.");
+
+DEFINE_bool(stirling_socket_tracer_coalesce_iovecs,
+            gflags::BoolFromEnv("PL_STIRLING_SOCKET_TRACER_COALESCE_IOVECS", false),
+            "If true, the iovecs of a vectored syscall are copied into as few data events as "
+            "possible, and up to 8 messages of each sendmmsg()/recvmmsg() call are traced, each "
+            "in its own events. Only takes effect on kernels 5.3 or newer.");
+
+DEFINE_bool(stirling_skip_disabled_protocol_inference,
+            gflags::BoolFromEnv("PL_STIRLING_SKIP_DISABLED_PROTOCOL_INFERENCE", false),
+            "If true, the BPF code doesn't try to infer the protocols whose tracing is disabled. "
+            "Their connections are then reported as unknown in conn_stats.");
+
+DEFINE_bool(stirling_conn_stats_bpf_map,
+            gflags::BoolFromEnv("PL_STIRLING_CONN_STATS_BPF_MAP", false),
+            "If true, the totals of the connections are kept in a BPF map, which is read once per "
+            "conn_stats period, instead of being sent through the conn_stats_events perf "
+            "buffer.");
+
+DEFINE_uint32(stirling_conn_tracker_transfer_threads,
+              gflags::Uint32FromEnv("PL_STIRLING_CONN_TRACKER_TRANSFER_THREADS", 1),
+              "Number of threads that parse and stitch the data of the connection trackers in "
+              "each iteration. Each connection is always processed by the same thread.");
+
+DEFINE_string(stirling_socket_trace_policies,
+              gflags::StringFromEnv("PL_STIRLING_SOCKET_TRACE_POLICIES", ""),
+              "Comma-separated policies that sample connections and limit the bytes sent per "
+              "syscall inside BPF, each as <protocol>:<role>:<sample_rate>[:<max_bytes>], "
+              "eg. 'http:server:10:1024'. The sample rate is the percentage of connections "
+              "traced.");
+
+DEFINE_string(stirling_grpc_descriptor_sets,
+              gflags::StringFromEnv("PL_STIRLING_GRPC_DESCRIPTOR_SETS", ""),
+              "Comma-separated paths of serialized FileDescriptorSets of the traced gRPC services, "
+              "eg. from 'protoc --include_imports --descriptor_set_out'. The bodies of the calls "
+              "to these services are decoded with their schemas, as JSON.");
+
 DEFINE_bool(stirling_enable_periodic_bpf_map_cleanup, true,
             "Disable periodic BPF map cleanup (for testing)");
 
@@ -82,6 +130,13 @@ DEFINE_bool(stirling_enable_dns_tracing, true,
             "If true, stirling will trace and process DNS messages.");
 DEFINE_bool(stirling_enable_redis_tracing, true,
             "If true, stirling will trace and process Redis messages.");
+DEFINE_bool(stirling_enable_kafka_tracing, true,
+            "If true, stirling will trace and process Kafka messages.");
+
+DEFINE_bool(stirling_http_compact_headers,
+            gflags::BoolFromEnv("PL_STIRLING_HTTP_COMPACT_HEADERS", false),
+            "If true, the HTTP header columns store the compact encoding of "
+            "src/shared/http_headers instead of JSON. Use px.http_header() to read them.");
 
 DEFINE_bool(stirling_disable_self_tracing, true,
             "If true, stirling will not trace and process syscalls made by itself.");
@@ -104,6 +159,7 @@ using ::px::utils::ToJSONString;
 SocketTraceConnector::SocketTraceConnector(std::string_view source_name)
     : SourceConnector(source_name, kTables), conn_stats_(&conn_trackers_mgr_), uprobe_mgr_(this) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
+  fd_link_cache_ = std::make_unique<FDLinkCache>(proc_parser_.get());
   InitProtocolTransferSpecs();
 }
 
@@ -152,10 +208,10 @@ void SocketTraceConnector::InitProtocolTransferSpecs() {
       // mongo in the future.
       {kProtocolMongo,
        TransferSpec{false, kHTTPTableNum, {kRoleUnknown, kRoleClient, kRoleServer}, nullptr}},
-      // TODO(chengruizhe): Add Kafka table. nullptr should be replaced by the transfer_fn for
-      // kafka in the future.
-      {kProtocolKafka,
-       TransferSpec{false, kHTTPTableNum, {kRoleUnknown, kRoleClient, kRoleServer}, nullptr}},
+      {kProtocolKafka, TransferSpec{FLAGS_stirling_enable_kafka_tracing,
+                                    kKafkaTableNum,
+                                    {kRoleClient, kRoleServer},
+                                    TRANSFER_STREAM_PROTOCOL(kafka)}},
       {kProtocolUnknown, TransferSpec{false /*enabled*/,
                                       // Unknown protocols attached to HTTP table so that they run
                                       // their cleanup functions, but the use of nullptr transfer_fn
@@ -186,25 +242,88 @@ Status SocketTraceConnector::InitImpl() {
         "timestamps in a way that matches how /proc/stat does it");
   }
 
-  PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script));
+  use_data_ringbuf_ = FLAGS_stirling_socket_tracer_data_ringbuf && SupportsRingBuffers();
+  LOG_IF(WARNING, FLAGS_stirling_socket_tracer_data_ringbuf && !use_data_ringbuf_)
+      << "BPF ring buffers are not supported by this kernel, using perf buffers for data events.";
+
+  std::vector<std::string> cflags;
+  if (use_data_ringbuf_) {
+    cflags.push_back("-DUSE_RINGBUF=1");
+    cflags.push_back(absl::Substitute("-DRINGBUF_PAGE_CNT=$0",
+                                      bpf_tools::BufferPageCount(kTargetDataBufferSize)));
+  }
+  if (FLAGS_stirling_socket_tracer_coalesce_iovecs && SupportsBoundedLoops()) {
+    cflags.push_back("-DCOALESCE_IOVECS=1");
+    cflags.push_back("-DMMSG_LIMIT=8");
+  }
+  use_conn_stats_map_ = FLAGS_stirling_conn_stats_bpf_map;
+  if (use_conn_stats_map_) {
+    cflags.push_back("-DUSE_CONN_STATS_MAP=1");
+  }
+  if (FLAGS_stirling_skip_disabled_protocol_inference) {
+    uint64_t skip_mask = 0;
+    for (const auto& p : TrafficProtocolEnumValues()) {
+      if (!protocol_transfer_specs_[p].enabled) {
+        skip_mask |= 1ULL << p;
+      }
+    }
+    cflags.push_back(absl::Substitute("-DPROTOCOL_INFERENCE_SKIP_MASK=$0ULL", skip_mask));
+  }
+  cgroup_filter_ = CGroupFilter::CreateFromFlags();
+  if (cgroup_filter_ != nullptr) {
+    for (auto& cflag : cgroup_filter_->BPFCFlags()) {
+      cflags.push_back(std::move(cflag));
+    }
+  }
+  bool conn_info_map_lru = FLAGS_stirling_conn_info_map_lru && SupportsLRUHashMaps();
+  if (conn_info_map_lru) {
+    cflags.push_back("-DCONN_INFO_MAP_LRU=1");
+  }
+  const int64_t mem_bytes = static_cast<int64_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+  const uint32_t conn_info_map_size = ConnInfoMapSize(mem_bytes, static_cast<int>(kCPUCount));
+  cflags.push_back(absl::Substitute("-DCONN_INFO_MAP_SIZE=$0", conn_info_map_size));
+  LOG(INFO) << absl::Substitute("conn_info_map: size=$0 lru=$1", conn_info_map_size,
+                                conn_info_map_lru);
+
+  PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script, cflags));
   PL_RETURN_IF_ERROR(AttachKProbes(kProbeSpecs));
   LOG(INFO) << absl::Substitute("Number of kprobes deployed = $0", kProbeSpecs.size());
   LOG(INFO) << "Probes successfully deployed.";
 
-  PL_RETURN_IF_ERROR(OpenPerfBuffers(kPerfBufferSpecs, this));
-  LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0", kPerfBufferSpecs.size());
+  int num_perf_buffers = 0;
+  for (const auto& perf_buffer : kPerfBufferSpecs) {
+    if (use_data_ringbuf_ && perf_buffer.name == kDataRingBufferSpec.name) {
+      continue;
+    }
+    if (use_conn_stats_map_ && perf_buffer.name == "conn_stats_events") {
+      continue;
+    }
+    PL_RETURN_IF_ERROR(OpenPerfBuffer(perf_buffer, this));
+    ++num_perf_buffers;
+  }
+  LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0", num_perf_buffers);
+  if (use_data_ringbuf_) {
+    PL_RETURN_IF_ERROR(OpenRingBuffer(kDataRingBufferSpec, this));
+    LOG(INFO) << absl::Substitute("Data events use ring buffer $0", kDataRingBufferSpec.name);
+  }
 
   // Set trace role to BPF probes.
   for (const auto& p : TrafficProtocolEnumValues()) {
-    if (protocol_transfer_specs_[p].enabled) {
-      uint64_t role_mask = 0;
-      for (auto role : protocol_transfer_specs_[p].trace_roles) {
-        role_mask |= role;
-      }
-      PL_RETURN_IF_ERROR(UpdateBPFProtocolTraceRole(p, role_mask));
+    const TransferSpec& transfer_spec = protocol_transfer_specs_[p];
+    if (transfer_spec.enabled && transfer_spec.demanded) {
+      PL_RETURN_IF_ERROR(UpdateBPFProtocolTraceRole(p, transfer_spec.TraceRoleMask()));
     }
   }
 
+  PL_ASSIGN_OR_RETURN(configured_trace_policies_,
+                      ParseTracePolicies(FLAGS_stirling_socket_trace_policies));
+  for (const auto& p : configured_trace_policies_) {
+    PL_RETURN_IF_ERROR(UpdateBPFTracePolicy(p.key, p.policy));
+  }
+  if (load_shed_level_ > 0) {
+    PL_RETURN_IF_ERROR(UpdateLoadShedTracePolicies(/* prev_level */ 0));
+  }
+
   PL_RETURN_IF_ERROR(TestOnlySetTargetPID(FLAGS_test_only_socket_trace_target_pid));
   if (FLAGS_stirling_disable_self_tracing) {
     PL_RETURN_IF_ERROR(DisableSelfTracing());
@@ -223,7 +342,8 @@ Status SocketTraceConnector::InitImpl() {
     socket_info_mgr_ = s.ConsumeValueOrDie();
   }
 
-  conn_info_map_mgr_ = std::make_shared<ConnInfoMapManager>(this);
+  conn_info_map_mgr_ =
+      std::make_shared<ConnInfoMapManager>(this, conn_info_map_size, conn_info_map_lru);
   ConnTracker::SetConnInfoMapManager(conn_info_map_mgr_);
 
   uprobe_mgr_.Init(protocol_transfer_specs_[kProtocolHTTP2].enabled,
@@ -334,12 +454,20 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   // No data is lost, but this is a side-effect of sorts that affects timing of transfers.
   // It may be worth noting during debug.
   PollPerfBuffers();
+  PollRingBuffers();
 
   // Set-up current state for connection inference purposes.
   if (socket_info_mgr_ != nullptr) {
     socket_info_mgr_->Flush();
   }
 
+  if (cgroup_filter_ != nullptr) {
+    auto cgroup_filter_map = GetHashTable<uint64_t, uint8_t>(CGroupFilter::kBPFMapName);
+    Status s = cgroup_filter_->UpdateBPFMap(ctx->GetK8SMetadata(), ctx->GetUPIDsGeneration(),
+                                            &cgroup_filter_map);
+    LOG_IF(ERROR, !s.ok()) << s.msg();
+  }
+
   // Deploy uprobes on newly discovered PIDs.
   std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs());
   // Let it run in the background.
@@ -351,16 +479,38 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
 
   // Periodically check for leaking conn_info_map entries.
   // TODO(oazizi): Track down and plug the leaks, then zap this function.
-  constexpr auto kCleanupBPFMapLeaksPeriod = std::chrono::minutes(5);
+  constexpr auto kCleanupBPFMapLeaksPeriod = std::chrono::minutes(1);
   constexpr int kCleanupBPFMapLeaksSamplingRatio = kCleanupBPFMapLeaksPeriod / kSamplingPeriod;
   if (FLAGS_stirling_enable_periodic_bpf_map_cleanup &&
       sampling_freq_mgr_.count() % kCleanupBPFMapLeaksSamplingRatio == 0) {
     if (conn_info_map_mgr_ != nullptr) {
       conn_info_map_mgr_->CleanupBPFMapLeaks(&conn_trackers_mgr_);
+      ReportConnInfoMapStats();
     }
   }
 }
 
+void SocketTraceConnector::ReportConnInfoMapStats() {
+  auto stats_or = conn_info_map_mgr_->GetStats();
+  if (!stats_or.ok()) {
+    LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to read conn_info_map stats: $0",
+                                                 stats_or.msg());
+    return;
+  }
+  const ConnInfoMapStats& stats = stats_or.ValueOrDie();
+  std::string msg = absl::Substitute(
+      "conn_info_map: occupancy=$0/$1 inserts=$2 insert_failures=$3 deletes=$4 evictions=$5",
+      stats.occupancy, stats.capacity, stats.inserts, stats.insert_failures, stats.deletes,
+      stats.evictions);
+  // Failed inserts are connections that are not traced at all.
+  if (stats.insert_failures > conn_info_map_stats_.insert_failures) {
+    LOG(WARNING) << msg;
+  } else {
+    VLOG(1) << msg;
+  }
+  conn_info_map_stats_ = stats;
+}
+
 void SocketTraceConnector::UpdateTrackerTraceLevel(ConnTracker* tracker) {
   if (pids_to_trace_.contains(tracker->conn_id().upid.pid)) {
     tracker->SetDebugTrace(2);
@@ -370,15 +520,29 @@ void SocketTraceConnector::UpdateTrackerTraceLevel(ConnTracker* tracker) {
   }
 }
 
+double SocketTraceConnector::SamplingLoad(const std::vector<DataTable*>& data_tables) {
+  // Lost perf buffer events mean the buffers filled up before they were polled,
+  // so treat them as full load and poll more often.
+  int64_t data_event_loss = stats_.Get(StatKey::kLossSocketDataEvent);
+  bool lost_events = data_event_loss > last_data_event_loss_;
+  last_data_event_loss_ = data_event_loss;
+  return lost_events ? 1.0 : SourceConnector::SamplingLoad(data_tables);
+}
+
 void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
                                             const std::vector<DataTable*>& data_tables) {
   set_iteration_time(std::chrono::steady_clock::now());
 
   UpdateCommonState(ctx);
 
+  bool conn_stats_period =
+      sampling_freq_mgr_.count() % FLAGS_stirling_conn_stats_sampling_ratio == 0;
+  if (use_conn_stats_map_ && conn_stats_period) {
+    // Read regardless of the table, so that the entries of closed connections are deleted.
+    ReadConnStatsMap();
+  }
   DataTable* conn_stats_table = data_tables[kConnStatsTableNum];
-  if (conn_stats_table != nullptr &&
-      sampling_freq_mgr_.count() % FLAGS_stirling_conn_stats_sampling_ratio == 0) {
+  if (conn_stats_table != nullptr && conn_stats_period) {
     TransferConnStats(ctx, conn_stats_table);
   }
 
@@ -386,6 +550,7 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     conn_trackers_mgr_.ComputeProtocolStats();
     LOG(INFO) << "ConnTracker statistics: " << conn_trackers_mgr_.StatsString();
     LOG(INFO) << "SocketTracer statistics: " << stats_.Print();
+    LOG(INFO) << "UProbeManager statistics: " << uprobe_mgr_.StatsString();
   }
 
   constexpr auto kDebugDumpPeriod = std::chrono::minutes(1);
@@ -409,22 +574,31 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     }
   }
 
-  for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
-    const auto& transfer_spec = protocol_transfer_specs_[conn_tracker->protocol()];
-    DataTable* data_table = data_tables[transfer_spec.table_num];
+  // Parked trackers whose timers are due are visited again, the other parked ones are skipped.
+  conn_trackers_mgr_.BeginIteration(iteration_time_);
 
-    UpdateTrackerTraceLevel(conn_tracker);
+  if (FLAGS_stirling_conn_tracker_transfer_threads > 1) {
+    TransferConnTrackersParallel(ctx, data_tables, cluster_cidrs,
+                                 FLAGS_stirling_conn_tracker_transfer_threads);
+  } else {
+    for (const auto& conn_tracker : conn_trackers_mgr_.hot_trackers()) {
+      UpdateTrackerTraceLevel(conn_tracker);
 
-    conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, proc_parser_.get(),
-                                   socket_info_mgr_.get());
-    if (transfer_spec.enabled && transfer_spec.transfer_fn && data_table != nullptr) {
-      transfer_spec.transfer_fn(*this, ctx, conn_tracker, data_table);
+      conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, fd_link_cache_.get(),
+                                     socket_info_mgr_.get());
+      TransferConnTracker(ctx, conn_tracker, data_tables);
+      conn_tracker->IterationPostTick();
     }
-    conn_tracker->IterationPostTick();
   }
 
+  conn_trackers_mgr_.ParkIdleTrackers(kSamplingPeriod);
+  fd_link_cache_->EvictUnused();
+
   // Once we've cleared all the debug trace levels for this pid, we can remove it from the list.
   pids_to_trace_disable_.clear();
+
+  stats_gauges_.Update(stats_);
+  conn_tracker_gauges_.Update(conn_trackers_mgr_.stats());
 }
 
 template <typename TValueType>
@@ -444,6 +618,110 @@ Status SocketTraceConnector::UpdateBPFProtocolTraceRole(TrafficProtocol protocol
   return UpdatePerCPUArrayValue(static_cast<int>(protocol), role_mask, &control_map_handle);
 }
 
+void SocketTraceConnector::SetTableDemand(const absl::flat_hash_set<std::string>& table_names) {
+  for (const auto& p : TrafficProtocolEnumValues()) {
+    TransferSpec& transfer_spec = protocol_transfer_specs_[p];
+    std::string_view table_name = table_schemas()[transfer_spec.table_num].name();
+    bool demanded = table_names.contains(table_name);
+    if (!transfer_spec.enabled || transfer_spec.demanded == demanded) {
+      continue;
+    }
+    transfer_spec.demanded = demanded;
+    LOG(INFO) << absl::Substitute("$0 tracing of $1, as table $2 is $3 demand.",
+                                  demanded ? "Resuming" : "Pausing", magic_enum::enum_name(p),
+                                  table_name, demanded ? "in" : "out of");
+
+    // Before InitImpl(), the roles are set when the probes are deployed.
+    if (state() != State::kActive) {
+      continue;
+    }
+    // Without any role to trace, the probes only keep the connection stats of the protocol, and
+    // send none of its data to user-space.
+    uint64_t role_mask = demanded ? transfer_spec.TraceRoleMask() : 0;
+    Status s = UpdateBPFProtocolTraceRole(p, role_mask);
+    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to update the trace roles of $0: $1",
+                                               magic_enum::enum_name(p), s.msg());
+  }
+}
+
+void SocketTraceConnector::SetLoadShedLevel(int level) {
+  SourceConnector::SetLoadShedLevel(level);
+  if (load_shed_level_ == level) {
+    return;
+  }
+  LOG(INFO) << absl::Substitute("Changing the load shed level of socket tracing from $0 to $1.",
+                                load_shed_level_, level);
+  int prev_level = load_shed_level_;
+  load_shed_level_ = level;
+
+  // Before InitImpl(), the policies are set when the probes are deployed.
+  if (state() != State::kActive) {
+    return;
+  }
+  Status s = UpdateLoadShedTracePolicies(prev_level);
+  LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to update the load shed trace policies: $0",
+                                             s.msg());
+}
+
+Status SocketTraceConnector::UpdateLoadShedTracePolicies(int prev_level) {
+  // Tracing everything is the same as having no policy.
+  constexpr struct trace_policy_t kTraceAll = {kTracePolicySampleRateDenom, 0};
+
+  for (const auto& p : TrafficProtocolEnumValues()) {
+    if (!protocol_transfer_specs_[p].enabled) {
+      continue;
+    }
+    for (EndpointRole role : {kRoleClient, kRoleServer}) {
+      struct trace_policy_key_t key = {};
+      key.tgid = 0;
+      key.protocol = p;
+      key.role = role;
+
+      std::optional<struct trace_policy_t> configured;
+      for (const auto& spec : configured_trace_policies_) {
+        if (spec.key.protocol == p && spec.key.role == role) {
+          configured = spec.policy;
+        }
+      }
+
+      if (load_shed_level_ > 0) {
+        PL_RETURN_IF_ERROR(
+            UpdateBPFTracePolicy(key, ShedTracePolicy(configured.value_or(kTraceAll),
+                                                      load_shed_level_)));
+      } else if (configured.has_value()) {
+        PL_RETURN_IF_ERROR(UpdateBPFTracePolicy(key, configured.value()));
+      } else if (prev_level > 0) {
+        PL_RETURN_IF_ERROR(RemoveBPFTracePolicy(key));
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status SocketTraceConnector::UpdateBPFTracePolicy(const struct trace_policy_key_t& key,
+                                                  const struct trace_policy_t& policy) {
+  auto policy_map_handle =
+      GetHashTable<struct trace_policy_key_t, struct trace_policy_t>(kTracePolicyMapName);
+  auto update_res = policy_map_handle.update_value(key, policy);
+  if (!update_res.ok()) {
+    return error::Internal("Failed to set trace policy for tgid=$0 protocol=$1, error message: $2",
+                           key.tgid, magic_enum::enum_name(key.protocol), update_res.msg());
+  }
+  return Status::OK();
+}
+
+Status SocketTraceConnector::RemoveBPFTracePolicy(const struct trace_policy_key_t& key) {
+  auto policy_map_handle =
+      GetHashTable<struct trace_policy_key_t, struct trace_policy_t>(kTracePolicyMapName);
+  auto remove_res = policy_map_handle.remove_value(key);
+  if (!remove_res.ok()) {
+    return error::Internal(
+        "Failed to remove trace policy for tgid=$0 protocol=$1, error message: $2", key.tgid,
+        magic_enum::enum_name(key.protocol), remove_res.msg());
+  }
+  return Status::OK();
+}
+
 Status SocketTraceConnector::TestOnlySetTargetPID(int64_t pid) {
   auto control_map_handle = GetPerCPUArrayTable<int64_t>(kControlValuesArrayName);
   return UpdatePerCPUArrayValue(kTargetTGIDIndex, pid, &control_map_handle);
@@ -459,11 +737,22 @@ Status SocketTraceConnector::DisableSelfTracing() {
 // Perf Buffer Polling and Callback functions.
 //-----------------------------------------------------------------------------
 
+void SocketTraceConnector::PollPerfBuffers(int timeout_ms) {
+  BCCWrapper::PollPerfBuffers(timeout_ms);
+  AcceptDataEvents(&staged_data_events_);
+}
+
+void SocketTraceConnector::PollRingBuffers(int timeout_ms) {
+  BCCWrapper::PollRingBuffers(timeout_ms);
+  AcceptDataEvents(&staged_data_events_);
+}
+
 void SocketTraceConnector::HandleDataEvent(void* cb_cookie, void* data, int /*data_size*/) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
   auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
-  auto data_event_ptr = std::make_unique<SocketDataEvent>(data);
-  connector->AcceptDataEvent(std::move(data_event_ptr));
+  // The event is staged, and handed to its tracker along with the other events of its connection
+  // once the poll completes. See AcceptDataEvents().
+  connector->staged_data_events_.push_back(std::make_unique<SocketDataEvent>(data));
 }
 
 void SocketTraceConnector::HandleDataEventLoss(void* cb_cookie, uint64_t lost) {
@@ -480,8 +769,10 @@ void SocketTraceConnector::HandleControlEvent(void* cb_cookie, void* data, int /
 
 void SocketTraceConnector::HandleControlEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossSocketControlEvent,
-                                                                  lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossSocketControlEvent, lost);
+  // The lost events may have invalidated cached FD links.
+  connector->fd_link_cache_->Clear();
 }
 
 void SocketTraceConnector::HandleConnStatsEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -507,19 +798,20 @@ void SocketTraceConnector::HandleMMapEventLoss(void* cb_cookie, uint64_t lost) {
   static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossMMapEvent, lost);
 }
 
-void SocketTraceConnector::HandleHTTP2HeaderEvent(void* cb_cookie, void* data, int /*data_size*/) {
+void SocketTraceConnector::HandleHTTP2HeaderEvent(void* cb_cookie, void* data, int data_size) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
 
   auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
 
-  auto event = std::make_unique<HTTP2HeaderEvent>(data);
-
-  VLOG(3) << absl::Substitute(
-      "t=$0 pid=$1 type=$2 fd=$3 tsid=$4 stream_id=$5 end_stream=$6 name=$7 value=$8",
-      event->attr.timestamp_ns, event->attr.conn_id.upid.pid,
-      magic_enum::enum_name(event->attr.type), event->attr.conn_id.fd, event->attr.conn_id.tsid,
-      event->attr.stream_id, event->attr.end_stream, event->name, event->value);
-  connector->AcceptHTTP2Header(std::move(event));
+  // Each perf event carries a batch of the header fields of a frame.
+  for (auto& event : UnpackHTTP2HeaderEvents(data, data_size)) {
+    VLOG(3) << absl::Substitute(
+        "t=$0 pid=$1 type=$2 fd=$3 tsid=$4 stream_id=$5 end_stream=$6 name=$7 value=$8",
+        event->attr.timestamp_ns, event->attr.conn_id.upid.pid,
+        magic_enum::enum_name(event->attr.type), event->attr.conn_id.fd, event->attr.conn_id.tsid,
+        event->attr.stream_id, event->attr.end_stream, event->name, event->value);
+    connector->AcceptHTTP2Header(std::move(event));
+  }
 }
 
 void SocketTraceConnector::HandleHTTP2HeaderEventLoss(void* cb_cookie, uint64_t lost) {
@@ -571,10 +863,50 @@ void SocketTraceConnector::AcceptDataEvent(std::unique_ptr<SocketDataEvent> even
   tracker.AddDataEvent(std::move(event));
 }
 
+namespace {
+
+bool ConnIDLess(const struct conn_id_t& a, const struct conn_id_t& b) {
+  return std::tie(a.upid.pid, a.upid.start_time_ticks, a.fd, a.tsid) <
+         std::tie(b.upid.pid, b.upid.start_time_ticks, b.fd, b.tsid);
+}
+
+}  // namespace
+
+void SocketTraceConnector::AcceptDataEvents(std::vector<std::unique_ptr<SocketDataEvent>>* events) {
+  // The per-CPU buffers are drained one after the other, so the events of a connection are
+  // scattered across the batch. A stable sort groups them, and keeps the order in which they
+  // arrived within each connection.
+  std::stable_sort(events->begin(), events->end(),
+                   [](const std::unique_ptr<SocketDataEvent>& a,
+                      const std::unique_ptr<SocketDataEvent>& b) {
+                     return ConnIDLess(a->attr.conn_id, b->attr.conn_id);
+                   });
+
+  auto iter = events->begin();
+  while (iter != events->end()) {
+    const struct conn_id_t conn_id = (*iter)->attr.conn_id;
+    ConnTracker& tracker = GetOrCreateConnTracker(conn_id);
+    for (; iter != events->end() && (*iter)->attr.conn_id == conn_id; ++iter) {
+      std::unique_ptr<SocketDataEvent>& event = *iter;
+      event->attr.timestamp_ns += ClockRealTimeOffset();
+
+      if (perf_buffer_events_output_stream_ != nullptr) {
+        WriteDataEvent(*event);
+      }
+
+      tracker.AddDataEvent(std::move(event));
+    }
+  }
+  events->clear();
+}
+
 void SocketTraceConnector::AcceptControlEvent(socket_control_event_t event) {
   // timestamp_ns is a common field of open and close fields.
   event.timestamp_ns += ClockRealTimeOffset();
 
+  // The FD now refers to another file, or to none.
+  fd_link_cache_->Invalidate(event.conn_id.upid.pid, event.conn_id.fd);
+
   ConnTracker& tracker = GetOrCreateConnTracker(event.conn_id);
   tracker.AddControlEvent(event);
 }
@@ -586,6 +918,45 @@ void SocketTraceConnector::AcceptConnStatsEvent(conn_stats_event_t event) {
   tracker.AddConnStats(event);
 }
 
+void SocketTraceConnector::ReadConnStatsMap() {
+  auto conn_stats_map = GetBatchHashTable<struct conn_id_t, struct conn_stats_event_t>(
+      "conn_stats_map");
+  auto entries_or = conn_stats_map.GetTableOffline();
+  if (!entries_or.ok()) {
+    LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to read conn_stats_map: $0",
+                                                 entries_or.msg());
+    return;
+  }
+
+  std::vector<struct conn_id_t> closed_conns;
+  for (const auto& [conn_id, event] : entries_or.ValueOrDie()) {
+    std::pair<uint64_t, uint64_t> key = {
+        (static_cast<uint64_t>(conn_id.upid.pid) << 32) | static_cast<uint32_t>(conn_id.fd),
+        conn_id.tsid};
+    bool closed = event.conn_events & CONN_CLOSE;
+    if (closed) {
+      closed_conns.push_back(conn_id);
+    }
+    auto [iter, inserted] = conn_stats_map_timestamps_.try_emplace(key, event.timestamp_ns);
+    if (!inserted && iter->second == event.timestamp_ns) {
+      // The connection was idle since the last read.
+    } else {
+      iter->second = event.timestamp_ns;
+      AcceptConnStatsEvent(event);
+    }
+    if (closed) {
+      conn_stats_map_timestamps_.erase(iter);
+    }
+  }
+
+  if (!closed_conns.empty()) {
+    auto removed_or = conn_stats_map.RemoveValues(closed_conns);
+    LOG_IF(WARNING, !removed_or.ok())
+        << absl::Substitute("Failed to remove closed connections from conn_stats_map: $0",
+                            removed_or.msg());
+  }
+}
+
 void SocketTraceConnector::AcceptHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> event) {
   event->attr.timestamp_ns += ClockRealTimeOffset();
 
@@ -617,6 +988,47 @@ int64_t CalculateLatency(int64_t req_timestamp_ns, int64_t resp_timestamp_ns) {
   return latency_ns;
 }
 
+// The gRPC methods of --stirling_grpc_descriptor_sets, or nullptr if there are none.
+grpc::GRPCMethodRegistry* GRPCMethods() {
+  static const std::unique_ptr<grpc::GRPCMethodRegistry> registry =
+      []() -> std::unique_ptr<grpc::GRPCMethodRegistry> {
+    if (FLAGS_stirling_grpc_descriptor_sets.empty()) {
+      return nullptr;
+    }
+    std::vector<std::string> paths =
+        absl::StrSplit(FLAGS_stirling_grpc_descriptor_sets, ',', absl::SkipEmpty());
+    StatusOr<std::unique_ptr<grpc::GRPCMethodRegistry>> registry_status =
+        grpc::GRPCMethodRegistry::CreateFromFiles(paths);
+    if (!registry_status.ok()) {
+      LOG(WARNING) << absl::Substitute(
+          "Failed to load the gRPC descriptors, gRPC bodies are decoded without schemas. "
+          "Message: $0",
+          registry_status.msg());
+      return nullptr;
+    }
+    return registry_status.ConsumeValueOrDie();
+  }();
+  return registry.get();
+}
+
+// Decodes a gRPC body as JSON with the schema of its message, if the message type is known.
+std::string ParseGRPCBody(std::string_view body, grpc::GRPCMethodRegistry* grpc_methods,
+                          const google::protobuf::Message* prototype, size_t str_truncation_len) {
+  if (prototype == nullptr) {
+    return grpc::ParsePB(body, str_truncation_len);
+  }
+  return grpc_methods->ParsePBToJSON(body, *prototype, str_truncation_len, kMaxBodyBytes);
+}
+
+// Encodes headers for the req_headers and resp_headers columns.
+template <typename TContainer>
+std::string HeadersColumnValue(const TContainer& headers, size_t max_bytes) {
+  if (FLAGS_stirling_http_compact_headers) {
+    return http_headers::EncodeHeaders(headers, max_bytes);
+  }
+  return ToJSONString(headers);
+}
+
 }  // namespace
 
 template <>
@@ -627,7 +1039,9 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
   // Currently decompresses gzip content, but could handle other transformations too.
   // Note that we do this after filtering to avoid burning CPU cycles unnecessarily.
-  protocols::http::PreProcessMessage(&resp_message);
+  // One byte more than the column keeps is decompressed, so that the body is recorded with the
+  // truncation marker.
+  protocols::http::PreProcessMessage(&resp_message, kMaxBodyBytes + 1);
 
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
@@ -648,15 +1062,17 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("major_version")>(1);
   r.Append<r.ColIndex("minor_version")>(resp_message.minor_version);
   r.Append<r.ColIndex("content_type")>(static_cast<uint64_t>(content_type));
-  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(ToJSONString(req_message.headers));
+  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(
+      HeadersColumnValue(req_message.headers, kMaxHTTPHeadersBytes));
   r.Append<r.ColIndex("req_method")>(std::move(req_message.req_method));
   r.Append<r.ColIndex("req_path")>(std::move(req_message.req_path));
-  r.Append<r.ColIndex("req_body_size")>(req_message.body.size());
+  r.Append<r.ColIndex("req_body_size")>(req_message.BodySize());
   r.Append<r.ColIndex("req_body"), kMaxBodyBytes>(std::move(req_message.body));
-  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_message.headers));
+  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(
+      HeadersColumnValue(resp_message.headers, kMaxHTTPHeadersBytes));
   r.Append<r.ColIndex("resp_status")>(resp_message.resp_status);
   r.Append<r.ColIndex("resp_message")>(std::move(resp_message.resp_message));
-  r.Append<r.ColIndex("resp_body_size")>(resp_message.body.size());
+  r.Append<r.ColIndex("resp_body_size")>(resp_message.BodySize());
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(resp_message.body));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_message.timestamp_ns, resp_message.timestamp_ns));
@@ -668,8 +1084,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
                                          protocols::http2::Record record, DataTable* data_table) {
-  using ::px::grpc::MethodInputOutput;
-  using ::px::stirling::grpc::ParsePB;
+  using ::px::grpc::MethodPrototypes;
 
   protocols::http2::HalfStream* req_stream;
   protocols::http2::HalfStream* resp_stream;
@@ -702,11 +1117,14 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   size_t resp_data_size = resp_stream->original_data_size();
   if (record.HasGRPCContentType()) {
     content_type = HTTPContentType::kGRPC;
-    req_data = ParsePB(req_data, kMaxPBStringLen);
+    grpc::GRPCMethodRegistry* grpc_methods = GRPCMethods();
+    MethodPrototypes method =
+        grpc_methods == nullptr ? MethodPrototypes{} : grpc_methods->Lookup(path);
+    req_data = ParseGRPCBody(req_data, grpc_methods, method.input, kMaxPBStringLen);
     if (req_stream->data_truncated()) {
       req_data.append(DataTable::kTruncatedMsg);
     }
-    resp_data = ParsePB(resp_data, kMaxPBStringLen);
+    resp_data = ParseGRPCBody(resp_data, grpc_methods, method.output, kMaxPBStringLen);
     if (resp_stream->data_truncated()) {
       resp_data.append(DataTable::kTruncatedMsg);
     }
@@ -721,9 +1139,11 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("major_version")>(2);
   // HTTP2 does not define minor version.
   r.Append<r.ColIndex("minor_version")>(0);
-  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(ToJSONString(req_stream->headers()));
+  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(
+      HeadersColumnValue(req_stream->headers(), kMaxHTTPHeadersBytes));
   r.Append<r.ColIndex("content_type")>(static_cast<uint64_t>(content_type));
-  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_stream->headers()));
+  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(
+      HeadersColumnValue(resp_stream->headers(), kMaxHTTPHeadersBytes));
   r.Append<r.ColIndex("req_method")>(
       req_stream->headers().ValueByKey(protocols::http2::headers::kMethod));
   r.Append<r.ColIndex("req_path")>(req_stream->headers().ValueByKey(":path"));
@@ -879,6 +1299,29 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 #endif
 }
 
+template <>
+void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
+                                         protocols::kafka::Record entry, DataTable* data_table) {
+  md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
+                conn_tracker.conn_id().upid.start_time_ticks);
+
+  DataTable::RecordBuilder<&kKafkaTable> r(data_table, entry.resp.timestamp_ns);
+  r.Append<r.ColIndex("time_")>(entry.resp.timestamp_ns);
+  r.Append<r.ColIndex("upid")>(upid.value());
+  r.Append<r.ColIndex("remote_addr")>(conn_tracker.remote_endpoint().AddrStr());
+  r.Append<r.ColIndex("remote_port")>(conn_tracker.remote_endpoint().port());
+  r.Append<r.ColIndex("trace_role")>(conn_tracker.role());
+  r.Append<r.ColIndex("req_cmd")>(static_cast<int64_t>(entry.req.api_key));
+  r.Append<r.ColIndex("client_id")>(std::move(entry.req.client_id));
+  r.Append<r.ColIndex("req_body"), kMaxBodyBytes>(std::move(entry.req.msg));
+  r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(entry.resp.msg));
+  r.Append<r.ColIndex("latency")>(
+      CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+#ifndef NDEBUG
+  r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
+#endif
+}
+
 void SocketTraceConnector::SetupOutput(const std::filesystem::path& path) {
   DCHECK(!path.empty());
 
@@ -957,6 +1400,73 @@ void SocketTraceConnector::TransferStream(ConnectorContext* ctx, ConnTracker* tr
   }
 }
 
+void SocketTraceConnector::TransferConnTracker(ConnectorContext* ctx, ConnTracker* tracker,
+                                               const std::vector<DataTable*>& data_tables) {
+  const auto& transfer_spec = protocol_transfer_specs_[tracker->protocol()];
+  DataTable* data_table = data_tables[transfer_spec.table_num];
+  if (transfer_spec.enabled && transfer_spec.demanded && transfer_spec.transfer_fn &&
+      data_table != nullptr) {
+    transfer_spec.transfer_fn(*this, ctx, tracker, data_table);
+  }
+}
+
+void SocketTraceConnector::TransferConnTrackersParallel(
+    ConnectorContext* ctx, const std::vector<DataTable*>& data_tables,
+    const std::vector<CIDRBlock>& cluster_cidrs, size_t num_shards) {
+  // The pre-tick and post-tick run on this thread, because they use the shared ProcParser,
+  // SocketInfoManager and BPF maps. Only the parsing and stitching is spread across threads.
+  std::vector<std::vector<ConnTracker*>> shards(num_shards);
+  for (const auto& conn_tracker : conn_trackers_mgr_.hot_trackers()) {
+    UpdateTrackerTraceLevel(conn_tracker);
+
+    conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, fd_link_cache_.get(),
+                                   socket_info_mgr_.get());
+
+    // Shard by connection, so the records of a connection are always produced in order by a
+    // single thread.
+    const struct conn_id_t& conn_id = conn_tracker->conn_id();
+    uint64_t hash = HashCombine(HashCombine(conn_id.upid.pid, conn_id.fd), conn_id.tsid);
+    shards[hash % num_shards].push_back(conn_tracker);
+  }
+
+  // DataTable is not thread-safe, so each shard appends to staging tables of its own, which
+  // are merged into the output tables once all the shards are done.
+  std::vector<std::vector<std::unique_ptr<DataTable>>> staging_tables(num_shards);
+  std::vector<std::vector<DataTable*>> staging_table_ptrs(num_shards);
+  for (size_t i = 0; i < num_shards; ++i) {
+    for (size_t table_num = 0; table_num < data_tables.size(); ++table_num) {
+      if (data_tables[table_num] == nullptr || table_num == kConnStatsTableNum) {
+        staging_tables[i].push_back(nullptr);
+      } else {
+        staging_tables[i].push_back(
+            std::make_unique<DataTable>(data_tables[table_num]->id(), kTables[table_num]));
+      }
+      staging_table_ptrs[i].push_back(staging_tables[i].back().get());
+    }
+  }
+
+  if (transfer_pool_ == nullptr || transfer_pool_->num_threads() != num_shards) {
+    transfer_pool_ = std::make_unique<utils::WorkerPool>(num_shards);
+  }
+  transfer_pool_->Run(num_shards, [&](size_t i) {
+    for (ConnTracker* conn_tracker : shards[i]) {
+      TransferConnTracker(ctx, conn_tracker, staging_table_ptrs[i]);
+    }
+  });
+
+  for (const auto& shard_tables : staging_tables) {
+    for (size_t table_num = 0; table_num < data_tables.size(); ++table_num) {
+      if (shard_tables[table_num] != nullptr) {
+        data_tables[table_num]->Merge(shard_tables[table_num].get());
+      }
+    }
+  }
+
+  for (const auto& conn_tracker : conn_trackers_mgr_.hot_trackers()) {
+    conn_tracker->IterationPostTick();
+  }
+}
+
 void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* data_table) {
   namespace idx = ::px::stirling::conn_stats_idx;
 
@@ -28,6 +28,7 @@
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
 
 #include "src/common/grpcutils/service_descriptor_database.h"
@@ -36,6 +37,7 @@
 #include "src/stirling/obj_tools/dwarf_tools.h"
 #include "src/stirling/obj_tools/elf_tools.h"
 
+#include "src/stirling/core/cgroup_filter.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/conn_stats.h"
@@ -43,12 +45,18 @@
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_tables.h"
+#include "src/stirling/source_connectors/socket_tracer/trace_policy.h"
 #include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
 #include "src/stirling/utils/proc_path_tools.h"
 #include "src/stirling/utils/proc_tracker.h"
+#include "src/stirling/utils/worker_pool.h"
 
 DECLARE_uint32(stirling_conn_stats_sampling_ratio);
 DECLARE_bool(stirling_enable_periodic_bpf_map_cleanup);
+DECLARE_uint32(stirling_conn_tracker_transfer_threads);
+DECLARE_bool(stirling_socket_tracer_data_ringbuf);
+DECLARE_bool(stirling_conn_stats_bpf_map);
+DECLARE_string(stirling_socket_trace_policies);
 DECLARE_string(perf_buffer_events_output_path);
 DECLARE_bool(stirling_enable_http_tracing);
 DECLARE_bool(stirling_enable_http2_tracing);
@@ -56,6 +64,7 @@ DECLARE_bool(stirling_enable_mysql_tracing);
 DECLARE_bool(stirling_enable_cass_tracing);
 DECLARE_bool(stirling_enable_dns_tracing);
 DECLARE_bool(stirling_enable_redis_tracing);
+DECLARE_bool(stirling_enable_kafka_tracing);
 DECLARE_bool(stirling_disable_self_tracing);
 DECLARE_string(stirling_role_to_trace);
 
@@ -69,7 +78,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
  public:
   static constexpr std::string_view kName = "socket_tracer";
   static constexpr auto kTables = MakeArray(kConnStatsTable, kHTTPTable, kMySQLTable, kCQLTable,
-                                            kPGSQLTable, kDNSTable, kRedisTable);
+                                            kPGSQLTable, kDNSTable, kRedisTable, kKafkaTable);
 
   static constexpr uint32_t kConnStatsTableNum = TableNum(kTables, kConnStatsTable);
   static constexpr uint32_t kHTTPTableNum = TableNum(kTables, kHTTPTable);
@@ -78,6 +87,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr uint32_t kPGSQLTableNum = TableNum(kTables, kPGSQLTable);
   static constexpr uint32_t kDNSTableNum = TableNum(kTables, kDNSTable);
   static constexpr uint32_t kRedisTableNum = TableNum(kTables, kRedisTable);
+  static constexpr uint32_t kKafkaTableNum = TableNum(kTables, kKafkaTable);
 
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{200};
   // TODO(yzhao): This is not used right now. Eventually use this to control data push frequency.
@@ -91,6 +101,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   Status StopImpl() override;
   void InitContextImpl(ConnectorContext* ctx) override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+  double SamplingLoad(const std::vector<DataTable*>& data_tables) override;
 
   // Perform actions that are not specifically targeting a table.
   // For example, drain perf buffers, deploy new uprobes, and update socket info manager.
@@ -99,12 +110,28 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // That would then cause performance overheads.
   void UpdateCommonState(ConnectorContext* ctx);
 
+  // Drain the perf buffers and ring buffers like BCCWrapper does, then hand the data events that
+  // were staged by the poll to their connection trackers.
+  void PollPerfBuffers(int timeout_ms = 0);
+  void PollRingBuffers(int timeout_ms = 0);
+
   // Updates control map value for protocol, which specifies which role(s) to trace for the given
   // protocol's traffic.
   //
   // Role_mask a bit mask, and represents the EndpointRole roles that are allowed to transfer
   // data from inside BPF to user-space.
   Status UpdateBPFProtocolTraceRole(TrafficProtocol protocol, uint64_t role_mask);
+
+  // Sets or removes the BPF trace policy of a {tgid, protocol, role}, which samples connections and
+  // limits the bytes sent per syscall. Policies can be changed while the probes are running.
+  Status UpdateBPFTracePolicy(const struct trace_policy_key_t& key,
+                              const struct trace_policy_t& policy);
+  Status RemoveBPFTracePolicy(const struct trace_policy_key_t& key);
+
+  // Sets the policies of all processes for load_shed_level_, or restores the configured ones at
+  // level 0. The policies of prev_level are the ones replaced.
+  Status UpdateLoadShedTracePolicies(int prev_level);
+
   Status TestOnlySetTargetPID(int64_t pid);
   Status DisableSelfTracing();
 
@@ -113,6 +140,14 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
     pids_to_trace_disable_.insert(pid);
   }
 
+  // Pauses the tracing of the enabled protocols whose tables are out of demand, both in BPF and
+  // in user-space, and resumes it once they are in demand again.
+  void SetTableDemand(const absl::flat_hash_set<std::string>& table_names) override;
+
+  // On top of the longer cycles, samples fewer connections and captures less of each syscall, by
+  // replacing the policies of all processes with ShedTracePolicy() of the configured ones.
+  void SetLoadShedLevel(int level) override;
+
   /**
    * Gets a pointer to the most recent ConnTracker for the given pid and fd.
    *
@@ -208,6 +243,11 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
       {"go_grpc_data_events", HandleHTTP2Data, HandleHTTP2DataLoss, kTargetDataBufferSize},
   });
 
+  // Replaces the socket_data_events perf buffer when --stirling_socket_tracer_data_ringbuf is
+  // set. There is a single ring buffer for all CPUs, so it is sized for the whole data rate.
+  inline static const bpf_tools::RingBufferSpec kDataRingBufferSpec = {"socket_data_events",
+                                                                        HandleDataEvent};
+
   // Most HTTP servers support 8K headers, so we truncate after that.
   // https://stackoverflow.com/questions/686217/maximum-on-http-header-values
   inline static constexpr size_t kMaxHTTPHeadersBytes = 8192;
@@ -233,8 +273,18 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   // Events from BPF.
   void AcceptDataEvent(std::unique_ptr<SocketDataEvent> event);
+  // Accepts a batch of data events, grouped by connection, so that each run of events of a
+  // connection costs a single tracker lookup. The batch is left empty, ready for reuse.
+  void AcceptDataEvents(std::vector<std::unique_ptr<SocketDataEvent>>* events);
   void AcceptControlEvent(socket_control_event_t event);
   void AcceptConnStatsEvent(conn_stats_event_t event);
+  // Accepts the totals of the connections whose stats changed since the last read of
+  // conn_stats_map, and deletes the entries of the closed connections.
+  void ReadConnStatsMap();
+
+  // Logs the occupancy and pressure of conn_info_map, as a warning if inserts failed since the
+  // last report.
+  void ReportConnInfoMapStats();
   void AcceptHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> event);
   void AcceptHTTP2Data(std::unique_ptr<HTTP2DataEvent> event);
 
@@ -242,6 +292,18 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   void TransferStreams(ConnectorContext* ctx, uint32_t table_num, DataTable* data_table);
   void TransferConnStats(ConnectorContext* ctx, DataTable* data_table);
 
+  // Runs the transfer_fn of the tracker's protocol, if the protocol is enabled and its table is
+  // subscribed to.
+  void TransferConnTracker(ConnectorContext* ctx, ConnTracker* tracker,
+                           const std::vector<DataTable*>& data_tables);
+
+  // Transfers all the active trackers, with their parsing and stitching spread across
+  // num_shards threads of transfer_pool_.
+  void TransferConnTrackersParallel(ConnectorContext* ctx,
+                                    const std::vector<DataTable*>& data_tables,
+                                    const std::vector<CIDRBlock>& cluster_cidrs,
+                                    size_t num_shards);
+
   template <typename TProtocolTraits>
   void TransferStream(ConnectorContext* ctx, ConnTracker* tracker, DataTable* data_table);
 
@@ -267,6 +329,9 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   ConnTrackersManager conn_trackers_mgr_;
 
+  // The threads of TransferConnTrackersParallel(). Recreated if the number of threads changes.
+  std::unique_ptr<utils::WorkerPool> transfer_pool_;
+
   ConnStats conn_stats_;
 
   absl::flat_hash_set<int> pids_to_trace_disable_;
@@ -279,6 +344,16 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
     std::vector<EndpointRole> trace_roles;
     std::function<void(SocketTraceConnector&, ConnectorContext*, ConnTracker*, DataTable*)>
         transfer_fn = nullptr;
+    // Whether the agent queries or retains the table, see SetTableDemand().
+    bool demanded = true;
+
+    uint64_t TraceRoleMask() const {
+      uint64_t role_mask = 0;
+      for (auto role : trace_roles) {
+        role_mask |= role;
+      }
+      return role_mask;
+    }
   };
 
   // This map controls how each protocol is processed and transferred.
@@ -296,6 +371,10 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   //   Example: data_table->SetConsumeRecordsCutoffTime(perf_buffer_drain_time_);
   uint64_t perf_buffer_drain_time_ = 0;
 
+  // Data events received during the current poll of the buffers. They are handed to the
+  // trackers once the poll completes, instead of one at a time by the poll callback.
+  std::vector<std::unique_ptr<SocketDataEvent>> staged_data_events_;
+
   // If not a nullptr, writes the events received from perf buffers to this stream.
   std::unique_ptr<std::ofstream> perf_buffer_events_output_stream_;
   enum class OutputFormat {
@@ -309,8 +388,31 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   std::unique_ptr<system::ProcParser> proc_parser_;
 
+  // The /proc/<pid>/fd links read to infer the connections whose open was not traced.
+  std::unique_ptr<FDLinkCache> fd_link_cache_;
+
+  // Only set when the probes filter on cgroups, see CGroupFilter::CreateFromFlags().
+  std::unique_ptr<CGroupFilter> cgroup_filter_;
+
+  // The policies of --stirling_socket_trace_policies, which the load shedding policies derive from
+  // and are restored to.
+  std::vector<TracePolicySpec> configured_trace_policies_;
+  int load_shed_level_ = 0;
+
   std::shared_ptr<ConnInfoMapManager> conn_info_map_mgr_;
 
+  // Whether the data events come from kDataRingBufferSpec rather than a perf buffer.
+  bool use_data_ringbuf_ = false;
+
+  // Whether the conn stats are read from conn_stats_map rather than sent as conn_stats_events.
+  bool use_conn_stats_map_ = false;
+  // The timestamp of the last update of each conn_stats_map entry that was accepted, so that the
+  // entries of idle connections are skipped. Key is {tgid_fd, tsid}.
+  absl::flat_hash_map<std::pair<uint64_t, uint64_t>, uint64_t> conn_stats_map_timestamps_;
+
+  // The last reported stats of conn_info_map.
+  ConnInfoMapStats conn_info_map_stats_;
+
   UProbeManager uprobe_mgr_;
 
   enum class StatKey {
@@ -324,10 +426,21 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   utils::StatCounter<StatKey> stats_;
 
+  // Export stats_ and the ConnTracker counts on /metrics.
+  utils::StatCounterGauges<StatKey> stats_gauges_{"stirling_socket_tracer_stats",
+                                                  "Socket tracer statistics."};
+  utils::StatCounterGauges<ConnTrackersManager::StatKey> conn_tracker_gauges_{
+      "stirling_conn_trackers", "ConnTracker counts, and the bytes they hold per protocol."};
+
+  // The value of kLossSocketDataEvent at the last SamplingLoad() call.
+  int64_t last_data_event_loss_ = 0;
+
   FRIEND_TEST(SocketTraceConnectorTest, AppendNonContiguousEvents);
   FRIEND_TEST(SocketTraceConnectorTest, NoEvents);
   FRIEND_TEST(SocketTraceConnectorTest, SortedByResponseTime);
   FRIEND_TEST(SocketTraceConnectorTest, HTTPBasic);
+  FRIEND_TEST(SocketTraceConnectorTest, HTTPParallelTransfer);
+  FRIEND_TEST(SocketTraceConnectorTest, HTTPBatchedDataEvents);
   FRIEND_TEST(SocketTraceConnectorTest, HTTPContentType);
   FRIEND_TEST(SocketTraceConnectorTest, UPIDCheck);
   FRIEND_TEST(SocketTraceConnectorTest, RequestResponseMatching);
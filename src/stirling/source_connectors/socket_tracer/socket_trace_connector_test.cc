@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 
 #include <sys/socket.h>
+#include <algorithm>
 #include <memory>
 
 #include "src/shared/metadata/metadata.h"
@@ -45,6 +46,8 @@ namespace cass = protocols::cass;
 
 using ::testing::Each;
 using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
 
 using ::px::stirling::testing::ColWrapperSizeIs;
 
@@ -258,6 +261,89 @@ TEST_F(SocketTraceConnectorTest, HTTPBasic) {
   EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), ElementsAre("foo"));
 }
 
+TEST_F(SocketTraceConnectorTest, HTTPTableDemand) {
+  testing::EventGenerator event_gen(&mock_clock_);
+
+  // HTTP is out of demand, so it isn't transferred.
+  source_->SetTableDemand({"mysql_events"});
+  source_->AcceptControlEvent(event_gen.InitConn());
+  source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq0));
+  source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kResp0));
+  source_->AcceptControlEvent(event_gen.InitClose());
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+  EXPECT_THAT(http_table_->ConsumeRecords(), IsEmpty());
+
+  // Back in demand.
+  testing::EventGenerator event_gen2(&mock_clock_, kPID, kFD + 1);
+  source_->SetTableDemand({"http_events", "mysql_events"});
+  source_->AcceptControlEvent(event_gen2.InitConn());
+  source_->AcceptDataEvent(event_gen2.InitSendEvent<kProtocolHTTP>(kReq0));
+  source_->AcceptDataEvent(event_gen2.InitRecvEvent<kProtocolHTTP>(kResp0));
+  source_->AcceptControlEvent(event_gen2.InitClose());
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  EXPECT_THAT(tablets[0].records, Each(ColWrapperSizeIs(1)));
+}
+
+TEST_F(SocketTraceConnectorTest, HTTPParallelTransfer) {
+  gflags::FlagSaver flag_saver;
+  FLAGS_stirling_conn_tracker_transfer_threads = 4;
+
+  // Each connection is on its own fd, and sends two requests, so that the records of every
+  // connection must come out in order.
+  constexpr int kNumConns = 16;
+  for (int i = 0; i < kNumConns; ++i) {
+    testing::EventGenerator event_gen(&mock_clock_, testing::kPID, /*fd*/ i + 1);
+    source_->AcceptControlEvent(event_gen.InitConn());
+    source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq0));
+    source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kJSONResp));
+    source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq1));
+    source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kTextResp));
+    source_->AcceptControlEvent(event_gen.InitClose());
+  }
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+
+  EXPECT_THAT(record_batch, Each(ColWrapperSizeIs(2 * kNumConns)));
+  std::vector<std::string> resp_bodies = ToStringVector(record_batch[kHTTPRespBodyIdx]);
+  EXPECT_EQ(kNumConns, std::count(resp_bodies.begin(), resp_bodies.end(), "foo"));
+  EXPECT_EQ(kNumConns, std::count(resp_bodies.begin(), resp_bodies.end(), "bar"));
+}
+
+TEST_F(SocketTraceConnectorTest, HTTPBatchedDataEvents) {
+  testing::EventGenerator event_gen0(&mock_clock_, testing::kPID, /*fd*/ 1);
+  testing::EventGenerator event_gen1(&mock_clock_, testing::kPID, /*fd*/ 2);
+  source_->AcceptControlEvent(event_gen0.InitConn());
+  source_->AcceptControlEvent(event_gen1.InitConn());
+
+  // The events of the two connections are interleaved, as they would be when drained from
+  // the per-CPU buffers.
+  std::vector<std::unique_ptr<SocketDataEvent>> events;
+  events.push_back(event_gen0.InitSendEvent<kProtocolHTTP>(kReq0));
+  events.push_back(event_gen1.InitSendEvent<kProtocolHTTP>(kReq1));
+  events.push_back(event_gen0.InitRecvEvent<kProtocolHTTP>(kJSONResp));
+  events.push_back(event_gen1.InitRecvEvent<kProtocolHTTP>(kTextResp));
+  source_->AcceptDataEvents(&events);
+  EXPECT_TRUE(events.empty());
+
+  source_->AcceptControlEvent(event_gen0.InitClose());
+  source_->AcceptControlEvent(event_gen1.InitClose());
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+
+  EXPECT_THAT(record_batch, Each(ColWrapperSizeIs(2)));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), UnorderedElementsAre("foo", "bar"));
+}
+
 TEST_F(SocketTraceConnectorTest, HTTPContentType) {
   testing::EventGenerator event_gen(&mock_clock_);
   struct socket_control_event_t conn = event_gen.InitConn();
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/trace_policy.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <magic_enum.hpp>
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+// Finds the enum value whose name, without the given prefix, matches the name in any case.
+template <typename TEnum>
+std::optional<TEnum> EnumFromShortName(std::string_view prefix, std::string_view name) {
+  for (const auto& [value, value_name] : magic_enum::enum_entries<TEnum>()) {
+    if (absl::StartsWith(value_name, prefix) &&
+        absl::EqualsIgnoreCase(value_name.substr(prefix.size()), name)) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+StatusOr<TracePolicySpec> ParseTracePolicy(std::string_view spec) {
+  std::vector<std::string_view> fields = absl::StrSplit(spec, ':');
+  if (fields.size() != 3 && fields.size() != 4) {
+    return error::InvalidArgument(
+        "Trace policy '$0' must have the form <protocol>:<role>:<sample_rate>[:<max_bytes>]",
+        spec);
+  }
+
+  std::optional<TrafficProtocol> protocol =
+      EnumFromShortName<TrafficProtocol>("kProtocol", fields[0]);
+  if (!protocol.has_value() || protocol == kProtocolUnknown || protocol == kNumProtocols) {
+    return error::InvalidArgument("Unknown protocol '$0' in trace policy '$1'", fields[0], spec);
+  }
+
+  std::optional<EndpointRole> role = EnumFromShortName<EndpointRole>("kRole", fields[1]);
+  if (!role.has_value() || role == kRoleUnknown) {
+    return error::InvalidArgument("Unknown role '$0' in trace policy '$1'", fields[1], spec);
+  }
+
+  TracePolicySpec policy_spec = {};
+  policy_spec.key.tgid = 0;
+  policy_spec.key.protocol = protocol.value();
+  policy_spec.key.role = role.value();
+
+  if (!absl::SimpleAtoi(fields[2], &policy_spec.policy.sample_rate) ||
+      policy_spec.policy.sample_rate > kTracePolicySampleRateDenom) {
+    return error::InvalidArgument("Invalid sample rate '$0' in trace policy '$1'", fields[2],
+                                  spec);
+  }
+  if (fields.size() == 4 &&
+      !absl::SimpleAtoi(fields[3], &policy_spec.policy.max_bytes_per_syscall)) {
+    return error::InvalidArgument("Invalid max bytes '$0' in trace policy '$1'", fields[3], spec);
+  }
+  return policy_spec;
+}
+
+}  // namespace
+
+StatusOr<std::vector<TracePolicySpec>> ParseTracePolicies(std::string_view specs) {
+  std::vector<TracePolicySpec> policies;
+  for (std::string_view spec : absl::StrSplit(specs, ',', absl::SkipWhitespace())) {
+    PL_ASSIGN_OR_RETURN(TracePolicySpec policy,
+                        ParseTracePolicy(absl::StripAsciiWhitespace(spec)));
+    policies.push_back(policy);
+  }
+  return policies;
+}
+
+struct trace_policy_t ShedTracePolicy(const struct trace_policy_t& policy, int level) {
+  // At level 1, the syscalls keep 16KiB, enough for the headers and a typical body.
+  constexpr uint32_t kShedMaxBytesPerSyscall = 16 * 1024;
+  constexpr int kMaxShift = 8;
+
+  int shift = std::clamp(level, 0, kMaxShift);
+  if (shift == 0) {
+    return policy;
+  }
+  struct trace_policy_t shed = {};
+  shed.sample_rate = std::max<uint32_t>(policy.sample_rate >> shift, 1);
+  shed.max_bytes_per_syscall = kShedMaxBytesPerSyscall >> (2 * (shift - 1));
+  if (policy.max_bytes_per_syscall != 0) {
+    shed.max_bytes_per_syscall = std::min(shed.max_bytes_per_syscall, policy.max_bytes_per_syscall);
+  }
+  return shed;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+
+namespace px {
+namespace stirling {
+
+struct TracePolicySpec {
+  struct trace_policy_key_t key;
+  struct trace_policy_t policy;
+};
+
+/**
+ * Parses a comma-separated list of trace policies for the trace_policy_map BPF map, each of the
+ * form <protocol>:<role>:<sample_rate>[:<max_bytes_per_syscall>], eg. "http:server:10:1024".
+ *
+ * Protocols and roles are the TrafficProtocol and EndpointRole names without their prefix, in
+ * any case (eg. "http", "mysql", "client"). The sample rate is the percentage of connections to
+ * trace. The parsed policies apply to all processes.
+ */
+StatusOr<std::vector<TracePolicySpec>> ParseTracePolicies(std::string_view specs);
+
+/**
+ * Returns the policy that sheds load from the given one, at a load shed level from 1 up: each
+ * level halves the sample rate (down to 1), and caps the bytes per syscall harder, so that less of
+ * the message bodies is captured.
+ */
+struct trace_policy_t ShedTracePolicy(const struct trace_policy_t& policy, int level);
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/trace_policy.h"
+
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+TEST(ParseTracePoliciesTest, Basic) {
+  ASSERT_OK_AND_ASSIGN(std::vector<TracePolicySpec> policies,
+                       ParseTracePolicies("http:server:10:1024, MySQL:client:50"));
+  ASSERT_EQ(policies.size(), 2);
+
+  EXPECT_EQ(policies[0].key.tgid, 0);
+  EXPECT_EQ(policies[0].key.protocol, kProtocolHTTP);
+  EXPECT_EQ(policies[0].key.role, kRoleServer);
+  EXPECT_EQ(policies[0].policy.sample_rate, 10);
+  EXPECT_EQ(policies[0].policy.max_bytes_per_syscall, 1024);
+
+  EXPECT_EQ(policies[1].key.protocol, kProtocolMySQL);
+  EXPECT_EQ(policies[1].key.role, kRoleClient);
+  EXPECT_EQ(policies[1].policy.sample_rate, 50);
+  EXPECT_EQ(policies[1].policy.max_bytes_per_syscall, 0);
+}
+
+TEST(ParseTracePoliciesTest, Empty) {
+  ASSERT_OK_AND_ASSIGN(std::vector<TracePolicySpec> policies, ParseTracePolicies(""));
+  EXPECT_TRUE(policies.empty());
+}
+
+TEST(ParseTracePoliciesTest, Invalid) {
+  EXPECT_NOT_OK(ParseTracePolicies("http:server"));
+  EXPECT_NOT_OK(ParseTracePolicies("http:server:10:1024:1"));
+  EXPECT_NOT_OK(ParseTracePolicies("foo:server:10"));
+  EXPECT_NOT_OK(ParseTracePolicies("unknown:server:10"));
+  EXPECT_NOT_OK(ParseTracePolicies("http:unknown:10"));
+  EXPECT_NOT_OK(ParseTracePolicies("http:server:101"));
+  EXPECT_NOT_OK(ParseTracePolicies("http:server:-1"));
+  EXPECT_NOT_OK(ParseTracePolicies("http:server:10:lots"));
+}
+
+TEST(ShedTracePolicyTest, Levels) {
+  struct trace_policy_t all = {kTracePolicySampleRateDenom, 0};
+
+  struct trace_policy_t shed = ShedTracePolicy(all, 0);
+  EXPECT_EQ(shed.sample_rate, 100);
+  EXPECT_EQ(shed.max_bytes_per_syscall, 0);
+
+  shed = ShedTracePolicy(all, 1);
+  EXPECT_EQ(shed.sample_rate, 50);
+  EXPECT_EQ(shed.max_bytes_per_syscall, 16 * 1024);
+
+  shed = ShedTracePolicy(all, 3);
+  EXPECT_EQ(shed.sample_rate, 12);
+  EXPECT_EQ(shed.max_bytes_per_syscall, 1024);
+
+  // The configured policies get stricter, never looser.
+  shed = ShedTracePolicy({3, 512}, 2);
+  EXPECT_EQ(shed.sample_rate, 1);
+  EXPECT_EQ(shed.max_bytes_per_syscall, 512);
+}
+
+}  // namespace stirling
+}  // namespace px
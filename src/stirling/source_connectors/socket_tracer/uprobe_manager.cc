@@ -22,24 +22,32 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <map>
+#include <thread>
 
 #include "src/common/base/base.h"
 #include "src/common/base/utils.h"
 #include "src/common/fs/fs_wrapper.h"
 #include "src/stirling/bpf_tools/macros.h"
+#include "src/stirling/obj_tools/build_id.h"
 #include "src/stirling/obj_tools/dwarf_tools.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
 #include "src/stirling/source_connectors/socket_tracer/uprobe_symaddrs.h"
 #include "src/stirling/utils/proc_path_tools.h"
 
-DEFINE_bool(stirling_rescan_for_dlopen, false,
-            "If enabled, Stirling will use mmap tracing information to rescan binaries for delay "
-            "loaded libraries like OpenSSL");
-DEFINE_double(stirling_rescan_exp_backoff_factor, 2.0,
-              "Exponential backoff factor used in decided how often to rescan binaries for "
-              "dynamically loaded libraries");
+DEFINE_bool(stirling_rescan_for_dlopen, true,
+            "If enabled, Stirling rescans the processes that mapped a new executable file, "
+            "as reported by mmap tracing, for delay loaded libraries like OpenSSL");
+DEFINE_string(stirling_uprobe_cache_dir,
+              gflags::StringFromEnv("PL_STIRLING_UPROBE_CACHE_DIR", ""),
+              "If set, the symbol addresses and uprobes resolved from Go binaries are persisted "
+              "in this directory, by build-id, so binaries seen before are probed without being "
+              "analyzed again, even after a restart.");
+DEFINE_int32(stirling_uprobe_analysis_threads, 4,
+             "The maximum number of threads used to analyze the ELF and DWARF info of new "
+             "binaries, before uprobes are attached to them.");
 
 namespace px {
 namespace stirling {
@@ -47,7 +55,8 @@ namespace stirling {
 using ::px::stirling::obj_tools::DwarfReader;
 using ::px::stirling::obj_tools::ElfReader;
 
-UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc) : bcc_(bcc) {
+UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc)
+    : bcc_(bcc), go_uprobe_cache_(FLAGS_stirling_uprobe_cache_dir) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
 }
 
@@ -65,16 +74,18 @@ void UProbeManager::Init(bool enable_http2_tracing, bool disable_self_probing) {
       bcc_, "go_tls_symaddrs_map");
 }
 
-void UProbeManager::NotifyMMapEvent(upid_t upid) { upids_with_mmap_.insert(upid); }
+void UProbeManager::NotifyMMapEvent(upid_t upid) {
+  absl::MutexLock lock(&mmap_mutex_);
+  upids_with_mmap_.insert(upid);
+}
 
-StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
-                                              const std::string& binary,
-                                              obj_tools::ElfReader* elf_reader) {
+StatusOr<std::vector<bpf_tools::UProbeSpec>> UProbeManager::ResolveUProbeTmpl(
+    const ArrayView<UProbeTmpl>& probe_tmpls, obj_tools::ElfReader* elf_reader) {
   using bpf_tools::BPFProbeAttachType;
 
-  int uprobe_count = 0;
+  std::vector<bpf_tools::UProbeSpec> probes;
   for (const auto& tmpl : probe_tmpls) {
-    bpf_tools::UProbeSpec spec = {binary,
+    bpf_tools::UProbeSpec spec = {{},
                                   {},
                                   0,
                                   bpf_tools::UProbeSpec::kDefaultPID,
@@ -95,8 +106,7 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
         case BPFProbeAttachType::kEntry:
         case BPFProbeAttachType::kReturn: {
           spec.symbol = symbol_info.name;
-          PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-          ++uprobe_count;
+          probes.push_back(spec);
           break;
         }
         case BPFProbeAttachType::kReturnInsts: {
@@ -113,8 +123,7 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
           for (const uint64_t& addr : ret_inst_addrs) {
             spec.attach_type = BPFProbeAttachType::kEntry;
             spec.address = addr;
-            PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-            ++uprobe_count;
+            probes.push_back(spec);
           }
           break;
         }
@@ -123,48 +132,31 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
       }
     }
   }
-  return uprobe_count;
-}
-
-Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path, uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(struct openssl_symaddrs_t symaddrs, OpenSSLSymAddrs(libcrypto_path));
-
-  openssl_symaddrs_map_->UpdateValue(pid, symaddrs);
-
-  return Status::OK();
+  return probes;
 }
 
-Status UProbeManager::UpdateGoCommonSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                             const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_common_symaddrs_t symaddrs,
-                      GoCommonSymAddrs(elf_reader, dwarf_reader));
-
-  for (auto& pid : pids) {
-    go_common_symaddrs_map_->UpdateValue(pid, symaddrs);
+StatusOr<int> UProbeManager::AttachUProbes(const std::vector<bpf_tools::UProbeSpec>& probes,
+                                           const std::string& binary) {
+  for (const auto& probe : probes) {
+    bpf_tools::UProbeSpec spec = probe;
+    spec.binary_path = binary;
+    PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
   }
-
-  return Status::OK();
+  return static_cast<int>(probes.size());
 }
 
-Status UProbeManager::UpdateGoHTTP2SymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                            const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_http2_symaddrs_t symaddrs,
-                      GoHTTP2SymAddrs(elf_reader, dwarf_reader));
-
-  for (auto& pid : pids) {
-    go_http2_symaddrs_map_->UpdateValue(pid, symaddrs);
-  }
-
-  return Status::OK();
+StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
+                                              const std::string& binary,
+                                              obj_tools::ElfReader* elf_reader) {
+  PL_ASSIGN_OR_RETURN(std::vector<bpf_tools::UProbeSpec> probes,
+                      ResolveUProbeTmpl(probe_tmpls, elf_reader));
+  return AttachUProbes(probes, binary);
 }
 
-Status UProbeManager::UpdateGoTLSSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                          const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_tls_symaddrs_t symaddrs, GoTLSSymAddrs(elf_reader, dwarf_reader));
+Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path, uint32_t pid) {
+  PL_ASSIGN_OR_RETURN(struct openssl_symaddrs_t symaddrs, OpenSSLSymAddrs(libcrypto_path));
 
-  for (auto& pid : pids) {
-    go_tls_symaddrs_map_->UpdateValue(pid, symaddrs);
-  }
+  openssl_symaddrs_map_->UpdateValue(pid, symaddrs);
 
   return Status::OK();
 }
@@ -258,6 +250,7 @@ StatusOr<int> UProbeManager::AttachOpenSSLUProbes(uint32_t pid) {
   PL_RETURN_IF_ERROR(fs::Exists(container_libcrypto));
 
   PL_RETURN_IF_ERROR(UpdateOpenSSLSymAddrs(container_libcrypto, pid));
+  openssl_pids_.insert(pid);
 
   // Only try probing .so files that we haven't already set probes on.
   auto result = openssl_probed_binaries_.insert(container_libssl);
@@ -273,25 +266,27 @@ StatusOr<int> UProbeManager::AttachOpenSSLUProbes(uint32_t pid) {
 }
 
 StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
-                                                obj_tools::ElfReader* elf_reader,
-                                                obj_tools::DwarfReader* dwarf_reader,
+                                                const GoBinaryUProbeInfo& info,
                                                 const std::vector<int32_t>& pids) {
-  // Step 1: Update BPF symbols_map on all new PIDs.
-  Status s = UpdateGoTLSSymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
+  if (!info.tls_symaddrs.has_value()) {
     // Doesn't appear to be a binary with the mandatory symbols.
     // Might not even be a golang binary.
     // Either way, not of interest to probe.
     return 0;
   }
 
+  // Step 1: Update BPF symbols_map on all new PIDs.
+  for (auto& pid : pids) {
+    go_tls_symaddrs_map_->UpdateValue(pid, info.tls_symaddrs.value());
+  }
+
   // Step 2: Deploy uprobes on all new binaries.
   auto result = go_tls_probed_binaries_.insert(binary);
   if (!result.second) {
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kGoTLSUProbeTmpls, binary, elf_reader);
+  return AttachUProbes(info.tls_probes, binary);
 }
 
 // TODO(oazizi/yzhao): Should HTTP uprobes use a different set of perf buffers than the kprobes?
@@ -299,22 +294,113 @@ StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
 // cleanly. For example, right now, enabling uprobe & kprobe simultaneously can crash Stirling,
 // because of the mixed & duplicate data events from these 2 sources.
 StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
-                                                 obj_tools::ElfReader* elf_reader,
-                                                 obj_tools::DwarfReader* dwarf_reader,
+                                                 const GoBinaryUProbeInfo& info,
                                                  const std::vector<int32_t>& pids) {
-  // Step 1: Update BPF symaddrs for this binary.
-  Status s = UpdateGoHTTP2SymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
+  if (!info.http2_symaddrs.has_value()) {
     return 0;
   }
 
+  // Step 1: Update BPF symaddrs for this binary.
+  for (auto& pid : pids) {
+    go_http2_symaddrs_map_->UpdateValue(pid, info.http2_symaddrs.value());
+  }
+
   // Step 2: Deploy uprobes on all new binaries.
   auto result = go_http2_probed_binaries_.insert(binary);
   if (!result.second) {
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kHTTP2ProbeTmpls, binary, elf_reader);
+  return AttachUProbes(info.http2_probes, binary);
+}
+
+StatusOr<GoBinaryUProbeInfo> UProbeManager::ResolveGoUProbeInfo(const std::string& binary) {
+  GoBinaryUProbeInfo info;
+  info.http2_resolved = cfg_enable_http2_tracing_;
+
+  // Read binary's symbols.
+  StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
+  if (!elf_reader_status.ok()) {
+    return error::Internal(
+        "Cannot analyze binary $0 for uprobe deployment. "
+        "If file is under /var/lib, container may have terminated. "
+        "Message = $1",
+        binary, elf_reader_status.msg());
+  }
+  std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
+
+  // Avoid going passed this point if not a golang program.
+  // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
+  // TODO(oazizi): Consolidate with similar check in dynamic_tracing/autogen.cc.
+  bool is_golang_binary = elf_reader->SymbolAddress("runtime.buildVersion").has_value();
+  if (!is_golang_binary) {
+    return info;
+  }
+
+  StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status = DwarfReader::Create(binary);
+  if (!dwarf_reader_status.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
+        "Message = $1",
+        binary, dwarf_reader_status.msg());
+    return info;
+  }
+  std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+
+  StatusOr<struct go_common_symaddrs_t> common_symaddrs =
+      GoCommonSymAddrs(elf_reader.get(), dwarf_reader.get());
+  if (!common_symaddrs.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
+    return info;
+  }
+  info.common_symaddrs = common_symaddrs.ConsumeValueOrDie();
+
+  StatusOr<struct go_tls_symaddrs_t> tls_symaddrs =
+      GoTLSSymAddrs(elf_reader.get(), dwarf_reader.get());
+  if (tls_symaddrs.ok()) {
+    info.tls_symaddrs = tls_symaddrs.ConsumeValueOrDie();
+    PL_ASSIGN_OR_RETURN(info.tls_probes, ResolveUProbeTmpl(kGoTLSUProbeTmpls, elf_reader.get()));
+  }
+
+  if (cfg_enable_http2_tracing_) {
+    StatusOr<struct go_http2_symaddrs_t> http2_symaddrs =
+        GoHTTP2SymAddrs(elf_reader.get(), dwarf_reader.get());
+    if (http2_symaddrs.ok()) {
+      info.http2_symaddrs = http2_symaddrs.ConsumeValueOrDie();
+      PL_ASSIGN_OR_RETURN(info.http2_probes,
+                          ResolveUProbeTmpl(kHTTP2ProbeTmpls, elf_reader.get()));
+    }
+  }
+
+  return info;
+}
+
+std::vector<StatusOr<GoBinaryUProbeInfo>> UProbeManager::ResolveGoUProbeInfos(
+    const std::vector<std::string>& binaries) {
+  std::vector<StatusOr<GoBinaryUProbeInfo>> infos(binaries.size());
+
+  // The workers pick the binaries in order, so one large binary does not hold up the others.
+  std::atomic<size_t> next_idx = 0;
+  auto worker = [&]() {
+    for (size_t i = next_idx++; i < binaries.size(); i = next_idx++) {
+      infos[i] = ResolveGoUProbeInfo(binaries[i]);
+    }
+  };
+
+  const size_t num_threads =
+      std::min<size_t>(std::max(FLAGS_stirling_uprobe_analysis_threads, 1), binaries.size());
+  std::vector<std::thread> threads;
+  // The calling thread is one of the workers.
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  return infos;
 }
 
 namespace {
@@ -363,11 +449,19 @@ std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::
 }
 
 void UProbeManager::CleanupSymaddrMaps(const absl::flat_hash_set<md::UPID>& deleted_upids) {
-  for (const auto& pid : deleted_upids) {
-    openssl_symaddrs_map_->RemoveValue(pid.pid());
-    go_common_symaddrs_map_->RemoveValue(pid.pid());
-    go_tls_symaddrs_map_->RemoveValue(pid.pid());
-    go_http2_symaddrs_map_->RemoveValue(pid.pid());
+  std::vector<uint32_t> pids;
+  pids.reserve(deleted_upids.size());
+  for (const auto& upid : deleted_upids) {
+    pids.push_back(upid.pid());
+  }
+
+  openssl_symaddrs_map_->RemoveValues(pids);
+  go_common_symaddrs_map_->RemoveValues(pids);
+  go_tls_symaddrs_map_->RemoveValues(pids);
+  go_http2_symaddrs_map_->RemoveValues(pids);
+
+  for (uint32_t pid : pids) {
+    openssl_pids_.erase(pid);
   }
 }
 
@@ -398,7 +492,22 @@ int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
 
   static int32_t kPID = getpid();
 
-  for (const auto& [binary, pid_vec] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
+  struct GoBinary {
+    std::string path;
+    std::vector<int32_t> pids;
+    std::string build_id;
+    // The index of the binary in binaries_to_analyze, or -1 if its info is in the cache.
+    int analysis_idx = -1;
+  };
+  std::vector<GoBinary> binaries;
+
+  // Instances of the same binary, eg. the replicas of a deployment, share the same build-id,
+  // so they only need to be analyzed once.
+  std::vector<std::string> binaries_to_analyze;
+  absl::flat_hash_map<std::string, int> analysis_idxs;
+
+  // Step 1: Find the new binaries, and the ones among them that need to be analyzed.
+  for (auto& [binary, pid_vec] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
     // Don't bother rescanning binaries that have been scanned before to avoid unnecessary work.
     if (!scanned_binaries_.insert(binary).second) {
       continue;
@@ -412,50 +521,72 @@ int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
       }
     }
 
-    // Read binary's symbols.
-    StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
-    if (!elf_reader_status.ok()) {
-      LOG(WARNING) << absl::Substitute(
-          "Cannot analyze binary $0 for uprobe deployment. "
-          "If file is under /var/lib, container may have terminated. "
-          "Message = $1",
-          binary, elf_reader_status.msg());
-      continue;
+    GoBinary& go_binary = binaries.emplace_back();
+    go_binary.path = binary;
+    go_binary.pids = std::move(pid_vec);
+    go_binary.build_id = obj_tools::ReadBuildID(binary).ValueOr("");
+
+    const GoBinaryUProbeInfo* info =
+        go_binary.build_id.empty() ? nullptr : go_uprobe_cache_.Lookup(go_binary.build_id);
+    if (info == nullptr || (cfg_enable_http2_tracing_ && !info->http2_resolved)) {
+      const std::string& key = go_binary.build_id.empty() ? binary : go_binary.build_id;
+      auto [iter, inserted] = analysis_idxs.try_emplace(key, binaries_to_analyze.size());
+      if (inserted) {
+        binaries_to_analyze.push_back(binary);
+      }
+      go_binary.analysis_idx = iter->second;
     }
-    std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
+  }
 
-    // Avoid going passed this point if not a golang program.
-    // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
-    // TODO(oazizi): Consolidate with similar check in dynamic_tracing/autogen.cc.
-    bool is_golang_binary = elf_reader->SymbolAddress("runtime.buildVersion").has_value();
-    if (!is_golang_binary) {
-      continue;
-    }
+  // Step 2: Analyze the binaries concurrently.
+  std::vector<StatusOr<GoBinaryUProbeInfo>> analyzed_infos =
+      ResolveGoUProbeInfos(binaries_to_analyze);
+  {
+    absl::MutexLock lock(&stats_mutex_);
+    stats_.Increment(StatKey::kBinariesAnalyzed, binaries_to_analyze.size());
+    stats_.Increment(StatKey::kBinariesFromCache, binaries.size() - binaries_to_analyze.size());
+  }
 
-    StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status = DwarfReader::Create(binary);
-    if (!dwarf_reader_status.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
-          "Message = $1",
-          binary, dwarf_reader_status.msg());
-      continue;
+  // Step 3: Attach the probes, one binary at a time. BCC is not thread-safe, so this is left on
+  // this thread.
+  for (const GoBinary& go_binary : binaries) {
+    const std::string& binary = go_binary.path;
+    const std::vector<int32_t>& pid_vec = go_binary.pids;
+
+    const GoBinaryUProbeInfo* info = nullptr;
+    if (go_binary.analysis_idx < 0) {
+      info = go_uprobe_cache_.Lookup(go_binary.build_id);
+    } else {
+      StatusOr<GoBinaryUProbeInfo>& info_status = analyzed_infos[go_binary.analysis_idx];
+      if (!info_status.ok()) {
+        LOG(WARNING) << info_status.msg();
+        absl::MutexLock lock(&stats_mutex_);
+        stats_.Increment(StatKey::kAnalysisErrors);
+        continue;
+      }
+      info = &info_status.ValueOrDie();
+      // Only cache the info once, for the binary it was analyzed from.
+      if (!go_binary.build_id.empty() && binaries_to_analyze[go_binary.analysis_idx] == binary) {
+        go_uprobe_cache_.Insert(go_binary.build_id, *info);
+      }
     }
-    std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+    DCHECK(info != nullptr);
 
-    Status s = UpdateGoCommonSymAddrs(elf_reader.get(), dwarf_reader.get(), pid_vec);
-    if (!s.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
+    if (!info->common_symaddrs.has_value()) {
       continue;
     }
+    for (auto& pid : pid_vec) {
+      go_common_symaddrs_map_->UpdateValue(pid, info->common_symaddrs.value());
+    }
 
     // GoTLS Probes.
     {
-      StatusOr<int> attach_status =
-          AttachGoTLSUProbes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
+      StatusOr<int> attach_status = AttachGoTLSUProbes(binary, *info, pid_vec);
       if (!attach_status.ok()) {
         LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
                                                      binary, attach_status.ToString());
+        absl::MutexLock lock(&stats_mutex_);
+        stats_.Increment(StatKey::kAttachErrors);
       } else {
         uprobe_count += attach_status.ValueOrDie();
       }
@@ -463,11 +594,12 @@ int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
 
     // Go HTTP2 Probes.
     if (cfg_enable_http2_tracing_) {
-      StatusOr<int> attach_status =
-          AttachGoHTTP2Probes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
+      StatusOr<int> attach_status = AttachGoHTTP2Probes(binary, *info, pid_vec);
       if (!attach_status.ok()) {
         LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
                                                      binary, attach_status.ToString());
+        absl::MutexLock lock(&stats_mutex_);
+        stats_.Increment(StatKey::kAttachErrors);
       } else {
         uprobe_count += attach_status.ValueOrDie();
       }
@@ -478,8 +610,11 @@ int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
 }
 
 absl::flat_hash_set<md::UPID> UProbeManager::PIDsToRescanForUProbes() {
-  // Count number of calls to this function.
-  ++rescan_counter_;
+  absl::flat_hash_set<upid_t> upids_with_mmap;
+  {
+    absl::MutexLock lock(&mmap_mutex_);
+    upids_with_mmap.swap(upids_with_mmap_);
+  }
 
   // Get the ASID, using an entry from proc_tracker.
   if (proc_tracker_.upids().empty()) {
@@ -488,38 +623,15 @@ absl::flat_hash_set<md::UPID> UProbeManager::PIDsToRescanForUProbes() {
   uint32_t asid = proc_tracker_.upids().begin()->asid();
 
   absl::flat_hash_set<md::UPID> upids_to_rescan;
-  for (const auto& pid : upids_with_mmap_) {
+  for (const auto& pid : upids_with_mmap) {
     md::UPID upid(asid, pid.pid, pid.start_time_ticks);
-
-    if (proc_tracker_.upids().contains(upid) && !proc_tracker_.new_upids().contains(upid)) {
-      // Filter out upids_to_rescan based on a backoff that is tracked per UPID.
-      // Each UPID has a modulus, which defines the periodicity at which it can rescan.
-      // This periodicity is used in a modulo operation, hence the term modulus.
-      constexpr int kInitialModulus = 1;
-      constexpr int kMaximumModulus = 1 << 12;
-      const double kBackoffFactor = FLAGS_stirling_rescan_exp_backoff_factor;
-
-      auto [iter, success] = backoff_map_.emplace(upid, kInitialModulus);
-      int& modulus = iter->second;
-      DCHECK_NE(modulus, 0) << success;
-
-      // Each PID has a backoff period that exponentially grows since the last attempted rescan.
-      // The simple version would be:
-      //   if (rescan_counter_ % modulus  == 0)
-      // But this could cause a bunch of pids to be added to the rescan list in the same iteration.
-      // Jitter this by comparing to the modulus to the pid:
-      //   if ((rescan_counter_ % modulus) == (upid.pid() % modulus))
-      if ((rescan_counter_ % modulus) == static_cast<int>(upid.pid() % modulus)) {
-        upids_to_rescan.insert(upid);
-
-        // Increase backoff period according to an exponential back-off.
-        modulus = std::min(static_cast<int>(modulus * kBackoffFactor), kMaximumModulus);
-      }
+    // New UPIDs are scanned anyway, and the ones already traced have no library left to find.
+    if (proc_tracker_.upids().contains(upid) && !proc_tracker_.new_upids().contains(upid) &&
+        !openssl_pids_.contains(pid.pid)) {
+      upids_to_rescan.insert(upid);
     }
   }
 
-  upids_with_mmap_.clear();
-
   return upids_to_rescan;
 }
 
@@ -542,10 +654,20 @@ void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids) {
   }
   uprobe_count += DeployGoUProbes(proc_tracker_.new_upids());
 
+  {
+    absl::MutexLock lock(&stats_mutex_);
+    stats_.Increment(StatKey::kUProbesAttached, uprobe_count);
+  }
+
   if (uprobe_count != 0) {
     LOG(INFO) << absl::Substitute("Number of uprobes deployed = $0", uprobe_count);
   }
 }
 
+std::string UProbeManager::StatsString() const {
+  absl::MutexLock lock(&stats_mutex_);
+  return stats_.Print();
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -31,12 +31,15 @@
 
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+#include "src/stirling/source_connectors/socket_tracer/go_uprobe_cache.h"
 
 #include "src/stirling/utils/proc_path_tools.h"
 #include "src/stirling/utils/proc_tracker.h"
+#include "src/stirling/utils/stat_counter.h"
 
 DECLARE_bool(stirling_rescan_for_dlopen);
-DECLARE_double(stirling_rescan_exp_backoff_factor);
+DECLARE_string(stirling_uprobe_cache_dir);
+DECLARE_int32(stirling_uprobe_analysis_threads);
 
 namespace px {
 namespace stirling {
@@ -79,12 +82,27 @@ class UserSpaceManagedBPFMap {
     }
   }
 
+  // Removes all the given keys with one batched BPF map operation.
+  void RemoveValues(const std::vector<TKeyType>& keys) {
+    std::vector<TKeyType> keys_to_remove;
+    for (const auto& key : keys) {
+      if (shadow_keys_.erase(key) != 0) {
+        keys_to_remove.push_back(key);
+      }
+    }
+    if (keys_to_remove.empty()) {
+      return;
+    }
+    auto s = map_->RemoveValues(keys_to_remove);
+    LOG_IF(WARNING, !s.ok()) << absl::StrCat("Could not remove from BPF map. Message=", s.msg());
+  }
+
  private:
   UserSpaceManagedBPFMap(bpf_tools::BCCWrapper* bcc, const std::string& map_name)
-      : map_(std::make_unique<ebpf::BPFHashTable<TKeyType, TValueType> >(
-            bcc->GetHashTable<TKeyType, TValueType>(map_name))) {}
+      : map_(std::make_unique<bpf_tools::BatchHashTable<TKeyType, TValueType> >(
+            bcc->GetBatchHashTable<TKeyType, TValueType>(map_name))) {}
 
-  std::unique_ptr<ebpf::BPFHashTable<TKeyType, TValueType> > map_;
+  std::unique_ptr<bpf_tools::BatchHashTable<TKeyType, TValueType> > map_;
   absl::flat_hash_set<TKeyType> shadow_keys_;
 };
 
@@ -108,8 +126,8 @@ class UProbeManager {
   void Init(bool enable_http2_tracing, bool disable_self_tracing = true);
 
   /**
-   * Notify uprobe manager of an mmap event. An mmap may be indicative of a dlopen,
-   * so this is used to determine when to rescan binaries for newly loaded shared libraries.
+   * Notify uprobe manager of an mmap event. Only executable mappings of files are reported,
+   * which is what a dlopen does, so the process is rescanned for newly loaded shared libraries.
    * @param upid UPID of the process that performed the mmap.
    */
   void NotifyMMapEvent(upid_t upid);
@@ -127,6 +145,22 @@ class UProbeManager {
    */
   bool ThreadsRunning() { return num_deploy_uprobes_threads_ != 0; }
 
+  enum class StatKey {
+    // Binaries whose ELF and DWARF info were analyzed.
+    kBinariesAnalyzed,
+    // Binaries whose info came from the cache, or from another binary with the same build-id.
+    kBinariesFromCache,
+    kAnalysisErrors,
+    kUProbesAttached,
+    kAttachErrors,
+  };
+
+  /**
+   * Returns the progress of the uprobe deployment so far. Safe to call while a deployment thread
+   * is running.
+   */
+  std::string StatsString() const;
+
  private:
   inline static constexpr auto kHTTP2ProbeTmpls = MakeArray<UProbeTmpl>({
       // Probes on Golang net/http2 library.
@@ -258,38 +292,55 @@ class UProbeManager {
    */
   int DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids);
 
+  /**
+   * Reads the symbol addresses and the uprobes of a Go binary, from its ELF and DWARF info.
+   *
+   * @param binary The path to the binary.
+   * @return The info of the binary, or error if the binary could not be read. A binary that is
+   *         not a Go binary, or cannot be traced, is not an error; its info is just empty.
+   *
+   * Only reads the configuration of the UProbeManager, so it can run on several binaries
+   * concurrently.
+   */
+  StatusOr<GoBinaryUProbeInfo> ResolveGoUProbeInfo(const std::string& binary);
+
+  /**
+   * Runs ResolveGoUProbeInfo() on each of the binaries, on up to
+   * FLAGS_stirling_uprobe_analysis_threads threads.
+   *
+   * @return The info of each binary, in the same order as the binaries.
+   */
+  std::vector<StatusOr<GoBinaryUProbeInfo>> ResolveGoUProbeInfos(
+      const std::vector<std::string>& binaries);
+
   /**
    * Attaches the required probes for Go HTTP2 tracing to the specified binary, if it is a
    * compatible Go binary.
    *
    * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param info The resolved info of the binary.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not considered an error if the binary
    *         is not a Go binary or doesn't use a Go HTTP2 library; instead the return value will be
    *         zero.
    */
-  StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                    obj_tools::DwarfReader* dwarf_reader,
+  StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, const GoBinaryUProbeInfo& info,
                                     const std::vector<int32_t>& pids);
 
   /**
    * Attaches the required probes for GoTLS tracing to the specified binary, if it is a compatible
    * Go binary.
    *
-   * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param binary The path to the binary on which to deploy Go TLS probes.
+   * @param info The resolved info of the binary.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not an error if the binary
    *         is not a Go binary or doesn't use Go TLS; instead the return value will be zero.
    */
-  StatusOr<int> AttachGoTLSUProbes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                   obj_tools::DwarfReader* dwarf_reader,
-                                   const std::vector<int32_t>& new_pids);
+  StatusOr<int> AttachGoTLSUProbes(const std::string& binary, const GoBinaryUProbeInfo& info,
+                                   const std::vector<int32_t>& pids);
 
   /**
    * // Attaches the required probes for OpenSSL tracing to the specified PID, if it uses OpenSSL.
@@ -318,18 +369,26 @@ class UProbeManager {
   StatusOr<int> AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
                                  const std::string& binary, obj_tools::ElfReader* elf_reader);
 
-  // Returns set of PIDs that have had mmap called on them since the last call.
+  /**
+   * Finds the uprobes that AttachUProbeTmpl() would attach, without attaching them.
+   * The returned specs have no binary_path set.
+   */
+  StatusOr<std::vector<bpf_tools::UProbeSpec>> ResolveUProbeTmpl(
+      const ArrayView<UProbeTmpl>& probe_tmpls, obj_tools::ElfReader* elf_reader);
+
+  /**
+   * Attaches the uprobes to the binary.
+   *
+   * @return Number of uprobes deployed, or error if uprobes failed to deploy.
+   */
+  StatusOr<int> AttachUProbes(const std::vector<bpf_tools::UProbeSpec>& probes,
+                              const std::string& binary);
+
+  // Returns set of PIDs that have had mmap called on them since the last call, minus the ones
+  // that are new or already have OpenSSL traced.
   absl::flat_hash_set<md::UPID> PIDsToRescanForUProbes();
 
   Status UpdateOpenSSLSymAddrs(std::filesystem::path container_lib, uint32_t pid);
-  Status UpdateGoCommonSymAddrs(obj_tools::ElfReader* elf_reader,
-                                obj_tools::DwarfReader* dwarf_reader,
-                                const std::vector<int32_t>& pids);
-  Status UpdateGoHTTP2SymAddrs(obj_tools::ElfReader* elf_reader,
-                               obj_tools::DwarfReader* dwarf_reader,
-                               const std::vector<int32_t>& pids);
-  Status UpdateGoTLSSymAddrs(obj_tools::ElfReader* elf_reader, obj_tools::DwarfReader* dwarf_reader,
-                             const std::vector<int32_t>& pids);
 
   // Clean-up various BPF maps used to communicate symbol addresses per PID.
   // Once the PID has terminated, the information is not required anymore.
@@ -352,15 +411,12 @@ class UProbeManager {
   ProcTracker proc_tracker_;
   LazyLoadedFPResolver fp_resolver_;
 
-  absl::flat_hash_set<upid_t> upids_with_mmap_;
-
-  // Count the number of times PIDsToRescanForUProbes() has been called.
-  int rescan_counter_ = 0;
+  // Written by the mmap_events perf buffer callback, read by the deploy thread.
+  absl::Mutex mmap_mutex_;
+  absl::flat_hash_set<upid_t> upids_with_mmap_ ABSL_GUARDED_BY(mmap_mutex_);
 
-  // Map of UPIDs to the periodicity at which they are allowed to be rescanned.
-  // The backoff value starts at 1 (meaning they can be scanned every iteration),
-  // and exponentially grows every time nothing new is found.
-  absl::flat_hash_map<md::UPID, int> backoff_map_;
+  // The PIDs whose OpenSSL symbol addresses are set. They are not rescanned on mmap.
+  absl::flat_hash_set<uint32_t> openssl_pids_;
 
   // Records the binaries that have uprobes attached, so we don't try to probe them again.
   // TODO(oazizi): How should these sets be cleaned up of old binaries, once they are deleted?
@@ -370,6 +426,10 @@ class UProbeManager {
   absl::flat_hash_set<std::string> go_http2_probed_binaries_;
   absl::flat_hash_set<std::string> go_tls_probed_binaries_;
 
+  // The resolved info of the Go binaries, by build-id. Only used by DeployGoUProbes(), which runs
+  // under deploy_uprobes_mutex_.
+  GoUProbeCache go_uprobe_cache_;
+
   // BPF maps through which the addresses of symbols for a given pid are communicated to uprobes.
   std::unique_ptr<UserSpaceManagedBPFMap<uint32_t, struct openssl_symaddrs_t> >
       openssl_symaddrs_map_;
@@ -378,6 +438,10 @@ class UProbeManager {
   std::unique_ptr<UserSpaceManagedBPFMap<uint32_t, struct go_http2_symaddrs_t> >
       go_http2_symaddrs_map_;
   std::unique_ptr<UserSpaceManagedBPFMap<uint32_t, struct go_tls_symaddrs_t> > go_tls_symaddrs_map_;
+
+  // Written by the deployment threads, read by StatsString().
+  mutable absl::Mutex stats_mutex_;
+  utils::StatCounter<StatKey> stats_ ABSL_GUARDED_BY(stats_mutex_);
 };
 
 }  // namespace stirling
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/stirling_overhead/stirling_overhead_connector.h"
+
+#include <magic_enum.hpp>
+
+#include "src/common/base/base.h"
+#include "src/stirling/utils/overhead_stats.h"
+
+namespace px {
+namespace stirling {
+
+using utils::OverheadStat;
+
+Status StirlingOverheadConnector::InitImpl() {
+  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  push_freq_mgr_.set_period(kPushPeriod);
+  return Status::OK();
+}
+
+void StirlingOverheadConnector::TransferDataImpl(ConnectorContext* /* ctx */,
+                                                 const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), 1);
+  DataTable* data_table = data_tables[0];
+
+  if (data_table == nullptr) {
+    return;
+  }
+
+  const int64_t timestamp = CurrentTimeNS();
+  for (const OverheadStat& stat : utils::OverheadStats::GetInstance().Collect()) {
+    // Drop the 'k' of the enum name.
+    std::string_view kind = magic_enum::enum_name(stat.kind).substr(1);
+
+    DataTable::RecordBuilder<&kTable> r(data_table, timestamp);
+    r.Append<r.ColIndex("time_")>(timestamp);
+    r.Append<r.ColIndex("kind")>(std::string(kind));
+    r.Append<r.ColIndex("name")>(stat.name);
+    r.Append<r.ColIndex("run_count")>(stat.run_count);
+    r.Append<r.ColIndex("run_time_ns")>(stat.run_time_ns);
+    r.Append<r.ColIndex("lost_count")>(stat.lost_count);
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
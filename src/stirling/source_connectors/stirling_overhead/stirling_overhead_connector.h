@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/stirling/core/canonical_types.h"
+#include "src/stirling/core/source_connector.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Reports Stirling's own overhead: the time spent in each source connector, and, when
+ * --stirling_enable_bpf_stats is set, the runs and run time of each BPF program. Also reports the
+ * events lost by each perf buffer. See utils::OverheadStats.
+ */
+class StirlingOverheadConnector : public SourceConnector {
+ public:
+  static constexpr std::string_view kName = "stirling_overhead";
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{10000};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{10000};
+  // clang-format off
+  static constexpr DataElement kElements[] = {
+      canonical_data_elements::kTime,
+      {"kind", "The kind of component: TransferData, PushData, BPFProgram or PerfBuffer",
+       types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL_ENUM},
+      {"name", "The source connector, BPF program or perf buffer",
+       types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+      {"run_count", "The number of runs since the component was created",
+       types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+      {"run_time_ns", "The total run time since the component was created",
+       types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+       types::PatternType::METRIC_COUNTER},
+      {"lost_count", "The number of lost events since the perf buffer was opened",
+       types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+  };
+  // clang-format on
+  static constexpr auto kTable =
+      DataTableSchema("stirling_overhead", "The CPU overhead of Stirling's components", kElements);
+
+  static constexpr auto kTables = MakeArray(kTable);
+
+  StirlingOverheadConnector() = delete;
+  ~StirlingOverheadConnector() override = default;
+  static std::unique_ptr<SourceConnector> Create(std::string_view name) {
+    return std::unique_ptr<SourceConnector>(new StirlingOverheadConnector(name));
+  }
+
+ protected:
+  explicit StirlingOverheadConnector(std::string_view name) : SourceConnector(name, kTables) {}
+  Status InitImpl() override;
+  void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+  Status StopImpl() override { return Status::OK(); }
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/stirling_overhead/stirling_overhead_connector.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/utils/overhead_stats.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::Contains;
+
+TEST(StirlingOverheadConnectorTest, ReportsRuns) {
+  std::unique_ptr<SourceConnector> connector =
+      StirlingOverheadConnector::Create("stirling_overhead_connector");
+  ASSERT_OK(connector->Init());
+
+  utils::OverheadStats::GetInstance().AddRun(utils::OverheadStat::Kind::kTransferData,
+                                             "test_connector", std::chrono::nanoseconds{100});
+
+  DataTable data_table(/*id*/ 0, StirlingOverheadConnector::kTable);
+  StandaloneContext ctx;
+  connector->TransferData(&ctx, {&data_table});
+  std::vector<TaggedRecordBatch> tablets = data_table.ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  const types::ColumnWrapperRecordBatch& records = tablets[0].records;
+
+  // The connector's own TransferData() is only added once it returns.
+  constexpr auto kTable = StirlingOverheadConnector::kTable;
+  ASSERT_EQ(records[kTable.ColIndex("name")]->Size(), 1);
+  EXPECT_EQ(records[kTable.ColIndex("kind")]->Get<types::StringValue>(0), "TransferData");
+  EXPECT_EQ(records[kTable.ColIndex("name")]->Get<types::StringValue>(0), "test_connector");
+  EXPECT_EQ(records[kTable.ColIndex("run_count")]->Get<types::Int64Value>(0), 1);
+  EXPECT_EQ(records[kTable.ColIndex("run_time_ns")]->Get<types::Int64Value>(0), 100);
+
+  connector->TransferData(&ctx, {&data_table});
+  tablets = data_table.ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  std::vector<std::string> names;
+  for (size_t i = 0; i < tablets[0].records[kTable.ColIndex("name")]->Size(); ++i) {
+    names.push_back(tablets[0].records[kTable.ColIndex("name")]->Get<types::StringValue>(i));
+  }
+  EXPECT_THAT(names, Contains("stirling_overhead_connector"));
+
+  ASSERT_OK(connector->Stop());
+}
+
+}  // namespace stirling
+}  // namespace px
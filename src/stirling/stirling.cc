@@ -29,9 +29,13 @@
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_split.h>
 
 #include "src/common/base/base.h"
 #include "src/common/perf/elapsed_timer.h"
+#include "src/common/perf/self_profile.h"
+#include "src/common/system/config.h"
 #include "src/common/system/system_info.h"
 
 #include "src/stirling/bpf_tools/probe_cleaner.h"
@@ -48,12 +52,27 @@
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
 #include "src/stirling/source_connectors/pid_runtime/pid_runtime_connector.h"
 #include "src/stirling/source_connectors/proc_stat/proc_stat_connector.h"
+#include "src/stirling/source_connectors/process_stats/process_stats_bpf_connector.h"
 #include "src/stirling/source_connectors/process_stats/process_stats_connector.h"
 #include "src/stirling/source_connectors/seq_gen/seq_gen_connector.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
+#include "src/stirling/source_connectors/stirling_overhead/stirling_overhead_connector.h"
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
+DEFINE_string(stirling_source_thread_groups,
+              gflags::StringFromEnv("PL_STIRLING_SOURCE_THREAD_GROUPS", ""),
+              "Groups of source connectors that run on their own thread, so that a slow source "
+              "doesn't delay the sources of the other groups. Groups are separated by ';', and "
+              "each is a comma-separated list of source names, "
+              "e.g. 'socket_tracer;perf_profiler,jvm_stats'. The sources of a group run in turn. "
+              "All the other sources run on the main Stirling thread. The data push callback "
+              "must be thread-safe when groups are set.");
+DEFINE_bool(stirling_parallel_source_init,
+            gflags::BoolFromEnv("PL_STIRLING_PARALLEL_SOURCE_INIT", true),
+            "If true, the source connectors are initialized concurrently at startup, so that they "
+            "compile and attach their BPF programs in parallel.");
+
 namespace px {
 namespace stirling {
 
@@ -66,6 +85,9 @@ const absl::flat_hash_map<std::string_view, SourceRegistry::RegistryElement> kAl
     REGISTRY_PAIR(ProcStatConnector),     REGISTRY_PAIR(SeqGenConnector),
     REGISTRY_PAIR(SocketTraceConnector),  REGISTRY_PAIR(ProcessStatsConnector),
     REGISTRY_PAIR(NetworkStatsConnector), REGISTRY_PAIR(PerfProfileConnector),
+    REGISTRY_PAIR(StirlingOverheadConnector),
+    // Not part of any group, since it fills the same table as ProcessStatsConnector.
+    REGISTRY_PAIR(ProcessStatsBPFConnector),
 };
 #undef REGISTRY_PAIR
 
@@ -82,7 +104,8 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
         NetworkStatsConnector::kName,
         JVMStatsConnector::kName,
         SocketTraceConnector::kName,
-        PerfProfileConnector::kName
+        PerfProfileConnector::kName,
+        StirlingOverheadConnector::kName
       };
     case SourceConnectorGroup::kAll:
       return {
@@ -93,7 +116,8 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
         ProcStatConnector::kName,
         SeqGenConnector::kName,
         SocketTraceConnector::kName,
-        PerfProfileConnector::kName
+        PerfProfileConnector::kName,
+        StirlingOverheadConnector::kName
       };
     case SourceConnectorGroup::kTracers:
       return {
@@ -143,6 +167,21 @@ struct SourceOutput {
   std::vector<DataTable*> data_tables;
 };
 
+// The sources that run on one thread, see FLAGS_stirling_source_thread_groups.
+struct SourceGroup {
+  // The names of the sources of the group. Empty for the main group, which runs all the sources
+  // that aren't in another group.
+  absl::flat_hash_set<std::string> source_names;
+
+  // Runs the group, unless it is the main group, which runs on the thread of RunCore().
+  std::thread thread;
+
+  // Held for an iteration over the sources of the group, so that they aren't changed from other
+  // threads in the middle of a transfer.
+  absl::base_internal::SpinLock lock;
+  absl::flat_hash_map<SourceConnector*, SourceOutput> source_output_map ABSL_GUARDED_BY(lock);
+};
+
 class StirlingImpl final : public Stirling {
  public:
   explicit StirlingImpl(std::unique_ptr<SourceRegistry> registry);
@@ -166,6 +205,8 @@ class StirlingImpl final : public Stirling {
     DCHECK(f != nullptr);
     agent_metadata_callback_ = f;
   }
+  void SetTableDemand(const absl::flat_hash_set<std::string>& table_names) override;
+  void SetLoadShedLevel(int level) override;
   std::unique_ptr<ConnectorContext> GetContext();
 
   void Run() override;
@@ -186,6 +227,9 @@ class StirlingImpl final : public Stirling {
   // Adds a source to Stirling, and updates all state accordingly.
   Status AddSource(std::unique_ptr<SourceConnector> source);
 
+  // Adds a source whose Init() succeeded.
+  void AddInitializedSource(std::unique_ptr<SourceConnector> source);
+
   // Removes a source and all its info classes from stirling.
   Status RemoveSource(std::string_view source_name);
 
@@ -200,6 +244,15 @@ class StirlingImpl final : public Stirling {
   // Main run implementation.
   void RunCore();
 
+  // Samples and pushes the data of the sources of the group until Stirling is stopped.
+  void RunSourceGroup(SourceGroup* group);
+
+  // The group that the source with the given name runs in.
+  SourceGroup* GetSourceGroup(std::string_view source_name);
+
+  // Calls fn on each source, while the source isn't running.
+  void ForEachSource(const std::function<void(SourceConnector*)>& fn);
+
   // Wait for Stirling to stop its main loop.
   void WaitForStop();
 
@@ -210,13 +263,13 @@ class StirlingImpl final : public Stirling {
   std::atomic<bool> running_ = false;
   std::vector<std::unique_ptr<SourceConnector>> sources_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
 
-  // TODO(yzhao): Move InfoClassManager objects into SourceConnector, and remove this map.
-  absl::flat_hash_map<SourceConnector*, SourceOutput> source_output_map_
-      ABSL_GUARDED_BY(info_class_mgrs_lock_);
+  // The first group is the main group. Each source is in the output map of its group.
+  // TODO(yzhao): Move InfoClassManager objects into SourceConnector, and remove the output maps.
+  std::vector<std::unique_ptr<SourceGroup>> source_groups_;
 
   InfoClassManagerVec info_class_mgrs_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
 
-  // Lock to protect both info_class_mgrs_ and sources_.
+  // Lock to protect both info_class_mgrs_ and sources_. Taken before the lock of a source group.
   absl::base_internal::SpinLock info_class_mgrs_lock_;
 
   std::unique_ptr<SourceRegistry> registry_;
@@ -313,7 +366,36 @@ void UserSignalHandler(int /* signum */, siginfo_t* info, void* /* context */) {
 }
 
 StirlingImpl::StirlingImpl(std::unique_ptr<SourceRegistry> registry)
-    : registry_(std::move(registry)) {}
+    : registry_(std::move(registry)) {
+  source_groups_.push_back(std::make_unique<SourceGroup>());
+  for (std::string_view group_names :
+       absl::StrSplit(FLAGS_stirling_source_thread_groups, ';', absl::SkipWhitespace())) {
+    auto group = std::make_unique<SourceGroup>();
+    for (std::string_view name : absl::StrSplit(group_names, ',', absl::SkipWhitespace())) {
+      group->source_names.insert(std::string(absl::StripAsciiWhitespace(name)));
+    }
+    source_groups_.push_back(std::move(group));
+  }
+}
+
+SourceGroup* StirlingImpl::GetSourceGroup(std::string_view source_name) {
+  for (size_t i = 1; i < source_groups_.size(); ++i) {
+    if (source_groups_[i]->source_names.contains(source_name)) {
+      return source_groups_[i].get();
+    }
+  }
+  return source_groups_[0].get();
+}
+
+void StirlingImpl::ForEachSource(const std::function<void(SourceConnector*)>& fn) {
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  for (auto& group : source_groups_) {
+    absl::base_internal::SpinLockHolder group_lock(&group->lock);
+    for (auto& [source, output] : group->source_output_map) {
+      fn(source);
+    }
+  }
+}
 
 StirlingImpl::~StirlingImpl() { Stop(); }
 
@@ -348,10 +430,41 @@ Status StirlingImpl::Init() {
     return error::NotFound("Source registry doesn't exist");
   }
 
+  std::vector<std::string_view> names;
+  std::vector<std::unique_ptr<SourceConnector>> sources;
   for (const auto& [name, registry_element] : registry_->sources()) {
-    Status s = AddSource(registry_element.create_source_fn(name));
-    LOG_IF(DFATAL, !s.ok()) << absl::Substitute(
-        "Source Connector (registry name=$0) not instantiated, error: $1", name, s.ToString());
+    names.push_back(name);
+    sources.push_back(registry_element.create_source_fn(name));
+  }
+
+  // Initializing a source mostly compiles and attaches its BPF programs, which the sources do
+  // independently, so they are initialized concurrently. They are added in the registry order.
+  std::vector<Status> init_statuses(sources.size());
+  if (FLAGS_stirling_parallel_source_init) {
+    std::vector<std::thread> init_threads;
+    init_threads.reserve(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+      init_threads.emplace_back([&sources, &init_statuses, i]() {
+        init_statuses[i] = sources[i]->Init();
+      });
+    }
+    for (auto& t : init_threads) {
+      t.join();
+    }
+  } else {
+    for (size_t i = 0; i < sources.size(); ++i) {
+      init_statuses[i] = sources[i]->Init();
+    }
+  }
+
+  for (size_t i = 0; i < sources.size(); ++i) {
+    if (!init_statuses[i].ok()) {
+      LOG(DFATAL) << absl::Substitute(
+          "Source Connector (registry name=$0) not instantiated, error: $1", names[i],
+          init_statuses[i].ToString());
+      continue;
+    }
+    AddInitializedSource(std::move(sources[i]));
   }
   LOG(INFO) << "Stirling successfully initialized.";
   return Status::OK();
@@ -381,6 +494,11 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
   // Step 1: Init the source.
   PL_RETURN_IF_ERROR(source->Init());
 
+  AddInitializedSource(std::move(source));
+  return Status::OK();
+}
+
+void StirlingImpl::AddInitializedSource(std::unique_ptr<SourceConnector> source) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   std::vector<InfoClassManager*> mgrs;
@@ -396,12 +514,14 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
 
   std::vector<DataTable*> data_tables = GetDataTables(mgrs);
 
-  source_output_map_[source.get()] = {std::move(mgrs),
-                                      // DataTable objects are created after subscribing.
-                                      std::move(data_tables)};
+  SourceGroup* group = GetSourceGroup(source->name());
+  {
+    absl::base_internal::SpinLockHolder group_lock(&group->lock);
+    group->source_output_map[source.get()] = {std::move(mgrs),
+                                              // DataTable objects are created after subscribing.
+                                              std::move(data_tables)};
+  }
   sources_.push_back(std::move(source));
-
-  return Status::OK();
 }
 
 Status StirlingImpl::RemoveSource(std::string_view source_name) {
@@ -417,6 +537,11 @@ Status StirlingImpl::RemoveSource(std::string_view source_name) {
   }
   std::unique_ptr<SourceConnector>& source = *source_iter;
 
+  // Wait for the group of the source to finish its iteration, and take the source out of it.
+  SourceGroup* group = GetSourceGroup(source->name());
+  absl::base_internal::SpinLockHolder group_lock(&group->lock);
+  group->source_output_map.erase(source.get());
+
   // Remove all info class managers that point back to the source.
   info_class_mgrs_.erase(std::remove_if(info_class_mgrs_.begin(), info_class_mgrs_.end(),
                                         [&source](std::unique_ptr<InfoClassManager>& mgr) {
@@ -426,7 +551,6 @@ Status StirlingImpl::RemoveSource(std::string_view source_name) {
 
   // Now perform the removal.
   PL_RETURN_IF_ERROR(source->Stop());
-  source_output_map_.erase(source.get());
   sources_.erase(source_iter);
 
   return Status::OK();
@@ -465,18 +589,20 @@ StatusOr<std::unique_ptr<SourceConnector>> CreateDynamicSourceConnector(
     return error::Internal("Nothing defined in the input tracepoint_deployment.");
   }
 
-  if (tracepoint_deployment->tracepoints_size() > 1) {
-    return error::Internal("Only one Tracepoint is currently supported.");
-  }
-
-  const auto tracepoint = tracepoint_deployment->tracepoints(0);
-
-  if (tracepoint.has_program() && tracepoint.has_bpftrace()) {
-    return error::Internal("Cannot have both PXL program and bpftrace.");
+  // Tracepoints deployed together are compiled into a single BPF program, with one output table
+  // per output. bpftrace scripts are deployed on their own.
+  for (const auto& tracepoint : tracepoint_deployment->tracepoints()) {
+    if (tracepoint.has_program() && tracepoint.has_bpftrace()) {
+      return error::Internal("Cannot have both PXL program and bpftrace.");
+    }
+    if (tracepoint.has_bpftrace() && tracepoint_deployment->tracepoints_size() > 1) {
+      return error::Internal("A bpftrace Tracepoint must be deployed on its own.");
+    }
   }
 
   std::string source_name = absl::StrCat(kDynTraceSourcePrefix, trace_id.str());
 
+  const auto& tracepoint = tracepoint_deployment->tracepoints(0);
   if (tracepoint.has_bpftrace()) {
     return DynamicBPFTraceConnector::Create(source_name, tracepoint);
   }
@@ -499,8 +625,11 @@ void StirlingImpl::DeployDynamicTraceConnector(
   LOG(INFO) << absl::Substitute("DynamicTraceConnector [$0] created in $1 ms.", source->name(),
                                 timer.ElapsedTime_us() / 1000.0);
 
-  // Cache table schema name as source will be moved below.
-  std::string output_name(source->table_schemas()[0].name());
+  // Cache table schema names as source will be moved below.
+  std::vector<std::string> output_names;
+  for (const auto& table_schema : source->table_schemas()) {
+    output_names.emplace_back(table_schema.name());
+  }
 
   timer.Start();
   // Next, try adding the source (this actually tries to deploy BPF code).
@@ -512,7 +641,9 @@ void StirlingImpl::DeployDynamicTraceConnector(
   stirlingpb::Publish publication;
   {
     absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-    PopulatePublishProto(&publication, info_class_mgrs_, output_name);
+    for (const auto& output_name : output_names) {
+      PopulatePublishProto(&publication, info_class_mgrs_, output_name);
+    }
   }
 
   absl::base_internal::SpinLockHolder lock(&dynamic_trace_status_map_lock_);
@@ -674,7 +805,7 @@ static constexpr std::chrono::milliseconds kMaxSleepDuration{1000};
 
 // Helper function: Figure out when to wake up next.
 std::chrono::milliseconds TimeUntilNextTick(
-    const absl::flat_hash_map<SourceConnector*, SourceOutput> source_output_map) {
+    const absl::flat_hash_map<SourceConnector*, SourceOutput>& source_output_map) {
   // The amount to sleep depends on when the earliest Source needs to be sampled again.
   // Do this to avoid burning CPU cycles unnecessarily
   auto now = px::chrono::coarse_steady_clock::now();
@@ -722,6 +853,7 @@ bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
 // Must run as a thread, so only call from Run() as a thread.
 void StirlingImpl::RunCore() {
   running_ = true;
+  px::profiler::SetCurrentThreadRole(px::profiler::ThreadRole::kStirlingCore);
 
   // First initialize each info class manager with context.
   {
@@ -733,6 +865,21 @@ void StirlingImpl::RunCore() {
   }
   // TODO(oazizi): We need to call InitContext on dynamic sources too. Fix.
 
+  // The other groups get their own threads, which inherit the name of this one.
+  for (size_t i = 1; i < source_groups_.size(); ++i) {
+    SourceGroup* group = source_groups_[i].get();
+    group->thread = std::thread(&StirlingImpl::RunSourceGroup, this, group);
+  }
+  RunSourceGroup(source_groups_[0].get());
+  for (size_t i = 1; i < source_groups_.size(); ++i) {
+    source_groups_[i]->thread.join();
+  }
+
+  running_ = false;
+}
+
+void StirlingImpl::RunSourceGroup(SourceGroup* group) {
+  const bool main_group = group == source_groups_[0].get();
   while (run_enable_) {
     auto sleep_duration = std::chrono::milliseconds::zero();
 
@@ -743,30 +890,44 @@ void StirlingImpl::RunCore() {
     //               mgr->SamplingRequired() will be true for any manager.
     std::unique_ptr<ConnectorContext> ctx = GetContext();
 
+    // Follow steps of the realtime clock in the BPF timestamp conversions.
+    if (main_group) {
+      system::Config::GetInstance().UpdateClockRealTimeOffset();
+    }
+
     {
       // Acquire spin lock to go through one iteration of sampling and pushing data.
       // Needed to avoid race with main thread update info_class_mgrs_ on new subscription.
-      absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+      absl::base_internal::SpinLockHolder lock(&group->lock);
 
       // Run through every SourceConnector and InfoClassManager being managed.
-      for (auto& [source, output] : source_output_map_) {
+      bool push_all = false;
+      for (auto& [source, output] : group->source_output_map) {
         // Phase 1: Probe each source for its data.
         if (source->sampling_freq_mgr().Expired()) {
           source->TransferData(ctx.get(), output.data_tables);
         }
         // Phase 2: Push Data upstream.
-        if (source->push_freq_mgr().Expired() || DataExceedsThreshold(output.data_tables)) {
+        bool push = source->push_freq_mgr().Expired() || DataExceedsThreshold(output.data_tables);
+        if (FLAGS_stirling_adaptive_scheduling) {
+          // Pushes are coalesced below, so that the table store gets one burst per cycle.
+          push_all |= push;
+        } else if (push) {
+          source->PushData(data_push_callback_, output.data_tables);
+        }
+      }
+      if (push_all) {
+        for (auto& [source, output] : group->source_output_map) {
           source->PushData(data_push_callback_, output.data_tables);
         }
       }
 
       // Figure out how long to sleep.
-      sleep_duration = TimeUntilNextTick(source_output_map_);
+      sleep_duration = TimeUntilNextTick(group->source_output_map);
     }
 
     SleepForDuration(sleep_duration);
   }
-  running_ = false;
 }
 
 bool StirlingImpl::IsRunning() const { return running_; }
@@ -801,25 +962,25 @@ void StirlingImpl::Stop() {
 }
 
 void StirlingImpl::SetDebugLevel(int level) {
-  // Lock not really required, but compiler is making sure we're safe.
-  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->SetDebugLevel(level);
-  }
+  ForEachSource([level](SourceConnector* s) { s->SetDebugLevel(level); });
+}
+
+void StirlingImpl::SetTableDemand(const absl::flat_hash_set<std::string>& table_names) {
+  // Sources don't change what they collect in the middle of a transfer.
+  ForEachSource([&table_names](SourceConnector* s) { s->SetTableDemand(table_names); });
+}
+
+void StirlingImpl::SetLoadShedLevel(int level) {
+  level = std::clamp(level, 0, SourceConnector::kMaxLoadShedLevel);
+  ForEachSource([level](SourceConnector* s) { s->SetLoadShedLevel(level); });
 }
 
 void StirlingImpl::EnablePIDTrace(int pid) {
-  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->EnablePIDTrace(pid);
-  }
+  ForEachSource([pid](SourceConnector* s) { s->EnablePIDTrace(pid); });
 }
 
 void StirlingImpl::DisablePIDTrace(int pid) {
-  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->DisablePIDTrace(pid);
-  }
+  ForEachSource([pid](SourceConnector* s) { s->DisablePIDTrace(pid); });
 }
 
 std::unique_ptr<Stirling> Stirling::Create(std::unique_ptr<SourceRegistry> registry) {
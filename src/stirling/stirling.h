@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
 #include <sole.hpp>
 
 #include "src/common/base/base.h"
@@ -32,6 +33,8 @@
 #include "src/stirling/proto/stirling.pb.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/ir/logicalpb/logical.pb.h"
 
+DECLARE_string(stirling_source_thread_groups);
+
 namespace px {
 namespace stirling {
 
@@ -149,6 +152,20 @@ class Stirling : public NotCopyable {
    */
   virtual void RegisterAgentMetadataCallback(AgentMetadataCallback f) = 0;
 
+  /**
+   * Sets the tables in demand, ie. that the agent queries or retains. The sources that can collect
+   * less for the tables out of demand do so, until the tables are in demand again.
+   * Until this is called, all the tables are in demand.
+   */
+  virtual void SetTableDemand(const absl::flat_hash_set<std::string>& table_names) = 0;
+
+  /**
+   * Sets how much collection the sources shed to save CPU, from 0 (none) to
+   * SourceConnector::kMaxLoadShedLevel, values beyond being clamped. The higher the level, the
+   * less often the sources sample, and the less data the socket tracer captures.
+   */
+  virtual void SetLoadShedLevel(int level) = 0;
+
   /**
    * Main data collection call. This version blocks, so make sure to wrap a thread around it.
    */
@@ -54,11 +54,63 @@ class BinaryDecoder {
     if (buf_.size() < sizeof(TIntType)) {
       return error::ResourceUnavailable("Insufficient number of bytes.");
     }
+    return ExtractIntUnchecked<TIntType>();
+  }
+
+  /**
+   * Extracts count consecutive big-endian ints into out, with a single bounds check.
+   */
+  template <typename TIntType>
+  Status ExtractInts(size_t count, TIntType* out) {
+    if (buf_.size() / sizeof(TIntType) < count) {
+      return error::ResourceUnavailable("Insufficient number of bytes.");
+    }
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = ::px::utils::BEndianBytesToInt<TIntType>(
+          std::string_view(buf_.data() + i * sizeof(TIntType), sizeof(TIntType)));
+    }
+    buf_.remove_prefix(count * sizeof(TIntType));
+    return Status::OK();
+  }
+
+  /**
+   * Checks that the buffer holds at least len more bytes. A parser that decodes a fixed layout
+   * can check for all of its fields at once, and then read them with the Unchecked functions
+   * below, which skip the check and the StatusOr of each field.
+   */
+  Status CheckSize(size_t len) const {
+    if (buf_.size() < len) {
+      return error::ResourceUnavailable("Insufficient number of bytes.");
+    }
+    return Status::OK();
+  }
+
+  template <typename TCharType = char>
+  TCharType ExtractCharUnchecked() {
+    static_assert(sizeof(TCharType) == 1);
+    DCHECK(!buf_.empty());
+    TCharType res = buf_.front();
+    buf_.remove_prefix(1);
+    return res;
+  }
+
+  template <typename TIntType>
+  TIntType ExtractIntUnchecked() {
+    DCHECK_GE(buf_.size(), sizeof(TIntType));
     TIntType val = ::px::utils::BEndianBytesToInt<TIntType>(buf_);
     buf_.remove_prefix(sizeof(TIntType));
     return val;
   }
 
+  template <typename TCharType = char>
+  std::basic_string_view<TCharType> ExtractStringUnchecked(size_t len) {
+    static_assert(sizeof(TCharType) == 1);
+    DCHECK_GE(buf_.size(), len);
+    auto tbuf = CreateStringView<TCharType>(buf_);
+    buf_.remove_prefix(len);
+    return tbuf.substr(0, len);
+  }
+
   template <typename TCharType = char>
   StatusOr<std::basic_string_view<TCharType>> ExtractString(size_t len) {
     static_assert(sizeof(TCharType) == 1);
@@ -50,6 +50,35 @@ TEST(BinaryDecoderTest, ExtractInt) {
   EXPECT_EQ(0, bin_decoder.BufSize());
 }
 
+TEST(BinaryDecoderTest, ExtractUnchecked) {
+  std::string_view data = ConstStringView("\x01\x00\x00\x01\x02" "abc!");
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_OK(bin_decoder.CheckSize(9));
+  EXPECT_EQ(bin_decoder.ExtractCharUnchecked(), 1);
+  EXPECT_EQ(bin_decoder.ExtractIntUnchecked<int16_t>(), 0);
+  EXPECT_EQ(bin_decoder.ExtractIntUnchecked<uint16_t>(), 258);
+  EXPECT_EQ(bin_decoder.ExtractStringUnchecked(3), "abc");
+  EXPECT_EQ(bin_decoder.Buf(), "!");
+  EXPECT_NOT_OK(bin_decoder.CheckSize(2));
+}
+
+TEST(BinaryDecoderTest, ExtractInts) {
+  std::string_view data = ConstStringView("\x00\x01\x00\x02\xff\xff\x05");
+  BinaryDecoder bin_decoder(data);
+
+  int16_t vals[3];
+  ASSERT_OK(bin_decoder.ExtractInts(3, vals));
+  EXPECT_EQ(vals[0], 1);
+  EXPECT_EQ(vals[1], 2);
+  EXPECT_EQ(vals[2], -1);
+  EXPECT_EQ(bin_decoder.BufSize(), 1);
+
+  // A failed bulk read consumes nothing.
+  EXPECT_NOT_OK(bin_decoder.ExtractInts(1, vals));
+  EXPECT_EQ(bin_decoder.BufSize(), 1);
+}
+
 TEST(BinaryDecoderTest, ExtractString) {
   std::string_view data("abc123");
   BinaryDecoder bin_decoder(data);
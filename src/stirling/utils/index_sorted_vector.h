@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <queue>
+#include <utility>
 #include <vector>
 
 namespace px {
@@ -45,6 +47,42 @@ std::vector<size_t> SortedIndexes(const std::vector<T>& v) {
   return idx;
 }
 
+// Like SortedIndexes(), for a vector made of sorted runs, which are merged instead of sorted.
+// run_starts has the start of every run but the first, in increasing order.
+// Ties are broken by position, so the result is the same as with SortedIndexes().
+template <typename T>
+std::vector<size_t> MergedRunIndexes(const std::vector<T>& v,
+                                     const std::vector<size_t>& run_starts) {
+  std::vector<size_t> idx;
+  idx.reserve(v.size());
+
+  // Each cursor is the next position in a run, and the end of the run.
+  using Cursor = std::pair<size_t, size_t>;
+  auto after = [&v](const Cursor& c1, const Cursor& c2) {
+    return v[c2.first] < v[c1.first] || (!(v[c1.first] < v[c2.first]) && c2.first < c1.first);
+  };
+  std::priority_queue<Cursor, std::vector<Cursor>, decltype(after)> cursors(after);
+  size_t run_start = 0;
+  for (size_t run_end : run_starts) {
+    cursors.push({run_start, run_end});
+    run_start = run_end;
+  }
+  if (run_start < v.size()) {
+    cursors.push({run_start, v.size()});
+  }
+
+  while (!cursors.empty()) {
+    Cursor c = cursors.top();
+    cursors.pop();
+    idx.push_back(c.first);
+    if (++c.first < c.second) {
+      cursors.push(c);
+    }
+  }
+
+  return idx;
+}
+
 // An iterator that walks over a vector according to provided indexes.
 // Used in conjunction with SortedIndexes to iterate through an unsorted vector in sorted order.
 template <typename T>
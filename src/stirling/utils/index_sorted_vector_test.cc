@@ -33,6 +33,28 @@ TEST(SortedIndexes, Basic) {
   EXPECT_EQ(sort_indexes, (std::vector<size_t>{1, 0, 2, 5, 4, 3}));
 }
 
+TEST(MergedRunIndexes, Basic) {
+  // Runs: {2}, {0, 4, 10}, {8}, {6}.
+  std::vector<int> data = {2, 0, 4, 10, 8, 6};
+  EXPECT_EQ(MergedRunIndexes(data, {1, 4, 5}), (std::vector<size_t>{1, 0, 2, 5, 4, 3}));
+
+  std::vector<int> sorted = {0, 1, 1, 3};
+  EXPECT_EQ(MergedRunIndexes(sorted, {}), (std::vector<size_t>{0, 1, 2, 3}));
+  EXPECT_EQ(MergedRunIndexes(std::vector<int>{}, {}), (std::vector<size_t>{}));
+}
+
+TEST(MergedRunIndexes, MatchesSortedIndexes) {
+  // Ties across runs must keep the order of appearance, like the stable sort.
+  std::vector<int> data = {1, 3, 5, 1, 3, 5, 0, 3, 7, 2};
+  std::vector<size_t> run_starts;
+  for (size_t i = 1; i < data.size(); ++i) {
+    if (data[i] < data[i - 1]) {
+      run_starts.push_back(i);
+    }
+  }
+  EXPECT_EQ(MergedRunIndexes(data, run_starts), SortedIndexes(data));
+}
+
 TEST(SplitSortedVector, Basic) {
   // Corresponds to {0, 2, 4, 6, 8, 10} after applying sort_indexes
   std::vector<int> data = {2, 0, 4, 10, 8, 6};
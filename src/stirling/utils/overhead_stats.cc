@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/overhead_stats.h"
+
+#include <utility>
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+OverheadStats& OverheadStats::GetInstance() {
+  static OverheadStats stats;
+  return stats;
+}
+
+void OverheadStats::AddRun(OverheadStat::Kind kind, std::string_view name,
+                           std::chrono::nanoseconds duration) {
+  absl::MutexLock lock(&mu_);
+  auto [iter, inserted] = runs_.try_emplace({kind, std::string(name)});
+  OverheadStat& stat = iter->second;
+  if (inserted) {
+    stat.kind = kind;
+    stat.name = std::string(name);
+  }
+  ++stat.run_count;
+  stat.run_time_ns += duration.count();
+}
+
+int64_t OverheadStats::AddCollector(Collector collector) {
+  absl::MutexLock lock(&mu_);
+  int64_t id = next_collector_id_++;
+  collectors_[id] = std::move(collector);
+  return id;
+}
+
+void OverheadStats::RemoveCollector(int64_t id) {
+  absl::MutexLock lock(&mu_);
+  collectors_.erase(id);
+}
+
+std::vector<OverheadStat> OverheadStats::Collect() {
+  absl::MutexLock lock(&mu_);
+  std::vector<OverheadStat> stats;
+  stats.reserve(runs_.size());
+  for (const auto& [key, stat] : runs_) {
+    stats.push_back(stat);
+  }
+  for (const auto& [id, collector] : collectors_) {
+    collector(&stats);
+  }
+  return stats;
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+/**
+ * The overhead of one Stirling component: a source connector, a BPF program or a perf buffer.
+ * Counters are cumulative since the component was created.
+ */
+struct OverheadStat {
+  enum class Kind {
+    // SourceConnector::TransferData(): reading, parsing and stitching data into the tables.
+    kTransferData,
+    // SourceConnector::PushData(): pushing the tables to the agent.
+    kPushData,
+    // A BPF program; only counted while BPF stats are enabled.
+    kBPFProgram,
+    // A perf buffer; only lost_count is set.
+    kPerfBuffer,
+  };
+
+  Kind kind;
+  std::string name;
+  int64_t run_count = 0;
+  int64_t run_time_ns = 0;
+  int64_t lost_count = 0;
+};
+
+/**
+ * Process-wide registry of the overhead of Stirling's components, reported by the
+ * stirling_overhead table.
+ *
+ * Source connectors add their runs directly. Components that hold their own counters, such as
+ * BCCWrapper, register a collector that appends their stats when the registry is read.
+ */
+class OverheadStats {
+ public:
+  using Collector = std::function<void(std::vector<OverheadStat>*)>;
+
+  static OverheadStats& GetInstance();
+
+  /**
+   * Adds a run of the named component, which must be of kind kTransferData or kPushData.
+   */
+  void AddRun(OverheadStat::Kind kind, std::string_view name, std::chrono::nanoseconds duration);
+
+  /**
+   * Registers a collector, which is called by Collect() until it is removed with the returned ID.
+   * Collectors are called with the registry locked, so removing a collector also waits for any
+   * call in progress to finish.
+   */
+  int64_t AddCollector(Collector collector);
+  void RemoveCollector(int64_t id);
+
+  /**
+   * Returns the overhead of all the components.
+   */
+  std::vector<OverheadStat> Collect();
+
+ private:
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::pair<OverheadStat::Kind, std::string>, OverheadStat> runs_
+      ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<int64_t, Collector> collectors_ ABSL_GUARDED_BY(mu_);
+  int64_t next_collector_id_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+/**
+ * Measures a scope, and adds it as a run of the named component when it ends.
+ */
+class ScopedOverheadTimer {
+ public:
+  ScopedOverheadTimer(OverheadStat::Kind kind, std::string_view name)
+      : kind_(kind), name_(name), start_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedOverheadTimer() {
+    OverheadStats::GetInstance().AddRun(kind_, name_, std::chrono::steady_clock::now() - start_);
+  }
+
+ private:
+  const OverheadStat::Kind kind_;
+  const std::string_view name_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/overhead_stats.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+using ::testing::Field;
+using ::testing::UnorderedElementsAre;
+
+TEST(OverheadStatsTest, RunsAndCollectors) {
+  OverheadStats stats;
+
+  stats.AddRun(OverheadStat::Kind::kTransferData, "a", std::chrono::nanoseconds(10));
+  stats.AddRun(OverheadStat::Kind::kTransferData, "a", std::chrono::nanoseconds(5));
+  stats.AddRun(OverheadStat::Kind::kPushData, "a", std::chrono::nanoseconds(1));
+
+  int64_t id = stats.AddCollector([](std::vector<OverheadStat>* out) {
+    out->push_back({OverheadStat::Kind::kBPFProgram, "probe", 3, 300, 0});
+  });
+
+  std::vector<OverheadStat> collected = stats.Collect();
+  EXPECT_THAT(collected, UnorderedElementsAre(Field(&OverheadStat::run_time_ns, 15),
+                                              Field(&OverheadStat::run_time_ns, 1),
+                                              Field(&OverheadStat::run_time_ns, 300)));
+  for (const auto& stat : collected) {
+    if (stat.kind == OverheadStat::Kind::kTransferData) {
+      EXPECT_EQ(stat.name, "a");
+      EXPECT_EQ(stat.run_count, 2);
+    }
+  }
+
+  stats.RemoveCollector(id);
+  EXPECT_EQ(stats.Collect().size(), 2);
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
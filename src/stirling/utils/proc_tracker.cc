@@ -37,6 +37,17 @@ void ProcTracker::Update(absl::flat_hash_set<md::UPID> upids) {
   }
   deleted_upids_ = std::move(upids_);
   upids_ = std::move(upids);
+  generation_ = 0;
+}
+
+void ProcTracker::Update(const absl::flat_hash_set<md::UPID>& upids, uint64_t generation) {
+  if (generation != 0 && generation == generation_) {
+    new_upids_.clear();
+    deleted_upids_.clear();
+    return;
+  }
+  Update(absl::flat_hash_set<md::UPID>(upids));
+  generation_ = generation;
 }
 
 }  // namespace stirling
@@ -38,6 +38,14 @@ class ProcTracker : NotCopyMoveable {
    */
   void Update(absl::flat_hash_set<md::UPID> upids);
 
+  /**
+   * Same as Update(upids), for a set of UPIDs that is tagged with a generation number which
+   * changes whenever the set may have changed. An update with the same (non-zero) generation as
+   * the previous one skips copying and diffing the set, and leaves new_upids() and
+   * deleted_upids() empty. A generation of 0 means unknown, and the set is always diffed.
+   */
+  void Update(const absl::flat_hash_set<md::UPID>& upids, uint64_t generation);
+
   /**
    * Returns all current upids, as set by last call to Update().
    */
@@ -57,6 +65,7 @@ class ProcTracker : NotCopyMoveable {
   absl::flat_hash_set<md::UPID> upids_;
   absl::flat_hash_set<md::UPID> new_upids_;
   absl::flat_hash_set<md::UPID> deleted_upids_;
+  uint64_t generation_ = 0;
 };
 
 }  // namespace stirling
@@ -61,5 +61,32 @@ TEST_F(ProcTrackerTest, Basic) {
   EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID3));
 }
 
+TEST_F(ProcTrackerTest, Generation) {
+  using UPIDSet = absl::flat_hash_set<md::UPID>;
+
+  const md::UPID kUPID1 = md::UPID(0, 1, 111);
+  const md::UPID kUPID2 = md::UPID(0, 2, 222);
+
+  proc_tracker_.Update(UPIDSet{kUPID1}, 1);
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID1));
+
+  // Same generation: the set is assumed unchanged.
+  proc_tracker_.Update(UPIDSet{kUPID1}, 1);
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1));
+  EXPECT_THAT(proc_tracker_.new_upids(), IsEmpty());
+  EXPECT_THAT(proc_tracker_.deleted_upids(), IsEmpty());
+
+  proc_tracker_.Update(UPIDSet{kUPID2}, 2);
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID2));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID2));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID1));
+
+  // An unknown generation is always diffed.
+  proc_tracker_.Update(UPIDSet{kUPID1, kUPID2}, 0);
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID1));
+  proc_tracker_.Update(UPIDSet{kUPID2}, 0);
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID1));
+}
+
 }  // namespace stirling
 }  // namespace px
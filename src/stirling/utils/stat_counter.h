@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <absl/strings/str_cat.h>
@@ -27,6 +28,8 @@
 
 #include <magic_enum.hpp>
 
+#include "src/common/metrics/metrics.h"
+
 namespace px {
 namespace stirling {
 namespace utils {
@@ -39,8 +42,8 @@ namespace utils {
 template <typename TKeyType>
 class StatCounter {
  public:
-  void Increment(TKeyType key, int count = 1) { counts_[static_cast<int>(key)] += count; }
-  void Decrement(TKeyType key, int count = 1) { counts_[static_cast<int>(key)] -= count; }
+  void Increment(TKeyType key, int64_t count = 1) { counts_[static_cast<int>(key)] += count; }
+  void Decrement(TKeyType key, int64_t count = 1) { counts_[static_cast<int>(key)] -= count; }
   void Reset(TKeyType key) { counts_[static_cast<int>(key)] = 0; }
   int64_t Get(TKeyType key) const { return counts_[static_cast<int>(key)]; }
   std::string Print() const {
@@ -55,6 +58,35 @@ class StatCounter {
   std::vector<int64_t> counts_ = std::vector<int64_t>(magic_enum::enum_count<TKeyType>(), 0);
 };
 
+/**
+ * Mirrors a StatCounter into a family of gauges, labeled by the key names, so that its counts
+ * can be scraped from /metrics. Update() is called by the thread that owns the StatCounter.
+ */
+template <typename TKeyType>
+class StatCounterGauges {
+ public:
+  StatCounterGauges(std::string_view name, std::string_view help) {
+    for (auto key : magic_enum::enum_values<TKeyType>()) {
+      std::string_view key_name = magic_enum::enum_name(key);
+      // Drop the "k" prefix of the enum values' names.
+      if (key_name.size() > 1 && key_name[0] == 'k') {
+        key_name.remove_prefix(1);
+      }
+      gauges_.push_back(metrics::MetricsRegistry::Global()->GetGauge(
+          name, help, {{"stat", std::string(key_name)}}));
+    }
+  }
+
+  void Update(const StatCounter<TKeyType>& counter) {
+    for (auto key : magic_enum::enum_values<TKeyType>()) {
+      gauges_[static_cast<int>(key)]->Set(counter.Get(key));
+    }
+  }
+
+ private:
+  std::vector<metrics::Gauge*> gauges_;
+};
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace stirling {
+
+/**
+ * TimerWheel is a hierarchical timing wheel: it buckets keys by the tick at which they are due,
+ * so that advancing time only visits the buckets that became due, rather than every key.
+ *
+ * Keys may fire up to one tick late, and keys scheduled beyond the range of the wheel fire early,
+ * so callers are expected to re-check a fired key against its actual deadline (and reschedule it
+ * if it's not yet due).
+ */
+template <typename TKey>
+class TimerWheel {
+ public:
+  explicit TimerWheel(std::chrono::nanoseconds tick) : tick_ns_(tick.count()) {}
+
+  /**
+   * Schedules the key to fire once time advances past timestamp_ns.
+   * Keys scheduled in the past fire on the next call to Advance().
+   */
+  void Schedule(TKey key, uint64_t timestamp_ns) {
+    uint64_t tick = timestamp_ns / tick_ns_;
+    if (!initialized_) {
+      current_tick_ = tick > 0 ? tick - 1 : 0;
+      initialized_ = true;
+    }
+    if (tick <= current_tick_) {
+      due_.push_back(std::move(key));
+      return;
+    }
+    uint32_t node = AllocNode(std::move(key), tick);
+    Insert(node);
+  }
+
+  /**
+   * Advances time to timestamp_ns, and appends all keys that are now due to expired.
+   */
+  void Advance(uint64_t timestamp_ns, std::vector<TKey>* expired) {
+    for (auto& key : due_) {
+      expired->push_back(std::move(key));
+    }
+    due_.clear();
+
+    uint64_t target_tick = timestamp_ns / tick_ns_;
+    if (num_slotted_ == 0) {
+      // Nothing to visit, so jump straight to the target.
+      current_tick_ = std::max(current_tick_, target_tick);
+      initialized_ = true;
+      return;
+    }
+
+    while (current_tick_ < target_tick && num_slotted_ > 0) {
+      // If the lower levels are empty, skip ahead to the next tick at which the first non-empty
+      // level cascades.
+      int lowest = 0;
+      while (lowest < kNumLevels - 1 && (*level_sizes_)[lowest] == 0) {
+        ++lowest;
+      }
+      if (lowest > 0) {
+        uint64_t span = uint64_t{1} << (kLevelBits * lowest);
+        uint64_t next_cascade = (current_tick_ / span + 1) * span;
+        current_tick_ = std::min(target_tick, next_cascade) - 1;
+      }
+
+      ++current_tick_;
+      // Move entries of higher levels down, whenever the lower level wraps around.
+      for (int level = 1; level < kNumLevels; ++level) {
+        if ((current_tick_ & ((uint64_t{1} << (kLevelBits * level)) - 1)) != 0) {
+          break;
+        }
+        uint32_t node = TakeSlot(level, SlotIndex(current_tick_, level));
+        while (node != kNil) {
+          uint32_t next = nodes_[node].next;
+          if (nodes_[node].tick <= current_tick_) {
+            Fire(node, expired);
+          } else {
+            Insert(node);
+          }
+          node = next;
+        }
+      }
+      uint32_t node = TakeSlot(0, SlotIndex(current_tick_, 0));
+      while (node != kNil) {
+        uint32_t next = nodes_[node].next;
+        Fire(node, expired);
+        node = next;
+      }
+    }
+    current_tick_ = std::max(current_tick_, target_tick);
+  }
+
+  /**
+   * Number of keys that are scheduled, but have not yet fired.
+   */
+  size_t size() const { return num_slotted_ + due_.size(); }
+
+  void Clear() {
+    slots_.reset();
+    level_sizes_.reset();
+    nodes_.clear();
+    free_head_ = kNil;
+    num_slotted_ = 0;
+    due_.clear();
+  }
+
+ private:
+  static constexpr int kLevelBits = 6;
+  static constexpr int kNumSlots = 1 << kLevelBits;
+  static constexpr int kNumLevels = 4;
+  static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+
+  struct Node {
+    TKey key;
+    uint64_t tick;
+    uint32_t next;
+  };
+
+  static size_t SlotIndex(uint64_t tick, int level) {
+    return (tick >> (kLevelBits * level)) & (kNumSlots - 1);
+  }
+
+  uint32_t AllocNode(TKey key, uint64_t tick) {
+    if (free_head_ != kNil) {
+      uint32_t node = free_head_;
+      free_head_ = nodes_[node].next;
+      nodes_[node] = Node{std::move(key), tick, kNil};
+      return node;
+    }
+    nodes_.push_back(Node{std::move(key), tick, kNil});
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  void Insert(uint32_t node) {
+    if (slots_ == nullptr) {
+      // Allocated lazily, since many owners never schedule anything.
+      slots_ = std::make_unique<Slots>();
+      for (auto& level : *slots_) {
+        level.fill(kNil);
+      }
+      level_sizes_ = std::make_unique<std::array<size_t, kNumLevels>>();
+      level_sizes_->fill(0);
+    }
+
+    uint64_t delta = nodes_[node].tick - current_tick_;
+    int level = 0;
+    while (level < kNumLevels - 1 && delta >= (uint64_t{1} << (kLevelBits * (level + 1)))) {
+      ++level;
+    }
+    uint64_t tick = nodes_[node].tick;
+    if (delta >= (uint64_t{1} << (kLevelBits * kNumLevels))) {
+      // Beyond the range of the wheel; park it in the furthest slot, it will fire early.
+      tick = current_tick_ + (uint64_t{1} << (kLevelBits * kNumLevels)) - 1;
+      nodes_[node].tick = tick;
+    }
+
+    uint32_t& head = (*slots_)[level][SlotIndex(tick, level)];
+    nodes_[node].next = head;
+    head = node;
+    ++(*level_sizes_)[level];
+    ++num_slotted_;
+  }
+
+  uint32_t TakeSlot(int level, size_t index) {
+    uint32_t& head = (*slots_)[level][index];
+    uint32_t node = head;
+    head = kNil;
+    for (uint32_t n = node; n != kNil; n = nodes_[n].next) {
+      --(*level_sizes_)[level];
+      --num_slotted_;
+    }
+    return node;
+  }
+
+  void Fire(uint32_t node, std::vector<TKey>* expired) {
+    expired->push_back(std::move(nodes_[node].key));
+    nodes_[node].next = free_head_;
+    free_head_ = node;
+  }
+
+  using Slots = std::array<std::array<uint32_t, kNumSlots>, kNumLevels>;
+
+  const uint64_t tick_ns_;
+  bool initialized_ = false;
+  // All ticks up to and including current_tick_ have fired.
+  uint64_t current_tick_ = 0;
+
+  std::unique_ptr<Slots> slots_;
+  std::unique_ptr<std::array<size_t, kNumLevels>> level_sizes_;
+  std::vector<Node> nodes_;
+  uint32_t free_head_ = kNil;
+  size_t num_slotted_ = 0;
+
+  // Keys that were scheduled in the past.
+  std::vector<TKey> due_;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/timer_wheel.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+constexpr uint64_t kSec = 1000 * 1000 * 1000;
+
+TEST(TimerWheelTest, FiresInTimestampOrder) {
+  TimerWheel<int> wheel(std::chrono::seconds(1));
+  const uint64_t kStart = 1000000 * kSec;
+
+  wheel.Schedule(1, kStart + 1 * kSec);
+  wheel.Schedule(2, kStart + 5 * kSec);
+  wheel.Schedule(3, kStart + 5 * kSec);
+  EXPECT_EQ(wheel.size(), 3);
+
+  std::vector<int> expired;
+  wheel.Advance(kStart, &expired);
+  EXPECT_THAT(expired, IsEmpty());
+
+  wheel.Advance(kStart + 2 * kSec, &expired);
+  EXPECT_THAT(expired, ElementsAre(1));
+
+  expired.clear();
+  wheel.Advance(kStart + 5 * kSec, &expired);
+  EXPECT_THAT(expired, UnorderedElementsAre(2, 3));
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimerWheelTest, PastTimestampsFireOnNextAdvance) {
+  TimerWheel<int> wheel(std::chrono::seconds(1));
+  const uint64_t kStart = 1000000 * kSec;
+
+  std::vector<int> expired;
+  wheel.Advance(kStart, &expired);
+  wheel.Schedule(1, kStart - 100 * kSec);
+  wheel.Schedule(2, 0);
+
+  wheel.Advance(kStart, &expired);
+  EXPECT_THAT(expired, UnorderedElementsAre(1, 2));
+}
+
+TEST(TimerWheelTest, CascadesFromHigherLevels) {
+  TimerWheel<int> wheel(std::chrono::seconds(1));
+  const uint64_t kStart = 1000000 * kSec;
+
+  // Spread over all levels of the wheel.
+  std::vector<uint64_t> offsets = {3, 70, 4000, 300000, 10000000};
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    wheel.Schedule(i, kStart + offsets[i] * kSec);
+  }
+
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    std::vector<int> expired;
+    wheel.Advance(kStart + (offsets[i] - 1) * kSec, &expired);
+    EXPECT_THAT(expired, IsEmpty()) << i;
+    wheel.Advance(kStart + offsets[i] * kSec, &expired);
+    EXPECT_THAT(expired, ElementsAre(i));
+  }
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimerWheelTest, BeyondRangeFiresEarly) {
+  TimerWheel<int> wheel(std::chrono::seconds(1));
+  const uint64_t kStart = 1000000 * kSec;
+
+  std::vector<int> expired;
+  wheel.Advance(kStart, &expired);
+  // 2^24 ticks is the range of the wheel.
+  wheel.Schedule(1, kStart + (uint64_t{1} << 30) * kSec);
+
+  wheel.Advance(kStart + (uint64_t{1} << 24) * kSec, &expired);
+  EXPECT_THAT(expired, ElementsAre(1));
+}
+
+TEST(TimerWheelTest, ReusesNodes) {
+  TimerWheel<int> wheel(std::chrono::seconds(1));
+  const uint64_t kStart = 1000000 * kSec;
+
+  std::vector<int> expired;
+  for (int i = 0; i < 100; ++i) {
+    wheel.Schedule(i, kStart + (i + 1) * kSec);
+    wheel.Advance(kStart + (i + 1) * kSec, &expired);
+  }
+  EXPECT_EQ(expired.size(), 100);
+  EXPECT_EQ(wheel.size(), 0);
+
+  wheel.Schedule(7, kStart + 200 * kSec);
+  wheel.Clear();
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+}  // namespace stirling
+}  // namespace px
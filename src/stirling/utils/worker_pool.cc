@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/worker_pool.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+WorkerPool::WorkerPool(size_t num_threads) {
+  DCHECK_GE(num_threads, 1U);
+  for (size_t i = 1; i < num_threads; ++i) {
+    workers_.emplace_back(&WorkerPool::WorkerLoop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+  }
+  batch_started_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkerPool::Run(size_t num_tasks, const std::function<void(size_t)>& fn) {
+  std::unique_lock<std::mutex> lock(mu_);
+  fn_ = &fn;
+  num_tasks_ = num_tasks;
+  next_task_ = 0;
+  tasks_done_ = 0;
+  ++generation_;
+  batch_started_.notify_all();
+
+  RunTasks(&lock);
+  batch_done_.wait(lock, [this] { return tasks_done_ == num_tasks_; });
+  fn_ = nullptr;
+}
+
+void WorkerPool::RunTasks(std::unique_lock<std::mutex>* lock) {
+  while (next_task_ < num_tasks_) {
+    size_t task = next_task_++;
+    const auto& fn = *fn_;
+    // The tasks run without the lock, so that the threads run them concurrently.
+    lock->unlock();
+    fn(task);
+    lock->lock();
+    if (++tasks_done_ == num_tasks_) {
+      batch_done_.notify_all();
+    }
+  }
+}
+
+void WorkerPool::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mu_);
+  int64_t generation = generation_;
+  while (true) {
+    batch_started_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+    if (stopping_) {
+      return;
+    }
+    generation = generation_;
+    RunTasks(&lock);
+  }
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+/**
+ * A WorkerPool keeps a fixed set of threads alive to run batches of tasks, so that a connector
+ * that spreads its work across threads on every iteration doesn't start and join threads each
+ * time. The calling thread runs tasks too. Run() must only be called by one thread at a time.
+ */
+class WorkerPool : public NotCopyable {
+ public:
+  /**
+   * @param num_threads the number of threads that run tasks, including the calling thread.
+   */
+  explicit WorkerPool(size_t num_threads);
+  ~WorkerPool();
+
+  size_t num_threads() const { return workers_.size() + 1; }
+
+  /**
+   * Runs fn(i) for every i in [0, num_tasks), spread across the threads, and returns once all of
+   * them are done.
+   */
+  void Run(size_t num_tasks, const std::function<void(size_t)>& fn);
+
+ private:
+  void WorkerLoop();
+  // Runs tasks of the current batch until none are left to start.
+  void RunTasks(std::unique_lock<std::mutex>* lock);
+
+  std::mutex mu_;
+  // Signaled when a batch starts, and when the pool is stopped.
+  std::condition_variable batch_started_;
+  // Signaled when the last task of a batch is done.
+  std::condition_variable batch_done_;
+  // Incremented for every batch, for the workers to tell that a new batch started.
+  int64_t generation_ = 0;
+  const std::function<void(size_t)>* fn_ = nullptr;
+  size_t num_tasks_ = 0;
+  size_t next_task_ = 0;
+  size_t tasks_done_ = 0;
+  bool stopping_ = false;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
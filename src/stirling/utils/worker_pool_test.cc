@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/worker_pool.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+// Tests that every task of every batch runs exactly once.
+TEST(WorkerPoolTest, RunsEveryTaskOnce) {
+  WorkerPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4);
+
+  for (size_t num_tasks : {0, 1, 3, 4, 100}) {
+    std::vector<std::atomic<int>> runs(num_tasks);
+    pool.Run(num_tasks, [&](size_t i) { ++runs[i]; });
+    for (const auto& r : runs) {
+      EXPECT_EQ(r.load(), 1);
+    }
+  }
+}
+
+// Tests that the same threads are reused across batches.
+TEST(WorkerPoolTest, ReusesThreads) {
+  WorkerPool pool(3);
+
+  std::mutex mu;
+  std::set<std::thread::id> thread_ids;
+  for (int batch = 0; batch < 50; ++batch) {
+    pool.Run(8, [&](size_t) {
+      std::lock_guard<std::mutex> lock(mu);
+      thread_ids.insert(std::this_thread::get_id());
+    });
+  }
+  EXPECT_LE(thread_ids.size(), 3);
+}
+
+// Tests that a pool of one thread runs the tasks on the calling thread, in order.
+TEST(WorkerPoolTest, SingleThread) {
+  WorkerPool pool(1);
+
+  std::thread::id caller_id = std::this_thread::get_id();
+  std::vector<size_t> order;
+  pool.Run(5, [&](size_t i) {
+    EXPECT_EQ(std::this_thread::get_id(), caller_id);
+    order.push_back(i);
+  });
+  EXPECT_THAT(order, ::testing::ElementsAre(0, 1, 2, 3, 4));
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -17,6 +17,7 @@
  */
 
 #include <arrow/array.h>
+#include <arrow/builder.h>
 #include <algorithm>
 #include <memory>
 #include <string>
@@ -43,7 +44,9 @@ Status RowBatch::AddColumn(const std::shared_ptr<arrow::Array>& col) {
   if (col->length() != num_rows_) {
     return error::InvalidArgument("Schema only allows $0 rows, got $1", num_rows_, col->length());
   }
-  if (col->type_id() != types::ToArrowType(desc_.type(columns_.size()))) {
+  auto data_type = desc_.type(columns_.size());
+  bool dictionary_strings = data_type == DataType::STRING && types::IsDictionaryArray(*col);
+  if (col->type_id() != types::ToArrowType(data_type) && !dictionary_strings) {
     return error::InvalidArgument("Column[$0] was given incorrect type", columns_.size());
   }
 
@@ -51,6 +54,87 @@ Status RowBatch::AddColumn(const std::shared_ptr<arrow::Array>& col) {
   return Status::OK();
 }
 
+bool RowBatch::HasDictionaryColumns() const {
+  return std::any_of(columns_.begin(), columns_.end(),
+                     [](const auto& col) { return types::IsDictionaryArray(*col); });
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::DecodeDictionaries(
+    arrow::MemoryPool* mem_pool) const {
+  auto output_rb = std::make_unique<RowBatch>(desc_, num_rows_);
+  for (const auto& col : columns_) {
+    PL_ASSIGN_OR_RETURN(auto decoded, types::DecodeDictionaryArray(col, mem_pool));
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(decoded));
+  }
+  output_rb->set_eow(eow_);
+  output_rb->set_eos(eos_);
+  return output_rb;
+}
+
+namespace {
+
+template <DataType T>
+StatusOr<std::shared_ptr<arrow::Array>> SelectValues(const arrow::Array* input_col,
+                                                     const std::vector<int64_t>& rows,
+                                                     arrow::MemoryPool* mem_pool) {
+  auto builder_generic = types::MakeArrowBuilder(T, mem_pool);
+  auto* builder =
+      static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(builder_generic.get());
+  PL_RETURN_IF_ERROR(builder->Reserve(rows.size()));
+  if constexpr (T == DataType::STRING) {
+    int64_t data_size = 0;
+    for (int64_t row : rows) {
+      data_size += types::GetValueFromArrowArray<T>(input_col, row).size();
+    }
+    PL_RETURN_IF_ERROR(builder->ReserveData(data_size));
+  }
+  for (int64_t row : rows) {
+    builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input_col, row));
+  }
+  std::shared_ptr<arrow::Array> output_col;
+  PL_RETURN_IF_ERROR(builder->Finish(&output_col));
+  return output_col;
+}
+
+// Dictionary-encoded strings only copy the codes of the selected rows, and share the dictionary.
+StatusOr<std::shared_ptr<arrow::Array>> SelectCodes(const arrow::Array* input_col,
+                                                    const std::vector<int64_t>& rows,
+                                                    arrow::MemoryPool* mem_pool) {
+  auto dict_arr = static_cast<const arrow::DictionaryArray*>(input_col);
+  auto codes = static_cast<const arrow::Int32Array*>(dict_arr->indices().get());
+  arrow::Int32Builder codes_builder(mem_pool);
+  PL_RETURN_IF_ERROR(codes_builder.Reserve(rows.size()));
+  for (int64_t row : rows) {
+    codes_builder.UnsafeAppend(codes->Value(row));
+  }
+  std::shared_ptr<arrow::Array> output_codes;
+  PL_RETURN_IF_ERROR(codes_builder.Finish(&output_codes));
+  return types::MakeDictionaryStringArray(output_codes, dict_arr->dictionary());
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::Materialize(arrow::MemoryPool* mem_pool) const {
+  DCHECK(selection_ != nullptr);
+  const auto& rows = *selection_;
+  auto output_rb = std::make_unique<RowBatch>(desc_, rows.size());
+  for (const auto& [col_idx, col] : Enumerate(columns_)) {
+    std::shared_ptr<arrow::Array> output_col;
+    if (types::IsDictionaryArray(*col)) {
+      PL_ASSIGN_OR_RETURN(output_col, SelectCodes(col.get(), rows, mem_pool));
+    } else {
+#define TYPE_CASE(_dt_) \
+  PL_ASSIGN_OR_RETURN(output_col, SelectValues<_dt_>(col.get(), rows, mem_pool));
+      PL_SWITCH_FOREACH_DATATYPE(desc_.type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+    }
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+  }
+  output_rb->set_eow(eow_);
+  output_rb->set_eos(eos_);
+  return output_rb;
+}
+
 bool RowBatch::HasColumn(int64_t i) const { return columns_.size() > static_cast<size_t>(i); }
 
 std::string RowBatch::DebugString() const {
@@ -70,9 +154,9 @@ int64_t RowBatch::NumBytes() const {
   }
 
   int64_t total_bytes = 0;
-  for (auto col : columns_) {
+  for (const auto& [col_idx, col] : Enumerate(columns_)) {
 #define TYPE_CASE(_dt_) total_bytes += types::GetArrowArrayBytes<_dt_>(col.get());
-    PL_SWITCH_FOREACH_DATATYPE(types::ArrowToDataType(col->type_id()), TYPE_CASE);
+    PL_SWITCH_FOREACH_DATATYPE(desc_.type(col_idx), TYPE_CASE);
 #undef TYPE_CASE
   }
   return total_bytes;
@@ -159,12 +243,16 @@ Status CopyFromInputPB(std::shared_ptr<arrow::Array>* output_column,
 }
 
 Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto) const {
+  DCHECK(selection_ == nullptr) << "Materialize the row batch before serializing it.";
   proto->set_num_rows(num_rows_);
   proto->set_eow(eow_);
   proto->set_eos(eos_);
 
   for (auto col_idx = 0; col_idx < num_columns(); ++col_idx) {
-    auto input_col = ColumnAt(col_idx).get();
+    // The protos only hold plain columns.
+    PL_ASSIGN_OR_RETURN(auto decoded_col, types::DecodeDictionaryArray(
+                                              ColumnAt(col_idx), arrow::default_memory_pool()));
+    auto input_col = decoded_col.get();
     auto output_col_data = proto->add_cols();
     auto dt = desc_.type(col_idx);
 
@@ -223,6 +311,148 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
   return output_rb;
 }
 
+namespace {
+
+template <DataType T>
+void CopyBuffersIntoOutputPB(table_store::schemapb::ArrowRowBatchData::Column* output_column,
+                             const arrow::Array* input_column) {
+  using native_type = typename types::DataTypeTraits<T>::native_type;
+  const auto* values =
+      static_cast<const typename types::DataTypeTraits<T>::arrow_array_type*>(input_column)
+          ->raw_values();
+  output_column->set_data(values, input_column->length() * sizeof(native_type));
+}
+
+template <>
+void CopyBuffersIntoOutputPB<DataType::BOOLEAN>(
+    table_store::schemapb::ArrowRowBatchData::Column* output_column,
+    const arrow::Array* input_column) {
+  // Slices can start in the middle of a byte of the bitmap, so the bit offset is kept.
+  int64_t first_byte = input_column->offset() / 8;
+  int64_t end_byte = (input_column->offset() + input_column->length() + 7) / 8;
+  const auto* bitmap = static_cast<const arrow::BooleanArray*>(input_column)->values()->data();
+  output_column->set_data(bitmap + first_byte, end_byte - first_byte);
+  output_column->set_bit_offset(input_column->offset() % 8);
+}
+
+template <>
+void CopyBuffersIntoOutputPB<DataType::STRING>(
+    table_store::schemapb::ArrowRowBatchData::Column* output_column,
+    const arrow::Array* input_column) {
+  const auto* str_column = static_cast<const arrow::StringArray*>(input_column);
+  int64_t length = input_column->length();
+  const int32_t* offsets = str_column->raw_value_offsets();
+  int32_t first = offsets[0];
+  output_column->set_data(str_column->value_data()->data() + first, offsets[length] - first);
+
+  // Only the characters of the slice are sent, so the offsets are rebased on its first value.
+  std::string* output_offsets = output_column->mutable_offsets();
+  output_offsets->resize((length + 1) * sizeof(int32_t));
+  auto* rebased_offsets = reinterpret_cast<int32_t*>(output_offsets->data());
+  for (int64_t i = 0; i <= length; ++i) {
+    rebased_offsets[i] = offsets[i] - first;
+  }
+}
+
+// Checks that the buffers of the column hold num_rows values, so the arrays built on top of
+// them don't read past their end.
+Status CheckBufferSizes(const table_store::schemapb::ArrowRowBatchData::Column& column,
+                        int64_t num_rows) {
+  int64_t data_size = column.data().size();
+  switch (column.data_type()) {
+    case DataType::BOOLEAN:
+      if (column.bit_offset() < 0 || column.bit_offset() >= 8 ||
+          data_size < (column.bit_offset() + num_rows + 7) / 8) {
+        return error::InvalidArgument("Boolean column too small for $0 rows", num_rows);
+      }
+      return Status::OK();
+    case DataType::STRING: {
+      int64_t offsets_size = column.offsets().size();
+      if (offsets_size != (num_rows + 1) * static_cast<int64_t>(sizeof(int32_t))) {
+        return error::InvalidArgument("String column offsets don't match $0 rows", num_rows);
+      }
+      const auto* offsets = reinterpret_cast<const int32_t*>(column.offsets().data());
+      if (offsets[0] != 0 || offsets[num_rows] != data_size) {
+        return error::InvalidArgument("String column offsets don't match its data");
+      }
+      return Status::OK();
+    }
+    case DataType::INT64:
+    case DataType::UINT128:
+    case DataType::TIME64NS:
+    case DataType::FLOAT64: {
+      int64_t width = types::ArrowTypeToBytes(types::ToArrowType(column.data_type()));
+      if (data_size != num_rows * width) {
+        return error::InvalidArgument("Column of type $0 doesn't hold $1 rows",
+                                      types::ToString(column.data_type()), num_rows);
+      }
+      return Status::OK();
+    }
+    default:
+      return error::InvalidArgument("Received unknown column data type '$0'",
+                                    types::ToString(column.data_type()));
+  }
+}
+
+}  // namespace
+
+Status RowBatch::ToArrowProto(table_store::schemapb::ArrowRowBatchData* proto) const {
+  DCHECK(selection_ == nullptr) << "Materialize the row batch before serializing it.";
+  proto->set_num_rows(num_rows_);
+  proto->set_eow(eow_);
+  proto->set_eos(eos_);
+
+  for (auto col_idx = 0; col_idx < num_columns(); ++col_idx) {
+    // The protos only hold plain columns.
+    PL_ASSIGN_OR_RETURN(auto decoded_col, types::DecodeDictionaryArray(
+                                              ColumnAt(col_idx), arrow::default_memory_pool()));
+    auto input_col = decoded_col.get();
+    auto output_col_data = proto->add_cols();
+    auto dt = desc_.type(col_idx);
+    output_col_data->set_data_type(dt);
+
+#define TYPE_CASE(_dt_) CopyBuffersIntoOutputPB<_dt_>(output_col_data, input_col);
+    PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromArrowProto(
+    table_store::schemapb::ArrowRowBatchData* proto) {
+  int64_t num_rows = proto->num_rows();
+  std::vector<DataType> types(proto->cols_size());
+  std::vector<std::shared_ptr<arrow::Array>> data_columns(proto->cols_size());
+
+  for (auto i = 0; i < proto->cols_size(); ++i) {
+    auto* col = proto->mutable_cols(i);
+    types[i] = col->data_type();
+    PL_RETURN_IF_ERROR(CheckBufferSizes(*col, num_rows));
+
+    // Pixie columns don't have nulls, so there is no validity bitmap.
+    std::vector<std::shared_ptr<arrow::Buffer>> buffers = {nullptr};
+    if (types[i] == DataType::STRING) {
+      buffers.push_back(arrow::Buffer::FromString(std::move(*col->mutable_offsets())));
+    }
+    buffers.push_back(arrow::Buffer::FromString(std::move(*col->mutable_data())));
+    data_columns[i] = arrow::MakeArray(arrow::ArrayData::Make(
+        types::DataTypeToArrowType(types[i]), num_rows, std::move(buffers), /* null_count */ 0,
+        /* offset */ col->bit_offset()));
+  }
+
+  RowDescriptor desc(types);
+  std::unique_ptr<RowBatch> output_rb = std::make_unique<RowBatch>(desc, num_rows);
+  output_rb->set_eow(proto->eow());
+  output_rb->set_eos(proto->eos());
+
+  for (auto i = 0; i < proto->cols_size(); ++i) {
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(data_columns[i]));
+  }
+
+  return output_rb;
+}
+
 StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromColumnBuilders(
     const RowDescriptor& desc, bool eow, bool eos,
     std::vector<std::unique_ptr<arrow::ArrayBuilder>>* builders) {
@@ -55,6 +55,17 @@ class RowBatch {
   static StatusOr<std::unique_ptr<RowBatch>> FromProto(
       const table_store::schemapb::RowBatchData& row_batch_proto);
 
+  /**
+   * Serializes the row batch as the arrow buffers of its columns. This is much cheaper than
+   * ToProto, which copies each value into its own proto field.
+   */
+  Status ToArrowProto(table_store::schemapb::ArrowRowBatchData* row_batch_proto) const;
+  /**
+   * Creates a row batch on top of the buffers of the proto, which are moved out of it.
+   */
+  static StatusOr<std::unique_ptr<RowBatch>> FromArrowProto(
+      table_store::schemapb::ArrowRowBatchData* row_batch_proto);
+
   static StatusOr<std::unique_ptr<RowBatch>> FromColumnBuilders(
       const RowDescriptor& desc, bool eow, bool eos,
       std::vector<std::unique_ptr<arrow::ArrayBuilder>>* builders);
@@ -84,6 +95,39 @@ class RowBatch {
    */
   Status AddColumn(const std::shared_ptr<arrow::Array>& col);
 
+  /**
+   * @ returns whether any of the string columns is dictionary encoded.
+   */
+  bool HasDictionaryColumns() const;
+
+  /**
+   * @ returns a copy of the row batch with its dictionary-encoded string columns decoded.
+   */
+  StatusOr<std::unique_ptr<RowBatch>> DecodeDictionaries(arrow::MemoryPool* mem_pool) const;
+
+  /**
+   * Restricts the row batch to the given rows (in increasing order) of its columns, without
+   * copying them. The selection is shared with the batches that are derived from this one.
+   */
+  void set_selection(std::shared_ptr<const std::vector<int64_t>> selection) {
+    selection_ = std::move(selection);
+  }
+  const std::shared_ptr<const std::vector<int64_t>>& selection() const { return selection_; }
+  bool has_selection() const { return selection_ != nullptr; }
+
+  /**
+   * @ return the number of rows that are selected, which is num_rows() without a selection.
+   */
+  int64_t num_selected_rows() const {
+    return selection_ == nullptr ? num_rows_ : static_cast<int64_t>(selection_->size());
+  }
+
+  /**
+   * @ returns a copy of the row batch that only has the selected rows in its columns, and no
+   * selection. Dictionary-encoded string columns stay encoded.
+   */
+  StatusOr<std::unique_ptr<RowBatch>> Materialize(arrow::MemoryPool* mem_pool) const;
+
   /**
    * @ param i the index of the column to be accessed.
    * @ returns the Arrow array for the column at the given index.
@@ -97,7 +141,8 @@ class RowBatch {
   bool HasColumn(int64_t i) const;
 
   /**
-   * @ return the number of rows that each row batch should contain.
+   * @ return the number of rows that each column of the row batch contains, including the ones
+   * left out by the selection.
    */
   int64_t num_rows() const { return num_rows_; }
 
@@ -128,6 +173,7 @@ class RowBatch {
   bool eow_ = false;
   bool eos_ = false;
   std::vector<std::shared_ptr<arrow::Array>> columns_;
+  std::shared_ptr<const std::vector<int64_t>> selection_;
 };
 
 // Append a scalar value to an arrow::Array.
@@ -19,6 +19,7 @@
 #include <arrow/array.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
+#include <memory>
 #include <vector>
 
 #include "src/common/testing/testing.h"
@@ -179,6 +180,55 @@ TEST_F(RowBatchTest, to_from_proto) {
   EXPECT_TRUE(differ.Compare(input_proto, output_proto));
 }
 
+TEST_F(RowBatchTest, to_from_arrow_proto) {
+  table_store::schemapb::RowBatchData input_proto;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kTestRowBatchProto, &input_proto));
+  auto input_rb = RowBatch::FromProto(input_proto).ConsumeValueOrDie();
+
+  table_store::schemapb::ArrowRowBatchData arrow_proto;
+  EXPECT_OK(input_rb->ToArrowProto(&arrow_proto));
+  ASSERT_OK_AND_ASSIGN(auto rb, RowBatch::FromArrowProto(&arrow_proto));
+  EXPECT_TRUE(rb->eow());
+  EXPECT_FALSE(rb->eos());
+  EXPECT_EQ(input_rb->desc(), rb->desc());
+  EXPECT_EQ(input_rb->DebugString(), rb->DebugString());
+
+  table_store::schemapb::RowBatchData output_proto;
+  EXPECT_OK(rb->ToProto(&output_proto));
+  google::protobuf::util::MessageDifferencer differ;
+  EXPECT_TRUE(differ.Compare(input_proto, output_proto));
+}
+
+TEST_F(RowBatchTest, to_from_arrow_proto_slice) {
+  auto descriptor = std::vector<types::DataType>(
+      {types::DataType::BOOLEAN, types::DataType::TIME64NS, types::DataType::STRING});
+  RowDescriptor rd(descriptor);
+  RowBatch rb(rd, 10);
+  std::vector<types::BoolValue> in1 = {true, false, true, true, false,
+                                       false, true, false, true, true};
+  std::vector<types::Time64NSValue> in2 = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  std::vector<types::StringValue> in3 = {"a", "bc", "def", "", "ghij", "k", "lm", "n", "op", "q"};
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in1, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in2, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in3, arrow::default_memory_pool())));
+
+  // The slice starts in the middle of the boolean bitmap and of the string data.
+  ASSERT_OK_AND_ASSIGN(auto slice, rb.Slice(3, 6));
+  table_store::schemapb::ArrowRowBatchData arrow_proto;
+  EXPECT_OK(slice->ToArrowProto(&arrow_proto));
+  EXPECT_EQ(10, arrow_proto.cols(2).data().size());
+
+  ASSERT_OK_AND_ASSIGN(auto output_rb, RowBatch::FromArrowProto(&arrow_proto));
+  EXPECT_EQ(slice->DebugString(), output_rb->DebugString());
+}
+
+TEST_F(RowBatchTest, from_arrow_proto_bad_buffers) {
+  table_store::schemapb::ArrowRowBatchData arrow_proto;
+  EXPECT_OK(rb_->ToArrowProto(&arrow_proto));
+  arrow_proto.set_num_rows(4);
+  EXPECT_NOT_OK(RowBatch::FromArrowProto(&arrow_proto));
+}
+
 TEST_F(RowBatchTest, with_zero_rows) {
   bool eow = true;
   bool eos = false;
@@ -190,6 +240,50 @@ TEST_F(RowBatchTest, with_zero_rows) {
   EXPECT_EQ(eos, rb->eos());
 }
 
+TEST_F(RowBatchTest, materialize_selection) {
+  EXPECT_FALSE(rb_->has_selection());
+  EXPECT_EQ(3, rb_->num_selected_rows());
+
+  rb_->set_selection(std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 2}));
+  rb_->set_eow(true);
+  EXPECT_TRUE(rb_->has_selection());
+  EXPECT_EQ(3, rb_->num_rows());
+  EXPECT_EQ(2, rb_->num_selected_rows());
+
+  ASSERT_OK_AND_ASSIGN(auto output_rb, rb_->Materialize(arrow::default_memory_pool()));
+  EXPECT_FALSE(output_rb->has_selection());
+  EXPECT_EQ(2, output_rb->num_rows());
+  EXPECT_TRUE(output_rb->eow());
+  EXPECT_EQ("RowBatch(eow=1, eos=0):\n  [\n  true,\n  true\n]\n  [\n  3,\n  5\n]\n  [\n  "
+            "3.3,\n  5.6\n]\n",
+            output_rb->DebugString());
+}
+
+TEST(RowBatchSelectionTest, materialize_dictionary_strings) {
+  RowDescriptor rd({types::DataType::STRING});
+  arrow::Int32Builder codes_builder;
+  for (int32_t code : {1, 0, 1}) {
+    ASSERT_TRUE(codes_builder.Append(code).ok());
+  }
+  std::shared_ptr<arrow::Array> codes;
+  ASSERT_TRUE(codes_builder.Finish(&codes).ok());
+  auto dict =
+      types::ToArrow(std::vector<types::StringValue>{"a", "b"}, arrow::default_memory_pool());
+
+  RowBatch rb(rd, 3);
+  ASSERT_OK(rb.AddColumn(types::MakeDictionaryStringArray(codes, dict)));
+  rb.set_selection(std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{1, 2}));
+
+  ASSERT_OK_AND_ASSIGN(auto output_rb, rb.Materialize(arrow::default_memory_pool()));
+  ASSERT_TRUE(types::IsDictionaryArray(*output_rb->ColumnAt(0)));
+  ASSERT_OK_AND_ASSIGN(auto decoded, types::DecodeDictionaryArray(output_rb->ColumnAt(0),
+                                                                  arrow::default_memory_pool()));
+  auto strings = static_cast<arrow::StringArray*>(decoded.get());
+  ASSERT_EQ(2, strings->length());
+  EXPECT_EQ("a", strings->GetString(0));
+  EXPECT_EQ("b", strings->GetString(1));
+}
+
 TEST_F(RowBatchTest, slice) {
   EXPECT_EQ(3, rb_->num_rows());
 
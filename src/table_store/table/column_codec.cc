@@ -0,0 +1,493 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+#include "src/common/zlib/zlib_wrapper.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+#include "src/table_store/table/column_codec.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+uint64_t ZigZagEncode(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+void AppendVarint(uint64_t v, std::string* out) {
+  while (v >= 0x80) {
+    out->push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  out->push_back(static_cast<char>(v));
+}
+
+// Appends the value of a row if it is selected, and an empty string otherwise, so that only the
+// strings of the selected rows are copied.
+arrow::Status AppendIfSelected(bool selected, std::string_view value,
+                               arrow::StringBuilder* builder) {
+  if (!selected) {
+    value = std::string_view("", 0);
+  }
+  return builder->Append(reinterpret_cast<const uint8_t*>(value.data()),
+                         static_cast<int32_t>(value.size()));
+}
+
+// Reads a varint at *pos and advances *pos past it.
+StatusOr<uint64_t> ReadVarint(std::string_view buf, size_t* pos) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (*pos >= buf.size()) {
+      return error::Internal("Truncated varint in encoded column batch.");
+    }
+    uint8_t byte = static_cast<uint8_t>(buf[(*pos)++]);
+    v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return v;
+    }
+  }
+  return error::Internal("Malformed varint in encoded column batch.");
+}
+
+int64_t PlainBytes(types::DataType data_type, const arrow::Array* arr) {
+  int64_t bytes = 0;
+#define TYPE_CASE(_dt_) bytes = types::GetArrowArrayBytes<_dt_>(arr);
+  PL_SWITCH_FOREACH_DATATYPE(data_type, TYPE_CASE);
+#undef TYPE_CASE
+  return bytes;
+}
+
+std::string_view StringAt(const arrow::StringArray& arr, int64_t i) {
+  int32_t len = 0;
+  const uint8_t* data = arr.GetValue(i, &len);
+  return std::string_view(reinterpret_cast<const char*>(data), len);
+}
+
+size_t StringHash(std::string_view val) { return absl::Hash<std::string_view>()(val); }
+
+}  // namespace
+
+std::shared_ptr<const std::string> StringInterner::Intern(std::string_view val, bool* inserted) {
+  auto& entry = strings_[StringHash(val)];
+  auto str = entry.lock();
+  if (str != nullptr && *str == val) {
+    *inserted = false;
+    return str;
+  }
+  str = std::make_shared<const std::string>(val);
+  entry = str;
+  *inserted = true;
+
+  if (strings_.size() >= sweep_size_) {
+    for (auto it = strings_.begin(); it != strings_.end();) {
+      if (it->second.expired()) {
+        strings_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    sweep_size_ = std::max<size_t>(sweep_size_, 2 * strings_.size());
+  }
+  return str;
+}
+
+bool StringInterner::Recent(std::string_view val) const {
+  size_t hash = StringHash(val);
+  if (prev_batch_hashes_.contains(hash)) {
+    return true;
+  }
+  auto it = strings_.find(hash);
+  return it != strings_.end() && !it->second.expired();
+}
+
+std::unique_ptr<EncodedColumnBatch> EncodedColumnBatch::Encode(
+    types::DataType data_type, const std::shared_ptr<arrow::Array>& arr,
+    StringInterner* interner) {
+  std::unique_ptr<EncodedColumnBatch> encoded;
+  // Null values are never produced by Stirling, but keep such batches untouched to be safe.
+  if (arr->null_count() == 0) {
+    switch (data_type) {
+      case types::DataType::INT64:
+      case types::DataType::TIME64NS:
+        encoded = EncodeDeltaOfDelta(data_type, *arr);
+        break;
+      case types::DataType::STRING:
+        encoded = EncodeString(*arr, interner);
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (encoded == nullptr) {
+    return Plain(data_type, arr);
+  }
+  encoded->zone_ = ColumnZone::FromArrow(data_type, arr.get());
+  encoded->bytes_ = encoded->data_.size();
+  for (const auto& val : encoded->dictionary_) {
+    encoded->bytes_ += val.size();
+  }
+  encoded->bytes_ += encoded->interned_.size() * sizeof(std::shared_ptr<const std::string>) +
+                     encoded->interned_bytes_;
+  int64_t plain_bytes = PlainBytes(data_type, arr.get());
+  // The strings newly interned by a batch are kept for the batches after it, so they don't count
+  // against it here. Otherwise the first batch of repeating values would never be interned.
+  if (encoded->bytes_ - encoded->interned_bytes_ >= plain_bytes) {
+    return Plain(data_type, arr);
+  }
+  return encoded;
+}
+
+std::unique_ptr<EncodedColumnBatch> EncodedColumnBatch::Plain(
+    types::DataType data_type, const std::shared_ptr<arrow::Array>& arr) {
+  auto plain = std::unique_ptr<EncodedColumnBatch>(
+      new EncodedColumnBatch(data_type, ColumnEncoding::kPlain, arr->length()));
+  plain->plain_ = arr;
+  plain->bytes_ = PlainBytes(data_type, arr.get());
+  plain->zone_ = ColumnZone::FromArrow(data_type, arr.get());
+  return plain;
+}
+
+std::unique_ptr<EncodedColumnBatch> EncodedColumnBatch::EncodeDeltaOfDelta(
+    types::DataType data_type, const arrow::Array& arr) {
+  auto encoded = std::unique_ptr<EncodedColumnBatch>(
+      new EncodedColumnBatch(data_type, ColumnEncoding::kDeltaOfDelta, arr.length()));
+  const int64_t* values = static_cast<const arrow::Int64Array&>(arr).raw_values();
+
+  int64_t prev = 0;
+  int64_t prev_delta = 0;
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    // Wrapping arithmetic is intended here; decoding wraps back the same way.
+    int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(values[i]) - prev);
+    int64_t dod = static_cast<int64_t>(static_cast<uint64_t>(delta) - prev_delta);
+    AppendVarint(ZigZagEncode(dod), &encoded->data_);
+    prev = values[i];
+    prev_delta = delta;
+  }
+  encoded->data_.shrink_to_fit();
+  return encoded;
+}
+
+std::unique_ptr<EncodedColumnBatch> EncodedColumnBatch::EncodeString(const arrow::Array& arr,
+                                                                     StringInterner* interner) {
+  const auto& str_arr = static_cast<const arrow::StringArray&>(arr);
+
+  absl::flat_hash_map<std::string_view, uint8_t> codes;
+  bool use_dictionary = true;
+  int64_t raw_bytes = 0;
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    auto val = StringAt(str_arr, i);
+    raw_bytes += val.size();
+    if (use_dictionary && !codes.contains(val)) {
+      if (codes.size() == kMaxDictionarySize) {
+        use_dictionary = false;
+        continue;
+      }
+      codes.emplace(val, static_cast<uint8_t>(codes.size()));
+    }
+  }
+
+  if (use_dictionary) {
+    auto encoded = std::unique_ptr<EncodedColumnBatch>(
+        new EncodedColumnBatch(types::DataType::STRING, ColumnEncoding::kDictionary, arr.length()));
+    encoded->dictionary_.resize(codes.size());
+    for (const auto& [val, code] : codes) {
+      encoded->dictionary_[code] = std::string(val);
+    }
+    encoded->data_.reserve(arr.length());
+    for (int64_t i = 0; i < arr.length(); ++i) {
+      encoded->data_.push_back(static_cast<char>(codes[StringAt(str_arr, i)]));
+    }
+    return encoded;
+  }
+
+  if (interner != nullptr) {
+    auto encoded = EncodeInterned(str_arr, interner);
+    if (encoded != nullptr) {
+      return encoded;
+    }
+  }
+
+  std::string raw;
+  raw.reserve(raw_bytes + arr.length());
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    auto val = StringAt(str_arr, i);
+    AppendVarint(val.size(), &raw);
+    raw.append(val.data(), val.size());
+  }
+  auto compressed = zlib::Deflate(raw);
+  if (!compressed.ok()) {
+    LOG(WARNING) << "Failed to compress column batch: " << compressed.msg();
+    return nullptr;
+  }
+
+  auto encoded = std::unique_ptr<EncodedColumnBatch>(
+      new EncodedColumnBatch(types::DataType::STRING, ColumnEncoding::kDeflate, arr.length()));
+  encoded->data_ = compressed.ConsumeValueOrDie();
+  encoded->raw_bytes_ = raw_bytes;
+  return encoded;
+}
+
+std::unique_ptr<EncodedColumnBatch> EncodedColumnBatch::EncodeInterned(
+    const arrow::StringArray& arr, StringInterner* interner) {
+  absl::flat_hash_set<size_t> hashes;
+  size_t recent = 0;
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    auto val = StringAt(arr, i);
+    if (hashes.insert(StringHash(val)).second && interner->Recent(val)) {
+      ++recent;
+    }
+  }
+  size_t num_distinct = hashes.size();
+  interner->SetPreviousBatch(std::move(hashes));
+  if (recent < kMinInternedFraction * num_distinct) {
+    return nullptr;
+  }
+
+  auto encoded = std::unique_ptr<EncodedColumnBatch>(
+      new EncodedColumnBatch(types::DataType::STRING, ColumnEncoding::kInterned, arr.length()));
+  absl::flat_hash_map<std::string_view, uint32_t> codes;
+  encoded->interned_.reserve(num_distinct);
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    auto val = StringAt(arr, i);
+    auto [it, added] = codes.try_emplace(val, encoded->interned_.size());
+    if (added) {
+      bool inserted = false;
+      encoded->interned_.push_back(interner->Intern(val, &inserted));
+      if (inserted) {
+        encoded->interned_bytes_ += val.size();
+      }
+    }
+    AppendVarint(it->second, &encoded->data_);
+  }
+  encoded->data_.shrink_to_fit();
+  return encoded;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedColumnBatch::Decode(
+    arrow::MemoryPool* mem_pool) const {
+  switch (encoding_) {
+    case ColumnEncoding::kPlain:
+      return plain_;
+    case ColumnEncoding::kDeltaOfDelta:
+      return DecodeDeltaOfDelta(mem_pool);
+    case ColumnEncoding::kDictionary:
+      return DecodeDictionary(mem_pool);
+    case ColumnEncoding::kDeflate:
+      return DecodeDeflate(mem_pool);
+    case ColumnEncoding::kInterned:
+      return DecodeInterned(mem_pool);
+  }
+  return error::Internal("Unknown column encoding.");
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedColumnBatch::DecodeRows(
+    arrow::MemoryPool* mem_pool, const std::vector<bool>& rows) const {
+  if (static_cast<int64_t>(rows.size()) != length_) {
+    return error::InvalidArgument("Got $0 selected rows for a batch of $1 rows.", rows.size(),
+                                  length_);
+  }
+  if (encoding_ != ColumnEncoding::kDictionary && encoding_ != ColumnEncoding::kInterned &&
+      encoding_ != ColumnEncoding::kDeflate) {
+    // The other encodings decode fixed-size values, which cost the same to skip as to copy.
+    return Decode(mem_pool);
+  }
+
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length_));
+  if (encoding_ == ColumnEncoding::kDictionary) {
+    for (int64_t i = 0; i < length_; ++i) {
+      PL_RETURN_IF_ERROR(
+          AppendIfSelected(rows[i], dictionary_[static_cast<uint8_t>(data_[i])], &builder));
+    }
+  } else if (encoding_ == ColumnEncoding::kInterned) {
+    PL_ASSIGN_OR_RETURN(std::vector<uint32_t> codes, InternedCodes());
+    for (int64_t i = 0; i < length_; ++i) {
+      PL_RETURN_IF_ERROR(AppendIfSelected(rows[i], *interned_[codes[i]], &builder));
+    }
+  } else {
+    // The whole batch is inflated, but only the selected strings are copied out of it.
+    PL_ASSIGN_OR_RETURN(std::string raw,
+                        zlib::Inflate(data_, raw_bytes_ + static_cast<size_t>(length_) * 2 + 1));
+    std::string_view buf(raw);
+    size_t pos = 0;
+    for (int64_t i = 0; i < length_; ++i) {
+      PL_ASSIGN_OR_RETURN(uint64_t len, ReadVarint(buf, &pos));
+      if (pos + len > buf.size()) {
+        return error::Internal("Truncated string in encoded column batch.");
+      }
+      PL_RETURN_IF_ERROR(AppendIfSelected(rows[i], buf.substr(pos, len), &builder));
+      pos += len;
+    }
+  }
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedColumnBatch::DecodeDeltaOfDelta(
+    arrow::MemoryPool* mem_pool) const {
+  arrow::Int64Builder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length_));
+
+  size_t pos = 0;
+  int64_t prev = 0;
+  int64_t prev_delta = 0;
+  for (int64_t i = 0; i < length_; ++i) {
+    PL_ASSIGN_OR_RETURN(uint64_t zz, ReadVarint(data_, &pos));
+    int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(prev_delta) +
+                                         static_cast<uint64_t>(ZigZagDecode(zz)));
+    int64_t val = static_cast<int64_t>(static_cast<uint64_t>(prev) + static_cast<uint64_t>(delta));
+    builder.UnsafeAppend(val);
+    prev = val;
+    prev_delta = delta;
+  }
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedColumnBatch::DecodeKeepingDictionary(
+    arrow::MemoryPool* mem_pool) const {
+  if (encoding_ != ColumnEncoding::kDictionary && encoding_ != ColumnEncoding::kInterned) {
+    return Decode(mem_pool);
+  }
+
+  arrow::Int32Builder codes_builder(mem_pool);
+  PL_RETURN_IF_ERROR(codes_builder.Reserve(length_));
+  arrow::StringBuilder values_builder(mem_pool);
+  if (encoding_ == ColumnEncoding::kDictionary) {
+    for (char code : data_) {
+      codes_builder.UnsafeAppend(static_cast<uint8_t>(code));
+    }
+    PL_RETURN_IF_ERROR(values_builder.Reserve(dictionary_.size()));
+    for (const auto& value : dictionary_) {
+      PL_RETURN_IF_ERROR(values_builder.Append(value));
+    }
+  } else {
+    PL_ASSIGN_OR_RETURN(std::vector<uint32_t> interned_codes, InternedCodes());
+    for (uint32_t code : interned_codes) {
+      codes_builder.UnsafeAppend(static_cast<int32_t>(code));
+    }
+    PL_RETURN_IF_ERROR(values_builder.Reserve(interned_.size()));
+    for (const auto& value : interned_) {
+      PL_RETURN_IF_ERROR(values_builder.Append(*value));
+    }
+  }
+  std::shared_ptr<arrow::Array> codes;
+  PL_RETURN_IF_ERROR(codes_builder.Finish(&codes));
+  std::shared_ptr<arrow::Array> values;
+  PL_RETURN_IF_ERROR(values_builder.Finish(&values));
+  return types::MakeDictionaryStringArray(codes, values);
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedColumnBatch::DecodeDictionary(
+    arrow::MemoryPool* mem_pool) const {
+  int64_t total_size = 0;
+  for (char code : data_) {
+    total_size += dictionary_[static_cast<uint8_t>(code)].size();
+  }
+
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length_));
+  PL_RETURN_IF_ERROR(builder.ReserveData(total_size));
+  for (char code : data_) {
+    builder.UnsafeAppend(dictionary_[static_cast<uint8_t>(code)]);
+  }
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedColumnBatch::DecodeDeflate(
+    arrow::MemoryPool* mem_pool) const {
+  PL_ASSIGN_OR_RETURN(std::string raw,
+                      zlib::Inflate(data_, raw_bytes_ + static_cast<size_t>(length_) * 2 + 1));
+
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length_));
+  PL_RETURN_IF_ERROR(builder.ReserveData(raw_bytes_));
+
+  std::string_view buf(raw);
+  size_t pos = 0;
+  for (int64_t i = 0; i < length_; ++i) {
+    PL_ASSIGN_OR_RETURN(uint64_t len, ReadVarint(buf, &pos));
+    if (pos + len > buf.size()) {
+      return error::Internal("Truncated string in encoded column batch.");
+    }
+    builder.UnsafeAppend(reinterpret_cast<const uint8_t*>(buf.data() + pos), len);
+    pos += len;
+  }
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+StatusOr<std::vector<uint32_t>> EncodedColumnBatch::InternedCodes() const {
+  std::vector<uint32_t> codes;
+  codes.reserve(length_);
+  size_t pos = 0;
+  for (int64_t i = 0; i < length_; ++i) {
+    PL_ASSIGN_OR_RETURN(uint64_t code, ReadVarint(data_, &pos));
+    if (code >= interned_.size()) {
+      return error::Internal("Invalid code in interned column batch.");
+    }
+    codes.push_back(static_cast<uint32_t>(code));
+  }
+  return codes;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedColumnBatch::DecodeInterned(
+    arrow::MemoryPool* mem_pool) const {
+  PL_ASSIGN_OR_RETURN(std::vector<uint32_t> codes, InternedCodes());
+  int64_t total_size = 0;
+  for (uint32_t code : codes) {
+    total_size += interned_[code]->size();
+  }
+
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length_));
+  PL_RETURN_IF_ERROR(builder.ReserveData(total_size));
+  for (uint32_t code : codes) {
+    builder.UnsafeAppend(*interned_[code]);
+  }
+
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+}  // namespace table_store
+}  // namespace px
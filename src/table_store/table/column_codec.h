@@ -0,0 +1,198 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace table_store {
+
+enum class ColumnEncoding {
+  // The arrow array is kept as-is.
+  kPlain,
+  // Integer columns: zigzag varints of the second order differences. Works best on time_.
+  kDeltaOfDelta,
+  // String columns with few distinct values: a dictionary plus one code per row.
+  kDictionary,
+  // String columns with many distinct values: length-prefixed values, gzipped.
+  kDeflate,
+  // String columns whose values repeat across batches: one varint code per row into a batch-local
+  // dictionary of strings shared, through a StringInterner, with the other batches of the column.
+  kInterned,
+};
+
+/**
+ * A StringInterner deduplicates the strings of one column across its cold batches, for values
+ * that repeat from batch to batch but are too many per batch for kDictionary (e.g. the stack
+ * traces of the profiler, sampled again every profiling period).
+ *
+ * The interner only holds weak references: a string is freed once the last batch using it
+ * expires. Not thread-safe; one interner must only be used by one encoder at a time.
+ */
+class StringInterner {
+ public:
+  /**
+   * @return the shared copy of val. *inserted is set if no live copy existed yet.
+   */
+  std::shared_ptr<const std::string> Intern(std::string_view val, bool* inserted);
+
+  /**
+   * @return whether val has a live copy in the interner, or was seen in the previous batch.
+   */
+  bool Recent(std::string_view val) const;
+
+  /**
+   * Records the distinct values of the batch being encoded, to be checked by Recent() for the
+   * next batch. This is what lets a column switch to kInterned once its values start repeating.
+   */
+  void SetPreviousBatch(absl::flat_hash_set<size_t> hashes) {
+    prev_batch_hashes_ = std::move(hashes);
+  }
+
+  /**
+   * @return the number of entries in the interner, including expired ones not yet swept.
+   */
+  size_t size() const { return strings_.size(); }
+
+ private:
+  // Entries are keyed by hash so that expired strings don't leave dangling keys. A collision
+  // just replaces the older entry, which only costs a duplicate copy.
+  absl::flat_hash_map<size_t, std::weak_ptr<const std::string>> strings_;
+  absl::flat_hash_set<size_t> prev_batch_hashes_;
+  // Expired entries are swept once the map doubles in size since the last sweep.
+  size_t sweep_size_ = 1024;
+};
+
+/**
+ * An EncodedColumnBatch is the compressed form of a single column batch in the cold tier.
+ * Encode() picks the smallest encoding available for the data type, and falls back to kPlain
+ * when no encoding beats the original arrow array.
+ */
+class EncodedColumnBatch {
+ public:
+  // Maximum number of distinct strings for the dictionary encoding. Codes are one byte wide.
+  static constexpr size_t kMaxDictionarySize = 256;
+
+  // Minimum fraction of the distinct strings of a batch that must have been seen recently by the
+  // interner for kInterned to be used over kDeflate.
+  static constexpr double kMinInternedFraction = 0.5;
+
+  /**
+   * Encodes arr. If an interner is given, string batches with too many distinct values for
+   * kDictionary share their values with the other batches encoded with the same interner.
+   */
+  static std::unique_ptr<EncodedColumnBatch> Encode(types::DataType data_type,
+                                                    const std::shared_ptr<arrow::Array>& arr,
+                                                    StringInterner* interner = nullptr);
+
+  /**
+   * Wraps the arrow array without encoding it.
+   */
+  static std::unique_ptr<EncodedColumnBatch> Plain(types::DataType data_type,
+                                                   const std::shared_ptr<arrow::Array>& arr);
+
+  /**
+   * Rebuilds the arrow array from the encoded data.
+   */
+  StatusOr<std::shared_ptr<arrow::Array>> Decode(arrow::MemoryPool* mem_pool) const;
+
+  /**
+   * Same as Decode(), but kDictionary and kInterned batches are returned as a dictionary-encoded
+   * arrow array (see types::IsDictionaryArray) instead of being expanded into one string per row.
+   */
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeKeepingDictionary(
+      arrow::MemoryPool* mem_pool) const;
+
+  /**
+   * Same as Decode(), but only the string values of the rows set in rows, which has one entry per
+   * row of the batch, are copied. The other rows are left empty, so they must not be read.
+   */
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeRows(arrow::MemoryPool* mem_pool,
+                                                     const std::vector<bool>& rows) const;
+
+  types::DataType data_type() const { return data_type_; }
+  ColumnEncoding encoding() const { return encoding_; }
+  int64_t length() const { return length_; }
+
+  /**
+   * @return the number of bytes held by the encoded representation. For kInterned, only the
+   * strings first interned by this batch are counted, so the bytes of shared strings are only
+   * accounted for once even though they outlive the batch that counted them when other batches
+   * still use them.
+   */
+  int64_t Bytes() const { return bytes_; }
+
+  /**
+   * @return the zone map of the batch, computed once when the batch was encoded.
+   */
+  const ColumnZone& zone() const { return zone_; }
+
+ private:
+  EncodedColumnBatch(types::DataType data_type, ColumnEncoding encoding, int64_t length)
+      : data_type_(data_type), encoding_(encoding), length_(length) {}
+
+  static std::unique_ptr<EncodedColumnBatch> EncodeDeltaOfDelta(types::DataType data_type,
+                                                                const arrow::Array& arr);
+  static std::unique_ptr<EncodedColumnBatch> EncodeString(const arrow::Array& arr,
+                                                          StringInterner* interner);
+  static std::unique_ptr<EncodedColumnBatch> EncodeInterned(const arrow::StringArray& arr,
+                                                            StringInterner* interner);
+
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeDeltaOfDelta(arrow::MemoryPool* mem_pool) const;
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeDictionary(arrow::MemoryPool* mem_pool) const;
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeDeflate(arrow::MemoryPool* mem_pool) const;
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeInterned(arrow::MemoryPool* mem_pool) const;
+  StatusOr<std::vector<uint32_t>> InternedCodes() const;
+
+  types::DataType data_type_;
+  ColumnEncoding encoding_;
+  int64_t length_;
+  int64_t bytes_ = 0;
+  ColumnZone zone_;
+
+  // kPlain only.
+  std::shared_ptr<arrow::Array> plain_;
+  // Varints for kDeltaOfDelta, one code per row for kDictionary, gzipped values for kDeflate,
+  // one varint code per row for kInterned.
+  std::string data_;
+  // kDictionary only.
+  std::vector<std::string> dictionary_;
+  // kInterned only.
+  std::vector<std::shared_ptr<const std::string>> interned_;
+  // kInterned only: the bytes of the strings this batch added to the interner.
+  int64_t interned_bytes_ = 0;
+  // kDeflate only: the number of bytes once inflated, used to size the decode buffers.
+  int64_t raw_bytes_ = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/column_codec.h"
+
+namespace px {
+namespace table_store {
+
+TEST(EncodedColumnBatchTest, delta_of_delta_time) {
+  std::vector<types::Time64NSValue> times;
+  for (int64_t i = 0; i < 1000; ++i) {
+    // Roughly periodic timestamps with some jitter.
+    times.push_back(1600000000000000000 + i * 100000000 + (i % 7) * 13);
+  }
+  auto arr = types::ToArrow(times, arrow::default_memory_pool());
+
+  auto encoded = EncodedColumnBatch::Encode(types::DataType::TIME64NS, arr);
+  EXPECT_EQ(encoded->encoding(), ColumnEncoding::kDeltaOfDelta);
+  EXPECT_EQ(encoded->length(), 1000);
+  EXPECT_LT(encoded->Bytes(), 1000 * static_cast<int64_t>(sizeof(int64_t)) / 3);
+
+  ASSERT_OK_AND_ASSIGN(auto decoded, encoded->Decode(arrow::default_memory_pool()));
+  EXPECT_TRUE(decoded->Equals(arr));
+}
+
+TEST(EncodedColumnBatchTest, delta_of_delta_extremes) {
+  std::vector<types::Int64Value> vals = {std::numeric_limits<int64_t>::max(),
+                                         std::numeric_limits<int64_t>::min(), 0, -1, 1,
+                                         std::numeric_limits<int64_t>::max()};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  // Falls back to plain since nothing is gained, but must still round trip.
+  auto encoded = EncodedColumnBatch::Encode(types::DataType::INT64, arr);
+  ASSERT_OK_AND_ASSIGN(auto decoded, encoded->Decode(arrow::default_memory_pool()));
+  EXPECT_TRUE(decoded->Equals(arr));
+}
+
+TEST(EncodedColumnBatchTest, dictionary_strings) {
+  std::vector<types::StringValue> methods;
+  for (int i = 0; i < 500; ++i) {
+    methods.push_back(i % 3 == 0 ? "GET" : (i % 3 == 1 ? "POST" : "DELETE"));
+  }
+  auto arr = types::ToArrow(methods, arrow::default_memory_pool());
+
+  auto encoded = EncodedColumnBatch::Encode(types::DataType::STRING, arr);
+  EXPECT_EQ(encoded->encoding(), ColumnEncoding::kDictionary);
+  EXPECT_EQ(encoded->Bytes(), 500 + 3 + 4 + 6);
+
+  ASSERT_OK_AND_ASSIGN(auto decoded, encoded->Decode(arrow::default_memory_pool()));
+  EXPECT_TRUE(decoded->Equals(arr));
+
+  ASSERT_OK_AND_ASSIGN(auto dict_arr,
+                       encoded->DecodeKeepingDictionary(arrow::default_memory_pool()));
+  ASSERT_TRUE(types::IsDictionaryArray(*dict_arr));
+  EXPECT_EQ(3, static_cast<arrow::DictionaryArray*>(dict_arr.get())->dictionary()->length());
+  ASSERT_OK_AND_ASSIGN(decoded,
+                       types::DecodeDictionaryArray(dict_arr, arrow::default_memory_pool()));
+  EXPECT_TRUE(decoded->Equals(arr));
+}
+
+TEST(EncodedColumnBatchTest, deflate_strings) {
+  std::vector<types::StringValue> bodies;
+  for (int i = 0; i < 500; ++i) {
+    bodies.push_back(
+        absl::StrCat("{\"id\": ", i, ", \"status\": \"ok\", \"payload\": \"abcdef\"}"));
+  }
+  auto arr = types::ToArrow(bodies, arrow::default_memory_pool());
+
+  auto encoded = EncodedColumnBatch::Encode(types::DataType::STRING, arr);
+  EXPECT_EQ(encoded->encoding(), ColumnEncoding::kDeflate);
+  EXPECT_LT(encoded->Bytes(), types::GetArrowArrayBytes<types::DataType::STRING>(arr.get()) / 3);
+
+  ASSERT_OK_AND_ASSIGN(auto decoded, encoded->Decode(arrow::default_memory_pool()));
+  EXPECT_TRUE(decoded->Equals(arr));
+}
+
+TEST(EncodedColumnBatchTest, interned_strings) {
+  std::vector<types::StringValue> stacks;
+  for (int i = 0; i < 500; ++i) {
+    stacks.push_back(absl::StrCat("main;run;handle_request;parse_", i, ";malloc"));
+  }
+  auto arr = types::ToArrow(stacks, arrow::default_memory_pool());
+
+  StringInterner interner;
+  // Nothing repeats yet, so the first batch is deflated.
+  auto first = EncodedColumnBatch::Encode(types::DataType::STRING, arr, &interner);
+  EXPECT_EQ(first->encoding(), ColumnEncoding::kDeflate);
+
+  // The values of the second batch were in the first one: they get interned.
+  auto second = EncodedColumnBatch::Encode(types::DataType::STRING, arr, &interner);
+  ASSERT_EQ(second->encoding(), ColumnEncoding::kInterned);
+  EXPECT_EQ(500, interner.size());
+
+  // The third batch shares the strings of the second one, and only pays for its codes.
+  auto third = EncodedColumnBatch::Encode(types::DataType::STRING, arr, &interner);
+  ASSERT_EQ(third->encoding(), ColumnEncoding::kInterned);
+  EXPECT_LT(third->Bytes(), second->Bytes());
+  EXPECT_LT(third->Bytes(),
+            500 * static_cast<int64_t>(2 + sizeof(std::shared_ptr<const std::string>)));
+
+  ASSERT_OK_AND_ASSIGN(auto decoded, third->Decode(arrow::default_memory_pool()));
+  EXPECT_TRUE(decoded->Equals(arr));
+  ASSERT_OK_AND_ASSIGN(auto dict_arr, third->DecodeKeepingDictionary(arrow::default_memory_pool()));
+  ASSERT_TRUE(types::IsDictionaryArray(*dict_arr));
+  EXPECT_EQ(500, static_cast<arrow::DictionaryArray*>(dict_arr.get())->dictionary()->length());
+  ASSERT_OK_AND_ASSIGN(decoded,
+                       types::DecodeDictionaryArray(dict_arr, arrow::default_memory_pool()));
+  EXPECT_TRUE(decoded->Equals(arr));
+
+  // Once the batches using them are gone, the strings are freed and have to be copied again.
+  int64_t third_bytes = third->Bytes();
+  second.reset();
+  third.reset();
+  auto fourth = EncodedColumnBatch::Encode(types::DataType::STRING, arr, &interner);
+  ASSERT_EQ(fourth->encoding(), ColumnEncoding::kInterned);
+  EXPECT_GT(fourth->Bytes(), third_bytes);
+}
+
+TEST(EncodedColumnBatchTest, decode_rows) {
+  std::vector<types::StringValue> methods;
+  std::vector<types::StringValue> bodies;
+  for (int i = 0; i < 500; ++i) {
+    methods.push_back(i % 2 == 0 ? "GET" : "POST");
+    bodies.push_back(absl::StrCat("{\"id\": ", i, ", \"status\": \"ok\"}"));
+  }
+  auto methods_arr = types::ToArrow(methods, arrow::default_memory_pool());
+  auto bodies_arr = types::ToArrow(bodies, arrow::default_memory_pool());
+  StringInterner interner;
+  auto deflated = EncodedColumnBatch::Encode(types::DataType::STRING, bodies_arr, &interner);
+  auto interned = EncodedColumnBatch::Encode(types::DataType::STRING, bodies_arr, &interner);
+  auto dictionary = EncodedColumnBatch::Encode(types::DataType::STRING, methods_arr);
+  ASSERT_EQ(deflated->encoding(), ColumnEncoding::kDeflate);
+  ASSERT_EQ(interned->encoding(), ColumnEncoding::kInterned);
+  ASSERT_EQ(dictionary->encoding(), ColumnEncoding::kDictionary);
+
+  // Every third row is selected, the others are left empty.
+  std::vector<bool> rows(500);
+  for (int i = 0; i < 500; i += 3) {
+    rows[i] = true;
+  }
+  for (const auto& [encoded, arr] : {std::make_pair(deflated.get(), bodies_arr),
+                                     std::make_pair(interned.get(), bodies_arr),
+                                     std::make_pair(dictionary.get(), methods_arr)}) {
+    ASSERT_OK_AND_ASSIGN(auto decoded, encoded->DecodeRows(arrow::default_memory_pool(), rows));
+    ASSERT_EQ(decoded->length(), 500);
+    auto decoded_strings = static_cast<arrow::StringArray*>(decoded.get());
+    auto strings = static_cast<arrow::StringArray*>(arr.get());
+    for (int i = 0; i < 500; ++i) {
+      EXPECT_EQ(decoded_strings->GetString(i), rows[i] ? strings->GetString(i) : "");
+    }
+  }
+
+  EXPECT_NOT_OK(dictionary->DecodeRows(arrow::default_memory_pool(), std::vector<bool>(3)));
+}
+
+TEST(EncodedColumnBatchTest, plain_fallback) {
+  std::vector<types::Float64Value> vals = {0.5, 1.2, 5.3};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  auto encoded = EncodedColumnBatch::Encode(types::DataType::FLOAT64, arr);
+  EXPECT_EQ(encoded->encoding(), ColumnEncoding::kPlain);
+  EXPECT_EQ(encoded->Bytes(), 3 * static_cast<int64_t>(sizeof(double)));
+
+  ASSERT_OK_AND_ASSIGN(auto decoded, encoded->Decode(arrow::default_memory_pool()));
+  EXPECT_EQ(decoded, arr);
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/memory_budget.h"
+
+#include "src/table_store/table/table.h"
+
+namespace px {
+namespace table_store {
+
+void MemoryBudget::AddTable(Table* table, const MemoryShare& share) {
+  DCHECK_GT(share.weight, 0);
+  absl::MutexLock lock(&mu_);
+  shares_[table] = share;
+}
+
+void MemoryBudget::RemoveTable(Table* table) {
+  absl::MutexLock lock(&mu_);
+  shares_.erase(table);
+}
+
+int64_t MemoryBudget::NumBytes() const {
+  absl::ReaderMutexLock lock(&mu_);
+  return NumBytesLocked();
+}
+
+int64_t MemoryBudget::NumBytesLocked() const {
+  int64_t bytes = 0;
+  for (const auto& [table, share] : shares_) {
+    bytes += table->NumBytes();
+  }
+  return bytes;
+}
+
+Table* MemoryBudget::PickVictimLocked(Table* requester) const {
+  Table* victim = nullptr;
+  double victim_excess = 0;
+  for (const auto& [table, share] : shares_) {
+    double excess = (table->NumBytes() - share.min_bytes) / share.weight;
+    if (excess > victim_excess && table->NumBatches() > 0) {
+      victim = table;
+      victim_excess = excess;
+    }
+  }
+  if (victim == nullptr && requester->NumBatches() > 0) {
+    return requester;
+  }
+  return victim;
+}
+
+Status MemoryBudget::Reserve(Table* table, int64_t bytes) {
+  if (bytes > max_bytes_) {
+    return error::InvalidArgument("RowBatch size ($0) is bigger than the memory budget ($1).",
+                                  bytes, max_bytes_);
+  }
+  // Other tables may be appended to while this evicts, so the total is summed up again each time.
+  absl::MutexLock lock(&mu_);
+  while (NumBytesLocked() + bytes > max_bytes_) {
+    Table* victim = PickVictimLocked(table);
+    if (victim == nullptr) {
+      // Nothing is left to evict, e.g. when the bytes are held by batches still being added.
+      break;
+    }
+    PL_RETURN_IF_ERROR(victim->DeleteNextRowBatch());
+  }
+  return Status::OK();
+}
+
+}  // namespace table_store
+}  // namespace px
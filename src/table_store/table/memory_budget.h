@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace table_store {
+
+class Table;
+
+// The share of a MemoryBudget that a table gets.
+struct MemoryShare {
+  // The relative share of the table, greater than zero.
+  double weight = 1.0;
+  // The bytes the table keeps however much the other tables need.
+  int64_t min_bytes = 0;
+};
+
+/**
+ * MemoryBudget bounds the bytes held by a set of tables together, e.g. all the tables of an
+ * agent, instead of bounding each table on its own. A table that fills up evicts the oldest
+ * batches of whichever table holds the most above its share, so a bursty table can use the
+ * budget that quiet tables leave unused.
+ *
+ * Each table has a weight and a number of bytes it always gets to keep. Beyond those, the tables
+ * share the budget in proportion to their weights: the table with the most bytes above its
+ * minimum per unit of weight is evicted from first. When all the tables are at their minimum, a
+ * table makes room by evicting its own batches.
+ *
+ * The budget is thread-safe. The tables it holds must be removed before they are destroyed,
+ * which Table does when it has joined the budget (see Table::JoinMemoryBudget()).
+ */
+class MemoryBudget : public NotCopyable {
+ public:
+  explicit MemoryBudget(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  void AddTable(Table* table, const MemoryShare& share);
+  void RemoveTable(Table* table);
+
+  /**
+   * Makes room in the budget for the given number of bytes about to be added to the table, by
+   * evicting batches from the tables. Called by the table before adding them.
+   */
+  Status Reserve(Table* table, int64_t bytes);
+
+  int64_t max_bytes() const { return max_bytes_; }
+
+  /**
+   * @return the bytes held by all the tables of the budget.
+   */
+  int64_t NumBytes() const;
+
+ private:
+  int64_t NumBytesLocked() const ABSL_SHARED_LOCKS_REQUIRED(mu_);
+  // Returns the table to evict the next batch from, or nullptr if none can be.
+  Table* PickVictimLocked(Table* requester) const ABSL_SHARED_LOCKS_REQUIRED(mu_);
+
+  const int64_t max_bytes_;
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<Table*, MemoryShare> shares_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/memory_budget.h"
+#include "src/table_store/table/table.h"
+#include "src/table_store/table/table_store.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+const schema::Relation kRelation({types::DataType::INT64}, {"col1"});
+
+// Writes a batch of two INT64s, which takes 16 bytes.
+void WriteBatch(Table* table) {
+  schema::RowBatch rb(schema::RowDescriptor(kRelation.col_types()), 2);
+  std::vector<types::Int64Value> col1 = {1, 2};
+  EXPECT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+  EXPECT_OK(table->WriteRowBatch(rb));
+}
+
+}  // namespace
+
+TEST(MemoryBudgetTest, bursty_table_uses_unused_budget) {
+  auto budget = std::make_shared<MemoryBudget>(80);
+  auto quiet = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  auto bursty = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  quiet->JoinMemoryBudget(budget, MemoryShare{});
+  bursty->JoinMemoryBudget(budget, MemoryShare{});
+
+  WriteBatch(quiet.get());
+  for (int i = 0; i < 10; ++i) {
+    WriteBatch(bursty.get());
+  }
+  // The bursty table holds more than half of the budget, and evicts its own history once the
+  // quiet table holds less than it.
+  EXPECT_EQ(quiet->NumBytes(), 16);
+  EXPECT_EQ(bursty->NumBytes(), 64);
+  EXPECT_EQ(budget->NumBytes(), 80);
+}
+
+TEST(MemoryBudgetTest, evicts_table_most_over_its_share) {
+  auto budget = std::make_shared<MemoryBudget>(64);
+  auto light = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  auto heavy = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  light->JoinMemoryBudget(budget, MemoryShare{});
+  heavy->JoinMemoryBudget(budget, MemoryShare{/* weight */ 3.0, /* min_bytes */ 0});
+
+  for (int i = 0; i < 2; ++i) {
+    WriteBatch(light.get());
+    WriteBatch(heavy.get());
+  }
+  // The light table has 32 bytes for its weight and the heavy one about 11, so the light one is
+  // evicted from.
+  WriteBatch(heavy.get());
+  EXPECT_EQ(light->NumBytes(), 16);
+  EXPECT_EQ(heavy->NumBytes(), 48);
+}
+
+TEST(MemoryBudgetTest, keeps_min_bytes) {
+  auto budget = std::make_shared<MemoryBudget>(64);
+  auto kept = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  auto other = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  kept->JoinMemoryBudget(budget, MemoryShare{/* weight */ 1.0, /* min_bytes */ 32});
+  other->JoinMemoryBudget(budget, MemoryShare{});
+
+  WriteBatch(kept.get());
+  WriteBatch(kept.get());
+  for (int i = 0; i < 10; ++i) {
+    WriteBatch(other.get());
+  }
+  EXPECT_EQ(kept->NumBytes(), 32);
+  EXPECT_EQ(other->NumBytes(), 32);
+}
+
+TEST(MemoryBudgetTest, batch_bigger_than_budget) {
+  auto budget = std::make_shared<MemoryBudget>(8);
+  auto table = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  table->JoinMemoryBudget(budget, MemoryShare{});
+
+  schema::RowBatch rb(schema::RowDescriptor(kRelation.col_types()), 2);
+  std::vector<types::Int64Value> col1 = {1, 2};
+  ASSERT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+  EXPECT_NOT_OK(table->WriteRowBatch(rb));
+}
+
+TEST(MemoryBudgetTest, destroyed_table_leaves_budget) {
+  auto budget = std::make_shared<MemoryBudget>(64);
+  {
+    auto table = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+    table->JoinMemoryBudget(budget, MemoryShare{});
+    WriteBatch(table.get());
+    EXPECT_EQ(budget->NumBytes(), 16);
+  }
+  EXPECT_EQ(budget->NumBytes(), 0);
+}
+
+TEST(MemoryBudgetTest, table_store_tables) {
+  TableStore table_store(/* memory_budget_bytes */ 48);
+  ASSERT_NE(table_store.memory_budget(), nullptr);
+  auto shared = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  auto unbudgeted = std::make_shared<Table>(kRelation, /* max_table_size */ -1);
+  std::vector<TableStore::TableEntry> tables;
+  tables.push_back({shared, "shared", 1, MemoryShare{}});
+  tables.push_back({unbudgeted, "unbudgeted", 2});
+  table_store.AddTables(std::move(tables));
+
+  for (int i = 0; i < 5; ++i) {
+    WriteBatch(shared.get());
+    WriteBatch(unbudgeted.get());
+  }
+  EXPECT_EQ(shared->NumBytes(), 48);
+  EXPECT_EQ(unbudgeted->NumBytes(), 80);
+  EXPECT_EQ(table_store.memory_budget()->NumBytes(), 48);
+
+  // New tablets of the table share the budget too.
+  auto record_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto col = std::make_shared<types::Int64ValueColumnWrapper>(2);
+  record_batch->push_back(col);
+  ASSERT_OK(table_store.AppendData(1, "tablet", std::move(record_batch)));
+  EXPECT_EQ(table_store.memory_budget()->NumBytes(), 48);
+  EXPECT_EQ(shared->NumBytes(), 32);
+
+  EXPECT_EQ(TableStore().memory_budget(), nullptr);
+}
+
+}  // namespace table_store
+}  // namespace px
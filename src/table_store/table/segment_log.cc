@@ -0,0 +1,410 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/segment_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+
+#include "src/common/fs/fs_wrapper.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace table_store {
+
+using types::DataType;
+
+namespace {
+
+constexpr uint32_t kRecordMagic = 0x504c5347;  // "PLSG"
+constexpr char kSegmentExtension[] = ".seg";
+// All the headers and buffers start at this alignment, which is enough for any column type.
+constexpr int64_t kAlignment = 16;
+
+struct RecordHeader {
+  uint32_t magic;
+  uint32_t num_columns;
+  int64_t num_rows;
+  // The size of the whole record, including this header.
+  int64_t size;
+  int64_t reserved;
+};
+
+struct ColumnHeader {
+  int32_t data_type;
+  // For boolean columns, the index of the bit in data that holds the first value.
+  int32_t bit_offset;
+  int64_t data_size;
+  // For string columns, the size of the int32 offsets, which come before the data.
+  int64_t offsets_size;
+  int64_t reserved;
+};
+
+static_assert(sizeof(RecordHeader) % kAlignment == 0);
+static_assert(sizeof(ColumnHeader) % kAlignment == 0);
+
+int64_t AlignUp(int64_t size) { return (size + kAlignment - 1) / kAlignment * kAlignment; }
+
+// A read-only mapping of a segment file. The recovered arrays hold a reference to it, so it stays
+// mapped until the last of them is freed, even if the file itself is expired.
+class MappedSegment {
+ public:
+  MappedSegment(const uint8_t* data, int64_t size) : data_(data), size_(size) {}
+  ~MappedSegment() { munmap(const_cast<uint8_t*>(data_), size_); }
+
+  const uint8_t* data() const { return data_; }
+  int64_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_;
+  int64_t size_;
+};
+
+class MappedBuffer : public arrow::Buffer {
+ public:
+  MappedBuffer(std::shared_ptr<const MappedSegment> segment, const uint8_t* data, int64_t size)
+      : arrow::Buffer(data, size), segment_(std::move(segment)) {}
+
+ private:
+  std::shared_ptr<const MappedSegment> segment_;
+};
+
+// Checks that the buffers of a column hold num_rows values, so the arrays built on top of them
+// don't read past their end.
+bool ValidColumn(const ColumnHeader& col, const uint8_t* offsets, int64_t num_rows) {
+  auto data_type = static_cast<DataType>(col.data_type);
+  switch (data_type) {
+    case DataType::BOOLEAN:
+      return col.offsets_size == 0 && col.bit_offset >= 0 && col.bit_offset < 8 &&
+             col.data_size >= (col.bit_offset + num_rows + 7) / 8;
+    case DataType::STRING: {
+      if (col.offsets_size != (num_rows + 1) * static_cast<int64_t>(sizeof(int32_t))) {
+        return false;
+      }
+      const auto* string_offsets = reinterpret_cast<const int32_t*>(offsets);
+      return string_offsets[0] == 0 && string_offsets[num_rows] == col.data_size;
+    }
+    case DataType::INT64:
+    case DataType::UINT128:
+    case DataType::TIME64NS:
+    case DataType::FLOAT64:
+      return col.offsets_size == 0 &&
+             col.data_size == num_rows * types::ArrowTypeToBytes(types::ToArrowType(data_type));
+    default:
+      return false;
+  }
+}
+
+// The parts of a column that are written to a record.
+struct ColumnBuffers {
+  ColumnHeader header = {};
+  const uint8_t* data = nullptr;
+  std::vector<int32_t> offsets;
+};
+
+ColumnBuffers GetColumnBuffers(DataType data_type, const arrow::Array& arr) {
+  ColumnBuffers col;
+  col.header.data_type = static_cast<int32_t>(data_type);
+  int64_t length = arr.length();
+  switch (data_type) {
+    case DataType::BOOLEAN:
+      col.data = arr.data()->buffers[1]->data() + arr.offset() / 8;
+      col.header.bit_offset = arr.offset() % 8;
+      col.header.data_size = (col.header.bit_offset + length + 7) / 8;
+      break;
+    case DataType::STRING: {
+      const auto& str_arr = static_cast<const arrow::StringArray&>(arr);
+      const int32_t* offsets = str_arr.raw_value_offsets();
+      int32_t first = offsets[0];
+      col.data = str_arr.value_data()->data() + first;
+      col.header.data_size = offsets[length] - first;
+      // Only the characters of the array are written, so the offsets are rebased on its first
+      // value.
+      col.offsets.resize(length + 1);
+      for (int64_t i = 0; i <= length; ++i) {
+        col.offsets[i] = offsets[i] - first;
+      }
+      col.header.offsets_size = col.offsets.size() * sizeof(int32_t);
+      break;
+    }
+    default: {
+      int64_t width = types::ArrowTypeToBytes(types::ToArrowType(data_type));
+      col.data = arr.data()->buffers[1]->data() + arr.offset() * width;
+      col.header.data_size = length * width;
+      break;
+    }
+  }
+  return col;
+}
+
+StatusOr<int64_t> ParseSegmentId(const std::filesystem::path& path) {
+  int64_t id = 0;
+  if (path.extension() != kSegmentExtension || !absl::SimpleAtoi(path.stem().string(), &id)) {
+    return error::InvalidArgument("$0 is not a segment file", path.string());
+  }
+  return id;
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<SegmentLog>> SegmentLog::Open(const std::filesystem::path& dir,
+                                                       std::vector<DataType> types,
+                                                       int64_t max_segment_bytes,
+                                                       std::vector<Batch>* recovered) {
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(dir));
+  std::unique_ptr<SegmentLog> log(new SegmentLog(dir, std::move(types), max_segment_bytes));
+
+  std::vector<std::pair<int64_t, std::filesystem::path>> segment_paths;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+    auto id_or = ParseSegmentId(entry.path());
+    if (id_or.ok()) {
+      segment_paths.emplace_back(id_or.ConsumeValueOrDie(), entry.path());
+    }
+  }
+  if (ec) {
+    return error::Internal("Failed to list segments in $0 ($1)", dir.string(), ec.message());
+  }
+  std::sort(segment_paths.begin(), segment_paths.end());
+
+  {
+    absl::MutexLock lock(&log->mu_);
+    for (const auto& [id, path] : segment_paths) {
+      log->next_segment_id_ = id + 1;
+      PL_ASSIGN_OR_RETURN(int64_t bytes, log->RecoverSegment(path, recovered));
+      if (bytes == 0) {
+        LOG(WARNING) << absl::Substitute("Removing unusable table segment $0", path.string());
+        PL_RETURN_IF_ERROR(fs::Remove(path));
+        continue;
+      }
+      log->segments_.push_back({path, bytes});
+      log->bytes_ += bytes;
+    }
+  }
+  return log;
+}
+
+SegmentLog::~SegmentLog() {
+  absl::MutexLock lock(&mu_);
+  if (f_ != nullptr) {
+    fclose(f_);
+  }
+}
+
+StatusOr<int64_t> SegmentLog::RecoverSegment(const std::filesystem::path& path,
+                                             std::vector<Batch>* recovered) {
+  int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open $0 ($1)", path.string(), std::strerror(errno));
+  }
+  DEFER(close(fd));
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return error::Internal("Failed to stat $0 ($1)", path.string(), std::strerror(errno));
+  }
+  if (st.st_size == 0) {
+    return int64_t{0};
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    return error::Internal("Failed to mmap $0 ($1)", path.string(), std::strerror(errno));
+  }
+  auto segment = std::make_shared<const MappedSegment>(static_cast<const uint8_t*>(data),
+                                                       st.st_size);
+
+  int64_t pos = 0;
+  std::vector<Batch> batches;
+  while (pos + static_cast<int64_t>(sizeof(RecordHeader)) <= segment->size()) {
+    const uint8_t* record = segment->data() + pos;
+    RecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    int64_t columns_end =
+        sizeof(RecordHeader) + static_cast<int64_t>(header.num_columns) * sizeof(ColumnHeader);
+    if (header.magic != kRecordMagic || header.num_rows < 0 || header.size % kAlignment != 0 ||
+        header.size < columns_end || header.size > segment->size() - pos) {
+      break;
+    }
+    if (header.num_columns != types_.size()) {
+      return int64_t{0};
+    }
+
+    Batch batch;
+    bool valid = true;
+    int64_t buffer_pos = columns_end;
+    for (size_t i = 0; i < types_.size(); ++i) {
+      ColumnHeader col;
+      std::memcpy(&col, record + sizeof(RecordHeader) + i * sizeof(ColumnHeader), sizeof(col));
+      if (static_cast<DataType>(col.data_type) != types_[i]) {
+        return int64_t{0};
+      }
+      if (col.data_size < 0 || col.offsets_size < 0 ||
+          buffer_pos + AlignUp(col.offsets_size) + AlignUp(col.data_size) > header.size) {
+        valid = false;
+        break;
+      }
+      const uint8_t* offsets = record + buffer_pos;
+      const uint8_t* values = offsets + AlignUp(col.offsets_size);
+      buffer_pos += AlignUp(col.offsets_size) + AlignUp(col.data_size);
+      if (!ValidColumn(col, offsets, header.num_rows)) {
+        valid = false;
+        break;
+      }
+
+      // Pixie columns don't have nulls, so there is no validity bitmap.
+      std::vector<std::shared_ptr<arrow::Buffer>> buffers = {nullptr};
+      if (types_[i] == DataType::STRING) {
+        buffers.push_back(std::make_shared<MappedBuffer>(segment, offsets, col.offsets_size));
+      }
+      buffers.push_back(std::make_shared<MappedBuffer>(segment, values, col.data_size));
+      batch.push_back(arrow::MakeArray(arrow::ArrayData::Make(
+          types::DataTypeToArrowType(types_[i]), header.num_rows, std::move(buffers),
+          /* null_count */ 0, /* offset */ col.bit_offset)));
+    }
+    if (!valid) {
+      break;
+    }
+    if (header.num_rows > 0) {
+      batches.push_back(std::move(batch));
+    }
+    pos += header.size;
+  }
+
+  if (pos < segment->size()) {
+    // The rest of the segment is a record that was cut short, drop it so that the ones appended
+    // after it aren't hidden. Only the dropped pages go beyond the end of the truncated file, and
+    // none of the recovered arrays point into them.
+    LOG(WARNING) << absl::Substitute("Dropping $0 bytes of incomplete records from $1",
+                                     segment->size() - pos, path.string());
+    if (ftruncate(fd, pos) != 0) {
+      return error::Internal("Failed to truncate $0 ($1)", path.string(), std::strerror(errno));
+    }
+  }
+  std::move(batches.begin(), batches.end(), std::back_inserter(*recovered));
+  return pos;
+}
+
+Status SegmentLog::StartSegment() {
+  auto path = dir_ / absl::StrFormat("%012d%s", next_segment_id_, kSegmentExtension);
+  f_ = fopen(path.c_str(), "wbe");
+  if (f_ == nullptr) {
+    return error::Internal("Failed to create segment $0 ($1)", path.string(),
+                           std::strerror(errno));
+  }
+  ++next_segment_id_;
+  segments_.push_back({path, 0});
+  return Status::OK();
+}
+
+Status SegmentLog::CloseSegment() {
+  std::FILE* f = f_;
+  f_ = nullptr;
+  if (fclose(f) != 0) {
+    return error::Internal("Failed to close segment $0 ($1)", segments_.back().path.string(),
+                           std::strerror(errno));
+  }
+  return Status::OK();
+}
+
+Status SegmentLog::Append(const Batch& columns) {
+  DCHECK_EQ(columns.size(), types_.size());
+  if (columns.empty()) {
+    return Status::OK();
+  }
+
+  RecordHeader header = {};
+  header.magic = kRecordMagic;
+  header.num_columns = columns.size();
+  header.num_rows = columns[0]->length();
+  header.size = sizeof(RecordHeader) + columns.size() * sizeof(ColumnHeader);
+  std::vector<ColumnBuffers> buffers;
+  buffers.reserve(columns.size());
+  for (size_t i = 0; i < columns.size(); ++i) {
+    DCHECK(!types::IsDictionaryArray(*columns[i]));
+    buffers.push_back(GetColumnBuffers(types_[i], *columns[i]));
+    header.size += AlignUp(buffers.back().header.offsets_size) +
+                   AlignUp(buffers.back().header.data_size);
+  }
+
+  absl::MutexLock lock(&mu_);
+  if (f_ != nullptr && segments_.back().bytes >= max_segment_bytes_) {
+    PL_RETURN_IF_ERROR(CloseSegment());
+  }
+  if (f_ == nullptr) {
+    PL_RETURN_IF_ERROR(StartSegment());
+  }
+
+  static const char kPadding[kAlignment] = {};
+  bool ok = fwrite(&header, sizeof(header), 1, f_) == 1;
+  for (const auto& col : buffers) {
+    ok = ok && fwrite(&col.header, sizeof(col.header), 1, f_) == 1;
+  }
+  auto write_buffer = [this](const void* data, int64_t size) {
+    int64_t padding = AlignUp(size) - size;
+    return fwrite(data, 1, size, f_) == static_cast<size_t>(size) &&
+           fwrite(kPadding, 1, padding, f_) == static_cast<size_t>(padding);
+  };
+  for (const auto& col : buffers) {
+    ok = ok && write_buffer(col.offsets.data(), col.header.offsets_size);
+    ok = ok && write_buffer(col.data, col.header.data_size);
+  }
+  // Hand the record to the kernel right away, so it is not lost if the agent crashes.
+  ok = ok && fflush(f_) == 0;
+  if (!ok) {
+    return error::Internal("Failed to write segment $0 ($1)", segments_.back().path.string(),
+                           std::strerror(errno));
+  }
+  segments_.back().bytes += header.size;
+  bytes_ += header.size;
+  return Status::OK();
+}
+
+Status SegmentLog::Expire(int64_t max_bytes) {
+  absl::MutexLock lock(&mu_);
+  while (bytes_ > max_bytes && segments_.size() > static_cast<size_t>(f_ != nullptr)) {
+    PL_RETURN_IF_ERROR(fs::Remove(segments_.front().path));
+    bytes_ -= segments_.front().bytes;
+    segments_.pop_front();
+  }
+  return Status::OK();
+}
+
+int64_t SegmentLog::bytes() const {
+  absl::MutexLock lock(&mu_);
+  return bytes_;
+}
+
+int64_t SegmentLog::num_segments() const {
+  absl::MutexLock lock(&mu_);
+  return segments_.size();
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <arrow/array.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * SegmentLog persists the batches of a table in append-only segment files, so that the data
+ * collected by a PEM survives a restart of the agent.
+ *
+ * Each batch is written as one record: a fixed header followed by the raw arrow buffers of its
+ * columns, 8-byte aligned. Writes go through to the kernel once a record is complete, so the
+ * records appended before a crash are found when the log is opened again. A record that was cut
+ * short by the crash is dropped.
+ *
+ * Opening the log maps the existing segments into memory, and the recovered batches are arrow
+ * arrays that point straight into the mapped files. New records always go to a new segment.
+ */
+class SegmentLog : public NotCopyable {
+ public:
+  // The columns of one batch.
+  using Batch = std::vector<std::shared_ptr<arrow::Array>>;
+
+  /**
+   * Opens the log in the given directory, creating it if needed.
+   *
+   * @param dir the directory of the segment files. Each table needs its own directory.
+   * @param types the column types of the table. Segments written for other column types (e.g. by
+   * an agent with a different schema) are removed.
+   * @param max_segment_bytes the size at which a segment is closed and a new one is started.
+   * @param recovered the batches found in the existing segments, oldest first.
+   */
+  static StatusOr<std::unique_ptr<SegmentLog>> Open(const std::filesystem::path& dir,
+                                                    std::vector<types::DataType> types,
+                                                    int64_t max_segment_bytes,
+                                                    std::vector<Batch>* recovered);
+
+  ~SegmentLog();
+
+  /**
+   * Appends a batch, starting a new segment if the current one is full. The columns must be plain
+   * (not dictionary-encoded) arrays of the log's types.
+   */
+  Status Append(const Batch& columns);
+
+  /**
+   * Removes the oldest segments until the log holds at most max_bytes. The segment being written
+   * is never removed.
+   */
+  Status Expire(int64_t max_bytes);
+
+  int64_t bytes() const;
+  int64_t num_segments() const;
+
+ private:
+  struct Segment {
+    std::filesystem::path path;
+    int64_t bytes = 0;
+  };
+
+  SegmentLog(std::filesystem::path dir, std::vector<types::DataType> types,
+             int64_t max_segment_bytes)
+      : dir_(std::move(dir)), types_(std::move(types)), max_segment_bytes_(max_segment_bytes) {}
+
+  // Maps the segment at the given path and appends its batches to recovered. Returns the size of
+  // the valid records, which the segment is truncated to, or 0 if the segment can't be used.
+  StatusOr<int64_t> RecoverSegment(const std::filesystem::path& path,
+                                   std::vector<Batch>* recovered);
+  Status StartSegment() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status CloseSegment() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::filesystem::path dir_;
+  const std::vector<types::DataType> types_;
+  const int64_t max_segment_bytes_;
+
+  mutable absl::Mutex mu_;
+  // The segments, oldest first. The last one is written to while f_ is open.
+  std::deque<Segment> segments_ ABSL_GUARDED_BY(mu_);
+  int64_t next_segment_id_ ABSL_GUARDED_BY(mu_) = 0;
+  std::FILE* f_ ABSL_GUARDED_BY(mu_) = nullptr;
+  int64_t bytes_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/segment_log.h"
+
+namespace px {
+namespace table_store {
+
+using types::DataType;
+
+namespace {
+
+const std::vector<DataType> kTypes = {DataType::TIME64NS, DataType::STRING, DataType::BOOLEAN,
+                                      DataType::UINT128};
+
+SegmentLog::Batch TestBatch(int64_t start) {
+  auto* pool = arrow::default_memory_pool();
+  return {
+      types::ToArrow(std::vector<types::Time64NSValue>{start, start + 1, start + 2}, pool),
+      types::ToArrow(std::vector<types::StringValue>{"a", "", "bcd"}, pool),
+      types::ToArrow(std::vector<types::BoolValue>{true, false, true}, pool),
+      types::ToArrow(std::vector<types::UInt128Value>{{1, 2}, {3, 4}, {5, 6}}, pool),
+  };
+}
+
+SegmentLog::Batch Slice(const SegmentLog::Batch& batch, int64_t offset, int64_t length) {
+  SegmentLog::Batch slice;
+  for (const auto& col : batch) {
+    slice.push_back(col->Slice(offset, length));
+  }
+  return slice;
+}
+
+void ExpectBatchEq(const SegmentLog::Batch& expected, const SegmentLog::Batch& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_TRUE(expected[i]->Equals(actual[i])) << "column " << i;
+  }
+}
+
+}  // namespace
+
+TEST(SegmentLog, append_and_recover) {
+  testing::TempDir dir;
+  std::vector<SegmentLog::Batch> recovered;
+  {
+    ASSERT_OK_AND_ASSIGN(auto log, SegmentLog::Open(dir.path(), kTypes, 1024 * 1024, &recovered));
+    EXPECT_TRUE(recovered.empty());
+    EXPECT_OK(log->Append(TestBatch(0)));
+    // Slices are written without the values around them.
+    EXPECT_OK(log->Append(Slice(TestBatch(10), 1, 2)));
+    EXPECT_EQ(1, log->num_segments());
+    EXPECT_GT(log->bytes(), 0);
+  }
+
+  ASSERT_OK_AND_ASSIGN(auto log, SegmentLog::Open(dir.path(), kTypes, 1024 * 1024, &recovered));
+  ASSERT_EQ(2, recovered.size());
+  ExpectBatchEq(TestBatch(0), recovered[0]);
+  ExpectBatchEq(Slice(TestBatch(10), 1, 2), recovered[1]);
+
+  // New batches go to a new segment.
+  EXPECT_OK(log->Append(TestBatch(20)));
+  EXPECT_EQ(2, log->num_segments());
+}
+
+TEST(SegmentLog, rotate_and_expire) {
+  testing::TempDir dir;
+  std::vector<SegmentLog::Batch> recovered;
+  // Every batch fills a segment.
+  ASSERT_OK_AND_ASSIGN(auto log, SegmentLog::Open(dir.path(), kTypes, 1, &recovered));
+  for (int64_t i = 0; i < 4; ++i) {
+    EXPECT_OK(log->Append(TestBatch(i * 10)));
+  }
+  EXPECT_EQ(4, log->num_segments());
+  int64_t segment_bytes = log->bytes() / 4;
+
+  EXPECT_OK(log->Expire(2 * segment_bytes));
+  EXPECT_EQ(2, log->num_segments());
+  EXPECT_EQ(2 * segment_bytes, log->bytes());
+
+  // The segment being written is kept.
+  EXPECT_OK(log->Expire(0));
+  EXPECT_EQ(1, log->num_segments());
+  log.reset();
+
+  ASSERT_OK_AND_ASSIGN(log, SegmentLog::Open(dir.path(), kTypes, 1, &recovered));
+  ASSERT_EQ(1, recovered.size());
+  ExpectBatchEq(TestBatch(30), recovered[0]);
+}
+
+TEST(SegmentLog, drops_incomplete_record) {
+  testing::TempDir dir;
+  std::vector<SegmentLog::Batch> recovered;
+  ASSERT_OK_AND_ASSIGN(auto log, SegmentLog::Open(dir.path(), kTypes, 1024 * 1024, &recovered));
+  EXPECT_OK(log->Append(TestBatch(0)));
+  int64_t bytes = log->bytes();
+  log.reset();
+
+  // Simulate a crash in the middle of writing the next record.
+  auto segment_path = std::filesystem::directory_iterator(dir.path())->path();
+  std::ofstream(segment_path, std::ios::app | std::ios::binary) << "PLSG garbage";
+
+  ASSERT_OK_AND_ASSIGN(log, SegmentLog::Open(dir.path(), kTypes, 1024 * 1024, &recovered));
+  ASSERT_EQ(1, recovered.size());
+  ExpectBatchEq(TestBatch(0), recovered[0]);
+  EXPECT_EQ(bytes, log->bytes());
+  EXPECT_EQ(bytes, static_cast<int64_t>(std::filesystem::file_size(segment_path)));
+}
+
+TEST(SegmentLog, removes_segments_of_other_types) {
+  testing::TempDir dir;
+  std::vector<SegmentLog::Batch> recovered;
+  {
+    ASSERT_OK_AND_ASSIGN(auto log, SegmentLog::Open(dir.path(), kTypes, 1024 * 1024, &recovered));
+    EXPECT_OK(log->Append(TestBatch(0)));
+  }
+
+  ASSERT_OK_AND_ASSIGN(auto log, SegmentLog::Open(dir.path(), {DataType::INT64}, 1024 * 1024,
+                                                  &recovered));
+  EXPECT_TRUE(recovered.empty());
+  EXPECT_EQ(0, log->num_segments());
+  EXPECT_TRUE(std::filesystem::is_empty(dir.path()));
+}
+
+}  // namespace table_store
+}  // namespace px
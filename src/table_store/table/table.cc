@@ -21,10 +21,12 @@
 #include <iterator>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/str_format.h>
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/schema/relation.h"
@@ -33,18 +35,87 @@
 DEFINE_int32(table_store_table_size_limit, 128 * 1024 * 1024,
              "The maximal size a table allows. When the size grows beyond this limit, "
              "old data will be discarded. Set to '-1' to remove this limit.");
+DEFINE_int32(table_store_max_hot_batches, 64,
+             "The maximal number of hot batches a table holds. Older batches are encoded and moved "
+             "into the compressed cold tier. Set to '-1' to keep all batches hot.");
+DEFINE_string(table_store_persistence_dir,
+              gflags::StringFromEnv("PL_TABLE_STORE_PERSISTENCE_DIR", ""),
+              "If set, the PEM tables are persisted in segment files under this directory (e.g. a "
+              "hostPath volume), and the data persisted by the previous run is loaded on start.");
+DEFINE_int32(table_store_segment_bytes, 16 * 1024 * 1024,
+             "The size at which a persisted table segment is closed and a new one is started. "
+             "Segments are expired as a whole.");
 
 namespace px {
 namespace table_store {
 
+namespace {
+
+// Totals across all the tables of the process, exported on /metrics.
+struct TableStoreMetrics {
+  metrics::Gauge* bytes;
+  metrics::Counter* batches_added;
+  metrics::Counter* batches_expired;
+  metrics::Counter* bytes_expired;
+};
+
+const TableStoreMetrics& Metrics() {
+  static const TableStoreMetrics table_store_metrics = [] {
+    auto* registry = metrics::MetricsRegistry::Global();
+    return TableStoreMetrics{
+        registry->GetGauge("table_store_bytes", "Bytes held by all the tables."),
+        registry->GetCounter("table_store_batches_added_total", "Batches added to the tables."),
+        registry->GetCounter("table_store_batches_expired_total",
+                             "Batches expired from the tables to stay within their size limit."),
+        registry->GetCounter("table_store_bytes_expired_total",
+                             "Bytes expired from the tables to stay within their size limit."),
+    };
+  }();
+  return table_store_metrics;
+}
+
+void RecordBatchAdded(int64_t bytes) {
+  Metrics().bytes->Add(bytes);
+  Metrics().batches_added->Increment();
+}
+
+void RecordBatchExpired(int64_t bytes) {
+  Metrics().bytes->Add(-bytes);
+  Metrics().batches_expired->Increment();
+  Metrics().bytes_expired->Increment(bytes);
+}
+
+}  // namespace
+
 Table::Table(const schema::Relation& relation, int64_t max_table_size)
     : desc_(relation.col_types()), max_table_size_(max_table_size) {
   uint64_t num_cols = desc_.size();
   columns_.reserve(num_cols);
+  string_interners_.resize(num_cols);
   for (uint64_t i = 0; i < num_cols; ++i) {
     PL_CHECK_OK(
         AddColumn(std::make_shared<Column>(relation.GetColumnType(i), relation.GetColumnName(i))));
+    if (relation.GetColumnType(i) == types::DataType::STRING) {
+      string_interners_[i] = std::make_unique<StringInterner>();
+    }
+  }
+  time_col_idx_ = FindTimeColumn();
+  if (time_col_idx_ != -1 && desc_.type(time_col_idx_) != types::DataType::TIME64NS) {
+    time_col_idx_ = -1;
+  }
+}
+
+Table::~Table() {
+  if (memory_budget_ != nullptr) {
+    memory_budget_->RemoveTable(this);
   }
+  Metrics().bytes->Add(-bytes_);
+}
+
+void Table::JoinMemoryBudget(std::shared_ptr<MemoryBudget> budget, const MemoryShare& share) {
+  DCHECK(memory_budget_ == nullptr || memory_budget_ == budget);
+  memory_budget_ = std::move(budget);
+  memory_budget_->AddTable(this, share);
 }
 
 Status Column::AddBatch(const std::shared_ptr<arrow::Array>& batch) {
@@ -54,7 +125,17 @@ Status Column::AddBatch(const std::shared_ptr<arrow::Array>& batch) {
                                   batch->type_id(), data_type_);
   }
 
-  batches_.emplace_back(batch);
+  batches_.emplace_back(EncodedColumnBatch::Plain(data_type_, batch));
+  return Status::OK();
+}
+
+Status Column::AddEncodedBatch(std::unique_ptr<EncodedColumnBatch> batch) {
+  if (batch->data_type() != data_type_) {
+    return error::InvalidArgument("Column is of type $0, but needs to be type $1.",
+                                  batch->data_type(), data_type_);
+  }
+
+  batches_.emplace_back(std::move(batch));
   return Status::OK();
 }
 
@@ -86,10 +167,10 @@ Status Table::AddColumn(std::shared_ptr<Column> col) {
     }
     // Check size of batches.
     for (int64_t batch_idx = 0; batch_idx < columns_[0]->numBatches(); batch_idx++) {
-      if (columns_[0]->batch(batch_idx)->length() != col->batch(batch_idx)->length()) {
+      if (columns_[0]->batch_length(batch_idx) != col->batch_length(batch_idx)) {
         return error::InvalidArgument("Column has batch of size $0, but should have size $1.",
-                                      col->batch(batch_idx)->length(),
-                                      columns_[0]->batch(batch_idx)->length());
+                                      col->batch_length(batch_idx),
+                                      columns_[0]->batch_length(batch_idx));
       }
     }
   }
@@ -125,11 +206,9 @@ StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatch(int64_t row_batch
   return GetRowBatchSlice(row_batch_idx, cols, mem_pool, 0 /* offset */, -1 /* end */);
 }
 
-StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(int64_t row_batch_idx,
-                                                                    std::vector<int64_t> cols,
-                                                                    arrow::MemoryPool* mem_pool,
-                                                                    int64_t offset,
-                                                                    int64_t end) const {
+StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(
+    int64_t row_batch_idx, std::vector<int64_t> cols, arrow::MemoryPool* mem_pool, int64_t offset,
+    int64_t end, bool keep_dictionaries) const {
   DCHECK(!columns_.empty()) << "RowBatch does not have any columns.";
   DCHECK(NumBatches() > row_batch_idx) << absl::StrFormat(
       "Table has %d batches, but requesting batch %d", NumBatches(), row_batch_idx);
@@ -141,79 +220,151 @@ StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(int64_t row_
     rb_types.push_back(desc_.type(col_idx));
   }
 
-  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+  BatchSnapshot snapshot;
+  {
+    absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+    snapshot = SnapshotBatchUnlocked(row_batch_idx);
+  }
 
-  auto num_cold_batches = !columns_.empty() ? columns_[0]->numBatches() : 0;
-  // If i > num_cold_batches, hot_idx is the index of the batch that we want from the hot columns.
-  auto hot_idx = row_batch_idx - num_cold_batches;
+  // The copy out of the table happens without holding any lock, so that it doesn't stall writers.
+  auto batch_size = (end == -1) ? (snapshot.length() - offset) : (end - offset);
+  auto output_rb = std::make_unique<schema::RowBatch>(schema::RowDescriptor(rb_types), batch_size);
+  for (auto col_idx : cols) {
+    // Encoded cold batches are decoded here, and only for the requested columns.
+    PL_ASSIGN_OR_RETURN(auto arrow_array_sptr,
+                        snapshot.GetColumn(col_idx, mem_pool, keep_dictionaries));
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(arrow_array_sptr->Slice(offset, batch_size)));
+  }
+
+  return output_rb;
+}
+
+StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetFilteredRowBatchSlice(
+    int64_t row_batch_idx, const std::vector<int64_t>& cols,
+    const std::vector<int64_t>& filter_cols, const RowFilter& filter, arrow::MemoryPool* mem_pool,
+    int64_t offset, int64_t end, bool keep_dictionaries) const {
+  DCHECK(NumBatches() > row_batch_idx) << absl::StrFormat(
+      "Table has %d batches, but requesting batch %d", NumBatches(), row_batch_idx);
+
+  std::vector<types::DataType> rb_types;
+  for (int64_t col_idx : cols) {
+    DCHECK(col_idx < static_cast<int64_t>(desc_.size()));
+    rb_types.push_back(desc_.type(col_idx));
+  }
+  std::vector<types::DataType> filter_types;
+  for (int64_t col_idx : filter_cols) {
+    DCHECK(col_idx < static_cast<int64_t>(desc_.size()));
+    filter_types.push_back(desc_.type(col_idx));
+  }
 
+  // Both reads use the same snapshot, so that the filter applies to the same rows even if the
+  // batch is expired or moved into the cold tier in between.
+  BatchSnapshot snapshot;
   {
+    absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
     absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+    snapshot = SnapshotBatchUnlocked(row_batch_idx);
+  }
 
-    if (hot_idx >= 0) {
-      DCHECK(hot_batches_.size() > static_cast<size_t>(hot_idx));
-      // Move hot column batches 0 to hot_idx into cold storage.
-      // TODO(michellenguyen, PL-388): We're currently converting hot data to row batches on a 1:1
-      // basis. This should be updated so that multiple hot column batches are merged into a single
-      // row batch.
-      auto batch_idx = 0;
-      while (batch_idx <= hot_idx) {
-        for (size_t col_idx = 0; col_idx < columns_.size(); col_idx++) {
-          DCHECK(hot_batches_[batch_idx]->size() > col_idx);
-          auto hot_batch_sptr = hot_batches_[batch_idx]->at(col_idx)->ConvertToArrow(mem_pool);
-          PL_RETURN_IF_ERROR(columns_.at(col_idx)->AddBatch(hot_batch_sptr));
-        }
-        batch_idx++;
-      }
-      // Remove hot column batches 0 to hot_idx from hot columns.
-      hot_batches_.erase(hot_batches_.begin(), hot_batches_.begin() + hot_idx + 1);
-    }
+  auto batch_size = (end == -1) ? (snapshot.length() - offset) : (end - offset);
+  schema::RowBatch filter_batch(schema::RowDescriptor(filter_types), batch_size);
+  for (auto col_idx : filter_cols) {
+    // The filter reads the values, so dictionary columns are decoded.
+    PL_ASSIGN_OR_RETURN(auto arrow_array_sptr, snapshot.GetColumn(col_idx, mem_pool));
+    PL_RETURN_IF_ERROR(filter_batch.AddColumn(arrow_array_sptr->Slice(offset, batch_size)));
+  }
+  std::vector<bool> selected(batch_size, true);
+  PL_ASSIGN_OR_RETURN(int64_t num_selected, filter(filter_batch, &selected));
+  if (num_selected == 0) {
+    return schema::RowBatch::WithZeroRows(schema::RowDescriptor(rb_types), /* eow */ false,
+                                          /* eos */ false);
+  }
+
+  // Cold string columns only copy the values of the rows that passed the filter. Their other rows
+  // are left empty, which is fine since the selection below hides them.
+  std::vector<bool> batch_rows;
+  if (snapshot.hot == nullptr && !keep_dictionaries && num_selected < batch_size) {
+    batch_rows.resize(snapshot.length(), false);
+    std::copy(selected.begin(), selected.end(), batch_rows.begin() + offset);
   }
 
-  DCHECK_GT(columns_.size(), static_cast<size_t>(0));
-  DCHECK(columns_[0]->numBatches() > row_batch_idx);
-  auto batch_size =
-      (end == -1) ? (columns_[0]->batch(row_batch_idx)->length() - offset) : (end - offset);
   auto output_rb = std::make_unique<schema::RowBatch>(schema::RowDescriptor(rb_types), batch_size);
   for (auto col_idx : cols) {
-    auto arrow_array_sptr = columns_[col_idx]->batch(row_batch_idx);
+    auto it = std::find(filter_cols.begin(), filter_cols.end(), col_idx);
+    if (it != filter_cols.end()) {
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(filter_batch.ColumnAt(it - filter_cols.begin())));
+      continue;
+    }
+    std::shared_ptr<arrow::Array> arrow_array_sptr;
+    if (!batch_rows.empty()) {
+      PL_ASSIGN_OR_RETURN(arrow_array_sptr,
+                          snapshot.cold.at(col_idx)->DecodeRows(mem_pool, batch_rows));
+    } else {
+      PL_ASSIGN_OR_RETURN(arrow_array_sptr,
+                          snapshot.GetColumn(col_idx, mem_pool, keep_dictionaries));
+    }
     PL_RETURN_IF_ERROR(output_rb->AddColumn(arrow_array_sptr->Slice(offset, batch_size)));
   }
-
+  if (num_selected < batch_size) {
+    auto selection = std::make_shared<std::vector<int64_t>>();
+    selection->reserve(num_selected);
+    for (int64_t i = 0; i < batch_size; ++i) {
+      if (selected[i]) {
+        selection->push_back(i);
+      }
+    }
+    output_rb->set_selection(std::move(selection));
+  }
   return output_rb;
 }
 
 Status Table::DeleteNextRowBatch() {
+  // Declared ahead of the locks so that an expired hot batch is freed after they are released.
+  // Readers that still hold a snapshot of it keep it alive until they are done.
+  HotBatch expired_hot_batch;
+
   // First delete row batches from cold columns.
   absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
 
   if (!columns_.empty() && columns_[0]->numBatches() > 0) {
-    auto rb_size = 0;
+    int64_t rb_size = 0;
     for (auto col : columns_) {
-      auto batch = col->batch(0);
-#define TYPE_CASE(_dt_) rb_size += types::GetArrowArrayBytes<_dt_>(batch.get());
-      PL_SWITCH_FOREACH_DATATYPE(col->data_type(), TYPE_CASE);
-#undef TYPE_CASE
+      // Encoded batches account for their compressed size.
+      rb_size += col->batch_bytes(0);
       PL_RETURN_IF_ERROR(col->DeleteNextBatch());
     }
     bytes_ -= rb_size;
     ++batches_expired_;
-    // Delete row batches from hot columns if cold columns are empty.
-  } else if (!hot_batches_.empty()) {
-    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
-    auto batch = std::move(hot_batches_.front());
-
-    auto rb_size = 0;
-    for (const auto& col : *batch) {
-      rb_size += col->Bytes();
+    {
+      absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+      time_index_.Expire(batches_expired_);
     }
+    RecordBatchExpired(rb_size);
+    return Status::OK();
+  }
 
-    hot_batches_.pop_front();
-    bytes_ -= rb_size;
-    ++batches_expired_;
-  } else {
+  // Delete row batches from hot columns if cold columns are empty.
+  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+  if (hot_batches_.empty()) {
     return error::InvalidArgument("No row batches to delete.");
   }
+  expired_hot_batch = std::move(hot_batches_.front());
+  hot_batches_.pop_front();
+  hot_zones_.pop_front();
+
+  bytes_ -= expired_hot_batch->bytes;
+  ++batches_expired_;
+  time_index_.Expire(batches_expired_);
+  RecordBatchExpired(expired_hot_batch->bytes);
+  return Status::OK();
+}
+
+Status Table::Clear() {
+  // Batches appended concurrently are left alone, there is no end to them otherwise.
+  for (int64_t num_batches = NumBatches(); num_batches > 0; --num_batches) {
+    PL_RETURN_IF_ERROR(DeleteNextRowBatch());
+  }
   return Status::OK();
 }
 
@@ -227,6 +378,12 @@ Status Table::ExpireRowBatches(int64_t row_batch_size) {
       DCHECK_NE(NumBatches(), 0);
       PL_RETURN_IF_ERROR(DeleteNextRowBatch());
     }
+    if (segment_log_ != nullptr) {
+      PL_RETURN_IF_ERROR(segment_log_->Expire(max_table_size_ - row_batch_size));
+    }
+  }
+  if (memory_budget_ != nullptr) {
+    PL_RETURN_IF_ERROR(memory_budget_->Reserve(this, row_batch_size));
   }
   return Status::OK();
 }
@@ -247,16 +404,39 @@ Status Table::WriteRowBatch(schema::RowBatch rb) {
 
   PL_RETURN_IF_ERROR(ExpireRowBatches(rb_bytes));
 
+  std::vector<std::unique_ptr<EncodedColumnBatch>> batches;
+  batches.reserve(rb.num_columns());
+  for (int64_t i = 0; i < rb.num_columns(); i++) {
+    if (types::ToArrowType(desc_.type(i)) != rb.ColumnAt(i)->type_id()) {
+      return error::InvalidArgument("Column is of type $0, but needs to be type $1.",
+                                    rb.ColumnAt(i)->type_id(), desc_.type(i));
+    }
+    batches.push_back(EncodedColumnBatch::Plain(desc_.type(i), rb.ColumnAt(i)));
+  }
+
   {
     absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
 
+    if (hot_batches_.empty()) {
+      std::vector<ColumnZone> zones;
+      zones.reserve(batches.size());
+      for (const auto& batch : batches) {
+        zones.push_back(batch->zone());
+      }
+      IndexBatchUnlocked(zones);
+    } else {
+      // The batch goes in front of the hot batches, which shifts their sequence numbers.
+      ++next_seq_;
+      time_index_.Clear();
+    }
     for (int64_t i = 0; i < rb.num_columns(); i++) {
-      auto s = columns_[i]->AddBatch(rb.ColumnAt(i));
-      PL_RETURN_IF_ERROR(s);
+      PL_RETURN_IF_ERROR(columns_[i]->AddEncodedBatch(std::move(batches[i])));
     }
   }
   bytes_ += rb_bytes;
   ++batches_added_;
+  RecordBatchAdded(rb_bytes);
   return Status::OK();
 }
 
@@ -276,6 +456,8 @@ Status Table::TransferRecordBatch(
 
   uint32_t i = 0;
   auto rb_bytes = 0;
+  std::vector<ColumnZone> zones;
+  zones.reserve(record_batch->size());
   for (const auto& col : *record_batch) {
     auto received_type = col->data_type();
     auto expected_type = desc_.type(i);
@@ -283,16 +465,130 @@ Status Table::TransferRecordBatch(
         << absl::StrFormat("Type mismatch [column=%u]: expected=%s received=%s", i,
                            ToString(expected_type), ToString(received_type));
     rb_bytes += col->Bytes();
+    zones.push_back(ColumnZone::FromColumnWrapper(*col));
     ++i;
   }
 
   PL_RETURN_IF_ERROR(ExpireRowBatches(rb_bytes));
 
+  auto batch = std::make_shared<HotBatchData>();
+  batch->columns.reserve(record_batch->size());
+  for (const auto& col : *record_batch) {
+    batch->columns.push_back(col->ConvertToArrow(arrow::default_memory_pool()));
+  }
+  batch->bytes = rb_bytes;
+  // The column wrappers are not needed past this point, so free them before taking the lock.
+  record_batch.reset();
+  if (segment_log_ != nullptr) {
+    // A batch that can't be persisted is still kept in memory.
+    Status s = segment_log_->Append(batch->columns);
+    if (!s.ok()) {
+      LOG_EVERY_N(ERROR, 100) << absl::Substitute("Failed to persist batch: $0", s.msg());
+    }
+  }
+  {
+    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+    IndexBatchUnlocked(zones);
+    hot_batches_.push_back(std::move(batch));
+    hot_zones_.push_back(std::move(zones));
+    bytes_ += rb_bytes;
+    ++batches_added_;
+    RecordBatchAdded(rb_bytes);
+  }
+
+  return CompactHotBatches();
+}
+
+Status Table::EnablePersistence(const std::filesystem::path& dir) {
+  DCHECK(segment_log_ == nullptr);
+  DCHECK_EQ(NumBatches(), 0);
+  std::vector<SegmentLog::Batch> recovered;
+  PL_ASSIGN_OR_RETURN(segment_log_, SegmentLog::Open(dir, desc_.types(),
+                                                     FLAGS_table_store_segment_bytes, &recovered));
+
+  // The recovered arrays point into the mapped segments, until they are compacted.
+  for (auto& columns : recovered) {
+    int64_t rb_bytes = 0;
+    std::vector<ColumnZone> zones;
+    zones.reserve(columns.size());
+    for (const auto& [i, col] : Enumerate(columns)) {
+#define TYPE_CASE(_dt_) rb_bytes += types::GetArrowArrayBytes<_dt_>(col.get());
+      PL_SWITCH_FOREACH_DATATYPE(desc_.type(i), TYPE_CASE);
+#undef TYPE_CASE
+      zones.push_back(ColumnZone::FromArrow(desc_.type(i), col.get()));
+    }
+    PL_RETURN_IF_ERROR(ExpireRowBatches(rb_bytes));
+
+    auto batch = std::make_shared<HotBatchData>();
+    batch->columns = std::move(columns);
+    batch->bytes = rb_bytes;
+    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+    IndexBatchUnlocked(zones);
+    hot_batches_.push_back(std::move(batch));
+    hot_zones_.push_back(std::move(zones));
+    bytes_ += rb_bytes;
+    ++batches_added_;
+    RecordBatchAdded(rb_bytes);
+  }
+  if (!recovered.empty()) {
+    LOG(INFO) << absl::Substitute("Loaded $0 persisted batches from $1", recovered.size(),
+                                  dir.string());
+  }
+  return CompactHotBatches();
+}
+
+Status Table::CompactHotBatches() {
+  if (FLAGS_table_store_max_hot_batches < 0) {
+    return Status::OK();
+  }
+  auto max_hot_batches = static_cast<size_t>(FLAGS_table_store_max_hot_batches);
+
+  // Another writer is already compacting, and will pick up the batches added since it started.
+  if (compacting_.exchange(true, std::memory_order_acquire)) {
+    return Status::OK();
+  }
+  DEFER(compacting_.store(false, std::memory_order_release));
+
+  std::vector<HotBatch> to_compact;
+  {
+    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+    for (size_t i = 0; i + max_hot_batches < hot_batches_.size(); ++i) {
+      to_compact.push_back(hot_batches_[i]);
+    }
+  }
+  if (to_compact.empty()) {
+    return Status::OK();
+  }
+
+  // Encode without holding the batch locks, so that neither readers nor other writers wait on it.
+  std::vector<std::vector<std::unique_ptr<EncodedColumnBatch>>> encoded(to_compact.size());
+  for (size_t i = 0; i < to_compact.size(); ++i) {
+    for (size_t col_idx = 0; col_idx < columns_.size(); col_idx++) {
+      encoded[i].push_back(EncodedColumnBatch::Encode(columns_[col_idx]->data_type(),
+                                                      to_compact[i]->columns[col_idx],
+                                                      string_interners_[col_idx].get()));
+    }
+  }
+
+  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
   absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
-  hot_batches_.push_back(std::move(record_batch));
-  bytes_ += rb_bytes;
-  ++batches_added_;
+  for (size_t i = 0; i < to_compact.size(); ++i) {
+    // The batch may have expired while it was being encoded. Expiration only removes the oldest
+    // batch, so anything still in the table is at the front.
+    if (hot_batches_.empty() || hot_batches_.front() != to_compact[i]) {
+      continue;
+    }
+    hot_batches_.pop_front();
+    hot_zones_.pop_front();
 
+    int64_t cold_bytes = 0;
+    for (size_t col_idx = 0; col_idx < columns_.size(); col_idx++) {
+      cold_bytes += encoded[i][col_idx]->Bytes();
+      PL_RETURN_IF_ERROR(columns_[col_idx]->AddEncodedBatch(std::move(encoded[i][col_idx])));
+    }
+    bytes_ += cold_bytes - to_compact[i]->bytes;
+    Metrics().bytes->Add(cold_bytes - to_compact[i]->bytes);
+  }
   return Status::OK();
 }
 
@@ -314,6 +610,31 @@ int64_t Table::NumBatchesUnlocked() const {
   return num_batches;
 }
 
+void Table::IndexBatchUnlocked(const std::vector<ColumnZone>& zones) {
+  int64_t seq = next_seq_++;
+  if (time_col_idx_ == -1 || !zones[time_col_idx_].has_range) {
+    return;
+  }
+  time_index_.AddBatch(seq, zones[time_col_idx_].max);
+}
+
+ColumnZone Table::GetColumnZone(int64_t batch_idx, int64_t col_idx) const {
+  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+  return GetColumnZoneUnlocked(batch_idx, col_idx);
+}
+
+ColumnZone Table::GetColumnZoneUnlocked(int64_t batch_idx, int64_t col_idx) const {
+  DCHECK(NumBatchesUnlocked() > batch_idx);
+  DCHECK(static_cast<int64_t>(columns_.size()) > col_idx);
+
+  auto num_cold_batches = columns_[col_idx]->numBatches();
+  if (batch_idx >= num_cold_batches) {
+    return hot_zones_.at(batch_idx - num_cold_batches).at(col_idx);
+  }
+  return columns_[col_idx]->batch_zone(batch_idx);
+}
+
 int64_t Table::FindTimeColumn() {
   int64_t time_col_idx = -1;
   for (size_t i = 0; i < columns_.size(); i++) {
@@ -325,41 +646,100 @@ int64_t Table::FindTimeColumn() {
   return time_col_idx;
 }
 
-std::shared_ptr<arrow::Array> Table::GetColumnBatch(int64_t col, int64_t batch,
-                                                    arrow::MemoryPool* mem_pool) {
-  DCHECK(static_cast<int64_t>(NumBatchesUnlocked()) > batch);
-  DCHECK(static_cast<int64_t>(columns_.size()) > col);
+std::shared_ptr<const void> Table::BatchRef(int64_t batch_idx) const {
+  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+  if (batch_idx < 0 || batch_idx >= NumBatchesUnlocked()) {
+    return nullptr;
+  }
+  BatchSnapshot snapshot = SnapshotBatchUnlocked(batch_idx);
+  if (snapshot.hot != nullptr) {
+    return snapshot.hot;
+  }
+  // The columns of a cold batch are encoded (and replaced) together, so the first one stands for
+  // all of them.
+  return snapshot.cold.empty() ? nullptr : snapshot.cold[0];
+}
+
+Table::BatchSnapshot Table::SnapshotBatchUnlocked(int64_t batch_idx) const {
+  DCHECK(NumBatchesUnlocked() > batch_idx) << absl::StrFormat(
+      "Table has %d batches, but requesting batch %d", NumBatchesUnlocked(), batch_idx);
+
+  BatchSnapshot snapshot;
+  auto num_cold_batches = !columns_.empty() ? columns_[0]->numBatches() : 0;
+  if (batch_idx >= num_cold_batches) {
+    snapshot.hot = hot_batches_.at(batch_idx - num_cold_batches);
+    return snapshot;
+  }
+  snapshot.cold.reserve(columns_.size());
+  for (const auto& col : columns_) {
+    snapshot.cold.push_back(col->encoded_batch(batch_idx));
+  }
+  return snapshot;
+}
+
+int64_t Table::BatchSnapshot::length() const {
+  if (hot != nullptr) {
+    return hot->columns.empty() ? 0 : hot->columns[0]->length();
+  }
+  return cold.empty() ? 0 : cold[0]->length();
+}
 
-  if (batch >= columns_[col]->numBatches()) {
-    auto hot_col_idx = batch - columns_[col]->numBatches();
-    return hot_batches_.at(hot_col_idx)->at(col)->ConvertToArrow(mem_pool);
+StatusOr<std::shared_ptr<arrow::Array>> Table::BatchSnapshot::GetColumn(
+    int64_t col_idx, arrow::MemoryPool* mem_pool, bool keep_dictionaries) const {
+  if (hot != nullptr) {
+    // Hot batches are already in arrow form, so they are shared with the reader as is.
+    return hot->columns.at(col_idx);
+  }
+  if (keep_dictionaries) {
+    return cold.at(col_idx)->DecodeKeepingDictionary(mem_pool);
   }
-  return columns_[col]->batch(batch);
+  return cold.at(col_idx)->Decode(mem_pool);
 }
 
 int64_t Table::FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
                                            arrow::MemoryPool* mem_pool) {
   DCHECK(columns_[time_col_idx]->data_type() == types::DataType::TIME64NS);
 
-  return FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool, 0, NumBatchesUnlocked() - 1);
+  int64_t start = 0;
+  int64_t end = NumBatchesUnlocked() - 1;
+  if (next_seq_ != batches_expired_ + end + 1) {
+    // Batches were added to the columns directly, without going through the index.
+    time_index_.Clear();
+    next_seq_ = batches_expired_ + end + 1;
+  }
+  int64_t lo_seq;
+  int64_t hi_seq;
+  if (end >= 0 && time_col_idx == time_col_idx_ && time_index_.Lookup(time, &lo_seq, &hi_seq)) {
+    // If the end of the range has expired, the oldest batch that is left is the one, and if the
+    // start of the range is past the last batch, that batch rules out the time.
+    start = std::clamp(lo_seq - batches_expired_, int64_t{0}, end);
+    end = std::clamp(hi_seq - batches_expired_, int64_t{0}, end);
+  }
+  return FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool, start, end);
 }
 
 BatchPosition Table::FindBatchPositionGreaterThanOrEqual(int64_t time,
                                                          arrow::MemoryPool* mem_pool) {
-  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
-  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
-
   BatchPosition batch_pos = {-1, -1};
 
   int64_t time_col_idx = FindTimeColumn();
   DCHECK_NE(time_col_idx, -1);
 
-  batch_pos.batch_idx = FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool);
+  BatchSnapshot snapshot;
+  {
+    absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
+    batch_pos.batch_idx = FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool);
+    if (batch_pos.FoundValidBatches()) {
+      snapshot = SnapshotBatchUnlocked(batch_pos.batch_idx);
+    }
+  }
 
   if (batch_pos.FoundValidBatches()) {
     // If batch in range exists, find the specific row in the batch.
     std::shared_ptr<arrow::Array> batch =
-        GetColumnBatch(time_col_idx, batch_pos.batch_idx, mem_pool);
+        snapshot.GetColumn(time_col_idx, mem_pool).ConsumeValueOrDie();
     batch_pos.row_idx =
         types::SearchArrowArrayGreaterThanOrEqual<types::DataType::INT64>(batch.get(), time);
   }
@@ -374,10 +754,20 @@ int64_t Table::FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
   }
 
   int64_t mid = (start + end) / 2;
-  auto batch = GetColumnBatch(time_col_idx, mid, mem_pool);
-  auto start_val = types::GetValueFromArrowArray<types::DataType::INT64>(batch.get(), 0);
-  auto stop_val =
-      types::GetValueFromArrowArray<types::DataType::INT64>(batch.get(), batch->length() - 1);
+  // Time is sorted, so the zone map range is the first and last value of the batch. This avoids
+  // materializing (or decoding) the time column of every batch visited by the search.
+  int64_t start_val;
+  int64_t stop_val;
+  auto zone = GetColumnZoneUnlocked(mid, time_col_idx);
+  if (zone.has_range) {
+    start_val = zone.min;
+    stop_val = zone.max;
+  } else {
+    auto batch = SnapshotBatchUnlocked(mid).GetColumn(time_col_idx, mem_pool).ConsumeValueOrDie();
+    start_val = types::GetValueFromArrowArray<types::DataType::INT64>(batch.get(), 0);
+    stop_val =
+        types::GetValueFromArrowArray<types::DataType::INT64>(batch.get(), batch->length() - 1);
+  }
   if (time > start_val && time <= stop_val) {
     return mid;
   }
@@ -19,8 +19,12 @@
 #pragma once
 
 #include <arrow/array.h>
+#include <arrow/memory_pool.h>
 #include <arrow/record_batch.h>
+#include <atomic>
 #include <deque>
+#include <filesystem>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -36,8 +40,16 @@
 #include "src/table_store/schema/row_batch.h"
 #include "src/table_store/schema/row_descriptor.h"
 #include "src/table_store/schemapb/schema.pb.h"
+#include "src/table_store/table/column_codec.h"
+#include "src/table_store/table/memory_budget.h"
+#include "src/table_store/table/segment_log.h"
+#include "src/table_store/table/time_index.h"
+#include "src/table_store/table/zone_map.h"
 
 DECLARE_int32(table_store_table_size_limit);
+DECLARE_int32(table_store_max_hot_batches);
+DECLARE_string(table_store_persistence_dir);
+DECLARE_int32(table_store_segment_bytes);
 
 namespace px {
 namespace table_store {
@@ -59,7 +71,8 @@ struct TableStats {
 };
 
 /**
- * A Column is batched into equally-sized Arrow Arrays.
+ * A Column is batched into equally-sized Arrow Arrays. Batches may be held in an encoded form
+ * (see EncodedColumnBatch), in which case they are decoded whenever they are accessed.
  */
 class Column {
  public:
@@ -88,6 +101,13 @@ class Column {
    */
   Status AddBatch(const std::shared_ptr<arrow::Array>& batch);
 
+  /**
+   * Add a new batch that has already been encoded. The batch must be of the column's datatype.
+   *
+   * @ param batch the encoded batch to add to the column.
+   */
+  Status AddEncodedBatch(std::unique_ptr<EncodedColumnBatch> batch);
+
   /**
    * Delete the next batch in the column.
    * @return a status of whether deletion was successful.
@@ -95,21 +115,53 @@ class Column {
   Status DeleteNextBatch();
 
   /**
-   * @ param i the index to get the batch from.
+   * @ param i the index to get the batch from. Encoded batches are decoded on the default pool.
    */
   std::shared_ptr<arrow::Array> batch(size_t i) {
+    return batch(i, arrow::default_memory_pool()).ConsumeValueOrDie();
+  }
+
+  /**
+   * @ param i the index to get the batch from.
+   * @ param mem_pool the arrow memory pool used if the batch needs to be decoded.
+   */
+  StatusOr<std::shared_ptr<arrow::Array>> batch(size_t i, arrow::MemoryPool* mem_pool) {
+    return encoded_batch(i)->Decode(mem_pool);
+  }
+
+  /**
+   * @ param i the index to get the batch from.
+   * @ return a reference to the stored batch. Batches are immutable, so the reference stays valid
+   * and can be decoded after the batch has been removed from the column.
+   */
+  std::shared_ptr<const EncodedColumnBatch> encoded_batch(size_t i) const {
     DCHECK(i < batches_.size()) << absl::StrFormat(
         "batches_[%d] does not exist, batches_ is size %d", i, batches_.size());
     return batches_[i];
   }
 
+  /**
+   * @ return the number of rows in the i-th batch, without decoding it.
+   */
+  int64_t batch_length(size_t i) const { return batches_[i]->length(); }
+
+  /**
+   * @ return the number of bytes used by the i-th batch in its stored (possibly encoded) form.
+   */
+  int64_t batch_bytes(size_t i) const { return batches_[i]->Bytes(); }
+
+  /**
+   * @ return the zone map of the i-th batch, without decoding it.
+   */
+  const ColumnZone& batch_zone(size_t i) const { return batches_[i]->zone(); }
+
   std::string name() { return name_; }
 
  private:
   std::string name_;
   types::DataType data_type_;
 
-  std::deque<std::shared_ptr<arrow::Array>> batches_;
+  std::deque<std::shared_ptr<const EncodedColumnBatch>> batches_;
 };
 
 /**
@@ -132,6 +184,8 @@ class Table : public NotCopyable {
    */
   explicit Table(const schema::Relation& relation, int64_t max_table_size);
 
+  ~Table();
+
   /**
    * @ param i the index of the column to get.
    */
@@ -155,11 +209,32 @@ class Table : public NotCopyable {
    * @ param mem_pool the arrow memory pool.
    * @ param offset the first index of the slice of the RowBatch.
    * @ param end the ending index of the slice of the RowBatch (not inclusive).
+   * @ param keep_dictionaries whether dictionary-encoded cold string columns are returned as
+   * dictionary arrays, for readers that can consume them.
+   */
+  StatusOr<std::unique_ptr<schema::RowBatch>> GetRowBatchSlice(
+      int64_t row_batch_idx, std::vector<int64_t> cols, arrow::MemoryPool* mem_pool,
+      int64_t offset, int64_t end, bool keep_dictionaries = false) const;
+
+  /**
+   * Called with the filter columns of a slice, to clear the entries of selected (one per row of
+   * the slice, all set) for the rows to leave out. Returns the number of rows that are left.
    */
-  StatusOr<std::unique_ptr<schema::RowBatch>> GetRowBatchSlice(int64_t row_batch_idx,
-                                                               std::vector<int64_t> cols,
-                                                               arrow::MemoryPool* mem_pool,
-                                                               int64_t offset, int64_t end) const;
+  using RowFilter =
+      std::function<StatusOr<int64_t>(const schema::RowBatch& filter_batch,
+                                      std::vector<bool>* selected)>;
+
+  /**
+   * Same as GetRowBatchSlice(), but only returns the rows that pass filter. The columns in
+   * filter_cols are read first, and the other columns are only read if some rows pass. The filter
+   * columns are read once, and reused for the columns in cols. The rows are selected rather than
+   * copied out of the columns (see schema::RowBatch::set_selection()).
+   */
+  StatusOr<std::unique_ptr<schema::RowBatch>> GetFilteredRowBatchSlice(
+      int64_t row_batch_idx, const std::vector<int64_t>& cols,
+      const std::vector<int64_t>& filter_cols, const RowFilter& filter,
+      arrow::MemoryPool* mem_pool, int64_t offset, int64_t end,
+      bool keep_dictionaries = false) const;
 
   /**
    * @ param rb Rowbatch to write to the table.
@@ -168,17 +243,46 @@ class Table : public NotCopyable {
 
   /**
    * Transfers the given record batch (from Stirling) into the Table.
+   * The batch is converted to arrow here, once, and the arrays are then shared by all the reads
+   * of the batch and by its compaction into the cold tier.
    *
    * @param record_batch the record batch to be appended to the Table.
    * @return status
    */
   Status TransferRecordBatch(std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch);
 
+  /**
+   * Persists the batches transferred into the table in a SegmentLog in the given directory, and
+   * adds the batches that were persisted there before (e.g. by the previous run of the agent).
+   * The segments expire with the same byte budget as the table. Must be called before any data is
+   * added to the table.
+   *
+   * @param dir the directory of the table's segments.
+   * @return status
+   */
+  Status EnablePersistence(const std::filesystem::path& dir);
+
+  /**
+   * Makes the table share the given memory budget with the other tables that joined it, on top of
+   * its own maximum size. Must be called before any data is added to the table.
+   *
+   * @param budget the budget to join.
+   * @param share the share of the budget the table gets.
+   */
+  void JoinMemoryBudget(std::shared_ptr<MemoryBudget> budget, const MemoryShare& share);
+
   /**
    * @return number of column batches.
    */
   int64_t NumBatches() const;
 
+  /**
+   * Deletes all of the batches of the table, as if they expired.
+   *
+   * @return Status of the deletion.
+   */
+  Status Clear();
+
   /**
    * @return number of columns.
    */
@@ -187,7 +291,17 @@ class Table : public NotCopyable {
   /**
    * @return the size of the table in bytes.
    */
-  int64_t NumBytes() const { return bytes_; }
+  int64_t NumBytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+  /**
+   * Records that a query read the table, for the agent to know which tables are in use.
+   */
+  void RecordRead() { last_read_time_ns_.store(CurrentTimeNS(), std::memory_order_relaxed); }
+
+  /**
+   * @return the time of the last RecordRead(), or 0 if the table was never read.
+   */
+  int64_t last_read_time_ns() const { return last_read_time_ns_.load(std::memory_order_relaxed); }
 
   schema::Relation GetRelation() const;
   StatusOr<std::vector<RecordBatchSPtr>> GetTableAsRecordBatches() const;
@@ -200,6 +314,22 @@ class Table : public NotCopyable {
    */
   BatchPosition FindBatchPositionGreaterThanOrEqual(int64_t time, arrow::MemoryPool* mem_pool);
 
+  /**
+   * @param batch_idx the index of the batch.
+   * @param col_idx the index of the column.
+   * @return the zone map of the column in the given batch. Lets callers skip batches, e.g. on an
+   * equality predicate, without materializing them.
+   */
+  ColumnZone GetColumnZone(int64_t batch_idx, int64_t col_idx) const;
+
+  /**
+   * @param batch_idx the index of the batch.
+   * @return an opaque reference to the data of the batch, which stays the same for as long as the
+   * batch is unchanged (until it is expired or moved into the cold tier). Lets readers recognize
+   * the same batch across reads, even as expiry shifts the batch indices.
+   */
+  std::shared_ptr<const void> BatchRef(int64_t batch_idx) const;
+
   // TODO(michellenguyen, PL-404): Time should always be column 0.
   int64_t FindTimeColumn();
 
@@ -213,6 +343,40 @@ class Table : public NotCopyable {
   TableStats GetTableStats() const;
 
  private:
+  // Evicts the batches of the table when other tables of its budget need the room.
+  friend class MemoryBudget;
+
+  /**
+   * The columns of a batch transferred from Stirling. They are converted to arrow once, when the
+   * batch is transferred, so that readers and the compaction into the cold tier all share the
+   * same arrays instead of each converting the batch again.
+   */
+  struct HotBatchData {
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+    // The size of the batch as it was accounted for in bytes_.
+    int64_t bytes = 0;
+  };
+  using HotBatch = std::shared_ptr<const HotBatchData>;
+
+  /**
+   * A reference to the data of one batch, taken while holding the batch locks. Appended batches
+   * are never modified, so the snapshot can be read after the locks are released, even if the
+   * batch is concurrently expired or moved into the cold tier.
+   */
+  struct BatchSnapshot {
+    // Set if the batch is hot.
+    HotBatch hot;
+    // Set if the batch is cold, indexed by column.
+    std::vector<std::shared_ptr<const EncodedColumnBatch>> cold;
+
+    int64_t length() const;
+    StatusOr<std::shared_ptr<arrow::Array>> GetColumn(int64_t col_idx, arrow::MemoryPool* mem_pool,
+                                                      bool keep_dictionaries = false) const;
+  };
+
+  BatchSnapshot SnapshotBatchUnlocked(int64_t batch_idx) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_, hot_batches_lock_);
+
   /**
    * Adds a column to the table. The column must have the same type as the column expected by the
    * relation and be the same size as the other columns.
@@ -222,30 +386,66 @@ class Table : public NotCopyable {
   Status ExpireRowBatches(int64_t row_batch_size);
   Status DeleteNextRowBatch();
 
+  /**
+   * Moves the oldest hot batches into the cold tier, encoding them on the way, until at most
+   * FLAGS_table_store_max_hot_batches hot batches remain. Encoding happens without holding the
+   * batch locks; only one writer compacts at a time, the others skip it.
+   */
+  Status CompactHotBatches();
+
   int64_t FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
                                       arrow::MemoryPool* mem_pool)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_, hot_batches_lock_);
   int64_t FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
                                       arrow::MemoryPool* mem_pool, int64_t start, int64_t end)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
-  std::shared_ptr<arrow::Array> GetColumnBatch(int64_t col, int64_t batch,
-                                               arrow::MemoryPool* mem_pool)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_, hot_batches_lock_);
+  ColumnZone GetColumnZoneUnlocked(int64_t batch_idx, int64_t col_idx) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
   int64_t NumBatchesUnlocked() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
+  // Adds a batch to the end of the table to the time index, see time_index_.
+  void IndexBatchUnlocked(const std::vector<ColumnZone>& zones)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_batches_lock_);
+
   schema::RowDescriptor desc_;
   std::vector<std::shared_ptr<Column>> columns_;
   // TODO(michellenguyen, PL-388): Change hot_batches_ to a list-based queue.
   std::unordered_map<std::string, std::shared_ptr<Column>> name_to_column_map_;
 
-  mutable std::deque<std::unique_ptr<px::types::ColumnWrapperRecordBatch>> hot_batches_;
+  // The batch locks only guard the batch lists. Readers take them long enough to snapshot a batch
+  // (see BatchSnapshot) and decode it without them; writers never hold them while encoding.
+  std::deque<HotBatch> hot_batches_ ABSL_GUARDED_BY(hot_batches_lock_);
+  // Zone maps of the hot batches, one entry per column. Kept in sync with hot_batches_.
+  std::deque<std::vector<ColumnZone>> hot_zones_ ABSL_GUARDED_BY(hot_batches_lock_);
   mutable absl::base_internal::SpinLock hot_batches_lock_;
 
   mutable absl::base_internal::SpinLock cold_batches_lock_;
 
+  // The index of the "time_" column, or -1 if the table has none.
+  int64_t time_col_idx_ = -1;
+  // Narrows the search of FindBatchPositionGreaterThanOrEqual() to the batches of one time bucket.
+  // Indexed by the sequence number of the batches, which is their index plus batches_expired_.
+  // Guarded by the hot lock only, so that writers appending hot batches don't wait on the cold one.
+  TimeIndex time_index_ ABSL_GUARDED_BY(hot_batches_lock_);
+  // The sequence number of the next batch added to the table.
+  int64_t next_seq_ ABSL_GUARDED_BY(hot_batches_lock_) = 0;
+
+  // Set while a writer is compacting hot batches.
+  std::atomic<bool> compacting_{false};
+  // One interner per string column (nullptr for other columns), so that cold batches share the
+  // strings that repeat across batches. Only used by the compacting writer.
+  std::vector<std::unique_ptr<StringInterner>> string_interners_;
+
   int64_t batches_expired_ = 0;
-  int64_t bytes_ = 0;
+  std::atomic<int64_t> bytes_{0};
   int64_t batches_added_ = 0;
   int64_t max_table_size_ = 0;
+  std::atomic<int64_t> last_read_time_ns_{0};
+
+  // Set if the table is persisted, see EnablePersistence().
+  std::unique_ptr<SegmentLog> segment_log_;
+
+  // Set if the table shares a memory budget with other tables, see JoinMemoryBudget().
+  std::shared_ptr<MemoryBudget> memory_budget_;
 };
 
 }  // namespace table_store
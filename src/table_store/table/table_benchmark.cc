@@ -17,6 +17,10 @@
  */
 
 #include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+
 #include "src/shared/types/types.h"
 #include "src/table_store/table/table.h"
 
@@ -58,6 +62,8 @@ static inline schema::RowBatch MakeColdBatch(int64_t batch_size) {
 }
 
 static inline void FillTableHot(Table* table, int64_t table_size, int64_t batch_length) {
+  // Keep every batch hot; compaction into the cold tier would change the table size.
+  FLAGS_table_store_max_hot_batches = -1;
   int64_t batch_size = batch_length * sizeof(int64_t) + batch_length * sizeof(double);
   for (int64_t i = 0; i < (table_size / batch_size); ++i) {
     auto batch = MakeHotBatch(batch_length);
@@ -193,11 +199,39 @@ static void BM_TableWriteFull(benchmark::State& state) {
   state.SetBytesProcessed(state.iterations() * batch_size);
 }
 
+// Reads while another thread keeps appending, which is what queries see while Stirling pushes data.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TableReadWhileWriting(benchmark::State& state) {
+  int64_t table_size = 4 * 1024 * 1024;
+  int64_t batch_length = 256;
+  auto table = MakeTable(table_size);
+  FillTableCold(table.get(), table_size, batch_length);
+
+  std::atomic<bool> done = false;
+  std::thread writer([&]() {
+    while (!done) {
+      PL_CHECK_OK(table->TransferRecordBatch(MakeHotBatch(batch_length)));
+    }
+  });
+
+  for (auto _ : state) {
+    // Expiration shifts batch indices, so stay clear of both ends of the table.
+    benchmark::DoNotOptimize(
+        table->GetRowBatch(table->NumBatches() / 2, {0, 1}, arrow::default_memory_pool()));
+  }
+  done = true;
+  writer.join();
+
+  int64_t batch_size = batch_length * sizeof(int64_t) + batch_length * sizeof(double);
+  state.SetBytesProcessed(state.iterations() * batch_size);
+}
+
 BENCHMARK(BM_TableReadAllHot);
 BENCHMARK(BM_TableReadAllCold);
 BENCHMARK(BM_TableReadLastBatchAllHot);
 BENCHMARK(BM_TableReadLastBatchAllCold);
 BENCHMARK(BM_TableWriteEmpty);
 BENCHMARK(BM_TableWriteFull);
+BENCHMARK(BM_TableReadWhileWriting);
 
 }  // namespace px::table_store
@@ -17,21 +17,38 @@
  */
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 
 #include "src/table_store/table/table_store.h"
 
+DEFINE_int64(table_store_memory_budget, gflags::Int64FromEnv("PL_TABLE_STORE_MEMORY_BUDGET", 0),
+             "If set, the bytes that the agent's tables hold together. The tables then expire the "
+             "data of whichever table holds the most for its share, instead of each keeping to "
+             "its own limit. Zero means no such budget.");
+
 namespace px {
 namespace table_store {
 
-std::unique_ptr<std::unordered_map<std::string, schema::Relation>> TableStore::GetRelationMap() {
-  auto map = std::make_unique<RelationMap>();
-  map->reserve(name_to_relation_map_.size());
-  for (auto& [table_name, relation] : name_to_relation_map_) {
-    map->emplace(table_name, relation);
+TableStore::TableStore(int64_t memory_budget_bytes) {
+  if (memory_budget_bytes > 0) {
+    memory_budget_ = std::make_shared<MemoryBudget>(memory_budget_bytes);
+  }
+}
+
+std::shared_ptr<const TableStore::RelationMap> TableStore::GetRelationMap() {
+  absl::ReaderMutexLock lock(&mu_);
+  absl::MutexLock relation_map_lock(&relation_map_mu_);
+  if (relation_map_ == nullptr) {
+    auto map = std::make_shared<RelationMap>();
+    map->reserve(name_to_relation_map_.size());
+    for (auto& [table_name, relation] : name_to_relation_map_) {
+      map->emplace(table_name, relation);
+    }
+    relation_map_ = std::move(map);
   }
-  return map;
+  return relation_map_;
 }
 
 StatusOr<Table*> TableStore::CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id) {
@@ -43,14 +60,25 @@ StatusOr<Table*> TableStore::CreateNewTablet(uint64_t table_id, const types::Tab
   const TableInfo& table_info = id_to_table_info_map_iter->second;
   const schema::Relation& relation = table_info.relation;
   std::shared_ptr<Table> new_tablet = Table::Create(relation);
+  auto memory_share_iter = id_to_memory_share_.find(table_id);
+  if (memory_share_iter != id_to_memory_share_.end()) {
+    new_tablet->JoinMemoryBudget(memory_budget_, memory_share_iter->second);
+  }
 
   TableIDTablet id_key = {table_id, tablet_id};
   id_to_table_map_[id_key] = new_tablet;
+  if (tablet_id == kDefaultTablet && table_id < kNumDirectTables) {
+    direct_tables_[table_id].store(new_tablet.get(), std::memory_order_release);
+  }
 
   const std::string& table_name = table_info.table_name;
   DCHECK(relation == name_to_relation_map_.find(table_name)->second);
   NameTablet name_key = {table_name, tablet_id};
-  name_to_table_map_[name_key] = new_tablet;
+  auto& name_entry = name_to_table_map_[name_key];
+  if (name_entry != nullptr) {
+    RetireTable(std::move(name_entry));
+  }
+  name_entry = new_tablet;
   return new_tablet.get();
 }
 
@@ -59,13 +87,22 @@ Status TableStore::AppendData(uint64_t table_id, types::TabletID tablet_id,
   Table* table = GetTable(table_id, tablet_id);
   // We create new tablets only if the table at `table_id` exists, otherwise errors out.
   if (table == nullptr) {
-    PL_ASSIGN_OR_RETURN(table, CreateNewTablet(table_id, tablet_id));
+    absl::MutexLock lock(&mu_);
+    // Another thread may have created the tablet since the lookup.
+    auto it = id_to_table_map_.find(TableIDTablet{table_id, tablet_id});
+    if (it != id_to_table_map_.end()) {
+      table = it->second.get();
+    } else {
+      PL_ASSIGN_OR_RETURN(table, CreateNewTablet(table_id, tablet_id));
+    }
   }
+  // The table is appended to outside of the lock, so adding tables doesn't hold up the pushes.
   return table->TransferRecordBatch(std::move(record_batch));
 }
 
 table_store::Table* TableStore::GetTable(const std::string& table_name,
                                          const types::TabletID& tablet_id) const {
+  absl::ReaderMutexLock lock(&mu_);
   auto name_to_table_iter = name_to_table_map_.find(NameTablet{table_name, tablet_id});
   if (name_to_table_iter == name_to_table_map_.end()) {
     return nullptr;
@@ -73,8 +110,45 @@ table_store::Table* TableStore::GetTable(const std::string& table_name,
   return name_to_table_iter->second.get();
 }
 
+std::vector<table_store::Table*> TableStore::GetTablets(const std::string& table_name) const {
+  std::vector<std::pair<types::TabletID, Table*>> tablets;
+  {
+    absl::ReaderMutexLock lock(&mu_);
+    for (const auto& [key, table] : name_to_table_map_) {
+      if (key.name_ == table_name) {
+        tablets.emplace_back(key.tablet_id_, table.get());
+      }
+    }
+  }
+  std::sort(tablets.begin(), tablets.end());
+  std::vector<Table*> tables;
+  tables.reserve(tablets.size());
+  for (const auto& [tablet_id, table] : tablets) {
+    tables.push_back(table);
+  }
+  return tables;
+}
+
+absl::flat_hash_set<std::string> TableStore::TablesReadSince(int64_t time_ns) const {
+  absl::flat_hash_set<std::string> table_names;
+  absl::ReaderMutexLock lock(&mu_);
+  for (const auto& [key, table] : name_to_table_map_) {
+    if (table->last_read_time_ns() >= time_ns) {
+      table_names.insert(key.name_);
+    }
+  }
+  return table_names;
+}
+
 table_store::Table* TableStore::GetTable(uint64_t table_id,
                                          const types::TabletID& tablet_id) const {
+  if (tablet_id == kDefaultTablet && table_id < kNumDirectTables) {
+    Table* table = direct_tables_[table_id].load(std::memory_order_acquire);
+    if (table != nullptr) {
+      return table;
+    }
+  }
+  absl::ReaderMutexLock lock(&mu_);
   auto id_to_table_iter = id_to_table_map_.find(TableIDTablet{table_id, tablet_id});
   if (id_to_table_iter == id_to_table_map_.end()) {
     return nullptr;
@@ -88,12 +162,18 @@ void TableStore::RegisterTableName(const std::string& table_name, const types::T
   auto name_to_relation_map_iter = name_to_relation_map_.find(table_name);
   if (name_to_relation_map_iter == name_to_relation_map_.end()) {
     name_to_relation_map_[table_name] = table_relation;
+    absl::MutexLock relation_map_lock(&relation_map_mu_);
+    relation_map_ = nullptr;
   } else {
     DCHECK_EQ(name_to_relation_map_iter->second, table_relation);
   }
 
   NameTablet key = {table_name, tablet_id};
-  name_to_table_map_[key] = table;
+  auto& entry = name_to_table_map_[key];
+  if (entry != nullptr && entry != table) {
+    RetireTable(std::move(entry));
+  }
+  entry = std::move(table);
 }
 
 void TableStore::RegisterTableID(uint64_t table_id, TableInfo table_info,
@@ -107,13 +187,39 @@ void TableStore::RegisterTableID(uint64_t table_id, TableInfo table_info,
     DCHECK_EQ(id_to_table_info_map_iter->second.relation, table_info.relation);
   }
 
+  if (tablet_id == kDefaultTablet && table_id < kNumDirectTables) {
+    direct_tables_[table_id].store(table.get(), std::memory_order_release);
+  }
   TableIDTablet key{table_id, tablet_id};
-  id_to_table_map_[key] = table;
+  auto& entry = id_to_table_map_[key];
+  if (entry != nullptr && entry != table) {
+    RetireTable(std::move(entry));
+  }
+  entry = std::move(table);
+}
+
+void TableStore::RetireTable(std::shared_ptr<Table> table) {
+  // Readers of direct_tables_ or of the pointers returned by GetTable() hold no reference to the
+  // table, so it has to stay alive as long as the TableStore. A table registered by both name and
+  // ID is retired twice, and only kept once.
+  if (std::find(retired_tables_.begin(), retired_tables_.end(), table) == retired_tables_.end()) {
+    retired_tables_.push_back(std::move(table));
+  }
+  // Its data does not have to: once nothing but the retired list refers to a table, its batches
+  // are freed. This also frees what was appended to the tables retired earlier since then.
+  for (const auto& retired : retired_tables_) {
+    if (retired.use_count() != 1) {
+      continue;
+    }
+    auto s = retired->Clear();
+    LOG_IF(WARNING, !s.ok()) << "Failed to clear a retired table: " << s.msg();
+  }
 }
 
 void TableStore::AddTable(std::shared_ptr<table_store::Table> table, const std::string& table_name,
                           std::optional<uint64_t> table_id, const types::TabletID& tablet_id) {
   const auto& table_relation = table->GetRelation();
+  absl::MutexLock lock(&mu_);
 
   // Register the table by name.
   RegisterTableName(table_name, tablet_id, table_relation, table);
@@ -124,7 +230,28 @@ void TableStore::AddTable(std::shared_ptr<table_store::Table> table, const std::
   }
 }
 
+void TableStore::AddTables(std::vector<TableEntry> tables) {
+  absl::MutexLock lock(&mu_);
+  name_to_table_map_.reserve(name_to_table_map_.size() + tables.size());
+  id_to_table_map_.reserve(id_to_table_map_.size() + tables.size());
+  for (auto& entry : tables) {
+    if (memory_budget_ != nullptr && entry.memory_share.has_value()) {
+      entry.table->JoinMemoryBudget(memory_budget_, entry.memory_share.value());
+      if (entry.table_id.has_value()) {
+        id_to_memory_share_[entry.table_id.value()] = entry.memory_share.value();
+      }
+    }
+    const auto& table_relation = entry.table->GetRelation();
+    RegisterTableName(entry.table_name, kDefaultTablet, table_relation, entry.table);
+    if (entry.table_id.has_value()) {
+      RegisterTableID(entry.table_id.value(), TableInfo{entry.table_name, table_relation},
+                      kDefaultTablet, std::move(entry.table));
+    }
+  }
+}
+
 Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_name) {
+  absl::MutexLock lock(&mu_);
   auto table_iter = name_to_table_map_.find({table_name, ""});
   if (table_iter == name_to_table_map_.end()) {
     return error::Internal(
@@ -146,10 +273,12 @@ Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_nam
 }
 
 Status TableStore::SchemaAsProto(schemapb::Schema* schema) const {
+  absl::ReaderMutexLock lock(&mu_);
   return schema::Schema::ToProto(schema, name_to_relation_map_);
 }
 
 std::vector<uint64_t> TableStore::GetTableIDs() const {
+  absl::ReaderMutexLock lock(&mu_);
   std::vector<uint64_t> ids;
   for (const auto& it : id_to_table_map_) {
     ids.emplace_back(it.first.table_id_);
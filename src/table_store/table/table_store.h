@@ -18,22 +18,30 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/base/base.h"
 #include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/hash_utils.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/schema/schema.h"
+#include "src/table_store/table/memory_budget.h"
 #include "src/table_store/table/table.h"
 #include "src/table_store/table/tablets_group.h"
 
+DECLARE_int64(table_store_memory_budget);
+
 namespace px {
 namespace table_store {
 
@@ -75,12 +83,29 @@ struct TableInfo {
 
 /**
  * TableStore keeps track of the tables in our system.
+ *
+ * The TableStore is thread-safe: tables may be added (eg. for tracepoints) while data is appended
+ * and queries look tables up. Tables are never freed before the TableStore, so the Table pointers
+ * it hands out stay valid. The default tablets of the tables with small IDs are also kept in an
+ * array indexed by the ID, so that appending to them (the Stirling push path) takes no lock and
+ * does no hashing.
+ *
+ * If the TableStore has a memory budget, the tables added with a MemoryShare share it: together
+ * they hold at most the bytes of the budget, and the tables that hold the most for their share
+ * are expired first (see MemoryBudget). Other tables, e.g. the results of queries, don't count
+ * against it.
  */
 class TableStore {
  public:
   using RelationMap = std::unordered_map<std::string, schema::Relation>;
 
-  TableStore() = default;
+  TableStore() : TableStore(FLAGS_table_store_memory_budget) {}
+
+  /**
+   * @param memory_budget_bytes the bytes the tables added with a MemoryShare hold together, or 0
+   * for no budget.
+   */
+  explicit TableStore(int64_t memory_budget_bytes);
 
   /**
    * Get table IDs returns a list of table ids available in the table store.
@@ -107,6 +132,14 @@ class TableStore {
   table_store::Table* GetTable(uint64_t table_id,
                                const types::TabletID& tablet_id = kDefaultTablet) const;
 
+  /**
+   * Gets all the tablets of the table with the given name, ordered by their tablet IDs.
+   *
+   * @ param table_name the name of the table to get
+   * @ returns the tablets, none if the table doesn't exist
+   */
+  std::vector<table_store::Table*> GetTablets(const std::string& table_name) const;
+
   /**
    * Add a table under the given name and optionally tablet id.
    *
@@ -123,6 +156,20 @@ class TableStore {
                 std::optional<uint64_t> table_id = std::nullopt,
                 const types::TabletID& tablet_id = kDefaultTablet);
 
+  struct TableEntry {
+    std::shared_ptr<table_store::Table> table;
+    std::string table_name;
+    std::optional<uint64_t> table_id;
+    // If set, the table and its tablets join the memory budget of the TableStore, if it has one.
+    std::optional<MemoryShare> memory_share = std::nullopt;
+  };
+
+  /**
+   * Adds several tables as their default tablets, same as calling AddTable() for each, but
+   * taking the lock only once.
+   */
+  void AddTables(std::vector<TableEntry> tables);
+
   // Old interface: Deprecated.
   void AddTable(const std::string& table_name, std::shared_ptr<table_store::Table> table) {
     return AddTable(std::move(table), table_name);
@@ -135,9 +182,11 @@ class TableStore {
   Status AddTableAlias(uint64_t table_id, const std::string& table_name);
 
   /**
-   * @return A map of table name to relation representing the table's structure.
+   * @return A map of table name to relation representing the table's structure. The map is built
+   * once per schema change and shared by the callers, so compiling a query doesn't copy every
+   * relation. A map that was handed out never changes; a new table makes a new one.
    */
-  std::unique_ptr<RelationMap> GetRelationMap();
+  std::shared_ptr<const RelationMap> GetRelationMap();
 
   /**
    * @brief Appends the record_batch to the sepcified table and tablet_id. If the table exists but
@@ -154,10 +203,20 @@ class TableStore {
 
   Status SchemaAsProto(schemapb::Schema* schema) const;
 
+  /**
+   * @param time_ns the time since which to look for reads.
+   * @return the names of the tables that have a tablet read by a query since the given time.
+   */
+  absl::flat_hash_set<std::string> TablesReadSince(int64_t time_ns) const;
+
+  // The budget shared by the tables added with a MemoryShare, or nullptr if there is none.
+  MemoryBudget* memory_budget() const { return memory_budget_.get(); }
+
   /**
    * GetTableName returns the table name if the ID is found, else empty string.
    */
   std::string GetTableName(uint64_t id) const {
+    absl::ReaderMutexLock lock(&mu_);
     const auto& it = id_to_table_info_map_.find(id);
     if (it != id_to_table_info_map_.end()) {
       return it->second.table_name;
@@ -168,10 +227,16 @@ class TableStore {
  private:
   void RegisterTableName(const std::string& table_name, const types::TabletID& tablet_id,
                          const schema::Relation& table_relation,
-                         std::shared_ptr<table_store::Table> table);
+                         std::shared_ptr<table_store::Table> table)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   void RegisterTableID(uint64_t table_id, TableInfo table_info, const types::TabletID& tablet_id,
-                       std::shared_ptr<table_store::Table> table);
+                       std::shared_ptr<table_store::Table> table)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Keeps a table that is replaced in one of the maps alive, because it may still be in use, and
+  // frees the batches of the retired tables nothing else refers to.
+  void RetireTable(std::shared_ptr<Table> table) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   /**
    * Create a new tablet inside of the table with table_id
@@ -180,21 +245,41 @@ class TableStore {
    * @param tablet_id: the tablet to create for the tablet.
    * @return StatusOr<Table*>: the table object or an error if the table is nonexistant.
    */
-  StatusOr<Table*> CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id);
+  StatusOr<Table*> CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // The default value for tablets, when tablet is not specified.
   inline static types::TabletID kDefaultTablet = "";
+  // The table IDs below this have their default tablet in direct_tables_.
+  static constexpr uint64_t kNumDirectTables = 1024;
+
+  // Guards the maps. The tables themselves are synchronized on their own.
+  mutable absl::Mutex mu_;
+  // The default tablet of each table ID below kNumDirectTables, or nullptr. Written under mu_ and
+  // read without it.
+  std::array<std::atomic<Table*>, kNumDirectTables> direct_tables_{};
   // Map a name to a table.
-  absl::flat_hash_map<NameTablet, std::shared_ptr<Table>> name_to_table_map_;
+  absl::flat_hash_map<NameTablet, std::shared_ptr<Table>> name_to_table_map_ ABSL_GUARDED_BY(mu_);
   // Map an id to a table.
-  absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>> id_to_table_map_;
+  absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>> id_to_table_map_
+      ABSL_GUARDED_BY(mu_);
   // Mapping from name to relation for adding new tablets.
   // TODO(oazizi): value should likely be shared_ptr<schema::Relation> because the
   //               same information is in id_to_table_info_map_ TableInfo.
   //               Can avoid this copy.
-  absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map_;
+  absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map_ ABSL_GUARDED_BY(mu_);
+  // The map returned by GetRelationMap(), or nullptr if the relations changed since it was built.
+  // Taken after mu_.
+  absl::Mutex relation_map_mu_;
+  std::shared_ptr<const RelationMap> relation_map_ ABSL_GUARDED_BY(relation_map_mu_);
   // Mapping from id to name and relation pair for adding new tablets.
-  absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_;
+  absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_ ABSL_GUARDED_BY(mu_);
+  // The tables that were replaced by others, see RetireTable().
+  std::vector<std::shared_ptr<Table>> retired_tables_ ABSL_GUARDED_BY(mu_);
+  // Shared with the tables that joined it, which may outlive the TableStore.
+  std::shared_ptr<MemoryBudget> memory_budget_;
+  // The shares of the budget of the tables that joined it, for their new tablets.
+  absl::flat_hash_map<uint64_t, MemoryShare> id_to_memory_share_ ABSL_GUARDED_BY(mu_);
 };
 
 }  // namespace table_store
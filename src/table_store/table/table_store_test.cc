@@ -20,8 +20,12 @@
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
+
 #include "src/common/testing/testing.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/schema/row_descriptor.h"
@@ -75,6 +79,8 @@ TEST_F(TableStoreTest, basic) {
 
   auto lookup = table_store.GetRelationMap();
   EXPECT_EQ(2, lookup->size());
+  // The map is shared until the relations change.
+  EXPECT_EQ(lookup, table_store.GetRelationMap());
   EXPECT_EQ(types::DataType::BOOLEAN, lookup->at("a").GetColumnType(0));
   EXPECT_EQ("table1col1", lookup->at("a").GetColumnName(0));
   EXPECT_EQ(types::DataType::FLOAT64, lookup->at("a").GetColumnType(1));
@@ -85,6 +91,13 @@ TEST_F(TableStoreTest, basic) {
   EXPECT_EQ("table2col2", lookup->at("b").GetColumnName(1));
   EXPECT_EQ(types::DataType::INT64, lookup->at("b").GetColumnType(2));
   EXPECT_EQ("table2col3", lookup->at("b").GetColumnName(2));
+
+  // A new table makes a new map, and leaves the one handed out alone.
+  table_store.AddTable(table1, "c");
+  auto new_lookup = table_store.GetRelationMap();
+  EXPECT_NE(lookup, new_lookup);
+  EXPECT_EQ(2, lookup->size());
+  EXPECT_EQ(3, new_lookup->size());
 }
 
 TEST_F(TableStoreTest, get_table_ids) {
@@ -95,6 +108,29 @@ TEST_F(TableStoreTest, get_table_ids) {
   EXPECT_THAT(table_store.GetTableIDs(), ::testing::UnorderedElementsAre(1, 20));
 }
 
+TEST_F(TableStoreTest, add_tables) {
+  auto table_store = TableStore();
+  table_store.AddTables({{table1, "a", 1}, {table2, "b", std::nullopt}});
+
+  EXPECT_THAT(table_store.GetTableIDs(), ::testing::UnorderedElementsAre(1));
+  EXPECT_EQ(table1.get(), table_store.GetTable("a"));
+  EXPECT_EQ(table1.get(), table_store.GetTable(1));
+  EXPECT_EQ(table2.get(), table_store.GetTable("b"));
+  EXPECT_EQ("a", table_store.GetTableName(1));
+}
+
+TEST_F(TableStoreTest, tables_read_since) {
+  auto table_store = TableStore();
+  table_store.AddTables({{table1, "a", 1}, {table2, "b", 2}});
+
+  int64_t start_time = CurrentTimeNS();
+  EXPECT_THAT(table_store.TablesReadSince(start_time), ::testing::IsEmpty());
+
+  table_store.GetTable("a")->RecordRead();
+  EXPECT_THAT(table_store.TablesReadSince(start_time), ::testing::UnorderedElementsAre("a"));
+  EXPECT_THAT(table_store.TablesReadSince(CurrentTimeNS() + 1), ::testing::IsEmpty());
+}
+
 TEST_F(TableStoreTest, table_id_aliasing) {
   auto table_store = TableStore();
 
@@ -147,6 +183,68 @@ TEST_F(TableStoreTest, table_id_aliasing) {
   EXPECT_EQ(table->NumBatches(), 2);
 }
 
+TEST_F(TableStoreTest, replaced_table_stays_valid) {
+  auto table_store = TableStore();
+  table_store.AddTable(Table::Create(rel1), "a", 1);
+  Table* table = table_store.GetTable(1);
+
+  // The first table has no other reference, but a pusher may still be appending to it.
+  auto new_table = Table::Create(rel1);
+  table_store.AddTable(new_table, "a", 1);
+  EXPECT_EQ(new_table.get(), table_store.GetTable(1));
+  EXPECT_EQ(new_table.get(), table_store.GetTable("a"));
+  EXPECT_OK(table->TransferRecordBatch(MakeRel1ColumnWrapperBatch()));
+  EXPECT_EQ(table->NumBatches(), 1);
+}
+
+TEST_F(TableStoreTest, replaced_table_is_cleared) {
+  auto table_store = TableStore();
+  table_store.AddTable(Table::Create(rel1), "a", 1);
+  Table* table = table_store.GetTable(1);
+  EXPECT_OK(table_store.AppendData(1, "", MakeRel1ColumnWrapperBatch()));
+  EXPECT_EQ(table->NumBatches(), 1);
+
+  // The table is still registered by name, so its data stays.
+  table_store.AddTable(table1, "b", 1);
+  EXPECT_EQ(table1.get(), table_store.GetTable(1));
+  EXPECT_EQ(table, table_store.GetTable("a"));
+  EXPECT_EQ(table->NumBatches(), 1);
+
+  // Nothing but the store refers to it anymore once it is replaced by name too.
+  table_store.AddTable(Table::Create(rel1), "a");
+  EXPECT_EQ(table->NumBatches(), 0);
+  EXPECT_EQ(table->NumBytes(), 0);
+
+  // Replacing a table that is still referenced elsewhere leaves its data alone.
+  EXPECT_OK(table_store.AppendData(1, "", MakeRel1ColumnWrapperBatch()));
+  table_store.AddTable(Table::Create(rel1), "b", 1);
+  EXPECT_EQ(table1->NumBatches(), 1);
+}
+
+TEST_F(TableStoreTest, add_tables_while_appending) {
+  auto table_store = TableStore();
+  const uint64_t kTableID = 1;
+  const int kNumBatches = 1000;
+  table_store.AddTable(table1, "a", kTableID);
+
+  std::thread pusher([&]() {
+    for (int i = 0; i < kNumBatches; ++i) {
+      EXPECT_OK(table_store.AppendData(kTableID, "", MakeRel1ColumnWrapperBatch()));
+    }
+  });
+  // Tables are added the way tracepoints add them, including IDs outside of the direct tables.
+  for (uint64_t id = 100; id < 2000; id += 10) {
+    std::string name = absl::StrCat("tracepoint_", id);
+    table_store.AddTable(Table::Create(rel2), name, id);
+    EXPECT_NE(table_store.GetTable(id), nullptr);
+    EXPECT_EQ(table_store.GetTable(name), table_store.GetTable(id));
+  }
+  pusher.join();
+
+  EXPECT_EQ(table_store.GetTable(kTableID)->NumBatches(), kNumBatches);
+  EXPECT_EQ(table_store.GetTableIDs().size(), 191);
+}
+
 using TableStoreDeathTest = TableStoreTest;
 TEST_F(TableStoreDeathTest, rewrite_fails) {
   auto table_store = TableStore();
@@ -251,6 +349,19 @@ TEST_F(TableStoreTabletsTest, tablet_test) {
   EXPECT_EQ(tablet2->NumBatches(), 0);
 }
 
+TEST_F(TableStoreTabletsTest, get_tablets) {
+  auto table_store = TableStore();
+  uint64_t table_id = 123;
+
+  table_store.AddTable(tablet1_2, "a", table_id, "789");
+  table_store.AddTable(tablet1_1, "a", table_id, "456");
+  table_store.AddTable(tablet2_1, "b", 124, "456");
+
+  EXPECT_THAT(table_store.GetTablets("a"),
+              ::testing::ElementsAre(tablet1_1.get(), tablet1_2.get()));
+  EXPECT_THAT(table_store.GetTablets("c"), ::testing::IsEmpty());
+}
+
 // Test to make sure that appending data makes a tablet.
 TEST_F(TableStoreTabletsTest, add_tablet_on_append_data) {
   auto table_store = TableStore();
@@ -19,8 +19,11 @@
 #include <arrow/array.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
+#include <atomic>
+#include <thread>
 #include <vector>
 
+#include "src/common/testing/temp_dir.h"
 #include "src/common/testing/testing.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/table_store/schema/relation.h"
@@ -117,6 +120,96 @@ TEST(TableTest, basic_test) {
   EXPECT_TRUE(rb2->ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST(TableTest, filtered_row_batch_slice) {
+  auto table = TestTable();
+
+  int64_t num_filter_calls = 0;
+  // Keeps the rows of col2 that are odd.
+  auto filter = [&](const schema::RowBatch& filter_batch,
+                    std::vector<bool>* selected) -> StatusOr<int64_t> {
+    ++num_filter_calls;
+    EXPECT_EQ(filter_batch.num_columns(), 1);
+    auto col2 = static_cast<const arrow::Int64Array*>(filter_batch.ColumnAt(0).get());
+    int64_t num_selected = 0;
+    for (int64_t i = 0; i < col2->length(); ++i) {
+      (*selected)[i] = col2->Value(i) % 2 == 1;
+      num_selected += (*selected)[i];
+    }
+    return num_selected;
+  };
+
+  auto rb = table
+                ->GetFilteredRowBatchSlice(0, std::vector<int64_t>({1, 0}),
+                                           std::vector<int64_t>({1}), filter,
+                                           arrow::default_memory_pool(), 0, -1)
+                .ConsumeValueOrDie();
+  EXPECT_EQ(num_filter_calls, 1);
+  EXPECT_EQ(rb->num_rows(), 3);
+  EXPECT_EQ(rb->num_selected_rows(), 2);
+  EXPECT_THAT(*rb->selection(), ::testing::ElementsAre(0, 2));
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(std::vector<types::Int64Value>({1, 2, 3}),
+                                                     arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(1)->Equals(types::ToArrow(
+      std::vector<types::Float64Value>({0.5, 1.2, 5.3}), arrow::default_memory_pool())));
+
+  // None of the rows [1, 2) of the second batch pass.
+  rb = table
+           ->GetFilteredRowBatchSlice(1, std::vector<int64_t>({0, 1}), std::vector<int64_t>({1}),
+                                      filter, arrow::default_memory_pool(), 1, 2)
+           .ConsumeValueOrDie();
+  EXPECT_EQ(num_filter_calls, 2);
+  EXPECT_EQ(rb->num_rows(), 0);
+  EXPECT_EQ(rb->num_columns(), 2);
+}
+
+TEST(TableTest, filtered_row_batch_slice_of_cold_batch) {
+  gflags::FlagSaver flag_saver;
+  FLAGS_table_store_max_hot_batches = 1;
+
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::STRING}, {"time_", "method"});
+  std::shared_ptr<Table> table = Table::Create(rel);
+  std::vector<types::Time64NSValue> times;
+  std::vector<types::StringValue> methods;
+  for (int i = 0; i < 100; ++i) {
+    times.push_back(i * 10);
+    methods.push_back(i % 2 ? "GET" : "POST");
+  }
+  for (int b = 0; b < 2; ++b) {
+    auto rb_wrapper = std::make_unique<types::ColumnWrapperRecordBatch>();
+    rb_wrapper->push_back(
+        types::ColumnWrapper::FromArrow(types::ToArrow(times, arrow::default_memory_pool())));
+    rb_wrapper->push_back(
+        types::ColumnWrapper::FromArrow(types::ToArrow(methods, arrow::default_memory_pool())));
+    EXPECT_OK(table->TransferRecordBatch(std::move(rb_wrapper)));
+  }
+  ASSERT_EQ(table->GetColumn(1)->numBatches(), 1);
+
+  // Keeps the rows of [10, 20) whose time is a multiple of 30.
+  auto filter = [&](const schema::RowBatch& filter_batch,
+                    std::vector<bool>* selected) -> StatusOr<int64_t> {
+    auto time_col = static_cast<const arrow::Int64Array*>(filter_batch.ColumnAt(0).get());
+    int64_t num_selected = 0;
+    for (int64_t i = 0; i < time_col->length(); ++i) {
+      (*selected)[i] = time_col->Value(i) % 30 == 0;
+      num_selected += (*selected)[i];
+    }
+    return num_selected;
+  };
+  auto rb = table
+                ->GetFilteredRowBatchSlice(0, std::vector<int64_t>({0, 1}),
+                                           std::vector<int64_t>({0}), filter,
+                                           arrow::default_memory_pool(), 10, 20)
+                .ConsumeValueOrDie();
+  EXPECT_EQ(rb->num_rows(), 10);
+  EXPECT_THAT(*rb->selection(), ::testing::ElementsAre(2, 5, 8));
+
+  // Only the strings of the selected rows of the cold batch are decoded.
+  auto method_col = static_cast<const arrow::StringArray*>(rb->ColumnAt(1).get());
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(method_col->GetString(i), (i % 3 == 2) ? methods[10 + i] : "");
+  }
+}
+
 TEST(TableTest, bytes_test) {
   auto rd = schema::RowDescriptor({types::DataType::INT64, types::DataType::STRING});
   schema::Relation rel(rd.types(), {"col1", "col2"});
@@ -363,6 +456,129 @@ TEST(TableTest, hot_batches_test) {
   EXPECT_TRUE(rb2->ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST(TableTest, hot_batches_are_converted_once) {
+  schema::Relation rel({types::DataType::INT64}, {"col1"});
+  std::shared_ptr<Table> table_ptr = Table::Create(rel);
+  Table& table = *table_ptr;
+
+  std::vector<types::Int64Value> col1_in1 = {1, 2, 3};
+  auto rb_wrapper = std::make_unique<types::ColumnWrapperRecordBatch>();
+  rb_wrapper->push_back(
+      types::ColumnWrapper::FromArrow(types::ToArrow(col1_in1, arrow::default_memory_pool())));
+  EXPECT_OK(table.TransferRecordBatch(std::move(rb_wrapper)));
+
+  auto rb1 = table.GetRowBatch(0, std::vector<int64_t>({0}), arrow::default_memory_pool())
+                 .ConsumeValueOrDie();
+  auto rb2 = table.GetRowBatch(0, std::vector<int64_t>({0}), arrow::default_memory_pool())
+                 .ConsumeValueOrDie();
+  EXPECT_TRUE(rb1->ColumnAt(0)->Equals(types::ToArrow(col1_in1, arrow::default_memory_pool())));
+  // Both reads share the arrays built when the batch was transferred.
+  EXPECT_EQ(rb1->ColumnAt(0)->data()->buffers[1]->data(),
+            rb2->ColumnAt(0)->data()->buffers[1]->data());
+}
+
+TEST(TableTest, compacted_cold_batches_test) {
+  auto max_hot_batches = FLAGS_table_store_max_hot_batches;
+  FLAGS_table_store_max_hot_batches = 1;
+
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::STRING}, {"time_", "method"});
+  std::shared_ptr<Table> table_ptr = Table::Create(rel);
+  Table& table = *table_ptr;
+
+  std::vector<std::vector<types::Time64NSValue>> times;
+  std::vector<std::vector<types::StringValue>> methods;
+  for (int b = 0; b < 3; ++b) {
+    times.emplace_back();
+    methods.emplace_back();
+    for (int i = 0; i < 100; ++i) {
+      times.back().push_back(b * 1000 + i * 10);
+      methods.back().push_back(i % 2 ? "GET" : "POST");
+    }
+    auto rb_wrapper = std::make_unique<types::ColumnWrapperRecordBatch>();
+    rb_wrapper->push_back(types::ColumnWrapper::FromArrow(
+        types::ToArrow(times.back(), arrow::default_memory_pool())));
+    rb_wrapper->push_back(types::ColumnWrapper::FromArrow(
+        types::ToArrow(methods.back(), arrow::default_memory_pool())));
+    EXPECT_OK(table.TransferRecordBatch(std::move(rb_wrapper)));
+  }
+
+  // The two oldest batches were encoded into the cold tier, which shrinks the table.
+  EXPECT_EQ(table.NumBatches(), 3);
+  EXPECT_EQ(table.GetColumn(0)->numBatches(), 2);
+  EXPECT_LT(table.NumBytes(), 3 * 100 * (8 + 4));
+
+  for (int b = 0; b < 3; ++b) {
+    auto rb = table.GetRowBatch(b, std::vector<int64_t>({0, 1}), arrow::default_memory_pool())
+                  .ConsumeValueOrDie();
+    EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(times[b], arrow::default_memory_pool())));
+    EXPECT_TRUE(rb->ColumnAt(1)->Equals(types::ToArrow(methods[b], arrow::default_memory_pool())));
+  }
+
+  auto pos = table.FindBatchPositionGreaterThanOrEqual(1005, arrow::default_memory_pool());
+  EXPECT_EQ(pos.batch_idx, 1);
+  EXPECT_EQ(pos.row_idx, 1);
+
+  FLAGS_table_store_max_hot_batches = max_hot_batches;
+}
+
+TEST(TableTest, concurrent_append_and_read) {
+  auto max_hot_batches = FLAGS_table_store_max_hot_batches;
+  FLAGS_table_store_max_hot_batches = 2;
+
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::STRING}, {"time_", "method"});
+  auto table = std::make_shared<Table>(rel, /* max_table_size */ -1);
+
+  constexpr int kNumWriters = 2;
+  constexpr int kBatchesPerWriter = 50;
+  constexpr int kBatchLength = 20;
+
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kNumWriters; ++w) {
+    writers.emplace_back([&table, w]() {
+      for (int b = 0; b < kBatchesPerWriter; ++b) {
+        std::vector<types::Time64NSValue> times;
+        std::vector<types::StringValue> methods;
+        for (int i = 0; i < kBatchLength; ++i) {
+          times.push_back((w * kBatchesPerWriter + b) * kBatchLength + i);
+          methods.push_back(i % 2 ? "GET" : "POST");
+        }
+        auto rb_wrapper = std::make_unique<types::ColumnWrapperRecordBatch>();
+        rb_wrapper->push_back(
+            types::ColumnWrapper::FromArrow(types::ToArrow(times, arrow::default_memory_pool())));
+        rb_wrapper->push_back(
+            types::ColumnWrapper::FromArrow(types::ToArrow(methods, arrow::default_memory_pool())));
+        EXPECT_OK(table->TransferRecordBatch(std::move(rb_wrapper)));
+      }
+    });
+  }
+
+  std::atomic<bool> done = false;
+  std::thread reader([&table, &done]() {
+    while (!done) {
+      for (int64_t i = 0; i < table->NumBatches(); ++i) {
+        auto rb_or_s = table->GetRowBatch(i, {0, 1}, arrow::default_memory_pool());
+        ASSERT_OK(rb_or_s);
+        EXPECT_EQ(kBatchLength, rb_or_s.ValueOrDie()->num_rows());
+      }
+    }
+  });
+
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(kNumWriters * kBatchesPerWriter, table->NumBatches());
+  for (int64_t i = 0; i < table->NumBatches(); ++i) {
+    auto rb = table->GetRowBatch(i, {1}, arrow::default_memory_pool()).ConsumeValueOrDie();
+    EXPECT_EQ("POST", types::GetValueFromArrowArray<types::DataType::STRING>(
+                          rb->ColumnAt(0).get(), 0));
+  }
+
+  FLAGS_table_store_max_hot_batches = max_hot_batches;
+}
+
 TEST(TableTest, greater_than_eq_eq) {
   schema::Relation rel({types::DataType::BOOLEAN, types::DataType::INT64}, {"col1", "col2"});
   schema::RowDescriptor rd({types::DataType::BOOLEAN, types::DataType::INT64});
@@ -461,6 +677,135 @@ TEST(TableTest, find_batch_position_greater_or_eq) {
   EXPECT_EQ(-1, batch_pos.row_idx);
 }
 
+TEST(TableTest, find_batch_position_with_time_index) {
+  schema::Relation rel({types::DataType::TIME64NS}, {"time_"});
+  // Room for 20 batches of 10 times each.
+  Table table(rel, /* max_table_size */ 20 * 10 * sizeof(int64_t));
+
+  // Batch b holds b * 400ms + i * 10ms, so that a time bucket spans a few batches.
+  constexpr int64_t kMillis = 1000 * 1000;
+  for (int64_t b = 0; b < 50; ++b) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    for (int64_t i = 0; i < 10; ++i) {
+      col_wrapper->Append(b * 400 * kMillis + i * 10 * kMillis);
+    }
+    wrapper_batch->push_back(col_wrapper);
+    EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  }
+  ASSERT_EQ(table.NumBatches(), 20);
+
+  // Batch 30 is the oldest left.
+  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(0, arrow::default_memory_pool());
+  EXPECT_EQ(0, batch_pos.batch_idx);
+  EXPECT_EQ(0, batch_pos.row_idx);
+
+  batch_pos =
+      table.FindBatchPositionGreaterThanOrEqual(35 * 400 * kMillis, arrow::default_memory_pool());
+  EXPECT_EQ(5, batch_pos.batch_idx);
+  EXPECT_EQ(0, batch_pos.row_idx);
+
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(41 * 400 * kMillis + 25 * kMillis,
+                                                        arrow::default_memory_pool());
+  EXPECT_EQ(11, batch_pos.batch_idx);
+  EXPECT_EQ(3, batch_pos.row_idx);
+
+  // Between two batches.
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(44 * 400 * kMillis + 200 * kMillis,
+                                                        arrow::default_memory_pool());
+  EXPECT_EQ(15, batch_pos.batch_idx);
+  EXPECT_EQ(0, batch_pos.row_idx);
+
+  batch_pos =
+      table.FindBatchPositionGreaterThanOrEqual(50 * 400 * kMillis, arrow::default_memory_pool());
+  EXPECT_EQ(-1, batch_pos.batch_idx);
+}
+
+TEST(TableTest, find_batch_position_with_time_index_across_tiers) {
+  // The batches are indexed as they are added, and keep their sequence numbers once compacted.
+  gflags::FlagSaver flag_saver;
+  FLAGS_table_store_max_hot_batches = 2;
+  schema::Relation rel({types::DataType::TIME64NS}, {"time_"});
+  Table table(rel, /* max_table_size */ 20 * 10 * sizeof(int64_t));
+
+  constexpr int64_t kMillis = 1000 * 1000;
+  for (int64_t b = 0; b < 50; ++b) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    for (int64_t i = 0; i < 10; ++i) {
+      col_wrapper->Append(b * 400 * kMillis + i * 10 * kMillis);
+    }
+    wrapper_batch->push_back(col_wrapper);
+    EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  }
+  ASSERT_GE(table.NumBatches(), 20);
+  int64_t first_batch = 50 - table.NumBatches();
+
+  // A cold batch.
+  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(
+      (first_batch + 5) * 400 * kMillis + 25 * kMillis, arrow::default_memory_pool());
+  EXPECT_EQ(5, batch_pos.batch_idx);
+  EXPECT_EQ(3, batch_pos.row_idx);
+
+  // The last batch, which is still hot.
+  batch_pos =
+      table.FindBatchPositionGreaterThanOrEqual(49 * 400 * kMillis, arrow::default_memory_pool());
+  EXPECT_EQ(49 - first_batch, batch_pos.batch_idx);
+  EXPECT_EQ(0, batch_pos.row_idx);
+}
+
+TEST(TableTest, column_zones) {
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::INT64}, {"time_", "val"});
+  std::shared_ptr<Table> table_ptr = Table::Create(rel);
+  Table& table = *table_ptr;
+
+  std::vector<types::Time64NSValue> cold_times = {1, 2, 3};
+  std::vector<types::Int64Value> cold_vals = {40, 10, 20};
+  EXPECT_OK(table.GetColumn(0)->AddBatch(types::ToArrow(cold_times, arrow::default_memory_pool())));
+  EXPECT_OK(table.GetColumn(1)->AddBatch(types::ToArrow(cold_vals, arrow::default_memory_pool())));
+
+  auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  wrapper_batch->push_back(types::ColumnWrapper::FromArrow(types::ToArrow(
+      std::vector<types::Time64NSValue>({5, 6}), arrow::default_memory_pool())));
+  wrapper_batch->push_back(types::ColumnWrapper::FromArrow(
+      types::ToArrow(std::vector<types::Int64Value>({-1, 7}), arrow::default_memory_pool())));
+  EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+
+  auto cold_zone = table.GetColumnZone(0, 1);
+  EXPECT_EQ(cold_zone.num_rows, 3);
+  EXPECT_EQ(cold_zone.min, 10);
+  EXPECT_EQ(cold_zone.max, 40);
+  EXPECT_FALSE(cold_zone.MayContain(int64_t{7}));
+
+  auto hot_zone = table.GetColumnZone(1, 1);
+  EXPECT_EQ(hot_zone.num_rows, 2);
+  EXPECT_EQ(hot_zone.min, -1);
+  EXPECT_EQ(hot_zone.max, 7);
+  EXPECT_TRUE(hot_zone.MayContain(int64_t{7}));
+
+  auto hot_time_zone = table.GetColumnZone(1, 0);
+  EXPECT_EQ(hot_time_zone.min, 5);
+  EXPECT_EQ(hot_time_zone.max, 6);
+
+  // Transferring another batch with a single hot batch allowed compacts the hot batch into the
+  // cold tier. Its zone map must be unchanged.
+  gflags::FlagSaver flag_saver;
+  FLAGS_table_store_max_hot_batches = 1;
+  wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  wrapper_batch->push_back(types::ColumnWrapper::FromArrow(
+      types::ToArrow(std::vector<types::Time64NSValue>({8}), arrow::default_memory_pool())));
+  wrapper_batch->push_back(types::ColumnWrapper::FromArrow(
+      types::ToArrow(std::vector<types::Int64Value>({100}), arrow::default_memory_pool())));
+  EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  ASSERT_EQ(table.GetColumn(1)->numBatches(), 2);
+
+  auto moved_zone = table.GetColumnZone(1, 1);
+  EXPECT_EQ(moved_zone.num_rows, 2);
+  EXPECT_EQ(moved_zone.min, -1);
+  EXPECT_EQ(moved_zone.max, 7);
+  EXPECT_FALSE(moved_zone.MayContain(int64_t{100}));
+}
+
 TEST(TableTest, ToProto) {
   auto table = TestTable();
   table_store::schemapb::Table table_proto;
@@ -562,5 +907,69 @@ TEST(TableTest, write_zero_row_row_batch) {
   EXPECT_EQ(status.ConsumeValueOrDie()->num_rows(), 0);
 }
 
+TEST(TableTest, batch_ref_follows_expiry) {
+  auto rd = schema::RowDescriptor({types::DataType::INT64});
+  schema::Relation rel(rd.types(), {"col1"});
+  // Fits two of the batches below.
+  Table table(rel, 2 * 3 * sizeof(int64_t));
+
+  for (int64_t i = 0; i < 2; ++i) {
+    schema::RowBatch rb(rd, 3);
+    EXPECT_OK(rb.AddColumn(
+        types::ToArrow(std::vector<types::Int64Value>{i, i, i}, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+  }
+  auto first_ref = table.BatchRef(0);
+  auto second_ref = table.BatchRef(1);
+  ASSERT_NE(nullptr, first_ref);
+  EXPECT_NE(first_ref, second_ref);
+  EXPECT_EQ(first_ref, table.BatchRef(0));
+  EXPECT_EQ(nullptr, table.BatchRef(2));
+
+  // Expires the first batch, so the second one moves to index 0.
+  schema::RowBatch rb(rd, 3);
+  EXPECT_OK(rb.AddColumn(
+      types::ToArrow(std::vector<types::Int64Value>{2, 2, 2}, arrow::default_memory_pool())));
+  EXPECT_OK(table.WriteRowBatch(rb));
+  EXPECT_EQ(2, table.NumBatches());
+  EXPECT_EQ(second_ref, table.BatchRef(0));
+}
+
+TEST(TableTest, persistence) {
+  testing::TempDir dir;
+  schema::Relation rel({types::DataType::INT64, types::DataType::STRING}, {"col1", "col2"});
+  auto make_batch = [](int64_t val) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper_1 = std::make_shared<types::Int64ValueColumnWrapper>(0);
+    col_wrapper_1->Append(val);
+    auto col_wrapper_2 = std::make_shared<types::StringValueColumnWrapper>(0);
+    col_wrapper_2->Append(absl::StrCat("val", val));
+    wrapper_batch->push_back(col_wrapper_1);
+    wrapper_batch->push_back(col_wrapper_2);
+    return wrapper_batch;
+  };
+
+  {
+    Table table(rel, 1024);
+    EXPECT_OK(table.EnablePersistence(dir.path()));
+    EXPECT_OK(table.TransferRecordBatch(make_batch(1)));
+    EXPECT_OK(table.TransferRecordBatch(make_batch(2)));
+  }
+
+  // A new table, e.g. after an agent restart, starts with the persisted batches.
+  Table table(rel, 1024);
+  EXPECT_OK(table.EnablePersistence(dir.path()));
+  EXPECT_OK(table.TransferRecordBatch(make_batch(3)));
+  ASSERT_EQ(3, table.NumBatches());
+  for (int64_t i = 0; i < 3; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto rb, table.GetRowBatch(i, {0, 1}, arrow::default_memory_pool()));
+    EXPECT_TRUE(rb->ColumnAt(0)->Equals(
+        types::ToArrow(std::vector<types::Int64Value>{i + 1}, arrow::default_memory_pool())));
+    std::vector<types::StringValue> expected_col2 = {absl::StrCat("val", i + 1)};
+    EXPECT_TRUE(
+        rb->ColumnAt(1)->Equals(types::ToArrow(expected_col2, arrow::default_memory_pool())));
+  }
+}
+
 }  // namespace table_store
 }  // namespace px
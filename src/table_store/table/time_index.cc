@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/time_index.h"
+
+namespace px {
+namespace table_store {
+
+int64_t TimeIndex::Bucket(int64_t time) const {
+  // Rounds down for negative times too.
+  int64_t bucket = time / bucket_ns_;
+  if (time % bucket_ns_ < 0) {
+    --bucket;
+  }
+  return bucket;
+}
+
+void TimeIndex::AddBatch(int64_t seq, int64_t max_time) {
+  int64_t bucket = Bucket(max_time);
+  int64_t next_bucket = first_bucket_ + NumBuckets();
+  if (first_seqs_.empty() || bucket - next_bucket >= kMaxBuckets) {
+    // The earlier batches are all before the first bucket, so lookups of their times still find
+    // them in front of it.
+    first_seqs_.clear();
+    first_bucket_ = bucket;
+    next_bucket = bucket;
+  }
+  for (; next_bucket <= bucket; ++next_bucket) {
+    first_seqs_.push_back(seq);
+  }
+  while (NumBuckets() > kMaxBuckets) {
+    first_seqs_.pop_front();
+    ++first_bucket_;
+  }
+  last_seq_ = seq;
+}
+
+void TimeIndex::Expire(int64_t first_seq) {
+  // The first bucket stays for as long as any of its batches are left.
+  while (first_seqs_.size() > 1 && first_seqs_[1] <= first_seq) {
+    first_seqs_.pop_front();
+    ++first_bucket_;
+  }
+}
+
+bool TimeIndex::Lookup(int64_t time, int64_t* lo, int64_t* hi) const {
+  if (first_seqs_.empty()) {
+    return false;
+  }
+  int64_t idx = Bucket(time) - first_bucket_;
+  if (idx < 0) {
+    // Any batch up to the first one of the index.
+    *lo = 0;
+    *hi = first_seqs_.front();
+  } else if (idx >= NumBuckets()) {
+    // Past all the batches, which the search of the last one confirms.
+    *lo = last_seq_;
+    *hi = last_seq_;
+  } else {
+    *lo = first_seqs_[idx];
+    *hi = idx + 1 < NumBuckets() ? first_seqs_[idx + 1] : last_seq_;
+  }
+  return true;
+}
+
+void TimeIndex::Clear() {
+  first_seqs_.clear();
+  first_bucket_ = 0;
+  last_seq_ = -1;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+namespace px {
+namespace table_store {
+
+/**
+ * A TimeIndex maps fixed-width time buckets to the first batch of a table that reaches them, so
+ * that the batch holding a start time is found without searching all the batches of the table.
+ * Batches are identified by their sequence number in the table (the number of batches that were
+ * added before them), which doesn't change as older batches expire.
+ *
+ * The batches must be added in time order, like the table itself expects of its time column.
+ */
+class TimeIndex {
+ public:
+  static constexpr int64_t kDefaultBucketNS = 1000 * 1000 * 1000;
+  // Bounds the size of the index. A jump in time past this many buckets restarts the index, and
+  // the oldest buckets are dropped when it grows beyond it.
+  static constexpr int64_t kMaxBuckets = 1 << 18;
+
+  explicit TimeIndex(int64_t bucket_ns = kDefaultBucketNS) : bucket_ns_(bucket_ns) {}
+
+  /**
+   * Records the batch with the given sequence number, whose greatest time is max_time.
+   */
+  void AddBatch(int64_t seq, int64_t max_time);
+
+  /**
+   * Drops the buckets in which all the batches precede first_seq, the oldest batch still in the
+   * table.
+   */
+  void Expire(int64_t first_seq);
+
+  /**
+   * Returns the range of sequence numbers [lo, hi] that holds the first batch with a time greater
+   * than or equal to the given time, if there is one. The range may extend past the batches that
+   * are still in the table.
+   *
+   * @return false if the index is empty.
+   */
+  bool Lookup(int64_t time, int64_t* lo, int64_t* hi) const;
+
+  void Clear();
+
+  int64_t NumBuckets() const { return first_seqs_.size(); }
+
+ private:
+  int64_t Bucket(int64_t time) const;
+
+  const int64_t bucket_ns_;
+  int64_t first_bucket_ = 0;
+  // first_seqs_[i] is the first batch whose greatest time is in bucket first_bucket_ + i or later.
+  std::deque<int64_t> first_seqs_;
+  int64_t last_seq_ = -1;
+};
+
+}  // namespace table_store
+}  // namespace px
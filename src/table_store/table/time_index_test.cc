@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/testing/testing.h"
+#include "src/table_store/table/time_index.h"
+
+namespace px {
+namespace table_store {
+
+TEST(TimeIndexTest, empty) {
+  TimeIndex index(/* bucket_ns */ 10);
+  int64_t lo;
+  int64_t hi;
+  EXPECT_FALSE(index.Lookup(5, &lo, &hi));
+}
+
+TEST(TimeIndexTest, lookup_bounds_the_batch) {
+  TimeIndex index(/* bucket_ns */ 10);
+  // Batch 0 ends at 4, 1 and 2 in bucket 1, 3 jumps to bucket 4.
+  index.AddBatch(0, 4);
+  index.AddBatch(1, 12);
+  index.AddBatch(2, 18);
+  index.AddBatch(3, 45);
+  EXPECT_EQ(index.NumBuckets(), 5);
+
+  int64_t lo;
+  int64_t hi;
+  ASSERT_TRUE(index.Lookup(3, &lo, &hi));
+  EXPECT_EQ(lo, 0);
+  EXPECT_EQ(hi, 1);
+
+  ASSERT_TRUE(index.Lookup(15, &lo, &hi));
+  EXPECT_EQ(lo, 1);
+  EXPECT_EQ(hi, 3);
+
+  // Buckets 2 and 3 hold no batch, so they point at the next one.
+  ASSERT_TRUE(index.Lookup(25, &lo, &hi));
+  EXPECT_EQ(lo, 3);
+  EXPECT_EQ(hi, 3);
+
+  ASSERT_TRUE(index.Lookup(100, &lo, &hi));
+  EXPECT_EQ(lo, 3);
+  EXPECT_EQ(hi, 3);
+
+  ASSERT_TRUE(index.Lookup(-5, &lo, &hi));
+  EXPECT_EQ(lo, 0);
+  EXPECT_EQ(hi, 0);
+}
+
+TEST(TimeIndexTest, expire_retires_whole_buckets) {
+  TimeIndex index(/* bucket_ns */ 10);
+  index.AddBatch(0, 4);
+  index.AddBatch(1, 8);
+  index.AddBatch(2, 12);
+  index.AddBatch(3, 25);
+
+  // Batch 1 is still in the first bucket.
+  index.Expire(1);
+  EXPECT_EQ(index.NumBuckets(), 3);
+  index.Expire(2);
+  EXPECT_EQ(index.NumBuckets(), 2);
+
+  int64_t lo;
+  int64_t hi;
+  ASSERT_TRUE(index.Lookup(5, &lo, &hi));
+  EXPECT_EQ(lo, 0);
+  EXPECT_EQ(hi, 2);
+}
+
+TEST(TimeIndexTest, restarts_on_large_jump) {
+  TimeIndex index(/* bucket_ns */ 1);
+  index.AddBatch(0, 0);
+  index.AddBatch(1, 10 * TimeIndex::kMaxBuckets);
+  EXPECT_EQ(index.NumBuckets(), 1);
+
+  int64_t lo;
+  int64_t hi;
+  ASSERT_TRUE(index.Lookup(5, &lo, &hi));
+  EXPECT_EQ(lo, 0);
+  EXPECT_EQ(hi, 1);
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+void SetInt64Range(const int64_t* vals, int64_t n, ColumnZone* zone) {
+  if (n == 0) {
+    return;
+  }
+  auto [min_it, max_it] = std::minmax_element(vals, vals + n);
+  zone->has_range = true;
+  zone->min = *min_it;
+  zone->max = *max_it;
+}
+
+template <typename TGetter>
+void SetUInt128Range(TGetter get, int64_t n, ColumnZone* zone) {
+  if (n == 0) {
+    return;
+  }
+  absl::uint128 min = get(0);
+  absl::uint128 max = min;
+  for (int64_t i = 1; i < n; ++i) {
+    absl::uint128 val = get(i);
+    min = std::min(min, val);
+    max = std::max(max, val);
+  }
+  zone->has_range = true;
+  zone->min_uint128 = min;
+  zone->max_uint128 = max;
+}
+
+}  // namespace
+
+ColumnZone ColumnZone::FromArrow(types::DataType data_type, const arrow::Array* arr) {
+  ColumnZone zone;
+  zone.num_rows = arr->length();
+  // Batches with nulls do not get a range, which leaves them unskippable.
+  if (arr->null_count() != 0) {
+    return zone;
+  }
+
+  switch (data_type) {
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+      SetInt64Range(static_cast<const arrow::Int64Array*>(arr)->raw_values(), arr->length(),
+                    &zone);
+      break;
+    case types::DataType::UINT128: {
+      auto uint128_arr = static_cast<const arrow::UInt128Array*>(arr);
+      SetUInt128Range([uint128_arr](int64_t i) -> absl::uint128 { return uint128_arr->Value(i); },
+                      arr->length(), &zone);
+      break;
+    }
+    default:
+      break;
+  }
+  return zone;
+}
+
+ColumnZone ColumnZone::FromColumnWrapper(const types::ColumnWrapper& col) {
+  ColumnZone zone;
+  zone.num_rows = col.Size();
+
+  switch (col.data_type()) {
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS: {
+      // Int64Value and Time64NSValue are a single int64_t, so the raw data can be scanned as one.
+      static_assert(sizeof(types::Int64Value) == sizeof(int64_t));
+      static_assert(sizeof(types::Time64NSValue) == sizeof(int64_t));
+      auto vals = reinterpret_cast<const int64_t*>(col.UnsafeRawData());
+      SetInt64Range(vals, zone.num_rows, &zone);
+      break;
+    }
+    case types::DataType::UINT128: {
+      auto vals = static_cast<const types::UInt128Value*>(col.UnsafeRawData());
+      SetUInt128Range([vals](int64_t i) { return vals[i].val; }, zone.num_rows, &zone);
+      break;
+    }
+    default:
+      break;
+  }
+  return zone;
+}
+
+}  // namespace table_store
+}  // namespace px
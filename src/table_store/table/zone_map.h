@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+
+#include <absl/numeric/int128.h>
+#include "src/shared/types/column_wrapper.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * A ColumnZone is the zone map of a single column batch: its row count, plus the min/max of its
+ * values for INT64, TIME64NS and UINT128 columns. Readers use it to skip a batch without
+ * decoding it. The MayContain/MayOverlap checks are conservative: they only return false when the
+ * batch is guaranteed to hold no matching value.
+ */
+struct ColumnZone {
+  int64_t num_rows = 0;
+  bool has_range = false;
+
+  // Valid for INT64 and TIME64NS columns.
+  int64_t min = 0;
+  int64_t max = 0;
+
+  // Valid for UINT128 columns.
+  absl::uint128 min_uint128 = 0;
+  absl::uint128 max_uint128 = 0;
+
+  bool MayOverlap(int64_t lo, int64_t hi) const {
+    return num_rows > 0 && (!has_range || (lo <= max && hi >= min));
+  }
+  bool MayContain(int64_t val) const { return MayOverlap(val, val); }
+  bool MayContain(absl::uint128 val) const {
+    return num_rows > 0 && (!has_range || (val >= min_uint128 && val <= max_uint128));
+  }
+
+  static ColumnZone FromArrow(types::DataType data_type, const arrow::Array* arr);
+  static ColumnZone FromColumnWrapper(const types::ColumnWrapper& col);
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace table_store {
+
+TEST(ColumnZoneTest, int64_from_arrow) {
+  std::vector<types::Int64Value> vals = {5, -3, 12, 7};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  auto zone = ColumnZone::FromArrow(types::DataType::INT64, arr.get());
+  EXPECT_EQ(zone.num_rows, 4);
+  EXPECT_TRUE(zone.has_range);
+  EXPECT_EQ(zone.min, -3);
+  EXPECT_EQ(zone.max, 12);
+
+  EXPECT_TRUE(zone.MayContain(int64_t{7}));
+  EXPECT_TRUE(zone.MayContain(int64_t{0}));
+  EXPECT_FALSE(zone.MayContain(int64_t{13}));
+  EXPECT_TRUE(zone.MayOverlap(12, 100));
+  EXPECT_FALSE(zone.MayOverlap(-10, -4));
+}
+
+TEST(ColumnZoneTest, time_from_column_wrapper) {
+  auto col = types::ColumnWrapper::Make(types::DataType::TIME64NS, 0);
+  col->Append<types::Time64NSValue>(100);
+  col->Append<types::Time64NSValue>(200);
+  col->Append<types::Time64NSValue>(300);
+
+  auto zone = ColumnZone::FromColumnWrapper(*col);
+  EXPECT_EQ(zone.num_rows, 3);
+  EXPECT_TRUE(zone.has_range);
+  EXPECT_EQ(zone.min, 100);
+  EXPECT_EQ(zone.max, 300);
+}
+
+TEST(ColumnZoneTest, uint128) {
+  std::vector<types::UInt128Value> vals = {{1, 5}, {1, 2}, {2, 0}};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  auto zone = ColumnZone::FromArrow(types::DataType::UINT128, arr.get());
+  EXPECT_TRUE(zone.has_range);
+  EXPECT_EQ(zone.min_uint128, absl::MakeUint128(1, 2));
+  EXPECT_EQ(zone.max_uint128, absl::MakeUint128(2, 0));
+  EXPECT_TRUE(zone.MayContain(absl::MakeUint128(1, 9)));
+  EXPECT_FALSE(zone.MayContain(absl::MakeUint128(1, 1)));
+
+  auto wrapper = types::ColumnWrapper::FromArrow(arr);
+  auto wrapper_zone = ColumnZone::FromColumnWrapper(*wrapper);
+  EXPECT_EQ(wrapper_zone.min_uint128, zone.min_uint128);
+  EXPECT_EQ(wrapper_zone.max_uint128, zone.max_uint128);
+}
+
+TEST(ColumnZoneTest, untracked_types_are_never_skipped) {
+  std::vector<types::StringValue> vals = {"a", "b"};
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  auto zone = ColumnZone::FromArrow(types::DataType::STRING, arr.get());
+  EXPECT_EQ(zone.num_rows, 2);
+  EXPECT_FALSE(zone.has_range);
+  EXPECT_TRUE(zone.MayContain(int64_t{42}));
+}
+
+TEST(ColumnZoneTest, empty_batch_is_always_skipped) {
+  std::vector<types::Int64Value> vals;
+  auto arr = types::ToArrow(vals, arrow::default_memory_pool());
+
+  auto zone = ColumnZone::FromArrow(types::DataType::INT64, arr.get());
+  EXPECT_EQ(zone.num_rows, 0);
+  EXPECT_FALSE(zone.MayContain(int64_t{0}));
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -18,26 +18,36 @@
 
 #include "src/vizier/funcs/md_udtfs/md_udtfs.h"
 
+#include <memory>
+
 #include "src/carnot/udf/udf.h"
 #include "src/common/base/base.h"
 #include "src/vizier/funcs/context/vizier_context.h"
 #include "src/vizier/funcs/md_udtfs/md_udtfs_impl.h"
 
+DEFINE_int64(md_udtf_cache_ttl_ms, gflags::Int64FromEnv("PL_MD_UDTF_CACHE_TTL_MS", 2000),
+             "How long the metadata UDTFs reuse a metadata service response before refetching it. "
+             "0 disables the cache.");
+
 namespace px {
 namespace vizier {
 namespace funcs {
 namespace md {
 
 void RegisterFuncsOrDie(const VizierFuncFactoryContext& ctx, carnot::udf::Registry* registry) {
-  registry->RegisterFactoryOrDie<GetTables, UDTFWithMDFactory<GetTables>>("GetTables", ctx);
-  registry->RegisterFactoryOrDie<GetTableSchemas, UDTFWithMDFactory<GetTableSchemas>>("GetSchemas",
-                                                                                      ctx);
-  registry->RegisterFactoryOrDie<GetAgentStatus, UDTFWithMDFactory<GetAgentStatus>>(
-      "GetAgentStatus", ctx);
+  // GetTables and GetSchemas both come from the same GetSchemas RPC.
+  auto schema_cache = std::make_shared<SchemaResponseCache>();
+  registry->RegisterFactoryOrDie<GetTables, UDTFWithCachedMDFactory<GetTables>>("GetTables", ctx,
+                                                                                schema_cache);
+  registry->RegisterFactoryOrDie<GetTableSchemas, UDTFWithCachedMDFactory<GetTableSchemas>>(
+      "GetSchemas", ctx, schema_cache);
+  registry->RegisterFactoryOrDie<GetAgentStatus, UDTFWithCachedMDFactory<GetAgentStatus>>(
+      "GetAgentStatus", ctx, std::make_shared<AgentInfoResponseCache>());
 
   registry->RegisterOrDie<GetDebugMDState>("_DebugMDState");
   registry->RegisterFactoryOrDie<GetDebugTableInfo, UDTFWithTableStoreFactory<GetDebugTableInfo>>(
       "_DebugTableInfo", ctx.table_store());
+  registry->RegisterOrDie<GetDebugSelfProfile>("_DebugSelfProfile");
 
   registry->RegisterFactoryOrDie<GetUDFList, UDTFWithRegistryFactory<GetUDFList>>("GetUDFList",
                                                                                   registry);
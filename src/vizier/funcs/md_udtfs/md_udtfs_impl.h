@@ -22,25 +22,130 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
 #include <absl/numeric/int128.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
 #include <magic_enum.hpp>
 
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/udf.h"
 #include "src/common/base/base.h"
+#include "src/common/perf/self_profile.h"
 #include "src/common/uuid/uuid.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DECLARE_int64(md_udtf_cache_ttl_ms);
+
 namespace px {
 namespace vizier {
 namespace funcs {
 namespace md {
+
+/**
+ * MDSResponseCache keeps the last response of a metadata service call for
+ * FLAGS_md_udtf_cache_ttl_ms, so that UI views which run the same metadata UDTFs over and over
+ * don't make an RPC for every query.
+ */
+template <typename TResponse>
+class MDSResponseCache {
+ public:
+  using FetchFn = std::function<Status(TResponse*)>;
+
+  /**
+   * Returns the cached response, or nullptr if there is none or it has expired.
+   */
+  std::shared_ptr<const TResponse> Lookup() {
+    absl::MutexLock lock(&mu_);
+    return LookupLocked();
+  }
+
+  /**
+   * Returns the cached response, or calls fetch to get a new one if it has expired. Concurrent
+   * callers wait for a single fetch instead of each making the call.
+   */
+  StatusOr<std::shared_ptr<const TResponse>> GetOrFetch(const FetchFn& fetch) {
+    absl::MutexLock lock(&mu_);
+    auto resp = LookupLocked();
+    if (resp != nullptr) {
+      return resp;
+    }
+    auto new_resp = std::make_shared<TResponse>();
+    PL_RETURN_IF_ERROR(fetch(new_resp.get()));
+    resp_ = new_resp;
+    fetch_time_ = std::chrono::steady_clock::now();
+    return resp_;
+  }
+
+ private:
+  std::shared_ptr<const TResponse> LookupLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (resp_ == nullptr || std::chrono::steady_clock::now() - fetch_time_ >
+                                std::chrono::milliseconds(FLAGS_md_udtf_cache_ttl_ms)) {
+      return nullptr;
+    }
+    return resp_;
+  }
+
+  absl::Mutex mu_;
+  std::shared_ptr<const TResponse> resp_ ABSL_GUARDED_BY(mu_);
+  std::chrono::steady_clock::time_point fetch_time_ ABSL_GUARDED_BY(mu_);
+};
+
+/**
+ * AsyncMDSResponse makes a metadata service call off of the Carnot thread. UDTFs start it in Init
+ * and poll it from Ready.
+ */
+template <typename TResponse>
+class AsyncMDSResponse {
+ public:
+  using FetchFn = typename MDSResponseCache<TResponse>::FetchFn;
+
+  void Start(std::shared_ptr<MDSResponseCache<TResponse>> cache, FetchFn fetch) {
+    resp_ = cache->Lookup();
+    if (resp_ != nullptr) {
+      return;
+    }
+    future_ = std::async(std::launch::async, [cache = std::move(cache), fetch = std::move(fetch)] {
+      return cache->GetOrFetch(fetch);
+    });
+  }
+
+  /**
+   * Returns whether the response has arrived, or the error if the call failed.
+   */
+  StatusOr<bool> Ready() {
+    if (resp_ != nullptr) {
+      return true;
+    }
+    if (!future_.valid()) {
+      return error::Internal("Metadata service call was never started");
+    }
+    if (future_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return false;
+    }
+    PL_ASSIGN_OR_RETURN(resp_, future_.get());
+    return true;
+  }
+
+  /**
+   * The response, nullptr until Ready returns true.
+   */
+  const std::shared_ptr<const TResponse>& resp() const { return resp_; }
+
+ private:
+  std::shared_ptr<const TResponse> resp_;
+  std::future<StatusOr<std::shared_ptr<const TResponse>>> future_;
+};
+
 template <typename TUDTF>
 class UDTFWithMDFactory : public carnot::udf::UDTFFactory {
  public:
@@ -55,6 +160,28 @@ class UDTFWithMDFactory : public carnot::udf::UDTFFactory {
   const VizierFuncFactoryContext& ctx_;
 };
 
+/**
+ * Creates UDTFs that call the metadata service through a response cache shared by all of the
+ * UDTFs from this factory.
+ */
+template <typename TUDTF>
+class UDTFWithCachedMDFactory : public carnot::udf::UDTFFactory {
+ public:
+  using ResponseCache = typename TUDTF::ResponseCache;
+  UDTFWithCachedMDFactory() = delete;
+  UDTFWithCachedMDFactory(const VizierFuncFactoryContext& ctx,
+                          std::shared_ptr<ResponseCache> cache)
+      : ctx_(ctx), cache_(std::move(cache)) {}
+
+  std::unique_ptr<carnot::udf::AnyUDTF> Make() override {
+    return std::make_unique<TUDTF>(ctx_.mds_stub(), ctx_.add_auth_to_grpc_context_func(), cache_);
+  }
+
+ private:
+  const VizierFuncFactoryContext& ctx_;
+  std::shared_ptr<ResponseCache> cache_;
+};
+
 template <typename TUDTF>
 class UDTFWithMDTPFactory : public carnot::udf::UDTFFactory {
  public:
@@ -98,17 +225,54 @@ class UDTFWithTableStoreFactory : public carnot::udf::UDTFFactory {
   const ::px::table_store::TableStore* table_store_;
 };
 
+using MDSStub = vizier::services::metadata::MetadataService::Stub;
+using SchemaResponseCache = MDSResponseCache<vizier::services::metadata::SchemaResponse>;
+using AgentInfoResponseCache = MDSResponseCache<vizier::services::metadata::AgentInfoResponse>;
+
+inline SchemaResponseCache::FetchFn FetchSchemas(
+    std::shared_ptr<MDSStub> stub,
+    std::function<void(grpc::ClientContext*)> add_context_authentication) {
+  return [stub, add_context_authentication](vizier::services::metadata::SchemaResponse* resp) {
+    px::vizier::services::metadata::SchemaRequest req;
+    grpc::ClientContext ctx;
+    add_context_authentication(&ctx);
+    auto s = stub->GetSchemas(&ctx, req, resp);
+    if (!s.ok()) {
+      return error::Internal("Failed to make RPC call to metadata service");
+    }
+    return Status::OK();
+  };
+}
+
+inline AgentInfoResponseCache::FetchFn FetchAgentInfo(
+    std::shared_ptr<MDSStub> stub,
+    std::function<void(grpc::ClientContext*)> add_context_authentication) {
+  return [stub, add_context_authentication](vizier::services::metadata::AgentInfoResponse* resp) {
+    px::vizier::services::metadata::AgentInfoRequest req;
+    grpc::ClientContext ctx;
+    add_context_authentication(&ctx);
+    auto s = stub->GetAgentInfo(&ctx, req, resp);
+    if (!s.ok()) {
+      return error::Internal("Failed to make RPC call to GetAgentInfo");
+    }
+    return Status::OK();
+  };
+}
+
 /**
  * This UDTF fetches all the tables that are available to query from the MDS.
  */
 class GetTables final : public carnot::udf::UDTF<GetTables> {
  public:
-  using MDSStub = vizier::services::metadata::MetadataService::Stub;
-  using SchemaResponse = vizier::services::metadata::SchemaResponse;
+  using ResponseCache = SchemaResponseCache;
   GetTables() = delete;
   GetTables(std::shared_ptr<MDSStub> stub,
-            std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+            std::function<void(grpc::ClientContext*)> add_context_authentication,
+            std::shared_ptr<ResponseCache> cache)
+      : idx_(0),
+        stub_(stub),
+        add_context_authentication_func_(add_context_authentication),
+        cache_(std::move(cache)) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -120,31 +284,28 @@ class GetTables final : public carnot::udf::UDTF<GetTables> {
   }
 
   Status Init(FunctionContext*) {
-    px::vizier::services::metadata::SchemaRequest req;
-    px::vizier::services::metadata::SchemaResponse resp;
-
-    grpc::ClientContext ctx;
-    add_context_authentication_func_(&ctx);
-    auto s = stub_->GetSchemas(&ctx, req, &resp);
-    if (!s.ok()) {
-      return error::Internal("Failed to make RPC call to metadata service");
-    }
-
-    for (const auto& [table_name, rel] : resp.schema().relation_map()) {
-      table_info_.emplace_back(table_name, rel.desc());
-    }
+    resp_.Start(cache_, FetchSchemas(stub_, add_context_authentication_func_));
     return Status::OK();
   }
 
-  bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    if (!table_info_.size()) {
-      return false;
+  StatusOr<bool> Ready(FunctionContext*) {
+    PL_ASSIGN_OR_RETURN(bool ready, resp_.Ready());
+    if (ready) {
+      table_info_.clear();
+      for (const auto& [table_name, rel] : resp_.resp()->schema().relation_map()) {
+        table_info_.emplace_back(table_name, rel.desc());
+      }
     }
-    const auto& r = table_info_[idx_];
-    rw->Append<IndexOf("table_name")>(r.table_name);
-    rw->Append<IndexOf("table_desc")>(r.table_desc);
+    return ready;
+  }
 
-    idx_++;
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    int end = std::min(idx_ + max_records, static_cast<int>(table_info_.size()));
+    for (; idx_ < end; ++idx_) {
+      const auto& r = table_info_[idx_];
+      rw->Append<IndexOf("table_name")>(r.table_name);
+      rw->Append<IndexOf("table_desc")>(r.table_desc);
+    }
     return idx_ < static_cast<int>(table_info_.size());
   }
 
@@ -160,6 +321,8 @@ class GetTables final : public carnot::udf::UDTF<GetTables> {
   std::vector<TableInfo> table_info_;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
+  std::shared_ptr<ResponseCache> cache_;
+  AsyncMDSResponse<vizier::services::metadata::SchemaResponse> resp_;
 };
 
 /**
@@ -167,12 +330,15 @@ class GetTables final : public carnot::udf::UDTF<GetTables> {
  */
 class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
  public:
-  using MDSStub = vizier::services::metadata::MetadataService::Stub;
-  using SchemaResponse = vizier::services::metadata::SchemaResponse;
+  using ResponseCache = SchemaResponseCache;
   GetTableSchemas() = delete;
   GetTableSchemas(std::shared_ptr<MDSStub> stub,
-                  std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+                  std::function<void(grpc::ClientContext*)> add_context_authentication,
+                  std::shared_ptr<ResponseCache> cache)
+      : idx_(0),
+        stub_(stub),
+        add_context_authentication_func_(add_context_authentication),
+        cache_(std::move(cache)) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -188,40 +354,36 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
   }
 
   Status Init(FunctionContext*) {
-    px::vizier::services::metadata::SchemaRequest req;
-    px::vizier::services::metadata::SchemaResponse resp;
+    resp_.Start(cache_, FetchSchemas(stub_, add_context_authentication_func_));
+    return Status::OK();
+  }
 
-    grpc::ClientContext ctx;
-    add_context_authentication_func_(&ctx);
-    auto s = stub_->GetSchemas(&ctx, req, &resp);
-    if (!s.ok()) {
-      return error::Internal("Failed to make RPC call to metadata service");
+  StatusOr<bool> Ready(FunctionContext*) {
+    PL_ASSIGN_OR_RETURN(bool ready, resp_.Ready());
+    if (!ready) {
+      return false;
     }
-
-    // TODO(zasgar): We store the data since it's hard to traverse two maps at once. We should
-    // either do that or perhaps have an interface that allows UDTFs to write multiple records in
-    // a single invocation.
-    for (const auto& [table_name, rel] : resp.schema().relation_map()) {
+    // We flatten the columns since it's hard to traverse two maps at once across batches.
+    relation_info_.clear();
+    for (const auto& [table_name, rel] : resp_.resp()->schema().relation_map()) {
       for (const auto& col : rel.columns()) {
         relation_info_.emplace_back(table_name, col.column_name(),
                                     std::string(magic_enum::enum_name(col.column_type())),
                                     col.column_desc());
       }
     }
-    return Status::OK();
+    return true;
   }
 
-  bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    if (!relation_info_.size()) {
-      return false;
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    int end = std::min(idx_ + max_records, static_cast<int>(relation_info_.size()));
+    for (; idx_ < end; ++idx_) {
+      const auto& r = relation_info_[idx_];
+      rw->Append<IndexOf("table_name")>(r.table_name);
+      rw->Append<IndexOf("column_name")>(r.column_name);
+      rw->Append<IndexOf("column_type")>(r.column_type);
+      rw->Append<IndexOf("column_desc")>(r.column_desc);
     }
-    const auto& r = relation_info_[idx_];
-    rw->Append<IndexOf("table_name")>(r.table_name);
-    rw->Append<IndexOf("column_name")>(r.column_name);
-    rw->Append<IndexOf("column_type")>(r.column_type);
-    rw->Append<IndexOf("column_desc")>(r.column_desc);
-
-    idx_++;
     return idx_ < static_cast<int>(relation_info_.size());
   }
 
@@ -243,6 +405,8 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
   std::vector<RelationInfo> relation_info_;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
+  std::shared_ptr<ResponseCache> cache_;
+  AsyncMDSResponse<vizier::services::metadata::SchemaResponse> resp_;
 };
 
 /**
@@ -250,12 +414,15 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
  */
 class GetAgentStatus final : public carnot::udf::UDTF<GetAgentStatus> {
  public:
-  using MDSStub = vizier::services::metadata::MetadataService::Stub;
-  using SchemaResponse = vizier::services::metadata::SchemaResponse;
+  using ResponseCache = AgentInfoResponseCache;
   GetAgentStatus() = delete;
   GetAgentStatus(std::shared_ptr<MDSStub> stub,
-                 std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+                 std::function<void(grpc::ClientContext*)> add_context_authentication,
+                 std::shared_ptr<ResponseCache> cache)
+      : idx_(0),
+        stub_(stub),
+        add_context_authentication_func_(add_context_authentication),
+        cache_(std::move(cache)) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -277,47 +444,47 @@ class GetAgentStatus final : public carnot::udf::UDTF<GetAgentStatus> {
   }
 
   Status Init(FunctionContext*) {
-    px::vizier::services::metadata::AgentInfoRequest req;
-    resp_ = std::make_unique<px::vizier::services::metadata::AgentInfoResponse>();
-
-    grpc::ClientContext ctx;
-    add_context_authentication_func_(&ctx);
-    auto s = stub_->GetAgentInfo(&ctx, req, resp_.get());
-    if (!s.ok()) {
-      return error::Internal("Failed to make RPC call to GetAgentInfo");
-    }
+    resp_.Start(cache_, FetchAgentInfo(stub_, add_context_authentication_func_));
     return Status::OK();
   }
 
-  bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    const auto& agent_metadata = resp_->info(idx_);
-    const auto& agent_info = agent_metadata.agent();
-    const auto& agent_status = agent_metadata.status();
+  StatusOr<bool> Ready(FunctionContext*) { return resp_.Ready(); }
 
-    auto u_or_s = ParseUUID(agent_info.info().agent_id());
-    sole::uuid u;
-    if (u_or_s.ok()) {
-      u = u_or_s.ConsumeValueOrDie();
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    const auto& resp = resp_.resp();
+    if (resp == nullptr) {
+      return false;
     }
-    // TODO(zasgar): Figure out abort mechanism;
-
-    rw->Append<IndexOf("agent_id")>(absl::MakeUint128(u.ab, u.cd));
-    rw->Append<IndexOf("asid")>(agent_info.asid());
-    rw->Append<IndexOf("hostname")>(agent_info.info().host_info().hostname());
-    rw->Append<IndexOf("ip_address")>(agent_info.info().ip_address());
-    rw->Append<IndexOf("agent_state")>(StringValue(magic_enum::enum_name(agent_status.state())));
-    rw->Append<IndexOf("create_time")>(agent_info.create_time_ns());
-    rw->Append<IndexOf("last_heartbeat_ns")>(agent_status.ns_since_last_heartbeat());
-
-    ++idx_;
-    return idx_ < resp_->info_size();
+    int end = std::min(idx_ + max_records, resp->info_size());
+    for (; idx_ < end; ++idx_) {
+      const auto& agent_metadata = resp->info(idx_);
+      const auto& agent_info = agent_metadata.agent();
+      const auto& agent_status = agent_metadata.status();
+
+      auto u_or_s = ParseUUID(agent_info.info().agent_id());
+      sole::uuid u;
+      if (u_or_s.ok()) {
+        u = u_or_s.ConsumeValueOrDie();
+      }
+      // TODO(zasgar): Figure out abort mechanism;
+
+      rw->Append<IndexOf("agent_id")>(absl::MakeUint128(u.ab, u.cd));
+      rw->Append<IndexOf("asid")>(agent_info.asid());
+      rw->Append<IndexOf("hostname")>(agent_info.info().host_info().hostname());
+      rw->Append<IndexOf("ip_address")>(agent_info.info().ip_address());
+      rw->Append<IndexOf("agent_state")>(StringValue(magic_enum::enum_name(agent_status.state())));
+      rw->Append<IndexOf("create_time")>(agent_info.create_time_ns());
+      rw->Append<IndexOf("last_heartbeat_ns")>(agent_status.ns_since_last_heartbeat());
+    }
+    return idx_ < resp->info_size();
   }
 
  private:
   int idx_ = 0;
-  std::unique_ptr<px::vizier::services::metadata::AgentInfoResponse> resp_;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
+  std::shared_ptr<ResponseCache> cache_;
+  AsyncMDSResponse<vizier::services::metadata::AgentInfoResponse> resp_;
 };
 
 namespace internal {
@@ -609,6 +776,59 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
   std::vector<uint64_t> table_ids_;
 };
 
+/**
+ * This UDTF dumps the most recent self-profile of the agent threads on this node, as folded
+ * stack traces. The profile is empty unless the perf profiler runs with
+ * --stirling_profiler_self_profile.
+ */
+class GetDebugSelfProfile final : public carnot::udf::UDTF<GetDebugSelfProfile> {
+ public:
+  static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(
+        ColInfo("time_", types::DataType::TIME64NS, types::PatternType::GENERAL,
+                "When the profile was taken"),
+        ColInfo("asid", types::DataType::INT64, types::PatternType::GENERAL,
+                "The short ID of the agent"),
+        ColInfo("upid", types::DataType::UINT128, types::PatternType::GENERAL,
+                "The UPID of the profiled agent process"),
+        ColInfo("thread_role", types::DataType::STRING, types::PatternType::GENERAL,
+                "The role of the sampled thread"),
+        ColInfo("stack_trace", types::DataType::STRING, types::PatternType::GENERAL,
+                "The folded stack trace, rooted at the thread role"),
+        ColInfo("count", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of times the stack trace was sampled"));
+  }
+
+  Status Init(FunctionContext*) {
+    samples_ = profiler::SelfProfile::Global()->Snapshot(&time_ns_);
+    return Status::OK();
+  }
+
+  bool NextRecord(FunctionContext* ctx, RecordWriter* rw) {
+    if (current_idx_ >= samples_.size()) {
+      return false;
+    }
+
+    const auto& sample = samples_[current_idx_];
+    rw->Append<IndexOf("time_")>(time_ns_);
+    rw->Append<IndexOf("asid")>(ctx->metadata_state()->asid());
+    rw->Append<IndexOf("upid")>(sample.upid);
+    rw->Append<IndexOf("thread_role")>(StringValue(profiler::ThreadRoleName(sample.role)));
+    rw->Append<IndexOf("stack_trace")>(sample.stack_trace);
+    rw->Append<IndexOf("count")>(static_cast<int64_t>(sample.count));
+
+    ++current_idx_;
+    return current_idx_ < samples_.size();
+  }
+
+ private:
+  size_t current_idx_ = 0;
+  int64_t time_ns_ = 0;
+  std::vector<profiler::SelfProfileSample> samples_;
+};
+
 /**
  * This UDTF fetches information about tracepoints from MDS.
  */
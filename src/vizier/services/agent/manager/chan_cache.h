@@ -20,9 +20,11 @@
 
 #include <grpcpp/grpcpp.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <absl/base/internal/spinlock.h>
 #include <absl/container/flat_hash_map.h>
@@ -41,15 +43,20 @@ class ChanCache {
    * channel to be out of use. This is in place to prevent a race where we add a Chan and
    * CleanupChans() is called before the Connection can be used, meaning the channel will come up
    * idle.
+   * @param chans_per_addr the number of channels to pool for each remote address. Each channel
+   * should be created with its own subchannel pool (GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL), so that
+   * the streams to a busy remote are spread over several connections.
    */
-  explicit ChanCache(std::chrono::nanoseconds warm_up_period) : warm_up_period_(warm_up_period) {}
+  explicit ChanCache(std::chrono::nanoseconds warm_up_period, size_t chans_per_addr = 1)
+      : warm_up_period_(warm_up_period), chans_per_addr_(std::max<size_t>(chans_per_addr, 1)) {}
   // Template to handle other duration types.
   template <typename T>
-  explicit ChanCache(std::chrono::duration<int64_t, T> warm_up_period)
-      : ChanCache(std::chrono::duration_cast<std::chrono::nanoseconds>(warm_up_period)) {}
+  explicit ChanCache(std::chrono::duration<int64_t, T> warm_up_period, size_t chans_per_addr = 1)
+      : ChanCache(std::chrono::duration_cast<std::chrono::nanoseconds>(warm_up_period),
+                  chans_per_addr) {}
   /**
-   * @brief Gets the Chan at remote_addr. If the cache doesn't contain the channel, it returns a
-   * nullptr.
+   * @brief Gets a Chan at remote_addr, round robin over the pooled channels. If the pool for the
+   * address isn't full yet, it returns a nullptr so that the caller opens another channel.
    *
    * @param remote_addr the remote_address to look up.
    * @return std::shared_ptr<::grpc::Channel> the channel or a nullptr if not found.
@@ -57,7 +64,8 @@ class ChanCache {
   std::shared_ptr<::grpc::Channel> GetChan(std::string_view remote_addr);
 
   /**
-   * @brief Caches `chan` for the `remote_addr`.
+   * @brief Caches `chan` for the `remote_addr`. Channels added once the pool is full are not
+   * cached.
    *
    * @param remote_addr the remote address corresponding to the channel.
    * @param chan the channel to cache.
@@ -76,17 +84,29 @@ class ChanCache {
    */
   Status CleanupChans();
 
+  /**
+   * @return the number of channels pooled for remote_addr.
+   */
+  size_t NumChans(std::string_view remote_addr);
+
  private:
   struct Channel {
     std::shared_ptr<::grpc::Channel> chan;
     std::chrono::system_clock::time_point start_time;
   };
 
+  struct ChannelPool {
+    std::vector<Channel> chans;
+    // The index of the next channel to hand out.
+    size_t next = 0;
+  };
+
   // The cache of channels (grpc conns) made to other agents.
-  absl::flat_hash_map<std::string, Channel> chan_cache_ GUARDED_BY(chan_cache_lock_);
+  absl::flat_hash_map<std::string, ChannelPool> chan_cache_ GUARDED_BY(chan_cache_lock_);
   absl::base_internal::SpinLock chan_cache_lock_;
   // Connections that are alive for shorter than warm_up_period_ won't be cleared.
   std::chrono::nanoseconds warm_up_period_;
+  size_t chans_per_addr_;
 };
 }  // namespace agent
 }  // namespace vizier
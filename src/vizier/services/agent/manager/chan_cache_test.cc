@@ -171,6 +171,29 @@ TEST_F(ChanCacheTest, channel_idleness_triggers_gc) {
   EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), nullptr);
 }
 
+TEST_F(ChanCacheTest, pools_chans_per_addr) {
+  ChanCache chan_cache(std::chrono::minutes(5), /*chans_per_addr*/ 2);
+
+  auto channel1 = grpc::CreateChannel(GetServerAddress(), InsecureChannelCredentials());
+  chan_cache.Add(GetServerAddress(), channel1);
+  // The pool isn't full, so the caller should open another channel.
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), nullptr);
+
+  auto channel2 = grpc::CreateChannel(GetServerAddress(), InsecureChannelCredentials());
+  chan_cache.Add(GetServerAddress(), channel2);
+  EXPECT_EQ(chan_cache.NumChans(GetServerAddress()), 2);
+
+  // Channels added to a full pool aren't cached.
+  auto channel3 = grpc::CreateChannel(GetServerAddress(), InsecureChannelCredentials());
+  chan_cache.Add(GetServerAddress(), channel3);
+  EXPECT_EQ(chan_cache.NumChans(GetServerAddress()), 2);
+
+  // The pooled channels are handed out round robin.
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel1);
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel2);
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel1);
+}
+
 }  // namespace agent
 }  // namespace vizier
 }  // namespace px
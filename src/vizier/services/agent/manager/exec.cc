@@ -21,14 +21,22 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <jwt/jwt.hpp>
 
 #include "src/common/base/base.h"
 #include "src/common/event/task.h"
+#include "src/common/metrics/metrics_registry.h"
 #include "src/common/perf/perf.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_bool(agent_async_query_execution,
+            gflags::BoolFromEnv("PL_AGENT_ASYNC_QUERY_EXECUTION", false),
+            "Whether queries run in steps on the thread pool, instead of each holding a thread "
+            "while it waits for data from other agents. This lets an agent, usually a Kelvin, run "
+            "more queries at once than it has threads (see --agent_max_concurrent_queries).");
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -46,12 +54,37 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
         query_id_(ParseUUID(req_.query_id()).ConsumeValueOrDie()) {}
 
   sole::uuid query_id() { return query_id_; }
+  const messages::ExecuteQueryRequest& req() const { return req_; }
 
   void Work() override {
+    // The threadpool threads only run queries, so they keep this name after the query is done.
+    profiler::SetCurrentThreadRole(profiler::ThreadRole::kCarnotQuery);
     LOG(INFO) << absl::Substitute("Executing query: id=$0", query_id_.str());
     VLOG(1) << absl::Substitute("Query Plan: $0=$1", query_id_.str(), req_.plan().DebugString());
 
-    auto s = carnot_->ExecutePlan(req_.plan(), query_id_, req_.analyze());
+    LogResult(carnot_->ExecutePlan(req_.plan(), query_id_, req_.analyze()));
+  }
+
+  void Done() override { parent_->HandleQueryExecutionComplete(query_id_); }
+
+  /**
+   * Runs the query without holding a thread while it waits, see Carnot::ExecutePlanAsync(). Done()
+   * is called on the dispatcher's thread once the query completes.
+   */
+  void StartAsync(px::event::Dispatcher* dispatcher) {
+    LOG(INFO) << absl::Substitute("Executing query asynchronously: id=$0", query_id_.str());
+    VLOG(1) << absl::Substitute("Query Plan: $0=$1", query_id_.str(), req_.plan().DebugString());
+
+    carnot_->ExecutePlanAsync(req_.plan(), query_id_, req_.analyze(), dispatcher,
+                              [this](Status s) {
+                                LogResult(s);
+                                // This task is deleted here, so it must be the last call.
+                                Done();
+                              });
+  }
+
+ private:
+  void LogResult(const Status& s) {
     if (!s.ok()) {
       if (s.code() == px::statuspb::Code::CANCELLED) {
         LOG(WARNING) << absl::Substitute("Cancelled query: $0", query_id_.str());
@@ -64,9 +97,6 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
     }
   }
 
-  void Done() override { parent_->HandleQueryExecutionComplete(query_id_); }
-
- private:
   ExecuteQueryMessageHandler* parent_;
   carnot::Carnot* carnot_;
 
@@ -79,30 +109,100 @@ ExecuteQueryMessageHandler::ExecuteQueryMessageHandler(px::event::Dispatcher* di
                                                        Info* agent_info,
                                                        Manager::VizierNATSConnector* nats_conn,
                                                        carnot::Carnot* carnot)
-    : MessageHandler(dispatcher, agent_info, nats_conn), carnot_(carnot) {}
+    : MessageHandler(dispatcher, agent_info, nats_conn),
+      carnot_(carnot),
+      admission_(QueryAdmissionController::LimitsFromFlags()) {}
+
+ExecuteQueryMessageHandler::~ExecuteQueryMessageHandler() = default;
 
 Status ExecuteQueryMessageHandler::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
-  // Create a task and run it on the threadpool.
   auto task = std::make_unique<ExecuteQueryTask>(this, carnot_, std::move(msg));
 
   auto query_id = task->query_id();
+  std::vector<sole::uuid> expired;
+  auto decision = admission_.Submit(query_id, task->req().priority(),
+                                    EstimateQueryMemoryBytes(task->req().plan()),
+                                    QueryAdmissionController::Clock::now(), &expired);
+  DropExpiredQueries(expired);
+
+  switch (decision) {
+    case QueryAdmissionController::Decision::kRun:
+      StartQuery(std::move(task));
+      break;
+    case QueryAdmissionController::Decision::kQueued:
+      LOG(INFO) << absl::Substitute("Queued query: id=$0 (running=$1, queued=$2)", query_id.str(),
+                                    admission_.num_running(), admission_.num_queued());
+      queued_queries_[query_id] = std::move(task);
+      break;
+    case QueryAdmissionController::Decision::kRejected: {
+      bool shed = admission_.reject_background() &&
+                  task->req().priority() == messages::ExecuteQueryRequest::PRIORITY_BACKGROUND;
+      std::string_view reason = shed ? "load_shed" : "queue_full";
+      metrics::MetricsRegistry::Global()
+          ->GetCounter("agent_rejected_queries_total", "Queries that the agent refused to run.",
+                       {{"reason", std::string(reason)}})
+          ->Increment();
+      if (shed) {
+        LOG(ERROR) << absl::Substitute(
+            "Rejected query: id=$0, background queries are shed to stay in the CPU budget",
+            query_id.str());
+      } else {
+        LOG(ERROR) << absl::Substitute(
+            "Rejected query: id=$0, too many queries are waiting to run", query_id.str());
+      }
+      break;
+    }
+  }
+
+  return Status::OK();
+}
+
+void ExecuteQueryMessageHandler::StartQuery(std::unique_ptr<ExecuteQueryTask> task) {
+  auto query_id = task->query_id();
+  if (FLAGS_agent_async_query_execution) {
+    auto task_ptr = task.get();
+    LOG(INFO) << "Queries in flight: " << running_queries_.size() + async_queries_.size();
+    async_queries_[query_id] = std::move(task);
+    task_ptr->StartAsync(dispatcher());
+    return;
+  }
+
+  // Run the task on the threadpool.
   auto runnable = dispatcher()->CreateAsyncTask(std::move(task));
   auto runnable_ptr = runnable.get();
-  LOG(INFO) << "Queries in flight: " << running_queries_.size();
+  LOG(INFO) << "Queries in flight: " << running_queries_.size() + async_queries_.size();
   running_queries_[query_id] = std::move(runnable);
   runnable_ptr->Run();
+}
 
-  return Status::OK();
+void ExecuteQueryMessageHandler::DropExpiredQueries(const std::vector<sole::uuid>& query_ids) {
+  for (const auto& query_id : query_ids) {
+    LOG(ERROR) << absl::Substitute("Dropped query: id=$0, it waited too long to run",
+                                   query_id.str());
+    queued_queries_.erase(query_id);
+  }
 }
 
 void ExecuteQueryMessageHandler::HandleQueryExecutionComplete(sole::uuid query_id) {
   // Upon completion of the query, we makr the runnable task for deletion.
   auto node = running_queries_.extract(query_id);
-  if (node.empty()) {
+  if (!node.empty()) {
+    dispatcher()->DeferredDelete(std::move(node.mapped()));
+  } else if (!async_queries_.erase(query_id)) {
     LOG(ERROR) << "Attempting to delete non-existent query: " << query_id.str();
     return;
   }
-  dispatcher()->DeferredDelete(std::move(node.mapped()));
+
+  std::vector<sole::uuid> expired;
+  std::vector<sole::uuid> admitted =
+      admission_.Release(query_id, QueryAdmissionController::Clock::now(), &expired);
+  DropExpiredQueries(expired);
+  for (const auto& admitted_id : admitted) {
+    auto queued = queued_queries_.extract(admitted_id);
+    if (!queued.empty()) {
+      StartQuery(std::move(queued.mapped()));
+    }
+  }
 }
 
 }  // namespace agent
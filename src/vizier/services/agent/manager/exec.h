@@ -19,10 +19,12 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <absl/container/flat_hash_map.h>
 #include "src/carnot/plan/plan.h"
 #include "src/vizier/services/agent/manager/manager.h"
+#include "src/vizier/services/agent/manager/query_admission.h"
 #include "src/vizier/services/query_broker/querybrokerpb/service.grpc.pb.h"
 
 namespace px {
@@ -35,16 +37,24 @@ namespace agent {
  * otherwise only query execution is performed.
  *
  * This class runs all of it's work on a thread pool and tracks pending queries internally.
+ * With --agent_async_query_execution, queries don't hold a thread of the pool while they wait.
+ * Queries go through a QueryAdmissionController first, so they may wait for others to finish.
  */
 class ExecuteQueryMessageHandler : public Manager::MessageHandler {
  public:
   ExecuteQueryMessageHandler() = delete;
   ExecuteQueryMessageHandler(px::event::Dispatcher* dispatcher, Info* agent_info,
                              Manager::VizierNATSConnector* nats_conn, carnot::Carnot* carnot);
-  ~ExecuteQueryMessageHandler() override = default;
+  ~ExecuteQueryMessageHandler() override;
 
   Status HandleMessage(std::unique_ptr<messages::VizierMessage> msg) override;
 
+  /**
+   * Rejects the background queries that come in from now on, while set. Must be called from the
+   * dispatcher's thread, like HandleMessage.
+   */
+  void SetRejectBackgroundQueries(bool reject) { admission_.set_reject_background(reject); }
+
  protected:
   /**
    * HandleQueryExecutionComplete can be called by the async task to signal that work has been
@@ -56,10 +66,19 @@ class ExecuteQueryMessageHandler : public Manager::MessageHandler {
   // Forward declare private task class.
   class ExecuteQueryTask;
 
+  void StartQuery(std::unique_ptr<ExecuteQueryTask> task);
+  void DropExpiredQueries(const std::vector<sole::uuid>& query_ids);
+
   carnot::Carnot* carnot_;
 
+  QueryAdmissionController admission_;
+
   // Map from query_id -> Running query task.
   absl::flat_hash_map<sole::uuid, px::event::RunnableAsyncTaskUPtr> running_queries_;
+  // Map from query_id -> Query task running asynchronously (see --agent_async_query_execution).
+  absl::flat_hash_map<sole::uuid, std::unique_ptr<ExecuteQueryTask>> async_queries_;
+  // Map from query_id -> Query task waiting to be admitted.
+  absl::flat_hash_map<sole::uuid, std::unique_ptr<ExecuteQueryTask>> queued_queries_;
 };
 
 }  // namespace agent
@@ -180,7 +180,7 @@ Status K8sUpdateHandler::HandleK8sUpdate(const ResourceUpdate& update) {
 
 Status K8sUpdateHandler::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
   LOG_IF(FATAL, !msg->has_k8s_metadata_message()) << "Expected K8sMetadataMessage";
-  auto k8s_msg = msg->k8s_metadata_message();
+  const auto& k8s_msg = msg->k8s_metadata_message();
 
   if (k8s_msg.has_k8s_metadata_update()) {
     return HandleK8sUpdate(k8s_msg.k8s_metadata_update());
@@ -26,6 +26,7 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <jwt/jwt.hpp>
 
@@ -56,6 +57,11 @@ px::StatusOr<std::string> GetHostname() {
 
 DEFINE_string(jwt_signing_key, gflags::StringFromEnv("PL_JWT_SIGNING_KEY", ""),
               "The JWT signing key for outgoing requests");
+DEFINE_int32(agent_result_chans_per_addr, gflags::Int32FromEnv("PL_AGENT_RESULT_CHANS_PER_ADDR", 4),
+             "The number of gRPC connections to pool for each remote that results are sent to");
+DEFINE_int32(metrics_port, gflags::Int32FromEnv("PL_METRICS_PORT", 0),
+             "If non-zero, the agent serves its metrics on this port at /metrics, in the "
+             "Prometheus text format.");
 
 namespace px {
 namespace vizier {
@@ -122,11 +128,14 @@ Manager::Manager(sole::uuid agent_id, std::string_view pod_name, std::string_vie
 }
 
 Status Manager::Init() {
+  // Name the dispatcher thread first, so that the NATS client threads it starts inherit the name.
+  profiler::SetCurrentThreadRole(profiler::ThreadRole::kDispatcher);
   PL_ASSIGN_OR_RETURN(
       agent_metadata_filter_,
       md::AgentMetadataFilter::Create(kMetadataFilterMaxEntries, kMetadataFilterMaxErrorRate,
                                       md::kMetadataFilterEntities));
-  chan_cache_ = std::make_unique<ChanCache>(kChanIdleGracePeriod);
+  chan_cache_ = std::make_unique<ChanCache>(kChanIdleGracePeriod,
+                                            FLAGS_agent_result_chans_per_addr);
   auto hostname_or_s = GetHostname();
   if (!hostname_or_s.ok()) {
     return hostname_or_s.status();
@@ -136,6 +145,11 @@ Status Manager::Init() {
 
   LOG(INFO) << "Hostname: " << info_.hostname;
 
+  if (FLAGS_metrics_port != 0) {
+    metrics_server_ = std::make_unique<metrics::MetricsServer>(metrics::MetricsRegistry::Global());
+    PL_RETURN_IF_ERROR(metrics_server_->Start(FLAGS_metrics_port));
+  }
+
   // Set up the agent NATS connector.
   if (!has_nats_connection()) {
     LOG(WARNING) << "NATS is not configured, skip connecting. Stirling and Carnot might not behave "
@@ -186,6 +200,9 @@ Status Manager::Stop(std::chrono::milliseconds timeout) {
 
   dispatcher_->Stop();
   auto s = StopImpl(timeout);
+  if (metrics_server_ != nullptr) {
+    metrics_server_->Stop();
+  }
 
   // Wait for a limited amount of time for main thread to stop processing.
   std::chrono::time_point expiration_time = time_system_->MonotonicTime() + timeout;
@@ -249,14 +266,50 @@ Status Manager::RegisterMessageHandler(Manager::MsgCase c, std::shared_ptr<Messa
 
 void Manager::NATSMessageHandler(Manager::VizierNATSConnector::MsgType msg) {
   // NATS returns data to us in an arbritrary thread. We need to handle it in the event
-  // loop thread so we post to the event loop.
-
-  // This funny pointer stuff is required because we generate an std::function,
-  // that requires a copy of the lambda. The release allows us to recapture the value
-  // into another unique pointer.
-  messages::VizierMessage* m = msg.release();
-  dispatcher_->Post(
-      [m, this]() mutable { HandleMessage(std::unique_ptr<messages::VizierMessage>(m)); });
+  // loop thread, so we queue the message and post a drain of the queues to the event loop.
+  // Only one drain is posted at a time, so a burst of messages costs a single post.
+  bool post = false;
+  {
+    absl::base_internal::SpinLockHolder lock(&message_lanes_lock_);
+    if (msg->msg_case() == messages::VizierMessage::MsgCase::kK8SMetadataMessage) {
+      metadata_lane_.push_back(std::move(msg));
+    } else {
+      control_lane_.push_back(std::move(msg));
+    }
+    post = !drain_posted_;
+    drain_posted_ = true;
+  }
+  if (post) {
+    dispatcher_->Post([this]() { DrainMessageLanes(); });
+  }
+}
+
+void Manager::DrainMessageLanes() {
+  std::deque<std::unique_ptr<messages::VizierMessage>> control_msgs;
+  std::vector<std::unique_ptr<messages::VizierMessage>> metadata_msgs;
+  bool repost = false;
+  {
+    absl::base_internal::SpinLockHolder lock(&message_lanes_lock_);
+    control_msgs.swap(control_lane_);
+    while (!metadata_lane_.empty() && metadata_msgs.size() < kMaxMetadataMessagesPerTick) {
+      metadata_msgs.push_back(std::move(metadata_lane_.front()));
+      metadata_lane_.pop_front();
+    }
+    // Keep the drain posted while metadata is left over, messages queued in the meantime will
+    // be picked up by the next drain.
+    repost = !metadata_lane_.empty();
+    drain_posted_ = repost;
+  }
+
+  for (auto& msg : control_msgs) {
+    HandleMessage(std::move(msg));
+  }
+  for (auto& msg : metadata_msgs) {
+    HandleMessage(std::move(msg));
+  }
+  if (repost) {
+    dispatcher_->Post([this]() { DrainMessageLanes(); });
+  }
 }
 
 void Manager::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
@@ -344,6 +397,8 @@ std::unique_ptr<Manager::ResultSinkStub> Manager::ResultSinkStubGenerator(
   args.SetInt(GRPC_ARG_HTTP2_BDP_PROBE, 1);
   args.SetInt(GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS, 50000);
   args.SetInt(GRPC_ARG_HTTP2_MIN_SENT_PING_INTERVAL_WITHOUT_DATA_MS, 100000);
+  // Every pooled channel gets its own connection, instead of sharing the global subchannel.
+  args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
 
   chan = grpc::CreateCustomChannel(remote_addr, grpc_channel_creds_, args);
   chan_cache_->Add(remote_addr, chan);
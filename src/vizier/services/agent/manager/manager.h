@@ -20,15 +20,18 @@
 #include <grpcpp/grpcpp.h>
 
 #include <chrono>
+#include <deque>
 #include <memory>
 #include <string>
 #include <thread>
 #include <utility>
 
+#include <absl/base/internal/spinlock.h>
 #include "src/carnot/carnot.h"
 #include "src/common/base/base.h"
 #include "src/common/event/event.h"
 #include "src/common/event/nats.h"
+#include "src/common/metrics/metrics.h"
 #include "src/common/uuid/uuid.h"
 #include "src/shared/metadata/metadata.h"
 #include "src/vizier/funcs/context/vizier_context.h"
@@ -167,6 +170,7 @@ class Manager : public px::NotCopyable {
   std::unique_ptr<ResultSinkStub> ResultSinkStubGenerator(const std::string& remote_addr,
                                                           const std::string& ssl_targetname);
   void NATSMessageHandler(VizierNATSConnector::MsgType msg);
+  void DrainMessageLanes();
   Status RegisterBackgroundHelpers();
   Status PostRegisterHook(uint32_t asid);
   Status ReregisterHook();
@@ -183,6 +187,18 @@ class Manager : public px::NotCopyable {
   absl::flat_hash_map<MsgCase, std::shared_ptr<MessageHandler>> message_handlers_;
   void HandleMessage(std::unique_ptr<messages::VizierMessage> msg);
 
+  // Messages received from NATS that are waiting to be handled on the event loop. K8s metadata
+  // messages go in their own lane, which is drained a bounded number of messages per loop tick,
+  // so that a burst of metadata updates doesn't hold up query execution and heartbeats.
+  absl::base_internal::SpinLock message_lanes_lock_;
+  std::deque<std::unique_ptr<messages::VizierMessage>> control_lane_
+      GUARDED_BY(message_lanes_lock_);
+  std::deque<std::unique_ptr<messages::VizierMessage>> metadata_lane_
+      GUARDED_BY(message_lanes_lock_);
+  // Whether a drain of the lanes is already posted to the event loop.
+  bool drain_posted_ GUARDED_BY(message_lanes_lock_) = false;
+  static constexpr size_t kMaxMetadataMessagesPerTick = 64;
+
   // The timer to manage metadata updates.
   px::event::TimerUPtr metadata_update_timer_;
 
@@ -192,6 +208,9 @@ class Manager : public px::NotCopyable {
   std::unique_ptr<md::AgentMetadataFilter> agent_metadata_filter_;
   // Chan caches active connections to other Agents. Methods are all threadsafe.
   std::unique_ptr<ChanCache> chan_cache_;
+
+  // Serves /metrics, if --metrics_port is set.
+  std::unique_ptr<metrics::MetricsServer> metrics_server_;
   // The timer that runs the garbage collection routine.
   px::event::TimerUPtr chan_cache_garbage_collect_timer_;
 
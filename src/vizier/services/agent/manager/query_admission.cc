@@ -0,0 +1,163 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/manager/query_admission.h"
+
+#include <algorithm>
+
+DEFINE_int32(agent_max_concurrent_queries,
+             gflags::Int32FromEnv("PL_AGENT_MAX_CONCURRENT_QUERIES", 8),
+             "The number of queries an agent runs at once. Further queries wait in a queue.");
+DEFINE_int64(agent_query_memory_budget_bytes,
+             gflags::Int64FromEnv("PL_AGENT_QUERY_MEMORY_BUDGET_BYTES", 1024LL * 1024 * 1024),
+             "The total estimated memory of the queries an agent runs at once. Further queries "
+             "wait in a queue. Set to '0' to only limit the number of queries.");
+DEFINE_int32(agent_max_queued_queries, gflags::Int32FromEnv("PL_AGENT_MAX_QUEUED_QUERIES", 64),
+             "The number of queries that can wait to run on an agent. Further queries are "
+             "rejected.");
+DEFINE_int32(agent_query_queue_timeout_ms,
+             gflags::Int32FromEnv("PL_AGENT_QUERY_QUEUE_TIMEOUT_MS", 30000),
+             "How long a query can wait to run on an agent before it's rejected.");
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+namespace {
+
+// What any query needs for its execution state and the row batches in flight.
+constexpr int64_t kQueryBaseMemoryBytes = 16LL * 1024 * 1024;
+// Operators that hold on to (some of) their input.
+constexpr int64_t kStatefulOperatorMemoryBytes = 64LL * 1024 * 1024;
+
+}  // namespace
+
+int64_t EstimateQueryMemoryBytes(const carnot::planpb::Plan& plan) {
+  int64_t bytes = kQueryBaseMemoryBytes;
+  for (const auto& fragment : plan.nodes()) {
+    for (const auto& node : fragment.nodes()) {
+      switch (node.op().op_type()) {
+        case carnot::planpb::AGGREGATE_OPERATOR:
+        case carnot::planpb::JOIN_OPERATOR:
+        case carnot::planpb::SORT_OPERATOR:
+          bytes += kStatefulOperatorMemoryBytes;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  return bytes;
+}
+
+QueryAdmissionController::Limits QueryAdmissionController::LimitsFromFlags() {
+  Limits limits;
+  limits.max_running = std::max(1, FLAGS_agent_max_concurrent_queries);
+  limits.memory_budget_bytes = FLAGS_agent_query_memory_budget_bytes;
+  limits.max_queued = std::max(0, FLAGS_agent_max_queued_queries);
+  limits.queue_timeout = std::chrono::milliseconds(FLAGS_agent_query_queue_timeout_ms);
+  return limits;
+}
+
+bool QueryAdmissionController::CanRun(int64_t memory_bytes) const {
+  if (running_.empty()) {
+    return true;
+  }
+  if (num_running() >= limits_.max_running) {
+    return false;
+  }
+  return limits_.memory_budget_bytes <= 0 ||
+         memory_in_use_bytes_ + memory_bytes <= limits_.memory_budget_bytes;
+}
+
+void QueryAdmissionController::Start(const sole::uuid& query_id, int64_t memory_bytes) {
+  running_[query_id] = memory_bytes;
+  memory_in_use_bytes_ += memory_bytes;
+}
+
+QueryAdmissionController::Decision QueryAdmissionController::Submit(
+    const sole::uuid& query_id, Priority priority, int64_t memory_bytes, Clock::time_point now,
+    std::vector<sole::uuid>* expired) {
+  if (reject_background_ && priority == messages::ExecuteQueryRequest::PRIORITY_BACKGROUND) {
+    return Decision::kRejected;
+  }
+
+  // Queries that are already waiting go first, unless the new one has a higher priority.
+  bool queue_is_ahead = priority == messages::ExecuteQueryRequest::PRIORITY_INTERACTIVE
+                            ? !interactive_queue_.empty()
+                            : num_queued() > 0;
+  if (!queue_is_ahead && CanRun(memory_bytes)) {
+    Start(query_id, memory_bytes);
+    return Decision::kRun;
+  }
+
+  RemoveExpired(now, expired);
+  if (num_queued() >= limits_.max_queued) {
+    return Decision::kRejected;
+  }
+
+  QueuedQuery queued{query_id, memory_bytes, now + limits_.queue_timeout};
+  if (priority == messages::ExecuteQueryRequest::PRIORITY_BACKGROUND) {
+    background_queue_.push_back(queued);
+  } else {
+    interactive_queue_.push_back(queued);
+  }
+  return Decision::kQueued;
+}
+
+std::vector<sole::uuid> QueryAdmissionController::Release(const sole::uuid& query_id,
+                                                          Clock::time_point now,
+                                                          std::vector<sole::uuid>* expired) {
+  auto it = running_.find(query_id);
+  if (it != running_.end()) {
+    memory_in_use_bytes_ -= it->second;
+    running_.erase(it);
+  }
+
+  RemoveExpired(now, expired);
+
+  // Start the waiting queries in order, and stop at the first one that doesn't fit so that large
+  // queries aren't overtaken forever.
+  std::vector<sole::uuid> admitted;
+  for (auto* queue : {&interactive_queue_, &background_queue_}) {
+    while (!queue->empty() && CanRun(queue->front().memory_bytes)) {
+      Start(queue->front().query_id, queue->front().memory_bytes);
+      admitted.push_back(queue->front().query_id);
+      queue->pop_front();
+    }
+    if (!queue->empty()) {
+      break;
+    }
+  }
+  return admitted;
+}
+
+void QueryAdmissionController::RemoveExpired(Clock::time_point now,
+                                             std::vector<sole::uuid>* expired) {
+  for (auto* queue : {&interactive_queue_, &background_queue_}) {
+    // Each queue is in arrival order, so the deadlines only increase along it.
+    while (!queue->empty() && queue->front().deadline < now) {
+      expired->push_back(queue->front().query_id);
+      queue->pop_front();
+    }
+  }
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <sole.hpp>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/vizier/messages/messagespb/messages.pb.h"
+
+DECLARE_int32(agent_max_concurrent_queries);
+DECLARE_int64(agent_query_memory_budget_bytes);
+DECLARE_int32(agent_max_queued_queries);
+DECLARE_int32(agent_query_queue_timeout_ms);
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * EstimateQueryMemoryBytes gives a rough upper bound of the memory a query needs on this agent.
+ * It only looks at the plan, so it's based on the operators that hold state (aggregates, joins
+ * and sorts) rather than on the data they'll see.
+ */
+int64_t EstimateQueryMemoryBytes(const carnot::planpb::Plan& plan);
+
+/**
+ * QueryAdmissionController decides when the queries sent to an agent get to run, so that a burst
+ * of queries can't starve the agent (and Stirling, on PEMs) of CPU and memory.
+ *
+ * A query runs right away if doing so keeps the agent under both the concurrency limit and the
+ * memory budget. Otherwise it waits in a queue for its priority; when queries finish, the waiting
+ * ones are started interactive ones first, each priority in arrival order. A query that waits
+ * longer than the queue timeout, or that arrives when the queue is full, is rejected.
+ *
+ * Not thread-safe; the agent calls it from its event loop.
+ */
+class QueryAdmissionController : public NotCopyable {
+ public:
+  using Priority = messages::ExecuteQueryRequest::Priority;
+  using Clock = std::chrono::steady_clock;
+
+  struct Limits {
+    int max_running;
+    // At least one query always runs, however large its estimate. 0 disables the budget.
+    int64_t memory_budget_bytes;
+    int max_queued;
+    std::chrono::milliseconds queue_timeout;
+  };
+
+  /**
+   * @return the limits set by the --agent_* flags.
+   */
+  static Limits LimitsFromFlags();
+
+  explicit QueryAdmissionController(Limits limits) : limits_(limits) {}
+
+  enum class Decision { kRun, kQueued, kRejected };
+
+  /**
+   * Submits a new query. If it's queued, it's returned by a later call to Release once it can run.
+   * @param expired gets the queued queries that timed out.
+   */
+  Decision Submit(const sole::uuid& query_id, Priority priority, int64_t memory_bytes,
+                  Clock::time_point now, std::vector<sole::uuid>* expired);
+
+  /**
+   * Releases the resources of a query that finished running.
+   * @param expired gets the queued queries that timed out.
+   * @return the queued queries that can run now.
+   */
+  std::vector<sole::uuid> Release(const sole::uuid& query_id, Clock::time_point now,
+                                  std::vector<sole::uuid>* expired);
+
+  /**
+   * While set, new background queries are rejected right away, e.g. when the agent sheds load to
+   * stay in its CPU budget. The queries that already run or wait are left alone.
+   */
+  void set_reject_background(bool reject_background) { reject_background_ = reject_background; }
+  bool reject_background() const { return reject_background_; }
+
+  int num_running() const { return static_cast<int>(running_.size()); }
+  int num_queued() const {
+    return static_cast<int>(interactive_queue_.size() + background_queue_.size());
+  }
+  int64_t memory_in_use_bytes() const { return memory_in_use_bytes_; }
+
+ private:
+  struct QueuedQuery {
+    sole::uuid query_id;
+    int64_t memory_bytes;
+    Clock::time_point deadline;
+  };
+
+  bool CanRun(int64_t memory_bytes) const;
+  void Start(const sole::uuid& query_id, int64_t memory_bytes);
+  void RemoveExpired(Clock::time_point now, std::vector<sole::uuid>* expired);
+
+  const Limits limits_;
+
+  // The memory estimates of the running queries.
+  absl::flat_hash_map<sole::uuid, int64_t> running_;
+  int64_t memory_in_use_bytes_ = 0;
+
+  bool reject_background_ = false;
+
+  std::deque<QueuedQuery> interactive_queue_;
+  std::deque<QueuedQuery> background_queue_;
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/vizier/services/agent/manager/query_admission.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+using Decision = QueryAdmissionController::Decision;
+using Clock = QueryAdmissionController::Clock;
+
+constexpr auto kInteractive = messages::ExecuteQueryRequest::PRIORITY_INTERACTIVE;
+constexpr auto kBackground = messages::ExecuteQueryRequest::PRIORITY_BACKGROUND;
+
+class QueryAdmissionControllerTest : public ::testing::Test {
+ protected:
+  static QueryAdmissionController::Limits TestLimits() {
+    QueryAdmissionController::Limits limits;
+    limits.max_running = 2;
+    limits.memory_budget_bytes = 100;
+    limits.max_queued = 3;
+    limits.queue_timeout = std::chrono::seconds(10);
+    return limits;
+  }
+
+  QueryAdmissionControllerTest() : controller_(TestLimits()) {
+    for (int i = 0; i < 8; ++i) {
+      ids_.push_back(sole::uuid4());
+    }
+  }
+
+  QueryAdmissionController controller_;
+  std::vector<sole::uuid> ids_;
+  Clock::time_point now_ = Clock::now();
+  std::vector<sole::uuid> expired_;
+};
+
+TEST_F(QueryAdmissionControllerTest, concurrency_limit) {
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[0], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[1], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[2], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(2, controller_.num_running());
+  EXPECT_EQ(1, controller_.num_queued());
+
+  EXPECT_THAT(controller_.Release(ids_[0], now_, &expired_), ElementsAre(ids_[2]));
+  EXPECT_THAT(controller_.Release(ids_[1], now_, &expired_), IsEmpty());
+  EXPECT_EQ(1, controller_.num_running());
+  EXPECT_EQ(10, controller_.memory_in_use_bytes());
+  EXPECT_THAT(expired_, IsEmpty());
+}
+
+TEST_F(QueryAdmissionControllerTest, memory_budget) {
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[0], kInteractive, 80, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[1], kInteractive, 30, now_, &expired_));
+  EXPECT_THAT(controller_.Release(ids_[0], now_, &expired_), ElementsAre(ids_[1]));
+
+  // A query over the budget still runs once nothing else does.
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[2], kInteractive, 500, now_, &expired_));
+  EXPECT_THAT(controller_.Release(ids_[1], now_, &expired_), ElementsAre(ids_[2]));
+  EXPECT_EQ(500, controller_.memory_in_use_bytes());
+}
+
+TEST_F(QueryAdmissionControllerTest, interactive_goes_first) {
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[0], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[1], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[2], kBackground, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[3], kInteractive, 10, now_, &expired_));
+
+  EXPECT_THAT(controller_.Release(ids_[0], now_, &expired_), ElementsAre(ids_[3]));
+  EXPECT_THAT(controller_.Release(ids_[1], now_, &expired_), ElementsAre(ids_[2]));
+
+  // A background query doesn't overtake the queue even if it would fit.
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[4], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[5], kBackground, 10, now_, &expired_));
+  EXPECT_THAT(controller_.Release(ids_[2], now_, &expired_), ElementsAre(ids_[4]));
+}
+
+TEST_F(QueryAdmissionControllerTest, queue_limit_and_timeout) {
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[0], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[1], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[2], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[3], kBackground, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[4], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kRejected, controller_.Submit(ids_[5], kInteractive, 10, now_, &expired_));
+  EXPECT_THAT(expired_, IsEmpty());
+
+  // Once the queued queries time out, they make room for new ones.
+  auto later = now_ + std::chrono::seconds(11);
+  EXPECT_EQ(Decision::kQueued, controller_.Submit(ids_[6], kInteractive, 10, later, &expired_));
+  EXPECT_THAT(expired_, ElementsAre(ids_[2], ids_[4], ids_[3]));
+  EXPECT_EQ(1, controller_.num_queued());
+
+  expired_.clear();
+  EXPECT_THAT(controller_.Release(ids_[0], later, &expired_), ElementsAre(ids_[6]));
+  EXPECT_THAT(expired_, IsEmpty());
+}
+
+TEST_F(QueryAdmissionControllerTest, reject_background) {
+  controller_.set_reject_background(true);
+  EXPECT_EQ(Decision::kRejected, controller_.Submit(ids_[0], kBackground, 10, now_, &expired_));
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[1], kInteractive, 10, now_, &expired_));
+  EXPECT_EQ(10, controller_.memory_in_use_bytes());
+
+  controller_.set_reject_background(false);
+  EXPECT_EQ(Decision::kRun, controller_.Submit(ids_[2], kBackground, 10, now_, &expired_));
+}
+
+TEST(EstimateQueryMemoryBytesTest, counts_stateful_operators) {
+  carnot::planpb::Plan plan;
+  auto* fragment = plan.add_nodes();
+  fragment->add_nodes()->mutable_op()->set_op_type(carnot::planpb::MEMORY_SOURCE_OPERATOR);
+  fragment->add_nodes()->mutable_op()->set_op_type(carnot::planpb::MAP_OPERATOR);
+  int64_t base = EstimateQueryMemoryBytes(plan);
+
+  fragment->add_nodes()->mutable_op()->set_op_type(carnot::planpb::AGGREGATE_OPERATOR);
+  int64_t with_agg = EstimateQueryMemoryBytes(plan);
+  EXPECT_GT(with_agg, base);
+
+  plan.add_nodes()->add_nodes()->mutable_op()->set_op_type(carnot::planpb::JOIN_OPERATOR);
+  EXPECT_EQ(with_agg + (with_agg - base), EstimateQueryMemoryBytes(plan));
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -16,7 +16,11 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <string>
 #include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
 
 #include "src/vizier/services/agent/manager/relation_info_manager.h"
 
@@ -34,6 +38,25 @@ Status RelationInfoManager::AddRelationInfo(RelationInfo relation_info) {
   return Status::OK();
 }
 
+Status RelationInfoManager::AddRelationInfos(std::vector<RelationInfo> relation_infos) {
+  absl::base_internal::SpinLockHolder lock(&relation_info_map_lock_);
+  absl::flat_hash_set<std::string_view> names;
+  for (const auto& relation_info : relation_infos) {
+    if (relation_info_map_.contains(relation_info.name) ||
+        !names.insert(relation_info.name).second) {
+      return error::AlreadyExists("Relation '$0' already exists", relation_info.name);
+    }
+  }
+  for (auto& relation_info : relation_infos) {
+    std::string name = relation_info.name;
+    relation_info_map_[name] = std::move(relation_info);
+  }
+  if (!relation_infos.empty()) {
+    has_updates_ = true;
+  }
+  return Status::OK();
+}
+
 bool RelationInfoManager::HasRelation(std::string_view name) const {
   absl::base_internal::SpinLockHolder lock(&relation_info_map_lock_);
   return relation_info_map_.contains(name);
@@ -44,6 +44,15 @@ class RelationInfoManager {
    */
   Status AddRelationInfo(RelationInfo relation_info);
 
+  /**
+   * @brief Adds several relation infos under a single lock acquisition. If any of them
+   * conflicts with an existing relation (or another one in the batch), none are added.
+   *
+   * @param relation_infos: The new relations to add.
+   * @return Status: Error if a relation is a conflict.
+   */
+  Status AddRelationInfos(std::vector<RelationInfo> relation_infos);
+
   /**
    * Checks to see if a relation with the given name exists.
    * @param name The name of the relation.
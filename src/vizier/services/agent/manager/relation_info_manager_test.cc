@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "src/vizier/services/agent/manager/relation_info_manager.h"
 
@@ -90,6 +91,30 @@ TEST_F(RelationInfoManagerTest, test_update) {
   EXPECT_THAT(update_info, EqualsProto(kAgentUpdateInfoSchemaNoTablets));
 }
 
+TEST_F(RelationInfoManagerTest, test_batch_update) {
+  Relation relation0({types::TIME64NS, types::INT64}, {"time_", "count"});
+  Relation relation1({types::TIME64NS, types::FLOAT64}, {"time_", "gauge"});
+  std::vector<RelationInfo> relation_infos;
+  relation_infos.emplace_back("relation0", /* id */ 0, "desc0", relation0);
+  relation_infos.emplace_back("relation1", /* id */ 1, "desc1", relation1);
+
+  EXPECT_OK(relation_info_manager_->AddRelationInfos(std::move(relation_infos)));
+  EXPECT_TRUE(relation_info_manager_->has_updates());
+
+  messages::AgentUpdateInfo update_info;
+  relation_info_manager_->AddSchemaToUpdateInfo(&update_info);
+  EXPECT_THAT(update_info, EqualsProto(kAgentUpdateInfoSchemaNoTablets));
+
+  // A conflict rejects the whole batch.
+  Relation relation2({types::TIME64NS, types::INT64}, {"time_", "count"});
+  std::vector<RelationInfo> conflicting;
+  conflicting.emplace_back("relation2", /* id */ 2, "desc2", relation2);
+  conflicting.emplace_back("relation0", /* id */ 3, "desc0", relation0);
+  EXPECT_NOT_OK(relation_info_manager_->AddRelationInfos(std::move(conflicting)));
+  EXPECT_FALSE(relation_info_manager_->HasRelation("relation2"));
+  EXPECT_FALSE(relation_info_manager_->has_updates());
+}
+
 const char* kAgentUpdateInfoSchemaHasTablets = R"proto(
 does_update_schema: true
 schema {
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/async_data_pusher.h"
+
+#include <utility>
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+void AsyncDataPusher::Start() {
+  DCHECK(!thread_.joinable());
+  running_ = true;
+  thread_ = std::thread(&AsyncDataPusher::Run, this);
+}
+
+void AsyncDataPusher::Stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+Status AsyncDataPusher::Push(uint64_t table_id, types::TabletID tablet_id,
+                             std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch) {
+  if (num_queued_.fetch_add(1) >= max_queued_batches_) {
+    --num_queued_;
+    ++num_dropped_;
+    LOG_EVERY_N(WARNING, 100) << absl::Substitute(
+        "Table store is not keeping up, dropped a record batch for table $0 (dropped=$1)",
+        table_id, num_dropped_.load());
+    // Not an error for Stirling: the data is dropped on purpose, so that collection goes on.
+    return Status::OK();
+  }
+  queue_.enqueue(QueuedBatch{table_id, std::move(tablet_id), std::move(record_batch)});
+  return Status::OK();
+}
+
+void AsyncDataPusher::Run() {
+  constexpr auto kDequeueTimeout = std::chrono::milliseconds(100);
+
+  QueuedBatch batch;
+  // Keep going after Stop() until the queue is drained.
+  while (running_ || num_queued_ > 0) {
+    if (!queue_.wait_dequeue_timed(batch, kDequeueTimeout)) {
+      continue;
+    }
+    --num_queued_;
+
+    Status s = table_store_->AppendData(batch.table_id, std::move(batch.tablet_id),
+                                        std::move(batch.record_batch));
+    if (s.ok()) {
+      ++num_appended_;
+    } else {
+      ++num_append_errors_;
+      LOG_EVERY_N(ERROR, 100) << absl::Substitute("Failed to push data. Message = $0", s.msg());
+    }
+  }
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "blockingconcurrentqueue.h"
+
+#include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/table/table_store.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * AsyncDataPusher decouples Stirling from the table store. Its Push() is registered as Stirling's
+ * data push callback, and only queues the record batches on a lock-free queue. A consumer thread
+ * appends them to the table store, so stalls in the table store (eg. expiration, or contention
+ * with queries) don't delay the next BPF drain.
+ *
+ * The queue is bounded. When it is full, batches are dropped instead of blocking Stirling, and are
+ * counted in num_dropped().
+ */
+class AsyncDataPusher : public NotCopyable {
+ public:
+  AsyncDataPusher(table_store::TableStore* table_store, size_t max_queued_batches)
+      : table_store_(table_store), max_queued_batches_(max_queued_batches) {}
+
+  ~AsyncDataPusher() { Stop(); }
+
+  /**
+   * Starts the consumer thread.
+   */
+  void Start();
+
+  /**
+   * Stops the consumer thread, after it has appended the batches that are already queued.
+   */
+  void Stop();
+
+  /**
+   * Queues a record batch to be appended to the table store. Never blocks.
+   */
+  Status Push(uint64_t table_id, types::TabletID tablet_id,
+              std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch);
+
+  size_t num_queued() const { return num_queued_; }
+  int64_t num_appended() const { return num_appended_; }
+  int64_t num_append_errors() const { return num_append_errors_; }
+  int64_t num_dropped() const { return num_dropped_; }
+
+ private:
+  struct QueuedBatch {
+    uint64_t table_id = 0;
+    types::TabletID tablet_id;
+    std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch;
+  };
+
+  void Run();
+
+  table_store::TableStore* table_store_;
+  const size_t max_queued_batches_;
+
+  moodycamel::BlockingConcurrentQueue<QueuedBatch> queue_;
+  std::atomic<size_t> num_queued_ = 0;
+
+  std::atomic<int64_t> num_appended_ = 0;
+  std::atomic<int64_t> num_append_errors_ = 0;
+  std::atomic<int64_t> num_dropped_ = 0;
+
+  std::atomic<bool> running_ = false;
+  std::thread thread_;
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/async_data_pusher.h"
+
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+class AsyncDataPusherTest : public ::testing::Test {
+ protected:
+  static constexpr uint64_t kTableID = 1;
+
+  void SetUp() override {
+    table_store::schema::Relation rel({types::DataType::INT64}, {"col1"});
+    table_store_.AddTable(table_store::Table::Create(rel), "a", kTableID);
+  }
+
+  std::unique_ptr<types::ColumnWrapperRecordBatch> MakeRecordBatch() {
+    auto record_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col = std::make_shared<types::Int64ValueColumnWrapper>(0);
+    col->AppendFromVector(std::vector<types::Int64Value>{1, 2, 3});
+    record_batch->push_back(col);
+    return record_batch;
+  }
+
+  table_store::TableStore table_store_;
+};
+
+TEST_F(AsyncDataPusherTest, AppendsQueuedBatches) {
+  AsyncDataPusher pusher(&table_store_, /*max_queued_batches*/ 100);
+  pusher.Start();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_OK(pusher.Push(kTableID, "", MakeRecordBatch()));
+  }
+  pusher.Stop();
+
+  EXPECT_EQ(pusher.num_queued(), 0);
+  EXPECT_EQ(pusher.num_appended(), 10);
+  EXPECT_EQ(pusher.num_dropped(), 0);
+  EXPECT_EQ(table_store_.GetTable("a")->NumBatches(), 10);
+}
+
+TEST_F(AsyncDataPusherTest, DropsWhenFull) {
+  AsyncDataPusher pusher(&table_store_, /*max_queued_batches*/ 3);
+  // Nothing consumes the queue until Start().
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_OK(pusher.Push(kTableID, "", MakeRecordBatch()));
+  }
+  EXPECT_EQ(pusher.num_queued(), 3);
+  EXPECT_EQ(pusher.num_dropped(), 2);
+
+  pusher.Start();
+  pusher.Stop();
+  EXPECT_EQ(pusher.num_appended(), 3);
+  EXPECT_EQ(table_store_.GetTable("a")->NumBatches(), 3);
+}
+
+TEST_F(AsyncDataPusherTest, CountsAppendErrors) {
+  AsyncDataPusher pusher(&table_store_, /*max_queued_batches*/ 100);
+  pusher.Start();
+  // There is no table with this ID.
+  EXPECT_OK(pusher.Push(kTableID + 1, "", MakeRecordBatch()));
+  pusher.Stop();
+  EXPECT_EQ(pusher.num_appended(), 0);
+  EXPECT_EQ(pusher.num_append_errors(), 1);
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/cpu_governor.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
+#include "src/common/base/file.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+StatusOr<int64_t> ParseCGroupCPUUsageUsec(std::string_view cpu_stat) {
+  for (std::string_view line : absl::StrSplit(cpu_stat, '\n', absl::SkipWhitespace())) {
+    std::vector<std::string_view> fields = absl::StrSplit(line, ' ', absl::SkipWhitespace());
+    if (fields.size() != 2 || fields[0] != "usage_usec") {
+      continue;
+    }
+    int64_t usage_usec;
+    if (!absl::SimpleAtoi(fields[1], &usage_usec)) {
+      return error::Internal("Invalid usage_usec '$0' in cpu.stat", fields[1]);
+    }
+    return usage_usec;
+  }
+  return error::NotFound("No usage_usec in cpu.stat");
+}
+
+StatusOr<int64_t> ReadCGroupCPUUsageUsec(const std::string& cpu_stat_path) {
+  PL_ASSIGN_OR_RETURN(std::string cpu_stat, ReadFileToString(cpu_stat_path));
+  return ParseCGroupCPUUsageUsec(cpu_stat);
+}
+
+int CPUGovernor::Update(Clock::time_point now, int64_t usage_usec) {
+  if (!has_sample_) {
+    has_sample_ = true;
+    last_sample_time_ = now;
+    last_usage_usec_ = usage_usec;
+    return shed_level_;
+  }
+
+  int64_t elapsed_usec =
+      std::chrono::duration_cast<std::chrono::microseconds>(now - last_sample_time_).count();
+  if (elapsed_usec <= 0) {
+    return shed_level_;
+  }
+  // A counter that goes backwards (e.g. the cgroup was recreated) counts as no use.
+  int64_t used_usec = std::max<int64_t>(usage_usec - last_usage_usec_, 0);
+  usage_millicores_ = used_usec * 1000 / elapsed_usec;
+  last_sample_time_ = now;
+  last_usage_usec_ = usage_usec;
+
+  if (usage_millicores_ > budget_millicores_) {
+    shed_level_ = std::min(shed_level_ + 1, kMaxShedLevel);
+  } else if (usage_millicores_ < kLowWatermark * budget_millicores_) {
+    shed_level_ = std::max(shed_level_ - 1, 0);
+  }
+  return shed_level_;
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
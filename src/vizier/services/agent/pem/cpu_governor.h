@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * Parses the total CPU time, in microseconds, out of the contents of a cgroup v2 cpu.stat file.
+ */
+StatusOr<int64_t> ParseCGroupCPUUsageUsec(std::string_view cpu_stat);
+
+/**
+ * Reads the total CPU time, in microseconds, that the cgroup of cpu_stat_path has used.
+ */
+StatusOr<int64_t> ReadCGroupCPUUsageUsec(const std::string& cpu_stat_path);
+
+/**
+ * CPUGovernor keeps the PEM's CPU use around a budget, by picking a load shed level from the
+ * samples of its cgroup's CPU time.
+ *
+ * The level goes up one step each update that the CPU use is over the budget, up to
+ * kMaxShedLevel, and down one step each update that it's under kLowWatermark of the budget. In
+ * between, the level is kept, so that it doesn't flap as the shedding brings the use down.
+ *
+ * Not thread-safe; the PEM calls it from its event loop.
+ */
+class CPUGovernor : public NotCopyable {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Same as stirling::SourceConnector::kMaxLoadShedLevel.
+  static constexpr int kMaxShedLevel = 3;
+
+  // The fraction of the budget below which the level is lowered.
+  static constexpr double kLowWatermark = 0.8;
+
+  explicit CPUGovernor(int64_t budget_millicores) : budget_millicores_(budget_millicores) {
+    DCHECK_GT(budget_millicores, 0);
+  }
+
+  /**
+   * Takes a sample of the cgroup's total CPU time, and adjusts the level to the CPU use since the
+   * previous sample. The first sample keeps the level at 0.
+   * @return the new load shed level.
+   */
+  int Update(Clock::time_point now, int64_t usage_usec);
+
+  int shed_level() const { return shed_level_; }
+  // The CPU use between the last two samples, in thousandths of a CPU.
+  int64_t usage_millicores() const { return usage_millicores_; }
+  int64_t budget_millicores() const { return budget_millicores_; }
+
+ private:
+  const int64_t budget_millicores_;
+
+  bool has_sample_ = false;
+  Clock::time_point last_sample_time_;
+  int64_t last_usage_usec_ = 0;
+
+  int64_t usage_millicores_ = 0;
+  int shed_level_ = 0;
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/cpu_governor.h"
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+TEST(ParseCGroupCPUUsageUsecTest, Basic) {
+  constexpr char kCPUStat[] =
+      "usage_usec 123456\n"
+      "user_usec 100000\n"
+      "system_usec 23456\n"
+      "nr_periods 0\n";
+  ASSERT_OK_AND_EQ(ParseCGroupCPUUsageUsec(kCPUStat), 123456);
+
+  EXPECT_NOT_OK(ParseCGroupCPUUsageUsec("user_usec 100000\n"));
+  EXPECT_NOT_OK(ParseCGroupCPUUsageUsec("usage_usec lots\n"));
+}
+
+TEST(CPUGovernorTest, RaisesAndLowersTheLevel) {
+  // Half a CPU.
+  CPUGovernor governor(500);
+  auto now = CPUGovernor::Clock::now();
+  int64_t usage_usec = 1000000;
+
+  // Uses the given fraction of a CPU for the next second.
+  auto use = [&](double cpus) {
+    now += std::chrono::seconds(1);
+    usage_usec += static_cast<int64_t>(cpus * 1000000);
+    return governor.Update(now, usage_usec);
+  };
+
+  EXPECT_EQ(governor.Update(now, usage_usec), 0);
+
+  EXPECT_EQ(use(0.2), 0);
+  EXPECT_EQ(governor.usage_millicores(), 200);
+
+  // Over the budget, the level goes up a step at a time.
+  EXPECT_EQ(use(0.9), 1);
+  EXPECT_EQ(governor.usage_millicores(), 900);
+  EXPECT_EQ(use(0.9), 2);
+  EXPECT_EQ(use(0.9), 3);
+  EXPECT_EQ(use(0.9), CPUGovernor::kMaxShedLevel);
+
+  // Between the low watermark and the budget, it stays.
+  EXPECT_EQ(use(0.45), 3);
+
+  // Under the low watermark, it goes down a step at a time.
+  EXPECT_EQ(use(0.1), 2);
+  EXPECT_EQ(use(0.1), 1);
+  EXPECT_EQ(use(0.1), 0);
+  EXPECT_EQ(use(0.1), 0);
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
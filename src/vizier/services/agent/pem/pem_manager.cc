@@ -18,19 +18,73 @@
 
 #include "src/vizier/services/agent/pem/pem_manager.h"
 
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_split.h>
+
+#include "src/common/metrics/metrics_registry.h"
 #include "src/vizier/services/agent/manager/exec.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_bool(pem_async_data_push, gflags::BoolFromEnv("PL_PEM_ASYNC_DATA_PUSH", false),
+            "If true, Stirling hands its record batches to a queue that a separate thread appends "
+            "to the table store, so that table store stalls don't delay data collection.");
+DEFINE_uint32(pem_async_data_push_queue_size,
+              gflags::Uint32FromEnv("PL_PEM_ASYNC_DATA_PUSH_QUEUE_SIZE", 4096),
+              "The number of record batches that can wait to be appended to the table store, "
+              "when --pem_async_data_push is set. Batches beyond this are dropped.");
+DEFINE_bool(pem_demand_driven_collection,
+            gflags::BoolFromEnv("PL_PEM_DEMAND_DRIVEN_COLLECTION", false),
+            "If true, Stirling pauses the collection of the tables that no query read in the last "
+            "--pem_table_demand_window_secs, and that aren't in --pem_retained_tables.");
+DEFINE_int32(pem_table_demand_window_secs,
+             gflags::Int32FromEnv("PL_PEM_TABLE_DEMAND_WINDOW_SECS", 15 * 60),
+             "How long the tables stay in demand after they are read by a query, when "
+             "--pem_demand_driven_collection is set.");
+DEFINE_string(pem_retained_tables, gflags::StringFromEnv("PL_PEM_RETAINED_TABLES", ""),
+              "Comma separated tables that are always collected, even when nothing queries them, "
+              "when --pem_demand_driven_collection is set.");
+DEFINE_int32(pem_cpu_budget_millicores, gflags::Int32FromEnv("PL_PEM_CPU_BUDGET_MILLICORES", 0),
+             "The CPU the PEM aims to stay under, in thousandths of a CPU. Over it, Stirling "
+             "samples less often and captures less data, and background queries are rejected. "
+             "0 disables the budget.");
+DEFINE_string(pem_cpu_stat_path,
+              gflags::StringFromEnv("PL_PEM_CPU_STAT_PATH", "/sys/fs/cgroup/cpu.stat"),
+              "The cgroup v2 cpu.stat file that the PEM's CPU use is read from, when "
+              "--pem_cpu_budget_millicores is set.");
+
 namespace px {
 namespace vizier {
 namespace agent {
 
+namespace {
+// How often the demand for the tables is updated, once the first window has passed.
+constexpr auto kTableDemandUpdateInterval = std::chrono::seconds(10);
+// How often the CPU use is sampled, when --pem_cpu_budget_millicores is set. The load shed level
+// moves one step per sample.
+constexpr auto kCPUGovernorUpdateInterval = std::chrono::seconds(5);
+}  // namespace
+
 Status PEMManager::InitImpl() { return Status::OK(); }
 
 Status PEMManager::PostRegisterHookImpl() {
-  stirling_->RegisterDataPushCallback(std::bind(&table_store::TableStore::AppendData, table_store(),
-                                                std::placeholders::_1, std::placeholders::_2,
-                                                std::placeholders::_3));
+  if (FLAGS_pem_async_data_push) {
+    async_data_pusher_ =
+        std::make_unique<AsyncDataPusher>(table_store(), FLAGS_pem_async_data_push_queue_size);
+    async_data_pusher_->Start();
+    stirling_->RegisterDataPushCallback(std::bind(&AsyncDataPusher::Push, async_data_pusher_.get(),
+                                                  std::placeholders::_1, std::placeholders::_2,
+                                                  std::placeholders::_3));
+  } else {
+    stirling_->RegisterDataPushCallback(std::bind(&table_store::TableStore::AppendData,
+                                                  table_store(), std::placeholders::_1,
+                                                  std::placeholders::_2, std::placeholders::_3));
+  }
 
   // Enable use of USR1/USR2 for controlling Stirling debug.
   stirling_->RegisterUserDebugSignalHandlers();
@@ -42,21 +96,112 @@ Status PEMManager::PostRegisterHookImpl() {
   PL_RETURN_IF_ERROR(InitSchemas());
   PL_RETURN_IF_ERROR(stirling_->RunAsThread());
 
-  auto execute_query_handler = std::make_shared<ExecuteQueryMessageHandler>(
+  execute_query_handler_ = std::make_shared<ExecuteQueryMessageHandler>(
       dispatcher(), info(), agent_nats_connector(), carnot());
   PL_RETURN_IF_ERROR(RegisterMessageHandler(messages::VizierMessage::MsgCase::kExecuteQueryRequest,
-                                            execute_query_handler));
+                                            execute_query_handler_));
 
   tracepoint_manager_ =
       std::make_shared<TracepointManager>(dispatcher(), info(), agent_nats_connector(),
                                           stirling_.get(), table_store(), relation_info_manager());
   PL_RETURN_IF_ERROR(RegisterMessageHandler(messages::VizierMessage::MsgCase::kTracepointMessage,
                                             tracepoint_manager_));
+
+  if (FLAGS_pem_demand_driven_collection) {
+    if (!FLAGS_table_store_persistence_dir.empty()) {
+      // The persisted tables are all retained, so there is nothing to pause.
+      LOG(WARNING) << "Ignoring --pem_demand_driven_collection, since the tables are persisted.";
+    } else {
+      table_demand_timer_ =
+          dispatcher()->CreateTimer(std::bind(&PEMManager::UpdateTableDemand, this));
+      // Every table is in demand for the first window, so that the queries have the time to come
+      // in before anything is paused.
+      table_demand_timer_->EnableTimer(std::chrono::seconds(FLAGS_pem_table_demand_window_secs));
+    }
+  }
+
+  if (FLAGS_pem_cpu_budget_millicores > 0) {
+    cpu_governor_ = std::make_unique<CPUGovernor>(FLAGS_pem_cpu_budget_millicores);
+    cpu_governor_timer_ =
+        dispatcher()->CreateTimer(std::bind(&PEMManager::UpdateCPUGovernor, this));
+    cpu_governor_timer_->EnableTimer(kCPUGovernorUpdateInterval);
+  }
   return Status::OK();
 }
 
+void PEMManager::UpdateTableDemand() {
+  auto window = std::chrono::seconds(FLAGS_pem_table_demand_window_secs);
+  int64_t window_start_ns =
+      CurrentTimeNS() - std::chrono::duration_cast<std::chrono::nanoseconds>(window).count();
+  absl::flat_hash_set<std::string> table_names = table_store()->TablesReadSince(window_start_ns);
+  for (std::string_view table_name :
+       absl::StrSplit(FLAGS_pem_retained_tables, ',', absl::SkipWhitespace())) {
+    table_names.emplace(table_name);
+  }
+  stirling_->SetTableDemand(table_names);
+  table_demand_timer_->EnableTimer(kTableDemandUpdateInterval);
+}
+
+void PEMManager::UpdateCPUGovernor() {
+  cpu_governor_timer_->EnableTimer(kCPUGovernorUpdateInterval);
+
+  auto usage_usec_or = ReadCGroupCPUUsageUsec(FLAGS_pem_cpu_stat_path);
+  if (!usage_usec_or.ok()) {
+    LOG_FIRST_N(ERROR, 1) << absl::Substitute("Failed to read the CPU use of the PEM: $0",
+                                              usage_usec_or.msg());
+    return;
+  }
+  int prev_level = cpu_governor_->shed_level();
+  int level = cpu_governor_->Update(CPUGovernor::Clock::now(), usage_usec_or.ConsumeValueOrDie());
+
+  auto* registry = metrics::MetricsRegistry::Global();
+  static metrics::Gauge* const usage_gauge = registry->GetGauge(
+      "pem_cpu_usage_millicores", "The CPU the PEM used over the last sample, in millicores.");
+  static metrics::Gauge* const budget_gauge = registry->GetGauge(
+      "pem_cpu_budget_millicores", "The CPU the PEM aims to stay under, in millicores.");
+  static metrics::Gauge* const level_gauge =
+      registry->GetGauge("pem_load_shed_level", "How much load the PEM sheds, from 0 (none) up.");
+  usage_gauge->Set(cpu_governor_->usage_millicores());
+  budget_gauge->Set(cpu_governor_->budget_millicores());
+  level_gauge->Set(level);
+
+  if (level != prev_level) {
+    LOG(INFO) << absl::Substitute(
+        "Changing the load shed level from $0 to $1, the PEM used $2 of its $3 millicores.",
+        prev_level, level, cpu_governor_->usage_millicores(), cpu_governor_->budget_millicores());
+    registry
+        ->GetCounter("pem_load_shed_level_changes_total",
+                     "Changes of the PEM's load shed level, by direction.",
+                     {{"direction", level > prev_level ? "up" : "down"}})
+        ->Increment();
+    SetLoadShedLevel(level);
+  }
+}
+
+void PEMManager::SetLoadShedLevel(int level) {
+  // Stirling samples less often, and the socket tracer samples fewer connections and captures
+  // less of each message.
+  stirling_->SetLoadShedLevel(level);
+  // The queries that the UI runs in the background can wait for the load to go down.
+  execute_query_handler_->SetRejectBackgroundQueries(level > 0);
+}
+
 Status PEMManager::StopImpl(std::chrono::milliseconds) {
+  if (table_demand_timer_ != nullptr) {
+    table_demand_timer_->DisableTimer();
+  }
+  if (cpu_governor_timer_ != nullptr) {
+    cpu_governor_timer_->DisableTimer();
+  }
   stirling_->Stop();
+  if (async_data_pusher_ != nullptr) {
+    // Stirling is stopped, so this only appends the batches that are still queued.
+    async_data_pusher_->Stop();
+    LOG(INFO) << absl::Substitute(
+        "Async data push stats: appended=$0 append_errors=$1 dropped=$2",
+        async_data_pusher_->num_appended(), async_data_pusher_->num_append_errors(),
+        async_data_pusher_->num_dropped());
+  }
   return Status::OK();
 }
 
@@ -64,20 +209,43 @@ Status PEMManager::InitSchemas() {
   px::stirling::stirlingpb::Publish publish_pb;
   stirling_->GetPublishProto(&publish_pb);
   auto relation_info_vec = ConvertPublishPBToRelationInfo(publish_pb);
+  // The tables and relations are registered in one batch each, rather than taking the table store
+  // and relation locks once per table.
+  std::vector<table_store::TableStore::TableEntry> tables;
+  tables.reserve(relation_info_vec.size());
   for (const auto& relation_info : relation_info_vec) {
     std::shared_ptr<table_store::Table> table_ptr;
-    if (relation_info.name == "http_events") {
+    std::optional<table_store::MemoryShare> memory_share;
+    if (table_store()->memory_budget() != nullptr) {
+      // The tables can each grow to the whole budget, but expire each other's data past it.
+      table_ptr = std::make_shared<table_store::Table>(relation_info.relation,
+                                                       FLAGS_table_store_memory_budget);
+      memory_share = table_store::MemoryShare{};
+      if (relation_info.name == "http_events") {
+        // Four times the share of the other tables, like its 512Mi limit without a budget.
+        memory_share->weight = 4.0;
+      }
+    } else if (relation_info.name == "http_events") {
       // Make http_events hold 512Mi. This is a hack and will be removed once we have proactive
       // backup.
       table_ptr = std::make_shared<table_store::Table>(relation_info.relation, 1024 * 1024 * 512);
     } else {
       table_ptr = table_store::Table::Create(relation_info.relation);
     }
+    if (!FLAGS_table_store_persistence_dir.empty()) {
+      // The agent still collects data if the table can't be persisted.
+      auto s = table_ptr->EnablePersistence(
+          std::filesystem::path(FLAGS_table_store_persistence_dir) / relation_info.name);
+      if (!s.ok()) {
+        LOG(ERROR) << absl::Substitute("Failed to persist table $0: $1", relation_info.name,
+                                       s.msg());
+      }
+    }
 
-    table_store()->AddTable(std::move(table_ptr), relation_info.name, relation_info.id);
-    PL_RETURN_IF_ERROR(relation_info_manager()->AddRelationInfo(relation_info));
+    tables.push_back({std::move(table_ptr), relation_info.name, relation_info.id, memory_share});
   }
-  return Status::OK();
+  table_store()->AddTables(std::move(tables));
+  return relation_info_manager()->AddRelationInfos(std::move(relation_info_vec));
 }
 
 }  // namespace agent
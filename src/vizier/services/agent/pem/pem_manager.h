@@ -23,7 +23,10 @@
 #include <utility>
 
 #include "src/stirling/stirling.h"
+#include "src/vizier/services/agent/manager/exec.h"
 #include "src/vizier/services/agent/manager/manager.h"
+#include "src/vizier/services/agent/pem/async_data_pusher.h"
+#include "src/vizier/services/agent/pem/cpu_governor.h"
 #include "src/vizier/services/agent/pem/tracepoint_manager.h"
 
 namespace px {
@@ -63,14 +66,29 @@ class PEMManager : public Manager {
 
  private:
   Status InitSchemas();
+  // Tells Stirling which tables were queried recently or are retained, so that it can pause the
+  // collection of the others.
+  void UpdateTableDemand();
+  // Samples the PEM's CPU use, and sheds more or less load to stay in --pem_cpu_budget_millicores.
+  void UpdateCPUGovernor();
+  void SetLoadShedLevel(int level);
   static services::shared::agent::AgentCapabilities Capabilities() {
     services::shared::agent::AgentCapabilities capabilities;
     capabilities.set_collects_data(true);
     return capabilities;
   }
 
+  // Only set when --pem_async_data_push is set. Declared before stirling_, so that it outlives
+  // the Stirling thread that pushes to it.
+  std::unique_ptr<AsyncDataPusher> async_data_pusher_;
   std::unique_ptr<stirling::Stirling> stirling_;
+  std::shared_ptr<ExecuteQueryMessageHandler> execute_query_handler_;
   std::shared_ptr<TracepointManager> tracepoint_manager_;
+  // Only set when --pem_demand_driven_collection is set.
+  event::TimerUPtr table_demand_timer_;
+  // Only set when --pem_cpu_budget_millicores is set.
+  std::unique_ptr<CPUGovernor> cpu_governor_;
+  event::TimerUPtr cpu_governor_timer_;
 };
 
 }  // namespace agent
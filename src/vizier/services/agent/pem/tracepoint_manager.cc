@@ -16,8 +16,12 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
 
 #include "src/carnot/planner/dynamic_tracing/ir/logicalpb/logical.pb.h"
 #include "src/common/base/base.h"
@@ -215,23 +219,47 @@ void TracepointManager::Monitor() {
 Status TracepointManager::UpdateSchema(const stirling::stirlingpb::Publish& publish_pb) {
   auto relation_info_vec = ConvertPublishPBToRelationInfo(publish_pb);
 
-  // TODO(zasgar): Failure here can lead to an inconsistent schema state. We should
-  // figure out how to handle this as part of the data model refactor project.
+  // All the output tables are checked before any is added, so that an incompatible table doesn't
+  // leave the others half-registered. The new ones are then added in one batch.
+  std::vector<RelationInfo> new_relation_infos;
+  std::vector<table_store::TableStore::TableEntry> new_tables;
+  absl::flat_hash_map<std::string, const table_store::schema::Relation*> new_relations;
+  std::vector<const RelationInfo*> aliases;
   for (const auto& relation_info : relation_info_vec) {
-    if (!relation_info_manager_->HasRelation(relation_info.name)) {
-      table_store_->AddTable(table_store::Table::Create(relation_info.relation), relation_info.name,
-                             relation_info.id);
-      PL_RETURN_IF_ERROR(relation_info_manager_->AddRelationInfo(relation_info));
+    auto new_relation_it = new_relations.find(relation_info.name);
+    if (new_relation_it == new_relations.end() &&
+        !relation_info_manager_->HasRelation(relation_info.name)) {
+      if (table_store_->memory_budget() != nullptr) {
+        // Tracepoint tables share the budget of the agent's tables, see PEMManager::InitSchemas.
+        new_tables.push_back({std::make_shared<table_store::Table>(
+                                  relation_info.relation, FLAGS_table_store_memory_budget),
+                              relation_info.name, relation_info.id, table_store::MemoryShare{}});
+      } else {
+        new_tables.push_back({table_store::Table::Create(relation_info.relation),
+                              relation_info.name, relation_info.id});
+      }
+      new_relation_infos.push_back(relation_info);
+      new_relations.emplace(relation_info.name, &relation_info.relation);
     } else {
-      if (relation_info.relation != table_store_->GetTable(relation_info.name)->GetRelation()) {
+      const auto& relation = new_relation_it != new_relations.end()
+                                 ? *new_relation_it->second
+                                 : table_store_->GetTable(relation_info.name)->GetRelation();
+      if (relation_info.relation != relation) {
         return error::Internal(
             "Tracepoint is not compatible with the schema of the specified output table. "
             "[table_name=$0]",
             relation_info.name);
       }
-      PL_RETURN_IF_ERROR(table_store_->AddTableAlias(relation_info.id, relation_info.name));
+      aliases.push_back(&relation_info);
     }
   }
+
+  // The aliases of new tables are added after them.
+  table_store_->AddTables(std::move(new_tables));
+  PL_RETURN_IF_ERROR(relation_info_manager_->AddRelationInfos(std::move(new_relation_infos)));
+  for (const RelationInfo* relation_info : aliases) {
+    PL_RETURN_IF_ERROR(table_store_->AddTableAlias(relation_info->id, relation_info->name));
+  }
   return Status::OK();
 }
 
@@ -32,8 +32,10 @@ import (
 	"px.dev/pixie/src/vizier/utils/messagebus"
 )
 
-// LaunchQuery launches a query by sending query fragments to relevant agents.
-func LaunchQuery(queryID uuid.UUID, natsConn *nats.Conn, planMap map[uuid.UUID]*planpb.Plan, analyze bool) error {
+// LaunchQuery launches a query by sending query fragments to relevant agents. The agents queue the
+// query by its priority when they can't run it right away.
+func LaunchQuery(queryID uuid.UUID, natsConn *nats.Conn, planMap map[uuid.UUID]*planpb.Plan, analyze bool,
+	priority messagespb.ExecuteQueryRequest_Priority) error {
 	if len(planMap) == 0 {
 		return fmt.Errorf("Received no agent plans for query %s", queryID.String())
 	}
@@ -52,9 +54,10 @@ func LaunchQuery(queryID uuid.UUID, natsConn *nats.Conn, planMap map[uuid.UUID]*
 		msg := messagespb.VizierMessage{
 			Msg: &messagespb.VizierMessage_ExecuteQueryRequest{
 				ExecuteQueryRequest: &messagespb.ExecuteQueryRequest{
-					QueryID: queryIDPB,
-					Plan:    logicalPlan,
-					Analyze: analyze,
+					QueryID:  queryIDPB,
+					Plan:     logicalPlan,
+					Analyze:  analyze,
+					Priority: priority,
 				},
 			},
 		}
@@ -89,7 +89,7 @@ func TestLaunchQuery(t *testing.T) {
 	planMap[agentUUIDs[1]] = planPB2
 
 	// Execute a query.
-	err = controllers.LaunchQuery(queryUUID, nc, planMap, false)
+	err = controllers.LaunchQuery(queryUUID, nc, planMap, false, messagespb.PRIORITY_BACKGROUND)
 	require.NoError(t, err)
 
 	// Check that each agent received the correct message.
@@ -105,6 +105,7 @@ func TestLaunchQuery(t *testing.T) {
 
 	assert.Equal(t, planPB1, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.Plan)
 	assert.Equal(t, queryUUIDPb, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.QueryID)
+	assert.Equal(t, messagespb.PRIORITY_BACKGROUND, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.Priority)
 
 	m2, err := sub2.NextMsg(time.Second)
 	require.NoError(t, err)
@@ -113,6 +114,7 @@ func TestLaunchQuery(t *testing.T) {
 	require.NoError(t, err)
 	assert.Equal(t, planPB2, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.Plan)
 	assert.Equal(t, queryUUIDPb, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.QueryID)
+	assert.Equal(t, messagespb.PRIORITY_BACKGROUND, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.Priority)
 }
 
 func TestLaunchQueryNoPlans(t *testing.T) {
@@ -126,7 +128,7 @@ func TestLaunchQueryNoPlans(t *testing.T) {
 
 	planMap := make(map[uuid.UUID]*planpb.Plan)
 
-	err = controllers.LaunchQuery(queryUUID, nc, planMap, false)
+	err = controllers.LaunchQuery(queryUUID, nc, planMap, false, messagespb.PRIORITY_INTERACTIVE)
 
 	assert.NotNil(t, err)
 	assert.Regexp(t, fmt.Sprintf("Received no agent plans for query %s", queryIDStr), err)
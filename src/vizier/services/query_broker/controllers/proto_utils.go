@@ -140,11 +140,25 @@ func VizierQueryRequestToPlannerMutationRequest(vpb *vizierpb.ExecuteScriptReque
 	}, nil
 }
 
+func convertResultColumns(inputColumns map[string]*vizierpb.ExecuteScriptRequest_ResultColumns) map[string]*plannerpb.QueryRequest_ResultColumns {
+	if len(inputColumns) == 0 {
+		return nil
+	}
+	columns := make(map[string]*plannerpb.QueryRequest_ResultColumns, len(inputColumns))
+	for tableName, c := range inputColumns {
+		columns[tableName] = &plannerpb.QueryRequest_ResultColumns{
+			ColumnNames: c.GetColumnNames(),
+		}
+	}
+	return columns
+}
+
 // VizierQueryRequestToPlannerQueryRequest converts a externally-facing query request to an internal representation.
 func VizierQueryRequestToPlannerQueryRequest(vpb *vizierpb.ExecuteScriptRequest) (*plannerpb.QueryRequest, error) {
 	return &plannerpb.QueryRequest{
-		QueryStr:  vpb.QueryStr,
-		ExecFuncs: convertExecFuncs(vpb.ExecFuncs),
+		QueryStr:      vpb.QueryStr,
+		ExecFuncs:     convertExecFuncs(vpb.ExecFuncs),
+		ResultColumns: convertResultColumns(vpb.ResultColumns),
 	}, nil
 }
 
@@ -253,6 +253,30 @@ func TestVizierQueryRequestToPlannerQueryRequest(t *testing.T) {
 	assert.Equal(t, expectedQr, qr)
 }
 
+func TestVizierQueryRequestToPlannerQueryRequest_ResultColumns(t *testing.T) {
+	sv := new(vizierpb.ExecuteScriptRequest)
+	if err := proto.UnmarshalText(executeScriptReqPb, sv); err != nil {
+		t.Fatalf("Cannot unmarshal proto")
+	}
+	sv.ResultColumns = map[string]*vizierpb.ExecuteScriptRequest_ResultColumns{
+		"table1": {ColumnNames: []string{"time_", "cpu_usage"}},
+		"table2": {},
+	}
+
+	expectedQr := new(plannerpb.QueryRequest)
+	if err := proto.UnmarshalText(queryReqPb, expectedQr); err != nil {
+		t.Fatalf("Cannot unmarshal proto %v", err)
+	}
+	expectedQr.ResultColumns = map[string]*plannerpb.QueryRequest_ResultColumns{
+		"table1": {ColumnNames: []string{"time_", "cpu_usage"}},
+		"table2": {},
+	}
+
+	qr, err := controllers.VizierQueryRequestToPlannerQueryRequest(sv)
+	require.NoError(t, err)
+	assert.Equal(t, expectedQr, qr)
+}
+
 func TestStatusToVizierStatus(t *testing.T) {
 	sv := new(statuspb.Status)
 	if err := proto.UnmarshalText(unauthenticatedStatusPb, sv); err != nil {
@@ -27,6 +27,7 @@ import (
 	"github.com/spf13/cast"
 
 	"px.dev/pixie/src/carnot/planpb"
+	"px.dev/pixie/src/vizier/messages/messagespb"
 )
 
 // The prefix which a PL Config line should begin with.
@@ -38,6 +39,13 @@ var defaultQueryFlags = map[string]interface{}{
 	"explain":                   false,
 	"analyze":                   false,
 	"max_output_rows_per_table": 10000,
+	"priority":                  "interactive",
+}
+
+// The values of the priority flag, and the priority the agents run the query with.
+var queryPriorities = map[string]messagespb.ExecuteQueryRequest_Priority{
+	"interactive": messagespb.PRIORITY_INTERACTIVE,
+	"background":  messagespb.PRIORITY_BACKGROUND,
 }
 
 // QueryFlags represents a set of Pixie configuration flags.
@@ -125,6 +133,11 @@ func (f *QueryFlags) GetPlanOptions() *planpb.PlanOptions {
 	}
 }
 
+// GetQueryPriority gets the priority that the agents run the query with.
+func (f *QueryFlags) GetQueryPriority() messagespb.ExecuteQueryRequest_Priority {
+	return queryPriorities[f.GetString("priority")]
+}
+
 // ParseQueryFlags takes a query string containing some config options and generates
 // a QueryFlags object that can be used to retrieve those options.
 func ParseQueryFlags(queryStr string) (*QueryFlags, error) {
@@ -149,5 +162,9 @@ func ParseQueryFlags(queryStr string) (*QueryFlags, error) {
 		}
 	}
 
+	if _, ok := queryPriorities[qf.GetString("priority")]; !ok {
+		return nil, fmt.Errorf("%s is not a valid priority", qf.GetString("priority"))
+	}
+
 	return qf, nil
 }
@@ -24,6 +24,7 @@ import (
 	"github.com/stretchr/testify/assert"
 	"github.com/stretchr/testify/require"
 
+	"px.dev/pixie/src/vizier/messages/messagespb"
 	"px.dev/pixie/src/vizier/services/query_broker/controllers"
 )
 
@@ -50,6 +51,14 @@ const invalidFlag2 = `
 #px:set analyze,true
 `
 
+const backgroundPriorityFlag = `
+#px:set priority=background
+`
+
+const invalidPriorityFlag = `
+#px:set priority=urgent
+`
+
 const nonexistentFlag = `
 #px:set ABCD=efgh
 `
@@ -110,3 +119,16 @@ func TestParseQueryFlags_PlanOptions(t *testing.T) {
 	assert.Equal(t, options.Explain, false)
 	assert.Equal(t, options.Analyze, true)
 }
+
+func TestParseQueryFlags_Priority(t *testing.T) {
+	qf, err := controllers.ParseQueryFlags(validQueryWithoutFlag)
+	require.NoError(t, err)
+	assert.Equal(t, messagespb.PRIORITY_INTERACTIVE, qf.GetQueryPriority())
+
+	qf, err = controllers.ParseQueryFlags(backgroundPriorityFlag)
+	require.NoError(t, err)
+	assert.Equal(t, messagespb.PRIORITY_BACKGROUND, qf.GetQueryPriority())
+
+	_, err = controllers.ParseQueryFlags(invalidPriorityFlag)
+	assert.NotNil(t, err)
+}
@@ -43,6 +43,7 @@ import (
 	"px.dev/pixie/src/common/base/statuspb"
 	"px.dev/pixie/src/utils"
 	funcs "px.dev/pixie/src/vizier/funcs/go"
+	"px.dev/pixie/src/vizier/messages/messagespb"
 	"px.dev/pixie/src/vizier/services/metadata/metadatapb"
 	"px.dev/pixie/src/vizier/services/query_broker/querybrokerenv"
 	"px.dev/pixie/src/vizier/services/query_broker/querybrokerpb"
@@ -60,6 +61,8 @@ const (
 // Planner describes the interface for any planner.
 type Planner interface {
 	Plan(planState *distributedpb.LogicalPlannerState, req *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error)
+	UpdateState(version int64, planState *distributedpb.LogicalPlannerState) (*distributedpb.LogicalPlannerResult, error)
+	PlanWithState(version int64, planOptions *planpb.PlanOptions, req *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error)
 	CompileMutations(planState *distributedpb.LogicalPlannerState, request *plannerpb.CompileMutationsRequest) (*plannerpb.CompileMutationsResponse, error)
 	Free()
 }
@@ -80,6 +83,9 @@ type AgentsTracker interface {
 
 // Server defines an gRPC server type.
 type Server struct {
+	// The query broker only receives results, the agents don't ask it for join filters.
+	carnotpb.UnimplementedResultSinkServiceServer
+
 	env           querybrokerenv.QueryBrokerEnv
 	agentsTracker AgentsTracker
 	natsConn      *nats.Conn
@@ -93,6 +99,11 @@ type Server struct {
 	resultForwarder QueryResultForwarder
 
 	planner Planner
+	// Serializes the calls to plan queries, since the planner isn't thread-safe, and guards
+	// plannerStateVersion.
+	plannerMu sync.Mutex
+	// The newest version of the distributed state that was sent to the planner, 0 if none was.
+	plannerStateVersion int64
 }
 
 // NewServer creates GRPC handlers.
@@ -140,7 +151,8 @@ func (s *Server) Close() {
 // runQuery executes a query and streams the results to the client.
 // returns a bool for whether the query timed out and an error.
 func (s *Server) runQuery(ctx context.Context, req *plannerpb.QueryRequest, queryID uuid.UUID,
-	planOpts *planpb.PlanOptions, distributedState *distributedpb.DistributedState,
+	planOpts *planpb.PlanOptions, priority messagespb.ExecuteQueryRequest_Priority,
+	distributedState *distributedpb.DistributedState, stateVersion int64,
 	resultStream chan *vizierpb.ExecuteScriptResponse, doneCh chan bool) error {
 	log.WithField("query_id", queryID).Infof("Running script")
 	start := time.Now()
@@ -159,15 +171,9 @@ func (s *Server) runQuery(ctx context.Context, req *plannerpb.QueryRequest, quer
 	if info == nil {
 		return status.Error(codes.Unavailable, "not ready yet")
 	}
-	plannerState := &distributedpb.LogicalPlannerState{
-		DistributedState:    distributedState,
-		PlanOptions:         planOpts,
-		ResultAddress:       s.env.Address(),
-		ResultSSLTargetName: s.env.SSLTargetName(),
-	}
 
 	// Compile the query plan.
-	plannerResultPB, err := s.planner.Plan(plannerState, req)
+	plannerResultPB, err := s.plan(req, planOpts, distributedState, stateVersion)
 
 	if err != nil {
 		// send the compilation error and return nil.
@@ -230,7 +236,7 @@ func (s *Server) runQuery(ctx context.Context, req *plannerpb.QueryRequest, quer
 	if err != nil {
 		return err
 	}
-	err = LaunchQuery(queryID, s.natsConn, planMap, planOpts.Analyze)
+	err = LaunchQuery(queryID, s.natsConn, planMap, planOpts.Analyze, priority)
 	if err != nil {
 		s.resultForwarder.DeleteQuery(queryID)
 		return err
@@ -251,6 +257,38 @@ func (s *Server) runQuery(ctx context.Context, req *plannerpb.QueryRequest, quer
 		compilationTimeNs, queryPlanOpts)
 }
 
+// plan compiles the query against the given version of the distributed state. The state is only
+// sent to the planner when it changes, the planner keeps it resident for the queries that follow.
+func (s *Server) plan(req *plannerpb.QueryRequest, planOpts *planpb.PlanOptions,
+	distributedState *distributedpb.DistributedState, stateVersion int64) (*distributedpb.LogicalPlannerResult, error) {
+	plannerState := &distributedpb.LogicalPlannerState{
+		DistributedState:    distributedState,
+		ResultAddress:       s.env.Address(),
+		ResultSSLTargetName: s.env.SSLTargetName(),
+	}
+
+	s.plannerMu.Lock()
+	defer s.plannerMu.Unlock()
+	if stateVersion > s.plannerStateVersion {
+		res, err := s.planner.UpdateState(stateVersion, plannerState)
+		if err != nil {
+			return nil, err
+		}
+		if res.Status.ErrCode != statuspb.OK {
+			return res, nil
+		}
+		s.plannerStateVersion = stateVersion
+	}
+
+	res, err := s.planner.PlanWithState(stateVersion, planOpts, req)
+	if err != nil || res.Status.ErrCode != statuspb.NOT_FOUND {
+		return res, err
+	}
+	// The query started against a state the planner no longer has, which is sent along instead.
+	plannerState.PlanOptions = planOpts
+	return s.planner.Plan(plannerState, req)
+}
+
 func loadUDFInfo(udfInfoPb *udfspb.UDFInfo) error {
 	b, err := funcs.Asset("src/vizier/funcs/data/udf.pb")
 	if err != nil {
@@ -308,8 +346,10 @@ func (s *Server) CheckHealth(ctx context.Context) error {
 		}
 	}()
 
-	distributedState := s.agentsTracker.GetAgentInfo().DistributedState()
-	err = s.runQuery(ctx, req, queryID, planOpts, &distributedState, resultStream, doneCh)
+	distributedState, stateVersion := s.agentsTracker.GetAgentInfo().VersionedDistributedState()
+	// Nobody waits on the health check, so it doesn't hold up the scripts that users run.
+	err = s.runQuery(ctx, req, queryID, planOpts, messagespb.PRIORITY_BACKGROUND, &distributedState, stateVersion,
+		resultStream, doneCh)
 	if err != nil {
 		return fmt.Errorf("error running healthcheck query ID %s: %v", queryID.String(), err)
 	}
@@ -391,7 +431,7 @@ func (s *Server) ExecuteScript(req *vizierpb.ExecuteScriptRequest, srv vizierpb.
 
 	planOpts := flags.GetPlanOptions()
 
-	distributedState := s.agentsTracker.GetAgentInfo().DistributedState()
+	distributedState, stateVersion := s.agentsTracker.GetAgentInfo().VersionedDistributedState()
 
 	if req.Mutation {
 		mutationExec := NewMutationExecutor(s.planner, s.mdtp, s.mdconf, &distributedState)
@@ -447,7 +487,8 @@ func (s *Server) ExecuteScript(req *vizierpb.ExecuteScriptRequest, srv vizierpb.
 	}()
 
 	log.Infof("Launching query: %s", queryID)
-	err = s.runQuery(ctx, convertedReq, queryID, planOpts, &distributedState, resultStream, doneCh)
+	err = s.runQuery(ctx, convertedReq, queryID, planOpts, flags.GetQueryPriority(), &distributedState, stateVersion,
+		resultStream, doneCh)
 	wg.Wait()
 
 	if err != nil {
@@ -36,6 +36,7 @@ import (
 	mock_carnotpb "px.dev/pixie/src/carnot/carnotpb/mock"
 	"px.dev/pixie/src/carnot/planner/distributedpb"
 	"px.dev/pixie/src/carnot/queryresultspb"
+	"px.dev/pixie/src/common/base/statuspb"
 	"px.dev/pixie/src/shared/services/authcontext"
 	"px.dev/pixie/src/table_store/schemapb"
 	"px.dev/pixie/src/utils"
@@ -325,6 +326,21 @@ func (f *fakeResultForwarder) OptionallyCancelClientStream(queryID uuid.UUID, er
 	f.ClientStreamClosed = true
 }
 
+// expectPlan expects the planner to be sent the distributed state of plannerStatePB once, and
+// returns the expected call that plans the query against it.
+func expectPlan(planner *mock_controllers.MockPlanner, plannerStatePB *distributedpb.LogicalPlannerState) *gomock.Call {
+	residentStatePB := &distributedpb.LogicalPlannerState{
+		DistributedState:    plannerStatePB.DistributedState,
+		ResultAddress:       plannerStatePB.ResultAddress,
+		ResultSSLTargetName: plannerStatePB.ResultSSLTargetName,
+	}
+	planner.EXPECT().
+		UpdateState(int64(1), residentStatePB).
+		Return(&distributedpb.LogicalPlannerResult{Status: &statuspb.Status{ErrCode: statuspb.OK}}, nil)
+	return planner.EXPECT().
+		PlanWithState(int64(1), plannerStatePB.PlanOptions, gomock.Any())
+}
+
 func TestCheckHealth_Success(t *testing.T) {
 	// Start NATS.
 	nc, cleanup := testingutils.MustStartTestNATS(t)
@@ -389,8 +405,7 @@ func TestCheckHealth_Success(t *testing.T) {
 	}
 
 	planner := mock_controllers.NewMockPlanner(ctrl)
-	planner.EXPECT().
-		Plan(plannerStatePB, gomock.Any()).
+	expectPlan(planner, plannerStatePB).
 		Return(plannerResultPB, nil)
 
 	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
@@ -400,7 +415,7 @@ func TestCheckHealth_Success(t *testing.T) {
 	require.NoError(t, err)
 }
 
-func TestCheckHealth_CompilationError(t *testing.T) {
+func TestCheckHealth_PlannerStateIsResident(t *testing.T) {
 	// Start NATS.
 	nc, cleanup := testingutils.MustStartTestNATS(t)
 	defer cleanup()
@@ -424,13 +439,95 @@ func TestCheckHealth_CompilationError(t *testing.T) {
 		t.Fatal("Failed to create api environment.")
 	}
 
+	queryID := uuid.Must(uuid.NewV4())
+	fakeResult := &vizierpb.ExecuteScriptResponse{
+		QueryID: queryID.String(),
+		Result: &vizierpb.ExecuteScriptResponse_Data{
+			Data: &vizierpb.QueryData{
+				Batch: &vizierpb.RowBatchData{
+					TableID: "health_check_unused",
+					Cols: []*vizierpb.Column{
+						{
+							ColData: &vizierpb.Column_StringData{
+								StringData: &vizierpb.StringColumn{
+									Data: []string{
+										"foo",
+									},
+								},
+							},
+						},
+					},
+					NumRows: 1,
+					Eow:     true,
+					Eos:     true,
+				},
+			},
+		},
+	}
+
 	rf := &fakeResultForwarder{
-		ClientResultsToSend: []*vizierpb.ExecuteScriptResponse{},
+		ClientResultsToSend: []*vizierpb.ExecuteScriptResponse{
+			fakeResult,
+		},
+	}
+
+	// Not the actual health check query, but that's okay for the test since the planner and
+	// query execution are mocked out.
+	plannerResultPB := new(distributedpb.LogicalPlannerResult)
+	if err := proto.UnmarshalText(expectedPlannerResult, plannerResultPB); err != nil {
+		t.Fatal("Cannot Unmarshal protobuf.")
 	}
 
 	planner := mock_controllers.NewMockPlanner(ctrl)
+	// The state is only sent to the planner for the first query, the others plan against it.
+	expectPlan(planner, plannerStatePB).
+		Return(plannerResultPB, nil).
+		Times(2)
+	// Once the planner no longer has the state, the query comes with it.
+	planner.EXPECT().
+		PlanWithState(int64(1), gomock.Any(), gomock.Any()).
+		Return(&distributedpb.LogicalPlannerResult{Status: &statuspb.Status{ErrCode: statuspb.NOT_FOUND}}, nil)
 	planner.EXPECT().
 		Plan(plannerStatePB, gomock.Any()).
+		Return(plannerResultPB, nil)
+
+	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
+	require.NoError(t, err)
+	for i := 0; i < 3; i++ {
+		require.NoError(t, s.CheckHealth(context.Background()))
+	}
+}
+
+func TestCheckHealth_CompilationError(t *testing.T) {
+	// Start NATS.
+	nc, cleanup := testingutils.MustStartTestNATS(t)
+	defer cleanup()
+
+	// Set up mocks.
+	ctrl := gomock.NewController(t)
+	defer ctrl.Finish()
+
+	plannerStatePB := new(distributedpb.LogicalPlannerState)
+	if err := proto.UnmarshalText(singleAgentDistributedState, plannerStatePB); err != nil {
+		t.Fatal("Cannot Unmarshal protobuf.")
+	}
+	agentsInfo := tracker.NewTestAgentsInfo(plannerStatePB.DistributedState)
+	at := fakeAgentsTracker{
+		agentsInfo: agentsInfo,
+	}
+
+	// Set up server.
+	env, err := querybrokerenv.New("qb_address", "qb_hostname", "test")
+	if err != nil {
+		t.Fatal("Failed to create api environment.")
+	}
+
+	rf := &fakeResultForwarder{
+		ClientResultsToSend: []*vizierpb.ExecuteScriptResponse{},
+	}
+
+	planner := mock_controllers.NewMockPlanner(ctrl)
+	expectPlan(planner, plannerStatePB).
 		Return(nil, fmt.Errorf("some compiler error"))
 
 	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
@@ -477,8 +574,7 @@ func TestHealthCheck_ExecutionError(t *testing.T) {
 	}
 
 	planner := mock_controllers.NewMockPlanner(ctrl)
-	planner.EXPECT().
-		Plan(plannerStatePB, gomock.Any()).
+	expectPlan(planner, plannerStatePB).
 		Return(plannerResultPB, nil)
 
 	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
@@ -559,8 +655,7 @@ func TestExecuteScript_Success(t *testing.T) {
 	}
 
 	planner := mock_controllers.NewMockPlanner(ctrl)
-	planner.EXPECT().
-		Plan(plannerStatePB, gomock.Any()).
+	expectPlan(planner, plannerStatePB).
 		Return(plannerResultPB, nil)
 
 	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
@@ -638,8 +733,7 @@ func TestExecuteScript_PlannerErrorResult(t *testing.T) {
 		t.Fatal("Cannot Unmarshal protobuf failedPlannerResult", failedPlannerResult)
 	}
 	planner := mock_controllers.NewMockPlanner(ctrl)
-	planner.EXPECT().
-		Plan(plannerStatePB, gomock.Any()).
+	expectPlan(planner, plannerStatePB).
 		Return(badPlannerResultPB, nil)
 
 	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
@@ -721,8 +815,7 @@ func TestExecuteScript_ErrorInStatusResult(t *testing.T) {
 	}
 
 	planner := mock_controllers.NewMockPlanner(ctrl)
-	planner.EXPECT().
-		Plan(plannerStatePB, gomock.Any()).
+	expectPlan(planner, plannerStatePB).
 		Return(badPlannerResultPB, nil)
 
 	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
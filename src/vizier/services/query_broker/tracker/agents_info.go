@@ -41,12 +41,15 @@ type AgentsInfo interface {
 	ClearPendingState()
 	UpdateAgentsInfo(update *metadatapb.AgentUpdatesResponse) error
 	DistributedState() distributedpb.DistributedState
+	VersionedDistributedState() (distributedpb.DistributedState, int64)
 }
 
 // AgentsInfoImpl implements AgentsInfo to track information about the distributed state of the system.
 type AgentsInfoImpl struct {
 	ds distributedpb.DistributedState
-	// Controls access to ds.
+	// Bumped every time ds changes.
+	dsVersion int64
+	// Controls access to ds and dsVersion.
 	dsMutex sync.Mutex
 
 	pendingDs *distributedpb.DistributedState
@@ -55,7 +58,8 @@ type AgentsInfoImpl struct {
 // NewAgentsInfo creates an empty agents info.
 func NewAgentsInfo() AgentsInfo {
 	return &AgentsInfoImpl{
-		ds: distributedpb.DistributedState{},
+		ds:        distributedpb.DistributedState{},
+		dsVersion: 1,
 		pendingDs: &distributedpb.DistributedState{
 			SchemaInfo: []*distributedpb.SchemaInfo{},
 			CarnotInfo: []*distributedpb.CarnotInfo{},
@@ -67,6 +71,7 @@ func NewAgentsInfo() AgentsInfo {
 func NewTestAgentsInfo(ds *distributedpb.DistributedState) AgentsInfo {
 	return &AgentsInfoImpl{
 		ds:        *(ds),
+		dsVersion: 1,
 		pendingDs: nil,
 	}
 }
@@ -169,6 +174,7 @@ func (a *AgentsInfoImpl) UpdateAgentsInfo(update *metadatapb.AgentUpdatesRespons
 	if update.EndOfVersion {
 		a.dsMutex.Lock()
 		a.ds = *(a.pendingDs)
+		a.dsVersion++
 		a.dsMutex.Unlock()
 	}
 
@@ -184,6 +190,14 @@ func (a *AgentsInfoImpl) DistributedState() distributedpb.DistributedState {
 	return a.ds
 }
 
+// VersionedDistributedState returns the current distributed state along with its version, which
+// changes every time the state does. The versions start at 1 and only go up.
+func (a *AgentsInfoImpl) VersionedDistributedState() (distributedpb.DistributedState, int64) {
+	a.dsMutex.Lock()
+	defer a.dsMutex.Unlock()
+	return a.ds, a.dsVersion
+}
+
 func makeAgentCarnotInfo(agentID uuid.UUID, asid uint32, agentMetadata *distributedpb.MetadataInfo) *distributedpb.CarnotInfo {
 	return &distributedpb.CarnotInfo{
 		QueryBrokerAddress:   agentID.String(),
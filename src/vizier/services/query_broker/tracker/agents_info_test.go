@@ -192,6 +192,8 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	// Initial conditions
 	assert.Equal(t, 0, len(agentsInfo.DistributedState().SchemaInfo))
 	assert.Equal(t, 0, len(agentsInfo.DistributedState().CarnotInfo))
+	_, version := agentsInfo.VersionedDistributedState()
+	assert.Equal(t, int64(1), version)
 
 	updates1 := []*metadatapb.AgentUpdate{
 		{
@@ -226,6 +228,8 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	// Updates shouldn't have been propagated yet until the end of the version.
 	assert.Equal(t, 0, len(agentsInfo.DistributedState().SchemaInfo))
 	assert.Equal(t, 0, len(agentsInfo.DistributedState().CarnotInfo))
+	_, version = agentsInfo.VersionedDistributedState()
+	assert.Equal(t, int64(1), version)
 
 	err = agentsInfo.UpdateAgentsInfo(&metadatapb.AgentUpdatesResponse{
 		AgentUpdates:        updates1,
@@ -235,6 +239,9 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	})
 	require.NoError(t, err)
 	assert.Equal(t, testSchema, agentsInfo.DistributedState().SchemaInfo)
+	ds, version := agentsInfo.VersionedDistributedState()
+	assert.Equal(t, int64(2), version)
+	assert.Equal(t, testSchema, ds.SchemaInfo)
 
 	expectedPEM1Info := &distributedpb.CarnotInfo{
 		QueryBrokerAddress:   "11285cdd-1de9-4ab1-ae6a-0ba08c8c676c",
@@ -45,6 +45,11 @@ func (a *fakeAgentsInfo) DistributedState() distributedpb.DistributedState {
 	return distributedpb.DistributedState{}
 }
 
+// VersionedDistributedState implementation for fake agents info.
+func (a *fakeAgentsInfo) VersionedDistributedState() (distributedpb.DistributedState, int64) {
+	return distributedpb.DistributedState{}, 1
+}
+
 func (a *fakeAgentsInfo) UpdateAgentsInfo(update *metadatapb.AgentUpdatesResponse) error {
 	if len(update.AgentUpdates) > 0 || len(update.AgentSchemas) > 0 {
 		a.wg.Done()